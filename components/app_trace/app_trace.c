@@ -163,6 +163,7 @@
 #include "soc/timer_group_reg.h"
 #include "freertos/FreeRTOS.h"
 #include "esp_app_trace.h"
+#include "esp_app_trace_port.h"
 
 #if CONFIG_ESP32_APPTRACE_ENABLE
 #define ESP_APPTRACE_MAX_VPRINTF_ARGS           256
@@ -307,7 +308,10 @@ typedef struct {
     // current (accumulated) pending user data chunk size
     uint16_t                            cur_pending_chunk_sz;
 #endif
+    // bytes currently stored in the pending buffer
+    uint32_t                            pending_level;
 #endif
+    esp_apptrace_stats_t                stats;
 } esp_apptrace_trax_data_t;
 
 /** tracing module internal data */
@@ -326,17 +330,7 @@ static esp_apptrace_buffer_t    s_trace_buf;
 static esp_apptrace_lock_t s_log_lock = {.irq_stat = 0, .portmux = portMUX_INITIALIZER_UNLOCKED};
 #endif
 
-typedef struct {
-    uint8_t *(*get_up_buffer)(uint32_t, esp_apptrace_tmo_t *);
-    esp_err_t (*put_up_buffer)(uint8_t *, esp_apptrace_tmo_t *);
-    esp_err_t (*flush_up_buffer)(uint32_t, esp_apptrace_tmo_t *);
-    uint8_t *(*get_down_buffer)(uint32_t *, esp_apptrace_tmo_t *);
-    esp_err_t (*put_down_buffer)(uint8_t *, esp_apptrace_tmo_t *);
-    bool (*host_is_connected)(void);
-    esp_err_t (*status_reg_set)(uint32_t val);
-    esp_err_t (*status_reg_get)(uint32_t *val);
-} esp_apptrace_hw_t;
-
+#if CONFIG_ESP32_APPTRACE_DEST_TRAX
 static uint32_t esp_apptrace_trax_down_buffer_write_nolock(uint8_t *data, uint32_t size);
 static esp_err_t esp_apptrace_trax_flush(uint32_t min_sz, esp_apptrace_tmo_t *tmo);
 static uint8_t *esp_apptrace_trax_get_buffer(uint32_t size, esp_apptrace_tmo_t *tmo);
@@ -346,6 +340,7 @@ static uint8_t *esp_apptrace_trax_down_buffer_get(uint32_t *size, esp_apptrace_t
 static esp_err_t esp_apptrace_trax_down_buffer_put(uint8_t *ptr, esp_apptrace_tmo_t *tmo);
 static esp_err_t esp_apptrace_trax_status_reg_set(uint32_t val);
 static esp_err_t esp_apptrace_trax_status_reg_get(uint32_t *val);
+static void esp_apptrace_trax_get_stats(esp_apptrace_stats_t *stats, bool reset);
 
 static esp_apptrace_hw_t s_trace_hw[ESP_APPTRACE_HW_MAX] = {
     {
@@ -356,9 +351,32 @@ static esp_apptrace_hw_t s_trace_hw[ESP_APPTRACE_HW_MAX] = {
         .put_down_buffer = esp_apptrace_trax_down_buffer_put,
         .host_is_connected = esp_apptrace_trax_host_is_connected,
         .status_reg_set = esp_apptrace_trax_status_reg_set,
-        .status_reg_get = esp_apptrace_trax_status_reg_get
+        .status_reg_get = esp_apptrace_trax_status_reg_get,
+        .get_stats = esp_apptrace_trax_get_stats
     }
 };
+#endif
+
+static esp_apptrace_hw_t *esp_apptrace_hw_get(esp_apptrace_dest_t dest)
+{
+    switch (dest) {
+#if CONFIG_ESP32_APPTRACE_DEST_TRAX
+    case ESP_APPTRACE_DEST_TRAX:
+        return ESP_APPTRACE_HW(ESP_APPTRACE_HW_TRAX);
+#endif
+#if CONFIG_ESP32_APPTRACE_DEST_UART
+    case ESP_APPTRACE_DEST_UART:
+        return esp_apptrace_uart_hw_get();
+#endif
+#if CONFIG_ESP32_APPTRACE_DEST_NET
+    case ESP_APPTRACE_DEST_NET:
+        return esp_apptrace_net_hw_get();
+#endif
+    default:
+        ESP_APPTRACE_LOGE("Trace destination %d is disabled in menuconfig!", dest);
+        return NULL;
+    }
+}
 
 static inline int esp_apptrace_log_lock()
 {
@@ -466,6 +484,22 @@ static uint16_t esp_apptrace_trax_pend_chunk_sz_get()
 }
 #endif
 
+#if CONFIG_ESP32_APPTRACE_PENDING_DATA_SIZE_MAX > 0
+// allocates space for user block in the pending buffer and accounts it in stats
+static uint8_t *esp_apptrace_trax_pend_produce(uint32_t size)
+{
+    uint8_t *ptr = esp_apptrace_rb_produce(&s_trace_buf.trax.rb_pend, size);
+    if (ptr) {
+        s_trace_buf.trax.pending_level += size;
+        s_trace_buf.trax.stats.bytes_pended += size;
+        if (s_trace_buf.trax.pending_level > s_trace_buf.trax.stats.pending_max) {
+            s_trace_buf.trax.stats.pending_max = s_trace_buf.trax.pending_level;
+        }
+    }
+    return ptr;
+}
+#endif
+
 // assumed to be protected by caller from multi-core/thread access
 static esp_err_t esp_apptrace_trax_block_switch()
 {
@@ -549,8 +583,13 @@ static esp_err_t esp_apptrace_trax_block_switch()
         }
         memcpy(s_trace_buf.trax.blocks[new_block_num].start + s_trace_buf.trax.state.markers[new_block_num], ptr, read_sz);
         s_trace_buf.trax.state.markers[new_block_num] += read_sz;
+        s_trace_buf.trax.pending_level -= read_sz;
     }
 #endif
+    s_trace_buf.trax.stats.blocks_sent++;
+    if (host_connected) {
+        s_trace_buf.trax.stats.bytes_sent += s_trace_buf.trax.state.markers[prev_block_num];
+    }
     eri_write(ESP_APPTRACE_TRAX_CTRL_REG, ESP_APPTRACE_TRAX_BLOCK_ID(s_trace_buf.trax.state.in_block) |
               host_connected | ESP_APPTRACE_TRAX_BLOCK_LEN(s_trace_buf.trax.state.markers[prev_block_num]));
 
@@ -567,13 +606,18 @@ _on_func_exit:
 
 static esp_err_t esp_apptrace_trax_block_switch_waitus(esp_apptrace_tmo_t *tmo)
 {
-    int res;
+    int res = esp_apptrace_trax_block_switch();
 
-    while ((res = esp_apptrace_trax_block_switch()) != ESP_OK) {
+    if (res != ESP_OK) {
+        // host has not read the previous block yet
+        s_trace_buf.trax.stats.host_waits++;
+    }
+    while (res != ESP_OK) {
         res = esp_apptrace_tmo_check(tmo);
         if (res != ESP_OK) {
             break;
         }
+        res = esp_apptrace_trax_block_switch();
     }
     return res;
 }
@@ -675,7 +719,7 @@ static inline uint8_t *esp_apptrace_trax_wait4buf(uint16_t size, esp_apptrace_tm
         // if after TRAX block switch still have pending data (not all pending data have been pumped to TRAX block)
         // alloc new pending buffer
         *pended = 1;
-        ptr = esp_apptrace_rb_produce(&s_trace_buf.trax.rb_pend, size);
+        ptr = esp_apptrace_trax_pend_produce(size);
         if (!ptr) {
             ESP_APPTRACE_LOGE("Failed to alloc pend buf 1: w-r-s %d-%d-%d!", s_trace_buf.trax.rb_pend.wr, s_trace_buf.trax.rb_pend.rd, s_trace_buf.trax.rb_pend.cur_size);
         }
@@ -686,7 +730,7 @@ static inline uint8_t *esp_apptrace_trax_wait4buf(uint16_t size, esp_apptrace_tm
         if (ESP_APPTRACE_TRAX_INBLOCK_MARKER() + size > ESP_APPTRACE_TRAX_INBLOCK_GET()->sz) {
 #if CONFIG_ESP32_APPTRACE_PENDING_DATA_SIZE_MAX > 0
             *pended = 1;
-            ptr = esp_apptrace_rb_produce(&s_trace_buf.trax.rb_pend, size);
+            ptr = esp_apptrace_trax_pend_produce(size);
             if (ptr == NULL) {
                 ESP_APPTRACE_LOGE("Failed to alloc pend buf 2: w-r-s %d-%d-%d!", s_trace_buf.trax.rb_pend.wr, s_trace_buf.trax.rb_pend.rd, s_trace_buf.trax.rb_pend.cur_size);
             }
@@ -723,7 +767,7 @@ static uint8_t *esp_apptrace_trax_get_buffer(uint32_t size, esp_apptrace_tmo_t *
     if (esp_apptrace_rb_read_size_get(&s_trace_buf.trax.rb_pend) > 0) {
         // if we have buffered data alloc new pending buffer
         ESP_APPTRACE_LOGD("Get %d bytes from PEND buffer", size);
-        buf_ptr = esp_apptrace_rb_produce(&s_trace_buf.trax.rb_pend, ESP_APPTRACE_USR_BLOCK_RAW_SZ(size));
+        buf_ptr = esp_apptrace_trax_pend_produce(ESP_APPTRACE_USR_BLOCK_RAW_SZ(size));
         if (buf_ptr == NULL) {
             int pended_buf;
             buf_ptr = esp_apptrace_trax_wait4buf(ESP_APPTRACE_USR_BLOCK_RAW_SZ(size), tmo, &pended_buf);
@@ -748,7 +792,7 @@ static uint8_t *esp_apptrace_trax_get_buffer(uint32_t size, esp_apptrace_tmo_t *
     if (ESP_APPTRACE_TRAX_INBLOCK_MARKER() + ESP_APPTRACE_USR_BLOCK_RAW_SZ(size) > ESP_APPTRACE_TRAX_INBLOCK_GET()->sz) {
 #if CONFIG_ESP32_APPTRACE_PENDING_DATA_SIZE_MAX > 0
         ESP_APPTRACE_LOGD("TRAX full. Get %d bytes from PEND buffer", size);
-        buf_ptr = esp_apptrace_rb_produce(&s_trace_buf.trax.rb_pend, ESP_APPTRACE_USR_BLOCK_RAW_SZ(size));
+        buf_ptr = esp_apptrace_trax_pend_produce(ESP_APPTRACE_USR_BLOCK_RAW_SZ(size));
         if (buf_ptr) {
 #if CONFIG_ESP32_APPTRACE_PENDING_DATA_SIZE_MAX > ESP_APPTRACE_TRAX_BLOCK_SIZE
             esp_apptrace_trax_pend_chunk_sz_update(ESP_APPTRACE_USR_BLOCK_RAW_SZ(size));
@@ -780,6 +824,9 @@ static uint8_t *esp_apptrace_trax_get_buffer(uint32_t size, esp_apptrace_tmo_t *
     }
     if (buf_ptr) {
         buf_ptr = esp_apptrace_data_header_init(buf_ptr, size);
+    } else {
+        s_trace_buf.trax.stats.failed_requests++;
+        s_trace_buf.trax.stats.failed_bytes += size;
     }
 
     // now we can safely unlock apptrace to allow other tasks/ISRs to get other buffers and write their data
@@ -845,6 +892,28 @@ static esp_err_t esp_apptrace_trax_status_reg_get(uint32_t *val)
     return ESP_OK;
 }
 
+static void esp_apptrace_trax_get_stats(esp_apptrace_stats_t *stats, bool reset)
+{
+    esp_apptrace_tmo_t tmo;
+
+    esp_apptrace_tmo_init(&tmo, ESP_APPTRACE_TMO_INFINITE);
+    if (esp_apptrace_lock(&tmo) != ESP_OK) {
+        return;
+    }
+    if (stats) {
+        *stats = s_trace_buf.trax.stats;
+    }
+    if (reset) {
+        memset(&s_trace_buf.trax.stats, 0, sizeof(s_trace_buf.trax.stats));
+#if CONFIG_ESP32_APPTRACE_PENDING_DATA_SIZE_MAX > 0
+        s_trace_buf.trax.stats.pending_max = s_trace_buf.trax.pending_level;
+#endif
+    }
+    if (esp_apptrace_unlock() != ESP_OK) {
+        assert(false && "Failed to unlock apptrace data!");
+    }
+}
+
 static esp_err_t esp_apptrace_trax_dest_init()
 {
     for (int i = 0; i < ESP_APPTRACE_TRAX_BLOCKS_NUM; i++) {
@@ -894,6 +963,20 @@ esp_err_t esp_apptrace_init()
             esp_apptrace_lock_cleanup();
             return res;
         }
+#elif CONFIG_ESP32_APPTRACE_DEST_UART
+        res = esp_apptrace_uart_init();
+        if (res != ESP_OK) {
+            ESP_APPTRACE_LOGE("Failed to init UART dest (%d)!", res);
+            esp_apptrace_lock_cleanup();
+            return res;
+        }
+#elif CONFIG_ESP32_APPTRACE_DEST_NET
+        res = esp_apptrace_net_init();
+        if (res != ESP_OK) {
+            ESP_APPTRACE_LOGE("Failed to init network dest (%d)!", res);
+            esp_apptrace_lock_cleanup();
+            return res;
+        }
 #endif
     }
 
@@ -918,15 +1001,8 @@ esp_err_t esp_apptrace_read(esp_apptrace_dest_t dest, void *buf, uint32_t *size,
     esp_apptrace_tmo_t tmo;
     esp_apptrace_hw_t *hw = NULL;
 
-    if (dest == ESP_APPTRACE_DEST_TRAX) {
-#if CONFIG_ESP32_APPTRACE_DEST_TRAX
-        hw = ESP_APPTRACE_HW(ESP_APPTRACE_HW_TRAX);
-#else
-        ESP_APPTRACE_LOGE("Application tracing via TRAX is disabled in menuconfig!");
-        return ESP_ERR_NOT_SUPPORTED;
-#endif
-    } else {
-        ESP_APPTRACE_LOGE("Trace destinations other then TRAX are not supported yet!");
+    hw = esp_apptrace_hw_get(dest);
+    if (hw == NULL) {
         return ESP_ERR_NOT_SUPPORTED;
     }
     if (buf == NULL || size == NULL || *size == 0) {
@@ -955,15 +1031,8 @@ uint8_t *esp_apptrace_down_buffer_get(esp_apptrace_dest_t dest, uint32_t *size,
     esp_apptrace_tmo_t tmo;
     esp_apptrace_hw_t *hw = NULL;
 
-    if (dest == ESP_APPTRACE_DEST_TRAX) {
-#if CONFIG_ESP32_APPTRACE_DEST_TRAX
-        hw = ESP_APPTRACE_HW(ESP_APPTRACE_HW_TRAX);
-#else
-        ESP_APPTRACE_LOGE("Application tracing via TRAX is disabled in menuconfig!");
-        return NULL;
-#endif
-    } else {
-        ESP_APPTRACE_LOGE("Trace destinations other then TRAX are not supported yet!");
+    hw = esp_apptrace_hw_get(dest);
+    if (hw == NULL) {
         return NULL;
     }
     if (size == NULL || *size == 0) {
@@ -979,15 +1048,8 @@ esp_err_t esp_apptrace_down_buffer_put(esp_apptrace_dest_t dest, uint8_t *ptr, u
     esp_apptrace_tmo_t tmo;
     esp_apptrace_hw_t *hw = NULL;
 
-    if (dest == ESP_APPTRACE_DEST_TRAX) {
-#if CONFIG_ESP32_APPTRACE_DEST_TRAX
-        hw = ESP_APPTRACE_HW(ESP_APPTRACE_HW_TRAX);
-#else
-        ESP_APPTRACE_LOGE("Application tracing via TRAX is disabled in menuconfig!");
-        return ESP_ERR_NOT_SUPPORTED;
-#endif
-    } else {
-        ESP_APPTRACE_LOGE("Trace destinations other then TRAX are not supported yet!");
+    hw = esp_apptrace_hw_get(dest);
+    if (hw == NULL) {
         return ESP_ERR_NOT_SUPPORTED;
     }
     if (ptr == NULL) {
@@ -1004,15 +1066,8 @@ esp_err_t esp_apptrace_write(esp_apptrace_dest_t dest, const void *data, uint32_
     esp_apptrace_tmo_t tmo;
     esp_apptrace_hw_t *hw = NULL;
 
-    if (dest == ESP_APPTRACE_DEST_TRAX) {
-#if CONFIG_ESP32_APPTRACE_DEST_TRAX
-        hw = ESP_APPTRACE_HW(ESP_APPTRACE_HW_TRAX);
-#else
-        ESP_APPTRACE_LOGE("Application tracing via TRAX is disabled in menuconfig!");
-        return ESP_ERR_NOT_SUPPORTED;
-#endif
-    } else {
-        ESP_APPTRACE_LOGE("Trace destinations other then TRAX are not supported yet!");
+    hw = esp_apptrace_hw_get(dest);
+    if (hw == NULL) {
         return ESP_ERR_NOT_SUPPORTED;
     }
     if (data == NULL || size == 0) {
@@ -1040,15 +1095,8 @@ int esp_apptrace_vprintf_to(esp_apptrace_dest_t dest, uint32_t user_tmo, const c
     esp_apptrace_tmo_t tmo;
     esp_apptrace_hw_t *hw = NULL;
 
-    if (dest == ESP_APPTRACE_DEST_TRAX) {
-#if CONFIG_ESP32_APPTRACE_DEST_TRAX
-        hw = ESP_APPTRACE_HW(ESP_APPTRACE_HW_TRAX);
-#else
-        ESP_APPTRACE_LOGE("Application tracing via TRAX is disabled in menuconfig!");
-        return ESP_ERR_NOT_SUPPORTED;
-#endif
-    } else {
-        ESP_APPTRACE_LOGE("Trace destinations other then TRAX are not supported yet!");
+    hw = esp_apptrace_hw_get(dest);
+    if (hw == NULL) {
         return ESP_ERR_NOT_SUPPORTED;
     }
     if (fmt == NULL) {
@@ -1096,7 +1144,7 @@ int esp_apptrace_vprintf_to(esp_apptrace_dest_t dest, uint32_t user_tmo, const c
 
 int esp_apptrace_vprintf(const char *fmt, va_list ap)
 {
-    return esp_apptrace_vprintf_to(ESP_APPTRACE_DEST_TRAX, /*ESP_APPTRACE_TMO_INFINITE*/0, fmt, ap);
+    return esp_apptrace_vprintf_to(ESP_APPTRACE_DEST_DEFAULT, /*ESP_APPTRACE_TMO_INFINITE*/0, fmt, ap);
 }
 
 uint8_t *esp_apptrace_buffer_get(esp_apptrace_dest_t dest, uint32_t size, uint32_t user_tmo)
@@ -1104,15 +1152,8 @@ uint8_t *esp_apptrace_buffer_get(esp_apptrace_dest_t dest, uint32_t size, uint32
     esp_apptrace_tmo_t tmo;
     esp_apptrace_hw_t *hw = NULL;
 
-    if (dest == ESP_APPTRACE_DEST_TRAX) {
-#if CONFIG_ESP32_APPTRACE_DEST_TRAX
-        hw = ESP_APPTRACE_HW(ESP_APPTRACE_HW_TRAX);
-#else
-        ESP_APPTRACE_LOGE("Application tracing via TRAX is disabled in menuconfig!");
-        return NULL;
-#endif
-    } else {
-        ESP_APPTRACE_LOGE("Trace destinations other then TRAX are not supported yet!");
+    hw = esp_apptrace_hw_get(dest);
+    if (hw == NULL) {
         return NULL;
     }
     if (size == 0) {
@@ -1128,15 +1169,8 @@ esp_err_t esp_apptrace_buffer_put(esp_apptrace_dest_t dest, uint8_t *ptr, uint32
     esp_apptrace_tmo_t tmo;
     esp_apptrace_hw_t *hw = NULL;
 
-    if (dest == ESP_APPTRACE_DEST_TRAX) {
-#if CONFIG_ESP32_APPTRACE_DEST_TRAX
-        hw = ESP_APPTRACE_HW(ESP_APPTRACE_HW_TRAX);
-#else
-        ESP_APPTRACE_LOGE("Application tracing via TRAX is disabled in menuconfig!");
-        return ESP_ERR_NOT_SUPPORTED;
-#endif
-    } else {
-        ESP_APPTRACE_LOGE("Trace destinations other then TRAX are not supported yet!");
+    hw = esp_apptrace_hw_get(dest);
+    if (hw == NULL) {
         return ESP_ERR_NOT_SUPPORTED;
     }
     if (ptr == NULL) {
@@ -1152,15 +1186,8 @@ esp_err_t esp_apptrace_flush_nolock(esp_apptrace_dest_t dest, uint32_t min_sz, u
     esp_apptrace_tmo_t tmo;
     esp_apptrace_hw_t *hw = NULL;
 
-    if (dest == ESP_APPTRACE_DEST_TRAX) {
-#if CONFIG_ESP32_APPTRACE_DEST_TRAX
-        hw = ESP_APPTRACE_HW(ESP_APPTRACE_HW_TRAX);
-#else
-        ESP_APPTRACE_LOGE("Application tracing via TRAX is disabled in menuconfig!");
-        return ESP_ERR_NOT_SUPPORTED;
-#endif
-    } else {
-        ESP_APPTRACE_LOGE("Trace destinations other then TRAX are not supported yet!");
+    hw = esp_apptrace_hw_get(dest);
+    if (hw == NULL) {
         return ESP_ERR_NOT_SUPPORTED;
     }
 
@@ -1196,33 +1223,46 @@ bool esp_apptrace_host_is_connected(esp_apptrace_dest_t dest)
 {
     esp_apptrace_hw_t *hw = NULL;
 
-    if (dest == ESP_APPTRACE_DEST_TRAX) {
-#if CONFIG_ESP32_APPTRACE_DEST_TRAX
-        hw = ESP_APPTRACE_HW(ESP_APPTRACE_HW_TRAX);
-#else
-        ESP_APPTRACE_LOGE("Application tracing via TRAX is disabled in menuconfig!");
-        return false;
-#endif
-    } else {
-        ESP_APPTRACE_LOGE("Trace destinations other then TRAX are not supported yet!");
+    hw = esp_apptrace_hw_get(dest);
+    if (hw == NULL) {
         return false;
     }
     return hw->host_is_connected();
 }
 
-esp_err_t esp_apptrace_status_reg_set(esp_apptrace_dest_t dest, uint32_t val)
+esp_err_t esp_apptrace_get_stats(esp_apptrace_dest_t dest, esp_apptrace_stats_t *stats)
 {
     esp_apptrace_hw_t *hw = NULL;
 
-    if (dest == ESP_APPTRACE_DEST_TRAX) {
-#if CONFIG_ESP32_APPTRACE_DEST_TRAX
-        hw = ESP_APPTRACE_HW(ESP_APPTRACE_HW_TRAX);
-#else
-        ESP_APPTRACE_LOGE("Application tracing via TRAX is disabled in menuconfig!");
+    hw = esp_apptrace_hw_get(dest);
+    if (hw == NULL) {
         return ESP_ERR_NOT_SUPPORTED;
-#endif
-    } else {
-        ESP_APPTRACE_LOGE("Trace destinations other then TRAX are not supported yet!");
+    }
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    hw->get_stats(stats, false);
+    return ESP_OK;
+}
+
+esp_err_t esp_apptrace_reset_stats(esp_apptrace_dest_t dest)
+{
+    esp_apptrace_hw_t *hw = NULL;
+
+    hw = esp_apptrace_hw_get(dest);
+    if (hw == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    hw->get_stats(NULL, true);
+    return ESP_OK;
+}
+
+esp_err_t esp_apptrace_status_reg_set(esp_apptrace_dest_t dest, uint32_t val)
+{
+    esp_apptrace_hw_t *hw = NULL;
+
+    hw = esp_apptrace_hw_get(dest);
+    if (hw == NULL) {
         return ESP_ERR_NOT_SUPPORTED;
     }
     return hw->status_reg_set(val);
@@ -1232,15 +1272,8 @@ esp_err_t esp_apptrace_status_reg_get(esp_apptrace_dest_t dest, uint32_t *val)
 {
     esp_apptrace_hw_t *hw = NULL;
 
-    if (dest == ESP_APPTRACE_DEST_TRAX) {
-#if CONFIG_ESP32_APPTRACE_DEST_TRAX
-        hw = ESP_APPTRACE_HW(ESP_APPTRACE_HW_TRAX);
-#else
-        ESP_APPTRACE_LOGE("Application tracing via TRAX is disabled in menuconfig!");
-        return ESP_ERR_NOT_SUPPORTED;
-#endif
-    } else {
-        ESP_APPTRACE_LOGE("Trace destinations other then TRAX are not supported yet!");
+    hw = esp_apptrace_hw_get(dest);
+    if (hw == NULL) {
         return ESP_ERR_NOT_SUPPORTED;
     }
     return hw->status_reg_get(val);
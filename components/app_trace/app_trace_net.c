@@ -0,0 +1,245 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Network transport for application tracing. lwIP can not be called from ISRs or with interrupts disabled,
+// so tracing calls only put data to the stream buffer and a dedicated task sends them to the host over TCP or UDP.
+// Until esp_apptrace_net_start() is called and the task has connected, the buffer collects the first trace data and
+// requests which do not fit are dropped. When connected, callers wait for free space (backpressure) as for other
+// streaming destinations, while the task is blocked by lwIP when the host or the network can not keep up.
+
+#include <string.h>
+#include <stdio.h>
+#include "sdkconfig.h"
+
+#if CONFIG_ESP32_APPTRACE_DEST_NET
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+#include "lwip/netdb.h"
+#include "esp_log.h"
+#include "esp_app_trace_port.h"
+
+// fits into one TCP segment or UDP datagram with default MTU
+#define ESP_APPTRACE_NET_CHUNK_SZ       1436
+#define ESP_APPTRACE_NET_RECONNECT_MS   1000
+#define ESP_APPTRACE_NET_HOST_LEN_MAX   64
+
+#if CONFIG_ESP32_APPTRACE_NET_PROTO_UDP
+#define ESP_APPTRACE_NET_SOCK_TYPE      SOCK_DGRAM
+#else
+#define ESP_APPTRACE_NET_SOCK_TYPE      SOCK_STREAM
+#endif
+
+static const char *TAG = "esp_apptrace_net";
+
+typedef struct {
+    esp_apptrace_stream_t   stream;
+    TaskHandle_t            task;
+    volatile int            sock;
+    volatile bool           stop;
+    char                    host[ESP_APPTRACE_NET_HOST_LEN_MAX];
+    uint16_t                port;
+} esp_apptrace_net_t;
+
+static esp_apptrace_net_t s_net = { .sock = -1 };
+static uint8_t s_net_buf[CONFIG_ESP32_APPTRACE_STREAM_BUF_SIZE];
+
+static int esp_apptrace_net_connect(void)
+{
+    const struct addrinfo hints = {
+        .ai_family = AF_INET,
+        .ai_socktype = ESP_APPTRACE_NET_SOCK_TYPE,
+    };
+    struct addrinfo *addr;
+    char port[8];
+
+    snprintf(port, sizeof(port), "%u", s_net.port);
+    int err = getaddrinfo(s_net.host, port, &hints, &addr);
+    if (err != 0 || addr == NULL) {
+        ESP_LOGW(TAG, "Failed to resolve %s (%d)", s_net.host, err);
+        return -1;
+    }
+    int sock = socket(addr->ai_family, addr->ai_socktype, 0);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Failed to create socket (%d)", errno);
+        freeaddrinfo(addr);
+        return -1;
+    }
+    // for UDP this only sets the destination
+    if (connect(sock, addr->ai_addr, addr->ai_addrlen) != 0) {
+        ESP_LOGW(TAG, "Failed to connect to %s:%s (%d)", s_net.host, port, errno);
+        close(sock);
+        sock = -1;
+    }
+    freeaddrinfo(addr);
+    return sock;
+}
+
+static esp_err_t esp_apptrace_net_send(int sock, const uint8_t *data, uint32_t size)
+{
+    while (size > 0) {
+        int n = send(sock, data, size, 0);
+        if (n < 0) {
+            if (errno == ENOMEM || errno == EAGAIN) {
+                // lwIP is out of buffers, wait for them to be freed
+                vTaskDelay(1);
+                continue;
+            }
+            ESP_LOGW(TAG, "Failed to send trace data (%d)", errno);
+            return ESP_FAIL;
+        }
+        data += n;
+        size -= n;
+    }
+    return ESP_OK;
+}
+
+static void esp_apptrace_net_task(void *arg)
+{
+    static uint8_t s_tx_buf[ESP_APPTRACE_NET_CHUNK_SZ];
+
+    while (!s_net.stop) {
+        s_net.sock = esp_apptrace_net_connect();
+        if (s_net.sock < 0) {
+            vTaskDelay(pdMS_TO_TICKS(ESP_APPTRACE_NET_RECONNECT_MS));
+            continue;
+        }
+        ESP_LOGI(TAG, "Sending trace data to %s:%u", s_net.host, s_net.port);
+        s_net.stream.connected = true;
+        while (!s_net.stop) {
+            uint32_t n = esp_apptrace_stream_read(&s_net.stream, s_tx_buf, sizeof(s_tx_buf));
+            if (n == 0) {
+                vTaskDelay(1);
+                continue;
+            }
+            // data which failed to be sent are lost
+            if (esp_apptrace_net_send(s_net.sock, s_tx_buf, n) != ESP_OK) {
+                break;
+            }
+        }
+        s_net.stream.connected = false;
+        close(s_net.sock);
+        s_net.sock = -1;
+    }
+    s_net.task = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t esp_apptrace_net_start(const char *host, uint16_t port)
+{
+    if (host == NULL || strlen(host) >= sizeof(s_net.host) || port == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_net.task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    strcpy(s_net.host, host);
+    s_net.port = port;
+    s_net.stop = false;
+    if (xTaskCreate(esp_apptrace_net_task, "apptrace_net", CONFIG_ESP32_APPTRACE_NET_TASK_STACK_SIZE, NULL,
+                    CONFIG_ESP32_APPTRACE_NET_TASK_PRIO, &s_net.task) != pdPASS) {
+        s_net.task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_apptrace_net_stop(void)
+{
+    if (s_net.task == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_net.stop = true;
+    int sock = s_net.sock;
+    if (sock >= 0) {
+        // unblock the task if it waits in send()
+        shutdown(sock, SHUT_RDWR);
+    }
+    while (s_net.task) {
+        vTaskDelay(1);
+    }
+    return ESP_OK;
+}
+
+static uint8_t *esp_apptrace_net_get_buffer(uint32_t size, esp_apptrace_tmo_t *tmo)
+{
+    return esp_apptrace_stream_get_buffer(&s_net.stream, size, tmo);
+}
+
+static esp_err_t esp_apptrace_net_put_buffer(uint8_t *ptr, esp_apptrace_tmo_t *tmo)
+{
+    return esp_apptrace_stream_put_buffer(&s_net.stream, ptr, tmo);
+}
+
+static esp_err_t esp_apptrace_net_flush(uint32_t min_sz, esp_apptrace_tmo_t *tmo)
+{
+    return esp_apptrace_stream_flush(&s_net.stream, min_sz, tmo);
+}
+
+static uint8_t *esp_apptrace_net_down_buffer_get(uint32_t *size, esp_apptrace_tmo_t *tmo)
+{
+    // host to target channel is not supported
+    return NULL;
+}
+
+static esp_err_t esp_apptrace_net_down_buffer_put(uint8_t *ptr, esp_apptrace_tmo_t *tmo)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static bool esp_apptrace_net_host_is_connected(void)
+{
+    return s_net.stream.connected;
+}
+
+static esp_err_t esp_apptrace_net_status_reg_set(uint32_t val)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static esp_err_t esp_apptrace_net_status_reg_get(uint32_t *val)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static void esp_apptrace_net_get_stats(esp_apptrace_stats_t *stats, bool reset)
+{
+    esp_apptrace_stream_get_stats(&s_net.stream, stats, reset);
+}
+
+static esp_apptrace_hw_t s_net_hw = {
+    .get_up_buffer = esp_apptrace_net_get_buffer,
+    .put_up_buffer = esp_apptrace_net_put_buffer,
+    .flush_up_buffer = esp_apptrace_net_flush,
+    .get_down_buffer = esp_apptrace_net_down_buffer_get,
+    .put_down_buffer = esp_apptrace_net_down_buffer_put,
+    .host_is_connected = esp_apptrace_net_host_is_connected,
+    .status_reg_set = esp_apptrace_net_status_reg_set,
+    .status_reg_get = esp_apptrace_net_status_reg_get,
+    .get_stats = esp_apptrace_net_get_stats
+};
+
+esp_apptrace_hw_t *esp_apptrace_net_hw_get(void)
+{
+    return &s_net_hw;
+}
+
+esp_err_t esp_apptrace_net_init(void)
+{
+    esp_apptrace_stream_init(&s_net.stream, s_net_buf, sizeof(s_net_buf), NULL);
+    return ESP_OK;
+}
+
+#endif
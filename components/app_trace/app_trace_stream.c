@@ -0,0 +1,166 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Streaming transports (UART, network) can not expose trace memory to the host, they send data from the CPU.
+// Data are written to the ring buffer below and read out by the transport's sending code (UART interrupt, network task).
+// Users can be preempted between esp_apptrace_buffer_get() and esp_apptrace_buffer_put(), so every block has a header
+// and the sending side stops at the first block which is not ready yet. Backpressure works in the same way as
+// for TRAX in streaming mode: when the ring buffer is full, callers wait for free space until their timeout expires.
+
+#include <string.h>
+#include <sys/param.h>
+#include "sdkconfig.h"
+
+#if CONFIG_ESP32_APPTRACE_DEST_UART || CONFIG_ESP32_APPTRACE_DEST_NET
+
+#include "esp_app_trace_port.h"
+
+/** Stream block header, blocks are word aligned to keep headers aligned */
+typedef struct {
+    uint16_t    size;   // size of user data
+    uint16_t    ready;  // non-zero when user has put the block
+} esp_apptrace_stream_hdr_t;
+
+#define ESP_APPTRACE_STREAM_RAW_SZ(_s_)     (((_s_) + sizeof(esp_apptrace_stream_hdr_t) + 3) & ~3UL)
+
+void esp_apptrace_stream_init(esp_apptrace_stream_t *stream, uint8_t *buf, uint32_t size, void (*pump)(void))
+{
+    memset(stream, 0, sizeof(*stream));
+    esp_apptrace_lock_init(&stream->lock);
+    // keep the size word aligned, ring buffer wraps at its end
+    esp_apptrace_rb_init(&stream->rb, buf, size & ~3UL);
+    stream->pump = pump;
+}
+
+uint8_t *esp_apptrace_stream_get_buffer(esp_apptrace_stream_t *stream, uint32_t size, esp_apptrace_tmo_t *tmo)
+{
+    uint32_t raw_sz = ESP_APPTRACE_STREAM_RAW_SZ(size);
+    bool waited = false;
+
+    if (size > UINT16_MAX || raw_sz >= stream->rb.size) {
+        return NULL;
+    }
+    while (1) {
+        if (esp_apptrace_lock_take(&stream->lock, tmo) != ESP_OK) {
+            return NULL;
+        }
+        esp_apptrace_stream_hdr_t *hdr = (esp_apptrace_stream_hdr_t *)esp_apptrace_rb_produce(&stream->rb, raw_sz);
+        if (hdr) {
+            hdr->size = size;
+            hdr->ready = 0;
+            stream->level += raw_sz;
+            if (stream->level > stream->stats.pending_max) {
+                stream->stats.pending_max = stream->level;
+            }
+            esp_apptrace_lock_give(&stream->lock);
+            return (uint8_t *)(hdr + 1);
+        }
+        if (!stream->connected || esp_apptrace_tmo_check(tmo) != ESP_OK) {
+            // nobody reads data or we have waited for too long
+            stream->stats.failed_requests++;
+            stream->stats.failed_bytes += size;
+            esp_apptrace_lock_give(&stream->lock);
+            return NULL;
+        }
+        if (!waited) {
+            stream->stats.host_waits++;
+            waited = true;
+        }
+        esp_apptrace_lock_give(&stream->lock);
+        if (stream->pump) {
+            stream->pump();
+        }
+    }
+}
+
+esp_err_t esp_apptrace_stream_put_buffer(esp_apptrace_stream_t *stream, uint8_t *ptr, esp_apptrace_tmo_t *tmo)
+{
+    esp_apptrace_stream_hdr_t *hdr = (esp_apptrace_stream_hdr_t *)ptr - 1;
+
+    esp_err_t res = esp_apptrace_lock_take(&stream->lock, tmo);
+    if (res != ESP_OK) {
+        return res;
+    }
+    hdr->ready = 1;
+    esp_apptrace_lock_give(&stream->lock);
+    return ESP_OK;
+}
+
+uint32_t esp_apptrace_stream_read(esp_apptrace_stream_t *stream, uint8_t *buf, uint32_t size)
+{
+    esp_apptrace_tmo_t tmo;
+    uint32_t rd_sz = 0;
+
+    esp_apptrace_tmo_init(&tmo, ESP_APPTRACE_TMO_INFINITE);
+    if (esp_apptrace_lock_take(&stream->lock, &tmo) != ESP_OK) {
+        return 0;
+    }
+    while (rd_sz < size && esp_apptrace_rb_read_size_get(&stream->rb) > 0) {
+        esp_apptrace_stream_hdr_t *hdr = (esp_apptrace_stream_hdr_t *)(stream->rb.data + stream->rb.rd);
+        if (!hdr->ready) {
+            break;
+        }
+        uint32_t n = MIN(hdr->size - stream->rd_offset, size - rd_sz);
+        memcpy(buf + rd_sz, (uint8_t *)(hdr + 1) + stream->rd_offset, n);
+        rd_sz += n;
+        stream->rd_offset += n;
+        if (stream->rd_offset == hdr->size) {
+            uint32_t raw_sz = ESP_APPTRACE_STREAM_RAW_SZ(hdr->size);
+            esp_apptrace_rb_consume(&stream->rb, raw_sz);
+            stream->level -= raw_sz;
+            stream->rd_offset = 0;
+            stream->stats.blocks_sent++;
+        }
+    }
+    stream->stats.bytes_sent += rd_sz;
+    esp_apptrace_lock_give(&stream->lock);
+    return rd_sz;
+}
+
+esp_err_t esp_apptrace_stream_flush(esp_apptrace_stream_t *stream, uint32_t min_sz, esp_apptrace_tmo_t *tmo)
+{
+    if (stream->level < min_sz) {
+        return ESP_OK;
+    }
+    while (stream->level > 0 && stream->connected) {
+        if (stream->pump) {
+            stream->pump();
+        }
+        esp_err_t res = esp_apptrace_tmo_check(tmo);
+        if (res != ESP_OK) {
+            return res;
+        }
+    }
+    return ESP_OK;
+}
+
+void esp_apptrace_stream_get_stats(esp_apptrace_stream_t *stream, esp_apptrace_stats_t *stats, bool reset)
+{
+    esp_apptrace_tmo_t tmo;
+
+    esp_apptrace_tmo_init(&tmo, ESP_APPTRACE_TMO_INFINITE);
+    if (esp_apptrace_lock_take(&stream->lock, &tmo) != ESP_OK) {
+        return;
+    }
+    if (stats) {
+        *stats = stream->stats;
+    }
+    if (reset) {
+        memset(&stream->stats, 0, sizeof(stream->stats));
+        stream->stats.pending_max = stream->level;
+    }
+    esp_apptrace_lock_give(&stream->lock);
+}
+
+#endif
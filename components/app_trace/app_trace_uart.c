@@ -0,0 +1,174 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// UART transport for application tracing. Data are sent as a plain byte stream without block headers,
+// so the host only needs to capture the serial port. Tracing calls can come from ISRs, the scheduler or the panic handler,
+// so the UART driver is not used for transmission: TX FIFO is filled directly from the stream buffer, by TX FIFO empty
+// interrupt and by callers which wait for free space in the stream buffer. There is no way to tell whether the host
+// reads the port, so this destination always works in streaming mode.
+
+#include "sdkconfig.h"
+
+#if CONFIG_ESP32_APPTRACE_DEST_UART
+
+#include "soc/uart_struct.h"
+#include "soc/uart_reg.h"
+#include "driver/uart.h"
+#include "esp_intr_alloc.h"
+#include "esp_app_trace_port.h"
+
+#if CONFIG_ESP32_APPTRACE_UART_NUM == 0
+#define ESP_APPTRACE_UART_DEV           UART0
+#define ESP_APPTRACE_UART_INTR_SOURCE   ETS_UART0_INTR_SOURCE
+#elif CONFIG_ESP32_APPTRACE_UART_NUM == 1
+#define ESP_APPTRACE_UART_DEV           UART1
+#define ESP_APPTRACE_UART_INTR_SOURCE   ETS_UART1_INTR_SOURCE
+#else
+#define ESP_APPTRACE_UART_DEV           UART2
+#define ESP_APPTRACE_UART_INTR_SOURCE   ETS_UART2_INTR_SOURCE
+#endif
+
+// refill TX FIFO when there are less bytes in it
+#define ESP_APPTRACE_UART_TXFIFO_EMPTY_THRESH   32
+
+static esp_apptrace_stream_t s_uart_stream;
+static uint8_t s_uart_buf[CONFIG_ESP32_APPTRACE_STREAM_BUF_SIZE];
+// serializes TX FIFO filling, so that data chunks read out of the stream are not reordered
+static esp_apptrace_lock_t s_uart_tx_lock;
+
+static void esp_apptrace_uart_pump(void)
+{
+    esp_apptrace_tmo_t tmo;
+    uint8_t buf[UART_FIFO_LEN];
+
+    // if another CPU or ISR is filling TX FIFO, it will send our data too
+    esp_apptrace_tmo_init(&tmo, 0);
+    if (esp_apptrace_lock_take(&s_uart_tx_lock, &tmo) != ESP_OK) {
+        return;
+    }
+    uint32_t n = esp_apptrace_stream_read(&s_uart_stream, buf, UART_FIFO_LEN - ESP_APPTRACE_UART_DEV.status.txfifo_cnt);
+    for (uint32_t i = 0; i < n; i++) {
+        WRITE_PERI_REG(UART_FIFO_AHB_REG(CONFIG_ESP32_APPTRACE_UART_NUM), buf[i]);
+    }
+    // keep interrupt enabled while there are data to send
+    ESP_APPTRACE_UART_DEV.int_ena.txfifo_empty = esp_apptrace_stream_level_get(&s_uart_stream) > 0;
+    esp_apptrace_lock_give(&s_uart_tx_lock);
+}
+
+static void esp_apptrace_uart_isr(void *arg)
+{
+    ESP_APPTRACE_UART_DEV.int_clr.txfifo_empty = 1;
+    esp_apptrace_uart_pump();
+}
+
+static uint8_t *esp_apptrace_uart_get_buffer(uint32_t size, esp_apptrace_tmo_t *tmo)
+{
+    return esp_apptrace_stream_get_buffer(&s_uart_stream, size, tmo);
+}
+
+static esp_err_t esp_apptrace_uart_put_buffer(uint8_t *ptr, esp_apptrace_tmo_t *tmo)
+{
+    esp_err_t res = esp_apptrace_stream_put_buffer(&s_uart_stream, ptr, tmo);
+    if (res == ESP_OK) {
+        esp_apptrace_uart_pump();
+    }
+    return res;
+}
+
+static esp_err_t esp_apptrace_uart_flush(uint32_t min_sz, esp_apptrace_tmo_t *tmo)
+{
+    return esp_apptrace_stream_flush(&s_uart_stream, min_sz, tmo);
+}
+
+static uint8_t *esp_apptrace_uart_down_buffer_get(uint32_t *size, esp_apptrace_tmo_t *tmo)
+{
+    // host to target channel is not supported
+    return NULL;
+}
+
+static esp_err_t esp_apptrace_uart_down_buffer_put(uint8_t *ptr, esp_apptrace_tmo_t *tmo)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static bool esp_apptrace_uart_host_is_connected(void)
+{
+    return true;
+}
+
+static esp_err_t esp_apptrace_uart_status_reg_set(uint32_t val)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static esp_err_t esp_apptrace_uart_status_reg_get(uint32_t *val)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static void esp_apptrace_uart_get_stats(esp_apptrace_stats_t *stats, bool reset)
+{
+    esp_apptrace_stream_get_stats(&s_uart_stream, stats, reset);
+}
+
+static esp_apptrace_hw_t s_uart_hw = {
+    .get_up_buffer = esp_apptrace_uart_get_buffer,
+    .put_up_buffer = esp_apptrace_uart_put_buffer,
+    .flush_up_buffer = esp_apptrace_uart_flush,
+    .get_down_buffer = esp_apptrace_uart_down_buffer_get,
+    .put_down_buffer = esp_apptrace_uart_down_buffer_put,
+    .host_is_connected = esp_apptrace_uart_host_is_connected,
+    .status_reg_set = esp_apptrace_uart_status_reg_set,
+    .status_reg_get = esp_apptrace_uart_status_reg_get,
+    .get_stats = esp_apptrace_uart_get_stats
+};
+
+esp_apptrace_hw_t *esp_apptrace_uart_hw_get(void)
+{
+    return &s_uart_hw;
+}
+
+esp_err_t esp_apptrace_uart_init(void)
+{
+    const uart_config_t uart_config = {
+        .baud_rate = CONFIG_ESP32_APPTRACE_UART_BAUDRATE,
+        .data_bits = UART_DATA_8_BITS,
+        .parity    = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+    };
+
+    esp_apptrace_stream_init(&s_uart_stream, s_uart_buf, sizeof(s_uart_buf), esp_apptrace_uart_pump);
+    esp_apptrace_lock_init(&s_uart_tx_lock);
+    esp_err_t res = uart_param_config(CONFIG_ESP32_APPTRACE_UART_NUM, &uart_config);
+    if (res != ESP_OK) {
+        return res;
+    }
+    res = uart_set_pin(CONFIG_ESP32_APPTRACE_UART_NUM, CONFIG_ESP32_APPTRACE_UART_TX_GPIO,
+                       UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    if (res != ESP_OK) {
+        return res;
+    }
+    ESP_APPTRACE_UART_DEV.int_ena.val = 0;
+    ESP_APPTRACE_UART_DEV.int_clr.val = UINT32_MAX;
+    ESP_APPTRACE_UART_DEV.conf1.txfifo_empty_thrhd = ESP_APPTRACE_UART_TXFIFO_EMPTY_THRESH;
+    res = esp_intr_alloc(ESP_APPTRACE_UART_INTR_SOURCE, ESP_INTR_FLAG_IRAM, esp_apptrace_uart_isr, NULL, NULL);
+    if (res != ESP_OK) {
+        return res;
+    }
+    s_uart_stream.connected = true;
+    return ESP_OK;
+}
+
+#endif
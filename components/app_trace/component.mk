@@ -6,6 +6,8 @@ COMPONENT_SRCDIRS := .
 
 COMPONENT_ADD_INCLUDEDIRS = include
 
+COMPONENT_PRIV_INCLUDEDIRS = private_include
+
 COMPONENT_ADD_LDFLAGS = -lapp_trace
 
 # do not produce gcov info for this module, it is used as transport for gcov
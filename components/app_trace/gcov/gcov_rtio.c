@@ -14,6 +14,8 @@
 
 // This module implements runtime file I/O API for GCOV.
 
+#include <string.h>
+#include <stdio.h>
 #include "esp_task_wdt.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -26,6 +28,7 @@
 #if CONFIG_ESP32_GCOV_ENABLE
 
 #define ESP_GCOV_DOWN_BUF_SIZE  4200
+#define ESP_GCOV_STREAM_BUF_SIZE 4096
 
 #define LOG_LOCAL_LEVEL CONFIG_LOG_DEFAULT_LEVEL
 #include "esp_log.h"
@@ -38,6 +41,9 @@ void __gcov_reset(void);
 /* The next code for old GCC */
 
 static void (*s_gcov_exit)(void);
+#endif
+
+#if !GCC_NOT_5_2_0 || CONFIG_ESP32_GCOV_DUMP_STREAM
 /* Root of a program/shared-object state */
 struct gcov_root
 {
@@ -58,11 +64,127 @@ static void esp_gcov_reset_status(void)
 }
 #endif
 
+#if CONFIG_ESP32_GCOV_DUMP_STREAM
+/* Stream records, see tools/esp_app_trace/gcovtrace_proc.py */
+#define ESP_GCOV_STREAM_MAGIC       0x53564f43UL // "COVS"
+#define ESP_GCOV_STREAM_VERSION     1
+#define ESP_GCOV_REC_FILE_OPEN      0x1 // u16 path length, path
+#define ESP_GCOV_REC_FILE_WRITE     0x2 // u32 offset, u32 length, data
+#define ESP_GCOV_REC_FILE_CLOSE     0x3
+#define ESP_GCOV_REC_DUMP_END       0x4
+
+typedef struct {
+    uint8_t *   buf;
+    uint32_t    fill;
+    // offset of the length field of the last write record, if it is still in buffer
+    int32_t     wr_len_pos;
+    // file position at the end of the last write record
+    uint32_t    wr_end;
+    esp_err_t   err;
+} esp_gcov_stream_t;
+
+typedef struct {
+    uint32_t    pos;
+    uint32_t    size;
+} esp_gcov_stream_file_t;
+
+static esp_gcov_stream_t s_gcov_stream;
+// libgcov handles one file at a time
+static esp_gcov_stream_file_t s_gcov_file;
+
+static void esp_gcov_stream_flush(void)
+{
+    if (s_gcov_stream.fill && s_gcov_stream.err == ESP_OK) {
+        s_gcov_stream.err = esp_apptrace_write(ESP_APPTRACE_DEST_TRAX, s_gcov_stream.buf, s_gcov_stream.fill,
+                                               ESP_APPTRACE_TMO_INFINITE);
+        if (s_gcov_stream.err != ESP_OK) {
+            ESP_EARLY_LOGE(TAG, "Failed to write coverage data (%d)!", s_gcov_stream.err);
+        }
+    }
+    s_gcov_stream.fill = 0;
+    s_gcov_stream.wr_len_pos = -1;
+}
+
+static void esp_gcov_stream_put(const void *data, uint32_t size)
+{
+    const uint8_t *p = data;
+    while (size) {
+        uint32_t len = ESP_GCOV_STREAM_BUF_SIZE - s_gcov_stream.fill;
+        if (len > size) {
+            len = size;
+        }
+        memcpy(s_gcov_stream.buf + s_gcov_stream.fill, p, len);
+        s_gcov_stream.fill += len;
+        p += len;
+        size -= len;
+        if (s_gcov_stream.fill == ESP_GCOV_STREAM_BUF_SIZE) {
+            esp_gcov_stream_flush();
+        }
+    }
+}
+
+static void esp_gcov_stream_put_rec(uint8_t type, const void *args, uint32_t args_len)
+{
+    esp_gcov_stream_put(&type, sizeof(type));
+    esp_gcov_stream_put(args, args_len);
+}
+
+static esp_err_t esp_gcov_stream_start(void)
+{
+    const uint32_t hdr[2] = {ESP_GCOV_STREAM_MAGIC, ESP_GCOV_STREAM_VERSION};
+
+    s_gcov_stream.buf = malloc(ESP_GCOV_STREAM_BUF_SIZE);
+    if (s_gcov_stream.buf == NULL) {
+        ESP_EARLY_LOGE(TAG, "Could not allocate memory for the buffer");
+        return ESP_ERR_NO_MEM;
+    }
+    s_gcov_stream.fill = 0;
+    s_gcov_stream.wr_len_pos = -1;
+    s_gcov_stream.err = ESP_OK;
+    esp_gcov_stream_put(hdr, sizeof(hdr));
+    return ESP_OK;
+}
+
+static esp_err_t esp_gcov_stream_stop(void)
+{
+    esp_gcov_stream_put_rec(ESP_GCOV_REC_DUMP_END, NULL, 0);
+    esp_gcov_stream_flush();
+    free(s_gcov_stream.buf);
+    s_gcov_stream.buf = NULL;
+    if (s_gcov_stream.err != ESP_OK) {
+        return s_gcov_stream.err;
+    }
+    return esp_apptrace_flush(ESP_APPTRACE_DEST_TRAX, ESP_APPTRACE_TMO_INFINITE);
+}
+#endif
 
 static int esp_dbg_stub_gcov_dump_do(void)
 {
     int ret = ESP_OK;
 
+#if CONFIG_ESP32_GCOV_DUMP_STREAM
+    // Data of all files are sent as one stream, host side does not need to handle file I/O commands.
+    // Files are never read back, so counters are not reset and every dump holds the data since the start.
+    ret = esp_gcov_stream_start();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ESP_EARLY_LOGV(TAG, "Dump data...");
+#if GCC_NOT_5_2_0
+    __gcov_dump();
+#else
+    if (s_gcov_exit) {
+        s_gcov_exit();
+    }
+#endif
+    // allow the next dump
+    esp_gcov_reset_status();
+    ret = esp_gcov_stream_stop();
+    if (ret != ESP_OK) {
+        ESP_EARLY_LOGE(TAG, "Failed to send coverage data (%d)!", ret);
+    }
+    return ret;
+#else
     ESP_EARLY_LOGV(TAG, "Alloc apptrace down buf %d bytes", ESP_GCOV_DOWN_BUF_SIZE);
     void *down_buf = malloc(ESP_GCOV_DOWN_BUF_SIZE);
     if (down_buf == NULL) {
@@ -92,8 +214,10 @@ static int esp_dbg_stub_gcov_dump_do(void)
         ESP_EARLY_LOGE(TAG, "Failed to send files transfer stop cmd (%d)!", ret);
     }
     return ret;
+#endif
 }
 
+#if !CONFIG_ESP32_GCOV_DUMP_STREAM
 /**
  * @brief Triggers gcov info dump.
  *        This function is to be called by OpenOCD, not by normal user code.
@@ -114,6 +238,7 @@ static int esp_dbg_stub_gcov_entry(void)
     return ret;
 #endif
 }
+#endif
 
 void esp_gcov_dump()
 {
@@ -149,10 +274,104 @@ int gcov_rtio_atexit(void (*function)(void) __attribute__ ((unused)))
     ESP_EARLY_LOGV(TAG, "%s %p", __FUNCTION__, function);
     s_gcov_exit = function;
 #endif
+#if !CONFIG_ESP32_GCOV_DUMP_STREAM
+    // OpenOCD 'esp32 gcov' command handles file I/O commands only
     esp_dbg_stub_entry_set(ESP_DBG_STUB_ENTRY_GCOV, (uint32_t)&esp_dbg_stub_gcov_entry);
+#endif
+    return 0;
+}
+
+#if CONFIG_ESP32_GCOV_DUMP_STREAM
+void *gcov_rtio_fopen(const char *path, const char *mode)
+{
+    uint16_t len = strlen(path);
+
+    ESP_EARLY_LOGV(TAG, "%s '%s' '%s'", __FUNCTION__, path, mode);
+    if (s_gcov_stream.buf == NULL) {
+        return NULL;
+    }
+    esp_gcov_stream_put_rec(ESP_GCOV_REC_FILE_OPEN, &len, sizeof(len));
+    esp_gcov_stream_put(path, len);
+    // host does not send existing file, libgcov treats it as a new one
+    s_gcov_file.pos = 0;
+    s_gcov_file.size = 0;
+    s_gcov_stream.wr_len_pos = -1;
+    return &s_gcov_file;
+}
+
+int gcov_rtio_fclose(void *stream)
+{
+    ESP_EARLY_LOGV(TAG, "%s", __FUNCTION__);
+    esp_gcov_stream_put_rec(ESP_GCOV_REC_FILE_CLOSE, NULL, 0);
+    return s_gcov_stream.err == ESP_OK ? 0 : EOF;
+}
+
+size_t gcov_rtio_fread(void *ptr, size_t size, size_t nmemb, void *stream)
+{
+    ESP_EARLY_LOGV(TAG, "%s read %u", __FUNCTION__, size*nmemb);
+    return 0;
+}
+
+size_t gcov_rtio_fwrite(const void *ptr, size_t size, size_t nmemb, void *stream)
+{
+    esp_gcov_stream_file_t *f = stream;
+    uint32_t len = size * nmemb;
+
+    ESP_EARLY_LOGV(TAG, "%s", __FUNCTION__);
+    if (s_gcov_stream.wr_len_pos >= 0 && s_gcov_stream.wr_end == f->pos) {
+        // continuation of the last write record which is still in buffer, update its length
+        uint32_t rec_len;
+        memcpy(&rec_len, s_gcov_stream.buf + s_gcov_stream.wr_len_pos, sizeof(rec_len));
+        rec_len += len;
+        memcpy(s_gcov_stream.buf + s_gcov_stream.wr_len_pos, &rec_len, sizeof(rec_len));
+    } else {
+        uint32_t args[2] = {f->pos, len};
+        esp_gcov_stream_put_rec(ESP_GCOV_REC_FILE_WRITE, args, sizeof(args));
+        // length field is the last one of record header, it can be updated if the header has not been flushed
+        if (s_gcov_stream.fill >= sizeof(uint8_t) + sizeof(args)) {
+            s_gcov_stream.wr_len_pos = s_gcov_stream.fill - sizeof(uint32_t);
+        }
+    }
+    uint32_t fill = s_gcov_stream.fill;
+    esp_gcov_stream_put(ptr, len);
+    if (s_gcov_stream.fill < fill + len) {
+        // buffer has been flushed
+        s_gcov_stream.wr_len_pos = -1;
+    }
+    f->pos += len;
+    if (f->pos > f->size) {
+        f->size = f->pos;
+    }
+    s_gcov_stream.wr_end = f->pos;
+    return s_gcov_stream.err == ESP_OK ? nmemb : 0;
+}
+
+int gcov_rtio_fseek(void *stream, long offset, int whence)
+{
+    esp_gcov_stream_file_t *f = stream;
+    long pos = offset;
+
+    if (whence == SEEK_CUR) {
+        pos += f->pos;
+    } else if (whence == SEEK_END) {
+        pos += f->size;
+    }
+    ESP_EARLY_LOGV(TAG, "%s(%p %ld %d) = %ld", __FUNCTION__, stream, offset, whence, pos);
+    if (pos < 0) {
+        return -1;
+    }
+    f->pos = pos;
     return 0;
 }
 
+long gcov_rtio_ftell(void *stream)
+{
+    esp_gcov_stream_file_t *f = stream;
+    ESP_EARLY_LOGV(TAG, "%s(%p) = %u", __FUNCTION__, stream, f->pos);
+    return f->pos;
+}
+#else
+
 void *gcov_rtio_fopen(const char *path, const char *mode)
 {
     ESP_EARLY_LOGV(TAG, "%s '%s' '%s'", __FUNCTION__, path, mode);
@@ -192,4 +411,5 @@ long gcov_rtio_ftell(void *stream)
     ESP_EARLY_LOGV(TAG, "%s(%p) = %ld", __FUNCTION__, stream, ret);
     return ret;
 }
+#endif // CONFIG_ESP32_GCOV_DUMP_STREAM
 #endif
@@ -0,0 +1,74 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <stdio.h>
+#include <sdkconfig.h>
+
+#define HEAP_TRACE_SRCFILE /* don't warn on inclusion here */
+#include "esp_heap_trace.h"
+#undef HEAP_TRACE_SRCFILE
+
+#include "esp_app_trace.h"
+
+#define STACK_DEPTH CONFIG_HEAP_TRACING_STACK_DEPTH
+
+#ifdef CONFIG_HEAP_TRACING_SAMPLING
+
+esp_err_t heap_trace_dump_to_host(uint32_t tmo)
+{
+#if CONFIG_ESP32_APPTRACE_ENABLE
+    /* Enough for the counters and 11 characters per stack frame */
+    char line[80 + 11 * STACK_DEPTH];
+    size_t total_live = 0;
+    size_t count = heap_trace_get_callsite_count();
+
+    for (size_t i = 0; i < count; i++) {
+        heap_trace_callsite_t site;
+        if (heap_trace_get_callsite(i, &site) != ESP_OK) {
+            break;
+        }
+        int len = snprintf(line, sizeof(line), "%u bytes live (%u samples) %u bytes total caller ",
+                           site.live_bytes, site.live_samples, site.total_bytes);
+        for (int j = 0; j < STACK_DEPTH && site.alloced_by[j] != 0 && len < sizeof(line); j++) {
+            len += snprintf(line + len, sizeof(line) - len, "%p%s", site.alloced_by[j],
+                            (j < STACK_DEPTH - 1) ? ":" : "");
+        }
+        if (len < sizeof(line)) {
+            len += snprintf(line + len, sizeof(line) - len, "\n");
+        }
+        if (len > sizeof(line) - 1) {
+            len = sizeof(line) - 1;
+        }
+        esp_err_t err = esp_apptrace_write(ESP_APPTRACE_DEST_DEFAULT, line, len, tmo);
+        if (err != ESP_OK) {
+            return err;
+        }
+        total_live += site.live_bytes;
+    }
+
+    int len = snprintf(line, sizeof(line), "%u bytes estimated alive in trace (%u sampled allocations)\n",
+                       total_live, heap_trace_get_count());
+    if (len > sizeof(line) - 1) {
+        len = sizeof(line) - 1;
+    }
+    esp_err_t err = esp_apptrace_write(ESP_APPTRACE_DEST_DEFAULT, line, len, tmo);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return esp_apptrace_flush(ESP_APPTRACE_DEST_DEFAULT, tmo);
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+#endif /*CONFIG_HEAP_TRACING_SAMPLING*/
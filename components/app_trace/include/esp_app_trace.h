@@ -15,6 +15,7 @@
 #define ESP_APP_TRACE_H_
 
 #include <stdarg.h>
+#include "sdkconfig.h"
 #include "esp_err.h"
 #include "esp_app_trace_util.h" // ESP_APPTRACE_TMO_INFINITE
 
@@ -23,9 +24,35 @@
  */
 typedef enum {
     ESP_APPTRACE_DEST_TRAX = 0x1,	///< JTAG destination
-    ESP_APPTRACE_DEST_UART0 = 0x2,	///< UART destination
+    ESP_APPTRACE_DEST_UART = 0x2,	///< UART destination, port is selected in menuconfig
+    ESP_APPTRACE_DEST_UART0 = ESP_APPTRACE_DEST_UART,	///< Deprecated, use ESP_APPTRACE_DEST_UART
+    ESP_APPTRACE_DEST_NET = 0x4,	///< TCP or UDP destination
 } esp_apptrace_dest_t;
 
+/**
+ * Destination selected in menuconfig. SystemView, heap tracing and the panic handler send their data there.
+ */
+#if CONFIG_ESP32_APPTRACE_DEST_UART
+#define ESP_APPTRACE_DEST_DEFAULT   ESP_APPTRACE_DEST_UART
+#elif CONFIG_ESP32_APPTRACE_DEST_NET
+#define ESP_APPTRACE_DEST_DEFAULT   ESP_APPTRACE_DEST_NET
+#else
+#define ESP_APPTRACE_DEST_DEFAULT   ESP_APPTRACE_DEST_TRAX
+#endif
+
+/**
+ * Application trace transfer statistics.
+ */
+typedef struct {
+    uint32_t bytes_sent;        ///< Bytes handed over to the host in completed trace memory blocks or to UART/network
+    uint32_t blocks_sent;       ///< Number of trace memory block switches, for UART and network number of sent user blocks
+    uint32_t bytes_pended;      ///< Bytes which went through the pending data buffer because trace memory block was full
+    uint32_t pending_max;       ///< Maximum number of bytes held in the pending data buffer (stream buffer for UART and network) at once
+    uint32_t host_waits;        ///< Number of times the target had to wait for the host to read data
+    uint32_t failed_requests;   ///< Number of buffer requests which failed, their data were lost
+    uint32_t failed_bytes;      ///< Bytes requested by failed buffer requests
+} esp_apptrace_stats_t;
+
 /**
  * @brief  Initializes application tracing module.
  *
@@ -170,6 +197,46 @@ esp_err_t esp_apptrace_down_buffer_put(esp_apptrace_dest_t dest, uint8_t *ptr, u
  */
 bool esp_apptrace_host_is_connected(esp_apptrace_dest_t dest);
 
+/**
+ * @brief Gets transfer statistics collected since start or since the last call to esp_apptrace_reset_stats.
+ *        Use them to find out whether trace data are lost and how large the pending data buffer should be.
+ *
+ * @param dest  Indicates HW interface to get statistics for.
+ * @param stats Pointer to structure to fill.
+ *
+ * @return ESP_OK on success, otherwise see esp_err_t
+ */
+esp_err_t esp_apptrace_get_stats(esp_apptrace_dest_t dest, esp_apptrace_stats_t *stats);
+
+/**
+ * @brief Resets transfer statistics.
+ *
+ * @param dest Indicates HW interface to reset statistics for.
+ *
+ * @return ESP_OK on success, otherwise see esp_err_t
+ */
+esp_err_t esp_apptrace_reset_stats(esp_apptrace_dest_t dest);
+
+/**
+ * @brief Starts sending trace data to the host over network.
+ *        Available when network destination is selected in menuconfig. Call it when network interface has got
+ *        an IP address. Until connected, trace data are kept in the stream buffer, data which do not fit are dropped.
+ *        Protocol (TCP or UDP) is selected in menuconfig. Connection is re-established if it breaks.
+ *
+ * @param host Host name or IP address of the host which collects trace data.
+ * @param port Port on the host.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if already started, otherwise see esp_err_t
+ */
+esp_err_t esp_apptrace_net_start(const char *host, uint16_t port);
+
+/**
+ * @brief Stops sending trace data over network and closes connection.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not started.
+ */
+esp_err_t esp_apptrace_net_stop(void);
+
 /**
  * @brief Opens file on host.
  *		  This function has the same semantic as 'fopen' except for the first argument.
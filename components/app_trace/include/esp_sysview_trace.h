@@ -15,10 +15,17 @@
 #define ESP_SYSVIEW_TRACE_H_
 
 #include <stdarg.h>
+#include <stdbool.h>
 #include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "SEGGER_RTT.h" // SEGGER_RTT_ESP32_Flush
+#include "SEGGER_SYSVIEW.h" // SYSVIEW_EVTMASK_XXX
 #include "esp_app_trace_util.h" // ESP_APPTRACE_TMO_INFINITE
 
+/** Mask of FreeRTOS API call events (queue, task notification etc.) for esp_sysview_enable/disable_events() */
+#define ESP_SYSVIEW_EVTMASK_API     (1UL << 30)
+
 /**
  * @brief Flushes remaining data in SystemView trace buffer to host.
  *
@@ -32,6 +39,62 @@ static inline esp_err_t esp_sysview_flush(uint32_t tmo)
     return ESP_OK;
 }
 
+/**
+ * @brief Gets the number of SystemView events which have been dropped because
+ *        the host did not read trace data fast enough (see CONFIG_SYSVIEW_BUF_WAIT_TMO).
+ *
+ * @return Number of dropped events.
+ */
+static inline uint32_t esp_sysview_get_dropped_events(void)
+{
+    return SEGGER_RTT_ESP32_GetDroppedEvents();
+}
+
+/**
+ * @brief Sets sampling of SystemView events for interrupt source.
+ *
+ * Enter and exit events are recorded for one of every `period` invocations of the ISRs of the source.
+ * Initial period of all sources is set by CONFIG_SYSVIEW_ISR_SAMPLE_PERIOD.
+ *
+ * @param source  Interrupt source, one of ETS_*_INTR_SOURCE values, including internal ones (see esp_intr_alloc.h).
+ * @param period  0 to never record events of the source, 1 to record all of them, N to record one of N.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if source is invalid or period is greater than 65535.
+ */
+esp_err_t esp_sysview_set_isr_sampling(int source, uint32_t period);
+
+/**
+ * @brief Enables or disables recording of FreeRTOS API call events issued by the task.
+ *
+ * Scheduling events of the task (start of execution, ready state) are still recorded,
+ * so the timeline stays correct. Up to 8 tasks can be excluded.
+ *
+ * @param task    Task handle, NULL for the calling task.
+ * @param enable  false to stop recording API call events of the task, true to resume.
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if too many tasks are excluded.
+ */
+esp_err_t esp_sysview_set_task_filter(TaskHandle_t task, bool enable);
+
+/**
+ * @brief Enables recording of SystemView events.
+ *
+ * Events initially disabled are selected in menuconfig (CONFIG_SYSVIEW_EVT_XXX).
+ *
+ * @param evt_mask  Mask of events, combination of SYSVIEW_EVTMASK_XXX and ESP_SYSVIEW_EVTMASK_API.
+ */
+void esp_sysview_enable_events(uint32_t evt_mask);
+
+/**
+ * @brief Disables recording of SystemView events.
+ *
+ * Unlike SEGGER_SYSVIEW_DisableEvents(), ISR and FreeRTOS API call events disabled
+ * by this function are dropped before taking the trace lock and reading the timestamp.
+ *
+ * @param evt_mask  Mask of events, combination of SYSVIEW_EVTMASK_XXX and ESP_SYSVIEW_EVTMASK_API.
+ */
+void esp_sysview_disable_events(uint32_t evt_mask);
+
 /**
  * @brief vprintf-like function to sent log messages to the host.
  *
@@ -0,0 +1,131 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef ESP_APP_TRACE_PORT_H_
+#define ESP_APP_TRACE_PORT_H_
+
+#include <stdbool.h>
+#include "esp_app_trace.h"
+#include "esp_app_trace_util.h"
+
+/** Application trace transport (HW interface) */
+typedef struct {
+    uint8_t *(*get_up_buffer)(uint32_t, esp_apptrace_tmo_t *);
+    esp_err_t (*put_up_buffer)(uint8_t *, esp_apptrace_tmo_t *);
+    esp_err_t (*flush_up_buffer)(uint32_t, esp_apptrace_tmo_t *);
+    uint8_t *(*get_down_buffer)(uint32_t *, esp_apptrace_tmo_t *);
+    esp_err_t (*put_down_buffer)(uint8_t *, esp_apptrace_tmo_t *);
+    bool (*host_is_connected)(void);
+    esp_err_t (*status_reg_set)(uint32_t val);
+    esp_err_t (*status_reg_get)(uint32_t *val);
+    void (*get_stats)(esp_apptrace_stats_t *stats, bool reset); // copies stats if stats is not NULL, then resets them if requested
+} esp_apptrace_hw_t;
+
+/** Stream of user data blocks kept in RAM until the transport sends them off.
+ *  Used by transports which send data from the CPU (UART, network) instead of exposing memory to the host.
+ *  Every block is prepended with a header which marks it ready when esp_apptrace_stream_put_buffer() is called,
+ *  blocks are read out in allocation order and only after they are ready.
+ */
+typedef struct {
+    esp_apptrace_lock_t     lock;       // protects ring buffer and stats
+    esp_apptrace_rb_t       rb;         // ring buffer for user blocks
+    uint32_t                level;      // bytes allocated in the ring buffer
+    uint32_t                rd_offset;  // bytes of the oldest block which have already been read out
+    volatile bool           connected;  // if false, requests fail at once instead of waiting for free space
+    void                    (*pump)(void); // called while waiting for free space, can be NULL
+    esp_apptrace_stats_t    stats;
+} esp_apptrace_stream_t;
+
+/**
+ * @brief Initializes stream.
+ *
+ * @param stream Pointer to stream structure to be initialized.
+ * @param buf    Storage for stream data.
+ * @param size   Size of the storage.
+ * @param pump   Function which moves stream data to HW when free space is needed, can be NULL.
+ */
+void esp_apptrace_stream_init(esp_apptrace_stream_t *stream, uint8_t *buf, uint32_t size, void (*pump)(void));
+
+/**
+ * @brief Allocates buffer for user data in stream.
+ *        If there is no free space and stream is connected, waits for the transport to send data off.
+ *
+ * @param stream Pointer to stream structure.
+ * @param size   Size of user data.
+ * @param tmo    Pointer to timeout struct.
+ *
+ * @return Pointer to the allocated buffer or NULL in case of failure.
+ */
+uint8_t *esp_apptrace_stream_get_buffer(esp_apptrace_stream_t *stream, uint32_t size, esp_apptrace_tmo_t *tmo);
+
+/**
+ * @brief Marks buffer obtained with esp_apptrace_stream_get_buffer() as ready to be sent.
+ *
+ * @param stream Pointer to stream structure.
+ * @param ptr    Pointer to buffer.
+ * @param tmo    Pointer to timeout struct.
+ *
+ * @return ESP_OK on success, otherwise see esp_err_t
+ */
+esp_err_t esp_apptrace_stream_put_buffer(esp_apptrace_stream_t *stream, uint8_t *ptr, esp_apptrace_tmo_t *tmo);
+
+/**
+ * @brief Reads out ready user data. Headers are not copied, so the transport gets contiguous data stream.
+ *
+ * @param stream Pointer to stream structure.
+ * @param buf    Buffer to copy data to.
+ * @param size   Size of the buffer.
+ *
+ * @return Number of bytes copied to buf.
+ */
+uint32_t esp_apptrace_stream_read(esp_apptrace_stream_t *stream, uint8_t *buf, uint32_t size);
+
+/**
+ * @brief Waits until all data are read out of stream.
+ *
+ * @param stream Pointer to stream structure.
+ * @param min_sz Threshold for flushing data. If there are less bytes in stream, function returns at once.
+ * @param tmo    Pointer to timeout struct.
+ *
+ * @return ESP_OK on success, otherwise see esp_err_t
+ */
+esp_err_t esp_apptrace_stream_flush(esp_apptrace_stream_t *stream, uint32_t min_sz, esp_apptrace_tmo_t *tmo);
+
+/**
+ * @brief Copies and/or resets stream statistics.
+ *
+ * @param stream Pointer to stream structure.
+ * @param stats  Pointer to structure to fill, can be NULL.
+ * @param reset  If true, statistics are reset after they have been copied.
+ */
+void esp_apptrace_stream_get_stats(esp_apptrace_stream_t *stream, esp_apptrace_stats_t *stats, bool reset);
+
+/**
+ * @brief Gets number of bytes allocated in stream.
+ */
+static inline uint32_t esp_apptrace_stream_level_get(esp_apptrace_stream_t *stream)
+{
+    return stream->level;
+}
+
+#if CONFIG_ESP32_APPTRACE_DEST_UART
+esp_err_t esp_apptrace_uart_init(void);
+esp_apptrace_hw_t *esp_apptrace_uart_hw_get(void);
+#endif
+
+#if CONFIG_ESP32_APPTRACE_DEST_NET
+esp_err_t esp_apptrace_net_init(void);
+esp_apptrace_hw_t *esp_apptrace_net_hw_get(void);
+#endif
+
+#endif //ESP_APP_TRACE_PORT_H_
@@ -161,6 +161,7 @@ unsigned     SEGGER_RTT_WriteString             (unsigned BufferIndex, const cha
 void         SEGGER_RTT_WriteWithOverwriteNoLock(unsigned BufferIndex, const void* pBuffer, unsigned NumBytes);
 void         SEGGER_RTT_ESP32_FlushNoLock       (unsigned long min_sz, unsigned long tmo);
 void         SEGGER_RTT_ESP32_Flush             (unsigned long min_sz, unsigned long tmo);
+unsigned long SEGGER_RTT_ESP32_GetDroppedEvents (void);
 //
 // Function macro for performance optimization
 //
@@ -63,6 +63,7 @@ Revision: $Rev: 3734 $
 */
 #include "freertos/FreeRTOS.h"
 #include "SEGGER_SYSVIEW.h"
+#include "SEGGER_SYSVIEW_FreeRTOS.h"
 #include "esp32/rom/ets_sys.h"
 #include "esp_app_trace.h"
 #include "esp_app_trace_util.h"
@@ -96,7 +97,7 @@ extern const SEGGER_SYSVIEW_OS_API SYSVIEW_X_OS_TraceAPI;
 #include "driver/timer.h"
 
 // Timer group timer divisor
-#define SYSVIEW_TIMER_DIV       2
+#define SYSVIEW_TIMER_DIV       CONFIG_SYSVIEW_TS_TIMER_DIV
 
 // Frequency of the timestamp.
 #define SYSVIEW_TIMESTAMP_FREQ  (esp_clk_apb_freq() / SYSVIEW_TIMER_DIV)
@@ -313,7 +314,11 @@ void SEGGER_SYSVIEW_Conf(void) {
 #if !CONFIG_SYSVIEW_EVT_TIMER_EXIT_ENABLE
     disable_evts |= SYSVIEW_EVTMASK_TIMER_EXIT;
 #endif
-  SEGGER_SYSVIEW_DisableEvents(disable_evts);
+  SYSVIEW_FilterInit(disable_evts);
+#if !CONFIG_ESP32_APPTRACE_DEST_TRAX
+  // UART and network destinations have no channel for the host to send start command, so start recording at once
+  SEGGER_SYSVIEW_Start();
+#endif
 }
 
 U32 SEGGER_SYSVIEW_X_GetTimestamp()
@@ -37,6 +37,8 @@ const static char *TAG = "segger_rtt";
 
 static uint8_t s_events_buf[SYSVIEW_EVENTS_BUF_SZ];
 static uint16_t s_events_buf_filled;
+// number of events which could not be stored and have been dropped
+static uint32_t s_events_dropped;
 static uint8_t s_down_buf[SYSVIEW_DOWN_BUF_SIZE];
 
 /*********************************************************************
@@ -64,13 +66,13 @@ void SEGGER_RTT_ESP32_FlushNoLock(unsigned long min_sz, unsigned long tmo)
 {
     esp_err_t res;
     if (s_events_buf_filled > 0) {
-      res = esp_apptrace_write(ESP_APPTRACE_DEST_TRAX, s_events_buf, s_events_buf_filled, tmo);
+      res = esp_apptrace_write(ESP_APPTRACE_DEST_DEFAULT, s_events_buf, s_events_buf_filled, tmo);
       if (res != ESP_OK) {
         ESP_LOGE(TAG, "Failed to flush buffered events (%d)!\n", res);
       }
     }
     // flush even if we failed to write buffered events, because no new events will be sent after STOP
-    res = esp_apptrace_flush_nolock(ESP_APPTRACE_DEST_TRAX, min_sz, tmo);
+    res = esp_apptrace_flush_nolock(ESP_APPTRACE_DEST_DEFAULT, min_sz, tmo);
     if (res != ESP_OK) {
       ESP_LOGE(TAG, "Failed to flush apptrace data (%d)!\n", res);
     }
@@ -117,7 +119,7 @@ void SEGGER_RTT_ESP32_Flush(unsigned long min_sz, unsigned long tmo)
 */
 unsigned SEGGER_RTT_ReadNoLock(unsigned BufferIndex, void* pData, unsigned BufferSize) {
   uint32_t size = BufferSize;
-  esp_err_t res = esp_apptrace_read(ESP_APPTRACE_DEST_TRAX, pData, &size, 0);
+  esp_err_t res = esp_apptrace_read(ESP_APPTRACE_DEST_DEFAULT, pData, &size, 0);
   if (res != ESP_OK) {
     return 0;
   }
@@ -154,6 +156,7 @@ unsigned SEGGER_RTT_WriteSkipNoLock(unsigned BufferIndex, const void* pBuffer, u
 
   if (NumBytes > SYSVIEW_EVENTS_BUF_SZ) {
       ESP_LOGE(TAG, "Too large event %u bytes!", NumBytes);
+      s_events_dropped++;
       return 0;
   }
   if (xPortGetCoreID()) { // dual core specific code
@@ -167,8 +170,9 @@ unsigned SEGGER_RTT_WriteSkipNoLock(unsigned BufferIndex, const void* pBuffer, u
     }
   }
   if (s_events_buf_filled + NumBytes > SYSVIEW_EVENTS_BUF_SZ) {
-    esp_err_t res = esp_apptrace_write(ESP_APPTRACE_DEST_TRAX, s_events_buf, s_events_buf_filled, SEGGER_HOST_WAIT_TMO);
+    esp_err_t res = esp_apptrace_write(ESP_APPTRACE_DEST_DEFAULT, s_events_buf, s_events_buf_filled, SEGGER_HOST_WAIT_TMO);
     if (res != ESP_OK) {
+      s_events_dropped++;
       return 0; // skip current data buffer only, accumulated events are kept
     }
     s_events_buf_filled = 0;
@@ -181,6 +185,18 @@ unsigned SEGGER_RTT_WriteSkipNoLock(unsigned BufferIndex, const void* pBuffer, u
   return NumBytes;
 }
 
+/*********************************************************************
+*
+*       SEGGER_RTT_ESP32_GetDroppedEvents()
+*
+*  Function description
+*    Returns the number of events which have been dropped because
+*    there was no space for them in the trace buffer.
+*/
+unsigned long SEGGER_RTT_ESP32_GetDroppedEvents(void) {
+  return s_events_dropped;
+}
+
 /*********************************************************************
 *
 *       SEGGER_RTT_ConfigUpBuffer
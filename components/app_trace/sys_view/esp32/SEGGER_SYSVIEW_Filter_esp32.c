@@ -0,0 +1,211 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Filtering and sampling of SystemView events.
+// Checks are done before SEGGER code takes its lock and reads the timestamp,
+// so filtered out events cost only a few instructions.
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "SEGGER_SYSVIEW.h"
+#include "SEGGER_SYSVIEW_FreeRTOS.h"
+#include "soc/soc.h"
+#include "esp_intr_alloc.h"
+#include "esp_sysview_trace.h"
+
+// IRQ IDs reported to SystemView are interrupt sources shifted by ETS_INTERNAL_INTR_SOURCE_OFF
+#define SYSVIEW_IRQ_ID_MAX              (ETS_CACHE_IA_INTR_SOURCE + ETS_INTERNAL_INTR_SOURCE_OFF + 1)
+
+#if CONFIG_FREERTOS_CORETIMER_0
+#define SYSVIEW_SYSTICK_INTR_ID         (ETS_INTERNAL_TIMER0_INTR_SOURCE + ETS_INTERNAL_INTR_SOURCE_OFF)
+#endif
+#if CONFIG_FREERTOS_CORETIMER_1
+#define SYSVIEW_SYSTICK_INTR_ID         (ETS_INTERNAL_TIMER1_INTR_SOURCE + ETS_INTERNAL_INTR_SOURCE_OFF)
+#endif
+
+#define SYSVIEW_MAX_FILTERED_TASKS      8
+// max nesting level of traced ISRs, deeper ones are always recorded
+#define SYSVIEW_MAX_ISR_NESTING         32
+
+// sampling period of every IRQ ID: 0 - never record, 1 - record every ISR, N - record one of N
+static U16 s_isr_period[SYSVIEW_IRQ_ID_MAX];
+static U16 s_isr_count[SYSVIEW_IRQ_ID_MAX];
+// per core: nesting level of traced ISRs and bitmap of levels whose enter event has been filtered out
+static U32 s_isr_nesting[portNUM_PROCESSORS];
+static U32 s_isr_skipped[portNUM_PROCESSORS];
+// events disabled via esp_sysview_disable_events(), checked before calling SEGGER code
+static volatile U32 s_disabled_evts;
+
+static U32 s_filtered_tasks[SYSVIEW_MAX_FILTERED_TASKS];
+static volatile unsigned s_filtered_tasks_num;
+static portMUX_TYPE s_filter_lock = portMUX_INITIALIZER_UNLOCKED;
+
+volatile U8 SYSVIEW_ApiEvtsOff;
+volatile U8 SYSVIEW_aTaskFiltered[portNUM_PROCESSORS];
+
+void SYSVIEW_FilterInit(U32 DisabledEvents)
+{
+    for (int i = 0; i < SYSVIEW_IRQ_ID_MAX; i++) {
+        s_isr_period[i] = CONFIG_SYSVIEW_ISR_SAMPLE_PERIOD;
+        s_isr_count[i] = 0;
+    }
+#if !CONFIG_SYSVIEW_EVT_SYSTICK_ENABLE
+    s_isr_period[SYSVIEW_SYSTICK_INTR_ID] = 0;
+#endif
+    esp_sysview_disable_events(DisabledEvents);
+}
+
+static inline bool sysview_isr_sample(U32 IrqId)
+{
+    if (IrqId >= SYSVIEW_IRQ_ID_MAX) {
+        return true;
+    }
+    U32 period = s_isr_period[IrqId];
+    if (period <= 1) {
+        return period == 1;
+    }
+    // counter is shared between cores, a race can only shift the sampling phase
+    U32 count = s_isr_count[IrqId];
+    s_isr_count[IrqId] = (count == 0) ? period - 1 : count - 1;
+    return count == 0;
+}
+
+void SYSVIEW_RecordEnterISR(U32 IrqId)
+{
+    int core = xPortGetCoreID();
+    U32 level = s_isr_nesting[core]++;
+    bool record = sysview_isr_sample(IrqId);
+
+    if (level < SYSVIEW_MAX_ISR_NESTING) {
+        if (record) {
+            s_isr_skipped[core] &= ~(1UL << level);
+        } else {
+            s_isr_skipped[core] |= 1UL << level;
+        }
+    } else {
+        record = true;
+    }
+    if (record && !(s_disabled_evts & SYSVIEW_EVTMASK_ISR_ENTER)) {
+        SEGGER_SYSVIEW_RecordEnterISR(IrqId);
+    }
+}
+
+/* Returns true if exit event should be recorded for the innermost traced ISR */
+static inline bool sysview_isr_leave(void)
+{
+    int core = xPortGetCoreID();
+    if (s_isr_nesting[core] == 0) {
+        // ISR which has not been traced on enter
+        return true;
+    }
+    U32 level = --s_isr_nesting[core];
+    return level >= SYSVIEW_MAX_ISR_NESTING || !(s_isr_skipped[core] & (1UL << level));
+}
+
+void SYSVIEW_RecordExitISR(void)
+{
+    if (sysview_isr_leave() && !(s_disabled_evts & SYSVIEW_EVTMASK_ISR_EXIT)) {
+        SEGGER_SYSVIEW_RecordExitISR();
+    }
+}
+
+void SYSVIEW_RecordExitISRToScheduler(void)
+{
+    if (sysview_isr_leave() && !(s_disabled_evts & SYSVIEW_EVTMASK_ISR_TO_SCHEDULER)) {
+        SEGGER_SYSVIEW_RecordExitISRToScheduler();
+    }
+}
+
+static bool sysview_task_filtered(U32 xHandle)
+{
+    for (unsigned i = 0; i < s_filtered_tasks_num; i++) {
+        if (s_filtered_tasks[i] == xHandle) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SYSVIEW_OnTaskSwitchedIn(U32 xHandle)
+{
+    int core = xPortGetCoreID();
+    // Context is switched on exit from the outermost interrupt, so no traced ISRs are running on this core.
+    // This also drops nesting levels of ISRs which have yielded to scheduler and been followed by other ISRs.
+    s_isr_nesting[core] = 0;
+    SYSVIEW_aTaskFiltered[core] = s_filtered_tasks_num && sysview_task_filtered(xHandle);
+}
+
+esp_err_t esp_sysview_set_isr_sampling(int source, uint32_t period)
+{
+    int id = source + ETS_INTERNAL_INTR_SOURCE_OFF;
+    if (id < 0 || id >= SYSVIEW_IRQ_ID_MAX || period > UINT16_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&s_filter_lock);
+    s_isr_period[id] = period;
+    s_isr_count[id] = 0;
+    portEXIT_CRITICAL(&s_filter_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_sysview_set_task_filter(TaskHandle_t task, bool enable)
+{
+    esp_err_t res = ESP_OK;
+    U32 handle = (U32)(task ? task : xTaskGetCurrentTaskHandle());
+
+    portENTER_CRITICAL(&s_filter_lock);
+    bool filtered = sysview_task_filtered(handle);
+    if (!enable && !filtered) {
+        if (s_filtered_tasks_num < SYSVIEW_MAX_FILTERED_TASKS) {
+            s_filtered_tasks[s_filtered_tasks_num++] = handle;
+        } else {
+            res = ESP_ERR_NO_MEM;
+        }
+    } else if (enable && filtered) {
+        for (unsigned i = 0; i < s_filtered_tasks_num; i++) {
+            if (s_filtered_tasks[i] == handle) {
+                s_filtered_tasks[i] = s_filtered_tasks[--s_filtered_tasks_num];
+                break;
+            }
+        }
+    }
+    // takes effect for the running task at once, other tasks are checked when switched in
+    if (res == ESP_OK && handle == (U32)xTaskGetCurrentTaskHandle()) {
+        SYSVIEW_aTaskFiltered[xPortGetCoreID()] = !enable;
+    }
+    portEXIT_CRITICAL(&s_filter_lock);
+    return res;
+}
+
+void esp_sysview_enable_events(uint32_t evt_mask)
+{
+    portENTER_CRITICAL(&s_filter_lock);
+    s_disabled_evts &= ~evt_mask;
+    if (evt_mask & ESP_SYSVIEW_EVTMASK_API) {
+        SYSVIEW_ApiEvtsOff = 0;
+    }
+    SEGGER_SYSVIEW_EnableEvents(evt_mask & ~ESP_SYSVIEW_EVTMASK_API);
+    portEXIT_CRITICAL(&s_filter_lock);
+}
+
+void esp_sysview_disable_events(uint32_t evt_mask)
+{
+    portENTER_CRITICAL(&s_filter_lock);
+    s_disabled_evts |= evt_mask;
+    if (evt_mask & ESP_SYSVIEW_EVTMASK_API) {
+        SYSVIEW_ApiEvtsOff = 1;
+    }
+    SEGGER_SYSVIEW_DisableEvents(evt_mask & ~ESP_SYSVIEW_EVTMASK_API);
+    portEXIT_CRITICAL(&s_filter_lock);
+}
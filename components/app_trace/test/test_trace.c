@@ -729,6 +729,39 @@ TEST_CASE("App trace test (2 tasks: 1 @ each core)", "[trace][ignore]")
 }
 #endif
 
+TEST_CASE("App trace statistics count sent blocks", "[trace]")
+{
+    esp_apptrace_stats_t stats;
+    uint8_t buf[ESP_APPTRACE_TEST_BLOCK_SIZE];
+
+    memset(buf, 0xA5, sizeof(buf));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_apptrace_get_stats(ESP_APPTRACE_DEST_DEFAULT, NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_apptrace_reset_stats(ESP_APPTRACE_DEST_DEFAULT));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_apptrace_get_stats(ESP_APPTRACE_DEST_DEFAULT, &stats));
+    TEST_ASSERT_EQUAL(0, stats.blocks_sent);
+    TEST_ASSERT_EQUAL(0, stats.failed_requests);
+
+    for (int i = 0; i < 40; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_apptrace_write(ESP_APPTRACE_DEST_DEFAULT, buf, sizeof(buf), ESP_APPTRACE_TMO_INFINITE));
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, esp_apptrace_flush(ESP_APPTRACE_DEST_DEFAULT, ESP_APPTRACE_TMO_INFINITE));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_apptrace_get_stats(ESP_APPTRACE_DEST_DEFAULT, &stats));
+#if CONFIG_ESP32_APPTRACE_DEST_TRAX
+    // without host trace memory blocks are switched as soon as they are full (post-mortem mode),
+    // 40 KB of data need at least two switches
+    if (!esp_apptrace_host_is_connected(ESP_APPTRACE_DEST_TRAX)) {
+        TEST_ASSERT_GREATER_OR_EQUAL(2, stats.blocks_sent);
+        TEST_ASSERT_EQUAL(0, stats.bytes_sent);
+    }
+#elif CONFIG_ESP32_APPTRACE_DEST_UART
+    // UART sends every user block as is
+    TEST_ASSERT_EQUAL(40, stats.blocks_sent);
+    TEST_ASSERT_EQUAL(40 * sizeof(buf), stats.bytes_sent);
+#endif
+    TEST_ASSERT_EQUAL(0, stats.failed_requests);
+    TEST_ASSERT_EQUAL(0, stats.failed_bytes);
+}
+
 TEST_CASE("App trace test (1 task)", "[trace][ignore]")
 {
     esp_apptrace_test_cfg_t test_cfg = {
@@ -828,6 +861,8 @@ TEST_CASE("Log trace test (2 tasks)", "[trace][ignore]")
 
 #else
 
+#include "esp_sysview_trace.h"
+
 typedef struct {
     int group;
     int timer;
@@ -1054,5 +1089,37 @@ TEST_CASE("SysView trace test 2", "[trace][ignore]")
     vSemaphoreDelete(arg4.done);
     vSemaphoreDelete(test_sync);
 }
+
+TEST_CASE("SysView filter settings are checked", "[trace]")
+{
+    static int dummy_tasks[8];
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_sysview_set_isr_sampling(ETS_INTERNAL_PROFILING_INTR_SOURCE - 1, 1));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_sysview_set_isr_sampling(ETS_CACHE_IA_INTR_SOURCE + 1, 1));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_sysview_set_isr_sampling(ETS_GPIO_INTR_SOURCE, 65536));
+    TEST_ESP_OK(esp_sysview_set_isr_sampling(ETS_GPIO_INTR_SOURCE, 4));
+    TEST_ESP_OK(esp_sysview_set_isr_sampling(ETS_INTERNAL_PROFILING_INTR_SOURCE, 0));
+    TEST_ESP_OK(esp_sysview_set_isr_sampling(ETS_GPIO_INTR_SOURCE, CONFIG_SYSVIEW_ISR_SAMPLE_PERIOD));
+    TEST_ESP_OK(esp_sysview_set_isr_sampling(ETS_INTERNAL_PROFILING_INTR_SOURCE, CONFIG_SYSVIEW_ISR_SAMPLE_PERIOD));
+
+    // excluding a task twice takes one slot
+    TEST_ESP_OK(esp_sysview_set_task_filter(NULL, false));
+    TEST_ESP_OK(esp_sysview_set_task_filter(NULL, false));
+    for (int i = 0; i < 7; i++) {
+        TEST_ESP_OK(esp_sysview_set_task_filter((TaskHandle_t)&dummy_tasks[i], false));
+    }
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, esp_sysview_set_task_filter((TaskHandle_t)&dummy_tasks[7], false));
+    // API events of filtered task are not recorded, the calls must work as usual
+    vTaskDelay(1);
+    TEST_ESP_OK(esp_sysview_set_task_filter(NULL, true));
+    TEST_ESP_OK(esp_sysview_set_task_filter((TaskHandle_t)&dummy_tasks[7], false));
+    for (int i = 0; i < 8; i++) {
+        TEST_ESP_OK(esp_sysview_set_task_filter((TaskHandle_t)&dummy_tasks[i], true));
+    }
+
+    esp_sysview_disable_events(ESP_SYSVIEW_EVTMASK_API);
+    vTaskDelay(1);
+    esp_sysview_enable_events(ESP_SYSVIEW_EVTMASK_API);
+}
 #endif
 #endif
@@ -0,0 +1,358 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_spi_flash.h"
+#include "esp_flash_partitions.h"
+#include "bootloader_common.h"
+#include "sys/param.h"
+#include "esp_ota_ops.h"
+#include "esp_ota_delta.h"
+
+#define DELTA_MAX_ARGS 2
+
+typedef enum {
+    DELTA_STATE_HEADER,         // receiving esp_ota_delta_header_t
+    DELTA_STATE_OP,             // expecting an operation byte
+    DELTA_STATE_ARGS,           // receiving the arguments of the operation
+    DELTA_STATE_INSERT_DATA,    // receiving the bytes of an INSERT operation
+    DELTA_STATE_DIFF_PAIR,      // receiving the lengths of the next pair of a DIFF operation
+    DELTA_STATE_DIFF_DATA,      // receiving the diff bytes of a DIFF pair
+    DELTA_STATE_DONE,           // END operation received
+} delta_state_t;
+
+struct esp_ota_delta {
+    esp_ota_handle_t ota_handle;
+    const esp_partition_t *source;
+    esp_ota_delta_header_t header;
+    size_t header_len;
+    esp_err_t error;
+    delta_state_t state;
+    uint8_t op;
+    uint32_t args[DELTA_MAX_ARGS];
+    int arg_count;
+    int arg_index;
+    uint32_t varint;
+    int varint_shift;
+    uint32_t src_offset;        // next byte of the source used by the current operation
+    uint32_t op_remaining;      // bytes of the target still produced by the current operation
+    uint32_t diff_remaining;    // diff bytes still expected in the current DIFF pair
+    uint32_t target_written;    // bytes of the target produced so far
+    size_t buf_len;
+    uint8_t buf[SPI_FLASH_SEC_SIZE]; // target bytes not yet passed to esp_ota_write
+};
+
+static const char *TAG = "esp_ota_delta";
+
+esp_err_t esp_ota_delta_begin(const esp_partition_t *partition, esp_ota_delta_handle_t *out_handle)
+{
+    if (partition == NULL || out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const esp_partition_t *source = esp_ota_get_running_partition();
+    if (source == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    struct esp_ota_delta *d = calloc(1, sizeof(struct esp_ota_delta));
+    if (d == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t err = esp_ota_begin(partition, OTA_SIZE_UNKNOWN, &d->ota_handle);
+    if (err != ESP_OK) {
+        free(d);
+        return err;
+    }
+    d->source = source;
+    d->state = DELTA_STATE_HEADER;
+    *out_handle = d;
+    return ESP_OK;
+}
+
+static esp_err_t flush_target(struct esp_ota_delta *d)
+{
+    if (d->buf_len == 0) {
+        return ESP_OK;
+    }
+    esp_err_t err = esp_ota_write(d->ota_handle, d->buf, d->buf_len);
+    d->buf_len = 0;
+    return err;
+}
+
+static esp_err_t check_header(struct esp_ota_delta *d)
+{
+    const esp_ota_delta_header_t *h = &d->header;
+    if (h->magic != ESP_OTA_DELTA_MAGIC || h->version != ESP_OTA_DELTA_VERSION) {
+        ESP_LOGE(TAG, "Not a delta patch (magic 0x%x version %d)", h->magic, h->version);
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    if (h->source_size == 0 || h->source_size > d->source->size || h->target_size == 0) {
+        ESP_LOGE(TAG, "Invalid patch sizes (source %d target %d)", h->source_size, h->target_size);
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    uint8_t sha256[sizeof(h->source_sha256)];
+    esp_err_t err = bootloader_common_get_sha256_of_partition(d->source->address, h->source_size, PART_TYPE_DATA, sha256);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (memcmp(sha256, h->source_sha256, sizeof(sha256)) != 0) {
+        ESP_LOGE(TAG, "Patch was not created for the running app");
+        return ESP_ERR_OTA_DELTA_SOURCE_MISMATCH;
+    }
+    return ESP_OK;
+}
+
+/* Check that an operation using len bytes of the source at src_offset stays within the source and the target */
+static bool range_is_valid(const struct esp_ota_delta *d, uint32_t src_offset, uint32_t len)
+{
+    return src_offset <= d->header.source_size && len <= d->header.source_size - src_offset
+        && len <= d->header.target_size - d->target_written;
+}
+
+/* Append len bytes of the source at src_offset to the target */
+static esp_err_t copy_source(struct esp_ota_delta *d, uint32_t src_offset, uint32_t len)
+{
+    while (len > 0) {
+        size_t n = MIN(len, sizeof(d->buf) - d->buf_len);
+        esp_err_t err = esp_partition_read(d->source, src_offset, d->buf + d->buf_len, n);
+        if (err != ESP_OK) {
+            return err;
+        }
+        d->buf_len += n;
+        d->target_written += n;
+        src_offset += n;
+        len -= n;
+        if (d->buf_len == sizeof(d->buf)) {
+            err = flush_target(d);
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+/* Append up to len bytes of the patch to the target, adding them to the source bytes at src_offset
+   if diff is true. Returns the number of bytes used, which is limited by the space in the buffer. */
+static size_t copy_patch(struct esp_ota_delta *d, const uint8_t *data, size_t len, bool diff)
+{
+    size_t n = MIN(len, sizeof(d->buf) - d->buf_len);
+    uint8_t *out = d->buf + d->buf_len;
+    if (diff) {
+        d->error = esp_partition_read(d->source, d->src_offset, out, n);
+        if (d->error != ESP_OK) {
+            return 0;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            out[i] += data[i];
+        }
+        d->src_offset += n;
+    } else {
+        memcpy(out, data, n);
+    }
+    d->buf_len += n;
+    d->target_written += n;
+    if (d->buf_len == sizeof(d->buf)) {
+        d->error = flush_target(d);
+    }
+    return n;
+}
+
+/* Parse the next byte of an unsigned LEB128 number, returns true when the number is complete */
+static bool parse_varint(struct esp_ota_delta *d, uint8_t b)
+{
+    if (d->varint_shift > 28 || (d->varint_shift == 28 && (b & 0xf0) != 0)) {
+        d->error = ESP_ERR_OTA_VALIDATE_FAILED;
+        return false;
+    }
+    d->varint |= (uint32_t) (b & 0x7f) << d->varint_shift;
+    d->varint_shift += 7;
+    return (b & 0x80) == 0;
+}
+
+static void expect_args(struct esp_ota_delta *d, delta_state_t state, int count)
+{
+    d->state = state;
+    d->arg_count = count;
+    d->arg_index = 0;
+    d->varint = 0;
+    d->varint_shift = 0;
+}
+
+static void start_op(struct esp_ota_delta *d)
+{
+    const uint32_t offset = d->args[0];
+    const uint32_t len = d->args[d->arg_count - 1];
+    switch (d->op) {
+    case ESP_OTA_DELTA_OP_COPY:
+        if (!range_is_valid(d, offset, len)) {
+            break;
+        }
+        d->error = copy_source(d, offset, len);
+        d->state = DELTA_STATE_OP;
+        return;
+    case ESP_OTA_DELTA_OP_INSERT:
+        if (len > d->header.target_size - d->target_written) {
+            break;
+        }
+        d->op_remaining = len;
+        d->state = (len > 0) ? DELTA_STATE_INSERT_DATA : DELTA_STATE_OP;
+        return;
+    case ESP_OTA_DELTA_OP_DIFF:
+        if (!range_is_valid(d, offset, len)) {
+            break;
+        }
+        d->src_offset = offset;
+        d->op_remaining = len;
+        if (len > 0) {
+            expect_args(d, DELTA_STATE_DIFF_PAIR, 2);
+        } else {
+            d->state = DELTA_STATE_OP;
+        }
+        return;
+    }
+    ESP_LOGE(TAG, "Operation %d out of range (0x%x, 0x%x) at target offset 0x%x", d->op, offset, len, d->target_written);
+    d->error = ESP_ERR_OTA_VALIDATE_FAILED;
+}
+
+static void start_diff_pair(struct esp_ota_delta *d)
+{
+    const uint32_t same = d->args[0];
+    const uint32_t diff = d->args[1];
+    if ((same == 0 && diff == 0) || same > d->op_remaining || diff > d->op_remaining - same) {
+        ESP_LOGE(TAG, "Invalid diff (0x%x, 0x%x) at target offset 0x%x", same, diff, d->target_written);
+        d->error = ESP_ERR_OTA_VALIDATE_FAILED;
+        return;
+    }
+    d->error = copy_source(d, d->src_offset, same);
+    d->src_offset += same;
+    d->op_remaining -= same;
+    d->diff_remaining = diff;
+    if (diff > 0) {
+        d->state = DELTA_STATE_DIFF_DATA;
+    } else if (d->op_remaining > 0) {
+        expect_args(d, DELTA_STATE_DIFF_PAIR, 2);
+    } else {
+        d->state = DELTA_STATE_OP;
+    }
+}
+
+esp_err_t esp_ota_delta_write(esp_ota_delta_handle_t d, const void *data, size_t size)
+{
+    if (d == NULL || (data == NULL && size > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const uint8_t *p = (const uint8_t *) data;
+    const uint8_t *end = p + size;
+    while (p < end && d->error == ESP_OK) {
+        size_t n;
+        switch (d->state) {
+        case DELTA_STATE_HEADER:
+            n = MIN((size_t) (end - p), sizeof(d->header) - d->header_len);
+            memcpy((uint8_t *) &d->header + d->header_len, p, n);
+            d->header_len += n;
+            p += n;
+            if (d->header_len == sizeof(d->header)) {
+                d->error = check_header(d);
+                d->state = DELTA_STATE_OP;
+            }
+            break;
+        case DELTA_STATE_OP:
+            d->op = *p++;
+            if (d->op == ESP_OTA_DELTA_OP_END) {
+                d->state = DELTA_STATE_DONE;
+            } else if (d->op == ESP_OTA_DELTA_OP_INSERT) {
+                expect_args(d, DELTA_STATE_ARGS, 1);
+            } else if (d->op == ESP_OTA_DELTA_OP_COPY || d->op == ESP_OTA_DELTA_OP_DIFF) {
+                expect_args(d, DELTA_STATE_ARGS, 2);
+            } else {
+                ESP_LOGE(TAG, "Invalid operation %d at target offset 0x%x", d->op, d->target_written);
+                d->error = ESP_ERR_OTA_VALIDATE_FAILED;
+            }
+            break;
+        case DELTA_STATE_ARGS:
+        case DELTA_STATE_DIFF_PAIR:
+            if (!parse_varint(d, *p++)) {
+                break;
+            }
+            d->args[d->arg_index++] = d->varint;
+            d->varint = 0;
+            d->varint_shift = 0;
+            if (d->arg_index < d->arg_count) {
+                break;
+            }
+            if (d->state == DELTA_STATE_ARGS) {
+                start_op(d);
+            } else {
+                start_diff_pair(d);
+            }
+            break;
+        case DELTA_STATE_INSERT_DATA:
+            n = copy_patch(d, p, MIN((size_t) (end - p), d->op_remaining), false);
+            p += n;
+            d->op_remaining -= n;
+            if (d->op_remaining == 0) {
+                d->state = DELTA_STATE_OP;
+            }
+            break;
+        case DELTA_STATE_DIFF_DATA:
+            n = copy_patch(d, p, MIN((size_t) (end - p), d->diff_remaining), true);
+            p += n;
+            d->op_remaining -= n;
+            d->diff_remaining -= n;
+            if (d->diff_remaining > 0) {
+                break;
+            }
+            if (d->op_remaining > 0) {
+                expect_args(d, DELTA_STATE_DIFF_PAIR, 2);
+            } else {
+                d->state = DELTA_STATE_OP;
+            }
+            break;
+        case DELTA_STATE_DONE:
+            ESP_LOGE(TAG, "Unexpected data after the end of the patch");
+            d->error = ESP_ERR_OTA_VALIDATE_FAILED;
+            break;
+        }
+    }
+    return d->error;
+}
+
+esp_err_t esp_ota_delta_end(esp_ota_delta_handle_t d)
+{
+    if (d == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = d->error;
+    if (err == ESP_OK) {
+        err = flush_target(d);
+    }
+    if (err == ESP_OK && (d->state != DELTA_STATE_DONE || d->target_written != d->header.target_size)) {
+        ESP_LOGE(TAG, "Patch is incomplete (0x%x of 0x%x bytes)", d->target_written, d->header.target_size);
+        err = ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    /* esp_ota_end() also releases the OTA handle, so it is called even after an error */
+    esp_err_t end_err = esp_ota_end(d->ota_handle);
+    free(d);
+    return (err != ESP_OK) ? err : end_err;
+}
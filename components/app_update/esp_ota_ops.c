@@ -19,6 +19,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
+#include <sys/lock.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
@@ -41,17 +42,35 @@
 #include "sys/param.h"
 #include "esp_system.h"
 #include "esp_efuse.h"
+#ifdef CONFIG_APP_UPDATE_COMPRESSED_IMAGE
+#include "esp32/rom/miniz.h"
+#endif
 
 
 #define SUB_TYPE_ID(i) (i & 0x0F) 
 
+#ifdef CONFIG_APP_UPDATE_COMPRESSED_IMAGE
+/* State of the decompression of a zlib compressed image */
+typedef struct {
+    tinfl_decompressor inflator;
+    bool done;              /* end of the compressed stream was reached */
+    size_t window_size;     /* size of the deflate window of the stream */
+    size_t window_ofs;      /* where the next output is written to */
+    uint8_t window[];       /* output buffer, also used as the deflate dictionary */
+} ota_inflate_t;
+#endif
+
 typedef struct ota_ops_entry_ {
     uint32_t handle;
     const esp_partition_t *part;
+    uint32_t image_size;
     uint32_t erased_size;
     uint32_t wrote_size;
-    uint8_t partial_bytes;
-    uint8_t partial_data[16];
+    uint8_t *buf;            /* with flash encryption or compression, data is staged here so that whole sectors are written */
+    size_t buf_len;
+#ifdef CONFIG_APP_UPDATE_COMPRESSED_IMAGE
+    ota_inflate_t *inflate;
+#endif
     LIST_ENTRY(ota_ops_entry_) entries;
 } ota_ops_entry_t;
 
@@ -60,6 +79,12 @@ static LIST_HEAD(ota_ops_entries_head, ota_ops_entry_) s_ota_ops_entries_head =
 
 static uint32_t s_ota_ops_last_handle = 0;
 
+/* Protects s_ota_ops_entries_head and s_ota_ops_last_entry, so updates of different partitions can run in parallel */
+static _lock_t s_ota_ops_lock;
+
+/* Entry used most recently, so that esp_ota_write() usually finds it without walking the list */
+static ota_ops_entry_t *s_ota_ops_last_entry = NULL;
+
 const static char *TAG = "esp_ota_ops";
 
 /* Return true if this is an OTA app partition */
@@ -124,7 +149,6 @@ static esp_ota_img_states_t set_new_state_otadata(void)
 esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t image_size, esp_ota_handle_t *out_handle)
 {
     ota_ops_entry_t *new_entry;
-    esp_err_t ret = ESP_OK;
 
     if ((partition == NULL) || (out_handle == NULL)) {
         return ESP_ERR_INVALID_ARG;
@@ -154,15 +178,8 @@ esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t image_size, esp
     }
 #endif
 
-    // If input image size is 0 or OTA_SIZE_UNKNOWN, erase entire partition
-    if ((image_size == 0) || (image_size == OTA_SIZE_UNKNOWN)) {
-        ret = esp_partition_erase_range(partition, 0, partition->size);
-    } else {
-        ret = esp_partition_erase_range(partition, 0, (image_size / SPI_FLASH_SEC_SIZE + 1) * SPI_FLASH_SEC_SIZE);
-    }
-
-    if (ret != ESP_OK) {
-        return ret;
+    if (partition->address + partition->size > spi_flash_get_chip_size()) {
+        return ESP_ERR_INVALID_SIZE;
     }
 
     new_entry = (ota_ops_entry_t *) calloc(sizeof(ota_ops_entry_t), 1);
@@ -170,24 +187,208 @@ esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t image_size, esp
         return ESP_ERR_NO_MEM;
     }
 
-    LIST_INSERT_HEAD(&s_ota_ops_entries_head, new_entry, entries);
+    if (esp_flash_encryption_enabled()) {
+        new_entry->buf = malloc(SPI_FLASH_SEC_SIZE);
+        if (new_entry->buf == NULL) {
+            free(new_entry);
+            return ESP_ERR_NO_MEM;
+        }
+    }
 
+    // The partition is erased by esp_ota_write(), just ahead of the data
     if ((image_size == 0) || (image_size == OTA_SIZE_UNKNOWN)) {
-        new_entry->erased_size = partition->size;
+        new_entry->image_size = partition->size;
     } else {
-        new_entry->erased_size = image_size;
+        new_entry->image_size = MIN(image_size, partition->size);
     }
 
     new_entry->part = partition;
+
+    _lock_acquire(&s_ota_ops_lock);
     new_entry->handle = ++s_ota_ops_last_handle;
+    LIST_INSERT_HEAD(&s_ota_ops_entries_head, new_entry, entries);
+    s_ota_ops_last_entry = new_entry;
+    _lock_release(&s_ota_ops_lock);
+
     *out_handle = new_entry->handle;
     return ESP_OK;
 }
 
+/* Find the entry of a handle, or return NULL. If remove is true, the entry is also removed from the list. */
+static ota_ops_entry_t *ota_find_entry(esp_ota_handle_t handle, bool remove)
+{
+    _lock_acquire(&s_ota_ops_lock);
+    ota_ops_entry_t *it = s_ota_ops_last_entry;
+    if (it == NULL || it->handle != handle) {
+        for (it = LIST_FIRST(&s_ota_ops_entries_head); it != NULL; it = LIST_NEXT(it, entries)) {
+            if (it->handle == handle) {
+                break;
+            }
+        }
+    }
+    if (it != NULL && remove) {
+        LIST_REMOVE(it, entries);
+        if (s_ota_ops_last_entry == it) {
+            s_ota_ops_last_entry = NULL;
+        }
+    } else if (it != NULL) {
+        s_ota_ops_last_entry = it;
+    }
+    _lock_release(&s_ota_ops_lock);
+    return it;
+}
+
+/* Erase the partition up to the sector containing byte end - 1, if not erased yet */
+static esp_err_t ota_erase_ahead(ota_ops_entry_t *it, uint32_t end)
+{
+    const uint32_t block_size = 64 * 1024;
+    const uint32_t image_end = (it->image_size + SPI_FLASH_SEC_SIZE - 1) & ~(SPI_FLASH_SEC_SIZE - 1);
+    esp_err_t ret = ESP_OK;
+    while (it->erased_size < end && it->erased_size < it->part->size) {
+        // erasing a 64 KB block is much faster than erasing its sectors one by one,
+        // use it as long as the whole block belongs to the image
+        uint32_t erase_size = SPI_FLASH_SEC_SIZE;
+        if (it->erased_size % block_size == 0 && it->erased_size + block_size <= image_end) {
+            erase_size = block_size;
+        }
+        ret = esp_partition_erase_range(it->part, it->erased_size, erase_size);
+        if (ret != ESP_OK) {
+            break;
+        }
+        it->erased_size += erase_size;
+    }
+    return ret;
+}
+
+/* Write data to the partition after the data written so far */
+static esp_err_t ota_write_flash(ota_ops_entry_t *it, const uint8_t *data_bytes, size_t size)
+{
+    esp_err_t ret = ota_erase_ahead(it, it->wrote_size + size);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = esp_partition_write(it->part, it->wrote_size, data_bytes, size);
+    if (ret == ESP_OK) {
+        it->wrote_size += size;
+    }
+    return ret;
+}
+
+/* Write a part of the app image to the partition */
+static esp_err_t ota_write_image(ota_ops_entry_t *it, const uint8_t *data_bytes, size_t size)
+{
+    esp_err_t ret;
+
+    if (it->wrote_size == 0 && it->buf_len == 0 && size > 0 && data_bytes[0] != ESP_IMAGE_HEADER_MAGIC) {
+        ESP_LOGE(TAG, "OTA image has invalid magic byte (expected 0xE9, saw 0x%02x", data_bytes[0]);
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+
+    if (it->buf == NULL) {
+        return ota_write_flash(it, data_bytes, size);
+    }
+
+    /* Flash encryption needs 16 byte blocks and writing whole sectors is fastest,
+       so the data is staged and written a sector at a time */
+    while (size > 0) {
+        if (it->buf_len == 0 && size >= SPI_FLASH_SEC_SIZE) {
+            /* whole sectors, no need to copy them */
+            const size_t len = size & ~(SPI_FLASH_SEC_SIZE - 1);
+            ret = ota_write_flash(it, data_bytes, len);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+            data_bytes += len;
+            size -= len;
+            continue;
+        }
+        const size_t copy_len = MIN(SPI_FLASH_SEC_SIZE - it->buf_len, size);
+        memcpy(it->buf + it->buf_len, data_bytes, copy_len);
+        it->buf_len += copy_len;
+        data_bytes += copy_len;
+        size -= copy_len;
+        if (it->buf_len == SPI_FLASH_SEC_SIZE) {
+            ret = ota_write_flash(it, it->buf, SPI_FLASH_SEC_SIZE);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+            it->buf_len = 0;
+        }
+    }
+    return ESP_OK;
+}
+
+#ifdef CONFIG_APP_UPDATE_COMPRESSED_IMAGE
+/* Return true if the image starts with the first byte of a zlib header (deflate method), rather than ESP_IMAGE_HEADER_MAGIC */
+static bool is_zlib_header(uint8_t cmf)
+{
+    return (cmf & 0x0F) == 8 && (cmf >> 4) <= 7;
+}
+
+static esp_err_t ota_inflate_begin(ota_ops_entry_t *it, uint8_t cmf)
+{
+    // the window size is given by the stream, images compressed with a smaller window need less memory
+    const size_t window_size = 1 << ((cmf >> 4) + 8);
+    it->inflate = malloc(sizeof(ota_inflate_t) + window_size);
+    if (it->inflate == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    // the decompressor outputs small pieces, stage them to write whole sectors
+    if (it->buf == NULL) {
+        it->buf = malloc(SPI_FLASH_SEC_SIZE);
+        if (it->buf == NULL) {
+            free(it->inflate);
+            it->inflate = NULL;
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    tinfl_init(&it->inflate->inflator);
+    it->inflate->done = false;
+    it->inflate->window_size = window_size;
+    it->inflate->window_ofs = 0;
+    // the size of the decompressed image is unknown, but the partition holds it
+    it->image_size = it->part->size;
+    ESP_LOGD(TAG, "Compressed image, window size %d", window_size);
+    return ESP_OK;
+}
+
+/* Decompress a part of the image and write the output to the partition */
+static esp_err_t ota_inflate_write(ota_ops_entry_t *it, const uint8_t *data_bytes, size_t size)
+{
+    ota_inflate_t *inflate = it->inflate;
+    tinfl_status status = TINFL_STATUS_NEEDS_MORE_INPUT;
+    while (!inflate->done && (size > 0 || status == TINFL_STATUS_HAS_MORE_OUTPUT)) {
+        size_t in_size = size;
+        size_t out_size = inflate->window_size - inflate->window_ofs;
+        uint8_t *out = inflate->window + inflate->window_ofs;
+        status = tinfl_decompress(&inflate->inflator, data_bytes, &in_size, inflate->window, out, &out_size,
+                                  TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_HAS_MORE_INPUT);
+        if (status < TINFL_STATUS_DONE) {
+            ESP_LOGE(TAG, "Compressed image is invalid (%d)", status);
+            return ESP_ERR_OTA_VALIDATE_FAILED;
+        }
+        data_bytes += in_size;
+        size -= in_size;
+        if (out_size > 0) {
+            esp_err_t ret = ota_write_image(it, out, out_size);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+            inflate->window_ofs = (inflate->window_ofs + out_size) & (inflate->window_size - 1);
+        }
+        inflate->done = (status == TINFL_STATUS_DONE);
+    }
+    if (size > 0) {
+        ESP_LOGE(TAG, "Unexpected data after the end of the compressed image");
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    return ESP_OK;
+}
+#endif // CONFIG_APP_UPDATE_COMPRESSED_IMAGE
+
 esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size)
 {
     const uint8_t *data_bytes = (const uint8_t *)data;
-    esp_err_t ret;
     ota_ops_entry_t *it;
 
     if (data == NULL) {
@@ -195,59 +396,24 @@ esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size)
         return ESP_ERR_INVALID_ARG;
     }
 
-    // find ota handle in linked list
-    for (it = LIST_FIRST(&s_ota_ops_entries_head); it != NULL; it = LIST_NEXT(it, entries)) {
-        if (it->handle == handle) {
-            // must erase the partition before writing to it
-            assert(it->erased_size > 0 && "must erase the partition before writing to it");
-            if (it->wrote_size == 0 && it->partial_bytes == 0 && size > 0 && data_bytes[0] != ESP_IMAGE_HEADER_MAGIC) {
-                ESP_LOGE(TAG, "OTA image has invalid magic byte (expected 0xE9, saw 0x%02x", data_bytes[0]);
-                return ESP_ERR_OTA_VALIDATE_FAILED;
-            }
-
-            if (esp_flash_encryption_enabled()) {
-                /* Can only write 16 byte blocks to flash, so need to cache anything else */
-                size_t copy_len;
-
-                /* check if we have partially written data from earlier */
-                if (it->partial_bytes != 0) {
-                    copy_len = MIN(16 - it->partial_bytes, size);
-                    memcpy(it->partial_data + it->partial_bytes, data_bytes, copy_len);
-                    it->partial_bytes += copy_len;
-                    if (it->partial_bytes != 16) {
-                        return ESP_OK; /* nothing to write yet, just filling buffer */
-                    }
-                    /* write 16 byte to partition */
-                    ret = esp_partition_write(it->part, it->wrote_size, it->partial_data, 16);
-                    if (ret != ESP_OK) {
-                        return ret;
-                    }
-                    it->partial_bytes = 0;
-                    memset(it->partial_data, 0xFF, 16);
-                    it->wrote_size += 16;
-                    data_bytes += copy_len;
-                    size -= copy_len;
-                }
-
-                /* check if we need to save trailing data that we're about to write */
-                it->partial_bytes = size % 16;
-                if (it->partial_bytes != 0) {
-                    size -= it->partial_bytes;
-                    memcpy(it->partial_data, data_bytes + size, it->partial_bytes);
-                }
-            }
+    it = ota_find_entry(handle, false);
+    if (it == NULL) {
+        ESP_LOGE(TAG,"not found the handle");
+        return ESP_ERR_INVALID_ARG;
+    }
 
-            ret = esp_partition_write(it->part, it->wrote_size, data_bytes, size);
-            if(ret == ESP_OK){
-                it->wrote_size += size;
-            }
+#ifdef CONFIG_APP_UPDATE_COMPRESSED_IMAGE
+    if (it->inflate == NULL && it->wrote_size == 0 && it->buf_len == 0 && size > 0 && is_zlib_header(data_bytes[0])) {
+        esp_err_t ret = ota_inflate_begin(it, data_bytes[0]);
+        if (ret != ESP_OK) {
             return ret;
         }
     }
-
-    //if go to here ,means don't find the handle
-    ESP_LOGE(TAG,"not found the handle");
-    return ESP_ERR_INVALID_ARG;
+    if (it->inflate != NULL) {
+        return ota_inflate_write(it, data_bytes, size);
+    }
+#endif
+    return ota_write_image(it, data_bytes, size);
 }
 
 esp_err_t esp_ota_end(esp_ota_handle_t handle)
@@ -255,34 +421,37 @@ esp_err_t esp_ota_end(esp_ota_handle_t handle)
     ota_ops_entry_t *it;
     esp_err_t ret = ESP_OK;
 
-    for (it = LIST_FIRST(&s_ota_ops_entries_head); it != NULL; it = LIST_NEXT(it, entries)) {
-        if (it->handle == handle) {
-            break;
-        }
-    }
-
+    it = ota_find_entry(handle, true);
     if (it == NULL) {
         return ESP_ERR_NOT_FOUND;
     }
 
     /* 'it' holds the ota_ops_entry_t for 'handle' */
 
+    if (it->buf_len > 0) {
+        /* Write out the staged data, padded to a 16 byte block */
+        const size_t len = (it->buf_len + 15) & ~15;
+        memset(it->buf + it->buf_len, 0xFF, len - it->buf_len);
+        if (ota_write_flash(it, it->buf, len) != ESP_OK) {
+            ret = ESP_ERR_INVALID_STATE;
+            goto cleanup;
+        }
+        it->buf_len = 0;
+    }
+
     // esp_ota_end() is only valid if some data was written to this handle
     if ((it->erased_size == 0) || (it->wrote_size == 0)) {
         ret = ESP_ERR_INVALID_ARG;
         goto cleanup;
     }
 
-    if (it->partial_bytes > 0) {
-        /* Write out last 16 bytes, if necessary */
-        ret = esp_partition_write(it->part, it->wrote_size, it->partial_data, 16);
-        if (ret != ESP_OK) {
-            ret = ESP_ERR_INVALID_STATE;
-            goto cleanup;
-        }
-        it->wrote_size += 16;
-        it->partial_bytes = 0;
+#ifdef CONFIG_APP_UPDATE_COMPRESSED_IMAGE
+    if (it->inflate != NULL && !it->inflate->done) {
+        ESP_LOGE(TAG, "Compressed image is incomplete");
+        ret = ESP_ERR_OTA_VALIDATE_FAILED;
+        goto cleanup;
     }
+#endif
 
     esp_image_metadata_t data;
     const esp_partition_pos_t part_pos = {
@@ -296,7 +465,10 @@ esp_err_t esp_ota_end(esp_ota_handle_t handle)
     }
 
  cleanup:
-    LIST_REMOVE(it, entries);
+    free(it->buf);
+#ifdef CONFIG_APP_UPDATE_COMPRESSED_IMAGE
+    free(it->inflate);
+#endif
     free(it);
     return ret;
 }
@@ -0,0 +1,118 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define ESP_OTA_DELTA_MAGIC     0x544c4544  /*!< "DELT", first word of a delta patch */
+#define ESP_OTA_DELTA_VERSION   1           /*!< Version of the delta patch format */
+
+/**
+ * @brief Header of a delta patch, as written by otadelta.py
+ *
+ * All fields are little endian. The header is followed by a sequence of
+ * operations, each an operation byte followed by its arguments as unsigned
+ * LEB128 numbers:
+ *
+ * - ESP_OTA_DELTA_OP_COPY source_offset length: copy bytes of the running app
+ * - ESP_OTA_DELTA_OP_INSERT length, followed by length bytes: insert new bytes
+ * - ESP_OTA_DELTA_OP_DIFF source_offset length, followed by pairs of
+ *   (same_length, diff_length, diff_length bytes) covering length bytes: copy bytes
+ *   of the running app, adding the diff bytes to diff_length of them (modulo 256)
+ * - ESP_OTA_DELTA_OP_END: end of the patch
+ */
+typedef struct {
+    uint32_t magic;                 /*!< ESP_OTA_DELTA_MAGIC */
+    uint32_t version;               /*!< ESP_OTA_DELTA_VERSION */
+    uint32_t source_size;           /*!< Size of the app the patch applies to */
+    uint32_t target_size;           /*!< Size of the app the patch creates */
+    uint8_t source_sha256[32];      /*!< SHA-256 of the source_size first bytes of the app the patch applies to */
+} esp_ota_delta_header_t;
+
+#define ESP_OTA_DELTA_OP_END    0   /*!< End of the patch */
+#define ESP_OTA_DELTA_OP_COPY   1   /*!< Copy bytes of the running app */
+#define ESP_OTA_DELTA_OP_INSERT 2   /*!< Insert bytes of the patch */
+#define ESP_OTA_DELTA_OP_DIFF   3   /*!< Copy bytes of the running app with some bytes changed */
+
+/**
+ * @brief Opaque handle for a delta update
+ */
+typedef struct esp_ota_delta *esp_ota_delta_handle_t;
+
+/**
+ * @brief   Start a delta update of the running app into the specified partition.
+ *
+ * The patch is applied to the running app, see esp_ota_get_running_partition(),
+ * and the result is written to the partition with esp_ota_write().
+ *
+ * @param partition   Partition which will receive the updated app. Required.
+ * @param out_handle  On success, returns a handle which should be used for subsequent
+ *                    esp_ota_delta_write() and esp_ota_delta_end() calls.
+ *
+ * @return
+ *    - ESP_OK: Delta update started.
+ *    - ESP_ERR_NO_MEM: Cannot allocate memory for the update.
+ *    - Errors returned by esp_ota_begin().
+ */
+esp_err_t esp_ota_delta_begin(const esp_partition_t *partition, esp_ota_delta_handle_t *out_handle);
+
+/**
+ * @brief   Apply a part of the delta patch
+ *
+ * This function can be called multiple times as the patch is received,
+ * with pieces of any size.
+ *
+ * @param handle  Handle obtained from esp_ota_delta_begin
+ * @param data    Part of the patch
+ * @param size    Size of data in bytes
+ *
+ * @return
+ *    - ESP_OK: The data was applied.
+ *    - ESP_ERR_INVALID_ARG: The handle or data are invalid.
+ *    - ESP_ERR_OTA_DELTA_SOURCE_MISMATCH: The patch was not created for the running app.
+ *    - ESP_ERR_OTA_VALIDATE_FAILED: The patch is invalid.
+ *    - Errors returned by esp_ota_write() or esp_partition_read().
+ *    After an error, the patch can't be applied any further; call esp_ota_delta_end()
+ *    to free the handle.
+ */
+esp_err_t esp_ota_delta_write(esp_ota_delta_handle_t handle, const void *data, size_t size);
+
+/**
+ * @brief   Finish the delta update and validate the new app image.
+ *
+ * The handle is freed, regardless of the result. The new app is validated
+ * by esp_ota_end(); use esp_ota_set_boot_partition() to boot it.
+ *
+ * @param handle  Handle obtained from esp_ota_delta_begin
+ *
+ * @return
+ *    - ESP_OK: The new app image is valid.
+ *    - ESP_ERR_INVALID_ARG: The handle is invalid.
+ *    - ESP_ERR_OTA_VALIDATE_FAILED: The patch is incomplete or the new app image is invalid.
+ *    - The error returned by esp_ota_delta_write() earlier, if there was one.
+ */
+esp_err_t esp_ota_delta_end(esp_ota_delta_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
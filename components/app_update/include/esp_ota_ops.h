@@ -37,6 +37,7 @@ extern "C"
 #define ESP_ERR_OTA_SMALL_SEC_VER                (ESP_ERR_OTA_BASE + 0x04)  /*!< Error if the firmware has a secure version less than the running firmware. */
 #define ESP_ERR_OTA_ROLLBACK_FAILED              (ESP_ERR_OTA_BASE + 0x05)  /*!< Error if flash does not have valid firmware in passive partition and hence rollback is not possible */
 #define ESP_ERR_OTA_ROLLBACK_INVALID_STATE       (ESP_ERR_OTA_BASE + 0x06)  /*!< Error if current active firmware is still marked in pending validation state (ESP_OTA_IMG_PENDING_VERIFY), essentially first boot of firmware image post upgrade and hence firmware upgrade is not possible */
+#define ESP_ERR_OTA_DELTA_SOURCE_MISMATCH        (ESP_ERR_OTA_BASE + 0x07)  /*!< Error if a delta patch was not created for the running firmware */
 
 
 /**
@@ -68,20 +69,30 @@ int esp_ota_get_app_elf_sha256(char* dst, size_t size);
 /**
  * @brief   Commence an OTA update writing to the specified partition.
 
- * The specified partition is erased to the specified image size.
+ * The partition is not erased here. esp_ota_write() erases it just ahead of
+ * the data being written, so this function returns quickly and no time is
+ * spent erasing beyond the end of the image. Where a whole 64 KB block of the
+ * partition belongs to the image, the block is erased at once, which is faster
+ * than erasing its sectors.
  *
- * If image size is not yet known, pass OTA_SIZE_UNKNOWN which will
- * cause the entire partition to be erased.
+ * If image size is not yet known, pass OTA_SIZE_UNKNOWN. Blocks are then
+ * erased up to the end of the partition, so up to 60 KB after the end of the
+ * image may be erased.
  *
  * On success, this function allocates memory that remains in use
- * until esp_ota_end() is called with the returned handle.
+ * until esp_ota_end() is called with the returned handle. If flash encryption
+ * is enabled, this includes a buffer of one sector: the data is written to
+ * flash a sector at a time, and the last part by esp_ota_end().
+ *
+ * Several updates, of different partitions, can be in progress at the same time,
+ * also from different tasks.
  *
  * Note: If the rollback option is enabled and the running application has the ESP_OTA_IMG_PENDING_VERIFY state then
  * it will lead to the ESP_ERR_OTA_ROLLBACK_INVALID_STATE error. Confirm the running app before to run download a new app,
  * use esp_ota_mark_app_valid_cancel_rollback() function for it (this should be done as early as possible when you first download a new application).
  *
  * @param partition Pointer to info for partition which will receive the OTA update. Required.
- * @param image_size Size of new OTA app image. Partition will be erased in order to receive this size of image. If 0 or OTA_SIZE_UNKNOWN, the entire partition is erased.
+ * @param image_size Size of new OTA app image, used to limit erasing to the sectors of the image. Can be 0 or OTA_SIZE_UNKNOWN.
  * @param out_handle On success, returns a handle which should be used for subsequent esp_ota_write() and esp_ota_end() calls.
 
  * @return
@@ -102,7 +113,11 @@ esp_err_t esp_ota_begin(const esp_partition_t* partition, size_t image_size, esp
  *
  * This function can be called multiple times as
  * data is received during the OTA operation. Data is written
- * sequentially to the partition.
+ * sequentially to the partition. The sectors the data is written to
+ * are erased first, if they have not been erased yet.
+ *
+ * If CONFIG_APP_UPDATE_COMPRESSED_IMAGE is enabled, the data may also be an app image
+ * compressed with zlib (see otacompress.py), which is decompressed as it is written.
  *
  * @param handle  Handle obtained from esp_ota_begin
  * @param data    Data buffer to write
@@ -111,7 +126,9 @@ esp_err_t esp_ota_begin(const esp_partition_t* partition, size_t image_size, esp
  * @return
  *    - ESP_OK: Data was written to flash successfully.
  *    - ESP_ERR_INVALID_ARG: handle is invalid.
- *    - ESP_ERR_OTA_VALIDATE_FAILED: First byte of image contains invalid app image magic byte.
+ *    - ESP_ERR_OTA_VALIDATE_FAILED: First byte of image contains invalid app image magic byte,
+ *      or the compressed image is invalid.
+ *    - ESP_ERR_NO_MEM: Cannot allocate memory to decompress a compressed image.
  *    - ESP_ERR_FLASH_OP_TIMEOUT or ESP_ERR_FLASH_OP_FAIL: Flash write failed.
  *    - ESP_ERR_OTA_SELECT_INFO_INVALID: OTA data partition has invalid contents
  */
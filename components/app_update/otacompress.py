@@ -0,0 +1,67 @@
+#!/usr/bin/env python
+#
+# otacompress compresses an app image, which can then be passed to esp_ota_write()
+# or esp_https_ota() if CONFIG_APP_UPDATE_COMPRESSED_IMAGE is enabled
+#
+# Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http:#www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+from __future__ import print_function, division
+import argparse
+import zlib
+
+__version__ = '1.0'
+
+ESP_IMAGE_HEADER_MAGIC = 0xE9
+
+# The device allocates a buffer of the window size, see ota_inflate_begin() in esp_ota_ops.c
+MIN_WINDOW_BITS = 10
+MAX_WINDOW_BITS = 15
+
+
+def compress_image(image, window_bits):
+    if not MIN_WINDOW_BITS <= window_bits <= MAX_WINDOW_BITS:
+        raise RuntimeError("window bits should be between %d and %d" % (MIN_WINDOW_BITS, MAX_WINDOW_BITS))
+    if len(image) == 0 or bytearray(image[:1])[0] != ESP_IMAGE_HEADER_MAGIC:
+        raise RuntimeError("input is not an app image")
+    compressor = zlib.compressobj(9, zlib.DEFLATED, window_bits, 9)
+    compressed = compressor.compress(image) + compressor.flush()
+    if zlib.decompress(compressed) != image:
+        raise RuntimeError("compressed image does not decompress to the app image")
+    return compressed
+
+
+def main():
+    parser = argparse.ArgumentParser("ESP-IDF OTA Image Compression Tool",
+                                     formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+
+    parser.add_argument("input", help="app image, e.g. build/app.bin")
+    parser.add_argument("output", help="file to write the compressed image to")
+    parser.add_argument("--window-bits", "-w",
+                        help="log2 of the deflate window size. The device needs a buffer of this size to decompress "
+                        "the image, a larger window usually compresses better",
+                        type=int, default=12)
+
+    args = parser.parse_args()
+
+    with open(args.input, "rb") as f:
+        image = f.read()
+    compressed = compress_image(image, args.window_bits)
+    with open(args.output, "wb") as f:
+        f.write(compressed)
+    print("Compressed %d bytes to %d bytes (%.1f%%)" %
+          (len(image), len(compressed), 100.0 * len(compressed) / len(image)))
+
+
+if __name__ == '__main__':
+    main()
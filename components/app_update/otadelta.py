@@ -0,0 +1,270 @@
+#!/usr/bin/env python
+#
+# otadelta creates delta patches between two app images, which can be applied
+# on the device with esp_ota_delta_begin/write/end, and applies them on the host
+#
+# Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http:#www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+from __future__ import print_function, division
+import argparse
+import hashlib
+import struct
+import sys
+
+__version__ = '1.0'
+
+# Based on esp_ota_delta_header_t and ESP_OTA_DELTA_OP_* in esp_ota_delta.h
+DELTA_MAGIC = 0x544c4544
+DELTA_VERSION = 1
+DELTA_HEADER_FORMAT = "<IIII32s"
+DELTA_HEADER_SIZE = struct.calcsize(DELTA_HEADER_FORMAT)
+
+OP_END = 0
+OP_COPY = 1
+OP_INSERT = 2
+OP_DIFF = 3
+
+# Source positions are indexed every BLOCK_STEP bytes by the BLOCK_SIZE bytes starting there
+BLOCK_SIZE = 16
+BLOCK_STEP = 4
+# A match is extended over mismatching bytes while this many more of the following bytes match
+MATCH_SCORE = 1
+MISMATCH_SCORE = 2
+EXTEND_SLACK = 32
+
+
+def encode_varint(value):
+    out = bytearray()
+    while True:
+        b = value & 0x7f
+        value >>= 7
+        if value:
+            out.append(b | 0x80)
+        else:
+            out.append(b)
+            return out
+
+
+def decode_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        if pos >= len(data) or shift > 28:
+            raise RuntimeError("invalid number at patch offset %d" % pos)
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7f) << shift
+        shift += 7
+        if not b & 0x80:
+            return value, pos
+
+
+class DeltaEncoder():
+    def __init__(self, source, target):
+        self.source = bytearray(source)
+        self.target = bytearray(target)
+        self.ops = bytearray()
+        self.index = {}
+        for pos in range(0, len(self.source) - BLOCK_SIZE + 1, BLOCK_STEP):
+            self.index.setdefault(bytes(self.source[pos:pos + BLOCK_SIZE]), pos)
+
+    def _find_match(self, tpos):
+        """ Return (source position, length) of an exact match of at least BLOCK_SIZE bytes at tpos, or None """
+        spos = self.index.get(bytes(self.target[tpos:tpos + BLOCK_SIZE]))
+        if spos is None:
+            return None
+        length = BLOCK_SIZE
+        while (spos + length < len(self.source) and tpos + length < len(self.target) and
+               self.source[spos + length] == self.target[tpos + length]):
+            length += 1
+        return spos, length
+
+    def _extend(self, spos, tpos, length):
+        """ Extend an exact match forward over bytes which mostly match, return the new length """
+        best_length = length
+        score = 0
+        best_score = 0
+        while spos + length < len(self.source) and tpos + length < len(self.target):
+            if self.source[spos + length] == self.target[tpos + length]:
+                score += MATCH_SCORE
+            else:
+                score -= MISMATCH_SCORE
+            length += 1
+            if score > best_score:
+                best_score = score
+                best_length = length
+            elif score < best_score - EXTEND_SLACK:
+                break
+        return best_length
+
+    def _insert(self, data):
+        if data:
+            self.ops += bytearray([OP_INSERT]) + encode_varint(len(data)) + data
+
+    def _copy(self, spos, tpos, length):
+        pairs = bytearray()
+        same = 0
+        i = 0
+        while i < length:
+            if self.source[spos + i] == self.target[tpos + i]:
+                same += 1
+                i += 1
+                continue
+            diff = bytearray()
+            while i < length and self.source[spos + i] != self.target[tpos + i]:
+                diff.append((self.target[tpos + i] - self.source[spos + i]) & 0xff)
+                i += 1
+            pairs += encode_varint(same) + encode_varint(len(diff)) + diff
+            same = 0
+        if not pairs:
+            self.ops += bytearray([OP_COPY]) + encode_varint(spos) + encode_varint(length)
+            return
+        if same:
+            pairs += encode_varint(same) + encode_varint(0)
+        self.ops += bytearray([OP_DIFF]) + encode_varint(spos) + encode_varint(length) + pairs
+
+    def encode(self):
+        literal_start = 0
+        tpos = 0
+        while tpos + BLOCK_SIZE <= len(self.target):
+            match = self._find_match(tpos)
+            if match is None:
+                tpos += 1
+                continue
+            spos, length = match
+            # extend the exact match backward into the pending literal bytes
+            while tpos > literal_start and spos > 0 and self.source[spos - 1] == self.target[tpos - 1]:
+                spos -= 1
+                tpos -= 1
+                length += 1
+            length = self._extend(spos, tpos, length)
+            self._insert(self.target[literal_start:tpos])
+            self._copy(spos, tpos, length)
+            tpos += length
+            literal_start = tpos
+        self._insert(self.target[literal_start:])
+        self.ops.append(OP_END)
+
+        header = struct.pack(DELTA_HEADER_FORMAT, DELTA_MAGIC, DELTA_VERSION, len(self.source), len(self.target),
+                             hashlib.sha256(self.source).digest())
+        return header + bytes(self.ops)
+
+
+def apply_patch(source, patch):
+    source = bytearray(source)
+    patch = bytearray(patch)
+    if len(patch) < DELTA_HEADER_SIZE:
+        raise RuntimeError("patch is too short")
+    magic, version, source_size, target_size, sha256 = struct.unpack(DELTA_HEADER_FORMAT, bytes(patch[:DELTA_HEADER_SIZE]))
+    if magic != DELTA_MAGIC or version != DELTA_VERSION:
+        raise RuntimeError("not a delta patch")
+    if source_size > len(source) or hashlib.sha256(source[:source_size]).digest() != sha256:
+        raise RuntimeError("patch was not created for this source image")
+    source = source[:source_size]
+
+    target = bytearray()
+    pos = DELTA_HEADER_SIZE
+    while True:
+        if pos >= len(patch):
+            raise RuntimeError("patch has no end")
+        op = patch[pos]
+        pos += 1
+        if op == OP_END:
+            break
+        elif op == OP_INSERT:
+            length, pos = decode_varint(patch, pos)
+            if pos + length > len(patch):
+                raise RuntimeError("insert of %d bytes is out of range" % length)
+            target += patch[pos:pos + length]
+            pos += length
+        elif op in (OP_COPY, OP_DIFF):
+            spos, pos = decode_varint(patch, pos)
+            length, pos = decode_varint(patch, pos)
+            if spos + length > len(source):
+                raise RuntimeError("copy of source 0x%x, %d bytes is out of range" % (spos, length))
+            if op == OP_COPY:
+                target += source[spos:spos + length]
+                continue
+            end = spos + length
+            while spos < end:
+                same, pos = decode_varint(patch, pos)
+                diff, pos = decode_varint(patch, pos)
+                if same + diff == 0 or spos + same + diff > end or pos + diff > len(patch):
+                    raise RuntimeError("invalid diff at patch offset %d" % pos)
+                target += source[spos:spos + same]
+                spos += same
+                for i in range(diff):
+                    target.append((source[spos + i] + patch[pos + i]) & 0xff)
+                spos += diff
+                pos += diff
+        else:
+            raise RuntimeError("invalid operation %d at patch offset %d" % (op, pos - 1))
+        if len(target) > target_size:
+            raise RuntimeError("patch creates more than %d bytes" % target_size)
+    if pos != len(patch) or len(target) != target_size:
+        raise RuntimeError("patch is incomplete")
+    return bytes(target)
+
+
+def create(args):
+    with open(args.source, "rb") as f:
+        source = f.read()
+    with open(args.target, "rb") as f:
+        target = f.read()
+    patch = DeltaEncoder(source, target).encode()
+    # check the patch before writing it
+    if apply_patch(source, patch) != target:
+        raise RuntimeError("created patch does not reproduce the target image")
+    with open(args.patch, "wb") as f:
+        f.write(patch)
+    print("Created patch of %d bytes for target image of %d bytes (%.1f%%)" %
+          (len(patch), len(target), 100.0 * len(patch) / max(len(target), 1)))
+
+
+def apply(args):
+    with open(args.source, "rb") as f:
+        source = f.read()
+    with open(args.patch, "rb") as f:
+        patch = f.read()
+    with open(args.output, "wb") as f:
+        f.write(apply_patch(source, patch))
+
+
+def main():
+    parser = argparse.ArgumentParser("ESP-IDF OTA Delta Patch Tool")
+
+    subparsers = parser.add_subparsers(dest="operation", help="run otadelta -h for additional help")
+
+    create_subparser = subparsers.add_parser("create", help="create a patch which updates the source app image to the target app image")
+    create_subparser.add_argument("source", help="app image running on the device")
+    create_subparser.add_argument("target", help="new app image")
+    create_subparser.add_argument("patch", help="file to write the patch to")
+
+    apply_subparser = subparsers.add_parser("apply", help="apply a patch to the source app image")
+    apply_subparser.add_argument("source", help="app image the patch was created for")
+    apply_subparser.add_argument("patch", help="patch created with the create command")
+    apply_subparser.add_argument("output", help="file to write the new app image to")
+
+    args = parser.parse_args()
+
+    if args.operation is None:
+        parser.print_help()
+        sys.exit(1)
+
+    operation_func = globals()[args.operation]
+    operation_func(args)
+
+
+if __name__ == '__main__':
+    main()
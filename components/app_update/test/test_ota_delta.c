@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+
+#include <unity.h>
+#include <test_utils.h>
+#include <esp_ota_ops.h>
+#include <esp_ota_delta.h>
+#include "esp_flash_partitions.h"
+#include "bootloader_common.h"
+
+#define SOURCE_SIZE 4096
+#define TARGET_SIZE (1024 + 16 + 2048)
+
+static uint8_t *put_varint(uint8_t *p, uint32_t value)
+{
+    while (value >= 0x80) {
+        *p++ = (value & 0x7f) | 0x80;
+        value >>= 7;
+    }
+    *p++ = value;
+    return p;
+}
+
+/* Create a patch against the running app, and the target it should produce */
+static size_t create_patch(uint8_t *patch, uint8_t *target)
+{
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    TEST_ASSERT_NOT_NULL(running);
+    uint8_t *source = malloc(SOURCE_SIZE);
+    TEST_ASSERT_NOT_NULL(source);
+    TEST_ESP_OK(esp_partition_read(running, 0, source, SOURCE_SIZE));
+
+    esp_ota_delta_header_t *header = (esp_ota_delta_header_t *) patch;
+    header->magic = ESP_OTA_DELTA_MAGIC;
+    header->version = ESP_OTA_DELTA_VERSION;
+    header->source_size = SOURCE_SIZE;
+    header->target_size = TARGET_SIZE;
+    TEST_ESP_OK(bootloader_common_get_sha256_of_partition(running->address, SOURCE_SIZE, PART_TYPE_DATA, header->source_sha256));
+    uint8_t *p = patch + sizeof(esp_ota_delta_header_t);
+
+    /* app header of the running app */
+    *p++ = ESP_OTA_DELTA_OP_COPY;
+    p = put_varint(p, 0);
+    p = put_varint(p, 1024);
+    memcpy(target, source, 1024);
+
+    *p++ = ESP_OTA_DELTA_OP_INSERT;
+    p = put_varint(p, 16);
+    for (int i = 0; i < 16; ++i) {
+        *p++ = i;
+        target[1024 + i] = i;
+    }
+
+    /* the rest of the source, with every 300th byte incremented by 3 */
+    *p++ = ESP_OTA_DELTA_OP_DIFF;
+    p = put_varint(p, 2048);
+    p = put_varint(p, 2048);
+    for (int i = 0; i < 2048; i += 300) {
+        p = put_varint(p, (i == 0) ? 0 : 299);
+        p = put_varint(p, 1);
+        *p++ = 3;
+    }
+    p = put_varint(p, 2048 - (2048 / 300) * 300 - 1);
+    p = put_varint(p, 0);
+    for (int i = 0; i < 2048; ++i) {
+        target[1040 + i] = source[2048 + i] + ((i % 300 == 0) ? 3 : 0);
+    }
+
+    *p++ = ESP_OTA_DELTA_OP_END;
+    free(source);
+    return p - patch;
+}
+
+TEST_CASE("esp_ota_delta applies a patch to the running app", "[ota]")
+{
+    const esp_partition_t *update = esp_ota_get_next_update_partition(NULL);
+    TEST_ASSERT_NOT_NULL(update);
+    uint8_t *patch = malloc(SOURCE_SIZE);
+    uint8_t *target = malloc(TARGET_SIZE);
+    uint8_t *written = malloc(TARGET_SIZE);
+    TEST_ASSERT_NOT_NULL(patch);
+    TEST_ASSERT_NOT_NULL(target);
+    TEST_ASSERT_NOT_NULL(written);
+    size_t patch_size = create_patch(patch, target);
+
+    /* apply in small pieces, which split the header and the numbers */
+    esp_ota_delta_handle_t handle;
+    TEST_ESP_OK(esp_ota_delta_begin(update, &handle));
+    for (size_t i = 0; i < patch_size; i += 7) {
+        TEST_ESP_OK(esp_ota_delta_write(handle, patch + i, MIN(7, patch_size - i)));
+    }
+    /* the target is not a complete app, so it doesn't validate */
+    TEST_ASSERT_EQUAL_HEX(ESP_ERR_OTA_VALIDATE_FAILED, esp_ota_delta_end(handle));
+    TEST_ESP_OK(esp_partition_read(update, 0, written, TARGET_SIZE));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(target, written, TARGET_SIZE);
+
+    /* a truncated patch is incomplete */
+    TEST_ESP_OK(esp_ota_delta_begin(update, &handle));
+    TEST_ESP_OK(esp_ota_delta_write(handle, patch, patch_size - 1));
+    TEST_ASSERT_EQUAL_HEX(ESP_ERR_OTA_VALIDATE_FAILED, esp_ota_delta_end(handle));
+
+    /* a copy beyond the source is rejected */
+    patch[sizeof(esp_ota_delta_header_t) + 3] = 0x7f;
+    TEST_ESP_OK(esp_ota_delta_begin(update, &handle));
+    TEST_ASSERT_EQUAL_HEX(ESP_ERR_OTA_VALIDATE_FAILED, esp_ota_delta_write(handle, patch, patch_size));
+    TEST_ASSERT_EQUAL_HEX(ESP_ERR_OTA_VALIDATE_FAILED, esp_ota_delta_end(handle));
+
+    free(patch);
+    free(target);
+    free(written);
+}
+
+TEST_CASE("esp_ota_delta rejects a patch for another app", "[ota]")
+{
+    const esp_partition_t *update = esp_ota_get_next_update_partition(NULL);
+    TEST_ASSERT_NOT_NULL(update);
+    uint8_t *patch = malloc(SOURCE_SIZE);
+    uint8_t *target = malloc(TARGET_SIZE);
+    TEST_ASSERT_NOT_NULL(patch);
+    TEST_ASSERT_NOT_NULL(target);
+    size_t patch_size = create_patch(patch, target);
+    ((esp_ota_delta_header_t *) patch)->source_sha256[0] ^= 1;
+
+    esp_ota_delta_handle_t handle;
+    TEST_ESP_OK(esp_ota_delta_begin(update, &handle));
+    TEST_ASSERT_EQUAL_HEX(ESP_ERR_OTA_DELTA_SOURCE_MISMATCH, esp_ota_delta_write(handle, patch, patch_size));
+    TEST_ASSERT_EQUAL_HEX(ESP_ERR_OTA_DELTA_SOURCE_MISMATCH, esp_ota_delta_end(handle));
+    free(patch);
+    free(target);
+}
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/param.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <freertos/semphr.h>
@@ -107,3 +108,178 @@ TEST_CASE("esp_ota_get_partition_description ", "[ota]")
     };
     TEST_ESP_ERR(ESP_ERR_NOT_FOUND, bootloader_common_get_partition_description(&not_app_pos, &app_desc1));
 }
+
+TEST_CASE("esp_ota_write erases only the sectors of the image", "[ota]")
+{
+    const esp_partition_t *update = esp_ota_get_next_update_partition(NULL);
+    TEST_ASSERT_NOT_NULL(update);
+    TEST_ASSERT_TRUE(update->size >= 2 * SPI_FLASH_SEC_SIZE);
+
+    uint8_t data[100];
+    memset(data, 0x55, sizeof(data));
+    uint8_t image[100];
+    memset(image, 0xa5, sizeof(image));
+    image[0] = ESP_IMAGE_HEADER_MAGIC;
+
+    /* image of known size: the second sector isn't erased */
+    TEST_ESP_OK(esp_partition_erase_range(update, 0, 2 * SPI_FLASH_SEC_SIZE));
+    TEST_ESP_OK(esp_partition_write(update, SPI_FLASH_SEC_SIZE, data, sizeof(data)));
+    esp_ota_handle_t handle;
+    TEST_ESP_OK(esp_ota_begin(update, sizeof(image), &handle));
+    TEST_ESP_OK(esp_ota_write(handle, image, sizeof(image)));
+    uint8_t buf[100];
+    TEST_ESP_OK(esp_partition_read(update, 0, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(image, buf, sizeof(buf));
+    TEST_ESP_OK(esp_partition_read(update, SPI_FLASH_SEC_SIZE, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(data, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_HEX(ESP_ERR_OTA_VALIDATE_FAILED, esp_ota_end(handle));
+
+    /* writing into the second sector erases it first */
+    TEST_ESP_OK(esp_ota_begin(update, sizeof(image), &handle));
+    for (int i = 0; i < SPI_FLASH_SEC_SIZE / sizeof(image) + 1; i++) {
+        TEST_ESP_OK(esp_ota_write(handle, image, sizeof(image)));
+    }
+    TEST_ESP_OK(esp_partition_read(update, SPI_FLASH_SEC_SIZE, buf, sizeof(buf)));
+    for (int i = 0; i < sizeof(buf); i++) {
+        uint32_t offset = SPI_FLASH_SEC_SIZE + i;
+        uint8_t expected = (offset < (SPI_FLASH_SEC_SIZE / sizeof(image) + 1) * sizeof(image)) ? image[offset % sizeof(image)] : 0xff;
+        TEST_ASSERT_EQUAL_HEX8(expected, buf[i]);
+    }
+    TEST_ASSERT_EQUAL_HEX(ESP_ERR_OTA_VALIDATE_FAILED, esp_ota_end(handle));
+}
+
+#ifdef CONFIG_APP_UPDATE_COMPRESSED_IMAGE
+#define COMPRESSED_IMAGE_SIZE 20000
+
+/* Byte i of the test image, byte 0 is ESP_IMAGE_HEADER_MAGIC */
+static uint8_t compressed_test_image_byte(size_t i)
+{
+    return (i == 0) ? ESP_IMAGE_HEADER_MAGIC : ((i / 64) * 13) & 0xff;
+}
+
+/* The test image compressed by zlib with a 1 KB window (wbits 10) */
+static const uint8_t s_compressed_test_image[] = {
+    0x28, 0xcf, 0xa5, 0xc1, 0x65, 0x83, 0x08, 0x06, 0x00, 0x00, 0x50, 0x71, 0x38, 0x9d, 0xa7, 0x19,
+    0xa6, 0x6f, 0x3a, 0x27, 0xa7, 0xfb, 0xd8, 0xc9, 0x4d, 0x9c, 0x98, 0x6e, 0xc6, 0x74, 0xb3, 0xe9,
+    0x1a, 0x27, 0x4e, 0xee, 0xd8, 0x74, 0xce, 0xe6, 0x70, 0x0b, 0xb5, 0x4d, 0x77, 0x77, 0xb7, 0xe9,
+    0xe6, 0x27, 0xf8, 0xf0, 0xde, 0xbb, 0x15, 0xc3, 0x24, 0x46, 0xe9, 0x51, 0x2e, 0x54, 0x14, 0x55,
+    0x40, 0x21, 0xa8, 0x29, 0xea, 0x80, 0xfa, 0xa0, 0x11, 0x68, 0x32, 0x8a, 0x40, 0xcb, 0xd0, 0x26,
+    0xb4, 0x1d, 0x1d, 0x44, 0xe7, 0xd0, 0x6d, 0xf4, 0x1c, 0x05, 0xa0, 0xe4, 0x28, 0x33, 0x0a, 0x46,
+    0x25, 0x51, 0x15, 0x14, 0x8a, 0xc2, 0x50, 0x17, 0xd4, 0x1f, 0x8d, 0x41, 0xd3, 0xd1, 0x42, 0xb4,
+    0x0a, 0x45, 0xa1, 0xdd, 0xe8, 0x28, 0xba, 0x84, 0xee, 0xa3, 0xd7, 0x28, 0x10, 0x05, 0xa1, 0x6c,
+    0xa8, 0x00, 0x2a, 0x83, 0x6a, 0xa0, 0x46, 0xa8, 0x0d, 0xea, 0x81, 0x06, 0xa3, 0x71, 0x28, 0x1c,
+    0x45, 0xa2, 0x75, 0x28, 0x1a, 0xed, 0x41, 0x27, 0xd1, 0x35, 0xf4, 0x08, 0xbd, 0x47, 0x89, 0x50,
+    0x3a, 0x94, 0x13, 0x15, 0x41, 0x5f, 0xa0, 0x3a, 0xe8, 0x6b, 0xd4, 0x1e, 0x7d, 0x8b, 0x86, 0xa3,
+    0x49, 0x68, 0x2e, 0xfa, 0x05, 0xfd, 0x8a, 0xfe, 0x46, 0x07, 0xd0, 0x59, 0x74, 0x0b, 0x3d, 0x43,
+    0xb1, 0x51, 0x32, 0x94, 0x09, 0xe5, 0x45, 0x25, 0x50, 0x65, 0xf4, 0x25, 0x6a, 0x81, 0x3a, 0xa3,
+    0x7e, 0x68, 0x34, 0x9a, 0x86, 0x16, 0xa0, 0x95, 0x68, 0x33, 0xda, 0x85, 0x8e, 0xa0, 0x8b, 0xe8,
+    0x1e, 0x7a, 0x85, 0xe2, 0xa1, 0x54, 0x28, 0x2b, 0xca, 0x8f, 0x4a, 0xa3, 0xea, 0xa8, 0x21, 0x6a,
+    0x8d, 0xba, 0xa3, 0x41, 0x68, 0x2c, 0x9a, 0x89, 0x7e, 0x42, 0x6b, 0xd1, 0x36, 0xf4, 0x1f, 0x3a,
+    0x81, 0xae, 0xa2, 0xff, 0xd1, 0x3b, 0x94, 0x10, 0xa5, 0x45, 0x39, 0x50, 0x61, 0x54, 0x1e, 0xd5,
+    0x46, 0x5f, 0xa1, 0x76, 0xa8, 0x37, 0x1a, 0x86, 0x26, 0xa2, 0x39, 0xe8, 0x67, 0xb4, 0x11, 0xfd,
+    0x85, 0xf6, 0xa3, 0x33, 0xe8, 0x26, 0x7a, 0x8a, 0x62, 0xa1, 0xa4, 0x28, 0x23, 0xca, 0x83, 0x8a,
+    0xa3, 0x4a, 0xa8, 0x1e, 0x6a, 0x8e, 0x3a, 0xa1, 0xef, 0xd0, 0x28, 0x34, 0x15, 0xcd, 0x47, 0x2b,
+    0xd0, 0xef, 0x68, 0x27, 0x3a, 0x8c, 0x2e, 0xa0, 0xbb, 0xe8, 0x25, 0x8a, 0x8b, 0x52, 0xa2, 0x2c,
+    0x28, 0x1f, 0x2a, 0x85, 0xaa, 0xa1, 0x06, 0xa8, 0x15, 0xea, 0x86, 0x06, 0xa2, 0x1f, 0xd0, 0x0c,
+    0xb4, 0x18, 0xad, 0x41, 0x5b, 0xd1, 0xbf, 0xe8, 0x38, 0xba, 0x82, 0x1e, 0xa2, 0xb7, 0x28, 0x01,
+    0x4a, 0x83, 0xb2, 0xa3, 0x42, 0xa8, 0x1c, 0xaa, 0x85, 0x9a, 0xa0, 0xb6, 0xa8, 0x17, 0x1a, 0x8a,
+    0x26, 0xa0, 0xd9, 0x68, 0x29, 0xda, 0x80, 0xfe, 0x44, 0xfb, 0xd0, 0x69, 0x74, 0x03, 0x3d, 0x41,
+    0x31, 0x51, 0x12, 0x94, 0x01, 0xe5, 0x46, 0xc5, 0x50, 0x45, 0x54, 0x17, 0x35, 0x43, 0x1d, 0x51,
+    0x5f, 0x34, 0x12, 0x4d, 0x41, 0xf3, 0xd0, 0x72, 0xf4, 0x1b, 0xda, 0x81, 0x0e, 0xa1, 0xf3, 0xe8,
+    0x0e, 0x7a, 0x81, 0xe2, 0xa0, 0x14, 0xe8, 0x13, 0xf4, 0x19, 0xfa, 0x1c, 0x55, 0x45, 0xf5, 0x51,
+    0x4b, 0xd4, 0x15, 0x0d, 0x40, 0xdf, 0xa3, 0x1f, 0xd1, 0x22, 0xb4, 0x1a, 0x6d, 0x41, 0xff, 0xa0,
+    0x63, 0xe8, 0x32, 0x7a, 0x80, 0xde, 0xa0, 0xf8, 0x28, 0x35, 0xfa, 0x14, 0x15, 0x44, 0x65, 0x51,
+    0x4d, 0xd4, 0x18, 0x7d, 0x83, 0x7a, 0xa2, 0x21, 0x68, 0x3c, 0x9a, 0x85, 0x96, 0xa0, 0xf5, 0xe8,
+    0x0f, 0xb4, 0x17, 0x9d, 0x42, 0xd7, 0xd1, 0x63, 0x14, 0x03, 0x25, 0x46, 0xe9, 0x51, 0x2e, 0x54,
+    0x14, 0x55, 0x40, 0x21, 0xa8, 0x29, 0xea, 0x80, 0xfa, 0xa0, 0x11, 0x68, 0x32, 0x8a, 0x40, 0xcb,
+    0xd0, 0x26, 0xb4, 0x1d, 0x1d, 0x44, 0xe7, 0xd0, 0x6d, 0xf4, 0x1c, 0x05, 0xa0, 0xe4, 0x28, 0x33,
+    0x0a, 0x46, 0x25, 0x51, 0x15, 0x14, 0x8a, 0xc2, 0x50, 0x17, 0xd4, 0x1f, 0x8d, 0x41, 0xd3, 0xd1,
+    0x42, 0xb4, 0x0a, 0x45, 0xa1, 0xdd, 0xe8, 0x28, 0xba, 0x84, 0xee, 0xa3, 0xd7, 0x28, 0x10, 0x05,
+    0xa1, 0x6c, 0xa8, 0x00, 0x2a, 0x83, 0x6a, 0xa0, 0x46, 0xa8, 0x0d, 0xea, 0x81, 0x06, 0xa3, 0x71,
+    0x28, 0x1c, 0x45, 0xa2, 0x75, 0x28, 0x1a, 0xed, 0x41, 0x27, 0x3f, 0xe2, 0x03, 0x56, 0x37, 0x8b,
+    0x24,
+};
+
+TEST_CASE("esp_ota_write decompresses a compressed image", "[ota]")
+{
+    const esp_partition_t *update = esp_ota_get_next_update_partition(NULL);
+    TEST_ASSERT_NOT_NULL(update);
+    const size_t compressed_size = sizeof(s_compressed_test_image);
+
+    /* written in small pieces, the window wraps around many times */
+    esp_ota_handle_t handle;
+    TEST_ESP_OK(esp_ota_begin(update, compressed_size, &handle));
+    for (size_t i = 0; i < compressed_size; i += 5) {
+        TEST_ESP_OK(esp_ota_write(handle, s_compressed_test_image + i, MIN(5, compressed_size - i)));
+    }
+    /* the stream ended, more data is rejected */
+    TEST_ASSERT_EQUAL_HEX(ESP_ERR_OTA_VALIDATE_FAILED, esp_ota_write(handle, s_compressed_test_image, 1));
+    /* the test image is not a valid app */
+    TEST_ASSERT_EQUAL_HEX(ESP_ERR_OTA_VALIDATE_FAILED, esp_ota_end(handle));
+
+    uint8_t buf[256];
+    for (size_t offset = 0; offset < COMPRESSED_IMAGE_SIZE; offset += sizeof(buf)) {
+        size_t len = MIN(sizeof(buf), COMPRESSED_IMAGE_SIZE - offset);
+        TEST_ESP_OK(esp_partition_read(update, offset, buf, len));
+        for (size_t i = 0; i < len; i++) {
+            TEST_ASSERT_EQUAL_HEX8(compressed_test_image_byte(offset + i), buf[i]);
+        }
+    }
+
+    /* a truncated stream is incomplete */
+    TEST_ESP_OK(esp_ota_begin(update, compressed_size, &handle));
+    TEST_ESP_OK(esp_ota_write(handle, s_compressed_test_image, compressed_size - 10));
+    TEST_ASSERT_EQUAL_HEX(ESP_ERR_OTA_VALIDATE_FAILED, esp_ota_end(handle));
+
+    /* a corrupted stream fails the checksum */
+    uint8_t *corrupted = malloc(compressed_size);
+    TEST_ASSERT_NOT_NULL(corrupted);
+    memcpy(corrupted, s_compressed_test_image, compressed_size);
+    corrupted[compressed_size - 1] ^= 1;
+    TEST_ESP_OK(esp_ota_begin(update, compressed_size, &handle));
+    TEST_ASSERT_EQUAL_HEX(ESP_ERR_OTA_VALIDATE_FAILED, esp_ota_write(handle, corrupted, compressed_size));
+    TEST_ASSERT_EQUAL_HEX(ESP_ERR_OTA_VALIDATE_FAILED, esp_ota_end(handle));
+    free(corrupted);
+}
+#endif // CONFIG_APP_UPDATE_COMPRESSED_IMAGE
+
+TEST_CASE("esp_ota_write can update two partitions at once", "[ota]")
+{
+    const esp_partition_t *ota_0 = esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_0, NULL);
+    const esp_partition_t *ota_1 = esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_1, NULL);
+    TEST_ASSERT_NOT_NULL(ota_0);
+    TEST_ASSERT_NOT_NULL(ota_1);
+
+    uint8_t image[3][100];
+    for (int i = 0; i < 3; i++) {
+        memset(image[i], i + 1, sizeof(image[i]));
+    }
+    image[0][0] = ESP_IMAGE_HEADER_MAGIC;
+
+    /* writes to both handles are interleaved */
+    esp_ota_handle_t handle_0, handle_1;
+    TEST_ESP_OK(esp_ota_begin(ota_0, OTA_SIZE_UNKNOWN, &handle_0));
+    TEST_ESP_OK(esp_ota_begin(ota_1, OTA_SIZE_UNKNOWN, &handle_1));
+    TEST_ASSERT_NOT_EQUAL(handle_0, handle_1);
+    TEST_ESP_OK(esp_ota_write(handle_0, image[0], sizeof(image[0])));
+    TEST_ASSERT_EQUAL_HEX(ESP_ERR_OTA_VALIDATE_FAILED, esp_ota_write(handle_1, image[2], sizeof(image[2])));
+    TEST_ESP_OK(esp_ota_write(handle_0, image[1], sizeof(image[1])));
+    TEST_ESP_OK(esp_ota_write(handle_1, image[0], sizeof(image[0])));
+    TEST_ESP_OK(esp_ota_write(handle_0, image[2], sizeof(image[2])));
+    TEST_ASSERT_EQUAL_HEX(ESP_ERR_OTA_VALIDATE_FAILED, esp_ota_end(handle_0));
+    /* the handle is not valid any more */
+    TEST_ASSERT_EQUAL_HEX(ESP_ERR_INVALID_ARG, esp_ota_write(handle_0, image[0], sizeof(image[0])));
+    TEST_ESP_OK(esp_ota_write(handle_1, image[1], sizeof(image[1])));
+    TEST_ASSERT_EQUAL_HEX(ESP_ERR_OTA_VALIDATE_FAILED, esp_ota_end(handle_1));
+    TEST_ASSERT_EQUAL_HEX(ESP_ERR_NOT_FOUND, esp_ota_end(handle_1));
+
+    uint8_t buf[100];
+    for (int i = 0; i < 3; i++) {
+        TEST_ESP_OK(esp_partition_read(ota_0, i * sizeof(buf), buf, sizeof(buf)));
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(image[i], buf, sizeof(buf));
+    }
+    for (int i = 0; i < 2; i++) {
+        TEST_ESP_OK(esp_partition_read(ota_1, i * sizeof(buf), buf, sizeof(buf)));
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(image[i], buf, sizeof(buf));
+    }
+}
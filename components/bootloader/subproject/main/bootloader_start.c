@@ -22,6 +22,7 @@
 #include "bootloader_init.h"
 #include "bootloader_utility.h"
 #include "bootloader_common.h"
+#include "bootloader_profile.h"
 #include "sdkconfig.h"
 #include "esp_image_format.h"
 
@@ -43,7 +44,9 @@ void __attribute__((noreturn)) call_start_cpu0()
 
     // 2. Select the number of boot partition
     bootloader_state_t bs = { 0 };
+    BOOTLOADER_PROFILE_BEGIN(BOOTLOADER_PROFILE_PARTITION_TABLE);
     int boot_index = select_partition_number(&bs);
+    BOOTLOADER_PROFILE_END(BOOTLOADER_PROFILE_PARTITION_TABLE);
     if (boot_index == INVALID_INDEX) {
         bootloader_reset();
     }
@@ -10,7 +10,7 @@ endif
 COMPONENT_SRCDIRS := src
 
 ifndef IS_BOOTLOADER_BUILD
-COMPONENT_OBJEXCLUDE := src/bootloader_init.o
+COMPONENT_OBJEXCLUDE := src/bootloader_init.o src/bootloader_profile.o
 endif
 
 #
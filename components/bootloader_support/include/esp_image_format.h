@@ -126,6 +126,7 @@ typedef enum {
     ESP_IMAGE_VERIFY_SILENT, /* Verify image contents, load metadata. Don't print errors. */
 #ifdef BOOTLOADER_BUILD
     ESP_IMAGE_LOAD,          /* Verify image contents, load to memory. Print errors. */
+    ESP_IMAGE_LOAD_NO_VALIDATE, /* Load to memory without checking the checksum or SHA-256 of the image. Print errors. */
 #endif
 } esp_image_load_mode_t;
 
@@ -212,6 +213,26 @@ esp_err_t esp_image_verify(esp_image_load_mode_t mode, const esp_partition_pos_t
  */
 esp_err_t bootloader_load_image(const esp_partition_pos_t *part, esp_image_metadata_t *data);
 
+/**
+ * @brief Load an app image without verifying its contents (in bootloader mode only).
+ *
+ * Same as bootloader_load_image(), but the checksum and the appended SHA-256 of the image are not checked, and the
+ * flash mapped segments are not read at all. Headers are still checked, so the image must have been verified before,
+ * for example when it was written with esp_ota_write() and selected with esp_ota_set_boot_partition().
+ *
+ * Not available if signature verification on boot is enabled.
+ *
+ * @param part Partition to load the app from.
+ * @param[inout] data Pointer to the image metadata structure which is be filled in by this function.
+ *
+ * @return
+ * - ESP_OK if load was successful
+ * - ESP_ERR_IMAGE_FLASH_FAIL if a SPI flash error occurs
+ * - ESP_ERR_IMAGE_INVALID if the image headers appear invalid.
+ * - ESP_ERR_INVALID_ARG if the partition or data pointers are invalid.
+ */
+esp_err_t bootloader_load_image_no_verify(const esp_partition_pos_t *part, esp_image_metadata_t *data);
+
 /**
  * @brief Verify the bootloader image.
  *
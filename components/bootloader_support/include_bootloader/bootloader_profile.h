@@ -0,0 +1,71 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Stages of the bootloader which are timed if CONFIG_BOOTLOADER_PROFILE_BOOT_TIME is enabled */
+typedef enum {
+    BOOTLOADER_PROFILE_CLOCK,           /* Clock init */
+    BOOTLOADER_PROFILE_FLASH,           /* Flash QIO mode setup */
+    BOOTLOADER_PROFILE_PARTITION_TABLE, /* Partition table & OTA data parse */
+    BOOTLOADER_PROFILE_LOAD,            /* Verify and load of the app */
+    BOOTLOADER_PROFILE_MAX,
+} bootloader_profile_stage_t;
+
+/**
+ * @brief Start the boot time profile.
+ *
+ * Called by bootloader_init() at the start of the bootloader, after .bss is cleared.
+ */
+void bootloader_profile_init(void);
+
+/**
+ * @brief Start timing a stage of the bootloader.
+ *
+ * @param stage Stage to time. A stage can be timed several times, the times add up.
+ */
+void bootloader_profile_begin(bootloader_profile_stage_t stage);
+
+/**
+ * @brief Stop timing a stage of the bootloader, started with bootloader_profile_begin().
+ *
+ * @param stage Stage passed to bootloader_profile_begin().
+ */
+void bootloader_profile_end(bootloader_profile_stage_t stage);
+
+/**
+ * @brief Log the time spent in each stage, and since bootloader_profile_init().
+ */
+void bootloader_profile_report(void);
+
+#if defined(BOOTLOADER_BUILD) && defined(CONFIG_BOOTLOADER_PROFILE_BOOT_TIME)
+#define BOOTLOADER_PROFILE_INIT()           bootloader_profile_init()
+#define BOOTLOADER_PROFILE_BEGIN(stage)     bootloader_profile_begin(stage)
+#define BOOTLOADER_PROFILE_END(stage)       bootloader_profile_end(stage)
+#define BOOTLOADER_PROFILE_REPORT()         bootloader_profile_report()
+#else
+#define BOOTLOADER_PROFILE_INIT()
+#define BOOTLOADER_PROFILE_BEGIN(stage)
+#define BOOTLOADER_PROFILE_END(stage)
+#define BOOTLOADER_PROFILE_REPORT()
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -52,6 +52,7 @@
 #include "bootloader_clock.h"
 
 #include "flash_qio_mode.h"
+#include "bootloader_profile.h"
 
 extern int _bss_start;
 extern int _bss_end;
@@ -87,6 +88,7 @@ esp_err_t bootloader_init()
 
     //Clear bss
     memset(&_bss_start, 0, (&_bss_end - &_bss_start) * sizeof(_bss_start));
+    BOOTLOADER_PROFILE_INIT();
 
     /* completely reset MMU for both CPUs
        (in case serial bootloader was running) */
@@ -136,7 +138,9 @@ static esp_err_t bootloader_main()
         return ESP_FAIL;
     }
 #endif
+    BOOTLOADER_PROFILE_BEGIN(BOOTLOADER_PROFILE_CLOCK);
     bootloader_clock_configure();
+    BOOTLOADER_PROFILE_END(BOOTLOADER_PROFILE_CLOCK);
     uart_console_configure();
     wdt_reset_check();
     ESP_LOGI(TAG, "ESP-IDF %s 2nd stage bootloader", IDF_VER);
@@ -175,7 +179,9 @@ static esp_err_t bootloader_main()
     bootloader_random_enable();
 
 #if CONFIG_FLASHMODE_QIO || CONFIG_FLASHMODE_QOUT
+    BOOTLOADER_PROFILE_BEGIN(BOOTLOADER_PROFILE_FLASH);
     bootloader_enable_qio_mode();
+    BOOTLOADER_PROFILE_END(BOOTLOADER_PROFILE_FLASH);
 #endif
 
     print_flash_info(&fhdr);
@@ -0,0 +1,63 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <stdint.h>
+
+#include "esp_log.h"
+#include "soc/rtc.h"
+#include "bootloader_profile.h"
+
+static const char* TAG = "boot";
+
+/* The CPU clock changes during the boot, so the stages are timed with the RTC timer,
+   which keeps its rate. It runs from the RTC slow clock, the resolution is a few microseconds. */
+static uint64_t s_init_time;
+static uint64_t s_begin_time[BOOTLOADER_PROFILE_MAX];
+static uint64_t s_stage_time[BOOTLOADER_PROFILE_MAX];
+
+static const char *const s_stage_names[BOOTLOADER_PROFILE_MAX] = {
+    [BOOTLOADER_PROFILE_CLOCK]           = "clock init",
+    [BOOTLOADER_PROFILE_FLASH]           = "flash QIO setup",
+    [BOOTLOADER_PROFILE_PARTITION_TABLE] = "partition table",
+    [BOOTLOADER_PROFILE_LOAD]            = "verify and load",
+};
+
+static uint32_t ticks_to_us(uint64_t ticks)
+{
+    return (uint32_t) (ticks * 1000000 / rtc_clk_slow_freq_get_hz());
+}
+
+void bootloader_profile_init(void)
+{
+    s_init_time = rtc_time_get();
+}
+
+void bootloader_profile_begin(bootloader_profile_stage_t stage)
+{
+    s_begin_time[stage] = rtc_time_get();
+}
+
+void bootloader_profile_end(bootloader_profile_stage_t stage)
+{
+    s_stage_time[stage] += rtc_time_get() - s_begin_time[stage];
+}
+
+void bootloader_profile_report(void)
+{
+    const uint64_t now = rtc_time_get();
+    ESP_LOGI(TAG, "Boot time profile:");
+    for (int i = 0; i < BOOTLOADER_PROFILE_MAX; i++) {
+        ESP_LOGI(TAG, "  %-16s %8u us", s_stage_names[i], ticks_to_us(s_stage_time[i]));
+    }
+    ESP_LOGI(TAG, "  %-16s %8u us", "total", ticks_to_us(now - s_init_time));
+}
@@ -51,6 +51,7 @@
 #include "bootloader_common.h"
 #include "bootloader_utility.h"
 #include "bootloader_sha.h"
+#include "bootloader_profile.h"
 #include "esp_efuse.h"
 
 static const char* TAG = "boot";
@@ -60,6 +61,18 @@ static const char* TAG = "boot";
 
 static bool ota_has_initial_contents;
 
+#ifdef CONFIG_BOOTLOADER_SKIP_VALIDATE_SELECTED_APP
+/* Index of the selected app if it was verified before, and doesn't need to be verified again */
+static int trusted_index = INVALID_INDEX;
+#endif
+
+#ifdef CONFIG_BOOTLOADER_SKIP_VALIDATE_IN_DEEP_SLEEP
+/* Keeps the offset of the booted app during deep sleep. App partitions are 64 KB aligned,
+   the low 16 bits hold a magic value. */
+#define RTC_BOOTED_APP_REG      RTC_CNTL_STORE0_REG
+#define RTC_BOOTED_APP_MAGIC    0xB007
+#endif
+
 static void load_image(const esp_image_metadata_t* image_data);
 static void unpack_load_app(const esp_image_metadata_t *data);
 static void set_cache_and_start_app(uint32_t drom_addr,
@@ -289,12 +302,21 @@ static int get_active_otadata_with_check_anti_rollback(const bootloader_state_t
 }
 #endif
 
+static void set_trusted_index(int index, bool trusted)
+{
+#ifdef CONFIG_BOOTLOADER_SKIP_VALIDATE_SELECTED_APP
+    trusted_index = trusted ? index : INVALID_INDEX;
+#endif
+}
+
 int bootloader_utility_get_selected_boot_partition(const bootloader_state_t *bs)
 {
     esp_ota_select_entry_t otadata[2];
     int boot_index = FACTORY_INDEX;
+    bool trusted = true;
 
     if (bs->ota_info.offset == 0) {
+        set_trusted_index(FACTORY_INDEX, trusted);
         return FACTORY_INDEX;
     }
 
@@ -358,6 +380,8 @@ int bootloader_utility_get_selected_boot_partition(const bootloader_state_t *bs)
             ESP_LOGD(TAG, "Mapping seq %d -> OTA slot %d", ota_seq, boot_index);
 #ifdef CONFIG_APP_ROLLBACK_ENABLE
             if (otadata[active_otadata].ota_state == ESP_OTA_IMG_NEW) {
+                // first boot of the new app, verify it
+                trusted = false;
                 ESP_LOGD(TAG, "otadata[%d] is selected as new and marked PENDING_VERIFY state", active_otadata);
                 otadata[active_otadata].ota_state = ESP_OTA_IMG_PENDING_VERIFY;
                 write_otadata(&otadata[active_otadata], bs->ota_info.offset + FLASH_SECTOR_SIZE * active_otadata, write_encrypted);
@@ -373,31 +397,64 @@ int bootloader_utility_get_selected_boot_partition(const bootloader_state_t *bs)
         } else if (bs->factory.offset != 0) {
             ESP_LOGE(TAG, "ota data partition invalid, falling back to factory");
             boot_index = FACTORY_INDEX;
+            trusted = false;
         } else {
             ESP_LOGE(TAG, "ota data partition invalid and no factory, will try all partitions");
             boot_index = FACTORY_INDEX;
+            trusted = false;
         }
     }
 
+    set_trusted_index(boot_index, trusted);
     return boot_index;
 }
 
+#ifdef BOOTLOADER_BUILD
+/* Return true if the app in the partition was verified before, and doesn't need to be verified again */
+static bool is_trusted_app(const esp_partition_pos_t *partition, int index)
+{
+    bool trusted = false;
+    // apps are trusted only for the first try, the apps the bootloader falls back to are verified
+#ifdef CONFIG_BOOTLOADER_SKIP_VALIDATE_SELECTED_APP
+    trusted = (index == trusted_index);
+    trusted_index = INVALID_INDEX;
+#endif
+#ifdef CONFIG_BOOTLOADER_SKIP_VALIDATE_IN_DEEP_SLEEP
+    // waking up into the app which was running before deep sleep
+    if (rtc_get_reset_reason(0) == DEEPSLEEP_RESET &&
+        REG_READ(RTC_BOOTED_APP_REG) == (partition->offset | RTC_BOOTED_APP_MAGIC)) {
+        trusted = true;
+    }
+    REG_WRITE(RTC_BOOTED_APP_REG, 0);
+#endif
+    return trusted;
+}
+#endif
+
 /* Return true if a partition has a valid app image that was successfully loaded */
-static bool try_load_partition(const esp_partition_pos_t *partition, esp_image_metadata_t *data)
+static bool try_load_partition(const esp_partition_pos_t *partition, esp_image_metadata_t *data, int index)
 {
     if (partition->size == 0) {
         ESP_LOGD(TAG, "Can't boot from zero-length partition");
         return false;
     }
+    bool loaded = false;
 #ifdef BOOTLOADER_BUILD
-    if (bootloader_load_image(partition, data) == ESP_OK) {
+    BOOTLOADER_PROFILE_BEGIN(BOOTLOADER_PROFILE_LOAD);
+    if (is_trusted_app(partition, index)) {
+        ESP_LOGI(TAG, "Skipping validation of the app");
+        loaded = (bootloader_load_image_no_verify(partition, data) == ESP_OK);
+    } else {
+        loaded = (bootloader_load_image(partition, data) == ESP_OK);
+    }
+    BOOTLOADER_PROFILE_END(BOOTLOADER_PROFILE_LOAD);
+    if (loaded) {
         ESP_LOGI(TAG, "Loaded app from partition at offset 0x%x",
                  partition->offset);
-        return true;
     }
 #endif
 
-    return false;
+    return loaded;
 }
 
 // ota_has_initial_contents flag is set if factory does not present in partition table and
@@ -429,7 +486,7 @@ void bootloader_utility_load_boot_image(const bootloader_state_t *bs, int start_
     esp_image_metadata_t image_data;
 
     if(start_index == TEST_APP_INDEX) {
-        if (try_load_partition(&bs->test, &image_data)) {
+        if (try_load_partition(&bs->test, &image_data, TEST_APP_INDEX)) {
             load_image(&image_data);
         } else {
             ESP_LOGE(TAG, "No bootable test partition in the partition table");
@@ -444,7 +501,7 @@ void bootloader_utility_load_boot_image(const bootloader_state_t *bs, int start_
             continue;
         }
         ESP_LOGD(TAG, TRY_LOG_FORMAT, index, part.offset, part.size);
-        if (check_anti_rollback(&part) && try_load_partition(&part, &image_data)) {
+        if (check_anti_rollback(&part) && try_load_partition(&part, &image_data, index)) {
             set_actual_ota_seq(bs, index);
             load_image(&image_data);
         }
@@ -458,14 +515,14 @@ void bootloader_utility_load_boot_image(const bootloader_state_t *bs, int start_
             continue;
         }
         ESP_LOGD(TAG, TRY_LOG_FORMAT, index, part.offset, part.size);
-        if (check_anti_rollback(&part) && try_load_partition(&part, &image_data)) {
+        if (check_anti_rollback(&part) && try_load_partition(&part, &image_data, index)) {
             set_actual_ota_seq(bs, index);
             load_image(&image_data);
         }
         log_invalid_app_partition(index);
     }
 
-    if (try_load_partition(&bs->test, &image_data)) {
+    if (try_load_partition(&bs->test, &image_data, TEST_APP_INDEX)) {
         ESP_LOGW(TAG, "Falling back to test app as only bootable partition");
         load_image(&image_data);
     }
@@ -516,6 +573,15 @@ static void load_image(const esp_image_metadata_t* image_data)
     ESP_LOGI(TAG, "Disabling RNG early entropy source...");
     bootloader_random_disable();
 
+#ifdef CONFIG_BOOTLOADER_SKIP_VALIDATE_IN_DEEP_SLEEP
+    // remember the app for the wakeup from deep sleep
+    if ((image_data->start_addr & 0xFFFF) == 0) {
+        REG_WRITE(RTC_BOOTED_APP_REG, image_data->start_addr | RTC_BOOTED_APP_MAGIC);
+    }
+#endif
+
+    BOOTLOADER_PROFILE_REPORT();
+
     // copy loaded segments to RAM, set up caches for mapped segments, and start application
     unpack_load_app(image_data);
 }
@@ -49,6 +49,17 @@ static const char *TAG = "esp_image";
 /* Headroom to ensure between stack SP (at time of checking) and data loaded from flash */
 #define STACK_LOAD_HEADROOM 32768
 
+/* Size of the chunks the segment data is passed to bootloader_sha256_data() in.
+   The bootloader drives the SHA engine directly and bootloader_sha256_data() returns as soon as the last block is
+   started, so passing a single block at a time lets the engine hash it while the same block is checksummed and
+   loaded. In the app, bootloader_sha256_data() goes through mbedTLS and larger chunks are faster.
+*/
+#ifdef BOOTLOADER_BUILD
+#define SHA_CHUNK 64
+#else
+#define SHA_CHUNK 1024
+#endif
+
 /* Mmap source address mask */
 #define MMAP_ALIGNED_MASK 0x0000FFFF
 
@@ -68,7 +79,7 @@ static bool should_load(uint32_t load_addr);
 /* Return true if load_addr is an address the bootloader should map via flash cache */
 static bool should_map(uint32_t load_addr);
 
-/* Load or verify a segment */
+/* Load or verify a segment. The segment data isn't checksummed if checksum is NULL. */
 static esp_err_t process_segment(int index, uint32_t flash_addr, esp_image_segment_header_t *header, bool silent, bool do_load, bootloader_sha256_handle_t sha_handle, uint32_t *checksum);
 
 /* split segment and verify if data_len is too long */
@@ -91,20 +102,27 @@ static esp_err_t verify_segment_header(int index, const esp_image_segment_header
 
 static esp_err_t verify_checksum(bootloader_sha256_handle_t sha_handle, uint32_t checksum_word, esp_image_metadata_t *data);
 
+/* Return the length of the image including the checksum, padding and appended hash */
+static uint32_t padded_image_len(const esp_image_metadata_t *data);
+
 static esp_err_t __attribute__((unused)) verify_secure_boot_signature(bootloader_sha256_handle_t sha_handle, esp_image_metadata_t *data);
 static esp_err_t __attribute__((unused)) verify_simple_hash(bootloader_sha256_handle_t sha_handle, esp_image_metadata_t *data);
 
 static esp_err_t image_load(esp_image_load_mode_t mode, const esp_partition_pos_t *part, esp_image_metadata_t *data)
 {
 #ifdef BOOTLOADER_BUILD
-    bool do_load = (mode == ESP_IMAGE_LOAD);
+    bool do_load = (mode == ESP_IMAGE_LOAD) || (mode == ESP_IMAGE_LOAD_NO_VALIDATE);
+    bool do_verify = (mode != ESP_IMAGE_LOAD_NO_VALIDATE);
 #else
     bool do_load = false; // Can't load the image in app mode
+    bool do_verify = true;
 #endif
     bool silent = (mode == ESP_IMAGE_VERIFY_SILENT);
     esp_err_t err = ESP_OK;
     // checksum the image a word at a time. This shaves 30-40ms per MB of image size
     uint32_t checksum_word = ESP_ROM_CHECKSUM_INITIAL;
+    // the image is not checksummed or hashed if it is not verified
+    uint32_t *checksum = do_verify ? &checksum_word : NULL;
     bootloader_sha256_handle_t sha_handle = NULL;
 
     if (data == NULL || part == NULL) {
@@ -129,7 +147,7 @@ static esp_err_t image_load(esp_image_load_mode_t mode, const esp_partition_pos_
 #ifdef SECURE_BOOT_CHECK_SIGNATURE
     if (1) {
 #else
-    if (data->image.hash_appended) {
+    if (data->image.hash_appended && do_verify) {
 #endif
         sha_handle = bootloader_sha256_start();
         if (sha_handle == NULL) {
@@ -159,7 +177,7 @@ static esp_err_t image_load(esp_image_load_mode_t mode, const esp_partition_pos_
     for(int i = 0; i < data->image.segment_count; i++) {
         esp_image_segment_header_t *header = &data->segments[i];
         ESP_LOGV(TAG, "loading segment header %d at offset 0x%x", i, next_addr);
-        err = process_segment(i, next_addr, header, silent, do_load, sha_handle, &checksum_word);
+        err = process_segment(i, next_addr, header, silent, do_load, sha_handle, checksum);
         if (err != ESP_OK) {
             goto err;
         }
@@ -176,7 +194,9 @@ static esp_err_t image_load(esp_image_load_mode_t mode, const esp_partition_pos_
 
     data->image_len = end_addr - data->start_addr;
     ESP_LOGV(TAG, "image start 0x%08x end of last section 0x%08x", data->start_addr, end_addr);
-    if (!esp_cpu_in_ocd_debug_mode()) {
+    if (!do_verify) {
+        data->image_len = padded_image_len(data);
+    } else if (!esp_cpu_in_ocd_debug_mode()) {
         err = verify_checksum(sha_handle, checksum_word, data);
         if (err != ESP_OK) {
             goto err;
@@ -263,6 +283,15 @@ esp_err_t bootloader_load_image(const esp_partition_pos_t *part, esp_image_metad
 #endif
 }
 
+esp_err_t bootloader_load_image_no_verify(const esp_partition_pos_t *part, esp_image_metadata_t *data)
+{
+#if defined(BOOTLOADER_BUILD) && !defined(SECURE_BOOT_CHECK_SIGNATURE)
+    return image_load(ESP_IMAGE_LOAD_NO_VALIDATE, part, data);
+#else
+    return ESP_FAIL;
+#endif
+}
+
 esp_err_t esp_image_verify(esp_image_load_mode_t mode, const esp_partition_pos_t *part, esp_image_metadata_t *data)
 {
     return image_load(mode, part, data);
@@ -368,6 +397,11 @@ static esp_err_t process_segment(int index, uint32_t flash_addr, esp_image_segme
     }
 #endif // BOOTLOADER_BUILD
 
+    if (!do_load && sha_handle == NULL && checksum == NULL) {
+        // Nothing to do with the data of a mapped segment if the image is not verified
+        return ESP_OK;
+    }
+
 #ifndef BOOTLOADER_BUILD
     uint32_t free_page_count = spi_flash_mmap_get_free_pages(SPI_FLASH_MMAP_DATA);
     ESP_LOGD(TAG, "free data page_count 0x%08x",free_page_count);
@@ -414,25 +448,31 @@ static esp_err_t process_segment_data(intptr_t load_addr, uint32_t data_addr, ui
 #endif
 
     const uint32_t *src = data;
+    uint32_t checksum_word = (checksum != NULL) ? *checksum : 0;
 
-    for (int i = 0; i < data_len; i += 4) {
-        int w_i = i/4; // Word index
-        uint32_t w = src[w_i];
-        *checksum ^= w;
-#ifdef BOOTLOADER_BUILD
-        if (do_load) {
-            dest[w_i] = w ^ ((w_i & 1) ? ram_obfs_value[0] : ram_obfs_value[1]);
+    for (int i = 0; i < data_len; ) {
+        // Chunks end on a SHA_CHUNK boundary of the flash address. Images start 64 byte aligned and are hashed
+        // from the start, so the chunks are also whole SHA-256 blocks.
+        const int chunk_len = MIN(SHA_CHUNK - ((data_addr + i) % SHA_CHUNK), data_len - i);
+        const int w_end = (i + chunk_len) / 4;
+        if (sha_handle != NULL) {
+            bootloader_sha256_data(sha_handle, &src[i / 4], chunk_len);
         }
+        // checksum and load the chunk in the same pass, while the data is still in the flash cache
+        for (int w_i = i / 4; w_i < w_end; w_i++) { // Word index
+            uint32_t w = src[w_i];
+            checksum_word ^= w;
+#ifdef BOOTLOADER_BUILD
+            if (do_load) {
+                dest[w_i] = w ^ ((w_i & 1) ? ram_obfs_value[0] : ram_obfs_value[1]);
+            }
 #endif
-        // SHA_CHUNK determined experimentally as the optimum size
-        // to call bootloader_sha256_data() with. This is a bit
-        // counter-intuitive, but it's ~3ms better than using the
-        // SHA256 block size.
-        const size_t SHA_CHUNK = 1024;
-        if (sha_handle != NULL && i % SHA_CHUNK == 0) {
-            bootloader_sha256_data(sha_handle, &src[w_i],
-                                   MIN(SHA_CHUNK, data_len - i));
         }
+        i += chunk_len;
+    }
+
+    if (checksum != NULL) {
+        *checksum = checksum_word;
     }
 
     bootloader_munmap(data);
@@ -537,6 +577,17 @@ esp_err_t esp_image_verify_bootloader_data(esp_image_metadata_t *data)
 }
 
 
+static uint32_t padded_image_len(const esp_image_metadata_t *data)
+{
+    uint32_t length = data->image_len + 1; // Add a byte for the checksum
+    length = (length + 15) & ~15; // Pad to next full 16 byte block
+    if (data->image.hash_appended) {
+        // Account for the hash in the total image length
+        length += HASH_LEN;
+    }
+    return length;
+}
+
 static esp_err_t verify_checksum(bootloader_sha256_handle_t sha_handle, uint32_t checksum_word, esp_image_metadata_t *data)
 {
     uint32_t unpadded_length = data->image_len;
@@ -559,11 +610,7 @@ static esp_err_t verify_checksum(bootloader_sha256_handle_t sha_handle, uint32_t
         bootloader_sha256_data(sha_handle, buf, length - unpadded_length);
     }
 
-    if (data->image.hash_appended) {
-        // Account for the hash in the total image length
-        length += HASH_LEN;
-    }
-    data->image_len = length;
+    data->image_len = padded_image_len(data);
 
     return ESP_OK;
 }
@@ -131,6 +131,9 @@ esp_err_t esp_bluedroid_init(void)
 #ifdef CONFIG_BLUEDROID_MEM_DEBUG
     osi_mem_dbg_init();
 #endif
+#if CONFIG_BLUEDROID_MEM_POOL
+    osi_mem_pool_init();
+#endif
 
     future_p = btc_main_get_future_p(BTC_MAIN_INIT_FUTURE);
     *future_p = future_new();
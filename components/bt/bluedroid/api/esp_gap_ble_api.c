@@ -517,6 +517,41 @@ esp_err_t esp_ble_gap_clean_duplicate_scan_exceptional_list(esp_duplicate_scan_e
                 == BT_STATUS_SUCCESS ? ESP_OK : ESP_FAIL);
 }
 
+esp_err_t esp_ble_gap_set_host_scan_filter(const esp_ble_host_scan_filter_t *filter)
+{
+    btc_msg_t msg;
+    btc_ble_gap_args_t arg;
+
+    ESP_BLUEDROID_STATUS_CHECK(ESP_BLUEDROID_STATUS_ENABLED);
+
+    if (filter == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if ((filter->filter_type & ESP_BLE_HOST_SCAN_FILTER_UUID) && filter->uuid.len != ESP_UUID_LEN_16 &&
+            filter->uuid.len != ESP_UUID_LEN_32 && filter->uuid.len != ESP_UUID_LEN_128) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    msg.sig = BTC_SIG_API_CALL;
+    msg.pid = BTC_PID_GAP_BLE;
+    msg.act = BTC_GAP_BLE_ACT_SET_HOST_SCAN_FILTER;
+    memcpy(&arg.set_host_scan_filter.filter, filter, sizeof(esp_ble_host_scan_filter_t));
+
+    return (btc_transfer_context(&msg, &arg, sizeof(btc_ble_gap_args_t), NULL) == BT_STATUS_SUCCESS ? ESP_OK : ESP_FAIL);
+}
+
+esp_err_t esp_ble_gap_get_host_scan_filter_stats(esp_ble_host_scan_filter_stats_t *stats)
+{
+    ESP_BLUEDROID_STATUS_CHECK(ESP_BLUEDROID_STATUS_ENABLED);
+
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    btc_get_host_scan_filter_stats(stats);
+
+    return ESP_OK;
+}
+
 #if (SMP_INCLUDED == TRUE)
 esp_err_t esp_ble_gap_set_security_param(esp_ble_sm_param_t param_type,
         void *value, uint8_t len)
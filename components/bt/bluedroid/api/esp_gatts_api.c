@@ -22,6 +22,7 @@
 #include "common/bt_target.h"
 #include "stack/l2cdefs.h"
 #include "stack/l2c_api.h"
+#include "stack/gatt_api.h"
 
 #if (GATTS_INCLUDED == TRUE)
 #define COPY_TO_GATTS_ARGS(_gatt_args, _arg, _arg_type) memcpy(_gatt_args, _arg, sizeof(_arg_type))
@@ -278,6 +279,73 @@ esp_err_t esp_ble_gatts_send_indicate(esp_gatt_if_t gatts_if, uint16_t conn_id,
                                  btc_gatts_arg_deep_copy) == BT_STATUS_SUCCESS ? ESP_OK : ESP_FAIL);
 }
 
+static esp_err_t esp_ble_gatts_notify_queue_err(tGATT_STATUS status)
+{
+    switch (status) {
+    case GATT_SUCCESS:
+        return ESP_OK;
+    case GATT_NO_RESOURCES:
+        return ESP_ERR_NO_MEM;
+    case GATT_ILLEGAL_PARAMETER:
+        return ESP_ERR_INVALID_ARG;
+    default:
+        return ESP_FAIL;
+    }
+}
+
+esp_err_t esp_ble_gatts_notify_queue_open(esp_gatt_if_t gatts_if, uint16_t conn_id, uint16_t depth, uint16_t max_len)
+{
+    ESP_BLUEDROID_STATUS_CHECK(ESP_BLUEDROID_STATUS_ENABLED);
+
+    tGATT_STATUS status = GATTS_NotifyQueueOpen(BTC_GATT_CREATE_CONN_ID(gatts_if, conn_id), depth, max_len);
+    return (status == GATT_BUSY) ? ESP_ERR_INVALID_STATE : esp_ble_gatts_notify_queue_err(status);
+}
+
+esp_err_t esp_ble_gatts_notify_queue_send(esp_gatt_if_t gatts_if, uint16_t conn_id, uint16_t attr_handle,
+                                          uint16_t value_len, const uint8_t *value)
+{
+    ESP_BLUEDROID_STATUS_CHECK(ESP_BLUEDROID_STATUS_ENABLED);
+
+    if (value == NULL && value_len > 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    tGATT_STATUS status = GATTS_NotifyQueueSend(BTC_GATT_CREATE_CONN_ID(gatts_if, conn_id), attr_handle, value_len, value);
+    return (status == GATT_BUSY) ? ESP_ERR_NO_MEM : esp_ble_gatts_notify_queue_err(status);
+}
+
+esp_err_t esp_ble_gatts_notify_queue_close(esp_gatt_if_t gatts_if, uint16_t conn_id)
+{
+    ESP_BLUEDROID_STATUS_CHECK(ESP_BLUEDROID_STATUS_ENABLED);
+
+    return esp_ble_gatts_notify_queue_err(GATTS_NotifyQueueClose(BTC_GATT_CREATE_CONN_ID(gatts_if, conn_id)));
+}
+
+esp_err_t esp_ble_gatts_notify_queue_get_stats(esp_gatt_if_t gatts_if, uint16_t conn_id,
+                                               esp_ble_gatts_notify_queue_stats_t *stats)
+{
+    tGATTS_NOTIFY_Q_STATS q_stats;
+
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ESP_BLUEDROID_STATUS_CHECK(ESP_BLUEDROID_STATUS_ENABLED);
+
+    tGATT_STATUS status = GATTS_NotifyQueueGetStats(BTC_GATT_CREATE_CONN_ID(gatts_if, conn_id), &q_stats);
+    if (status != GATT_SUCCESS) {
+        return esp_ble_gatts_notify_queue_err(status);
+    }
+    stats->queued = q_stats.queued;
+    stats->sent = q_stats.sent;
+    stats->bytes = q_stats.bytes;
+    stats->full = q_stats.full;
+    stats->errors = q_stats.errors;
+    stats->congested = q_stats.congested;
+    stats->depth = q_stats.depth;
+    stats->count = q_stats.count;
+    stats->peak = q_stats.peak;
+    return ESP_OK;
+}
+
 esp_err_t esp_ble_gatts_send_response(esp_gatt_if_t gatts_if, uint16_t conn_id, uint32_t trans_id,
                                       esp_gatt_status_t status, esp_gatt_rsp_t *rsp)
 {
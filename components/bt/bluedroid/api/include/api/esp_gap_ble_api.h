@@ -605,6 +605,32 @@ typedef enum {
 
 typedef uint8_t esp_duplicate_info_t[ESP_BD_ADDR_LEN];
 
+typedef enum {
+    ESP_BLE_HOST_SCAN_FILTER_DUPLICATE       = BLE_BIT(0),   /*!< Report a device again only when its advertising data or scan response changes */
+    ESP_BLE_HOST_SCAN_FILTER_RSSI            = BLE_BIT(1),   /*!< Drop results with an RSSI below rssi_threshold */
+    ESP_BLE_HOST_SCAN_FILTER_UUID            = BLE_BIT(2),   /*!< Drop results which don't advertise the service uuid, in a service UUID list or in service data */
+    ESP_BLE_HOST_SCAN_FILTER_MANUFACTURER    = BLE_BIT(3),   /*!< Drop results without manufacturer specific data of manufacturer_id */
+} esp_ble_host_scan_filter_type_t;
+
+/**
+ * @brief Scan result filter applied by the host, see esp_ble_gap_set_host_scan_filter()
+ */
+typedef struct {
+    uint8_t         filter_type;        /*!< One or more of esp_ble_host_scan_filter_type_t, 0 to report every result */
+    int8_t          rssi_threshold;     /*!< Lowest RSSI reported with ESP_BLE_HOST_SCAN_FILTER_RSSI, in dBm */
+    esp_bt_uuid_t   uuid;               /*!< Service UUID required with ESP_BLE_HOST_SCAN_FILTER_UUID. It only matches UUIDs of the same length in the advertising data */
+    uint16_t        manufacturer_id;    /*!< Company identifier required with ESP_BLE_HOST_SCAN_FILTER_MANUFACTURER */
+} esp_ble_host_scan_filter_t;
+
+/**
+ * @brief Counters of the host scan filter, see esp_ble_gap_get_host_scan_filter_stats()
+ */
+typedef struct {
+    uint32_t        accepted;           /*!< Number of results passed to the application */
+    uint32_t        duplicates;         /*!< Number of results dropped as duplicates */
+    uint32_t        rejected;           /*!< Number of results dropped by the RSSI, UUID or manufacturer filter */
+} esp_ble_host_scan_filter_stats_t;
+
 /**
  * @brief Gap callback parameters union
  */
@@ -1092,6 +1118,38 @@ esp_err_t esp_ble_gap_remove_duplicate_scan_exceptional_device(esp_ble_duplicate
  */
 esp_err_t esp_ble_gap_clean_duplicate_scan_exceptional_list(esp_duplicate_scan_exceptional_list_type_t list_type);
 
+/**
+ * @brief           This function is called to set the filter the host applies to scan results.
+ *
+ *                  Unlike the duplicate filter of esp_ble_scan_params_t, which runs in the controller,
+ *                  this filter runs in the host right after the advertising data and the scan response
+ *                  of a device are merged. Dropped results never reach the BTC task, which matters in
+ *                  busy environments. On the other hand, the controller still sends every report to the host.
+ *
+ *                  The filter applies to the next results, and setting it restarts duplicate detection.
+ *                  Duplicate detection also restarts each time scanning is started.
+ *
+ * @param[in]       filter: the filter, all results are reported if filter_type is 0
+ *
+ * @return
+ *                  - ESP_OK : success
+ *                  - ESP_ERR_INVALID_ARG : uuid has an invalid length
+ *                  - other  : failed
+ */
+esp_err_t esp_ble_gap_set_host_scan_filter(const esp_ble_host_scan_filter_t *filter);
+
+/**
+ * @brief           Get the number of scan results accepted and dropped by the host scan filter
+ *                  since it was set.
+ *
+ * @param[out]      stats: the counters
+ *
+ * @return
+ *                  - ESP_OK : success
+ *                  - other  : failed
+ */
+esp_err_t esp_ble_gap_get_host_scan_filter_stats(esp_ble_host_scan_filter_stats_t *stats);
+
 #if (SMP_INCLUDED == TRUE)
 /**
 * @brief             Set a GAP security parameter value. Overrides the default value.
@@ -278,6 +278,19 @@ typedef union {
 
 } esp_ble_gatts_cb_param_t;
 
+/// Counters of the notification queue of a connection, see esp_ble_gatts_notify_queue_open()
+typedef struct {
+    uint32_t queued;                    /*!< Notifications accepted by esp_ble_gatts_notify_queue_send() */
+    uint32_t sent;                      /*!< Notifications passed to L2CAP */
+    uint32_t bytes;                     /*!< Value bytes passed to L2CAP */
+    uint32_t full;                      /*!< Notifications rejected because the queue was full */
+    uint32_t errors;                    /*!< Notifications L2CAP did not accept */
+    uint32_t congested;                 /*!< Number of times sending stopped until the channel cleared */
+    uint16_t depth;                     /*!< Number of notifications the queue holds */
+    uint16_t count;                     /*!< Notifications currently in the queue */
+    uint16_t peak;                      /*!< Highest number of notifications in the queue */
+} esp_ble_gatts_notify_queue_stats_t;
+
 /**
  * @brief GATT Server callback function type
  * @param event : Event type
@@ -484,6 +497,75 @@ esp_err_t esp_ble_gatts_stop_service(uint16_t service_handle);
 esp_err_t esp_ble_gatts_send_indicate(esp_gatt_if_t gatts_if, uint16_t conn_id, uint16_t attr_handle,
                                       uint16_t value_len, uint8_t *value, bool need_confirm);
 
+/**
+ * @brief           Create a notification queue for a connection, to stream notifications.
+ *
+ *                  The queue holds depth notifications of up to max_len bytes, allocated here.
+ *                  esp_ble_gatts_notify_queue_send() copies a notification into the queue without
+ *                  allocating memory or posting a message per notification, and the Bluetooth host
+ *                  passes the queued notifications to L2CAP whenever the ATT channel is not congested.
+ *                  The queue is deleted when the connection closes.
+ *
+ * @param[in]       gatts_if: GATT server access interface the notifications are sent from
+ * @param[in]       conn_id - connection identifier.
+ * @param[in]       depth - number of notifications the queue holds.
+ * @param[in]       max_len - maximum length of a notification value, at most the MTU minus 3.
+ *
+ * @return
+ *                  - ESP_OK : success
+ *                  - ESP_ERR_INVALID_STATE : the connection has a queue already
+ *                  - ESP_ERR_NO_MEM : out of memory
+ *                  - other  : failed
+ *
+ */
+esp_err_t esp_ble_gatts_notify_queue_open(esp_gatt_if_t gatts_if, uint16_t conn_id, uint16_t depth, uint16_t max_len);
+
+/**
+ * @brief           Queue a notification. Can be called from any task, the value is copied.
+ *
+ * @param[in]       gatts_if: GATT server access interface
+ * @param[in]       conn_id - connection identifier.
+ * @param[in]       attr_handle - attribute handle to notify.
+ * @param[in]       value_len - notification value length, at most the max_len of the queue.
+ * @param[in]       value: notification value.
+ *
+ * @return
+ *                  - ESP_OK : success
+ *                  - ESP_ERR_NO_MEM : the queue is full, try again once notifications were sent
+ *                  - other  : failed
+ *
+ */
+esp_err_t esp_ble_gatts_notify_queue_send(esp_gatt_if_t gatts_if, uint16_t conn_id, uint16_t attr_handle,
+                                          uint16_t value_len, const uint8_t *value);
+
+/**
+ * @brief           Delete the notification queue of a connection. Notifications not sent yet are dropped.
+ *
+ * @param[in]       gatts_if: GATT server access interface
+ * @param[in]       conn_id - connection identifier.
+ *
+ * @return
+ *                  - ESP_OK : success
+ *                  - other  : failed
+ *
+ */
+esp_err_t esp_ble_gatts_notify_queue_close(esp_gatt_if_t gatts_if, uint16_t conn_id);
+
+/**
+ * @brief           Get the counters of the notification queue of a connection.
+ *
+ * @param[in]       gatts_if: GATT server access interface
+ * @param[in]       conn_id - connection identifier.
+ * @param[out]      stats - the counters.
+ *
+ * @return
+ *                  - ESP_OK : success
+ *                  - other  : failed
+ *
+ */
+esp_err_t esp_ble_gatts_notify_queue_get_stats(esp_gatt_if_t gatts_if, uint16_t conn_id,
+                                               esp_ble_gatts_notify_queue_stats_t *stats);
+
 
 /**
  * @brief           This function is called to send a response to a request.
@@ -86,7 +86,7 @@ static void _btc_storage_save(void)
             }
         }
     }
-    btc_config_flush();
+    btc_config_save();
 }
 
 void btc_storage_save(void)
@@ -30,11 +30,13 @@
 #include "stack/bt_types.h"
 
 static const char *CONFIG_FILE_PATH = "bt_config.conf";
-static const period_ms_t CONFIG_SETTLE_PERIOD_MS = 3000;
+static const period_ms_t CONFIG_SETTLE_PERIOD_MS = BTC_CONFIG_SAVE_DELAY;
 
 static void btc_key_value_to_string(uint8_t *key_value, char *value_str, int key_length);
 static osi_mutex_t lock;  // protects operations on |config|.
 static config_t *config;
+static osi_alarm_t *save_timer;  // NULL if changes are saved immediately
+static bool save_pending;        // protected by |lock|
 
 bool btc_compare_address_key_value(const char *section, const char *key_type, void *key_value, int key_length)
 {
@@ -66,6 +68,21 @@ static void btc_key_value_to_string(uint8_t *key_value, char *value_str, int key
     return;
 }
 
+static void btc_config_save_timer_cb(void *data)
+{
+    UNUSED(data);
+
+    if (config == NULL) {
+        return;
+    }
+    btc_config_lock();
+    if (save_pending) {
+        save_pending = false;
+        config_save(config, CONFIG_FILE_PATH);
+    }
+    btc_config_unlock();
+}
+
 // Module lifecycle functions
 
 bool btc_config_init(void)
@@ -84,6 +101,13 @@ bool btc_config_init(void)
         // unlink(LEGACY_CONFIG_FILE_PATH);
     }
 
+    if (CONFIG_SETTLE_PERIOD_MS > 0) {
+        save_timer = osi_alarm_new("btc_config", btc_config_save_timer_cb, NULL, CONFIG_SETTLE_PERIOD_MS);
+        if (!save_timer) {
+            BTC_TRACE_WARNING("%s unable to create the save timer; saving changes immediately.\n", __func__);
+        }
+    }
+
     return true;
 
 error:;
@@ -104,6 +128,10 @@ bool btc_config_clean_up(void)
 {
     btc_config_flush();
 
+    if (save_timer) {
+        osi_alarm_free(save_timer);
+        save_timer = NULL;
+    }
     config_free(config);
     osi_mutex_free(&lock);
     config = NULL;
@@ -307,10 +335,33 @@ bool btc_config_remove_section(const char *section)
     return config_remove_section(config, section);
 }
 
+void btc_config_save(void)
+{
+    assert(config != NULL);
+
+    if (save_timer == NULL) {
+        config_save(config, CONFIG_FILE_PATH);
+        return;
+    }
+    if (save_pending) {
+        // The save already scheduled writes this change as well
+        return;
+    }
+    if (osi_alarm_set(save_timer, CONFIG_SETTLE_PERIOD_MS) == OSI_ALARM_ERR_PASS) {
+        save_pending = true;
+    } else {
+        config_save(config, CONFIG_FILE_PATH);
+    }
+}
+
 void btc_config_flush(void)
 {
     assert(config != NULL);
 
+    if (save_pending) {
+        osi_alarm_cancel(save_timer);
+        save_pending = false;
+    }
     config_save(config, CONFIG_FILE_PATH);
 }
 
@@ -318,6 +369,10 @@ int btc_config_clear(void)
 {
     assert(config != NULL);
 
+    if (save_pending) {
+        osi_alarm_cancel(save_timer);
+        save_pending = false;
+    }
     config_free(config);
 
     config = config_new_empty();
@@ -48,8 +48,8 @@ bt_status_t btc_storage_add_bonded_device(bt_bdaddr_t *remote_bd_addr,
     int ret = btc_config_set_int(bdstr, BTC_STORAGE_LINK_KEY_TYPE_STR, (int)key_type);
     ret &= btc_config_set_int(bdstr, BTC_STORAGE_PIN_LENGTH_STR, (int)pin_length);
     ret &= btc_config_set_bin(bdstr, BTC_STORAGE_LINK_KEY_STR, link_key, sizeof(LINK_KEY));
-    /* write bonded info immediately */
-    btc_config_flush();
+    /* write bonded info */
+    btc_config_save();
     btc_config_unlock();
 
     BTC_TRACE_DEBUG("Storage add rslt %d\n", ret);
@@ -160,8 +160,8 @@ bt_status_t btc_storage_remove_bonded_device(bt_bdaddr_t *remote_bd_addr)
     if (btc_config_exist(bdstr, BTC_STORAGE_LINK_KEY_STR)) {
         ret &= btc_config_remove(bdstr, BTC_STORAGE_LINK_KEY_STR);
     }
-    /* write bonded info immediately */
-    btc_config_flush();
+    /* write bonded info */
+    btc_config_save();
     btc_config_unlock();
 
     return ret ? BT_STATUS_SUCCESS : BT_STATUS_FAIL;
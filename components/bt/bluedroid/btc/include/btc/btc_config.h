@@ -44,6 +44,10 @@ const btc_config_section_iter_t *btc_config_section_end(void);
 const btc_config_section_iter_t *btc_config_section_next(const btc_config_section_iter_t *section);
 const char *btc_config_section_name(const btc_config_section_iter_t *section);
 
+// Saves the changes to flash, after BTC_CONFIG_SAVE_DELAY ms so that the changes
+// made within the delay are written together. Must be called with the config locked.
+void btc_config_save(void);
+// Saves the changes to flash immediately, including those waiting for a delayed save.
 void btc_config_flush(void);
 int btc_config_clear(void);
 
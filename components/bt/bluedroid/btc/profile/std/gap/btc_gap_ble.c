@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <stddef.h>
 #include <string.h>
 
 #include "osi/allocator.h"
@@ -29,6 +30,7 @@
 #include "btc/btc_dm.h"
 #include "btc/btc_util.h"
 #include "osi/mutex.h"
+#include "osi/alarm.h"
 #include "esp_bt.h"
 
 static tBTA_BLE_ADV_DATA gl_bta_adv_data;
@@ -47,6 +49,26 @@ static uint16_t btc_adv_list_count = 0;
 #define  BTC_ADV_LIST_MAX_COUNT     200
 #endif
 
+#if (BTC_SCAN_RESULT_BATCH_SIZE > 1)
+/* Scan results are sent to the BTC task in batches: one message carries up to
+ * BTC_SCAN_RESULT_BATCH_SIZE results, which the BTC task passes to the application
+ * one by one. A batch which is not full is sent or delivered after
+ * BTC_SCAN_RESULT_BATCH_TIMEOUT ms, and before any other search event. */
+#define BTC_GAP_BLE_SCAN_RESULT_BATCH_EVT   (ESP_GAP_BLE_EVT_MAX + 1)
+
+typedef struct {
+    uint8_t num;
+    struct ble_scan_result_evt_param results[BTC_SCAN_RESULT_BATCH_SIZE];
+} btc_scan_result_batch_t;
+
+static btc_scan_result_batch_t scan_batch;
+static btc_scan_result_batch_t scan_batch_expired;  /* batch delivered by the timer, only used in the BTC task */
+static uint8_t scan_batch_pending;                  /* batches sent to the BTC task and not delivered yet */
+static bool scan_batch_timeout;
+static osi_mutex_t scan_batch_lock;
+static osi_alarm_t *scan_batch_timer;
+#endif
+
 static inline void btc_gap_ble_cb_to_app(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param)
 {
     esp_gap_ble_cb_t btc_gap_ble_cb = (esp_gap_ble_cb_t)btc_profile_cb_get(BTC_PID_GAP_BLE);
@@ -547,6 +569,104 @@ static void btc_ble_set_scan_params(esp_ble_scan_params_t *scan_params, tBLE_SCA
     }
 }
 
+#if (BTC_SCAN_RESULT_BATCH_SIZE > 1)
+static void btc_scan_result_batch_send(void)
+{
+    btc_msg_t msg;
+
+    if (scan_batch.num == 0) {
+        return;
+    }
+    msg.sig = BTC_SIG_API_CB;
+    msg.pid = BTC_PID_GAP_BLE;
+    msg.act = BTC_GAP_BLE_SCAN_RESULT_BATCH_EVT;
+    if (btc_transfer_context(&msg, &scan_batch, offsetof(btc_scan_result_batch_t, results) +
+                             scan_batch.num * sizeof(scan_batch.results[0]), NULL) == BT_STATUS_SUCCESS) {
+        scan_batch_pending++;
+    } else {
+        BTC_TRACE_ERROR("%s btc_transfer_context failed, %d results lost\n", __func__, scan_batch.num);
+    }
+    scan_batch.num = 0;
+    scan_batch_timeout = false;
+}
+
+static void btc_scan_result_batch_deliver(const btc_scan_result_batch_t *batch)
+{
+    esp_ble_gap_cb_param_t param;
+
+    for (int i = 0; i < batch->num; i++) {
+        param.scan_rst = batch->results[i];
+        btc_gap_ble_cb_to_app(ESP_GAP_BLE_SCAN_RESULT_EVT, &param);
+    }
+}
+
+/* Take the batch which timed out, as long as no older batch is still on the way to the BTC task */
+static bool btc_scan_result_batch_take_expired(void)
+{
+    bool taken = false;
+
+    osi_mutex_lock(&scan_batch_lock, OSI_MUTEX_MAX_TIMEOUT);
+    if (scan_batch_timeout && scan_batch_pending == 0 && scan_batch.num > 0) {
+        memcpy(&scan_batch_expired, &scan_batch, sizeof(scan_batch));
+        scan_batch.num = 0;
+        scan_batch_timeout = false;
+        taken = true;
+    }
+    osi_mutex_unlock(&scan_batch_lock);
+    return taken;
+}
+
+/* Runs in the BTC task */
+static void btc_scan_result_batch_timeout(void *arg)
+{
+    osi_mutex_lock(&scan_batch_lock, OSI_MUTEX_MAX_TIMEOUT);
+    scan_batch_timeout = true;
+    osi_mutex_unlock(&scan_batch_lock);
+
+    if (btc_scan_result_batch_take_expired()) {
+        btc_scan_result_batch_deliver(&scan_batch_expired);
+    }
+}
+
+/* Runs in the BTC task */
+static void btc_scan_result_batch_handler(btc_msg_t *msg)
+{
+    btc_scan_result_batch_deliver((btc_scan_result_batch_t *)msg->arg);
+
+    osi_mutex_lock(&scan_batch_lock, OSI_MUTEX_MAX_TIMEOUT);
+    scan_batch_pending--;
+    osi_mutex_unlock(&scan_batch_lock);
+
+    if (btc_scan_result_batch_take_expired()) {
+        btc_scan_result_batch_deliver(&scan_batch_expired);
+    }
+}
+
+static void btc_scan_result_batch_add(const struct ble_scan_result_evt_param *result)
+{
+    osi_mutex_lock(&scan_batch_lock, OSI_MUTEX_MAX_TIMEOUT);
+    if (scan_batch_timer == NULL) {
+        scan_batch_timer = osi_alarm_new("scan_batch", btc_scan_result_batch_timeout, NULL, 0);
+    }
+    scan_batch.results[scan_batch.num++] = *result;
+    if (scan_batch.num == BTC_SCAN_RESULT_BATCH_SIZE) {
+        btc_scan_result_batch_send();
+    } else if (scan_batch.num == 1 && scan_batch_timer) {
+        /* the timer may still run for the previous batch, which filled up before it expired */
+        osi_alarm_cancel(scan_batch_timer);
+        osi_alarm_set(scan_batch_timer, BTC_SCAN_RESULT_BATCH_TIMEOUT);
+    }
+    osi_mutex_unlock(&scan_batch_lock);
+}
+
+static void btc_scan_result_batch_flush(void)
+{
+    osi_mutex_lock(&scan_batch_lock, OSI_MUTEX_MAX_TIMEOUT);
+    btc_scan_result_batch_send();
+    osi_mutex_unlock(&scan_batch_lock);
+}
+#endif /* BTC_SCAN_RESULT_BATCH_SIZE > 1 */
+
 static void btc_search_callback(tBTA_DM_SEARCH_EVT event, tBTA_DM_SEARCH *p_data)
 {
     esp_ble_gap_cb_param_t param;
@@ -611,6 +731,14 @@ static void btc_search_callback(tBTA_DM_SEARCH_EVT event, tBTA_DM_SEARCH *p_data
         BTC_TRACE_ERROR("%s : Unknown event 0x%x\n", __FUNCTION__, event);
         return;
     }
+#if (BTC_SCAN_RESULT_BATCH_SIZE > 1)
+    if (event == BTA_DM_INQ_RES_EVT) {
+        btc_scan_result_batch_add(&param.scan_rst);
+        return;
+    }
+    /* the results found so far go first */
+    btc_scan_result_batch_flush();
+#endif
     btc_transfer_context(&msg, &param, sizeof(esp_ble_gap_cb_param_t), NULL);
 }
 
@@ -788,6 +916,38 @@ void btc_get_whitelist_size(uint16_t *length)
     return;
 }
 
+void btc_get_host_scan_filter_stats(esp_ble_host_scan_filter_stats_t *stats)
+{
+    tBTM_BLE_HOST_FILTER_STATS btm_stats;
+
+    BTM_BleGetHostScanFilterStats(&btm_stats);
+    stats->accepted = btm_stats.accepted;
+    stats->duplicates = btm_stats.duplicates;
+    stats->rejected = btm_stats.rejected;
+}
+
+static void btc_ble_set_host_scan_filter(const esp_ble_host_scan_filter_t *filter)
+{
+    tBTM_BLE_HOST_FILTER btm_filter = {0};
+    UINT8 *p = btm_filter.uuid;
+
+    btm_filter.flags = filter->filter_type;
+    btm_filter.rssi_threshold = filter->rssi_threshold;
+    btm_filter.manufacturer_id = filter->manufacturer_id;
+    btm_filter.uuid_len = filter->uuid.len;
+    if (filter->uuid.len == ESP_UUID_LEN_16) {
+        UINT16_TO_STREAM(p, filter->uuid.uuid.uuid16);
+    } else if (filter->uuid.len == ESP_UUID_LEN_32) {
+        UINT32_TO_STREAM(p, filter->uuid.uuid.uuid32);
+    } else if (filter->uuid.len == ESP_UUID_LEN_128) {
+        memcpy(p, filter->uuid.uuid.uuid128, ESP_UUID_LEN_128);
+    }
+
+    if (BTM_BleSetHostScanFilter(&btm_filter) != BTM_SUCCESS) {
+        BTC_TRACE_ERROR("%s no memory for the duplicate filter\n", __func__);
+    }
+}
+
 static void btc_ble_start_scanning(uint32_t duration,
                                    tBTA_DM_SEARCH_CBACK *results_cb,
                                    tBTA_START_STOP_SCAN_CMPL_CBACK *start_scan_cb)
@@ -896,6 +1056,10 @@ void btc_gap_ble_cb_handler(btc_msg_t *msg)
 
     if (msg->act < ESP_GAP_BLE_EVT_MAX) {
         btc_gap_ble_cb_to_app(msg->act, param);
+#if (BTC_SCAN_RESULT_BATCH_SIZE > 1)
+    } else if (msg->act == BTC_GAP_BLE_SCAN_RESULT_BATCH_EVT) {
+        btc_scan_result_batch_handler(msg);
+#endif
     } else {
         BTC_TRACE_ERROR("%s, unknow msg->act = %d", __func__, msg->act);
     }
@@ -1146,6 +1310,9 @@ void btc_gap_ble_call_handler(btc_msg_t *msg)
                                                 arg->update_duplicate_exceptional_list.device_info,
                                                 btc_update_duplicate_exceptional_list_callback);
         break;
+    case BTC_GAP_BLE_ACT_SET_HOST_SCAN_FILTER:
+        btc_ble_set_host_scan_filter(&arg->set_host_scan_filter.filter);
+        break;
 #if (SMP_INCLUDED == TRUE)
     case BTC_GAP_BLE_SET_ENCRYPTION_EVT: {
         BD_ADDR bd_addr;
@@ -1262,13 +1429,25 @@ void btc_gap_ble_call_handler(btc_msg_t *msg)
 void btc_gap_callback_init(void)
 {
     BTM_BleRegiseterConnParamCallback(btc_update_conn_param_callback);
-
+#if (BTC_SCAN_RESULT_BATCH_SIZE > 1)
+    osi_mutex_new(&scan_batch_lock);
+#endif
 }
 
 void btc_gap_ble_deinit(void)
 {
     btc_cleanup_adv_data(&gl_bta_adv_data);
     btc_cleanup_adv_data(&gl_bta_scan_rsp_data);
+#if (BTC_SCAN_RESULT_BATCH_SIZE > 1)
+    if (scan_batch_timer) {
+        osi_alarm_free(scan_batch_timer);
+        scan_batch_timer = NULL;
+    }
+    osi_mutex_free(&scan_batch_lock);
+    scan_batch.num = 0;
+    scan_batch_pending = 0;
+    scan_batch_timeout = false;
+#endif
 }
 
 #if SCAN_QUEUE_CONGEST_CHECK
@@ -48,6 +48,7 @@ typedef enum {
     BTC_GAP_BLE_REMOVE_BOND_DEV_EVT,
     BTC_GAP_BLE_OOB_REQ_REPLY_EVT,
     BTC_GAP_BLE_UPDATE_DUPLICATE_SCAN_EXCEPTIONAL_LIST,
+    BTC_GAP_BLE_ACT_SET_HOST_SCAN_FILTER,
 } btc_gap_ble_act_t;
 
 /* btc_ble_gap_args_t */
@@ -171,11 +172,16 @@ typedef union {
     struct read_rssi_args {
         esp_bd_addr_t remote_addr;
     } read_rssi;
+    //BTC_GAP_BLE_ACT_SET_HOST_SCAN_FILTER
+    struct set_host_scan_filter_args {
+        esp_ble_host_scan_filter_t filter;
+    } set_host_scan_filter;
 } btc_ble_gap_args_t;
 
 void btc_gap_ble_call_handler(btc_msg_t *msg);
 void btc_gap_ble_cb_handler(btc_msg_t *msg);
 void btc_get_whitelist_size(uint16_t *length);
+void btc_get_host_scan_filter_stats(esp_ble_host_scan_filter_stats_t *stats);
 void btc_gap_ble_arg_deep_copy(btc_msg_t *msg, void *p_dest, void *p_src);
 void btc_gap_ble_arg_deep_free(btc_msg_t *msg);
 void btc_gap_ble_cb_deep_free(btc_msg_t *msg);
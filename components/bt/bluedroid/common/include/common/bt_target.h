@@ -349,6 +349,30 @@
 #define SCAN_QUEUE_CONGEST_CHECK  CONFIG_BLE_HOST_QUEUE_CONGESTION_CHECK
 #endif
 
+#ifndef CONFIG_BLE_HOST_SCAN_FILTER_CACHE_SIZE
+#define BTM_BLE_HOST_FILTER_CACHE_SIZE  64
+#else
+#define BTM_BLE_HOST_FILTER_CACHE_SIZE  CONFIG_BLE_HOST_SCAN_FILTER_CACHE_SIZE
+#endif
+
+#ifndef CONFIG_BLE_SCAN_RESULT_BATCH_SIZE
+#define BTC_SCAN_RESULT_BATCH_SIZE  1
+#else
+#define BTC_SCAN_RESULT_BATCH_SIZE  CONFIG_BLE_SCAN_RESULT_BATCH_SIZE
+#endif
+
+#ifndef CONFIG_BLE_SCAN_RESULT_BATCH_TIMEOUT
+#define BTC_SCAN_RESULT_BATCH_TIMEOUT  20
+#else
+#define BTC_SCAN_RESULT_BATCH_TIMEOUT  CONFIG_BLE_SCAN_RESULT_BATCH_TIMEOUT
+#endif
+
+#ifndef CONFIG_BT_BOND_SAVE_DELAY
+#define BTC_CONFIG_SAVE_DELAY  0
+#else
+#define BTC_CONFIG_SAVE_DELAY  CONFIG_BT_BOND_SAVE_DELAY
+#endif
+
 #ifndef CONFIG_GATTS_SEND_SERVICE_CHANGE_MODE
 #define GATTS_SEND_SERVICE_CHANGE_MODE GATTS_SEND_SERVICE_CHANGE_AUTO
 #else
@@ -139,6 +139,8 @@ void *osi_malloc_func(size_t size)
 #endif /* #if CONFIG_BT_ALLOCATION_FROM_SPIRAM_FIRST */
     osi_mem_dbg_record(p, size, __func__, __LINE__);
     return p;
+#elif CONFIG_BLUEDROID_MEM_POOL
+    return osi_mem_pool_malloc(size);
 #else
 #if CONFIG_BT_ALLOCATION_FROM_SPIRAM_FIRST
     return heap_caps_malloc_prefer(size, 2, MALLOC_CAP_DEFAULT|MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL);
@@ -159,6 +161,8 @@ void *osi_calloc_func(size_t size)
 #endif /* #if CONFIG_BT_ALLOCATION_FROM_SPIRAM_FIRST */
     osi_mem_dbg_record(p, size, __func__, __LINE__);
     return p;
+#elif CONFIG_BLUEDROID_MEM_POOL
+    return osi_mem_pool_calloc(size);
 #else
 #if CONFIG_BT_ALLOCATION_FROM_SPIRAM_FIRST
     return heap_caps_calloc_prefer(1, size, 2, MALLOC_CAP_DEFAULT|MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL);
@@ -173,5 +177,9 @@ void osi_free_func(void *ptr)
 #ifdef CONFIG_BLUEDROID_MEM_DEBUG
     osi_mem_dbg_clean(ptr, __func__, __LINE__); 
 #endif
+#if CONFIG_BLUEDROID_MEM_POOL
+    osi_mem_pool_free(ptr);
+#else
     free(ptr);
+#endif
 }
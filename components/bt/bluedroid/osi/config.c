@@ -31,6 +31,18 @@
 #define CONFIG_FILE_MAX_SIZE             (1536)//1.5k
 #define CONFIG_FILE_DEFAULE_LENGTH       (2048)
 #define CONFIG_KEY                       "bt_cfg_key"
+#define CONFIG_SECTION_KEY               "bt_cfg_s"
+#define CONFIG_ORDER_KEY                 "bt_cfg_order"
+#define CONFIG_SLOT_NONE                 (0xFFFF)
+#define CONFIG_KEYNAME_BUFSZ             (sizeof(CONFIG_KEY) + 5 + 1) // including log10(sizeof(i))
+
+// Each section is stored in its own NVS blob "bt_cfg_s<slot>", in the same text
+// format the whole config used to be stored in. The "bt_cfg_order" blob is the
+// array of the uint16_t slots in section order. Saving writes the sections which
+// changed since the last save, and the order only if sections were added or
+// removed, so a change to one device costs one small blob write. Configs stored
+// by older versions as a whole in "bt_cfg_key<n>" are converted by the first save.
+
 typedef struct {
     char *key;
     char *value;
@@ -39,10 +51,16 @@ typedef struct {
 typedef struct {
     char *name;
     list_t *entries;
+    uint16_t slot;          // CONFIG_SLOT_NONE until the section is first saved
+    bool dirty;             // changed since the last save
 } section_t;
 
 struct config_t {
     list_t *sections;
+    list_t *erased_slots;   // slots of the sections removed since the last save
+    bool order_dirty;       // sections were added or removed since the last save
+    bool synced;            // the slots in flash are known, i.e. the config was loaded from flash or saved
+    bool legacy;            // the config in flash is in the old format
 };
 
 // Empty definition; this type is aliased to list_node_t.
@@ -53,6 +71,8 @@ static void config_parse(nvs_handle fp, config_t *config);
 static section_t *section_new(const char *name);
 static void section_free(void *ptr);
 static section_t *section_find(const config_t *config, const char *section);
+static section_t *section_get(config_t *config, const char *section, bool insert_back);
+static void section_set_slot(config_t *config, section_t *sec, uint16_t slot);
 
 static entry_t *entry_new(const char *key, const char *value);
 static void entry_free(void *ptr);
@@ -72,6 +92,12 @@ config_t *config_new_empty(void)
         goto error;
     }
 
+    config->erased_slots = list_new(osi_free_func);
+    if (!config->erased_slots) {
+        OSI_TRACE_ERROR("%s unable to allocate list for erased slots.\n", __func__);
+        goto error;
+    }
+
     return config;
 
 error:;
@@ -114,6 +140,7 @@ void config_free(config_t *config)
     }
 
     list_free(config->sections);
+    list_free(config->erased_slots);
     osi_free(config);
 }
 
@@ -226,27 +253,23 @@ void config_set_bool(config_t *config, const char *section, const char *key, boo
 
 void config_set_string(config_t *config, const char *section, const char *key, const char *value, bool insert_back)
 {
-    section_t *sec = section_find(config, section);
-    if (!sec) {
-        sec = section_new(section);
-        if (insert_back) {
-            list_append(config->sections, sec);
-        } else {
-            list_prepend(config->sections, sec);
-        }
-    }
+    section_t *sec = section_get(config, section, insert_back);
 
     for (const list_node_t *node = list_begin(sec->entries); node != list_end(sec->entries); node = list_next(node)) {
         entry_t *entry = list_node(node);
         if (!strcmp(entry->key, key)) {
-            osi_free(entry->value);
-            entry->value = osi_strdup(value);
+            if (strcmp(entry->value, value)) {
+                osi_free(entry->value);
+                entry->value = osi_strdup(value);
+                sec->dirty = true;
+            }
             return;
         }
     }
 
     entry_t *entry = entry_new(key, value);
     list_append(sec->entries, entry);
+    sec->dirty = true;
 }
 
 bool config_remove_section(config_t *config, const char *section)
@@ -259,6 +282,8 @@ bool config_remove_section(config_t *config, const char *section)
         return false;
     }
 
+    section_set_slot(config, sec, CONFIG_SLOT_NONE);
+    config->order_dirty = true;
     return list_remove(config->sections, sec);
 }
 
@@ -274,6 +299,7 @@ bool config_remove_key(config_t *config, const char *section, const char *key)
         return false;
     }
 
+    sec->dirty = true;
     return list_remove(sec->entries, entry);
 }
 
@@ -303,32 +329,75 @@ const char *config_section_name(const config_section_node_t *node)
     return section->name;
 }
 
-static int get_config_size(const config_t *config)
+static int get_section_size(const section_t *section)
 {
-    assert(config != NULL);
+    int total_size = strlen(section->name) + strlen("[]\n");// format "[section->name]\n"
 
-    int w_len = 0, total_size = 0;
+    for (const list_node_t *enode = list_begin(section->entries); enode != list_end(section->entries); enode = list_next(enode)) {
+        const entry_t *entry = (const entry_t *)list_node(enode);
+        total_size += strlen(entry->key) + strlen(entry->value) + strlen(" = \n");// format "entry->key = entry->value\n"
+    }
+    total_size ++; //'\0'
+    return total_size;
+}
+
+static int section_to_text(const section_t *section, char *buf, int buf_size)
+{
+    int w_cnt_total = snprintf(buf, buf_size, "[%s]\n", section->name);
+
+    for (const list_node_t *enode = list_begin(section->entries); enode != list_end(section->entries); enode = list_next(enode)) {
+        const entry_t *entry = (const entry_t *)list_node(enode);
+        OSI_TRACE_DEBUG("(key, val): (%s, %s)\n", entry->key, entry->value);
+        w_cnt_total += snprintf(buf + w_cnt_total, buf_size - w_cnt_total, "%s = %s\n", entry->key, entry->value);
+    }
+    return w_cnt_total;
+}
 
+static bool slot_in_use(const config_t *config, uint16_t slot)
+{
     for (const list_node_t *node = list_begin(config->sections); node != list_end(config->sections); node = list_next(node)) {
         const section_t *section = (const section_t *)list_node(node);
-        w_len = strlen(section->name) + strlen("[]\n");// format "[section->name]\n"
-        total_size += w_len;
-
-        for (const list_node_t *enode = list_begin(section->entries); enode != list_end(section->entries); enode = list_next(enode)) {
-            const entry_t *entry = (const entry_t *)list_node(enode);
-            w_len = strlen(entry->key) + strlen(entry->value) + strlen(" = \n");// format "entry->key = entry->value\n"
-            total_size += w_len;
+        if (section->slot == slot) {
+            return true;
         }
+    }
+    return false;
+}
 
-        // Only add a separating newline if there are more sections.
-        if (list_next(node) != list_end(config->sections)) {
-                total_size ++;  //'\n'
-        } else {
-            break;
+static uint16_t get_free_slot(const config_t *config)
+{
+    uint16_t slot = 0;
+    while (slot_in_use(config, slot)) {
+        ++slot;
+    }
+    return slot;
+}
+
+// Returns the slots of the stored sections in order, or NULL if there are none
+static uint16_t *get_order_from_flash(nvs_handle fp, size_t *count)
+{
+    size_t length = 0;
+    esp_err_t err = nvs_get_blob(fp, CONFIG_ORDER_KEY, NULL, &length);
+    if (err != ESP_OK || length < sizeof(uint16_t)) {
+        if (err != ESP_OK && err != ESP_ERR_NVS_NOT_FOUND) {
+            OSI_TRACE_ERROR("%s, error %d\n", __func__, err);
         }
+        return NULL;
     }
-    total_size ++; //'\0'
-    return total_size;
+
+    uint16_t *order = osi_malloc(length);
+    if (!order) {
+        OSI_TRACE_ERROR("%s, malloc error\n", __func__);
+        return NULL;
+    }
+    err = nvs_get_blob(fp, CONFIG_ORDER_KEY, order, &length);
+    if (err != ESP_OK) {
+        OSI_TRACE_ERROR("%s, error %d\n", __func__, err);
+        osi_free(order);
+        return NULL;
+    }
+    *count = length / sizeof(uint16_t);
+    return order;
 }
 
 static int get_config_size_from_flash(nvs_handle fp)
@@ -376,7 +445,27 @@ static int get_config_size_from_flash(nvs_handle fp)
     return total_length;
 }
 
-bool config_save(const config_t *config, const char *filename)
+static bool config_is_dirty(const config_t *config)
+{
+    if (!config->synced || config->order_dirty || config->legacy) {
+        return true;
+    }
+    for (const list_node_t *node = list_begin(config->sections); node != list_end(config->sections); node = list_next(node)) {
+        const section_t *section = (const section_t *)list_node(node);
+        if (section->dirty) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static esp_err_t erase_key(nvs_handle fp, const char *keyname)
+{
+    esp_err_t err = nvs_erase_key(fp, keyname);
+    return (err == ESP_ERR_NVS_NOT_FOUND) ? ESP_OK : err;
+}
+
+bool config_save(config_t *config, const char *filename)
 {
     assert(config != NULL);
     assert(filename != NULL);
@@ -385,14 +474,12 @@ bool config_save(const config_t *config, const char *filename)
     esp_err_t err;
     int err_code = 0;
     nvs_handle fp;
-    char *line = osi_calloc(1024);
-    const size_t keyname_bufsz = sizeof(CONFIG_KEY) + 5 + 1; // including log10(sizeof(i))
-    char *keyname = osi_calloc(keyname_bufsz);
-    int config_size = get_config_size(config);
-    char *buf = osi_calloc(config_size + 100);
-    if (!line || !buf || !keyname) {
-        err_code |= 0x01;
-        goto error;
+    char keyname[CONFIG_KEYNAME_BUFSZ];
+    char *buf = NULL;
+    uint16_t *order = NULL;
+
+    if (!config_is_dirty(config)) {
+        return true;
     }
 
     err = nvs_open(filename, NVS_READWRITE, &fp);
@@ -405,51 +492,104 @@ bool config_save(const config_t *config, const char *filename)
         goto error;
     }
 
-    int w_cnt, w_cnt_total = 0;
+    if (!config->synced) {
+        // The config was not loaded from flash, it replaces all the sections stored there.
+        size_t count = 0;
+        uint16_t *stored = get_order_from_flash(fp, &count);
+        for (size_t i = 0; i < count; i++) {
+            uint16_t *slot = osi_malloc(sizeof(uint16_t));
+            if (!slot) {
+                osi_free(stored);
+                nvs_close(fp);
+                err_code |= 0x01;
+                goto error;
+            }
+            *slot = stored[i];
+            list_append(config->erased_slots, slot);
+        }
+        if (stored) {
+            osi_free(stored);
+        }
+        config->order_dirty = true;
+        config->legacy = true;
+    }
+
+    // Write the sections which changed, giving a slot to the new ones
     for (const list_node_t *node = list_begin(config->sections); node != list_end(config->sections); node = list_next(node)) {
-        const section_t *section = (const section_t *)list_node(node);
-        w_cnt = snprintf(line, 1024, "[%s]\n", section->name);
-        OSI_TRACE_DEBUG("section name: %s, w_cnt + w_cnt_total = %d\n", section->name, w_cnt + w_cnt_total);
-        memcpy(buf + w_cnt_total, line, w_cnt);
-        w_cnt_total += w_cnt;
-
-        for (const list_node_t *enode = list_begin(section->entries); enode != list_end(section->entries); enode = list_next(enode)) {
-            const entry_t *entry = (const entry_t *)list_node(enode);
-            OSI_TRACE_DEBUG("(key, val): (%s, %s)\n", entry->key, entry->value);
-            w_cnt = snprintf(line, 1024, "%s = %s\n", entry->key, entry->value);
-            OSI_TRACE_DEBUG("%s, w_cnt + w_cnt_total = %d", __func__, w_cnt + w_cnt_total);
-            memcpy(buf + w_cnt_total, line, w_cnt);
-            w_cnt_total += w_cnt;
+        section_t *section = (section_t *)list_node(node);
+        if (section->slot == CONFIG_SLOT_NONE) {
+            section->slot = get_free_slot(config);
+            section->dirty = true;
+        }
+        if (!section->dirty) {
+            continue;
         }
 
-        // Only add a separating newline if there are more sections.
-        if (list_next(node) != list_end(config->sections)) {
-            buf[w_cnt_total] = '\n';
-            w_cnt_total += 1;
+        int buf_size = get_section_size(section);
+        buf = osi_malloc(buf_size);
+        if (!buf) {
+            nvs_close(fp);
+            err_code |= 0x01;
+            goto error;
+        }
+        int w_cnt = section_to_text(section, buf, buf_size);
+        snprintf(keyname, sizeof(keyname), "%s%u", CONFIG_SECTION_KEY, section->slot);
+        OSI_TRACE_DEBUG("save section %s to %s, %d bytes\n", section->name, keyname, w_cnt);
+        err = nvs_set_blob(fp, keyname, buf, w_cnt);
+        osi_free(buf);
+        buf = NULL;
+        if (err != ESP_OK) {
+            nvs_close(fp);
+            err_code |= 0x04;
+            goto error;
+        }
+    }
+
+    if (config->order_dirty) {
+        size_t count = list_length(config->sections);
+        if (count == 0) {
+            err = erase_key(fp, CONFIG_ORDER_KEY);
         } else {
-            break;
+            order = osi_malloc(count * sizeof(uint16_t));
+            if (!order) {
+                nvs_close(fp);
+                err_code |= 0x01;
+                goto error;
+            }
+            size_t i = 0;
+            for (const list_node_t *node = list_begin(config->sections); node != list_end(config->sections); node = list_next(node)) {
+                order[i++] = ((const section_t *)list_node(node))->slot;
+            }
+            err = nvs_set_blob(fp, CONFIG_ORDER_KEY, order, count * sizeof(uint16_t));
+        }
+        if (err != ESP_OK) {
+            nvs_close(fp);
+            err_code |= 0x04;
+            goto error;
         }
     }
-    buf[w_cnt_total] = '\0';
-    if (w_cnt_total < CONFIG_FILE_MAX_SIZE) {
-        snprintf(keyname, keyname_bufsz, "%s%d", CONFIG_KEY, 0);
-        err = nvs_set_blob(fp, keyname, buf, w_cnt_total);
+
+    // Erase the sections removed, unless their slot was given to a new section
+    for (const list_node_t *node = list_begin(config->erased_slots); node != list_end(config->erased_slots); node = list_next(node)) {
+        uint16_t slot = *(const uint16_t *)list_node(node);
+        if (slot_in_use(config, slot)) {
+            continue;
+        }
+        snprintf(keyname, sizeof(keyname), "%s%u", CONFIG_SECTION_KEY, slot);
+        err = erase_key(fp, keyname);
         if (err != ESP_OK) {
             nvs_close(fp);
             err_code |= 0x04;
             goto error;
         }
-    }else {
-        uint count = (w_cnt_total / CONFIG_FILE_MAX_SIZE);
-        for (int i = 0; i <= count; i++)
-        {
-            snprintf(keyname, keyname_bufsz, "%s%d", CONFIG_KEY, i);
-            if (i == count) {
-                err = nvs_set_blob(fp, keyname, buf + i*CONFIG_FILE_MAX_SIZE, w_cnt_total - i*CONFIG_FILE_MAX_SIZE);
-                OSI_TRACE_DEBUG("save keyname = %s, i = %d, %d\n", keyname, i, w_cnt_total - i*CONFIG_FILE_MAX_SIZE);
-            }else {
-                err = nvs_set_blob(fp, keyname, buf + i*CONFIG_FILE_MAX_SIZE, CONFIG_FILE_MAX_SIZE);
-                OSI_TRACE_DEBUG("save keyname = %s, i = %d, %d\n", keyname, i, CONFIG_FILE_MAX_SIZE);
+    }
+
+    if (config->legacy) {
+        for (int i = 0; ; i++) {
+            snprintf(keyname, sizeof(keyname), "%s%d", CONFIG_KEY, i);
+            err = nvs_erase_key(fp, keyname);
+            if (err == ESP_ERR_NVS_NOT_FOUND) {
+                break;
             }
             if (err != ESP_OK) {
                 nvs_close(fp);
@@ -467,20 +607,25 @@ bool config_save(const config_t *config, const char *filename)
     }
 
     nvs_close(fp);
-    osi_free(line);
-    osi_free(buf);
-    osi_free(keyname);
+
+    for (const list_node_t *node = list_begin(config->sections); node != list_end(config->sections); node = list_next(node)) {
+        ((section_t *)list_node(node))->dirty = false;
+    }
+    list_clear(config->erased_slots);
+    config->order_dirty = false;
+    config->synced = true;
+    config->legacy = false;
+    if (order) {
+        osi_free(order);
+    }
     return true;
 
 error:
     if (buf) {
         osi_free(buf);
     }
-    if (line) {
-        osi_free(line);
-    }
-    if (keyname) {
-        osi_free(keyname);
+    if (order) {
+        osi_free(order);
     }
     if (err_code) {
         OSI_TRACE_ERROR("%s, err_code: 0x%x\n", __func__, err_code);
@@ -507,56 +652,24 @@ static char *trim(char *str)
     return str;
 }
 
-static void config_parse(nvs_handle fp, config_t *config)
+// Parses |length| bytes of config text in |buf|, which must be nul terminated.
+// Returns the section the last key/value pair was added to, NULL if there was none.
+static section_t *config_parse_text(config_t *config, char *buf, size_t length)
 {
-    assert(fp != 0);
-    assert(config != NULL);
-
-    esp_err_t err;
     int line_num = 0;
-    int err_code = 0;
-    uint16_t i = 0;
-    size_t length = CONFIG_FILE_DEFAULE_LENGTH;
-    size_t total_length = 0;
+    section_t *last = NULL;
     char *line = osi_calloc(1024);
     char *section = osi_calloc(1024);
-    const size_t keyname_bufsz = sizeof(CONFIG_KEY) + 5 + 1; // including log10(sizeof(i))
-    char *keyname = osi_calloc(keyname_bufsz);
-    int buf_size = get_config_size_from_flash(fp);
-    char *buf = osi_calloc(buf_size + 100);
-    if (!line || !section || !buf || !keyname) {
-        err_code |= 0x01;
-        goto error;
-    }
-    snprintf(keyname, keyname_bufsz, "%s%d", CONFIG_KEY, 0);
-    err = nvs_get_blob(fp, keyname, buf, &length);
-    if (err == ESP_ERR_NVS_NOT_FOUND) {
-        goto error;
-    }
-    if (err != ESP_OK) {
-        err_code |= 0x02;
+    if (!line || !section) {
+        OSI_TRACE_ERROR("%s, malloc error\n", __func__);
         goto error;
     }
-    total_length += length;
-    while (length == CONFIG_FILE_MAX_SIZE) {
-        length = CONFIG_FILE_DEFAULE_LENGTH;
-        snprintf(keyname, keyname_bufsz, "%s%d", CONFIG_KEY, ++i);
-        err = nvs_get_blob(fp, keyname, buf + CONFIG_FILE_MAX_SIZE * i, &length);
 
-        if (err == ESP_ERR_NVS_NOT_FOUND) {
-            break;
-        }
-        if (err != ESP_OK) {
-            err_code |= 0x02;
-            goto error;
-        }
-        total_length += length;
-    }
     char *p_line_end;
     char *p_line_bgn = buf;
     strcpy(section, CONFIG_DEFAULT_SECTION);
 
-    while ( (p_line_bgn < buf + total_length - 1) && (p_line_end = strchr(p_line_bgn, '\n'))) {
+    while ( (p_line_bgn < buf + length - 1) && (p_line_end = strchr(p_line_bgn, '\n'))) {
 
         // get one line
         int line_len = p_line_end - p_line_bgn;
@@ -591,19 +704,74 @@ static void config_parse(nvs_handle fp, config_t *config)
             }
             *split = '\0';
             config_set_string(config, section, trim(line_ptr), trim(split + 1), true);
+            if (!last || strcmp(last->name, section)) {
+                last = section_find(config, section);
+            }
         }
     }
 
 error:
-    if (buf) {
-        osi_free(buf);
-    }
     if (line) {
         osi_free(line);
     }
     if (section) {
         osi_free(section);
     }
+    return last;
+}
+
+// Loads a config stored by older versions, as a whole in one or more blobs
+static void config_parse_legacy(nvs_handle fp, config_t *config)
+{
+    esp_err_t err;
+    int err_code = 0;
+    uint16_t i = 0;
+    size_t length = CONFIG_FILE_DEFAULE_LENGTH;
+    size_t total_length = 0;
+    const size_t keyname_bufsz = sizeof(CONFIG_KEY) + 5 + 1; // including log10(sizeof(i))
+    char *keyname = osi_calloc(keyname_bufsz);
+    int buf_size = get_config_size_from_flash(fp);
+    char *buf = NULL;
+    if (buf_size == 0) {
+        goto error;
+    }
+    buf = osi_calloc(buf_size + 100);
+    if (!buf || !keyname) {
+        err_code |= 0x01;
+        goto error;
+    }
+    snprintf(keyname, keyname_bufsz, "%s%d", CONFIG_KEY, 0);
+    err = nvs_get_blob(fp, keyname, buf, &length);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        goto error;
+    }
+    if (err != ESP_OK) {
+        err_code |= 0x02;
+        goto error;
+    }
+    total_length += length;
+    while (length == CONFIG_FILE_MAX_SIZE) {
+        length = CONFIG_FILE_DEFAULE_LENGTH;
+        snprintf(keyname, keyname_bufsz, "%s%d", CONFIG_KEY, ++i);
+        err = nvs_get_blob(fp, keyname, buf + CONFIG_FILE_MAX_SIZE * i, &length);
+
+        if (err == ESP_ERR_NVS_NOT_FOUND) {
+            break;
+        }
+        if (err != ESP_OK) {
+            err_code |= 0x02;
+            goto error;
+        }
+        total_length += length;
+    }
+    config_parse_text(config, buf, total_length);
+    // The first save converts the config to one blob per section
+    config->legacy = true;
+
+error:
+    if (buf) {
+        osi_free(buf);
+    }
     if (keyname) {
         osi_free(keyname);
     }
@@ -612,6 +780,63 @@ error:
     }
 }
 
+// Loads the section stored in |slot|. Returns false if the slot is missing or invalid.
+static bool config_parse_slot(nvs_handle fp, config_t *config, uint16_t slot)
+{
+    char keyname[CONFIG_KEYNAME_BUFSZ];
+    size_t length = 0;
+    bool loaded = false;
+
+    snprintf(keyname, sizeof(keyname), "%s%u", CONFIG_SECTION_KEY, slot);
+    esp_err_t err = nvs_get_blob(fp, keyname, NULL, &length);
+    if (err != ESP_OK) {
+        OSI_TRACE_ERROR("%s unable to read %s, error %d\n", __func__, keyname, err);
+        return false;
+    }
+    char *buf = osi_calloc(length + 1);
+    if (!buf) {
+        OSI_TRACE_ERROR("%s, malloc error\n", __func__);
+        return false;
+    }
+    err = nvs_get_blob(fp, keyname, buf, &length);
+    if (err == ESP_OK) {
+        section_t *sec = config_parse_text(config, buf, length);
+        if (sec) {
+            // A section stored twice is merged with the copy loaded first, whose slot is dropped
+            loaded = (sec->slot == CONFIG_SLOT_NONE);
+            section_set_slot(config, sec, slot);
+            sec->dirty = false;
+        }
+    } else {
+        OSI_TRACE_ERROR("%s unable to read %s, error %d\n", __func__, keyname, err);
+    }
+    osi_free(buf);
+    return loaded;
+}
+
+static void config_parse(nvs_handle fp, config_t *config)
+{
+    assert(fp != 0);
+    assert(config != NULL);
+
+    size_t count = 0;
+    uint16_t *order = get_order_from_flash(fp, &count);
+    if (!order) {
+        config_parse_legacy(fp, config);
+        config->order_dirty = config->legacy;
+        config->synced = true;
+        return;
+    }
+
+    bool order_valid = true;
+    for (size_t i = 0; i < count; i++) {
+        order_valid &= config_parse_slot(fp, config, order[i]);
+    }
+    osi_free(order);
+    config->order_dirty = !order_valid;
+    config->synced = true;
+}
+
 static section_t *section_new(const char *name)
 {
     section_t *section = osi_calloc(sizeof(section_t));
@@ -621,6 +846,8 @@ static section_t *section_new(const char *name)
 
     section->name = osi_strdup(name);
     section->entries = list_new(entry_free);
+    section->slot = CONFIG_SLOT_NONE;
+    section->dirty = true;
     return section;
 }
 
@@ -648,6 +875,35 @@ static section_t *section_find(const config_t *config, const char *section)
     return NULL;
 }
 
+static section_t *section_get(config_t *config, const char *section, bool insert_back)
+{
+    section_t *sec = section_find(config, section);
+    if (!sec) {
+        sec = section_new(section);
+        if (insert_back) {
+            list_append(config->sections, sec);
+        } else {
+            list_prepend(config->sections, sec);
+        }
+        config->order_dirty = true;
+    }
+
+    return sec;
+}
+
+// Moves |sec| to |slot|, the slot it was stored in is erased by the next save
+static void section_set_slot(config_t *config, section_t *sec, uint16_t slot)
+{
+    if (sec->slot != CONFIG_SLOT_NONE && sec->slot != slot) {
+        uint16_t *erased = osi_malloc(sizeof(uint16_t));
+        if (erased) {
+            *erased = sec->slot;
+            list_append(config->erased_slots, erased);
+        }
+    }
+    sec->slot = slot;
+}
+
 static entry_t *entry_new(const char *key, const char *value)
 {
     entry_t *entry = osi_calloc(sizeof(entry_t));
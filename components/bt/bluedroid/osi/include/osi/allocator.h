@@ -23,6 +23,7 @@
 #include <stdlib.h>
 #include "esp_heap_caps.h"
 #include "sdkconfig.h"
+#include "osi/mem_pool.h"
 
 char *osi_strdup(const char *str);
 
@@ -116,6 +117,12 @@ do {                                                    \
     free(tmp_point);                                    \
 } while (0)
 
+#elif CONFIG_BLUEDROID_MEM_POOL
+
+#define osi_malloc(size)                  osi_mem_pool_malloc((size))
+#define osi_calloc(size)                  osi_mem_pool_calloc((size))
+#define osi_free(p)                       osi_mem_pool_free((p))
+
 #else
 
 #if CONFIG_BT_ALLOCATION_FROM_SPIRAM_FIRST
@@ -137,12 +137,12 @@ const config_section_node_t *config_section_next(const config_section_node_t *it
 // equal the value returned by |config_section_end|.
 const char *config_section_name(const config_section_node_t *iter);
 
-// Saves |config| to a file given by |filename|. Note that this could be a destructive
-// operation: if |filename| already exists, it will be overwritten. The config
-// module does not preserve comments or formatting so if a config file was opened
-// with |config_new| and subsequently overwritten with |config_save|, all comments
-// and special formatting in the original file will be lost. Neither |config| nor
-// |filename| may be NULL.
-bool config_save(const config_t *config, const char *filename);
+// Saves |config| to the NVS namespace given by |filename|. Each section is stored
+// in its own blob, and only the sections changed since |config| was loaded or last
+// saved are written, so saving after a change to one section costs one small write.
+// Saving a config which was not loaded with |config_new| replaces everything stored
+// in the namespace. Comments and special formatting are not preserved. Neither
+// |config| nor |filename| may be NULL.
+bool config_save(config_t *config, const char *filename);
 
 #endif /* #ifndef __CONFIG_H__ */
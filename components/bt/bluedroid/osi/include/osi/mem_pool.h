@@ -0,0 +1,59 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _MEM_POOL_H_
+#define _MEM_POOL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Fixed size block pools for the small, short lived allocations of Bluedroid:
+ * HCI commands and events, BTC messages and the like.
+ *
+ * The blocks of all pools are one region allocated by osi_mem_pool_init(). Each
+ * pool is a free list, so allocating and freeing a block is O(1) and does not
+ * touch the heap. Allocations which are larger than the largest block, or made
+ * while their pool is empty, fall back to the heap. osi_mem_pool_free() frees
+ * both kinds of memory.
+ */
+
+#define OSI_MEM_POOL_CLASSES    4
+
+typedef struct {
+    size_t block_size;      /* Size of the blocks of the pool in bytes */
+    size_t blocks;          /* Number of blocks of the pool */
+    size_t in_use;          /* Number of blocks currently allocated */
+    size_t peak;            /* Highest number of blocks allocated at the same time */
+    uint32_t allocs;        /* Number of allocations served by the pool */
+    uint32_t fallbacks;     /* Number of allocations of this size which went to the heap because the pool was empty */
+} osi_mem_pool_stats_t;
+
+/* Create the pools. Does nothing if they already exist: the region is never freed */
+bool osi_mem_pool_init(void);
+
+void *osi_mem_pool_malloc(size_t size);
+void *osi_mem_pool_calloc(size_t size);
+void osi_mem_pool_free(void *ptr);
+
+/* Fill stats[OSI_MEM_POOL_CLASSES] with the counters of the pools, smallest blocks first */
+void osi_mem_pool_get_stats(osi_mem_pool_stats_t *stats);
+
+/* Number of allocations larger than the largest block */
+uint32_t osi_mem_pool_get_oversize_count(void);
+
+void osi_mem_pool_show(void);
+
+#endif /* _MEM_POOL_H_ */
@@ -54,6 +54,7 @@ typedef enum {
     SIG_BTU_GENERAL_ALARM,
     SIG_BTU_ONESHOT_ALARM,
     SIG_BTU_L2CAP_ALARM,
+    SIG_BTU_GATT_NOTIFY_Q,
     SIG_BTU_NUM,
 } SIG_BTU_t;
 
@@ -0,0 +1,206 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_heap_caps.h"
+#include "common/bt_defs.h"
+#include "common/bt_trace.h"
+#include "osi/mem_pool.h"
+#include "sdkconfig.h"
+
+#if CONFIG_BLUEDROID_MEM_POOL
+
+#if CONFIG_BT_ALLOCATION_FROM_SPIRAM_FIRST
+#define heap_malloc(size)   heap_caps_malloc_prefer(size, 2, MALLOC_CAP_DEFAULT|MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL)
+#define heap_calloc(size)   heap_caps_calloc_prefer(1, size, 2, MALLOC_CAP_DEFAULT|MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL)
+#else
+#define heap_malloc(size)   malloc(size)
+#define heap_calloc(size)   calloc(1, size)
+#endif /* CONFIG_BT_ALLOCATION_FROM_SPIRAM_FIRST */
+
+typedef struct free_block {
+    struct free_block *next;
+} free_block_t;
+
+typedef struct {
+    uint8_t *base;
+    uint8_t *end;
+    free_block_t *free_list;
+    osi_mem_pool_stats_t stats;
+} pool_t;
+
+/* The largest block holds the biggest HCI event: a BT_HDR, the 2 byte event header and 255 bytes of parameters */
+static const size_t s_block_sizes[OSI_MEM_POOL_CLASSES] = { 32, 64, 128, 320 };
+
+static const size_t s_block_counts[OSI_MEM_POOL_CLASSES] = {
+    CONFIG_BLUEDROID_MEM_POOL_BLOCKS_32,
+    CONFIG_BLUEDROID_MEM_POOL_BLOCKS_64,
+    CONFIG_BLUEDROID_MEM_POOL_BLOCKS_128,
+    CONFIG_BLUEDROID_MEM_POOL_BLOCKS_320,
+};
+
+static pool_t s_pools[OSI_MEM_POOL_CLASSES];
+static uint8_t *s_region;
+static uint8_t *s_region_end;
+static uint32_t s_oversize;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+bool osi_mem_pool_init(void)
+{
+    if (s_region != NULL) {
+        return true;
+    }
+
+    size_t total = 0;
+    for (int i = 0; i < OSI_MEM_POOL_CLASSES; i++) {
+        total += s_block_sizes[i] * s_block_counts[i];
+    }
+    if (total == 0) {
+        return true;
+    }
+    uint8_t *region = heap_malloc(total);
+    if (region == NULL) {
+        OSI_TRACE_ERROR("%s cannot allocate %u bytes, using the heap\n", __func__, (unsigned) total);
+        return false;
+    }
+
+    uint8_t *p = region;
+    for (int i = 0; i < OSI_MEM_POOL_CLASSES; i++) {
+        pool_t *pool = &s_pools[i];
+        pool->base = p;
+        pool->free_list = NULL;
+        /* Link the blocks so that the lowest address is allocated first */
+        for (size_t n = s_block_counts[i]; n > 0; n--) {
+            free_block_t *block = (free_block_t *)(p + (n - 1) * s_block_sizes[i]);
+            block->next = pool->free_list;
+            pool->free_list = block;
+        }
+        p += s_block_sizes[i] * s_block_counts[i];
+        pool->end = p;
+        pool->stats = (osi_mem_pool_stats_t) {
+            .block_size = s_block_sizes[i],
+            .blocks = s_block_counts[i],
+        };
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_region_end = region + total;
+    s_region = region;
+    portEXIT_CRITICAL(&s_lock);
+    return true;
+}
+
+static void *pool_alloc(size_t size)
+{
+    if (size == 0 || s_region == NULL) {
+        return NULL;
+    }
+    if (size > s_block_sizes[OSI_MEM_POOL_CLASSES - 1]) {
+        portENTER_CRITICAL(&s_lock);
+        s_oversize++;
+        portEXIT_CRITICAL(&s_lock);
+        return NULL;
+    }
+
+    int i = 0;
+    while (size > s_block_sizes[i]) {
+        i++;
+    }
+    pool_t *pool = &s_pools[i];
+    void *block = NULL;
+    portENTER_CRITICAL(&s_lock);
+    if (pool->free_list != NULL) {
+        block = pool->free_list;
+        pool->free_list = pool->free_list->next;
+        pool->stats.allocs++;
+        if (++pool->stats.in_use > pool->stats.peak) {
+            pool->stats.peak = pool->stats.in_use;
+        }
+    } else {
+        pool->stats.fallbacks++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return block;
+}
+
+void *osi_mem_pool_malloc(size_t size)
+{
+    void *p = pool_alloc(size);
+    return p ? p : heap_malloc(size);
+}
+
+void *osi_mem_pool_calloc(size_t size)
+{
+    void *p = pool_alloc(size);
+    if (p == NULL) {
+        return heap_calloc(size);
+    }
+    memset(p, 0, size);
+    return p;
+}
+
+void osi_mem_pool_free(void *ptr)
+{
+    uint8_t *p = ptr;
+    if (p == NULL || p < s_region || p >= s_region_end) {
+        free(ptr);
+        return;
+    }
+
+    int i = 0;
+    while (p >= s_pools[i].end) {
+        i++;
+    }
+    pool_t *pool = &s_pools[i];
+    assert((p - pool->base) % pool->stats.block_size == 0);
+    free_block_t *block = ptr;
+    portENTER_CRITICAL(&s_lock);
+    assert(pool->stats.in_use > 0);
+    block->next = pool->free_list;
+    pool->free_list = block;
+    pool->stats.in_use--;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void osi_mem_pool_get_stats(osi_mem_pool_stats_t *stats)
+{
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < OSI_MEM_POOL_CLASSES; i++) {
+        stats[i] = s_pools[i].stats;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+uint32_t osi_mem_pool_get_oversize_count(void)
+{
+    return s_oversize;
+}
+
+void osi_mem_pool_show(void)
+{
+    osi_mem_pool_stats_t stats[OSI_MEM_POOL_CLASSES];
+
+    osi_mem_pool_get_stats(stats);
+    for (int i = 0; i < OSI_MEM_POOL_CLASSES; i++) {
+        BT_PRINT_I("BT_OSI", "pool %3u bytes: %u blocks, in use %u, peak %u, allocs %u, fallbacks %u",
+                   (unsigned) stats[i].block_size, (unsigned) stats[i].blocks, (unsigned) stats[i].in_use,
+                   (unsigned) stats[i].peak, (unsigned) stats[i].allocs, (unsigned) stats[i].fallbacks);
+    }
+    BT_PRINT_I("BT_OSI", "larger than a block: %u", (unsigned) osi_mem_pool_get_oversize_count());
+}
+
+#endif /* CONFIG_BLUEDROID_MEM_POOL */
@@ -3420,6 +3420,33 @@ void btm_ble_process_adv_pkt (UINT8 *p_data)
     }
 }
 
+/*******************************************************************************
+**
+** Function         btm_ble_host_filter_drop
+**
+** Description      Apply the host scan filter to a result which is about to be
+**                  reported. A dropped result is cleared like a reported one.
+**
+** Returns          TRUE if the result is dropped
+**
+*******************************************************************************/
+static BOOLEAN btm_ble_host_filter_drop(tINQ_DB_ENT *p_i, UINT8 result)
+{
+    tBTM_BLE_INQ_CB *p_le_inq_cb = &btm_cb.ble_ctr_cb.inq_var;
+    BOOLEAN reported = (btm_cb.btm_inq_vars.p_inq_results_cb && (result & BTM_BLE_INQ_RESULT)) ||
+                       (btm_cb.ble_ctr_cb.p_obs_results_cb && (result & BTM_BLE_OBS_RESULT)) ||
+                       (btm_cb.ble_ctr_cb.p_scan_results_cb && (result & BTM_BLE_DISCO_RESULT));
+
+    if (!reported || btm_ble_host_filter_accept(&p_i->inq_info.results, p_le_inq_cb->adv_data_cache)) {
+        return FALSE;
+    }
+    p_le_inq_cb->adv_len = 0;
+    memset(p_le_inq_cb->adv_addr, 0, BD_ADDR_LEN);
+    p_i->inq_info.results.adv_data_len = 0;
+    p_i->inq_info.results.scan_rsp_len = 0;
+    return TRUE;
+}
+
 /*******************************************************************************
 **
 ** Function         btm_ble_process_last_adv_pkt
@@ -3460,7 +3487,7 @@ static void btm_ble_process_last_adv_pkt(void)
     /* background connection in selective connection mode */
     if (btm_cb.ble_ctr_cb.bg_conn_type == BTM_BLE_CONN_SELECTIVE) {
         //do nothing
-    } else {
+    } else if (!btm_ble_host_filter_drop(p_i, result)) {
         if (p_inq_results_cb && (result & BTM_BLE_INQ_RESULT)) {
             (p_inq_results_cb)((tBTM_INQ_RESULTS *) &p_i->inq_info.results, p_le_inq_cb->adv_data_cache);
             p_le_inq_cb->adv_len = 0;
@@ -3602,7 +3629,7 @@ static void btm_ble_process_adv_pkt_cont(BD_ADDR bda, UINT8 addr_type, UINT8 evt
         } else {
             BTM_TRACE_DEBUG("None LE device, can not initiate selective connection\n");
         }
-    } else {
+    } else if (!btm_ble_host_filter_drop(p_i, result)) {
         if (p_inq_results_cb && (result & BTM_BLE_INQ_RESULT)) {
             (p_inq_results_cb)((tBTM_INQ_RESULTS *) &p_i->inq_info.results, p_le_inq_cb->adv_data_cache);
             p_le_inq_cb->adv_len = 0;
@@ -3657,6 +3684,7 @@ tBTM_STATUS btm_ble_start_scan(void)
     if(p_inq->scan_duplicate_filter > BTM_BLE_DUPLICATE_MAX) {
         p_inq->scan_duplicate_filter = BTM_BLE_DUPLICATE_DISABLE;
     }
+    btm_ble_host_filter_reset();
     /* start scan, disable duplicate filtering */
     if (!btsnd_hcic_ble_set_scan_enable (BTM_BLE_SCAN_ENABLE, p_inq->scan_duplicate_filter)) {
         status = BTM_NO_RESOURCES;
@@ -4294,6 +4322,7 @@ void btm_ble_init (void)
 #if BLE_VND_INCLUDED == FALSE
     btm_ble_adv_filter_init();
 #endif
+    btm_ble_host_filter_init();
 }
 
 /*******************************************************************************
@@ -4312,6 +4341,7 @@ void btm_ble_free (void)
     BTM_TRACE_DEBUG("%s", __func__);
 
     fixed_queue_free(p_cb->conn_pending_q, osi_free_func);
+    btm_ble_host_filter_free();
 }
 
 /*******************************************************************************
@@ -0,0 +1,304 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Host side filter of BLE advertising reports.
+ *
+ * The filter runs in the BTU task, on each result BTM is about to report to
+ * its callbacks, i.e. after the advertising data and the scan response of a
+ * device are merged. Results it rejects never reach BTA and BTC, so they cost
+ * neither a BTC message nor a switch to the BTC task.
+ *
+ * Duplicates are found with a direct mapped cache indexed by the address: each
+ * entry keeps a hash of the last data reported for an address, so a device is
+ * reported again as soon as its data changes. Two addresses sharing an entry
+ * evict each other and are then reported more often, never less.
+ */
+
+#include <string.h>
+#include "common/bt_target.h"
+
+#if (BLE_INCLUDED == TRUE)
+#include "stack/bt_types.h"
+#include "stack/btm_ble_api.h"
+#include "btm_int.h"
+#include "btm_ble_int.h"
+#include "osi/allocator.h"
+#include "osi/mutex.h"
+
+#define HOST_FILTER_KIND_ADV        1
+#define HOST_FILTER_KIND_SCAN_RSP   2
+
+typedef struct {
+    BD_ADDR bda;
+    UINT8   kind;       /* 0 if the entry is unused */
+    UINT32  hash;       /* hash of the advertising data reported last */
+} tBTM_BLE_HOST_FILTER_ENTRY;
+
+static osi_mutex_t host_filter_lock;
+static tBTM_BLE_HOST_FILTER host_filter;
+static tBTM_BLE_HOST_FILTER_STATS host_filter_stats;
+static tBTM_BLE_HOST_FILTER_ENTRY *host_filter_cache;
+
+static UINT32 btm_ble_host_filter_hash(UINT32 hash, const UINT8 *p, UINT16 len)
+{
+    /* FNV-1a */
+    while (len--) {
+        hash = (hash ^ *p++) * 16777619;
+    }
+    return hash;
+}
+
+static BOOLEAN btm_ble_host_filter_match_uuid(UINT8 ad_type, const UINT8 *p, UINT8 len)
+{
+    UINT8 uuid_len;
+    BOOLEAN service_data = FALSE;
+
+    switch (ad_type) {
+    case BTM_BLE_AD_TYPE_16SRV_PART:
+    case BTM_BLE_AD_TYPE_16SRV_CMPL:
+        uuid_len = LEN_UUID_16;
+        break;
+    case BTM_BLE_AD_TYPE_32SRV_PART:
+    case BTM_BLE_AD_TYPE_32SRV_CMPL:
+        uuid_len = LEN_UUID_32;
+        break;
+    case BTM_BLE_AD_TYPE_128SRV_PART:
+    case BTM_BLE_AD_TYPE_128SRV_CMPL:
+        uuid_len = LEN_UUID_128;
+        break;
+    case BTM_BLE_AD_TYPE_SERVICE_DATA:
+        uuid_len = LEN_UUID_16;
+        service_data = TRUE;
+        break;
+    case BTM_BLE_AD_TYPE_32SERVICE_DATA:
+        uuid_len = LEN_UUID_32;
+        service_data = TRUE;
+        break;
+    case BTM_BLE_AD_TYPE_128SERVICE_DATA:
+        uuid_len = LEN_UUID_128;
+        service_data = TRUE;
+        break;
+    default:
+        return FALSE;
+    }
+
+    if (uuid_len != host_filter.uuid_len) {
+        return FALSE;
+    }
+    if (service_data) {
+        /* the UUID is followed by the service data */
+        return len >= uuid_len && memcmp(p, host_filter.uuid, uuid_len) == 0;
+    }
+    for (; len >= uuid_len; len -= uuid_len, p += uuid_len) {
+        if (memcmp(p, host_filter.uuid, uuid_len) == 0) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/* Check the advertising data (and scan response) against the UUID and manufacturer filters */
+static BOOLEAN btm_ble_host_filter_match_data(const UINT8 *p_data, UINT16 data_len)
+{
+    BOOLEAN need_uuid = (host_filter.flags & BTM_BLE_HOST_FILTER_UUID) != 0;
+    BOOLEAN need_manu = (host_filter.flags & BTM_BLE_HOST_FILTER_MANUFACTURER) != 0;
+    const UINT8 *p = p_data;
+    const UINT8 *p_end = p_data + data_len;
+
+    while ((need_uuid || need_manu) && p + 1 < p_end) {
+        UINT8 len = p[0];
+        if (len == 0 || p + 1 + len > p_end) {
+            break;
+        }
+        UINT8 ad_type = p[1];
+        const UINT8 *p_val = p + 2;
+        UINT8 val_len = len - 1;
+
+        if (need_manu && ad_type == BTM_BLE_AD_TYPE_MANU && val_len >= 2) {
+            UINT16 manufacturer_id;
+            STREAM_TO_UINT16(manufacturer_id, p_val);
+            if (manufacturer_id == host_filter.manufacturer_id) {
+                need_manu = FALSE;
+            }
+        } else if (need_uuid && btm_ble_host_filter_match_uuid(ad_type, p_val, val_len)) {
+            need_uuid = FALSE;
+        }
+        p += 1 + len;
+    }
+    return !need_uuid && !need_manu;
+}
+
+/* Returns TRUE if the same data was reported for the device already, and records it otherwise */
+static BOOLEAN btm_ble_host_filter_is_duplicate(tBTM_INQ_RESULTS *p_res, const UINT8 *p_data, UINT16 data_len)
+{
+    UINT8 kind = (p_res->ble_evt_type == BTM_BLE_SCAN_RSP_EVT) ? HOST_FILTER_KIND_SCAN_RSP : HOST_FILTER_KIND_ADV;
+    UINT32 index = btm_ble_host_filter_hash(2166136261u, p_res->remote_bd_addr, BD_ADDR_LEN);
+    tBTM_BLE_HOST_FILTER_ENTRY *p_entry;
+    UINT32 hash;
+
+    index = btm_ble_host_filter_hash(index, &kind, 1) % BTM_BLE_HOST_FILTER_CACHE_SIZE;
+    p_entry = &host_filter_cache[index];
+    hash = btm_ble_host_filter_hash(2166136261u, p_data, data_len);
+
+    if (p_entry->kind == kind && p_entry->hash == hash &&
+            memcmp(p_entry->bda, p_res->remote_bd_addr, BD_ADDR_LEN) == 0) {
+        return TRUE;
+    }
+    memcpy(p_entry->bda, p_res->remote_bd_addr, BD_ADDR_LEN);
+    p_entry->kind = kind;
+    p_entry->hash = hash;
+    return FALSE;
+}
+
+void btm_ble_host_filter_init(void)
+{
+    osi_mutex_new(&host_filter_lock);
+    memset(&host_filter, 0, sizeof(host_filter));
+    memset(&host_filter_stats, 0, sizeof(host_filter_stats));
+}
+
+void btm_ble_host_filter_free(void)
+{
+    osi_mutex_free(&host_filter_lock);
+    if (host_filter_cache) {
+        osi_free(host_filter_cache);
+        host_filter_cache = NULL;
+    }
+    host_filter.flags = 0;
+}
+
+/*******************************************************************************
+**
+** Function         btm_ble_host_filter_reset
+**
+** Description      Forget the devices reported so far, called when a scan starts.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btm_ble_host_filter_reset(void)
+{
+    osi_mutex_lock(&host_filter_lock, OSI_MUTEX_MAX_TIMEOUT);
+    if (host_filter_cache) {
+        memset(host_filter_cache, 0, BTM_BLE_HOST_FILTER_CACHE_SIZE * sizeof(tBTM_BLE_HOST_FILTER_ENTRY));
+    }
+    osi_mutex_unlock(&host_filter_lock);
+}
+
+/*******************************************************************************
+**
+** Function         btm_ble_host_filter_accept
+**
+** Description      Apply the host scan filter to a result BTM is about to report.
+**
+** Parameters       p_res: the result
+**                  p_data: advertising data followed by the scan response
+**
+** Returns          TRUE if the result is to be reported, FALSE to drop it.
+**
+*******************************************************************************/
+BOOLEAN btm_ble_host_filter_accept(tBTM_INQ_RESULTS *p_res, UINT8 *p_data)
+{
+    UINT16 data_len = p_res->adv_data_len + p_res->scan_rsp_len;
+    BOOLEAN accept = TRUE;
+
+    if (host_filter.flags == 0) {
+        return TRUE;
+    }
+
+    osi_mutex_lock(&host_filter_lock, OSI_MUTEX_MAX_TIMEOUT);
+    if ((host_filter.flags & BTM_BLE_HOST_FILTER_RSSI) && p_res->rssi < host_filter.rssi_threshold) {
+        accept = FALSE;
+    } else if ((host_filter.flags & (BTM_BLE_HOST_FILTER_UUID | BTM_BLE_HOST_FILTER_MANUFACTURER)) &&
+               !btm_ble_host_filter_match_data(p_data, data_len)) {
+        accept = FALSE;
+    }
+
+    if (!accept) {
+        host_filter_stats.rejected++;
+    } else if ((host_filter.flags & BTM_BLE_HOST_FILTER_DUPLICATE) && host_filter_cache &&
+               btm_ble_host_filter_is_duplicate(p_res, p_data, data_len)) {
+        host_filter_stats.duplicates++;
+        accept = FALSE;
+    } else {
+        host_filter_stats.accepted++;
+    }
+    osi_mutex_unlock(&host_filter_lock);
+
+    return accept;
+}
+
+/*******************************************************************************
+**
+** Function         BTM_BleSetHostScanFilter
+**
+** Description      Set the filter applied by the host to advertising reports.
+**                  Changing the filter also forgets the devices reported so far.
+**
+** Parameters       p_filter: the filter, NULL to report everything
+**
+** Returns          BTM_SUCCESS, or BTM_NO_RESOURCES if there is no memory
+**                  for the duplicate cache
+**
+*******************************************************************************/
+tBTM_STATUS BTM_BleSetHostScanFilter(const tBTM_BLE_HOST_FILTER *p_filter)
+{
+    tBTM_STATUS status = BTM_SUCCESS;
+
+    osi_mutex_lock(&host_filter_lock, OSI_MUTEX_MAX_TIMEOUT);
+    if (p_filter == NULL) {
+        memset(&host_filter, 0, sizeof(host_filter));
+    } else {
+        host_filter = *p_filter;
+    }
+
+    if (host_filter.flags & BTM_BLE_HOST_FILTER_DUPLICATE) {
+        if (host_filter_cache == NULL) {
+            host_filter_cache = osi_calloc(BTM_BLE_HOST_FILTER_CACHE_SIZE * sizeof(tBTM_BLE_HOST_FILTER_ENTRY));
+        } else {
+            memset(host_filter_cache, 0, BTM_BLE_HOST_FILTER_CACHE_SIZE * sizeof(tBTM_BLE_HOST_FILTER_ENTRY));
+        }
+        if (host_filter_cache == NULL) {
+            host_filter.flags &= ~BTM_BLE_HOST_FILTER_DUPLICATE;
+            status = BTM_NO_RESOURCES;
+        }
+    } else if (host_filter_cache) {
+        osi_free(host_filter_cache);
+        host_filter_cache = NULL;
+    }
+    memset(&host_filter_stats, 0, sizeof(host_filter_stats));
+    osi_mutex_unlock(&host_filter_lock);
+
+    return status;
+}
+
+/*******************************************************************************
+**
+** Function         BTM_BleGetHostScanFilterStats
+**
+** Description      Get the number of results the host scan filter accepted and
+**                  dropped since the filter was set.
+**
+** Returns          void
+**
+*******************************************************************************/
+void BTM_BleGetHostScanFilterStats(tBTM_BLE_HOST_FILTER_STATS *p_stats)
+{
+    osi_mutex_lock(&host_filter_lock, OSI_MUTEX_MAX_TIMEOUT);
+    *p_stats = host_filter_stats;
+    osi_mutex_unlock(&host_filter_lock);
+}
+
+#endif /* BLE_INCLUDED == TRUE */
@@ -374,6 +374,10 @@ extern "C" {
 void btm_ble_timeout(TIMER_LIST_ENT *p_tle);
 void btm_ble_process_adv_pkt (UINT8 *p);
 void btm_ble_process_adv_discard_evt(UINT8 *p);
+void btm_ble_host_filter_init(void);
+void btm_ble_host_filter_free(void);
+void btm_ble_host_filter_reset(void);
+BOOLEAN btm_ble_host_filter_accept(tBTM_INQ_RESULTS *p_res, UINT8 *p_data);
 void btm_ble_proc_scan_rsp_rpt (UINT8 *p);
 tBTM_STATUS btm_ble_read_remote_name(BD_ADDR remote_bda, tBTM_INQ_INFO *p_cur, tBTM_CMPL_CB *p_cb);
 BOOLEAN btm_ble_cancel_remote_name(BD_ADDR remote_bda);
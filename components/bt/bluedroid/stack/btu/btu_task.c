@@ -247,6 +247,11 @@ void btu_task_thread_handler(void *arg)
             case SIG_BTU_L2CAP_ALARM:
                 btu_l2cap_alarm_process((TIMER_LIST_ENT *)e.par);
                 break;
+#if (defined(GATTS_INCLUDED) && GATTS_INCLUDED == TRUE)
+            case SIG_BTU_GATT_NOTIFY_Q:
+                gatt_notify_queue_drain((UINT8)(uintptr_t)e.par);
+                break;
+#endif
             default:
                 break;
             }
@@ -139,6 +139,7 @@ void gatt_init (void)
     gatt_cb.hdl_cfg.app_start_hdl  = GATT_APP_START_HANDLE;
 #if (GATTS_INCLUDED == TRUE)
     gatt_profile_db_init();
+    gatt_notify_queue_init();
 #endif  ///GATTS_INCLUDED == TRUE
     //init local MTU size
     gatt_default.local_mtu = GATT_MAX_MTU_SIZE;
@@ -192,6 +193,7 @@ void gatt_free(void)
         gatt_free_attr_value_buffer(&gatt_cb.hdl_list[i]);
         gatt_free_hdl_buffer(&gatt_cb.hdl_list[i]);
     }
+    gatt_notify_queue_deinit();
 #endif /* #if (GATTS_INCLUDED == TRUE) */
 #if GATT_DYNAMIC_MEMORY
     FREE_AND_RESET(gatt_cb_ptr);
@@ -506,6 +508,11 @@ static void gatt_channel_congestion(tGATT_TCB *p_tcb, BOOLEAN congested)
         gatt_cl_send_next_cmd_inq(p_tcb);
     }
 #endif  ///GATTC_INCLUDED == TRUE
+#if (GATTS_INCLUDED == TRUE)
+    if (p_tcb != NULL) {
+        gatt_notify_queue_congestion(p_tcb->tcb_idx, congested);
+    }
+#endif  ///GATTS_INCLUDED == TRUE
     /* notifying all applications for the connection up event */
     for (i = 0, p_reg = gatt_cb.cl_rcb ; i < GATT_MAX_APPS; i++, p_reg++) {
         if (p_reg->in_use) {
@@ -0,0 +1,378 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Notification queues of the GATT server.
+ *
+ * A queue is a ring of fixed size slots allocated when it is opened for a
+ * connection. GATTS_NotifyQueueSend() copies the notification into the next
+ * free slot from the task of the caller, and wakes up the BTU task only if it
+ * is not already draining the queue: there is neither an allocation nor a
+ * BTC/BTA message per notification.
+ *
+ * The BTU task passes notifications to L2CAP until L2CAP reports the ATT
+ * channel as congested, i.e. until the channel used up its share of the
+ * controller buffers, and resumes when the channel is uncongested.
+ */
+
+#include <string.h>
+#include "common/bt_target.h"
+
+#if (GATTS_INCLUDED == TRUE)
+#include "osi/allocator.h"
+#include "osi/mutex.h"
+#include "osi/thread.h"
+#include "stack/btu.h"
+#include "stack/btm_api.h"
+#include "stack/l2c_api.h"
+#include "gatt_int.h"
+
+#define GATT_NOTIFY_Q_SLOT_HDR_SIZE     (sizeof(tGATT_NOTIFY_Q_SLOT))
+#define GATT_INVALID_ACL_HANDLE         0xFFFF
+
+typedef struct {
+    UINT16 attr_handle;
+    UINT16 len;
+    /* followed by the value */
+} tGATT_NOTIFY_Q_SLOT;
+
+typedef struct {
+    UINT16  conn_id;
+    UINT16  hci_handle;     /* GATT_INVALID_ACL_HANDLE unless ATT runs on the LE fixed channel */
+    UINT16  max_len;
+    UINT16  slot_size;
+    UINT16  head;           /* slot sent next */
+    BOOLEAN drain_pending;  /* the BTU task was posted to drain the queue */
+    BOOLEAN draining;       /* the BTU task is sending the head slot */
+    BOOLEAN released;       /* closed while draining, the BTU task frees it */
+    BOOLEAN congested;
+    UINT8   *p_slots;
+    tGATTS_NOTIFY_Q_STATS stats;
+} tGATT_NOTIFY_Q;
+
+static osi_mutex_t notify_q_lock;
+static tGATT_NOTIFY_Q *notify_q[GATT_MAX_PHY_CHANNEL];
+
+static tGATT_NOTIFY_Q_SLOT *gatt_notify_queue_slot(tGATT_NOTIFY_Q *p_q, UINT16 index)
+{
+    return (tGATT_NOTIFY_Q_SLOT *)(p_q->p_slots + (UINT32)(index % p_q->stats.depth) * p_q->slot_size);
+}
+
+static void gatt_notify_queue_free(tGATT_NOTIFY_Q *p_q)
+{
+    osi_free(p_q->p_slots);
+    osi_free(p_q);
+}
+
+void gatt_notify_queue_init(void)
+{
+    osi_mutex_new(&notify_q_lock);
+    memset(notify_q, 0, sizeof(notify_q));
+}
+
+void gatt_notify_queue_deinit(void)
+{
+    for (UINT8 i = 0; i < GATT_MAX_PHY_CHANNEL; i++) {
+        gatt_notify_queue_release(i);
+    }
+    osi_mutex_free(&notify_q_lock);
+}
+
+/*******************************************************************************
+**
+** Function         gatt_notify_queue_release
+**
+** Description      Free the notification queue of a connection, called when the
+**                  connection is closed.
+**
+** Returns          void
+**
+*******************************************************************************/
+void gatt_notify_queue_release(UINT8 tcb_idx)
+{
+    tGATT_NOTIFY_Q *p_q;
+
+    osi_mutex_lock(&notify_q_lock, OSI_MUTEX_MAX_TIMEOUT);
+    p_q = notify_q[tcb_idx];
+    notify_q[tcb_idx] = NULL;
+    if (p_q && p_q->draining) {
+        p_q->released = TRUE;
+        p_q = NULL;
+    }
+    osi_mutex_unlock(&notify_q_lock);
+
+    if (p_q) {
+        gatt_notify_queue_free(p_q);
+    }
+}
+
+/*******************************************************************************
+**
+** Function         gatt_notify_queue_drain
+**
+** Description      Pass the queued notifications of a connection to L2CAP until
+**                  the channel is congested. Runs in the BTU task.
+**
+** Returns          void
+**
+*******************************************************************************/
+void gatt_notify_queue_drain(UINT8 tcb_idx)
+{
+    tGATT_NOTIFY_Q *p_q;
+    tGATT_NOTIFY_Q_SLOT *p_slot;
+    tGATT_STATUS status;
+
+    osi_mutex_lock(&notify_q_lock, OSI_MUTEX_MAX_TIMEOUT);
+    p_q = notify_q[tcb_idx];
+    if (p_q) {
+        p_q->drain_pending = FALSE;
+    }
+    while (p_q && !p_q->congested && p_q->stats.count > 0) {
+        /* L2CAP drops what is sent on a congested channel: wait for the congestion callback */
+        if (p_q->hci_handle != GATT_INVALID_ACL_HANDLE && L2CA_CheckIsCongest(L2CAP_ATT_CID, p_q->hci_handle)) {
+            p_q->congested = TRUE;
+            p_q->stats.congested++;
+            break;
+        }
+        /* The producer only writes the free slots, so the head slot is left alone while unlocked */
+        p_slot = gatt_notify_queue_slot(p_q, p_q->head);
+        p_q->draining = TRUE;
+        osi_mutex_unlock(&notify_q_lock);
+
+        status = GATTS_HandleValueNotification(p_q->conn_id, p_slot->attr_handle, p_slot->len,
+                                               (UINT8 *)p_slot + GATT_NOTIFY_Q_SLOT_HDR_SIZE);
+
+        osi_mutex_lock(&notify_q_lock, OSI_MUTEX_MAX_TIMEOUT);
+        p_q->draining = FALSE;
+        if (p_q->released) {
+            /* closed meanwhile */
+            osi_mutex_unlock(&notify_q_lock);
+            gatt_notify_queue_free(p_q);
+            return;
+        }
+        if (status == GATT_SUCCESS || status == GATT_CONGESTED) {
+            p_q->stats.sent++;
+            p_q->stats.bytes += p_slot->len;
+        } else {
+            GATT_TRACE_WARNING("%s notification dropped, status %d\n", __func__, status);
+            p_q->stats.errors++;
+        }
+        p_q->head = (p_q->head + 1) % p_q->stats.depth;
+        p_q->stats.count--;
+        if (status == GATT_CONGESTED) {
+            /* L2CAP queued the notification, wait for the channel to clear */
+            p_q->congested = TRUE;
+            p_q->stats.congested++;
+        }
+    }
+    osi_mutex_unlock(&notify_q_lock);
+}
+
+/*******************************************************************************
+**
+** Function         gatt_notify_queue_congestion
+**
+** Description      Called in the BTU task when the ATT channel of a connection
+**                  becomes congested or uncongested.
+**
+** Returns          void
+**
+*******************************************************************************/
+void gatt_notify_queue_congestion(UINT8 tcb_idx, BOOLEAN congested)
+{
+    tGATT_NOTIFY_Q *p_q;
+    BOOLEAN resume = FALSE;
+
+    osi_mutex_lock(&notify_q_lock, OSI_MUTEX_MAX_TIMEOUT);
+    p_q = notify_q[tcb_idx];
+    if (p_q) {
+        resume = p_q->congested && !congested;
+        p_q->congested = congested;
+    }
+    osi_mutex_unlock(&notify_q_lock);
+
+    if (resume) {
+        gatt_notify_queue_drain(tcb_idx);
+    }
+}
+
+/*******************************************************************************
+**
+** Function         GATTS_NotifyQueueOpen
+**
+** Description      Create the notification queue of a connection.
+**
+** Parameter        conn_id: connection identifier, the notifications are sent
+**                           on behalf of its GATT interface.
+**                  depth: number of notifications the queue holds.
+**                  max_len: maximum length of a notification value.
+**
+** Returns          GATT_SUCCESS, GATT_BUSY if the connection has a queue
+**                  already, GATT_NO_RESOURCES if there is not enough memory,
+**                  GATT_ILLEGAL_PARAMETER otherwise.
+**
+*******************************************************************************/
+tGATT_STATUS GATTS_NotifyQueueOpen(UINT16 conn_id, UINT16 depth, UINT16 max_len)
+{
+    UINT8 tcb_idx = GATT_GET_TCB_IDX(conn_id);
+    tGATT_TCB *p_tcb = gatt_get_tcb_by_idx(tcb_idx);
+    tGATT_STATUS status = GATT_SUCCESS;
+    tGATT_NOTIFY_Q *p_q;
+
+    if (gatt_get_regcb(GATT_GET_GATT_IF(conn_id)) == NULL || p_tcb == NULL ||
+            depth == 0 || max_len == 0 || max_len > GATT_MAX_ATTR_LEN) {
+        return GATT_ILLEGAL_PARAMETER;
+    }
+
+    p_q = (tGATT_NOTIFY_Q *)osi_calloc(sizeof(tGATT_NOTIFY_Q));
+    if (p_q == NULL) {
+        return GATT_NO_RESOURCES;
+    }
+    /* keep the slots aligned for the header */
+    p_q->slot_size = (GATT_NOTIFY_Q_SLOT_HDR_SIZE + max_len + 3) & ~3;
+    p_q->p_slots = (UINT8 *)osi_malloc((UINT32)depth * p_q->slot_size);
+    if (p_q->p_slots == NULL) {
+        osi_free(p_q);
+        return GATT_NO_RESOURCES;
+    }
+    p_q->conn_id = conn_id;
+    p_q->hci_handle = GATT_INVALID_ACL_HANDLE;
+    if (p_tcb->att_lcid == L2CAP_ATT_CID) {
+        p_q->hci_handle = BTM_GetHCIConnHandle(p_tcb->peer_bda, p_tcb->transport);
+    }
+    p_q->max_len = max_len;
+    p_q->stats.depth = depth;
+
+    osi_mutex_lock(&notify_q_lock, OSI_MUTEX_MAX_TIMEOUT);
+    if (notify_q[tcb_idx] == NULL) {
+        notify_q[tcb_idx] = p_q;
+        p_q = NULL;
+    } else {
+        status = GATT_BUSY;
+    }
+    osi_mutex_unlock(&notify_q_lock);
+
+    if (p_q) {
+        gatt_notify_queue_free(p_q);
+    }
+    return status;
+}
+
+/*******************************************************************************
+**
+** Function         GATTS_NotifyQueueClose
+**
+** Description      Delete the notification queue of a connection. Notifications
+**                  still in the queue are dropped.
+**
+** Returns          GATT_SUCCESS, or GATT_ILLEGAL_PARAMETER if the connection
+**                  has no queue.
+**
+*******************************************************************************/
+tGATT_STATUS GATTS_NotifyQueueClose(UINT16 conn_id)
+{
+    UINT8 tcb_idx = GATT_GET_TCB_IDX(conn_id);
+
+    if (tcb_idx >= GATT_MAX_PHY_CHANNEL || notify_q[tcb_idx] == NULL) {
+        return GATT_ILLEGAL_PARAMETER;
+    }
+    gatt_notify_queue_release(tcb_idx);
+    return GATT_SUCCESS;
+}
+
+/*******************************************************************************
+**
+** Function         GATTS_NotifyQueueSend
+**
+** Description      Queue a notification. May be called from any task; the value
+**                  is copied before the function returns.
+**
+** Returns          GATT_SUCCESS if queued, GATT_BUSY if the queue is full,
+**                  GATT_ILLEGAL_PARAMETER if the connection has no queue or the
+**                  value is longer than the queue allows.
+**
+*******************************************************************************/
+tGATT_STATUS GATTS_NotifyQueueSend(UINT16 conn_id, UINT16 attr_handle, UINT16 val_len, const UINT8 *p_val)
+{
+    UINT8 tcb_idx = GATT_GET_TCB_IDX(conn_id);
+    tGATT_STATUS status = GATT_SUCCESS;
+    tGATT_NOTIFY_Q *p_q;
+    tGATT_NOTIFY_Q_SLOT *p_slot;
+    BOOLEAN post = FALSE;
+
+    if (tcb_idx >= GATT_MAX_PHY_CHANNEL || !GATT_HANDLE_IS_VALID(attr_handle)) {
+        return GATT_ILLEGAL_PARAMETER;
+    }
+
+    osi_mutex_lock(&notify_q_lock, OSI_MUTEX_MAX_TIMEOUT);
+    p_q = notify_q[tcb_idx];
+    if (p_q == NULL || val_len > p_q->max_len) {
+        status = GATT_ILLEGAL_PARAMETER;
+    } else if (p_q->stats.count == p_q->stats.depth) {
+        p_q->stats.full++;
+        status = GATT_BUSY;
+    } else {
+        p_slot = gatt_notify_queue_slot(p_q, p_q->head + p_q->stats.count);
+        p_slot->attr_handle = attr_handle;
+        p_slot->len = val_len;
+        memcpy((UINT8 *)p_slot + GATT_NOTIFY_Q_SLOT_HDR_SIZE, p_val, val_len);
+        p_q->stats.queued++;
+        if (++p_q->stats.count > p_q->stats.peak) {
+            p_q->stats.peak = p_q->stats.count;
+        }
+        if (!p_q->drain_pending && !p_q->congested) {
+            p_q->drain_pending = TRUE;
+            post = TRUE;
+        }
+    }
+    osi_mutex_unlock(&notify_q_lock);
+
+    if (post && btu_task_post(SIG_BTU_GATT_NOTIFY_Q, (void *)(uintptr_t)tcb_idx, TASK_POST_BLOCKING) != TASK_POST_SUCCESS) {
+        osi_mutex_lock(&notify_q_lock, OSI_MUTEX_MAX_TIMEOUT);
+        if (notify_q[tcb_idx] == p_q) {
+            p_q->drain_pending = FALSE;
+        }
+        osi_mutex_unlock(&notify_q_lock);
+    }
+    return status;
+}
+
+/*******************************************************************************
+**
+** Function         GATTS_NotifyQueueGetStats
+**
+** Description      Get the counters of the notification queue of a connection.
+**
+** Returns          GATT_SUCCESS, or GATT_ILLEGAL_PARAMETER if the connection
+**                  has no queue.
+**
+*******************************************************************************/
+tGATT_STATUS GATTS_NotifyQueueGetStats(UINT16 conn_id, tGATTS_NOTIFY_Q_STATS *p_stats)
+{
+    UINT8 tcb_idx = GATT_GET_TCB_IDX(conn_id);
+    tGATT_STATUS status = GATT_ILLEGAL_PARAMETER;
+
+    if (tcb_idx >= GATT_MAX_PHY_CHANNEL) {
+        return status;
+    }
+    osi_mutex_lock(&notify_q_lock, OSI_MUTEX_MAX_TIMEOUT);
+    if (notify_q[tcb_idx]) {
+        *p_stats = notify_q[tcb_idx]->stats;
+        status = GATT_SUCCESS;
+    }
+    osi_mutex_unlock(&notify_q_lock);
+    return status;
+}
+
+#endif /* GATTS_INCLUDED == TRUE */
@@ -573,6 +573,13 @@ extern void gatt_set_err_rsp(BOOLEAN enable, UINT8 req_op_code, UINT8 err_status
 extern void gatt_init (void);
 extern void gatt_free(void);
 
+/* from gatt_notify_queue.c */
+extern void gatt_notify_queue_init(void);
+extern void gatt_notify_queue_deinit(void);
+extern void gatt_notify_queue_release(UINT8 tcb_idx);
+extern void gatt_notify_queue_drain(UINT8 tcb_idx);
+extern void gatt_notify_queue_congestion(UINT8 tcb_idx, BOOLEAN congested);
+
 /* from gatt_main.c */
 extern BOOLEAN gatt_disconnect (tGATT_TCB *p_tcb);
 extern BOOLEAN gatt_act_connect (tGATT_REG *p_reg, BD_ADDR bd_addr, tBLE_ADDR_TYPE bd_addr_type, tBT_TRANSPORT transport);
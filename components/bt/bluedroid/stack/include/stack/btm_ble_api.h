@@ -871,6 +871,26 @@ typedef void (tBTM_START_STOP_ADV_CMPL_CBACK) (UINT8 status);
 
 typedef void (tBTM_UPDATE_DUPLICATE_EXCEPTIONAL_LIST_CMPL_CBACK) (tBTM_STATUS status, uint8_t subcode, uint32_t length, uint8_t *device_info);
 
+/* Host scan filter flags */
+#define BTM_BLE_HOST_FILTER_DUPLICATE       (1 << 0)    /* drop results whose data was reported already for the address */
+#define BTM_BLE_HOST_FILTER_RSSI            (1 << 1)    /* drop results weaker than rssi_threshold */
+#define BTM_BLE_HOST_FILTER_UUID            (1 << 2)    /* drop results which don't advertise the service uuid */
+#define BTM_BLE_HOST_FILTER_MANUFACTURER    (1 << 3)    /* drop results without manufacturer data of manufacturer_id */
+
+typedef struct {
+    UINT8   flags;                  /* BTM_BLE_HOST_FILTER_xxx */
+    INT8    rssi_threshold;
+    UINT8   uuid_len;               /* LEN_UUID_16, LEN_UUID_32 or LEN_UUID_128 */
+    UINT8   uuid[LEN_UUID_128];     /* in the byte order of the advertising data */
+    UINT16  manufacturer_id;
+} tBTM_BLE_HOST_FILTER;
+
+typedef struct {
+    UINT32  accepted;
+    UINT32  duplicates;
+    UINT32  rejected;               /* by the RSSI, uuid or manufacturer filter */
+} tBTM_BLE_HOST_FILTER_STATS;
+
 
 /*****************************************************************************
 **  EXTERNAL FUNCTION DECLARATIONS
@@ -894,6 +914,34 @@ extern "C" {
 *******************************************************************************/
 void BTM_BleRegiseterConnParamCallback(tBTM_UPDATE_CONN_PARAM_CBACK *update_conn_param_cb);
 
+/*******************************************************************************
+**
+** Function         BTM_BleSetHostScanFilter
+**
+** Description      Set the filter applied by the host to advertising reports
+**                  before they are passed to the results callbacks.
+**
+** Parameters:      p_filter: the filter, NULL to report everything
+**
+** Returns          BTM_SUCCESS, or BTM_NO_RESOURCES if there is no memory
+**                  for the duplicate cache
+**
+*******************************************************************************/
+tBTM_STATUS BTM_BleSetHostScanFilter(const tBTM_BLE_HOST_FILTER *p_filter);
+
+/*******************************************************************************
+**
+** Function         BTM_BleGetHostScanFilterStats
+**
+** Description      Get the counters of the host scan filter
+**
+** Parameters:      p_stats: filled with the counters since the filter was set
+**
+** Returns          void
+**
+*******************************************************************************/
+void BTM_BleGetHostScanFilterStats(tBTM_BLE_HOST_FILTER_STATS *p_stats);
+
 /*******************************************************************************
 **
 ** Function         BTM_SecAddBleDevice
@@ -347,6 +347,19 @@ typedef union {
 
 } tGATTS_RSP;
 
+/* Counters of a notification queue, see GATTS_NotifyQueueOpen */
+typedef struct {
+    UINT32  queued;         /* notifications accepted by GATTS_NotifyQueueSend */
+    UINT32  sent;           /* notifications passed to L2CAP */
+    UINT32  bytes;          /* value bytes passed to L2CAP */
+    UINT32  full;           /* notifications rejected because the queue was full */
+    UINT32  errors;         /* notifications L2CAP did not accept */
+    UINT32  congested;      /* times sending stopped until the channel cleared */
+    UINT16  depth;          /* number of slots of the queue */
+    UINT16  count;          /* notifications in the queue */
+    UINT16  peak;           /* highest number of notifications in the queue */
+} tGATTS_NOTIFY_Q_STATS;
+
 /* Transports for the primary service  */
 #define GATT_TRANSPORT_LE           BT_TRANSPORT_LE
 #define GATT_TRANSPORT_BR_EDR       BT_TRANSPORT_BR_EDR
@@ -875,6 +888,61 @@ extern  tGATT_STATUS GATTS_HandleValueIndication (UINT16 conn_id,
 extern  tGATT_STATUS GATTS_HandleValueNotification (UINT16 conn_id, UINT16 attr_handle,
         UINT16 val_len, UINT8 *p_val);
 
+/*******************************************************************************
+**
+** Function         GATTS_NotifyQueueOpen
+**
+** Description      Create the notification queue of a connection: a ring of
+**                  |depth| slots of |max_len| bytes, which GATTS_NotifyQueueSend
+**                  fills and the BTU task drains into L2CAP while the ATT
+**                  channel is not congested. The queue is freed when the
+**                  connection closes.
+**
+** Parameter        conn_id: connection identifier.
+**                  depth: number of notifications the queue holds.
+**                  max_len: maximum length of a notification value.
+**
+** Returns          GATT_SUCCESS if created; otherwise error code.
+**
+*******************************************************************************/
+extern tGATT_STATUS GATTS_NotifyQueueOpen(UINT16 conn_id, UINT16 depth, UINT16 max_len);
+
+/*******************************************************************************
+**
+** Function         GATTS_NotifyQueueClose
+**
+** Description      Delete the notification queue of a connection, dropping the
+**                  notifications not sent yet.
+**
+** Returns          GATT_SUCCESS if deleted; otherwise error code.
+**
+*******************************************************************************/
+extern tGATT_STATUS GATTS_NotifyQueueClose(UINT16 conn_id);
+
+/*******************************************************************************
+**
+** Function         GATTS_NotifyQueueSend
+**
+** Description      Copy a notification into the queue of the connection. Can be
+**                  called from any task.
+**
+** Returns          GATT_SUCCESS if queued, GATT_BUSY if the queue is full;
+**                  otherwise error code.
+**
+*******************************************************************************/
+extern tGATT_STATUS GATTS_NotifyQueueSend(UINT16 conn_id, UINT16 attr_handle, UINT16 val_len, const UINT8 *p_val);
+
+/*******************************************************************************
+**
+** Function         GATTS_NotifyQueueGetStats
+**
+** Description      Get the counters of the notification queue of a connection.
+**
+** Returns          GATT_SUCCESS if the connection has a queue; otherwise error code.
+**
+*******************************************************************************/
+extern tGATT_STATUS GATTS_NotifyQueueGetStats(UINT16 conn_id, tGATTS_NOTIFY_Q_STATS *p_stats);
+
 
 /*******************************************************************************
 **
@@ -53,6 +53,7 @@
 #include "pdu.h"
 #include "utlist.h"
 #include "resource.h"
+#include "coap_io_select.h"
 
 #if !defined(WITH_CONTIKI)
  /* define generic PKTINFO for IPv4 */
@@ -1302,39 +1303,161 @@ coap_write(coap_context_t *ctx,
   return (unsigned int)((timeout * 1000 + COAP_TICKS_PER_SECOND - 1) / COAP_TICKS_PER_SECOND);
 }
 
+/* Sockets of a context are collected by coap_write(), the array is on stack */
+#define COAP_IO_MAX_SOCKETS 64
+
+static unsigned int
+coap_io_want_events(const coap_socket_t *sock) {
+  unsigned int events = 0;
+
+  if (sock->flags & (COAP_SOCKET_WANT_READ | COAP_SOCKET_WANT_ACCEPT))
+    events |= COAP_IO_EVENT_READ;
+  if (sock->flags & (COAP_SOCKET_WANT_WRITE | COAP_SOCKET_WANT_CONNECT))
+    events |= COAP_IO_EVENT_WRITE;
+  if (sock->flags & COAP_SOCKET_WANT_CONNECT)
+    events |= COAP_IO_EVENT_ERROR;
+  return events;
+}
+
+static void
+coap_io_socket_ready(coap_socket_t *sock, unsigned int events) {
+  if ((sock->flags & COAP_SOCKET_WANT_READ) && (events & COAP_IO_EVENT_READ))
+    sock->flags |= COAP_SOCKET_CAN_READ;
+  if ((sock->flags & COAP_SOCKET_WANT_ACCEPT) && (events & COAP_IO_EVENT_READ))
+    sock->flags |= COAP_SOCKET_CAN_ACCEPT;
+  if ((sock->flags & COAP_SOCKET_WANT_WRITE) && (events & COAP_IO_EVENT_WRITE))
+    sock->flags |= COAP_SOCKET_CAN_WRITE;
+  if ((sock->flags & COAP_SOCKET_WANT_CONNECT) && (events & (COAP_IO_EVENT_WRITE | COAP_IO_EVENT_ERROR)))
+    sock->flags |= COAP_SOCKET_CAN_CONNECT;
+}
+
+/* Looks up a socket of the context, the same ones coap_write() reports */
+static coap_socket_t *
+coap_io_find_socket(coap_context_t *ctx, coap_fd_t fd) {
+  coap_endpoint_t *ep;
+  coap_session_t *s;
+
+  LL_FOREACH(ctx->endpoint, ep) {
+    if (ep->sock.fd == fd)
+      return &ep->sock;
+    LL_FOREACH(ep->sessions, s) {
+      if (s->sock.fd == fd)
+        return &s->sock;
+    }
+  }
+  LL_FOREACH(ctx->sessions, s) {
+    if (s->sock.fd == fd)
+      return &s->sock;
+  }
+  return NULL;
+}
+
+unsigned int
+coap_io_prepare(coap_context_t *ctx, coap_io_fd_t fds[], unsigned int max_fds,
+                unsigned int *timeout_ms) {
+  coap_socket_t *sockets[COAP_IO_MAX_SOCKETS];
+  unsigned int num_sockets = 0, num_fds = 0, i;
+  coap_tick_t now;
+
+  coap_ticks(&now);
+  *timeout_ms = coap_write(ctx, sockets, COAP_IO_MAX_SOCKETS, &num_sockets, now);
+  for (i = 0; i < num_sockets && num_fds < max_fds; i++) {
+    unsigned int events = coap_io_want_events(sockets[i]);
+    if (events) {
+      fds[num_fds].fd = sockets[i]->fd;
+      fds[num_fds].events = events;
+      num_fds++;
+    }
+  }
+  return num_fds;
+}
+
+void
+coap_io_fd_ready(coap_context_t *ctx, coap_fd_t fd, unsigned int events) {
+  coap_socket_t *sock = coap_io_find_socket(ctx, fd);
+
+  if (sock)
+    coap_io_socket_ready(sock, events);
+}
+
+void
+coap_io_process(coap_context_t *ctx) {
+  coap_tick_t now;
+
+  coap_ticks(&now);
+  coap_read(ctx, now);
+}
+
+coap_fd_t
+coap_io_prepare_select(coap_context_t *ctx, fd_set *readfds, fd_set *writefds,
+                       fd_set *exceptfds, coap_fd_t nfds, unsigned int *timeout_ms) {
+  coap_io_fd_t fds[COAP_IO_MAX_SOCKETS];
+  unsigned int num_fds, i;
+
+  num_fds = coap_io_prepare(ctx, fds, COAP_IO_MAX_SOCKETS, timeout_ms);
+  for (i = 0; i < num_fds; i++) {
+    if (fds[i].fd + 1 > nfds)
+      nfds = fds[i].fd + 1;
+    if (fds[i].events & COAP_IO_EVENT_READ)
+      FD_SET(fds[i].fd, readfds);
+    if (fds[i].events & COAP_IO_EVENT_WRITE)
+      FD_SET(fds[i].fd, writefds);
+    if (fds[i].events & COAP_IO_EVENT_ERROR)
+      FD_SET(fds[i].fd, exceptfds);
+  }
+  return nfds;
+}
+
+/* Marks the sockets of the context which are set in the FD sets and processes them */
+static void
+coap_io_mark_select(coap_socket_t *sock, fd_set *readfds, fd_set *writefds, fd_set *exceptfds) {
+  unsigned int events = 0;
+
+  if (sock->fd == COAP_INVALID_SOCKET)
+    return;
+  if (FD_ISSET(sock->fd, readfds))
+    events |= COAP_IO_EVENT_READ;
+  if (FD_ISSET(sock->fd, writefds))
+    events |= COAP_IO_EVENT_WRITE;
+  if (FD_ISSET(sock->fd, exceptfds))
+    events |= COAP_IO_EVENT_ERROR;
+  coap_io_socket_ready(sock, events);
+}
+
+void
+coap_io_process_select(coap_context_t *ctx, fd_set *readfds, fd_set *writefds, fd_set *exceptfds) {
+  coap_endpoint_t *ep;
+  coap_session_t *s;
+
+  LL_FOREACH(ctx->endpoint, ep) {
+    coap_io_mark_select(&ep->sock, readfds, writefds, exceptfds);
+    LL_FOREACH(ep->sessions, s) {
+      coap_io_mark_select(&s->sock, readfds, writefds, exceptfds);
+    }
+  }
+  LL_FOREACH(ctx->sessions, s) {
+    coap_io_mark_select(&s->sock, readfds, writefds, exceptfds);
+  }
+  coap_io_process(ctx);
+}
+
 int
 coap_run_once(coap_context_t *ctx, unsigned timeout_ms) {
   fd_set readfds, writefds, exceptfds;
-  coap_fd_t nfds = 0;
+  coap_fd_t nfds;
   struct timeval tv;
   coap_tick_t before, now;
   int result;
-  coap_socket_t *sockets[64];
-  unsigned int num_sockets = 0, i, timeout;
+  unsigned int timeout;
 
   coap_ticks(&before);
 
-  timeout = coap_write(ctx, sockets, (unsigned int)(sizeof(sockets) / sizeof(sockets[0])), &num_sockets, before);
-  if (timeout == 0 || timeout_ms < timeout)
-    timeout = timeout_ms;
-
   FD_ZERO(&readfds);
   FD_ZERO(&writefds);
   FD_ZERO(&exceptfds);
-  for (i = 0; i < num_sockets; i++) {
-    if (sockets[i]->fd + 1 > nfds)
-      nfds = sockets[i]->fd + 1;
-    if (sockets[i]->flags & COAP_SOCKET_WANT_READ)
-      FD_SET(sockets[i]->fd, &readfds);
-    if (sockets[i]->flags & COAP_SOCKET_WANT_WRITE)
-      FD_SET(sockets[i]->fd, &writefds);
-    if (sockets[i]->flags & COAP_SOCKET_WANT_ACCEPT)
-      FD_SET(sockets[i]->fd, &readfds);
-    if (sockets[i]->flags & COAP_SOCKET_WANT_CONNECT) {
-      FD_SET(sockets[i]->fd, &writefds);
-      FD_SET(sockets[i]->fd, &exceptfds);
-    }
-  }
+  nfds = coap_io_prepare_select(ctx, &readfds, &writefds, &exceptfds, 0, &timeout);
+  if (timeout == 0 || timeout_ms < timeout)
+    timeout = timeout_ms;
 
   if ( timeout > 0 ) {
     tv.tv_usec = (timeout % 1000) * 1000;
@@ -1354,22 +1477,15 @@ coap_run_once(coap_context_t *ctx, unsigned timeout_ms) {
     }
   }
 
-  if (result > 0) {
-    for (i = 0; i < num_sockets; i++) {
-      if ((sockets[i]->flags & COAP_SOCKET_WANT_READ) && FD_ISSET(sockets[i]->fd, &readfds))
-        sockets[i]->flags |= COAP_SOCKET_CAN_READ;
-      if ((sockets[i]->flags & COAP_SOCKET_WANT_ACCEPT) && FD_ISSET(sockets[i]->fd, &readfds))
-        sockets[i]->flags |= COAP_SOCKET_CAN_ACCEPT;
-      if ((sockets[i]->flags & COAP_SOCKET_WANT_WRITE) && FD_ISSET(sockets[i]->fd, &writefds))
-        sockets[i]->flags |= COAP_SOCKET_CAN_WRITE;
-      if ((sockets[i]->flags & COAP_SOCKET_WANT_CONNECT) && (FD_ISSET(sockets[i]->fd, &writefds) || FD_ISSET(sockets[i]->fd, &exceptfds)))
-        sockets[i]->flags |= COAP_SOCKET_CAN_CONNECT;
-    }
+  if (result <= 0) {
+    /* nothing is ready, the FD sets may be left unchanged on error */
+    FD_ZERO(&readfds);
+    FD_ZERO(&writefds);
+    FD_ZERO(&exceptfds);
   }
+  coap_io_process_select(ctx, &readfds, &writefds, &exceptfds);
 
   coap_ticks(&now);
-  coap_read(ctx, now);
-
   return (int)(((now - before) * 1000) / COAP_TICKS_PER_SECOND);
 }
 
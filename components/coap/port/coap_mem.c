@@ -0,0 +1,127 @@
+/*
+ * coap_mem.c -- Memory handling of libcoap for ESP32 platform
+ *
+ * Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+ *
+ * This file is part of the CoAP library libcoap. Please see README for terms
+ * of use.
+ *
+ * Replaces libcoap/src/mem.c. PDUs, PDU buffers and send queue nodes are
+ * allocated and freed for every message, so the freed blocks are kept in
+ * per type free lists and reused instead of going back to the heap.
+ *
+ * The cached blocks are plain heap blocks: libcoap grows PDU buffers with
+ * realloc(), so they can not be taken from a static pool. To make reuse safe
+ * anyway, every block of a cached type is allocated with at least the block
+ * size of its type. realloc() only grows PDU buffers, so any freed block is
+ * large enough to be handed out again for a request up to the block size.
+ */
+
+#include <stdlib.h>
+#include "coap_config.h"
+#include "libcoap.h"
+#include "mem.h"
+#include "pdu.h"
+#include "net.h"
+#include "freertos/FreeRTOS.h"
+#include "sdkconfig.h"
+
+#if CONFIG_COAP_PDU_POOL_SIZE > 0
+
+typedef struct coap_mem_block_t {
+  struct coap_mem_block_t *next;
+} coap_mem_block_t;
+
+typedef struct {
+  coap_mem_block_t *free_list;
+  size_t block_size;
+  unsigned int count;
+} coap_mem_pool_t;
+
+#define COAP_MEM_BLOCK_SIZE(size) \
+  ((size) < sizeof(coap_mem_block_t) ? sizeof(coap_mem_block_t) : (size))
+
+static coap_mem_pool_t pdu_pool = { NULL, COAP_MEM_BLOCK_SIZE(sizeof(coap_pdu_t)), 0 };
+static coap_mem_pool_t pdu_buf_pool = { NULL, COAP_MEM_BLOCK_SIZE(CONFIG_COAP_PDU_POOL_BUF_SIZE), 0 };
+static coap_mem_pool_t node_pool = { NULL, COAP_MEM_BLOCK_SIZE(sizeof(coap_queue_t)), 0 };
+
+/* Contexts may be run by different tasks */
+static portMUX_TYPE pool_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static coap_mem_pool_t *
+coap_mem_get_pool(coap_memory_tag_t type) {
+  switch (type) {
+  case COAP_PDU:
+    return &pdu_pool;
+  case COAP_PDU_BUF:
+    return &pdu_buf_pool;
+  case COAP_NODE:
+    return &node_pool;
+  default:
+    return NULL;
+  }
+}
+
+void
+coap_memory_init(void) {
+}
+
+void *
+coap_malloc_type(coap_memory_tag_t type, size_t size) {
+  coap_mem_pool_t *pool = coap_mem_get_pool(type);
+  coap_mem_block_t *block = NULL;
+
+  if (!pool)
+    return malloc(size);
+  if (size <= pool->block_size) {
+    portENTER_CRITICAL(&pool_lock);
+    block = pool->free_list;
+    if (block) {
+      pool->free_list = block->next;
+      pool->count--;
+    }
+    portEXIT_CRITICAL(&pool_lock);
+    if (block)
+      return block;
+    size = pool->block_size;
+  }
+  return malloc(size);
+}
+
+void
+coap_free_type(coap_memory_tag_t type, void *p) {
+  coap_mem_pool_t *pool = coap_mem_get_pool(type);
+  coap_mem_block_t *block = (coap_mem_block_t *)p;
+
+  if (pool && block) {
+    portENTER_CRITICAL(&pool_lock);
+    if (pool->count < CONFIG_COAP_PDU_POOL_SIZE) {
+      block->next = pool->free_list;
+      pool->free_list = block;
+      pool->count++;
+      block = NULL;
+    }
+    portEXIT_CRITICAL(&pool_lock);
+  }
+  free(block);
+}
+
+#else /* CONFIG_COAP_PDU_POOL_SIZE > 0 */
+
+void
+coap_memory_init(void) {
+}
+
+void *
+coap_malloc_type(coap_memory_tag_t type, size_t size) {
+  (void)type;
+  return malloc(size);
+}
+
+void
+coap_free_type(coap_memory_tag_t type, void *p) {
+  (void)type;
+  free(p);
+}
+
+#endif /* CONFIG_COAP_PDU_POOL_SIZE > 0 */
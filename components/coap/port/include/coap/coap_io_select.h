@@ -0,0 +1,97 @@
+/*
+ * coap_io_select.h -- Non-blocking network I/O of libcoap for ESP32 platform
+ *
+ * Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+ *
+ * This file is part of the CoAP library libcoap. Please see README for terms
+ * of use.
+ */
+
+#ifndef _COAP_IO_SELECT_H_
+#define _COAP_IO_SELECT_H_
+
+#include <sys/select.h>
+#include "coap_io.h"
+#include "net.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * coap_run_once() waits in select() on the sockets of one context. The functions
+ * below split it into steps, so the sockets of the context can be waited for
+ * together with other file descriptors by the application (esp_vfs_select() or
+ * esp_vfs_epoll_wait()):
+ *
+ * 1. coap_io_prepare() or coap_io_prepare_select() sends pending retransmissions
+ *    and notifications and reports the sockets to wait for and the timeout
+ *    until the next call is due.
+ * 2. The application waits for the sockets and its own file descriptors.
+ * 3. coap_io_fd_ready() is called for every ready socket and then coap_io_process(),
+ *    or coap_io_process_select() is called with the FD sets returned by select().
+ *
+ * Sockets are non-blocking, so none of the functions waits. They must be called
+ * from the task which owns the context. Sockets reported by the prepare step may
+ * be closed during processing, so the set of sockets should be updated every time.
+ */
+
+#define COAP_IO_EVENT_READ    0x1   /**< socket is ready to read or accept */
+#define COAP_IO_EVENT_WRITE   0x2   /**< socket is ready to write or connected */
+#define COAP_IO_EVENT_ERROR   0x4   /**< error condition, e.g. failed connect */
+
+/** Socket of a context and events to wait for */
+typedef struct coap_io_fd_t {
+  coap_fd_t fd;
+  unsigned int events;              /**< COAP_IO_EVENT_* flags */
+} coap_io_fd_t;
+
+/**
+ * Runs the output processing of a context and reports its sockets.
+ *
+ * @param ctx         The CoAP context
+ * @param fds         Array to store the sockets and the events to wait for
+ * @param max_fds     Number of items in fds
+ * @param timeout_ms  Time in milliseconds until the next call is due,
+ *                    0 if there are no pending timers
+ *
+ * @return Number of sockets stored in fds
+ */
+unsigned int coap_io_prepare(coap_context_t *ctx, coap_io_fd_t fds[], unsigned int max_fds,
+                             unsigned int *timeout_ms);
+
+/**
+ * Reports the ready events of a socket returned by coap_io_prepare().
+ * The socket is processed by the next call of coap_io_process().
+ */
+void coap_io_fd_ready(coap_context_t *ctx, coap_fd_t fd, unsigned int events);
+
+/**
+ * Processes the ready sockets: receives and handles messages,
+ * accepts and connects TCP sessions.
+ */
+void coap_io_process(coap_context_t *ctx);
+
+/**
+ * The same as coap_io_prepare(), the sockets are added to the FD sets
+ * which may already contain other file descriptors of the application.
+ *
+ * @param nfds  Highest file descriptor in the FD sets plus 1
+ *
+ * @return Updated nfds to pass to select()
+ */
+coap_fd_t coap_io_prepare_select(coap_context_t *ctx, fd_set *readfds, fd_set *writefds,
+                                 fd_set *exceptfds, coap_fd_t nfds, unsigned int *timeout_ms);
+
+/**
+ * Marks the sockets of the context which are set in the FD sets returned by select()
+ * as ready and processes them, see coap_io_process().
+ */
+void coap_io_process_select(coap_context_t *ctx, fd_set *readfds, fd_set *writefds,
+                            fd_set *exceptfds);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _COAP_IO_SELECT_H_ */
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
 #include <sys/param.h>
@@ -23,6 +24,7 @@
 #include "sys/queue.h"
 
 #define ANSI_COLOR_DEFAULT      39      /** Default foreground color */
+#define CMD_TABLE_SIZE          32      /** Number of buckets in command lookup table, power of 2 */
 
 typedef struct cmd_item_ {
     /**
@@ -41,11 +43,15 @@ typedef struct cmd_item_ {
     esp_console_cmd_func_t func;    //!< pointer to the command handler
     void *argtable;                 //!< optional pointer to arg table
     SLIST_ENTRY(cmd_item_) next;    //!< next command in the list
+    SLIST_ENTRY(cmd_item_) next_in_bucket;  //!< next command with the same hash
 } cmd_item_t;
 
-/** linked list of command structures */
+/** linked list of command structures, in order of registration */
 static SLIST_HEAD(cmd_list_, cmd_item_) s_cmd_list;
 
+/** commands hashed by name, for lookup when running a command */
+static struct cmd_list_ s_cmd_table[CMD_TABLE_SIZE];
+
 /** run-time configuration options */
 static esp_console_config_t s_config;
 
@@ -53,6 +59,7 @@ static esp_console_config_t s_config;
 static char *s_tmp_line_buf;
 
 static const cmd_item_t *find_command_by_name(const char *name);
+static struct cmd_list_ *get_bucket(const char *name);
 
 esp_err_t esp_console_init(const esp_console_config_t *config)
 {
@@ -77,10 +84,13 @@ esp_err_t esp_console_deinit()
     }
     free(s_tmp_line_buf);
     cmd_item_t *it, *tmp;
+    s_tmp_line_buf = NULL;
     SLIST_FOREACH_SAFE(it, &s_cmd_list, next, tmp) {
         free(it->hint);
         free(it);
     }
+    SLIST_INIT(&s_cmd_list);
+    memset(s_cmd_table, 0, sizeof(s_cmd_table));
     return ESP_OK;
 }
 
@@ -129,6 +139,20 @@ esp_err_t esp_console_cmd_register(const esp_console_cmd_t *cmd)
         }
         SLIST_INSERT_AFTER(last, item, next);
     }
+    /* Append to the bucket, so that the first command registered
+     * with the same name is found, as before.
+     */
+    struct cmd_list_ *bucket = get_bucket(item->command);
+    last = SLIST_FIRST(bucket);
+    if (last == NULL) {
+        SLIST_INSERT_HEAD(bucket, item, next_in_bucket);
+    } else {
+        cmd_item_t *it;
+        while ((it = SLIST_NEXT(last, next_in_bucket)) != NULL) {
+            last = it;
+        }
+        SLIST_INSERT_AFTER(last, item, next_in_bucket);
+    }
     return ESP_OK;
 }
 
@@ -149,24 +173,30 @@ void esp_console_get_completion(const char *buf, linenoiseCompletions *lc)
 
 const char *esp_console_get_hint(const char *buf, int *color, int *bold)
 {
-    int len = strlen(buf);
-    cmd_item_t *it;
-    SLIST_FOREACH(it, &s_cmd_list, next) {
-        if (strlen(it->command) == len &&
-                strncmp(buf, it->command, len) == 0) {
-            *color = s_config.hint_color;
-            *bold = s_config.hint_bold;
-            return it->hint;
-        }
+    const cmd_item_t *cmd = find_command_by_name(buf);
+    if (cmd == NULL) {
+        return NULL;
+    }
+    *color = s_config.hint_color;
+    *bold = s_config.hint_bold;
+    return cmd->hint;
+}
+
+/* FNV-1a hash of the command name */
+static struct cmd_list_ *get_bucket(const char *name)
+{
+    uint32_t hash = 2166136261;
+    for (const char *p = name; *p != '\0'; p++) {
+        hash = (hash ^ (uint8_t) *p) * 16777619;
     }
-    return NULL;
+    return &s_cmd_table[hash & (CMD_TABLE_SIZE - 1)];
 }
 
 static const cmd_item_t *find_command_by_name(const char *name)
 {
     const cmd_item_t *cmd = NULL;
     cmd_item_t *it;
-    SLIST_FOREACH(it, &s_cmd_list, next) {
+    SLIST_FOREACH(it, get_bucket(name), next_in_bucket) {
         if (strcmp(name, it->command) == 0) {
             cmd = it;
             break;
@@ -144,8 +144,17 @@ struct linenoiseState {
     size_t cols;        /* Number of columns in terminal. */
     size_t maxrows;     /* Maximum num of rows used so far (multiline mode) */
     int history_index;  /* The history index we are currently editing. */
+    int esc_len;        /* Escape sequence bytes received plus 1, 0 if none. */
+    char seq[3];        /* Escape sequence following ESC. */
+    linenoiseCompletions lc; /* Completions while in completion mode. */
+    size_t completion_idx; /* Completion shown, lc.len for the original buffer. */
+    int in_completion;  /* Set while the user cycles through completions. */
 };
 
+/* Returned by linenoiseEditFeed() while the line is not complete. */
+static char editMore;
+char *linenoiseEditMore = &editMore;
+
 enum KEY_ACTION{
 	KEY_NULL = 0,	    /* NULL */
 	CTRL_A = 1,         /* Ctrl+a */
@@ -276,68 +285,70 @@ static void freeCompletions(linenoiseCompletions *lc) {
         free(lc->cvec);
 }
 
-/* This is an helper function for linenoiseEdit() and is called when the
- * user types the <tab> key in order to complete the string currently in the
- * input.
+/* Show the selected completion or the original buffer. */
+static void refreshCompletion(struct linenoiseState *ls) {
+    if (ls->completion_idx < ls->lc.len) {
+        struct linenoiseState saved = *ls;
+
+        ls->len = ls->pos = strlen(ls->lc.cvec[ls->completion_idx]);
+        ls->buf = ls->lc.cvec[ls->completion_idx];
+        refreshLine(ls);
+        ls->len = saved.len;
+        ls->pos = saved.pos;
+        ls->buf = saved.buf;
+    } else {
+        refreshLine(ls);
+    }
+}
+
+/* This is an helper function for linenoiseEditProcess() and is called when
+ * the user types the <tab> key in order to complete the string currently in
+ * the input. The following keys are passed to completeLineKey() until the
+ * completion is accepted or cancelled.
  *
  * The state of the editing is encapsulated into the pointed linenoiseState
  * structure as described in the structure definition. */
-static int completeLine(struct linenoiseState *ls) {
-    linenoiseCompletions lc = { 0, NULL };
-    int nread, nwritten;
-    char c = 0;
-
-    completionCallback(ls->buf,&lc);
-    if (lc.len == 0) {
+static void completeLine(struct linenoiseState *ls) {
+    ls->lc.len = 0;
+    ls->lc.cvec = NULL;
+    completionCallback(ls->buf,&ls->lc);
+    if (ls->lc.len == 0) {
         linenoiseBeep();
+        freeCompletions(&ls->lc);
     } else {
-        size_t stop = 0, i = 0;
-
-        while(!stop) {
-            /* Show completion or original buffer */
-            if (i < lc.len) {
-                struct linenoiseState saved = *ls;
-
-                ls->len = ls->pos = strlen(lc.cvec[i]);
-                ls->buf = lc.cvec[i];
-                refreshLine(ls);
-                ls->len = saved.len;
-                ls->pos = saved.pos;
-                ls->buf = saved.buf;
-            } else {
-                refreshLine(ls);
-            }
-
-            nread = fread(&c, 1, 1, stdin);
-            if (nread <= 0) {
-                freeCompletions(&lc);
-                return -1;
-            }
+        ls->in_completion = 1;
+        ls->completion_idx = 0;
+        refreshCompletion(ls);
+    }
+}
 
-            switch(c) {
-                case TAB: /* tab */
-                    i = (i+1) % (lc.len+1);
-                    if (i == lc.len) linenoiseBeep();
-                    break;
-                case ESC: /* escape */
-                    /* Re-show original buffer */
-                    if (i < lc.len) refreshLine(ls);
-                    stop = 1;
-                    break;
-                default:
-                    /* Update buffer and return */
-                    if (i < lc.len) {
-                        nwritten = snprintf(ls->buf,ls->buflen,"%s",lc.cvec[i]);
-                        ls->len = ls->pos = nwritten;
-                    }
-                    stop = 1;
-                    break;
+/* Handle a key typed while in completion mode. Returns 0 when the key was
+ * consumed, otherwise the completion is finished and the key should be
+ * handled as usual. */
+static int completeLineKey(struct linenoiseState *ls, char c) {
+    int nwritten;
+
+    switch(c) {
+        case TAB: /* tab */
+            ls->completion_idx = (ls->completion_idx+1) % (ls->lc.len+1);
+            if (ls->completion_idx == ls->lc.len) linenoiseBeep();
+            refreshCompletion(ls);
+            return 0;
+        case ESC: /* escape */
+            /* Re-show original buffer */
+            if (ls->completion_idx < ls->lc.len) refreshLine(ls);
+            break;
+        default:
+            /* Update buffer and return */
+            if (ls->completion_idx < ls->lc.len) {
+                nwritten = snprintf(ls->buf,ls->buflen,"%s",ls->lc.cvec[ls->completion_idx]);
+                ls->len = ls->pos = nwritten;
             }
-        }
+            break;
     }
-
-    freeCompletions(&lc);
-    return c; /* Return last read character */
+    ls->in_completion = 0;
+    freeCompletions(&ls->lc);
+    return 1;
 }
 
 /* Register a callback function to be called for tab-completion. */
@@ -691,195 +702,261 @@ void linenoiseEditDeletePrevWord(struct linenoiseState *l) {
     refreshLine(l);
 }
 
-/* This function is the core of the line editing capability of linenoise.
- * It expects 'fd' to be already in "raw mode" so that every key pressed
- * will be returned ASAP to read().
+/* Returned by linenoiseEditProcess() while the line is not complete. */
+#define LINENOISE_EDIT_MORE -2
+
+/* Number of columns taken by the prompt, skipping ESC [ ... sequences
+ * used to set colors. */
+static size_t promptWidth(const char *prompt) {
+    size_t width = 0;
+    while (*prompt) {
+        if (prompt[0] == ESC && prompt[1] == '[') {
+            prompt += 2;
+            while (*prompt && (*prompt < 0x40 || *prompt > 0x7e)) prompt++;
+            if (*prompt) prompt++;
+        } else {
+            width++;
+            prompt++;
+        }
+    }
+    return width;
+}
+
+/* Populate the linenoise state that we pass to functions implementing
+ * specific editing functionalities and show the prompt.
  *
- * The resulting string is put into 'buf' when the user type enter, or
- * when ctrl+d is typed.
+ * The number of columns and the width of the prompt are read from the
+ * terminal if 'probe' is set. The response comes from stdin, so this is
+ * only possible if nobody else reads it. Otherwise 80 columns are assumed.
  *
- * The function returns the length of the current buffer. */
-static int linenoiseEdit(char *buf, size_t buflen, const char *prompt)
+ * On error writing to the terminal -1 is returned, otherwise 0. */
+static int linenoiseEditInit(struct linenoiseState *l, char *buf, size_t buflen,
+                             const char *prompt, int probe)
 {
-    struct linenoiseState l;
-
-    /* Populate the linenoise state that we pass to functions implementing
-     * specific editing functionalities. */
-    l.buf = buf;
-    l.buflen = buflen;
-    l.prompt = prompt;
-    l.plen = strlen(prompt);
-    l.oldpos = l.pos = 0;
-    l.len = 0;
-    l.cols = getColumns();
-    l.maxrows = 0;
-    l.history_index = 0;
+    l->buf = buf;
+    l->buflen = buflen;
+    l->prompt = prompt;
+    l->plen = probe ? strlen(prompt) : promptWidth(prompt);
+    l->oldpos = l->pos = 0;
+    l->len = 0;
+    l->cols = probe ? getColumns() : 80;
+    l->maxrows = 0;
+    l->history_index = 0;
+    l->esc_len = 0;
+    l->lc.len = 0;
+    l->lc.cvec = NULL;
+    l->completion_idx = 0;
+    l->in_completion = 0;
 
     /* Buffer starts empty. */
-    l.buf[0] = '\0';
-    l.buflen--; /* Make sure there is always space for the nulterm */
+    l->buf[0] = '\0';
+    l->buflen--; /* Make sure there is always space for the nulterm */
 
     /* The latest history entry is always our current buffer, that
      * initially is just an empty string. */
     linenoiseHistoryAdd("");
 
-    int pos1 = getCursorPosition();
-    if (fwrite(prompt,l.plen,1,stdout) == -1) return -1;
-    int pos2 = getCursorPosition();
+    int pos1 = probe ? getCursorPosition() : -1;
+    if (fwrite(prompt,strlen(prompt),1,stdout) == -1) return -1;
+    int pos2 = probe ? getCursorPosition() : -1;
     if (pos1 >= 0 && pos2 >= 0) {
-        l.plen = pos2 - pos1;
+        l->plen = pos2 - pos1;
     }
-    while(1) {
-        char c;
-        int nread;
-        char seq[3];
+    return 0;
+}
 
-        nread = fread(&c, 1, 1, stdin);
-        if (nread <= 0) return l.len;
-
-        /* Only autocomplete when the callback is set. It returns < 0 when
-         * there was an error reading from fd. Otherwise it will return the
-         * character that should be handled next. */
-        if (c == 9 && completionCallback != NULL) {
-            int c2 = completeLine(&l);
-            /* Return on errors */
-            if (c2 < 0) return l.len;
-            /* Read next character when 0 */
-            if (c2 == 0) continue;
-            c = c2;
+/* Handle the bytes following ESC. Returns LINENOISE_EDIT_MORE until the
+ * whole sequence is received. */
+static int linenoiseEditEscape(struct linenoiseState *l, char c)
+{
+    l->seq[l->esc_len - 1] = c;
+    l->esc_len++;
+    /* Wait for the next two bytes representing the escape sequence. */
+    if (l->esc_len <= 2) return LINENOISE_EDIT_MORE;
+
+    /* ESC [ sequences. */
+    if (l->seq[0] == '[') {
+        if (l->seq[1] >= '0' && l->seq[1] <= '9') {
+            /* Extended escape, wait for additional byte. */
+            if (l->esc_len <= 3) return LINENOISE_EDIT_MORE;
+            if (l->seq[2] == '~') {
+                switch(l->seq[1]) {
+                case '3': /* Delete key. */
+                    linenoiseEditDelete(l);
+                    break;
+                }
+            }
+        } else {
+            switch(l->seq[1]) {
+            case 'A': /* Up */
+                linenoiseEditHistoryNext(l, LINENOISE_HISTORY_PREV);
+                break;
+            case 'B': /* Down */
+                linenoiseEditHistoryNext(l, LINENOISE_HISTORY_NEXT);
+                break;
+            case 'C': /* Right */
+                linenoiseEditMoveRight(l);
+                break;
+            case 'D': /* Left */
+                linenoiseEditMoveLeft(l);
+                break;
+            case 'H': /* Home */
+                linenoiseEditMoveHome(l);
+                break;
+            case 'F': /* End*/
+                linenoiseEditMoveEnd(l);
+                break;
+            }
+        }
+    }
+
+    /* ESC O sequences. */
+    else if (l->seq[0] == 'O') {
+        switch(l->seq[1]) {
+        case 'H': /* Home */
+            linenoiseEditMoveHome(l);
+            break;
+        case 'F': /* End*/
+            linenoiseEditMoveEnd(l);
+            break;
         }
+    }
+    l->esc_len = 0;
+    return LINENOISE_EDIT_MORE;
+}
+
+/* This function is the core of the line editing capability of linenoise.
+ * It handles one character typed by the user.
+ *
+ * The resulting string is put into the state buffer when the user type
+ * enter, or when ctrl+d is typed.
+ *
+ * The function returns LINENOISE_EDIT_MORE if the line is not complete yet,
+ * otherwise the length of the current buffer or -1 when editing was
+ * cancelled or on error. */
+static int linenoiseEditProcess(struct linenoiseState *l, char c)
+{
+    char *buf = l->buf;
 
-        switch(c) {
-        case ENTER:    /* enter */
+    if (l->esc_len > 0) return linenoiseEditEscape(l, c);
+
+    /* Keys typed while showing completions either cycle through them
+     * or accept the completion and are handled as usual. */
+    if (l->in_completion && !completeLineKey(l, c)) return LINENOISE_EDIT_MORE;
+
+    /* Only autocomplete when the callback is set. */
+    if (c == TAB && completionCallback != NULL) {
+        completeLine(l);
+        return LINENOISE_EDIT_MORE;
+    }
+
+    switch(c) {
+    case ENTER:    /* enter */
+        history_len--;
+        free(history[history_len]);
+        if (mlmode) linenoiseEditMoveEnd(l);
+        if (hintsCallback) {
+            /* Force a refresh without hints to leave the previous
+             * line as the user typed it after a newline. */
+            linenoiseHintsCallback *hc = hintsCallback;
+            hintsCallback = NULL;
+            refreshLine(l);
+            hintsCallback = hc;
+        }
+        return (int)l->len;
+    case CTRL_C:     /* ctrl-c */
+        errno = EAGAIN;
+        return -1;
+    case BACKSPACE:   /* backspace */
+    case 8:     /* ctrl-h */
+        linenoiseEditBackspace(l);
+        break;
+    case CTRL_D:     /* ctrl-d, remove char at right of cursor, or if the
+                        line is empty, act as end-of-file. */
+        if (l->len > 0) {
+            linenoiseEditDelete(l);
+        } else {
             history_len--;
             free(history[history_len]);
-            if (mlmode) linenoiseEditMoveEnd(&l);
-            if (hintsCallback) {
-                /* Force a refresh without hints to leave the previous
-                 * line as the user typed it after a newline. */
-                linenoiseHintsCallback *hc = hintsCallback;
-                hintsCallback = NULL;
-                refreshLine(&l);
-                hintsCallback = hc;
-            }
-            return (int)l.len;
-        case CTRL_C:     /* ctrl-c */
-            errno = EAGAIN;
             return -1;
-        case BACKSPACE:   /* backspace */
-        case 8:     /* ctrl-h */
-            linenoiseEditBackspace(&l);
-            break;
-        case CTRL_D:     /* ctrl-d, remove char at right of cursor, or if the
-                            line is empty, act as end-of-file. */
-            if (l.len > 0) {
-                linenoiseEditDelete(&l);
-            } else {
-                history_len--;
-                free(history[history_len]);
-                return -1;
-            }
-            break;
-        case CTRL_T:    /* ctrl-t, swaps current character with previous. */
-            if (l.pos > 0 && l.pos < l.len) {
-                int aux = buf[l.pos-1];
-                buf[l.pos-1] = buf[l.pos];
-                buf[l.pos] = aux;
-                if (l.pos != l.len-1) l.pos++;
-                refreshLine(&l);
-            }
-            break;
-        case CTRL_B:     /* ctrl-b */
-            linenoiseEditMoveLeft(&l);
-            break;
-        case CTRL_F:     /* ctrl-f */
-            linenoiseEditMoveRight(&l);
-            break;
-        case CTRL_P:    /* ctrl-p */
-            linenoiseEditHistoryNext(&l, LINENOISE_HISTORY_PREV);
-            break;
-        case CTRL_N:    /* ctrl-n */
-            linenoiseEditHistoryNext(&l, LINENOISE_HISTORY_NEXT);
-            break;
-        case ESC:    /* escape sequence */
-            /* Read the next two bytes representing the escape sequence. */
-            if (fread(seq, 1, 2, stdin) < 2) break;
-
-            /* ESC [ sequences. */
-            if (seq[0] == '[') {
-                if (seq[1] >= '0' && seq[1] <= '9') {
-                    /* Extended escape, read additional byte. */
-                    if (fread(seq+2, 1, 1, stdin) == -1) break;
-                    if (seq[2] == '~') {
-                        switch(seq[1]) {
-                        case '3': /* Delete key. */
-                            linenoiseEditDelete(&l);
-                            break;
-                        }
-                    }
-                } else {
-                    switch(seq[1]) {
-                    case 'A': /* Up */
-                        linenoiseEditHistoryNext(&l, LINENOISE_HISTORY_PREV);
-                        break;
-                    case 'B': /* Down */
-                        linenoiseEditHistoryNext(&l, LINENOISE_HISTORY_NEXT);
-                        break;
-                    case 'C': /* Right */
-                        linenoiseEditMoveRight(&l);
-                        break;
-                    case 'D': /* Left */
-                        linenoiseEditMoveLeft(&l);
-                        break;
-                    case 'H': /* Home */
-                        linenoiseEditMoveHome(&l);
-                        break;
-                    case 'F': /* End*/
-                        linenoiseEditMoveEnd(&l);
-                        break;
-                    }
-                }
-            }
+        }
+        break;
+    case CTRL_T:    /* ctrl-t, swaps current character with previous. */
+        if (l->pos > 0 && l->pos < l->len) {
+            int aux = buf[l->pos-1];
+            buf[l->pos-1] = buf[l->pos];
+            buf[l->pos] = aux;
+            if (l->pos != l->len-1) l->pos++;
+            refreshLine(l);
+        }
+        break;
+    case CTRL_B:     /* ctrl-b */
+        linenoiseEditMoveLeft(l);
+        break;
+    case CTRL_F:     /* ctrl-f */
+        linenoiseEditMoveRight(l);
+        break;
+    case CTRL_P:    /* ctrl-p */
+        linenoiseEditHistoryNext(l, LINENOISE_HISTORY_PREV);
+        break;
+    case CTRL_N:    /* ctrl-n */
+        linenoiseEditHistoryNext(l, LINENOISE_HISTORY_NEXT);
+        break;
+    case ESC:    /* escape sequence */
+        l->esc_len = 1;
+        break;
+    default:
+        if (linenoiseEditInsert(l,c)) return -1;
+        break;
+    case CTRL_U: /* Ctrl+u, delete the whole line. */
+        buf[0] = '\0';
+        l->pos = l->len = 0;
+        refreshLine(l);
+        break;
+    case CTRL_K: /* Ctrl+k, delete from current to end of line. */
+        buf[l->pos] = '\0';
+        l->len = l->pos;
+        refreshLine(l);
+        break;
+    case CTRL_A: /* Ctrl+a, go to the start of the line */
+        linenoiseEditMoveHome(l);
+        break;
+    case CTRL_E: /* ctrl+e, go to the end of the line */
+        linenoiseEditMoveEnd(l);
+        break;
+    case CTRL_L: /* ctrl+l, clear screen */
+        linenoiseClearScreen();
+        refreshLine(l);
+        break;
+    case CTRL_W: /* ctrl+w, delete previous word */
+        linenoiseEditDeletePrevWord(l);
+        break;
+    }
+    return LINENOISE_EDIT_MORE;
+}
 
-            /* ESC O sequences. */
-            else if (seq[0] == 'O') {
-                switch(seq[1]) {
-                case 'H': /* Home */
-                    linenoiseEditMoveHome(&l);
-                    break;
-                case 'F': /* End*/
-                    linenoiseEditMoveEnd(&l);
-                    break;
-                }
-            }
-            break;
-        default:
-            if (linenoiseEditInsert(&l,c)) return -1;
-            break;
-        case CTRL_U: /* Ctrl+u, delete the whole line. */
-            buf[0] = '\0';
-            l.pos = l.len = 0;
-            refreshLine(&l);
-            break;
-        case CTRL_K: /* Ctrl+k, delete from current to end of line. */
-            buf[l.pos] = '\0';
-            l.len = l.pos;
-            refreshLine(&l);
-            break;
-        case CTRL_A: /* Ctrl+a, go to the start of the line */
-            linenoiseEditMoveHome(&l);
-            break;
-        case CTRL_E: /* ctrl+e, go to the end of the line */
-            linenoiseEditMoveEnd(&l);
-            break;
-        case CTRL_L: /* ctrl+l, clear screen */
-            linenoiseClearScreen();
-            refreshLine(&l);
-            break;
-        case CTRL_W: /* ctrl+w, delete previous word */
-            linenoiseEditDeletePrevWord(&l);
-            break;
+/* Edit a line reading characters from stdin until the user types enter.
+ * It expects stdin to be already in "raw mode" so that every key pressed
+ * will be returned ASAP to read().
+ *
+ * The function returns the length of the current buffer. */
+static int linenoiseEdit(char *buf, size_t buflen, const char *prompt)
+{
+    struct linenoiseState l;
+
+    if (linenoiseEditInit(&l, buf, buflen, prompt, 1) == -1) return -1;
+    while(1) {
+        char c;
+        int nread;
+
+        nread = fread(&c, 1, 1, stdin);
+        if (nread <= 0) {
+            if (l.in_completion) freeCompletions(&l.lc);
+            return l.len;
         }
+
+        int ret = linenoiseEditProcess(&l, c);
+        if (ret != LINENOISE_EDIT_MORE) return ret;
         if (__fbufsize(stdout) > 0) {
             fflush(stdout);
         }
@@ -933,30 +1010,39 @@ static int linenoiseRaw(char *buf, size_t buflen, const char *prompt) {
     return count;
 }
 
+/* Handle one character in dumb mode. Returns the length of the line when
+ * it is complete, otherwise LINENOISE_EDIT_MORE. */
+static int linenoiseDumbKey(struct linenoiseState *l, int c) {
+    if (c == '\n') {
+        return l->len;
+    } else if (c >= 0x1c && c <= 0x1f){
+        return LINENOISE_EDIT_MORE; /* consume arrow keys */
+    } else if (c == BACKSPACE || c == 0x8) {
+        if (l->len > 0) {
+            l->buf[l->len - 1] = 0;
+            l->len --;
+        }
+        fputs("\x08 ", stdout); /* Windows CMD: erase symbol under cursor */
+    } else {
+        l->buf[l->len] = c;
+        ++l->len;
+    }
+    fputc(c, stdout); /* echo */
+    return (l->len < l->buflen) ? LINENOISE_EDIT_MORE : (int)l->len;
+}
+
 static int linenoiseDumb(char* buf, size_t buflen, const char* prompt) {
     /* dumb terminal, fall back to fgets */
+    /* Make sure there is always space for the nulterm */
+    struct linenoiseState l = { .buf = buf, .buflen = buflen - 1 };
     fputs(prompt, stdout);
-    int count = 0;
-    while (count < buflen) {
-        int c = fgetc(stdin);
-        if (c == '\n') {
+    while (l.len < l.buflen) {
+        if (linenoiseDumbKey(&l, fgetc(stdin)) != LINENOISE_EDIT_MORE) {
             break;
-        } else if (c >= 0x1c && c <= 0x1f){
-            continue; /* consume arrow keys */
-        } else if (c == BACKSPACE || c == 0x8) {
-            if (count > 0) {
-                buf[count - 1] = 0;
-                count --;
-            }
-            fputs("\x08 ", stdout); /* Windows CMD: erase symbol under cursor */
-        } else {
-            buf[count] = c;
-            ++count;
         }
-        fputc(c, stdout); /* echo */
     }
     fputc('\n', stdout);
-    return count;
+    return l.len;
 }
 
 static void sanitize(char* src) {
@@ -970,6 +1056,21 @@ static void sanitize(char* src) {
     *dst = 0;
 }
 
+/* Turn the edited buffer into the value returned to the user: NULL for
+ * empty lines and errors, otherwise the buffer with non-printable
+ * characters removed. */
+static char *linenoiseResult(char *buf, int count) {
+    if (count > 0) {
+        sanitize(buf);
+        count = strlen(buf);
+    }
+    if (count <= 0) {
+        free(buf);
+        return NULL;
+    }
+    return buf;
+}
+
 /* The high level function that is the main API of the linenoise library. */
 char *linenoise(const char *prompt) {
     char *buf = calloc(1, LINENOISE_MAX_LINE);
@@ -979,15 +1080,110 @@ char *linenoise(const char *prompt) {
     } else {
         count = linenoiseDumb(buf, LINENOISE_MAX_LINE, prompt);
     }
-    if (count > 0) {
-        sanitize(buf);
-        count = strlen(buf);
+    return linenoiseResult(buf, count);
+}
+
+/* ======================= Non-blocking line editing ======================== */
+
+/* State of the line edited with linenoiseEditStart() / linenoiseEditFeed().
+ * Characters are passed by the application as they are received, so no task
+ * has to wait in a blocking read of stdin. The terminal is not queried for
+ * the number of columns, as its response would have to be read from stdin. */
+static struct linenoiseState editState;
+static int editActive = 0;
+
+/* Show the prompt and start editing a new line. Returns 0 on success,
+ * -1 on error with errno set. */
+int linenoiseEditStart(const char *prompt) {
+    if (editActive) {
+        errno = EBUSY;
+        return -1;
     }
-    if (count <= 0) {
-        free(buf);
+    char *buf = calloc(1, LINENOISE_MAX_LINE);
+    if (buf == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (!dumbmode) {
+        if (linenoiseEditInit(&editState, buf, LINENOISE_MAX_LINE, prompt, 0) == -1) {
+            history_len--;
+            free(history[history_len]);
+            free(buf);
+            return -1;
+        }
+    } else {
+        memset(&editState, 0, sizeof(editState));
+        editState.buf = buf;
+        editState.buflen = LINENOISE_MAX_LINE - 1;
+        editState.prompt = prompt;
+        fputs(prompt, stdout);
+    }
+    editActive = 1;
+    fflush(stdout);
+    return 0;
+}
+
+/* Pass a character typed by the user to the line being edited.
+ *
+ * Returns linenoiseEditMore while the line is not complete. Otherwise
+ * editing is finished and the line is returned the same way as by
+ * linenoise(): a heap allocated string to be freed with linenoiseFree(),
+ * or NULL for an empty line, ctrl-c (errno is set to EAGAIN) or ctrl-d.
+ * linenoiseEditStart() has to be called again for the next line. */
+char *linenoiseEditFeed(char c) {
+    if (!editActive) {
+        errno = EINVAL;
         return NULL;
     }
-    return buf;
+    int count = dumbmode ? linenoiseDumbKey(&editState, c)
+                         : linenoiseEditProcess(&editState, c);
+    if (count == LINENOISE_EDIT_MORE) {
+        fflush(stdout);
+        return linenoiseEditMore;
+    }
+    editActive = 0;
+    fputc('\n', stdout);
+    fflush(stdout);
+    return linenoiseResult(editState.buf, count);
+}
+
+/* Abandon the line being edited, e.g. when the terminal is disconnected. */
+void linenoiseEditStop(void) {
+    if (!editActive) return;
+    editActive = 0;
+    if (!dumbmode) {
+        if (editState.in_completion) freeCompletions(&editState.lc);
+        history_len--;
+        free(history[history_len]);
+    }
+    free(editState.buf);
+    fputc('\n', stdout);
+    fflush(stdout);
+}
+
+/* Clear the prompt and the line being edited, so that the application can
+ * print other output. linenoiseShow() restores them. */
+void linenoiseHide(void) {
+    if (!editActive || dumbmode) return;
+    if (mlmode) {
+        /* Go up to the first row and clear everything below. */
+        int rpos = (editState.plen+editState.oldpos+editState.cols)/editState.cols;
+        if (rpos > 1) fprintf(stdout, "\x1b[%dA", rpos-1);
+        fputs("\r\x1b[0J", stdout);
+    } else {
+        fputs("\r\x1b[0K", stdout);
+    }
+    fflush(stdout);
+}
+
+/* Show the prompt and the line being edited again after linenoiseHide(). */
+void linenoiseShow(void) {
+    if (!editActive || dumbmode) return;
+    /* The rows used before hiding are not on the screen any more */
+    editState.maxrows = 0;
+    editState.oldpos = 0;
+    refreshLine(&editState);
+    fflush(stdout);
 }
 
 /* This is just a wrapper the user may want to call in order to make sure
@@ -69,6 +69,13 @@ void linenoiseSetMultiLine(int ml);
 void linenoiseSetDumbMode(int set);
 void linenoisePrintKeyCodes(void);
 
+extern char *linenoiseEditMore;
+int linenoiseEditStart(const char *prompt);
+char *linenoiseEditFeed(char c);
+void linenoiseEditStop(void);
+void linenoiseHide(void);
+void linenoiseShow(void);
+
 #ifdef __cplusplus
 }
 #endif
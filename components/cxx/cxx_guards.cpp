@@ -22,6 +22,9 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "freertos/task.h"
+#include "soc/soc_memory_layout.h"
+#include "sdkconfig.h"
+#include "esp_cxx_guard.h"
 
 using __cxxabiv1::__guard;
 
@@ -29,9 +32,7 @@ static SemaphoreHandle_t s_static_init_mutex = NULL;        //!< lock used for t
 static SemaphoreHandle_t s_static_init_wait_sem = NULL;     //!< counting semaphore used by the waiting tasks
 static portMUX_TYPE s_init_spinlock = portMUX_INITIALIZER_UNLOCKED;   //!< spinlock used to guard initialization of the above two primitives
 static size_t s_static_init_waiting_count = 0;              //!< number of tasks which are waiting for static init guards
-#ifndef _NDEBUG
-static size_t s_static_init_max_waiting_count = 0;          //!< maximum ever value of the above; can be inspected using GDB for debugging purposes
-#endif
+static esp_cxx_guard_stats_t s_stats;                       //!< wait statistics, updated with s_static_init_mutex taken
 
 extern "C" int __cxa_guard_acquire(__guard* pg);
 extern "C" void __cxa_guard_release(__guard* pg);
@@ -42,12 +43,44 @@ extern "C" void __cxa_guard_dummy();
  * Layout of the guard object (defined by the ABI).
  *
  * Compiler will check lower byte before calling guard functions.
+ * The other bytes are ours. The first 32-bit word is changed with compare and
+ * set, so that a guard which no other task waits for is acquired and released
+ * without taking s_static_init_mutex.
  */
 typedef struct {
     uint8_t ready;      //!< nonzero if initialization is done
     uint8_t pending;    //!< nonzero if initialization is in progress
+    uint8_t waiting;    //!< nonzero if tasks wait for the initialization to complete
+    uint8_t reserved;
+    uint32_t wait_count;    //!< number of times a task had to wait for this guard
 } guard_t;
 
+static_assert(sizeof(guard_t) <= sizeof(__guard), "guard_t doesn't fit into __guard");
+
+/* Values of the first word of guard_t (little endian) */
+#define GUARD_READY     0x000001
+#define GUARD_PENDING   0x000100
+#define GUARD_WAITING   0x010000
+
+/* Compare the state of the guard with compare and set it to set if they are equal. Returns the previous state. */
+static inline uint32_t guard_compare_set(guard_t* g, uint32_t compare, uint32_t set)
+{
+    volatile uint32_t* state = reinterpret_cast<volatile uint32_t*>(g);
+#if defined(CONFIG_SPIRAM_SUPPORT)
+    if (esp_ptr_external_ram(g)) {
+        uxPortCompareSetExtram(state, compare, &set);
+        return set;
+    }
+#endif
+    uxPortCompareSet(state, compare, &set);
+    return set;
+}
+
+static inline uint32_t guard_state(guard_t* g)
+{
+    return *reinterpret_cast<volatile uint32_t*>(g);
+}
+
 static void static_init_prepare()
 {
     portENTER_CRITICAL(&s_init_spinlock);
@@ -63,21 +96,19 @@ static void static_init_prepare()
 }
 
 /**
- * Use s_static_init_wait_sem to wait until guard->pending == 0.
+ * Use s_static_init_wait_sem to wait until the guard isn't pending anymore.
  * Preconditions:
  * - s_static_init_mutex taken
- * - guard.pending == 1
+ * - guard is pending, with GUARD_WAITING set
  * Postconditions:
  * - s_static_init_mutex taken
- * - guard.pending == 0
+ * - guard isn't pending
  */
 static void wait_for_guard_obj(guard_t* g)
 {
     s_static_init_waiting_count++;
-#ifndef _NDEBUG
-    s_static_init_max_waiting_count = std::max(s_static_init_waiting_count,
-            s_static_init_max_waiting_count);
-#endif
+    s_stats.max_waiting = std::max(s_static_init_waiting_count, s_stats.max_waiting);
+    const TickType_t start = xTaskGetTickCount();
 
     do {
         auto result = xSemaphoreGive(s_static_init_mutex);
@@ -98,8 +129,15 @@ static void wait_for_guard_obj(guard_t* g)
         /* Semaphore may have been given because some other guard object became ready.
          * Check the guard object we need and wait again if it is still pending.
          */
-    } while(g->pending);
+    } while(guard_state(g) & GUARD_PENDING);
     s_static_init_waiting_count--;
+
+    s_stats.waits++;
+    s_stats.wait_ticks += xTaskGetTickCount() - start;
+    if (++g->wait_count > s_stats.most_waited_count) {
+        s_stats.most_waited_count = g->wait_count;
+        s_stats.most_waited_guard = g;
+    }
 }
 
 /**
@@ -117,98 +155,124 @@ static void signal_waiting_tasks()
     }
 }
 
+/* Take s_static_init_mutex, used only when the guard is contended */
+static void static_init_lock()
+{
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {
+        /* Before the scheduler has started, there we don't support simultaneous
+         * static initialization.
+         */
+        abort();
+    }
+    if (s_static_init_mutex == NULL) {
+        static_init_prepare();
+    }
+    auto result = xSemaphoreTake(s_static_init_mutex, portMAX_DELAY);
+    assert(result);
+}
+
+static void static_init_unlock()
+{
+    auto result = xSemaphoreGive(s_static_init_mutex);
+    assert(result);
+}
+
 extern "C" int __cxa_guard_acquire(__guard* pg)
 {
     guard_t* g = reinterpret_cast<guard_t*>(pg);
-    const auto scheduler_started = xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED;
-    if (!scheduler_started) {
-        if (g->pending) {
-            /* Before the scheduler has started, there we don't support simultaneous
-             * static initialization. This may be implemented using a spinlock and a
-             * s32c1i instruction, though.
+
+    /* The compiler checks g->ready before calling __cxa_guard_acquire, but another task may
+     * have completed or started the initialization since. Claim the guard if it is free.
+     */
+    uint32_t state = guard_compare_set(g, 0, GUARD_PENDING);
+    if (state == 0) {
+        /* Current task can start doing static initialization */
+        return 1;
+    }
+    if (state & GUARD_READY) {
+        /* Static initialization has been done by another task; nothing to do here */
+        return 0;
+    }
+
+    /* Another task is doing initialization at the moment; wait until it calls
+     * __cxa_guard_release or __cxa_guard_abort
+     */
+    static_init_lock();
+    int ret;
+    while (true) {
+        state = guard_compare_set(g, 0, GUARD_PENDING);
+        if (state == 0) {
+            /* The task which was doing static initialization has called __cxa_guard_abort;
+             * we acquire the guard and return 1, same as for the case if we didn't have to wait.
+             * Note: actually this scenario is unlikely to occur in the current
+             * configuration because exception support is disabled.
              */
-            abort();
+            ret = 1;
+            break;
         }
-    } else {
-        if (s_static_init_mutex == NULL) {
-            static_init_prepare();
+        if (state & GUARD_READY) {
+            /* The task which was doing static initialization has called __cxa_guard_release */
+            ret = 0;
+            break;
         }
-
-        /* We don't need to use double-checked locking pattern here, as the compiler
-         * must generate code to check if the first byte of *pg is non-zero, before
-         * calling __cxa_guard_acquire.
+        /* Ask the initializing task to signal the waiting tasks; only waiting tasks change the
+         * guard while it is pending, and they do so with s_static_init_mutex taken.
          */
-        auto result = xSemaphoreTake(s_static_init_mutex, portMAX_DELAY);
-        assert(result);
-        if (g->pending) {
-            /* Another task is doing initialization at the moment; wait until it calls
-             * __cxa_guard_release or __cxa_guard_abort
-             */
+        if (guard_compare_set(g, state, state | GUARD_WAITING) == state) {
             wait_for_guard_obj(g);
-            /* At this point there are two scenarios:
-             * - the task which was doing static initialization has called __cxa_guard_release,
-             *   which means that g->ready is set. We need to return 0.
-             * - the task which was doing static initialization has called __cxa_guard_abort,
-             *   which means that g->ready is not set; we should acquire the guard and return 1,
-             *   same as for the case if we didn't have to wait.
-             * Note: actually the second scenario is unlikely to occur in the current
-             * configuration because exception support is disabled.
-             */
         }
     }
-    int ret;
-    if (g->ready) {
-        /* Static initialization has been done by another task; nothing to do here */
-        ret = 0;
-    } else {
-        /* Current task can start doing static initialization */
-        g->pending = 1;
-        ret = 1;
-    }
-    if (scheduler_started) {
-        auto result = xSemaphoreGive(s_static_init_mutex);
-        assert(result);
-    }
+    static_init_unlock();
     return ret;
 }
 
 extern "C" void __cxa_guard_release(__guard* pg)
 {
     guard_t* g = reinterpret_cast<guard_t*>(pg);
-    const auto scheduler_started = xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED;
-    if (scheduler_started) {
-        auto result = xSemaphoreTake(s_static_init_mutex, portMAX_DELAY);
-        assert(result);
-    }
-    assert(g->pending && "tried to release a guard which wasn't acquired");
-    g->pending = 0;
     /* Initialization was successful */
-    g->ready = 1;
-    if (scheduler_started) {
-        /* Unblock the tasks waiting for static initialization to complete */
-        signal_waiting_tasks();
-        auto result = xSemaphoreGive(s_static_init_mutex);
-        assert(result);
+    uint32_t state = guard_compare_set(g, GUARD_PENDING, GUARD_READY);
+    if (state == GUARD_PENDING) {
+        /* nobody waits */
+        return;
     }
+    assert(state == (GUARD_PENDING | GUARD_WAITING) && "tried to release a guard which wasn't acquired");
+
+    static_init_lock();
+    guard_compare_set(g, GUARD_PENDING | GUARD_WAITING, GUARD_READY);
+    /* Unblock the tasks waiting for static initialization to complete */
+    signal_waiting_tasks();
+    static_init_unlock();
 }
 
 extern "C" void __cxa_guard_abort(__guard* pg)
 {
     guard_t* g = reinterpret_cast<guard_t*>(pg);
-    const auto scheduler_started = xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED;
-    if (scheduler_started) {
-        auto result = xSemaphoreTake(s_static_init_mutex, portMAX_DELAY);
-        assert(result);
+    uint32_t state = guard_compare_set(g, GUARD_PENDING, 0);
+    if (state == GUARD_PENDING) {
+        /* nobody waits */
+        return;
     }
-    assert(!g->ready && "tried to abort a guard which is ready");
-    assert(g->pending && "tried to release a guard which is not acquired");
-    g->pending = 0;
-    if (scheduler_started) {
-        /* Unblock the tasks waiting for static initialization to complete */
-        signal_waiting_tasks();
-        auto result = xSemaphoreGive(s_static_init_mutex);
-        assert(result);
+    assert(!(state & GUARD_READY) && "tried to abort a guard which is ready");
+    assert(state == (GUARD_PENDING | GUARD_WAITING) && "tried to release a guard which is not acquired");
+
+    static_init_lock();
+    guard_compare_set(g, GUARD_PENDING | GUARD_WAITING, 0);
+    /* Unblock the tasks waiting for static initialization to complete */
+    signal_waiting_tasks();
+    static_init_unlock();
+}
+
+extern "C" void esp_cxx_guard_get_stats(esp_cxx_guard_stats_t* stats)
+{
+    if (s_static_init_mutex == NULL) {
+        /* nobody has waited yet */
+        *stats = s_stats;
+        return;
     }
+    auto result = xSemaphoreTake(s_static_init_mutex, portMAX_DELAY);
+    assert(result);
+    *stats = s_stats;
+    static_init_unlock();
 }
 
 /**
@@ -0,0 +1,46 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Statistics of the tasks which waited for a static initialization of another task
+ *
+ * Static initialization which isn't contended doesn't take a lock and isn't counted.
+ */
+typedef struct {
+    uint32_t waits;                 /*!< Number of times a task waited for a static initialization */
+    uint32_t wait_ticks;            /*!< Total number of ticks the tasks spent waiting */
+    size_t max_waiting;             /*!< Highest number of tasks waiting at the same time */
+    const void *most_waited_guard;  /*!< Guard variable waited for most often, NULL if none. Can be resolved to a symbol using addr2line */
+    uint32_t most_waited_count;     /*!< Number of times a task waited for most_waited_guard */
+} esp_cxx_guard_stats_t;
+
+/**
+ * @brief Get the statistics of contended static initialization
+ *
+ * @param[out] stats  filled with the statistics since the application started
+ */
+void esp_cxx_guard_get_stats(esp_cxx_guard_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -7,6 +7,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "esp_cxx_guard.h"
 
 static const char* TAG = "cxx";
 
@@ -115,6 +116,8 @@ static int start_slow_init_task(int id, int affinity)
 
 TEST_CASE("static initialization guards work as expected", "[cxx]")
 {
+    esp_cxx_guard_stats_t stats_before, stats_after;
+    esp_cxx_guard_get_stats(&stats_before);
     s_slow_init_sem = xSemaphoreCreateCounting(10, 0);
     TEST_ASSERT_NOT_NULL(s_slow_init_sem);
     int task_count = 0;
@@ -140,6 +143,13 @@ TEST_CASE("static initialization guards work as expected", "[cxx]")
     }
     vSemaphoreDelete(s_slow_init_sem);
 
+    // the tasks which didn't do the initialization had to wait for it
+    esp_cxx_guard_get_stats(&stats_after);
+    TEST_ASSERT_GREATER_OR_EQUAL(stats_before.waits + task_count - 2, stats_after.waits);
+    TEST_ASSERT_GREATER_THAN(stats_before.wait_ticks, stats_after.wait_ticks);
+    TEST_ASSERT_GREATER_OR_EQUAL(2, stats_after.max_waiting);
+    TEST_ASSERT_NOT_NULL(stats_after.most_waited_guard);
+
     vTaskDelay(10); // Allow tasks to clean up, avoids race with leak detector
 }
 
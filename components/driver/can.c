@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/portmacro.h"
 #include "freertos/task.h"
@@ -21,6 +22,7 @@
 #include "esp_log.h"
 #include "esp_intr_alloc.h"
 #include "esp_pm.h"
+#include "esp_timer.h"
 #include "soc/dport_reg.h"
 #include "soc/can_struct.h"
 #include "driver/gpio.h"
@@ -78,6 +80,13 @@
 #define FRAME_STD_ID_LEN            2           //SFF ID requires 2 bytes (11bit)
 #define FRAME_INFO_LEN              1           //Frame info requires 1 byte
 
+//Software filter
+#define SW_FILTER_HASH_BITS         8           //Software filter is a bit map of 2^8 ID hashes
+#define SW_FILTER_WORDS             ((1 << SW_FILTER_HASH_BITS) / 32)
+
+//Number of frames copied out of the RX queue at once by can_receive_batch()
+#define RX_BATCH_LEN                8
+
 #define ALERT_LOG_LEVEL_WARNING     CAN_ALERT_ARB_LOST  //Alerts above and including this level use ESP_LOGW
 #define ALERT_LOG_LEVEL_ERROR       CAN_ALERT_TX_FAILED //Alerts above and including this level use ESP_LOGE
 
@@ -111,6 +120,12 @@ typedef union {
     uint8_t bytes[FRAME_MAX_LEN];
 } can_frame_t;
 
+//Item of the RX queue
+typedef struct {
+    can_frame_t frame;
+    int64_t timestamp;                              //Time the RX interrupt was handled (esp_timer_get_time())
+} can_rx_frame_t;
+
 //Control structure for CAN driver
 typedef struct {
     //Control and status members
@@ -119,6 +134,7 @@ typedef struct {
     uint32_t tx_failed_count;
     uint32_t arb_lost_count;
     uint32_t bus_error_count;
+    uint32_t rx_filtered_count;
     intr_handle_t isr_handle;
     //TX and RX
     QueueHandle_t tx_queue;
@@ -129,6 +145,9 @@ typedef struct {
     SemaphoreHandle_t alert_semphr;
     uint32_t alerts_enabled;
     uint32_t alerts_triggered;
+    //Software filter
+    bool sw_filter_en;
+    uint32_t sw_filter[SW_FILTER_WORDS];
 #ifdef CONFIG_PM_ENABLE
     //Power Management
     esp_pm_lock_handle_t pm_lock;
@@ -334,6 +353,34 @@ static inline uint32_t can_get_rx_message_counter()
     return CAN.rx_message_counter_reg.val;
 }
 
+/* ------------------------- Frame ID Functions ----------------------------- */
+
+static inline uint32_t can_get_frame_id(const can_frame_t *frame)
+{
+    int id_len = (frame->frame_format) ? FRAME_EXTD_ID_LEN : FRAME_STD_ID_LEN;
+    const uint8_t *id_buffer = (frame->frame_format) ? frame->extended.id : frame->standard.id;
+    uint32_t id_temp = 0;
+    for (int i = 0; i < id_len; i++) {
+        id_temp |= id_buffer[i] << (8 * i);     //Copy big-endian ID byte by byte
+    }
+    //Revert endianness of 4 or 2 byte ID, and shift into 29 or 11 bit ID
+    id_temp = (frame->frame_format) ? (__builtin_bswap32(id_temp) >> 3) :    //((byte[i] << 8*(3-i)) >> 3)
+                                      (__builtin_bswap16(id_temp) >> 5);     //((byte[i] << 8*(1-i)) >> 5)
+    return id_temp & ((frame->frame_format) ? CAN_EXTD_ID_MASK : CAN_STD_ID_MASK);
+}
+
+static inline uint32_t can_sw_filter_hash(uint32_t id, bool extd)
+{
+    //Multiplicative hash of the ID and frame format, keeping the top SW_FILTER_HASH_BITS bits
+    return ((id | (extd ? CAN_SW_FILTER_ID_EXTD : 0)) * 2654435761U) >> (32 - SW_FILTER_HASH_BITS);
+}
+
+static inline bool can_sw_filter_match(const can_frame_t *frame)
+{
+    uint32_t hash = can_sw_filter_hash(can_get_frame_id(frame), frame->frame_format);
+    return p_can_obj->sw_filter[hash / 32] & (1 << (hash % 32));
+}
+
 /* -------------------- Interrupt and Alert Handlers ------------------------ */
 
 static void can_alert_handler(uint32_t alert_code, int *alert_req)
@@ -426,19 +473,25 @@ static void can_intr_handler_rx(BaseType_t *task_woken, int *alert_req)
 {
     can_rx_msg_cnt_reg_t msg_count_reg;
     msg_count_reg.val = can_get_rx_message_counter();
+    int64_t timestamp = esp_timer_get_time();
 
     for (int i = 0; i < msg_count_reg.rx_message_counter; i++) {
-        can_frame_t frame;
-        can_get_rx_buffer_and_clear(&frame);
+        can_rx_frame_t rx_frame;
+        can_get_rx_buffer_and_clear(&rx_frame.frame);
+        //Drop frames passing the acceptance filter but not the software filter
+        if (p_can_obj->sw_filter_en && !can_sw_filter_match(&rx_frame.frame)) {
+            p_can_obj->rx_filtered_count++;
+            continue;
+        }
+        rx_frame.timestamp = timestamp;
         //Copy frame into RX Queue
-        if (xQueueSendFromISR(p_can_obj->rx_queue, &frame, task_woken) == pdTRUE) {
+        if (xQueueSendFromISR(p_can_obj->rx_queue, &rx_frame, task_woken) == pdTRUE) {
             p_can_obj->rx_msg_count++;
         } else {
             p_can_obj->rx_missed_count++;
             can_alert_handler(CAN_ALERT_RX_QUEUE_FULL, alert_req);
         }
     }
-    //Todo: Add Software Filters
     //Todo: Check for data overrun of RX FIFO, then trigger alert
 }
 
@@ -564,16 +617,7 @@ static void can_parse_frame(can_frame_t *rx_frame, uint32_t *id, uint8_t *dlc, u
     *flags |= (rx_frame->frame_format) ? CAN_MSG_FLAG_EXTD : 0;
 
     //Copy ID
-    int id_len = (rx_frame->frame_format) ? FRAME_EXTD_ID_LEN : FRAME_STD_ID_LEN;
-    uint8_t *id_buffer = (rx_frame->frame_format) ? rx_frame->extended.id : rx_frame->standard.id;
-    uint32_t id_temp = 0;
-    for (int i = 0; i < id_len; i++) {
-        id_temp |= id_buffer[i] << (8 * i);     //Copy big-endian ID byte by byte
-    }
-    //Revert endianness of 4 or 2 byte ID, and shift into 29 or 11 bit ID
-    id_temp = (rx_frame->frame_format) ? (__builtin_bswap32(id_temp) >> 3) :    //((byte[i] << 8*(3-i)) >> 3)
-                                         (__builtin_bswap16(id_temp) >> 5);     //((byte[i] << 8*(1-i)) >> 5)
-    *id = id_temp & ((rx_frame->frame_format) ? CAN_EXTD_ID_MASK : CAN_STD_ID_MASK);
+    *id = can_get_frame_id(rx_frame);
 
     //Copy data
     uint8_t *data_buffer = (rx_frame->frame_format) ? rx_frame->extended.data : rx_frame->standard.data;
@@ -635,7 +679,7 @@ esp_err_t can_driver_install(const can_general_config_t *g_config, const can_tim
 
     //Initialize queues, semaphores, and power management locks
     p_can_obj_dummy->tx_queue = (g_config->tx_queue_len > 0) ? xQueueCreate(g_config->tx_queue_len, sizeof(can_frame_t)) : NULL;
-    p_can_obj_dummy->rx_queue = xQueueCreate(g_config->rx_queue_len, sizeof(can_frame_t));
+    p_can_obj_dummy->rx_queue = xQueueCreate(g_config->rx_queue_len, sizeof(can_rx_frame_t));
     p_can_obj_dummy->alert_semphr = xSemaphoreCreateBinary();
     if ((g_config->tx_queue_len > 0 && p_can_obj_dummy->tx_queue == NULL) ||
         p_can_obj_dummy->rx_queue == NULL || p_can_obj_dummy->alert_semphr == NULL) {
@@ -660,6 +704,8 @@ esp_err_t can_driver_install(const can_general_config_t *g_config, const can_tim
     p_can_obj_dummy->rx_missed_count = 0;
     p_can_obj_dummy->arb_lost_count = 0;
     p_can_obj_dummy->bus_error_count = 0;
+    p_can_obj_dummy->rx_filtered_count = 0;
+    p_can_obj_dummy->sw_filter_en = false;
     p_can_obj_dummy->alerts_enabled = g_config->alerts_enabled;
     p_can_obj_dummy->alerts_triggered = 0;
 
@@ -876,7 +922,7 @@ esp_err_t can_receive(can_message_t *message, TickType_t ticks_to_wait)
     CAN_CHECK(message != NULL, ESP_ERR_INVALID_ARG);
 
     //Get frame from RX Queue or RX Buffer
-    can_frame_t rx_frame;
+    can_rx_frame_t rx_frame;
     if (xQueueReceive(p_can_obj->rx_queue, &rx_frame, ticks_to_wait) != pdTRUE) {
         return ESP_ERR_TIMEOUT;
     }
@@ -886,7 +932,42 @@ esp_err_t can_receive(can_message_t *message, TickType_t ticks_to_wait)
     CAN_EXIT_CRITICAL();
 
     //Decode frame
-    can_parse_frame(&rx_frame, &(message->identifier), &(message->data_length_code), message->data, &(message->flags));
+    can_parse_frame(&rx_frame.frame, &(message->identifier), &(message->data_length_code), message->data, &(message->flags));
+    return ESP_OK;
+}
+
+esp_err_t can_receive_batch(can_timestamped_message_t *messages, size_t max_num, size_t *num_received, TickType_t ticks_to_wait)
+{
+    //Check arguments and state
+    CAN_CHECK(p_can_obj != NULL, ESP_ERR_INVALID_STATE);
+    CAN_CHECK(messages != NULL && max_num > 0, ESP_ERR_INVALID_ARG);
+
+    can_rx_frame_t rx_frames[RX_BATCH_LEN];
+    size_t num = 0;
+    while (num < max_num) {
+        size_t batch_len = (max_num - num < RX_BATCH_LEN) ? max_num - num : RX_BATCH_LEN;
+        //Only block until the first frame is received
+        size_t batch_num = xQueueReceiveMultiple(p_can_obj->rx_queue, rx_frames, batch_len, (num == 0) ? ticks_to_wait : 0);
+        for (int i = 0; i < batch_num; i++) {
+            can_message_t *message = &messages[num + i].message;
+            can_parse_frame(&rx_frames[i].frame, &(message->identifier), &(message->data_length_code), message->data, &(message->flags));
+            messages[num + i].timestamp = rx_frames[i].timestamp;
+        }
+        num += batch_num;
+        if (batch_num < batch_len) {
+            break;      //RX queue is empty
+        }
+    }
+    if (num_received != NULL) {
+        *num_received = num;
+    }
+    if (num == 0) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    CAN_ENTER_CRITICAL();
+    p_can_obj->rx_msg_count -= num;
+    CAN_EXIT_CRITICAL();
     return ESP_OK;
 }
 
@@ -964,6 +1045,7 @@ esp_err_t can_get_status_info(can_status_info_t *status_info)
     status_info->rx_missed_count = p_can_obj->rx_missed_count;
     status_info->arb_lost_count = p_can_obj->arb_lost_count;
     status_info->bus_error_count = p_can_obj->bus_error_count;
+    status_info->rx_filtered_count = p_can_obj->rx_filtered_count;
     if (p_can_obj->control_flags & CTRL_FLAG_RECOVERING) {
         status_info->state = CAN_STATE_RECOVERING;
     } else if (p_can_obj->control_flags & CTRL_FLAG_BUS_OFF) {
@@ -1005,3 +1087,41 @@ esp_err_t can_clear_receive_queue()
 
     return ESP_OK;
 }
+
+esp_err_t can_reconfigure_filter(const can_filter_config_t *f_config)
+{
+    CAN_CHECK(f_config != NULL, ESP_ERR_INVALID_ARG);
+
+    CAN_ENTER_CRITICAL();
+    //Check state. Acceptance filter registers can only be written in reset mode
+    CAN_CHECK_FROM_CRIT(p_can_obj != NULL, ESP_ERR_INVALID_STATE);
+    CAN_CHECK_FROM_CRIT(p_can_obj->control_flags & CTRL_FLAG_STOPPED, ESP_ERR_INVALID_STATE);
+    can_config_acceptance_filter(f_config->acceptance_code, f_config->acceptance_mask, f_config->single_filter);
+    CAN_EXIT_CRITICAL();
+
+    return ESP_OK;
+}
+
+esp_err_t can_reconfigure_sw_filter(const uint32_t *ids, size_t num_ids)
+{
+    //Check arguments and state
+    CAN_CHECK(p_can_obj != NULL, ESP_ERR_INVALID_STATE);
+    CAN_CHECK(ids != NULL || num_ids == 0, ESP_ERR_INVALID_ARG);
+
+    //Build the new filter outside of the critical section
+    uint32_t sw_filter[SW_FILTER_WORDS] = {0};
+    for (int i = 0; i < num_ids; i++) {
+        bool extd = ids[i] & CAN_SW_FILTER_ID_EXTD;
+        uint32_t id = ids[i] & ~CAN_SW_FILTER_ID_EXTD;
+        CAN_CHECK(id <= (extd ? CAN_EXTD_ID_MASK : CAN_STD_ID_MASK), ESP_ERR_INVALID_ARG);
+        uint32_t hash = can_sw_filter_hash(id, extd);
+        sw_filter[hash / 32] |= 1 << (hash % 32);
+    }
+
+    CAN_ENTER_CRITICAL();
+    memcpy(p_can_obj->sw_filter, sw_filter, sizeof(sw_filter));
+    p_can_obj->sw_filter_en = (num_ids > 0);
+    CAN_EXIT_CRITICAL();
+
+    return ESP_OK;
+}
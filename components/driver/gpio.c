@@ -30,6 +30,9 @@ static const char* GPIO_TAG = "gpio";
         return (ret_val); \
     }
 
+// GPIO0-33 can be outputs, except GPIO20, GPIO24 and GPIO28-31, which are not bonded out
+#define GPIO_OUTPUT_PIN_MASK    ((BIT64(34) - 1) & ~(BIT64(20) | BIT64(24) | BIT64(28) | BIT64(29) | BIT64(30) | BIT64(31)))
+
 typedef struct {
     gpio_isr_t fn;   /*!< isr function */
     void* args;      /*!< isr function args */
@@ -181,6 +184,35 @@ int gpio_get_level(gpio_num_t gpio_num)
     }
 }
 
+esp_err_t gpio_set_level_mask(uint64_t mask, uint64_t levels)
+{
+    GPIO_CHECK((mask & ~GPIO_OUTPUT_PIN_MASK) == 0, "GPIO output mask error", ESP_ERR_INVALID_ARG);
+    const uint64_t set = mask & levels;
+    const uint64_t clr = mask & ~levels;
+    if ((uint32_t) set) {
+        GPIO.out_w1ts = (uint32_t) set;
+    }
+    if ((uint32_t) clr) {
+        GPIO.out_w1tc = (uint32_t) clr;
+    }
+    if (set >> 32) {
+        GPIO.out1_w1ts.data = set >> 32;
+    }
+    if (clr >> 32) {
+        GPIO.out1_w1tc.data = clr >> 32;
+    }
+    return ESP_OK;
+}
+
+uint64_t gpio_get_level_mask(uint64_t mask)
+{
+    uint64_t levels = GPIO.in;
+    if (mask >> 32) {
+        levels |= ((uint64_t) GPIO.in1.data) << 32;
+    }
+    return levels & mask;
+}
+
 esp_err_t gpio_set_pull_mode(gpio_num_t gpio_num, gpio_pull_mode_t pull)
 {
     GPIO_CHECK(GPIO_IS_VALID_GPIO(gpio_num), "GPIO number error", ESP_ERR_INVALID_ARG);
@@ -328,12 +360,14 @@ esp_err_t gpio_reset_pin(gpio_num_t gpio_num)
 }
 
 static inline void IRAM_ATTR gpio_isr_loop(uint32_t status, const uint32_t gpio_num_start) {
+    // Only visit the pending pins, highest first: __builtin_clz is a single NSAU instruction
     while (status) {
-        int nbit = __builtin_ffs(status) - 1;
-        status &= ~(1 << nbit);
-        int gpio_num = gpio_num_start + nbit;
-        if (gpio_isr_func[gpio_num].fn != NULL) {
-            gpio_isr_func[gpio_num].fn(gpio_isr_func[gpio_num].args);
+        int nbit = 31 - __builtin_clz(status);
+        status &= ~BIT(nbit);
+        const gpio_isr_func_t *isr = &gpio_isr_func[gpio_num_start + nbit];
+        gpio_isr_t fn = isr->fn;
+        if (fn != NULL) {
+            fn(isr->args);
         }
     }
 }
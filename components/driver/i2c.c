@@ -69,6 +69,8 @@ static DRAM_ATTR i2c_dev_t* const I2C[I2C_NUM_MAX] = { &I2C0, &I2C1 };
 #define I2C_DATA_LEN_ERR_STR           "i2c data read length error"
 #define I2C_PSRAM_BUFFER_WARN_STR      "Using buffer allocated from psram"
 #define I2C_LOCK_ERR_STR               "Power lock creation error"
+#define I2C_CMD_LINK_SIZE_ERR_STR      "i2c static command link buffer too small"
+#define I2C_CMD_QUEUE_FULL_ERR_STR     "i2c command queue full"
 #define I2C_FIFO_FULL_THRESH_VAL       (28)
 #define I2C_FIFO_EMPTY_THRESH_VAL      (5)
 #define I2C_IO_INIT_LEVEL              (1)
@@ -76,6 +78,7 @@ static DRAM_ATTR i2c_dev_t* const I2C[I2C_NUM_MAX] = { &I2C0, &I2C1 };
 #define I2C_CMD_EVT_ALIVE              (0)
 #define I2C_CMD_EVT_DONE               (1)
 #define I2C_EVT_QUEUE_LEN              (1)
+#define I2C_CMD_QUEUE_LEN              (8)         /* Number of transactions that can be queued with i2c_master_cmd_queue */
 #define I2C_SLAVE_TIMEOUT_DEFAULT      (32000)     /* I2C slave timeout value, APB clock cycle number */
 #define I2C_SLAVE_SDA_SAMPLE_DEFAULT   (10)        /* I2C slave sample time after scl positive edge default value */
 #define I2C_SLAVE_SDA_HOLD_DEFAULT     (10)        /* I2C slave hold time after scl negative edge default value */
@@ -106,8 +109,20 @@ typedef struct {
     i2c_cmd_link_t* head;     /*!< head of the command link */
     i2c_cmd_link_t* cur;      /*!< last node of the command link */
     i2c_cmd_link_t* free;     /*!< the first node to free of the command link */
+    uint8_t* static_buf;      /*!< free space of the caller's buffer, for static command links */
+    uint32_t static_size;     /*!< size of the free space of the caller's buffer */
+    bool is_static;           /*!< the nodes are allocated from the caller's buffer instead of the heap */
 } i2c_cmd_desc_t;
 
+_Static_assert(sizeof(i2c_cmd_desc_t) <= I2C_CMD_LINK_INTERNAL_SIZE, "i2c_cmd_desc_t > I2C_CMD_LINK_INTERNAL_SIZE");
+_Static_assert(sizeof(i2c_cmd_link_t) <= I2C_CMD_LINK_INTERNAL_SIZE, "i2c_cmd_link_t > I2C_CMD_LINK_INTERNAL_SIZE");
+
+typedef struct {
+    i2c_cmd_handle_t cmd;     /*!< command link of the transaction */
+    i2c_cmd_done_cb_t done_cb;/*!< callback called when the transaction is done */
+    void* arg;                /*!< argument for the callback */
+} i2c_cmd_trans_t;
+
 typedef enum {
     I2C_STATUS_READ,      /*!< read status for current master command */
     I2C_STATUS_WRITE,     /*!< write status for current master command */
@@ -138,6 +153,11 @@ typedef struct {
     StaticQueue_t evt_queue_buffer;  /*!< The buffer that will hold the queue structure*/
 #endif
     xSemaphoreHandle cmd_mux;        /*!< semaphore to lock command process */
+    i2c_cmd_trans_t cmd_queue[I2C_CMD_QUEUE_LEN]; /*!< transactions queued with i2c_master_cmd_queue */
+    int cmd_queue_head;              /*!< index of the running queued transaction */
+    int cmd_queue_len;               /*!< number of queued transactions, including the running one */
+    bool cmd_queue_busy;             /*!< queued transactions are running, i2c_master_cmd_begin has to wait */
+    xSemaphoreHandle cmd_queue_idle; /*!< given when the last queued transaction is done */
 #ifdef CONFIG_PM_ENABLE
     esp_pm_lock_handle_t pm_lock;
 #endif
@@ -155,6 +175,8 @@ typedef struct {
 static i2c_obj_t *p_i2c_obj[I2C_NUM_MAX] = {0};
 static void i2c_isr_handler_default(void* arg);
 static void IRAM_ATTR i2c_master_cmd_begin_static(i2c_port_t i2c_num);
+static void IRAM_ATTR i2c_master_cmd_done(i2c_port_t i2c_num, portBASE_TYPE* HPTaskAwoken);
+static void i2c_master_cmd_queue_abort(i2c_port_t i2c_num);
 static esp_err_t IRAM_ATTR i2c_hw_fsm_reset(i2c_port_t i2c_num);
 
 /*
@@ -233,6 +255,7 @@ esp_err_t i2c_driver_install(i2c_port_t i2c_num, i2c_mode_t mode, size_t slv_rx_
         } else {
             //semaphore to sync sending process, because we only have 32 bytes for hardware fifo.
             p_i2c->cmd_mux = xSemaphoreCreateMutex();
+            p_i2c->cmd_queue_idle = xSemaphoreCreateBinary();
 #ifdef CONFIG_PM_ENABLE
             if (esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, "i2c_driver", &p_i2c->pm_lock) != ESP_OK) {
                 ESP_LOGE(I2C_TAG, I2C_LOCK_ERR_STR);
@@ -254,7 +277,7 @@ esp_err_t i2c_driver_install(i2c_port_t i2c_num, i2c_mode_t mode, size_t slv_rx_
                 p_i2c->cmd_evt_queue =  xQueueCreateStatic(I2C_EVT_QUEUE_LEN, sizeof(i2c_cmd_evt_t), p_i2c->evt_queue_storage, &p_i2c->evt_queue_buffer);
             }
 #endif
-            if (p_i2c->cmd_mux == NULL || p_i2c->cmd_evt_queue == NULL) {
+            if (p_i2c->cmd_mux == NULL || p_i2c->cmd_queue_idle == NULL || p_i2c->cmd_evt_queue == NULL) {
                 ESP_LOGE(I2C_TAG, I2C_SEM_ERR_STR);
                 goto err;
             }
@@ -304,6 +327,9 @@ esp_err_t i2c_driver_install(i2c_port_t i2c_num, i2c_mode_t mode, size_t slv_rx_
         if (p_i2c_obj[i2c_num]->cmd_mux) {
             vSemaphoreDelete(p_i2c_obj[i2c_num]->cmd_mux);
         }
+        if (p_i2c_obj[i2c_num]->cmd_queue_idle) {
+            vSemaphoreDelete(p_i2c_obj[i2c_num]->cmd_queue_idle);
+        }
         if (p_i2c_obj[i2c_num]->slv_rx_mux) {
             vSemaphoreDelete(p_i2c_obj[i2c_num]->slv_rx_mux);
         }
@@ -361,8 +387,14 @@ esp_err_t i2c_driver_delete(i2c_port_t i2c_num)
 
     if (p_i2c->cmd_mux) {
         xSemaphoreTake(p_i2c->cmd_mux, portMAX_DELAY);
+        if (p_i2c->cmd_queue_busy) {
+            i2c_master_cmd_queue_abort(i2c_num);
+        }
         vSemaphoreDelete(p_i2c->cmd_mux);
     }
+    if (p_i2c->cmd_queue_idle) {
+        vSemaphoreDelete(p_i2c->cmd_queue_idle);
+    }
     if (p_i2c_obj[i2c_num]->cmd_evt_queue) {
         vQueueDelete(p_i2c_obj[i2c_num]->cmd_evt_queue);
         p_i2c_obj[i2c_num]->cmd_evt_queue = NULL;
@@ -953,12 +985,56 @@ i2c_cmd_handle_t i2c_cmd_link_create()
     return (i2c_cmd_handle_t) cmd_desc;
 }
 
+i2c_cmd_handle_t i2c_cmd_link_create_static(uint8_t* buffer, uint32_t size)
+{
+    //the descriptor and the nodes hold pointers, so they have to be word aligned
+    uint32_t pad = (4 - ((uint32_t) buffer & 3)) & 3;
+    if (buffer == NULL || size < pad + sizeof(i2c_cmd_desc_t)) {
+        return NULL;
+    }
+    i2c_cmd_desc_t* cmd_desc = (i2c_cmd_desc_t*) (buffer + pad);
+    memset(cmd_desc, 0, sizeof(i2c_cmd_desc_t));
+    cmd_desc->is_static = true;
+    cmd_desc->static_buf = (uint8_t*) (cmd_desc + 1);
+    cmd_desc->static_size = size - pad - sizeof(i2c_cmd_desc_t);
+    return (i2c_cmd_handle_t) cmd_desc;
+}
+
+static i2c_cmd_link_t* i2c_cmd_link_alloc(i2c_cmd_desc_t* cmd_desc)
+{
+    if (cmd_desc->is_static) {
+        //sizeof(i2c_cmd_link_t) is a multiple of the word size, so the nodes stay aligned
+        if (cmd_desc->static_size < sizeof(i2c_cmd_link_t)) {
+            ESP_LOGE(I2C_TAG, I2C_CMD_LINK_SIZE_ERR_STR);
+            return NULL;
+        }
+        i2c_cmd_link_t* link = (i2c_cmd_link_t*) cmd_desc->static_buf;
+        cmd_desc->static_buf += sizeof(i2c_cmd_link_t);
+        cmd_desc->static_size -= sizeof(i2c_cmd_link_t);
+        memset(link, 0, sizeof(i2c_cmd_link_t));
+        return link;
+    }
+#if !CONFIG_SPIRAM_USE_MALLOC
+    i2c_cmd_link_t* link = (i2c_cmd_link_t*) calloc(1, sizeof(i2c_cmd_link_t));
+#else
+    i2c_cmd_link_t* link = (i2c_cmd_link_t*) heap_caps_calloc(1, sizeof(i2c_cmd_link_t), MALLOC_CAP_INTERNAL|MALLOC_CAP_8BIT);
+#endif
+    if (link == NULL) {
+        ESP_LOGE(I2C_TAG, I2C_CMD_MALLOC_ERR_STR);
+    }
+    return link;
+}
+
 void i2c_cmd_link_delete(i2c_cmd_handle_t cmd_handle)
 {
     if (cmd_handle == NULL) {
         return;
     }
     i2c_cmd_desc_t* cmd = (i2c_cmd_desc_t*) cmd_handle;
+    if (cmd->is_static) {
+        //the caller owns the buffer of a static command link
+        return;
+    }
     while (cmd->free) {
         i2c_cmd_link_t* ptmp = cmd->free;
         cmd->free = cmd->free->next;
@@ -975,25 +1051,15 @@ static esp_err_t i2c_cmd_link_append(i2c_cmd_handle_t cmd_handle, i2c_cmd_t* cmd
 {
     i2c_cmd_desc_t* cmd_desc = (i2c_cmd_desc_t*) cmd_handle;
     if (cmd_desc->head == NULL) {
-#if !CONFIG_SPIRAM_USE_MALLOC
-        cmd_desc->head = (i2c_cmd_link_t*) calloc(1, sizeof(i2c_cmd_link_t));
-#else
-        cmd_desc->head = (i2c_cmd_link_t*) heap_caps_calloc(1, sizeof(i2c_cmd_link_t), MALLOC_CAP_INTERNAL|MALLOC_CAP_8BIT);
-#endif
+        cmd_desc->head = i2c_cmd_link_alloc(cmd_desc);
         if (cmd_desc->head == NULL) {
-            ESP_LOGE(I2C_TAG, I2C_CMD_MALLOC_ERR_STR);
             goto err;
         }
         cmd_desc->cur = cmd_desc->head;
         cmd_desc->free = cmd_desc->head;
     } else {
-#if !CONFIG_SPIRAM_USE_MALLOC
-        cmd_desc->cur->next = (i2c_cmd_link_t*) calloc(1, sizeof(i2c_cmd_link_t));
-#else
-        cmd_desc->cur->next = (i2c_cmd_link_t*) heap_caps_calloc(1, sizeof(i2c_cmd_link_t), MALLOC_CAP_INTERNAL|MALLOC_CAP_8BIT);
-#endif
+        cmd_desc->cur->next = i2c_cmd_link_alloc(cmd_desc);
         if (cmd_desc->cur->next == NULL) {
-            ESP_LOGE(I2C_TAG, I2C_CMD_MALLOC_ERR_STR);
             goto err;
         }
         cmd_desc->cur = cmd_desc->cur->next;
@@ -1139,7 +1205,6 @@ static void IRAM_ATTR i2c_master_cmd_begin_static(i2c_port_t i2c_num)
 {
     i2c_obj_t* p_i2c = p_i2c_obj[i2c_num];
     portBASE_TYPE HPTaskAwoken = pdFALSE;
-    i2c_cmd_evt_t evt;
     //This should never happen
     if (p_i2c->mode == I2C_MODE_SLAVE) {
         return;
@@ -1154,8 +1219,7 @@ static void IRAM_ATTR i2c_master_cmd_begin_static(i2c_port_t i2c_num)
             I2C[i2c_num]->int_clr.time_out = 1;
             I2C[i2c_num]->int_ena.val = 0;
         }
-        evt.type = I2C_CMD_EVT_DONE;
-        xQueueOverwriteFromISR(p_i2c->cmd_evt_queue, &evt, &HPTaskAwoken);
+        i2c_master_cmd_done(i2c_num, &HPTaskAwoken);
         if (HPTaskAwoken == pdTRUE) {
             portYIELD_FROM_ISR();
         }
@@ -1174,13 +1238,10 @@ static void IRAM_ATTR i2c_master_cmd_begin_static(i2c_port_t i2c_num)
     }
     if (p_i2c->cmd_link.head == NULL) {
         p_i2c->cmd_link.cur = NULL;
-        evt.type = I2C_CMD_EVT_DONE;
-        xQueueOverwriteFromISR(p_i2c->cmd_evt_queue, &evt, &HPTaskAwoken);
+        i2c_master_cmd_done(i2c_num, &HPTaskAwoken);
         if (HPTaskAwoken == pdTRUE) {
             portYIELD_FROM_ISR();
         }
-        // Return to the IDLE status after cmd_eve_done signal were send out.
-        p_i2c->status = I2C_STATUS_IDLE;
         return;
     }
     while (p_i2c->cmd_link.head) {
@@ -1251,6 +1312,98 @@ static void IRAM_ATTR i2c_master_cmd_begin_static(i2c_port_t i2c_num)
     return;
 }
 
+//Load a command link and send the first part of it. Called from the ISR as well, so it can't use the FIFO reset functions.
+static void IRAM_ATTR i2c_master_cmd_start(i2c_port_t i2c_num, i2c_cmd_desc_t* cmd)
+{
+    i2c_obj_t* p_i2c = p_i2c_obj[i2c_num];
+    I2C[i2c_num]->fifo_conf.tx_fifo_rst = 1;
+    I2C[i2c_num]->fifo_conf.tx_fifo_rst = 0;
+    I2C[i2c_num]->fifo_conf.rx_fifo_rst = 1;
+    I2C[i2c_num]->fifo_conf.rx_fifo_rst = 0;
+    p_i2c->cmd_link.free = cmd->free;
+    p_i2c->cmd_link.cur = cmd->cur;
+    p_i2c->cmd_link.head = cmd->head;
+    p_i2c->status = I2C_STATUS_IDLE;
+    p_i2c->cmd_idx = 0;
+    p_i2c->rx_cnt = 0;
+    p_i2c->tx_fifo_remain = I2C_FIFO_LEN;
+    p_i2c->rx_fifo_remain = I2C_FIFO_LEN;
+    // These two interrupts some times can not be cleared when the FSM gets stuck.
+    // so we disable them when these two interrupt occurs and re-enable them here.
+    I2C[i2c_num]->int_ena.ack_err = 1;
+    I2C[i2c_num]->int_ena.time_out = 1;
+    //start send commands, at most 32 bytes one time, isr handler will process the remaining commands.
+    i2c_master_cmd_begin_static(i2c_num);
+}
+
+//Complete the queued transaction that is running and start the next one. After a timeout the FSM has to
+//be reset, which can't be done from the ISR, so all remaining transactions are completed with the error.
+static void IRAM_ATTR i2c_master_cmd_queue_next(i2c_port_t i2c_num, esp_err_t ret, portBASE_TYPE* HPTaskAwoken)
+{
+    i2c_obj_t* p_i2c = p_i2c_obj[i2c_num];
+    while (1) {
+        //the running transaction stays in the queue until its callback returned, so that
+        //transactions queued in the meantime are started here.
+        i2c_cmd_trans_t* trans = &p_i2c->cmd_queue[p_i2c->cmd_queue_head];
+        if (trans->done_cb) {
+            trans->done_cb(i2c_num, trans->cmd, ret, trans->arg);
+        }
+        I2C_ENTER_CRITICAL_ISR(&i2c_spinlock[i2c_num]);
+        p_i2c->cmd_queue_head = (p_i2c->cmd_queue_head + 1) % I2C_CMD_QUEUE_LEN;
+        p_i2c->cmd_queue_len--;
+        if (p_i2c->cmd_queue_len == 0) {
+            p_i2c->cmd_queue_busy = false;
+            xSemaphoreGiveFromISR(p_i2c->cmd_queue_idle, HPTaskAwoken);
+#ifdef CONFIG_PM_ENABLE
+            esp_pm_lock_release(p_i2c->pm_lock);
+#endif
+            I2C_EXIT_CRITICAL_ISR(&i2c_spinlock[i2c_num]);
+            return;
+        }
+        I2C_EXIT_CRITICAL_ISR(&i2c_spinlock[i2c_num]);
+        if (ret != ESP_ERR_TIMEOUT) {
+            break;
+        }
+    }
+    i2c_master_cmd_start(i2c_num, (i2c_cmd_desc_t*) p_i2c->cmd_queue[p_i2c->cmd_queue_head].cmd);
+}
+
+static void IRAM_ATTR i2c_master_cmd_done(i2c_port_t i2c_num, portBASE_TYPE* HPTaskAwoken)
+{
+    i2c_obj_t* p_i2c = p_i2c_obj[i2c_num];
+    if (p_i2c->cmd_queue_busy) {
+        esp_err_t ret = ESP_OK;
+        if (p_i2c->status == I2C_STATUS_TIMEOUT) {
+            ret = ESP_ERR_TIMEOUT;
+        } else if (p_i2c->status == I2C_STATUS_ACK_ERROR) {
+            ret = ESP_FAIL;
+        } else {
+            p_i2c->status = I2C_STATUS_IDLE;
+        }
+        i2c_master_cmd_queue_next(i2c_num, ret, HPTaskAwoken);
+        return;
+    }
+    i2c_cmd_evt_t evt;
+    evt.type = I2C_CMD_EVT_DONE;
+    xQueueOverwriteFromISR(p_i2c->cmd_evt_queue, &evt, HPTaskAwoken);
+    if (p_i2c->status != I2C_STATUS_ACK_ERROR && p_i2c->status != I2C_STATUS_TIMEOUT) {
+        // Return to the IDLE status after cmd_eve_done signal were send out.
+        p_i2c->status = I2C_STATUS_IDLE;
+    }
+}
+
+//Complete all queued transactions with ESP_ERR_TIMEOUT and reset the FSM. Called with cmd_mux taken.
+static void i2c_master_cmd_queue_abort(i2c_port_t i2c_num)
+{
+    i2c_obj_t* p_i2c = p_i2c_obj[i2c_num];
+    portBASE_TYPE HPTaskAwoken = pdFALSE;
+    I2C[i2c_num]->int_ena.val = 0;
+    p_i2c->status = I2C_STATUS_TIMEOUT;
+    i2c_master_cmd_queue_next(i2c_num, ESP_ERR_TIMEOUT, &HPTaskAwoken);
+    i2c_hw_fsm_reset(i2c_num);
+    p_i2c->status = I2C_STATUS_DONE;
+}
+
 #if CONFIG_SPIRAM_USE_MALLOC
 //Check whether read or write buffer in cmd_link is internal.
 static bool is_cmd_link_buffer_internal(i2c_cmd_link_t *link)
@@ -1297,31 +1450,25 @@ esp_err_t i2c_master_cmd_begin(i2c_port_t i2c_num, i2c_cmd_handle_t cmd_handle,
     if (res == pdFALSE) {
         return ESP_ERR_TIMEOUT;
     }
+    if (p_i2c->cmd_queue_busy) {
+        //let the queued transactions finish first
+        TickType_t elapsed = xTaskGetTickCount() - ticks_start;
+        if (elapsed > ticks_to_wait
+            || xSemaphoreTake(p_i2c->cmd_queue_idle, ticks_to_wait - elapsed) == pdFALSE) {
+#ifdef CONFIG_PM_ENABLE
+            esp_pm_lock_release(p_i2c->pm_lock);
+#endif
+            xSemaphoreGive(p_i2c->cmd_mux);
+            return ESP_ERR_TIMEOUT;
+        }
+    }
     xQueueReset(p_i2c->cmd_evt_queue);
     if (p_i2c->status == I2C_STATUS_TIMEOUT
         || I2C[i2c_num]->status_reg.bus_busy == 1) {
         i2c_hw_fsm_reset(i2c_num);
         clear_bus_cnt = 0;
     }
-    i2c_reset_tx_fifo(i2c_num);
-    i2c_reset_rx_fifo(i2c_num);
-    i2c_cmd_desc_t* cmd = (i2c_cmd_desc_t*) cmd_handle;
-    p_i2c->cmd_link.free = cmd->free;
-    p_i2c->cmd_link.cur = cmd->cur;
-    p_i2c->cmd_link.head = cmd->head;
-    p_i2c->status = I2C_STATUS_IDLE;
-    p_i2c->cmd_idx = 0;
-    p_i2c->rx_cnt = 0;
-    p_i2c->tx_fifo_remain = I2C_FIFO_LEN;
-    p_i2c->rx_fifo_remain = I2C_FIFO_LEN;
-    i2c_reset_tx_fifo(i2c_num);
-    i2c_reset_rx_fifo(i2c_num);
-    // These two interrupts some times can not be cleared when the FSM gets stuck.
-    // so we disable them when these two interrupt occurs and re-enable them here.
-    I2C[i2c_num]->int_ena.ack_err = 1;
-    I2C[i2c_num]->int_ena.time_out = 1;
-    //start send commands, at most 32 bytes one time, isr handler will process the remaining commands.
-    i2c_master_cmd_begin_static(i2c_num);
+    i2c_master_cmd_start(i2c_num, (i2c_cmd_desc_t*) cmd_handle);
 
     // Wait event bits
     i2c_cmd_evt_t evt;
@@ -1378,6 +1525,87 @@ esp_err_t i2c_master_cmd_begin(i2c_port_t i2c_num, i2c_cmd_handle_t cmd_handle,
     return ret;
 }
 
+esp_err_t i2c_master_cmd_queue(i2c_port_t i2c_num, i2c_cmd_handle_t cmd_handle, i2c_cmd_done_cb_t done_cb, void* arg, TickType_t ticks_to_wait)
+{
+    I2C_CHECK(( i2c_num < I2C_NUM_MAX ), I2C_NUM_ERROR_STR, ESP_ERR_INVALID_ARG);
+    I2C_CHECK(p_i2c_obj[i2c_num] != NULL, I2C_DRIVER_NOT_INSTALL_ERR_STR, ESP_ERR_INVALID_STATE);
+    I2C_CHECK(p_i2c_obj[i2c_num]->mode == I2C_MODE_MASTER, I2C_MASTER_MODE_ERR_STR, ESP_ERR_INVALID_STATE);
+    I2C_CHECK(cmd_handle != NULL, I2C_CMD_LINK_INIT_ERR_STR, ESP_ERR_INVALID_ARG);
+
+#if CONFIG_SPIRAM_USE_MALLOC
+    if( (p_i2c_obj[i2c_num]->intr_alloc_flags & ESP_INTR_FLAG_IRAM) ) {
+        if( !is_cmd_link_buffer_internal(((i2c_cmd_desc_t*)cmd_handle)->head) ) {
+            ESP_LOGE(I2C_TAG, I2C_PSRAM_BUFFER_WARN_STR);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+#endif
+    i2c_obj_t* p_i2c = p_i2c_obj[i2c_num];
+    //the mutex only keeps out i2c_master_cmd_begin, queued transactions are run by the ISR
+    if (xSemaphoreTake(p_i2c->cmd_mux, ticks_to_wait) == pdFALSE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    bool start = false;
+    I2C_ENTER_CRITICAL(&i2c_spinlock[i2c_num]);
+    if (p_i2c->cmd_queue_len == I2C_CMD_QUEUE_LEN) {
+        I2C_EXIT_CRITICAL(&i2c_spinlock[i2c_num]);
+        xSemaphoreGive(p_i2c->cmd_mux);
+        ESP_LOGE(I2C_TAG, I2C_CMD_QUEUE_FULL_ERR_STR);
+        return ESP_ERR_NO_MEM;
+    }
+    i2c_cmd_trans_t* trans = &p_i2c->cmd_queue[(p_i2c->cmd_queue_head + p_i2c->cmd_queue_len) % I2C_CMD_QUEUE_LEN];
+    trans->cmd = cmd_handle;
+    trans->done_cb = done_cb;
+    trans->arg = arg;
+    p_i2c->cmd_queue_len++;
+    if (!p_i2c->cmd_queue_busy) {
+        p_i2c->cmd_queue_busy = true;
+        start = true;
+    }
+    I2C_EXIT_CRITICAL(&i2c_spinlock[i2c_num]);
+
+    if (start) {
+#ifdef CONFIG_PM_ENABLE
+        esp_pm_lock_acquire(p_i2c->pm_lock);
+#endif
+        //clear the idle signal left over from the previous batch of transactions
+        xSemaphoreTake(p_i2c->cmd_queue_idle, 0);
+        if (p_i2c->status == I2C_STATUS_TIMEOUT
+            || I2C[i2c_num]->status_reg.bus_busy == 1) {
+            i2c_hw_fsm_reset(i2c_num);
+        }
+        i2c_master_cmd_start(i2c_num, (i2c_cmd_desc_t*) cmd_handle);
+    }
+    xSemaphoreGive(p_i2c->cmd_mux);
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_cmd_queue_wait(i2c_port_t i2c_num, TickType_t ticks_to_wait)
+{
+    I2C_CHECK(( i2c_num < I2C_NUM_MAX ), I2C_NUM_ERROR_STR, ESP_ERR_INVALID_ARG);
+    I2C_CHECK(p_i2c_obj[i2c_num] != NULL, I2C_DRIVER_NOT_INSTALL_ERR_STR, ESP_ERR_INVALID_STATE);
+    I2C_CHECK(p_i2c_obj[i2c_num]->mode == I2C_MODE_MASTER, I2C_MASTER_MODE_ERR_STR, ESP_ERR_INVALID_STATE);
+
+    i2c_obj_t* p_i2c = p_i2c_obj[i2c_num];
+    portTickType ticks_start = xTaskGetTickCount();
+    if (xSemaphoreTake(p_i2c->cmd_mux, ticks_to_wait) == pdFALSE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    esp_err_t ret = ESP_OK;
+    if (p_i2c->cmd_queue_busy) {
+        TickType_t elapsed = xTaskGetTickCount() - ticks_start;
+        if (elapsed > ticks_to_wait
+            || xSemaphoreTake(p_i2c->cmd_queue_idle, ticks_to_wait - elapsed) == pdFALSE) {
+            // In the same way as i2c_master_cmd_begin, a transaction that doesn't finish means that the
+            // bus or the FSM is stuck, so the remaining transactions are dropped and the FSM is reset.
+            i2c_master_cmd_queue_abort(i2c_num);
+            ret = ESP_ERR_TIMEOUT;
+        }
+    }
+    xSemaphoreGive(p_i2c->cmd_mux);
+    return ret;
+}
+
 int i2c_slave_write_buffer(i2c_port_t i2c_num, uint8_t* data, int size, TickType_t ticks_to_wait)
 {
     I2C_CHECK(( i2c_num < I2C_NUM_MAX ), I2C_NUM_ERROR_STR, ESP_FAIL);
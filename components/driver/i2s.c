@@ -66,6 +66,7 @@ typedef struct {
     int buf_size;
     int rw_pos;
     void *curr_ptr;
+    bool acquired;              /*!< Buffer handed out by i2s_dma_buffer_acquire, mux is held until release */
     SemaphoreHandle_t mux;
     xQueueHandle queue;
     lldesc_t **desc;
@@ -101,7 +102,8 @@ static i2s_obj_t *p_i2s_obj[I2S_NUM_MAX] = {0};
 static i2s_dev_t* I2S[I2S_NUM_MAX] = {&I2S0, &I2S1};
 static portMUX_TYPE i2s_spinlock[I2S_NUM_MAX] = {portMUX_INITIALIZER_UNLOCKED, portMUX_INITIALIZER_UNLOCKED};
 static int _i2s_adc_unit = -1;
-static int _i2s_adc_channel = -1;
+static adc_i2s_pattern_t _i2s_adc_pattern[ADC_I2S_PATTERN_LEN_MAX];
+static int _i2s_adc_pattern_len = 0;
 
 static i2s_dma_t *i2s_create_dma_queue(i2s_port_t i2s_num, int dma_buf_count, int dma_buf_len);
 static esp_err_t i2s_destroy_dma_queue(i2s_port_t i2s_num, i2s_dma_t *dma);
@@ -726,17 +728,58 @@ esp_err_t i2s_set_dac_mode(i2s_dac_mode_t dac_mode)
 
 static esp_err_t _i2s_adc_mode_recover()
 {
-    I2S_CHECK(((_i2s_adc_unit != -1) && (_i2s_adc_channel != -1)), "i2s ADC recover error, not initialized...", ESP_ERR_INVALID_ARG);
-    return adc_i2s_mode_init(_i2s_adc_unit, _i2s_adc_channel);
+    I2S_CHECK(((_i2s_adc_unit != -1) && (_i2s_adc_pattern_len > 0)), "i2s ADC recover error, not initialized...", ESP_ERR_INVALID_ARG);
+    return adc_i2s_mode_init_pattern(_i2s_adc_unit, _i2s_adc_pattern, _i2s_adc_pattern_len);
 }
 
 esp_err_t i2s_set_adc_mode(adc_unit_t adc_unit, adc1_channel_t adc_channel)
+{
+    const adc_i2s_pattern_t pattern = {
+        .channel = (adc_channel_t) adc_channel,
+        .atten = ADC_ATTEN_DB_11,
+    };
+    return i2s_set_adc_pattern(adc_unit, &pattern, 1);
+}
+
+esp_err_t i2s_set_adc_pattern(adc_unit_t adc_unit, const adc_i2s_pattern_t *pattern, int pattern_len)
 {
     I2S_CHECK((adc_unit < ADC_UNIT_2), "i2s ADC unit error, only support ADC1 for now", ESP_ERR_INVALID_ARG);
+    I2S_CHECK((pattern != NULL && pattern_len > 0 && pattern_len <= ADC_I2S_PATTERN_LEN_MAX), "i2s ADC pattern error", ESP_ERR_INVALID_ARG);
     // For now, we only support SAR ADC1.
+    esp_err_t ret = adc_i2s_mode_init_pattern(adc_unit, pattern, pattern_len);
+    if (ret != ESP_OK) {
+        return ret;
+    }
     _i2s_adc_unit = adc_unit;
-    _i2s_adc_channel = adc_channel;
-    return adc_i2s_mode_init(adc_unit, adc_channel);
+    memcpy(_i2s_adc_pattern, pattern, pattern_len * sizeof(adc_i2s_pattern_t));
+    _i2s_adc_pattern_len = pattern_len;
+    return ESP_OK;
+}
+
+int i2s_adc_demux(const void *data, size_t size, i2s_adc_channel_buf_t channels[ADC1_CHANNEL_MAX])
+{
+    const uint32_t *words = (const uint32_t *) data;
+    int dropped = 0;
+    uint16_t sample[2];
+
+    if (data == NULL || channels == NULL) {
+        return ESP_FAIL;
+    }
+    // I2S stores the two 16-bit samples of each word with the earlier one in the upper half
+    for (int i = 0; i < size / sizeof(uint32_t); i++) {
+        sample[0] = words[i] >> 16;
+        sample[1] = words[i] & 0xffff;
+        for (int j = 0; j < 2; j++) {
+            int ch = sample[j] >> 12;
+            i2s_adc_channel_buf_t *dest = &channels[ch];
+            if (ch >= ADC1_CHANNEL_MAX || dest->buf == NULL || dest->len >= dest->size) {
+                dropped++;
+                continue;
+            }
+            dest->buf[dest->len++] = sample[j] & 0xfff;
+        }
+    }
+    return dropped;
 }
 
 esp_err_t i2s_set_pin(i2s_port_t i2s_num, const i2s_pin_config_t *pin)
@@ -1356,6 +1399,90 @@ esp_err_t i2s_read(i2s_port_t i2s_num, void *dest, size_t size, size_t *bytes_re
     return ESP_OK;
 }
 
+esp_err_t i2s_dma_buffer_acquire(i2s_port_t i2s_num, i2s_mode_t dir, void **buf, size_t *size, TickType_t ticks_to_wait)
+{
+    i2s_dma_t *dma;
+    I2S_CHECK((i2s_num < I2S_NUM_MAX), "i2s_num error", ESP_ERR_INVALID_ARG);
+    I2S_CHECK((p_i2s_obj[i2s_num] != NULL), "Not initialized yet", ESP_ERR_INVALID_STATE);
+    I2S_CHECK((dir == I2S_MODE_TX || dir == I2S_MODE_RX), "dir error", ESP_ERR_INVALID_ARG);
+    I2S_CHECK((buf != NULL && size != NULL), "buf or size NULL", ESP_ERR_INVALID_ARG);
+    dma = (dir == I2S_MODE_TX) ? p_i2s_obj[i2s_num]->tx : p_i2s_obj[i2s_num]->rx;
+    I2S_CHECK((dma), (dir == I2S_MODE_TX) ? "tx NULL" : "rx NULL", ESP_ERR_INVALID_ARG);
+    if (xSemaphoreTake(dma->mux, ticks_to_wait) == pdFALSE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    if (dma->acquired) {
+        xSemaphoreGive(dma->mux);
+        ESP_LOGE(I2S_TAG, "dma buffer already acquired");
+        return ESP_ERR_INVALID_STATE;
+    }
+    // Same bookkeeping as i2s_write/i2s_read: hand out the rest of the buffer they left partially
+    // used, otherwise the next buffer the ISR returned to the queue.
+    if (dma->rw_pos == dma->buf_size || dma->curr_ptr == NULL) {
+        if (xQueueReceive(dma->queue, &dma->curr_ptr, ticks_to_wait) == pdFALSE) {
+            xSemaphoreGive(dma->mux);
+            return ESP_ERR_TIMEOUT;
+        }
+        dma->rw_pos = 0;
+    }
+#ifdef CONFIG_PM_ENABLE
+    esp_pm_lock_acquire(p_i2s_obj[i2s_num]->pm_lock);
+#endif
+    dma->acquired = true;
+    *buf = (char *)dma->curr_ptr + dma->rw_pos;
+    *size = dma->buf_size - dma->rw_pos;
+    return ESP_OK;
+}
+
+esp_err_t i2s_dma_buffer_release(i2s_port_t i2s_num, i2s_mode_t dir, void *buf)
+{
+    i2s_dma_t *dma;
+    I2S_CHECK((i2s_num < I2S_NUM_MAX), "i2s_num error", ESP_ERR_INVALID_ARG);
+    I2S_CHECK((p_i2s_obj[i2s_num] != NULL), "Not initialized yet", ESP_ERR_INVALID_STATE);
+    I2S_CHECK((dir == I2S_MODE_TX || dir == I2S_MODE_RX), "dir error", ESP_ERR_INVALID_ARG);
+    dma = (dir == I2S_MODE_TX) ? p_i2s_obj[i2s_num]->tx : p_i2s_obj[i2s_num]->rx;
+    I2S_CHECK((dma), (dir == I2S_MODE_TX) ? "tx NULL" : "rx NULL", ESP_ERR_INVALID_ARG);
+    I2S_CHECK((dma->acquired), "dma buffer not acquired", ESP_ERR_INVALID_STATE);
+    I2S_CHECK((buf == (char *)dma->curr_ptr + dma->rw_pos), "buf is not the acquired dma buffer", ESP_ERR_INVALID_ARG);
+    dma->acquired = false;
+    dma->rw_pos = dma->buf_size;
+#ifdef CONFIG_PM_ENABLE
+    esp_pm_lock_release(p_i2s_obj[i2s_num]->pm_lock);
+#endif
+    xSemaphoreGive(dma->mux);
+    return ESP_OK;
+}
+
+esp_err_t i2s_expand_in_place(void *buf, size_t size, size_t src_bits, size_t aim_bits)
+{
+    int src_bytes, aim_bytes, zero_bytes, samples;
+    I2S_CHECK((buf != NULL), "buf NULL", ESP_ERR_INVALID_ARG);
+    I2S_CHECK((aim_bits >= src_bits), "aim_bits musn't less than src_bits", ESP_ERR_INVALID_ARG);
+    I2S_CHECK((src_bits >= I2S_BITS_PER_SAMPLE_8BIT && aim_bits <= I2S_BITS_PER_SAMPLE_32BIT && src_bits % 8 == 0 && aim_bits % 8 == 0), "bits error", ESP_ERR_INVALID_ARG);
+    src_bytes = src_bits / 8;
+    aim_bytes = aim_bits / 8;
+    zero_bytes = aim_bytes - src_bytes;
+    I2S_CHECK((size % src_bytes == 0), "size must be a multiple of the source sample size", ESP_ERR_INVALID_ARG);
+    samples = size / src_bytes;
+
+    // Walk backwards so that no source sample is overwritten before it is moved. The output
+    // layout is the one i2s_write_expand produces: the sample in the upper bytes, zeros below.
+    if (src_bits == I2S_BITS_PER_SAMPLE_16BIT && aim_bits == I2S_BITS_PER_SAMPLE_32BIT && ((uint32_t)buf & 3) == 0) {
+        const uint16_t *src = (const uint16_t *)buf;
+        uint32_t *dst = (uint32_t *)buf;
+        for (int i = samples - 1; i >= 0; i--) {
+            dst[i] = (uint32_t)src[i] << 16;
+        }
+    } else if (zero_bytes > 0) {
+        uint8_t *data = (uint8_t *)buf;
+        for (int i = samples - 1; i >= 0; i--) {
+            memmove(&data[i * aim_bytes + zero_bytes], &data[i * src_bytes], src_bytes);
+            memset(&data[i * aim_bytes], 0, zero_bytes);
+        }
+    }
+    return ESP_OK;
+}
+
 int i2s_push_sample(i2s_port_t i2s_num, const void *sample, TickType_t ticks_to_wait)
 {
     size_t bytes_push = 0;
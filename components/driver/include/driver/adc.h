@@ -283,6 +283,32 @@ esp_err_t adc_set_i2s_data_source(adc_i2s_source_t src);
  */
 esp_err_t adc_i2s_mode_init(adc_unit_t adc_unit, adc_channel_t channel);
 
+/**
+ * @brief Entry of the pattern table the ADC digital controller steps through in I2S ADC mode
+ */
+typedef struct {
+    adc_channel_t channel;   /*!< ADC channel index */
+    adc_atten_t atten;       /*!< Attenuation of the channel */
+} adc_i2s_pattern_t;
+
+#define ADC_I2S_PATTERN_LEN_MAX  (16)  /*!< Max number of entries in the I2S ADC pattern table */
+
+/**
+ * @brief Initialize I2S ADC mode to sample several channels
+ *
+ * The ADC digital controller converts the channels of the pattern table in turn, so the
+ * I2S DMA data contains the samples of the channels interleaved. Each 16-bit sample carries
+ * its channel index in bits [15:12], see i2s_adc_demux.
+ *
+ * @param adc_unit ADC unit index
+ * @param pattern Pattern table, a channel may appear more than once to be sampled more often
+ * @param pattern_len Number of entries in pattern, 1 to ADC_I2S_PATTERN_LEN_MAX
+ * @return
+ *     - ESP_OK success
+ *     - ESP_ERR_INVALID_ARG Parameter error
+ */
+esp_err_t adc_i2s_mode_init_pattern(adc_unit_t adc_unit, const adc_i2s_pattern_t *pattern, int pattern_len);
+
 /**
  * @brief Configure ADC1 to be usable by the ULP
  *
@@ -107,6 +107,7 @@ extern "C" {
 #define CAN_STD_ID_MASK                 0x7FF       /**< Bit mask for 11 bit Standard Frame Format ID */
 #define CAN_MAX_DATA_LEN                8           /**< Maximum number of data bytes in a CAN2.0B frame */
 #define CAN_IO_UNUSED                   ((gpio_num_t) -1)   /**< Marks GPIO as unused in CAN configuration */
+#define CAN_SW_FILTER_ID_EXTD           0x80000000  /**< Marks an ID passed to can_reconfigure_sw_filter() as an Extended Frame Format ID */
 /** @endcond */
 
 /* ----------------------- Enum and Struct Definitions ---------------------- */
@@ -184,6 +185,7 @@ typedef struct {
     uint32_t rx_missed_count;       /**< Number of messages that were lost due to a full RX queue */
     uint32_t arb_lost_count;        /**< Number of instances arbitration was lost */
     uint32_t bus_error_count;       /**< Number of instances a bus error has occurred */
+    uint32_t rx_filtered_count;     /**< Number of messages dropped by the software filter */
 } can_status_info_t;
 
 /**
@@ -199,6 +201,14 @@ typedef struct {
     uint8_t data[CAN_MAX_DATA_LEN]; /**< Data bytes (not relevant in RTR frame) */
 } can_message_t;
 
+/**
+ * @brief   Structure to store a received CAN message with its time of reception
+ */
+typedef struct {
+    can_message_t message;          /**< Received message */
+    int64_t timestamp;              /**< Time the message was taken out of the RX buffer, in microseconds since boot (see esp_timer_get_time()) */
+} can_timestamped_message_t;
+
 /* ----------------------------- Public API -------------------------------- */
 
 /**
@@ -326,6 +336,27 @@ esp_err_t can_transmit(const can_message_t *message, TickType_t ticks_to_wait);
  */
 esp_err_t can_receive(can_message_t *message, TickType_t ticks_to_wait);
 
+/**
+ * @brief   Receive several CAN messages with their timestamps
+ *
+ * This function blocks until there is at least one message in the RX queue,
+ * then receives as many messages as are available, up to max_num. Compared to
+ * calling can_receive() for each message, it takes the messages out of the RX
+ * queue in batches of several messages.
+ *
+ * @param[out]  messages        Array of at least max_num messages to store the received messages in
+ * @param[in]   max_num         Maximum number of messages to receive
+ * @param[out]  num_received    Number of messages received (optional, can be NULL)
+ * @param[in]   ticks_to_wait   Number of FreeRTOS ticks to block on RX queue
+ *
+ * @return
+ *      - ESP_OK: At least one message successfully received from RX queue
+ *      - ESP_ERR_TIMEOUT: Timed out waiting for message
+ *      - ESP_ERR_INVALID_ARG: Arguments are invalid
+ *      - ESP_ERR_INVALID_STATE: CAN driver is not installed
+ */
+esp_err_t can_receive_batch(can_timestamped_message_t *messages, size_t max_num, size_t *num_received, TickType_t ticks_to_wait);
+
 /**
  * @brief   Read CAN driver alerts
  *
@@ -421,6 +452,44 @@ esp_err_t can_clear_transmit_queue();
  */
 esp_err_t can_clear_receive_queue();
 
+/**
+ * @brief   Reconfigure the acceptance filter
+ *
+ * This function replaces the acceptance filter configured by
+ * can_driver_install(). The acceptance filter registers can only be written
+ * whilst the CAN controller is in the stopped state, so stop the driver with
+ * can_stop() first and restart it with can_start() afterwards.
+ *
+ * @param[in]   f_config    New acceptance filter configuration
+ *
+ * @return
+ *      - ESP_OK: Acceptance filter reconfigured
+ *      - ESP_ERR_INVALID_ARG: Arguments are invalid
+ *      - ESP_ERR_INVALID_STATE: CAN driver is not installed or not in the stopped state
+ */
+esp_err_t can_reconfigure_filter(const can_filter_config_t *f_config);
+
+/**
+ * @brief   Reconfigure the software filter
+ *
+ * The software filter is applied by the interrupt handler to messages that
+ * have passed the acceptance filter, before they are copied into the RX queue.
+ * It keeps the messages whose ID hashes to the same value as one of the given
+ * IDs, so unlike the acceptance filter it can select any set of IDs, but some
+ * IDs that were not given may still be received. Messages dropped by the
+ * software filter are counted in the rx_filtered_count of can_status_info_t.
+ * This function can be called in any state.
+ *
+ * @param[in]   ids         IDs to receive. Extended Frame Format IDs should be ORed with CAN_SW_FILTER_ID_EXTD
+ * @param[in]   num_ids     Number of IDs, 0 to disable the software filter
+ *
+ * @return
+ *      - ESP_OK: Software filter reconfigured
+ *      - ESP_ERR_INVALID_ARG: Arguments are invalid
+ *      - ESP_ERR_INVALID_STATE: CAN driver is not installed
+ */
+esp_err_t can_reconfigure_sw_filter(const uint32_t *ids, size_t num_ids);
+
 #ifdef __cplusplus
 }
 #endif
@@ -329,6 +329,34 @@ esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level);
  */
 int gpio_get_level(gpio_num_t gpio_num);
 
+/**
+ * @brief  GPIO set output level of several pins at once
+ *
+ * Pins of GPIO0-31 and of GPIO32-33 are each set with a single register write and cleared with another one,
+ * so the pins of one group being set change at the same time, as do the ones being cleared.
+ *
+ * @param  mask Bit mask of the pins to change (GPIO_SEL_x), pins not in mask are left as they are
+ * @param  levels Bit mask of the output levels, bit x is the level of GPIOx. 0: low ; 1: high
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG mask contains a pin which can't be an output
+ *
+ */
+esp_err_t gpio_set_level_mask(uint64_t mask, uint64_t levels);
+
+/**
+ * @brief  GPIO get input level of several pins at once
+ *
+ * @warning If a pad is not configured for input (or input and output) its level is always returned as 0.
+ *
+ * @param  mask Bit mask of the pins to read (GPIO_SEL_x)
+ *
+ * @return Bit mask of the input levels of the pins in mask, bit x is the level of GPIOx
+ *
+ */
+uint64_t gpio_get_level_mask(uint64_t mask);
+
 /**
  * @brief	 GPIO set direction
  *
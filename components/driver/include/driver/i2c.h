@@ -100,6 +100,27 @@ typedef struct{
 
 typedef void* i2c_cmd_handle_t;    /*!< I2C command handle  */
 
+/**
+ * @brief Callback called when a transaction queued with i2c_master_cmd_queue() is done.
+ *        It is called from the I2C ISR, so it has to be short and must not block.
+ *
+ * @param i2c_num I2C port number
+ * @param cmd_handle command link of the transaction
+ * @param result ESP_OK, ESP_FAIL if the slave didn't ACK or ESP_ERR_TIMEOUT if the bus is stuck.
+ * @param arg argument passed to i2c_master_cmd_queue()
+ */
+typedef void (*i2c_cmd_done_cb_t)(i2c_port_t i2c_num, i2c_cmd_handle_t cmd_handle, esp_err_t result, void* arg);
+
+#define I2C_CMD_LINK_INTERNAL_SIZE (24)  /*!< Upper bound of the size of the command link descriptor and of each command */
+
+/**
+ * @brief Size of the buffer for i2c_cmd_link_create_static() to hold CMD_NUM commands.
+ *        Start, stop, i2c_master_write_byte() and i2c_master_read_byte() are one command each,
+ *        i2c_master_write() and i2c_master_read() use one command per 255 bytes of data
+ *        (plus one for I2C_MASTER_LAST_NACK).
+ */
+#define I2C_CMD_LINK_STATIC_SIZE(CMD_NUM) (I2C_CMD_LINK_INTERNAL_SIZE * ((CMD_NUM) + 1) + 3)
+
 /**
  * @brief I2C driver install
  *
@@ -238,6 +259,21 @@ i2c_cmd_handle_t i2c_cmd_link_create();
  */
 void i2c_cmd_link_delete(i2c_cmd_handle_t cmd_handle);
 
+/**
+ * @brief Create and init I2C command link in a buffer provided by the caller
+ *        @note
+ *        The commands are stored in the buffer as well, so building the command link doesn't
+ *        allocate memory. The buffer has to stay valid until the command link is no longer used.
+ *        Calling this function again with the same buffer clears the command link.
+ *        i2c_cmd_link_delete() does nothing for static command links.
+ *
+ * @param buffer buffer to hold the command link, use I2C_CMD_LINK_STATIC_SIZE() to get its size
+ * @param size size of the buffer
+ *
+ * @return i2c command link handler, NULL if the buffer is too small
+ */
+i2c_cmd_handle_t i2c_cmd_link_create_static(uint8_t* buffer, uint32_t size);
+
 /**
  * @brief Queue command for I2C master to generate a start signal
  *        @note
@@ -360,6 +396,49 @@ esp_err_t i2c_master_stop(i2c_cmd_handle_t cmd_handle);
  */
 esp_err_t i2c_master_cmd_begin(i2c_port_t i2c_num, i2c_cmd_handle_t cmd_handle, TickType_t ticks_to_wait);
 
+/**
+ * @brief I2C master queue commands to be sent without blocking.
+ *        The queued transactions are sent one after the other by the I2C ISR, and done_cb is called
+ *        after each of them. A transaction that fails doesn't stop the following ones, except for a
+ *        timeout, after which all remaining queued transactions are completed with ESP_ERR_TIMEOUT.
+ *        i2c_master_cmd_begin() waits for the queued transactions to be done.
+ *        @note
+ *        Only call this function in I2C master mode.
+ *        The command link and the data buffers have to stay valid until done_cb is called.
+ *        If the interrupt is allocated with ESP_INTR_FLAG_IRAM, done_cb has to be placed in IRAM.
+ *
+ * @param i2c_num I2C port number
+ * @param cmd_handle I2C command handler
+ * @param done_cb callback called from the ISR when the transaction is done, can be NULL
+ * @param arg argument for done_cb
+ * @param ticks_to_wait maximum ticks to wait for a running i2c_master_cmd_begin() to return
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Parameter error
+ *     - ESP_ERR_INVALID_STATE I2C driver not installed or not in master mode.
+ *     - ESP_ERR_NO_MEM The queue of transactions is full.
+ *     - ESP_ERR_TIMEOUT Operation timeout because the bus is busy.
+ */
+esp_err_t i2c_master_cmd_queue(i2c_port_t i2c_num, i2c_cmd_handle_t cmd_handle, i2c_cmd_done_cb_t done_cb, void* arg, TickType_t ticks_to_wait);
+
+/**
+ * @brief I2C master wait for the transactions queued with i2c_master_cmd_queue() to be done.
+ *        If they are not done in time the bus is assumed to be stuck: the remaining transactions
+ *        are completed with ESP_ERR_TIMEOUT (done_cb is called from this task) and the I2C
+ *        hardware is reset.
+ *
+ * @param i2c_num I2C port number
+ * @param ticks_to_wait maximum wait ticks.
+ *
+ * @return
+ *     - ESP_OK All queued transactions are done
+ *     - ESP_ERR_INVALID_ARG Parameter error
+ *     - ESP_ERR_INVALID_STATE I2C driver not installed or not in master mode.
+ *     - ESP_ERR_TIMEOUT The queued transactions were aborted.
+ */
+esp_err_t i2c_master_cmd_queue_wait(i2c_port_t i2c_num, TickType_t ticks_to_wait);
+
 /**
  * @brief I2C slave write data to internal ringbuffer, when tx fifo empty, isr will fill the hardware
  *        fifo from the internal ringbuffer
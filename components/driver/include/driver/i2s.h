@@ -389,6 +389,74 @@ int i2s_read_bytes(i2s_port_t i2s_num, void *dest, size_t size, TickType_t ticks
  */
 esp_err_t i2s_read(i2s_port_t i2s_num, void *dest, size_t size, size_t *bytes_read, TickType_t ticks_to_wait);
 
+/**
+ * @brief Get direct access to the next I2S DMA buffer, without copying
+ *
+ * For I2S_MODE_TX this is the next buffer to be filled with data to send, for I2S_MODE_RX the
+ * next buffer filled with received data. If a previous i2s_write or i2s_read call used only
+ * part of a buffer, the remaining part of that buffer is returned.
+ *
+ * The buffer belongs to the caller until i2s_dma_buffer_release is called, which must be done
+ * from the same task. i2s_write/i2s_read calls in the same direction block until then.
+ *
+ * @param i2s_num         I2S_NUM_0, I2S_NUM_1
+ *
+ * @param dir             I2S_MODE_TX or I2S_MODE_RX
+ *
+ * @param[out] buf        Address of the DMA buffer
+ *
+ * @param[out] size       Size of the DMA buffer in bytes
+ *
+ * @param ticks_to_wait   Timeout in RTOS ticks to wait for a buffer to become available. Pass portMAX_DELAY for no timeout.
+ *
+ * @return
+ *     - ESP_OK                Success
+ *     - ESP_ERR_INVALID_ARG   Parameter error
+ *     - ESP_ERR_INVALID_STATE Driver not installed, or a buffer in this direction is already acquired
+ *     - ESP_ERR_TIMEOUT       No buffer became available in time
+ */
+esp_err_t i2s_dma_buffer_acquire(i2s_port_t i2s_num, i2s_mode_t dir, void **buf, size_t *size, TickType_t ticks_to_wait);
+
+/**
+ * @brief Return a DMA buffer obtained with i2s_dma_buffer_acquire to the driver
+ *
+ * A TX buffer is sent the next time the DMA reaches it, so it must be completely filled.
+ * A RX buffer is handed back to the DMA to be filled again.
+ *
+ * @param i2s_num         I2S_NUM_0, I2S_NUM_1
+ *
+ * @param dir             I2S_MODE_TX or I2S_MODE_RX
+ *
+ * @param buf             Buffer returned by i2s_dma_buffer_acquire
+ *
+ * @return
+ *     - ESP_OK                Success
+ *     - ESP_ERR_INVALID_ARG   Parameter error
+ *     - ESP_ERR_INVALID_STATE No buffer in this direction is acquired
+ */
+esp_err_t i2s_dma_buffer_release(i2s_port_t i2s_num, i2s_mode_t dir, void *buf);
+
+/**
+ * @brief Expand the number of bits per sample of the data at the start of a buffer, in place
+ *
+ * Produces the same layout as i2s_write_expand, and can be used to expand samples written to
+ * the first half of an acquired DMA buffer to fill the whole buffer. 16 to 32 bit expansion of
+ * a word aligned buffer is done a sample at a time instead of byte by byte.
+ *
+ * @param buf             Buffer, at least size * aim_bits / src_bits bytes long
+ *
+ * @param size            Size of the source data in bytes
+ *
+ * @param src_bits        Source audio bit
+ *
+ * @param aim_bits        Bit wanted, no more than 32, and must be greater than or equal to src_bits
+ *
+ * @return
+ *     - ESP_OK              Success
+ *     - ESP_ERR_INVALID_ARG Parameter error
+ */
+esp_err_t i2s_expand_in_place(void *buf, size_t size, size_t src_bits, size_t aim_bits);
+
 /**
  * @brief Write a single sample to the I2S DMA TX buffer.
  *
@@ -514,6 +582,48 @@ esp_err_t i2s_set_clk(i2s_port_t i2s_num, uint32_t rate, i2s_bits_per_sample_t b
  */
 esp_err_t i2s_set_adc_mode(adc_unit_t adc_unit, adc1_channel_t adc_channel);
 
+/**
+ * @brief Set built-in ADC mode for I2S DMA sampling several ADC channels in turn
+ *
+ * The channels of the pattern table are converted one after the other at the I2S sample rate,
+ * so the rate of each channel is the sample rate divided by the number of times it appears in
+ * the table. Use i2s_adc_demux to sort the data read from I2S by channel.
+ *
+ * @param adc_unit    SAR ADC unit index, only ADC_UNIT_1 is supported
+ * @param pattern     Pattern table, see adc_i2s_pattern_t
+ * @param pattern_len Number of entries in pattern, 1 to ADC_I2S_PATTERN_LEN_MAX
+ * @return
+ *     - ESP_OK              Success
+ *     - ESP_ERR_INVALID_ARG Parameter error
+ */
+esp_err_t i2s_set_adc_pattern(adc_unit_t adc_unit, const adc_i2s_pattern_t *pattern, int pattern_len);
+
+/**
+ * @brief Destination buffer of one ADC channel for i2s_adc_demux
+ */
+typedef struct {
+    uint16_t *buf;      /*!< Buffer for the raw 12-bit readings of the channel, NULL to drop them */
+    size_t size;        /*!< Size of buf, in readings */
+    size_t len;         /*!< Number of readings in buf, incremented by i2s_adc_demux */
+} i2s_adc_channel_buf_t;
+
+/**
+ * @brief Sort the samples read from I2S in ADC mode into a buffer per channel
+ *
+ * Works on data from i2s_read or directly on a buffer from i2s_dma_buffer_acquire. The readings
+ * are appended to the channel buffers in the order they were sampled, and can be converted to
+ * voltages with esp_adc_cal_raw_to_voltage_batch.
+ *
+ * @param data        Data read from I2S, 16 bits per sample
+ * @param size        Size of data in bytes, a multiple of 4
+ * @param channels    Array of ADC1_CHANNEL_MAX channel buffers, indexed by ADC1 channel
+ *
+ * @return
+ *     - Number of samples dropped because their channel buffer is NULL or full
+ *     - ESP_FAIL Parameter error
+ */
+int i2s_adc_demux(const void *data, size_t size, i2s_adc_channel_buf_t channels[ADC1_CHANNEL_MAX]);
+
 /**
  * @brief Start to use I2S built-in ADC mode
  * @note This function would acquire the lock of ADC to prevent the data getting corrupted
@@ -127,6 +127,24 @@ typedef struct {
     uint32_t freq_hz;                      /*!< LEDC timer frequency (Hz) */
 } ledc_timer_config_t;
 
+/**
+ * @brief Duty of one channel for ledc_set_duty_batch function
+ */
+typedef struct {
+    ledc_channel_t channel;         /*!< LEDC channel (0 - 7) */
+    uint32_t duty;                  /*!< LEDC channel duty, the range of duty setting is [0, (2**duty_resolution)] */
+    uint32_t hpoint;                /*!< LEDC channel hpoint value, the max value is 0xfffff */
+} ledc_channel_duty_t;
+
+/**
+ * @brief One step of a ramp table for ledc_set_fade_table_and_start function
+ */
+typedef struct {
+    uint32_t duty;                  /*!< Duty to fade to in this step of the ramp */
+    uint32_t scale;                 /*!< Duty change of each fade step, 0 to jump to the duty directly */
+    uint32_t cycle_num;             /*!< Change the duty every cycle_num PWM cycles (1 - 1023) */
+} ledc_fade_step_t;
+
 typedef intr_handle_t ledc_isr_handle_t;
 
 /**
@@ -467,6 +485,23 @@ esp_err_t ledc_fade_start(ledc_mode_t speed_mode, ledc_channel_t channel, ledc_f
  */
 esp_err_t ledc_set_duty_and_update(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t duty, uint32_t hpoint);
 
+/**
+ * @brief A thread-safe API to set the duty of several LEDC channels at once.
+ *        The duties of all channels are staged first and then started together, under a single lock,
+ *        so that each channel switches to its new duty at the next period of its timer.
+ *        Channels sharing a timer thus switch on the same PWM period.
+ * @note  If a fade operation is running in progress on one of the channels, this function waits until it has finished.
+ *
+ * @param speed_mode Select the LEDC speed_mode, high-speed mode and low-speed mode
+ * @param duties Array of channel duties, each channel may only appear once
+ * @param num Number of entries in duties
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Parameter error
+ */
+esp_err_t ledc_set_duty_batch(ledc_mode_t speed_mode, const ledc_channel_duty_t *duties, size_t num);
+
 /**
  * @brief A thread-safe API to set and start LEDC fade function, with a limited time.
  * @note  Call ledc_fade_func_install() once, before calling this function.
@@ -503,6 +538,28 @@ esp_err_t ledc_set_fade_time_and_start(ledc_mode_t speed_mode, ledc_channel_t ch
  *     - ESP_FAIL Fade function init error
  */
 esp_err_t ledc_set_fade_step_and_start(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t target_duty, uint32_t scale, uint32_t cycle_num, ledc_fade_mode_t fade_mode);
+
+/**
+ * @brief A thread-safe API to start a LEDC fade following a precomputed ramp table.
+ *        The steps of the table are faded through one after the other, the fade interrupt loads
+ *        the next step when the duty of the previous one is reached, without waking up any task.
+ * @note  Call ledc_fade_func_install() once before calling this function.
+ * @note  The table must be in internal memory, and must stay valid until the fade has finished.
+ * @note  If a fade operation is running in progress on that channel, the driver would not allow it to be stopped.
+ *        Other duty operations will have to wait until the fade operation has finished.
+ * @param speed_mode Select the LEDC speed_mode, high-speed mode and low-speed mode,
+ * @param channel LEDC channel index (0-7), select from ledc_channel_t
+ * @param table Ramp table, the fade starts from the current duty towards the duty of the first step
+ * @param table_len Number of steps in table
+ * @param fade_mode choose blocking or non-blocking mode
+ * @return
+ *     - ESP_ERR_INVALID_ARG Parameter error
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_STATE Fade function not installed.
+ *     - ESP_FAIL Fade function init error
+ */
+esp_err_t ledc_set_fade_table_and_start(ledc_mode_t speed_mode, ledc_channel_t channel, const ledc_fade_step_t *table, size_t table_len, ledc_fade_mode_t fade_mode);
+
 #ifdef __cplusplus
 }
 #endif
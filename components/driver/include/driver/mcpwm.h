@@ -226,6 +226,15 @@ typedef struct {
     mcpwm_counter_type_t counter_mode;  /*!<Set  type of MCPWM counter*/
 } mcpwm_config_t;
 
+/**
+ * @brief Duty cycle of one operator for mcpwm_set_duty_batch function
+ */
+typedef struct {
+    mcpwm_timer_t timer_num;         /*!<Timer number(0-2) of the operator*/
+    mcpwm_operator_t op_num;         /*!<Operator(MCPWMXA/MCPWMXB)*/
+    float duty;                      /*!<Duty cycle in %(i.e for 62.3% duty cycle, duty = 62.3)*/
+} mcpwm_duty_update_t;
+
 /**
  * @brief MCPWM config carrier structure
  */
@@ -322,6 +331,22 @@ esp_err_t mcpwm_set_duty(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, mcpwm_
  */
 esp_err_t mcpwm_set_duty_in_us(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, mcpwm_operator_t op_num, uint32_t duty);
 
+/**
+ * @brief Set duty cycle of several operators at once
+ *        The compare registers involved are frozen while the new duty cycles are written, and released
+ *        together afterwards, so that all of them take effect when their timer next reaches zero,
+ *        instead of some of them being applied one period earlier than the others.
+ *
+ * @param mcpwm_num set MCPWM unit(0-1)
+ * @param updates array of operator duty cycles
+ * @param num number of entries in updates
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Parameter error
+ */
+esp_err_t mcpwm_set_duty_batch(mcpwm_unit_t mcpwm_num, const mcpwm_duty_update_t *updates, size_t num);
+
 /**
  * @brief Set duty either active high or active low(out of phase/inverted)
  *        @note
@@ -12,6 +12,7 @@
 #include "soc/pcnt_struct.h"
 #include "soc/gpio_sig_map.h"
 #include "driver/gpio.h"
+#include "driver/timer.h"
 #include "esp_intr_alloc.h"
 
 #ifdef __cplusplus
@@ -392,6 +393,95 @@ void pcnt_isr_service_uninstall(void);
  */
 esp_err_t pcnt_isr_handler_remove(pcnt_unit_t unit);
 
+/**
+ * @brief Configure both channels of a PCNT unit to decode a quadrature encoder
+ *
+ * Every edge of both signals is counted (x4 decoding), the counter goes up when A leads B.
+ * The counter limits are set to limit and -limit, they should be set large enough
+ * for the limit events not to happen faster than they can be handled by the extended counter.
+ *
+ * @param unit PCNT unit number
+ * @param a_gpio_num GPIO number of the A signal
+ * @param b_gpio_num GPIO number of the B signal
+ * @param limit Limit of the 16-bit hardware counter (1 to 32767)
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Parameter error
+ */
+esp_err_t pcnt_quadrature_config(pcnt_unit_t unit, int a_gpio_num, int b_gpio_num, int16_t limit);
+
+/**
+ * @brief Extend the counter of a PCNT unit to 64 bits, and measure the frequency of the counted pulses
+ *
+ * The counter value is extended by the PCNT ISR service each time the counter reaches the high or low
+ * limit of the unit (enabling the PCNT_EVT_H_LIM and PCNT_EVT_L_LIM events).
+ * If a timer is given, the time of the limit events is read from it to measure the frequency.
+ * The timer should be configured to count up, and started, by the application.
+ *
+ * @note The PCNT ISR service should be installed first. The extended counter uses the
+ *       ISR handler of the unit, so pcnt_isr_handler_add() can't be used for the same unit.
+ *
+ * @param unit PCNT unit number, configured with a non-zero high or low limit
+ * @param group_num Timer group used to measure the frequency, TIMER_GROUP_MAX to only extend the counter
+ * @param timer_num Timer index in the timer group
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Parameter error
+ *     - ESP_ERR_INVALID_STATE ISR service not installed, already installed on the unit, or no limit configured
+ *     - ESP_ERR_NO_MEM No memory for the extended counter
+ */
+esp_err_t pcnt_ext_counter_install(pcnt_unit_t unit, timer_group_t group_num, timer_idx_t timer_num);
+
+/**
+ * @brief Stop extending the counter of a PCNT unit
+ *
+ * @param unit PCNT unit number
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Parameter error
+ *     - ESP_ERR_INVALID_STATE Extended counter not installed on the unit
+ */
+esp_err_t pcnt_ext_counter_uninstall(pcnt_unit_t unit);
+
+/**
+ * @brief Get the 64-bit counter value of a PCNT unit
+ *
+ * The value is the sum of the limits reached since pcnt_ext_counter_install(), plus the hardware counter.
+ * This function doesn't take a lock, so it can be called from any task at any rate.
+ *
+ * @note pcnt_counter_clear() only clears the hardware counter, not the limits already reached.
+ *
+ * @param unit PCNT unit number
+ * @param count Pointer to accept the counter value
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Parameter error
+ *     - ESP_ERR_INVALID_STATE Extended counter not installed on the unit
+ */
+esp_err_t pcnt_ext_counter_get_value(pcnt_unit_t unit, int64_t *count);
+
+/**
+ * @brief Get the frequency of the pulses counted by a PCNT unit
+ *
+ * The frequency is measured between the last two limit events, so it's updated every
+ * high (or low) limit counts. If the next limit event is overdue, it is estimated from
+ * the time since the last one, so it decays towards 0 when the pulses stop.
+ * The frequency is negative when the counter goes down.
+ *
+ * @param unit PCNT unit number
+ * @param freq_hz Pointer to accept the frequency in Hz, 0 until two limit events happened
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Parameter error
+ *     - ESP_ERR_INVALID_STATE Extended counter not installed on the unit, or installed without a timer
+ */
+esp_err_t pcnt_ext_counter_get_frequency(pcnt_unit_t unit, float *freq_hz);
+
 /**
  * @addtogroup pcnt-examples
  *
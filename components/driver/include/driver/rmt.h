@@ -160,6 +160,9 @@ typedef struct {
  *       In fact, item_num should be a multiple of translated_size, e.g. :
  *       When we convert each byte of uint8_t type data to rmt format data,
  *       the relation between item_num and translated_size should be `item_num = translated_size*8`.
+ *       While raw data remains, item_num should be equal to wanted_num, since the transmission ends
+ *       after the first memory block (or half block) that is not completely filled.
+ *       Use rmt_translator_get_context to get the context set by rmt_translator_set_context.
  */
 typedef void (*sample_to_rmt_t)(const void* src, rmt_item32_t* dest, size_t src_size, size_t wanted_num, size_t* translated_size, size_t* item_num);
 
@@ -747,6 +750,32 @@ esp_err_t rmt_get_ringbuf_handle(rmt_channel_t channel, RingbufHandle_t* buf_han
  */
 esp_err_t rmt_translator_init(rmt_channel_t channel, sample_to_rmt_t fn);
 
+/**
+ * @brief Set user context for the translator of specific channel
+ *
+ * @param channel RMT channel (0 - 7).
+ * @param context User context, passed to the translator through rmt_translator_get_context.
+ *
+ * @return
+ *     - ESP_FAIL Set context fail
+ *     - ESP_OK Set context success
+ */
+esp_err_t rmt_translator_set_context(rmt_channel_t channel, void *context);
+
+/**
+ * @brief Get the user context set by rmt_translator_set_context
+ *
+ * @note This function must only be called from the translator (sample_to_rmt_t), which is
+ *       called from the RMT interrupt when the data doesn't fit in the RMT memory block.
+ *
+ * @param item_num Address of the item_num argument of the translator
+ * @param context Returns the user context
+ *
+ * @return
+ *     - ESP_OK Get context success
+ */
+esp_err_t rmt_translator_get_context(const size_t *item_num, void **context);
+
 /**
  * @brief Translate uint8_t type of data into rmt format and send it out.
  *        Requires rmt_translator_init to init the translator first.
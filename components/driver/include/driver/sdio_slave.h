@@ -164,8 +164,8 @@ esp_err_t sdio_slave_recv_unregister_buf(sdio_slave_buf_handle_t handle);
  * @param handle Handle to the buffer ready to receive data.
  *
  * @return
- *     - ESP_ERR_INVALID_ARG    if invalid handle or the buffer is already in the queue. Only after the buffer is returened by
- *                              ``sdio_slave_recv`` can you load it again.
+ *     - ESP_ERR_INVALID_ARG    if invalid handle, the buffer is loaned, or the buffer is already in the queue. Only after
+ *                              the buffer is returened by ``sdio_slave_recv`` can you load it again.
  *     - ESP_OK if success
  */
 esp_err_t sdio_slave_recv_load_buf(sdio_slave_buf_handle_t handle);
@@ -196,6 +196,32 @@ esp_err_t sdio_slave_recv(sdio_slave_buf_handle_t* handle_ret, uint8_t **out_add
  */
 uint8_t* sdio_slave_recv_get_buf(sdio_slave_buf_handle_t handle, size_t *len_o);
 
+/** Loan a received buffer to a consumer of the data, e.g. wrapped in a custom pbuf handed to the network stack.
+ *
+ * Each loan is returned by ``sdio_slave_recv_loan_return``. When the last loan of a buffer is returned, the buffer is
+ * loaded to receive again, without copying the data or calling ``sdio_slave_recv_load_buf``.
+ *
+ * @param handle Handle of a buffer returned by ``sdio_slave_recv``.
+ *
+ * @return
+ *     - ESP_ERR_INVALID_ARG    if invalid handle or the buffer is in the queue waiting to receive data.
+ *     - ESP_OK if success
+ */
+esp_err_t sdio_slave_recv_loan(sdio_slave_buf_handle_t handle);
+
+/** Return a loan taken by ``sdio_slave_recv_loan``, loading the buffer to receive again if it was the last one.
+ *
+ * @note The buffer shouldn't be unregistered or loaded by ``sdio_slave_recv_load_buf`` while it's loaned.
+ *       Not to be called from an ISR.
+ *
+ * @param handle Handle of the loaned buffer.
+ *
+ * @return
+ *     - ESP_ERR_INVALID_ARG    if invalid handle or the buffer is not loaned.
+ *     - ESP_OK if success
+ */
+esp_err_t sdio_slave_recv_loan_return(sdio_slave_buf_handle_t handle);
+
 /*---------------------------------------------------------------------------
  *                  Send
  *--------------------------------------------------------------------------*/
@@ -223,6 +249,23 @@ esp_err_t sdio_slave_send_queue(uint8_t* addr, size_t len, void* arg, TickType_t
  */
 esp_err_t sdio_slave_send_get_finished(void** out_arg, TickType_t wait);
 
+/** Return the ownership of several finished transactions at once.
+ *
+ * Blocks until at least one transaction is finished, then returns the arguments of all finished transactions that fit
+ * in ``out_args``, in the order they were queued.
+ *
+ * @param out_args Output of the arguments of the finished transactions, should have room for ``max_num`` pointers.
+ * @param max_num Maximum number of transactions to return.
+ * @param out_num Output of the number of finished transactions returned. Set to NULL if unused.
+ * @param wait Time to wait if there's no finished sending transaction.
+ *
+ * @return
+ *     - ESP_ERR_INVALID_ARG if ``out_args`` is NULL or ``max_num`` is 0.
+ *     - ESP_ERR_TIMEOUT if no transaction finished.
+ *     - ESP_OK if success.
+ */
+esp_err_t sdio_slave_send_get_finished_batch(void** out_args, size_t max_num, size_t *out_num, TickType_t wait);
+
 /** Start a new sending transfer, and wait for it (blocked) to be finished.
  *
  * @param addr Start address of the buffer to send
@@ -110,6 +110,7 @@ typedef struct {
 #define SPI_TRANS_VARIABLE_CMD        (1<<5)  ///< Use the ``command_bits`` in ``spi_transaction_ext_t`` rather than default value in ``spi_device_interface_config_t``.
 #define SPI_TRANS_VARIABLE_ADDR       (1<<6)  ///< Use the ``address_bits`` in ``spi_transaction_ext_t`` rather than default value in ``spi_device_interface_config_t``.
 #define SPI_TRANS_VARIABLE_DUMMY      (1<<7)  ///< Use the ``dummy_bits`` in ``spi_transaction_ext_t`` rather than default value in ``spi_device_interface_config_t``.
+#define SPI_TRANS_NO_BOUNCE           (1<<8)  ///< Fail with ESP_ERR_INVALID_ARG instead of copying the data through a temporary buffer when a buffer can't be used by the DMA directly.
 
 /**
  * This structure describes one SPI transaction. The descriptor should not be modified until the transaction finishes.
@@ -266,11 +267,111 @@ esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *
  * @return
  *         - ESP_ERR_INVALID_ARG   if parameter is invalid
  *         - ESP_ERR_TIMEOUT       if there was no completed transaction before ticks_to_wait expired
+ *         - ESP_ERR_INVALID_STATE if the next result is a batch queued by ``spi_device_queue_trans_batch``
  *         - ESP_OK                on success
  */
 esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans_desc, TickType_t ticks_to_wait);
 
 
+/**
+ * @brief Queue a batch of SPI transactions for interrupt transaction execution. Get the result by ``spi_device_get_trans_batch_result``.
+ *
+ * The transactions are sent one after another, each with its own CS assertion and
+ * ``pre_cb``/``post_cb`` calls (e.g. to set a D/C line). The whole batch takes a single
+ * item in the queue of the device, and the SPI interrupt handler starts each transaction
+ * as soon as the previous one is done, without going through the queues. The task is only
+ * woken up once the whole batch is done. This saves a lot of CPU time when sending many
+ * small transactions, e.g. the commands and data of a display.
+ *
+ * @note The hardware still raises one interrupt per transaction. Transactions queued
+ *       to other devices are only sent once the whole batch is done.
+ *
+ * @param handle Device handle obtained using spi_host_add_dev
+ * @param trans_descs Array of pointers to the descriptions of the transactions to execute. The array
+ *                    and the descriptors should not be modified until the batch is returned by
+ *                    spi_device_get_trans_batch_result.
+ * @param count Number of transactions in the batch
+ * @param ticks_to_wait Ticks to wait until there's room in the queue; use portMAX_DELAY to
+ *                      never time out.
+ * @return
+ *         - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *         - ESP_ERR_TIMEOUT       if there was no room in the queue before ticks_to_wait expired
+ *         - ESP_ERR_NO_MEM        if allocating the batch or a DMA-capable temporary buffer failed
+ *         - ESP_ERR_INVALID_STATE if previous transactions are not finished
+ *         - ESP_OK                on success
+ */
+esp_err_t spi_device_queue_trans_batch(spi_device_handle_t handle, spi_transaction_t **trans_descs, int count, TickType_t ticks_to_wait);
+
+
+/**
+ * @brief Get the result of a batch of SPI transactions queued earlier by ``spi_device_queue_trans_batch``.
+ *
+ * Results are returned in the order the transactions and batches were queued. If the next result is a
+ * single transaction queued by ``spi_device_queue_trans``, it is left in the queue and
+ * ESP_ERR_INVALID_STATE is returned.
+ *
+ * @param handle Device handle obtained using spi_host_add_dev
+ * @param trans_descs Pointer to variable to hold the array of transactions passed to spi_device_queue_trans_batch
+ * @param count Pointer to variable to hold the number of transactions in the batch
+ * @param ticks_to_wait Ticks to wait until there's a returned item; use portMAX_DELAY to never time
+ *                      out.
+ * @return
+ *         - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *         - ESP_ERR_TIMEOUT       if there was no completed batch before ticks_to_wait expired
+ *         - ESP_ERR_INVALID_STATE if the next result is not a batch
+ *         - ESP_OK                on success
+ */
+esp_err_t spi_device_get_trans_batch_result(spi_device_handle_t handle, spi_transaction_t ***trans_descs, int *count, TickType_t ticks_to_wait);
+
+
+/**
+ * @brief Counters of the data copied through temporary DMA-capable buffers, see ``spi_device_get_bounce_stats``.
+ */
+typedef struct {
+    uint32_t tx_bounces;            ///< Number of tx buffers copied to a temporary buffer before being sent
+    uint32_t rx_bounces;            ///< Number of rx buffers received into a temporary buffer and copied afterwards
+    uint32_t shared_chunks;         ///< Number of temporary buffers taken from the shared DMA bounce pool (see ``esp_dma_bounce_init``), because no buffer of the bounce pool of the device was free or big enough
+    uint32_t heap_allocs;           ///< Number of temporary buffers allocated from the heap, because no buffer of the bounce pools was free or big enough
+} spi_device_bounce_stats_t;
+
+/**
+ * @brief Allocate a pool of DMA-capable buffers used to bounce the data of the device.
+ *
+ * When the bus uses DMA, buffers which are not DMA-capable (e.g. in PSRAM) or, for rx buffers,
+ * not 32-bit aligned are copied through a temporary DMA-capable buffer. By default, such a buffer
+ * is taken from the shared DMA bounce pool if there is one (see ``esp_dma_bounce_init``), or else
+ * allocated from the heap for each transaction. With a pool for the device, a free buffer of the pool
+ * which is big enough is used first.
+ *
+ * Transactions which should never be copied can set ``SPI_TRANS_NO_BOUNCE``, they fail instead.
+ *
+ * @note Call this when there are no transactions in flight for the device. The pool is freed
+ *       by ``spi_bus_remove_device``.
+ *
+ * @param handle Device handle obtained using spi_host_add_dev
+ * @param buffer_size Size of each buffer, in bytes. Rounded up to a multiple of 4. Note that a
+ *                    rx bounce buffer needs up to 4 bytes more than the data received.
+ * @param buffer_num Number of buffers (at most 32), 0 to free the pool.
+ * @return
+ *         - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *         - ESP_ERR_INVALID_STATE if buffers of the current pool are in use
+ *         - ESP_ERR_NO_MEM        if allocating the pool failed
+ *         - ESP_OK                on success
+ */
+esp_err_t spi_device_alloc_bounce_pool(spi_device_handle_t handle, size_t buffer_size, int buffer_num);
+
+/**
+ * @brief Get the counters of the data of the device copied through temporary buffers.
+ *
+ * @param handle Device handle obtained using spi_host_add_dev
+ * @param[out] stats Counters since the device was added
+ * @return
+ *         - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *         - ESP_OK                on success
+ */
+esp_err_t spi_device_get_bounce_stats(spi_device_handle_t handle, spi_device_bounce_stats_t *stats);
+
+
 /**
  * @brief Send a SPI transaction, wait for it to complete, and return the result
  *
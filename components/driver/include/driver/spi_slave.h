@@ -19,6 +19,7 @@
 #include "esp_err.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/ringbuf.h"
 #include "driver/spi_common.h"
 
 
@@ -183,6 +184,81 @@ esp_err_t spi_slave_get_trans_result(spi_host_device_t host, spi_slave_transacti
  */
 esp_err_t spi_slave_transmit(spi_host_device_t host, spi_slave_transaction_t *trans_desc, TickType_t ticks_to_wait);
 
+/**
+ * @brief Callback called for each segment filled by the ring reception, in interrupt context.
+ *
+ * @param data Data received. Only valid until the callback returns, the DMA reuses the memory afterwards.
+ * @param len Length of the data, in bytes
+ * @param arg The ``arg`` member of the ``spi_slave_ring_config_t``
+ */
+typedef void (*spi_slave_ring_cb_t)(const uint8_t *data, size_t len, void *arg);
+
+/**
+ * @brief Configuration of the continuous ring reception, see ``spi_slave_start_ring_rx``.
+ */
+typedef struct {
+    size_t segment_size;            ///< Size of each segment of the ring, in bytes. Multiple of 4, up to 4092.
+    int segment_num;                ///< Number of segments in the ring, at least 2
+    spi_slave_ring_cb_t on_segment; ///< Called in interrupt context for each filled segment, or NULL. Should be in IRAM when the driver is initialized with ESP_INTR_FLAG_IRAM.
+    void *arg;                      ///< User argument passed to ``on_segment``
+    RingbufHandle_t ringbuf;        ///< If not NULL, each filled segment is copied into this ring buffer (as an item of a no-split or allow-split buffer, or bytes of a byte buffer).
+} spi_slave_ring_config_t;
+
+/**
+ * @brief Counters of the ring reception, see ``spi_slave_get_ring_stats``.
+ */
+typedef struct {
+    uint32_t segments;              ///< Number of segments filled
+    uint32_t overflows;             ///< Number of times the DMA ran out of segments (the interrupt was too late to hand them back), data was lost
+    uint32_t dropped;               ///< Number of segments not copied because ``ringbuf`` was full
+} spi_slave_ring_stats_t;
+
+/**
+ * @brief Start receiving continuously into a ring of DMA buffers
+ *
+ * Instead of queueing a transaction for each CS assertion, the DMA fills a circular list of segments
+ * with all the data the master sends, without gaps between transactions. Each time a segment is
+ * full, it is handed to ``on_segment`` and/or copied into ``ringbuf``, and given back to the DMA.
+ * Data is delivered in whole segments only, choose the segment size according to the latency needed.
+ *
+ * The slave doesn't send any data (MISO) meanwhile, and transactions can't be queued until
+ * ``spi_slave_stop_ring_rx`` is called.
+ *
+ * @param host SPI peripheral that is acting as a slave, initialized with a DMA channel
+ * @param ring_config Configuration of the ring
+ * @return
+ *         - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *         - ESP_ERR_INVALID_STATE if the slave doesn't use DMA, transactions are in flight or the reception is already running
+ *         - ESP_ERR_NO_MEM        if out of memory
+ *         - ESP_OK                on success
+ */
+esp_err_t spi_slave_start_ring_rx(spi_host_device_t host, const spi_slave_ring_config_t *ring_config);
+
+/**
+ * @brief Stop the ring reception started by ``spi_slave_start_ring_rx``
+ *
+ * Data of a segment not completely filled is discarded.
+ *
+ * @param host SPI peripheral that is acting as a slave
+ * @return
+ *         - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *         - ESP_ERR_INVALID_STATE if the reception is not running
+ *         - ESP_OK                on success
+ */
+esp_err_t spi_slave_stop_ring_rx(spi_host_device_t host);
+
+/**
+ * @brief Get the counters of the running ring reception
+ *
+ * @param host SPI peripheral that is acting as a slave
+ * @param[out] stats Counters since the reception was started
+ * @return
+ *         - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *         - ESP_ERR_INVALID_STATE if the reception is not running
+ *         - ESP_OK                on success
+ */
+esp_err_t spi_slave_get_ring_stats(spi_host_device_t host, spi_slave_ring_stats_t *stats);
+
 
 #ifdef __cplusplus
 }
@@ -122,6 +122,19 @@ typedef intr_handle_t timer_isr_handle_t;
  */
 esp_err_t timer_get_counter_value(timer_group_t group_num, timer_idx_t timer_num, uint64_t* timer_val);
 
+/**
+ * @brief Read the counter value of hardware timer, in an ISR.
+ *
+ * @note This function is placed in IRAM and doesn't check its arguments, so it can be
+ *       called from an ISR allocated with ESP_INTR_FLAG_IRAM.
+ *
+ * @param group_num Timer group, 0 for TIMERG0 or 1 for TIMERG1
+ * @param timer_num Timer index, 0 for hw_timer[0] & 1 for hw_timer[1]
+ *
+ * @return Counter value of the timer
+ */
+uint64_t timer_group_get_counter_value_in_isr(timer_group_t group_num, timer_idx_t timer_num);
+
 /**
  * @brief Read the counter value of hardware timer, in unit of a given scale.
  *
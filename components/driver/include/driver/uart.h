@@ -152,6 +152,8 @@ typedef enum {
 typedef struct {
     uart_event_type_t type; /*!< UART event type */
     size_t size;            /*!< UART data size for UART_DATA event*/
+    bool timeout_flag;      /*!< UART data read timeout flag for UART_DATA event (no new data received during configured RX TOUT)*/
+                            /*!< If the event is caused by FIFO-full interrupt, then there will be no timeout flag before the next byte coming.*/
 } uart_event_t;
 
 typedef intr_handle_t uart_isr_handle_t;
@@ -627,6 +629,39 @@ int uart_write_bytes_with_break(uart_port_t uart_num, const char* src, size_t si
  */
 int uart_read_bytes(uart_port_t uart_num, uint8_t* buf, uint32_t length, TickType_t ticks_to_wait);
 
+/**
+ * @brief Get a pointer to data in the UART RX ring buffer, without copying it
+ *
+ * Returns the data received next, up to the end of the current ring buffer item, so fewer bytes
+ * than are buffered may be returned. The data stays valid until uart_read_release is called,
+ * which must be done from the same task. uart_read_bytes and uart_flush_input block until then.
+ *
+ * @param uart_num UART_NUM_0, UART_NUM_1 or UART_NUM_2
+ * @param[out] data Pointer to the received data, NULL if there is none
+ * @param max_length Maximum number of bytes to return
+ * @param ticks_to_wait Timeout, count in RTOS ticks
+ *
+ * @return
+ *     - (-1) Error
+ *     - 0 No data was received in time
+ *     - OTHERS (>0) The number of bytes at data
+ */
+int uart_read_acquire(uart_port_t uart_num, const uint8_t** data, uint32_t max_length, TickType_t ticks_to_wait);
+
+/**
+ * @brief Give the data returned by uart_read_acquire back to the RX ring buffer
+ *
+ * @param uart_num UART_NUM_0, UART_NUM_1 or UART_NUM_2
+ * @param consumed Number of bytes that have been processed, at most the number returned by
+ *                 uart_read_acquire. The rest is returned again by the next read.
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Parameter error
+ *     - ESP_ERR_INVALID_STATE No data is acquired
+ */
+esp_err_t uart_read_release(uart_port_t uart_num, uint32_t consumed);
+
 /**
  * @brief Alias of uart_flush_input.
  *        UART ring buffer flush. This will discard all data in the UART RX buffer.
@@ -842,6 +877,76 @@ esp_err_t uart_set_wakeup_threshold(uart_port_t uart_num, int wakeup_threshold);
  */
 esp_err_t uart_get_wakeup_threshold(uart_port_t uart_num, int* out_wakeup_threshold);
 
+/**
+ * @brief UART DMA (UHCI) mode configuration
+ */
+typedef struct {
+    int rx_dma_buf_size;        /*!< Size of the circular DMA RX buffer in bytes, at least 4 * 4 bytes. It is split into
+                                     descriptors of at most 4092 bytes, and at least 4 of them */
+    int tx_dma_buf_size;        /*!< Size of the DMA TX buffer in bytes, the data is sent through it in pieces of this size */
+    uint16_t rx_idle_thresh;    /*!< Number of bit periods the RX line must stay idle to end the current DMA RX
+                                     descriptor early, so a partial packet is delivered. 1 .. 1023 */
+    int intr_alloc_flags;       /*!< Flags used to allocate the UHCI interrupt, see esp_intr_alloc.h. ESP_INTR_FLAG_IRAM is not supported */
+} uart_dma_config_t;
+
+/**
+ * @brief Move the data of a UART through DMA instead of byte by byte in the UART interrupt
+ *
+ * One of the two UHCI controllers is attached to the UART. Received data is written by DMA
+ * into a circular buffer of descriptors. Full descriptors, and partially filled ones when
+ * the RX line has been idle for rx_idle_thresh bit periods, are copied to the RX ring buffer
+ * in one piece, so uart_read_bytes and the UART_DATA events work as before. While the cache is
+ * disabled, e.g. during flash operations, reception continues into the DMA buffer.
+ *
+ * uart_write_bytes sends the data by DMA and returns once it has been handed to the UART,
+ * without using the TX ring buffer. uart_write_bytes_with_break still uses the TX FIFO.
+ *
+ * @note Pattern detection and RS485 modes are not supported in DMA mode.
+ * @note Call this function after uart_driver_install and before any data is written.
+ *
+ * @param uart_num UART_NUM_0, UART_NUM_1 or UART_NUM_2
+ * @param dma_config DMA mode configuration
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Parameter error
+ *     - ESP_ERR_INVALID_STATE Driver not installed, or DMA mode already enabled
+ *     - ESP_ERR_NOT_FOUND Both UHCI controllers are used by other UARTs
+ *     - ESP_ERR_NO_MEM Out of memory
+ */
+esp_err_t uart_enable_dma(uart_port_t uart_num, const uart_dma_config_t *dma_config);
+
+/**
+ * @brief Go back from DMA mode to moving the data in the UART interrupt
+ *
+ * Data that is still in the DMA RX buffer is discarded. uart_driver_delete calls this function
+ * if DMA mode is enabled.
+ *
+ * @param uart_num UART_NUM_0, UART_NUM_1 or UART_NUM_2
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Parameter error
+ *     - ESP_ERR_INVALID_STATE DMA mode is not enabled
+ */
+esp_err_t uart_disable_dma(uart_port_t uart_num);
+
+/**
+ * @brief Get the number of times DMA reception has stalled in DMA mode
+ *
+ * Reception stalls when all DMA RX descriptors are full because the RX ring buffer is not read
+ * fast enough. The UART RX FIFO then fills up, and data is lost unless hardware flow control is used.
+ *
+ * @param uart_num UART_NUM_0, UART_NUM_1 or UART_NUM_2
+ * @param[out] overflows Number of stalls since DMA mode was enabled
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Parameter error
+ *     - ESP_ERR_INVALID_STATE DMA mode is not enabled
+ */
+esp_err_t uart_get_dma_rx_overflows(uart_port_t uart_num, uint32_t *overflows);
+
 #ifdef __cplusplus
 }
 #endif
@@ -22,6 +22,7 @@
 #include "driver/ledc.h"
 #include "soc/ledc_reg.h"
 #include "soc/ledc_struct.h"
+#include "soc/soc_memory_layout.h"
 #include "esp_log.h"
 
 static const char* LEDC_TAG = "ledc";
@@ -41,6 +42,9 @@ typedef struct {
     int cycle_num;
     int scale;
     ledc_fade_mode_t mode;
+    const ledc_fade_step_t *table;  /* ramp table of ledc_set_fade_table_and_start, in internal memory */
+    uint32_t table_len;
+    uint32_t table_idx;             /* next step of the ramp table */
     xSemaphoreHandle ledc_fade_sem;
     xSemaphoreHandle ledc_fade_mux;
 #if CONFIG_SPIRAM_USE_MALLOC
@@ -127,7 +131,7 @@ static void _ledc_op_lock_release(ledc_mode_t mode, ledc_channel_t channel)
     }
 }
 
-static int ledc_get_max_duty(ledc_mode_t speed_mode, ledc_channel_t channel)
+static IRAM_ATTR int ledc_get_max_duty(ledc_mode_t speed_mode, ledc_channel_t channel)
 {
     // The arguments are checked before internally calling this function.
     int timer_sel = LEDC.channel_group[speed_mode].channel[channel].conf0.timer_sel;
@@ -415,6 +419,44 @@ esp_err_t ledc_set_duty(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t
     return ESP_OK;
 }
 
+esp_err_t ledc_set_duty_batch(ledc_mode_t speed_mode, const ledc_channel_duty_t *duties, size_t num)
+{
+    LEDC_ARG_CHECK(speed_mode < LEDC_SPEED_MODE_MAX, "speed_mode");
+    LEDC_ARG_CHECK(duties != NULL && num > 0, "duties");
+    uint32_t channels = 0;
+    for (int i = 0; i < num; i++) {
+        LEDC_ARG_CHECK(duties[i].channel < LEDC_CHANNEL_MAX && !(channels & BIT(duties[i].channel)), "channel");
+        LEDC_ARG_CHECK(duties[i].duty <= ledc_get_max_duty(speed_mode, duties[i].channel), "duty");
+        LEDC_ARG_CHECK(duties[i].hpoint <= LEDC_HPOINT_VAL_MAX, "hpoint");
+        channels |= BIT(duties[i].channel);
+    }
+    /* The channel configuration should not be changed before the fade operation is done.
+       Wait for the channels in ascending order, so that concurrent batches can't deadlock. */
+    for (int channel = 0; channel < LEDC_CHANNEL_MAX; channel++) {
+        if (channels & BIT(channel)) {
+            _ledc_fade_hw_acquire(speed_mode, channel);
+        }
+    }
+    portENTER_CRITICAL(&ledc_spinlock);
+    for (int i = 0; i < num; i++) {
+        ledc_duty_config(speed_mode, duties[i].channel, duties[i].hpoint, duties[i].duty << 4, 1, 1, 1, 0);
+    }
+    /* The new duty is only latched at the next period once duty_start is set, so start all channels
+       after staging the duty of every channel, for the updates to land on the same period. */
+    for (int i = 0; i < num; i++) {
+        LEDC.channel_group[speed_mode].channel[duties[i].channel].conf0.sig_out_en = 1;
+        LEDC.channel_group[speed_mode].channel[duties[i].channel].conf1.duty_start = 1;
+        ledc_ls_channel_update(speed_mode, duties[i].channel);
+    }
+    portEXIT_CRITICAL(&ledc_spinlock);
+    for (int channel = 0; channel < LEDC_CHANNEL_MAX; channel++) {
+        if (channels & BIT(channel)) {
+            _ledc_fade_hw_release(speed_mode, channel);
+        }
+    }
+    return ESP_OK;
+}
+
 uint32_t ledc_get_duty(ledc_mode_t speed_mode, ledc_channel_t channel)
 {
     LEDC_ARG_CHECK(speed_mode < LEDC_SPEED_MODE_MAX, "speed_mode");
@@ -472,6 +514,30 @@ uint32_t ledc_get_freq(ledc_mode_t speed_mode, ledc_timer_t timer_num)
     return freq;
 }
 
+// Configure the hardware to fade to the next step of the ramp table, called with ledc_spinlock held
+static IRAM_ATTR void _ledc_fade_table_next(ledc_mode_t speed_mode, ledc_channel_t channel)
+{
+    ledc_fade_t *fade = s_ledc_fade_rec[speed_mode][channel];
+    const ledc_fade_step_t *step = &fade->table[fade->table_idx++];
+    uint32_t duty_cur = LEDC.channel_group[speed_mode].channel[channel].duty_rd.duty_read >> LEDC_DUTY_DECIMAL_BIT_NUM;
+    // When duty == max_duty, meanwhile, if scale == 1 and fade_down == 1, counter would overflow.
+    if (duty_cur == ledc_get_max_duty(speed_mode, channel)) {
+        duty_cur -= 1;
+    }
+    fade->target_duty = step->duty;
+    fade->cycle_num = step->cycle_num;
+    fade->scale = step->scale;
+    fade->direction = (step->duty < duty_cur) ? LEDC_DUTY_DIR_DECREASE : LEDC_DUTY_DIR_INCREASE;
+    int delta = (step->duty < duty_cur) ? duty_cur - step->duty : step->duty - duty_cur;
+    int step_num = (step->scale > 0) ? delta / step->scale : 0;
+    step_num = step_num > LEDC_STEP_NUM_MAX ? LEDC_STEP_NUM_MAX : step_num;
+    if (step_num > 0) {
+        ledc_duty_config(speed_mode, channel, LEDC_VAL_NO_CHANGE, duty_cur << LEDC_DUTY_DECIMAL_BIT_NUM, fade->direction, step_num, step->cycle_num, step->scale);
+    } else {
+        ledc_duty_config(speed_mode, channel, LEDC_VAL_NO_CHANGE, step->duty << LEDC_DUTY_DECIMAL_BIT_NUM, fade->direction, 0, 1, 0);
+    }
+}
+
 void IRAM_ATTR ledc_fade_isr(void* arg)
 {
     int channel;
@@ -492,6 +558,11 @@ void IRAM_ATTR ledc_fade_isr(void* arg)
             }
             uint32_t duty_cur = LEDC.channel_group[speed_mode].channel[channel].duty_rd.duty_read >> LEDC_DUTY_DECIMAL_BIT_NUM;
             if (duty_cur == s_ledc_fade_rec[speed_mode][channel]->target_duty) {
+                if (s_ledc_fade_rec[speed_mode][channel]->table_idx < s_ledc_fade_rec[speed_mode][channel]->table_len) {
+                    _ledc_fade_table_next(speed_mode, channel);
+                    LEDC.channel_group[speed_mode].channel[channel].conf1.duty_start = 1;
+                    continue;
+                }
                 xSemaphoreGiveFromISR(s_ledc_fade_rec[speed_mode][channel]->ledc_fade_sem, &HPTaskAwoken);
                 if (HPTaskAwoken == pdTRUE) {
                     portYIELD_FROM_ISR();
@@ -596,6 +667,7 @@ static esp_err_t _ledc_set_fade_with_step(ledc_mode_t speed_mode, ledc_channel_t
     s_ledc_fade_rec[speed_mode][channel]->target_duty = target_duty;
     s_ledc_fade_rec[speed_mode][channel]->cycle_num = cycle_num;
     s_ledc_fade_rec[speed_mode][channel]->scale = scale;
+    s_ledc_fade_rec[speed_mode][channel]->table_len = 0;
     int step_num = 0;
     int dir = LEDC_DUTY_DIR_DECREASE;
     if (scale > 0) {
@@ -789,3 +861,32 @@ esp_err_t ledc_set_fade_step_and_start(ledc_mode_t speed_mode, ledc_channel_t ch
     _ledc_op_lock_release(speed_mode, channel);
     return ESP_OK;
 }
+
+esp_err_t ledc_set_fade_table_and_start(ledc_mode_t speed_mode, ledc_channel_t channel, const ledc_fade_step_t *table, size_t table_len, ledc_fade_mode_t fade_mode)
+{
+    LEDC_ARG_CHECK(speed_mode < LEDC_SPEED_MODE_MAX, "speed_mode");
+    LEDC_ARG_CHECK(channel < LEDC_CHANNEL_MAX, "channel");
+    LEDC_ARG_CHECK(fade_mode < LEDC_FADE_MAX, "fade_mode");
+    LEDC_ARG_CHECK(table != NULL && table_len > 0 && esp_ptr_internal(table), "table");
+    for (int i = 0; i < table_len; i++) {
+        LEDC_ARG_CHECK(table[i].duty <= ledc_get_max_duty(speed_mode, channel), "table duty");
+        LEDC_ARG_CHECK(table[i].scale <= LEDC_DUTY_SCALE_HSCH0_V, "table scale");
+        LEDC_ARG_CHECK((table[i].cycle_num > 0) && (table[i].cycle_num <= LEDC_DUTY_CYCLE_HSCH0_V), "table cycle_num");
+    }
+    LEDC_CHECK(ledc_fade_channel_init_check(speed_mode, channel) == ESP_OK , LEDC_FADE_INIT_ERROR_STR, ESP_FAIL);
+    _ledc_op_lock_acquire(speed_mode, channel);
+    _ledc_fade_hw_acquire(speed_mode, channel);
+    portENTER_CRITICAL(&ledc_spinlock);
+    s_ledc_fade_rec[speed_mode][channel]->speed_mode = speed_mode;
+    s_ledc_fade_rec[speed_mode][channel]->table = table;
+    s_ledc_fade_rec[speed_mode][channel]->table_len = table_len;
+    s_ledc_fade_rec[speed_mode][channel]->table_idx = 0;
+    _ledc_fade_table_next(speed_mode, channel);
+    portEXIT_CRITICAL(&ledc_spinlock);
+    _ledc_fade_start(speed_mode, channel, fade_mode);
+    if (fade_mode == LEDC_FADE_WAIT_DONE) {
+        _ledc_fade_hw_release(speed_mode, channel);
+    }
+    _ledc_op_lock_release(speed_mode, channel);
+    return ESP_OK;
+}
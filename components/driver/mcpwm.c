@@ -169,6 +169,41 @@ esp_err_t mcpwm_set_duty(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, mcpwm_
     portEXIT_CRITICAL(&mcpwm_spinlock);
     return ESP_OK;
 }
+esp_err_t mcpwm_set_duty_batch(mcpwm_unit_t mcpwm_num, const mcpwm_duty_update_t *updates, size_t num)
+{
+    uint32_t timers = 0;
+    MCPWM_CHECK(mcpwm_num < MCPWM_UNIT_MAX, MCPWM_UNIT_NUM_ERROR, ESP_ERR_INVALID_ARG);
+    MCPWM_CHECK(updates != NULL, "MCPWM UPDATES ERROR", ESP_ERR_INVALID_ARG);
+    for (int i = 0; i < num; i++) {
+        MCPWM_CHECK(updates[i].timer_num < MCPWM_TIMER_MAX, MCPWM_TIMER_ERROR, ESP_ERR_INVALID_ARG);
+        MCPWM_CHECK(updates[i].op_num < MCPWM_OPR_MAX, MCPWM_OP_ERROR, ESP_ERR_INVALID_ARG);
+        timers |= BIT(updates[i].timer_num);
+    }
+    portENTER_CRITICAL(&mcpwm_spinlock);
+    // Freeze the compare registers, so that no update happens while only some of them are written
+    for (int timer_num = 0; timer_num < MCPWM_TIMER_MAX; timer_num++) {
+        if (timers & BIT(timer_num)) {
+            MCPWM[mcpwm_num]->channel[timer_num].cmpr_cfg.a_upmethod = BIT(3);
+            MCPWM[mcpwm_num]->channel[timer_num].cmpr_cfg.b_upmethod = BIT(3);
+        }
+    }
+    for (int i = 0; i < num; i++) {
+        uint32_t set_duty = (MCPWM[mcpwm_num]->timer[updates[i].timer_num].period.period) * (updates[i].duty) / 100;
+        MCPWM[mcpwm_num]->channel[updates[i].timer_num].cmpr_value[updates[i].op_num].cmpr_val = set_duty;
+    }
+    // Update both compare registers of an operator with a single write, on the next TEZ
+    for (int timer_num = 0; timer_num < MCPWM_TIMER_MAX; timer_num++) {
+        if (timers & BIT(timer_num)) {
+            typeof(MCPWM[mcpwm_num]->channel[timer_num].cmpr_cfg) cmpr_cfg = MCPWM[mcpwm_num]->channel[timer_num].cmpr_cfg;
+            cmpr_cfg.a_upmethod = BIT(0);
+            cmpr_cfg.b_upmethod = BIT(0);
+            MCPWM[mcpwm_num]->channel[timer_num].cmpr_cfg.val = cmpr_cfg.val;
+        }
+    }
+    portEXIT_CRITICAL(&mcpwm_spinlock);
+    return ESP_OK;
+}
+
 esp_err_t mcpwm_set_duty_in_us(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, mcpwm_operator_t op_num, uint32_t duty)
 {
     MCPWM_CHECK(mcpwm_num < MCPWM_UNIT_MAX, MCPWM_UNIT_NUM_ERROR, ESP_ERR_INVALID_ARG);
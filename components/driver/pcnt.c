@@ -13,6 +13,7 @@
 // limitations under the License.
 #include "esp_log.h"
 #include "esp_intr_alloc.h"
+#include "esp_heap_caps.h"
 #include "driver/pcnt.h"
 #include "driver/periph_ctrl.h"
 
@@ -40,10 +41,28 @@ typedef struct{
     void* args;              /*!< isr function args */
 } pcnt_isr_func_t;
 
+/* State of the extended counter of a unit, updated by the ISR and read without locks.
+   The ISR makes seq odd while it updates the other members, readers retry until they
+   get the same even seq before and after reading them. */
+typedef struct {
+    volatile uint32_t seq;
+    volatile int64_t accum;                 /*!< sum of the limits reached */
+    volatile uint32_t event_num;            /*!< number of limit events, saturated at 2 */
+    volatile int32_t last_event_count;      /*!< limit reached by the last event */
+    volatile uint64_t last_event_time;      /*!< timer value at the last limit event */
+    volatile uint64_t prev_event_time;      /*!< timer value at the limit event before */
+    pcnt_unit_t unit;
+    int16_t h_lim;
+    int16_t l_lim;
+    timer_group_t timer_group;
+    timer_idx_t timer_idx;
+} pcnt_ext_counter_t;
+
 static pcnt_isr_func_t *pcnt_isr_func = NULL;
 static pcnt_isr_handle_t pcnt_isr_service = NULL;
 static portMUX_TYPE pcnt_spinlock = portMUX_INITIALIZER_UNLOCKED;
 static const char* PCNT_TAG = "pcnt";
+static pcnt_ext_counter_t *pcnt_ext_counter[PCNT_UNIT_MAX] = {0};
 
 esp_err_t pcnt_unit_config(const pcnt_config_t *pcnt_config)
 {
@@ -364,3 +383,167 @@ void pcnt_isr_service_uninstall(void)
     pcnt_isr_service = NULL;
     PCNT_EXIT_CRITICAL(&pcnt_spinlock);
 }
+
+esp_err_t pcnt_quadrature_config(pcnt_unit_t unit, int a_gpio_num, int b_gpio_num, int16_t limit)
+{
+    PCNT_CHECK(limit > 0, PCNT_LIMT_VAL_ERR_STR, ESP_ERR_INVALID_ARG);
+    pcnt_config_t pcnt_config = {
+        .pulse_gpio_num = a_gpio_num,
+        .ctrl_gpio_num = b_gpio_num,
+        .lctrl_mode = PCNT_MODE_REVERSE,
+        .hctrl_mode = PCNT_MODE_KEEP,
+        .pos_mode = PCNT_COUNT_DEC,
+        .neg_mode = PCNT_COUNT_INC,
+        .counter_h_lim = limit,
+        .counter_l_lim = -limit,
+        .unit = unit,
+        .channel = PCNT_CHANNEL_0,
+    };
+    esp_err_t ret = pcnt_unit_config(&pcnt_config);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    /*Channel 1 counts the edges of B, in the same direction as channel 0*/
+    pcnt_config.pulse_gpio_num = b_gpio_num;
+    pcnt_config.ctrl_gpio_num = a_gpio_num;
+    pcnt_config.pos_mode = PCNT_COUNT_INC;
+    pcnt_config.neg_mode = PCNT_COUNT_DEC;
+    pcnt_config.channel = PCNT_CHANNEL_1;
+    return pcnt_unit_config(&pcnt_config);
+}
+
+static void IRAM_ATTR pcnt_ext_counter_isr(void *arg)
+{
+    pcnt_ext_counter_t *ext = (pcnt_ext_counter_t *) arg;
+    uint32_t status = PCNT.status_unit[ext->unit].val;
+    int32_t delta;
+    if (status & PCNT_STATUS_H_LIM_M) {
+        delta = ext->h_lim;
+    } else if (status & PCNT_STATUS_L_LIM_M) {
+        delta = ext->l_lim;
+    } else {
+        return;
+    }
+    uint64_t now = (ext->timer_group < TIMER_GROUP_MAX) ? timer_group_get_counter_value_in_isr(ext->timer_group, ext->timer_idx) : 0;
+
+    ext->seq++;
+    ext->accum += delta;
+    ext->prev_event_time = ext->last_event_time;
+    ext->last_event_time = now;
+    ext->last_event_count = delta;
+    if (ext->event_num < 2) {
+        ext->event_num++;
+    }
+    /*Clear the interrupt before seq is even again, so readers never see it pending after accum is updated*/
+    PCNT.int_clr.val = BIT(ext->unit);
+    ext->seq++;
+}
+
+esp_err_t pcnt_ext_counter_install(pcnt_unit_t unit, timer_group_t group_num, timer_idx_t timer_num)
+{
+    PCNT_CHECK(unit < PCNT_UNIT_MAX, PCNT_UNIT_ERR_STR, ESP_ERR_INVALID_ARG);
+    PCNT_CHECK(group_num <= TIMER_GROUP_MAX && timer_num < TIMER_MAX, "PCNT timer error", ESP_ERR_INVALID_ARG);
+    PCNT_CHECK(pcnt_isr_func != NULL, "ISR service is not installed, call pcnt_install_isr_service() first", ESP_ERR_INVALID_STATE);
+    PCNT_CHECK(pcnt_ext_counter[unit] == NULL, "extended counter already installed", ESP_ERR_INVALID_STATE);
+    int16_t h_lim, l_lim;
+    pcnt_get_event_value(unit, PCNT_EVT_H_LIM, &h_lim);
+    pcnt_get_event_value(unit, PCNT_EVT_L_LIM, &l_lim);
+    PCNT_CHECK(h_lim > 0 || l_lim < 0, "PCNT limits not configured", ESP_ERR_INVALID_STATE);
+
+    /*Accessed from the ISR, which may run with the cache disabled*/
+    pcnt_ext_counter_t *ext = heap_caps_calloc(1, sizeof(pcnt_ext_counter_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    PCNT_CHECK(ext != NULL, "no memory for extended counter", ESP_ERR_NO_MEM);
+    ext->unit = unit;
+    ext->h_lim = h_lim;
+    ext->l_lim = l_lim;
+    ext->timer_group = group_num;
+    ext->timer_idx = timer_num;
+    pcnt_ext_counter[unit] = ext;
+
+    if (h_lim > 0) {
+        pcnt_event_enable(unit, PCNT_EVT_H_LIM);
+    }
+    if (l_lim < 0) {
+        pcnt_event_enable(unit, PCNT_EVT_L_LIM);
+    }
+    return pcnt_isr_handler_add(unit, pcnt_ext_counter_isr, ext);
+}
+
+esp_err_t pcnt_ext_counter_uninstall(pcnt_unit_t unit)
+{
+    PCNT_CHECK(unit < PCNT_UNIT_MAX, PCNT_UNIT_ERR_STR, ESP_ERR_INVALID_ARG);
+    PCNT_CHECK(pcnt_ext_counter[unit] != NULL, "extended counter not installed", ESP_ERR_INVALID_STATE);
+    pcnt_isr_handler_remove(unit);
+    pcnt_event_disable(unit, PCNT_EVT_H_LIM);
+    pcnt_event_disable(unit, PCNT_EVT_L_LIM);
+    free(pcnt_ext_counter[unit]);
+    pcnt_ext_counter[unit] = NULL;
+    return ESP_OK;
+}
+
+esp_err_t pcnt_ext_counter_get_value(pcnt_unit_t unit, int64_t *count)
+{
+    PCNT_CHECK(unit < PCNT_UNIT_MAX, PCNT_UNIT_ERR_STR, ESP_ERR_INVALID_ARG);
+    PCNT_CHECK(count != NULL, PCNT_ADDRESS_ERR_STR, ESP_ERR_INVALID_ARG);
+    pcnt_ext_counter_t *ext = pcnt_ext_counter[unit];
+    PCNT_CHECK(ext != NULL, "extended counter not installed", ESP_ERR_INVALID_STATE);
+
+    uint32_t seq;
+    int64_t value;
+    while (1) {
+        seq = ext->seq;
+        value = ext->accum;
+        /*A limit reached but not handled by the ISR yet has already reset the hardware counter*/
+        uint32_t pending = PCNT.int_raw.val & BIT(unit);
+        int16_t cnt_val = (int16_t) PCNT.cnt_unit[unit].cnt_val;
+        uint32_t status = PCNT.status_unit[unit].val;
+        if (pending != (PCNT.int_raw.val & BIT(unit))) {
+            continue;   /*The limit may have been reached before or after reading the hardware counter*/
+        }
+        if ((seq & 1) || seq != ext->seq) {
+            continue;   /*Updated by the ISR while reading*/
+        }
+        if (pending && (status & PCNT_STATUS_H_LIM_M)) {
+            value += ext->h_lim;
+        } else if (pending && (status & PCNT_STATUS_L_LIM_M)) {
+            value += ext->l_lim;
+        }
+        *count = value + cnt_val;
+        return ESP_OK;
+    }
+}
+
+esp_err_t pcnt_ext_counter_get_frequency(pcnt_unit_t unit, float *freq_hz)
+{
+    PCNT_CHECK(unit < PCNT_UNIT_MAX, PCNT_UNIT_ERR_STR, ESP_ERR_INVALID_ARG);
+    PCNT_CHECK(freq_hz != NULL, PCNT_ADDRESS_ERR_STR, ESP_ERR_INVALID_ARG);
+    pcnt_ext_counter_t *ext = pcnt_ext_counter[unit];
+    PCNT_CHECK(ext != NULL && ext->timer_group < TIMER_GROUP_MAX, "extended counter not installed with a timer", ESP_ERR_INVALID_STATE);
+
+    uint32_t seq, event_num;
+    int32_t count;
+    uint64_t last_time, prev_time;
+    do {
+        seq = ext->seq;
+        event_num = ext->event_num;
+        count = ext->last_event_count;
+        last_time = ext->last_event_time;
+        prev_time = ext->prev_event_time;
+    } while ((seq & 1) || seq != ext->seq);
+    if (event_num < 2) {
+        *freq_hz = 0;
+        return ESP_OK;
+    }
+
+    uint64_t now;
+    timer_config_t timer_config;
+    timer_get_counter_value(ext->timer_group, ext->timer_idx, &now);
+    timer_get_config(ext->timer_group, ext->timer_idx, &timer_config);
+    uint64_t period = last_time - prev_time;
+    if (now - last_time > period) {
+        /*The next limit event is overdue, the pulses slowed down or stopped*/
+        period = now - last_time;
+    }
+    *freq_hz = (float) count * (TIMER_BASE_CLK / timer_config.divider) / period;
+    return ESP_OK;
+}
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 #include <esp_types.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdlib.h>
 #include "freertos/FreeRTOS.h"
@@ -82,6 +83,7 @@ typedef struct {
     rmt_item32_t* tx_buf;
     RingbufHandle_t rx_buf;
     sample_to_rmt_t sample_to_rmt;
+    void* tx_context;
     size_t sample_size_remain;
     const uint8_t *sample_cur;
 } rmt_obj_t;
@@ -636,6 +638,7 @@ static void IRAM_ATTR rmt_driver_isr_default(void* arg)
                     } else {
                         p_rmt->sample_cur = NULL;
                         p_rmt->translator = false;
+                        p_rmt->tx_len_rem = 0;
                     }
                 }
                 const rmt_item32_t* pdata = p_rmt->tx_data;
@@ -888,12 +891,30 @@ esp_err_t rmt_translator_init(rmt_channel_t channel, sample_to_rmt_t fn)
         }
     }
     p_rmt_obj[channel]->sample_to_rmt = fn;
+    p_rmt_obj[channel]->tx_context = NULL;
     p_rmt_obj[channel]->sample_size_remain = 0;
     p_rmt_obj[channel]->sample_cur = NULL;
     ESP_LOGD(RMT_TAG, "RMT translator init done");
     return ESP_OK;
 }
 
+esp_err_t rmt_translator_set_context(rmt_channel_t channel, void *context)
+{
+    RMT_CHECK(channel < RMT_CHANNEL_MAX, RMT_CHANNEL_ERROR_STR, ESP_ERR_INVALID_ARG);
+    RMT_CHECK(p_rmt_obj[channel] != NULL, RMT_DRIVER_ERROR_STR, ESP_FAIL);
+    p_rmt_obj[channel]->tx_context = context;
+    return ESP_OK;
+}
+
+esp_err_t IRAM_ATTR rmt_translator_get_context(const size_t *item_num, void **context)
+{
+    //item_num always points to tx_len_rem of the channel, which identifies the channel
+    //without changing the signature of the translator.
+    rmt_obj_t *p_rmt = (rmt_obj_t *) ((const uint8_t *) item_num - offsetof(rmt_obj_t, tx_len_rem));
+    *context = p_rmt->tx_context;
+    return ESP_OK;
+}
+
 esp_err_t rmt_write_sample(rmt_channel_t channel, const uint8_t *src, size_t src_size, bool wait_tx_done)
 {
     RMT_CHECK(channel < RMT_CHANNEL_MAX, RMT_CHANNEL_ERROR_STR, ESP_ERR_INVALID_ARG);
@@ -913,7 +934,10 @@ esp_err_t rmt_write_sample(rmt_channel_t channel, const uint8_t *src, size_t src
     const uint32_t item_block_len = RMT.conf_ch[channel].conf0.mem_size * RMT_MEM_ITEM_NUM;
     const uint32_t item_sub_len = item_block_len / 2;
     xSemaphoreTake(p_rmt->tx_sem, portMAX_DELAY);
-    p_rmt->sample_to_rmt((void *)src, p_rmt->tx_buf, src_size, item_block_len, &translated_size, &item_num);
+    p_rmt->tx_len_rem = 0;
+    p_rmt->sample_to_rmt((void *)src, p_rmt->tx_buf, src_size, item_block_len, &translated_size, &p_rmt->tx_len_rem);
+    item_num = p_rmt->tx_len_rem;
+    p_rmt->tx_len_rem = 0;
     p_rmt->sample_size_remain = src_size - translated_size;
     p_rmt->sample_cur = src + translated_size;
     rmt_fill_memory(channel, p_rmt->tx_buf, item_num, 0);
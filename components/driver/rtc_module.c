@@ -1345,7 +1345,7 @@ static int adc_convert( adc_unit_t unit, int channel)
 static esp_err_t adc_set_i2s_data_len(adc_unit_t adc_unit, int patt_len)
 {
     ADC_CHECK_UNIT(adc_unit);
-    RTC_MODULE_CHECK((patt_len < ADC_PATT_LEN_MAX) && (patt_len > 0), "ADC pattern length error", ESP_ERR_INVALID_ARG);
+    RTC_MODULE_CHECK((patt_len <= ADC_PATT_LEN_MAX) && (patt_len > 0), "ADC pattern length error", ESP_ERR_INVALID_ARG);
     portENTER_CRITICAL(&rtc_spinlock);
     if(adc_unit & ADC_UNIT_1) {
         SYSCON.saradc_ctrl.sar1_patt_len = patt_len - 1;
@@ -1385,18 +1385,33 @@ static esp_err_t adc_set_i2s_data_pattern(adc_unit_t adc_unit, int seq_num, adc_
 }
 
 esp_err_t adc_i2s_mode_init(adc_unit_t adc_unit, adc_channel_t channel)
+{
+    const adc_i2s_pattern_t pattern = {
+        .channel = channel,
+        .atten = ADC_ATTEN_DB_11,
+    };
+    return adc_i2s_mode_init_pattern(adc_unit, &pattern, 1);
+}
+
+esp_err_t adc_i2s_mode_init_pattern(adc_unit_t adc_unit, const adc_i2s_pattern_t *pattern, int pattern_len)
 {
     ADC_CHECK_UNIT(adc_unit);
-    if (adc_unit & ADC_UNIT_1) {
-        RTC_MODULE_CHECK((adc1_channel_t) channel < ADC1_CHANNEL_MAX, "ADC1 channel error", ESP_ERR_INVALID_ARG);
+    RTC_MODULE_CHECK(pattern != NULL, "ADC pattern error", ESP_ERR_INVALID_ARG);
+    RTC_MODULE_CHECK((pattern_len <= ADC_PATT_LEN_MAX) && (pattern_len > 0), "ADC pattern length error", ESP_ERR_INVALID_ARG);
+    for (int i = 0; i < pattern_len; i++) {
+        if (adc_unit & ADC_UNIT_1) {
+            RTC_MODULE_CHECK((adc1_channel_t) pattern[i].channel < ADC1_CHANNEL_MAX, "ADC1 channel error", ESP_ERR_INVALID_ARG);
+        }
+        RTC_MODULE_CHECK(pattern[i].atten < ADC_ATTEN_MAX, "ADC Atten Err", ESP_ERR_INVALID_ARG);
     }
 
-    uint8_t table_len = 1;
     //POWER ON SAR
     adc_power_always_on();
-    adc_gpio_init(adc_unit, channel);
-    adc_set_i2s_data_len(adc_unit, table_len);
-    adc_set_i2s_data_pattern(adc_unit, 0, channel, ADC_WIDTH_BIT_12, ADC_ATTEN_DB_11);
+    for (int i = 0; i < pattern_len; i++) {
+        adc_gpio_init(adc_unit, pattern[i].channel);
+        adc_set_i2s_data_pattern(adc_unit, i, pattern[i].channel, ADC_WIDTH_BIT_12, pattern[i].atten);
+    }
+    adc_set_i2s_data_len(adc_unit, pattern_len);
     portENTER_CRITICAL(&rtc_spinlock);
     if (adc_unit & ADC_UNIT_1) {
         adc_set_controller( ADC_UNIT_1, ADC_CTRL_DIG );
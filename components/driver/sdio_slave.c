@@ -139,6 +139,7 @@ typedef struct  buf_desc_s{
         };
     };
     void*   arg;        /* to hold some parameters */
+    uint32_t loan_cnt;  /* receiving buffers only: references the app holds, reloaded when the last one is returned */
 } buf_desc_t;
 
 typedef STAILQ_HEAD(bufdesc_stailq_head_s, buf_desc_s) buf_stailq_t;
@@ -938,6 +939,15 @@ esp_err_t sdio_slave_send_get_finished(void** out_arg, TickType_t wait)
     return ESP_OK;
 }
 
+esp_err_t sdio_slave_send_get_finished_batch(void** out_args, size_t max_num, size_t *out_num, TickType_t wait)
+{
+    SDIO_SLAVE_CHECK(out_args != NULL && max_num > 0, "no space for the finished args", ESP_ERR_INVALID_ARG);
+    size_t num = xQueueReceiveMultiple(context.ret_queue, out_args, max_num, wait);
+    if (out_num) *out_num = num;
+    if (num == 0) return ESP_ERR_TIMEOUT;
+    return ESP_OK;
+}
+
 esp_err_t sdio_slave_transmit(uint8_t* addr, size_t len)
 {
     uint32_t timestamp = XTHAL_GET_CCOUNT();
@@ -1037,7 +1047,7 @@ static esp_err_t send_reset_counter()
  *--------------------------------------------------------------------------*/
 //strange but the registers for host->slave transfers are really called "tx*".
 
-#define CHECK_HANDLE_IDLE(desc) do { if (desc == NULL || !desc->not_receiving) {\
+#define CHECK_HANDLE_IDLE(desc) do { if (desc == NULL || !desc->not_receiving || desc->loan_cnt != 0) {\
     return ESP_ERR_INVALID_ARG; } } while(0)
 
 static inline void critical_enter_recv()
@@ -1245,6 +1255,33 @@ esp_err_t sdio_slave_recv_unregister_buf(sdio_slave_buf_handle_t handle)
     return ESP_OK;
 }
 
+esp_err_t sdio_slave_recv_loan(sdio_slave_buf_handle_t handle)
+{
+    buf_desc_t *desc = (buf_desc_t*)handle;
+    if (desc == NULL) return ESP_ERR_INVALID_ARG;
+
+    critical_enter_recv();
+    bool idle = desc->not_receiving;
+    if (idle) desc->loan_cnt++;
+    critical_exit_recv();
+    return idle? ESP_OK: ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t sdio_slave_recv_loan_return(sdio_slave_buf_handle_t handle)
+{
+    buf_desc_t *desc = (buf_desc_t*)handle;
+    if (desc == NULL) return ESP_ERR_INVALID_ARG;
+
+    critical_enter_recv();
+    bool loaned = desc->not_receiving && desc->loan_cnt > 0;
+    bool last = loaned && --desc->loan_cnt == 0;
+    critical_exit_recv();
+    if (!loaned) return ESP_ERR_INVALID_ARG;
+    //the last consumer is done with the data, give the buffer back to the DMA.
+    if (last) return sdio_slave_recv_load_buf(handle);
+    return ESP_OK;
+}
+
 uint8_t* sdio_slave_recv_get_buf(sdio_slave_buf_handle_t handle, size_t *len_o)
 {
     buf_desc_t *desc = (buf_desc_t*)handle;
@@ -26,6 +26,7 @@
 #include "sdspi_private.h"
 #include "sdspi_crc.h"
 #include "esp_timer.h"
+#include "sdkconfig.h"
 
 
 /// Max number of transactions in flight (used in start_command_write_blocks)
@@ -579,6 +580,18 @@ static esp_err_t poll_cmd_response(int slot, sdspi_hw_cmd_t *cmd)
 }
 
 
+/// Compare CRC of received data with the CRC sent by the card
+static esp_err_t check_data_crc(const uint8_t* data, size_t size, uint16_t crc)
+{
+    uint16_t crc_of_data = sdspi_crc16(data, size);
+    if (crc_of_data != crc) {
+        ESP_LOGE(TAG, "data CRC failed, got=0x%04x expected=0x%04x", crc_of_data, crc);
+        esp_log_buffer_hex(TAG, data, 16);
+        return ESP_ERR_INVALID_CRC;
+    }
+    return ESP_OK;
+}
+
 /**
  * Receiving one or more blocks of data happens as follows:
  * 1. send command + receive r1 response (SDSPI_CMD_R1_SIZE bytes total)
@@ -617,8 +630,10 @@ static esp_err_t poll_cmd_response(int slot, sdspi_hw_cmd_t *cmd)
  *
  * With this approach the delay between blocks of a multi-block transfer is
  * ~95 microseconds, out of which 35 microseconds are spend doing the CRC check.
- * Further speedup is possible by pipelining transfers and CRC checks, at an
- * expense of one extra temporary buffer.
+ * To hide the CRC check, the data of each block is copied to the destination
+ * buffer as soon as it is received, and its CRC is checked while the transfer
+ * of the next block is in flight (the last block is checked after the loop).
+ * CRC checks can be skipped altogether with CONFIG_SDSPI_VERIFY_READ_CRC.
  */
 static esp_err_t start_command_read_blocks(int slot, sdspi_hw_cmd_t *cmd,
         uint8_t *data, uint32_t rx_length)
@@ -653,6 +668,16 @@ static esp_err_t start_command_read_blocks(int slot, sdspi_hw_cmd_t *cmd,
         return ESP_ERR_TIMEOUT;
     }
 
+#if CONFIG_SDSPI_VERIFY_READ_CRC
+    bool verify_crc = data_crc_enabled(slot);
+#else
+    bool verify_crc = false;
+#endif
+    // Block received last, the CRC of which is checked during the next transfer
+    const uint8_t* crc_pending_data = NULL;
+    size_t crc_pending_size = 0;
+    uint16_t crc_pending = 0;
+
     while (rx_length > 0) {
         size_t extra_data_size = 0;
         const uint8_t* extra_data_ptr = NULL;
@@ -688,6 +713,11 @@ static esp_err_t start_command_read_blocks(int slot, sdspi_hw_cmd_t *cmd,
             return ret;
         }
 
+        // Extra data may be at the end of rx_data, which is about to be overwritten
+        if (extra_data_size) {
+            memcpy(data, extra_data_ptr, extra_data_size);
+        }
+
         // receive actual data
         const size_t receive_extra_bytes = (rx_length > SDSPI_MAX_DATA_LEN) ? 4 : 2;
         memset(rx_data, 0xff, will_receive + receive_extra_bytes);
@@ -698,11 +728,22 @@ static esp_err_t start_command_read_blocks(int slot, sdspi_hw_cmd_t *cmd,
             .tx_buffer = rx_data
         };
 
-        ret = spi_device_transmit(spi_handle(slot), t_data);
+        ret = spi_device_queue_trans(spi_handle(slot), t_data, 0);
         if (ret != ESP_OK) {
+            release_transaction(slot);
             return ret;
         }
-        release_transaction(slot);
+
+        // Check the CRC of the previous block while this one is being received
+        esp_err_t crc_ret = ESP_OK;
+        if (crc_pending_data) {
+            crc_ret = check_data_crc(crc_pending_data, crc_pending_size, crc_pending);
+        }
+
+        wait_for_transactions(slot);
+        if (crc_ret != ESP_OK) {
+            return crc_ret;
+        }
 
         // CRC bytes need to be received even if CRC is not enabled
         uint16_t crc = UINT16_MAX;
@@ -714,19 +755,11 @@ static esp_err_t start_command_read_blocks(int slot, sdspi_hw_cmd_t *cmd,
 
         // Copy data to the destination buffer
         memcpy(data + extra_data_size, rx_data, will_receive);
-        if (extra_data_size) {
-            memcpy(data, extra_data_ptr, extra_data_size);
-        }
 
-        // compute CRC of the received data
-        uint16_t crc_of_data = 0;
-        if (data_crc_enabled(slot)) {
-            crc_of_data = sdspi_crc16(data, will_receive + extra_data_size);
-            if (crc_of_data != crc) {
-                ESP_LOGE(TAG, "data CRC failed, got=0x%04x expected=0x%04x", crc_of_data, crc);
-                esp_log_buffer_hex(TAG, data, 16);
-                return ESP_ERR_INVALID_CRC;
-            }
+        if (verify_crc) {
+            crc_pending_data = data;
+            crc_pending_size = will_receive + extra_data_size;
+            crc_pending = crc;
         }
 
         data += will_receive + extra_data_size;
@@ -735,6 +768,13 @@ static esp_err_t start_command_read_blocks(int slot, sdspi_hw_cmd_t *cmd,
         extra_data_ptr = NULL;
     }
 
+    if (crc_pending_data) {
+        ret = check_data_crc(crc_pending_data, crc_pending_size, crc_pending);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
     if (need_stop_command) {
         // To end multi block transfer, send stop command and wait for the
         // card to process it
@@ -824,8 +864,9 @@ static esp_err_t start_command_write_blocks(int slot, sdspi_hw_cmd_t *cmd,
             return ret;
         }
 
-        // Write CRC
-        uint16_t crc = sdspi_crc16(data, will_send);
+        // Write CRC, computed while the data is being sent. The card ignores it
+        // unless CRC checks are enabled.
+        uint16_t crc = data_crc_enabled(slot) ? sdspi_crc16(data, will_send) : UINT16_MAX;
         spi_transaction_t* t_crc = get_transaction(slot);
         *t_crc = (spi_transaction_t) {
             .length = sizeof(crc) * 8,
@@ -142,9 +142,11 @@ We have two bits to control the interrupt:
 #include "driver/gpio.h"
 #include "driver/periph_ctrl.h"
 #include "esp_heap_caps.h"
+#include "esp32/dma_bounce.h"
 #include "stdatomic.h"
 
 typedef struct spi_device_t spi_device_t;
+typedef struct spi_batch_priv_t spi_batch_priv_t;
 typedef typeof(SPI1.clock) spi_clock_reg_t;
 
 #define NO_CS 3     //Number of CS pins per SPI host
@@ -168,8 +170,18 @@ typedef struct {
     const uint32_t *buffer_to_send;   //equals to tx_data, if SPI_TRANS_USE_RXDATA is applied; otherwise if original buffer wasn't in DMA-capable memory, this gets the address of a temporary buffer that is;
                                 //otherwise sets to the original buffer or NULL if no buffer is assigned.
     uint32_t *buffer_to_rcv;    // similar to buffer_to_send
+    spi_batch_priv_t *batch;    //the batch this transaction belongs to, NULL if queued by itself
 } spi_trans_priv_t;
 
+/// Private data of a batch of transactions queued by ``spi_device_queue_trans_batch``.
+/// The whole batch takes one item in the queues, the ISR sends the transactions one after another.
+struct spi_batch_priv_t {
+    spi_transaction_t **trans_descs;
+    int count;
+    int cur;                    //index of the transaction in flight
+    spi_trans_priv_t trans_buf[];
+};
+
 typedef struct {
     _Atomic(spi_device_t*) device[NO_CS];
     intr_handle_t intr;
@@ -208,8 +220,15 @@ struct spi_device_t {
     spi_host_t *host;
     SemaphoreHandle_t semphr_polling;   //semaphore to notify the device it claimed the bus
     bool        waiting;                //the device is waiting for the exclusive control of the bus
+    uint8_t *bounce_pool;               //DMA-capable buffers used before allocating temporary buffers from the heap
+    size_t bounce_buf_size;             //size of each buffer in bounce_pool
+    int bounce_buf_num;
+    atomic_uint bounce_free;            //bitmask of the free buffers in bounce_pool
+    spi_device_bounce_stats_t bounce_stats;
 };
 
+#define BOUNCE_POOL_MAX_BUFS    32
+
 static spi_host_t *spihost[3];
 
 
@@ -531,6 +550,7 @@ esp_err_t spi_bus_remove_device(spi_device_handle_t handle)
     int spics_io_num = handle->cfg.spics_io_num;
     if (spics_io_num >= 0) spicommon_cs_free_io(spics_io_num);
 
+    free(handle->bounce_pool);
     //Kill queues
     vQueueDelete(handle->trans_queue);
     vQueueDelete(handle->ret_queue);
@@ -1031,8 +1051,23 @@ static void SPI_MASTER_ISR_ATTR spi_intr(void *arg)
             spicommon_dmaworkaround_idle(host->dma_chan);
         }
 
+        spi_batch_priv_t *const batch = host->cur_trans_buf.batch;
         //cur_cs is changed to NO_CS here
         spi_post_trans(host);
+        if (batch != NULL) {
+            if (++batch->cur < batch->count) {
+                //Start the next transaction of the batch right away, without going through the queues.
+                //The interrupt is still enabled, and the bus can't be taken by polling transactions in between since isr_free is false.
+                host->cur_trans_buf = batch->trans_buf[batch->cur];
+                if (host->dma_chan != 0 && (host->cur_trans_buf.buffer_to_rcv || host->cur_trans_buf.buffer_to_send)) {
+                    spicommon_dmaworkaround_transfer_active(host->dma_chan);
+                }
+                spi_new_trans(atomic_load(&host->device[cs]), &host->cur_trans_buf);
+                return;
+            }
+            //The whole batch is returned as one item
+            host->cur_trans_buf = (spi_trans_priv_t) { .batch = batch, };
+        }
         //Return transaction descriptor.
         xQueueSendFromISR(atomic_load(&host->device[cs])->ret_queue, &host->cur_trans_buf, &do_yield);
 #ifdef CONFIG_PM_ENABLE
@@ -1131,27 +1166,67 @@ static SPI_MASTER_ISR_ATTR esp_err_t check_trans_valid(spi_device_handle_t handl
     return ESP_OK;
 }
 
-static SPI_MASTER_ISR_ATTR void uninstall_priv_desc(spi_trans_priv_t* trans_buf)
+// Get a DMA-capable buffer to bounce the data of a transaction through, from the pool of the device if possible,
+// else from the shared bounce pool.
+static SPI_MASTER_ISR_ATTR void *bounce_buf_get(spi_device_t *dev, size_t size)
+{
+    if (size <= dev->bounce_buf_size) {
+        unsigned free_mask = atomic_load(&dev->bounce_free);
+        while (free_mask != 0) {
+            int i = __builtin_ctz(free_mask);
+            //free_mask is updated on failure
+            if (atomic_compare_exchange_weak(&dev->bounce_free, &free_mask, free_mask & ~(1U << i))) {
+                return dev->bounce_pool + i * dev->bounce_buf_size;
+            }
+        }
+    }
+    if (size <= esp_dma_bounce_chunk_size()) {
+        void *chunk = esp_dma_bounce_get();
+        if (chunk != NULL) {
+            dev->bounce_stats.shared_chunks++;
+            return chunk;
+        }
+    }
+    dev->bounce_stats.heap_allocs++;
+    return heap_caps_malloc(size, MALLOC_CAP_DMA);
+}
+
+static SPI_MASTER_ISR_ATTR void bounce_buf_put(spi_device_t *dev, void *buf)
+{
+    uint8_t *ptr = (uint8_t *)buf;
+    if (dev->bounce_pool != NULL && ptr >= dev->bounce_pool && ptr < dev->bounce_pool + dev->bounce_buf_num * dev->bounce_buf_size) {
+        atomic_fetch_or(&dev->bounce_free, 1U << ((ptr - dev->bounce_pool) / dev->bounce_buf_size));
+    } else if (esp_dma_bounce_is_chunk(ptr)) {
+        esp_dma_bounce_put(ptr);
+    } else {
+        free(buf);
+    }
+}
+
+static SPI_MASTER_ISR_ATTR void uninstall_priv_desc(spi_device_t *dev, spi_trans_priv_t* trans_buf)
 {
     spi_transaction_t *trans_desc = trans_buf->trans;
-    if ((void *)trans_buf->buffer_to_send != &trans_desc->tx_data[0] &&
+    if (trans_buf->buffer_to_send != NULL && (void *)trans_buf->buffer_to_send != &trans_desc->tx_data[0] &&
         trans_buf->buffer_to_send != trans_desc->tx_buffer) {
-        free((void *)trans_buf->buffer_to_send); //force free, ignore const
+        bounce_buf_put(dev, (void *)trans_buf->buffer_to_send); //force free, ignore const
     }
     //copy data from temporary DMA-capable buffer back to IRAM buffer and free the temporary one.
-    if ((void *)trans_buf->buffer_to_rcv != &trans_desc->rx_data[0] &&
+    if (trans_buf->buffer_to_rcv != NULL && (void *)trans_buf->buffer_to_rcv != &trans_desc->rx_data[0] &&
         trans_buf->buffer_to_rcv != trans_desc->rx_buffer) {
         if (trans_desc->flags & SPI_TRANS_USE_RXDATA) {
             memcpy((uint8_t *) & trans_desc->rx_data[0], trans_buf->buffer_to_rcv, (trans_desc->rxlength + 7) / 8);
         } else {
             memcpy(trans_desc->rx_buffer, trans_buf->buffer_to_rcv, (trans_desc->rxlength + 7) / 8);
         }
-        free(trans_buf->buffer_to_rcv);
+        bounce_buf_put(dev, trans_buf->buffer_to_rcv);
     }
 }
 
-static SPI_MASTER_ISR_ATTR esp_err_t setup_priv_desc(spi_transaction_t *trans_desc, spi_trans_priv_t* new_desc, bool isdma)
+static SPI_MASTER_ISR_ATTR esp_err_t setup_priv_desc(spi_device_t *dev, spi_transaction_t *trans_desc, spi_trans_priv_t* new_desc)
 {
+    const bool isdma = (dev->host->dma_chan != 0);
+    const bool no_bounce = (trans_desc->flags & SPI_TRANS_NO_BOUNCE) != 0;
+    esp_err_t ret = ESP_ERR_NO_MEM;
     *new_desc = (spi_trans_priv_t) { .trans = trans_desc, };
 
     // rx memory assign
@@ -1163,10 +1238,16 @@ static SPI_MASTER_ISR_ATTR esp_err_t setup_priv_desc(spi_transaction_t *trans_de
         rcv_ptr = trans_desc->rx_buffer;
     }
     if (rcv_ptr && isdma && (!esp_ptr_dma_capable(rcv_ptr) || ((int)rcv_ptr % 4 != 0))) {
+        if (no_bounce) {
+            ESP_LOGE( SPI_TAG, "rx buffer %p is not DMA-capable or not 32-bit aligned", rcv_ptr );
+            ret = ESP_ERR_INVALID_ARG;
+            goto clean_up;
+        }
         //if rxbuf in the desc not DMA-capable, malloc a new one. The rx buffer need to be length of multiples of 32 bits to avoid heap corruption.
-        ESP_LOGI( SPI_TAG, "Allocate RX buffer for DMA" );
-        rcv_ptr = heap_caps_malloc((trans_desc->rxlength + 31) / 8, MALLOC_CAP_DMA);
+        ESP_LOGD( SPI_TAG, "Allocate RX buffer for DMA" );
+        rcv_ptr = bounce_buf_get(dev, (trans_desc->rxlength + 31) / 8);
         if (rcv_ptr == NULL) goto clean_up;
+        dev->bounce_stats.rx_bounces++;
     }
     new_desc->buffer_to_rcv = rcv_ptr;
 
@@ -1179,10 +1260,16 @@ static SPI_MASTER_ISR_ATTR esp_err_t setup_priv_desc(spi_transaction_t *trans_de
         send_ptr = trans_desc->tx_buffer ;
     }
     if (send_ptr && isdma && !esp_ptr_dma_capable( send_ptr )) {
+        if (no_bounce) {
+            ESP_LOGE( SPI_TAG, "tx buffer %p is not DMA-capable", send_ptr );
+            ret = ESP_ERR_INVALID_ARG;
+            goto clean_up;
+        }
         //if txbuf in the desc not DMA-capable, malloc a new one
-        ESP_LOGI( SPI_TAG, "Allocate TX buffer for DMA" );
-        uint32_t *temp = heap_caps_malloc((trans_desc->length + 7) / 8, MALLOC_CAP_DMA);
+        ESP_LOGD( SPI_TAG, "Allocate TX buffer for DMA" );
+        uint32_t *temp = bounce_buf_get(dev, (trans_desc->length + 7) / 8);
         if (temp == NULL) goto clean_up;
+        dev->bounce_stats.tx_bounces++;
 
         memcpy( temp, send_ptr, (trans_desc->length + 7) / 8 );
         send_ptr = temp;
@@ -1192,8 +1279,40 @@ static SPI_MASTER_ISR_ATTR esp_err_t setup_priv_desc(spi_transaction_t *trans_de
     return ESP_OK;
 
 clean_up:
-    uninstall_priv_desc(new_desc);
-    return ESP_ERR_NO_MEM;
+    uninstall_priv_desc(dev, new_desc);
+    return ret;
+}
+
+esp_err_t spi_device_alloc_bounce_pool(spi_device_handle_t handle, size_t buffer_size, int buffer_num)
+{
+    SPI_CHECK(handle!=NULL, "invalid dev handle", ESP_ERR_INVALID_ARG);
+    SPI_CHECK(buffer_num >= 0 && buffer_num <= BOUNCE_POOL_MAX_BUFS, "invalid number of buffers", ESP_ERR_INVALID_ARG);
+    //Not exhaustive, only here to catch design errors.
+    SPI_CHECK(atomic_load(&handle->bounce_free) == (1ULL << handle->bounce_buf_num) - 1, "buffers of the pool are in use", ESP_ERR_INVALID_STATE);
+
+    //Keep the buffers 32-bit aligned, as needed for rx buffers
+    buffer_size = (buffer_size + 3) & ~3;
+    uint8_t *pool = NULL;
+    if (buffer_size != 0 && buffer_num != 0) {
+        pool = heap_caps_malloc(buffer_size * buffer_num, MALLOC_CAP_DMA);
+        if (pool == NULL) return ESP_ERR_NO_MEM;
+    } else {
+        buffer_size = 0;
+        buffer_num = 0;
+    }
+    free(handle->bounce_pool);
+    handle->bounce_pool = pool;
+    handle->bounce_buf_size = buffer_size;
+    handle->bounce_buf_num = buffer_num;
+    atomic_store(&handle->bounce_free, (unsigned)((1ULL << buffer_num) - 1));
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_bounce_stats(spi_device_handle_t handle, spi_device_bounce_stats_t *stats)
+{
+    SPI_CHECK(handle!=NULL && stats!=NULL, "invalid arg", ESP_ERR_INVALID_ARG);
+    *stats = handle->bounce_stats;
+    return ESP_OK;
 }
 
 esp_err_t SPI_MASTER_ATTR spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans_desc,  TickType_t ticks_to_wait)
@@ -1201,16 +1320,14 @@ esp_err_t SPI_MASTER_ATTR spi_device_queue_trans(spi_device_handle_t handle, spi
     esp_err_t ret = check_trans_valid(handle, trans_desc);
     if (ret != ESP_OK) return ret;
 
-    spi_host_t *host = handle->host;
-
     SPI_CHECK( !device_is_polling(handle), "Cannot queue new transaction while previous polling transaction is not terminated.", ESP_ERR_INVALID_STATE );
 
     spi_trans_priv_t trans_buf;
-    ret = setup_priv_desc(trans_desc, &trans_buf, (host->dma_chan!=0));
+    ret = setup_priv_desc(handle, trans_desc, &trans_buf);
     if (ret != ESP_OK) return ret;
 
 #ifdef CONFIG_PM_ENABLE
-    esp_pm_lock_acquire(host->pm_lock);
+    esp_pm_lock_acquire(handle->host->pm_lock);
 #endif
     //Send to queue and invoke the ISR.
 
@@ -1219,7 +1336,7 @@ esp_err_t SPI_MASTER_ATTR spi_device_queue_trans(spi_device_handle_t handle, spi
         ret = ESP_ERR_TIMEOUT;
 #ifdef CONFIG_PM_ENABLE
         //Release APB frequency lock
-        esp_pm_lock_release(host->pm_lock);
+        esp_pm_lock_release(handle->host->pm_lock);
 #endif
         goto clean_up;
     }
@@ -1227,31 +1344,108 @@ esp_err_t SPI_MASTER_ATTR spi_device_queue_trans(spi_device_handle_t handle, spi
     return ESP_OK;
 
 clean_up:
-    uninstall_priv_desc(&trans_buf);
+    uninstall_priv_desc(handle, &trans_buf);
     return ret;
 }
 
-esp_err_t SPI_MASTER_ATTR spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans_desc, TickType_t ticks_to_wait)
+esp_err_t SPI_MASTER_ATTR spi_device_queue_trans_batch(spi_device_handle_t handle, spi_transaction_t **trans_descs, int count, TickType_t ticks_to_wait)
+{
+    esp_err_t ret;
+    SPI_CHECK(handle!=NULL, "invalid dev handle", ESP_ERR_INVALID_ARG);
+    SPI_CHECK(trans_descs!=NULL && count > 0, "invalid batch", ESP_ERR_INVALID_ARG);
+    for (int i = 0; i < count; i++) {
+        ret = check_trans_valid(handle, trans_descs[i]);
+        if (ret != ESP_OK) return ret;
+    }
+
+    SPI_CHECK( !device_is_polling(handle), "Cannot queue new transaction while previous polling transaction is not terminated.", ESP_ERR_INVALID_STATE );
+
+    //The ISR walks through the batch, so it has to be in internal memory
+    spi_batch_priv_t *batch = heap_caps_malloc(sizeof(spi_batch_priv_t) + count * sizeof(spi_trans_priv_t), MALLOC_CAP_INTERNAL|MALLOC_CAP_8BIT);
+    if (batch == NULL) return ESP_ERR_NO_MEM;
+    *batch = (spi_batch_priv_t) {
+        .trans_descs = trans_descs,
+        .count = 0,
+    };
+    for (int i = 0; i < count; i++) {
+        ret = setup_priv_desc(handle, trans_descs[i], &batch->trans_buf[i]);
+        if (ret != ESP_OK) goto clean_up;
+        batch->trans_buf[i].batch = batch;
+        batch->count++;
+    }
+
+#ifdef CONFIG_PM_ENABLE
+    esp_pm_lock_acquire(handle->host->pm_lock);
+#endif
+    //Send the first transaction to the queue, it stands for the whole batch, and invoke the ISR.
+    BaseType_t r = xQueueSend(handle->trans_queue, (void *)&batch->trans_buf[0], ticks_to_wait);
+    if (!r) {
+        ret = ESP_ERR_TIMEOUT;
+#ifdef CONFIG_PM_ENABLE
+        //Release APB frequency lock
+        esp_pm_lock_release(handle->host->pm_lock);
+#endif
+        goto clean_up;
+    }
+    spi_isr_invoke(handle);
+    return ESP_OK;
+
+clean_up:
+    for (int i = 0; i < batch->count; i++) {
+        uninstall_priv_desc(handle, &batch->trans_buf[i]);
+    }
+    free(batch);
+    return ret;
+}
+
+// Take the next item from the return queue, if it is a batch (if is_batch is true) or a single transaction (otherwise).
+static esp_err_t SPI_MASTER_ATTR get_ret_item(spi_device_handle_t handle, spi_trans_priv_t *trans_buf, bool is_batch, TickType_t ticks_to_wait)
 {
-    BaseType_t r;
-    spi_trans_priv_t trans_buf;
     SPI_CHECK(handle!=NULL, "invalid dev handle", ESP_ERR_INVALID_ARG);
 
     //use the interrupt, block until return
-    r=xQueueReceive(handle->ret_queue, (void*)&trans_buf, ticks_to_wait);
+    BaseType_t r=xQueuePeek(handle->ret_queue, (void*)trans_buf, ticks_to_wait);
     if (!r) {
         // The memory occupied by rx and tx DMA buffer destroyed only when receiving from the queue (transaction finished).
         // If timeout, wait and retry.
         // Every in-flight transaction request occupies internal memory as DMA buffer if needed.
         return ESP_ERR_TIMEOUT;
     }
+    SPI_CHECK((trans_buf->batch != NULL) == is_batch, "the next result is of another kind (single transaction or batch)", ESP_ERR_INVALID_STATE);
+    //Only the task owning the device takes from the return queue, the item is still there
+    xQueueReceive(handle->ret_queue, (void*)trans_buf, 0);
+    return ESP_OK;
+}
+
+esp_err_t SPI_MASTER_ATTR spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans_desc, TickType_t ticks_to_wait)
+{
+    spi_trans_priv_t trans_buf;
+    esp_err_t ret = get_ret_item(handle, &trans_buf, false, ticks_to_wait);
+    if (ret != ESP_OK) return ret;
     //release temporary buffers
-    uninstall_priv_desc(&trans_buf);
+    uninstall_priv_desc(handle, &trans_buf);
     (*trans_desc) = trans_buf.trans;
 
     return ESP_OK;
 }
 
+esp_err_t SPI_MASTER_ATTR spi_device_get_trans_batch_result(spi_device_handle_t handle, spi_transaction_t ***trans_descs, int *count, TickType_t ticks_to_wait)
+{
+    spi_trans_priv_t trans_buf;
+    esp_err_t ret = get_ret_item(handle, &trans_buf, true, ticks_to_wait);
+    if (ret != ESP_OK) return ret;
+    spi_batch_priv_t *batch = trans_buf.batch;
+    //release temporary buffers
+    for (int i = 0; i < batch->count; i++) {
+        uninstall_priv_desc(handle, &batch->trans_buf[i]);
+    }
+    (*trans_descs) = batch->trans_descs;
+    (*count) = batch->count;
+    free(batch);
+
+    return ESP_OK;
+}
+
 //Porcelain to do one blocking transmission.
 esp_err_t SPI_MASTER_ATTR spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans_desc)
 {
@@ -1334,7 +1528,7 @@ esp_err_t SPI_MASTER_ISR_ATTR spi_device_polling_start(spi_device_handle_t handl
 
     SPI_CHECK( !device_is_polling(handle), "Cannot send polling transaction while the previous polling transaction is not terminated.", ESP_ERR_INVALID_STATE );
 
-    ret = setup_priv_desc(trans_desc, &host->cur_trans_buf, (handle->host->dma_chan!=0));
+    ret = setup_priv_desc(handle, trans_desc, &host->cur_trans_buf);
     if (ret!=ESP_OK) return ret;
 
     device_acquire_bus_internal(handle, portMAX_DELAY);
@@ -1371,7 +1565,7 @@ esp_err_t SPI_MASTER_ISR_ATTR spi_device_polling_end(spi_device_handle_t handle,
     //deal with the in-flight transaction
     spi_post_trans(host);
     //release temporary buffers
-    uninstall_priv_desc(&host->cur_trans_buf);
+    uninstall_priv_desc(handle, &host->cur_trans_buf);
     host->polling = false;
 
     if (!host->bus_locked) {
@@ -46,6 +46,8 @@ static const char *SPI_TAG = "spi_slave";
 
 #define VALID_HOST(x) (x>SPI_HOST && x<=VSPI_HOST)
 
+#define SPI_SLAVE_RING_MAX_BITLEN   ((1 << 24) - 1)    //Largest transaction length the slave registers take
+
 #ifdef CONFIG_SPI_SLAVE_ISR_IN_IRAM
 #define SPI_SLAVE_ISR_ATTR IRAM_ATTR
 #else
@@ -58,6 +60,16 @@ static const char *SPI_TAG = "spi_slave";
 #define SPI_SLAVE_ATTR
 #endif
 
+/// State of the continuous reception started by ``spi_slave_start_ring_rx``
+typedef struct {
+    spi_slave_ring_config_t cfg;
+    lldesc_t *desc;             //circular list of descriptors, one per segment
+    uint8_t *buf;
+    int next;                   //segment the DMA fills next
+    intr_handle_t intr;         //DMA interrupt, signals each filled segment
+    spi_slave_ring_stats_t stats;
+} spi_slave_ring_t;
+
 typedef struct {
     int id;
     spi_slave_interface_config_t cfg;
@@ -71,6 +83,8 @@ typedef struct {
     QueueHandle_t trans_queue;
     QueueHandle_t ret_queue;
     int dma_chan;
+    int intr_flags;
+    spi_slave_ring_t *ring; //set while the ring reception is running, transactions can't be queued then
 #ifdef CONFIG_PM_ENABLE
     esp_pm_lock_handle_t pm_lock;
 #endif
@@ -79,6 +93,7 @@ typedef struct {
 static spi_slave_t *spihost[3];
 
 static void IRAM_ATTR spi_intr(void *arg);
+static void spi_ring_intr(void *arg);
 
 static inline bool bus_is_iomux(spi_slave_t *host)
 {
@@ -178,6 +193,7 @@ esp_err_t spi_slave_initialize(spi_host_device_t host, const spi_bus_config_t *b
         goto cleanup;
     }
 
+    spihost[host]->intr_flags = bus_config->intr_flags;
     int flags = bus_config->intr_flags | ESP_INTR_FLAG_INTRDISABLED;
     err = esp_intr_alloc(spicommon_irqsource_for_host(host), flags, spi_intr, (void *)spihost[host], &spihost[host]->intr);
     if (err != ESP_OK) {
@@ -308,6 +324,7 @@ esp_err_t spi_slave_free(spi_host_device_t host)
 {
     SPI_CHECK(VALID_HOST(host), "invalid host", ESP_ERR_INVALID_ARG);
     SPI_CHECK(spihost[host], "host not slave", ESP_ERR_INVALID_ARG);
+    SPI_CHECK(spihost[host]->ring == NULL, "ring reception still running", ESP_ERR_INVALID_STATE);
     if (spihost[host]->trans_queue) vQueueDelete(spihost[host]->trans_queue);
     if (spihost[host]->ret_queue) vQueueDelete(spihost[host]->ret_queue);
     if ( spihost[host]->dma_chan > 0 ) {
@@ -332,6 +349,7 @@ esp_err_t SPI_SLAVE_ATTR spi_slave_queue_trans(spi_host_device_t host, const spi
     BaseType_t r;
     SPI_CHECK(VALID_HOST(host), "invalid host", ESP_ERR_INVALID_ARG);
     SPI_CHECK(spihost[host], "host not slave", ESP_ERR_INVALID_ARG);
+    SPI_CHECK(spihost[host]->ring == NULL, "ring reception running", ESP_ERR_INVALID_STATE);
     SPI_CHECK(spihost[host]->dma_chan == 0 || trans_desc->tx_buffer==NULL || esp_ptr_dma_capable(trans_desc->tx_buffer),
 			"txdata not in DMA-capable memory", ESP_ERR_INVALID_ARG);
     SPI_CHECK(spihost[host]->dma_chan == 0 || trans_desc->rx_buffer==NULL ||
@@ -371,6 +389,130 @@ esp_err_t SPI_SLAVE_ATTR spi_slave_transmit(spi_host_device_t host, spi_slave_tr
     return ESP_OK;
 }
 
+static void ring_free(spi_slave_ring_t *ring)
+{
+    if (ring->intr) esp_intr_free(ring->intr);
+    free(ring->desc);
+    free(ring->buf);
+    free(ring);
+}
+
+esp_err_t spi_slave_start_ring_rx(spi_host_device_t host, const spi_slave_ring_config_t *ring_config)
+{
+    SPI_CHECK(VALID_HOST(host), "invalid host", ESP_ERR_INVALID_ARG);
+    SPI_CHECK(spihost[host], "host not slave", ESP_ERR_INVALID_ARG);
+    spi_slave_t *slave = spihost[host];
+    SPI_CHECK(slave->dma_chan != 0, "ring reception needs DMA", ESP_ERR_INVALID_STATE);
+    SPI_CHECK(slave->ring == NULL, "ring reception already running", ESP_ERR_INVALID_STATE);
+    SPI_CHECK(ring_config->segment_size > 0 && ring_config->segment_size % 4 == 0 && ring_config->segment_size <= SPI_MAX_DMA_LEN,
+        "segment size should be a multiple of 4, up to 4092", ESP_ERR_INVALID_ARG);
+    SPI_CHECK(ring_config->segment_num >= 2, "at least 2 segments needed", ESP_ERR_INVALID_ARG);
+    SPI_CHECK(ring_config->on_segment != NULL || ring_config->ringbuf != NULL, "no segment callback or ring buffer", ESP_ERR_INVALID_ARG);
+    //These checks aren't exhaustive, they are only here to catch design errors.
+    SPI_CHECK(slave->cur_trans == NULL && uxQueueMessagesWaiting(slave->trans_queue) == 0, "have unfinished transactions", ESP_ERR_INVALID_STATE);
+
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    spi_slave_ring_t *ring = heap_caps_calloc(1, sizeof(spi_slave_ring_t), MALLOC_CAP_INTERNAL|MALLOC_CAP_8BIT);
+    if (ring == NULL) return ESP_ERR_NO_MEM;
+    ring->cfg = *ring_config;
+    ring->desc = heap_caps_malloc(sizeof(lldesc_t) * ring_config->segment_num, MALLOC_CAP_DMA);
+    ring->buf = heap_caps_malloc(ring_config->segment_size * ring_config->segment_num, MALLOC_CAP_DMA);
+    if (ring->desc == NULL || ring->buf == NULL) goto cleanup;
+    for (int i = 0; i < ring_config->segment_num; i++) {
+        ring->desc[i] = (lldesc_t) {
+            .size = ring_config->segment_size,
+            .length = ring_config->segment_size,
+            .buf = ring->buf + i * ring_config->segment_size,
+            .owner = 1,
+        };
+        //No eof, the last descriptor links back to the first one
+        ring->desc[i].qe.stqe_next = &ring->desc[(i + 1) % ring_config->segment_num];
+    }
+    ret = esp_intr_alloc(spi_periph_signal[host].irq_dma, slave->intr_flags | ESP_INTR_FLAG_INTRDISABLED, spi_ring_intr, (void *)slave, &ring->intr);
+    if (ret != ESP_OK) goto cleanup;
+
+    //No more transactions, the ISR only re-arms the slave after each CS assertion from now on.
+    esp_intr_disable(slave->intr);
+    slave->ring = ring;
+    spicommon_dmaworkaround_transfer_active(slave->dma_chan);
+
+    spi_dev_t *hw = slave->hw;
+    hw->dma_conf.val |= SPI_OUT_RST | SPI_IN_RST | SPI_AHBM_RST | SPI_AHBM_FIFO_RST;
+    hw->dma_out_link.start = 0;
+    hw->dma_in_link.start = 0;
+    hw->dma_conf.val &= ~(SPI_OUT_RST | SPI_IN_RST | SPI_AHBM_RST | SPI_AHBM_FIFO_RST);
+    hw->dma_conf.out_data_burst_en = 0;
+    hw->dma_conf.indscr_burst_en = 0;
+    hw->dma_conf.outdscr_burst_en = 0;
+    //The DMA keeps its position in the descriptor list between transactions
+    hw->dma_conf.dma_continue = 1;
+    hw->dma_int_clr.val = UINT32_MAX;
+    hw->dma_int_ena.val = 0;
+    hw->dma_int_ena.in_done = 1;
+    hw->dma_int_ena.inlink_dscr_empty = 1;
+
+    hw->user.usr_miso_highpart = 0;
+    hw->dma_in_link.addr = (int)(&ring->desc[0]) & 0xFFFFF;
+    hw->dma_in_link.start = 1;
+    hw->slave.sync_reset = 1;
+    hw->slave.sync_reset = 0;
+
+    //Receive as much as the master sends in each transaction
+    hw->slv_rd_bit.slv_rdata_bit = 0;
+    hw->slv_wrbuf_dlen.bit_len = SPI_SLAVE_RING_MAX_BITLEN;
+    hw->mosi_dlen.usr_mosi_dbitlen = SPI_SLAVE_RING_MAX_BITLEN;
+    hw->user.usr_mosi = 1;
+    hw->user.usr_miso = 0;
+
+    restore_cs(slave);
+    hw->slave.trans_done = 0;
+    hw->cmd.usr = 1;
+    esp_intr_enable(ring->intr);
+    esp_intr_enable(slave->intr);
+    return ESP_OK;
+
+cleanup:
+    ring_free(ring);
+    return ret;
+}
+
+esp_err_t spi_slave_stop_ring_rx(spi_host_device_t host)
+{
+    SPI_CHECK(VALID_HOST(host), "invalid host", ESP_ERR_INVALID_ARG);
+    SPI_CHECK(spihost[host], "host not slave", ESP_ERR_INVALID_ARG);
+    spi_slave_t *slave = spihost[host];
+    SPI_CHECK(slave->ring != NULL, "ring reception not running", ESP_ERR_INVALID_STATE);
+
+    spi_slave_ring_t *ring = slave->ring;
+    spi_dev_t *hw = slave->hw;
+    esp_intr_disable(slave->intr);
+    esp_intr_disable(ring->intr);
+    freeze_cs(slave);
+    hw->dma_int_ena.val = 0;
+    hw->dma_int_clr.val = UINT32_MAX;
+    hw->dma_in_link.stop = 1;
+    hw->dma_conf.dma_continue = 0;
+    hw->dma_conf.val |= SPI_OUT_RST | SPI_IN_RST | SPI_AHBM_RST | SPI_AHBM_FIFO_RST;
+    hw->dma_in_link.start = 0;
+    hw->dma_conf.val &= ~(SPI_OUT_RST | SPI_IN_RST | SPI_AHBM_RST | SPI_AHBM_FIFO_RST);
+    spicommon_dmaworkaround_idle(slave->dma_chan);
+
+    slave->ring = NULL;
+    ring_free(ring);
+    //Back to the idle state set by spi_slave_initialize, the interrupt fires when a transaction is queued
+    hw->slave.trans_done = 1;
+    return ESP_OK;
+}
+
+esp_err_t spi_slave_get_ring_stats(spi_host_device_t host, spi_slave_ring_stats_t *stats)
+{
+    SPI_CHECK(VALID_HOST(host), "invalid host", ESP_ERR_INVALID_ARG);
+    SPI_CHECK(spihost[host], "host not slave", ESP_ERR_INVALID_ARG);
+    SPI_CHECK(spihost[host]->ring != NULL, "ring reception not running", ESP_ERR_INVALID_STATE);
+    *stats = spihost[host]->ring->stats;
+    return ESP_OK;
+}
+
 #ifdef DEBUG_SLAVE
 static void dumpregs(spi_dev_t *hw)
 {
@@ -419,6 +561,13 @@ static void SPI_SLAVE_ISR_ATTR spi_intr(void *arg)
     //Ignore all but the trans_done int.
     if (!host->hw->slave.trans_done) return;
 
+    if (host->ring) {
+        //The data goes to the ring, only get ready for the next transaction
+        host->hw->slave.trans_done = 0;
+        host->hw->cmd.usr = 1;
+        return;
+    }
+
     if (host->cur_trans) {
         // When DMA is enabled, the slave rx dma suffers from unexpected transactions. Forbid reading until transaction ready.
         if (host->dma_chan != 0) freeze_cs(host);
@@ -541,3 +690,36 @@ static void SPI_SLAVE_ISR_ATTR spi_intr(void *arg)
     if (do_yield) portYIELD_FROM_ISR();
 }
 
+//DMA interrupt of the ring reception, hands the filled segments over to the application
+static void SPI_SLAVE_ISR_ATTR spi_ring_intr(void *arg)
+{
+    BaseType_t do_yield = pdFALSE;
+    spi_slave_t *host = (spi_slave_t *)arg;
+    spi_slave_ring_t *ring = host->ring;
+    typeof(host->hw->dma_int_st) st = host->hw->dma_int_st;
+    host->hw->dma_int_clr.val = st.val;
+
+    //The DMA clears the owner bit of each descriptor it filled, in order
+    while (ring->desc[ring->next].owner == 0) {
+        lldesc_t *desc = &ring->desc[ring->next];
+        ring->stats.segments++;
+        if (ring->cfg.ringbuf) {
+            if (xRingbufferSendFromISR(ring->cfg.ringbuf, (const void *)desc->buf, desc->length, &do_yield) != pdTRUE) {
+                ring->stats.dropped++;
+            }
+        }
+        if (ring->cfg.on_segment) {
+            ring->cfg.on_segment((const uint8_t *)desc->buf, desc->length, ring->cfg.arg);
+        }
+        //Give the segment back to the DMA
+        desc->length = desc->size;
+        desc->owner = 1;
+        ring->next = (ring->next + 1) % ring->cfg.segment_num;
+    }
+    if (st.inlink_dscr_empty) {
+        //The DMA caught up with a segment not handed back yet; received data was lost
+        ring->stats.overflows++;
+        host->hw->dma_in_link.restart = 1;
+    }
+    if (do_yield) portYIELD_FROM_ISR();
+}
@@ -396,6 +396,34 @@ TEST_CASE("GPIO get input level test", "[gpio][ignore]")
     //when case finish, get the result from multimeter, the pin17 is 3.3v, the pin19 is 0.00v
 }
 
+TEST_CASE("GPIO set and get level of several pins at once", "[gpio]")
+{
+    // pins in input and output mode read back their own output level
+    const uint64_t mask = BIT64(GPIO_OUTPUT_IO) | BIT64(GPIO_INPUT_IO) | BIT64(GPIO_NUM_32);
+    gpio_config_t io_conf = {
+        .intr_type = GPIO_PIN_INTR_DISABLE,
+        .mode = GPIO_MODE_INPUT_OUTPUT,
+        .pin_bit_mask = mask,
+    };
+    TEST_ESP_OK(gpio_config(&io_conf));
+
+    const uint64_t patterns[] = {0, mask, BIT64(GPIO_OUTPUT_IO) | BIT64(GPIO_NUM_32), BIT64(GPIO_INPUT_IO)};
+    for (int i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++) {
+        TEST_ESP_OK(gpio_set_level_mask(mask, patterns[i]));
+        TEST_ASSERT(gpio_get_level_mask(mask) == patterns[i]);
+        TEST_ASSERT_EQUAL_INT((patterns[i] >> GPIO_OUTPUT_IO) & 1, gpio_get_level(GPIO_OUTPUT_IO));
+    }
+    // pins outside of the mask are left unchanged
+    TEST_ESP_OK(gpio_set_level_mask(BIT64(GPIO_INPUT_IO), 0));
+    TEST_ASSERT(gpio_get_level_mask(BIT64(GPIO_INPUT_IO)) == 0);
+    TEST_ASSERT(gpio_get_level_mask(BIT64(GPIO_OUTPUT_IO) | BIT64(GPIO_NUM_32)) == (BIT64(GPIO_OUTPUT_IO) | BIT64(GPIO_NUM_32)));
+
+    // IO34-39 are just used for input, IO20 doesn't exist
+    TEST_ASSERT(gpio_set_level_mask(BIT64(GPIO_NUM_34), 0) == ESP_ERR_INVALID_ARG);
+    TEST_ASSERT(gpio_set_level_mask(BIT64(20), 0) == ESP_ERR_INVALID_ARG);
+    TEST_ESP_OK(gpio_set_level_mask(mask, 0));
+}
+
 TEST_CASE("GPIO io pull up/down function", "[gpio]")
 {
     gpio_config_t  io_conf = init_io(GPIO_INPUT_IO);
@@ -506,3 +506,77 @@ static void i2c_slave_repeat_read()
 }
 
 TEST_CASE_MULTIPLE_DEVICES("I2C repeat write test", "[i2c][test_env=UT_T2_I2C][timeout=150]", i2c_master_repeat_write, i2c_slave_repeat_read);
+
+TEST_CASE("I2C static command link", "[i2c]")
+{
+    uint8_t buffer[I2C_CMD_LINK_STATIC_SIZE(4)];
+    uint8_t data[2];
+
+    TEST_ASSERT_NULL(i2c_cmd_link_create_static(buffer, 4));
+    int size = esp_get_free_heap_size();
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(buffer, sizeof(buffer));
+    TEST_ASSERT_NOT_NULL(cmd);
+    TEST_ESP_OK(i2c_master_start(cmd));
+    TEST_ESP_OK(i2c_master_write_byte(cmd, ( ESP_SLAVE_ADDR << 1 ) | READ_BIT, ACK_CHECK_EN));
+    TEST_ESP_OK(i2c_master_read(cmd, data, sizeof(data), I2C_MASTER_LAST_NACK));
+    // the buffer only holds 4 commands
+    TEST_ASSERT_EQUAL(ESP_FAIL, i2c_master_stop(cmd));
+    TEST_ASSERT_EQUAL(size, esp_get_free_heap_size());
+    i2c_cmd_link_delete(cmd);
+
+    // creating the link again with the same buffer clears it
+    cmd = i2c_cmd_link_create_static(buffer, sizeof(buffer));
+    TEST_ESP_OK(i2c_master_start(cmd));
+    TEST_ESP_OK(i2c_master_stop(cmd));
+}
+
+#define QUEUE_TRANS_NUM 3
+
+typedef struct {
+    uint8_t link[QUEUE_TRANS_NUM][I2C_CMD_LINK_STATIC_SIZE(4)];
+    uint8_t data[QUEUE_TRANS_NUM][RW_TEST_LENGTH];
+    esp_err_t result[QUEUE_TRANS_NUM];
+    volatile int done;
+} queue_test_t;
+
+static void IRAM_ATTR i2c_queue_done_cb(i2c_port_t i2c_num, i2c_cmd_handle_t cmd_handle, esp_err_t result, void* arg)
+{
+    queue_test_t *test = (queue_test_t *) arg;
+    test->result[test->done++] = result;
+}
+
+static void i2c_master_queue_write()
+{
+    queue_test_t *test = (queue_test_t *) calloc(1, sizeof(queue_test_t));
+
+    i2c_config_t conf_master = i2c_master_init();
+    TEST_ESP_OK(i2c_param_config(I2C_MASTER_NUM, &conf_master));
+    TEST_ESP_OK(i2c_driver_install(I2C_MASTER_NUM, I2C_MODE_MASTER,
+                                   I2C_MASTER_RX_BUF_DISABLE,
+                                   I2C_MASTER_TX_BUF_DISABLE, 0));
+    unity_wait_for_signal("i2c slave init finish");
+
+    // all transactions are queued at once and sent back to back by the ISR
+    for (int j = 0; j < QUEUE_TRANS_NUM; j++) {
+        for (int i = 0; i < RW_TEST_LENGTH; i++) {
+            test->data[j][i] = j + i;
+        }
+        i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(test->link[j], sizeof(test->link[j]));
+        TEST_ESP_OK(i2c_master_start(cmd));
+        TEST_ESP_OK(i2c_master_write_byte(cmd, ( ESP_SLAVE_ADDR << 1 ) | WRITE_BIT, ACK_CHECK_EN));
+        TEST_ESP_OK(i2c_master_write(cmd, test->data[j], RW_TEST_LENGTH, ACK_CHECK_EN));
+        TEST_ESP_OK(i2c_master_stop(cmd));
+        TEST_ESP_OK(i2c_master_cmd_queue(I2C_MASTER_NUM, cmd, i2c_queue_done_cb, test, portMAX_DELAY));
+    }
+    TEST_ESP_OK(i2c_master_cmd_queue_wait(I2C_MASTER_NUM, 5000 / portTICK_RATE_MS));
+    TEST_ASSERT_EQUAL(QUEUE_TRANS_NUM, test->done);
+    for (int j = 0; j < QUEUE_TRANS_NUM; j++) {
+        TEST_ESP_OK(test->result[j]);
+    }
+    free(test);
+    unity_send_signal("master write");
+    unity_wait_for_signal("ready to delete");
+    i2c_driver_delete(I2C_MASTER_NUM);
+}
+
+TEST_CASE_MULTIPLE_DEVICES("I2C queued write test", "[i2c][test_env=UT_T2_I2C][timeout=150]", i2c_master_queue_write, i2c_slave_repeat_read);
@@ -267,3 +267,142 @@ TEST_CASE("I2S memory leaking test", "[i2s]")
     vTaskDelay(100 / portTICK_PERIOD_MS);
     TEST_ASSERT(initial_size == esp_get_free_heap_size());
 }
+
+TEST_CASE("I2S dma buffer acquire and release", "[i2s]")
+{
+    i2s_config_t i2s_config = {
+        .mode = I2S_MODE_MASTER | I2S_MODE_TX | I2S_MODE_RX,
+        .sample_rate = SAMPLE_RATE,
+        .bits_per_sample = I2S_BITS_PER_SAMPLE_32BIT,
+        .channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT,
+        .communication_format = I2S_COMM_FORMAT_I2S | I2S_COMM_FORMAT_I2S_MSB,
+        .dma_buf_count = 4,
+        .dma_buf_len = 64,
+        .use_apll = 0,
+        .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
+    };
+    void *buf;
+    size_t size;
+
+    TEST_ESP_OK(i2s_driver_install(I2S_NUM_0, &i2s_config, 0, NULL));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, i2s_dma_buffer_release(I2S_NUM_0, I2S_MODE_TX, NULL));
+
+    // fill a tx buffer with 16 bit samples and expand them to 32 bit in place
+    TEST_ESP_OK(i2s_dma_buffer_acquire(I2S_NUM_0, I2S_MODE_TX, &buf, &size, 1000 / portTICK_PERIOD_MS));
+    TEST_ASSERT_EQUAL(64 * 2 * 4, size);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, i2s_dma_buffer_acquire(I2S_NUM_0, I2S_MODE_TX, &buf, &size, 0));
+    uint16_t *samples = (uint16_t *)buf;
+    for (int i = 0; i < size / 4; i++) {
+        samples[i] = i + 1;
+    }
+    TEST_ESP_OK(i2s_expand_in_place(buf, size / 2, 16, 32));
+    for (int i = 0; i < size / 4; i++) {
+        TEST_ASSERT_EQUAL_HEX32((i + 1) << 16, ((uint32_t *)buf)[i]);
+    }
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, i2s_dma_buffer_release(I2S_NUM_0, I2S_MODE_TX, (char *)buf + 4));
+    TEST_ESP_OK(i2s_dma_buffer_release(I2S_NUM_0, I2S_MODE_TX, buf));
+
+    // the rest of a buffer partially written by i2s_write is handed out
+    size_t bytes_written;
+    uint32_t word = 0;
+    TEST_ESP_OK(i2s_write(I2S_NUM_0, &word, sizeof(word), &bytes_written, 1000 / portTICK_PERIOD_MS));
+    TEST_ESP_OK(i2s_dma_buffer_acquire(I2S_NUM_0, I2S_MODE_TX, &buf, &size, 1000 / portTICK_PERIOD_MS));
+    TEST_ASSERT_EQUAL(64 * 2 * 4 - sizeof(word), size);
+    TEST_ESP_OK(i2s_dma_buffer_release(I2S_NUM_0, I2S_MODE_TX, buf));
+
+    // received buffers
+    for (int i = 0; i < 8; i++) {
+        TEST_ESP_OK(i2s_dma_buffer_acquire(I2S_NUM_0, I2S_MODE_RX, &buf, &size, 1000 / portTICK_PERIOD_MS));
+        TEST_ASSERT_EQUAL(64 * 2 * 4, size);
+        TEST_ESP_OK(i2s_dma_buffer_release(I2S_NUM_0, I2S_MODE_RX, buf));
+    }
+    TEST_ESP_OK(i2s_driver_uninstall(I2S_NUM_0));
+
+    // 8 to 24 bit expansion goes through the byte path
+    uint8_t bytes[6] = {0x11, 0x22};
+    TEST_ESP_OK(i2s_expand_in_place(bytes, 2, 8, 24));
+    const uint8_t expected[6] = {0, 0, 0x11, 0, 0, 0x22};
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, bytes, 6);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, i2s_expand_in_place(bytes, 3, 16, 32));
+}
+
+TEST_CASE("I2S ADC demux", "[i2s]")
+{
+    // samples of channels 0, 3 and 6 in turn, two per word with the earlier one in the upper half
+    uint32_t words[6];
+    const int chans[3] = {0, 3, 6};
+    for (int i = 0; i < 12; i += 2) {
+        words[i / 2] = ((chans[i % 3] << 12 | i) << 16) | (chans[(i + 1) % 3] << 12 | (i + 1));
+    }
+    uint16_t ch0[4], ch3[2];
+    i2s_adc_channel_buf_t channels[ADC1_CHANNEL_MAX] = {
+        [0] = { .buf = ch0, .size = 4 },
+        [3] = { .buf = ch3, .size = 2 },
+    };
+
+    // channel 6 has no buffer, and the buffer of channel 3 fills up
+    TEST_ASSERT_EQUAL(6, i2s_adc_demux(words, sizeof(words), channels));
+    TEST_ASSERT_EQUAL(4, channels[0].len);
+    TEST_ASSERT_EQUAL(2, channels[3].len);
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL(i * 3, ch0[i]);
+    }
+    TEST_ASSERT_EQUAL(1, ch3[0]);
+    TEST_ASSERT_EQUAL(4, ch3[1]);
+}
+
+TEST_CASE("I2S ADC pattern samples several channels", "[i2s]")
+{
+    i2s_config_t i2s_config = {
+        .mode = I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN,
+        .sample_rate = 40000,
+        .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
+        .channel_format = I2S_CHANNEL_FMT_ONLY_RIGHT,
+        .communication_format = I2S_COMM_FORMAT_I2S_MSB,
+        .dma_buf_count = 4,
+        .dma_buf_len = 256,
+        .use_apll = 0,
+        .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
+    };
+    const adc_i2s_pattern_t pattern[] = {
+        { .channel = ADC1_CHANNEL_0, .atten = ADC_ATTEN_DB_11 },
+        { .channel = ADC1_CHANNEL_3, .atten = ADC_ATTEN_DB_11 },
+        { .channel = ADC1_CHANNEL_0, .atten = ADC_ATTEN_DB_11 },
+        { .channel = ADC1_CHANNEL_6, .atten = ADC_ATTEN_DB_0 },
+    };
+    i2s_adc_channel_buf_t channels[ADC1_CHANNEL_MAX] = {0};
+    for (int ch = 0; ch < ADC1_CHANNEL_MAX; ch++) {
+        channels[ch].size = 1024;
+        channels[ch].buf = malloc(channels[ch].size * sizeof(uint16_t));
+        TEST_ASSERT_NOT_NULL(channels[ch].buf);
+    }
+
+    TEST_ESP_OK(i2s_driver_install(I2S_NUM_0, &i2s_config, 0, NULL));
+    TEST_ESP_OK(i2s_set_adc_pattern(ADC_UNIT_1, pattern, sizeof(pattern) / sizeof(pattern[0])));
+    TEST_ESP_OK(i2s_adc_enable(I2S_NUM_0));
+    // skip the first buffers, they may have been filled before the pattern took effect
+    void *buf;
+    size_t size;
+    for (int i = 0; i < 2; i++) {
+        TEST_ESP_OK(i2s_dma_buffer_acquire(I2S_NUM_0, I2S_MODE_RX, &buf, &size, 1000 / portTICK_PERIOD_MS));
+        TEST_ESP_OK(i2s_dma_buffer_release(I2S_NUM_0, I2S_MODE_RX, buf));
+    }
+    for (int i = 0; i < 2; i++) {
+        TEST_ESP_OK(i2s_dma_buffer_acquire(I2S_NUM_0, I2S_MODE_RX, &buf, &size, 1000 / portTICK_PERIOD_MS));
+        TEST_ASSERT_EQUAL(0, i2s_adc_demux(buf, size, channels));
+        TEST_ESP_OK(i2s_dma_buffer_release(I2S_NUM_0, I2S_MODE_RX, buf));
+    }
+    TEST_ESP_OK(i2s_adc_disable(I2S_NUM_0));
+    TEST_ESP_OK(i2s_driver_uninstall(I2S_NUM_0));
+
+    // channel 0 appears twice in the pattern, so it gets half of the samples
+    size_t total = 2 * 256;
+    printf("samples: ch0 %d ch3 %d ch6 %d\n", channels[0].len, channels[3].len, channels[6].len);
+    TEST_ASSERT_EQUAL(total, channels[0].len + channels[3].len + channels[6].len);
+    TEST_ASSERT_INT_WITHIN(2, total / 2, channels[0].len);
+    TEST_ASSERT_INT_WITHIN(2, total / 4, channels[3].len);
+    TEST_ASSERT_INT_WITHIN(2, total / 4, channels[6].len);
+    for (int ch = 0; ch < ADC1_CHANNEL_MAX; ch++) {
+        free(channels[ch].buf);
+    }
+}
@@ -453,6 +453,65 @@ TEST_CASE("LEDC fade with step(logic analyzer)", "[ledc][ignore]")
     ledc_fade_func_uninstall();
 }
 
+TEST_CASE("LEDC duty batch update and fade with ramp table", "[ledc]")
+{
+    ledc_timer_config_t ledc_time_config = {
+        .speed_mode = LEDC_HIGH_SPEED_MODE,
+        .duty_resolution = LEDC_TIMER_13_BIT,
+        .timer_num = LEDC_TIMER_0,
+        .freq_hz = 5000,
+    };
+    TEST_ESP_OK(ledc_timer_config(&ledc_time_config));
+    for (int i = 0; i < 3; i++) {
+        ledc_channel_config_t ledc_ch_config = {
+            .gpio_num = PULSE_IO,
+            .speed_mode = LEDC_HIGH_SPEED_MODE,
+            .channel  = LEDC_CHANNEL_0 + i,
+            .intr_type = LEDC_INTR_DISABLE,
+            .timer_sel = LEDC_TIMER_0,
+            .duty = 0,
+        };
+        TEST_ESP_OK(ledc_channel_config(&ledc_ch_config));
+    }
+
+    ledc_channel_duty_t duties[3] = {
+        { .channel = LEDC_CHANNEL_0, .duty = 1000 },
+        { .channel = LEDC_CHANNEL_1, .duty = 2000 },
+        { .channel = LEDC_CHANNEL_2, .duty = 3000 },
+    };
+    TEST_ESP_OK(ledc_set_duty_batch(LEDC_HIGH_SPEED_MODE, duties, 3));
+    vTaskDelay(10 / portTICK_RATE_MS);
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_INT32(duties[i].duty, ledc_get_duty(LEDC_HIGH_SPEED_MODE, duties[i].channel));
+    }
+    // each channel may only be given once
+    duties[2].channel = LEDC_CHANNEL_0;
+    TEST_ASSERT(ledc_set_duty_batch(LEDC_HIGH_SPEED_MODE, duties, 3) == ESP_ERR_INVALID_ARG);
+
+    TEST_ESP_OK(ledc_fade_func_install(0));
+    ledc_fade_step_t table[] = {
+        { .duty = 4000, .scale = 20, .cycle_num = 1 },
+        { .duty = 500, .scale = 50, .cycle_num = 1 },
+        { .duty = 6000, .scale = 0, .cycle_num = 1 },
+        { .duty = 2000, .scale = 100, .cycle_num = 2 },
+    };
+    TEST_ESP_OK(ledc_set_fade_table_and_start(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_0, table, sizeof(table) / sizeof(table[0]), LEDC_FADE_WAIT_DONE));
+    TEST_ASSERT_EQUAL_INT32(2000, ledc_get_duty(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_0));
+    TEST_ESP_OK(ledc_set_fade_table_and_start(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_0, table, 2, LEDC_FADE_NO_WAIT));
+    vTaskDelay(1000 / portTICK_RATE_MS);
+    TEST_ASSERT_EQUAL_INT32(500, ledc_get_duty(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_0));
+    // a regular fade after the table one doesn't continue with the table
+    TEST_ESP_OK(ledc_set_fade_step_and_start(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_0, 1500, 10, 1, LEDC_FADE_WAIT_DONE));
+    TEST_ASSERT_EQUAL_INT32(1500, ledc_get_duty(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_0));
+    table[1].cycle_num = 0;
+    TEST_ASSERT(ledc_set_fade_table_and_start(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_0, table, 2, LEDC_FADE_WAIT_DONE) == ESP_ERR_INVALID_ARG);
+    ledc_fade_func_uninstall();
+
+    for (int i = 0; i < 3; i++) {
+        TEST_ESP_OK(ledc_stop(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_0 + i, 0));
+    }
+}
+
 // memory leaking problem detecting
 TEST_CASE("LEDC memory test", "[ledc][test_env=UT_T1_LEDC]")
 {
@@ -648,3 +648,87 @@ TEST_CASE("PCNT counting mode test", "[pcnt][test_env=UT_T1_PCNT]")
     printf("PCNT mode test for negative count\n");
     count_mode_test(PCNT_CTRL_GND_IO);
 }
+
+TEST_CASE("PCNT extended counter and frequency measurement", "[pcnt]")
+{
+    ledc_timer_config_t ledc_timer = {
+        .speed_mode = LEDC_HIGH_SPEED_MODE,
+        .timer_num  = LEDC_TIMER_1,
+        .duty_resolution = LEDC_TIMER_10_BIT,
+        .freq_hz = 1000,
+    };
+    ledc_channel_config_t ledc_channel = {
+        .speed_mode = LEDC_HIGH_SPEED_MODE,
+        .channel = LEDC_CHANNEL_1,
+        .timer_sel = LEDC_TIMER_1,
+        .intr_type = LEDC_INTR_DISABLE,
+        .gpio_num = PULSE_IO,
+        .duty = 512,
+        .hpoint = 0,
+    };
+    // count the LEDC output on the same pin, no external connection needed
+    pcnt_config_t pcnt_config = {
+        .pulse_gpio_num = PULSE_IO,
+        .ctrl_gpio_num = -1,
+        .channel = PCNT_CHANNEL_0,
+        .unit = PCNT_UNIT_1,
+        .pos_mode = PCNT_COUNT_INC,
+        .neg_mode = PCNT_COUNT_DIS,
+        .lctrl_mode = PCNT_MODE_KEEP,
+        .hctrl_mode = PCNT_MODE_KEEP,
+        .counter_h_lim = 100,
+        .counter_l_lim = -100,
+    };
+    timer_config_t timer_config = {
+        .divider = 80,  // 1 MHz
+        .counter_dir = TIMER_COUNT_UP,
+        .counter_en = TIMER_PAUSE,
+        .alarm_en = TIMER_ALARM_DIS,
+        .auto_reload = false,
+    };
+    int64_t count;
+    float freq;
+
+    TEST_ESP_OK(pcnt_unit_config(&pcnt_config));
+    TEST_ESP_OK(pcnt_counter_pause(PCNT_UNIT_1));
+    TEST_ESP_OK(pcnt_counter_clear(PCNT_UNIT_1));
+    TEST_ESP_OK(ledc_timer_config(&ledc_timer));
+    TEST_ESP_OK(ledc_channel_config(&ledc_channel));
+    TEST_ESP_OK(gpio_set_direction(PULSE_IO, GPIO_MODE_INPUT_OUTPUT));
+    TEST_ESP_OK(timer_init(TIMER_GROUP_0, TIMER_0, &timer_config));
+    TEST_ESP_OK(timer_start(TIMER_GROUP_0, TIMER_0));
+
+    TEST_ESP_OK(pcnt_isr_service_install(0));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, pcnt_ext_counter_get_value(PCNT_UNIT_1, &count));
+    TEST_ESP_OK(pcnt_ext_counter_install(PCNT_UNIT_1, TIMER_GROUP_0, TIMER_0));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, pcnt_ext_counter_install(PCNT_UNIT_1, TIMER_GROUP_0, TIMER_0));
+    TEST_ESP_OK(pcnt_ext_counter_get_frequency(PCNT_UNIT_1, &freq));
+    TEST_ASSERT_EQUAL_FLOAT(0, freq);
+
+    // the counter goes well past the 16-bit hardware limit
+    TEST_ESP_OK(pcnt_counter_resume(PCNT_UNIT_1));
+    vTaskDelay(1000 / portTICK_PERIOD_MS);
+    TEST_ESP_OK(pcnt_ext_counter_get_value(PCNT_UNIT_1, &count));
+    TEST_ESP_OK(pcnt_ext_counter_get_frequency(PCNT_UNIT_1, &freq));
+    printf("count %d, frequency %f Hz\n", (int) count, freq);
+    TEST_ASSERT_INT_WITHIN(30, 1000, (int) count);
+    TEST_ASSERT_FLOAT_WITHIN(10, 1000, freq);
+
+    // the value never goes backwards while counting up
+    int64_t last = count;
+    for (int i = 0; i < 100000; i++) {
+        TEST_ESP_OK(pcnt_ext_counter_get_value(PCNT_UNIT_1, &count));
+        TEST_ASSERT_TRUE(count >= last);
+        last = count;
+    }
+
+    // the frequency decays when the pulses stop
+    TEST_ESP_OK(ledc_stop(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_1, 0));
+    vTaskDelay(500 / portTICK_PERIOD_MS);
+    TEST_ESP_OK(pcnt_ext_counter_get_frequency(PCNT_UNIT_1, &freq));
+    TEST_ASSERT_LESS_THAN(250, (int) freq);
+
+    TEST_ESP_OK(pcnt_ext_counter_uninstall(PCNT_UNIT_1));
+    pcnt_isr_service_uninstall();
+    TEST_ESP_OK(timer_pause(TIMER_GROUP_0, TIMER_0));
+}
@@ -805,3 +805,88 @@ TEST_CASE("RMT use multi channel", "[rmt][test_env=UT_T1_RMT]")
     TEST_ESP_OK(rmt_driver_uninstall(7));
 }
 
+
+#define SAMPLE_TX_CHANNEL   6   /*!< uses one memory block, 64 items */
+#define SAMPLE_RX_CHANNEL   2   /*!< uses four memory blocks to receive all items at once */
+#define SAMPLE_BYTES        24  /*!< 192 items, three times the memory block of the transmitter */
+#define SAMPLE_SHORT_US     560
+#define SAMPLE_LONG_US      1690
+
+typedef struct {
+    rmt_item32_t bit0;
+    rmt_item32_t bit1;
+} byte_translator_t;
+
+static void IRAM_ATTR byte_to_rmt(const void* src, rmt_item32_t* dest, size_t src_size,
+                                  size_t wanted_num, size_t* translated_size, size_t* item_num)
+{
+    byte_translator_t *ctx = NULL;
+    rmt_translator_get_context(item_num, (void **) &ctx);
+    const uint8_t *psrc = (const uint8_t *) src;
+    size_t size = 0;
+    size_t num = 0;
+    while (size < src_size && num + 8 <= wanted_num) {
+        for (int bit = 7; bit >= 0; bit--) {
+            *dest++ = (psrc[size] >> bit) & 1 ? ctx->bit1 : ctx->bit0;
+        }
+        num += 8;
+        size++;
+    }
+    *translated_size = size;
+    *item_num = num;
+}
+
+TEST_CASE("RMT TX write sample with translator context", "[rmt][test_env=UT_T1_RMT]")
+{
+    rmt_config_t rmt_tx = {
+        .channel = SAMPLE_TX_CHANNEL,
+        .gpio_num = RMT_TX_GPIO_NUM,
+        .mem_block_num = 1,
+        .clk_div = RMT_CLK_DIV,
+        .tx_config.idle_output_en = true,
+        .rmt_mode = RMT_MODE_TX,
+    };
+    rmt_config_t rmt_rx = {
+        .channel = SAMPLE_RX_CHANNEL,
+        .gpio_num = RMT_RX_GPIO_NUM,
+        .mem_block_num = 4,
+        .clk_div = RMT_CLK_DIV,
+        .rx_config.filter_en = true,
+        .rx_config.filter_ticks_thresh = 100,
+        .rx_config.idle_threshold = RMT_ITEM32_TIMEOUT_US / 10 * (RMT_TICK_10_US),
+        .rmt_mode = RMT_MODE_RX,
+    };
+    TEST_ESP_OK(rmt_config(&rmt_tx));
+    TEST_ESP_OK(rmt_config(&rmt_rx));
+    TEST_ESP_OK(rmt_driver_install(SAMPLE_TX_CHANNEL, 0, 0));
+    TEST_ESP_OK(rmt_driver_install(SAMPLE_RX_CHANNEL, 4 * RMT_MEM_ITEM_NUM * sizeof(rmt_item32_t) * 2, 0));
+
+    byte_translator_t ctx;
+    fill_item_level(&ctx.bit0, SAMPLE_SHORT_US, SAMPLE_SHORT_US);
+    fill_item_level(&ctx.bit1, SAMPLE_LONG_US, SAMPLE_SHORT_US);
+    TEST_ESP_OK(rmt_translator_init(SAMPLE_TX_CHANNEL, byte_to_rmt));
+    TEST_ESP_OK(rmt_translator_set_context(SAMPLE_TX_CHANNEL, &ctx));
+
+    uint8_t sample[SAMPLE_BYTES];
+    for (int i = 0; i < SAMPLE_BYTES; i++) {
+        sample[i] = i * 37 + 1;
+    }
+    RingbufHandle_t rb = NULL;
+    TEST_ESP_OK(rmt_get_ringbuf_handle(SAMPLE_RX_CHANNEL, &rb));
+    TEST_ESP_OK(rmt_rx_start(SAMPLE_RX_CHANNEL, 1));
+    TEST_ESP_OK(rmt_write_sample(SAMPLE_TX_CHANNEL, sample, SAMPLE_BYTES, true));
+
+    // the high time of each item tells the bits apart, the low time of the last item merges with idle
+    size_t rx_size = 0;
+    rmt_item32_t* rx_item = (rmt_item32_t*) xRingbufferReceive(rb, &rx_size, 1000 / portTICK_PERIOD_MS);
+    TEST_ASSERT_NOT_NULL(rx_item);
+    TEST_ASSERT_EQUAL(SAMPLE_BYTES * 8, rx_size / sizeof(rmt_item32_t));
+    for (int i = 0; i < SAMPLE_BYTES * 8; i++) {
+        bool one = check_in_range(rx_item[i].duration0, SAMPLE_LONG_US, BIT_MARGIN * 5);
+        TEST_ASSERT(one || check_in_range(rx_item[i].duration0, SAMPLE_SHORT_US, BIT_MARGIN * 5));
+        TEST_ASSERT_EQUAL((sample[i / 8] >> (7 - i % 8)) & 1, one);
+    }
+    vRingbufferReturnItem(rb, (void*) rx_item);
+    TEST_ESP_OK(rmt_driver_uninstall(SAMPLE_TX_CHANNEL));
+    TEST_ESP_OK(rmt_driver_uninstall(SAMPLE_RX_CHANNEL));
+}
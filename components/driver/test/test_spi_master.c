@@ -1205,3 +1205,136 @@ TEST_CASE("spi poll tasks","[spi]")
 
 
 //TODO: add a case when a non-polling transaction happened in the bus-acquiring time and then release the bus then queue a new trans
+
+static int batch_pre_cb_count;
+
+static IRAM_ATTR void batch_pre_cb(spi_transaction_t *t)
+{
+    //the user field holds the index of the transaction, check they are sent in order
+    if ((int)t->user == batch_pre_cb_count) {
+        batch_pre_cb_count++;
+    }
+}
+
+TEST_CASE("SPI master transaction batch", "[spi]")
+{
+    spi_device_handle_t spi;
+    spi_bus_config_t buscfg=SPI_BUS_TEST_DEFAULT_CONFIG();
+    buscfg.miso_io_num = PIN_NUM_MOSI;
+    spi_device_interface_config_t devcfg=SPI_DEVICE_TEST_DEFAULT_CONFIG();
+    devcfg.queue_size = 3;
+    devcfg.pre_cb = batch_pre_cb;
+
+    TEST_ESP_OK(spi_bus_initialize(TEST_SPI_HOST, &buscfg, 1));
+    TEST_ESP_OK(spi_bus_add_device(TEST_SPI_HOST, &devcfg, &spi));
+    //connect MOSI to two devices breaks the output, fix it.
+    spitest_gpio_output_sel(buscfg.mosi_io_num, FUNC_GPIO, spi_periph_signal[TEST_SPI_HOST].spid_out);
+
+#define TEST_BATCH_SIZE 50
+    static spi_transaction_t trans[TEST_BATCH_SIZE];
+    spi_transaction_t *batch[TEST_BATCH_SIZE];
+    WORD_ALIGNED_ATTR static uint8_t rx_buf[TEST_BATCH_SIZE][16];
+    static uint8_t tx_buf[TEST_BATCH_SIZE][16];
+    spi_transaction_t single = {
+        .flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA,
+        .length = 4*8,
+        .tx_data = { 0x12, 0x34, 0x56, 0x78 },
+        .user = (void*)0,
+    };
+
+    //alternate short commands in tx_data and data in DMA buffers, like a display driver
+    memset(trans, 0, sizeof(trans));
+    for (int i = 0; i < TEST_BATCH_SIZE; i++) {
+        trans[i].user = (void*)(i + 1);
+        if (i % 2 == 0) {
+            trans[i].flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA;
+            trans[i].length = 8;
+            trans[i].tx_data[0] = i;
+        } else {
+            for (int j = 0; j < sizeof(tx_buf[i]); j++) {
+                tx_buf[i][j] = i + j;
+            }
+            trans[i].length = sizeof(tx_buf[i]) * 8;
+            trans[i].tx_buffer = tx_buf[i];
+            trans[i].rx_buffer = rx_buf[i];
+        }
+        batch[i] = &trans[i];
+    }
+
+    batch_pre_cb_count = 0;
+    spi_transaction_t *ret_trans;
+    spi_transaction_t **ret_batch;
+    int ret_count;
+    TEST_ESP_OK(spi_device_queue_trans(spi, &single, portMAX_DELAY));
+    TEST_ESP_OK(spi_device_queue_trans_batch(spi, batch, TEST_BATCH_SIZE, portMAX_DELAY));
+    //results are returned in order, and of the right kind only
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, spi_device_get_trans_batch_result(spi, &ret_batch, &ret_count, portMAX_DELAY));
+    TEST_ESP_OK(spi_device_get_trans_result(spi, &ret_trans, portMAX_DELAY));
+    TEST_ASSERT(ret_trans == &single);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, spi_device_get_trans_result(spi, &ret_trans, portMAX_DELAY));
+    TEST_ESP_OK(spi_device_get_trans_batch_result(spi, &ret_batch, &ret_count, portMAX_DELAY));
+    TEST_ASSERT(ret_batch == batch);
+    TEST_ASSERT_EQUAL(TEST_BATCH_SIZE, ret_count);
+    TEST_ASSERT_EQUAL(TEST_BATCH_SIZE + 1, batch_pre_cb_count);
+
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(single.tx_data, single.rx_data, 4);
+    for (int i = 0; i < TEST_BATCH_SIZE; i++) {
+        if (i % 2 == 0) {
+            TEST_ASSERT_EQUAL_HEX8(trans[i].tx_data[0], trans[i].rx_data[0]);
+        } else {
+            TEST_ASSERT_EQUAL_HEX8_ARRAY(tx_buf[i], rx_buf[i], sizeof(tx_buf[i]));
+        }
+    }
+
+    master_free_device_bus(spi);
+}
+
+TEST_CASE("SPI master bounce pool and SPI_TRANS_NO_BOUNCE", "[spi]")
+{
+    spi_device_handle_t spi;
+    spi_bus_config_t buscfg=SPI_BUS_TEST_DEFAULT_CONFIG();
+    buscfg.miso_io_num = PIN_NUM_MOSI;
+    spi_device_interface_config_t devcfg=SPI_DEVICE_TEST_DEFAULT_CONFIG();
+
+    TEST_ESP_OK(spi_bus_initialize(TEST_SPI_HOST, &buscfg, 1));
+    TEST_ESP_OK(spi_bus_add_device(TEST_SPI_HOST, &devcfg, &spi));
+    //connect MOSI to two devices breaks the output, fix it.
+    spitest_gpio_output_sel(buscfg.mosi_io_num, FUNC_GPIO, spi_periph_signal[TEST_SPI_HOST].spid_out);
+    TEST_ESP_OK(spi_device_alloc_bounce_pool(spi, 68, 2));
+
+    //data in flash is not DMA-capable, the rx buffer is not aligned
+    WORD_ALIGNED_ATTR uint8_t rx_buf[320+4];
+    spi_transaction_t t = {
+        .length = 64*8,
+        .tx_buffer = data_drom,
+        .rx_buffer = rx_buf+1,
+    };
+    spi_device_bounce_stats_t stats;
+
+    TEST_ESP_OK(spi_device_transmit(spi, &t));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(data_drom, rx_buf+1, 64);
+    TEST_ESP_OK(spi_device_get_bounce_stats(spi, &stats));
+    TEST_ASSERT_EQUAL(1, stats.tx_bounces);
+    TEST_ASSERT_EQUAL(1, stats.rx_bounces);
+    TEST_ASSERT_EQUAL(0, stats.heap_allocs);
+
+    //too big for the buffers of the pool
+    t.length = 320*8;
+    TEST_ESP_OK(spi_device_transmit(spi, &t));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(data_drom, rx_buf+1, 320);
+    TEST_ESP_OK(spi_device_get_bounce_stats(spi, &stats));
+    //taken from the shared DMA bounce pool if there is one
+    TEST_ASSERT_EQUAL(2, stats.heap_allocs + stats.shared_chunks);
+
+    t.flags = SPI_TRANS_NO_BOUNCE;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, spi_device_transmit(spi, &t));
+    t.tx_buffer = data_dram;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, spi_device_transmit(spi, &t));
+    t.rx_buffer = rx_buf;
+    TEST_ESP_OK(spi_device_transmit(spi, &t));
+    TEST_ESP_OK(spi_device_get_bounce_stats(spi, &stats));
+    TEST_ASSERT_EQUAL(2, stats.tx_bounces);
+    TEST_ASSERT_EQUAL(2, stats.rx_bounces);
+
+    master_free_device_bus(spi);
+}
@@ -7,6 +7,7 @@
 #include "driver/spi_master.h"
 #include "driver/spi_slave.h"
 #include "esp_log.h"
+#include "freertos/ringbuf.h"
 #include "sdkconfig.h"
 #include "test/test_common_spi.h"
 
@@ -139,4 +140,66 @@ TEST_CASE("test slave send unaligned","[spi]")
     ESP_LOGI(MASTER_TAG, "test passed.");
 }
 
+TEST_CASE("test slave ring reception","[spi]")
+{
+    const int trans_len = 40, trans_num = 64, segment_size = 64;
+    WORD_ALIGNED_ATTR uint8_t master_txbuf[40];
+    RingbufHandle_t ringbuf = xRingbufferCreate(4096, RINGBUF_TYPE_BYTEBUF);
+    TEST_ASSERT_NOT_NULL(ringbuf);
+
+    spi_device_handle_t spi;
+    master_init_nodma( &spi );
+    slave_init();
+    spi_slave_ring_config_t ring_cfg = {
+        .segment_size = segment_size,
+        .segment_num = 8,
+        .ringbuf = ringbuf,
+    };
+    TEST_ESP_OK(spi_slave_start_ring_rx(TEST_SLAVE_HOST, &ring_cfg));
+    //no transactions while the ring is running
+    spi_slave_transaction_t slave_t = { .length = 8*32, .rx_buffer = NULL };
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, spi_slave_queue_trans(TEST_SLAVE_HOST, &slave_t, 0));
+
+    //do internal connection
+    int_connect( PIN_NUM_MOSI,  HSPID_OUT_IDX,   VSPIQ_IN_IDX );
+    int_connect( PIN_NUM_MISO,  VSPIQ_OUT_IDX,   HSPID_IN_IDX );
+    int_connect( PIN_NUM_CS,    HSPICS0_OUT_IDX, VSPICS0_IN_IDX );
+    int_connect( PIN_NUM_CLK,   HSPICLK_OUT_IDX, VSPICLK_IN_IDX );
+
+    //transactions don't line up with the segments, the data should come out as one stream
+    for (int i = 0; i < trans_num; i++) {
+        for (int j = 0; j < trans_len; j++) {
+            master_txbuf[j] = i * trans_len + j;
+        }
+        spi_transaction_t t = {
+            .length = trans_len * 8,
+            .tx_buffer = master_txbuf,
+        };
+        TEST_ESP_OK(spi_device_transmit(spi, &t));
+    }
+
+    int received = 0;
+    while (received < trans_len * trans_num) {
+        size_t len;
+        uint8_t *data = xRingbufferReceiveUpTo(ringbuf, &len, 1000 / portTICK_PERIOD_MS, trans_len * trans_num - received);
+        TEST_ASSERT_NOT_NULL(data);
+        for (int i = 0; i < len; i++) {
+            TEST_ASSERT_EQUAL_HEX8((uint8_t)(received + i), data[i]);
+        }
+        received += len;
+        vRingbufferReturnItem(ringbuf, data);
+    }
+    spi_slave_ring_stats_t stats;
+    TEST_ESP_OK(spi_slave_get_ring_stats(TEST_SLAVE_HOST, &stats));
+    TEST_ASSERT_EQUAL(trans_len * trans_num / segment_size, stats.segments);
+    TEST_ASSERT_EQUAL(0, stats.overflows);
+    TEST_ASSERT_EQUAL(0, stats.dropped);
+    TEST_ESP_OK(spi_slave_stop_ring_rx(TEST_SLAVE_HOST));
+
+    TEST_ASSERT(spi_slave_free(TEST_SLAVE_HOST) == ESP_OK);
+    TEST_ASSERT(spi_bus_remove_device(spi) == ESP_OK);
+    TEST_ASSERT(spi_bus_free(TEST_SPI_HOST) == ESP_OK);
+    vRingbufferDelete(ringbuf);
+}
+
 #endif // !CONFIG_SPIRAM_SUPPORT
@@ -326,3 +326,101 @@ static void rs485_master()
 */
 TEST_CASE_MULTIPLE_DEVICES("RS485 half duplex uart multiple devices test.", "[driver_RS485][test_env=UT_T2_RS485]", rs485_master, rs485_slave);
 
+
+TEST_CASE("test uart dma mode loopback", "[uart]")
+{
+    const int len = 5000;
+    uint8_t *wr = malloc(len);
+    uint8_t *rd = malloc(len);
+    TEST_ASSERT(wr != NULL && rd != NULL);
+    for (int i = 0; i < len; i++) {
+        wr[i] = esp_random();
+    }
+    uart_config_t uart_config = {
+        .baud_rate = 2000000,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+    };
+    TEST_ESP_OK(uart_param_config(UART_NUM1, &uart_config));
+    TEST_ESP_OK(uart_set_pin(UART_NUM1, UART1_TX_PIN, UART1_RX_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
+    TEST_ESP_OK(uart_driver_install(UART_NUM1, len + 1, 0, 0, NULL, 0));
+    uart_dma_config_t dma_config = {
+        .rx_dma_buf_size = 1024,
+        .tx_dma_buf_size = 1024,
+        .rx_idle_thresh = 20,
+    };
+    TEST_ESP_OK(uart_enable_dma(UART_NUM1, &dma_config));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, uart_enable_dma(UART_NUM1, &dma_config));
+    UART1.conf0.loopback = 1;
+
+    // a bulk transfer spanning several descriptors and TX buffers
+    TEST_ASSERT_EQUAL(len, uart_write_bytes(UART_NUM1, (const char *)wr, len));
+    TEST_ASSERT_EQUAL(len, uart_read_bytes(UART_NUM1, rd, len, PACKET_READ_TICS));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(wr, rd, len);
+
+    // a short packet is delivered once the line goes idle
+    TEST_ASSERT_EQUAL(10, uart_write_bytes(UART_NUM1, (const char *)wr, 10));
+    TEST_ASSERT_EQUAL(10, uart_read_bytes(UART_NUM1, rd, 10, 10 / portTICK_RATE_MS));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(wr, rd, 10);
+
+    uint32_t overflows;
+    TEST_ESP_OK(uart_get_dma_rx_overflows(UART_NUM1, &overflows));
+    TEST_ASSERT_EQUAL(0, overflows);
+
+    // back to the FIFO interrupts
+    TEST_ESP_OK(uart_disable_dma(UART_NUM1));
+    TEST_ASSERT_EQUAL(100, uart_write_bytes(UART_NUM1, (const char *)wr, 100));
+    TEST_ASSERT_EQUAL(100, uart_read_bytes(UART_NUM1, rd, 100, PACKET_READ_TICS));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(wr, rd, 100);
+
+    UART1.conf0.loopback = 0;
+    uart_driver_delete(UART_NUM1);
+    free(wr);
+    free(rd);
+}
+
+TEST_CASE("test uart read acquire and release", "[uart]")
+{
+    const char *msg = "$GPGGA,123519,4807.038,N*47\r\n";
+    const int msg_len = strlen(msg);
+    const uint8_t *data;
+    uint8_t rd[64];
+
+    uart_config(UART_BAUD_115200, false);
+    UART1.conf0.loopback = 1;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, uart_read_release(UART_NUM1, 0));
+    TEST_ASSERT_EQUAL(0, uart_read_acquire(UART_NUM1, &data, sizeof(rd), 10 / portTICK_RATE_MS));
+    TEST_ASSERT_NULL(data);
+
+    uart_write_bytes(UART_NUM1, msg, msg_len);
+    uart_wait_tx_done(UART_NUM1, PACKET_READ_TICS);
+    vTaskDelay(10 / portTICK_RATE_MS);
+
+    // consume the data in place in two steps, the rest is left for uart_read_bytes
+    int len = uart_read_acquire(UART_NUM1, &data, 7, PACKET_READ_TICS);
+    TEST_ASSERT_EQUAL(7, len);
+    TEST_ASSERT_EQUAL(-1, uart_read_acquire(UART_NUM1, &data, 7, 0));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(msg, data, 7);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, uart_read_release(UART_NUM1, 8));
+    TEST_ESP_OK(uart_read_release(UART_NUM1, 6));
+    len = uart_read_acquire(UART_NUM1, &data, sizeof(rd), PACKET_READ_TICS);
+    TEST_ASSERT_GREATER_THAN(0, len);
+    TEST_ASSERT_EQUAL(',', data[0]);
+    TEST_ESP_OK(uart_read_release(UART_NUM1, 1));
+
+    int total = 7;
+    while (total < msg_len) {
+        len = uart_read_bytes(UART_NUM1, rd + total, msg_len - total, PACKET_READ_TICS);
+        TEST_ASSERT_GREATER_THAN(0, len);
+        total += len;
+    }
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(msg + 7, rd + 7, msg_len - 7);
+    size_t buffered;
+    TEST_ESP_OK(uart_get_buffered_data_len(UART_NUM1, &buffered));
+    TEST_ASSERT_EQUAL(0, buffered);
+
+    UART1.conf0.loopback = 0;
+    uart_driver_delete(UART_NUM1);
+}
@@ -14,6 +14,7 @@
 #include <string.h>
 #include "esp_log.h"
 #include "esp_err.h"
+#include "esp_attr.h"
 #include "esp_intr_alloc.h"
 #include "esp_intr_alloc.h"
 #include "freertos/FreeRTOS.h"
@@ -55,6 +56,16 @@ esp_err_t timer_get_counter_value(timer_group_t group_num, timer_idx_t timer_num
     return ESP_OK;
 }
 
+uint64_t IRAM_ATTR timer_group_get_counter_value_in_isr(timer_group_t group_num, timer_idx_t timer_num)
+{
+    portENTER_CRITICAL_ISR(&timer_spinlock[group_num]);
+    TG[group_num]->hw_timer[timer_num].update = 1;
+    uint64_t timer_val = ((uint64_t) TG[group_num]->hw_timer[timer_num].cnt_high << 32)
+        | (TG[group_num]->hw_timer[timer_num].cnt_low);
+    portEXIT_CRITICAL_ISR(&timer_spinlock[group_num]);
+    return timer_val;
+}
+
 esp_err_t timer_get_counter_time_sec(timer_group_t group_num, timer_idx_t timer_num, double* time)
 {
     TIMER_CHECK(group_num < TIMER_GROUP_MAX, TIMER_GROUP_NUM_ERROR, ESP_ERR_INVALID_ARG);
@@ -27,6 +27,10 @@
 #include "freertos/ringbuf.h"
 #include "soc/dport_reg.h"
 #include "soc/uart_struct.h"
+#include "soc/uhci_struct.h"
+#include "soc/uhci_reg.h"
+#include "esp32/rom/lldesc.h"
+#include "esp_heap_caps.h"
 #include "driver/uart.h"
 #include "driver/gpio.h"
 #include "driver/uart_select.h"
@@ -49,6 +53,9 @@ static const char* UART_TAG = "uart";
 #define UART_TX_IDLE_NUM_DEFAULT   (0)
 #define UART_PATTERN_DET_QLEN_DEFAULT (10)
 #define UART_MIN_WAKEUP_THRESH      (2)
+#define UART_DMA_DESC_BUF_MAX       (4092)
+#define UART_DMA_RX_DESC_NUM_MIN    (4)
+#define UHCI_NUM_MAX                (2)
 
 #define UART_ENTER_CRITICAL_ISR(mux)    portENTER_CRITICAL_ISR(mux)
 #define UART_EXIT_CRITICAL_ISR(mux)     portEXIT_CRITICAL_ISR(mux)
@@ -74,6 +81,21 @@ typedef struct {
     int* data;
 } uart_pat_rb_t;
 
+typedef struct {
+    int uhci_num;                       /*!< UHCI controller attached to the UART*/
+    intr_handle_t intr_handle;          /*!< UHCI interrupt handle*/
+    uint8_t* rx_buf;                    /*!< Circular DMA RX buffer*/
+    lldesc_t* rx_desc;                  /*!< Circular list of RX descriptors over rx_buf*/
+    int rx_desc_num;                    /*!< Number of RX descriptors*/
+    int rx_next;                        /*!< Next RX descriptor to be handed to the RX ring buffer*/
+    bool rx_stalled;                    /*!< The DMA ran out of RX descriptors and needs a restart*/
+    uint32_t rx_overflows;              /*!< Number of times the DMA ran out of RX descriptors*/
+    uint8_t* tx_buf;                    /*!< DMA TX buffer*/
+    lldesc_t* tx_desc;                  /*!< TX descriptors over tx_buf*/
+    int tx_buf_size;                    /*!< Size of tx_buf*/
+    SemaphoreHandle_t tx_done_sem;      /*!< Given by the UHCI interrupt when tx_buf has been sent*/
+} uart_dma_t;
+
 typedef struct {
     uart_port_t uart_num;               /*!< UART port number*/
     int queue_size;                     /*!< UART event queue size*/
@@ -91,6 +113,8 @@ typedef struct {
     int rx_cur_remain;                  /*!< Data number that waiting to be read out in ring buffer item*/
     uint8_t* rx_ptr;                    /*!< pointer to the current data in ring buffer*/
     uint8_t* rx_head_ptr;               /*!< pointer to the head of RX item*/
+    bool rx_acquired;                   /*!< Data handed out by uart_read_acquire, rx_mux is held until uart_read_release */
+    uint32_t rx_acquired_len;           /*!< Number of bytes handed out by uart_read_acquire */
     uint8_t rx_data_buf[UART_FIFO_LEN]; /*!< Data buffer to stash FIFO data*/
     uint8_t rx_stash_len;               /*!< stashed data length.(When using flow control, after reading out FIFO data, if we fail to push to buffer, we can just stash them.) */
     uart_pat_rb_t rx_pattern_pos;
@@ -111,6 +135,7 @@ typedef struct {
     uint8_t tx_brk_len;                 /*!< TX break signal cycle length/number */
     uint8_t tx_waiting_brk;             /*!< Flag to indicate that TX FIFO is ready to send break signal after FIFO is empty, do not push data into TX FIFO right now.*/
     uart_select_notif_callback_t uart_select_notif_callback; /*!< Notification about select() events */
+    uart_dma_t* dma;                    /*!< DMA mode state, NULL if the data goes through the FIFO interrupts */
 } uart_obj_t;
 
 static uart_obj_t *p_uart_obj[UART_NUM_MAX] = {0};
@@ -118,6 +143,9 @@ static uart_obj_t *p_uart_obj[UART_NUM_MAX] = {0};
 static DRAM_ATTR uart_dev_t* const UART[UART_NUM_MAX] = {&UART0, &UART1, &UART2};
 static portMUX_TYPE uart_spinlock[UART_NUM_MAX] = {portMUX_INITIALIZER_UNLOCKED, portMUX_INITIALIZER_UNLOCKED, portMUX_INITIALIZER_UNLOCKED};
 static portMUX_TYPE uart_selectlock = portMUX_INITIALIZER_UNLOCKED;
+static uhci_dev_t* const UHCI[UHCI_NUM_MAX] = {&UHCI0, &UHCI1};
+static uart_port_t uhci_owner[UHCI_NUM_MAX] = {UART_NUM_MAX, UART_NUM_MAX};
+static portMUX_TYPE uhci_spinlock = portMUX_INITIALIZER_UNLOCKED;
 
 esp_err_t uart_set_word_length(uart_port_t uart_num, uart_word_length_t data_bit)
 {
@@ -743,6 +771,7 @@ static void uart_rx_intr_handler_default(void *param)
     while(uart_intr_status != 0x0) {
         buf_idx = 0;
         uart_event.type = UART_EVENT_MAX;
+        uart_event.timeout_flag = false;
         if(uart_intr_status & UART_TXFIFO_EMPTY_INT_ST_M) {
             uart_clear_intr_status(uart_num, UART_TXFIFO_EMPTY_INT_CLR_M);
             uart_disable_intr_mask_from_isr(uart_num, UART_TXFIFO_EMPTY_INT_ENA_M);
@@ -880,6 +909,7 @@ static void uart_rx_intr_handler_default(void *param)
                     uart_clear_intr_status(uart_num, UART_RXFIFO_TOUT_INT_CLR_M | UART_RXFIFO_FULL_INT_CLR_M);
                     uart_event.type = UART_DATA;
                     uart_event.size = rx_fifo_len;
+                    uart_event.timeout_flag = (uart_intr_status & UART_RXFIFO_TOUT_INT_ST_M) ? true : false;
                     UART_ENTER_CRITICAL_ISR(&uart_selectlock);
                     if (p_uart->uart_select_notif_callback) {
                         p_uart->uart_select_notif_callback(uart_num, UART_SELECT_READ_NOTIF, &HPTaskAwoken);
@@ -1109,6 +1139,272 @@ int uart_tx_chars(uart_port_t uart_num, const char* buffer, uint32_t len)
     return tx_len;
 }
 
+/*-------------------------------------------------------------------------------------
+ *                      DMA (UHCI) mode
+ *------------------------------------------------------------------------------------*/
+//Hand the RX descriptors the DMA has finished with to the RX ring buffer, and give them back to the DMA.
+//Called with uart_spinlock held, from the UHCI interrupt or from a task once there is space in the ring buffer.
+static int uart_dma_rx_process(uart_obj_t* p_uart, BaseType_t* HPTaskAwoken)
+{
+    uart_dma_t* dma = p_uart->dma;
+    int received = 0;
+
+    while (dma->rx_desc[dma->rx_next].owner == 0) {
+        lldesc_t* desc = &dma->rx_desc[dma->rx_next];
+        if (desc->length > 0) {
+            if (pdFALSE == xRingbufferSendFromISR(p_uart->rx_ring_buf, (void*) desc->buf, desc->length, HPTaskAwoken)) {
+                //Leave the descriptor to the CPU, the DMA stalls on it until uart_read_bytes makes space
+                p_uart->rx_buffer_full_flg = true;
+                break;
+            }
+            p_uart->rx_buffered_len += desc->length;
+            received += desc->length;
+        }
+        desc->length = 0;
+        desc->eof = 0;
+        desc->owner = 1;
+        dma->rx_next = (dma->rx_next + 1) % dma->rx_desc_num;
+    }
+    if (dma->rx_stalled && dma->rx_desc[dma->rx_next].owner == 1) {
+        dma->rx_stalled = false;
+        UHCI[dma->uhci_num]->dma_in_link.restart = 1;
+    }
+    return received;
+}
+
+static void uart_dma_intr_handler(void *param)
+{
+    uart_obj_t *p_uart = (uart_obj_t*) param;
+    uart_dma_t* dma = p_uart->dma;
+    uhci_dev_t* uhci = UHCI[dma->uhci_num];
+    uint32_t status = uhci->int_st.val;
+    portBASE_TYPE HPTaskAwoken = 0;
+    uart_event_t uart_event;
+    int received;
+
+    uhci->int_clr.val = status;
+    if (status & (UHCI_IN_DONE_INT_ST_M | UHCI_IN_SUC_EOF_INT_ST_M | UHCI_IN_DSCR_EMPTY_INT_ST_M)) {
+        UART_ENTER_CRITICAL_ISR(&uart_spinlock[p_uart->uart_num]);
+        if (status & UHCI_IN_DSCR_EMPTY_INT_ST_M) {
+            dma->rx_stalled = true;
+            dma->rx_overflows++;
+        }
+        received = uart_dma_rx_process(p_uart, &HPTaskAwoken);
+        UART_EXIT_CRITICAL_ISR(&uart_spinlock[p_uart->uart_num]);
+        uart_event.type = UART_EVENT_MAX;
+        uart_event.timeout_flag = false;
+        if (received > 0) {
+            uart_event.type = UART_DATA;
+            uart_event.size = received;
+            // idle EOF closes the buffer once the line has been idle for rx_idle_thresh bits
+            uart_event.timeout_flag = (status & UHCI_IN_SUC_EOF_INT_ST_M) ? true : false;
+            UART_ENTER_CRITICAL_ISR(&uart_selectlock);
+            if (p_uart->uart_select_notif_callback) {
+                p_uart->uart_select_notif_callback(p_uart->uart_num, UART_SELECT_READ_NOTIF, &HPTaskAwoken);
+            }
+            UART_EXIT_CRITICAL_ISR(&uart_selectlock);
+        } else if (p_uart->rx_buffer_full_flg) {
+            uart_event.type = UART_BUFFER_FULL;
+        }
+        if (uart_event.type != UART_EVENT_MAX && p_uart->xQueueUart) {
+            if (pdFALSE == xQueueSendFromISR(p_uart->xQueueUart, (void * )&uart_event, &HPTaskAwoken)) {
+                ESP_EARLY_LOGV(UART_TAG, "UART event queue full");
+            }
+        }
+    }
+    if (status & UHCI_OUT_EOF_INT_ST_M) {
+        xSemaphoreGiveFromISR(dma->tx_done_sem, &HPTaskAwoken);
+    }
+    if (HPTaskAwoken == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+//Send data through the DMA TX buffer, called with tx_mux taken
+static void uart_dma_tx(uart_port_t uart_num, const char* src, size_t size)
+{
+    uart_dma_t* dma = p_uart_obj[uart_num]->dma;
+    uhci_dev_t* uhci = UHCI[dma->uhci_num];
+
+    while (size > 0) {
+        size_t send_size = size > dma->tx_buf_size ? dma->tx_buf_size : size;
+        int n = 0;
+        memcpy(dma->tx_buf, src, send_size);
+        for (size_t offset = 0; offset < send_size; offset += UART_DMA_DESC_BUF_MAX, n++) {
+            size_t len = send_size - offset > UART_DMA_DESC_BUF_MAX ? UART_DMA_DESC_BUF_MAX : send_size - offset;
+            dma->tx_desc[n].size = (len + 3) & (~3);
+            dma->tx_desc[n].length = len;
+            dma->tx_desc[n].buf = dma->tx_buf + offset;
+            dma->tx_desc[n].eof = (offset + len == send_size);
+            dma->tx_desc[n].owner = 1;
+            dma->tx_desc[n].empty = (uint32_t) &dma->tx_desc[n + 1];
+        }
+        dma->tx_desc[n - 1].empty = 0;
+        xSemaphoreTake(dma->tx_done_sem, 0);
+        uhci->dma_out_link.addr = ((uint32_t) &dma->tx_desc[0]) & UHCI_OUTLINK_ADDR_V;
+        uhci->dma_out_link.start = 1;
+        xSemaphoreTake(dma->tx_done_sem, (portTickType)portMAX_DELAY);
+        size -= send_size;
+        src += send_size;
+    }
+}
+
+static void uart_dma_free(uart_dma_t* dma)
+{
+    if (dma->tx_done_sem) {
+        vSemaphoreDelete(dma->tx_done_sem);
+    }
+    free(dma->rx_buf);
+    free(dma->rx_desc);
+    free(dma->tx_buf);
+    free(dma->tx_desc);
+    free(dma);
+}
+
+esp_err_t uart_enable_dma(uart_port_t uart_num, const uart_dma_config_t *dma_config)
+{
+    UART_CHECK((uart_num < UART_NUM_MAX), "uart_num error", ESP_ERR_INVALID_ARG);
+    UART_CHECK((dma_config), "dma config null", ESP_ERR_INVALID_ARG);
+    UART_CHECK((p_uart_obj[uart_num]), "uart driver error", ESP_ERR_INVALID_STATE);
+    UART_CHECK((p_uart_obj[uart_num]->dma == NULL), "uart dma already enabled", ESP_ERR_INVALID_STATE);
+    UART_CHECK((dma_config->rx_dma_buf_size >= UART_DMA_RX_DESC_NUM_MIN * 4), "rx dma buffer size error", ESP_ERR_INVALID_ARG);
+    UART_CHECK((dma_config->tx_dma_buf_size > 0), "tx dma buffer size error", ESP_ERR_INVALID_ARG);
+    UART_CHECK((dma_config->rx_idle_thresh > 0 && dma_config->rx_idle_thresh <= UART_RX_IDLE_THRHD_V), "rx idle thresh error", ESP_ERR_INVALID_ARG);
+    UART_CHECK((dma_config->intr_alloc_flags & ESP_INTR_FLAG_IRAM) == 0, "ESP_INTR_FLAG_IRAM set in intr_alloc_flags", ESP_ERR_INVALID_ARG);
+
+    uart_dma_t* dma = (uart_dma_t*) calloc(1, sizeof(uart_dma_t));
+    if (dma == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    dma->uhci_num = -1;
+    UART_ENTER_CRITICAL(&uhci_spinlock);
+    for (int i = 0; i < UHCI_NUM_MAX; i++) {
+        if (uhci_owner[i] == UART_NUM_MAX) {
+            uhci_owner[i] = uart_num;
+            dma->uhci_num = i;
+            break;
+        }
+    }
+    UART_EXIT_CRITICAL(&uhci_spinlock);
+    if (dma->uhci_num < 0) {
+        free(dma);
+        ESP_LOGE(UART_TAG, "no free UHCI controller");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    //Split the RX buffer into at least UART_DMA_RX_DESC_NUM_MIN word aligned pieces the DMA can fill
+    int rx_desc_num = (dma_config->rx_dma_buf_size + UART_DMA_DESC_BUF_MAX - 1) / UART_DMA_DESC_BUF_MAX;
+    if (rx_desc_num < UART_DMA_RX_DESC_NUM_MIN) {
+        rx_desc_num = UART_DMA_RX_DESC_NUM_MIN;
+    }
+    int rx_desc_size = (dma_config->rx_dma_buf_size / rx_desc_num) & (~3);
+    int tx_desc_num = (dma_config->tx_dma_buf_size + UART_DMA_DESC_BUF_MAX - 1) / UART_DMA_DESC_BUF_MAX;
+    dma->rx_desc_num = rx_desc_num;
+    dma->tx_buf_size = dma_config->tx_dma_buf_size;
+    dma->rx_buf = heap_caps_malloc(rx_desc_num * rx_desc_size, MALLOC_CAP_DMA);
+    dma->rx_desc = heap_caps_calloc(rx_desc_num, sizeof(lldesc_t), MALLOC_CAP_DMA);
+    dma->tx_buf = heap_caps_malloc(dma->tx_buf_size, MALLOC_CAP_DMA);
+    dma->tx_desc = heap_caps_calloc(tx_desc_num, sizeof(lldesc_t), MALLOC_CAP_DMA);
+    dma->tx_done_sem = xSemaphoreCreateBinary();
+    if (!dma->rx_buf || !dma->rx_desc || !dma->tx_buf || !dma->tx_desc || !dma->tx_done_sem) {
+        ESP_LOGE(UART_TAG, "UART DMA malloc error");
+        uhci_owner[dma->uhci_num] = UART_NUM_MAX;
+        uart_dma_free(dma);
+        return ESP_ERR_NO_MEM;
+    }
+    for (int i = 0; i < rx_desc_num; i++) {
+        dma->rx_desc[i].size = rx_desc_size;
+        dma->rx_desc[i].length = 0;
+        dma->rx_desc[i].buf = dma->rx_buf + i * rx_desc_size;
+        dma->rx_desc[i].owner = 1;
+        dma->rx_desc[i].empty = (uint32_t) &dma->rx_desc[(i + 1) % rx_desc_num];
+    }
+
+    //Wait for data sent through the FIFO, and stop the UART interrupt from reading the RX FIFO
+    uart_wait_tx_done(uart_num, portMAX_DELAY);
+    uart_disable_rx_intr(uart_num);
+
+    periph_module_enable(dma->uhci_num == 0 ? PERIPH_UHCI0_MODULE : PERIPH_UHCI1_MODULE);
+    uhci_dev_t* uhci = UHCI[dma->uhci_num];
+    uhci->int_ena.val = 0;
+    uhci->int_clr.val = UINT32_MAX;
+    uhci->conf0.in_rst = 1;
+    uhci->conf0.in_rst = 0;
+    uhci->conf0.out_rst = 1;
+    uhci->conf0.out_rst = 0;
+    uhci->conf0.ahbm_fifo_rst = 1;
+    uhci->conf0.ahbm_fifo_rst = 0;
+    uhci->conf0.ahbm_rst = 1;
+    uhci->conf0.ahbm_rst = 0;
+    //Plain byte stream: no separator chars, packet headers, CRC or escaping
+    uhci->conf0.val = 0;
+    uhci->conf1.val = 0;
+    uhci->conf1.check_owner = 1;
+    uhci->escape_conf.val = 0;
+    uhci->conf0.uart0_ce = (uart_num == UART_NUM_0);
+    uhci->conf0.uart1_ce = (uart_num == UART_NUM_1);
+    uhci->conf0.uart2_ce = (uart_num == UART_NUM_2);
+    uhci->conf0.uart_idle_eof_en = 1;
+    uhci->conf0.out_eof_mode = 1;
+    UART_ENTER_CRITICAL(&uart_spinlock[uart_num]);
+    UART[uart_num]->idle_conf.rx_idle_thrhd = dma_config->rx_idle_thresh;
+    p_uart_obj[uart_num]->dma = dma;
+    UART_EXIT_CRITICAL(&uart_spinlock[uart_num]);
+
+    int intr_source = dma->uhci_num == 0 ? ETS_UHCI0_INTR_SOURCE : ETS_UHCI1_INTR_SOURCE;
+    esp_err_t ret = esp_intr_alloc(intr_source, dma_config->intr_alloc_flags, uart_dma_intr_handler, p_uart_obj[uart_num], &dma->intr_handle);
+    if (ret != ESP_OK) {
+        uart_disable_dma(uart_num);
+        return ret;
+    }
+    uhci->int_ena.val = UHCI_IN_DONE_INT_ENA_M | UHCI_IN_SUC_EOF_INT_ENA_M | UHCI_IN_DSCR_EMPTY_INT_ENA_M | UHCI_OUT_EOF_INT_ENA_M;
+    uart_reset_rx_fifo(uart_num);
+    uhci->dma_in_link.addr = ((uint32_t) &dma->rx_desc[0]) & UHCI_INLINK_ADDR_V;
+    uhci->dma_in_link.start = 1;
+    return ESP_OK;
+}
+
+esp_err_t uart_disable_dma(uart_port_t uart_num)
+{
+    UART_CHECK((uart_num < UART_NUM_MAX), "uart_num error", ESP_ERR_INVALID_ARG);
+    UART_CHECK((p_uart_obj[uart_num] && p_uart_obj[uart_num]->dma), "uart dma not enabled", ESP_ERR_INVALID_STATE);
+    uart_dma_t* dma = p_uart_obj[uart_num]->dma;
+    uhci_dev_t* uhci = UHCI[dma->uhci_num];
+
+    xSemaphoreTake(p_uart_obj[uart_num]->tx_mux, (portTickType)portMAX_DELAY);
+    xSemaphoreTake(p_uart_obj[uart_num]->rx_mux, (portTickType)portMAX_DELAY);
+    uhci->int_ena.val = 0;
+    uhci->dma_in_link.stop = 1;
+    uhci->dma_out_link.stop = 1;
+    if (dma->intr_handle) {
+        esp_intr_free(dma->intr_handle);
+    }
+    uhci->conf0.val = 0;
+    periph_module_disable(dma->uhci_num == 0 ? PERIPH_UHCI0_MODULE : PERIPH_UHCI1_MODULE);
+    UART_ENTER_CRITICAL(&uart_spinlock[uart_num]);
+    p_uart_obj[uart_num]->dma = NULL;
+    p_uart_obj[uart_num]->rx_buffer_full_flg = false;
+    UART_EXIT_CRITICAL(&uart_spinlock[uart_num]);
+    UART_ENTER_CRITICAL(&uhci_spinlock);
+    uhci_owner[dma->uhci_num] = UART_NUM_MAX;
+    UART_EXIT_CRITICAL(&uhci_spinlock);
+    uart_dma_free(dma);
+    uart_reset_rx_fifo(uart_num);
+    uart_enable_rx_intr(uart_num);
+    xSemaphoreGive(p_uart_obj[uart_num]->rx_mux);
+    xSemaphoreGive(p_uart_obj[uart_num]->tx_mux);
+    return ESP_OK;
+}
+
+esp_err_t uart_get_dma_rx_overflows(uart_port_t uart_num, uint32_t *overflows)
+{
+    UART_CHECK((uart_num < UART_NUM_MAX), "uart_num error", ESP_ERR_INVALID_ARG);
+    UART_CHECK((overflows), "overflows null", ESP_ERR_INVALID_ARG);
+    UART_CHECK((p_uart_obj[uart_num] && p_uart_obj[uart_num]->dma), "uart dma not enabled", ESP_ERR_INVALID_STATE);
+    *overflows = p_uart_obj[uart_num]->dma->rx_overflows;
+    return ESP_OK;
+}
+
 static int uart_tx_all(uart_port_t uart_num, const char* src, size_t size, bool brk_en, int brk_len)
 {
     if(size == 0) {
@@ -1119,7 +1415,9 @@ static int uart_tx_all(uart_port_t uart_num, const char* src, size_t size, bool
     //lock for uart_tx
     xSemaphoreTake(p_uart_obj[uart_num]->tx_mux, (portTickType)portMAX_DELAY);
     p_uart_obj[uart_num]->coll_det_flg = false;
-    if(p_uart_obj[uart_num]->tx_buf_size > 0) {
+    if(p_uart_obj[uart_num]->dma && !brk_en) {
+        uart_dma_tx(uart_num, src, size);
+    } else if(p_uart_obj[uart_num]->tx_buf_size > 0) {
         int max_size = xRingbufferGetMaxItemSize(p_uart_obj[uart_num]->tx_ring_buf);
         int offset = 0;
         uart_tx_data_t evt;
@@ -1181,6 +1479,18 @@ int uart_write_bytes_with_break(uart_port_t uart_num, const char* src, size_t si
 
 static bool uart_check_buf_full(uart_port_t uart_num)
 {
+    if(p_uart_obj[uart_num]->dma) {
+        //In DMA mode the data waits in the DMA RX descriptors instead of the stash buffer
+        BaseType_t HPTaskAwoken = 0;
+        int received = 0;
+        UART_ENTER_CRITICAL(&uart_spinlock[uart_num]);
+        if(p_uart_obj[uart_num]->rx_buffer_full_flg) {
+            p_uart_obj[uart_num]->rx_buffer_full_flg = false;
+            received = uart_dma_rx_process(p_uart_obj[uart_num], &HPTaskAwoken);
+        }
+        UART_EXIT_CRITICAL(&uart_spinlock[uart_num]);
+        return received > 0;
+    }
     if(p_uart_obj[uart_num]->rx_buffer_full_flg) {
         BaseType_t res = xRingbufferSend(p_uart_obj[uart_num]->rx_ring_buf, p_uart_obj[uart_num]->rx_data_buf, p_uart_obj[uart_num]->rx_stash_len, 1);
         if(res == pdTRUE) {
@@ -1195,38 +1505,62 @@ static bool uart_check_buf_full(uart_port_t uart_num)
     return false;
 }
 
+//Make sure there is a current RX ring buffer item with data left in it, called with rx_mux taken
+static bool uart_rx_get_item(uart_port_t uart_num, TickType_t ticks_to_wait)
+{
+    uint8_t* data = NULL;
+    size_t size;
+    while(p_uart_obj[uart_num]->rx_cur_remain == 0) {
+        data = (uint8_t*) xRingbufferReceive(p_uart_obj[uart_num]->rx_ring_buf, &size, (portTickType) ticks_to_wait);
+        if(data) {
+            p_uart_obj[uart_num]->rx_head_ptr = data;
+            p_uart_obj[uart_num]->rx_ptr = data;
+            p_uart_obj[uart_num]->rx_cur_remain = size;
+        } else {
+            //When using dual cores, `rx_buffer_full_flg` may read and write on different cores at same time,
+            //which may lose synchronization. So we also need to call `uart_check_buf_full` once when ringbuffer is empty
+            //to solve the possible asynchronous issues.
+            if(uart_check_buf_full(uart_num)) {
+                //This condition will never be true if `uart_read_bytes`
+                //and `uart_rx_intr_handler_default` are scheduled on the same core.
+                continue;
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+//Consume len bytes of the current RX ring buffer item, called with rx_mux taken
+static void uart_rx_consume(uart_port_t uart_num, uint32_t len)
+{
+    UART_ENTER_CRITICAL(&uart_spinlock[uart_num]);
+    p_uart_obj[uart_num]->rx_buffered_len -= len;
+    uart_pattern_queue_update(uart_num, len);
+    p_uart_obj[uart_num]->rx_ptr += len;
+    UART_EXIT_CRITICAL(&uart_spinlock[uart_num]);
+    p_uart_obj[uart_num]->rx_cur_remain -= len;
+    if(p_uart_obj[uart_num]->rx_cur_remain == 0) {
+        vRingbufferReturnItem(p_uart_obj[uart_num]->rx_ring_buf, p_uart_obj[uart_num]->rx_head_ptr);
+        p_uart_obj[uart_num]->rx_head_ptr = NULL;
+        p_uart_obj[uart_num]->rx_ptr = NULL;
+        uart_check_buf_full(uart_num);
+    }
+}
+
 int uart_read_bytes(uart_port_t uart_num, uint8_t* buf, uint32_t length, TickType_t ticks_to_wait)
 {
     UART_CHECK((uart_num < UART_NUM_MAX), "uart_num error", (-1));
     UART_CHECK((buf), "uart data null", (-1));
     UART_CHECK((p_uart_obj[uart_num]), "uart driver error", (-1));
-    uint8_t* data = NULL;
-    size_t size;
     size_t copy_len = 0;
     int len_tmp;
     if(xSemaphoreTake(p_uart_obj[uart_num]->rx_mux,(portTickType)ticks_to_wait) != pdTRUE) {
         return -1;
     }
     while(length) {
-        if(p_uart_obj[uart_num]->rx_cur_remain == 0) {
-            data = (uint8_t*) xRingbufferReceive(p_uart_obj[uart_num]->rx_ring_buf, &size, (portTickType) ticks_to_wait);
-            if(data) {
-                p_uart_obj[uart_num]->rx_head_ptr = data;
-                p_uart_obj[uart_num]->rx_ptr = data;
-                p_uart_obj[uart_num]->rx_cur_remain = size;
-            } else {
-                //When using dual cores, `rx_buffer_full_flg` may read and write on different cores at same time,
-                //which may lose synchronization. So we also need to call `uart_check_buf_full` once when ringbuffer is empty
-                //to solve the possible asynchronous issues.
-                if(uart_check_buf_full(uart_num)) {
-                    //This condition will never be true if `uart_read_bytes`
-                    //and `uart_rx_intr_handler_default` are scheduled on the same core.
-                    continue;
-                } else {
-                    xSemaphoreGive(p_uart_obj[uart_num]->rx_mux);
-                    return copy_len;
-                }
-            }
+        if(!uart_rx_get_item(uart_num, ticks_to_wait)) {
+            break;
         }
         if(p_uart_obj[uart_num]->rx_cur_remain > length) {
             len_tmp = length;
@@ -1234,26 +1568,59 @@ int uart_read_bytes(uart_port_t uart_num, uint8_t* buf, uint32_t length, TickTyp
             len_tmp = p_uart_obj[uart_num]->rx_cur_remain;
         }
         memcpy(buf + copy_len, p_uart_obj[uart_num]->rx_ptr, len_tmp);
-        UART_ENTER_CRITICAL(&uart_spinlock[uart_num]);
-        p_uart_obj[uart_num]->rx_buffered_len -= len_tmp;
-        uart_pattern_queue_update(uart_num, len_tmp);
-        p_uart_obj[uart_num]->rx_ptr += len_tmp;
-        UART_EXIT_CRITICAL(&uart_spinlock[uart_num]);
-        p_uart_obj[uart_num]->rx_cur_remain -= len_tmp;
+        uart_rx_consume(uart_num, len_tmp);
         copy_len += len_tmp;
         length -= len_tmp;
-        if(p_uart_obj[uart_num]->rx_cur_remain == 0) {
-            vRingbufferReturnItem(p_uart_obj[uart_num]->rx_ring_buf, p_uart_obj[uart_num]->rx_head_ptr);
-            p_uart_obj[uart_num]->rx_head_ptr = NULL;
-            p_uart_obj[uart_num]->rx_ptr = NULL;
-            uart_check_buf_full(uart_num);
-        }
     }
 
     xSemaphoreGive(p_uart_obj[uart_num]->rx_mux);
     return copy_len;
 }
 
+int uart_read_acquire(uart_port_t uart_num, const uint8_t** data, uint32_t max_length, TickType_t ticks_to_wait)
+{
+    UART_CHECK((uart_num < UART_NUM_MAX), "uart_num error", (-1));
+    UART_CHECK((data), "uart data null", (-1));
+    UART_CHECK((p_uart_obj[uart_num]), "uart driver error", (-1));
+    if(xSemaphoreTake(p_uart_obj[uart_num]->rx_mux,(portTickType)ticks_to_wait) != pdTRUE) {
+        return -1;
+    }
+    if(p_uart_obj[uart_num]->rx_acquired) {
+        xSemaphoreGive(p_uart_obj[uart_num]->rx_mux);
+        ESP_LOGE(UART_TAG, "uart data already acquired");
+        return -1;
+    }
+    if(max_length == 0 || !uart_rx_get_item(uart_num, ticks_to_wait)) {
+        *data = NULL;
+        xSemaphoreGive(p_uart_obj[uart_num]->rx_mux);
+        return 0;
+    }
+    uint32_t len = p_uart_obj[uart_num]->rx_cur_remain;
+    if(len > max_length) {
+        len = max_length;
+    }
+    //Keep rx_mux until uart_read_release
+    p_uart_obj[uart_num]->rx_acquired = true;
+    p_uart_obj[uart_num]->rx_acquired_len = len;
+    *data = p_uart_obj[uart_num]->rx_ptr;
+    return len;
+}
+
+esp_err_t uart_read_release(uart_port_t uart_num, uint32_t consumed)
+{
+    UART_CHECK((uart_num < UART_NUM_MAX), "uart_num error", ESP_ERR_INVALID_ARG);
+    UART_CHECK((p_uart_obj[uart_num]), "uart driver error", ESP_ERR_INVALID_STATE);
+    UART_CHECK((p_uart_obj[uart_num]->rx_acquired), "uart data not acquired", ESP_ERR_INVALID_STATE);
+    UART_CHECK((consumed <= p_uart_obj[uart_num]->rx_acquired_len), "consumed more than acquired", ESP_ERR_INVALID_ARG);
+    if(consumed > 0) {
+        uart_rx_consume(uart_num, consumed);
+    }
+    p_uart_obj[uart_num]->rx_acquired = false;
+    p_uart_obj[uart_num]->rx_acquired_len = 0;
+    xSemaphoreGive(p_uart_obj[uart_num]->rx_mux);
+    return ESP_OK;
+}
+
 esp_err_t uart_get_buffered_data_len(uart_port_t uart_num, size_t* size)
 {
     UART_CHECK((uart_num < UART_NUM_MAX), "uart_num error", ESP_FAIL);
@@ -1274,7 +1641,9 @@ esp_err_t uart_flush_input(uart_port_t uart_num)
 
     //rx sem protect the ring buffer read related functions
     xSemaphoreTake(p_uart->rx_mux, (portTickType)portMAX_DELAY);
-    uart_disable_rx_intr(p_uart_obj[uart_num]->uart_num);
+    if(p_uart->dma == NULL) {
+        uart_disable_rx_intr(p_uart_obj[uart_num]->uart_num);
+    }
     while(true) {
         if(p_uart->rx_head_ptr) {
             vRingbufferReturnItem(p_uart->rx_ring_buf, p_uart->rx_head_ptr);
@@ -1293,9 +1662,14 @@ esp_err_t uart_flush_input(uart_port_t uart_num)
                 p_uart_obj[uart_num]->rx_buffered_len = 0;
             }
             //We also need to clear the `rx_buffer_full_flg` here.
-            UART_ENTER_CRITICAL(&uart_spinlock[uart_num]);
-            p_uart_obj[uart_num]->rx_buffer_full_flg = false;
-            UART_EXIT_CRITICAL(&uart_spinlock[uart_num]);
+            //In DMA mode, clearing it would leave the DMA stalled, so give the descriptors back instead.
+            if(p_uart->dma) {
+                uart_check_buf_full(uart_num);
+            } else {
+                UART_ENTER_CRITICAL(&uart_spinlock[uart_num]);
+                p_uart_obj[uart_num]->rx_buffer_full_flg = false;
+                UART_EXIT_CRITICAL(&uart_spinlock[uart_num]);
+            }
             break;
         }
         UART_ENTER_CRITICAL(&uart_spinlock[uart_num]);
@@ -1303,7 +1677,9 @@ esp_err_t uart_flush_input(uart_port_t uart_num)
         uart_pattern_queue_update(uart_num, size);
         UART_EXIT_CRITICAL(&uart_spinlock[uart_num]);
         vRingbufferReturnItem(p_uart->rx_ring_buf, data);
-        if(p_uart_obj[uart_num]->rx_buffer_full_flg) {
+        if(p_uart->dma) {
+            uart_check_buf_full(uart_num);
+        } else if(p_uart_obj[uart_num]->rx_buffer_full_flg) {
             BaseType_t res = xRingbufferSend(p_uart_obj[uart_num]->rx_ring_buf, p_uart_obj[uart_num]->rx_data_buf, p_uart_obj[uart_num]->rx_stash_len, 1);
             if(res == pdTRUE) {
                 UART_ENTER_CRITICAL(&uart_spinlock[uart_num]);
@@ -1316,8 +1692,10 @@ esp_err_t uart_flush_input(uart_port_t uart_num)
     p_uart->rx_ptr = NULL;
     p_uart->rx_cur_remain = 0;
     p_uart->rx_head_ptr = NULL;
-    uart_reset_rx_fifo(uart_num);
-    uart_enable_rx_intr(p_uart_obj[uart_num]->uart_num);
+    if(p_uart->dma == NULL) {
+        uart_reset_rx_fifo(uart_num);
+        uart_enable_rx_intr(p_uart_obj[uart_num]->uart_num);
+    }
     xSemaphoreGive(p_uart->rx_mux);
     return ESP_OK;
 }
@@ -1411,6 +1789,9 @@ esp_err_t uart_driver_delete(uart_port_t uart_num)
         ESP_LOGI(UART_TAG, "ALREADY NULL");
         return ESP_OK;
     }
+    if(p_uart_obj[uart_num]->dma) {
+        uart_disable_dma(uart_num);
+    }
     esp_intr_free(p_uart_obj[uart_num]->intr_handle);
     uart_disable_rx_intr(uart_num);
     uart_disable_tx_intr(uart_num);
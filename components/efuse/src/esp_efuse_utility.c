@@ -36,6 +36,11 @@ static uint32_t virt_blocks[COUNT_EFUSE_BLOCKS][COUNT_EFUSE_REG_PER_BLOCK];
 /* Call the update function to seed virtual efuses during initialization */
 __attribute__((constructor)) void esp_efuse_utility_update_virt_blocks();
 
+#else
+// Copy of the efuse read registers. Reading a field takes the registers from here
+// instead of the peripheral. Loaded on first use and again after efuses are burned.
+static uint32_t shadow_blocks[COUNT_EFUSE_BLOCKS][COUNT_EFUSE_REG_PER_BLOCK];
+static volatile bool shadow_blocks_valid;
 #endif
 
 /**
@@ -70,6 +75,7 @@ static void write_reg(esp_efuse_block_t blk, unsigned int num_reg, uint32_t valu
 static uint32_t fill_reg(int bit_start_in_reg, int bit_count_in_reg, uint8_t* blob, int* filled_bits_blob);
 static uint32_t set_cnt_in_reg(int bit_start_in_reg, int bit_count_used_in_reg, uint32_t reg_masked, size_t* cnt);
 static bool check_range_of_bits(esp_efuse_block_t blk, int offset_in_bits, int size_bits);
+static void read_r_data(esp_efuse_block_t num_block, uint32_t* buf_r_data);
 
 // This function processes the field by calling the passed function.
 esp_err_t esp_efuse_utility_process(const esp_efuse_desc_t* field[], void* ptr, size_t ptr_size_bits, efuse_func_proc_t func_proc)
@@ -112,26 +118,16 @@ esp_err_t esp_efuse_utility_process(const esp_efuse_desc_t* field[], void* ptr,
 // Read efuse register and write this value to array.
 esp_err_t esp_efuse_utility_fill_buff(unsigned int num_reg, esp_efuse_block_t efuse_block, int bit_start, int bit_count, void* arr_out, int* bits_counter)
 {
-    uint8_t* blob = (uint8_t *) arr_out;
+    uint8_t* blob = (uint8_t *) arr_out + (*bits_counter) / 8;
     uint32_t reg = esp_efuse_utility_read_reg(efuse_block, num_reg);
-    uint64_t reg_of_aligned_bits = (reg >> bit_start) & get_mask(bit_count, 0);
-
     int shift_bit = (*bits_counter) % 8;
-    if (shift_bit != 0) {
-        blob[(*bits_counter) / 8] |= (uint8_t)(reg_of_aligned_bits << shift_bit);
-        shift_bit = ((8 - shift_bit) < bit_count) ? (8 - shift_bit) : bit_count;
-        (*bits_counter) += shift_bit;
-        bit_count -= shift_bit;
-    }
+    // The bits of the register, placed at their position in the first byte they go to.
+    uint64_t bits = (uint64_t)((reg >> bit_start) & get_mask(bit_count, 0)) << shift_bit;
 
-    int sum_shift = 0;
-    while (bit_count > 0) {
-        sum_shift += shift_bit;
-        blob[(*bits_counter) / 8] |= (uint8_t)(reg_of_aligned_bits >> sum_shift);
-        shift_bit = (bit_count > 8) ? 8 : bit_count;
-        (*bits_counter) += shift_bit;
-        bit_count -= shift_bit;
-    };
+    for (int i = 0; i < (shift_bit + bit_count + 7) / 8; ++i) {
+        blob[i] |= (uint8_t)(bits >> (i * 8));
+    }
+    (*bits_counter) += bit_count;
     return ESP_OK;
 }
 
@@ -216,6 +212,8 @@ void esp_efuse_utility_burn_efuses(void)
     REG_WRITE(EFUSE_CONF_REG, EFUSE_CONF_READ);
     REG_WRITE(EFUSE_CMD_REG,  EFUSE_CMD_READ);
     while (REG_READ(EFUSE_CMD_REG) != 0) {};
+    // The read registers now hold the new values.
+    shadow_blocks_valid = false;
 #endif
     esp_efuse_utility_reset();
 }
@@ -305,7 +303,13 @@ uint32_t esp_efuse_utility_read_reg(esp_efuse_block_t blk, unsigned int num_reg)
 #ifdef CONFIG_EFUSE_VIRTUAL
     value = virt_blocks[blk][num_reg];
 #else
-    value = REG_READ(range_read_addr_blocks[blk].start + num_reg * 4);
+    if (!shadow_blocks_valid) {
+        for (int num_block = 0; num_block < COUNT_EFUSE_BLOCKS; num_block++) {
+            read_r_data(num_block, shadow_blocks[num_block]);
+        }
+        shadow_blocks_valid = true;
+    }
+    value = shadow_blocks[blk][num_reg];
 #endif
     return value;
 }
@@ -332,7 +336,7 @@ static uint32_t get_mask(unsigned int bit_count, unsigned int shift)
 {
     uint32_t mask;
     if (bit_count != 32) {
-        mask = (1 << bit_count) - 1;
+        mask = (1U << bit_count) - 1;
     } else {
         mask = 0xFFFFFFFF;
     }
@@ -360,19 +364,14 @@ static int get_starting_bit_num_in_reg(int bit_start, int i_reg)
 // Returns the number of bits in the register.
 static int get_count_bits_in_reg(int bit_start, int bit_count, int i_reg)
 {
-    int ret_count = 0;
-    int num_reg = 0;
     int last_used_bit = (bit_start + bit_count - 1);
-    for (int num_bit = bit_start; num_bit <= last_used_bit; ++num_bit) {
-        ++ret_count;
-        if ((((num_bit + 1) % 32) == 0) || (num_bit == last_used_bit)) {
-            if (i_reg == num_reg++) {
-                return ret_count;
-            }
-            ret_count = 0;
-        }
+    int num_reg = bit_start / 32 + i_reg;
+    if (bit_count <= 0 || num_reg > last_used_bit / 32) {
+        return 0;
     }
-    return 0;
+    int first_bit = (i_reg == 0) ? bit_start % 32 : 0;
+    int last_bit = (num_reg == last_used_bit / 32) ? last_used_bit % 32 : 31;
+    return last_bit - first_bit + 1;
 }
 
 // fill efuse register from array.
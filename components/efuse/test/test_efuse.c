@@ -11,6 +11,7 @@
 #include "../src/esp_efuse_utility.h"
 #include "esp_efuse_test_table.h"
 #include "esp32/rom/efuse.h"
+#include "soc/efuse_reg.h"
 #include "bootloader_random.h"
 #include "sdkconfig.h"
 
@@ -81,6 +82,24 @@ TEST_CASE("efuse test read_field_cnt", "[efuse]")
     test_read_cnt();
 }
 
+TEST_CASE("efuse reads match the efuse registers", "[efuse]")
+{
+    esp_efuse_utility_update_virt_blocks();
+    const uint32_t rdata_regs[] = { EFUSE_BLK0_RDATA0_REG, EFUSE_BLK1_RDATA0_REG, EFUSE_BLK2_RDATA0_REG, EFUSE_BLK3_RDATA0_REG };
+    for (int blk = EFUSE_BLK0; blk <= EFUSE_BLK3; ++blk) {
+        for (int num_reg = 0; num_reg < ((blk == EFUSE_BLK0) ? 7 : 8); ++num_reg) {
+            TEST_ASSERT_EQUAL_HEX32(REG_READ(rdata_regs[blk] + num_reg * 4), esp_efuse_read_reg(blk, num_reg));
+        }
+    }
+
+    uint8_t mac[6];
+    TEST_ESP_OK(esp_efuse_read_field_blob(ESP_EFUSE_MAC_FACTORY, &mac, sizeof(mac) * 8));
+    uint32_t mac_low = REG_READ(EFUSE_BLK0_RDATA1_REG);
+    uint32_t mac_high = REG_READ(EFUSE_BLK0_RDATA2_REG);
+    uint8_t expected[6] = { mac_high >> 8, mac_high, mac_low >> 24, mac_low >> 16, mac_low >> 8, mac_low };
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, mac, sizeof(mac));
+}
+
 // If using efuse is real, then turn off writing tests.
 #ifdef CONFIG_EFUSE_VIRTUAL
 static void test_write_blob(void)
@@ -18,12 +18,31 @@
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/lock.h>
+#include <sys/param.h>
 #include <netdb.h>
 
+#include "lwip/dns.h"
+#include "lwip/tcpip.h"
+#include "sdkconfig.h"
+
 #include <http_parser.h>
 #include "esp_tls.h"
 #include <errno.h>
 
+typedef enum {
+    ESP_TLS_DNS_PENDING = 0,
+    ESP_TLS_DNS_DONE,
+    ESP_TLS_DNS_FAILED,
+} esp_tls_dns_state_t;
+
+typedef struct esp_tls_dns_req {
+    char *hostname;
+    ip_addr_t addr;                 /*!< Resolved address, valid in ESP_TLS_DNS_DONE state */
+    esp_tls_dns_state_t state;
+    bool abandoned;                 /*!< The connection was deleted while the lookup was pending */
+} esp_tls_dns_req_t;
+
 static const char *TAG = "esp-tls";
 static mbedtls_x509_crt *global_cacert = NULL;
 
@@ -82,36 +101,31 @@ static void ms_to_timeval(int timeout_ms, struct timeval *tv)
     tv->tv_usec = (timeout_ms % 1000) * 1000;
 }
 
-static int esp_tcp_connect(const char *host, int hostlen, int port, int *sockfd, const esp_tls_cfg_t *cfg)
+static int esp_tcp_connect_addr(struct sockaddr_storage *addr, int port, int *sockfd, const esp_tls_cfg_t *cfg)
 {
     int ret = -1;
-    struct addrinfo *res = resolve_host_name(host, hostlen);
-    if (!res) {
+    socklen_t addrlen;
+
+    if (addr->ss_family == AF_INET) {
+        struct sockaddr_in *p = (struct sockaddr_in *)addr;
+        p->sin_port = htons(port);
+        addrlen = sizeof(struct sockaddr_in);
+    } else if (addr->ss_family == AF_INET6) {
+        struct sockaddr_in6 *p = (struct sockaddr_in6 *)addr;
+        p->sin6_port = htons(port);
+        addrlen = sizeof(struct sockaddr_in6);
+    } else {
+        ESP_LOGE(TAG, "Unsupported protocol family %d", addr->ss_family);
         return ret;
     }
 
-    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    int fd = socket(addr->ss_family, SOCK_STREAM, IPPROTO_TCP);
     if (fd < 0) {
-        ESP_LOGE(TAG, "Failed to create socket (family %d socktype %d protocol %d)", res->ai_family, res->ai_socktype, res->ai_protocol);
-        goto err_freeaddr;
+        ESP_LOGE(TAG, "Failed to create socket (family %d)", addr->ss_family);
+        return ret;
     }
     *sockfd = fd;
 
-    void *addr_ptr;
-    if (res->ai_family == AF_INET) {
-        struct sockaddr_in *p = (struct sockaddr_in *)res->ai_addr;
-        p->sin_port = htons(port);
-        addr_ptr = p;
-    } else if (res->ai_family == AF_INET6) {
-        struct sockaddr_in6 *p = (struct sockaddr_in6 *)res->ai_addr;
-        p->sin6_port = htons(port);
-        p->sin6_family = AF_INET6;
-        addr_ptr = p;
-    } else {
-        ESP_LOGE(TAG, "Unsupported protocol family %d", res->ai_family);
-        goto err_freesocket;
-    }
-
     if (cfg) {
         if (cfg->timeout_ms >= 0) {
             struct timeval tv;
@@ -124,21 +138,133 @@ static int esp_tcp_connect(const char *host, int hostlen, int port, int *sockfd,
         }
     }
 
-    ret = connect(fd, addr_ptr, res->ai_addrlen);
-    if (ret < 0 && !(errno == EINPROGRESS && cfg->non_block)) {
+    ret = connect(fd, (struct sockaddr *)addr, addrlen);
+    if (ret < 0 && !(errno == EINPROGRESS && cfg && cfg->non_block)) {
 
         ESP_LOGE(TAG, "Failed to connnect to host (errno %d)", errno);
-        goto err_freesocket;
+        close(fd);
+        return ret;
     }
+    return 0;
+}
 
+static int esp_tcp_connect(const char *host, int hostlen, int port, int *sockfd, const esp_tls_cfg_t *cfg)
+{
+    struct sockaddr_storage addr = { 0 };
+    struct addrinfo *res = resolve_host_name(host, hostlen);
+    if (!res) {
+        return -1;
+    }
+    memcpy(&addr, res->ai_addr, MIN(res->ai_addrlen, sizeof(addr)));
     freeaddrinfo(res);
+    return esp_tcp_connect_addr(&addr, port, sockfd, cfg);
+}
+
+/* Asynchronous DNS lookups are run by lwIP in the tcpip thread. The request is
+ * shared with that thread and, if the connection is deleted while the lookup is
+ * pending, it is freed by the DNS callback instead. */
+static _lock_t s_dns_lock;
+
+static void esp_tls_dns_found(const char *name, const ip_addr_t *ipaddr, void *arg)
+{
+    esp_tls_dns_req_t *req = arg;
+    _lock_acquire(&s_dns_lock);
+    if (req->abandoned) {
+        free(req->hostname);
+        free(req);
+    } else if (ipaddr) {
+        req->addr = *ipaddr;
+        req->state = ESP_TLS_DNS_DONE;
+    } else {
+        req->state = ESP_TLS_DNS_FAILED;
+    }
+    _lock_release(&s_dns_lock);
+}
+
+static void esp_tls_dns_start(void *arg)
+{
+    esp_tls_dns_req_t *req = arg;
+    ip_addr_t addr;
+    err_t err = dns_gethostbyname(req->hostname, &addr, esp_tls_dns_found, req);
+    if (err == ERR_OK) {
+        esp_tls_dns_found(req->hostname, &addr, req);
+    } else if (err != ERR_INPROGRESS) {
+        esp_tls_dns_found(req->hostname, NULL, req);
+    }
+}
+
+static int esp_tls_dns_request(esp_tls_t *tls, const char *hostname, int hostlen)
+{
+    esp_tls_dns_req_t *req = calloc(1, sizeof(esp_tls_dns_req_t));
+    if (!req) {
+        return -1;
+    }
+    req->hostname = strndup(hostname, hostlen);
+    if (!req->hostname) {
+        free(req);
+        return -1;
+    }
+    req->state = ESP_TLS_DNS_PENDING;
+    if (tcpip_callback(esp_tls_dns_start, req) != ERR_OK) {
+        free(req->hostname);
+        free(req);
+        return -1;
+    }
+    tls->dns_req = req;
     return 0;
+}
 
-err_freesocket:
-    close(fd);
-err_freeaddr:
-    freeaddrinfo(res);
-    return ret;
+/* Returns 0 while the lookup is pending, 1 with the address filled in once it is resolved, -1 on failure */
+static int esp_tls_dns_result(esp_tls_t *tls, struct sockaddr_storage *addr)
+{
+    esp_tls_dns_req_t *req = tls->dns_req;
+    _lock_acquire(&s_dns_lock);
+    esp_tls_dns_state_t state = req->state;
+    _lock_release(&s_dns_lock);
+
+    if (state == ESP_TLS_DNS_PENDING) {
+        return 0;
+    }
+    tls->dns_req = NULL;
+    if (state == ESP_TLS_DNS_FAILED) {
+        ESP_LOGE(TAG, "couldn't get hostname for :%s:", req->hostname);
+        free(req->hostname);
+        free(req);
+        return -1;
+    }
+    memset(addr, 0, sizeof(struct sockaddr_storage));
+    if (IP_IS_V6(&req->addr)) {
+        struct sockaddr_in6 *p = (struct sockaddr_in6 *)addr;
+        p->sin6_family = AF_INET6;
+        inet6_addr_from_ip6addr(&p->sin6_addr, ip_2_ip6(&req->addr));
+    } else {
+        struct sockaddr_in *p = (struct sockaddr_in *)addr;
+        p->sin_family = AF_INET;
+        inet_addr_from_ip4addr(&p->sin_addr, ip_2_ip4(&req->addr));
+    }
+    free(req->hostname);
+    free(req);
+    return 1;
+}
+
+static void esp_tls_dns_cancel(esp_tls_t *tls)
+{
+    esp_tls_dns_req_t *req = tls->dns_req;
+    if (!req) {
+        return;
+    }
+    tls->dns_req = NULL;
+    _lock_acquire(&s_dns_lock);
+    if (req->state == ESP_TLS_DNS_PENDING) {
+        /* Freed by esp_tls_dns_found() */
+        req->abandoned = true;
+        req = NULL;
+    }
+    _lock_release(&s_dns_lock);
+    if (req) {
+        free(req->hostname);
+        free(req);
+    }
 }
 
 esp_err_t esp_tls_init_global_ca_store()
@@ -192,6 +318,163 @@ void esp_tls_free_global_ca_store()
     }
 }
 
+#if CONFIG_ESP_TLS_CLIENT_SESSION_CACHE_SIZE > 0
+#define CLIENT_SESSION_CACHE_SIZE CONFIG_ESP_TLS_CLIENT_SESSION_CACHE_SIZE
+
+typedef struct {
+    char *host;                                 /*!< Server hostname, NULL if the entry is unused */
+    int port;
+    const unsigned char *cacert_pem_buf;        /*!< Certificates the session was verified with */
+    const unsigned char *clientcert_pem_buf;
+    bool use_global_ca_store;
+    unsigned lru_counter;
+    mbedtls_ssl_session session;
+} client_session_entry_t;
+
+static client_session_entry_t s_session_cache[CLIENT_SESSION_CACHE_SIZE];
+static unsigned s_session_lru_counter;
+static _lock_t s_session_cache_lock;
+
+/* Must be called with the cache lock held */
+static client_session_entry_t *session_cache_find(const char *hostname, size_t hostlen, int port, const esp_tls_cfg_t *cfg)
+{
+    for (int i = 0; i < CLIENT_SESSION_CACHE_SIZE; i++) {
+        client_session_entry_t *entry = &s_session_cache[i];
+        if (entry->host && entry->port == port
+                && entry->cacert_pem_buf == cfg->cacert_pem_buf
+                && entry->clientcert_pem_buf == cfg->clientcert_pem_buf
+                && entry->use_global_ca_store == cfg->use_global_ca_store
+                && strlen(entry->host) == hostlen
+                && strncasecmp(entry->host, hostname, hostlen) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void session_cache_clear(client_session_entry_t *entry)
+{
+    free(entry->host);
+    entry->host = NULL;
+    mbedtls_ssl_session_free(&entry->session);
+}
+
+static void session_cache_resume(esp_tls_t *tls, const char *hostname, size_t hostlen, int port, const esp_tls_cfg_t *cfg)
+{
+    int ret = 0;
+    _lock_acquire(&s_session_cache_lock);
+    client_session_entry_t *entry = session_cache_find(hostname, hostlen, port, cfg);
+    if (entry) {
+        ret = mbedtls_ssl_set_session(&tls->ssl, &entry->session);
+        entry->lru_counter = ++s_session_lru_counter;
+    }
+    _lock_release(&s_session_cache_lock);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "mbedtls_ssl_set_session returned -0x%x", -ret);
+    } else if (entry) {
+        ESP_LOGD(TAG, "offering cached session");
+    }
+}
+
+static void session_cache_save(esp_tls_t *tls, const char *hostname, size_t hostlen, int port, const esp_tls_cfg_t *cfg)
+{
+    _lock_acquire(&s_session_cache_lock);
+    client_session_entry_t *entry = session_cache_find(hostname, hostlen, port, cfg);
+    if (entry == NULL) {
+        /* Take an unused entry, or replace the least recently used one */
+        for (int i = 0; i < CLIENT_SESSION_CACHE_SIZE; i++) {
+            if (entry == NULL || s_session_cache[i].host == NULL
+                    || (entry->host && s_session_cache[i].lru_counter < entry->lru_counter)) {
+                entry = &s_session_cache[i];
+            }
+        }
+        session_cache_clear(entry);
+        entry->host = strndup(hostname, hostlen);
+        if (entry->host == NULL) {
+            _lock_release(&s_session_cache_lock);
+            return;
+        }
+        entry->port = port;
+        entry->cacert_pem_buf = cfg->cacert_pem_buf;
+        entry->clientcert_pem_buf = cfg->clientcert_pem_buf;
+        entry->use_global_ca_store = cfg->use_global_ca_store;
+    }
+    int ret = mbedtls_ssl_get_session(&tls->ssl, &entry->session);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "mbedtls_ssl_get_session returned -0x%x", -ret);
+        session_cache_clear(entry);
+    }
+    entry->lru_counter = ++s_session_lru_counter;
+    _lock_release(&s_session_cache_lock);
+}
+
+static void session_cache_remove(const char *hostname, size_t hostlen, int port, const esp_tls_cfg_t *cfg)
+{
+    _lock_acquire(&s_session_cache_lock);
+    client_session_entry_t *entry = session_cache_find(hostname, hostlen, port, cfg);
+    if (entry) {
+        session_cache_clear(entry);
+    }
+    _lock_release(&s_session_cache_lock);
+}
+
+void esp_tls_flush_client_session_cache()
+{
+    _lock_acquire(&s_session_cache_lock);
+    for (int i = 0; i < CLIENT_SESSION_CACHE_SIZE; i++) {
+        session_cache_clear(&s_session_cache[i]);
+    }
+    _lock_release(&s_session_cache_lock);
+}
+
+#else
+
+static inline void session_cache_resume(esp_tls_t *tls, const char *hostname, size_t hostlen, int port, const esp_tls_cfg_t *cfg)
+{
+}
+
+static inline void session_cache_save(esp_tls_t *tls, const char *hostname, size_t hostlen, int port, const esp_tls_cfg_t *cfg)
+{
+}
+
+static inline void session_cache_remove(const char *hostname, size_t hostlen, int port, const esp_tls_cfg_t *cfg)
+{
+}
+
+void esp_tls_flush_client_session_cache()
+{
+}
+
+#endif /* CONFIG_ESP_TLS_CLIENT_SESSION_CACHE_SIZE > 0 */
+
+esp_tls_client_session_t *esp_tls_get_client_session(esp_tls_t *tls)
+{
+    if (!tls || tls->conn_state != ESP_TLS_DONE) {
+        ESP_LOGE(TAG, "esp_tls_get_client_session() needs a connection with a completed handshake");
+        return NULL;
+    }
+    esp_tls_client_session_t *client_session = calloc(1, sizeof(esp_tls_client_session_t));
+    if (!client_session) {
+        return NULL;
+    }
+    mbedtls_ssl_session_init(&client_session->saved_session);
+    int ret = mbedtls_ssl_get_session(&tls->ssl, &client_session->saved_session);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "mbedtls_ssl_get_session returned -0x%x", -ret);
+        esp_tls_free_client_session(client_session);
+        return NULL;
+    }
+    return client_session;
+}
+
+void esp_tls_free_client_session(esp_tls_client_session_t *client_session)
+{
+    if (client_session) {
+        mbedtls_ssl_session_free(&client_session->saved_session);
+        free(client_session);
+    }
+}
+
 static void verify_certificate(esp_tls_t *tls)
 {
     int flags;
@@ -263,6 +546,19 @@ static int create_ssl_handle(esp_tls_t *tls, const char *hostname, size_t hostle
         goto exit;
     }
 
+#if defined(CONFIG_ESP_TLS_MAX_FRAGMENT_LENGTH) && defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH) && MBEDTLS_SSL_IN_CONTENT_LEN < 16384
+    /* Records longer than the incoming buffer can't be received */
+#if MBEDTLS_SSL_IN_CONTENT_LEN >= 4096
+    mbedtls_ssl_conf_max_frag_len(&tls->conf, MBEDTLS_SSL_MAX_FRAG_LEN_4096);
+#elif MBEDTLS_SSL_IN_CONTENT_LEN >= 2048
+    mbedtls_ssl_conf_max_frag_len(&tls->conf, MBEDTLS_SSL_MAX_FRAG_LEN_2048);
+#elif MBEDTLS_SSL_IN_CONTENT_LEN >= 1024
+    mbedtls_ssl_conf_max_frag_len(&tls->conf, MBEDTLS_SSL_MAX_FRAG_LEN_1024);
+#else
+    mbedtls_ssl_conf_max_frag_len(&tls->conf, MBEDTLS_SSL_MAX_FRAG_LEN_512);
+#endif
+#endif
+
 #ifdef CONFIG_MBEDTLS_SSL_ALPN
     if (cfg->alpn_protos) {
         mbedtls_ssl_conf_alpn_protocols(&tls->conf, cfg->alpn_protos);
@@ -342,6 +638,7 @@ exit:
 void esp_tls_conn_delete(esp_tls_t *tls)
 {
     if (tls != NULL) {
+        esp_tls_dns_cancel(tls);
         mbedtls_cleanup(tls);
         if (tls->sockfd) {
             close(tls->sockfd);
@@ -366,8 +663,12 @@ static ssize_t tls_write(esp_tls_t *tls, const char *data, size_t datalen)
     return ret;
 }
 
-static int esp_tls_low_level_conn(const char *hostname, int hostlen, int port, const esp_tls_cfg_t *cfg, esp_tls_t *tls)
+static int esp_tls_low_level_conn(const char *hostname, int hostlen, int port, const esp_tls_cfg_t *cfg, esp_tls_t *tls, bool async)
 {
+    int ret;
+    int sockfd;
+    struct sockaddr_storage addr;
+
     if (!tls) {
         ESP_LOGE(TAG, "empty esp_tls parameter");
         return -1;
@@ -376,45 +677,68 @@ static int esp_tls_low_level_conn(const char *hostname, int hostlen, int port, c
     and in case of blocking connect these cases will get executed one after the other */
     switch (tls->conn_state) {
         case ESP_TLS_INIT:
-            ;
-            int sockfd;
-            int ret = esp_tcp_connect(hostname, hostlen, port, &sockfd, cfg);
-            if (ret < 0) {
-                return -1;
-            }
-            tls->sockfd = sockfd;
-            if (!cfg) {
-                tls->read = tcp_read;
-                tls->write = tcp_write;
-                ESP_LOGD(TAG, "non-tls connection established");
-                return 1;
+            if (async && cfg && cfg->non_block) {
+                /* Don't block the caller in getaddrinfo() */
+                if (esp_tls_dns_request(tls, hostname, hostlen) != 0) {
+                    ESP_LOGE(TAG, "Failed to start DNS lookup");
+                    tls->conn_state = ESP_TLS_FAIL;
+                    return -1;
+                }
+                tls->conn_state = ESP_TLS_RESOLVING;
+            } else {
+                ret = esp_tcp_connect(hostname, hostlen, port, &sockfd, cfg);
+                if (ret < 0) {
+                    return -1;
+                }
+                tls->sockfd = sockfd;
+                if (!cfg) {
+                    tls->read = tcp_read;
+                    tls->write = tcp_write;
+                    ESP_LOGD(TAG, "non-tls connection established");
+                    return 1;
+                }
+                tls->conn_state = ESP_TLS_CONNECTING;
             }
-            if (cfg->non_block) {
-                FD_ZERO(&tls->rset);
-                FD_SET(tls->sockfd, &tls->rset);
-                tls->wset = tls->rset;
+            /* falls through */
+        case ESP_TLS_RESOLVING:
+            if (tls->conn_state == ESP_TLS_RESOLVING) {
+                ret = esp_tls_dns_result(tls, &addr);
+                if (ret == 0) {
+                    return 0;
+                }
+                if (ret < 0 || esp_tcp_connect_addr(&addr, port, &sockfd, cfg) < 0) {
+                    tls->conn_state = ESP_TLS_FAIL;
+                    return -1;
+                }
+                tls->sockfd = sockfd;
+                tls->conn_state = ESP_TLS_CONNECTING;
             }
-            tls->conn_state = ESP_TLS_CONNECTING;
             /* falls through */
         case ESP_TLS_CONNECTING:
             if (cfg->non_block) {
                 ESP_LOGD(TAG, "connecting...");
-                struct timeval tv;
-                ms_to_timeval(cfg->timeout_ms, &tv);
+                struct timeval tv = { 0 };
+                if (!async) {
+                    ms_to_timeval(cfg->timeout_ms, &tv);
+                }
+                FD_ZERO(&tls->rset);
+                FD_SET(tls->sockfd, &tls->rset);
+                tls->wset = tls->rset;
 
                 /* In case of non-blocking I/O, we use the select() API to check whether
-                   connection has been estbalished or not*/
+                   connection has been estbalished or not. The asynchronous API only polls,
+                   so that a single task can drive many connections */
                 if (select(tls->sockfd + 1, &tls->rset, &tls->wset, NULL,
-                    cfg->timeout_ms ? &tv : NULL) == 0) {
+                    (async || cfg->timeout_ms) ? &tv : NULL) == 0) {
                     ESP_LOGD(TAG, "select() timed out");
                     return 0;
                 }
                 if (FD_ISSET(tls->sockfd, &tls->rset) || FD_ISSET(tls->sockfd, &tls->wset)) {
-                    int error;
+                    int error = 0;
                     unsigned int len = sizeof(error);
                     /* pending error check */
-                    if (getsockopt(tls->sockfd, SOL_SOCKET, SO_ERROR, &error, &len) < 0) {
-                        ESP_LOGD(TAG, "Non blocking connect failed");
+                    if (getsockopt(tls->sockfd, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error != 0) {
+                        ESP_LOGD(TAG, "Non blocking connect failed (errno %d)", error);
                         tls->conn_state = ESP_TLS_FAIL;
                         return -1;
                     }
@@ -427,6 +751,15 @@ static int esp_tls_low_level_conn(const char *hostname, int hostlen, int port, c
                 tls->conn_state = ESP_TLS_FAIL;
                 return -1;
             }
+            if (cfg->client_session) {
+                ret = mbedtls_ssl_set_session(&tls->ssl, &cfg->client_session->saved_session);
+                if (ret != 0) {
+                    /* Not fatal, the server will see a full handshake */
+                    ESP_LOGE(TAG, "mbedtls_ssl_set_session returned -0x%x", -ret);
+                }
+            } else {
+                session_cache_resume(tls, hostname, hostlen, port, cfg);
+            }
             tls->read = tls_read;
             tls->write = tls_write;
             tls->conn_state = ESP_TLS_HANDSHAKE;
@@ -436,6 +769,7 @@ static int esp_tls_low_level_conn(const char *hostname, int hostlen, int port, c
             ret = mbedtls_ssl_handshake(&tls->ssl);
             if (ret == 0) {
                 tls->conn_state = ESP_TLS_DONE;
+                session_cache_save(tls, hostname, hostlen, port, cfg);
                 return 1;
             } else {
                 if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
@@ -444,6 +778,8 @@ static int esp_tls_low_level_conn(const char *hostname, int hostlen, int port, c
                         /* This is to check whether handshake failed due to invalid certificate*/
                         verify_certificate(tls);
                     }
+                    /* Don't offer a session the server may have choked on again */
+                    session_cache_remove(hostname, hostlen, port, cfg);
                     tls->conn_state = ESP_TLS_FAIL;
                     return -1;
                 }
@@ -474,7 +810,7 @@ esp_tls_t *esp_tls_conn_new(const char *hostname, int hostlen, int port, const e
     /* esp_tls_conn_new() API establishes connection in a blocking manner thus this loop ensures that esp_tls_conn_new()
        API returns only after connection is established unless there is an error*/
     while (1) {
-        int ret = esp_tls_low_level_conn(hostname, hostlen, port, cfg, tls);
+        int ret = esp_tls_low_level_conn(hostname, hostlen, port, cfg, tls, false);
         if (ret == 1) {
             return tls;
         } else if (ret == -1) {
@@ -491,7 +827,7 @@ esp_tls_t *esp_tls_conn_new(const char *hostname, int hostlen, int port, const e
  */
 int esp_tls_conn_new_async(const char *hostname, int hostlen, int port, const esp_tls_cfg_t *cfg , esp_tls_t *tls)
 {
-    return esp_tls_low_level_conn(hostname, hostlen, port, cfg, tls);
+    return esp_tls_low_level_conn(hostname, hostlen, port, cfg, tls, true);
 }
 
 static int get_port(const char *url, struct http_parser_url *u)
@@ -36,12 +36,20 @@ extern "C" {
  */
 typedef enum esp_tls_conn_state {
     ESP_TLS_INIT = 0,
+    ESP_TLS_RESOLVING,
     ESP_TLS_CONNECTING,
     ESP_TLS_HANDSHAKE,
     ESP_TLS_FAIL,
     ESP_TLS_DONE,
 } esp_tls_conn_state_t;
 
+/**
+ * @brief      ESP-TLS client session, used to resume a previous TLS session
+ */
+typedef struct esp_tls_client_session {
+    mbedtls_ssl_session saved_session;      /*!< Copy of the negotiated session (and ticket, if any) */
+} esp_tls_client_session_t;
+
 /**
  * @brief      ESP-TLS configuration parameters 
  */ 
@@ -84,6 +92,10 @@ typedef struct esp_tls_cfg {
 
     bool use_global_ca_store;               /*!< Use a global ca_store for all the connections in which
                                                  this bool is set. */
+
+    esp_tls_client_session_t *client_session; /*!< Session to offer to the server for resumption, as returned
+                                                 by esp_tls_get_client_session(). If NULL, the session cache
+                                                 (CONFIG_ESP_TLS_CLIENT_SESSION_CACHE_SIZE) is used, if enabled */
 } esp_tls_cfg_t;
 
 /**
@@ -126,6 +138,9 @@ typedef struct esp_tls {
     fd_set rset;                                                                /*!< read file descriptors */
 
     fd_set wset;                                                                /*!< write file descriptors */
+
+    struct esp_tls_dns_req *dns_req;                                            /*!< Pending hostname lookup of a non-blocking
+                                                                                     connection */
 } esp_tls_t;
 
 /**
@@ -164,6 +179,12 @@ esp_tls_t *esp_tls_conn_http_new(const char *url, const esp_tls_cfg_t *cfg);
  * This function initiates a non-blocking TLS/SSL connection with the specified host, but due to
  * its non-blocking nature, it doesn't wait for the connection to get established.
  *
+ * None of the steps block: the hostname is resolved asynchronously by lwIP, and the TCP connect
+ * and TLS handshake only poll the socket. The function should be called again with the same
+ * arguments until it returns 1 or -1, e.g. when `tls->sockfd` becomes writable (ESP_TLS_CONNECTING)
+ * or readable (ESP_TLS_HANDSHAKE), or periodically while the hostname is being resolved
+ * (ESP_TLS_RESOLVING, the socket doesn't exist yet). Any timeout has to be applied by the caller.
+ *
  * @param[in]  hostname  Hostname of the host.
  * @param[in]  hostlen   Length of hostname.
  * @param[in]  port      Port number of the host.
@@ -313,6 +334,36 @@ mbedtls_x509_crt *esp_tls_get_global_ca_store();
  */
 void esp_tls_free_global_ca_store();
 
+/**
+ * @brief      Get a copy of the session negotiated on a TLS connection.
+ *
+ * The returned session can be set as `client_session` in esp_tls_cfg_t to resume
+ * it on a later connection to the same server, even across esp_tls_conn_delete().
+ *
+ * @param[in]  tls  pointer to esp-tls as esp-tls handle, with a completed handshake.
+ *
+ * @return
+ *             - Pointer to the saved session, to be freed with esp_tls_free_client_session()
+ *             - NULL if the handshake is not complete or memory is exhausted
+ */
+esp_tls_client_session_t *esp_tls_get_client_session(esp_tls_t *tls);
+
+/**
+ * @brief      Free a client session returned by esp_tls_get_client_session().
+ *
+ * @param[in]  client_session  session to free, may be NULL.
+ */
+void esp_tls_free_client_session(esp_tls_client_session_t *client_session);
+
+/**
+ * @brief      Drop all the sessions kept in the client session cache.
+ *
+ * Sessions in the cache stay valid until the server expires them. The application can call
+ * this API to free the memory they hold, or to force full handshakes e.g. after the CA
+ * certificates have changed.
+ */
+void esp_tls_flush_client_session_cache();
+
 
 #ifdef __cplusplus
 }
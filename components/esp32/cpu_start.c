@@ -66,6 +66,7 @@
 #include "esp_private/dbg_stubs.h"
 #include "esp_efuse.h"
 #include "esp32/spiram.h"
+#include "esp32/dma_bounce.h"
 #include "esp_clk_internal.h"
 #include "esp_timer.h"
 #include "esp_pm.h"
@@ -494,6 +495,12 @@ static void main_task(void* args)
         abort();
     }
 #endif
+#if CONFIG_SPIRAM_DMA_BOUNCE_CHUNKS
+    if (esp_dma_bounce_init(CONFIG_SPIRAM_DMA_BOUNCE_CHUNK_SIZE, CONFIG_SPIRAM_DMA_BOUNCE_CHUNKS) != ESP_OK) {
+        ESP_EARLY_LOGE(TAG, "Could not create the shared DMA bounce pool");
+        abort();
+    }
+#endif
 
     //Initialize task wdt if configured to do so
 #ifdef CONFIG_TASK_WDT_PANIC
@@ -18,6 +18,10 @@
 #include "esp_err.h"
 #include "esp_intr_alloc.h"
 #include "esp_intr_alloc.h"
+#include "esp_crosscore_int.h"
+#if CONFIG_CROSSCORE_INT_PROFILING
+#include "esp_timer.h"
+#endif
 
 #include "esp32/rom/ets_sys.h"
 #include "esp32/rom/uart.h"
@@ -40,6 +44,13 @@
 static portMUX_TYPE reason_spinlock = portMUX_INITIALIZER_UNLOCKED;
 static volatile uint32_t reason[ portNUM_PROCESSORS ];
 
+#if CONFIG_CROSSCORE_INT_PROFILING
+//Protected by reason_spinlock. send_time is the time the interrupt was raised, 0 if it
+//is not pending.
+static esp_crosscore_int_stats_t s_stats[ portNUM_PROCESSORS ];
+static int64_t s_send_time[ portNUM_PROCESSORS ];
+#endif
+
 /*
 ToDo: There is a small chance the CPU already has yielded when this ISR is serviced. In that case, it's running the intended task but
 the ISR will cause it to switch _away_ from it. portYIELD_FROM_ISR will probably just schedule the task again, but have to check that.
@@ -53,6 +64,9 @@ static void IRAM_ATTR esp_crosscore_isr(void *arg) {
     uint32_t my_reason_val;
     //A pointer to the correct reason array item is passed to this ISR.
     volatile uint32_t *my_reason=arg;
+#if CONFIG_CROSSCORE_INT_PROFILING
+    int64_t now = esp_timer_get_time();
+#endif
 
     //Clear the interrupt first.
     if (xPortGetCoreID()==0) {
@@ -64,6 +78,21 @@ static void IRAM_ATTR esp_crosscore_isr(void *arg) {
     portENTER_CRITICAL_ISR(&reason_spinlock);
     my_reason_val=*my_reason;
     *my_reason=0;
+#if CONFIG_CROSSCORE_INT_PROFILING
+    int core_id = xPortGetCoreID();
+    esp_crosscore_int_stats_t *stats = &s_stats[core_id];
+    stats->isr_count++;
+    if (s_send_time[core_id] != 0) {
+        //A request raised after this handler was entered is handled by this run too
+        uint32_t latency = (now > s_send_time[core_id]) ? now - s_send_time[core_id] : 0;
+        stats->latency_count++;
+        stats->latency_total_us += latency;
+        if (latency > stats->latency_max_us) {
+            stats->latency_max_us = latency;
+        }
+        s_send_time[core_id] = 0;
+    }
+#endif
     portEXIT_CRITICAL_ISR(&reason_spinlock);
 
     //Check what we need to do.
@@ -95,16 +124,45 @@ void esp_crosscore_int_init() {
 
 static void IRAM_ATTR esp_crosscore_int_send(int core_id, uint32_t reason_mask) {
     assert(core_id<portNUM_PROCESSORS);
-    //Mark the reason we interrupt the other CPU
+#if CONFIG_CROSSCORE_INT_PROFILING
+    int64_t now = esp_timer_get_time();
+#endif
+    //Mark the reason we interrupt the other CPU. If all the reasons are already
+    //pending, the interrupt has been raised and the ISR has not fetched them yet,
+    //so it will handle this request too. The interrupt is raised with the spinlock
+    //held, so that a pending reason always means that the interrupt is raised.
     portENTER_CRITICAL(&reason_spinlock);
+    bool pending = (reason[core_id] & reason_mask) == reason_mask;
     reason[core_id] |= reason_mask;
-    portEXIT_CRITICAL(&reason_spinlock);
-    //Poke the other CPU.
-    if (core_id==0) {
-        DPORT_WRITE_PERI_REG(DPORT_CPU_INTR_FROM_CPU_0_REG, DPORT_CPU_INTR_FROM_CPU_0);
-    } else {
-        DPORT_WRITE_PERI_REG(DPORT_CPU_INTR_FROM_CPU_1_REG, DPORT_CPU_INTR_FROM_CPU_1);
+#if CONFIG_CROSSCORE_INT_PROFILING
+    esp_crosscore_int_stats_t *stats = &s_stats[core_id];
+    if (reason_mask & REASON_YIELD) {
+        if (pending) {
+            stats->yield_coalesced++;
+        } else {
+            stats->yield_sent++;
+        }
+    }
+    if (reason_mask & REASON_FREQ_SWITCH) {
+        if (pending) {
+            stats->freq_switch_coalesced++;
+        } else {
+            stats->freq_switch_sent++;
+        }
     }
+    if (!pending && s_send_time[core_id] == 0) {
+        s_send_time[core_id] = now;
+    }
+#endif
+    if (!pending) {
+        //Poke the other CPU.
+        if (core_id==0) {
+            DPORT_WRITE_PERI_REG(DPORT_CPU_INTR_FROM_CPU_0_REG, DPORT_CPU_INTR_FROM_CPU_0);
+        } else {
+            DPORT_WRITE_PERI_REG(DPORT_CPU_INTR_FROM_CPU_1_REG, DPORT_CPU_INTR_FROM_CPU_1);
+        }
+    }
+    portEXIT_CRITICAL(&reason_spinlock);
 }
 
 void IRAM_ATTR esp_crosscore_int_send_yield(int core_id)
@@ -117,3 +175,29 @@ void IRAM_ATTR esp_crosscore_int_send_freq_switch(int core_id)
     esp_crosscore_int_send(core_id, REASON_FREQ_SWITCH);
 }
 
+esp_err_t esp_crosscore_int_get_stats(int core_id, esp_crosscore_int_stats_t *stats)
+{
+#if CONFIG_CROSSCORE_INT_PROFILING
+    if (core_id < 0 || core_id >= portNUM_PROCESSORS || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&reason_spinlock);
+    *stats = s_stats[core_id];
+    portEXIT_CRITICAL(&reason_spinlock);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t esp_crosscore_int_reset_stats(void)
+{
+#if CONFIG_CROSSCORE_INT_PROFILING
+    portENTER_CRITICAL(&reason_spinlock);
+    memset(s_stats, 0, sizeof(s_stats));
+    portEXIT_CRITICAL(&reason_spinlock);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
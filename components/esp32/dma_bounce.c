@@ -0,0 +1,266 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "soc/soc_memory_layout.h"
+#include "esp32/dma_bounce.h"
+#include "esp32/spiram.h"
+
+/*
+Shared pool of DMA-capable bounce buffers.
+
+The chunks are one block of DMA-capable memory, with a bitmask of the free chunks. Taking and returning a chunk is
+a few instructions under a spinlock, so drivers can do it from their ISRs or with the flash cache disabled. The
+pool is created once and never freed: drivers may hold on to a chunk from anywhere.
+
+A stream has at most one chunk in flight, and uses a second chunk (if one is free) to copy the data of the next
+chunk while the peripheral works on the current one.
+*/
+
+static const char *TAG = "dma_bounce";
+
+#define MAX_CHUNKS 32
+
+static uint8_t *s_storage;
+static size_t s_chunk_size;
+static size_t s_chunks;
+static uint32_t s_free_mask;
+static size_t s_min_free;
+static uint32_t s_exhausted;
+static uint64_t s_bytes;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+esp_err_t esp_dma_bounce_init(size_t chunk_size, size_t chunks)
+{
+    if (chunk_size == 0 || chunks == 0 || chunks > MAX_CHUNKS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_storage != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    chunk_size = (chunk_size + 3) & ~3;
+    uint8_t *storage = heap_caps_malloc(chunk_size * chunks, MALLOC_CAP_DMA);
+    if (storage == NULL) {
+        ESP_LOGE(TAG, "cannot allocate %u chunks of %u bytes", (unsigned) chunks, (unsigned) chunk_size);
+        return ESP_ERR_NO_MEM;
+    }
+    portENTER_CRITICAL(&s_lock);
+    s_chunk_size = chunk_size;
+    s_chunks = chunks;
+    s_free_mask = (uint32_t)((1ULL << chunks) - 1);
+    s_min_free = chunks;
+    s_storage = storage;
+    portEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
+
+size_t IRAM_ATTR esp_dma_bounce_chunk_size(void)
+{
+    return s_chunk_size;
+}
+
+void *IRAM_ATTR esp_dma_bounce_get(void)
+{
+    void *chunk = NULL;
+    portENTER_CRITICAL(&s_lock);
+    if (s_free_mask != 0) {
+        int i = __builtin_ctz(s_free_mask);
+        s_free_mask &= ~(1U << i);
+        chunk = s_storage + i * s_chunk_size;
+        size_t free_chunks = __builtin_popcount(s_free_mask);
+        if (free_chunks < s_min_free) {
+            s_min_free = free_chunks;
+        }
+    } else if (s_storage != NULL) {
+        s_exhausted++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return chunk;
+}
+
+bool IRAM_ATTR esp_dma_bounce_is_chunk(const void *ptr)
+{
+    const uint8_t *p = ptr;
+    return s_storage != NULL && p >= s_storage && p < s_storage + s_chunks * s_chunk_size;
+}
+
+void IRAM_ATTR esp_dma_bounce_put(void *chunk)
+{
+    if (chunk == NULL) {
+        return;
+    }
+    assert(esp_dma_bounce_is_chunk(chunk) && "esp_dma_bounce_put() buffer is not a chunk of the pool");
+    uint32_t bit = 1U << (((uint8_t *)chunk - s_storage) / s_chunk_size);
+    portENTER_CRITICAL(&s_lock);
+    assert((s_free_mask & bit) == 0 && "esp_dma_bounce_put() chunk returned twice");
+    s_free_mask |= bit;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static void copy(void *dst, const void *src, size_t len)
+{
+#if CONFIG_SPIRAM_SUPPORT
+    if (esp_ptr_external_ram(dst) || esp_ptr_external_ram(src)) {
+        esp_spiram_memcpy(dst, src, len);
+        return;
+    }
+#endif
+    memcpy(dst, src, len);
+}
+
+//Take one chunk, and a second one if it is free. Returns the length of the data which fits into a chunk.
+static esp_err_t stream_begin(const esp_dma_bounce_stream_t *stream, void *bufs[2], size_t *chunk_len)
+{
+    size_t align = MAX(stream->align, 1);
+    *chunk_len = s_chunk_size - s_chunk_size % align;
+    if (s_storage != NULL && *chunk_len == 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    bufs[0] = esp_dma_bounce_get();
+    if (bufs[0] == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    bufs[1] = esp_dma_bounce_get();
+    return ESP_OK;
+}
+
+static void stream_end(void *bufs[2], size_t done)
+{
+    esp_dma_bounce_put(bufs[0]);
+    esp_dma_bounce_put(bufs[1]);
+    portENTER_CRITICAL(&s_lock);
+    s_bytes += done;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static esp_err_t stream_finish(const esp_dma_bounce_stream_t *stream, size_t *done, size_t len, size_t total)
+{
+    esp_err_t err = stream->finish ? stream->finish(stream->arg) : ESP_OK;
+    if (err == ESP_OK) {
+        *done += len;
+        if (stream->progress) {
+            stream->progress(*done, total, stream->arg);
+        }
+    }
+    return err;
+}
+
+esp_err_t esp_dma_bounce_tx(const esp_dma_bounce_stream_t *stream, const void *src, size_t len)
+{
+    void *bufs[2];
+    size_t chunk_len;
+    esp_err_t err = stream_begin(stream, bufs, &chunk_len);
+    if (err != ESP_OK) {
+        return err;
+    }
+    const uint8_t *data = src;
+    size_t offset = 0;
+    size_t done = 0;
+    size_t in_flight = 0;   //length of the chunk started last and not finished yet
+    int cur = 0;
+    while (offset < len && err == ESP_OK) {
+        size_t n = MIN(chunk_len, len - offset);
+        if (in_flight && bufs[1] == NULL) {
+            //Only one chunk: it has to be sent before it's refilled
+            err = stream_finish(stream, &done, in_flight, len);
+            in_flight = 0;
+            if (err != ESP_OK) {
+                break;
+            }
+        }
+        copy(bufs[cur], data + offset, n);
+        if (in_flight) {
+            err = stream_finish(stream, &done, in_flight, len);
+            in_flight = 0;
+            if (err != ESP_OK) {
+                break;
+            }
+        }
+        err = stream->start(bufs[cur], offset, n, stream->arg);
+        if (err == ESP_OK) {
+            in_flight = n;
+            offset += n;
+            if (bufs[1] != NULL) {
+                cur ^= 1;
+            }
+        }
+    }
+    if (in_flight) {
+        err = stream_finish(stream, &done, in_flight, len);
+    }
+    stream_end(bufs, done);
+    return err;
+}
+
+esp_err_t esp_dma_bounce_rx(const esp_dma_bounce_stream_t *stream, void *dst, size_t len)
+{
+    void *bufs[2];
+    size_t chunk_len;
+    esp_err_t err = stream_begin(stream, bufs, &chunk_len);
+    if (err != ESP_OK) {
+        return err;
+    }
+    uint8_t *data = dst;
+    size_t offset = 0;      //offset of the chunk in flight
+    size_t done = 0;
+    int cur = 0;
+    size_t n = MIN(chunk_len, len);
+    if (len > 0) {
+        err = stream->start(bufs[cur], 0, n, stream->arg);
+    }
+    while (offset < len && err == ESP_OK) {
+        err = stream_finish(stream, &done, n, len);
+        if (err != ESP_OK) {
+            break;
+        }
+        void *received = bufs[cur];
+        size_t received_len = n;
+        size_t next = offset + n;
+        n = MIN(chunk_len, len - next);
+        if (n > 0 && bufs[1] != NULL) {
+            //Receive the next chunk into the other buffer while this one is copied out
+            cur ^= 1;
+            err = stream->start(bufs[cur], next, n, stream->arg);
+        }
+        copy(data + offset, received, received_len);
+        if (err == ESP_OK && n > 0 && bufs[1] == NULL) {
+            err = stream->start(bufs[cur], next, n, stream->arg);
+        }
+        offset = next;
+    }
+    stream_end(bufs, done);
+    return err;
+}
+
+void esp_dma_bounce_get_stats(esp_dma_bounce_stats_t *stats)
+{
+    portENTER_CRITICAL(&s_lock);
+    *stats = (esp_dma_bounce_stats_t) {
+        .chunk_size = s_chunk_size,
+        .chunks = s_chunks,
+        .free_chunks = __builtin_popcount(s_free_mask),
+        .min_free_chunks = s_min_free,
+        .exhausted = s_exhausted,
+        .bytes = s_bytes,
+    };
+    portEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,254 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp32/himem.h"
+#include "esp_log.h"
+
+/*
+Paged buffer on top of the himem API.
+
+The window is a range of address blocks ("slots"). Every block of the buffer is either unmapped or mapped into
+exactly one slot, so there are never two mappings of the same physical memory (see esp_himem.c for why this
+matters). When a block which isn't mapped is accessed, it goes into a free slot or replaces the block in the least
+recently used slot. Unmapping writes back the SPI RAM cache, which is what makes remaps expensive, so they are
+counted in the statistics.
+*/
+
+#define TAG "esp_himem_buf"
+
+#define NO_BLOCK (-1)
+
+typedef struct {
+    int block;              //Block of the buffer mapped in this slot, or NO_BLOCK
+    uint8_t *ptr;           //Address of the slot while a block is mapped
+    uint32_t last_use;      //Value of use_counter at the last access
+} himem_buf_slot_t;
+
+typedef struct esp_himem_buf_t {
+    esp_himem_handle_t mem;
+    esp_himem_rangehandle_t range;
+    size_t block_ct;
+    size_t slot_ct;
+    himem_buf_slot_t *slots;
+    int16_t *slot_of_block; //Slot each block is mapped in, or NO_BLOCK
+    uint32_t use_counter;
+    SemaphoreHandle_t lock;
+    esp_himem_buf_stats_t stats;
+} esp_himem_buf_t;
+
+esp_err_t esp_himem_buf_create(size_t size, size_t window_blocks, esp_himem_buf_handle_t *handle_out)
+{
+    if (size == 0 || window_blocks == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t block_ct = (size + ESP_HIMEM_BLKSZ - 1) / ESP_HIMEM_BLKSZ;
+    //A window larger than the buffer would never be filled
+    window_blocks = MIN(window_blocks, block_ct);
+
+    esp_himem_buf_t *buf = calloc(1, sizeof(esp_himem_buf_t));
+    if (buf == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    buf->block_ct = block_ct;
+    buf->slot_ct = window_blocks;
+    buf->slots = calloc(window_blocks, sizeof(himem_buf_slot_t));
+    buf->slot_of_block = malloc(block_ct * sizeof(int16_t));
+    buf->lock = xSemaphoreCreateMutex();
+    if (buf->slots == NULL || buf->slot_of_block == NULL || buf->lock == NULL) {
+        esp_himem_buf_delete(buf);
+        return ESP_ERR_NO_MEM;
+    }
+    for (size_t i = 0; i < window_blocks; i++) {
+        buf->slots[i].block = NO_BLOCK;
+    }
+    for (size_t i = 0; i < block_ct; i++) {
+        buf->slot_of_block[i] = NO_BLOCK;
+    }
+
+    esp_err_t err = esp_himem_alloc_map_range(window_blocks * ESP_HIMEM_BLKSZ, &buf->range);
+    if (err == ESP_OK) {
+        err = esp_himem_alloc(block_ct * ESP_HIMEM_BLKSZ, &buf->mem);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "cannot allocate %d blocks with a window of %d blocks", block_ct, window_blocks);
+        esp_himem_buf_delete(buf);
+        return err;
+    }
+    *handle_out = buf;
+    return ESP_OK;
+}
+
+static esp_err_t unmap_slot(esp_himem_buf_t *buf, himem_buf_slot_t *slot)
+{
+    esp_err_t err = esp_himem_unmap(buf->range, slot->ptr, ESP_HIMEM_BLKSZ);
+    if (err == ESP_OK) {
+        buf->slot_of_block[slot->block] = NO_BLOCK;
+        slot->block = NO_BLOCK;
+        slot->ptr = NULL;
+    }
+    return err;
+}
+
+esp_err_t esp_himem_buf_delete(esp_himem_buf_handle_t buf)
+{
+    esp_err_t err;
+    //Slots can only be mapped once the range exists
+    if (buf->range != NULL) {
+        for (size_t i = 0; i < buf->slot_ct; i++) {
+            if (buf->slots[i].block != NO_BLOCK) {
+                err = unmap_slot(buf, &buf->slots[i]);
+                if (err != ESP_OK) {
+                    return err;
+                }
+            }
+        }
+    }
+    if (buf->mem != NULL) {
+        err = esp_himem_free(buf->mem);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    if (buf->range != NULL) {
+        err = esp_himem_free_map_range(buf->range);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    if (buf->lock != NULL) {
+        vSemaphoreDelete(buf->lock);
+    }
+    free(buf->slots);
+    free(buf->slot_of_block);
+    free(buf);
+    return ESP_OK;
+}
+
+//Return the address of the given block, mapping it if needed. Called with the lock taken.
+static esp_err_t map_block(esp_himem_buf_t *buf, size_t block, uint8_t **out_ptr)
+{
+    himem_buf_slot_t *slot;
+    int idx = buf->slot_of_block[block];
+
+    if (idx != NO_BLOCK) {
+        slot = &buf->slots[idx];
+        buf->stats.hits++;
+    } else {
+        //Take a free slot, or else the least recently used one
+        idx = 0;
+        for (size_t i = 0; i < buf->slot_ct; i++) {
+            if (buf->slots[i].block == NO_BLOCK) {
+                idx = i;
+                break;
+            }
+            if (buf->slots[i].last_use - buf->slots[idx].last_use > UINT32_MAX / 2) {
+                //older, also when use_counter wrapped around in between
+                idx = i;
+            }
+        }
+        slot = &buf->slots[idx];
+        esp_err_t err;
+        if (slot->block != NO_BLOCK) {
+            err = unmap_slot(buf, slot);
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+        void *ptr;
+        err = esp_himem_map(buf->mem, buf->range, block * ESP_HIMEM_BLKSZ, idx * ESP_HIMEM_BLKSZ, ESP_HIMEM_BLKSZ, 0, &ptr);
+        if (err != ESP_OK) {
+            return err;
+        }
+        slot->block = block;
+        slot->ptr = ptr;
+        buf->slot_of_block[block] = idx;
+        buf->stats.remaps++;
+    }
+    slot->last_use = ++buf->use_counter;
+    *out_ptr = slot->ptr;
+    return ESP_OK;
+}
+
+esp_err_t esp_himem_buf_iterate(esp_himem_buf_handle_t buf, size_t offset, size_t len, esp_himem_buf_cb_t cb, void *arg)
+{
+    size_t size = buf->block_ct * ESP_HIMEM_BLKSZ;
+    if (offset > size || len > size - offset) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    esp_err_t err = ESP_OK;
+    xSemaphoreTake(buf->lock, portMAX_DELAY);
+    while (len > 0 && err == ESP_OK) {
+        size_t block = offset / ESP_HIMEM_BLKSZ;
+        size_t block_offset = offset % ESP_HIMEM_BLKSZ;
+        size_t chunk = MIN(len, ESP_HIMEM_BLKSZ - block_offset);
+        uint8_t *ptr;
+        err = map_block(buf, block, &ptr);
+        if (err == ESP_OK) {
+            err = cb(ptr + block_offset, offset, chunk, arg);
+        }
+        offset += chunk;
+        len -= chunk;
+    }
+    xSemaphoreGive(buf->lock);
+    return err;
+}
+
+typedef struct {
+    uint8_t *data;
+    size_t start;
+    bool write;
+} himem_buf_copy_t;
+
+static esp_err_t copy_cb(void *data, size_t offset, size_t len, void *arg)
+{
+    himem_buf_copy_t *copy = (himem_buf_copy_t *)arg;
+    uint8_t *other = copy->data + (offset - copy->start);
+    if (copy->write) {
+        memcpy(data, other, len);
+    } else {
+        memcpy(other, data, len);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_himem_buf_read(esp_himem_buf_handle_t buf, size_t offset, void *dst, size_t len)
+{
+    himem_buf_copy_t copy = { .data = dst, .start = offset, .write = false };
+    return esp_himem_buf_iterate(buf, offset, len, copy_cb, &copy);
+}
+
+esp_err_t esp_himem_buf_write(esp_himem_buf_handle_t buf, size_t offset, const void *src, size_t len)
+{
+    himem_buf_copy_t copy = { .data = (uint8_t *)src, .start = offset, .write = true };
+    return esp_himem_buf_iterate(buf, offset, len, copy_cb, &copy);
+}
+
+size_t esp_himem_buf_get_size(esp_himem_buf_handle_t buf)
+{
+    return buf->block_ct * ESP_HIMEM_BLKSZ;
+}
+
+void esp_himem_buf_get_stats(esp_himem_buf_handle_t buf, esp_himem_buf_stats_t *stats)
+{
+    xSemaphoreTake(buf->lock, portMAX_DELAY);
+    *stats = buf->stats;
+    xSemaphoreGive(buf->lock);
+}
@@ -0,0 +1,167 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file dma_bounce.h
+ * @brief Shared pool of DMA-capable bounce buffers
+ *
+ * Peripherals with DMA can only access internal memory. Data in other memory, e.g. in SPI RAM,
+ * has to be copied through a DMA-capable buffer. Instead of every driver allocating such buffers
+ * for each transfer, drivers take fixed size chunks from one shared pool in internal memory.
+ *
+ * Buffers larger than a chunk are streamed with esp_dma_bounce_tx() and esp_dma_bounce_rx():
+ * while the peripheral transfers one chunk, the CPU copies the data of the next one, so the copy
+ * from or to SPI RAM mostly overlaps with the transfer.
+ */
+
+/**
+ * @brief Counters of the shared bounce pool, see esp_dma_bounce_get_stats()
+ */
+typedef struct {
+    size_t chunk_size;      /*!< Size of each chunk in bytes */
+    size_t chunks;          /*!< Number of chunks in the pool */
+    size_t free_chunks;     /*!< Number of chunks currently free */
+    size_t min_free_chunks; /*!< Lowest number of free chunks since the pool was created */
+    uint32_t exhausted;     /*!< Number of times no chunk was free when one was requested */
+    uint64_t bytes;         /*!< Number of bytes streamed by esp_dma_bounce_tx() and esp_dma_bounce_rx() */
+} esp_dma_bounce_stats_t;
+
+/**
+ * @brief Peripheral side of a streamed transfer, see esp_dma_bounce_tx() and esp_dma_bounce_rx()
+ *
+ * The stream never has more than one chunk in flight: finish is always called
+ * for a chunk before start is called for the next one.
+ */
+typedef struct {
+    /**
+     * Start the transfer of a chunk from or to a DMA-capable buffer. Drivers which can
+     * only do blocking transfers may do the whole transfer here and leave finish NULL.
+     *
+     * @param dma_buf DMA-capable buffer holding (tx) or receiving (rx) the data
+     * @param offset Offset of the chunk in the whole transfer
+     * @param len Length of the chunk, a multiple of 'align' except for the last chunk
+     */
+    esp_err_t (*start)(void *dma_buf, size_t offset, size_t len, void *arg);
+    /** Wait until the transfer started last is done. May be NULL. */
+    esp_err_t (*finish)(void *arg);
+    /** Called after each chunk with the number of bytes transferred so far. May be NULL. */
+    void (*progress)(size_t done, size_t total, void *arg);
+    void *arg;              /*!< Argument passed to the callbacks */
+    size_t align;           /*!< Chunk lengths are a multiple of this, e.g. the sector size. 0 or 1 for no constraint */
+} esp_dma_bounce_stream_t;
+
+/**
+ * @brief Create the shared bounce pool
+ *
+ * Called at startup when CONFIG_SPIRAM_DMA_BOUNCE_CHUNKS is not 0. Otherwise the application
+ * can call this to create the pool.
+ *
+ * @param chunk_size Size of each chunk in bytes, rounded up to a multiple of 4
+ * @param chunks Number of chunks. Two chunks are enough to pipeline one stream.
+ *
+ * @return
+ *          - ESP_OK on success
+ *          - ESP_ERR_INVALID_ARG if chunk_size or chunks is 0
+ *          - ESP_ERR_INVALID_STATE if the pool already exists
+ *          - ESP_ERR_NO_MEM if there is not enough DMA-capable memory
+ */
+esp_err_t esp_dma_bounce_init(size_t chunk_size, size_t chunks);
+
+/**
+ * @brief Get the size of the chunks of the shared pool
+ *
+ * @return Chunk size in bytes, or 0 if there is no pool
+ */
+size_t esp_dma_bounce_chunk_size(void);
+
+/**
+ * @brief Take a chunk from the shared pool
+ *
+ * Never blocks, may be called from an ISR and while the flash cache is disabled.
+ *
+ * @return DMA-capable buffer of esp_dma_bounce_chunk_size() bytes, or NULL if
+ *         there is no pool or no chunk is free
+ */
+void *esp_dma_bounce_get(void);
+
+/**
+ * @brief Return a chunk to the shared pool
+ *
+ * May be called from an ISR and while the flash cache is disabled.
+ *
+ * @param chunk Chunk returned by esp_dma_bounce_get(), may be NULL
+ */
+void esp_dma_bounce_put(void *chunk);
+
+/**
+ * @brief Check whether a buffer is a chunk of the shared pool
+ *
+ * @param ptr Any pointer
+ * @return true if ptr points into the storage of the pool
+ */
+bool esp_dma_bounce_is_chunk(const void *ptr);
+
+/**
+ * @brief Send a buffer which is not DMA-capable through chunks of the shared pool
+ *
+ * The data of each chunk is copied into a chunk of the pool and then passed to stream->start.
+ * When two chunks are free, the copy of a chunk overlaps with the transfer of the previous one.
+ *
+ * @param stream Peripheral callbacks
+ * @param src Data to send
+ * @param len Length of the data in bytes
+ *
+ * @return
+ *          - ESP_OK on success
+ *          - ESP_ERR_NO_MEM if there is no pool or no chunk is free
+ *          - ESP_ERR_INVALID_SIZE if the chunk size is smaller than stream->align
+ *          - error returned by a callback, the transfer stops at that chunk
+ */
+esp_err_t esp_dma_bounce_tx(const esp_dma_bounce_stream_t *stream, const void *src, size_t len);
+
+/**
+ * @brief Receive into a buffer which is not DMA-capable through chunks of the shared pool
+ *
+ * Each chunk is received into a chunk of the pool and copied into dst. When two chunks are free,
+ * the copy of a chunk overlaps with the transfer of the next one.
+ *
+ * @param stream Peripheral callbacks
+ * @param dst Buffer for the received data
+ * @param len Length of the data in bytes
+ *
+ * @return same as esp_dma_bounce_tx()
+ */
+esp_err_t esp_dma_bounce_rx(const esp_dma_bounce_stream_t *stream, void *dst, size_t len);
+
+/**
+ * @brief Get the counters of the shared pool
+ *
+ * @param[out] stats Counters, all 0 if there is no pool
+ */
+void esp_dma_bounce_get_stats(esp_dma_bounce_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
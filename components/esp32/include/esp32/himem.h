@@ -146,6 +146,116 @@ size_t esp_himem_get_free_size();
 size_t esp_himem_reserved_area_size();
 
 
+//Opaque pointer as handle for a paged buffer
+typedef struct esp_himem_buf_t *esp_himem_buf_handle_t;
+
+/**
+ * @brief Statistics of a paged buffer
+ */
+typedef struct {
+    size_t remaps;          /*!< Number of times a block had to be mapped into the window, each costs a cache writeback */
+    size_t hits;            /*!< Number of block accesses served by a block which was mapped already */
+} esp_himem_buf_stats_t;
+
+/**
+ * @brief Callback for esp_himem_buf_iterate
+ *
+ * @param data Pointer to the mapped data, valid until the callback returns
+ * @param offset Offset of data in the buffer
+ * @param len Length of data, never crosses a 32K block boundary
+ * @param arg Argument given to esp_himem_buf_iterate
+ * @returns ESP_OK to continue iterating, any other value stops iteration and is returned by esp_himem_buf_iterate
+ */
+typedef esp_err_t (*esp_himem_buf_cb_t)(void *data, size_t offset, size_t len, void *arg);
+
+/**
+ * @brief Allocate a paged buffer in high memory
+ *
+ * A paged buffer hides the bank switching: it allocates the physical memory and a window of
+ * window_blocks address blocks, and it maps the blocks of the buffer into the window as they are
+ * accessed. When the window is full, the least recently used block is unmapped. Accesses with a locality
+ * of at most window_blocks * 32K therefore cause no remaps.
+ *
+ * Access functions of a buffer may be called from several tasks, they are serialized by a mutex.
+ *
+ * @param size Size of the buffer in bytes, rounded up to a multiple of 32K
+ * @param window_blocks Number of 32K address blocks to reserve for the window, at most CONFIG_SPIRAM_BANKSWITCH_RESERVE
+ * @param[out] handle_out Handle to be returned
+ * @returns - ESP_OK if succesful
+ *          - ESP_ERR_INVALID_ARG if size or window_blocks is zero
+ *          - ESP_ERR_NO_MEM if out of high memory, address blocks or internal memory
+ *          - ESP_ERR_INVALID_STATE if himem is not available
+ */
+esp_err_t esp_himem_buf_create(size_t size, size_t window_blocks, esp_himem_buf_handle_t *handle_out);
+
+/**
+ * @brief Free a paged buffer, its high memory and its window
+ *
+ * @param handle Handle of the buffer
+ * @returns - ESP_OK if succesful
+ *          - other error codes of esp_himem_unmap, esp_himem_free and esp_himem_free_map_range
+ */
+esp_err_t esp_himem_buf_delete(esp_himem_buf_handle_t handle);
+
+/**
+ * @brief Copy data from a paged buffer
+ *
+ * @param handle Handle of the buffer
+ * @param offset Offset in the buffer to read from, no alignment needed
+ * @param[out] dst Destination, must not be another mapping of high memory
+ * @param len Number of bytes to read
+ * @returns - ESP_OK if succesful
+ *          - ESP_ERR_INVALID_SIZE if offset and len are out of the buffer
+ */
+esp_err_t esp_himem_buf_read(esp_himem_buf_handle_t handle, size_t offset, void *dst, size_t len);
+
+/**
+ * @brief Copy data into a paged buffer
+ *
+ * @param handle Handle of the buffer
+ * @param offset Offset in the buffer to write to, no alignment needed
+ * @param src Source, must not be another mapping of high memory
+ * @param len Number of bytes to write
+ * @returns - ESP_OK if succesful
+ *          - ESP_ERR_INVALID_SIZE if offset and len are out of the buffer
+ */
+esp_err_t esp_himem_buf_write(esp_himem_buf_handle_t handle, size_t offset, const void *src, size_t len);
+
+/**
+ * @brief Access a part of a paged buffer in place
+ *
+ * The part is split at 32K block boundaries. Each piece is mapped in turn and passed to the callback,
+ * which may read and modify it. The buffer is locked while the callback runs, so the callback must
+ * not access the same buffer.
+ *
+ * @param handle Handle of the buffer
+ * @param offset Offset of the part in the buffer
+ * @param len Length of the part
+ * @param cb Callback
+ * @param arg Argument passed to the callback
+ * @returns - ESP_OK if succesful
+ *          - ESP_ERR_INVALID_SIZE if offset and len are out of the buffer
+ *          - the value returned by the callback if it isn't ESP_OK
+ */
+esp_err_t esp_himem_buf_iterate(esp_himem_buf_handle_t handle, size_t offset, size_t len, esp_himem_buf_cb_t cb, void *arg);
+
+/**
+ * @brief Get the size of a paged buffer
+ *
+ * @param handle Handle of the buffer
+ * @returns Size in bytes, a multiple of 32K
+ */
+size_t esp_himem_buf_get_size(esp_himem_buf_handle_t handle);
+
+/**
+ * @brief Get the statistics of a paged buffer
+ *
+ * @param handle Handle of the buffer
+ * @param[out] stats Statistics since the buffer was created
+ */
+void esp_himem_buf_get_stats(esp_himem_buf_handle_t handle, esp_himem_buf_stats_t *stats);
+
+
 #ifdef __cplusplus
 }
 #endif
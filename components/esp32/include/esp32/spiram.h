@@ -103,6 +103,73 @@ void esp_spiram_writeback_cache();
 esp_err_t esp_spiram_reserve_dma_pool(size_t size);
 
 
+/**
+ * @brief Result of sampling the SPI RAM cache, see esp_spiram_sample_cache()
+ */
+typedef struct {
+    size_t lines;           /*!< Number of cache lines sampled */
+    size_t hits;            /*!< Number of lines which were in the cache */
+    size_t misses;          /*!< Number of lines which had to be read from SPI RAM */
+    uint32_t miss_cycles;   /*!< CPU cycles spent waiting for the missed lines */
+} esp_spiram_cache_sample_t;
+
+/**
+ * @brief Sample which parts of a buffer in SPI RAM are currently held in the cache
+ *
+ * The ESP32 cache has no hit or miss counters. Instead, one word of each 32 byte cache
+ * line of the buffer is loaded and the load is timed: a load which waits for SPI RAM is
+ * counted as a miss. Sampling a buffer at intervals while the application runs tells how
+ * much of it stays in the cache shared by both cores, which helps to decide whether the
+ * buffer should rather be allocated in internal memory (see MALLOC_CAP_HOT and MALLOC_CAP_COLD).
+ *
+ * @note Sampling loads all sampled lines into the cache, evicting other data. Successive
+ *       samples of the same buffer only show what was evicted in between.
+ *
+ * @param addr Start of the buffer, must be in external RAM
+ * @param size Size of the buffer in bytes
+ * @param[out] sample Sampling result
+ *
+ * @return
+ *          - ESP_OK on success
+ *          - ESP_ERR_INVALID_ARG if the buffer is not in external RAM
+ *          - ESP_ERR_INVALID_STATE if SPI RAM is not initialized
+ */
+esp_err_t esp_spiram_sample_cache(const void *addr, size_t size, esp_spiram_cache_sample_t *sample);
+
+
+/**
+ * @brief Copy memory, optimized for large blocks in external RAM
+ *
+ * Same semantics as memcpy(). The copy is done one 32 byte cache line at a time with
+ * word accesses only, also when source and destination are not aligned to each other,
+ * and the routine runs from IRAM so that it doesn't compete with the data for the cache.
+ * Blocks shorter than 64 bytes are passed to memcpy().
+ *
+ * Works for any RAM, but only gives an advantage when at least one of the buffers is in
+ * external RAM, e.g. when copying frame buffers between external and internal RAM.
+ *
+ * @param dst Destination
+ * @param src Source, must not overlap with the destination
+ * @param n Number of bytes to copy
+ *
+ * @return dst
+ */
+void *esp_spiram_memcpy(void *dst, const void *src, size_t n);
+
+/**
+ * @brief Fill memory, optimized for large blocks in external RAM
+ *
+ * Same semantics as memset(), see esp_spiram_memcpy().
+ *
+ * @param dst Destination
+ * @param c Value to fill with, converted to unsigned char
+ * @param n Number of bytes to fill
+ *
+ * @return dst
+ */
+void *esp_spiram_memset(void *dst, int c, size_t n);
+
+
 /**
  * @brief If SPI RAM(PSRAM) has been initialized
  *
@@ -17,6 +17,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include "esp_err.h"
 #include "freertos/xtensa_api.h"
 
@@ -290,6 +291,26 @@ void esp_intr_noniram_disable();
  */
 void esp_intr_noniram_enable();
 
+/**
+ * @brief Print the allocated interrupts
+ *
+ * For each interrupt allocated with esp_intr_alloc, prints the CPU, interrupt
+ * number, source and flags. If CONFIG_INTR_ALLOC_PROFILING is enabled, also
+ * prints for each handler:
+ * - the number of times it was called,
+ * - average and maximum number of CPU cycles it took,
+ * - for non-IRAM interrupts, the number of times the interrupt was pending
+ *   when interrupts were re-enabled after a flash operation, and the longest
+ *   time, in CPU cycles, interrupts were disabled in such a case.
+ *
+ * Handlers with long execution times are candidates for moving work out of the
+ * ISR or to the other CPU, and handlers often delayed by flash operations are
+ * candidates for ESP_INTR_FLAG_IRAM.
+ *
+ * @param stream stream to print the information to, e.g. stdout
+ */
+void esp_intr_dump(FILE *stream);
+
 /**@}*/
 
 
@@ -32,6 +32,7 @@
 #include "esp_ipc.h"
 #include <limits.h>
 #include <assert.h>
+#include "xtensa/core-macros.h"
 
 static const char* TAG = "intr_alloc";
 
@@ -129,6 +130,24 @@ const static int_desc_t int_desc[32]={
 typedef struct shared_vector_desc_t shared_vector_desc_t;
 typedef struct vector_desc_t vector_desc_t;
 
+#if CONFIG_INTR_ALLOC_PROFILING
+typedef struct {
+    uint32_t count;                         //Number of times the handler was called
+    uint32_t max_cycles;                    //Longest run of the handler, in CPU cycles
+    uint64_t total_cycles;                  //Total time spent in the handler, in CPU cycles
+} isr_stats_t;
+
+typedef struct {
+    uint32_t count;                         //Number of times the int was pending when re-enabled by esp_intr_noniram_enable
+    uint32_t max_cycles;                    //Longest time non-IRAM ints were disabled while it was pending
+} noniram_delay_t;
+#endif
+
+//Non-shared handlers are called through a wrapper when they need to be traced or profiled
+#if CONFIG_SYSVIEW_ENABLE || CONFIG_INTR_ALLOC_PROFILING
+#define WITH_NON_SHARED_ISR_WRAPPER
+#endif
+
 struct shared_vector_desc_t {
     int disabled: 1;
     int source: 8;
@@ -137,6 +156,9 @@ struct shared_vector_desc_t {
     intr_handler_t isr;
     void *arg;
     shared_vector_desc_t *next;
+#if CONFIG_INTR_ALLOC_PROFILING
+    isr_stats_t stats;
+#endif
 };
 
 
@@ -166,6 +188,9 @@ struct non_shared_isr_arg_t {
     intr_handler_t isr;
     void *isr_arg;
     int source;
+#if CONFIG_INTR_ALLOC_PROFILING
+    isr_stats_t stats;
+#endif
 };
 
 //Linked list of vector descriptions, sorted by cpu.intno value
@@ -177,6 +202,12 @@ static uint32_t non_iram_int_mask[portNUM_PROCESSORS];
 static uint32_t non_iram_int_disabled[portNUM_PROCESSORS];
 static bool non_iram_int_disabled_flag[portNUM_PROCESSORS];
 
+#if CONFIG_INTR_ALLOC_PROFILING
+//CCOUNT when esp_intr_noniram_disable was called
+static uint32_t non_iram_int_disabled_ccount[portNUM_PROCESSORS];
+static noniram_delay_t non_iram_int_delay[portNUM_PROCESSORS][32];
+#endif
+
 #if CONFIG_SYSVIEW_ENABLE
 extern uint32_t port_switch_flag[];
 #endif
@@ -489,6 +520,18 @@ static int get_available_int(int flags, int cpu, int force, int source)
     return best;
 }
 
+#if CONFIG_INTR_ALLOC_PROFILING
+static inline void IRAM_ATTR isr_stats_update(isr_stats_t *stats, uint32_t start_ccount)
+{
+    uint32_t cycles = XTHAL_GET_CCOUNT() - start_ccount;
+    stats->count++;
+    stats->total_cycles += cycles;
+    if (cycles > stats->max_cycles) {
+        stats->max_cycles = cycles;
+    }
+}
+#endif
+
 //Common shared isr handler. Chain-call all ISRs.
 static void IRAM_ATTR shared_intr_isr(void *arg)
 {
@@ -498,6 +541,9 @@ static void IRAM_ATTR shared_intr_isr(void *arg)
     while(sh_vec) {
         if (!sh_vec->disabled) {
             if ((sh_vec->statusreg == NULL) || (*sh_vec->statusreg & sh_vec->statusmask)) {
+#if CONFIG_INTR_ALLOC_PROFILING
+                uint32_t start_ccount = XTHAL_GET_CCOUNT();
+#endif
 #if CONFIG_SYSVIEW_ENABLE
                 traceISR_ENTER(sh_vec->source+ETS_INTERNAL_INTR_SOURCE_OFF);
 #endif
@@ -507,6 +553,9 @@ static void IRAM_ATTR shared_intr_isr(void *arg)
                 if (!port_switch_flag[xPortGetCoreID()]) {
                     traceISR_EXIT();
                 }
+#endif
+#if CONFIG_INTR_ALLOC_PROFILING
+                isr_stats_update(&sh_vec->stats, start_ccount);
 #endif
             }
         }
@@ -515,21 +564,31 @@ static void IRAM_ATTR shared_intr_isr(void *arg)
     portEXIT_CRITICAL(&spinlock);
 }
 
-#if CONFIG_SYSVIEW_ENABLE
+#ifdef WITH_NON_SHARED_ISR_WRAPPER
 //Common non-shared isr handler wrapper.
 static void IRAM_ATTR non_shared_intr_isr(void *arg)
 {
     non_shared_isr_arg_t *ns_isr_arg=(non_shared_isr_arg_t*)arg;
+#if CONFIG_INTR_ALLOC_PROFILING
+    uint32_t start_ccount = XTHAL_GET_CCOUNT();
+#endif
+#if CONFIG_SYSVIEW_ENABLE
     portENTER_CRITICAL(&spinlock);
     traceISR_ENTER(ns_isr_arg->source+ETS_INTERNAL_INTR_SOURCE_OFF);
     // FIXME: can we call ISR and check port_switch_flag after releasing spinlock?
     // when CONFIG_SYSVIEW_ENABLE = 0 ISRs for non-shared IRQs are called without spinlock
+#endif
     ns_isr_arg->isr(ns_isr_arg->isr_arg);
+#if CONFIG_SYSVIEW_ENABLE
     // check if we will return to scheduler or to interrupted task after ISR
     if (!port_switch_flag[xPortGetCoreID()]) {
         traceISR_EXIT();
     }
     portEXIT_CRITICAL(&spinlock);
+#endif
+#if CONFIG_INTR_ALLOC_PROFILING
+    isr_stats_update(&ns_isr_arg->stats, start_ccount);
+#endif
 }
 #endif
 
@@ -621,8 +680,9 @@ esp_err_t esp_intr_alloc_intrstatus(int source, int flags, uint32_t intrstatusre
         //Mark as unusable for other interrupt sources. This is ours now!
         vd->flags=VECDESC_FL_NONSHARED;
         if (handler) {
-#if CONFIG_SYSVIEW_ENABLE
-            non_shared_isr_arg_t *ns_isr_arg=malloc(sizeof(non_shared_isr_arg_t));
+#ifdef WITH_NON_SHARED_ISR_WRAPPER
+            //The wrapper may run while the cache is disabled, so its argument must be in internal memory
+            non_shared_isr_arg_t *ns_isr_arg=heap_caps_calloc(1, sizeof(non_shared_isr_arg_t), MALLOC_CAP_INTERNAL|MALLOC_CAP_8BIT);
             if (!ns_isr_arg) {
                 portEXIT_CRITICAL(&spinlock);
                 free(ret);
@@ -748,7 +808,7 @@ esp_err_t esp_intr_free(intr_handle_t handle)
 
     if ((handle->vector_desc->flags&VECDESC_FL_NONSHARED) || free_shared_vector) {
         ESP_LOGV(TAG, "esp_intr_free: Disabling int, killing handler");
-#if CONFIG_SYSVIEW_ENABLE
+#ifdef WITH_NON_SHARED_ISR_WRAPPER
         if (!free_shared_vector) {
             void *isr_arg = xt_get_interrupt_handler_arg(handle->vector_desc->intno);
             if (isr_arg) {
@@ -872,6 +932,9 @@ void IRAM_ATTR esp_intr_noniram_disable()
         :"=&r"(oldint):"r"(intmask):"a3");
     //Save which ints we did disable
     non_iram_int_disabled[cpu]=oldint&non_iram_int_mask[cpu];
+#if CONFIG_INTR_ALLOC_PROFILING
+    non_iram_int_disabled_ccount[cpu]=XTHAL_GET_CCOUNT();
+#endif
 }
 
 void IRAM_ATTR esp_intr_noniram_enable()
@@ -880,6 +943,19 @@ void IRAM_ATTR esp_intr_noniram_enable()
     int intmask=non_iram_int_disabled[cpu];
     if (!non_iram_int_disabled_flag[cpu]) abort();
     non_iram_int_disabled_flag[cpu]=false;
+#if CONFIG_INTR_ALLOC_PROFILING
+    //Ints which became pending while disabled have been delayed by up to the time they were disabled
+    uint32_t pending=XTHAL_GET_INTERRUPT()&intmask;
+    uint32_t cycles=XTHAL_GET_CCOUNT()-non_iram_int_disabled_ccount[cpu];
+    while (pending) {
+        int intr=__builtin_ctz(pending);
+        pending&=pending-1;
+        non_iram_int_delay[cpu][intr].count++;
+        if (cycles>non_iram_int_delay[cpu][intr].max_cycles) {
+            non_iram_int_delay[cpu][intr].max_cycles=cycles;
+        }
+    }
+#endif
     asm volatile (
         "movi a3,0\n"
         "xsr a3,INTENABLE\n"
@@ -890,6 +966,91 @@ void IRAM_ATTR esp_intr_noniram_enable()
         ::"r"(intmask):"a3");
 }
 
+typedef struct {
+    uint8_t cpu;
+    uint8_t intno;
+    int8_t source;
+    bool shared;
+    bool iram;
+#if CONFIG_INTR_ALLOC_PROFILING
+    isr_stats_t stats;
+#endif
+} intr_dump_row_t;
+
+//Copies up to max_rows handler descriptions into rows. Returns the total number of handlers.
+static int intr_dump_collect(intr_dump_row_t *rows, int max_rows)
+{
+    int n=0;
+    portENTER_CRITICAL(&spinlock);
+    for (vector_desc_t *vd=vector_desc_head; vd!=NULL; vd=vd->next) {
+        bool iram=(non_iram_int_mask[vd->cpu]&(1<<vd->intno))==0;
+        if (vd->flags&VECDESC_FL_SHARED) {
+            for (shared_vector_desc_t *sh_vec=vd->shared_vec_info; sh_vec!=NULL; sh_vec=sh_vec->next, n++) {
+                if (n>=max_rows) continue;
+                rows[n]=(intr_dump_row_t) {
+                    .cpu=vd->cpu, .intno=vd->intno, .source=sh_vec->source, .shared=true, .iram=iram,
+#if CONFIG_INTR_ALLOC_PROFILING
+                    .stats=sh_vec->stats,
+#endif
+                };
+            }
+        } else if (vd->flags&VECDESC_FL_NONSHARED) {
+            if (n<max_rows) {
+                rows[n]=(intr_dump_row_t) {
+                    .cpu=vd->cpu, .intno=vd->intno, .source=vd->source, .shared=false, .iram=iram,
+                };
+#if CONFIG_INTR_ALLOC_PROFILING
+                xt_handler_table_entry *entry=&_xt_interrupt_table[vd->intno*portNUM_PROCESSORS+vd->cpu];
+                if (entry->handler==(void*)non_shared_intr_isr) {
+                    rows[n].stats=((non_shared_isr_arg_t*)entry->arg)->stats;
+                }
+#endif
+            }
+            n++;
+        }
+    }
+    portEXIT_CRITICAL(&spinlock);
+    return n;
+}
+
+void esp_intr_dump(FILE *stream)
+{
+    intr_dump_row_t *rows=NULL;
+    int count=intr_dump_collect(NULL, 0);
+    //Handlers may be allocated between the two calls, leave some room for them
+    int max_rows=count+4;
+    rows=calloc(max_rows, sizeof(intr_dump_row_t));
+    if (!rows) {
+        fprintf(stream, "esp_intr_dump: out of memory\n");
+        return;
+    }
+    count=intr_dump_collect(rows, max_rows);
+    if (count>max_rows) count=max_rows;
+
+#if CONFIG_INTR_ALLOC_PROFILING
+    fprintf(stream, "CPU Int Source Flags       Count   Avg cycles   Max cycles  Delayed  Max delay\n");
+#else
+    fprintf(stream, "CPU Int Source Flags\n");
+#endif
+    for (int i=0; i<count; i++) {
+        const intr_dump_row_t *r=&rows[i];
+        fprintf(stream, "%3d %3d %6d %-6s%-6s", r->cpu, r->intno, r->source,
+                r->iram?"IRAM":"", r->shared?"SHARED":"");
+#if CONFIG_INTR_ALLOC_PROFILING
+        const noniram_delay_t *delay=&non_iram_int_delay[r->cpu][r->intno];
+        fprintf(stream, " %10u %12u %12u", r->stats.count,
+                r->stats.count?(uint32_t)(r->stats.total_cycles/r->stats.count):0, r->stats.max_cycles);
+        if (r->iram) {
+            fprintf(stream, "        -          -");
+        } else {
+            fprintf(stream, " %8u %10u", delay->count, delay->max_cycles);
+        }
+#endif
+        fprintf(stream, "\n");
+    }
+    free(rows);
+}
+
 //These functions are provided in ROM, but the ROM-based functions use non-multicore-capable
 //virtualized interrupt levels. Thus, we disable them in the ld file and provide working
 //equivalents here.
@@ -33,6 +33,7 @@
 
 #include "esp_private/pm_impl.h"
 #include "esp_private/pm_trace.h"
+#include "esp_private/sleep_stats.h"
 #include "esp_private/esp_timer_impl.h"
 #include "esp32/pm.h"
 
@@ -139,9 +140,49 @@ static const char* s_mode_names[] = {
         "APB_MAX",
         "CPU_MAX"
 };
+/* User-readable light sleep phase names, used by esp_pm_impl_dump_stats */
+static const char* s_sleep_phase_names[] = {
+        "prepare",
+        "clk_down",
+        "configure",
+        "clk_up",
+        "flash",
+        "finish"
+};
 #endif // WITH_PROFILING
 
 
+#ifdef CONFIG_PM_DFS_GOVERNOR
+#if CONFIG_PM_DFS_GOVERNOR_DOWN_THRESHOLD >= CONFIG_PM_DFS_GOVERNOR_UP_THRESHOLD
+#error "CONFIG_PM_DFS_GOVERNOR_DOWN_THRESHOLD must be lower than CONFIG_PM_DFS_GOVERNOR_UP_THRESHOLD"
+#endif
+
+#define GOVERNOR_PERIOD_TICKS MAX(1, CONFIG_PM_DFS_GOVERNOR_PERIOD_MS / portTICK_PERIOD_MS)
+
+/* Load governor state of each CPU. Only accessed from the CPU it belongs to,
+ * with interrupts disabled (idle hook) or from the ISR hook.
+ */
+typedef struct {
+    /* Lock held instead of s_rtos_lock_handle while the CPU is busy and the load is low */
+    esp_pm_lock_handle_t apb_lock;
+    /* True if the load went above the up threshold and hasn't dropped below the down threshold since */
+    bool high_load;
+    /* Time the idle task was last entered */
+    int64_t idle_start;
+    /* Time spent in the idle task since the start of the measurement period, in microseconds */
+    uint32_t idle_time;
+    /* Start of the measurement period */
+    int64_t period_start;
+    TickType_t period_start_tick;
+    /* Load measured over the last period, in percent */
+    uint32_t load;
+    /* Number of times high_load has changed */
+    uint32_t switch_count;
+} governor_t;
+
+static governor_t s_governor[portNUM_PROCESSORS];
+#endif // CONFIG_PM_DFS_GOVERNOR
+
 static const char* TAG = "pm_esp32";
 
 static void update_ccompare();
@@ -431,14 +472,69 @@ static void IRAM_ATTR update_ccompare()
     }
 }
 
+#ifdef CONFIG_PM_DFS_GOVERNOR
+/* Lock held while the CPU is not idle */
+static inline esp_pm_lock_handle_t IRAM_ATTR busy_lock(int core_id)
+{
+    return s_governor[core_id].high_load ? s_rtos_lock_handle[core_id] : s_governor[core_id].apb_lock;
+}
+
+/* If the measurement period is over, computes the load and updates high_load.
+ * Returns true if high_load has changed.
+ */
+static bool IRAM_ATTR governor_update(int core_id)
+{
+    governor_t* gov = &s_governor[core_id];
+    TickType_t tick = xTaskGetTickCountFromISR();
+    if (tick - gov->period_start_tick < GOVERNOR_PERIOD_TICKS) {
+        return false;
+    }
+    int64_t now = esp_timer_get_time();
+    uint32_t elapsed = (uint32_t) MIN(now - gov->period_start, UINT32_MAX);
+    uint32_t idle_time = MIN(gov->idle_time, elapsed);
+    /* 32-bit division only, this can run from an IRAM interrupt while the cache is disabled */
+    gov->load = (elapsed > 0) ? 100 - idle_time / ((elapsed + 99) / 100) : 0;
+    gov->period_start = now;
+    gov->period_start_tick = tick;
+    gov->idle_time = 0;
+
+    bool high_load = gov->high_load ? gov->load > CONFIG_PM_DFS_GOVERNOR_DOWN_THRESHOLD
+                                    : gov->load >= CONFIG_PM_DFS_GOVERNOR_UP_THRESHOLD;
+    if (high_load == gov->high_load) {
+        return false;
+    }
+    gov->high_load = high_load;
+    gov->switch_count++;
+    return true;
+}
+#else
+static inline esp_pm_lock_handle_t IRAM_ATTR busy_lock(int core_id)
+{
+    return s_rtos_lock_handle[core_id];
+}
+#endif // CONFIG_PM_DFS_GOVERNOR
+
 static void IRAM_ATTR leave_idle()
 {
     int core_id = xPortGetCoreID();
     if (s_core_idle[core_id]) {
         // TODO: possible optimization: raise frequency here first
-        esp_pm_lock_acquire(s_rtos_lock_handle[core_id]);
+#ifdef CONFIG_PM_DFS_GOVERNOR
+        governor_t* gov = &s_governor[core_id];
+        gov->idle_time += (uint32_t) MIN(esp_timer_get_time() - gov->idle_start, UINT32_MAX - gov->idle_time);
+#endif
+        esp_pm_lock_acquire(busy_lock(core_id));
         s_core_idle[core_id] = false;
     }
+#ifdef CONFIG_PM_DFS_GOVERNOR
+    else if (governor_update(core_id)) {
+        /* Load has changed while busy, swap the lock which is held */
+        esp_pm_lock_handle_t prev = s_governor[core_id].high_load ?
+                s_governor[core_id].apb_lock : s_rtos_lock_handle[core_id];
+        esp_pm_lock_acquire(busy_lock(core_id));
+        esp_pm_lock_release(prev);
+    }
+#endif
 }
 
 void esp_pm_impl_idle_hook()
@@ -446,8 +542,12 @@ void esp_pm_impl_idle_hook()
     int core_id = xPortGetCoreID();
     uint32_t state = portENTER_CRITICAL_NESTED();
     if (!s_core_idle[core_id]) {
-        esp_pm_lock_release(s_rtos_lock_handle[core_id]);
+        esp_pm_lock_release(busy_lock(core_id));
         s_core_idle[core_id] = true;
+#ifdef CONFIG_PM_DFS_GOVERNOR
+        governor_update(core_id);
+        s_governor[core_id].idle_start = esp_timer_get_time();
+#endif
     }
     portEXIT_CRITICAL_NESTED(state);
     ESP_PM_TRACE_ENTER(IDLE, core_id);
@@ -586,6 +686,36 @@ void esp_pm_impl_dump_stats(FILE* out)
                 time_in_mode[i],
                 (int) (time_in_mode[i] * 100 / now));
     }
+
+    sleep_stats_t sleep_stats;
+    esp_sleep_get_light_sleep_stats(&sleep_stats);
+    if (sleep_stats.count > 0) {
+        fprintf(out, "Light sleep stats: %u sleeps, %u with flash powered down\n",
+                sleep_stats.count, sleep_stats.flash_pd_count);
+        fprintf(out, "%10s  %8s  %8s\n", "phase", "avg us", "max us");
+        uint32_t entry_us = 0;
+        uint32_t exit_us = 0;
+        for (int i = 0; i < SLEEP_PHASE_COUNT; ++i) {
+            uint32_t avg_us = (uint32_t) (sleep_stats.total_us[i] / sleep_stats.count);
+            if (i <= SLEEP_PHASE_CONFIGURE) {
+                entry_us += avg_us;
+            } else {
+                exit_us += avg_us;
+            }
+            fprintf(out, "%10s  %8u  %8u\n", s_sleep_phase_names[i], avg_us, sleep_stats.max_us[i]);
+        }
+        fprintf(out, "entry %u us, exit %u us on average\n", entry_us, exit_us);
+    }
+#ifdef CONFIG_PM_DFS_GOVERNOR
+    fprintf(out, "Load governor stats:\n");
+    for (int i = 0; i < portNUM_PROCESSORS; ++i) {
+        fprintf(out, "CPU%d  load %3d%%  %s  %d switches\n",
+                i,
+                s_governor[i].load,
+                s_governor[i].high_load ? "high" : "low ",
+                s_governor[i].switch_count);
+    }
+#endif // CONFIG_PM_DFS_GOVERNOR
 }
 #endif // WITH_PROFILING
 
@@ -602,6 +732,14 @@ void esp_pm_impl_init()
             &s_rtos_lock_handle[1]));
     ESP_ERROR_CHECK(esp_pm_lock_acquire(s_rtos_lock_handle[1]));
 #endif // portNUM_PROCESSORS == 2
+#ifdef CONFIG_PM_DFS_GOVERNOR
+    /* CPUs start with high load, holding s_rtos_lock_handle */
+    for (int i = 0; i < portNUM_PROCESSORS; ++i) {
+        ESP_ERROR_CHECK(esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, i == 0 ? "gov0" : "gov1",
+                &s_governor[i].apb_lock));
+        s_governor[i].high_load = true;
+    }
+#endif // CONFIG_PM_DFS_GOVERNOR
 
     /* Configure all modes to use the default CPU frequency.
      * This will be modified later by a call to esp_pm_configure.
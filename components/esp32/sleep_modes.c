@@ -13,11 +13,14 @@
 // limitations under the License.
 
 #include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
 #include <sys/lock.h>
 #include <sys/param.h>
 #include "esp_attr.h"
 #include "esp_sleep.h"
 #include "esp_private/esp_timer_impl.h"
+#include "esp_private/sleep_stats.h"
 #include "esp_log.h"
 #include "esp32/clk.h"
 #include "esp_newlib.h"
@@ -37,10 +40,11 @@
 #include "driver/uart.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "xtensa/core-macros.h"
 #include "sdkconfig.h"
 
 // If light sleep time is less than that, don't power down flash
-#define FLASH_PD_MIN_SLEEP_TIME_US  2000
+#define FLASH_PD_MIN_SLEEP_TIME_US  CONFIG_ESP32_LIGHT_SLEEP_FLASH_PD_MIN_TIME
 
 // Time from VDD_SDIO power up to first flash read in ROM code
 #define VDD_SDIO_POWERUP_TO_FLASH_READ_US 700
@@ -85,6 +89,25 @@ static sleep_config_t s_config = {
    expected when determining wakeup cause. */
 static bool s_light_sleep_wakeup = false;
 
+/* Power down flags used by the last light sleep. They are computed again only
+   when the wakeup triggers or the power down options change. */
+static struct {
+    bool valid;
+    uint32_t wakeup_triggers;
+    esp_sleep_pd_option_t pd_options[ESP_PD_DOMAIN_MAX];
+    uint32_t pd_flags;
+} s_light_sleep_pd;
+
+static portMUX_TYPE s_light_sleep_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#ifdef CONFIG_PM_PROFILING
+/* Latency counters of light sleep, protected by s_light_sleep_lock */
+static sleep_stats_t s_sleep_stats;
+/* CPU cycle count and CPU frequency when the current phase started */
+static uint32_t s_phase_start_ccount;
+static uint32_t s_phase_start_mhz;
+#endif
+
 /* Updating RTC_MEMORY_CRC_REG register via set_rtc_memory_crc()
    is not thread-safe. */
 static _lock_t lock_rtc_memory_crc;
@@ -150,6 +173,45 @@ void esp_deep_sleep(uint64_t time_in_us)
     esp_deep_sleep_start();
 }
 
+#ifdef CONFIG_PM_PROFILING
+static inline void IRAM_ATTR sleep_phase_start()
+{
+    s_phase_start_ccount = XTHAL_GET_CCOUNT();
+    s_phase_start_mhz = ets_get_cpu_frequency();
+}
+
+/* Charge the time since the previous mark to the given phase. If the CPU
+ * frequency changed in between, cycles are converted at the lower frequency:
+ * a clock switch spends most of its time waiting while running from XTAL.
+ */
+static void IRAM_ATTR sleep_phase_end(sleep_phase_t phase)
+{
+    uint32_t ccount = XTHAL_GET_CCOUNT();
+    uint32_t mhz = ets_get_cpu_frequency();
+    uint32_t us = (ccount - s_phase_start_ccount) / MIN(mhz, s_phase_start_mhz);
+    s_sleep_stats.total_us[phase] += us;
+    if (us > s_sleep_stats.max_us[phase]) {
+        s_sleep_stats.max_us[phase] = us;
+    }
+    s_phase_start_ccount = ccount;
+    s_phase_start_mhz = mhz;
+}
+#else
+#define sleep_phase_start()
+#define sleep_phase_end(phase)
+#endif // CONFIG_PM_PROFILING
+
+void esp_sleep_get_light_sleep_stats(sleep_stats_t *stats)
+{
+#ifdef CONFIG_PM_PROFILING
+    portENTER_CRITICAL(&s_light_sleep_lock);
+    *stats = s_sleep_stats;
+    portEXIT_CRITICAL(&s_light_sleep_lock);
+#else
+    memset(stats, 0, sizeof(*stats));
+#endif
+}
+
 static void IRAM_ATTR flush_uarts()
 {
     for (int i = 0; i < 3; ++i) {
@@ -187,10 +249,16 @@ static uint32_t IRAM_ATTR esp_sleep_start(uint32_t pd_flags)
         suspend_uarts();
     }
 
-    // Save current frequency and switch to XTAL
+    sleep_phase_end(SLEEP_PHASE_PREPARE);
+
+    // Save current frequency and switch to XTAL, unless the CPU runs from it already
     rtc_cpu_freq_config_t cpu_freq_config;
     rtc_clk_cpu_freq_get_config(&cpu_freq_config);
-    rtc_clk_cpu_freq_set_xtal();
+    bool switch_clk = cpu_freq_config.source != RTC_CPU_FREQ_SRC_XTAL || cpu_freq_config.div != 1;
+    if (switch_clk) {
+        rtc_clk_cpu_freq_set_xtal();
+    }
+    sleep_phase_end(SLEEP_PHASE_CLK_DOWN);
 
     // Configure pins for external wakeup
     if (s_config.wakeup_triggers & RTC_EXT0_TRIG_EN) {
@@ -213,13 +281,18 @@ static uint32_t IRAM_ATTR esp_sleep_start(uint32_t pd_flags)
         s_config.sleep_duration > 0) {
         timer_wakeup_prepare();
     }
+    sleep_phase_end(SLEEP_PHASE_CONFIGURE);
     uint32_t result = rtc_sleep_start(s_config.wakeup_triggers, 0);
+    sleep_phase_start();
 
     // Restore CPU frequency
-    rtc_clk_cpu_freq_set_config(&cpu_freq_config);
+    if (switch_clk) {
+        rtc_clk_cpu_freq_set_config(&cpu_freq_config);
+    }
 
     // re-enable UART output
     resume_uarts();
+    sleep_phase_end(SLEEP_PHASE_CLK_UP);
 
     return result;
 }
@@ -276,13 +349,32 @@ static esp_err_t esp_light_sleep_inner(uint32_t pd_flags,
         // Wait for the flash chip to start up
         ets_delay_us(flash_enable_time_us);
     }
+    sleep_phase_end(SLEEP_PHASE_FLASH);
     return err;
 }
 
+/* Power down flags for light sleep, reused while the configuration stays the same */
+static uint32_t get_light_sleep_power_down_flags()
+{
+    bool changed = !s_light_sleep_pd.valid ||
+                   s_light_sleep_pd.wakeup_triggers != s_config.wakeup_triggers;
+    for (int i = 0; i < ESP_PD_DOMAIN_MAX && !changed; ++i) {
+        changed = s_light_sleep_pd.pd_options[i] != s_config.pd_options[i];
+    }
+    if (changed) {
+        s_light_sleep_pd.pd_flags = get_power_down_flags();
+        // Compare with the options as resolved by get_power_down_flags next time
+        s_light_sleep_pd.wakeup_triggers = s_config.wakeup_triggers;
+        memcpy(s_light_sleep_pd.pd_options, s_config.pd_options, sizeof(s_config.pd_options));
+        s_light_sleep_pd.valid = true;
+    }
+    return s_light_sleep_pd.pd_flags;
+}
+
 esp_err_t esp_light_sleep_start()
 {
-    static portMUX_TYPE light_sleep_lock = portMUX_INITIALIZER_UNLOCKED;
-    portENTER_CRITICAL(&light_sleep_lock);
+    portENTER_CRITICAL(&s_light_sleep_lock);
+    sleep_phase_start();
     /* We will be calling esp_timer_impl_advance inside DPORT access critical
      * section. Make sure the code on the other CPU is not holding esp_timer
      * lock, otherwise there will be deadlock.
@@ -293,7 +385,7 @@ esp_err_t esp_light_sleep_start()
     DPORT_STALL_OTHER_CPU_START();
 
     // Decide which power domains can be powered down
-    uint32_t pd_flags = get_power_down_flags();
+    uint32_t pd_flags = get_light_sleep_power_down_flags();
 
     // Amount of time to subtract from actual sleep time.
     // This is spent on entering and leaving light sleep.
@@ -352,13 +444,20 @@ esp_err_t esp_light_sleep_start()
         esp_timer_impl_advance(time_diff);
     }
     esp_set_time_from_rtc();
+    sleep_phase_end(SLEEP_PHASE_FINISH);
+#ifdef CONFIG_PM_PROFILING
+    s_sleep_stats.count++;
+    if (pd_flags & RTC_SLEEP_PD_VDDSDIO) {
+        s_sleep_stats.flash_pd_count++;
+    }
+#endif
 
     esp_timer_impl_unlock();
     DPORT_STALL_OTHER_CPU_END();
     if (!wdt_was_enabled) {
         rtc_wdt_disable();
     }
-    portEXIT_CRITICAL(&light_sleep_lock);
+    portEXIT_CRITICAL(&s_light_sleep_lock);
     return err;
 }
 
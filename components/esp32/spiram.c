@@ -35,6 +35,7 @@ we add more types of external RAM memory, this can be made into a more intellige
 #include "soc/dport_reg.h"
 #include "esp32/himem.h"
 #include "esp32/rom/cache.h"
+#include "xtensa/core-macros.h"
 
 #if CONFIG_FREERTOS_UNICORE
 #define PSRAM_MODE PSRAM_VADDR_MODE_NORMAL
@@ -283,6 +284,44 @@ void IRAM_ATTR esp_spiram_writeback_cache()
 #endif
 }
 
+/*
+ Loads taking longer than this many CPU cycles are counted as cache misses. A hit costs a few cycles,
+ while a miss waits for the SPI transaction which fills the 32 byte cache line, about a microsecond.
+*/
+#define SPIRAM_CACHE_LINE_SIZE      32
+#define SPIRAM_CACHE_MISS_CYCLES    50
+
+esp_err_t IRAM_ATTR esp_spiram_sample_cache(const void *addr, size_t size, esp_spiram_cache_sample_t *sample)
+{
+    if (!spiram_inited) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (sample == NULL || size == 0 || !esp_ptr_external_ram(addr)
+            || !esp_ptr_external_ram((const uint8_t *)addr + size - 1)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(sample, 0, sizeof(*sample));
+
+    uintptr_t end = (uintptr_t)addr + size;
+    for (uintptr_t line = (uintptr_t)addr & ~(SPIRAM_CACHE_LINE_SIZE - 1); line < end; line += SPIRAM_CACHE_LINE_SIZE) {
+        //Interrupts would be counted as load time, so only keep them off for the load itself
+        unsigned state = portENTER_CRITICAL_NESTED();
+        uint32_t start = XTHAL_GET_CCOUNT();
+        (void) *(volatile uint32_t *)line;
+        uint32_t cycles = XTHAL_GET_CCOUNT() - start;
+        portEXIT_CRITICAL_NESTED(state);
+
+        sample->lines++;
+        if (cycles < SPIRAM_CACHE_MISS_CYCLES) {
+            sample->hits++;
+        } else {
+            sample->misses++;
+            sample->miss_cycles += cycles;
+        }
+    }
+    return ESP_OK;
+}
+
 /**
  * @brief If SPI RAM(PSRAM) has been initialized
  *
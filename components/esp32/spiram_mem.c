@@ -0,0 +1,128 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+memcpy() and memset() for large blocks in external RAM.
+
+The external RAM cache works on 32-byte lines: the first access to a line which isn't cached waits for the SPI
+transfer of the whole line. The routines below align the destination to a cache line and then move one line per
+loop iteration. All eight words of a source line are loaded before any of them is stored, so when both buffers are
+in external RAM the line fills of source and destination don't alternate word by word. Everything runs from IRAM,
+because instructions fetched from flash would take up the same cache as the data.
+
+If source and destination aren't aligned to each other, words are loaded aligned and shifted into place, so no
+unaligned or byte accesses are made in the main loop either.
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp32/spiram.h"
+
+#define CACHE_LINE_SIZE     32
+//Below this size, setting up the line loop costs more than it saves
+#define MIN_LINE_COPY_SIZE  (2 * CACHE_LINE_SIZE)
+
+void *IRAM_ATTR esp_spiram_memcpy(void *dst, const void *src, size_t n)
+{
+    if (n < MIN_LINE_COPY_SIZE) {
+        return memcpy(dst, src, n);
+    }
+    uint8_t *d = dst;
+    const uint8_t *s = src;
+
+    //Align the destination to a word, then to a cache line
+    while ((uintptr_t)d & 3) {
+        *d++ = *s++;
+        n--;
+    }
+    size_t shift = ((uintptr_t)s & 3) * 8;
+    if (shift == 0) {
+        while ((uintptr_t)d & (CACHE_LINE_SIZE - 1)) {
+            *(uint32_t *)d = *(const uint32_t *)s;
+            d += 4;
+            s += 4;
+            n -= 4;
+        }
+        uint32_t *dw = (uint32_t *)d;
+        const uint32_t *sw = (const uint32_t *)s;
+        for (; n >= CACHE_LINE_SIZE; n -= CACHE_LINE_SIZE) {
+            uint32_t w0 = sw[0], w1 = sw[1], w2 = sw[2], w3 = sw[3];
+            uint32_t w4 = sw[4], w5 = sw[5], w6 = sw[6], w7 = sw[7];
+            dw[0] = w0; dw[1] = w1; dw[2] = w2; dw[3] = w3;
+            dw[4] = w4; dw[5] = w5; dw[6] = w6; dw[7] = w7;
+            dw += 8;
+            sw += 8;
+        }
+        d = (uint8_t *)dw;
+        s = (const uint8_t *)sw;
+    } else {
+        //Each destination word is made of two aligned source words. Loads never go past the
+        //aligned word holding the last source byte copied, so they stay inside the source buffer.
+        const uint32_t *sw = (const uint32_t *)(s - shift / 8);
+        uint32_t prev = *sw++;
+#define MERGE(lo, hi) (((lo) >> shift) | ((hi) << (32 - shift)))
+        while ((uintptr_t)d & (CACHE_LINE_SIZE - 1)) {
+            uint32_t next = *sw++;
+            *(uint32_t *)d = MERGE(prev, next);
+            prev = next;
+            d += 4;
+            n -= 4;
+        }
+        uint32_t *dw = (uint32_t *)d;
+        for (; n >= CACHE_LINE_SIZE + 4; n -= CACHE_LINE_SIZE) {
+            uint32_t w0 = sw[0], w1 = sw[1], w2 = sw[2], w3 = sw[3];
+            uint32_t w4 = sw[4], w5 = sw[5], w6 = sw[6], w7 = sw[7];
+            dw[0] = MERGE(prev, w0); dw[1] = MERGE(w0, w1);
+            dw[2] = MERGE(w1, w2); dw[3] = MERGE(w2, w3);
+            dw[4] = MERGE(w3, w4); dw[5] = MERGE(w4, w5);
+            dw[6] = MERGE(w5, w6); dw[7] = MERGE(w6, w7);
+            prev = w7;
+            dw += 8;
+            sw += 8;
+        }
+#undef MERGE
+        d = (uint8_t *)dw;
+        s = (const uint8_t *)sw - 4 + shift / 8;
+    }
+    memcpy(d, s, n);
+    return dst;
+}
+
+void *IRAM_ATTR esp_spiram_memset(void *dst, int c, size_t n)
+{
+    if (n < MIN_LINE_COPY_SIZE) {
+        return memset(dst, c, n);
+    }
+    uint8_t *d = dst;
+    uint32_t w = (uint8_t)c * 0x01010101U;
+
+    while ((uintptr_t)d & 3) {
+        *d++ = c;
+        n--;
+    }
+    while ((uintptr_t)d & (CACHE_LINE_SIZE - 1)) {
+        *(uint32_t *)d = w;
+        d += 4;
+        n -= 4;
+    }
+    uint32_t *dw = (uint32_t *)d;
+    for (; n >= CACHE_LINE_SIZE; n -= CACHE_LINE_SIZE) {
+        dw[0] = w; dw[1] = w; dw[2] = w; dw[3] = w;
+        dw[4] = w; dw[5] = w; dw[6] = w; dw[7] = w;
+        dw += 8;
+    }
+    memset(dw, c, n);
+    return dst;
+}
@@ -50,18 +50,13 @@ static const char *TAG = "task_wdt";
 //Empty define used in ASSERT_EXIT_CRIT_RETURN macro when returning in void
 #define VOID_RETURN
 
-//Structure used for each subscribed task
-typedef struct twdt_task_t twdt_task_t;
-struct twdt_task_t {
-    TaskHandle_t task_handle;
-    bool has_reset;
-    twdt_task_t *next;
-};
+//Maximum number of subscribed tasks, one bit of the twdt_fed bitmap each
+#define TWDT_MAX_TASKS      32
 
 //Structure used to hold run time configuration of the TWDT
 typedef struct twdt_config_t twdt_config_t;
 struct twdt_config_t {
-    twdt_task_t *list;      //Linked list of subscribed tasks
+    TaskHandle_t tasks[TWDT_MAX_TASKS];     //Subscribed tasks, indexed by slot
     uint32_t timeout;       //Timeout period of TWDT
     bool panic;             //Flag to trigger panic when TWDT times out
     intr_handle_t intr_handle;
@@ -70,6 +65,13 @@ struct twdt_config_t {
 static twdt_config_t *twdt_config = NULL;
 static portMUX_TYPE twdt_spinlock = portMUX_INITIALIZER_UNLOCKED;
 
+/*
+ * Bitmaps of the slots of the subscribed tasks, and of the ones which have reset
+ * since the hardware timer was last reset. Only accessed within critical.
+ */
+static uint32_t twdt_subscribed = 0;
+static uint32_t twdt_fed = 0;
+
 /*
  * Idle hook callback for Idle Tasks to reset the TWDT. This callback will only
  * be registered to the Idle Hook of a particular core when the corresponding
@@ -82,28 +84,22 @@ static bool idle_hook_cb(void)
 }
 
 /*
- * Internal function that looks for the target task in the TWDT task list.
- * Returns the list item if found and returns null if not found. Also checks if
- * all the other tasks have reset. Should be called within critical.
+ * Returns the slot of a task, or -1 if the task is not subscribed. Only the
+ * slots set in twdt_subscribed are compared. Called within critical
  */
-static twdt_task_t *find_task_in_twdt_list(TaskHandle_t handle, bool *all_reset)
+static int get_task_slot(TaskHandle_t handle)
 {
-    twdt_task_t *target = NULL;
-    *all_reset = true;
-    for(twdt_task_t *task = twdt_config->list; task != NULL; task = task->next){
-        if(task->task_handle == handle){
-            target = task;   //Get pointer to target task list member
-        }else{
-            if(task->has_reset == false){     //If a task has yet to reset
-                *all_reset = false;
-            }
+    for (uint32_t slots = twdt_subscribed; slots != 0; slots &= slots - 1) {
+        int slot = __builtin_ctz(slots);
+        if (twdt_config->tasks[slot] == handle) {
+            return slot;
         }
     }
-    return target;
+    return -1;
 }
 
 /*
- * Resets the hardware timer and has_reset flags of each task on the list.
+ * Resets the hardware timer and the fed flags of every task.
  * Called within critical
  */
 static void reset_hw_timer()
@@ -112,9 +108,17 @@ static void reset_hw_timer()
     TIMERG0.wdt_wprotect=TIMG_WDT_WKEY_VALUE;
     TIMERG0.wdt_feed=1;
     TIMERG0.wdt_wprotect=0;
-    //Clear all has_reset flags in list
-    for (twdt_task_t *task = twdt_config->list; task != NULL; task = task->next){
-        task->has_reset=false;
+    //Clear all fed flags
+    twdt_fed = 0;
+}
+
+/*
+ * Resets the hardware timer if all subscribed tasks have reset. Called within critical
+ */
+static void reset_hw_timer_if_all_fed()
+{
+    if(twdt_fed == twdt_subscribed){
+        reset_hw_timer();
     }
 }
 
@@ -136,7 +140,6 @@ void __attribute__((weak)) esp_task_wdt_isr_user_handler(void)
 static void task_wdt_isr(void *arg)
 {
     portENTER_CRITICAL_ISR(&twdt_spinlock);
-    twdt_task_t *twdttask;
     const char *cpu;
     //Reset hardware timer so that 2nd stage timeout is not reached (will trigger system reset)
     TIMERG0.wdt_wprotect=TIMG_WDT_WKEY_VALUE;
@@ -150,15 +153,17 @@ static void task_wdt_isr(void *arg)
     //than the badness caused by a spinlock here.
 
     //Return immediately if no tasks have been added to task list
-    ASSERT_EXIT_CRIT_RETURN((twdt_config->list != NULL), VOID_RETURN);
+    ASSERT_EXIT_CRIT_RETURN((twdt_subscribed != 0), VOID_RETURN);
 
     //Watchdog got triggered because at least one task did not reset in time.
     ESP_EARLY_LOGE(TAG, "Task watchdog got triggered. The following tasks did not reset the watchdog in time:");
-    for (twdttask=twdt_config->list; twdttask!=NULL; twdttask=twdttask->next) {
-        if (!twdttask->has_reset) {
-            cpu=xTaskGetAffinity(twdttask->task_handle)==0?DRAM_STR("CPU 0"):DRAM_STR("CPU 1");
-            if (xTaskGetAffinity(twdttask->task_handle)==tskNO_AFFINITY) cpu=DRAM_STR("CPU 0/1");
-            ESP_EARLY_LOGE(TAG, " - %s (%s)", pcTaskGetTaskName(twdttask->task_handle), cpu);
+    uint32_t not_fed = twdt_subscribed & ~twdt_fed;
+    for (int slot = 0; slot < TWDT_MAX_TASKS; slot++) {
+        if (not_fed & (1U << slot)) {
+            TaskHandle_t handle = twdt_config->tasks[slot];
+            cpu=xTaskGetAffinity(handle)==0?DRAM_STR("CPU 0"):DRAM_STR("CPU 1");
+            if (xTaskGetAffinity(handle)==tskNO_AFFINITY) cpu=DRAM_STR("CPU 0/1");
+            ESP_EARLY_LOGE(TAG, " - %s (%s)", pcTaskGetTaskName(handle), cpu);
         }
     }
     ESP_EARLY_LOGE(TAG, "%s", DRAM_STR("Tasks currently running:"));
@@ -191,7 +196,6 @@ esp_err_t esp_task_wdt_init(uint32_t timeout, bool panic)
         twdt_config = calloc(1, sizeof(twdt_config_t));
         ASSERT_EXIT_CRIT_RETURN((twdt_config != NULL), ESP_ERR_NO_MEM);
 
-        twdt_config->list = NULL;
         twdt_config->timeout = timeout;
         twdt_config->panic = panic;
 
@@ -237,7 +241,7 @@ esp_err_t esp_task_wdt_deinit()
     //TWDT must already be initialized
     ASSERT_EXIT_CRIT_RETURN((twdt_config != NULL), ESP_ERR_NOT_FOUND);
     //Task list must be empty
-    ASSERT_EXIT_CRIT_RETURN((twdt_config->list == NULL), ESP_ERR_INVALID_STATE);
+    ASSERT_EXIT_CRIT_RETURN((twdt_subscribed == 0), ESP_ERR_INVALID_STATE);
 
     //Disable hardware timer
     TIMERG0.wdt_wprotect=TIMG_WDT_WKEY_VALUE;   //Disable write protection
@@ -257,31 +261,19 @@ esp_err_t esp_task_wdt_add(TaskHandle_t handle)
     //TWDT must already be initialized
     ASSERT_EXIT_CRIT_RETURN((twdt_config != NULL), ESP_ERR_INVALID_STATE);
 
-    twdt_task_t *target_task;
-    bool all_reset;
     if (handle == NULL){    //Get handle of current task if none is provided
         handle = xTaskGetCurrentTaskHandle();
     }
-    //Check if tasks exists in task list, and if all other tasks have reset
-    target_task = find_task_in_twdt_list(handle, &all_reset);
     //task cannot be already subscribed
-    ASSERT_EXIT_CRIT_RETURN((target_task == NULL), ESP_ERR_INVALID_ARG);
-
-    //Add target task to TWDT task list
-    target_task = calloc(1,sizeof(twdt_task_t));
-    ASSERT_EXIT_CRIT_RETURN((target_task != NULL), ESP_ERR_NO_MEM);
-    target_task->task_handle = handle;
-    target_task->has_reset = true;
-    target_task->next = NULL;
-    if (twdt_config->list == NULL) {    //Adding to empty list
-        twdt_config->list = target_task;
-    } else {    //Adding to tail of list
-        twdt_task_t *task;
-        for (task = twdt_config->list; task->next != NULL; task = task->next){
-            ;   //point task to current tail of TWDT task list
-        }
-        task->next = target_task;
-    }
+    ASSERT_EXIT_CRIT_RETURN((get_task_slot(handle) < 0), ESP_ERR_INVALID_ARG);
+    //There must be a free slot
+    ASSERT_EXIT_CRIT_RETURN((twdt_subscribed != UINT32_MAX), ESP_ERR_NO_MEM);
+
+    //Subscribe the task to the TWDT in the lowest free slot. The task starts out as having reset.
+    int slot = __builtin_ctz(~twdt_subscribed);
+    twdt_config->tasks[slot] = handle;
+    twdt_fed |= 1U << slot;
+    twdt_subscribed |= 1U << slot;
 
     //If idle task, register the idle hook callback to appropriate core
     for(int i = 0; i < portNUM_PROCESSORS; i++){
@@ -291,9 +283,7 @@ esp_err_t esp_task_wdt_add(TaskHandle_t handle)
         }
     }
 
-    if(all_reset){     //Reset hardware timer if all other tasks in list have reset in
-        reset_hw_timer();
-    }
+    reset_hw_timer_if_all_fed();     //Reset hardware timer if all other tasks have reset in
 
     portEXIT_CRITICAL(&twdt_spinlock);       //Nested critical if Legacy
     return ESP_OK;
@@ -305,19 +295,13 @@ esp_err_t esp_task_wdt_reset()
     //TWDT must already be initialized
     ASSERT_EXIT_CRIT_RETURN((twdt_config != NULL), ESP_ERR_INVALID_STATE);
 
-    TaskHandle_t handle = xTaskGetCurrentTaskHandle();
-    twdt_task_t *target_task;
-    bool all_reset;
+    int slot = get_task_slot(xTaskGetCurrentTaskHandle());
+    //Return error if trying to reset task that is not subscribed
+    ASSERT_EXIT_CRIT_RETURN((slot >= 0), ESP_ERR_NOT_FOUND);
 
-    //Check if task exists in task list, and if all other tasks have reset
-    target_task = find_task_in_twdt_list(handle, &all_reset);
-    //Return error if trying to reset task that is not on the task list
-    ASSERT_EXIT_CRIT_RETURN((target_task != NULL), ESP_ERR_NOT_FOUND);
-
-    target_task->has_reset = true;    //Reset the task if it's on the task list
-    if(all_reset){     //Reset if all other tasks in list have reset in
-        reset_hw_timer();
-    }
+    //Mark the task as having reset. The last task to reset resets the hardware timer
+    twdt_fed |= 1U << slot;
+    reset_hw_timer_if_all_fed();
 
     portEXIT_CRITICAL(&twdt_spinlock);
     return ESP_OK;
@@ -332,23 +316,13 @@ esp_err_t esp_task_wdt_delete(TaskHandle_t handle)
     //Return error if twdt has not been initialized
     ASSERT_EXIT_CRIT_RETURN((twdt_config != NULL), ESP_ERR_NOT_FOUND);
 
-    twdt_task_t *target_task;
-    bool all_reset;
-    target_task = find_task_in_twdt_list(handle, &all_reset);
-    //Task doesn't exist on list. Return error
-    ASSERT_EXIT_CRIT_RETURN((target_task != NULL), ESP_ERR_INVALID_ARG);
-
-    if(target_task == twdt_config->list){     //target_task is head of list. Delete
-        twdt_config->list = target_task->next;
-        free(target_task);
-    }else{                                      //target_task not head of list. Delete
-        twdt_task_t *prev;
-        for (prev = twdt_config->list; prev->next != target_task; prev = prev->next){
-            ;   //point prev to task preceding target_task
-        }
-        prev->next = target_task->next;
-        free(target_task);
-    }
+    int slot = get_task_slot(handle);
+    //Task isn't subscribed. Return error
+    ASSERT_EXIT_CRIT_RETURN((slot >= 0), ESP_ERR_INVALID_ARG);
+
+    twdt_subscribed &= ~(1U << slot);
+    twdt_fed &= ~(1U << slot);
+    twdt_config->tasks[slot] = NULL;
 
     //If idle task, deregister idle hook callback form appropriate core
     for(int i = 0; i < portNUM_PROCESSORS; i++){
@@ -358,9 +332,7 @@ esp_err_t esp_task_wdt_delete(TaskHandle_t handle)
         }
     }
 
-    if(all_reset){     //Reset hardware timer if all remaining tasks have reset
-        reset_hw_timer();
-    }
+    reset_hw_timer_if_all_fed();     //Reset hardware timer if all remaining tasks have reset
 
     portEXIT_CRITICAL(&twdt_spinlock);
     return ESP_OK;
@@ -376,56 +348,16 @@ esp_err_t esp_task_wdt_status(TaskHandle_t handle)
     //Return if TWDT is not initialized
     ASSERT_EXIT_CRIT_RETURN((twdt_config != NULL), ESP_ERR_INVALID_STATE);
 
-    twdt_task_t *task;
-    for(task = twdt_config->list; task!=NULL; task=task->next){
-        //Return ESP_OK if task is found
-        ASSERT_EXIT_CRIT_RETURN((task->task_handle != handle), ESP_OK);
-    }
-
-    //Task could not be found
+    //Return ESP_OK if the task is subscribed
+    int slot = get_task_slot(handle);
     portEXIT_CRITICAL(&twdt_spinlock);
-    return ESP_ERR_NOT_FOUND;
+    return (slot >= 0) ? ESP_OK : ESP_ERR_NOT_FOUND;
 }
 
 void esp_task_wdt_feed()
 {
-    portENTER_CRITICAL(&twdt_spinlock);
-    //Return immediately if TWDT has not been initialized
-    ASSERT_EXIT_CRIT_RETURN((twdt_config != NULL), VOID_RETURN);
-
-    //Check if task is on list
-    TaskHandle_t handle = xTaskGetCurrentTaskHandle();
-    bool all_reset;
-    twdt_task_t *target_task = find_task_in_twdt_list(handle, &all_reset);
-
-    //reset the task if it's on the list, then return
-    if(target_task != NULL){
-        target_task->has_reset = true;
-        if(all_reset){
-            reset_hw_timer();       //Reset hardware timer if all other tasks have reset
-        }
-        portEXIT_CRITICAL(&twdt_spinlock);
-        return;
-    }
-
-    //Add task if it's has not on list
-    target_task = calloc(1, sizeof(twdt_task_t));
-    ASSERT_EXIT_CRIT_RETURN((target_task != NULL), VOID_RETURN);   //If calloc failed
-    target_task->task_handle = handle;
-    target_task->has_reset = true;
-    target_task->next = NULL;
-
-    if (twdt_config->list == NULL) {    //Adding to empty list
-        twdt_config->list = target_task;
-    } else {    //Adding to tail of list
-        twdt_task_t *task;
-        for (task = twdt_config->list; task->next != NULL; task = task->next){
-            ;   //point task to current tail of wdt task list
-        }
-        task->next = target_task;
+    //Reset the task if it's subscribed, otherwise subscribe it
+    if(esp_task_wdt_reset() == ESP_ERR_NOT_FOUND){
+        esp_task_wdt_add(NULL);
     }
-
-    portEXIT_CRITICAL(&twdt_spinlock);
 }
-
-
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_crc.h"
+#include "esp32/rom/crc.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "idf_performance.h"
+#include "unity.h"
+#include "test_utils.h"
+
+#define CRC_BUFFER_SIZE 4096
+
+static uint8_t *alloc_random_buffer(size_t size)
+{
+    uint8_t *buf = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(buf);
+    for (size_t i = 0; i < size; i++) {
+        buf[i] = rand();
+    }
+    return buf;
+}
+
+TEST_CASE("esp_crc32_le and esp_crc16_be match the ROM functions", "[crc]")
+{
+    uint8_t *buf = alloc_random_buffer(CRC_BUFFER_SIZE);
+
+    TEST_ASSERT_EQUAL_HEX32(0xcbf43926, esp_crc32_le(0, (const uint8_t *) "123456789", 9));
+    for (int offset = 0; offset < 8; offset++) {
+        for (size_t len = 0; len < 100; len++) {
+            uint32_t crc = rand();
+            TEST_ASSERT_EQUAL_HEX32(crc32_le(crc, buf + offset, len), esp_crc32_le(crc, buf + offset, len));
+            TEST_ASSERT_EQUAL_HEX16(crc16_be(crc, buf + offset, len), esp_crc16_be(crc, buf + offset, len));
+        }
+    }
+    TEST_ASSERT_EQUAL_HEX32(crc32_le(0, buf, CRC_BUFFER_SIZE), esp_crc32_le(0, buf, CRC_BUFFER_SIZE));
+    TEST_ASSERT_EQUAL_HEX16(crc16_be(0, buf, CRC_BUFFER_SIZE), esp_crc16_be(0, buf, CRC_BUFFER_SIZE));
+
+    /* incremental */
+    uint32_t crc = esp_crc32_le(0xffffffff, buf, 13);
+    crc = esp_crc32_le(crc, buf + 13, CRC_BUFFER_SIZE - 13);
+    TEST_ASSERT_EQUAL_HEX32(crc32_le(0xffffffff, buf, CRC_BUFFER_SIZE), crc);
+
+    free(buf);
+}
+
+TEST_CASE("esp_crc32_le_combine", "[crc]")
+{
+    uint8_t *buf = alloc_random_buffer(CRC_BUFFER_SIZE);
+    const size_t split[] = { 0, 1, 7, 100, 1024, CRC_BUFFER_SIZE - 1, CRC_BUFFER_SIZE };
+
+    for (size_t i = 0; i < sizeof(split) / sizeof(split[0]); i++) {
+        size_t len1 = split[i];
+        size_t len2 = CRC_BUFFER_SIZE - len1;
+        uint32_t crc1 = esp_crc32_le(0xffffffff, buf, len1);
+        uint32_t crc2 = esp_crc32_le(0, buf + len1, len2);
+        TEST_ASSERT_EQUAL_HEX32(esp_crc32_le(0xffffffff, buf, CRC_BUFFER_SIZE),
+                                esp_crc32_le_combine(crc1, crc2, len2));
+    }
+    free(buf);
+}
+
+TEST_CASE("esp_crc32_le performance", "[crc]")
+{
+    const int count = 64;
+    uint8_t *buf = alloc_random_buffer(CRC_BUFFER_SIZE);
+    volatile uint32_t crc = 0;
+
+    /* warm up the flash cache with the tables */
+    crc = esp_crc32_le(crc, buf, CRC_BUFFER_SIZE);
+
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < count; i++) {
+        crc = crc32_le(crc, buf, CRC_BUFFER_SIZE);
+    }
+    int us_rom = (esp_timer_get_time() - start) / count;
+
+    start = esp_timer_get_time();
+    for (int i = 0; i < count; i++) {
+        crc = esp_crc32_le(crc, buf, CRC_BUFFER_SIZE);
+    }
+    int us_crc32 = (esp_timer_get_time() - start) / count;
+
+    start = esp_timer_get_time();
+    for (int i = 0; i < count; i++) {
+        /* 32 byte NVS entries */
+        for (int j = 0; j < CRC_BUFFER_SIZE; j += 32) {
+            crc = esp_crc32_le(crc, buf + j, 32);
+        }
+    }
+    int us_crc32_entries = (esp_timer_get_time() - start) / count;
+
+    start = esp_timer_get_time();
+    for (int i = 0; i < count; i++) {
+        crc = esp_crc16_be(crc, buf, CRC_BUFFER_SIZE);
+    }
+    int us_crc16 = (esp_timer_get_time() - start) / count;
+
+    printf("4 KB: ROM crc32_le %d us, esp_crc32_le %d us (%d us in 32 byte calls), esp_crc16_be %d us\n",
+           us_rom, us_crc32, us_crc32_entries, us_crc16);
+    free(buf);
+
+#if CONFIG_ESP_CRC_TABLES
+    TEST_ASSERT_LESS_THAN(us_rom, us_crc32);
+    TEST_PERFORMANCE_LESS_THAN(ESP_CRC32_4KB_TIME, "%dus", us_crc32);
+#endif
+}
@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "unity.h"
+#include "esp_crosscore_int.h"
+#include "esp_private/crosscore_int.h"
+
+#define PING_PONG_ROUNDS 10000
+
+static SemaphoreHandle_t s_ping, s_pong, s_done;
+
+static void ping_task(void *arg)
+{
+    for (int i = 0; i < PING_PONG_ROUNDS; i++) {
+        xSemaphoreGive(s_ping);
+        xSemaphoreTake(s_pong, portMAX_DELAY);
+    }
+    xSemaphoreGive(s_done);
+    vTaskDelete(NULL);
+}
+
+static void pong_task(void *arg)
+{
+    for (int i = 0; i < PING_PONG_ROUNDS; i++) {
+        xSemaphoreTake(s_ping, portMAX_DELAY);
+        xSemaphoreGive(s_pong);
+    }
+    xSemaphoreGive(s_done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("no yield is lost when cross-core interrupts are coalesced", "[esp32]")
+{
+    s_ping = xSemaphoreCreateBinary();
+    s_pong = xSemaphoreCreateBinary();
+    s_done = xSemaphoreCreateCounting(2, 0);
+    TEST_ASSERT(s_ping && s_pong && s_done);
+#if CONFIG_CROSSCORE_INT_PROFILING
+    TEST_ESP_OK(esp_crosscore_int_reset_stats());
+#endif
+
+    /* each give wakes the task of the other core, and each take yields within the API */
+    xTaskCreatePinnedToCore(ping_task, "ping", 2048, NULL, UNITY_FREERTOS_PRIORITY + 1, NULL, 0);
+    xTaskCreatePinnedToCore(pong_task, "pong", 2048, NULL, UNITY_FREERTOS_PRIORITY + 1, NULL, portNUM_PROCESSORS - 1);
+    TEST_ASSERT_TRUE(xSemaphoreTake(s_done, 5000 / portTICK_PERIOD_MS));
+    TEST_ASSERT_TRUE(xSemaphoreTake(s_done, 5000 / portTICK_PERIOD_MS));
+
+#if CONFIG_CROSSCORE_INT_PROFILING
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        esp_crosscore_int_stats_t stats;
+        TEST_ESP_OK(esp_crosscore_int_get_stats(core, &stats));
+        printf("core %d: yield sent %u coalesced %u, ISR %u, latency avg %u max %u us\n", core,
+               (unsigned) stats.yield_sent, (unsigned) stats.yield_coalesced, (unsigned) stats.isr_count,
+               stats.latency_count ? (unsigned) (stats.latency_total_us / stats.latency_count) : 0,
+               (unsigned) stats.latency_max_us);
+        TEST_ASSERT_GREATER_THAN(0, stats.yield_sent);
+        TEST_ASSERT_GREATER_OR_EQUAL(stats.latency_count, stats.isr_count);
+    }
+#endif
+
+    vSemaphoreDelete(s_ping);
+    vSemaphoreDelete(s_pong);
+    vSemaphoreDelete(s_done);
+}
+
+#if CONFIG_CROSSCORE_INT_PROFILING
+TEST_CASE("pending cross-core yield requests are coalesced", "[esp32]")
+{
+    static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+    esp_crosscore_int_stats_t before, after;
+    const int core = xPortGetCoreID();
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_crosscore_int_get_stats(portNUM_PROCESSORS, &before));
+    TEST_ESP_OK(esp_crosscore_int_get_stats(core, &before));
+    /* the interrupt is masked in the critical section, the requests after the first are coalesced */
+    portENTER_CRITICAL(&mux);
+    for (int i = 0; i < 10; i++) {
+        esp_crosscore_int_send_yield(core);
+    }
+    portEXIT_CRITICAL(&mux);
+    TEST_ESP_OK(esp_crosscore_int_get_stats(core, &after));
+
+    TEST_ASSERT_GREATER_OR_EQUAL(1, after.yield_sent - before.yield_sent);
+    TEST_ASSERT_GREATER_OR_EQUAL(9, after.yield_coalesced - before.yield_coalesced);
+    TEST_ASSERT_GREATER_OR_EQUAL(1, after.isr_count - before.isr_count);
+    TEST_ASSERT_GREATER_OR_EQUAL(1, after.latency_count - before.latency_count);
+}
+#else
+TEST_CASE("cross-core interrupt statistics are disabled", "[esp32]")
+{
+    esp_crosscore_int_stats_t stats;
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, esp_crosscore_int_get_stats(0, &stats));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, esp_crosscore_int_reset_stats());
+}
+#endif
@@ -0,0 +1,149 @@
+/*
+ Tests for the shared DMA bounce pool, with a peripheral emulated by memcpy.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "esp_heap_caps.h"
+#include "soc/soc_memory_layout.h"
+#include "esp32/dma_bounce.h"
+#include "sdkconfig.h"
+
+#define TEST_CHUNK_SIZE 1024
+#define TEST_LEN        (5 * TEST_CHUNK_SIZE + 100)
+
+typedef struct {
+    uint8_t *mem;           //memory of the emulated peripheral
+    bool rx;
+    void *buf;              //chunk in flight, NULL if none
+    size_t offset;
+    size_t len;
+    size_t chunks;
+    size_t progress;
+} test_dev_t;
+
+static esp_err_t test_start(void *dma_buf, size_t offset, size_t len, void *arg)
+{
+    test_dev_t *dev = (test_dev_t *)arg;
+    TEST_ASSERT_NULL(dev->buf);
+    TEST_ASSERT(esp_ptr_dma_capable(dma_buf));
+    if (dev->rx) {
+        memcpy(dma_buf, dev->mem + offset, len);
+    }
+    dev->buf = dma_buf;
+    dev->offset = offset;
+    dev->len = len;
+    dev->chunks++;
+    return ESP_OK;
+}
+
+static esp_err_t test_finish(void *arg)
+{
+    test_dev_t *dev = (test_dev_t *)arg;
+    TEST_ASSERT_NOT_NULL(dev->buf);
+    if (!dev->rx) {
+        memcpy(dev->mem + dev->offset, dev->buf, dev->len);
+    }
+    dev->buf = NULL;
+    return ESP_OK;
+}
+
+static void test_progress(size_t done, size_t total, void *arg)
+{
+    test_dev_t *dev = (test_dev_t *)arg;
+    TEST_ASSERT_GREATER_THAN(dev->progress, done);
+    TEST_ASSERT_LESS_OR_EQUAL(total, done);
+    dev->progress = done;
+}
+
+static void create_pool(void)
+{
+    if (esp_dma_bounce_chunk_size() == 0) {
+        TEST_ESP_OK(esp_dma_bounce_init(TEST_CHUNK_SIZE, 2));
+    }
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, esp_dma_bounce_init(TEST_CHUNK_SIZE, 2));
+}
+
+TEST_CASE("DMA bounce pool streams buffers which are not DMA-capable", "[dma_bounce]")
+{
+    create_pool();
+#if CONFIG_SPIRAM_USE_CAPS_ALLOC || CONFIG_SPIRAM_USE_MALLOC
+    uint8_t *data = heap_caps_malloc(TEST_LEN + 1, MALLOC_CAP_SPIRAM);
+#else
+    uint8_t *data = heap_caps_malloc(TEST_LEN + 1, MALLOC_CAP_8BIT);
+#endif
+    uint8_t *mem = heap_caps_malloc(TEST_LEN, MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(data);
+    TEST_ASSERT_NOT_NULL(mem);
+    for (int i = 0; i < TEST_LEN; i++) {
+        data[i + 1] = rand();
+    }
+    esp_dma_bounce_stats_t before, after;
+    esp_dma_bounce_get_stats(&before);
+
+    test_dev_t dev = { .mem = mem };
+    esp_dma_bounce_stream_t stream = {
+        .start = test_start,
+        .finish = test_finish,
+        .progress = test_progress,
+        .arg = &dev,
+        .align = 512,
+    };
+    memset(mem, 0, TEST_LEN);
+    TEST_ESP_OK(esp_dma_bounce_tx(&stream, data + 1, TEST_LEN));
+    TEST_ASSERT_NULL(dev.buf);
+    TEST_ASSERT_EQUAL(TEST_LEN, dev.progress);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(data + 1, mem, TEST_LEN);
+
+    dev = (test_dev_t) { .mem = mem, .rx = true };
+    memset(data, 0, TEST_LEN + 1);
+    TEST_ESP_OK(esp_dma_bounce_rx(&stream, data + 1, TEST_LEN));
+    TEST_ASSERT_NULL(dev.buf);
+    TEST_ASSERT_EQUAL(TEST_LEN, dev.progress);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(mem, data + 1, TEST_LEN);
+    size_t chunk_len = esp_dma_bounce_chunk_size() / 512 * 512;
+    TEST_ASSERT_EQUAL((TEST_LEN + chunk_len - 1) / chunk_len, dev.chunks);
+
+    esp_dma_bounce_get_stats(&after);
+    TEST_ASSERT_EQUAL(before.free_chunks, after.free_chunks);
+    TEST_ASSERT_EQUAL(2 * TEST_LEN, after.bytes - before.bytes);
+
+    free(data);
+    free(mem);
+}
+
+TEST_CASE("DMA bounce pool fails cleanly when all chunks are in use", "[dma_bounce]")
+{
+    create_pool();
+    esp_dma_bounce_stats_t stats;
+    esp_dma_bounce_get_stats(&stats);
+    void **chunks = calloc(stats.chunks, sizeof(void *));
+    TEST_ASSERT_NOT_NULL(chunks);
+    for (int i = 0; i < stats.free_chunks; i++) {
+        chunks[i] = esp_dma_bounce_get();
+        TEST_ASSERT(esp_dma_bounce_is_chunk(chunks[i]));
+    }
+    TEST_ASSERT_NULL(esp_dma_bounce_get());
+
+    uint8_t data[16];
+    test_dev_t dev = { .mem = data };
+    esp_dma_bounce_stream_t stream = { .start = test_start, .finish = test_finish, .arg = &dev };
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, esp_dma_bounce_tx(&stream, data, sizeof(data)));
+    TEST_ASSERT_EQUAL(0, dev.chunks);
+
+    esp_dma_bounce_stats_t exhausted;
+    esp_dma_bounce_get_stats(&exhausted);
+    TEST_ASSERT_EQUAL(0, exhausted.free_chunks);
+    TEST_ASSERT_EQUAL(0, exhausted.min_free_chunks);
+    TEST_ASSERT_EQUAL(2, exhausted.exhausted - stats.exhausted);
+    for (int i = 0; i < stats.free_chunks; i++) {
+        esp_dma_bounce_put(chunks[i]);
+    }
+    free(chunks);
+
+    stream.align = esp_dma_bounce_chunk_size() + 1;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, esp_dma_bounce_tx(&stream, data, sizeof(data)));
+}
@@ -594,3 +594,182 @@ TEST_CASE("after esp_timer_impl_advance, timers run when expected", "[esp_timer]
 
     ref_clock_deinit();
 }
+
+TEST_CASE("esp_timer dispatches a large number of timers in order", "[esp_timer]")
+{
+#define NUM_TIMERS 200
+
+    typedef struct {
+        int64_t last_timeout;
+        size_t count;
+        bool pass;
+    } test_state_t;
+
+    typedef struct {
+        int64_t timeout;
+        test_state_t* state;
+    } test_args_t;
+
+    void timer_func(void* varg)
+    {
+        test_args_t* arg = (test_args_t*) varg;
+        if (arg->timeout < arg->state->last_timeout) {
+            arg->state->pass = false;
+        }
+        arg->state->last_timeout = arg->timeout;
+        arg->state->count++;
+    }
+
+    test_state_t state = { .pass = true };
+    test_args_t* args = calloc(NUM_TIMERS, sizeof(test_args_t));
+    esp_timer_handle_t* handles = calloc(NUM_TIMERS, sizeof(esp_timer_handle_t));
+    TEST_ASSERT_NOT_NULL(args);
+    TEST_ASSERT_NOT_NULL(handles);
+
+    for (size_t i = 0; i < NUM_TIMERS; ++i) {
+        /* distinct timeouts 1ms apart, armed in a scrambled order */
+        args[i].timeout = 20000 + ((i * 73) % NUM_TIMERS) * 1000;
+        args[i].state = &state;
+        esp_timer_create_args_t timer_args = {
+                .callback = &timer_func,
+                .arg = &args[i],
+        };
+        TEST_ESP_OK(esp_timer_create(&timer_args, &handles[i]));
+    }
+
+    /* time arming and stopping one more timer while the others are armed */
+    int64_t t_start = esp_timer_get_time();
+    for (size_t i = 0; i < NUM_TIMERS; ++i) {
+        TEST_ESP_OK(esp_timer_start_once(handles[i], args[i].timeout));
+    }
+    int64_t t_armed = esp_timer_get_time();
+    esp_timer_create_args_t extra_args = { .callback = &timer_func };
+    esp_timer_handle_t extra;
+    TEST_ESP_OK(esp_timer_create(&extra_args, &extra));
+    const int iterations = 1000;
+    int64_t t_cycle_start = esp_timer_get_time();
+    for (int i = 0; i < iterations; ++i) {
+        TEST_ESP_OK(esp_timer_start_once(extra, 1000000 + i));
+        TEST_ESP_OK(esp_timer_stop(extra));
+    }
+    int64_t t_cycle_end = esp_timer_get_time();
+    printf("Arming %d timers took %lld us, start+stop with %d armed timers took %lld ns\n",
+            NUM_TIMERS, t_armed - t_start, NUM_TIMERS,
+            (t_cycle_end - t_cycle_start) * 1000 / iterations);
+
+    vTaskDelay((20 + NUM_TIMERS + 100) / portTICK_PERIOD_MS);
+    TEST_ASSERT_EQUAL(NUM_TIMERS, state.count);
+    TEST_ASSERT_TRUE(state.pass);
+
+    TEST_ESP_OK(esp_timer_delete(extra));
+    for (size_t i = 0; i < NUM_TIMERS; ++i) {
+        TEST_ESP_OK(esp_timer_delete(handles[i]));
+    }
+    free(handles);
+    free(args);
+#undef NUM_TIMERS
+}
+
+#ifdef CONFIG_ESP_TIMER_ISR_DISPATCH
+typedef struct {
+    int64_t expected_time;
+    int64_t max_delay;
+    int count;
+    bool in_isr;
+} test_isr_dispatch_state_t;
+
+static void IRAM_ATTR test_isr_dispatch_cb(void* varg)
+{
+    test_isr_dispatch_state_t* state = (test_isr_dispatch_state_t*) varg;
+    int64_t now = esp_timer_get_time();
+    state->max_delay = MAX(state->max_delay, now - state->expected_time);
+    state->expected_time += 1000;
+    state->in_isr = xPortInIsrContext();
+    state->count++;
+}
+
+TEST_CASE("esp_timer calls ESP_TIMER_ISR callbacks from the ISR", "[esp_timer]")
+{
+    test_isr_dispatch_state_t state = { 0 };
+    esp_timer_create_args_t timer_args = {
+            .callback = &test_isr_dispatch_cb,
+            .arg = &state,
+            .dispatch_method = ESP_TIMER_ISR,
+            .name = "isr_dispatch"
+    };
+    esp_timer_handle_t timer;
+    TEST_ESP_OK(esp_timer_create(&timer_args, &timer));
+    state.expected_time = esp_timer_get_time() + 1000;
+    TEST_ESP_OK(esp_timer_start_periodic(timer, 1000));
+    vTaskDelay(100 / portTICK_PERIOD_MS);
+    TEST_ESP_OK(esp_timer_stop(timer));
+    TEST_ESP_OK(esp_timer_delete(timer));
+    printf("count=%d max_delay=%lld us\n", state.count, state.max_delay);
+    TEST_ASSERT_TRUE(state.in_isr);
+    TEST_ASSERT_INT_WITHIN(2, 100, state.count);
+    TEST_ASSERT_LESS_THAN(100, (int) state.max_delay);
+}
+#endif // CONFIG_ESP_TIMER_ISR_DISPATCH
+
+#ifdef CONFIG_ESP_TIMER_TASK_PER_CORE
+TEST_CASE("esp_timer calls callbacks from the task of the given core", "[esp_timer]")
+{
+    void timer_func(void* varg)
+    {
+        *(int*) varg = xPortGetCoreID();
+    }
+
+    for (int core = 0; core < portNUM_PROCESSORS; ++core) {
+        int callback_core = -1;
+        esp_timer_create_args_t timer_args = {
+                .callback = &timer_func,
+                .arg = &callback_core,
+                .core_id = core
+        };
+        esp_timer_handle_t timer;
+        TEST_ESP_OK(esp_timer_create(&timer_args, &timer));
+        TEST_ESP_OK(esp_timer_start_once(timer, 1000));
+        vTaskDelay(10 / portTICK_PERIOD_MS);
+        TEST_ESP_OK(esp_timer_delete(timer));
+        TEST_ASSERT_EQUAL(core, callback_core);
+    }
+
+    esp_timer_create_args_t invalid_args = {
+            .callback = &timer_func,
+            .core_id = portNUM_PROCESSORS
+    };
+    esp_timer_handle_t timer;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_timer_create(&invalid_args, &timer));
+}
+#endif // CONFIG_ESP_TIMER_TASK_PER_CORE
+
+TEST_CASE("esp_timer calls timers with slack together", "[esp_timer]")
+{
+    void timer_func(void* varg)
+    {
+        *(int64_t*) varg = esp_timer_get_time();
+    }
+
+    int64_t cb_time[2] = { 0 };
+    esp_timer_create_args_t timer_args[2] = {
+        { .callback = &timer_func, .arg = &cb_time[0], .slack_us = 10000, .name = "slack" },
+        { .callback = &timer_func, .arg = &cb_time[1], .name = "exact" },
+    };
+    esp_timer_handle_t timers[2];
+    TEST_ESP_OK(esp_timer_create(&timer_args[0], &timers[0]));
+    TEST_ESP_OK(esp_timer_create(&timer_args[1], &timers[1]));
+
+    int64_t t_start = esp_timer_get_time();
+    TEST_ESP_OK(esp_timer_start_once(timers[0], 10000));
+    TEST_ESP_OK(esp_timer_start_once(timers[1], 15000));
+    TEST_ASSERT_INT_WITHIN(100, t_start + 20000, esp_timer_get_next_alarm());
+    vTaskDelay(50 / portTICK_PERIOD_MS);
+    printf("slack timer after %lld us, exact timer after %lld us\n",
+            cb_time[0] - t_start, cb_time[1] - t_start);
+    /* the timer with slack waits for the exact one */
+    TEST_ASSERT_INT_WITHIN(2000, 15000, (int) (cb_time[0] - t_start));
+    TEST_ASSERT_INT_WITHIN(2000, 15000, (int) (cb_time[1] - t_start));
+
+    TEST_ESP_OK(esp_timer_delete(timers[0]));
+    TEST_ESP_OK(esp_timer_delete(timers[1]));
+}
@@ -100,5 +100,47 @@ TEST_CASE("high psram memory test", "[himem]")
     vTaskDelay(100);
 }
 
+static esp_err_t check_seed_cb(void *data, size_t offset, size_t len, void *arg)
+{
+    return check_mem_seed(offset ^ (int)arg, data, len) ? ESP_OK : ESP_FAIL;
+}
+
+TEST_CASE("himem paged buffer keeps data and remaps only on window misses", "[himem]")
+{
+    const size_t SIZE = 1024 * 1024;
+    const size_t BLOCKS = SIZE / ESP_HIMEM_BLKSZ;
+    esp_himem_buf_handle_t buf;
+    esp_himem_buf_stats_t stats;
+    uint32_t *tmp = malloc(ESP_HIMEM_BLKSZ);
+    TEST_ASSERT_NOT_NULL(tmp);
+
+    TEST_ESP_OK(esp_himem_buf_create(SIZE, 2, &buf));
+    TEST_ASSERT_EQUAL(SIZE, esp_himem_buf_get_size(buf));
+    for (int i = 0; i < SIZE; i += ESP_HIMEM_BLKSZ) {
+        fill_mem_seed(i ^ 0x1234, tmp, ESP_HIMEM_BLKSZ);
+        //write with an offset so every write spans two blocks
+        TEST_ESP_OK(esp_himem_buf_write(buf, i, tmp, 1000));
+        if (i + 1000 < SIZE) {
+            TEST_ESP_OK(esp_himem_buf_write(buf, i + 1000, (uint8_t *)tmp + 1000, ESP_HIMEM_BLKSZ - 1000));
+        }
+    }
+    esp_himem_buf_get_stats(buf, &stats);
+    TEST_ASSERT_EQUAL(BLOCKS, stats.remaps);
+
+    TEST_ESP_OK(esp_himem_buf_iterate(buf, 0, SIZE, check_seed_cb, (void *)0x1234));
+
+    //two blocks fit the window: alternating between them doesn't remap
+    esp_himem_buf_get_stats(buf, &stats);
+    size_t remaps = stats.remaps;
+    for (int i = 0; i < 100; i++) {
+        TEST_ESP_OK(esp_himem_buf_read(buf, (i % 2) * ESP_HIMEM_BLKSZ, tmp, 64));
+    }
+    esp_himem_buf_get_stats(buf, &stats);
+    TEST_ASSERT_EQUAL(remaps + 2, stats.remaps);
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, esp_himem_buf_read(buf, SIZE - 4, tmp, 8));
+    TEST_ESP_OK(esp_himem_buf_delete(buf));
+    free(tmp);
+}
 
 #endif
@@ -4,6 +4,8 @@
 
 #include <esp_types.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "esp32/rom/ets_sys.h"
 
 #include "freertos/FreeRTOS.h"
@@ -298,6 +300,52 @@ TEST_CASE("allocate 2 handlers for a same source and remove the later one","[esp
     printf("test passed.\n");
 }
 
+static void IRAM_ATTR count_handler(void* arg)
+{
+    volatile int* count = (volatile int*)arg;
+    (*count)++;
+    SPI2.slave.trans_done = 0;
+}
+
+TEST_CASE("esp_intr_dump lists allocated handlers", "[esp32]")
+{
+    const int triggers = 10;
+    volatile int count = 0;
+    intr_handle_t handle;
+
+    periph_module_enable(PERIPH_HSPI_MODULE);
+    TEST_ESP_OK(esp_intr_alloc(ETS_SPI2_INTR_SOURCE, 0, count_handler, (void*)&count, &handle));
+    SPI2.slave.trans_inten = 1;
+    for (int i = 0; i < triggers; i++) {
+        SPI2.slave.trans_done = 1;
+        vTaskDelay(1);
+    }
+    SPI2.slave.trans_inten = 0;
+    TEST_ASSERT_EQUAL(triggers, count);
+
+    const size_t size = 4096;
+    char *buf = calloc(1, size);
+    TEST_ASSERT_NOT_NULL(buf);
+    FILE *f = fmemopen(buf, size, "w");
+    TEST_ASSERT_NOT_NULL(f);
+    esp_intr_dump(f);
+    fclose(f);
+    printf("%s", buf);
+
+    char row[32];
+    snprintf(row, sizeof(row), "%3d %3d %6d ", esp_intr_get_cpu(handle), esp_intr_get_intno(handle), ETS_SPI2_INTR_SOURCE);
+    char *found = strstr(buf, row);
+    TEST_ASSERT_NOT_NULL(found);
+#if CONFIG_INTR_ALLOC_PROFILING
+    unsigned calls = 0;
+    //skip the flags columns
+    TEST_ASSERT_EQUAL(1, sscanf(found + strlen(row) + 12, "%u", &calls));
+    TEST_ASSERT_EQUAL(triggers, calls);
+#endif
+    free(buf);
+    TEST_ESP_OK(esp_intr_free(handle));
+}
+
 #ifndef CONFIG_FREERTOS_UNICORE
 
 void isr_free_task(void *param)
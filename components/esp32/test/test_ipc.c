@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "unity.h"
 #include "esp_ipc.h"
 
@@ -21,3 +22,41 @@ TEST_CASE("Test blocking IPC function call", "[ipc]")
 #endif
     TEST_ASSERT_EQUAL_HEX(val, 0xa5a5);
 }
+
+static void test_func_ipc_async(void *arg)
+{
+    int *val = (int *)arg;
+    ++*val;
+}
+
+static void test_func_ipc_async_done(void *arg)
+{
+    xSemaphoreGive((SemaphoreHandle_t) arg);
+}
+
+TEST_CASE("Test asynchronous IPC function calls are run in order", "[ipc]")
+{
+    const int num_calls = CONFIG_IPC_QUEUE_SIZE - 1;
+    int val = 0;
+    SemaphoreHandle_t done = xSemaphoreCreateBinary();
+#ifdef CONFIG_FREERTOS_UNICORE
+    uint32_t cpu_id = xPortGetCoreID();
+#else
+    uint32_t cpu_id = !xPortGetCoreID();
+#endif
+    for (int i = 0; i < num_calls; ++i) {
+        TEST_ESP_OK(esp_ipc_call_async(cpu_id, test_func_ipc_async, &val, NULL, NULL));
+    }
+    TEST_ESP_OK(esp_ipc_call_async(cpu_id, test_func_ipc_async, &val, test_func_ipc_async_done, done));
+    TEST_ASSERT_TRUE(xSemaphoreTake(done, 100 / portTICK_PERIOD_MS));
+    TEST_ASSERT_EQUAL(num_calls + 1, val);
+
+    /* a blocking call runs after the queued ones */
+    val = 0;
+    TEST_ESP_OK(esp_ipc_call_async(cpu_id, test_func_ipc_cb, &val, NULL, NULL));
+    esp_ipc_call_blocking(cpu_id, test_func_ipc_async, &val);
+    TEST_ASSERT_EQUAL_HEX(0xa5a6, val);
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_ipc_call_async(portNUM_PROCESSORS, test_func_ipc_async, &val, NULL, NULL));
+    vSemaphoreDelete(done);
+}
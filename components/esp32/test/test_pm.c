@@ -58,6 +58,36 @@ TEST_CASE("Can switch frequency using esp_pm_configure", "[pm]")
     switch_freq(orig_freq_mhz);
 }
 
+#ifdef CONFIG_PM_DFS_GOVERNOR
+TEST_CASE("Load governor uses max frequency only while the load is high", "[pm]")
+{
+    int orig_freq_mhz = esp_clk_cpu_freq() / 1000000;
+    esp_pm_config_esp32_t pm_config = {
+        .max_freq_mhz = 160,
+        .min_freq_mhz = rtc_clk_xtal_freq_get(),
+    };
+    ESP_ERROR_CHECK( esp_pm_configure(&pm_config) );
+
+    /* Mostly idle for a few periods: tasks run at APB_MAX frequency */
+    for (int i = 0; i < 5; ++i) {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_PM_DFS_GOVERNOR_PERIOD_MS * 2));
+    }
+    TEST_ASSERT_EQUAL(80, esp_clk_cpu_freq() / 1000000);
+
+    /* Busy for a few periods: switches to max frequency */
+    int64_t end = esp_timer_get_time() + CONFIG_PM_DFS_GOVERNOR_PERIOD_MS * 4000;
+    while (esp_timer_get_time() < end) {
+        ;
+    }
+    TEST_ASSERT_EQUAL(160, esp_clk_cpu_freq() / 1000000);
+    esp_pm_dump_locks(stdout);
+
+    pm_config.max_freq_mhz = orig_freq_mhz;
+    pm_config.min_freq_mhz = orig_freq_mhz;
+    ESP_ERROR_CHECK( esp_pm_configure(&pm_config) );
+}
+#endif // CONFIG_PM_DFS_GOVERNOR
+
 #if CONFIG_FREERTOS_USE_TICKLESS_IDLE
 
 static void light_sleep_enable()
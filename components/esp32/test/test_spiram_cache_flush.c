@@ -19,6 +19,7 @@ This code tests the interaction between PSRAM and SPI flash routines.
 #include <string.h>
 #include "esp32/rom/ets_sys.h"
 #include "esp_heap_caps.h"
+#include "esp32/spiram.h"
 #include "esp_spi_flash.h"
 #include "esp_partition.h"
 #include "test_utils.h"
@@ -181,4 +182,35 @@ IRAM_ATTR TEST_CASE("Spiram memcmp weirdness at 80MHz", "[spiram]") {
 #endif
 }
 
+#if USE_CAPS_ALLOC
+TEST_CASE("Spiram cache sampling sees evicted lines", "[spiram]")
+{
+    const size_t SAMPLED = 1024;
+    const size_t EVICT = 128 * 1024; // larger than the cache
+    volatile uint8_t *buf = heap_caps_malloc(SAMPLED, MALLOC_CAP_SPIRAM);
+    volatile uint8_t *other = heap_caps_malloc(EVICT, MALLOC_CAP_SPIRAM);
+    TEST_ASSERT_NOT_NULL(buf);
+    TEST_ASSERT_NOT_NULL(other);
+    esp_spiram_cache_sample_t sample;
+
+    uint8_t internal[4];
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_spiram_sample_cache(internal, sizeof(internal), &sample));
+
+    memset((void *)buf, 0x55, SAMPLED);
+    TEST_ESP_OK(esp_spiram_sample_cache((const void *)buf, SAMPLED, &sample));
+    printf("after use: %d lines, %d hits, %d misses\n", sample.lines, sample.hits, sample.misses);
+    TEST_ASSERT(sample.lines >= SAMPLED / 32);
+    TEST_ASSERT_EQUAL(sample.lines, sample.hits + sample.misses);
+    TEST_ASSERT(sample.hits > sample.lines / 2);
+
+    memset((void *)other, 0xaa, EVICT);
+    TEST_ESP_OK(esp_spiram_sample_cache((const void *)buf, SAMPLED, &sample));
+    printf("after eviction: %d lines, %d hits, %d misses, %d cycles\n", sample.lines, sample.hits, sample.misses, sample.miss_cycles);
+    TEST_ASSERT(sample.misses > sample.lines / 2);
+
+    free((void *)buf);
+    free((void *)other);
+}
+#endif // USE_CAPS_ALLOC
+
 #endif // CONFIG_SPIRAM_SUPPORT
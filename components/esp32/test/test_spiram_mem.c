@@ -0,0 +1,135 @@
+/*
+ Tests and benchmark for the external RAM optimized memcpy/memset.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "esp_heap_caps.h"
+#include "test_utils.h"
+#include "esp32/spiram.h"
+#include "sdkconfig.h"
+
+#if CONFIG_SPIRAM_USE_CAPS_ALLOC || CONFIG_SPIRAM_USE_MALLOC
+
+#define BENCH_SIZE (64 * 1024)
+#define BENCH_ROUNDS 16
+
+typedef void *(*copy_fn_t)(void *dst, const void *src, size_t n);
+typedef void *(*set_fn_t)(void *dst, int c, size_t n);
+
+static void *libc_memcpy(void *dst, const void *src, size_t n)
+{
+    return memcpy(dst, src, n);
+}
+
+static void *libc_memset(void *dst, int c, size_t n)
+{
+    return memset(dst, c, n);
+}
+
+typedef struct {
+    copy_fn_t copy;
+    set_fn_t set;
+    uint8_t *dst;
+    const uint8_t *src;
+} bench_arg_t;
+
+static void run_copy(void *arg)
+{
+    bench_arg_t *b = (bench_arg_t *)arg;
+    b->copy(b->dst, b->src, BENCH_SIZE);
+}
+
+static void run_set(void *arg)
+{
+    bench_arg_t *b = (bench_arg_t *)arg;
+    b->set(b->dst, 0x5a, BENCH_SIZE);
+}
+
+static int bench_kbps(const char *name, void (*fn)(void *), bench_arg_t *arg)
+{
+    test_benchmark_result_t r;
+    test_benchmark_run(name, fn, arg, 1, BENCH_ROUNDS, &r);
+    return (int)((int64_t)BENCH_SIZE * CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ * 1000000 / 1024 / r.median);
+}
+
+TEST_CASE("esp_spiram_memcpy and esp_spiram_memset copy correctly at all alignments", "[spiram]")
+{
+    const size_t len = 300;
+    uint8_t *ext = heap_caps_malloc(len + 16, MALLOC_CAP_SPIRAM);
+    uint8_t *in = heap_caps_malloc(len + 16, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    uint8_t *ref = heap_caps_malloc(len + 16, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(ext);
+    TEST_ASSERT_NOT_NULL(in);
+    TEST_ASSERT_NOT_NULL(ref);
+
+    for (int i = 0; i < len + 16; i++) {
+        in[i] = rand();
+    }
+    for (int so = 0; so < 8; so++) {
+        for (int dof = 0; dof < 8; dof++) {
+            for (size_t n = len - 40; n <= len; n += 13) {
+                memset(ext, 0xcc, len + 16);
+                memset(ref, 0xcc, len + 16);
+                memcpy(ref + dof, in + so, n);
+                TEST_ASSERT_EQUAL_PTR(ext + dof, esp_spiram_memcpy(ext + dof, in + so, n));
+                TEST_ASSERT_EQUAL_HEX8_ARRAY(ref, ext, len + 16);
+
+                memset(ref + dof, so * 8 + dof, n);
+                TEST_ASSERT_EQUAL_PTR(ext + dof, esp_spiram_memset(ext + dof, so * 8 + dof, n));
+                TEST_ASSERT_EQUAL_HEX8_ARRAY(ref, ext, len + 16);
+            }
+        }
+    }
+    free(ext);
+    free(in);
+    free(ref);
+}
+
+TEST_CASE("esp_spiram_memcpy and esp_spiram_memset benchmark", "[spiram]")
+{
+    uint8_t *ext1 = heap_caps_malloc(BENCH_SIZE + 4, MALLOC_CAP_SPIRAM);
+    uint8_t *ext2 = heap_caps_malloc(BENCH_SIZE + 4, MALLOC_CAP_SPIRAM);
+    uint8_t *in = heap_caps_malloc(BENCH_SIZE + 4, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(ext1);
+    TEST_ASSERT_NOT_NULL(ext2);
+    TEST_ASSERT_NOT_NULL(in);
+    memset(ext1, 0x55, BENCH_SIZE + 4);
+    memset(in, 0xaa, BENCH_SIZE + 4);
+
+    const struct {
+        const char *name;
+        uint8_t *dst;
+        const uint8_t *src;
+    } cases[] = {
+        { "ext -> int", in, ext1 },
+        { "int -> ext", ext1, in },
+        { "ext -> ext", ext2, ext1 },
+        { "ext -> int, unaligned", in + 1, ext1 + 2 },
+        { "int -> ext, unaligned", ext1 + 3, in },
+    };
+    printf("%-24s %10s %10s (KB/s)\n", "memcpy", "libc", "spiram");
+    char name[64];
+    for (int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        bench_arg_t arg = { .copy = libc_memcpy, .dst = cases[i].dst, .src = cases[i].src };
+        snprintf(name, sizeof(name), "memcpy libc %s", cases[i].name);
+        int libc = bench_kbps(name, run_copy, &arg);
+        arg.copy = esp_spiram_memcpy;
+        snprintf(name, sizeof(name), "esp_spiram_memcpy %s", cases[i].name);
+        int opt = bench_kbps(name, run_copy, &arg);
+        printf("%-24s %10d %10d\n", cases[i].name, libc, opt);
+    }
+    bench_arg_t arg = { .set = libc_memset, .dst = ext1 };
+    int libc = bench_kbps("memset libc ext", run_set, &arg);
+    arg.set = esp_spiram_memset;
+    printf("%-24s %10d %10d\n", "memset ext", libc, bench_kbps("esp_spiram_memset ext", run_set, &arg));
+
+    free(ext1);
+    free(ext2);
+    free(in);
+}
+
+#endif // CONFIG_SPIRAM_USE_CAPS_ALLOC || CONFIG_SPIRAM_USE_MALLOC
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <stdint.h>
+#include <sys/param.h>
 #include "esp_types.h"
 #include "driver/adc.h"
 #include "soc/efuse_reg.h"
@@ -367,6 +368,64 @@ uint32_t esp_adc_cal_raw_to_voltage(uint32_t adc_reading, const esp_adc_cal_char
     }
 }
 
+void esp_adc_cal_raw_to_voltage_batch(const uint16_t *adc_readings, uint32_t *voltages, size_t count, const esp_adc_cal_characteristics_t *chars)
+{
+    assert(chars != NULL);
+    assert(count == 0 || (adc_readings != NULL && voltages != NULL));
+
+    //Hoist everything that only depends on the characteristics out of the loop, so that readings
+    //in the linear region cost one multiply-add each
+    const uint32_t shift = ADC_WIDTH_BIT_12 - chars->bit_width;
+    const uint32_t coeff_a = chars->coeff_a;
+    const uint32_t coeff_b = chars->coeff_b;
+    const uint32_t lut_thresh = (LUT_ENABLED && chars->atten == ADC_ATTEN_DB_11) ? LUT_LOW_THRESH : ADC_12_BIT_RES;
+
+    for (size_t i = 0; i < count; i++) {
+        uint32_t adc_reading = (uint32_t)adc_readings[i] << shift;
+        if (adc_reading >= lut_thresh || adc_reading > ADC_12_BIT_RES - 1) {
+            voltages[i] = esp_adc_cal_raw_to_voltage(adc_readings[i], chars);
+        } else {
+            voltages[i] = calculate_voltage_linear(adc_reading, coeff_a, coeff_b);
+        }
+    }
+}
+
+esp_err_t esp_adc_cal_build_table(const esp_adc_cal_characteristics_t *chars, uint16_t *table, size_t table_size)
+{
+    ADC_CAL_CHECK(chars != NULL, ESP_ERR_INVALID_ARG);
+    ADC_CAL_CHECK(table != NULL, ESP_ERR_INVALID_ARG);
+    ADC_CAL_CHECK(table_size == ESP_ADC_CAL_TABLE_SIZE(chars->bit_width), ESP_ERR_INVALID_ARG);
+
+    for (size_t i = 0; i < table_size; i++) {
+        table[i] = (uint16_t)esp_adc_cal_raw_to_voltage(i, chars);
+    }
+    return ESP_OK;
+}
+
+void esp_adc_cal_raw_to_voltage_table(const uint16_t *table, size_t table_size, const uint16_t *adc_readings, uint32_t *voltages, size_t count)
+{
+    assert(table != NULL);
+    assert(table_size > 0);
+    assert(count == 0 || (adc_readings != NULL && voltages != NULL));
+
+    //Readings above the bit width share the last entry, which holds the voltage of the clamped reading
+    const uint32_t max_reading = table_size - 1;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint32_t r0 = MIN(adc_readings[i], max_reading);
+        uint32_t r1 = MIN(adc_readings[i + 1], max_reading);
+        uint32_t r2 = MIN(adc_readings[i + 2], max_reading);
+        uint32_t r3 = MIN(adc_readings[i + 3], max_reading);
+        voltages[i] = table[r0];
+        voltages[i + 1] = table[r1];
+        voltages[i + 2] = table[r2];
+        voltages[i + 3] = table[r3];
+    }
+    for (; i < count; i++) {
+        voltages[i] = table[MIN(adc_readings[i], max_reading)];
+    }
+}
+
 esp_err_t esp_adc_cal_get_voltage(adc_channel_t channel,
                                   const esp_adc_cal_characteristics_t *chars,
                                   uint32_t *voltage)
@@ -23,6 +23,13 @@ extern "C" {
 #include "esp_err.h"
 #include "driver/adc.h"
 
+/**
+ * @brief Number of entries of a conversion table for readings of the given bit width
+ *
+ * One entry per possible reading, plus the last one for readings out of range.
+ */
+#define ESP_ADC_CAL_TABLE_SIZE(bit_width)   ((1 << (9 + (bit_width))) + 1)
+
 /**
  * @brief Type of calibration value used in characterization
  */
@@ -106,6 +113,52 @@ esp_adc_cal_value_t esp_adc_cal_characterize(adc_unit_t adc_num,
  */
 uint32_t esp_adc_cal_raw_to_voltage(uint32_t adc_reading, const esp_adc_cal_characteristics_t *chars);
 
+/**
+ * @brief   Convert a batch of ADC readings to voltages in mV
+ *
+ * Gives the same results as calling esp_adc_cal_raw_to_voltage() for each reading, but
+ * evaluates the characteristics once per batch. Meant for the per-channel buffers filled
+ * by i2s_adc_demux().
+ *
+ * @param[in]   adc_readings    Array of ADC readings
+ * @param[out]  voltages        Array of count voltages in mV
+ * @param[in]   count           Number of readings
+ * @param[in]   chars           Pointer to initialized structure containing ADC characteristics
+ */
+void esp_adc_cal_raw_to_voltage_batch(const uint16_t *adc_readings, uint32_t *voltages, size_t count, const esp_adc_cal_characteristics_t *chars);
+
+/**
+ * @brief   Build a table with the voltage for every possible ADC reading
+ *
+ * Lookup in the table replaces the linear and, at 11dB attenuation, the bilinear lookup table
+ * calculations of esp_adc_cal_raw_to_voltage(). A table is valid for the attenuation and bit width
+ * the characteristics were made for, so one table is needed per attenuation in use.
+ * Example for 12 bit readings: uint16_t table[ESP_ADC_CAL_TABLE_SIZE(ADC_WIDTH_BIT_12)] (about 8 KB).
+ *
+ * @param[in]   chars           Pointer to initialized structure containing ADC characteristics
+ * @param[out]  table           Table to fill in, voltages in mV indexed by ADC reading
+ * @param[in]   table_size      Number of entries in table, must be ESP_ADC_CAL_TABLE_SIZE(chars->bit_width)
+ *
+ * @return
+ *      - ESP_OK: Table is built
+ *      - ESP_ERR_INVALID_ARG: Error, invalid arguments or table size
+ */
+esp_err_t esp_adc_cal_build_table(const esp_adc_cal_characteristics_t *chars, uint16_t *table, size_t table_size);
+
+/**
+ * @brief   Convert a batch of ADC readings to voltages in mV using a table
+ *
+ * Gives the same results as esp_adc_cal_raw_to_voltage_batch() with the characteristics the table was
+ * built from, at the cost of one table lookup per reading.
+ *
+ * @param[in]   table           Table built by esp_adc_cal_build_table()
+ * @param[in]   table_size      Number of entries in table
+ * @param[in]   adc_readings    Array of ADC readings
+ * @param[out]  voltages        Array of count voltages in mV
+ * @param[in]   count           Number of readings
+ */
+void esp_adc_cal_raw_to_voltage_table(const uint16_t *table, size_t table_size, const uint16_t *adc_readings, uint32_t *voltages, size_t count);
+
 /**
  * @brief   Reads an ADC and converts the reading to a voltage in mV
  *
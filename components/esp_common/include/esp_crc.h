@@ -0,0 +1,99 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+
+#if !CONFIG_ESP_CRC_TABLES
+#include "esp32/rom/crc.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * These functions compute the same CRCs as crc32_le and crc16_be of esp32/rom/crc.h,
+ * with the same conventions: the initial value and the result are inverted, so
+ * a CRC over several buffers is computed by passing the result for one buffer as
+ * the initial value for the next one, e.g.
+ *
+ *     crc = esp_crc32_le(0, buf0, len0);
+ *     crc = esp_crc32_le(crc, buf1, len1);
+ *
+ * When CONFIG_ESP_CRC_TABLES is enabled, they are slicing-by-8 (CRC32) and
+ * slicing-by-4 (CRC16) implementations, which are faster than the ROM functions
+ * on buffers of more than a few bytes, at the cost of 10 KB of tables in flash.
+ * Otherwise they call the ROM functions.
+ *
+ * The tables are in flash: unlike the ROM functions, these can not be called
+ * while the flash cache is disabled.
+ */
+
+#if CONFIG_ESP_CRC_TABLES
+
+/**
+ * @brief CRC32 (polynomial 0x04c11db7, reflected), as computed by ROM crc32_le
+ *
+ * @param crc  CRC of the data before buf, 0 at the start of the data
+ * @param buf  data
+ * @param len  length of the data, in bytes
+ * @return CRC of the data up to the end of buf
+ */
+uint32_t esp_crc32_le(uint32_t crc, const uint8_t *buf, size_t len);
+
+/**
+ * @brief CRC16-CCITT (polynomial 0x1021, not reflected), as computed by ROM crc16_be
+ *
+ * @param crc  CRC of the data before buf
+ * @param buf  data
+ * @param len  length of the data, in bytes
+ * @return CRC of the data up to the end of buf
+ */
+uint16_t esp_crc16_be(uint16_t crc, const uint8_t *buf, size_t len);
+
+#else
+
+static inline uint32_t esp_crc32_le(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    return crc32_le(crc, buf, len);
+}
+
+static inline uint16_t esp_crc16_be(uint16_t crc, const uint8_t *buf, size_t len)
+{
+    return crc16_be(crc, buf, len);
+}
+
+#endif // CONFIG_ESP_CRC_TABLES
+
+/**
+ * @brief Combine the CRC32 of two consecutive buffers
+ *
+ * Gives the CRC of the concatenation of buffers A and B from the CRC of A and
+ * the CRC of B, without reading the data again, e.g. to merge CRCs computed in
+ * parallel, or to update a CRC after data was appended out of order.
+ *
+ * @param crc1  esp_crc32_le of buffer A, with any initial value
+ * @param crc2  esp_crc32_le of buffer B, with an initial value of 0
+ * @param len2  length of buffer B, in bytes
+ * @return esp_crc32_le of A followed by B, with the initial value used for A
+ */
+uint32_t esp_crc32_le_combine(uint32_t crc1, uint32_t crc2, size_t len2);
+
+#ifdef __cplusplus
+}
+#endif
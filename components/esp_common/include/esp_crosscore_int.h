@@ -0,0 +1,73 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Statistics of the cross-core interrupt of one CPU
+ *
+ * The scheduler interrupts a CPU to make it yield, e.g. when a task of the
+ * other CPU unblocks a higher priority task of this CPU, and also interrupts
+ * its own CPU to yield from within FreeRTOS APIs. A request for a reason which
+ * is already pending does not raise the interrupt again, and is counted as
+ * coalesced.
+ */
+typedef struct {
+    uint32_t yield_sent;            /*!< Yield requests which raised the interrupt */
+    uint32_t yield_coalesced;       /*!< Yield requests made while a yield was pending */
+    uint32_t freq_switch_sent;      /*!< Frequency switch requests which raised the interrupt */
+    uint32_t freq_switch_coalesced; /*!< Frequency switch requests made while one was pending */
+    uint32_t isr_count;             /*!< Number of times the interrupt handler ran */
+    uint32_t latency_count;         /*!< Number of latencies in latency_total_us */
+    uint64_t latency_total_us;      /*!< Sum of the times from raising the interrupt to
+                                         the handler running, in microseconds */
+    uint32_t latency_max_us;        /*!< Longest time from raising the interrupt to the
+                                         handler running, in microseconds */
+} esp_crosscore_int_stats_t;
+
+/**
+ * @brief Get the statistics of the cross-core interrupt of a CPU
+ *
+ * Only available if CONFIG_CROSSCORE_INT_PROFILING is enabled. Latencies are
+ * measured with esp_timer_get_time(), so they have a resolution of 1 microsecond.
+ *
+ * @param core_id CPU which receives the interrupts
+ * @param[out] stats Statistics since startup or since esp_crosscore_int_reset_stats()
+ *
+ * @return
+ *      - ESP_OK Success
+ *      - ESP_ERR_INVALID_ARG core_id is not a valid CPU, or stats is NULL
+ *      - ESP_ERR_NOT_SUPPORTED CONFIG_CROSSCORE_INT_PROFILING is disabled
+ */
+esp_err_t esp_crosscore_int_get_stats(int core_id, esp_crosscore_int_stats_t *stats);
+
+/**
+ * @brief Reset the statistics of the cross-core interrupts of all CPUs
+ *
+ * @return
+ *      - ESP_OK Success
+ *      - ESP_ERR_NOT_SUPPORTED CONFIG_CROSSCORE_INT_PROFILING is disabled
+ */
+esp_err_t esp_crosscore_int_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -85,6 +85,36 @@ esp_err_t esp_ipc_call(uint32_t cpu_id, esp_ipc_func_t func, void* arg);
  */
 esp_err_t esp_ipc_call_blocking(uint32_t cpu_id, esp_ipc_func_t func, void* arg);
 
+/**
+ * @brief Queue a function to be executed on the given CPU, without waiting for it
+ *
+ * The call is added to the queue of the IPC task of the CPU specified by
+ * cpu_id, and this function returns immediately. Calls to the same CPU are
+ * executed in order, including the ones made with esp_ipc_call and
+ * esp_ipc_call_blocking. The number of calls which can be pending for each CPU
+ * is set by the "Inter-Processor Call (IPC) queue size" setting in menuconfig.
+ *
+ * If done_cb is not NULL, it is called with done_arg in the IPC task once func
+ * returns, e.g. to release the memory pointed to by arg or to notify the caller.
+ *
+ * This function can be called from an ISR, and before the FreeRTOS scheduler
+ * is started (the call is executed once the scheduler starts).
+ *
+ * @param[in]   cpu_id   CPU where the given function should be executed (0 or 1)
+ * @param[in]   func     Pointer to a function of type void func(void* arg) to be executed
+ * @param[in]   arg      Arbitrary argument of type void* to be passed into the function
+ * @param[in]   done_cb  Function called after func returns, or NULL
+ * @param[in]   done_arg Arbitrary argument of type void* to be passed into done_cb
+ *
+ * @return
+ *      - ESP_ERR_INVALID_ARG if cpu_id or func is invalid
+ *      - ESP_ERR_INVALID_STATE if the IPC tasks are not created yet
+ *      - ESP_ERR_NO_MEM if the queue of the CPU is full
+ *      - ESP_OK otherwise
+ */
+esp_err_t esp_ipc_call_async(uint32_t cpu_id, esp_ipc_func_t func, void* arg,
+                             esp_ipc_func_t done_cb, void* done_arg);
+
 
 #ifdef __cplusplus
 }
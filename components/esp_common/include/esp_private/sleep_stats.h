@@ -0,0 +1,62 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/**
+ * @file esp_private/sleep_stats.h
+ *
+ * Latency counters of light sleep entry and exit, kept by esp_light_sleep_start
+ * when CONFIG_PM_PROFILING is enabled and printed by esp_pm_impl_dump_stats.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Phases of esp_light_sleep_start, in the order they run.
+ * The time spent sleeping is not part of any phase.
+ */
+typedef enum {
+    SLEEP_PHASE_PREPARE,    //!< Entry: power down flags, RTC WDT, UART suspend
+    SLEEP_PHASE_CLK_DOWN,   //!< Entry: CPU clock switch to XTAL
+    SLEEP_PHASE_CONFIGURE,  //!< Entry: wakeup sources and sleep registers
+    SLEEP_PHASE_CLK_UP,     //!< Exit: CPU clock restore
+    SLEEP_PHASE_FLASH,      //!< Exit: VDD_SDIO restore and wait for the flash
+    SLEEP_PHASE_FINISH,     //!< Exit: esp_timer and system time correction
+    SLEEP_PHASE_COUNT       //!< Number of items
+} sleep_phase_t;
+
+/**
+ * Light sleep latency counters
+ */
+typedef struct {
+    uint32_t count;                         //!< Number of light sleeps
+    uint32_t flash_pd_count;                //!< Number of light sleeps which powered down the flash
+    uint64_t total_us[SLEEP_PHASE_COUNT];   //!< Time spent in each phase, in microseconds
+    uint32_t max_us[SLEEP_PHASE_COUNT];     //!< Longest single run of each phase, in microseconds
+} sleep_stats_t;
+
+/**
+ * @brief Get the light sleep latency counters
+ * @param[out] stats filled with the counters; all zero unless CONFIG_PM_PROFILING is enabled
+ */
+void esp_sleep_get_light_sleep_stats(sleep_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
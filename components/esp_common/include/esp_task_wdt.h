@@ -76,8 +76,7 @@ esp_err_t esp_task_wdt_deinit();
   * @return
   *     - ESP_OK: Successfully subscribed the task to the TWDT
   *     - ESP_ERR_INVALID_ARG: Error, the task is already subscribed
-  *     - ESP_ERR_NO_MEM: Error, could not subscribe the task due to lack of
-  *                       memory
+  *     - ESP_ERR_NO_MEM: Error, 32 tasks are subscribed already
   *     - ESP_ERR_INVALID_STATE: Error, the TWDT has not been initialized yet
   */
 esp_err_t esp_task_wdt_add(TaskHandle_t handle);
@@ -93,7 +92,8 @@ esp_err_t esp_task_wdt_add(TaskHandle_t handle);
   * been subscribed to the TWDT, they will automatically call this function from
   * their idle hooks. Calling this function from a task that has not subscribed
   * to the TWDT, or when the TWDT is uninitialized will result in an error code
-  * being returned.
+  * being returned. Resetting again before all other subscribed tasks have reset
+  * returns immediately.
   *
   * @return
   *     - ESP_OK: Successfully reset the TWDT on behalf of the currently
@@ -64,23 +64,26 @@ typedef void (*esp_timer_cb_t)(void* arg);
  */
 typedef enum {
     ESP_TIMER_TASK,     //!< Callback is called from timer task
-
-    /* Not supported for now, provision to allow callbacks to run directly
-     * from an ISR:
-
-        ESP_TIMER_ISR,      //!< Callback is called from timer ISR
-
-     */
+    ESP_TIMER_ISR,      //!< Callback is called from timer ISR, requires CONFIG_ESP_TIMER_ISR_DISPATCH
 } esp_timer_dispatch_t;
 
 /**
  * @brief Timer configuration passed to esp_timer_create
+ *
+ * Callbacks of ESP_TIMER_ISR timers run in the timer interrupt handler, so
+ * they must be short, placed in IRAM (IRAM_ATTR), and may only call functions
+ * which are allowed in an ISR. esp_timer_start_once, esp_timer_start_periodic
+ * and esp_timer_stop can be called from them.
  */
 typedef struct {
     esp_timer_cb_t callback;        //!< Function to call when timer expires
     void* arg;                      //!< Argument to pass to the callback
     esp_timer_dispatch_t dispatch_method;   //!< Call the callback from task or from ISR
     const char* name;               //!< Timer name, used in esp_timer_dump function
+    int core_id;                    //!< Core of the timer task calling the callback of an ESP_TIMER_TASK timer.
+                                    //!< Timers of both cores share one task unless CONFIG_ESP_TIMER_TASK_PER_CORE is enabled.
+    uint32_t slack_us;              //!< Time in microseconds by which the callback may be delayed, so that it can be
+                                    //!< called together with other expiring timers, saving wakeups. 0 for exact timeouts.
 } esp_timer_create_args_t;
 
 /**
@@ -120,7 +123,8 @@ esp_err_t esp_timer_deinit();
  *
  * @return
  *      - ESP_OK on success
- *      - ESP_ERR_INVALID_ARG if some of the create_args are not valid
+ *      - ESP_ERR_INVALID_ARG if some of the create_args are not valid, e.g. the
+ *        dispatch method is not supported or core_id is not a valid core
  *      - ESP_ERR_INVALID_STATE if esp_timer library is not initialized yet
  *      - ESP_ERR_NO_MEM if memory allocation fails
  */
@@ -191,6 +195,9 @@ int64_t esp_timer_get_time();
 
 /**
  * @brief Get the timestamp when the next timeout is expected to occur
+ *
+ * For timers created with slack_us, this is the latest time the callback may be called.
+ *
  * @return Timestamp of the nearest timer event, in microseconds.
  *         The timebase is the same as for the values returned by esp_timer_get_time.
  */
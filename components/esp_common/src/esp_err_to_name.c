@@ -243,6 +243,10 @@ static const esp_err_msg_t esp_err_msg_table[] = {
                                                                             (ESP_OTA_IMG_PENDING_VERIFY), essentially
                                                                             first boot of firmware image post upgrade
                                                                             and hence firmware upgrade is not possible */
+#   endif
+#   ifdef      ESP_ERR_OTA_DELTA_SOURCE_MISMATCH
+    ERR_TBL_IT(ESP_ERR_OTA_DELTA_SOURCE_MISMATCH),          /*  5383 0x1507 Error if a delta patch was not created for
+                                                                            the running firmware */
 #   endif
     // components/efuse/include/esp_efuse.h
 #   ifdef      ESP_ERR_EFUSE
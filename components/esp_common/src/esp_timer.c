@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <sys/param.h>
+#include <stdlib.h>
 #include <string.h>
 #include "esp_types.h"
 #include "esp_attr.h"
@@ -20,6 +21,7 @@
 #include "esp_timer.h"
 #include "esp_task.h"
 #include "esp_log.h"
+#include "esp_heap_caps.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
@@ -39,10 +41,30 @@
 #include "sys/queue.h"
 
 #define TIMER_EVENT_QUEUE_SIZE      16
+// initial capacity of the timer heap of a queue, it grows by doubling
+#define TIMER_HEAP_MIN_CAPACITY     8
+
+#if CONFIG_ESP_TIMER_TASK_PER_CORE
+#define TIMER_TASK_COUNT            portNUM_PROCESSORS
+#else
+#define TIMER_TASK_COUNT            1
+#endif
+
+#if CONFIG_ESP_TIMER_ISR_DISPATCH
+// the queue of timers dispatched from the ISR follows the task queues
+#define TIMER_QUEUE_ISR             TIMER_TASK_COUNT
+#define TIMER_QUEUE_COUNT           (TIMER_TASK_COUNT + 1)
+// code processing the timers needs to be in IRAM when it runs from the ISR
+#define TIMER_ISR_ATTR              IRAM_ATTR
+#else
+#define TIMER_QUEUE_COUNT           TIMER_TASK_COUNT
+#define TIMER_ISR_ATTR
+#endif
 
 struct esp_timer {
     uint64_t alarm;
     uint64_t period;
+    uint32_t slack;         // the callback may be delayed until alarm + slack
     esp_timer_cb_t callback;
     void* arg;
 #if WITH_PROFILING
@@ -50,16 +72,43 @@ struct esp_timer {
     size_t times_triggered;
     size_t times_armed;
     uint64_t total_callback_run_time;
-#endif // WITH_PROFILING
     LIST_ENTRY(esp_timer) list_entry;
+#endif // WITH_PROFILING
+    size_t heap_index;      // position in the heap of its queue while armed
+    uint8_t queue;          // index of the queue in s_timer_queues
 };
 
+// Timers dispatched from the same task (or from the ISR)
+typedef struct {
+    // armed timers, as a binary min-heap ordered by deadline (alarm + slack).
+    // Its capacity is kept at least equal to the number of created timers,
+    // so that arming a timer never has to allocate.
+    esp_timer_handle_t* heap;
+    size_t count;
+    size_t capacity;
+    // number of created (not yet deleted) timers
+    size_t timer_count;
+    // task used to dispatch timer callbacks, NULL for the ISR queue
+    TaskHandle_t task;
+    // counting semaphore used to notify the timer task from ISR
+    SemaphoreHandle_t semaphore;
+    // mutex which protects timers from deletion during callback execution
+    SemaphoreHandle_t delete_mutex;
+    // set when the task is notified, until it starts processing the timers
+    bool notified;
+#if WITH_PROFILING
+    // used to keep track of the timer when executing the callback
+    esp_timer_handle_t in_callback;
+#endif
+} timer_queue_t;
+
 static bool is_initialized();
 static esp_err_t timer_insert(esp_timer_handle_t timer);
 static esp_err_t timer_remove(esp_timer_handle_t timer);
 static bool timer_armed(esp_timer_handle_t timer);
 static void timer_list_lock();
 static void timer_list_unlock();
+static esp_err_t timer_heap_reserve(timer_queue_t* queue, size_t count);
 
 #if WITH_PROFILING
 static void timer_insert_inactive(esp_timer_handle_t timer);
@@ -68,34 +117,41 @@ static void timer_remove_inactive(esp_timer_handle_t timer);
 
 static const char* TAG = "esp_timer";
 
-// list of currently armed timers
-static LIST_HEAD(esp_timer_list, esp_timer) s_timers =
-        LIST_HEAD_INITIALIZER(s_timers);
+static timer_queue_t s_timer_queues[TIMER_QUEUE_COUNT];
+static const char* const s_timer_task_names[] = { "esp_timer", "esp_timer1" };
 #if WITH_PROFILING
 // list of unarmed timers, used only to be able to dump statistics about
 // all the timers
 static LIST_HEAD(esp_inactive_timer_list, esp_timer) s_inactive_timers =
-        LIST_HEAD_INITIALIZER(s_timers);
-// used to keep track of the timer when executing the callback
-static esp_timer_handle_t s_timer_in_callback;
+        LIST_HEAD_INITIALIZER(s_inactive_timers);
 #endif
-// task used to dispatch timer callbacks
-static TaskHandle_t s_timer_task;
-// counting semaphore used to notify the timer task from ISR
-static SemaphoreHandle_t s_timer_semaphore;
-// mutex which protects timers from deletion during callback execution
-static SemaphoreHandle_t s_timer_delete_mutex;
 
 #if CONFIG_SPIRAM_USE_MALLOC
-// memory for s_timer_semaphore and s_timer_delete_mutex
-static StaticQueue_t s_timer_semaphore_memory;
-static StaticQueue_t s_timer_delete_mutex_memory;
+// memory for the semaphore and delete mutex of each timer task
+static StaticQueue_t s_timer_semaphore_memory[TIMER_TASK_COUNT];
+static StaticQueue_t s_timer_delete_mutex_memory[TIMER_TASK_COUNT];
 #endif
 
-// lock protecting s_timers, s_inactive_timers, s_timer_in_callback
+// lock protecting the timer heaps, s_inactive_timers, in_callback pointers
 static portMUX_TYPE s_timer_lock = portMUX_INITIALIZER_UNLOCKED;
 
 
+/* Index of the queue in s_timer_queues dispatching the timer, or -1 */
+static int timer_queue_index(const esp_timer_create_args_t* args)
+{
+    if (args->dispatch_method == ESP_TIMER_ISR) {
+#if CONFIG_ESP_TIMER_ISR_DISPATCH
+        return TIMER_QUEUE_ISR;
+#else
+        return -1;
+#endif
+    }
+    if (args->dispatch_method != ESP_TIMER_TASK ||
+            args->core_id < 0 || args->core_id >= portNUM_PROCESSORS) {
+        return -1;
+    }
+    return args->core_id % TIMER_TASK_COUNT;
+}
 
 esp_err_t esp_timer_create(const esp_timer_create_args_t* args,
                            esp_timer_handle_t* out_handle)
@@ -103,15 +159,26 @@ esp_err_t esp_timer_create(const esp_timer_create_args_t* args,
     if (!is_initialized()) {
         return ESP_ERR_INVALID_STATE;
     }
-    if (args->callback == NULL) {
+    int queue_index = timer_queue_index(args);
+    if (args->callback == NULL || queue_index < 0) {
         return ESP_ERR_INVALID_ARG;
     }
+    timer_queue_t* queue = &s_timer_queues[queue_index];
+    timer_list_lock();
+    size_t timer_count = ++queue->timer_count;
+    timer_list_unlock();
     esp_timer_handle_t result = (esp_timer_handle_t) calloc(1, sizeof(*result));
-    if (result == NULL) {
+    if (result == NULL || timer_heap_reserve(queue, timer_count) != ESP_OK) {
+        free(result);
+        timer_list_lock();
+        --queue->timer_count;
+        timer_list_unlock();
         return ESP_ERR_NO_MEM;
     }
     result->callback = args->callback;
     result->arg = args->arg;
+    result->queue = queue_index;
+    result->slack = args->slack_us;
 #if WITH_PROFILING
     result->name = args->name;
     timer_insert_inactive(result);
@@ -163,51 +230,178 @@ esp_err_t esp_timer_delete(esp_timer_handle_t timer)
     if (timer_armed(timer)) {
         return ESP_ERR_INVALID_STATE;
     }
-    xSemaphoreTakeRecursive(s_timer_delete_mutex, portMAX_DELAY);
+    timer_queue_t* queue = &s_timer_queues[timer->queue];
+    /* ISR callbacks can't be waited for, these get a copy of the callback
+     * and argument, and don't access the timer after the callback returns.
+     */
+    if (queue->delete_mutex) {
+        xSemaphoreTakeRecursive(queue->delete_mutex, portMAX_DELAY);
+    }
+    timer_list_lock();
 #if WITH_PROFILING
-    if (timer == s_timer_in_callback) {
-        s_timer_in_callback = NULL;
+    if (timer == queue->in_callback) {
+        queue->in_callback = NULL;
     }
     timer_remove_inactive(timer);
 #endif
+    --queue->timer_count;
+    timer_list_unlock();
     free(timer);
-    xSemaphoreGiveRecursive(s_timer_delete_mutex);
+    if (queue->delete_mutex) {
+        xSemaphoreGiveRecursive(queue->delete_mutex);
+    }
     return ESP_OK;
 }
 
-static IRAM_ATTR esp_err_t timer_insert(esp_timer_handle_t timer)
+static IRAM_ATTR uint64_t timer_deadline(esp_timer_handle_t timer)
+{
+    return timer->alarm + timer->slack;
+}
+
+static IRAM_ATTR void timer_heap_set(timer_queue_t* queue, size_t index, esp_timer_handle_t timer)
+{
+    queue->heap[index] = timer;
+    timer->heap_index = index;
+}
+
+static IRAM_ATTR void timer_heap_sift_up(timer_queue_t* queue, size_t index)
+{
+    esp_timer_handle_t timer = queue->heap[index];
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (timer_deadline(queue->heap[parent]) <= timer_deadline(timer)) {
+            break;
+        }
+        timer_heap_set(queue, index, queue->heap[parent]);
+        index = parent;
+    }
+    timer_heap_set(queue, index, timer);
+}
+
+static IRAM_ATTR void timer_heap_sift_down(timer_queue_t* queue, size_t index)
+{
+    esp_timer_handle_t timer = queue->heap[index];
+    while (true) {
+        size_t child = 2 * index + 1;
+        if (child >= queue->count) {
+            break;
+        }
+        if (child + 1 < queue->count &&
+                timer_deadline(queue->heap[child + 1]) < timer_deadline(queue->heap[child])) {
+            ++child;
+        }
+        if (timer_deadline(timer) <= timer_deadline(queue->heap[child])) {
+            break;
+        }
+        timer_heap_set(queue, index, queue->heap[child]);
+        index = child;
+    }
+    timer_heap_set(queue, index, timer);
+}
+
+static IRAM_ATTR esp_timer_handle_t timer_heap_first(timer_queue_t* queue)
+{
+    return (queue->count > 0) ? queue->heap[0] : NULL;
+}
+
+/* Make sure that the heap of the queue can hold 'count' timers. Must be
+ * called without the lock held, since it may allocate memory.
+ */
+static esp_err_t timer_heap_reserve(timer_queue_t* queue, size_t count)
 {
     timer_list_lock();
-#if WITH_PROFILING
-    timer_remove_inactive(timer);
-#endif
-    esp_timer_handle_t it, last = NULL;
-    if (LIST_FIRST(&s_timers) == NULL) {
-        LIST_INSERT_HEAD(&s_timers, timer, list_entry);
-    } else {
-        LIST_FOREACH(it, &s_timers, list_entry) {
-            if (timer->alarm < it->alarm) {
-                LIST_INSERT_BEFORE(it, timer, list_entry);
-                break;
+    size_t capacity = queue->capacity;
+    timer_list_unlock();
+    while (capacity < count) {
+        size_t new_capacity = MAX(MAX(2 * capacity, count), TIMER_HEAP_MIN_CAPACITY);
+        /* Arming and stopping timers is allowed while the cache is disabled */
+        esp_timer_handle_t* new_heap = heap_caps_malloc(new_capacity * sizeof(esp_timer_handle_t),
+                MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (new_heap == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        esp_timer_handle_t* old_heap = new_heap;
+        timer_list_lock();
+        if (queue->capacity < new_capacity) {
+            if (queue->count > 0) {
+                memcpy(new_heap, queue->heap, queue->count * sizeof(esp_timer_handle_t));
             }
-            last = it;
+            old_heap = queue->heap;
+            queue->heap = new_heap;
+            queue->capacity = new_capacity;
         }
-        if (it == NULL) {
-            assert(last);
-            LIST_INSERT_AFTER(last, timer, list_entry);
+        capacity = queue->capacity;
+        timer_list_unlock();
+        /* either the previous array, or the new one if another task has grown the heap meanwhile */
+        free(old_heap);
+    }
+    return ESP_OK;
+}
+
+/* Set the hardware alarm for the earliest deadline, skipping the queues whose
+ * task has been notified already: these set the alarm once they are done.
+ * Timers with slack are delayed up to their deadline, so that the ones
+ * expiring meanwhile are processed by the same interrupt.
+ * Must be called with the lock held.
+ */
+static IRAM_ATTR void timer_update_alarm()
+{
+    esp_timer_handle_t first = NULL;
+    for (int i = 0; i < TIMER_QUEUE_COUNT; ++i) {
+        esp_timer_handle_t it = timer_heap_first(&s_timer_queues[i]);
+        if (it && !s_timer_queues[i].notified &&
+                (first == NULL || timer_deadline(it) < timer_deadline(first))) {
+            first = it;
         }
     }
-    if (timer == LIST_FIRST(&s_timers)) {
-        esp_timer_impl_set_alarm(timer->alarm);
+    if (first) {
+        esp_timer_impl_set_alarm(timer_deadline(first));
+    }
+}
+
+/* Add the timer to the heap of its queue, must be called with the lock held */
+static IRAM_ATTR void timer_heap_insert(esp_timer_handle_t timer)
+{
+    timer_queue_t* queue = &s_timer_queues[timer->queue];
+    assert(queue->count < queue->capacity);
+    timer_heap_set(queue, queue->count++, timer);
+    timer_heap_sift_up(queue, timer->heap_index);
+    if (timer == timer_heap_first(queue) && !queue->notified) {
+        timer_update_alarm();
     }
+}
+
+static IRAM_ATTR esp_err_t timer_insert(esp_timer_handle_t timer)
+{
+    timer_list_lock();
+#if WITH_PROFILING
+    timer_remove_inactive(timer);
+#endif
+    timer_heap_insert(timer);
     timer_list_unlock();
     return ESP_OK;
 }
 
+/* Remove the timer from the heap of its queue, must be called with the lock held */
+static IRAM_ATTR void timer_heap_remove(esp_timer_handle_t timer)
+{
+    timer_queue_t* queue = &s_timer_queues[timer->queue];
+    size_t index = timer->heap_index;
+    esp_timer_handle_t last = queue->heap[--queue->count];
+    if (last != timer) {
+        timer_heap_set(queue, index, last);
+        if (index > 0 && timer_deadline(queue->heap[(index - 1) / 2]) > timer_deadline(last)) {
+            timer_heap_sift_up(queue, index);
+        } else {
+            timer_heap_sift_down(queue, index);
+        }
+    }
+}
+
 static IRAM_ATTR esp_err_t timer_remove(esp_timer_handle_t timer)
 {
     timer_list_lock();
-    LIST_REMOVE(timer, list_entry);
+    timer_heap_remove(timer);
     timer->alarm = 0;
     timer->period = 0;
 #if WITH_PROFILING
@@ -261,71 +455,95 @@ static IRAM_ATTR void timer_list_unlock()
     portEXIT_CRITICAL(&s_timer_lock);
 }
 
-static void timer_process_alarm(esp_timer_dispatch_t dispatch_method)
+/* Run the callbacks of the expired timers of the queue. The heap is ordered
+ * by deadline, so a timer with a large slack may stay in the heap past its
+ * alarm time until the timers before it expire, or its deadline is reached.
+ * Must be called with the lock held, which is released while each callback runs.
+ */
+static TIMER_ISR_ATTR void timer_process_alarm(timer_queue_t* queue)
 {
-    /* unused, provision to allow running callbacks from ISR */
-    (void) dispatch_method;
-
-    xSemaphoreTakeRecursive(s_timer_delete_mutex, portMAX_DELAY);
-    timer_list_lock();
     uint64_t now = esp_timer_impl_get_time();
-    esp_timer_handle_t it = LIST_FIRST(&s_timers);
+    esp_timer_handle_t it = timer_heap_first(queue);
     while (it != NULL &&
             it->alarm < now) {
-        LIST_REMOVE(it, list_entry);
+        timer_heap_remove(it);
         if (it->period > 0) {
             it->alarm += it->period;
-            timer_insert(it);
+            timer_heap_insert(it);
         } else {
             it->alarm = 0;
 #if WITH_PROFILING
             timer_insert_inactive(it);
 #endif
         }
+        esp_timer_cb_t callback = it->callback;
+        void* arg = it->arg;
 #if WITH_PROFILING
         uint64_t callback_start = now;
-        s_timer_in_callback = it;
+        queue->in_callback = it;
 #endif
         timer_list_unlock();
-        (*it->callback)(it->arg);
+        (*callback)(arg);
         timer_list_lock();
         now = esp_timer_impl_get_time();
 #if WITH_PROFILING
         /* The callback might have deleted the timer.
-         * If this happens, esp_timer_delete will set s_timer_in_callback
+         * If this happens, esp_timer_delete will set in_callback
          * to NULL.
          */
-        if (s_timer_in_callback) {
-            s_timer_in_callback->times_triggered++;
-            s_timer_in_callback->total_callback_run_time += now - callback_start;
+        if (queue->in_callback) {
+            queue->in_callback->times_triggered++;
+            queue->in_callback->total_callback_run_time += now - callback_start;
+            queue->in_callback = NULL;
         }
 #endif
-        it = LIST_FIRST(&s_timers);
+        it = timer_heap_first(queue);
     }
-    esp_timer_handle_t first = LIST_FIRST(&s_timers);
-    if (first) {
-        esp_timer_impl_set_alarm(first->alarm);
-    }
-    timer_list_unlock();
-    xSemaphoreGiveRecursive(s_timer_delete_mutex);
 }
 
 static void timer_task(void* arg)
 {
+    timer_queue_t* queue = (timer_queue_t*) arg;
     while (true){
-        int res = xSemaphoreTake(s_timer_semaphore, portMAX_DELAY);
+        int res = xSemaphoreTake(queue->semaphore, portMAX_DELAY);
         assert(res == pdTRUE);
-        timer_process_alarm(ESP_TIMER_TASK);
+        xSemaphoreTakeRecursive(queue->delete_mutex, portMAX_DELAY);
+        timer_list_lock();
+        queue->notified = false;
+        timer_process_alarm(queue);
+        timer_update_alarm();
+        timer_list_unlock();
+        xSemaphoreGiveRecursive(queue->delete_mutex);
     }
 }
 
 static void IRAM_ATTR timer_alarm_handler(void* arg)
 {
-    int need_yield;
-    if (xSemaphoreGiveFromISR(s_timer_semaphore, &need_yield) != pdPASS) {
-        ESP_EARLY_LOGD(TAG, "timer queue overflow");
-        return;
+    int need_yield = pdFALSE;
+    timer_list_lock();
+#if CONFIG_ESP_TIMER_ISR_DISPATCH
+    timer_process_alarm(&s_timer_queues[TIMER_QUEUE_ISR]);
+#endif
+    /* Wake up the tasks which have expired timers */
+    uint64_t now = esp_timer_impl_get_time();
+    for (int i = 0; i < TIMER_TASK_COUNT; ++i) {
+        timer_queue_t* queue = &s_timer_queues[i];
+        esp_timer_handle_t first = timer_heap_first(queue);
+        if (queue->notified || first == NULL || first->alarm > now) {
+            continue;
+        }
+        int task_yield = pdFALSE;
+        if (xSemaphoreGiveFromISR(queue->semaphore, &task_yield) != pdPASS) {
+            ESP_EARLY_LOGD(TAG, "timer queue overflow");
+            continue;
+        }
+        queue->notified = true;
+        if (task_yield == pdTRUE) {
+            need_yield = pdTRUE;
+        }
     }
+    timer_update_alarm();
+    timer_list_unlock();
     if (need_yield == pdTRUE) {
         portYIELD_FROM_ISR();
     }
@@ -333,7 +551,7 @@ static void IRAM_ATTR timer_alarm_handler(void* arg)
 
 static IRAM_ATTR bool is_initialized()
 {
-    return s_timer_task != NULL;
+    return s_timer_queues[0].task != NULL;
 }
 
 
@@ -344,34 +562,40 @@ esp_err_t esp_timer_init(void)
         return ESP_ERR_INVALID_STATE;
     }
 
+    for (int i = 0; i < TIMER_TASK_COUNT; ++i) {
+        timer_queue_t* queue = &s_timer_queues[i];
 #if CONFIG_SPIRAM_USE_MALLOC
-    memset(&s_timer_semaphore_memory, 0, sizeof(StaticQueue_t));
-    s_timer_semaphore = xSemaphoreCreateCountingStatic(TIMER_EVENT_QUEUE_SIZE, 0, &s_timer_semaphore_memory);
+        memset(&s_timer_semaphore_memory[i], 0, sizeof(StaticQueue_t));
+        queue->semaphore = xSemaphoreCreateCountingStatic(TIMER_EVENT_QUEUE_SIZE, 0, &s_timer_semaphore_memory[i]);
 #else
-    s_timer_semaphore = xSemaphoreCreateCounting(TIMER_EVENT_QUEUE_SIZE, 0);
+        queue->semaphore = xSemaphoreCreateCounting(TIMER_EVENT_QUEUE_SIZE, 0);
 #endif
-    if (!s_timer_semaphore) {
-        err = ESP_ERR_NO_MEM;
-        goto out;
-    }
+        if (!queue->semaphore) {
+            err = ESP_ERR_NO_MEM;
+            goto out;
+        }
 
 #if CONFIG_SPIRAM_USE_MALLOC
-    memset(&s_timer_delete_mutex_memory, 0, sizeof(StaticQueue_t));
-    s_timer_delete_mutex = xSemaphoreCreateRecursiveMutexStatic(&s_timer_delete_mutex_memory);
+        memset(&s_timer_delete_mutex_memory[i], 0, sizeof(StaticQueue_t));
+        queue->delete_mutex = xSemaphoreCreateRecursiveMutexStatic(&s_timer_delete_mutex_memory[i]);
 #else
-    s_timer_delete_mutex = xSemaphoreCreateRecursiveMutex();
+        queue->delete_mutex = xSemaphoreCreateRecursiveMutex();
 #endif
-    if (!s_timer_delete_mutex) {
-        err = ESP_ERR_NO_MEM;
-        goto out;
+        if (!queue->delete_mutex) {
+            err = ESP_ERR_NO_MEM;
+            goto out;
+        }
     }
 
-
-    int ret = xTaskCreatePinnedToCore(&timer_task, "esp_timer",
-            ESP_TASK_TIMER_STACK, NULL, ESP_TASK_TIMER_PRIO, &s_timer_task, PRO_CPU_NUM);
-    if (ret != pdPASS) {
-        err = ESP_ERR_NO_MEM;
-        goto out;
+    /* The task on the PRO CPU is created first, since is_initialized checks it */
+    for (int i = 0; i < TIMER_TASK_COUNT; ++i) {
+        int ret = xTaskCreatePinnedToCore(&timer_task, s_timer_task_names[i],
+                ESP_TASK_TIMER_STACK, &s_timer_queues[i], ESP_TASK_TIMER_PRIO,
+                &s_timer_queues[i].task, PRO_CPU_NUM + i);
+        if (ret != pdPASS) {
+            err = ESP_ERR_NO_MEM;
+            goto out;
+        }
     }
 
     err = esp_timer_impl_init(&timer_alarm_handler);
@@ -382,17 +606,20 @@ esp_err_t esp_timer_init(void)
     return ESP_OK;
 
 out:
-    if (s_timer_task) {
-        vTaskDelete(s_timer_task);
-        s_timer_task = NULL;
-    }
-    if (s_timer_semaphore) {
-        vSemaphoreDelete(s_timer_semaphore);
-        s_timer_semaphore = NULL;
-    }
-    if (s_timer_delete_mutex) {
-        vSemaphoreDelete(s_timer_delete_mutex);
-        s_timer_delete_mutex = NULL;
+    for (int i = 0; i < TIMER_TASK_COUNT; ++i) {
+        timer_queue_t* queue = &s_timer_queues[i];
+        if (queue->task) {
+            vTaskDelete(queue->task);
+            queue->task = NULL;
+        }
+        if (queue->semaphore) {
+            vSemaphoreDelete(queue->semaphore);
+            queue->semaphore = NULL;
+        }
+        if (queue->delete_mutex) {
+            vSemaphoreDelete(queue->delete_mutex);
+            queue->delete_mutex = NULL;
+        }
     }
     return ESP_ERR_NO_MEM;
 }
@@ -404,8 +631,10 @@ esp_err_t esp_timer_deinit(void)
     }
 
     /* Check if there are any active timers */
-    if (!LIST_EMPTY(&s_timers)) {
-        return ESP_ERR_INVALID_STATE;
+    for (int i = 0; i < TIMER_QUEUE_COUNT; ++i) {
+        if (s_timer_queues[i].count > 0) {
+            return ESP_ERR_INVALID_STATE;
+        }
     }
 
     /* We can only check if there are any timers which are not deleted if
@@ -419,10 +648,13 @@ esp_err_t esp_timer_deinit(void)
 
     esp_timer_impl_deinit();
 
-    vTaskDelete(s_timer_task);
-    s_timer_task = NULL;
-    vSemaphoreDelete(s_timer_semaphore);
-    s_timer_semaphore = NULL;
+    for (int i = 0; i < TIMER_TASK_COUNT; ++i) {
+        vTaskDelete(s_timer_queues[i].task);
+        s_timer_queues[i].task = NULL;
+        vSemaphoreDelete(s_timer_queues[i].semaphore);
+        s_timer_queues[i].semaphore = NULL;
+        s_timer_queues[i].notified = false;
+    }
     return ESP_OK;
 }
 
@@ -443,6 +675,12 @@ static void print_timer_info(esp_timer_handle_t t, char** dst, size_t* dst_size)
     *dst_size -= cb;
 }
 
+static int timer_alarm_compare(const void* a, const void* b)
+{
+    uint64_t alarm_a = (*(const esp_timer_handle_t*) a)->alarm;
+    uint64_t alarm_b = (*(const esp_timer_handle_t*) b)->alarm;
+    return (alarm_a > alarm_b) - (alarm_a < alarm_b);
+}
 
 esp_err_t esp_timer_dump(FILE* stream)
 {
@@ -452,14 +690,17 @@ esp_err_t esp_timer_dump(FILE* stream)
      * print to it, then dump this memory to stdout.
      */
 
+#if WITH_PROFILING
     esp_timer_handle_t it;
+#endif
 
     /* First count the number of timers */
-    size_t timer_count = 0;
     timer_list_lock();
-    LIST_FOREACH(it, &s_timers, list_entry) {
-        ++timer_count;
+    size_t armed_count = 0;
+    for (int i = 0; i < TIMER_QUEUE_COUNT; ++i) {
+        armed_count += s_timer_queues[i].count;
     }
+    size_t timer_count = armed_count;
 #if WITH_PROFILING
     LIST_FOREACH(it, &s_inactive_timers, list_entry) {
         ++timer_count;
@@ -474,15 +715,29 @@ esp_err_t esp_timer_dump(FILE* stream)
      */
     size_t buf_size = TIMER_INFO_LINE_LEN * (timer_count + 3);
     char* print_buf = calloc(1, buf_size + 1);
-    if (print_buf == NULL) {
+    /* The heaps are not sorted, armed timers are copied and sorted by alarm time */
+    size_t sorted_size = armed_count + 3;
+    esp_timer_handle_t* sorted = calloc(sorted_size, sizeof(esp_timer_handle_t));
+    if (print_buf == NULL || sorted == NULL) {
+        free(print_buf);
+        free(sorted);
         return ESP_ERR_NO_MEM;
     }
 
     /* Print to the buffer */
     timer_list_lock();
     char* pos = print_buf;
-    LIST_FOREACH(it, &s_timers, list_entry) {
-        print_timer_info(it, &pos, &buf_size);
+    size_t sorted_count = 0;
+    for (int i = 0; i < TIMER_QUEUE_COUNT; ++i) {
+        size_t count = MIN(s_timer_queues[i].count, sorted_size - sorted_count);
+        if (count > 0) {
+            memcpy(sorted + sorted_count, s_timer_queues[i].heap, count * sizeof(esp_timer_handle_t));
+            sorted_count += count;
+        }
+    }
+    qsort(sorted, sorted_count, sizeof(esp_timer_handle_t), &timer_alarm_compare);
+    for (size_t i = 0; i < sorted_count; ++i) {
+        print_timer_info(sorted[i], &pos, &buf_size);
     }
 #if WITH_PROFILING
     LIST_FOREACH(it, &s_inactive_timers, list_entry) {
@@ -494,6 +749,7 @@ esp_err_t esp_timer_dump(FILE* stream)
     /* Print the buffer */
     fputs(print_buf, stream);
 
+    free(sorted);
     free(print_buf);
     return ESP_OK;
 }
@@ -502,9 +758,11 @@ int64_t IRAM_ATTR esp_timer_get_next_alarm()
 {
     int64_t next_alarm = INT64_MAX;
     timer_list_lock();
-    esp_timer_handle_t it = LIST_FIRST(&s_timers);
-    if (it) {
-        next_alarm = it->alarm;
+    for (int i = 0; i < TIMER_QUEUE_COUNT; ++i) {
+        esp_timer_handle_t it = timer_heap_first(&s_timer_queues[i]);
+        if (it && (int64_t) timer_deadline(it) < next_alarm) {
+            next_alarm = timer_deadline(it);
+        }
     }
     timer_list_unlock();
     return next_alarm;
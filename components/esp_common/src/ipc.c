@@ -22,23 +22,30 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "freertos/semphr.h"
 
 
-static SemaphoreHandle_t s_ipc_mutex;                        // This mutex is used as a global lock for esp_ipc_* APIs
-static SemaphoreHandle_t s_ipc_sem[portNUM_PROCESSORS];      // Two semaphores used to wake each of ipc tasks
-static SemaphoreHandle_t s_ipc_ack;                          // Semaphore used to acknowledge that task was woken up,
-                                                             //   or function has finished running
-static volatile esp_ipc_func_t s_func;                       // Function which should be called by high priority task
-static void * volatile s_func_arg;                           // Argument to pass into s_func
 typedef enum {
     IPC_WAIT_FOR_START,
-    IPC_WAIT_FOR_END
+    IPC_WAIT_FOR_END,
+    IPC_WAIT_NONE,
 } esp_ipc_wait_t;
 
-static volatile esp_ipc_wait_t s_ipc_wait;                   // This variable tells high priority task when it should give
-                                                             //   s_ipc_ack semaphore: before s_func is called, or
-                                                             //   after it returns
+typedef struct {
+    esp_ipc_func_t func;                                     // Function which should be called by high priority task
+    void* arg;                                               // Argument to pass into func
+    esp_ipc_func_t done_cb;                                  // Optional function called after func returns
+    void* done_arg;                                          // Argument to pass into done_cb
+    esp_ipc_wait_t wait_for;                                 // Tells high priority task when it should give s_ipc_ack
+                                                             //   semaphore: before func is called, after it returns,
+                                                             //   or not at all for asynchronous calls
+} esp_ipc_call_t;
+
+static SemaphoreHandle_t s_ipc_mutex;                        // This mutex is used as a global lock for blocking esp_ipc_* APIs
+static QueueHandle_t s_ipc_queue[portNUM_PROCESSORS];        // Queues of pending calls, one per each of ipc tasks
+static SemaphoreHandle_t s_ipc_ack;                          // Semaphore used to acknowledge that task was woken up,
+                                                             //   or function has finished running
 
 static void IRAM_ATTR ipc_task(void* arg)
 {
@@ -46,23 +53,23 @@ static void IRAM_ATTR ipc_task(void* arg)
     assert(cpuid == xPortGetCoreID());
     while (true) {
         // Wait for IPC to be initiated.
-        // This will be indicated by giving the semaphore corresponding to
-        // this CPU.
-        if (xSemaphoreTake(s_ipc_sem[cpuid], portMAX_DELAY) != pdTRUE) {
+        // This will be indicated by a call posted to the queue of this CPU.
+        esp_ipc_call_t call;
+        if (xQueueReceive(s_ipc_queue[cpuid], &call, portMAX_DELAY) != pdTRUE) {
             // TODO: when can this happen?
             abort();
         }
 
-        esp_ipc_func_t func = s_func;
-        void* arg = s_func_arg;
-
-        if (s_ipc_wait == IPC_WAIT_FOR_START) {
+        if (call.wait_for == IPC_WAIT_FOR_START) {
             xSemaphoreGive(s_ipc_ack);
         }
-        (*func)(arg);
-        if (s_ipc_wait == IPC_WAIT_FOR_END) {
+        (*call.func)(call.arg);
+        if (call.wait_for == IPC_WAIT_FOR_END) {
             xSemaphoreGive(s_ipc_ack);
         }
+        if (call.done_cb) {
+            (*call.done_cb)(call.done_arg);
+        }
     }
     // TODO: currently this is unreachable code. Introduce esp_ipc_uninit
     // function which will signal to both tasks that they can shut down.
@@ -79,8 +86,8 @@ static void IRAM_ATTR ipc_task(void* arg)
  * This function start two tasks, one on each CPU. These tasks are started
  * with high priority. These tasks are normally inactive, waiting until one of
  * the esp_ipc_call_* functions to be used. One of these tasks will be
- * woken up to execute the callback provided to esp_ipc_call_nonblocking or
- * esp_ipc_call_blocking.
+ * woken up to execute the callback provided to esp_ipc_call,
+ * esp_ipc_call_blocking or esp_ipc_call_async.
  */
 static void esp_ipc_init() __attribute__((constructor));
 
@@ -91,7 +98,8 @@ static void esp_ipc_init()
     char task_name[15];
     for (int i = 0; i < portNUM_PROCESSORS; ++i) {
         snprintf(task_name, sizeof(task_name), "ipc%d", i);
-        s_ipc_sem[i] = xSemaphoreCreateBinary();
+        s_ipc_queue[i] = xQueueCreate(CONFIG_IPC_QUEUE_SIZE, sizeof(esp_ipc_call_t));
+        assert(s_ipc_queue[i]);
         portBASE_TYPE res = xTaskCreatePinnedToCore(ipc_task, task_name, CONFIG_IPC_TASK_STACK_SIZE, (void*) i,
                                                     configMAX_PRIORITIES - 1, NULL, i);
         assert(res == pdTRUE);
@@ -107,12 +115,13 @@ static esp_err_t esp_ipc_call_and_wait(uint32_t cpu_id, esp_ipc_func_t func, voi
         return ESP_ERR_INVALID_STATE;
     }
 
+    esp_ipc_call_t call = {
+        .func = func,
+        .arg = arg,
+        .wait_for = wait_for,
+    };
     xSemaphoreTake(s_ipc_mutex, portMAX_DELAY);
-
-    s_func = func;
-    s_func_arg = arg;
-    s_ipc_wait = wait_for;
-    xSemaphoreGive(s_ipc_sem[cpu_id]);
+    xQueueSend(s_ipc_queue[cpu_id], &call, portMAX_DELAY);
     xSemaphoreTake(s_ipc_ack, portMAX_DELAY);
     xSemaphoreGive(s_ipc_mutex);
     return ESP_OK;
@@ -128,3 +137,32 @@ esp_err_t esp_ipc_call_blocking(uint32_t cpu_id, esp_ipc_func_t func, void* arg)
     return esp_ipc_call_and_wait(cpu_id, func, arg, IPC_WAIT_FOR_END);
 }
 
+esp_err_t IRAM_ATTR esp_ipc_call_async(uint32_t cpu_id, esp_ipc_func_t func, void* arg,
+                                       esp_ipc_func_t done_cb, void* done_arg)
+{
+    if (cpu_id >= portNUM_PROCESSORS || func == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_ipc_queue[cpu_id] == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_ipc_call_t call = {
+        .func = func,
+        .arg = arg,
+        .done_cb = done_cb,
+        .done_arg = done_arg,
+        .wait_for = IPC_WAIT_NONE,
+    };
+    BaseType_t res;
+    if (xPortInIsrContext()) {
+        BaseType_t need_yield = pdFALSE;
+        res = xQueueSendFromISR(s_ipc_queue[cpu_id], &call, &need_yield);
+        if (need_yield == pdTRUE) {
+            portYIELD_FROM_ISR();
+        }
+    } else {
+        res = xQueueSend(s_ipc_queue[cpu_id], &call, 0);
+    }
+    return (res == pdTRUE) ? ESP_OK : ESP_ERR_NO_MEM;
+}
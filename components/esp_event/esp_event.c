@@ -30,10 +30,11 @@
 /* ---------------------------- Definitions --------------------------------- */
 
 #ifdef CONFIG_EVENT_LOOP_PROFILING
-// LOOP @<address, name> rx:<recieved events no.> dr:<dropped events no.>
-#define LOOP_DUMP_FORMAT              "LOOP @%p,%s rx:%u dr:%u\n"
- // handler @<address> ev:<base, id> inv:<times invoked> time:<runtime>
-#define HANDLER_DUMP_FORMAT           "  HANDLER @%p ev:%s,%s inv:%u time:%lld us\n"
+// LOOP @<address, name> rx:<recieved events no.> dr:<dropped events no.> isr rx/dr:<of which posted from ISRs>
+//      wait:<queue wait> wait max:<max queue wait>
+#define LOOP_DUMP_FORMAT              "LOOP @%p,%s rx:%u dr:%u isr rx:%u isr dr:%u wait:%lld us wait max:%lld us\n"
+ // handler @<address> ev:<base, id> inv:<times invoked> time:<runtime> max:<max runtime> p50/p90/p99:<percentiles>
+#define HANDLER_DUMP_FORMAT           "  HANDLER @%p ev:%s,%s inv:%u time:%lld us max:%lld us p50:%lld us p90:%lld us p99:%lld us\n"
 
 #define PRINT_DUMP_INFO(dst, sz, ...)  do { \
                                             int cb = snprintf(dst, sz, __VA_ARGS__); \
@@ -42,6 +43,15 @@
                                         } while(0);
 #endif
 
+// Size of an event queue item: the post instance, followed by space for inline event data if the loop has any
+#define POST_ITEM_SIZE(loop)            ((loop)->inline_data_size ? \
+                                            ESP_EVENT_POST_INLINE_DATA_OFFSET + (loop)->inline_data_size : \
+                                            sizeof(esp_event_post_instance_t))
+
+// Declare an event queue item on the stack, aligned for the inline event data
+#define POST_ITEM_DECLARE(loop, name)   uint64_t name##_storage[(POST_ITEM_SIZE(loop) + sizeof(uint64_t) - 1) / sizeof(uint64_t)]; \
+                                        esp_event_post_instance_t* name = (esp_event_post_instance_t*) name##_storage
+
 /* ------------------------- Static Variables ------------------------------- */
 
 static const char* TAG = "event";
@@ -95,11 +105,46 @@ static int esp_event_dump_prepare()
 
     // Reserve slightly more memory than computed
     int allowance = 3;
-    int size = (((loops + allowance) * (sizeof(LOOP_DUMP_FORMAT) + 10 + 20 + 2 * 11)) +
-                        ((handlers + allowance) * (sizeof(HANDLER_DUMP_FORMAT) + 10 + 2 * 20 + 11 + 20)));
+    int size = (((loops + allowance) * (sizeof(LOOP_DUMP_FORMAT) + 10 + 20 + 4 * 11 + 2 * 20)) +
+                        ((handlers + allowance) * (sizeof(HANDLER_DUMP_FORMAT) + 10 + 2 * 20 + 11 + 5 * 20)));
 
     return size;
 }
+
+static int64_t handler_time_percentile(esp_event_handler_instance_t* handler, uint32_t percentile)
+{
+    if (handler->invoked == 0) {
+        return 0;
+    }
+
+    // Number of calls at or below the percentile, rounded up
+    uint64_t rank = ((uint64_t) handler->invoked * percentile + 99) / 100;
+    uint64_t calls = 0;
+
+    for (int i = 0; i < ESP_EVENT_HANDLER_TIME_BUCKETS - 1; i++) {
+        calls += handler->time_hist[i];
+        if (calls >= rank) {
+            int64_t bound = 1LL << (i + 1);
+            return bound < handler->max_time ? bound : handler->max_time;
+        }
+    }
+
+    return handler->max_time;
+}
+
+static void handler_stats_get(esp_event_handler_instance_t* handler, esp_event_base_t base, int32_t id,
+                              esp_event_handler_stats_t* stats)
+{
+    stats->handler = handler->handler;
+    stats->event_base = base;
+    stats->event_id = id;
+    stats->invoked = handler->invoked;
+    stats->time = handler->time;
+    stats->max_time = handler->max_time;
+    stats->p50_time = handler_time_percentile(handler, 50);
+    stats->p90_time = handler_time_percentile(handler, 90);
+    stats->p99_time = handler_time_percentile(handler, 99);
+}
 #endif
 
 static void esp_event_loop_run_task(void* args)
@@ -138,6 +183,12 @@ static void handler_execute(esp_event_loop_instance_t* loop, esp_event_handler_i
 
     handler->invoked++;
     handler->time += diff;
+    if (diff > handler->max_time) {
+        handler->max_time = diff;
+    }
+    // Bucket n counts runtimes in [2^n, 2^(n + 1)) us, except the first and last buckets
+    int bucket = (diff < 2) ? 0 : 31 - __builtin_clz(diff < UINT32_MAX ? (uint32_t) diff : UINT32_MAX);
+    handler->time_hist[bucket < ESP_EVENT_HANDLER_TIME_BUCKETS ? bucket : ESP_EVENT_HANDLER_TIME_BUCKETS - 1]++;
 
     xSemaphoreGive(loop->profiling_mutex);
 #endif
@@ -175,7 +226,66 @@ static esp_err_t handler_instances_add(esp_event_handler_instances_t* handlers,
     return ESP_OK;
 }
 
-static esp_err_t base_node_add_handler(esp_event_base_node_t* base_node, int32_t id, esp_event_handler_t handler, void* handler_arg)
+static inline size_t base_index_bucket(esp_event_base_t base)
+{
+    // Event bases are compared by address, so hash the address; Fibonacci hashing spreads
+    // the aligned string addresses over the buckets.
+    return ((uint32_t) (uintptr_t) base * 2654435761u) >> (32 - ESP_EVENT_BASE_BUCKETS_BITS);
+}
+
+static inline size_t id_index_bucket(esp_event_base_node_t* base_node, int32_t id)
+{
+    return (((uint32_t) (uintptr_t) base_node ^ (uint32_t) id) * 2654435761u) >> (32 - ESP_EVENT_ID_BUCKETS_BITS);
+}
+
+static void base_index_add(esp_event_loop_instance_t* loop, esp_event_base_node_t* base_node)
+{
+    // Base nodes are always created after every existing base node of their loop node,
+    // so appending keeps each bucket in dispatch order.
+    esp_event_base_nodes_t* bucket = &(loop->base_index[base_index_bucket(base_node->base)]);
+    esp_event_base_node_t *it, *last = NULL;
+
+    SLIST_FOREACH(it, bucket, bucket_next) {
+        last = it;
+    }
+
+    if (!last) {
+        SLIST_INSERT_HEAD(bucket, base_node, bucket_next);
+    }
+    else {
+        SLIST_INSERT_AFTER(last, base_node, bucket_next);
+    }
+}
+
+static void base_index_remove(esp_event_loop_instance_t* loop, esp_event_base_node_t* base_node)
+{
+    SLIST_REMOVE(&(loop->base_index[base_index_bucket(base_node->base)]), base_node, esp_event_base_node, bucket_next);
+}
+
+static void id_index_add(esp_event_loop_instance_t* loop, esp_event_id_node_t* id_node)
+{
+    SLIST_INSERT_HEAD(&(loop->id_index[id_index_bucket(id_node->base_node, id_node->id)]), id_node, bucket_next);
+}
+
+static void id_index_remove(esp_event_loop_instance_t* loop, esp_event_id_node_t* id_node)
+{
+    SLIST_REMOVE(&(loop->id_index[id_index_bucket(id_node->base_node, id_node->id)]), id_node, esp_event_id_node, bucket_next);
+}
+
+static esp_event_id_node_t* id_index_find(esp_event_loop_instance_t* loop, esp_event_base_node_t* base_node, int32_t id)
+{
+    esp_event_id_node_t* it;
+
+    SLIST_FOREACH(it, &(loop->id_index[id_index_bucket(base_node, id)]), bucket_next) {
+        if (it->base_node == base_node && it->id == id) {
+            return it;
+        }
+    }
+
+    return NULL;
+}
+
+static esp_err_t base_node_add_handler(esp_event_loop_instance_t* loop, esp_event_base_node_t* base_node, int32_t id, esp_event_handler_t handler, void* handler_arg)
 {
     if (id == ESP_EVENT_ANY_ID) {
         return handler_instances_add(&(base_node->handlers), handler, handler_arg);
@@ -200,6 +310,7 @@ static esp_err_t base_node_add_handler(esp_event_base_node_t* base_node, int32_t
             }
 
             id_node->id = id;
+            id_node->base_node = base_node;
 
             SLIST_INIT(&(id_node->handlers));
 
@@ -212,6 +323,8 @@ static esp_err_t base_node_add_handler(esp_event_base_node_t* base_node, int32_t
                 else {
                     SLIST_INSERT_AFTER(last_id_node, id_node, next);
                 }
+
+                id_index_add(loop, id_node);
             }
 
             return err;
@@ -222,7 +335,7 @@ static esp_err_t base_node_add_handler(esp_event_base_node_t* base_node, int32_t
     }
 }
 
-static esp_err_t loop_node_add_handler(esp_event_loop_node_t* loop_node, esp_event_base_t base, int32_t id, esp_event_handler_t handler, void* handler_arg)
+static esp_err_t loop_node_add_handler(esp_event_loop_instance_t* loop, esp_event_loop_node_t* loop_node, esp_event_base_t base, int32_t id, esp_event_handler_t handler, void* handler_arg)
 {
     if (base == esp_event_any_base && id == ESP_EVENT_ANY_ID) {
         return handler_instances_add(&(loop_node->handlers), handler, handler_arg);
@@ -250,11 +363,12 @@ static esp_err_t loop_node_add_handler(esp_event_loop_node_t* loop_node, esp_eve
             }
 
             base_node->base = base;
+            base_node->loop_node = loop_node;
 
             SLIST_INIT(&(base_node->handlers));
             SLIST_INIT(&(base_node->id_nodes));
 
-            err = base_node_add_handler(base_node, id, handler, handler_arg);
+            err = base_node_add_handler(loop, base_node, id, handler, handler_arg);
 
             if (err == ESP_OK) {
                 if (!last_base_node) {
@@ -263,11 +377,13 @@ static esp_err_t loop_node_add_handler(esp_event_loop_node_t* loop_node, esp_eve
                 else {
                     SLIST_INSERT_AFTER(last_base_node, base_node, next);
                 }
+
+                base_index_add(loop, base_node);
             }
 
             return err;
         } else {
-            return base_node_add_handler(base_node, id, handler, handler_arg);
+            return base_node_add_handler(loop, base_node, id, handler, handler_arg);
         }
     }
 }
@@ -288,7 +404,7 @@ static esp_err_t handler_instances_remove(esp_event_handler_instances_t* handler
 }
 
 
-static esp_err_t base_node_remove_handler(esp_event_base_node_t* base_node, int32_t id, esp_event_handler_t handler)
+static esp_err_t base_node_remove_handler(esp_event_loop_instance_t* loop, esp_event_base_node_t* base_node, int32_t id, esp_event_handler_t handler)
 {
     if (id == ESP_EVENT_ANY_ID) {
         return handler_instances_remove(&(base_node->handlers), handler);
@@ -302,6 +418,7 @@ static esp_err_t base_node_remove_handler(esp_event_base_node_t* base_node, int3
                 if (res == ESP_OK) {
                     if (SLIST_EMPTY(&(it->handlers))) {
                         SLIST_REMOVE(&(base_node->id_nodes), it, esp_event_id_node, next);
+                        id_index_remove(loop, it);
                         free(it);
                         return ESP_OK;
                     }
@@ -313,7 +430,7 @@ static esp_err_t base_node_remove_handler(esp_event_base_node_t* base_node, int3
     return ESP_ERR_NOT_FOUND;
 }
 
-static esp_err_t loop_node_remove_handler(esp_event_loop_node_t* loop_node, esp_event_base_t base, int32_t id, esp_event_handler_t handler)
+static esp_err_t loop_node_remove_handler(esp_event_loop_instance_t* loop, esp_event_loop_node_t* loop_node, esp_event_base_t base, int32_t id, esp_event_handler_t handler)
 {
     if (base == esp_event_any_base && id == ESP_EVENT_ANY_ID) {
         return handler_instances_remove(&(loop_node->handlers), handler);
@@ -322,11 +439,12 @@ static esp_err_t loop_node_remove_handler(esp_event_loop_node_t* loop_node, esp_
         esp_event_base_node_t *it, *temp;
         SLIST_FOREACH_SAFE(it, &(loop_node->base_nodes), next, temp) {
             if (it->base == base) {
-                esp_err_t res = base_node_remove_handler(it, id, handler);
+                esp_err_t res = base_node_remove_handler(loop, it, id, handler);
 
                 if (res == ESP_OK) {
                     if (SLIST_EMPTY(&(it->handlers)) && SLIST_EMPTY(&(it->id_nodes))) {
                         SLIST_REMOVE(&(loop_node->base_nodes), it, esp_event_base_node, next);
+                        base_index_remove(loop, it);
                         free(it);
                         return ESP_OK;
                     }
@@ -371,25 +489,36 @@ static void loop_node_remove_all_handler(esp_event_loop_node_t* loop_node)
     }
 }
 
-static esp_err_t post_instance_create(esp_event_base_t event_base, int32_t event_id, void* event_data, int32_t event_data_size, esp_event_post_instance_t* post)
+static esp_err_t post_instance_create(esp_event_loop_instance_t* loop, esp_event_base_t event_base, int32_t event_id, void* event_data, int32_t event_data_size, esp_event_post_instance_t* post)
 {
     void* event_data_copy = NULL;
+    bool data_inline = false;
 
-    // Make persistent copy of event data on heap.
     if (event_data != NULL && event_data_size != 0) {
-        event_data_copy = calloc(1, event_data_size);
+        if (event_data_size <= loop->inline_data_size) {
+            // Small enough to be copied into the queue item itself, which holds space for it after the post
+            memcpy((uint8_t*) post + ESP_EVENT_POST_INLINE_DATA_OFFSET, event_data, event_data_size);
+            data_inline = true;
+        } else {
+            // Make persistent copy of event data on heap.
+            event_data_copy = calloc(1, event_data_size);
 
-        if (event_data_copy == NULL) {
-            ESP_LOGE(TAG, "alloc for post data to event %s:%d failed", event_base, event_id);
-            return ESP_ERR_NO_MEM;
-        }
+            if (event_data_copy == NULL) {
+                ESP_LOGE(TAG, "alloc for post data to event %s:%d failed", event_base, event_id);
+                return ESP_ERR_NO_MEM;
+            }
 
-        memcpy(event_data_copy, event_data, event_data_size);
+            memcpy(event_data_copy, event_data, event_data_size);
+        }
     }
 
     post->base = event_base;
     post->id = event_id;
     post->data = event_data_copy;
+    post->data_inline = data_inline;
+#ifdef CONFIG_EVENT_LOOP_PROFILING
+    post->time = esp_timer_get_time();
+#endif
 
     ESP_LOGD(TAG, "created post for event %s:%d", event_base, event_id);
 
@@ -398,7 +527,64 @@ static esp_err_t post_instance_create(esp_event_base_t event_base, int32_t event
 
 static void post_instance_delete(esp_event_post_instance_t* post)
 {
-    free(post->data);
+    if (!post->data_inline) {
+        free(post->data);
+    }
+}
+
+static void loop_workers_delete(esp_event_loop_instance_t* loop)
+{
+    for (size_t i = 0; i < loop->worker_count; i++) {
+        esp_event_loop_delete((esp_event_loop_handle_t) loop->workers[i]);
+    }
+
+    free(loop->workers);
+    free(loop);
+}
+
+static esp_err_t loop_workers_create(const esp_event_loop_args_t* event_loop_args, esp_event_loop_handle_t* event_loop)
+{
+    if (event_loop_args->task_name == NULL) {
+        ESP_LOGE(TAG, "event loop with multiple tasks requires a task name");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_event_loop_instance_t* loop = calloc(1, sizeof(*loop));
+    if (loop == NULL) {
+        ESP_LOGE(TAG, "alloc for event loop failed");
+        return ESP_ERR_NO_MEM;
+    }
+
+    loop->workers = calloc(event_loop_args->task_count, sizeof(*(loop->workers)));
+    if (loop->workers == NULL) {
+        ESP_LOGE(TAG, "alloc for event loop workers failed");
+        free(loop);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Each worker is an ordinary loop with a single task; posts and handler registrations made
+    // through the returned loop are forwarded to the worker, or workers, serving the event base.
+    esp_event_loop_args_t worker_args = *event_loop_args;
+    worker_args.task_count = 1;
+
+    for (uint32_t i = 0; i < event_loop_args->task_count; i++) {
+        esp_err_t err = esp_event_loop_create(&worker_args, (esp_event_loop_handle_t*) &(loop->workers[i]));
+
+        if (err != ESP_OK) {
+            loop_workers_delete(loop);
+            return err;
+        }
+
+        loop->worker_count++;
+    }
+
+    loop->name = event_loop_args->task_name;
+
+    *event_loop = (esp_event_loop_handle_t) loop;
+
+    ESP_LOGD(TAG, "created event loop %p with %d tasks", loop, loop->worker_count);
+
+    return ESP_OK;
 }
 
 /* ---------------------------- Public API --------------------------------- */
@@ -407,6 +593,10 @@ esp_err_t esp_event_loop_create(const esp_event_loop_args_t* event_loop_args, es
 {
     assert(event_loop_args);
 
+    if (event_loop_args->task_count > 1) {
+        return loop_workers_create(event_loop_args, event_loop);
+    }
+
     esp_event_loop_instance_t* loop;
     esp_err_t err = ESP_ERR_NO_MEM; // most likely error
 
@@ -416,7 +606,8 @@ esp_err_t esp_event_loop_create(const esp_event_loop_args_t* event_loop_args, es
         goto on_err;
     }
 
-    loop->queue = xQueueCreate(event_loop_args->queue_size , sizeof(esp_event_post_instance_t));
+    loop->inline_data_size = event_loop_args->inline_data_size;
+    loop->queue = xQueueCreate(event_loop_args->queue_size , POST_ITEM_SIZE(loop));
     if (loop->queue == NULL) {
         ESP_LOGE(TAG, "create event loop queue failed");
         goto on_err;
@@ -434,6 +625,8 @@ esp_err_t esp_event_loop_create(const esp_event_loop_args_t* event_loop_args, es
         ESP_LOGE(TAG, "create event loop profiling mutex failed");
         goto on_err;
     }
+
+    vPortCPUInitializeMutex(&(loop->isr_stats_spinlock));
 #endif
 
     SLIST_INIT(&(loop->loop_nodes));
@@ -503,7 +696,13 @@ esp_err_t esp_event_loop_run(esp_event_loop_handle_t event_loop, TickType_t tick
     assert(event_loop);
 
     esp_event_loop_instance_t* loop = (esp_event_loop_instance_t*) event_loop;
-    esp_event_post_instance_t post;
+
+    if (loop->worker_count) {
+        ESP_LOGE(TAG, "event loop with multiple tasks can not be run");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    POST_ITEM_DECLARE(loop, item);
     TickType_t marker = xTaskGetTickCount();
     TickType_t end = 0;
 
@@ -513,7 +712,24 @@ esp_err_t esp_event_loop_run(esp_event_loop_handle_t event_loop, TickType_t tick
     int64_t remaining_ticks = ticks_to_run;
 #endif
 
-    while(xQueueReceive(loop->queue, &post, ticks_to_run) == pdTRUE) {
+    while(xQueueReceive(loop->queue, item, ticks_to_run) == pdTRUE) {
+        esp_event_post_instance_t post = *item;
+        if (post.data_inline) {
+            post.data = (uint8_t*) item + ESP_EVENT_POST_INLINE_DATA_OFFSET;
+        }
+
+#ifdef CONFIG_EVENT_LOOP_PROFILING
+        int64_t wait = esp_timer_get_time() - post.time;
+
+        xSemaphoreTake(loop->profiling_mutex, portMAX_DELAY);
+        loop->events_dispatched++;
+        loop->queue_wait_time += wait;
+        if (wait > loop->max_queue_wait_time) {
+            loop->max_queue_wait_time = wait;
+        }
+        xSemaphoreGive(loop->profiling_mutex);
+#endif
+
         // The event has already been unqueued, so ensure it gets executed.
         xSemaphoreTakeRecursive(loop->mutex, portMAX_DELAY);
 
@@ -525,6 +741,7 @@ esp_err_t esp_event_loop_run(esp_event_loop_handle_t event_loop, TickType_t tick
         esp_event_loop_node_t *loop_node;
         esp_event_base_node_t *base_node;
         esp_event_id_node_t *id_node;
+        size_t index_bucket = base_index_bucket(post.base);
 
         SLIST_FOREACH(loop_node, &(loop->loop_nodes), next) {
             // Execute loop level handlers
@@ -533,23 +750,21 @@ esp_err_t esp_event_loop_run(esp_event_loop_handle_t event_loop, TickType_t tick
                 exec |= true;
             }
 
-            SLIST_FOREACH(base_node, &(loop_node->base_nodes), next) {
-                if (base_node->base == post.base) {
+            // Only visit base nodes hashed to the posted base; the bucket is in dispatch order
+            SLIST_FOREACH(base_node, &(loop->base_index[index_bucket]), bucket_next) {
+                if (base_node->loop_node == loop_node && base_node->base == post.base) {
                     // Execute base level handlers
                     SLIST_FOREACH(handler, &(base_node->handlers), next) {
                         handler_execute(loop, handler, post);
                         exec |= true;
                     }
 
-                    SLIST_FOREACH(id_node, &(base_node->id_nodes), next) {
-                        if(id_node->id == post.id) {
-                            // Execute id level handlers
-                            SLIST_FOREACH(handler, &(id_node->handlers), next) {
-                                handler_execute(loop, handler, post);
-                                exec |= true;
-                            }
-                            // Skip to next base node
-                            break;
+                    id_node = id_index_find(loop, base_node, post.id);
+                    if (id_node) {
+                        // Execute id level handlers
+                        SLIST_FOREACH(handler, &(id_node->handlers), next) {
+                            handler_execute(loop, handler, post);
+                            exec |= true;
                         }
                     }
                 }
@@ -588,6 +803,12 @@ esp_err_t esp_event_loop_delete(esp_event_loop_handle_t event_loop)
     assert(event_loop);
 
     esp_event_loop_instance_t* loop = (esp_event_loop_instance_t*) event_loop;
+
+    if (loop->worker_count) {
+        loop_workers_delete(loop);
+        return ESP_OK;
+    }
+
     SemaphoreHandle_t loop_mutex = loop->mutex;
 #ifdef CONFIG_EVENT_LOOP_PROFILING
     SemaphoreHandle_t loop_profiling_mutex = loop->profiling_mutex;
@@ -616,9 +837,9 @@ esp_err_t esp_event_loop_delete(esp_event_loop_handle_t event_loop)
     }
 
     // Drop existing posts on the queue
-    esp_event_post_instance_t post;
-    while(xQueueReceive(loop->queue, &post, 0) == pdTRUE) {
-        free(post.data);
+    POST_ITEM_DECLARE(loop, item);
+    while(xQueueReceive(loop->queue, item, 0) == pdTRUE) {
+        post_instance_delete(item);
     }
 
     // Cleanup loop
@@ -650,6 +871,27 @@ esp_err_t esp_event_handler_register_with(esp_event_loop_handle_t event_loop, es
 
     esp_event_loop_instance_t* loop = (esp_event_loop_instance_t*) event_loop;
 
+    if (loop->worker_count) {
+        if (event_base != ESP_EVENT_ANY_BASE) {
+            return esp_event_handler_register_with(esp_event_loop_worker_for_base(loop, event_base), event_base,
+                                                    event_id, event_handler, event_handler_arg);
+        }
+
+        // Loop level handlers are registered with every worker, in the same order as for a single task loop
+        for (size_t i = 0; i < loop->worker_count; i++) {
+            esp_err_t err = esp_event_handler_register_with(loop->workers[i], event_base, event_id,
+                                                            event_handler, event_handler_arg);
+            if (err != ESP_OK) {
+                while (i--) {
+                    esp_event_handler_unregister_with(loop->workers[i], event_base, event_id, event_handler);
+                }
+                return err;
+            }
+        }
+
+        return ESP_OK;
+    }
+
     if (event_base == ESP_EVENT_ANY_BASE) {
         event_base = esp_event_any_base;
     }
@@ -679,7 +921,7 @@ esp_err_t esp_event_handler_register_with(esp_event_loop_handle_t event_loop, es
             goto on_err;
         }
 
-        err = loop_node_add_handler(loop_node, event_base, event_id, event_handler, event_handler_arg);
+        err = loop_node_add_handler(loop, loop_node, event_base, event_id, event_handler, event_handler_arg);
 
         if (err == ESP_OK) {
             if (!last_loop_node) {
@@ -691,7 +933,7 @@ esp_err_t esp_event_handler_register_with(esp_event_loop_handle_t event_loop, es
         }
     }
     else {
-        err = loop_node_add_handler(last_loop_node, event_base, event_id, event_handler, event_handler_arg);
+        err = loop_node_add_handler(loop, last_loop_node, event_base, event_id, event_handler, event_handler_arg);
     }
 
 on_err:
@@ -710,6 +952,21 @@ esp_err_t esp_event_handler_unregister_with(esp_event_loop_handle_t event_loop,
         return ESP_FAIL;
     }
 
+    if (((esp_event_loop_instance_t*) event_loop)->worker_count) {
+        esp_event_loop_instance_t* loop = (esp_event_loop_instance_t*) event_loop;
+
+        if (event_base != ESP_EVENT_ANY_BASE) {
+            return esp_event_handler_unregister_with(esp_event_loop_worker_for_base(loop, event_base), event_base,
+                                                    event_id, event_handler);
+        }
+
+        for (size_t i = 0; i < loop->worker_count; i++) {
+            esp_event_handler_unregister_with(loop->workers[i], event_base, event_id, event_handler);
+        }
+
+        return ESP_OK;
+    }
+
     if (event_base == ESP_EVENT_ANY_BASE) {
         event_base = esp_event_any_base;
     }
@@ -721,7 +978,7 @@ esp_err_t esp_event_handler_unregister_with(esp_event_loop_handle_t event_loop,
     esp_event_loop_node_t *it, *temp;
 
     SLIST_FOREACH_SAFE(it, &(loop->loop_nodes), next, temp) {
-        esp_err_t res = loop_node_remove_handler(it, event_base, event_id, event_handler);
+        esp_err_t res = loop_node_remove_handler(loop, it, event_base, event_id, event_handler);
 
         if (res == ESP_OK && SLIST_EMPTY(&(it->base_nodes)) && SLIST_EMPTY(&(it->handlers))) {
             SLIST_REMOVE(&(loop->loop_nodes), it, esp_event_loop_node, next);
@@ -748,8 +1005,14 @@ esp_err_t esp_event_post_to(esp_event_loop_handle_t event_loop, esp_event_base_t
 
     esp_event_loop_instance_t* loop = (esp_event_loop_instance_t*) event_loop;
 
-    esp_event_post_instance_t post;
-    esp_err_t err = post_instance_create(event_base, event_id, event_data, event_data_size, &post);
+    if (loop->worker_count) {
+        // Events of a base are always posted to the same worker, which preserves their order
+        loop = esp_event_loop_worker_for_base(loop, event_base);
+        event_loop = (esp_event_loop_handle_t) loop;
+    }
+
+    POST_ITEM_DECLARE(loop, post);
+    esp_err_t err = post_instance_create(loop, event_base, event_id, event_data, event_data_size, post);
 
     if (err != ESP_OK) {
         return err;
@@ -766,23 +1029,23 @@ esp_err_t esp_event_post_to(esp_event_loop_handle_t event_loop, esp_event_base_t
         if (result == pdTRUE) {
             if (loop->running_task != xTaskGetCurrentTaskHandle()) {
                 xSemaphoreGiveRecursive(loop->mutex);
-                result = xQueueSendToBack(loop->queue, &post, ticks_to_wait);
+                result = xQueueSendToBack(loop->queue, post, ticks_to_wait);
             } else {
                 xSemaphoreGiveRecursive(loop->mutex);
-                result = xQueueSendToBack(loop->queue, &post, 0);
+                result = xQueueSendToBack(loop->queue, post, 0);
             }
         }
     } else {
         // The loop has a dedicated task.
         if (loop->task != xTaskGetCurrentTaskHandle()) {
-            result = xQueueSendToBack(loop->queue, &post, ticks_to_wait);
+            result = xQueueSendToBack(loop->queue, post, ticks_to_wait);
         } else {
-            result = xQueueSendToBack(loop->queue, &post, 0);
+            result = xQueueSendToBack(loop->queue, post, 0);
         }
     }
 
     if (result != pdTRUE) {
-        post_instance_delete(&post);
+        post_instance_delete(post);
 
 #ifdef CONFIG_EVENT_LOOP_PROFILING
         xSemaphoreTake(loop->profiling_mutex, portMAX_DELAY);
@@ -798,11 +1061,64 @@ esp_err_t esp_event_post_to(esp_event_loop_handle_t event_loop, esp_event_base_t
     xSemaphoreGive(loop->profiling_mutex);
 #endif
 
-    ESP_LOGD(TAG, "posted %s:%d to loop %p", post.base, post.id, event_loop);
+    ESP_LOGD(TAG, "posted %s:%d to loop %p", post->base, post->id, event_loop);
 
     return ESP_OK;
 }
 
+#if CONFIG_EVENT_LOOP_POST_FROM_ISR
+esp_err_t ESP_EVENT_ISR_ATTR esp_event_isr_post_to(esp_event_loop_handle_t event_loop, esp_event_base_t event_base,
+                                int32_t event_id, void* event_data, size_t event_data_size, BaseType_t* task_unblocked)
+{
+    assert(event_loop);
+
+    if (event_base == ESP_EVENT_ANY_BASE || event_id == ESP_EVENT_ANY_ID) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_event_loop_instance_t* loop = (esp_event_loop_instance_t*) event_loop;
+
+    if (loop->worker_count) {
+        loop = esp_event_loop_worker_for_base(loop, event_base);
+    }
+
+    // Nothing can be allocated here, so the event data must fit in the queue item. The queue storage
+    // itself is allocated with the loop, and sending to it never blocks.
+    if (event_data != NULL && event_data_size > loop->inline_data_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    POST_ITEM_DECLARE(loop, post);
+
+    post->base = event_base;
+    post->id = event_id;
+    post->data = NULL;
+    post->data_inline = false;
+
+    if (event_data != NULL && event_data_size != 0) {
+        memcpy((uint8_t*) post + ESP_EVENT_POST_INLINE_DATA_OFFSET, event_data, event_data_size);
+        post->data_inline = true;
+    }
+#ifdef CONFIG_EVENT_LOOP_PROFILING
+    post->time = esp_timer_get_time();
+#endif
+
+    BaseType_t result = xQueueSendToBackFromISR(loop->queue, post, task_unblocked);
+
+#ifdef CONFIG_EVENT_LOOP_PROFILING
+    portENTER_CRITICAL_ISR(&(loop->isr_stats_spinlock));
+    if (result == pdTRUE) {
+        loop->isr_events_recieved++;
+    } else {
+        loop->isr_events_dropped++;
+    }
+    portEXIT_CRITICAL_ISR(&(loop->isr_stats_spinlock));
+#endif
+
+    return (result == pdTRUE) ? ESP_OK : ESP_FAIL;
+}
+#endif
+
 
 esp_err_t esp_event_dump(FILE* file)
 {
@@ -827,20 +1143,27 @@ esp_err_t esp_event_dump(FILE* file)
 
     SLIST_FOREACH(loop_it, &s_event_loops, next) {
         PRINT_DUMP_INFO(dst, sz, LOOP_DUMP_FORMAT, loop_it, loop_it->task != NULL ? loop_it->name : "none" ,
-                        loop_it->events_recieved, loop_it->events_dropped);
+                        loop_it->events_recieved + loop_it->isr_events_recieved,
+                        loop_it->events_dropped + loop_it->isr_events_dropped,
+                        loop_it->isr_events_recieved, loop_it->isr_events_dropped,
+                        loop_it->queue_wait_time, loop_it->max_queue_wait_time);
 
         int sz_bak = sz;
 
         SLIST_FOREACH(loop_node_it, &(loop_it->loop_nodes), next) {
             SLIST_FOREACH(handler_it, &(loop_node_it->handlers), next) {
                 PRINT_DUMP_INFO(dst, sz, HANDLER_DUMP_FORMAT, handler_it->handler, "ESP_EVENT_ANY_BASE",
-                                "ESP_EVENT_ANY_ID", handler_it->invoked, handler_it->time);
+                                "ESP_EVENT_ANY_ID", handler_it->invoked, handler_it->time, handler_it->max_time,
+                                handler_time_percentile(handler_it, 50), handler_time_percentile(handler_it, 90),
+                                handler_time_percentile(handler_it, 99));
             }
 
             SLIST_FOREACH(base_node_it, &(loop_node_it->base_nodes), next) {
                 SLIST_FOREACH(handler_it, &(base_node_it->handlers), next) {
                     PRINT_DUMP_INFO(dst, sz, HANDLER_DUMP_FORMAT, handler_it->handler, base_node_it->base ,
-                                    "ESP_EVENT_ANY_ID", handler_it->invoked, handler_it->time);
+                                    "ESP_EVENT_ANY_ID", handler_it->invoked, handler_it->time, handler_it->max_time,
+                                    handler_time_percentile(handler_it, 50), handler_time_percentile(handler_it, 90),
+                                    handler_time_percentile(handler_it, 99));
                 }
 
                 SLIST_FOREACH(id_node_it, &(base_node_it->id_nodes), next) {
@@ -849,7 +1172,9 @@ esp_err_t esp_event_dump(FILE* file)
                         snprintf(id_str_buf, sizeof(id_str_buf), "%d", id_node_it->id);
 
                         PRINT_DUMP_INFO(dst, sz, HANDLER_DUMP_FORMAT, handler_it->handler, base_node_it->base ,
-                                        id_str_buf, handler_it->invoked, handler_it->time);
+                                        id_str_buf, handler_it->invoked, handler_it->time, handler_it->max_time,
+                                        handler_time_percentile(handler_it, 50), handler_time_percentile(handler_it, 90),
+                                        handler_time_percentile(handler_it, 99));
                     }
                 }
             }
@@ -871,3 +1196,134 @@ esp_err_t esp_event_dump(FILE* file)
 #endif
     return ESP_OK;
 }
+
+esp_err_t esp_event_loop_get_stats(esp_event_loop_handle_t event_loop, esp_event_loop_stats_t* stats)
+{
+#ifdef CONFIG_EVENT_LOOP_PROFILING
+    assert(event_loop);
+    assert(stats);
+
+    esp_event_loop_instance_t* loop = (esp_event_loop_instance_t*) event_loop;
+
+    if (loop->worker_count) {
+        esp_event_loop_stats_t worker_stats;
+
+        memset(stats, 0, sizeof(*stats));
+
+        for (size_t i = 0; i < loop->worker_count; i++) {
+            esp_event_loop_get_stats(loop->workers[i], &worker_stats);
+
+            stats->events_received += worker_stats.events_received;
+            stats->events_dropped += worker_stats.events_dropped;
+            stats->events_dispatched += worker_stats.events_dispatched;
+            stats->isr_events_received += worker_stats.isr_events_received;
+            stats->isr_events_dropped += worker_stats.isr_events_dropped;
+            stats->queue_wait_time += worker_stats.queue_wait_time;
+            if (worker_stats.max_queue_wait_time > stats->max_queue_wait_time) {
+                stats->max_queue_wait_time = worker_stats.max_queue_wait_time;
+            }
+        }
+
+        return ESP_OK;
+    }
+
+    xSemaphoreTake(loop->profiling_mutex, portMAX_DELAY);
+
+    stats->events_received = loop->events_recieved;
+    stats->events_dropped = loop->events_dropped;
+    stats->events_dispatched = loop->events_dispatched;
+    stats->queue_wait_time = loop->queue_wait_time;
+    stats->max_queue_wait_time = loop->max_queue_wait_time;
+
+    xSemaphoreGive(loop->profiling_mutex);
+
+    portENTER_CRITICAL(&(loop->isr_stats_spinlock));
+    stats->isr_events_received = loop->isr_events_recieved;
+    stats->isr_events_dropped = loop->isr_events_dropped;
+    portEXIT_CRITICAL(&(loop->isr_stats_spinlock));
+
+    stats->events_received += stats->isr_events_received;
+    stats->events_dropped += stats->isr_events_dropped;
+
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t esp_event_loop_get_handler_stats(esp_event_loop_handle_t event_loop, esp_event_handler_stats_t* stats, size_t* count)
+{
+#ifdef CONFIG_EVENT_LOOP_PROFILING
+    assert(event_loop);
+    assert(count);
+    assert(stats || *count == 0);
+
+    esp_event_loop_instance_t* loop = (esp_event_loop_instance_t*) event_loop;
+    esp_err_t err = ESP_OK;
+
+    if (loop->worker_count) {
+        size_t stored = 0;
+
+        for (size_t i = 0; i < loop->worker_count; i++) {
+            size_t worker_count = *count - stored;
+
+            if (esp_event_loop_get_handler_stats(loop->workers[i], stats + stored, &worker_count) != ESP_OK) {
+                err = ESP_ERR_INVALID_SIZE;
+            }
+
+            stored += worker_count;
+        }
+
+        *count = stored;
+        return err;
+    }
+
+    esp_event_loop_node_t *loop_node_it;
+    esp_event_base_node_t* base_node_it;
+    esp_event_id_node_t* id_node_it;
+    esp_event_handler_instance_t* handler_it;
+    size_t stored = 0;
+
+    // The handler lists are protected by the loop mutex, the statistics by the profiling mutex
+    xSemaphoreTakeRecursive(loop->mutex, portMAX_DELAY);
+    xSemaphoreTake(loop->profiling_mutex, portMAX_DELAY);
+
+    SLIST_FOREACH(loop_node_it, &(loop->loop_nodes), next) {
+        SLIST_FOREACH(handler_it, &(loop_node_it->handlers), next) {
+            if (stored < *count) {
+                handler_stats_get(handler_it, ESP_EVENT_ANY_BASE, ESP_EVENT_ANY_ID, &stats[stored++]);
+            } else {
+                err = ESP_ERR_INVALID_SIZE;
+            }
+        }
+
+        SLIST_FOREACH(base_node_it, &(loop_node_it->base_nodes), next) {
+            SLIST_FOREACH(handler_it, &(base_node_it->handlers), next) {
+                if (stored < *count) {
+                    handler_stats_get(handler_it, base_node_it->base, ESP_EVENT_ANY_ID, &stats[stored++]);
+                } else {
+                    err = ESP_ERR_INVALID_SIZE;
+                }
+            }
+
+            SLIST_FOREACH(id_node_it, &(base_node_it->id_nodes), next) {
+                SLIST_FOREACH(handler_it, &(id_node_it->handlers), next) {
+                    if (stored < *count) {
+                        handler_stats_get(handler_it, base_node_it->base, id_node_it->id, &stats[stored++]);
+                    } else {
+                        err = ESP_ERR_INVALID_SIZE;
+                    }
+                }
+            }
+        }
+    }
+
+    xSemaphoreGive(loop->profiling_mutex);
+    xSemaphoreGiveRecursive(loop->mutex);
+
+    *count = stored;
+    return err;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
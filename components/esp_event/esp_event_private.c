@@ -21,6 +21,11 @@ bool esp_event_is_handler_registered(esp_event_loop_handle_t event_loop, esp_eve
 {
     esp_event_loop_instance_t* loop = (esp_event_loop_instance_t*) event_loop;
 
+    if (loop->worker_count) {
+        // Loop level handlers are registered with every worker
+        loop = (event_base == ESP_EVENT_ANY_BASE) ? loop->workers[0] : esp_event_loop_worker_for_base(loop, event_base);
+    }
+
     bool result = false;
 
     esp_event_loop_node_t* loop_node;
@@ -19,6 +19,7 @@
 #include "esp_err.h"
 #include "esp_wifi.h"
 #include "esp_private/wifi.h"
+#include "esp_private/wifi_fast_connect.h"
 #include "esp_event.h"
 #include "esp_event_loop.h"
 #include "esp_task.h"
@@ -195,6 +196,9 @@ static esp_err_t system_event_sta_got_ip_default(system_event_t *event)
            IP2STR(&event->event_info.got_ip.ip_info.netmask),
            IP2STR(&event->event_info.got_ip.ip_info.gw));
 
+#if CONFIG_ESP32_WIFI_FAST_CONNECT
+    wifi_fast_connect_sta_got_ip();
+#endif
     return ESP_OK;
 }
 
@@ -236,6 +240,9 @@ esp_err_t system_event_sta_start_handle_default(system_event_t *event)
     tcpip_adapter_get_ip_info(TCPIP_ADAPTER_IF_STA, &sta_ip);
     tcpip_adapter_sta_start(sta_mac, &sta_ip);
 
+#if CONFIG_ESP32_WIFI_FAST_CONNECT
+    wifi_fast_connect_sta_start();
+#endif
     return ESP_OK;
 }
 
@@ -250,6 +257,9 @@ esp_err_t system_event_sta_connected_handle_default(system_event_t *event)
 {
     tcpip_adapter_dhcp_status_t status;
 
+#if CONFIG_ESP32_WIFI_FAST_CONNECT
+    wifi_fast_connect_sta_connected();
+#endif
     WIFI_API_CALL_CHECK("esp_wifi_internal_reg_rxcb", esp_wifi_internal_reg_rxcb(ESP_IF_WIFI_STA, (wifi_rxcb_t)tcpip_adapter_sta_input), ESP_OK);
 
     tcpip_adapter_up(TCPIP_ADAPTER_IF_STA);
@@ -292,6 +302,9 @@ esp_err_t system_event_sta_disconnected_handle_default(system_event_t *event)
 {
     tcpip_adapter_down(TCPIP_ADAPTER_IF_STA);
     WIFI_API_CALL_CHECK("esp_wifi_internal_reg_rxcb", esp_wifi_internal_reg_rxcb(ESP_IF_WIFI_STA, NULL), ESP_OK);
+#if CONFIG_ESP32_WIFI_FAST_CONNECT
+    wifi_fast_connect_sta_disconnected();
+#endif
     return ESP_OK;
 }
 
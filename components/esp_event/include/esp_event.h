@@ -30,6 +30,32 @@ extern "C" {
 #endif
 
 
+/// Statistics of an event loop, collected when CONFIG_EVENT_LOOP_PROFILING is enabled
+typedef struct {
+    uint32_t events_received;                   /**< number of events successfully posted to the loop */
+    uint32_t events_dropped;                    /**< number of events not posted because the queue was full */
+    uint32_t events_dispatched;                 /**< number of events taken from the queue and dispatched */
+    int64_t queue_wait_time;                    /**< total time in microseconds dispatched events spent in the queue */
+    int64_t max_queue_wait_time;                /**< longest time in microseconds an event spent in the queue */
+    uint32_t isr_events_received;               /**< number of events_received which were posted from an ISR */
+    uint32_t isr_events_dropped;                /**< number of events_dropped which were posted from an ISR */
+} esp_event_loop_stats_t;
+
+/// Statistics of a handler registered with an event loop, collected when CONFIG_EVENT_LOOP_PROFILING is enabled
+typedef struct {
+    esp_event_handler_t handler;                /**< the handler function */
+    esp_event_base_t event_base;                /**< event base the handler is registered for, ESP_EVENT_ANY_BASE
+                                                        for all events of the loop */
+    int32_t event_id;                           /**< event id the handler is registered for, ESP_EVENT_ANY_ID for
+                                                        all events of the base */
+    uint32_t invoked;                           /**< number of times the handler has been invoked */
+    int64_t time;                               /**< total runtime of the handler in microseconds */
+    int64_t max_time;                           /**< longest runtime of a single call in microseconds */
+    int64_t p50_time;                           /**< median runtime in microseconds, rounded up to a power of two */
+    int64_t p90_time;                           /**< 90th percentile runtime in microseconds, rounded up to a power of two */
+    int64_t p99_time;                           /**< 99th percentile runtime in microseconds, rounded up to a power of two */
+} esp_event_handler_stats_t;
+
 /// Configuration for creating event loops
 typedef struct {
     int32_t queue_size;                         /**< size of the event loop queue */
@@ -39,6 +65,15 @@ typedef struct {
     uint32_t task_stack_size;                   /**< stack size of the event loop task, ignored if task name is NULL */
     BaseType_t task_core_id;                    /**< core to which the event loop task is pinned to,
                                                         ignored if task name is NULL */
+    size_t inline_data_size;                    /**< event data of up to this many bytes is copied into the event
+                                                        queue item instead of a heap allocation; 0 to always
+                                                        allocate. Each of the queue_size queue items grows by this
+                                                        amount, and a queue item is held on the stack of posting
+                                                        and loop running tasks */
+    uint32_t task_count;                        /**< number of tasks dispatching events for the loop; 0 or 1
+                                                        for a single task. With more than one task, events are
+                                                        sharded between the tasks by event base, each task having
+                                                        its own queue of queue_size items. Requires task_name */
 } esp_event_loop_args_t;
 
 /**
@@ -110,6 +145,7 @@ esp_err_t esp_event_loop_delete_default();
  *
  * @return
  *  - ESP_OK: Success
+ *  - ESP_ERR_NOT_SUPPORTED: The loop was created with multiple tasks
  *  - Others: Fail
  */
 esp_err_t esp_event_loop_run(esp_event_loop_handle_t event_loop, TickType_t ticks_to_run);
@@ -229,7 +265,7 @@ esp_err_t esp_event_handler_unregister_with(esp_event_loop_handle_t event_loop,
  * @param[in] event_data_size the size of the event data
  * @param[in] ticks_to_wait number of ticks to block on a full event queue
  *
- * @note posting events from an ISR is not supported
+ * @note posting events from an ISR is not supported, see esp_event_isr_post and esp_event_isr_post_to
  *
  * @return
  *  - ESP_OK: Success
@@ -258,7 +294,7 @@ esp_err_t esp_event_post(esp_event_base_t event_base,
  * @param[in] event_data_size the size of the event data
  * @param[in] ticks_to_wait number of ticks to block on a full event queue
  *
- * @note posting events from an ISR is not supported
+ * @note posting events from an ISR is not supported, see esp_event_isr_post and esp_event_isr_post_to
  *
  * @return
  *  - ESP_OK: Success
@@ -273,6 +309,68 @@ esp_err_t esp_event_post_to(esp_event_loop_handle_t event_loop,
                             size_t event_data_size,
                             TickType_t ticks_to_wait);
 
+#if CONFIG_EVENT_LOOP_POST_FROM_ISR
+/**
+ * @brief Special variant of esp_event_post for posting events from interrupt handlers.
+ *
+ * @param[in] event_base the event base that identifies the event
+ * @param[in] event_id the event id that identifies the event
+ * @param[in] event_data the data, specific to the event occurence, that gets passed to the handler
+ * @param[in] event_data_size the size of the event data; at most the inline_data_size of the loop
+ * @param[out] task_unblocked an optional parameter (can be NULL) which indicates that an event task with
+ *                            higher priority than currently running task has been unblocked by the posted event;
+ *                            a context switch should be requested before the interrupt is exited.
+ *
+ * @note this function is only available when CONFIG_EVENT_LOOP_POST_FROM_ISR is enabled
+ * @note the default event loop copies at most 4 bytes of event data into the queue item
+ *
+ * @return
+ *  - ESP_OK: Success
+ *  - ESP_FAIL: Event queue for the default event loop full
+ *  - ESP_ERR_INVALID_ARG: Invalid combination of event base and event id
+ *  - ESP_ERR_INVALID_SIZE: Event data does not fit in the event queue item
+ *  - ESP_ERR_INVALID_STATE: Default event loop has not been created
+ */
+esp_err_t esp_event_isr_post(esp_event_base_t event_base,
+                            int32_t event_id,
+                            void* event_data,
+                            size_t event_data_size,
+                            BaseType_t* task_unblocked);
+
+/**
+ * @brief Special variant of esp_event_post_to for posting events from interrupt handlers.
+ *
+ * The event and a copy of event_data are put into the queue of the loop without blocking and without
+ * allocating memory, so the event data has to fit in the queue item: event_data_size can be at most the
+ * inline_data_size the loop was created with. Events which do not fit in the queue are dropped, and
+ * counted in the loop statistics when CONFIG_EVENT_LOOP_PROFILING is enabled.
+ *
+ * @param[in] event_loop the event loop to post to
+ * @param[in] event_base the event base that identifies the event
+ * @param[in] event_id the event id that identifies the event
+ * @param[in] event_data the data, specific to the event occurence, that gets passed to the handler
+ * @param[in] event_data_size the size of the event data; at most the inline_data_size of the loop
+ * @param[out] task_unblocked an optional parameter (can be NULL) which indicates that an event task with
+ *                            higher priority than currently running task has been unblocked by the posted event;
+ *                            a context switch should be requested before the interrupt is exited.
+ *
+ * @note this function is only available when CONFIG_EVENT_LOOP_POST_FROM_ISR is enabled
+ * @note when this function is called from an ISR placed in IRAM, the event data must be in internal RAM
+ *
+ * @return
+ *  - ESP_OK: Success
+ *  - ESP_FAIL: Event queue for the loop full
+ *  - ESP_ERR_INVALID_ARG: Invalid combination of event base and event id
+ *  - ESP_ERR_INVALID_SIZE: Event data does not fit in the event queue item
+ */
+esp_err_t esp_event_isr_post_to(esp_event_loop_handle_t event_loop,
+                            esp_event_base_t event_base,
+                            int32_t event_id,
+                            void* event_data,
+                            size_t event_data_size,
+                            BaseType_t* task_unblocked);
+#endif
+
 /**
  * @brief Dumps statistics of all event loops.
  *
@@ -291,20 +389,24 @@ esp_err_t esp_event_post_to(esp_event_loop_handle_t event_loop,
   where:
 
    event loop
-       format: address,name rx:total_recieved dr:total_dropped
+       format: address,name rx:total_recieved dr:total_dropped wait:total_wait us wait max:max_wait us
        where:
            address - memory address of the event loop
            name - name of the event loop, 'none' if no dedicated task
            total_recieved - number of successfully posted events
            total_dropped - number of events unsucessfully posted due to queue being full
+           total_wait - total amount of time dispatched events spent in the queue
+           max_wait - longest time an event spent in the queue
 
    handler
-       format: address ev:base,id inv:total_invoked run:total_runtime
+       format: address ev:base,id inv:total_invoked run:total_runtime max:max_runtime p50:p50 p90:p90 p99:p99
        where:
            address - address of the handler function
            base,id - the event specified by event base and id this handler executes
            total_invoked - number of times this handler has been invoked
            total_runtime - total amount of time used for invoking this handler
+           max_runtime - longest time used for a single invocation
+           p50,p90,p99 - runtime percentiles, see esp_event_loop_get_handler_stats
 
  @endverbatim
  *
@@ -319,6 +421,38 @@ esp_err_t esp_event_post_to(esp_event_loop_handle_t event_loop,
  */
 esp_err_t esp_event_dump(FILE* file);
 
+/**
+ * @brief Get the statistics of an event loop
+ *
+ * For a loop created with multiple tasks, the statistics of all its tasks are added up.
+ *
+ * @param[in] event_loop the event loop to get the statistics of
+ * @param[out] stats the statistics of the loop
+ *
+ * @return
+ *  - ESP_OK: Success
+ *  - ESP_ERR_NOT_SUPPORTED: CONFIG_EVENT_LOOP_PROFILING is disabled
+ */
+esp_err_t esp_event_loop_get_stats(esp_event_loop_handle_t event_loop, esp_event_loop_stats_t* stats);
+
+/**
+ * @brief Get the statistics of the handlers registered with an event loop
+ *
+ * Runtime percentiles are taken from a histogram with power of two buckets, so they are reported as the
+ * upper bound of the bucket they fall in, capped at the longest runtime. For a loop created with multiple
+ * tasks, handlers registered with ESP_EVENT_ANY_BASE are reported once for each task.
+ *
+ * @param[in] event_loop the event loop to get the handler statistics of
+ * @param[out] stats array to store the statistics of the handlers in
+ * @param[inout] count on input, the number of entries in stats; on output, the number of entries stored
+ *
+ * @return
+ *  - ESP_OK: Success
+ *  - ESP_ERR_INVALID_SIZE: More handlers are registered than fit in stats, the first ones are stored
+ *  - ESP_ERR_NOT_SUPPORTED: CONFIG_EVENT_LOOP_PROFILING is disabled
+ */
+esp_err_t esp_event_loop_get_handler_stats(esp_event_loop_handle_t event_loop, esp_event_handler_stats_t* stats, size_t* count);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -15,6 +15,8 @@
 #ifndef ESP_EVENT_INTERNAL_H_
 #define ESP_EVENT_INTERNAL_H_
 
+#include <stdbool.h>
+#include "esp_attr.h"
 #include "esp_event.h"
 
 #ifdef __cplusplus
@@ -23,6 +25,26 @@ extern "C" {
 
 typedef SLIST_HEAD(base_nodes, base_node) base_nodes_t;
 
+#ifdef CONFIG_EVENT_LOOP_PROFILING
+/// Number of buckets in the runtime histogram of a handler, the last one counting all longer runtimes
+#define ESP_EVENT_HANDLER_TIME_BUCKETS  16
+#endif
+
+/// Placement of the functions posting events from ISRs
+#if CONFIG_EVENT_LOOP_POST_FROM_IRAM_ISR
+#define ESP_EVENT_ISR_ATTR              IRAM_ATTR
+#else
+#define ESP_EVENT_ISR_ATTR
+#endif
+
+/// Number of buckets, as a power of two, in the loop's index of base nodes by event base
+#define ESP_EVENT_BASE_BUCKETS_BITS     3
+/// Number of buckets, as a power of two, in the loop's index of id nodes by base node and event id
+#define ESP_EVENT_ID_BUCKETS_BITS       5
+
+#define ESP_EVENT_BASE_BUCKETS          (1 << ESP_EVENT_BASE_BUCKETS_BITS)
+#define ESP_EVENT_ID_BUCKETS            (1 << ESP_EVENT_ID_BUCKETS_BITS)
+
 /// Event handler
 typedef struct esp_event_handler_instance {
     esp_event_handler_t handler;                                    /**< event handler function*/
@@ -30,6 +52,9 @@ typedef struct esp_event_handler_instance {
 #ifdef CONFIG_EVENT_LOOP_PROFILING
     uint32_t invoked;                                               /**< number of times this handler has been invoked */
     int64_t time;                                                   /**< total runtime of this handler across all calls */
+    int64_t max_time;                                               /**< longest runtime of a single call */
+    uint32_t time_hist[ESP_EVENT_HANDLER_TIME_BUCKETS];             /**< number of calls by runtime, bucket n counting
+                                                                            runtimes below 2^(n + 1) us */
 #endif
     SLIST_ENTRY(esp_event_handler_instance) next;                   /**< next event handler in the list */
 } esp_event_handler_instance_t;
@@ -41,7 +66,10 @@ typedef struct esp_event_id_node {
     int32_t id;                                                     /**< id number of the event */
     esp_event_handler_instances_t handlers;                         /**< list of handlers to be executed when
                                                                             this event is raised */
+    struct esp_event_base_node* base_node;                          /**< base node this event node belongs to */
     SLIST_ENTRY(esp_event_id_node) next;                            /**< pointer to the next event node on the linked list */
+    SLIST_ENTRY(esp_event_id_node) bucket_next;                     /**< pointer to the next event node in the same
+                                                                            bucket of the loop's id index */
 } esp_event_id_node_t;
 
 typedef SLIST_HEAD(esp_event_id_nodes, esp_event_id_node) esp_event_id_nodes_t;
@@ -51,7 +79,11 @@ typedef struct esp_event_base_node {
     esp_event_handler_instances_t handlers;                         /**< event base level handlers, handlers for
                                                                             all events with this base */
     esp_event_id_nodes_t id_nodes;                                  /**< list of event ids with this base */
+    struct esp_event_loop_node* loop_node;                          /**< loop node this base node belongs to */
     SLIST_ENTRY(esp_event_base_node) next;                          /**< pointer to the next base node on the linked list */
+    SLIST_ENTRY(esp_event_base_node) bucket_next;                   /**< pointer to the next base node in the same
+                                                                            bucket of the loop's base index, in
+                                                                            dispatch order */
 } esp_event_base_node_t;
 
 typedef SLIST_HEAD(esp_event_base_nodes, esp_event_base_node) esp_event_base_nodes_t;
@@ -76,9 +108,27 @@ typedef struct esp_event_loop_instance {
     SemaphoreHandle_t mutex;                                        /**< mutex for updating the events linked list */
     esp_event_loop_nodes_t loop_nodes;                              /**< set of linked lists containing the
                                                                             registered handlers for the loop */
+    esp_event_base_nodes_t base_index[ESP_EVENT_BASE_BUCKETS];      /**< base nodes of all loop nodes, hashed by
+                                                                            event base */
+    esp_event_id_nodes_t id_index[ESP_EVENT_ID_BUCKETS];            /**< id nodes of all base nodes, hashed by
+                                                                            base node and event id */
+    size_t inline_data_size;                                        /**< maximum size of event data stored in the
+                                                                            queue item itself */
+    struct esp_event_loop_instance** workers;                       /**< for loops with multiple tasks, the single
+                                                                            task loops the events are sharded to */
+    size_t worker_count;                                            /**< number of worker loops, 0 if the loop
+                                                                            dispatches events itself */
 #ifdef CONFIG_EVENT_LOOP_PROFILING
     uint32_t events_recieved;                                       /**< number of events successfully posted to the loop */
     uint32_t events_dropped;                                        /**< number of events dropped due to queue being full */
+    uint32_t events_dispatched;                                     /**< number of events taken from the queue and dispatched */
+    int64_t queue_wait_time;                                        /**< total time dispatched events spent in the queue */
+    int64_t max_queue_wait_time;                                    /**< longest time an event spent in the queue */
+    uint32_t isr_events_recieved;                                   /**< number of events posted to the loop from an ISR */
+    uint32_t isr_events_dropped;                                    /**< number of events posted from an ISR dropped due
+                                                                            to queue being full */
+    portMUX_TYPE isr_stats_spinlock;                                /**< spinlock for the ISR counters, which can not
+                                                                            take the profiling mutex */
     SemaphoreHandle_t profiling_mutex;                              /**< mutex used for profiliing */
     SLIST_ENTRY(esp_event_loop_instance) next;                      /**< next event loop in the list */
 #endif
@@ -89,8 +139,25 @@ typedef struct esp_event_post_instance {
     esp_event_base_t base;                                           /**< the event base */
     int32_t id;                                                      /**< the event id */
     void* data;                                                      /**< data associated with the event */
+    bool data_inline;                                                /**< data is stored in the queue item, after
+                                                                            the post instance, rather than on the heap */
+#ifdef CONFIG_EVENT_LOOP_PROFILING
+    int64_t time;                                                    /**< time the event was posted */
+#endif
 } esp_event_post_instance_t;
 
+/// Worker of a loop with multiple tasks that dispatches the events of a base; always inlined, as it is
+/// also called by the ISR post functions, which may be placed in IRAM
+static inline __attribute__((always_inline)) esp_event_loop_instance_t* esp_event_loop_worker_for_base(esp_event_loop_instance_t* loop, esp_event_base_t base)
+{
+    // Event bases are compared by address, so the address is hashed and scaled to the worker count
+    uint32_t hash = (uint32_t) (uintptr_t) base * 2654435761u;
+    return loop->workers[((uint64_t) hash * loop->worker_count) >> 32];
+}
+
+/// Offset of inline event data in an event queue item, keeping the data 8-byte aligned
+#define ESP_EVENT_POST_INLINE_DATA_OFFSET   ((sizeof(esp_event_post_instance_t) + 7) & ~7)
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
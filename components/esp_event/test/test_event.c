@@ -14,6 +14,8 @@
 #include "esp_event_internal.h"
 
 #include "esp_heap_caps.h"
+#include "esp_attr.h"
+#include "driver/timer.h"
 
 #include "sdkconfig.h"
 #include "unity.h"
@@ -1102,6 +1104,274 @@ TEST_CASE("events are dispatched in the order they are registered", "[event]")
     TEST_TEARDOWN();
 }
 
+static void test_event_copy_data(void* event_handler_arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+{
+    memcpy(event_handler_arg, event_data, event_id);
+}
+
+TEST_CASE("can post events with inline data", "[event]")
+{
+    /* this test aims to verify that:
+     *  - event data up to inline_data_size is delivered without a heap allocation per post
+     *  - larger event data is still delivered using a heap allocation
+     *  - posts left in the queue are released when the loop is deleted */
+
+    TEST_SETUP();
+
+    esp_event_loop_handle_t loop;
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+
+    loop_args.task_name = NULL;
+    loop_args.inline_data_size = 16;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_loop_create(&loop_args, &loop));
+
+    uint8_t received[32];
+    uint8_t sent[32];
+    for (int i = 0; i < sizeof(sent); i++) {
+        sent[i] = i;
+    }
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_handler_register_with(loop, s_test_base1, ESP_EVENT_ANY_ID, test_event_copy_data, received));
+
+    // Event data fits inline, so posting it does not touch the heap
+    size_t free_mem_before_post = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_post_to(loop, s_test_base1, 16, sent, 16, portMAX_DELAY));
+    TEST_ASSERT_EQUAL(free_mem_before_post, heap_caps_get_free_size(MALLOC_CAP_DEFAULT));
+
+    memset(received, 0, sizeof(received));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_loop_run(loop, pdMS_TO_TICKS(10)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(sent, received, 16);
+
+    // Event data larger than inline_data_size is allocated
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_post_to(loop, s_test_base1, sizeof(sent), sent, sizeof(sent), portMAX_DELAY));
+    TEST_ASSERT_TRUE(heap_caps_get_free_size(MALLOC_CAP_DEFAULT) < free_mem_before_post);
+
+    memset(received, 0, sizeof(received));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_loop_run(loop, pdMS_TO_TICKS(10)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(sent, received, sizeof(sent));
+
+    // Leave both kinds of posts in the queue
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_post_to(loop, s_test_base1, 8, sent, 8, portMAX_DELAY));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_post_to(loop, s_test_base1, sizeof(sent), sent, sizeof(sent), portMAX_DELAY));
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_loop_delete(loop));
+
+    TEST_TEARDOWN();
+}
+
+static void test_event_worker_wait(void* event_handler_arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+{
+    SemaphoreHandle_t* sems = (SemaphoreHandle_t*) event_handler_arg;
+
+    // Only completes if the event of the other base is dispatched while this handler blocks
+    if (xSemaphoreTake(sems[0], pdMS_TO_TICKS(1000)) == pdTRUE) {
+        xSemaphoreGive(sems[1]);
+    }
+}
+
+static void test_event_worker_signal(void* event_handler_arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+{
+    SemaphoreHandle_t* sems = (SemaphoreHandle_t*) event_handler_arg;
+    xSemaphoreGive(sems[0]);
+}
+
+TEST_CASE("can dispatch events of different bases in parallel on a loop with multiple tasks", "[event]")
+{
+    /* this test aims to verify that:
+     *  - a loop with multiple tasks dispatches events of bases served by different tasks in parallel
+     *  - events of a base are still dispatched in the order they were posted, with loop level
+     *    handlers registered with every task */
+
+    TEST_SETUP();
+
+    esp_event_loop_handle_t loop;
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+
+    loop_args.task_count = 2;
+    loop_args.task_core_id = tskNO_AFFINITY;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_loop_create(&loop_args, &loop));
+
+    // Running the loop from another task is not possible with multiple tasks
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, esp_event_loop_run(loop, 0));
+
+    // Any string can serve as an event base; find two served by different tasks
+    static const char bases[16][4] = { "b0", "b1", "b2", "b3", "b4", "b5", "b6", "b7",
+                                       "b8", "b9", "b10", "b11", "b12", "b13", "b14", "b15" };
+    esp_event_loop_instance_t* instance = (esp_event_loop_instance_t*) loop;
+    esp_event_base_t wait_base = bases[0];
+    esp_event_base_t signal_base = NULL;
+
+    for (int i = 1; i < 16; i++) {
+        if (esp_event_loop_worker_for_base(instance, bases[i]) != esp_event_loop_worker_for_base(instance, wait_base)) {
+            signal_base = bases[i];
+            break;
+        }
+    }
+
+    TEST_ASSERT_NOT_NULL(signal_base);
+
+    SemaphoreHandle_t sems[2] = { xSemaphoreCreateBinary(), xSemaphoreCreateBinary() };
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_handler_register_with(loop, wait_base, TEST_EVENT_BASE1_EV1, test_event_worker_wait, sems));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_handler_register_with(loop, signal_base, TEST_EVENT_BASE1_EV1, test_event_worker_signal, sems));
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_post_to(loop, wait_base, TEST_EVENT_BASE1_EV1, NULL, 0, portMAX_DELAY));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_post_to(loop, signal_base, TEST_EVENT_BASE1_EV1, NULL, 0, portMAX_DELAY));
+
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(sems[1], pdMS_TO_TICKS(2000)));
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_handler_unregister_with(loop, wait_base, TEST_EVENT_BASE1_EV1, test_event_worker_wait));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_handler_unregister_with(loop, signal_base, TEST_EVENT_BASE1_EV1, test_event_worker_signal));
+
+    // Events of a base keep their order, interleaved with the loop level handler
+    int id_arr[2] = { 0, 1 };
+    int data_arr[4] = { 0 };
+
+    ordered_data_t data = {
+        .arr = data_arr,
+        .index = 0
+    };
+
+    ordered_data_t* dptr = &data;
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_handler_register_with(loop, s_test_base1, ESP_EVENT_ANY_ID, test_event_ordered_dispatch, id_arr + 0));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_handler_register_with(loop, ESP_EVENT_ANY_BASE, ESP_EVENT_ANY_ID, test_event_ordered_dispatch, id_arr + 1));
+    TEST_ASSERT_TRUE(esp_event_is_handler_registered(loop, ESP_EVENT_ANY_BASE, ESP_EVENT_ANY_ID, test_event_ordered_dispatch));
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_post_to(loop, s_test_base1, TEST_EVENT_BASE1_EV1, &dptr, sizeof(dptr), portMAX_DELAY));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_post_to(loop, s_test_base1, TEST_EVENT_BASE1_EV2, &dptr, sizeof(dptr), portMAX_DELAY));
+
+    vTaskDelay(pdMS_TO_TICKS(100));
+
+    int ref_arr[4] = { 0, 1, 0, 1 };
+    TEST_ASSERT_EQUAL_INT_ARRAY(ref_arr, data_arr, 4);
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_loop_delete(loop));
+
+    vSemaphoreDelete(sems[0]);
+    vSemaphoreDelete(sems[1]);
+
+    TEST_TEARDOWN();
+}
+
+#if CONFIG_EVENT_LOOP_POST_FROM_ISR
+#define TEST_ISR_POSTS      10
+
+#if CONFIG_EVENT_LOOP_POST_FROM_IRAM_ISR
+#define TEST_ISR_FLAGS      ESP_INTR_FLAG_IRAM
+#else
+#define TEST_ISR_FLAGS      0
+#endif
+
+typedef struct {
+    esp_event_loop_handle_t loop;
+    int posted;
+    int failed;
+    int received[TEST_ISR_POSTS];
+    int count;
+    SemaphoreHandle_t done;
+} isr_post_data_t;
+
+static void IRAM_ATTR test_event_on_timer_alarm(void* arg)
+{
+    isr_post_data_t* data = (isr_post_data_t*) arg;
+    BaseType_t task_unblocked = pdFALSE;
+
+    TIMERG0.int_clr_timers.t0 = 1;
+
+    if (data->posted == 0) {
+        // Larger than the loop's inline data, which can not be allocated
+        uint8_t large[8] = { 0 };
+        if (esp_event_isr_post_to(data->loop, s_test_base1, TEST_EVENT_BASE1_EV1, large, sizeof(large), NULL) != ESP_ERR_INVALID_SIZE) {
+            data->failed++;
+        }
+    }
+
+    data->posted++;
+    if (esp_event_isr_post_to(data->loop, s_test_base1, TEST_EVENT_BASE1_EV1, &data->posted, sizeof(data->posted), &task_unblocked) != ESP_OK) {
+        data->failed++;
+    }
+
+    if (data->posted < TEST_ISR_POSTS) {
+        TIMERG0.hw_timer[TIMER_0].config.alarm_en = 1;
+    }
+
+    if (task_unblocked) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+static void test_event_isr_post_handler(void* event_handler_arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+{
+    isr_post_data_t* data = (isr_post_data_t*) event_handler_arg;
+
+    data->received[data->count++] = *((int*) event_data);
+
+    if (data->count == TEST_ISR_POSTS) {
+        xSemaphoreGive(data->done);
+    }
+}
+
+TEST_CASE("can post events from ISR", "[event]")
+{
+    /* this test aims to verify that:
+     *  - events posted from an ISR are dispatched in order, with their data
+     *  - event data too large to be copied into the queue item is rejected */
+
+    TEST_SETUP();
+
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+    loop_args.inline_data_size = sizeof(int);
+
+    isr_post_data_t data = {
+        .done = xSemaphoreCreateBinary()
+    };
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_loop_create(&loop_args, &data.loop));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_handler_register_with(data.loop, s_test_base1, TEST_EVENT_BASE1_EV1, test_event_isr_post_handler, &data));
+
+    timer_config_t config = {
+        .alarm_en = 1,
+        .auto_reload = 1,
+        .counter_dir = TIMER_COUNT_UP,
+        .divider = 80,
+        .intr_type = TIMER_INTR_LEVEL,
+        .counter_en = TIMER_PAUSE,
+    };
+    intr_handle_t intr;
+
+    TEST_ESP_OK(timer_init(TIMER_GROUP_0, TIMER_0, &config));
+    TEST_ESP_OK(timer_set_counter_value(TIMER_GROUP_0, TIMER_0, 0));
+    TEST_ESP_OK(timer_set_alarm_value(TIMER_GROUP_0, TIMER_0, 1000));
+    TEST_ESP_OK(timer_enable_intr(TIMER_GROUP_0, TIMER_0));
+    TEST_ESP_OK(timer_isr_register(TIMER_GROUP_0, TIMER_0, test_event_on_timer_alarm, &data, TEST_ISR_FLAGS, &intr));
+    TEST_ESP_OK(timer_start(TIMER_GROUP_0, TIMER_0));
+
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(data.done, pdMS_TO_TICKS(1000)));
+
+    TEST_ESP_OK(timer_pause(TIMER_GROUP_0, TIMER_0));
+    TEST_ESP_OK(timer_disable_intr(TIMER_GROUP_0, TIMER_0));
+    TEST_ESP_OK(esp_intr_free(intr));
+
+    TEST_ASSERT_EQUAL(0, data.failed);
+    for (int i = 0; i < TEST_ISR_POSTS; i++) {
+        TEST_ASSERT_EQUAL(i + 1, data.received[i]);
+    }
+
+#ifdef CONFIG_EVENT_LOOP_PROFILING
+    esp_event_loop_stats_t loop_stats;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_loop_get_stats(data.loop, &loop_stats));
+    TEST_ASSERT_EQUAL(TEST_ISR_POSTS, loop_stats.isr_events_received);
+    TEST_ASSERT_EQUAL(0, loop_stats.isr_events_dropped);
+#endif
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_loop_delete(data.loop));
+    vSemaphoreDelete(data.done);
+
+    TEST_TEARDOWN();
+}
+#endif
+
 #ifdef CONFIG_EVENT_LOOP_PROFILING
 TEST_CASE("can dump event loop profile", "[event]")
 {
@@ -1148,6 +1418,39 @@ TEST_CASE("can dump event loop profile", "[event]")
 
     TEST_ASSERT_EQUAL(ESP_OK, esp_event_dump(stdout));
 
+    esp_event_loop_stats_t loop_stats;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_loop_get_stats(loop, &loop_stats));
+    TEST_ASSERT_EQUAL(5, loop_stats.events_received);
+    TEST_ASSERT_EQUAL(1, loop_stats.events_dropped);
+    TEST_ASSERT_EQUAL(5, loop_stats.events_dispatched);
+    TEST_ASSERT_TRUE(loop_stats.max_queue_wait_time <= loop_stats.queue_wait_time);
+
+    // Handlers are reported in the order they are dispatched
+    const int ref_invoked[6] = { 5, 3, 2, 1, 1, 1 };
+    esp_event_handler_stats_t handler_stats[6];
+    size_t handler_count = 5;
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, esp_event_loop_get_handler_stats(loop, handler_stats, &handler_count));
+    TEST_ASSERT_EQUAL(5, handler_count);
+
+    handler_count = 6;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_loop_get_handler_stats(loop, handler_stats, &handler_count));
+    TEST_ASSERT_EQUAL(6, handler_count);
+
+    for (int i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL_PTR(test_event_simple_handler, handler_stats[i].handler);
+        TEST_ASSERT_EQUAL(ref_invoked[i], handler_stats[i].invoked);
+        TEST_ASSERT_TRUE(handler_stats[i].max_time <= handler_stats[i].time);
+        TEST_ASSERT_TRUE(handler_stats[i].p50_time <= handler_stats[i].p90_time);
+        TEST_ASSERT_TRUE(handler_stats[i].p90_time <= handler_stats[i].p99_time);
+        TEST_ASSERT_TRUE(handler_stats[i].p99_time <= handler_stats[i].max_time);
+    }
+
+    TEST_ASSERT_EQUAL(ESP_EVENT_ANY_BASE, handler_stats[0].event_base);
+    TEST_ASSERT_EQUAL(s_test_base1, handler_stats[1].event_base);
+    TEST_ASSERT_EQUAL(ESP_EVENT_ANY_ID, handler_stats[1].event_id);
+    TEST_ASSERT_EQUAL(TEST_EVENT_BASE1_EV1, handler_stats[2].event_id);
+
     TEST_ASSERT_EQUAL(ESP_OK, esp_event_loop_delete(loop));
 
     vSemaphoreDelete(arg.mutex);
@@ -14,6 +14,7 @@
 
 
 #include <string.h>
+#include <sys/param.h>
 
 #include "esp_system.h"
 #include "esp_log.h"
@@ -23,6 +24,8 @@
 #include "esp_transport_tcp.h"
 #include "http_utils.h"
 #include "http_auth.h"
+#include "http_pool.h"
+#include "http_gzip.h"
 #include "sdkconfig.h"
 #include "esp_http_client.h"
 #include "errno.h"
@@ -56,6 +59,7 @@ typedef struct {
     int                 data_process;   /*!< data processed */
     int                 method;         /*!< http method */
     bool                is_chunked;
+    bool                is_gzip;        /*!< body is gzip encoded and is being decompressed */
 } esp_http_data_t;
 
 typedef struct {
@@ -118,17 +122,29 @@ struct esp_http_client {
     bool                        first_line_prepared;
     int                         header_index;
     bool                        is_async;
+    bool                        use_connection_pool;
+    bool                        transport_borrowed;     /*!< transport was taken from the pool, it isn't in transport_list */
+    http_pool_key_t             pool_key;               /*!< key of the open connection, scheme and host are owned */
+    bool                        accept_gzip;
+    http_gzip_handle_t          gzip;                   /*!< gzip decoder, allocated with the first gzip response */
+    const char                  *gzip_out;              /*!< decompressed data not yet returned by esp_http_client_read() */
+    size_t                      gzip_out_len;
+    bool                        pipelining;             /*!< stop the parser at the end of each response */
+    bool                        skip_response_body;     /*!< the response being parsed is to a HEAD request */
 };
 
 typedef struct esp_http_client esp_http_client_t;
 
 static esp_err_t _clear_connection_info(esp_http_client_handle_t client);
+static esp_transport_handle_t _create_transport(esp_http_client_handle_t client, const char *scheme);
 /**
  * Default settings
  */
 #define DEFAULT_HTTP_PORT (80)
 #define DEFAULT_HTTPS_PORT (443)
 
+#define MAX_PIPELINED_REQUESTS (8)
+
 #define ASYNC_TRANS_CONNECT_FAIL -1
 #define ASYNC_TRANS_CONNECTING 0
 #define ASYNC_TRANS_CONNECT_PASS 1
@@ -166,7 +182,7 @@ enum HttpStatus_Code
 };
 
 
-static esp_err_t esp_http_client_request_send(esp_http_client_handle_t client, int write_len);
+static esp_err_t esp_http_client_request_send(esp_http_client_handle_t client, int write_len, bool with_post_data);
 static esp_err_t esp_http_client_connect(esp_http_client_handle_t client);
 static esp_err_t esp_http_client_send_post_data(esp_http_client_handle_t client);
 
@@ -190,6 +206,7 @@ static int http_on_message_begin(http_parser *parser)
     ESP_LOGD(TAG, "on_message_begin");
 
     client->response->is_chunked = false;
+    client->response->is_gzip = false;
     client->is_chunk_complete = false;
     return 0;
 }
@@ -224,6 +241,9 @@ static int http_on_header_value(http_parser *parser, const char *at, size_t leng
     } else if (strcasecmp(client->current_header_key, "Transfer-Encoding") == 0
                && memcmp(at, "chunked", length) == 0) {
         client->response->is_chunked = true;
+    } else if (strcasecmp(client->current_header_key, "Content-Encoding") == 0
+               && length == 4 && strncasecmp(at, "gzip", length) == 0) {
+        client->response->is_gzip = client->accept_gzip;
     } else if (strcasecmp(client->current_header_key, "WWW-Authenticate") == 0) {
         http_utils_assign_string(&client->auth_header, at, length);
     }
@@ -249,30 +269,82 @@ static int http_on_headers_complete(http_parser *parser)
     client->response->data_process = 0;
     ESP_LOGD(TAG, "http_on_headers_complete, status=%d, offset=%d, nread=%d", parser->status_code, client->response->data_offset, parser->nread);
     client->state = HTTP_STATE_RES_COMPLETE_HEADER;
-    return 0;
+    client->gzip_out_len = 0;
+    if (client->response->is_gzip) {
+        if (client->gzip == NULL) {
+            client->gzip = http_gzip_init();
+        }
+        if (client->gzip) {
+            http_gzip_reset(client->gzip);
+        } else {
+            ESP_LOGE(TAG, "Memory exhausted, passing the gzip encoded body as is");
+            client->response->is_gzip = false;
+        }
+    }
+    /* A response to HEAD has no body, whatever its headers say */
+    return client->skip_response_body ? 1 : 0;
 }
 
 static int http_on_body(http_parser *parser, const char *at, size_t length)
 {
     esp_http_client_t *client = parser->data;
+    esp_http_buffer_t *res_buffer = client->response->buffer;
+    char *data;
     ESP_LOGD(TAG, "http_on_body %d", length);
-    client->response->buffer->raw_data = (char *)at;
-    if (client->response->buffer->output_ptr) {
-        memcpy(client->response->buffer->output_ptr, (char *)at, length);
-        client->response->buffer->output_ptr += length;
+
+    /* The body is decoded in place: the parser runs over the buffer the data was
+     * received in, and only the chunk framing between two parts has to be squeezed out */
+    if (res_buffer->output_ptr) {
+        data = res_buffer->output_ptr;
+        res_buffer->output_ptr += length;
+    } else if (res_buffer->raw_len == 0) {
+        data = (char *)at;
+        res_buffer->raw_data = data;
+    } else {
+        data = res_buffer->raw_data + res_buffer->raw_len;
+    }
+    if (data != at) {
+        memmove(data, at, length);
     }
 
     client->response->data_process += length;
-    client->response->buffer->raw_len += length;
-    http_dispatch_event(client, HTTP_EVENT_ON_DATA, (void *)at, length);
+    res_buffer->raw_len += length;
+    if (!client->response->is_gzip) {
+        http_dispatch_event(client, HTTP_EVENT_ON_DATA, data, length);
+    }
     return 0;
 }
 
+/* Decompresses the body collected in the response buffer, and dispatches it with HTTP_EVENT_ON_DATA */
+static esp_err_t http_client_inflate(esp_http_client_handle_t client)
+{
+    esp_http_buffer_t *res_buffer = client->response->buffer;
+    const char *in = res_buffer->raw_data;
+    size_t in_len = res_buffer->raw_len;
+    const char *out;
+    size_t out_len;
+
+    res_buffer->raw_len = 0;
+    while (in_len > 0 || http_gzip_has_output(client->gzip)) {
+        if (http_gzip_decompress(client->gzip, &in, &in_len, &out, &out_len) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        if (out_len) {
+            http_dispatch_event(client, HTTP_EVENT_ON_DATA, (void *)out, out_len);
+        }
+    }
+    return ESP_OK;
+}
+
 static int http_on_message_complete(http_parser *parser)
 {
     ESP_LOGD(TAG, "http_on_message_complete, parser=%x", (int)parser);
     esp_http_client_handle_t client = parser->data;
     client->is_chunk_complete = true;
+    if (client->pipelining) {
+        /* The next response may follow in the same buffer, let the caller handle this one first */
+        http_parser_pause(parser, 1);
+    }
     return 0;
 }
 
@@ -376,6 +448,8 @@ static esp_err_t _set_config(esp_http_client_handle_t client, const esp_http_cli
     if (config->is_async) {
         client->is_async = true;
     }
+    client->use_connection_pool = config->use_connection_pool;
+    client->accept_gzip = config->accept_gzip;
 
     return ESP_OK;
 }
@@ -443,7 +517,6 @@ esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *co
 {
 
     esp_http_client_handle_t client;
-    esp_transport_handle_t tcp;
     bool _success;
 
     _success = (
@@ -464,42 +537,24 @@ esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *co
         goto error;
     }
 
+    client->pool_key.use_global_ca_store = config->use_global_ca_store;
+    client->pool_key.cert_pem = config->use_global_ca_store ? NULL : config->cert_pem;
+    client->pool_key.client_cert_pem = config->client_cert_pem;
+    client->pool_key.client_key_pem = config->client_key_pem;
+
     _success = (
                    (client->transport_list = esp_transport_list_init()) &&
-                   (tcp = esp_transport_tcp_init()) &&
-                   (esp_transport_set_default_port(tcp, DEFAULT_HTTP_PORT) == ESP_OK) &&
-                   (esp_transport_list_add(client->transport_list, tcp, "http") == ESP_OK)
+                   (_create_transport(client, "http"))
                );
     if (!_success) {
         ESP_LOGE(TAG, "Error initialize transport");
         goto error;
     }
 #ifdef CONFIG_ESP_HTTP_CLIENT_ENABLE_HTTPS
-    esp_transport_handle_t ssl;
-    _success = (
-                   (ssl = esp_transport_ssl_init()) &&
-                   (esp_transport_set_default_port(ssl, DEFAULT_HTTPS_PORT) == ESP_OK) &&
-                   (esp_transport_list_add(client->transport_list, ssl, "https") == ESP_OK)
-               );
-
-    if (!_success) {
+    if (_create_transport(client, "https") == NULL) {
         ESP_LOGE(TAG, "Error initialize SSL Transport");
         goto error;
     }
-
-    if (config->use_global_ca_store == true) {
-        esp_transport_ssl_enable_global_ca_store(ssl);
-    } else if (config->cert_pem) {
-        esp_transport_ssl_set_cert_data(ssl, config->cert_pem, strlen(config->cert_pem));
-    }
-
-    if (config->client_cert_pem) {
-        esp_transport_ssl_set_client_cert_data(ssl, config->client_cert_pem, strlen(config->client_cert_pem));
-    }
-
-    if (config->client_key_pem) {
-        esp_transport_ssl_set_client_key_data(ssl, config->client_key_pem, strlen(config->client_key_pem));
-    }
 #endif
 
     if (_set_config(client, config) != ESP_OK) {
@@ -542,6 +597,11 @@ esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *co
         goto error;
     }
 
+    if (client->accept_gzip && esp_http_client_set_header(client, "Accept-Encoding", "gzip") != ESP_OK) {
+        ESP_LOGE(TAG, "Error while setting default configurations");
+        goto error;
+    }
+
     client->parser_settings->on_message_begin = http_on_message_begin;
     client->parser_settings->on_url = http_on_url;
     client->parser_settings->on_status = http_on_status;
@@ -561,6 +621,50 @@ error:
     return NULL;
 }
 
+/* Creates the transport for the scheme and adds it to the transport list of the client */
+static esp_transport_handle_t _create_transport(esp_http_client_handle_t client, const char *scheme)
+{
+    esp_transport_handle_t t = NULL;
+    int port = 0;
+
+    if (strcasecmp(scheme, "http") == 0) {
+        t = esp_transport_tcp_init();
+        port = DEFAULT_HTTP_PORT;
+    }
+#ifdef CONFIG_ESP_HTTP_CLIENT_ENABLE_HTTPS
+    else if (strcasecmp(scheme, "https") == 0) {
+        const http_pool_key_t *tls = &client->pool_key;
+        t = esp_transport_ssl_init();
+        port = DEFAULT_HTTPS_PORT;
+        if (t == NULL) {
+            return NULL;
+        }
+        if (tls->use_global_ca_store == true) {
+            esp_transport_ssl_enable_global_ca_store(t);
+        } else if (tls->cert_pem) {
+            esp_transport_ssl_set_cert_data(t, tls->cert_pem, strlen(tls->cert_pem));
+        }
+
+        if (tls->client_cert_pem) {
+            esp_transport_ssl_set_client_cert_data(t, tls->client_cert_pem, strlen(tls->client_cert_pem));
+        }
+
+        if (tls->client_key_pem) {
+            esp_transport_ssl_set_client_key_data(t, tls->client_key_pem, strlen(tls->client_key_pem));
+        }
+    }
+#endif
+    if (t == NULL) {
+        return NULL;
+    }
+    if (esp_transport_set_default_port(t, port) != ESP_OK ||
+            esp_transport_list_add(client->transport_list, t, scheme) != ESP_OK) {
+        esp_transport_destroy(t);
+        return NULL;
+    }
+    return t;
+}
+
 esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
 {
     if (client == NULL) {
@@ -585,6 +689,9 @@ esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
     free(client->current_header_key);
     free(client->location);
     free(client->auth_header);
+    free((char *)client->pool_key.scheme);
+    free((char *)client->pool_key.host);
+    http_gzip_cleanup(client->gzip);
     free(client);
     return ESP_OK;
 }
@@ -644,7 +751,6 @@ static esp_err_t esp_http_check_response(esp_http_client_handle_t client)
 
 esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char *url)
 {
-    char *old_host = NULL;
     struct http_parser_url purl;
     int old_port;
 
@@ -661,21 +767,25 @@ esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char *u
         ESP_LOGE(TAG, "Error parse url %s", url);
         return ESP_ERR_INVALID_ARG;
     }
-    old_host = client->connection_info.host;
     old_port = client->connection_info.port;
 
     if (purl.field_data[UF_HOST].len) {
-        http_utils_assign_string(&client->connection_info.host, url + purl.field_data[UF_HOST].off, purl.field_data[UF_HOST].len);
+        const char *host = url + purl.field_data[UF_HOST].off;
+        size_t host_len = purl.field_data[UF_HOST].len;
+        /* Compare before assigning, the old string may be reallocated in place */
+        bool host_changed = client->connection_info.host
+                            && (strlen(client->connection_info.host) != host_len
+                                || strncasecmp(client->connection_info.host, host, host_len) != 0);
+        http_utils_assign_string(&client->connection_info.host, host, host_len);
         HTTP_MEM_CHECK(TAG, client->connection_info.host, return ESP_ERR_NO_MEM);
-    }
-    // Close the connection if host was changed
-    if (old_host && client->connection_info.host
-            && strcasecmp(old_host, (const void *)client->connection_info.host) != 0) {
-        ESP_LOGD(TAG, "New host assign = %s", client->connection_info.host);
-        if (esp_http_client_set_header(client, "Host", client->connection_info.host) != ESP_OK) {
-            return ESP_ERR_NO_MEM;
+        // Close the connection if host was changed
+        if (host_changed) {
+            ESP_LOGD(TAG, "New host assign = %s", client->connection_info.host);
+            if (esp_http_client_set_header(client, "Host", client->connection_info.host) != ESP_OK) {
+                return ESP_ERR_NO_MEM;
+            }
+            esp_http_client_close(client);
         }
-        esp_http_client_close(client);
     }
 
     if (purl.field_data[UF_SCHEMA].len) {
@@ -764,15 +874,69 @@ static int esp_http_client_get_data(esp_http_client_handle_t client)
 
     int rlen = esp_transport_read(client->transport, res_buffer->data, client->buffer_size, client->timeout_ms);
     if (rlen >= 0) {
+        res_buffer->raw_len = 0;
         http_parser_execute(client->parser, client->parser_settings, res_buffer->data, rlen);
+        if (client->response->is_gzip && http_client_inflate(client) != ESP_OK) {
+            return ESP_FAIL;
+        }
     }
     return rlen;
 }
 
+static bool http_client_is_body_remaining(esp_http_client_handle_t client)
+{
+    if (client->response->is_chunked) {
+        return !client->is_chunk_complete;
+    }
+    return client->response->data_process < client->response->content_length;
+}
+
+static int http_client_read_gzip(esp_http_client_handle_t client, char *buffer, int len)
+{
+    esp_http_buffer_t *res_buffer = client->response->buffer;
+    int ridx = 0;
+
+    while (ridx < len) {
+        if (client->gzip_out_len) {
+            int copy_len = MIN(len - ridx, client->gzip_out_len);
+            memcpy(buffer + ridx, client->gzip_out, copy_len);
+            client->gzip_out += copy_len;
+            client->gzip_out_len -= copy_len;
+            ridx += copy_len;
+        } else if (res_buffer->raw_len || http_gzip_has_output(client->gzip)) {
+            const char *in = res_buffer->raw_data;
+            size_t in_len = res_buffer->raw_len;
+            if (http_gzip_decompress(client->gzip, &in, &in_len, &client->gzip_out, &client->gzip_out_len) != ESP_OK) {
+                res_buffer->raw_len = 0;
+                return ridx ? ridx : ESP_FAIL;
+            }
+            res_buffer->raw_data = (char *)in;
+            res_buffer->raw_len = in_len;
+            if (client->gzip_out_len) {
+                http_dispatch_event(client, HTTP_EVENT_ON_DATA, (void *)client->gzip_out, client->gzip_out_len);
+            }
+        } else if (http_client_is_body_remaining(client)) {
+            int rlen = esp_transport_read(client->transport, res_buffer->data, client->buffer_size, client->timeout_ms);
+            ESP_LOGD(TAG, "need_read=%d, rlen=%d", len - ridx, rlen);
+            if (rlen <= 0) {
+                break;
+            }
+            http_parser_execute(client->parser, client->parser_settings, res_buffer->data, rlen);
+        } else {
+            break;
+        }
+    }
+    return ridx;
+}
+
 int esp_http_client_read(esp_http_client_handle_t client, char *buffer, int len)
 {
     esp_http_buffer_t *res_buffer = client->response->buffer;
 
+    if (client->response->is_gzip) {
+        return http_client_read_gzip(client, buffer, len);
+    }
+
     int rlen = ESP_FAIL, ridx = 0;
     if (res_buffer->raw_len) {
         int remain_len = client->response->buffer->raw_len;
@@ -787,27 +951,25 @@ int esp_http_client_read(esp_http_client_handle_t client, char *buffer, int len)
     int need_read = len - ridx;
     bool is_data_remain = true;
     while (need_read > 0 && is_data_remain) {
-        if (client->response->is_chunked) {
-            is_data_remain = !client->is_chunk_complete;
-        } else {
-            is_data_remain = client->response->data_process < client->response->content_length;
-        }
+        is_data_remain = http_client_is_body_remaining(client);
         ESP_LOGD(TAG, "is_data_remain=%d, is_chunked=%d", is_data_remain, client->response->is_chunked);
         if (!is_data_remain) {
             break;
         }
         int byte_to_read = need_read;
-        if (byte_to_read > client->buffer_size) {
-            byte_to_read = client->buffer_size;
+        if (!client->response->is_chunked
+                && byte_to_read > client->response->content_length - client->response->data_process) {
+            byte_to_read = client->response->content_length - client->response->data_process;
         }
-        rlen = esp_transport_read(client->transport, res_buffer->data, byte_to_read, client->timeout_ms);
+        /* Receive straight into the caller's buffer, the body is then decoded in place */
+        rlen = esp_transport_read(client->transport, buffer + ridx, byte_to_read, client->timeout_ms);
         ESP_LOGD(TAG, "need_read=%d, byte_to_read=%d, rlen=%d, ridx=%d", need_read, byte_to_read, rlen, ridx);
 
         if (rlen <= 0) {
             return ridx;
         }
         res_buffer->output_ptr = buffer + ridx;
-        http_parser_execute(client->parser, client->parser_settings, res_buffer->data, rlen);
+        http_parser_execute(client->parser, client->parser_settings, buffer + ridx, rlen);
         ridx += res_buffer->raw_len;
         need_read -= res_buffer->raw_len;
 
@@ -839,7 +1001,7 @@ esp_err_t esp_http_client_perform(esp_http_client_handle_t client)
                 }
                 /* falls through */
             case HTTP_STATE_CONNECTED:
-                if ((err = esp_http_client_request_send(client, client->post_len)) != ESP_OK) {
+                if ((err = esp_http_client_request_send(client, client->post_len, true)) != ESP_OK) {
                     if (client->is_async && errno == EAGAIN) {
                         return ESP_ERR_HTTP_EAGAIN;
                     }
@@ -867,6 +1029,10 @@ esp_err_t esp_http_client_perform(esp_http_client_handle_t client)
                     ESP_LOGE(TAG, "Error response");
                     return err;
                 }
+                /* Part of the body may have arrived with the headers */
+                if (client->response->is_gzip && http_client_inflate(client) != ESP_OK) {
+                    return ESP_FAIL;
+                }
                 while (client->response->is_chunked && !client->is_chunk_complete) {
                     if (esp_http_client_get_data(client) <= 0) {
                         if (client->is_async && errno == EAGAIN) {
@@ -904,6 +1070,132 @@ esp_err_t esp_http_client_perform(esp_http_client_handle_t client)
     return ESP_OK;
 }
 
+/* Sends a request of a batch, with the first line and body of the request in place of the client's ones */
+static esp_err_t http_client_batch_send(esp_http_client_handle_t client, const esp_http_client_batch_request_t *request)
+{
+    esp_http_client_method_t method = client->connection_info.method;
+    char *path = client->connection_info.path;
+    char *query = client->connection_info.query;
+    char *post_data = client->post_data;
+    int post_len = client->post_len;
+    esp_err_t err;
+
+    client->connection_info.method = request->method;
+    client->connection_info.path = (char *)request->path;
+    client->connection_info.query = NULL;
+    client->post_data = (char *)request->data;
+    client->post_len = request->data ? request->data_len : 0;
+    client->first_line_prepared = false;
+
+    err = esp_http_client_request_send(client, client->post_len, true);
+    if (err == ESP_OK) {
+        err = esp_http_client_send_post_data(client);
+    }
+
+    client->connection_info.method = method;
+    client->connection_info.path = path;
+    client->connection_info.query = query;
+    client->post_data = post_data;
+    client->post_len = post_len;
+    client->first_line_prepared = false;
+    return err == ESP_OK ? ESP_OK : ESP_ERR_HTTP_WRITE_DATA;
+}
+
+/* Receives the next response of a batch. Data following it is left in *pending */
+static esp_err_t http_client_batch_receive(esp_http_client_handle_t client, bool is_head, const char **pending, int *pending_len)
+{
+    esp_http_buffer_t *res_buffer = client->response->buffer;
+
+    client->state = HTTP_STATE_REQ_COMPLETE_DATA;
+    client->response->status_code = -1;
+    client->is_chunk_complete = false;
+    client->skip_response_body = is_head;
+    while (!client->is_chunk_complete) {
+        if (*pending_len == 0) {
+            int rlen = esp_transport_read(client->transport, res_buffer->data, client->buffer_size, client->timeout_ms);
+            if (rlen <= 0) {
+                ESP_LOGE(TAG, "Connection closed before the response was complete");
+                return ESP_FAIL;
+            }
+            *pending = res_buffer->data;
+            *pending_len = rlen;
+        }
+        res_buffer->raw_len = 0;
+        int parsed = http_parser_execute(client->parser, client->parser_settings, *pending, *pending_len);
+        if (HTTP_PARSER_ERRNO(client->parser) == HPE_PAUSED) {
+            http_parser_pause(client->parser, 0);
+        } else if (parsed != *pending_len) {
+            ESP_LOGE(TAG, "Error parsing the response: %s", http_errno_description(HTTP_PARSER_ERRNO(client->parser)));
+            return ESP_FAIL;
+        }
+        *pending += parsed;
+        *pending_len -= parsed;
+        if (client->response->is_gzip && http_client_inflate(client) != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_perform_batch(esp_http_client_handle_t client, esp_http_client_batch_request_t *requests, int count)
+{
+    const char *pending = NULL;
+    int pending_len = 0;
+    int sent = 0, received = 0;
+    esp_err_t err = ESP_OK;
+
+    if (client == NULL || (requests == NULL && count) || client->is_async) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < count; i++) {
+        requests[i].status_code = -1;
+    }
+    if ((err = esp_http_client_connect(client)) != ESP_OK) {
+        return err;
+    }
+
+    client->pipelining = true;
+    while (received < count) {
+        /* Keep a few requests in flight, without filling the buffers of both sides while nobody reads */
+        while (sent < count && sent - received < MAX_PIPELINED_REQUESTS) {
+            if ((err = http_client_batch_send(client, &requests[sent])) != ESP_OK) {
+                goto exit;
+            }
+            sent++;
+        }
+        if (http_client_batch_receive(client, requests[received].method == HTTP_METHOD_HEAD, &pending, &pending_len) != ESP_OK) {
+            err = ESP_ERR_HTTP_FETCH_HEADER;
+            goto exit;
+        }
+        requests[received].status_code = client->response->status_code;
+        http_dispatch_event(client, HTTP_EVENT_ON_FINISH, NULL, 0);
+        received++;
+
+        if (!http_should_keep_alive(client->parser)) {
+            /* The server doesn't process the requests following the one it closes the connection on */
+            ESP_LOGD(TAG, "Server closed the connection after %d responses", received);
+            esp_http_client_close(client);
+            if (received < count) {
+                pending_len = 0;
+                sent = received;
+                if ((err = esp_http_client_connect(client)) != ESP_OK) {
+                    goto exit;
+                }
+            }
+        }
+    }
+
+exit:
+    client->pipelining = false;
+    client->skip_response_body = false;
+    if (err != ESP_OK) {
+        esp_http_client_close(client);
+    } else if (client->state > HTTP_STATE_CONNECTED) {
+        client->state = HTTP_STATE_CONNECTED;
+    }
+    return err;
+}
+
 int esp_http_client_fetch_headers(esp_http_client_handle_t client)
 {
     if (client->state < HTTP_STATE_REQ_COMPLETE_HEADER) {
@@ -913,6 +1205,7 @@ int esp_http_client_fetch_headers(esp_http_client_handle_t client)
     client->state = HTTP_STATE_REQ_COMPLETE_DATA;
     esp_http_buffer_t *buffer = client->response->buffer;
     client->response->status_code = -1;
+    buffer->raw_len = 0;
 
     while (client->state < HTTP_STATE_RES_COMPLETE_HEADER) {
         buffer->len = esp_transport_read(client->transport, buffer->data, client->buffer_size, client->timeout_ms);
@@ -929,6 +1222,21 @@ int esp_http_client_fetch_headers(esp_http_client_handle_t client)
     return client->response->content_length;
 }
 
+static esp_err_t http_client_set_pool_key(esp_http_client_handle_t client)
+{
+    char *scheme = (char *)client->pool_key.scheme;
+    char *host = (char *)client->pool_key.host;
+
+    http_utils_assign_string(&scheme, client->connection_info.scheme, 0);
+    client->pool_key.scheme = scheme;
+    HTTP_MEM_CHECK(TAG, scheme, return ESP_ERR_NO_MEM);
+    http_utils_assign_string(&host, client->connection_info.host, 0);
+    client->pool_key.host = host;
+    HTTP_MEM_CHECK(TAG, host, return ESP_ERR_NO_MEM);
+    client->pool_key.port = client->connection_info.port;
+    return ESP_OK;
+}
+
 static esp_err_t esp_http_client_connect(esp_http_client_handle_t client)
 {
     esp_err_t err;
@@ -946,7 +1254,25 @@ static esp_err_t esp_http_client_connect(esp_http_client_handle_t client)
 
     if (client->state < HTTP_STATE_CONNECTED) {
         ESP_LOGD(TAG, "Begin connect to: %s://%s:%d", client->connection_info.scheme, client->connection_info.host, client->connection_info.port);
+        if (http_client_set_pool_key(client) != ESP_OK) {
+            return ESP_ERR_NO_MEM;
+        }
+        if (client->use_connection_pool && !client->is_async) {
+            esp_transport_handle_t t = http_pool_take(&client->pool_key);
+            if (t) {
+                ESP_LOGD(TAG, "Reuse pooled connection");
+                client->transport = t;
+                client->transport_borrowed = true;
+                client->state = HTTP_STATE_CONNECTED;
+                http_dispatch_event(client, HTTP_EVENT_ON_CONNECTED, NULL, 0);
+                return ESP_OK;
+            }
+        }
         client->transport = esp_transport_list_get_transport(client->transport_list, client->connection_info.scheme);
+        if (client->transport == NULL) {
+            /* The transport was given to the connection pool */
+            client->transport = _create_transport(client, client->connection_info.scheme);
+        }
         if (client->transport == NULL) {
             ESP_LOGE(TAG, "No transport found");
 #ifndef CONFIG_ESP_HTTP_CLIENT_ENABLE_HTTPS
@@ -1019,7 +1345,7 @@ static int http_client_prepare_first_line(esp_http_client_handle_t client, int w
     return first_line_len;
 }
 
-static esp_err_t esp_http_client_request_send(esp_http_client_handle_t client, int write_len)
+static esp_err_t esp_http_client_request_send(esp_http_client_handle_t client, int write_len, bool with_post_data)
 {
     int first_line_len = 0;
     if (!client->first_line_prepared) {
@@ -1047,6 +1373,7 @@ static esp_err_t esp_http_client_request_send(esp_http_client_handle_t client, i
         }
     }
 
+    int post_sent = 0;
     int wlen = client->buffer_size - first_line_len;
     while ((client->header_index = http_header_generate_string(client->request->headers, client->header_index, client->request->buffer->data + first_line_len, &wlen))) {
         if (wlen <= 0) {
@@ -1059,23 +1386,41 @@ static esp_err_t esp_http_client_request_send(esp_http_client_handle_t client, i
         client->request->buffer->data[wlen] = 0;
         ESP_LOGD(TAG, "Write header[%d]: %s", client->header_index, client->request->buffer->data);
 
+        /* The last chunk ends with the blank line, the body can go out in the same segment */
+        bool is_last = wlen >= 4 && memcmp(client->request->buffer->data + wlen - 4, "\r\n\r\n", 4) == 0;
+        bool send_body = with_post_data && is_last && !client->is_async && client->post_data && client->post_len > 0;
+
         client->data_write_left = wlen;
         client->data_written_index = 0;
         while (client->data_write_left > 0) {
-            int wret = esp_transport_write(client->transport, client->request->buffer->data + client->data_written_index, client->data_write_left, client->timeout_ms);
+            int wret;
+            if (send_body) {
+                esp_transport_iovec_t iov[2] = {
+                    { .buffer = client->request->buffer->data + client->data_written_index, .len = client->data_write_left },
+                    { .buffer = client->post_data, .len = client->post_len },
+                };
+                wret = esp_transport_writev(client->transport, iov, 2, client->timeout_ms);
+            } else {
+                wret = esp_transport_write(client->transport, client->request->buffer->data + client->data_written_index, client->data_write_left, client->timeout_ms);
+            }
             if (wret <= 0) {
                 ESP_LOGE(TAG, "Error write request");
                 esp_http_client_close(client);
                 return ESP_ERR_HTTP_WRITE_DATA;
             }
+            if (wret > client->data_write_left) {
+                post_sent = wret - client->data_write_left;
+                wret = client->data_write_left;
+            }
             client->data_write_left -= wret;
             client->data_written_index += wret;
         }
         wlen = client->buffer_size;
     }
 
-    client->data_written_index = 0;
-    client->data_write_left = client->post_len;
+    /* esp_http_client_send_post_data() writes what is left of the body */
+    client->data_written_index = post_sent;
+    client->data_write_left = client->post_len - post_sent;
     http_dispatch_event(client, HTTP_EVENT_HEADER_SENT, NULL, 0);
     client->state = HTTP_STATE_REQ_COMPLETE_HEADER;
     return ESP_OK;
@@ -1116,7 +1461,7 @@ esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len)
     if ((err = esp_http_client_connect(client)) != ESP_OK) {
         return err;
     }
-    if ((err = esp_http_client_request_send(client, write_len)) != ESP_OK) {
+    if ((err = esp_http_client_request_send(client, write_len, false)) != ESP_OK) {
         return err; 
     }
     return ESP_OK;
@@ -1142,16 +1487,50 @@ int esp_http_client_write(esp_http_client_handle_t client, const char *buffer, i
     return widx;
 }
 
+/* Whether the connection is idle and may be used by another request */
+static bool http_client_is_reusable(esp_http_client_handle_t client)
+{
+    if (client->state == HTTP_STATE_CONNECTED) {
+        return !client->first_line_prepared;
+    }
+    return client->state >= HTTP_STATE_RES_COMPLETE_HEADER && client->is_chunk_complete
+           && http_should_keep_alive(client->parser);
+}
+
 esp_err_t esp_http_client_close(esp_http_client_handle_t client)
 {
     if (client->state >= HTTP_STATE_INIT) {
+        bool reuse = client->use_connection_pool && !client->is_async && http_client_is_reusable(client);
         http_dispatch_event(client, HTTP_EVENT_DISCONNECTED, NULL, 0);
         client->state = HTTP_STATE_INIT;
-        return esp_transport_close(client->transport);
+        esp_transport_handle_t t = client->transport;
+        if (reuse) {
+            ESP_LOGD(TAG, "Keep connection to %s:%d in the pool", client->pool_key.host, client->pool_key.port);
+            if (!client->transport_borrowed) {
+                esp_transport_list_remove(client->transport_list, t);
+            }
+            client->transport = NULL;
+            client->transport_borrowed = false;
+            http_pool_put(&client->pool_key, t);
+            return ESP_OK;
+        }
+        int ret = esp_transport_close(t);
+        if (client->transport_borrowed) {
+            esp_transport_destroy(t);
+            client->transport = NULL;
+            client->transport_borrowed = false;
+        }
+        return ret;
     }
     return ESP_OK;
 }
 
+esp_err_t esp_http_client_flush_connection_pool(void)
+{
+    http_pool_flush();
+    return ESP_OK;
+}
+
 esp_err_t esp_http_client_set_post_field(esp_http_client_handle_t client, const char *data, int len)
 {
     esp_err_t err = ESP_OK;
@@ -118,8 +118,24 @@ typedef struct {
     void                        *user_data;               /*!< HTTP user_data context */
     bool                        is_async;                 /*!< Set asynchronous mode, only supported with HTTPS for now */
     bool                        use_global_ca_store;      /*!< Use a global ca_store for all the connections in which this bool is set. */
+    bool                        use_connection_pool;      /*!< Share keep-alive connections with other clients through the connection pool, not supported in asynchronous mode.
+                                                               Connections to HTTPS servers are only shared between clients with the same cert_pem, client_cert_pem and client_key_pem pointers. */
+    bool                        accept_gzip;              /*!< Send "Accept-Encoding: gzip" and decompress gzip encoded response bodies. The data passed with HTTP_EVENT_ON_DATA
+                                                               and returned by esp_http_client_read() is then decompressed, while the content length is the one of the encoded body.
+                                                               Decompressing a response needs about 45KB of heap */
 } esp_http_client_config_t;
 
+/**
+ * @brief One request of esp_http_client_perform_batch()
+ */
+typedef struct {
+    esp_http_client_method_t    method;                   /*!< HTTP Method */
+    const char                  *path;                    /*!< HTTP Path, including the query if any, e.g. "/api/data?id=1" */
+    const char                  *data;                    /*!< Request body, NULL if there is none */
+    int                         data_len;                 /*!< Length of the request body */
+    int                         status_code;              /*!< [out] Status code of the response, -1 if no response was received */
+} esp_http_client_batch_request_t;
+
 
 #define ESP_ERR_HTTP_BASE               (0x7000)                    /*!< Starting number of HTTP error codes */
 #define ESP_ERR_HTTP_MAX_REDIRECT       (ESP_ERR_HTTP_BASE + 1)     /*!< The error exceeds the number of HTTP redirects */
@@ -169,6 +185,32 @@ esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *co
  */
 esp_err_t esp_http_client_perform(esp_http_client_handle_t client);
 
+/**
+ * @brief      Perform several requests to the server of the client URL on one keep-alive connection, using HTTP pipelining.
+ *             The requests are sent back to back, without waiting for the previous responses, and the responses are
+ *             received in order. Each response is passed with the usual HTTP_EVENT_ON_HEADER and HTTP_EVENT_ON_DATA events,
+ *             followed by HTTP_EVENT_ON_FINISH, and its status code is stored in the request.
+ *
+ *             All the requests are sent with the headers of the client (see esp_http_client_set_header()) and a Content-Length,
+ *             redirections and authentication challenges are not followed.
+ *             If the server closes the connection after a response, the requests it didn't answer are sent again
+ *             on a new connection.
+ *
+ * @note       Not supported in asynchronous mode. Servers may process pipelined requests in parallel; only
+ *             batch requests which do not depend on each other.
+ *
+ * @param[in]     client    The esp_http_client handle
+ * @param[inout]  requests  The requests
+ * @param[in]     count     Number of requests
+ *
+ * @return
+ *  - ESP_OK if a response was received for every request
+ *  - ESP_ERR_INVALID_ARG if the arguments are invalid or the client is asynchronous
+ *  - ESP_ERR_HTTP_CONNECT, ESP_ERR_HTTP_WRITE_DATA or ESP_ERR_HTTP_FETCH_HEADER if the connection failed; requests
+ *    which got no response have a status code of -1
+ */
+esp_err_t esp_http_client_perform_batch(esp_http_client_handle_t client, esp_http_client_batch_request_t *requests, int count);
+
 /**
  * @brief      Set URL for client, when performing this behavior, the options in the URL will replace the old ones
  *
@@ -307,6 +349,10 @@ bool esp_http_client_is_chunked_response(esp_http_client_handle_t client);
 /**
  * @brief      Read data from http stream
  *
+ * @note       The data is received directly into `buffer` and the chunked encoding, if any, is
+ *             removed in place, so reading with a large buffer saves copying the body through the
+ *             internal buffer. Gzip encoded bodies (see `accept_gzip`) still go through it.
+ *
  * @param[in]  client  The esp_http_client handle
  * @param      buffer  The buffer
  * @param[in]  len     The length
@@ -350,6 +396,17 @@ int esp_http_client_get_content_length(esp_http_client_handle_t client);
  */
 esp_err_t esp_http_client_close(esp_http_client_handle_t client);
 
+/**
+ * @brief      Close all idle connections kept in the connection pool
+ *
+ * @note       Connections are pooled by clients with `use_connection_pool` set, when they are
+ *             closed or cleaned up after a complete keep-alive response.
+ *
+ * @return
+ *     - ESP_OK
+ */
+esp_err_t esp_http_client_flush_connection_pool(void);
+
 /**
  * @brief      This function must be the last function to call for an session.
  *             It is the opposite of the esp_http_client_init function and must be called with the same handle as input that a esp_http_client_init call returned.
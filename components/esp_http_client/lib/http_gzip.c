@@ -0,0 +1,201 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "esp32/rom/miniz.h"
+#include "esp_log.h"
+#include "http_gzip.h"
+
+static const char *TAG = "HTTP_GZIP";
+
+/* RFC 1952 header flags */
+#define GZIP_FHCRC      0x02
+#define GZIP_FEXTRA     0x04
+#define GZIP_FNAME      0x08
+#define GZIP_FCOMMENT   0x10
+
+#define GZIP_FIXED_HEADER_LEN   10
+
+typedef enum {
+    GZIP_STATE_HEADER = 0,      /*!< Fixed part of the header */
+    GZIP_STATE_EXTRA_LEN,
+    GZIP_STATE_EXTRA,
+    GZIP_STATE_NAME,
+    GZIP_STATE_COMMENT,
+    GZIP_STATE_HCRC,
+    GZIP_STATE_DEFLATE,
+    GZIP_STATE_TRAILER,         /*!< CRC32 and size of the data, not checked */
+} gzip_state_t;
+
+struct http_gzip {
+    tinfl_decompressor  inflator;
+    uint8_t             *window;        /*!< Output buffer, also used as the deflate dictionary */
+    size_t              window_ofs;     /*!< Where the next output is written to */
+    gzip_state_t        state;
+    uint8_t             flags;          /*!< Header fields still to be skipped */
+    uint8_t             extra_len;      /*!< Low byte of the extra field length */
+    size_t              count;          /*!< Bytes left (or consumed, for the fixed header) in the current field */
+    bool                has_output;
+};
+
+http_gzip_handle_t http_gzip_init(void)
+{
+    http_gzip_handle_t gz = calloc(1, sizeof(struct http_gzip));
+    if (gz == NULL) {
+        return NULL;
+    }
+    gz->window = malloc(TINFL_LZ_DICT_SIZE);
+    if (gz->window == NULL) {
+        free(gz);
+        return NULL;
+    }
+    http_gzip_reset(gz);
+    return gz;
+}
+
+void http_gzip_reset(http_gzip_handle_t gz)
+{
+    tinfl_init(&gz->inflator);
+    gz->window_ofs = 0;
+    gz->state = GZIP_STATE_HEADER;
+    gz->flags = 0;
+    gz->extra_len = 0;
+    gz->count = 0;
+    gz->has_output = false;
+}
+
+/* State following the current header field, depending on the remaining flags */
+static gzip_state_t http_gzip_next_field(http_gzip_handle_t gz)
+{
+    if (gz->flags & GZIP_FEXTRA) {
+        gz->flags &= ~GZIP_FEXTRA;
+        gz->count = 0;
+        return GZIP_STATE_EXTRA_LEN;
+    }
+    if (gz->flags & GZIP_FNAME) {
+        gz->flags &= ~GZIP_FNAME;
+        return GZIP_STATE_NAME;
+    }
+    if (gz->flags & GZIP_FCOMMENT) {
+        gz->flags &= ~GZIP_FCOMMENT;
+        return GZIP_STATE_COMMENT;
+    }
+    if (gz->flags & GZIP_FHCRC) {
+        gz->flags &= ~GZIP_FHCRC;
+        gz->count = 2;
+        return GZIP_STATE_HCRC;
+    }
+    return GZIP_STATE_DEFLATE;
+}
+
+static esp_err_t http_gzip_parse_header(http_gzip_handle_t gz, const char **in, size_t *in_len)
+{
+    while (*in_len && gz->state < GZIP_STATE_DEFLATE) {
+        uint8_t c = (uint8_t)**in;
+        (*in)++;
+        (*in_len)--;
+        switch (gz->state) {
+            case GZIP_STATE_HEADER:
+                if ((gz->count == 0 && c != 0x1f) || (gz->count == 1 && c != 0x8b) || (gz->count == 2 && c != 8)) {
+                    ESP_LOGE(TAG, "Not a gzip stream");
+                    return ESP_FAIL;
+                }
+                if (gz->count == 3) {
+                    gz->flags = c;
+                }
+                if (++gz->count == GZIP_FIXED_HEADER_LEN) {
+                    gz->state = http_gzip_next_field(gz);
+                }
+                break;
+            case GZIP_STATE_EXTRA_LEN:
+                /* Little endian length, the low byte comes first */
+                if (gz->count == 0) {
+                    gz->extra_len = c;
+                    gz->count = 1;
+                } else {
+                    gz->count = gz->extra_len | (c << 8);
+                    gz->state = gz->count ? GZIP_STATE_EXTRA : http_gzip_next_field(gz);
+                }
+                break;
+            case GZIP_STATE_EXTRA:
+            case GZIP_STATE_HCRC:
+                if (--gz->count == 0) {
+                    gz->state = http_gzip_next_field(gz);
+                }
+                break;
+            case GZIP_STATE_NAME:
+            case GZIP_STATE_COMMENT:
+                if (c == 0) {
+                    gz->state = http_gzip_next_field(gz);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t http_gzip_decompress(http_gzip_handle_t gz, const char **in, size_t *in_len, const char **out, size_t *out_len)
+{
+    *out = NULL;
+    *out_len = 0;
+    if (gz->state < GZIP_STATE_DEFLATE && http_gzip_parse_header(gz, in, in_len) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    if (gz->state == GZIP_STATE_TRAILER) {
+        *in += *in_len;
+        *in_len = 0;
+        return ESP_OK;
+    }
+    if (gz->state != GZIP_STATE_DEFLATE || (*in_len == 0 && !gz->has_output)) {
+        return ESP_OK;
+    }
+
+    size_t in_size = *in_len;
+    size_t out_size = TINFL_LZ_DICT_SIZE - gz->window_ofs;
+    tinfl_status status = tinfl_decompress(&gz->inflator, (const mz_uint8 *)*in, &in_size,
+                                           gz->window, gz->window + gz->window_ofs, &out_size,
+                                           TINFL_FLAG_HAS_MORE_INPUT);
+    if (status < TINFL_STATUS_DONE) {
+        ESP_LOGE(TAG, "tinfl_decompress failed (%d)", status);
+        return ESP_FAIL;
+    }
+    *in += in_size;
+    *in_len -= in_size;
+    *out = (const char *)gz->window + gz->window_ofs;
+    *out_len = out_size;
+    gz->window_ofs = (gz->window_ofs + out_size) & (TINFL_LZ_DICT_SIZE - 1);
+    gz->has_output = (status == TINFL_STATUS_HAS_MORE_OUTPUT);
+    if (status == TINFL_STATUS_DONE) {
+        gz->state = GZIP_STATE_TRAILER;
+    }
+    return ESP_OK;
+}
+
+bool http_gzip_has_output(http_gzip_handle_t gz)
+{
+    return gz->has_output;
+}
+
+void http_gzip_cleanup(http_gzip_handle_t gz)
+{
+    if (gz) {
+        free(gz->window);
+        free(gz);
+    }
+}
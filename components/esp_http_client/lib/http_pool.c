@@ -0,0 +1,195 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/lock.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#include "http_pool.h"
+
+#define HTTP_POOL_SIZE          CONFIG_ESP_HTTP_CLIENT_POOL_SIZE
+#define HTTP_POOL_IDLE_TIMEOUT  ((int64_t)CONFIG_ESP_HTTP_CLIENT_POOL_IDLE_TIMEOUT * 1000000)
+
+typedef struct {
+    esp_transport_handle_t  transport;      /*!< Idle connection, NULL if the entry is unused */
+    char                    *scheme;
+    char                    *host;
+    int                     port;
+    const char              *cert_pem;
+    const char              *client_cert_pem;
+    const char              *client_key_pem;
+    bool                    use_global_ca_store;
+    int64_t                 last_used;      /*!< Time the connection was put into the pool */
+} http_pool_entry_t;
+
+#if HTTP_POOL_SIZE > 0
+static const char *TAG = "HTTP_POOL";
+static http_pool_entry_t s_pool[HTTP_POOL_SIZE];
+static _lock_t s_pool_lock;
+
+static bool http_pool_match(const http_pool_entry_t *entry, const http_pool_key_t *key)
+{
+    return entry->port == key->port
+           && entry->cert_pem == key->cert_pem
+           && entry->client_cert_pem == key->client_cert_pem
+           && entry->client_key_pem == key->client_key_pem
+           && entry->use_global_ca_store == key->use_global_ca_store
+           && strcasecmp(entry->scheme, key->scheme) == 0
+           && strcasecmp(entry->host, key->host) == 0;
+}
+
+/* Clears the entry and returns its transport, must be called with the lock held */
+static esp_transport_handle_t http_pool_detach(http_pool_entry_t *entry)
+{
+    esp_transport_handle_t t = entry->transport;
+    free(entry->scheme);
+    free(entry->host);
+    memset(entry, 0, sizeof(http_pool_entry_t));
+    return t;
+}
+
+/* Detaches the expired connections into expired[], must be called with the lock held */
+static int http_pool_detach_expired(esp_transport_handle_t *expired, int64_t now)
+{
+    int count = 0;
+    for (int i = 0; i < HTTP_POOL_SIZE; i++) {
+        if (s_pool[i].transport && now - s_pool[i].last_used > HTTP_POOL_IDLE_TIMEOUT) {
+            ESP_LOGD(TAG, "Idle connection to %s:%d expired", s_pool[i].host, s_pool[i].port);
+            expired[count++] = http_pool_detach(&s_pool[i]);
+        }
+    }
+    return count;
+}
+
+static void http_pool_destroy(esp_transport_handle_t *list, int count)
+{
+    for (int i = 0; i < count; i++) {
+        esp_transport_close(list[i]);
+        esp_transport_destroy(list[i]);
+    }
+}
+
+esp_transport_handle_t http_pool_take(const http_pool_key_t *key)
+{
+    esp_transport_handle_t expired[HTTP_POOL_SIZE];
+    esp_transport_handle_t t;
+    int count;
+
+    do {
+        http_pool_entry_t *found = NULL;
+        t = NULL;
+
+        _lock_acquire(&s_pool_lock);
+        count = http_pool_detach_expired(expired, esp_timer_get_time());
+        for (int i = 0; i < HTTP_POOL_SIZE; i++) {
+            /* Prefer the most recently used connection */
+            if (s_pool[i].transport && http_pool_match(&s_pool[i], key)
+                    && (found == NULL || s_pool[i].last_used > found->last_used)) {
+                found = &s_pool[i];
+            }
+        }
+        if (found) {
+            t = http_pool_detach(found);
+        }
+        _lock_release(&s_pool_lock);
+        http_pool_destroy(expired, count);
+
+        /* An idle connection has nothing to read, unless the server closed it */
+        if (t && esp_transport_poll_read(t, 0) != 0) {
+            ESP_LOGD(TAG, "Pooled connection to %s:%d was closed by the server", key->host, key->port);
+            http_pool_destroy(&t, 1);
+            continue;
+        }
+        return t;
+    } while (1);
+}
+
+void http_pool_put(const http_pool_key_t *key, esp_transport_handle_t t)
+{
+    esp_transport_handle_t expired[HTTP_POOL_SIZE + 1];
+    http_pool_entry_t *entry = NULL;
+    int64_t now = esp_timer_get_time();
+    int count;
+
+    _lock_acquire(&s_pool_lock);
+    count = http_pool_detach_expired(expired, now);
+    for (int i = 0; i < HTTP_POOL_SIZE; i++) {
+        if (s_pool[i].transport == NULL) {
+            entry = &s_pool[i];
+            break;
+        }
+        if (entry == NULL || s_pool[i].last_used < entry->last_used) {
+            entry = &s_pool[i];
+        }
+    }
+    if (entry->transport) {
+        ESP_LOGD(TAG, "Pool is full, closing connection to %s:%d", entry->host, entry->port);
+        expired[count++] = http_pool_detach(entry);
+    }
+    entry->scheme = strdup(key->scheme);
+    entry->host = strdup(key->host);
+    if (entry->scheme && entry->host) {
+        entry->transport = t;
+        entry->port = key->port;
+        entry->cert_pem = key->cert_pem;
+        entry->client_cert_pem = key->client_cert_pem;
+        entry->client_key_pem = key->client_key_pem;
+        entry->use_global_ca_store = key->use_global_ca_store;
+        entry->last_used = now;
+    } else {
+        ESP_LOGE(TAG, "Memory exhausted");
+        http_pool_detach(entry);
+        expired[count++] = t;
+    }
+    _lock_release(&s_pool_lock);
+    http_pool_destroy(expired, count);
+}
+
+void http_pool_flush(void)
+{
+    esp_transport_handle_t idle[HTTP_POOL_SIZE];
+    int count = 0;
+
+    _lock_acquire(&s_pool_lock);
+    for (int i = 0; i < HTTP_POOL_SIZE; i++) {
+        if (s_pool[i].transport) {
+            idle[count++] = http_pool_detach(&s_pool[i]);
+        }
+    }
+    _lock_release(&s_pool_lock);
+    http_pool_destroy(idle, count);
+}
+
+#else
+
+esp_transport_handle_t http_pool_take(const http_pool_key_t *key)
+{
+    return NULL;
+}
+
+void http_pool_put(const http_pool_key_t *key, esp_transport_handle_t t)
+{
+    esp_transport_close(t);
+    esp_transport_destroy(t);
+}
+
+void http_pool_flush(void)
+{
+}
+
+#endif
@@ -0,0 +1,82 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _HTTP_GZIP_H_
+#define _HTTP_GZIP_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct http_gzip *http_gzip_handle_t;
+
+/**
+ * @brief      Create a gzip decoder, using the inflater in ROM.
+ *             It holds the 32KB window of the deflate stream.
+ *
+ * @return     The decoder handle, or NULL if memory is exhausted
+ */
+http_gzip_handle_t http_gzip_init(void);
+
+/**
+ * @brief      Prepare the decoder for a new gzip stream
+ *
+ * @param[in]  gz    The decoder handle
+ */
+void http_gzip_reset(http_gzip_handle_t gz);
+
+/**
+ * @brief      Decompress the next part of the stream.
+ *             Consumes input from *in, advancing *in and *in_len, and returns the
+ *             decompressed data as a slice of the window, valid until the next call.
+ *             Must be called again while http_gzip_has_output() returns true, even
+ *             without new input.
+ *
+ * @param[in]     gz       The decoder handle
+ * @param[inout]  in       The compressed data
+ * @param[inout]  in_len   Length of the compressed data
+ * @param[out]    out      The decompressed data
+ * @param[out]    out_len  Length of the decompressed data, may be 0
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL if the stream is not valid gzip
+ */
+esp_err_t http_gzip_decompress(http_gzip_handle_t gz, const char **in, size_t *in_len, const char **out, size_t *out_len);
+
+/**
+ * @brief      Check if the decoder has more output for the input it has already consumed
+ *
+ * @param[in]  gz    The decoder handle
+ *
+ * @return     true if http_gzip_decompress() has to be called again
+ */
+bool http_gzip_has_output(http_gzip_handle_t gz);
+
+/**
+ * @brief      Free the decoder
+ *
+ * @param[in]  gz    The decoder handle, may be NULL
+ */
+void http_gzip_cleanup(http_gzip_handle_t gz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
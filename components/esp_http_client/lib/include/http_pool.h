@@ -0,0 +1,70 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _HTTP_POOL_H_
+#define _HTTP_POOL_H_
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_transport.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Identifies the connections which can be shared between clients.
+ * The TLS settings are compared by pointer, connections are only shared
+ * between clients which trust the same server certificates.
+ */
+typedef struct {
+    const char *scheme;
+    const char *host;
+    int port;
+    const char *cert_pem;
+    const char *client_cert_pem;
+    const char *client_key_pem;
+    bool use_global_ca_store;
+} http_pool_key_t;
+
+/**
+ * @brief      Take an idle connection out of the pool
+ *
+ * @param[in]  key   The key
+ *
+ * @return
+ *     - A connected transport, the caller owns it until it is put back or destroyed
+ *     - NULL if there is no usable connection for the key
+ */
+esp_transport_handle_t http_pool_take(const http_pool_key_t *key);
+
+/**
+ * @brief      Put an idle connection into the pool, the pool takes the ownership of the
+ *             transport. If the pool is full, the least recently used connection is closed.
+ *
+ * @param[in]  key   The key of the connection
+ * @param[in]  t     The connected transport, not part of any transport list
+ */
+void http_pool_put(const http_pool_key_t *key, esp_transport_handle_t t);
+
+/**
+ * @brief      Close all idle connections in the pool
+ */
+void http_pool_flush(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -17,11 +17,13 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <stdbool.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <http_parser.h>
 #include <sdkconfig.h>
 #include <esp_err.h>
+#include <esp_partition.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -35,6 +37,7 @@ initializer that should be kept in sync
         .task_priority      = tskIDLE_PRIORITY+5,       \
         .stack_size         = 4096,                     \
         .core_id            = tskNO_AFFINITY,           \
+        .worker_count       = 0,                        \
         .server_port        = 80,                       \
         .ctrl_port          = 32768,                    \
         .max_open_sockets   = 7,                        \
@@ -44,6 +47,7 @@ initializer that should be kept in sync
         .lru_purge_enable   = false,                    \
         .recv_wait_timeout  = 5,                        \
         .send_wait_timeout  = 5,                        \
+        .sess_idle_timeout  = 0,                        \
         .global_user_ctx = NULL,                        \
         .global_user_ctx_free_fn = NULL,                \
         .global_transport_ctx = NULL,                   \
@@ -142,6 +146,18 @@ typedef struct httpd_config {
     size_t      stack_size;         /*!< The maximum stack size allowed for the server task */
     BaseType_t  core_id;            /*!< The core the HTTP server task will run on */
 
+    /**
+     * Number of worker tasks which process requests and run the URI handlers.
+     *
+     * If 0, requests are processed by the server task, one at a time, so a slow
+     * URI handler delays the requests of all other clients. Otherwise the server
+     * task only waits for requests and new connections, and hands each socket with
+     * a pending request over to a free worker task. A socket is processed by one
+     * worker at a time. Worker tasks use the stack size and priority of the server
+     * task and are spread over both cores, unless core_id is set.
+     */
+    uint8_t     worker_count;
+
     /**
      * TCP Port number for receiving and transmitting HTTP traffic
      */
@@ -161,6 +177,13 @@ typedef struct httpd_config {
     uint16_t    recv_wait_timeout;  /*!< Timeout for recv function (in seconds)*/
     uint16_t    send_wait_timeout;  /*!< Timeout for send function (in seconds)*/
 
+    /**
+     * Sessions which haven't received a request for this long (in seconds)
+     * are closed, even if the server isn't full. 0 keeps sessions open until
+     * the client closes them or they are purged by the LRU logic.
+     */
+    uint16_t    sess_idle_timeout;
+
     /**
      * Global user context.
      *
@@ -233,6 +256,10 @@ typedef struct httpd_config {
      *
      * Users can implement their own matching functions (See description
      * of the `httpd_uri_match_func_t` function prototype)
+     *
+     * With the first two options the handlers are kept in a hash table
+     * and found without comparing the URI with each of them. Custom
+     * matching functions are called for every handler in turn.
      */
     httpd_uri_match_func_t uri_match_fn;
 } httpd_config_t;
@@ -395,6 +422,16 @@ typedef struct httpd_uri {
      * Pointer to user context data which will be available to handler
      */
     void *user_ctx;
+
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    /**
+     * Flag for indicating a WebSocket endpoint.
+     * If this flag is true, then method must be HTTP_GET. The handler
+     * is called with method HTTP_GET once the handshake is done, and
+     * with method 0 for every data frame received afterwards.
+     */
+    bool is_websocket;
+#endif
 } httpd_uri_t;
 
 /**
@@ -744,6 +781,26 @@ esp_err_t httpd_sess_set_send_override(httpd_handle_t hd, int sockfd, httpd_send
  */
 esp_err_t httpd_sess_set_pending_override(httpd_handle_t hd, int sockfd, httpd_pending_func_t pending_func);
 
+/**
+ * @brief   Allocate memory which is freed when the request completes
+ *
+ * Allocations are carved out of a per-server arena, which is reset after
+ * every request, so URI handlers can make many small allocations (e.g. for
+ * parsing a request body) without freeing them and without fragmenting the heap.
+ *
+ * @note    This API is supposed to be called only from the context of
+ *          a URI handler where httpd_req_t* request pointer is valid.
+ *          The memory must not be used after the handler returns.
+ *
+ * @param[in] r     The request being handled
+ * @param[in] size  Size of the allocation in bytes
+ *
+ * @return
+ *  - Pointer : 4 byte aligned memory valid until the request completes
+ *  - NULL    : Invalid/NULL request pointer, size of zero or out of memory
+ */
+void *httpd_req_alloc(httpd_req_t *r, size_t size);
+
 /**
  * @brief   Get the Socket Descriptor from the HTTP request
  *
@@ -1056,10 +1113,91 @@ static inline esp_err_t httpd_resp_sendstr_chunk(httpd_req_t *r, const char *str
     return httpd_resp_send_chunk(r, str, (str == NULL) ? 0 : strlen(str));
 }
 
+/**
+ * @brief   API to send a part of a file as HTTP response.
+ *
+ * The data is read from the file descriptor with pread() in blocks of
+ * CONFIG_HTTPD_SEND_FILE_BUF_SIZE bytes, aligned to multiples of the block
+ * size in the file, and sent with a Content-Length header, so that the
+ * handler doesn't need to copy and send the file in chunks.
+ *
+ * If no ETag header has been set with httpd_resp_set_hdr(), one is generated
+ * from the modification time and size of the file, provided that fstat()
+ * reports a modification time. If the ETag matches the If-None-Match header
+ * of the request, only the headers are sent with status 304. The body is
+ * also left out for HEAD requests.
+ *
+ * @note
+ *  - Headers of the request are not available after calling this function.
+ *  - The file descriptor is not closed.
+ *
+ * @param[in] r         The request being responded to
+ * @param[in] fd        File descriptor to read from
+ * @param[in] offset    Offset of the data in the file
+ * @param[in] len       Length of the data, -1 to send until the end of file
+ *
+ * @return
+ *  - ESP_OK : On successfully sending the response packet
+ *  - ESP_ERR_INVALID_ARG : Null request pointer or invalid file range
+ *  - ESP_ERR_NO_MEM : No memory for the read buffer
+ *  - ESP_ERR_HTTPD_RESP_HDR    : Essential headers are too large for internal buffer
+ *  - ESP_ERR_HTTPD_RESP_SEND   : Error in raw send
+ *  - ESP_ERR_HTTPD_INVALID_REQ : Invalid request
+ *  - ESP_FAIL : Error reading the file after the headers have been sent
+ */
+esp_err_t httpd_resp_send_file(httpd_req_t *r, int fd, off_t offset, ssize_t len);
+
+/**
+ * @brief   API to send a file, or its precompressed variant, as HTTP response.
+ *
+ * If the request accepts gzip encoding and a file named path with ".gz"
+ * appended exists, that file is sent instead, with "Content-Encoding: gzip"
+ * and "Vary: Accept-Encoding" headers. The file is sent with
+ * httpd_resp_send_file(). Content type has to be set by the caller.
+ *
+ * @param[in] r         The request being responded to
+ * @param[in] path      Path of the file in VFS
+ *
+ * @return
+ *  - ESP_OK : On successfully sending the response packet
+ *  - ESP_ERR_NOT_FOUND : The file can't be opened, nothing has been sent
+ *  - Other errors as returned by httpd_resp_send_file()
+ */
+esp_err_t httpd_resp_send_file_path(httpd_req_t *r, const char *path);
+
+/**
+ * @brief   API to send data from a flash partition as HTTP response.
+ *
+ * The data is mapped into memory with esp_partition_mmap(), one MMU page
+ * at a time, and sent without being copied to a buffer.
+ *
+ * The response can be validated by ETag as with httpd_resp_send_file(),
+ * except that there is no default ETag. Set one with httpd_resp_set_hdr(),
+ * e.g. from a version or hash stored with the data.
+ *
+ * @note    Headers of the request are not available after calling this function.
+ *
+ * @param[in] r         The request being responded to
+ * @param[in] partition Partition to send the data from
+ * @param[in] offset    Offset of the data in the partition
+ * @param[in] len       Length of the data, -1 to send until the end of partition
+ *
+ * @return
+ *  - ESP_OK : On successfully sending the response packet
+ *  - ESP_ERR_INVALID_ARG : Null pointer or invalid range
+ *  - ESP_ERR_HTTPD_RESP_HDR    : Essential headers are too large for internal buffer
+ *  - ESP_ERR_HTTPD_RESP_SEND   : Error in raw send
+ *  - ESP_ERR_HTTPD_INVALID_REQ : Invalid request
+ *  - ESP_FAIL : Error mapping the partition after the headers have been sent
+ */
+esp_err_t httpd_resp_send_partition(httpd_req_t *r, const esp_partition_t *partition,
+                                    size_t offset, ssize_t len);
+
 /* Some commonly used status codes */
 #define HTTPD_200      "200 OK"                     /*!< HTTP Response 200 */
 #define HTTPD_204      "204 No Content"             /*!< HTTP Response 204 */
 #define HTTPD_207      "207 Multi-Status"           /*!< HTTP Response 207 */
+#define HTTPD_304      "304 Not Modified"           /*!< HTTP Response 304 */
 #define HTTPD_400      "400 Bad Request"            /*!< HTTP Response 400 */
 #define HTTPD_404      "404 Not Found"              /*!< HTTP Response 404 */
 #define HTTPD_408      "408 Request Timeout"        /*!< HTTP Response 408 */
@@ -1391,7 +1529,8 @@ esp_err_t httpd_sess_trigger_close(httpd_handle_t handle, int sockfd);
  * exchanged a packet.
  *
  * @note    Calling this API is only necessary if the LRU Purge Enable option
- *          is enabled.
+ *          is enabled or sess_idle_timeout is set. It also resets the idle
+ *          timeout of the session.
  *
  * @param[in] handle    Handle to server returned by httpd_start
  * @param[in] sockfd    The socket descriptor of the session for which LRU counter
@@ -1445,6 +1584,115 @@ esp_err_t httpd_queue_work(httpd_handle_t handle, httpd_work_fn_t work, void *ar
  * @}
  */
 
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+/* ************** Group: WebSocket ************** */
+/** @name WebSocket
+ * Functions and structs for WebSocket server
+ * @{
+ */
+
+/**
+ * @brief Enum for WebSocket packet types (Opcode in the header)
+ * @note Please refer to RFC6455 Section 5.2 for more details.
+ */
+typedef enum {
+    HTTPD_WS_TYPE_CONTINUE   = 0x0,
+    HTTPD_WS_TYPE_TEXT       = 0x1,
+    HTTPD_WS_TYPE_BINARY     = 0x2,
+    HTTPD_WS_TYPE_CLOSE      = 0x8,
+    HTTPD_WS_TYPE_PING       = 0x9,
+    HTTPD_WS_TYPE_PONG       = 0xA
+} httpd_ws_type_t;
+
+/**
+ * @brief WebSocket frame format
+ */
+typedef struct httpd_ws_frame {
+    bool final;                 /*!< Received frame is the final frame of a message */
+    bool fragmented;            /*!< Frame to be sent is followed by more frames of the message */
+    httpd_ws_type_t type;       /*!< WebSocket frame type */
+    uint8_t *payload;           /*!< Pre-allocated data buffer */
+    size_t len;                 /*!< Length of the WebSocket data */
+} httpd_ws_frame_t;
+
+/**
+ * @brief Receive a WebSocket frame from inside a WebSocket URI handler
+ *
+ * The frame header has been read before the handler is called. Calling this
+ * with max_len 0 only fills the type, final flag and length of the payload.
+ * Otherwise up to max_len bytes of the payload which haven't been received
+ * yet are read from the socket straight into frame->payload and unmasked
+ * there, and frame->len is set to the number of bytes read. A large payload
+ * can thus be received in several parts. Payload which the handler doesn't
+ * read is discarded after the handler returns.
+ *
+ * Ping frames are answered, and close frames are confirmed, by the server
+ * without calling the handler.
+ *
+ * @param[in]     req       Current request
+ * @param[in,out] frame     WebSocket frame, payload has to be provided by the caller
+ * @param[in]     max_len   Maximum number of payload bytes to read
+ *
+ * @return
+ *  - ESP_OK                    : On successful
+ *  - ESP_ERR_INVALID_ARG       : Argument is invalid or the request is not a WebSocket frame
+ *  - ESP_FAIL                  : Socket errors
+ *  - ESP_ERR_HTTPD_INVALID_REQ : Invalid request
+ */
+esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *frame, size_t max_len);
+
+/**
+ * @brief Send a WebSocket frame from inside a URI handler of the session
+ *
+ * Payloads of up to 125 bytes are sent together with the frame header
+ * in a single write.
+ *
+ * @param[in] req   Current request
+ * @param[in] frame WebSocket frame
+ *
+ * @return
+ *  - ESP_OK                    : On successful
+ *  - ESP_ERR_INVALID_ARG       : Argument is invalid or the session is not a WebSocket
+ *  - ESP_FAIL                  : Socket errors
+ *  - ESP_ERR_HTTPD_INVALID_REQ : Invalid request
+ */
+esp_err_t httpd_ws_send_frame(httpd_req_t *req, httpd_ws_frame_t *frame);
+
+/**
+ * @brief Send a WebSocket frame on a session outside of its URI handler
+ *
+ * This is meant to be called from a work function queued with
+ * httpd_queue_work(), so that the frame doesn't get mixed with data
+ * which the server sends on the same socket. It can be used to push
+ * updates to a client without waiting for a request.
+ *
+ * @param[in] hd    Server instance
+ * @param[in] fd    Socket descriptor of the session
+ * @param[in] frame WebSocket frame
+ *
+ * @return
+ *  - ESP_OK                : On successful
+ *  - ESP_ERR_INVALID_ARG   : Argument is invalid or the session is not a WebSocket
+ *  - ESP_ERR_INVALID_STATE : A worker task is processing a frame of the session, retry later
+ *  - ESP_FAIL              : Socket errors
+ */
+esp_err_t httpd_ws_send_frame_async(httpd_handle_t hd, int fd, httpd_ws_frame_t *frame);
+
+/**
+ * @brief Check if a session has completed the WebSocket handshake
+ *
+ * @param[in] hd    Server instance
+ * @param[in] fd    Socket descriptor of the session
+ *
+ * @return True if the session is a WebSocket
+ */
+bool httpd_ws_is_websocket(httpd_handle_t hd, int fd);
+
+/** End of WebSocket related stuff
+ * @}
+ */
+#endif /* CONFIG_HTTPD_WS_SUPPORT */
+
 #ifdef __cplusplus
 }
 #endif
@@ -24,6 +24,7 @@
 #include <esp_err.h>
 
 #include <esp_http_server.h>
+#include <esp_heap_caps.h>
 #include "osal.h"
 
 #ifdef __cplusplus
@@ -68,9 +69,20 @@ struct sock_db {
     httpd_send_func_t send_fn;              /*!< Send function for this socket */
     httpd_recv_func_t recv_fn;              /*!< Receive function for this socket */
     httpd_pending_func_t pending_fn;        /*!< Pending function for this socket */
-    uint64_t lru_counter;                   /*!< LRU Counter indicating when the socket was last used */
+    struct sock_db *lru_prev;               /*!< Previous open session in LRU order, or next free slot */
+    struct sock_db *lru_next;               /*!< Next open session in LRU order */
+    int64_t last_active;                    /*!< Time when the socket was last used, in microseconds */
+    bool lru_touched;                       /*!< Used by another task since last_active, not moved in the LRU list yet */
     char pending_data[PARSER_BLOCK_SIZE];   /*!< Buffer for pending data to be received */
     size_t pending_len;                     /*!< Length of pending data to be received */
+    httpd_req_t *req;                       /*!< Request being processed on this socket, NULL in between requests */
+    bool busy;                              /*!< Socket is being processed by a worker task */
+    bool close_pending;                     /*!< Close the socket when the worker task is done with it */
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    bool ws_handshake_done;                 /*!< The session is a WebSocket, data is received as frames */
+    esp_err_t (*ws_handler)(httpd_req_t *r); /*!< WebSocket handler, called for every data frame */
+    void *ws_user_ctx;                      /*!< User context of the WebSocket handler */
+#endif
 };
 
 /**
@@ -91,6 +103,47 @@ struct httpd_req_aux {
         const char *value;
     } *resp_hdrs;                                   /*!< Additional headers in response packet */
     struct http_parser_url url_parse_res;           /*!< URL parsing result, used for retrieving URL elements */
+    heap_caps_arena_handle_t arena;                 /*!< Memory for httpd_req_alloc(), reset after each request. Created on first use */
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    bool            ws_handshake_detect;            /*!< Request asks for an upgrade to WebSocket */
+    bool            ws_frame;                       /*!< Request is a WebSocket frame */
+    bool            ws_final;                       /*!< FIN bit of the frame */
+    httpd_ws_type_t ws_type;                        /*!< Opcode of the frame */
+    uint8_t         ws_mask[4];                     /*!< Masking key of the frame */
+    size_t          ws_offset;                      /*!< Number of payload bytes received, for unmasking */
+#endif
+};
+
+/**
+ * @brief   Entry of the URI handler lookup table. Handlers are found by the hash of
+ *          the part of the URI template which all matching URIs start with.
+ */
+struct httpd_uri_route {
+    httpd_uri_t *uri;                       /*!< URI handler, NULL for an empty slot */
+    uint32_t hash;                          /*!< Hash of the first len characters of the template */
+    uint16_t len;                           /*!< Number of characters which all matching URIs start with */
+    uint16_t order;                         /*!< Index of the handler in hd_calls, the first match wins */
+    bool exact;                             /*!< Only URIs of length len match */
+};
+
+/**
+ * @brief   A task which processes requests, with the request data it uses.
+ *          If no worker tasks are configured, the only one of these is used
+ *          by the server task itself.
+ */
+struct httpd_worker {
+    struct httpd_data *hd;                  /*!< Server instance */
+    struct thread_data td;                  /*!< Information for the worker thread */
+    struct httpd_req req;                   /*!< The current HTTPD request of this worker */
+    struct httpd_req_aux req_aux;           /*!< Additional data about the HTTPD request kept unexposed */
+};
+
+/**
+ * @brief   Result of processing a socket by a worker task
+ */
+struct httpd_worker_done {
+    struct sock_db *sd;                     /*!< Processed socket */
+    esp_err_t ret;                          /*!< Result of httpd_sess_process() */
 };
 
 /**
@@ -104,9 +157,18 @@ struct httpd_data {
     int msg_fd;                             /*!< Ctrl message sender FD */
     struct thread_data hd_td;               /*!< Information for the HTTPD thread */
     struct sock_db *hd_sd;                  /*!< The socket database */
+    struct sock_db **hd_sd_map;             /*!< Open sessions hashed by fd, hd_sd_map_size entries */
+    unsigned hd_sd_map_size;                /*!< Number of slots in hd_sd_map, a power of 2 */
+    struct sock_db *hd_sd_free;             /*!< Unused entries of hd_sd, linked by lru_prev */
+    struct sock_db *hd_lru_head;            /*!< Least recently used open session */
+    struct sock_db *hd_lru_tail;            /*!< Most recently used open session */
     httpd_uri_t **hd_calls;                 /*!< Registered URI handlers */
-    struct httpd_req hd_req;                /*!< The current HTTPD request */
-    struct httpd_req_aux hd_req_aux;        /*!< Additional data about the HTTPD request kept unexposed */
+    struct httpd_uri_route *hd_routes;      /*!< Lookup table of hd_calls, NULL if handlers are searched linearly */
+    unsigned hd_routes_size;                /*!< Number of slots in hd_routes, a power of 2 */
+    uint64_t hd_routes_prefix_lens;         /*!< Bit n set if a prefix route has len n, bit 63 for len >= 63 */
+    struct httpd_worker *hd_workers;        /*!< Worker tasks, MAX(config.worker_count, 1) entries */
+    oqueue_t work_queue;                    /*!< Sockets ready to be processed by a worker task */
+    oqueue_t done_queue;                    /*!< Sockets processed by a worker task (struct httpd_worker_done) */
 
     /* Array of registered error handler functions */
     httpd_err_handler_func_t *err_handler_fns;
@@ -159,13 +221,14 @@ esp_err_t httpd_sess_new(struct httpd_data *hd, int newfd);
  * @brief   Processes incoming HTTP requests
  *
  * @param[in] hd    Server instance data
- * @param[in] clifd Descriptor of the client from which data is to be received
+ * @param[in] sd    Session of the client from which data is to be received
+ * @param[in] r     Request structure of the task which processes the request
  *
  * @return
  *  - ESP_OK    : on successfully receiving, parsing and responding to a request
  *  - ESP_FAIL  : in case of failure in any of the stages of processing
  */
-esp_err_t httpd_sess_process(struct httpd_data *hd, int clifd);
+esp_err_t httpd_sess_process(struct httpd_data *hd, struct sock_db *sd, httpd_req_t *r);
 
 /**
  * @brief   Remove client descriptor from the session / socket database
@@ -230,6 +293,16 @@ int httpd_sess_iterate(struct httpd_data *hd, int fd);
  */
 bool httpd_is_sess_available(struct httpd_data *hd);
 
+/**
+ * @brief   Checks if any open session is not being processed by a worker
+ *          task, so that it can be closed to make space for a new client.
+ *
+ * @param[in] hd  Server instance data
+ *
+ * @return True if there is an idle session
+ */
+bool httpd_is_sess_idle(struct httpd_data *hd);
+
 /**
  * @brief   Checks if session has any pending data/packets
  *          for processing
@@ -261,11 +334,32 @@ bool httpd_sess_pending(struct httpd_data *hd, int fd);
  * @param[in] hd  Server instance data
  *
  * @return
- *  - ESP_OK    : if session closure initiated successfully
+ *  - ESP_OK    : if session closure initiated successfully, or if all
+ *                sessions are busy and none can be closed right now
  *  - ESP_FAIL  : if failed
  */
 esp_err_t httpd_sess_close_lru(struct httpd_data *hd);
 
+/**
+ * @brief   Marks a session as used just now, which makes it the most
+ *          recently used one. Must be called from the server task.
+ *
+ * @param[in] hd  Server instance data
+ * @param[in] sd  Session
+ */
+void httpd_sess_touch(struct httpd_data *hd, struct sock_db *sd);
+
+/**
+ * @brief   Closes sessions which haven't been used for the idle timeout
+ *          of the configuration.
+ *
+ * @param[in] hd  Server instance data
+ *
+ * @return  Time in microseconds until the next session times out, or -1
+ *          if no session is open or the idle timeout is disabled
+ */
+int64_t httpd_sess_close_idle(struct httpd_data *hd);
+
 /** End of Group : Session Management
  * @}
  */
@@ -281,12 +375,13 @@ esp_err_t httpd_sess_close_lru(struct httpd_data *hd);
  *          and invokes the appropriate one if found
  *
  * @param[in] hd  Server instance data for which handler needs to be invoked
+ * @param[in] r   The parsed request
  *
  * @return
  *  - ESP_OK    : if handler found and executed successfully
  *  - ESP_FAIL  : otherwise
  */
-esp_err_t httpd_uri(struct httpd_data *hd);
+esp_err_t httpd_uri(struct httpd_data *hd, httpd_req_t *r);
 
 /**
  * @brief   Unregister all URI handlers
@@ -335,25 +430,28 @@ bool httpd_validate_req_ptr(httpd_req_t *r);
  * http_recv() after this reads the body of the request.
  *
  * @param[in] hd  Server instance data
+ * @param[in] r   Request structure to be filled, its aux member must point
+ *                to the auxiliary data of the processing task
  * @param[in] sd  Pointer to socket which is needed for receiving TCP packets.
  *
  * @return
  *  - ESP_OK    : if request packet is valid
  *  - ESP_FAIL  : otherwise
  */
-esp_err_t httpd_req_new(struct httpd_data *hd, struct sock_db *sd);
+esp_err_t httpd_req_new(struct httpd_data *hd, httpd_req_t *r, struct sock_db *sd);
 
 /**
  * @brief   For an HTTP request, resets the resources allocated for it and
  *          purges any data left to be received
  *
  * @param[in] hd  Server instance data
+ * @param[in] r   The request
  *
  * @return
  *  - ESP_OK    : if request packet deleted and resources cleaned.
  *  - ESP_FAIL  : otherwise.
  */
-esp_err_t httpd_req_delete(struct httpd_data *hd);
+esp_err_t httpd_req_delete(struct httpd_data *hd, httpd_req_t *r);
 
 /**
  * @brief   For handling HTTP errors by invoking registered
@@ -471,6 +569,43 @@ int httpd_default_recv(httpd_handle_t hd, int sockfd, char *buf, size_t buf_len,
  * @}
  */
 
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+/****************** Group : WebSocket ********************/
+/** @name WebSocket
+ * Functions for the WebSocket protocol
+ * @{
+ */
+
+/**
+ * @brief   Respond to a WebSocket handshake request
+ *
+ * @param[in] req   The handshake request
+ *
+ * @return
+ *  - ESP_OK    : if the handshake has been sent
+ *  - ESP_FAIL  : if the request is invalid or sending failed
+ */
+esp_err_t httpd_ws_respond_server_handshake(httpd_req_t *req);
+
+/**
+ * @brief   Receive a frame on a WebSocket session. The header is read,
+ *          control frames are answered directly and data frames are
+ *          passed to the WebSocket handler of the session.
+ *
+ * @param[in] hd    Server instance data
+ * @param[in] r     Request structure associated with the session
+ *
+ * @return
+ *  - ESP_OK    : if the frame has been processed
+ *  - ESP_FAIL  : if the session needs to be closed
+ */
+esp_err_t httpd_ws_process_frame(struct httpd_data *hd, httpd_req_t *r);
+
+/** End of Group : WebSocket
+ * @}
+ */
+#endif /* CONFIG_HTTPD_WS_SUPPORT */
+
 #ifdef __cplusplus
 }
 #endif
@@ -75,6 +75,7 @@ struct httpd_ctrl_data {
     enum httpd_ctrl_msg {
         HTTPD_CTRL_SHUTDOWN,
         HTTPD_CTRL_WORK,
+        HTTPD_CTRL_WORKER_DONE,
     } hc_msg;
     httpd_work_fn_t hc_work;
     void *hc_work_arg;
@@ -146,17 +147,121 @@ static void httpd_process_ctrl_msg(struct httpd_data *hd)
         ESP_LOGD(TAG, LOG_FMT("shutdown"));
         hd->hd_td.status = THREAD_STOPPING;
         break;
+    case HTTPD_CTRL_WORKER_DONE:
+        /* Only wakes up the server, results are taken from done_queue */
+        ESP_LOGD(TAG, LOG_FMT("worker done"));
+        break;
     default:
         break;
     }
 }
 
+/* Worker task, processes the sessions which the server task
+ * found ready, one at a time */
+static void httpd_worker_thread(void *arg)
+{
+    struct httpd_worker *w = (struct httpd_worker *) arg;
+    struct httpd_data *hd = w->hd;
+    w->td.status = THREAD_RUNNING;
+
+    struct sock_db *sd;
+    while (httpd_os_queue_receive(hd->work_queue, &sd, true) == OS_SUCCESS && sd != NULL) {
+        ESP_LOGD(TAG, LOG_FMT("processing socket %d"), sd->fd);
+        struct httpd_worker_done done = {
+            .sd = sd,
+            .ret = httpd_sess_process(hd, sd, &w->req),
+        };
+        /* The queue has space for all sessions, so this can't fail */
+        httpd_os_queue_send(hd->done_queue, &done);
+
+        struct httpd_ctrl_data msg = {
+            .hc_msg = HTTPD_CTRL_WORKER_DONE,
+        };
+        cs_send_to_ctrl_sock(hd->msg_fd, hd->config.ctrl_port, &msg, sizeof(msg));
+    }
+
+    w->td.status = THREAD_STOPPED;
+    httpd_os_thread_delete();
+}
+
+static esp_err_t httpd_workers_start(struct httpd_data *hd)
+{
+    for (int i = 0; i < hd->config.worker_count; i++) {
+        struct httpd_worker *w = &hd->hd_workers[i];
+        /* Spread the workers over all cores unless the server is pinned */
+        BaseType_t core_id = hd->config.core_id;
+        if (core_id == tskNO_AFFINITY) {
+            core_id = i % portNUM_PROCESSORS;
+        }
+        if (httpd_os_thread_create(&w->td.handle, "httpd_worker",
+                                   hd->config.stack_size,
+                                   hd->config.task_priority,
+                                   httpd_worker_thread, w,
+                                   core_id) != ESP_OK) {
+            ESP_LOGE(TAG, LOG_FMT("failed to start worker %d"), i);
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
+
+/* Stop the worker tasks which have been started. They finish the
+ * sessions they are processing first. */
+static void httpd_workers_stop(struct httpd_data *hd)
+{
+    for (int i = 0; i < hd->config.worker_count; i++) {
+        if (hd->hd_workers[i].td.handle) {
+            /* The queue has space for all sessions and these */
+            struct sock_db *stop = NULL;
+            httpd_os_queue_send(hd->work_queue, &stop);
+        }
+    }
+    for (int i = 0; i < hd->config.worker_count; i++) {
+        struct httpd_worker *w = &hd->hd_workers[i];
+        if (w->td.handle) {
+            while (w->td.status != THREAD_STOPPED) {
+                httpd_os_thread_sleep(10);
+            }
+            w->td.handle = NULL;
+        }
+    }
+}
+
+/* Take back the sessions which worker tasks are done with */
+static void httpd_process_worker_done(struct httpd_data *hd)
+{
+    struct httpd_worker_done done;
+    while (httpd_os_queue_receive(hd->done_queue, &done, false) == OS_SUCCESS) {
+        struct sock_db *sd = done.sd;
+        sd->busy = false;
+        if (done.ret != ESP_OK || sd->close_pending) {
+            int fd = sd->fd;
+            ESP_LOGD(TAG, LOG_FMT("closing socket %d"), fd);
+            httpd_sess_delete(hd, fd);
+            close(fd);
+        } else {
+            httpd_sess_touch(hd, sd);
+        }
+    }
+}
+
 /* Manage in-coming connection or data requests */
 static esp_err_t httpd_server(struct httpd_data *hd)
 {
+    /* Close idle sessions and wake up when the next one times out */
+    struct timeval tv;
+    struct timeval *timeout = NULL;
+    int64_t idle_us = httpd_sess_close_idle(hd);
+    if (idle_us >= 0) {
+        tv.tv_sec = idle_us / 1000000;
+        tv.tv_usec = idle_us % 1000000;
+        timeout = &tv;
+    }
+
     fd_set read_set;
     FD_ZERO(&read_set);
-    if (hd->config.lru_purge_enable || httpd_is_sess_available(hd)) {
+    if (httpd_is_sess_available(hd) ||
+            (hd->config.lru_purge_enable && httpd_is_sess_idle(hd))) {
         /* Only listen for new connections if server has capacity to
          * handle more (or when LRU purge is enabled, in which case
          * older connections will be closed) */
@@ -170,8 +275,19 @@ static esp_err_t httpd_server(struct httpd_data *hd)
     tmp_max_fd = maxfd;
     maxfd = MAX(hd->ctrl_fd, tmp_max_fd);
 
+    /* Data which was received with a previous request, e.g. a WebSocket
+     * frame sent right after the handshake, doesn't wake up select() */
+    int fd = -1;
+    while ((fd = httpd_sess_iterate(hd, fd)) != -1) {
+        if (!httpd_sess_get(hd, fd)->busy && httpd_sess_pending(hd, fd)) {
+            tv.tv_sec = tv.tv_usec = 0;
+            timeout = &tv;
+            break;
+        }
+    }
+
     ESP_LOGD(TAG, LOG_FMT("doing select maxfd+1 = %d"), maxfd + 1);
-    int active_cnt = select(maxfd + 1, &read_set, NULL, NULL, NULL);
+    int active_cnt = select(maxfd + 1, &read_set, NULL, NULL, timeout);
     if (active_cnt < 0) {
         ESP_LOGE(TAG, LOG_FMT("error in select (%d)"), errno);
         httpd_sess_delete_invalid(hd);
@@ -188,18 +304,36 @@ static esp_err_t httpd_server(struct httpd_data *hd)
         }
     }
 
+    if (hd->config.worker_count) {
+        httpd_process_worker_done(hd);
+    }
+
     /* Case1: Do we have any activity on the current data
      * sessions? */
-    int fd = -1;
+    fd = -1;
     while ((fd = httpd_sess_iterate(hd, fd)) != -1) {
+        struct sock_db *sd = httpd_sess_get(hd, fd);
+        if (sd->busy) {
+            continue;
+        }
         if (FD_ISSET(fd, &read_set) || (httpd_sess_pending(hd, fd))) {
+            if (hd->config.worker_count) {
+                /* Hand the session over to a worker task, it is not
+                 * touched here until the worker is done with it */
+                ESP_LOGD(TAG, LOG_FMT("dispatching socket %d"), fd);
+                sd->busy = true;
+                httpd_os_queue_send(hd->work_queue, &sd);
+                continue;
+            }
             ESP_LOGD(TAG, LOG_FMT("processing socket %d"), fd);
-            if (httpd_sess_process(hd, fd) != ESP_OK) {
+            if (httpd_sess_process(hd, sd, &hd->hd_workers[0].req) != ESP_OK) {
                 ESP_LOGD(TAG, LOG_FMT("closing socket %d"), fd);
                 close(fd);
                 /* Delete session and update fd to that
                  * preceding the one being deleted */
                 fd = httpd_sess_delete(hd, fd);
+            } else {
+                httpd_sess_touch(hd, sd);
             }
         }
     }
@@ -231,6 +365,7 @@ static void httpd_thread(void *arg)
     }
 
     ESP_LOGD(TAG, LOG_FMT("web server exiting"));
+    httpd_workers_stop(hd);
     close(hd->msg_fd);
     cs_free_ctrl_sock(hd->ctrl_fd);
     httpd_close_all_sessions(hd);
@@ -289,6 +424,8 @@ static esp_err_t httpd_server_init(struct httpd_data *hd)
     return ESP_OK;
 }
 
+static void httpd_delete(struct httpd_data *hd);
+
 static struct httpd_data *httpd_create(const httpd_config_t *config)
 {
     /* Allocate memory for httpd instance data */
@@ -310,35 +447,78 @@ static struct httpd_data *httpd_create(const httpd_config_t *config)
         free(hd);
         return NULL;
     }
-    struct httpd_req_aux *ra = &hd->hd_req_aux;
-    ra->resp_hdrs = calloc(config->max_resp_headers, sizeof(struct resp_hdr));
-    if (!ra->resp_hdrs) {
-        ESP_LOGE(TAG, LOG_FMT("Failed to allocate memory for HTTP response headers"));
+    /* Save the configuration for this instance */
+    hd->config = *config;
+    /* Keep the fd hash table at most half full */
+    hd->hd_sd_map_size = 4;
+    while (hd->hd_sd_map_size < config->max_open_sockets * 2) {
+        hd->hd_sd_map_size *= 2;
+    }
+    hd->hd_sd_map = calloc(hd->hd_sd_map_size, sizeof(struct sock_db *));
+    if (!hd->hd_sd_map) {
+        ESP_LOGE(TAG, LOG_FMT("Failed to allocate memory for HTTP session map"));
         free(hd->hd_sd);
         free(hd->hd_calls);
         free(hd);
         return NULL;
     }
-    hd->err_handler_fns = calloc(HTTPD_ERR_CODE_MAX, sizeof(httpd_err_handler_func_t));
-    if (!hd->err_handler_fns) {
-        ESP_LOGE(TAG, LOG_FMT("Failed to allocate memory for HTTP error handlers"));
-        free(ra->resp_hdrs);
+    hd->hd_workers = calloc(MAX(config->worker_count, 1), sizeof(struct httpd_worker));
+    if (!hd->hd_workers) {
+        ESP_LOGE(TAG, LOG_FMT("Failed to allocate memory for HTTP workers"));
+        free(hd->hd_sd_map);
         free(hd->hd_sd);
         free(hd->hd_calls);
         free(hd);
         return NULL;
     }
-    /* Save the configuration for this instance */
-    hd->config = *config;
+    for (int i = 0; i < MAX(config->worker_count, 1); i++) {
+        struct httpd_worker *w = &hd->hd_workers[i];
+        w->hd = hd;
+        w->req.aux = &w->req_aux;
+        w->req_aux.resp_hdrs = calloc(config->max_resp_headers, sizeof(struct resp_hdr));
+        if (!w->req_aux.resp_hdrs) {
+            ESP_LOGE(TAG, LOG_FMT("Failed to allocate memory for HTTP response headers"));
+            httpd_delete(hd);
+            return NULL;
+        }
+    }
+    if (config->worker_count) {
+        hd->work_queue = httpd_os_queue_create(config->max_open_sockets + config->worker_count,
+                                               sizeof(struct sock_db *));
+        hd->done_queue = httpd_os_queue_create(config->max_open_sockets,
+                                               sizeof(struct httpd_worker_done));
+        if (!hd->work_queue || !hd->done_queue) {
+            ESP_LOGE(TAG, LOG_FMT("Failed to allocate memory for HTTP worker queues"));
+            httpd_delete(hd);
+            return NULL;
+        }
+    }
+    hd->err_handler_fns = calloc(HTTPD_ERR_CODE_MAX, sizeof(httpd_err_handler_func_t));
+    if (!hd->err_handler_fns) {
+        ESP_LOGE(TAG, LOG_FMT("Failed to allocate memory for HTTP error handlers"));
+        httpd_delete(hd);
+        return NULL;
+    }
     return hd;
 }
 
 static void httpd_delete(struct httpd_data *hd)
 {
-    struct httpd_req_aux *ra = &hd->hd_req_aux;
     /* Free memory of httpd instance data */
     free(hd->err_handler_fns);
-    free(ra->resp_hdrs);
+    for (int i = 0; i < MAX(hd->config.worker_count, 1); i++) {
+        struct httpd_req_aux *ra = &hd->hd_workers[i].req_aux;
+        free(ra->resp_hdrs);
+        heap_caps_arena_destroy(ra->arena);
+    }
+    free(hd->hd_workers);
+    if (hd->work_queue) {
+        httpd_os_queue_delete(hd->work_queue);
+    }
+    if (hd->done_queue) {
+        httpd_os_queue_delete(hd->done_queue);
+    }
+    free(hd->hd_sd_map);
     free(hd->hd_sd);
 
     /* Free registered URI handlers */
@@ -382,12 +562,21 @@ esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config)
     }
 
     httpd_sess_init(hd);
+    if (httpd_workers_start(hd) != ESP_OK) {
+        httpd_workers_stop(hd);
+        close(hd->msg_fd);
+        cs_free_ctrl_sock(hd->ctrl_fd);
+        close(hd->listen_fd);
+        httpd_delete(hd);
+        return ESP_ERR_HTTPD_TASK;
+    }
     if (httpd_os_thread_create(&hd->hd_td.handle, "httpd",
                                hd->config.stack_size,
                                hd->config.task_priority,
                                httpd_thread, hd,
                                hd->config.core_id) != ESP_OK) {
         /* Failed to launch task */
+        httpd_workers_stop(hd);
         httpd_delete(hd);
         return ESP_ERR_HTTPD_TASK;
     }
@@ -358,6 +358,19 @@ static esp_err_t cb_headers_complete(http_parser *parser)
     ESP_LOGD(TAG, LOG_FMT("content length = %zu"), r->content_len);
 
     if (parser->upgrade) {
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+        /* Only upgrades to WebSocket are supported, whether the URI
+         * is a WebSocket endpoint is checked by httpd_uri() */
+        char upgrade[sizeof("websocket")];
+        if (httpd_req_get_hdr_value_str(r, "Upgrade", upgrade, sizeof(upgrade)) == ESP_OK &&
+                strcasecmp(upgrade, "websocket") == 0) {
+            ESP_LOGD(TAG, LOG_FMT("websocket handshake"));
+            ra->ws_handshake_detect = true;
+            parser_data->status = PARSING_BODY;
+            ra->remaining_len = r->content_len;
+            return ESP_OK;
+        }
+#endif
         ESP_LOGW(TAG, LOG_FMT("upgrade from HTTP not supported"));
         /* There is no specific HTTP error code to notify the client that
          * upgrade is not supported, thus sending 400 Bad Request */
@@ -582,9 +595,8 @@ static void parse_init(httpd_req_t *r, http_parser *parser, parser_data_t *data)
 
 /* Function that receives TCP data and runs parser on it
  */
-static esp_err_t httpd_parse_req(struct httpd_data *hd)
+static esp_err_t httpd_parse_req(struct httpd_data *hd, httpd_req_t *r)
 {
-    httpd_req_t *r = &hd->hd_req;
     int blk_len,  offset;
     http_parser   parser;
     parser_data_t parser_data;
@@ -624,7 +636,7 @@ static esp_err_t httpd_parse_req(struct httpd_data *hd)
     } while (parser_data.status != PARSING_COMPLETE);
 
     ESP_LOGD(TAG, LOG_FMT("parsing complete"));
-    return httpd_uri(hd);
+    return httpd_uri(hd, r);
 }
 
 static void init_req(httpd_req_t *r, httpd_config_t *config)
@@ -633,7 +645,6 @@ static void init_req(httpd_req_t *r, httpd_config_t *config)
     r->method = 0;
     memset((char*)r->uri, 0, sizeof(r->uri));
     r->content_len = 0;
-    r->aux = 0;
     r->user_ctx = 0;
     r->sess_ctx = 0;
     r->free_ctx = 0;
@@ -651,6 +662,10 @@ static void init_req_aux(struct httpd_req_aux *ra, httpd_config_t *config)
     ra->req_hdrs_count = 0;
     ra->resp_hdrs_count = 0;
     memset(ra->resp_hdrs, 0, config->max_resp_headers * sizeof(struct resp_hdr));
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    ra->ws_handshake_detect = false;
+    ra->ws_frame = false;
+#endif
 }
 
 static void httpd_req_cleanup(httpd_req_t *r)
@@ -665,26 +680,31 @@ static void httpd_req_cleanup(httpd_req_t *r)
     ra->sd->ctx = r->sess_ctx;
     ra->sd->free_ctx = r->free_ctx;
     ra->sd->ignore_sess_ctx_changes = r->ignore_sess_ctx_changes;
+    ra->sd->req = NULL;
+
+    /* Free everything allocated with httpd_req_alloc() */
+    if (ra->arena) {
+        heap_caps_arena_reset(ra->arena);
+    }
 
-    /* Clear out the request and request_aux structures */
+    /* Clear out the request and request_aux structures. The aux pointer
+     * is kept, it belongs to the task processing requests with r */
     ra->sd = NULL;
     r->handle = NULL;
-    r->aux = NULL;
 }
 
 /* Function that processes incoming TCP data and
  * updates the http request data httpd_req_t
  */
-esp_err_t httpd_req_new(struct httpd_data *hd, struct sock_db *sd)
+esp_err_t httpd_req_new(struct httpd_data *hd, httpd_req_t *r, struct sock_db *sd)
 {
-    httpd_req_t *r = &hd->hd_req;
+    struct httpd_req_aux *ra = r->aux;
     init_req(r, &hd->config);
-    init_req_aux(&hd->hd_req_aux, &hd->config);
+    init_req_aux(ra, &hd->config);
     r->handle = hd;
-    r->aux = &hd->hd_req_aux;
     /* Associate the request to the socket */
-    struct httpd_req_aux *ra = r->aux;
     ra->sd = sd;
+    sd->req = r;
     /* Set defaults */
     ra->status = (char *)HTTPD_200;
     ra->content_type = (char *)HTTPD_TYPE_TEXT;
@@ -693,8 +713,18 @@ esp_err_t httpd_req_new(struct httpd_data *hd, struct sock_db *sd)
     r->sess_ctx = sd->ctx;
     r->free_ctx = sd->free_ctx;
     r->ignore_sess_ctx_changes = sd->ignore_sess_ctx_changes;
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    /* After the handshake only WebSocket frames are received */
+    if (sd->ws_handshake_done) {
+        esp_err_t err = httpd_ws_process_frame(hd, r);
+        if (err != ESP_OK) {
+            httpd_req_cleanup(r);
+        }
+        return err;
+    }
+#endif
     /* Parse request */
-    esp_err_t err = httpd_parse_req(hd);
+    esp_err_t err = httpd_parse_req(hd, r);
     if (err != ESP_OK) {
         httpd_req_cleanup(r);
     }
@@ -703,9 +733,8 @@ esp_err_t httpd_req_new(struct httpd_data *hd, struct sock_db *sd)
 
 /* Function that resets the http request data
  */
-esp_err_t httpd_req_delete(struct httpd_data *hd)
+esp_err_t httpd_req_delete(struct httpd_data *hd, httpd_req_t *r)
 {
-    httpd_req_t *r = &hd->hd_req;
     struct httpd_req_aux *ra = r->aux;
 
     /* Finish off reading any pending/leftover data */
@@ -738,9 +767,14 @@ bool httpd_validate_req_ptr(httpd_req_t *r)
         struct httpd_data *hd = (struct httpd_data *) r->handle;
         if (hd) {
             /* Check if this function is running in the context of
-             * the correct httpd server thread */
-            if (httpd_os_thread_handle() == hd->hd_td.handle) {
-                return true;
+             * the httpd server thread or worker which owns the request */
+            if (hd->config.worker_count == 0) {
+                return httpd_os_thread_handle() == hd->hd_td.handle;
+            }
+            for (int i = 0; i < hd->config.worker_count; i++) {
+                if (&hd->hd_workers[i].req == r) {
+                    return httpd_os_thread_handle() == hd->hd_workers[i].td.handle;
+                }
             }
         }
     }
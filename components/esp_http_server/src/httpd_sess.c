@@ -16,17 +16,104 @@
 #include <stdlib.h>
 #include <esp_log.h>
 #include <esp_err.h>
+#include <esp_timer.h>
 
 #include <esp_http_server.h>
 #include "esp_httpd_priv.h"
 
 static const char *TAG = "httpd_sess";
 
+/* Sessions are found by fd in an open addressing hash table. LwIP
+ * allocates descriptors consecutively, so the low bits are enough */
+static inline unsigned httpd_sess_map_slot(struct httpd_data *hd, int fd)
+{
+    return (unsigned) fd & (hd->hd_sd_map_size - 1);
+}
+
+static void httpd_sess_map_add(struct httpd_data *hd, struct sock_db *sd)
+{
+    unsigned i = httpd_sess_map_slot(hd, sd->fd);
+    while (hd->hd_sd_map[i]) {
+        i = (i + 1) & (hd->hd_sd_map_size - 1);
+    }
+    hd->hd_sd_map[i] = sd;
+}
+
+static void httpd_sess_map_remove(struct httpd_data *hd, struct sock_db *sd)
+{
+    const unsigned mask = hd->hd_sd_map_size - 1;
+    unsigned i = httpd_sess_map_slot(hd, sd->fd);
+    while (hd->hd_sd_map[i] != sd) {
+        if (hd->hd_sd_map[i] == NULL) {
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+    hd->hd_sd_map[i] = NULL;
+
+    /* Move back the following entries which would no longer be found */
+    for (unsigned j = (i + 1) & mask; hd->hd_sd_map[j]; j = (j + 1) & mask) {
+        unsigned k = httpd_sess_map_slot(hd, hd->hd_sd_map[j]->fd);
+        if ((j > i && (k <= i || k > j)) || (j < i && (k <= i && k > j))) {
+            hd->hd_sd_map[i] = hd->hd_sd_map[j];
+            hd->hd_sd_map[j] = NULL;
+            i = j;
+        }
+    }
+}
+
+static void httpd_sess_lru_unlink(struct httpd_data *hd, struct sock_db *sd)
+{
+    /* Only the head of the list has no previous entry */
+    if (sd->lru_prev == NULL && hd->hd_lru_head != sd) {
+        return;
+    }
+    if (sd->lru_prev) {
+        sd->lru_prev->lru_next = sd->lru_next;
+    } else {
+        hd->hd_lru_head = sd->lru_next;
+    }
+    if (sd->lru_next) {
+        sd->lru_next->lru_prev = sd->lru_prev;
+    } else {
+        hd->hd_lru_tail = sd->lru_prev;
+    }
+    sd->lru_prev = sd->lru_next = NULL;
+}
+
+void httpd_sess_touch(struct httpd_data *hd, struct sock_db *sd)
+{
+    httpd_sess_lru_unlink(hd, sd);
+    sd->lru_prev = hd->hd_lru_tail;
+    if (hd->hd_lru_tail) {
+        hd->hd_lru_tail->lru_next = sd;
+    } else {
+        hd->hd_lru_head = sd;
+    }
+    hd->hd_lru_tail = sd;
+    sd->last_active = esp_timer_get_time();
+    sd->lru_touched = false;
+}
+
+/* Take a session out of the database, without closing anything */
+static void httpd_sess_release(struct httpd_data *hd, struct sock_db *sd)
+{
+    httpd_sess_lru_unlink(hd, sd);
+    httpd_sess_map_remove(hd, sd);
+    sd->fd = -1;
+    sd->lru_prev = hd->hd_sd_free;
+    hd->hd_sd_free = sd;
+}
+
 bool httpd_is_sess_available(struct httpd_data *hd)
 {
-    int i;
-    for (i = 0; i < hd->config.max_open_sockets; i++) {
-        if (hd->hd_sd[i].fd == -1) {
+    return hd->hd_sd_free != NULL;
+}
+
+bool httpd_is_sess_idle(struct httpd_data *hd)
+{
+    for (struct sock_db *sd = hd->hd_lru_head; sd; sd = sd->lru_next) {
+        if (!sd->busy) {
             return true;
         }
     }
@@ -35,22 +122,14 @@ bool httpd_is_sess_available(struct httpd_data *hd)
 
 struct sock_db *httpd_sess_get(struct httpd_data *hd, int sockfd)
 {
-    if (hd == NULL) {
+    if (hd == NULL || sockfd < 0) {
         return NULL;
     }
 
-    /* Check if called inside a request handler, and the
-     * session sockfd in use is same as the parameter */
-    if ((hd->hd_req_aux.sd) && (hd->hd_req_aux.sd->fd == sockfd)) {
-        /* Just return the pointer to the sock_db
-         * corresponding to the request */
-        return hd->hd_req_aux.sd;
-    }
-
-    int i;
-    for (i = 0; i < hd->config.max_open_sockets; i++) {
-        if (hd->hd_sd[i].fd == sockfd) {
-            return &hd->hd_sd[i];
+    const unsigned mask = hd->hd_sd_map_size - 1;
+    for (unsigned i = httpd_sess_map_slot(hd, sockfd); hd->hd_sd_map[i]; i = (i + 1) & mask) {
+        if (hd->hd_sd_map[i]->fd == sockfd) {
+            return hd->hd_sd_map[i];
         }
     }
     return NULL;
@@ -65,25 +144,31 @@ esp_err_t httpd_sess_new(struct httpd_data *hd, int newfd)
         return ESP_FAIL;
     }
 
-    int i;
-    for (i = 0; i < hd->config.max_open_sockets; i++) {
-        if (hd->hd_sd[i].fd == -1) {
-            memset(&hd->hd_sd[i], 0, sizeof(hd->hd_sd[i]));
-            hd->hd_sd[i].fd = newfd;
-            hd->hd_sd[i].handle = (httpd_handle_t) hd;
-            hd->hd_sd[i].send_fn = httpd_default_send;
-            hd->hd_sd[i].recv_fn = httpd_default_recv;
-
-            /* Call user-defined session opening function */
-            if (hd->config.open_fn) {
-                esp_err_t ret = hd->config.open_fn(hd, hd->hd_sd[i].fd);
-                if (ret != ESP_OK) return ret;
-            }
-            return ESP_OK;
+    struct sock_db *sd = hd->hd_sd_free;
+    if (sd == NULL) {
+        ESP_LOGD(TAG, LOG_FMT("unable to launch session for fd = %d"), newfd);
+        return ESP_FAIL;
+    }
+    hd->hd_sd_free = sd->lru_prev;
+
+    memset(sd, 0, sizeof(*sd));
+    sd->fd = newfd;
+    sd->handle = (httpd_handle_t) hd;
+    sd->send_fn = httpd_default_send;
+    sd->recv_fn = httpd_default_recv;
+    httpd_sess_map_add(hd, sd);
+    httpd_sess_touch(hd, sd);
+
+    /* Call user-defined session opening function */
+    if (hd->config.open_fn) {
+        esp_err_t ret = hd->config.open_fn(hd, sd->fd);
+        if (ret != ESP_OK) {
+            /* The caller closes the socket */
+            httpd_sess_release(hd, sd);
+            return ret;
         }
     }
-    ESP_LOGD(TAG, LOG_FMT("unable to launch session for fd = %d"), newfd);
-    return ESP_FAIL;
+    return ESP_OK;
 }
 
 void httpd_sess_free_ctx(void *ctx, httpd_free_ctx_fn_t free_fn)
@@ -107,9 +192,8 @@ void *httpd_sess_get_ctx(httpd_handle_t handle, int sockfd)
     /* Check if the function has been called from inside a
      * request handler, in which case fetch the context from
      * the httpd_req_t structure */
-    struct httpd_data *hd = (struct httpd_data *) handle;
-    if (hd->hd_req_aux.sd == sd) {
-        return hd->hd_req.sess_ctx;
+    if (sd->req) {
+        return sd->req->sess_ctx;
     }
 
     return sd->ctx;
@@ -125,18 +209,18 @@ void httpd_sess_set_ctx(httpd_handle_t handle, int sockfd, void *ctx, httpd_free
     /* Check if the function has been called from inside a
      * request handler, in which case set the context inside
      * the httpd_req_t structure */
-    struct httpd_data *hd = (struct httpd_data *) handle;
-    if (hd->hd_req_aux.sd == sd) {
-        if (hd->hd_req.sess_ctx != ctx) {
+    httpd_req_t *r = sd->req;
+    if (r) {
+        if (r->sess_ctx != ctx) {
             /* Don't free previous context if it is in sockdb
              * as it will be freed inside httpd_req_cleanup() */
-            if (sd->ctx != hd->hd_req.sess_ctx) {
+            if (sd->ctx != r->sess_ctx) {
                 /* Free previous context */
-                httpd_sess_free_ctx(hd->hd_req.sess_ctx, hd->hd_req.free_ctx);
+                httpd_sess_free_ctx(r->sess_ctx, r->free_ctx);
             }
-            hd->hd_req.sess_ctx = ctx;
+            r->sess_ctx = ctx;
         }
-        hd->hd_req.free_ctx = free_fn;
+        r->free_ctx = free_fn;
         return;
     }
 
@@ -177,13 +261,13 @@ void httpd_sess_set_transport_ctx(httpd_handle_t handle, int sockfd, void *ctx,
 void httpd_sess_set_descriptors(struct httpd_data *hd,
                                 fd_set *fdset, int *maxfd)
 {
-    int i;
     *maxfd = -1;
-    for (i = 0; i < hd->config.max_open_sockets; i++) {
-        if (hd->hd_sd[i].fd != -1) {
-            FD_SET(hd->hd_sd[i].fd, fdset);
-            if (hd->hd_sd[i].fd > *maxfd) {
-                *maxfd = hd->hd_sd[i].fd;
+    for (struct sock_db *sd = hd->hd_lru_head; sd; sd = sd->lru_next) {
+        /* Sessions owned by a worker task are not watched until it is done */
+        if (!sd->busy) {
+            FD_SET(sd->fd, fdset);
+            if (sd->fd > *maxfd) {
+                *maxfd = sd->fd;
             }
         }
     }
@@ -195,18 +279,14 @@ static int fd_is_valid(int fd)
     return fcntl(fd, F_GETFD) != -1 || errno != EBADF;
 }
 
-static inline uint64_t httpd_sess_get_lru_counter()
-{
-    static uint64_t lru_counter = 0;
-    return lru_counter++;
-}
-
 void httpd_sess_delete_invalid(struct httpd_data *hd)
 {
-    for (int i = 0; i < hd->config.max_open_sockets; i++) {
-        if (hd->hd_sd[i].fd != -1 && !fd_is_valid(hd->hd_sd[i].fd)) {
-            ESP_LOGW(TAG, LOG_FMT("Closing invalid socket %d"), hd->hd_sd[i].fd);
-            httpd_sess_delete(hd, hd->hd_sd[i].fd);
+    struct sock_db *next;
+    for (struct sock_db *sd = hd->hd_lru_head; sd; sd = next) {
+        next = sd->lru_next;
+        if (!sd->busy && !fd_is_valid(sd->fd)) {
+            ESP_LOGW(TAG, LOG_FMT("Closing invalid socket %d"), sd->fd);
+            httpd_sess_delete(hd, sd->fd);
         }
     }
 }
@@ -214,57 +294,64 @@ void httpd_sess_delete_invalid(struct httpd_data *hd)
 int httpd_sess_delete(struct httpd_data *hd, int fd)
 {
     ESP_LOGD(TAG, LOG_FMT("fd = %d"), fd);
-    int i;
-    int pre_sess_fd = -1;
-    for (i = 0; i < hd->config.max_open_sockets; i++) {
-        if (hd->hd_sd[i].fd == fd) {
-            /* global close handler */
-            if (hd->config.close_fn) {
-                hd->config.close_fn(hd, fd);
-            }
+    struct sock_db *sd = httpd_sess_get(hd, fd);
+    if (sd == NULL) {
+        return -1;
+    }
 
-            /* release 'user' context */
-            if (hd->hd_sd[i].ctx) {
-                if (hd->hd_sd[i].free_ctx) {
-                    hd->hd_sd[i].free_ctx(hd->hd_sd[i].ctx);
-                } else {
-                    free(hd->hd_sd[i].ctx);
-                }
-                hd->hd_sd[i].ctx = NULL;
-                hd->hd_sd[i].free_ctx = NULL;
-            }
+    /* global close handler */
+    if (hd->config.close_fn) {
+        hd->config.close_fn(hd, fd);
+    }
 
-            /* release 'transport' context */
-            if (hd->hd_sd[i].transport_ctx) {
-                if (hd->hd_sd[i].free_transport_ctx) {
-                    hd->hd_sd[i].free_transport_ctx(hd->hd_sd[i].transport_ctx);
-                } else {
-                    free(hd->hd_sd[i].transport_ctx);
-                }
-                hd->hd_sd[i].transport_ctx = NULL;
-                hd->hd_sd[i].free_transport_ctx = NULL;
-            }
+    /* release 'user' context */
+    if (sd->ctx) {
+        if (sd->free_ctx) {
+            sd->free_ctx(sd->ctx);
+        } else {
+            free(sd->ctx);
+        }
+        sd->ctx = NULL;
+        sd->free_ctx = NULL;
+    }
+
+    /* release 'transport' context */
+    if (sd->transport_ctx) {
+        if (sd->free_transport_ctx) {
+            sd->free_transport_ctx(sd->transport_ctx);
+        } else {
+            free(sd->transport_ctx);
+        }
+        sd->transport_ctx = NULL;
+        sd->free_transport_ctx = NULL;
+    }
 
-            /* mark session slot as available */
-            hd->hd_sd[i].fd = -1;
-            break;
-        } else if (hd->hd_sd[i].fd != -1) {
-            /* Return the fd just preceding the one being
-             * deleted so that iterator can continue from
-             * the correct fd */
-            pre_sess_fd = hd->hd_sd[i].fd;
+    /* mark session slot as available */
+    httpd_sess_release(hd, sd);
+
+    /* Return the fd just preceding the one being
+     * deleted so that iterator can continue from
+     * the correct fd */
+    for (struct sock_db *pre = sd; pre-- != hd->hd_sd; ) {
+        if (pre->fd != -1) {
+            return pre->fd;
         }
     }
-    return pre_sess_fd;
+    return -1;
 }
 
 void httpd_sess_init(struct httpd_data *hd)
 {
     int i;
-    for (i = 0; i < hd->config.max_open_sockets; i++) {
+    hd->hd_sd_free = NULL;
+    for (i = hd->config.max_open_sockets - 1; i >= 0; i--) {
         hd->hd_sd[i].fd = -1;
         hd->hd_sd[i].ctx = NULL;
+        hd->hd_sd[i].lru_prev = hd->hd_sd_free;
+        hd->hd_sd_free = &hd->hd_sd[i];
     }
+    memset(hd->hd_sd_map, 0, hd->hd_sd_map_size * sizeof(struct sock_db *));
+    hd->hd_lru_head = hd->hd_lru_tail = NULL;
 }
 
 bool httpd_sess_pending(struct httpd_data *hd, int fd)
@@ -287,23 +374,17 @@ bool httpd_sess_pending(struct httpd_data *hd, int fd)
  * value is returned, everything related to this socket will be
  * cleaned up and the socket will be closed.
  */
-esp_err_t httpd_sess_process(struct httpd_data *hd, int newfd)
+esp_err_t httpd_sess_process(struct httpd_data *hd, struct sock_db *sd, httpd_req_t *r)
 {
-    struct sock_db *sd = httpd_sess_get(hd, newfd);
-    if (! sd) {
-        return ESP_FAIL;
-    }
-
     ESP_LOGD(TAG, LOG_FMT("httpd_req_new"));
-    if (httpd_req_new(hd, sd) != ESP_OK) {
+    if (httpd_req_new(hd, r, sd) != ESP_OK) {
         return ESP_FAIL;
     }
     ESP_LOGD(TAG, LOG_FMT("httpd_req_delete"));
-    if (httpd_req_delete(hd) != ESP_OK) {
+    if (httpd_req_delete(hd, r) != ESP_OK) {
         return ESP_FAIL;
     }
     ESP_LOGD(TAG, LOG_FMT("success"));
-    sd->lru_counter = httpd_sess_get_lru_counter();
     return ESP_OK;
 }
 
@@ -315,36 +396,75 @@ esp_err_t httpd_sess_update_lru_counter(httpd_handle_t handle, int sockfd)
 
     /* Search for the socket database entry */
     struct httpd_data *hd = (struct httpd_data *) handle;
-    int i;
-    for (i = 0; i < hd->config.max_open_sockets; i++) {
-        if (hd->hd_sd[i].fd == sockfd) {
-            hd->hd_sd[i].lru_counter = httpd_sess_get_lru_counter();
-            return ESP_OK;
+    struct sock_db *sd = httpd_sess_get(hd, sockfd);
+    if (sd == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    /* Only the server task changes the LRU list, for other tasks
+     * the session is moved when the server task comes across it */
+    if (httpd_os_thread_handle() == hd->hd_td.handle) {
+        httpd_sess_touch(hd, sd);
+    } else {
+        sd->lru_touched = true;
+    }
+    return ESP_OK;
+}
+
+/* Find the least recently used session which may be closed */
+static struct sock_db *httpd_sess_get_lru(struct httpd_data *hd)
+{
+    struct sock_db *last = hd->hd_lru_tail;
+    struct sock_db *sd = hd->hd_lru_head;
+    while (sd) {
+        struct sock_db *next = (sd == last) ? NULL : sd->lru_next;
+        if (sd->lru_touched) {
+            httpd_sess_touch(hd, sd);
+        } else if (!sd->busy) {
+            /* Sessions owned by a worker task can't be closed right now */
+            return sd;
         }
+        sd = next;
     }
-    return ESP_ERR_NOT_FOUND;
+    return NULL;
 }
 
 esp_err_t httpd_sess_close_lru(struct httpd_data *hd)
 {
-    uint64_t lru_counter = UINT64_MAX;
-    int lru_fd = -1;
-    int i;
-    for (i = 0; i < hd->config.max_open_sockets; i++) {
-        /* If a descriptor is -1, there is no need to close any session.
-         * So, we can return from here, without finding the Least Recently Used
-         * session
-         */
-        if (hd->hd_sd[i].fd == -1) {
-            return ESP_OK;
-        }
-        if (hd->hd_sd[i].lru_counter < lru_counter) {
-            lru_counter = hd->hd_sd[i].lru_counter;
-            lru_fd = hd->hd_sd[i].fd;
+    /* If a slot is free, there is no need to close any session */
+    if (httpd_is_sess_available(hd)) {
+        return ESP_OK;
+    }
+    struct sock_db *sd = httpd_sess_get_lru(hd);
+    if (sd == NULL) {
+        /* All sessions are busy, the connection is accepted
+         * after one of the workers is done */
+        return ESP_OK;
+    }
+    ESP_LOGD(TAG, LOG_FMT("fd = %d"), sd->fd);
+    return httpd_sess_trigger_close(hd, sd->fd);
+}
+
+int64_t httpd_sess_close_idle(struct httpd_data *hd)
+{
+    if (hd->config.sess_idle_timeout == 0) {
+        return -1;
+    }
+
+    const int64_t timeout = (int64_t) hd->config.sess_idle_timeout * 1000000;
+    const int64_t now = esp_timer_get_time();
+    struct sock_db *sd;
+    while ((sd = httpd_sess_get_lru(hd)) != NULL) {
+        int64_t idle = now - sd->last_active;
+        if (idle < timeout) {
+            return timeout - idle;
         }
+        int fd = sd->fd;
+        ESP_LOGD(TAG, LOG_FMT("closing idle socket %d"), fd);
+        httpd_sess_delete(hd, fd);
+        close(fd);
     }
-    ESP_LOGD(TAG, LOG_FMT("fd = %d"), lru_fd);
-    return httpd_sess_trigger_close(hd, lru_fd);
+    return -1;
 }
 
 int httpd_sess_iterate(struct httpd_data *hd, int start_fd)
@@ -354,11 +474,9 @@ int httpd_sess_iterate(struct httpd_data *hd, int start_fd)
 
     if (start_fd != -1) {
         /* Take our index to where this fd is stored */
-        for (i = 0; i < hd->config.max_open_sockets; i++) {
-            if (hd->hd_sd[i].fd == start_fd) {
-                start_index = i + 1;
-                break;
-            }
+        struct sock_db *sd = httpd_sess_get(hd, start_fd);
+        if (sd) {
+            start_index = sd - hd->hd_sd + 1;
         }
     }
 
@@ -374,6 +492,12 @@ static void httpd_sess_close(void *arg)
 {
     struct sock_db *sock_db = (struct sock_db *)arg;
     if (sock_db) {
+        if (sock_db->busy) {
+            /* A worker task is processing a request on this session,
+             * it will be closed when the worker is done */
+            sock_db->close_pending = true;
+            return;
+        }
         int fd = sock_db->fd;
         struct httpd_data *hd = (struct httpd_data *) sock_db->handle;
         httpd_sess_delete(hd, fd);
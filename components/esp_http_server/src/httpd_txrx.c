@@ -14,8 +14,12 @@
 
 
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include <esp_log.h>
 #include <esp_err.h>
+#include <esp_spi_flash.h>
 
 #include <esp_http_server.h>
 #include "esp_httpd_priv.h"
@@ -380,6 +384,199 @@ esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t buf_len
     return ESP_OK;
 }
 
+/* Get a request header as string allocated from the request arena */
+static char *httpd_req_get_hdr_alloc(httpd_req_t *r, const char *field)
+{
+    size_t len = httpd_req_get_hdr_value_len(r, field);
+    if (len == 0) {
+        return NULL;
+    }
+    char *val = httpd_req_alloc(r, len + 1);
+    if (val == NULL || httpd_req_get_hdr_value_str(r, field, val, len + 1) != ESP_OK) {
+        return NULL;
+    }
+    return val;
+}
+
+/* Find the ETag set with httpd_resp_set_hdr() */
+static const char *httpd_resp_get_etag(httpd_req_t *r)
+{
+    struct httpd_req_aux *ra = r->aux;
+    for (unsigned i = 0; i < ra->resp_hdrs_count; i++) {
+        if (strcasecmp(ra->resp_hdrs[i].field, "ETag") == 0) {
+            return ra->resp_hdrs[i].value;
+        }
+    }
+    return NULL;
+}
+
+/* Send the headers of a response with a body of len bytes. The body
+ * isn't needed if the client has the data already, or for HEAD */
+static esp_err_t httpd_resp_send_body_hdrs(httpd_req_t *r, size_t len, bool *send_body)
+{
+    struct httpd_req_aux *ra = r->aux;
+    const char *etag = httpd_resp_get_etag(r);
+
+    *send_body = (r->method != HTTP_HEAD);
+    if (etag) {
+        const char *match = httpd_req_get_hdr_alloc(r, "If-None-Match");
+        if (match && (strcmp(match, "*") == 0 || strstr(match, etag))) {
+            ESP_LOGD(TAG, LOG_FMT("not modified, etag = %s"), etag);
+            ra->status = HTTPD_304;
+            *send_body = false;
+        }
+    }
+    /* Content-Length of a 304 response is that of the full response */
+    return httpd_resp_send(r, NULL, len);
+}
+
+esp_err_t httpd_resp_send_file(httpd_req_t *r, int fd, off_t offset, ssize_t len)
+{
+    if (r == NULL || offset < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!httpd_valid_req(r)) {
+        return ESP_ERR_HTTPD_INVALID_REQ;
+    }
+
+    struct stat st;
+    bool have_stat = (fstat(fd, &st) == 0 && S_ISREG(st.st_mode));
+    if (len < 0) {
+        if (!have_stat || offset > st.st_size) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        len = st.st_size - offset;
+    }
+
+    /* Without a modification time, changes which keep the
+     * size of the file would go unnoticed */
+    if (have_stat && st.st_mtime != 0 && httpd_resp_get_etag(r) == NULL) {
+        char *etag = httpd_req_alloc(r, 40);
+        if (etag) {
+            snprintf(etag, 40, "\"%lx-%lx-%lx-%x\"", (long) st.st_mtime,
+                     (long) st.st_size, (long) offset, len);
+            /* Fails only if there are too many headers already */
+            httpd_resp_set_hdr(r, "ETag", etag);
+        }
+    }
+
+    bool send_body;
+    esp_err_t ret = httpd_resp_send_body_hdrs(r, len, &send_body);
+    if (ret != ESP_OK || !send_body || len == 0) {
+        return ret;
+    }
+
+    const size_t buf_size = CONFIG_HTTPD_SEND_FILE_BUF_SIZE;
+    char *buf = malloc(MIN(len, buf_size));
+    if (buf == NULL) {
+        ESP_LOGE(TAG, LOG_FMT("no memory for file buffer"));
+        return ESP_ERR_NO_MEM;
+    }
+
+    while (len > 0) {
+        /* Keep the reads aligned to the buffer size in the file */
+        size_t n = MIN(len, buf_size - offset % buf_size);
+        ssize_t rd = pread(fd, buf, n, offset);
+        if (rd <= 0) {
+            ESP_LOGW(TAG, LOG_FMT("error reading file at %ld (%d)"), (long) offset, errno);
+            ret = ESP_FAIL;
+            break;
+        }
+        if (httpd_send_all(r, buf, rd) != ESP_OK) {
+            ret = ESP_ERR_HTTPD_RESP_SEND;
+            break;
+        }
+        offset += rd;
+        len    -= rd;
+    }
+    free(buf);
+    return ret;
+}
+
+esp_err_t httpd_resp_send_file_path(httpd_req_t *r, const char *path)
+{
+    if (r == NULL || path == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!httpd_valid_req(r)) {
+        return ESP_ERR_HTTPD_INVALID_REQ;
+    }
+
+    int fd = -1;
+    const char *encoding = httpd_req_get_hdr_alloc(r, "Accept-Encoding");
+    if (encoding && strstr(encoding, "gzip")) {
+        size_t path_len = strlen(path);
+        char *gz_path = httpd_req_alloc(r, path_len + sizeof(".gz"));
+        if (gz_path) {
+            memcpy(gz_path, path, path_len);
+            memcpy(gz_path + path_len, ".gz", sizeof(".gz"));
+            fd = open(gz_path, O_RDONLY);
+        }
+        if (fd >= 0) {
+            ESP_LOGD(TAG, LOG_FMT("sending %s"), gz_path);
+            httpd_resp_set_hdr(r, "Content-Encoding", "gzip");
+            httpd_resp_set_hdr(r, "Vary", "Accept-Encoding");
+        }
+    }
+    if (fd < 0) {
+        fd = open(path, O_RDONLY);
+    }
+    if (fd < 0) {
+        ESP_LOGD(TAG, LOG_FMT("can't open %s (%d)"), path, errno);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t ret = httpd_resp_send_file(r, fd, 0, -1);
+    close(fd);
+    return ret;
+}
+
+esp_err_t httpd_resp_send_partition(httpd_req_t *r, const esp_partition_t *partition,
+                                    size_t offset, ssize_t len)
+{
+    if (r == NULL || partition == NULL || offset > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!httpd_valid_req(r)) {
+        return ESP_ERR_HTTPD_INVALID_REQ;
+    }
+
+    if (len < 0) {
+        len = partition->size - offset;
+    } else if (len > partition->size - offset) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    bool send_body;
+    esp_err_t ret = httpd_resp_send_body_hdrs(r, len, &send_body);
+    if (ret != ESP_OK || !send_body) {
+        return ret;
+    }
+
+    while (len > 0) {
+        /* Map up to the end of the MMU page, so only one page is used */
+        size_t n = MIN(len, SPI_FLASH_MMU_PAGE_SIZE -
+                            (partition->address + offset) % SPI_FLASH_MMU_PAGE_SIZE);
+        const void *ptr;
+        spi_flash_mmap_handle_t handle;
+        if (esp_partition_mmap(partition, offset, n, SPI_FLASH_MMAP_DATA, &ptr, &handle) != ESP_OK) {
+            ESP_LOGW(TAG, LOG_FMT("error mapping partition at 0x%x"), offset);
+            return ESP_FAIL;
+        }
+        ret = httpd_send_all(r, ptr, n);
+        spi_flash_munmap(handle);
+        if (ret != ESP_OK) {
+            return ESP_ERR_HTTPD_RESP_SEND;
+        }
+        offset += n;
+        len    -= n;
+    }
+    return ESP_OK;
+}
+
 esp_err_t httpd_resp_send_err(httpd_req_t *req, httpd_err_code_t error, const char *usr_msg)
 {
     esp_err_t ret;
@@ -535,6 +732,27 @@ int httpd_req_recv(httpd_req_t *r, char *buf, size_t buf_len)
     return ret;
 }
 
+void *httpd_req_alloc(httpd_req_t *r, size_t size)
+{
+    if (r == NULL) {
+        return NULL;
+    }
+
+    if (!httpd_valid_req(r)) {
+        ESP_LOGW(TAG, LOG_FMT("invalid request"));
+        return NULL;
+    }
+
+    struct httpd_req_aux *ra = r->aux;
+    if (ra->arena == NULL) {
+        ra->arena = heap_caps_arena_create(CONFIG_HTTPD_REQ_ARENA_CHUNK_SIZE, MALLOC_CAP_DEFAULT);
+        if (ra->arena == NULL) {
+            return NULL;
+        }
+    }
+    return heap_caps_arena_alloc(ra->arena, size);
+}
+
 int httpd_req_to_sockfd(httpd_req_t *r)
 {
     if (r == NULL) {
@@ -88,6 +88,119 @@ bool httpd_uri_match_wildcard(const char *template, const char *uri, size_t len)
     }
 }
 
+/* FNV-1a, computed incrementally over the characters of the URI so
+ * that the hashes of all its prefixes are available in one pass */
+#define ROUTE_HASH_INIT         2166136261U
+#define ROUTE_HASH_NEXT(h, c)   (((h) ^ (uint8_t) (c)) * 16777619U)
+
+/* Find the part of a template which every matching URI starts with.
+ * Returns false if the template can't match any URI */
+static bool httpd_uri_route_key(struct httpd_data *hd, const char *template,
+                                uint16_t *len, bool *exact)
+{
+    size_t tpl_len = strlen(template);
+    *exact = true;
+    if (hd->config.uri_match_fn == httpd_uri_match_wildcard) {
+        /* Same rules as in httpd_uri_match_wildcard() */
+        const char last = (const char) (tpl_len > 0 ? template[tpl_len - 1] : 0);
+        const char prevlast = (const char) (tpl_len > 1 ? template[tpl_len - 2] : 0);
+        const bool asterisk = last == '*' || (prevlast == '*' && last == '?');
+        const bool quest = last == '?' || (prevlast == '?' && last == '*');
+        if (tpl_len < asterisk + quest*2) {
+            return false;
+        }
+        tpl_len -= asterisk + quest*2;
+        *exact = !asterisk && !quest;
+    }
+    if (tpl_len > UINT16_MAX) {
+        return false;
+    }
+    *len = tpl_len;
+    return true;
+}
+
+/* Rebuild the lookup table after the handlers have changed. Lookups
+ * fall back to the linear search if there is no table, which is the
+ * case for custom uri_match_fn, whose rules aren't known */
+static void httpd_uri_routes_update(struct httpd_data *hd)
+{
+    free(hd->hd_routes);
+    hd->hd_routes = NULL;
+    hd->hd_routes_size = 0;
+    hd->hd_routes_prefix_lens = 0;
+    if (hd->config.uri_match_fn != NULL &&
+            hd->config.uri_match_fn != httpd_uri_match_wildcard) {
+        return;
+    }
+
+    unsigned count = 0;
+    while (count < hd->config.max_uri_handlers && hd->hd_calls[count]) {
+        count++;
+    }
+    /* Keep the table at most half full */
+    unsigned size = 8;
+    while (size < count * 2) {
+        size *= 2;
+    }
+    struct httpd_uri_route *routes = calloc(size, sizeof(struct httpd_uri_route));
+    if (routes == NULL) {
+        ESP_LOGW(TAG, LOG_FMT("no memory for the URI lookup table"));
+        return;
+    }
+
+    for (unsigned i = 0; i < count; i++) {
+        const char *template = hd->hd_calls[i]->uri;
+        uint16_t len;
+        bool exact;
+        if (!httpd_uri_route_key(hd, template, &len, &exact)) {
+            continue;
+        }
+        uint32_t hash = ROUTE_HASH_INIT;
+        for (uint16_t k = 0; k < len; k++) {
+            hash = ROUTE_HASH_NEXT(hash, template[k]);
+        }
+        unsigned slot = hash & (size - 1);
+        while (routes[slot].uri) {
+            slot = (slot + 1) & (size - 1);
+        }
+        routes[slot] = (struct httpd_uri_route) {
+            .uri = hd->hd_calls[i],
+            .hash = hash,
+            .len = len,
+            .order = i,
+            .exact = exact,
+        };
+        if (!exact) {
+            hd->hd_routes_prefix_lens |= 1ULL << MIN(len, 63);
+        }
+    }
+    hd->hd_routes = routes;
+    hd->hd_routes_size = size;
+}
+
+/* Check the handlers whose key has the given hash and length */
+static void httpd_uri_routes_probe(struct httpd_data *hd, uint32_t hash, size_t len, bool exact,
+                                   const char *uri, size_t uri_len, httpd_method_t method,
+                                   struct httpd_uri_route **found, bool *uri_found)
+{
+    const unsigned mask = hd->hd_routes_size - 1;
+    for (unsigned slot = hash & mask; hd->hd_routes[slot].uri; slot = (slot + 1) & mask) {
+        struct httpd_uri_route *route = &hd->hd_routes[slot];
+        if (route->hash != hash || route->len != len || route->exact != exact) {
+            continue;
+        }
+        if (exact ? strncmp(route->uri->uri, uri, len) != 0 :
+                    !httpd_uri_match_wildcard(route->uri->uri, uri, uri_len)) {
+            continue;
+        }
+        if (route->uri->method != method) {
+            *uri_found = true;
+        } else if (*found == NULL || route->order < (*found)->order) {
+            *found = route;
+        }
+    }
+}
+
 /* Find handler with matching URI and method, and set
  * appropriate error code if URI or method not found */
 static httpd_uri_t* httpd_find_uri_handler(struct httpd_data *hd,
@@ -99,6 +212,34 @@ static httpd_uri_t* httpd_find_uri_handler(struct httpd_data *hd,
         *err = HTTPD_404_NOT_FOUND;
     }
 
+    if (hd->hd_routes) {
+        /* All templates which can match are keyed by a prefix of the URI,
+         * so probe the table for the prefixes which are used as keys */
+        struct httpd_uri_route *found = NULL;
+        bool uri_found = false;
+        uint32_t hash = ROUTE_HASH_INIT;
+        for (size_t k = 0; ; k++) {
+            if (hd->hd_routes_prefix_lens & (1ULL << MIN(k, 63))) {
+                httpd_uri_routes_probe(hd, hash, k, false, uri, uri_len, method, &found, &uri_found);
+            }
+            if (k == uri_len) {
+                httpd_uri_routes_probe(hd, hash, k, true, uri, uri_len, method, &found, &uri_found);
+                break;
+            }
+            hash = ROUTE_HASH_NEXT(hash, uri[k]);
+        }
+        if (found) {
+            if (err) {
+                *err = 0;
+            }
+            return found->uri;
+        }
+        if (err && uri_found) {
+            *err = HTTPD_405_METHOD_NOT_ALLOWED;
+        }
+        return NULL;
+    }
+
     for (int i = 0; i < hd->config.max_uri_handlers; i++) {
         if (!hd->hd_calls[i]) {
             break;
@@ -140,6 +281,13 @@ esp_err_t httpd_register_uri_handler(httpd_handle_t handle,
 
     struct httpd_data *hd = (struct httpd_data *) handle;
 
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    /* WebSocket handshakes are GET requests */
+    if (uri_handler->is_websocket && uri_handler->method != HTTP_GET) {
+        return ESP_ERR_INVALID_ARG;
+    }
+#endif
+
     /* Make sure another handler with matching URI and method
      * is not already registered. This will also catch cases
      * when a registered URI wildcard pattern already accounts
@@ -172,7 +320,11 @@ esp_err_t httpd_register_uri_handler(httpd_handle_t handle,
             hd->hd_calls[i]->method   = uri_handler->method;
             hd->hd_calls[i]->handler  = uri_handler->handler;
             hd->hd_calls[i]->user_ctx = uri_handler->user_ctx;
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+            hd->hd_calls[i]->is_websocket = uri_handler->is_websocket;
+#endif
             ESP_LOGD(TAG, LOG_FMT("[%d] installed %s"), i, uri_handler->uri);
+            httpd_uri_routes_update(hd);
             return ESP_OK;
         }
         ESP_LOGD(TAG, LOG_FMT("[%d] exists %s"), i, hd->hd_calls[i]->uri);
@@ -211,6 +363,7 @@ esp_err_t httpd_unregister_uri_handler(httpd_handle_t handle,
             }
             /* Nullify the following non null entry */
             hd->hd_calls[i-1] = NULL;
+            httpd_uri_routes_update(hd);
             return ESP_OK;
         }
     }
@@ -254,6 +407,8 @@ esp_err_t httpd_unregister_uri(httpd_handle_t handle, const char *uri)
 
     if (!found) {
         ESP_LOGW(TAG, LOG_FMT("no handler found for URI %s"), uri);
+    } else {
+        httpd_uri_routes_update(hd);
     }
     return (found ? ESP_OK : ESP_ERR_NOT_FOUND);
 }
@@ -270,13 +425,15 @@ void httpd_unregister_all_uri_handlers(struct httpd_data *hd)
         free(hd->hd_calls[i]);
         hd->hd_calls[i] = NULL;
     }
+    free(hd->hd_routes);
+    hd->hd_routes = NULL;
+    hd->hd_routes_size = 0;
 }
 
-esp_err_t httpd_uri(struct httpd_data *hd)
+esp_err_t httpd_uri(struct httpd_data *hd, httpd_req_t *req)
 {
     httpd_uri_t            *uri = NULL;
-    httpd_req_t            *req = &hd->hd_req;
-    struct http_parser_url *res = &hd->hd_req_aux.url_parse_res;
+    struct http_parser_url *res = &((struct httpd_req_aux *) req->aux)->url_parse_res;
 
     /* For conveying URI not found/method not allowed */
     httpd_err_code_t err = 0;
@@ -307,6 +464,24 @@ esp_err_t httpd_uri(struct httpd_data *hd)
     /* Attach user context data (passed during URI registration) into request */
     req->user_ctx = uri->user_ctx;
 
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    struct httpd_req_aux *ra = req->aux;
+    if (uri->is_websocket != ra->ws_handshake_detect) {
+        ESP_LOGW(TAG, LOG_FMT("URI '%s' %s a WebSocket handshake"), req->uri,
+                 uri->is_websocket ? "expects" : "doesn't expect");
+        return httpd_req_handle_err(req, HTTPD_400_BAD_REQUEST);
+    }
+    if (uri->is_websocket) {
+        if (httpd_ws_respond_server_handshake(req) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        /* Later frames of the session go straight to the handler */
+        ra->sd->ws_handshake_done = true;
+        ra->sd->ws_handler = uri->handler;
+        ra->sd->ws_user_ctx = uri->user_ctx;
+    }
+#endif
+
     /* Invoke handler */
     if (uri->handler(req) != ESP_OK) {
         /* Handler returns error, this socket should be closed */
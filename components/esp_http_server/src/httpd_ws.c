@@ -0,0 +1,327 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <stdlib.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <mbedtls/sha1.h>
+#include <mbedtls/base64.h>
+
+#include <esp_http_server.h>
+#include "esp_httpd_priv.h"
+
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+
+static const char *TAG = "httpd_ws";
+
+#define HTTPD_WS_FIN_BIT        0x80
+#define HTTPD_WS_RSV_BITS       0x70
+#define HTTPD_WS_OPCODE_BITS    0x0f
+#define HTTPD_WS_MASK_BIT       0x80
+#define HTTPD_WS_LEN_BITS       0x7f
+
+/* Largest payload of a control frame, and of a frame whose
+ * length fits in the first length byte */
+#define HTTPD_WS_SHORT_LEN      125
+
+/* See RFC6455 Section 1.3 */
+static const char ws_magic_uuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+esp_err_t httpd_ws_respond_server_handshake(httpd_req_t *req)
+{
+    /* Base64 encoding of a 16 byte nonce is 24 characters */
+    char key[24 + sizeof(ws_magic_uuid)];
+    if (httpd_req_get_hdr_value_len(req, "Sec-WebSocket-Key") != 24 ||
+            httpd_req_get_hdr_value_str(req, "Sec-WebSocket-Key", key, 25) != ESP_OK) {
+        ESP_LOGW(TAG, LOG_FMT("invalid Sec-WebSocket-Key"));
+        httpd_req_handle_err(req, HTTPD_400_BAD_REQUEST);
+        return ESP_FAIL;
+    }
+
+    /* Accept key is the Base64 encoded SHA1 of the key and the magic UUID */
+    memcpy(key + 24, ws_magic_uuid, sizeof(ws_magic_uuid));
+    unsigned char sha1[20];
+    mbedtls_sha1_ret((const unsigned char *) key, strlen(key), sha1);
+    unsigned char accept[29];
+    size_t accept_len;
+    mbedtls_base64_encode(accept, sizeof(accept), &accept_len, sha1, sizeof(sha1));
+
+    char resp[sizeof("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                     "Connection: Upgrade\r\nSec-WebSocket-Accept: \r\n\r\n") + sizeof(accept)];
+    int len = snprintf(resp, sizeof(resp), "HTTP/1.1 101 Switching Protocols\r\n"
+                       "Upgrade: websocket\r\n"
+                       "Connection: Upgrade\r\n"
+                       "Sec-WebSocket-Accept: %s\r\n\r\n", accept);
+    ESP_LOGD(TAG, LOG_FMT("accept key = %s"), accept);
+
+    /* Request headers are no longer available */
+    struct httpd_req_aux *ra = req->aux;
+    ra->req_hdrs_count = 0;
+
+    for (int sent = 0; sent < len; ) {
+        int ret = httpd_send(req, resp + sent, len - sent);
+        if (ret < 0) {
+            return ESP_FAIL;
+        }
+        sent += ret;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t httpd_ws_send_all(struct sock_db *sd, const uint8_t *buf, size_t len)
+{
+    while (len > 0) {
+        int ret = sd->send_fn(sd->handle, sd->fd, (const char *) buf, len, 0);
+        if (ret < 0) {
+            ESP_LOGD(TAG, LOG_FMT("error in send_fn"));
+            return ESP_FAIL;
+        }
+        buf += ret;
+        len -= ret;
+    }
+    return ESP_OK;
+}
+
+/* Frames sent by the server are not masked, so the header is
+ * 2 bytes for the short payloads usually pushed to clients */
+static esp_err_t httpd_ws_send(struct sock_db *sd, const httpd_ws_frame_t *frame)
+{
+    if (frame->len && frame->payload == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t buf[10 + HTTPD_WS_SHORT_LEN];
+    size_t hdr_len;
+    buf[0] = (frame->fragmented ? 0 : HTTPD_WS_FIN_BIT) | (frame->type & HTTPD_WS_OPCODE_BITS);
+    if (frame->len <= HTTPD_WS_SHORT_LEN) {
+        buf[1] = frame->len;
+        hdr_len = 2;
+    } else if (frame->len <= UINT16_MAX) {
+        buf[1] = 126;
+        buf[2] = frame->len >> 8;
+        buf[3] = frame->len;
+        hdr_len = 4;
+    } else {
+        buf[1] = 127;
+        memset(buf + 2, 0, 4);
+        buf[6] = frame->len >> 24;
+        buf[7] = frame->len >> 16;
+        buf[8] = frame->len >> 8;
+        buf[9] = frame->len;
+        hdr_len = 10;
+    }
+
+    /* Send short frames with a single write */
+    if (frame->len <= HTTPD_WS_SHORT_LEN) {
+        if (frame->len) {
+            memcpy(buf + hdr_len, frame->payload, frame->len);
+        }
+        return httpd_ws_send_all(sd, buf, hdr_len + frame->len);
+    }
+    if (httpd_ws_send_all(sd, buf, hdr_len) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    return httpd_ws_send_all(sd, frame->payload, frame->len);
+}
+
+/* Receive exactly len bytes of the frame header */
+static esp_err_t httpd_ws_recv_hdr(httpd_req_t *r, uint8_t *buf, size_t len)
+{
+    while (len > 0) {
+        int ret = httpd_recv_with_opt(r, (char *) buf, len, false);
+        if (ret <= 0) {
+            ESP_LOGD(TAG, LOG_FMT("error in recv (%d)"), ret);
+            return ESP_FAIL;
+        }
+        buf += ret;
+        len -= ret;
+    }
+    return ESP_OK;
+}
+
+/* Receive payload of the current frame and unmask it in place */
+static esp_err_t httpd_ws_recv_payload(httpd_req_t *r, uint8_t *buf, size_t len)
+{
+    struct httpd_req_aux *ra = r->aux;
+    while (len > 0) {
+        int ret = httpd_req_recv(r, (char *) buf, len);
+        if (ret <= 0) {
+            ESP_LOGD(TAG, LOG_FMT("error in recv (%d)"), ret);
+            return ESP_FAIL;
+        }
+        for (int i = 0; i < ret; i++) {
+            buf[i] ^= ra->ws_mask[(ra->ws_offset + i) % 4];
+        }
+        ra->ws_offset += ret;
+        buf += ret;
+        len -= ret;
+    }
+    return ESP_OK;
+}
+
+esp_err_t httpd_ws_process_frame(struct httpd_data *hd, httpd_req_t *r)
+{
+    struct httpd_req_aux *ra = r->aux;
+    struct sock_db *sd = ra->sd;
+
+    uint8_t hdr[8];
+    if (httpd_ws_recv_hdr(r, hdr, 2) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    ra->ws_final = (hdr[0] & HTTPD_WS_FIN_BIT) != 0;
+    ra->ws_type = hdr[0] & HTTPD_WS_OPCODE_BITS;
+
+    /* Frames from clients must be masked, and there are no extensions */
+    if ((hdr[0] & HTTPD_WS_RSV_BITS) || !(hdr[1] & HTTPD_WS_MASK_BIT)) {
+        ESP_LOGW(TAG, LOG_FMT("invalid frame header 0x%02x%02x"), hdr[0], hdr[1]);
+        return ESP_FAIL;
+    }
+
+    uint64_t len = hdr[1] & HTTPD_WS_LEN_BITS;
+    if (len == 126 || len == 127) {
+        size_t ext_len = (len == 126) ? 2 : 8;
+        if (httpd_ws_recv_hdr(r, hdr, ext_len) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        len = 0;
+        for (size_t i = 0; i < ext_len; i++) {
+            len = (len << 8) | hdr[i];
+        }
+        if (len > SIZE_MAX) {
+            ESP_LOGW(TAG, LOG_FMT("frame too large"));
+            return ESP_FAIL;
+        }
+    }
+    if (httpd_ws_recv_hdr(r, ra->ws_mask, sizeof(ra->ws_mask)) != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    ESP_LOGD(TAG, LOG_FMT("frame type = %d, final = %d, length = %llu"),
+             ra->ws_type, ra->ws_final, len);
+    ra->ws_frame = true;
+    ra->ws_offset = 0;
+    ra->remaining_len = len;
+    r->content_len = len;
+
+    if (ra->ws_type & 0x8) {
+        /* Control frames are short and not fragmented */
+        if (len > HTTPD_WS_SHORT_LEN || !ra->ws_final) {
+            ESP_LOGW(TAG, LOG_FMT("invalid control frame"));
+            return ESP_FAIL;
+        }
+        uint8_t payload[HTTPD_WS_SHORT_LEN];
+        if (httpd_ws_recv_payload(r, payload, len) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        httpd_ws_frame_t frame = {
+            .payload = payload,
+            .len = len,
+        };
+        switch (ra->ws_type) {
+        case HTTPD_WS_TYPE_PING:
+            frame.type = HTTPD_WS_TYPE_PONG;
+            return httpd_ws_send(sd, &frame);
+        case HTTPD_WS_TYPE_CLOSE:
+            /* Echo the status code and close the session */
+            frame.type = HTTPD_WS_TYPE_CLOSE;
+            frame.len = MIN(len, 2);
+            httpd_ws_send(sd, &frame);
+            ESP_LOGD(TAG, LOG_FMT("close frame on socket %d"), sd->fd);
+            return ESP_FAIL;
+        default:
+            /* Pong, or unknown control frame */
+            return ESP_OK;
+        }
+    }
+
+    r->user_ctx = sd->ws_user_ctx;
+    if (sd->ws_handler(r) != ESP_OK) {
+        ESP_LOGW(TAG, LOG_FMT("websocket handler execution failed"));
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *frame, size_t max_len)
+{
+    if (req == NULL || frame == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!httpd_valid_req(req)) {
+        return ESP_ERR_HTTPD_INVALID_REQ;
+    }
+
+    struct httpd_req_aux *ra = req->aux;
+    if (!ra->ws_frame) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    frame->type = ra->ws_type;
+    frame->final = ra->ws_final;
+    if (max_len == 0) {
+        frame->len = ra->remaining_len;
+        return ESP_OK;
+    }
+    if (frame->payload == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    frame->len = MIN(max_len, ra->remaining_len);
+    return httpd_ws_recv_payload(req, frame->payload, frame->len);
+}
+
+esp_err_t httpd_ws_send_frame(httpd_req_t *req, httpd_ws_frame_t *frame)
+{
+    if (req == NULL || frame == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!httpd_valid_req(req)) {
+        return ESP_ERR_HTTPD_INVALID_REQ;
+    }
+
+    struct httpd_req_aux *ra = req->aux;
+    if (!ra->sd->ws_handshake_done) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return httpd_ws_send(ra->sd, frame);
+}
+
+esp_err_t httpd_ws_send_frame_async(httpd_handle_t hd, int fd, httpd_ws_frame_t *frame)
+{
+    if (frame == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct sock_db *sd = httpd_sess_get(hd, fd);
+    if (sd == NULL || !sd->ws_handshake_done) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* The worker task owns the socket until it is done */
+    if (sd->busy) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return httpd_ws_send(sd, frame);
+}
+
+bool httpd_ws_is_websocket(httpd_handle_t hd, int fd)
+{
+    struct sock_db *sd = httpd_sess_get(hd, fd);
+    return sd && sd->ws_handshake_done;
+}
+
+#endif /* CONFIG_HTTPD_WS_SUPPORT */
@@ -251,3 +251,84 @@ TEST_CASE("Max Allowed Sockets Test", "[HTTP SERVER]")
     config.max_open_sockets += 1;
     TEST_ASSERT(httpd_start(&hd, &config) != ESP_OK);
 }
+
+TEST_CASE("Worker Tasks Test", "[HTTP SERVER]")
+{
+    test_case_uses_tcpip();
+
+    httpd_handle_t hd;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.worker_count = 2;
+
+    unsigned task_count = uxTaskGetNumberOfTasks();
+    TEST_ASSERT(httpd_start(&hd, &config) == ESP_OK);
+    vTaskDelay(10);
+    /* Server task and the worker tasks */
+    TEST_ASSERT_EQUAL(task_count + 1 + config.worker_count, uxTaskGetNumberOfTasks());
+    test_handler_limit(hd);
+
+    TEST_ASSERT(httpd_stop(hd) == ESP_OK);
+    vTaskDelay(10);
+    TEST_ASSERT_EQUAL(task_count, uxTaskGetNumberOfTasks());
+}
+
+TEST_CASE("URI Handler Lookup Test", "[HTTP SERVER]")
+{
+    test_case_uses_tcpip();
+
+    httpd_handle_t hd;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.uri_match_fn = httpd_uri_match_wildcard;
+
+    TEST_ASSERT(httpd_start(&hd, &config) == ESP_OK);
+
+    httpd_uri_t api = handler_limit_uri("/api/*");
+    httpd_uri_t item = handler_limit_uri("/api/item");
+    httpd_uri_t status = handler_limit_uri("/status");
+    httpd_uri_t sta = handler_limit_uri("/sta");
+    TEST_ASSERT(httpd_register_uri_handler(hd, &api) == ESP_OK);
+    TEST_ASSERT(httpd_register_uri_handler(hd, &status) == ESP_OK);
+    TEST_ASSERT(httpd_register_uri_handler(hd, &sta) == ESP_OK);
+
+    /* Already handled by the wildcard handler for the same method */
+    TEST_ASSERT(httpd_register_uri_handler(hd, &item) != ESP_OK);
+    item.method = HTTP_POST;
+    TEST_ASSERT(httpd_register_uri_handler(hd, &item) == ESP_OK);
+    TEST_ASSERT(httpd_register_uri_handler(hd, &status) != ESP_OK);
+
+    /* Lookups have to follow the handlers being removed */
+    TEST_ASSERT(httpd_unregister_uri_handler(hd, "/api/*", HTTP_GET) == ESP_OK);
+    item.method = HTTP_GET;
+    TEST_ASSERT(httpd_register_uri_handler(hd, &item) == ESP_OK);
+    TEST_ASSERT(httpd_unregister_uri(hd, "/api/item") == ESP_OK);
+    TEST_ASSERT(httpd_unregister_uri(hd, "/api/item") != ESP_OK);
+    TEST_ASSERT(httpd_register_uri_handler(hd, &api) == ESP_OK);
+
+    TEST_ASSERT(httpd_stop(hd) == ESP_OK);
+}
+
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+TEST_CASE("WebSocket Handler Registration Test", "[HTTP SERVER]")
+{
+    test_case_uses_tcpip();
+
+    httpd_handle_t hd;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    TEST_ASSERT(httpd_start(&hd, &config) == ESP_OK);
+
+    httpd_uri_t ws = handler_limit_uri("/ws");
+    ws.is_websocket = true;
+    ws.method = HTTP_POST;
+    /* Handshakes are GET requests */
+    TEST_ASSERT(httpd_register_uri_handler(hd, &ws) == ESP_ERR_INVALID_ARG);
+    ws.method = HTTP_GET;
+    TEST_ASSERT(httpd_register_uri_handler(hd, &ws) == ESP_OK);
+
+    /* Not a WebSocket session */
+    httpd_ws_frame_t frame = { .type = HTTPD_WS_TYPE_TEXT };
+    TEST_ASSERT(httpd_ws_send_frame_async(hd, 0, &frame) == ESP_ERR_INVALID_ARG);
+    TEST_ASSERT_FALSE(httpd_ws_is_websocket(hd, 0));
+
+    TEST_ASSERT(httpd_stop(hd) == ESP_OK);
+}
+#endif
@@ -30,6 +30,10 @@ extern "C" {
  * @note     For secure HTTPS updates, the `cert_pem` member of `config`
  *           structure must be set to the server certificate.
  *
+ * @note     If CONFIG_OTA_PIPELINE is enabled, the image is written to flash by a
+ *           separate task while it is downloaded, and the `buffer_size` member of
+ *           `config` only sets the receive buffer of the HTTP client.
+ *
  * @return
  *    - ESP_OK: OTA data updated, next reboot will use specified partition.
  *    - ESP_FAIL: For generic failure.
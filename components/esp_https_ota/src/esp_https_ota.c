@@ -18,6 +18,10 @@
 #include <esp_https_ota.h>
 #include <esp_ota_ops.h>
 #include <esp_log.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 
 #define DEFAULT_OTA_BUF_SIZE 256
 static const char *TAG = "esp_https_ota";
@@ -28,6 +32,164 @@ static void http_cleanup(esp_http_client_handle_t client)
     esp_http_client_cleanup(client);
 }
 
+#if !CONFIG_OTA_PIPELINE
+/* Reads a chunk from the network and writes it to flash, until all data is received */
+static esp_err_t ota_download(esp_http_client_handle_t client, esp_ota_handle_t update_handle,
+                              int alloc_size, int *binary_file_len)
+{
+    esp_err_t ota_write_err = ESP_OK;
+    char *upgrade_data_buf = (char *)malloc(alloc_size);
+    if (!upgrade_data_buf) {
+        ESP_LOGE(TAG, "Couldn't allocate memory to upgrade data buffer");
+        return ESP_ERR_NO_MEM;
+    }
+
+    while (1) {
+        int data_read = esp_http_client_read(client, upgrade_data_buf, alloc_size);
+        if (data_read == 0) {
+            ESP_LOGI(TAG, "Connection closed, all data received");
+            break;
+        }
+        if (data_read < 0) {
+            ESP_LOGE(TAG, "Error: SSL data read error");
+            break;
+        }
+        if (data_read > 0) {
+            ota_write_err = esp_ota_write(update_handle, (const void *) upgrade_data_buf, data_read);
+            if (ota_write_err != ESP_OK) {
+                break;
+            }
+            *binary_file_len += data_read;
+            ESP_LOGD(TAG, "Written image length %d", *binary_file_len);
+        }
+    }
+    free(upgrade_data_buf);
+    return ota_write_err;
+}
+
+#else // CONFIG_OTA_PIPELINE
+
+typedef struct {
+    char *data;
+    int len;                        /* 0 marks the end of the image */
+} ota_buffer_t;
+
+typedef struct {
+    esp_ota_handle_t update_handle;
+    QueueHandle_t free_queue;       /* Buffers which can be filled from the network */
+    QueueHandle_t full_queue;       /* Buffers waiting to be written to flash */
+    SemaphoreHandle_t done;         /* Given by the writer task when it exits */
+    volatile esp_err_t write_err;
+    int written;
+} ota_pipeline_t;
+
+/* Writes the buffers filled by esp_https_ota() to flash, and gives them back */
+static void ota_writer_task(void *arg)
+{
+    ota_pipeline_t *pipeline = (ota_pipeline_t *) arg;
+    ota_buffer_t buffer;
+    while (xQueueReceive(pipeline->full_queue, &buffer, portMAX_DELAY) == pdTRUE) {
+        if (buffer.len == 0) {
+            break;
+        }
+        // after an error, buffers are still given back so that the download can stop
+        if (pipeline->write_err == ESP_OK) {
+            pipeline->write_err = esp_ota_write(pipeline->update_handle, buffer.data, buffer.len);
+            pipeline->written += buffer.len;
+            ESP_LOGD(TAG, "Written image length %d", pipeline->written);
+        }
+        xQueueSend(pipeline->free_queue, &buffer, portMAX_DELAY);
+    }
+    xSemaphoreGive(pipeline->done);
+    vTaskDelete(NULL);
+}
+
+/* Reads from the network until the buffer is full or all data is received */
+static int ota_fill_buffer(esp_http_client_handle_t client, char *data, int size)
+{
+    int len = 0;
+    while (len < size) {
+        int data_read = esp_http_client_read(client, data + len, size - len);
+        if (data_read == 0) {
+            break;
+        }
+        if (data_read < 0) {
+            ESP_LOGE(TAG, "Error: SSL data read error");
+            break;
+        }
+        len += data_read;
+    }
+    return len;
+}
+
+/* Downloads the image into a set of buffers, while a separate task writes them to flash */
+static esp_err_t ota_download_pipelined(esp_http_client_handle_t client, esp_ota_handle_t update_handle,
+                                        int *binary_file_len)
+{
+    esp_err_t err = ESP_ERR_NO_MEM;
+    ota_pipeline_t pipeline = {
+        .update_handle = update_handle,
+        .free_queue = xQueueCreate(CONFIG_OTA_PIPELINE_BUFFERS, sizeof(ota_buffer_t)),
+        .full_queue = xQueueCreate(CONFIG_OTA_PIPELINE_BUFFERS + 1, sizeof(ota_buffer_t)),
+        .done = xSemaphoreCreateBinary(),
+        .write_err = ESP_OK,
+    };
+    char *buffers[CONFIG_OTA_PIPELINE_BUFFERS] = { 0 };
+    if (!pipeline.free_queue || !pipeline.full_queue || !pipeline.done) {
+        goto cleanup;
+    }
+    for (int i = 0; i < CONFIG_OTA_PIPELINE_BUFFERS; i++) {
+        buffers[i] = malloc(CONFIG_OTA_PIPELINE_BUFFER_SIZE);
+        if (!buffers[i]) {
+            goto cleanup;
+        }
+        ota_buffer_t buffer = { .data = buffers[i] };
+        xQueueSend(pipeline.free_queue, &buffer, 0);
+    }
+    if (xTaskCreate(&ota_writer_task, "ota_writer", CONFIG_OTA_PIPELINE_WRITER_STACK_SIZE,
+                    &pipeline, uxTaskPriorityGet(NULL), NULL) != pdPASS) {
+        goto cleanup;
+    }
+
+    ota_buffer_t buffer;
+    while (pipeline.write_err == ESP_OK) {
+        xQueueReceive(pipeline.free_queue, &buffer, portMAX_DELAY);
+        buffer.len = ota_fill_buffer(client, buffer.data, CONFIG_OTA_PIPELINE_BUFFER_SIZE);
+        if (buffer.len == 0) {
+            break;
+        }
+        xQueueSend(pipeline.full_queue, &buffer, portMAX_DELAY);
+        *binary_file_len += buffer.len;
+        if (buffer.len < CONFIG_OTA_PIPELINE_BUFFER_SIZE) {
+            break;
+        }
+    }
+    ESP_LOGI(TAG, "Connection closed, all data received");
+    buffer.len = 0;
+    xQueueSend(pipeline.full_queue, &buffer, portMAX_DELAY);
+    xSemaphoreTake(pipeline.done, portMAX_DELAY);
+    err = pipeline.write_err;
+
+cleanup:
+    if (err == ESP_ERR_NO_MEM) {
+        ESP_LOGE(TAG, "Couldn't allocate memory for the OTA pipeline");
+    }
+    for (int i = 0; i < CONFIG_OTA_PIPELINE_BUFFERS; i++) {
+        free(buffers[i]);
+    }
+    if (pipeline.free_queue) {
+        vQueueDelete(pipeline.free_queue);
+    }
+    if (pipeline.full_queue) {
+        vQueueDelete(pipeline.full_queue);
+    }
+    if (pipeline.done) {
+        vSemaphoreDelete(pipeline.done);
+    }
+    return err;
+}
+#endif // CONFIG_OTA_PIPELINE
+
 esp_err_t esp_https_ota(const esp_http_client_config_t *config)
 {
     if (!config) {
@@ -84,35 +246,13 @@ esp_err_t esp_https_ota(const esp_http_client_config_t *config)
     ESP_LOGI(TAG, "esp_ota_begin succeeded");
     ESP_LOGI(TAG, "Please Wait. This may take time");
 
-    esp_err_t ota_write_err = ESP_OK;
-    const int alloc_size = (config->buffer_size > 0) ? config->buffer_size : DEFAULT_OTA_BUF_SIZE;
-    char *upgrade_data_buf = (char *)malloc(alloc_size);
-    if (!upgrade_data_buf) {
-        ESP_LOGE(TAG, "Couldn't allocate memory to upgrade data buffer");
-        return ESP_ERR_NO_MEM;
-    }
-
     int binary_file_len = 0;
-    while (1) {
-        int data_read = esp_http_client_read(client, upgrade_data_buf, alloc_size);
-        if (data_read == 0) {
-            ESP_LOGI(TAG, "Connection closed, all data received");
-            break;
-        }
-        if (data_read < 0) {
-            ESP_LOGE(TAG, "Error: SSL data read error");
-            break;
-        }
-        if (data_read > 0) {
-            ota_write_err = esp_ota_write(update_handle, (const void *) upgrade_data_buf, data_read);
-            if (ota_write_err != ESP_OK) {
-                break;
-            }
-            binary_file_len += data_read;
-            ESP_LOGD(TAG, "Written image length %d", binary_file_len);
-        }
-    }
-    free(upgrade_data_buf);
+#if CONFIG_OTA_PIPELINE
+    esp_err_t ota_write_err = ota_download_pipelined(client, update_handle, &binary_file_len);
+#else
+    const int alloc_size = (config->buffer_size > 0) ? config->buffer_size : DEFAULT_OTA_BUF_SIZE;
+    esp_err_t ota_write_err = ota_download(client, update_handle, alloc_size, &binary_file_len);
+#endif
     http_cleanup(client); 
     ESP_LOGD(TAG, "Total binary data length writen: %d", binary_file_len);
     
@@ -61,10 +61,34 @@ struct httpd_ssl_config {
 
     /** Port used when transport mode is insecure (default 80) */
     uint16_t port_insecure;
+
+    /**
+     * Maximum number of TLS sessions cached for resumption by session ID
+     * (default 4). Resuming a session skips the key exchange of the handshake.
+     * Each cached session takes a few hundred bytes of RAM, 0 disables the cache.
+     */
+    uint16_t session_cache_size;
+
+    /**
+     * Issue RFC 5077 session tickets (default false). The session state is then
+     * stored by the client, at the cost of a per-server ticket key context.
+     */
+    bool session_tickets;
+
+    /** Lifetime of cached sessions and session tickets, in seconds (default 300) */
+    uint32_t session_timeout;
 };
 
 typedef struct httpd_ssl_config httpd_ssl_config_t;
 
+/**
+ * TLS session resumption statistics
+ */
+typedef struct {
+    uint32_t hits;      /*!< Handshakes which resumed a cached session or a session ticket */
+    uint32_t misses;    /*!< Sessions offered by clients which were unknown or had expired */
+} httpd_ssl_session_stats_t;
+
 /**
  * Default config struct init
  *
@@ -81,6 +105,7 @@ typedef struct httpd_ssl_config httpd_ssl_config_t;
         .task_priority      = tskIDLE_PRIORITY+5, \
         .stack_size         = 10240,              \
         .core_id            = tskNO_AFFINITY,     \
+        .worker_count       = 0,                  \
         .server_port        = 0,                  \
         .ctrl_port          = 32768,              \
         .max_open_sockets   = 4,                  \
@@ -90,6 +115,7 @@ typedef struct httpd_ssl_config httpd_ssl_config_t;
         .lru_purge_enable   = true,               \
         .recv_wait_timeout  = 5,                  \
         .send_wait_timeout  = 5,                  \
+        .sess_idle_timeout  = 0,                  \
         .global_user_ctx = NULL,                  \
         .global_user_ctx_free_fn = NULL,          \
         .global_transport_ctx = NULL,             \
@@ -105,6 +131,9 @@ typedef struct httpd_ssl_config httpd_ssl_config_t;
     .transport_mode = HTTPD_SSL_TRANSPORT_SECURE, \
     .port_secure = 443,                           \
     .port_insecure = 80,                          \
+    .session_cache_size = 4,                      \
+    .session_tickets = false,                     \
+    .session_timeout = 300,                       \
 }
 
 /**
@@ -124,6 +153,18 @@ esp_err_t httpd_ssl_start(httpd_handle_t *handle, httpd_ssl_config_t *config);
  */
 void httpd_ssl_stop(httpd_handle_t handle);
 
+/**
+ * Get the TLS session resumption statistics of a server
+ *
+ * @param[in] handle - server handle
+ * @param[out] stats - storage for the statistics
+ * @return
+ *  - ESP_OK : statistics are valid
+ *  - ESP_ERR_INVALID_ARG : null argument
+ *  - ESP_ERR_INVALID_STATE : the server doesn't use the secure transport mode
+ */
+esp_err_t httpd_ssl_get_session_stats(httpd_handle_t handle, httpd_ssl_session_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -146,6 +146,33 @@ static void free_secure_context(void *ctx)
     SSL_CTX_free(ctx);
 }
 
+/**
+ * Set up the session cache and session tickets of a SSL_CTX
+ *
+ * @param ctx
+ * @param config
+ */
+static void configure_session_resumption(SSL_CTX *ctx, const struct httpd_ssl_config *config)
+{
+    long mode = SSL_SESS_CACHE_SERVER;
+
+    if (config->session_cache_size == 0 && !config->session_tickets) {
+        return;
+    }
+    if (config->session_cache_size > 0) {
+        SSL_CTX_sess_set_cache_size(ctx, config->session_cache_size);
+    } else {
+        mode |= SSL_SESS_CACHE_NO_INTERNAL;
+    }
+    if (!config->session_tickets) {
+        SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+    }
+    SSL_CTX_set_timeout(ctx, config->session_timeout);
+    SSL_CTX_set_session_cache_mode(ctx, mode);
+    ESP_LOGD(TAG, "SSL session cache size %d, tickets %s",
+             config->session_cache_size, config->session_tickets ? "on" : "off");
+}
+
 /**
 * Create and perform basic init of a SSL_CTX, or return NULL on failure
 *
@@ -162,6 +189,7 @@ static SSL_CTX *create_secure_context(const struct httpd_ssl_config *config)
         ESP_LOGD(TAG, "SSL ctx set own cert");
         if (SSL_CTX_use_certificate_ASN1(ctx, config->cacert_len, config->cacert_pem)
             && SSL_CTX_use_PrivateKey_ASN1(0, ctx, config->prvtkey_pem, (long) config->prvtkey_len)) {
+            configure_session_resumption(ctx, config);
             return ctx;
         }
         else {
@@ -218,3 +246,19 @@ void httpd_ssl_stop(httpd_handle_t handle)
 {
     httpd_stop(handle);
 }
+
+esp_err_t httpd_ssl_get_session_stats(httpd_handle_t handle, httpd_ssl_session_stats_t *stats)
+{
+    if (handle == NULL || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    SSL_CTX *ctx = httpd_get_global_transport_ctx(handle);
+    if (ctx == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    stats->hits = SSL_CTX_sess_hits(ctx);
+    stats->misses = SSL_CTX_sess_misses(ctx);
+    return ESP_OK;
+}
@@ -0,0 +1,4 @@
+#
+# Component Makefile
+#
+COMPONENT_ADD_INCLUDEDIRS := include
@@ -0,0 +1,526 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/* Work-stealing executor with one worker task per core.
+
+   Each worker owns a fixed size Chase-Lev deque of job pointers (Le, Pop,
+   Cohen, Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory
+   Models", PPoPP 2013). The owner pushes and takes at the bottom, other
+   workers steal at the top. Jobs submitted by tasks which are not workers go
+   to a FIFO protected by a spinlock instead.
+
+   Jobs are not allocated: their storage is provided by the code which waits
+   for them (esp_parallel_task_t, or a frame of run_range() for the halves of
+   esp_parallel_for()). A worker waiting for jobs keeps running other jobs,
+   so nested parallelism does not block a core. Idle workers sleep on their
+   task notification after a short spin.
+*/
+
+#include <stdatomic.h>
+#include <string.h>
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_parallel.h"
+
+#define DEQUE_SIZE          CONFIG_ESP_PARALLEL_DEQUE_SIZE
+#define DEQUE_MASK          (DEQUE_SIZE - 1)
+
+/* Searches for a job before an idle worker goes to sleep */
+#define IDLE_SPINS          100
+
+/* Default grain of esp_parallel_for(), in chunks per core */
+#define CHUNKS_PER_CORE     8
+
+_Static_assert((DEQUE_SIZE & DEQUE_MASK) == 0, "CONFIG_ESP_PARALLEL_DEQUE_SIZE must be a power of 2");
+
+static const char *TAG = "esp_parallel";
+
+typedef struct parallel_group parallel_group_t;
+
+/* Counts the jobs of a group which are not done */
+typedef struct {
+    atomic_uint pending;
+    parallel_group_t *ext;          // set if waited for by a task which is not a worker
+} group_t;
+
+typedef struct job {
+    void (*run)(struct job *job);
+    struct job *next;               // in s_inject
+    group_t *group;
+} job_t;
+
+/* esp_parallel_task_t */
+typedef struct {
+    job_t job;
+    esp_parallel_fn_t fn;
+    void *arg;
+} task_job_t;
+
+/* esp_parallel_group_t */
+struct parallel_group {
+    group_t group;
+    portMUX_TYPE mux;               // protects pending and waiting for a waiter which is not a worker
+    int waiting;
+    SemaphoreHandle_t sem;
+    StaticSemaphore_t sem_buf;
+};
+
+_Static_assert(sizeof(esp_parallel_task_t) == sizeof(task_job_t), "esp_parallel_task_t != task_job_t");
+_Static_assert(sizeof(esp_parallel_group_t) == sizeof(parallel_group_t), "esp_parallel_group_t != parallel_group_t");
+
+typedef struct {
+    esp_parallel_range_fn_t fn;
+    void *arg;
+    size_t grain;
+} range_ctx_t;
+
+typedef struct {
+    job_t job;
+    const range_ctx_t *ctx;
+    size_t begin;
+    size_t end;
+} range_job_t;
+
+typedef struct {
+    /* Indexes wrap around, they are compared by their difference */
+    atomic_uint top;
+    atomic_uint bottom;
+    _Atomic(job_t *) slots[DEQUE_SIZE];
+    atomic_int sleeping;
+    TaskHandle_t task;
+    int index;
+} worker_t;
+
+static worker_t s_workers[portNUM_PROCESSORS];
+static bool s_running;
+static atomic_bool s_stop;
+static TaskHandle_t s_deinit_waiter;
+
+/* Jobs submitted from other tasks */
+static portMUX_TYPE s_inject_mux = portMUX_INITIALIZER_UNLOCKED;
+static job_t *s_inject_head;
+static job_t *s_inject_tail;
+static atomic_int s_inject_count;
+
+/* Owner only, false if the deque is full */
+static bool deque_push(worker_t *w, job_t *job)
+{
+    unsigned b = atomic_load_explicit(&w->bottom, memory_order_relaxed);
+    unsigned t = atomic_load_explicit(&w->top, memory_order_acquire);
+    if ((int)(b - t) >= DEQUE_SIZE) {
+        return false;
+    }
+    atomic_store_explicit(&w->slots[b & DEQUE_MASK], job, memory_order_relaxed);
+    atomic_store_explicit(&w->bottom, b + 1, memory_order_release);
+    return true;
+}
+
+/* Owner only, LIFO */
+static job_t *deque_take(worker_t *w)
+{
+    unsigned b = atomic_load_explicit(&w->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&w->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    unsigned t = atomic_load_explicit(&w->top, memory_order_relaxed);
+    job_t *job = NULL;
+    if ((int)(b - t) >= 0) {
+        job = atomic_load_explicit(&w->slots[b & DEQUE_MASK], memory_order_relaxed);
+        if (b == t) {
+            /* last job, race with the thieves */
+            if (!atomic_compare_exchange_strong_explicit(&w->top, &t, t + 1,
+                    memory_order_seq_cst, memory_order_relaxed)) {
+                job = NULL;
+            }
+            atomic_store_explicit(&w->bottom, b + 1, memory_order_relaxed);
+        }
+    } else {
+        atomic_store_explicit(&w->bottom, b + 1, memory_order_relaxed);
+    }
+    return job;
+}
+
+/* Any worker, FIFO. NULL if empty or if another thief won. */
+static job_t *deque_steal(worker_t *w)
+{
+    unsigned t = atomic_load_explicit(&w->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    unsigned b = atomic_load_explicit(&w->bottom, memory_order_acquire);
+    if ((int)(b - t) <= 0) {
+        return NULL;
+    }
+    job_t *job = atomic_load_explicit(&w->slots[t & DEQUE_MASK], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&w->top, &t, t + 1,
+            memory_order_seq_cst, memory_order_relaxed)) {
+        return NULL;
+    }
+    return job;
+}
+
+static bool deque_empty(worker_t *w)
+{
+    unsigned t = atomic_load(&w->top);
+    unsigned b = atomic_load(&w->bottom);
+    return (int)(b - t) <= 0;
+}
+
+static void inject_push(job_t *job)
+{
+    job->next = NULL;
+    portENTER_CRITICAL(&s_inject_mux);
+    if (s_inject_tail) {
+        s_inject_tail->next = job;
+    } else {
+        s_inject_head = job;
+    }
+    s_inject_tail = job;
+    atomic_fetch_add(&s_inject_count, 1);
+    portEXIT_CRITICAL(&s_inject_mux);
+}
+
+static job_t *inject_pop(void)
+{
+    job_t *job = NULL;
+    if (atomic_load_explicit(&s_inject_count, memory_order_relaxed) == 0) {
+        return NULL;
+    }
+    portENTER_CRITICAL(&s_inject_mux);
+    job = s_inject_head;
+    if (job) {
+        s_inject_head = job->next;
+        if (!s_inject_head) {
+            s_inject_tail = NULL;
+        }
+        atomic_fetch_sub(&s_inject_count, 1);
+    }
+    portEXIT_CRITICAL(&s_inject_mux);
+    return job;
+}
+
+/* Wakes one sleeping worker other than self, after a job was published */
+static void wake_one(const worker_t *self)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    for (int i = 0; i < portNUM_PROCESSORS; i++) {
+        worker_t *w = &s_workers[i];
+        if (w != self && atomic_load_explicit(&w->sleeping, memory_order_relaxed) &&
+                atomic_exchange(&w->sleeping, 0)) {
+            xTaskNotifyGive(w->task);
+            return;
+        }
+    }
+}
+
+static job_t *find_job(worker_t *self)
+{
+    job_t *job = deque_take(self);
+    if (job) {
+        return job;
+    }
+    job = inject_pop();
+    if (job) {
+        return job;
+    }
+    for (int i = 1; i < portNUM_PROCESSORS; i++) {
+        job = deque_steal(&s_workers[(self->index + i) % portNUM_PROCESSORS]);
+        if (job) {
+            return job;
+        }
+    }
+    return NULL;
+}
+
+static bool has_job(void)
+{
+    if (atomic_load(&s_inject_count)) {
+        return true;
+    }
+    for (int i = 0; i < portNUM_PROCESSORS; i++) {
+        if (!deque_empty(&s_workers[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void group_done(group_t *group)
+{
+    parallel_group_t *ext = group->ext;
+    if (!ext) {
+        /* the waiter may return as soon as it sees pending at 0, group is not used after this */
+        atomic_fetch_sub_explicit(&group->pending, 1, memory_order_release);
+        return;
+    }
+    portENTER_CRITICAL(&ext->mux);
+    bool wake = atomic_fetch_sub(&group->pending, 1) == 1 && ext->waiting;
+    if (wake) {
+        ext->waiting = 0;
+    }
+    portEXIT_CRITICAL(&ext->mux);
+    /* the waiter does not return before the semaphore is given */
+    if (wake) {
+        xSemaphoreGive(ext->sem);
+    }
+}
+
+static void run_job(job_t *job)
+{
+    group_t *group = job->group;
+    job->run(job);
+    group_done(group);
+}
+
+static inline worker_t *current_worker(void)
+{
+    worker_t *w = &s_workers[xPortGetCoreID()];
+    return (w->task && w->task == xTaskGetCurrentTaskHandle()) ? w : NULL;
+}
+
+static void submit(worker_t *self, group_t *group, job_t *job)
+{
+    job->group = group;
+    atomic_fetch_add_explicit(&group->pending, 1, memory_order_relaxed);
+    if (self) {
+        if (!deque_push(self, job)) {
+            run_job(job);
+            return;
+        }
+    } else {
+        inject_push(job);
+    }
+    wake_one(self);
+}
+
+/* Worker only, runs other jobs until the group is done */
+static void worker_wait(worker_t *self, group_t *group)
+{
+    while (atomic_load_explicit(&group->pending, memory_order_acquire) != 0) {
+        job_t *job = find_job(self);
+        if (job) {
+            run_job(job);
+        }
+    }
+}
+
+static void worker_task(void *arg)
+{
+    worker_t *self = (worker_t *) arg;
+
+    while (!atomic_load(&s_stop)) {
+        job_t *job = NULL;
+        for (int i = 0; i < IDLE_SPINS && !job; i++) {
+            job = find_job(self);
+        }
+        if (job) {
+            run_job(job);
+            continue;
+        }
+        atomic_store(&self->sleeping, 1);
+        if (has_job() || atomic_load(&s_stop)) {
+            atomic_store(&self->sleeping, 0);
+            continue;
+        }
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        atomic_store(&self->sleeping, 0);
+    }
+
+    xTaskNotifyGive(s_deinit_waiter);
+    vTaskDelete(NULL);
+}
+
+esp_err_t esp_parallel_init(const esp_parallel_config_t *config)
+{
+    const esp_parallel_config_t default_config = ESP_PARALLEL_CONFIG_DEFAULT();
+    if (!config) {
+        config = &default_config;
+    }
+    if (s_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    memset(s_workers, 0, sizeof(s_workers));
+    atomic_store(&s_stop, false);
+    for (int i = 0; i < portNUM_PROCESSORS; i++) {
+        s_workers[i].index = i;
+    }
+    /* the workers steal from each other as soon as they run */
+    for (int i = 0; i < portNUM_PROCESSORS; i++) {
+        char name[] = "parallel0";
+        name[sizeof(name) - 2] += i;
+        if (xTaskCreatePinnedToCore(worker_task, name, config->task_stack_size, &s_workers[i],
+                                    config->task_priority, &s_workers[i].task, i) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create worker task %d", i);
+            s_running = true;
+            s_workers[i].task = NULL;
+            esp_parallel_deinit();
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    s_running = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_parallel_deinit(void)
+{
+    if (!s_running || current_worker()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_deinit_waiter = xTaskGetCurrentTaskHandle();
+    atomic_store(&s_stop, true);
+    int created = 0;
+    for (int i = 0; i < portNUM_PROCESSORS; i++) {
+        if (s_workers[i].task) {
+            created++;
+            xTaskNotifyGive(s_workers[i].task);
+        }
+    }
+    for (int i = 0; i < created; i++) {
+        ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+    }
+    memset(s_workers, 0, sizeof(s_workers));
+    s_running = false;
+    return ESP_OK;
+}
+
+bool esp_parallel_in_worker(void)
+{
+    return current_worker() != NULL;
+}
+
+void esp_parallel_group_init(esp_parallel_group_t *group)
+{
+    parallel_group_t *g = (parallel_group_t *) group;
+    atomic_init(&g->group.pending, 0);
+    g->group.ext = NULL;
+    g->sem = NULL;
+    if (!current_worker()) {
+        g->group.ext = g;
+        vPortCPUInitializeMutex(&g->mux);
+        g->waiting = 0;
+        g->sem = xSemaphoreCreateBinaryStatic(&g->sem_buf);
+    }
+}
+
+static void task_job_run(job_t *job)
+{
+    task_job_t *task = (task_job_t *) job;
+    task->fn(task->arg);
+}
+
+esp_err_t esp_parallel_group_run(esp_parallel_group_t *group, esp_parallel_task_t *task, esp_parallel_fn_t fn, void *arg)
+{
+    if (!fn) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    task_job_t *t = (task_job_t *) task;
+    t->job.run = task_job_run;
+    t->fn = fn;
+    t->arg = arg;
+    submit(current_worker(), &((parallel_group_t *) group)->group, &t->job);
+    return ESP_OK;
+}
+
+void esp_parallel_group_wait(esp_parallel_group_t *group)
+{
+    parallel_group_t *g = (parallel_group_t *) group;
+    if (!g->group.ext) {
+        worker_wait(current_worker(), &g->group);
+        return;
+    }
+    portENTER_CRITICAL(&g->mux);
+    bool wait = atomic_load(&g->group.pending) != 0;
+    g->waiting = wait;
+    portEXIT_CRITICAL(&g->mux);
+    if (wait) {
+        xSemaphoreTake(g->sem, portMAX_DELAY);
+    }
+}
+
+static void range_job_run(job_t *job);
+
+/* Splits the range in halves, the right halves are left to thieves */
+static void run_range(worker_t *self, const range_ctx_t *ctx, size_t begin, size_t end)
+{
+    if (end - begin <= ctx->grain) {
+        ctx->fn(begin, end, ctx->arg);
+        return;
+    }
+
+    size_t chunks = (end - begin + ctx->grain - 1) / ctx->grain;
+    group_t join = { .ext = NULL };
+    range_job_t right = {
+        .job.run = range_job_run,
+        .ctx = ctx,
+        .begin = begin + (chunks / 2) * ctx->grain,
+        .end = end,
+    };
+    atomic_init(&join.pending, 0);
+    submit(self, &join, &right.job);
+    run_range(self, ctx, begin, right.begin);
+    worker_wait(self, &join);
+}
+
+static void range_job_run(job_t *job)
+{
+    range_job_t *r = (range_job_t *) job;
+    run_range(current_worker(), r->ctx, r->begin, r->end);
+}
+
+esp_err_t esp_parallel_for(size_t begin, size_t end, size_t grain, esp_parallel_range_fn_t fn, void *arg)
+{
+    if (!fn) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (end <= begin) {
+        return ESP_OK;
+    }
+    if (grain == 0) {
+        grain = (end - begin + CHUNKS_PER_CORE * portNUM_PROCESSORS - 1) / (CHUNKS_PER_CORE * portNUM_PROCESSORS);
+    }
+
+    range_ctx_t ctx = {
+        .fn = fn,
+        .arg = arg,
+        .grain = grain,
+    };
+    worker_t *self = current_worker();
+    if (self) {
+        run_range(self, &ctx, begin, end);
+        return ESP_OK;
+    }
+    if (end - begin <= grain) {
+        fn(begin, end, arg);
+        return ESP_OK;
+    }
+
+    esp_parallel_group_t group;
+    range_job_t root = {
+        .job.run = range_job_run,
+        .ctx = &ctx,
+        .begin = begin,
+        .end = end,
+    };
+    esp_parallel_group_init(&group);
+    submit(NULL, &((parallel_group_t *) &group)->group, &root.job);
+    esp_parallel_group_wait(&group);
+    return ESP_OK;
+}
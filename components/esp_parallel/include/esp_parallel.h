@@ -0,0 +1,257 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Function run by a task of a task group
+ *
+ * @param arg Argument passed to esp_parallel_group_run()
+ */
+typedef void (*esp_parallel_fn_t)(void *arg);
+
+/**
+ * @brief Function run on a chunk of the range of esp_parallel_for()
+ *
+ * @param begin First index of the chunk
+ * @param end Index after the last index of the chunk
+ * @param arg Argument passed to esp_parallel_for()
+ */
+typedef void (*esp_parallel_range_fn_t)(size_t begin, size_t end, void *arg);
+
+/** Configuration of the executor */
+typedef struct {
+    size_t task_stack_size;     ///< Stack size of the worker tasks, in bytes
+    UBaseType_t task_priority;  ///< Priority of the worker tasks
+} esp_parallel_config_t;
+
+/** Executor configuration with the values set in menuconfig */
+#define ESP_PARALLEL_CONFIG_DEFAULT() {                         \
+    .task_stack_size = CONFIG_ESP_PARALLEL_TASK_STACK_SIZE,     \
+    .task_priority = CONFIG_ESP_PARALLEL_TASK_PRIORITY,         \
+}
+
+/**
+ * @brief Storage of a task run by esp_parallel_group_run()
+ *
+ * The contents are private. The storage must stay valid until esp_parallel_group_wait() returns.
+ */
+typedef struct {
+    /** @cond */    //Doxygen command to hide this structure from API Reference
+    void *pvDummy[5];
+    /** @endcond */
+} esp_parallel_task_t;
+
+/**
+ * @brief Task group
+ *
+ * The contents are private, a task group is initialized with esp_parallel_group_init().
+ */
+typedef struct {
+    /** @cond */    //Doxygen command to hide this structure from API Reference
+    uint32_t uDummy1;
+    void *pvDummy2;
+    portMUX_TYPE muxDummy;
+    int iDummy3;
+    SemaphoreHandle_t xDummy4;
+    StaticSemaphore_t xDummy5;
+    /** @endcond */
+} esp_parallel_group_t;
+
+/**
+ * @brief Start the executor
+ *
+ * Creates one worker task pinned to each core.
+ *
+ * @param config Configuration, NULL for ESP_PARALLEL_CONFIG_DEFAULT()
+ *
+ * @return
+ *      - ESP_OK Success
+ *      - ESP_ERR_INVALID_STATE The executor is already started
+ *      - ESP_ERR_NO_MEM A worker task could not be created
+ */
+esp_err_t esp_parallel_init(const esp_parallel_config_t *config);
+
+/**
+ * @brief Stop the executor and delete the worker tasks
+ *
+ * No task group or esp_parallel_for() may be in progress.
+ *
+ * @return
+ *      - ESP_OK Success
+ *      - ESP_ERR_INVALID_STATE The executor is not started, or called from a worker task
+ */
+esp_err_t esp_parallel_deinit(void);
+
+/**
+ * @brief Run a function on a range of indexes, in parallel on all cores
+ *
+ * The range [begin, end) is split in halves until the halves are at most grain
+ * indexes long. The halves are pushed to the work-stealing deque of the worker
+ * which split them, idle workers steal the oldest ones. fn is called once for
+ * each chunk, in no particular order, and returns when all chunks are done.
+ *
+ * When called from a task which is not a worker, the calling task blocks until
+ * the workers are done. A range of at most grain indexes is run in the calling task.
+ * When called from a worker, e.g. from fn or from a task of a task group, the
+ * worker runs other chunks and tasks while it waits.
+ *
+ * @param begin First index
+ * @param end Index after the last index
+ * @param grain Maximum number of indexes of a chunk. 0 selects a grain for about
+ *              8 chunks per core.
+ * @param fn Function called for each chunk
+ * @param arg Argument passed to fn
+ *
+ * @return
+ *      - ESP_OK Success, fn has been called for all indexes
+ *      - ESP_ERR_INVALID_ARG fn is NULL
+ *      - ESP_ERR_INVALID_STATE The executor is not started
+ */
+esp_err_t esp_parallel_for(size_t begin, size_t end, size_t grain, esp_parallel_range_fn_t fn, void *arg);
+
+/**
+ * @brief Initialize a task group
+ *
+ * A task group may be reused after esp_parallel_group_wait() returned. It must be
+ * waited for by the same task which initialized it.
+ *
+ * @param group Task group
+ */
+void esp_parallel_group_init(esp_parallel_group_t *group);
+
+/**
+ * @brief Run a function as a task of a task group
+ *
+ * From a worker, the task is pushed to the deque of the worker, or run immediately
+ * if the deque is full. From another task, it is queued for the workers.
+ *
+ * @param group Task group
+ * @param task Storage of the task, valid until esp_parallel_group_wait() returns
+ * @param fn Function
+ * @param arg Argument passed to fn
+ *
+ * @return
+ *      - ESP_OK Success
+ *      - ESP_ERR_INVALID_ARG fn is NULL
+ *      - ESP_ERR_INVALID_STATE The executor is not started
+ */
+esp_err_t esp_parallel_group_run(esp_parallel_group_t *group, esp_parallel_task_t *task, esp_parallel_fn_t fn, void *arg);
+
+/**
+ * @brief Wait until all tasks of a task group are done
+ *
+ * A worker runs other tasks while it waits, another task blocks.
+ *
+ * @param group Task group
+ */
+void esp_parallel_group_wait(esp_parallel_group_t *group);
+
+/**
+ * @brief Check if the calling task is a worker of the executor
+ *
+ * @return true if called from a worker task
+ */
+bool esp_parallel_in_worker(void);
+
+#ifdef __cplusplus
+}
+
+#include <type_traits>
+
+namespace esp_parallel {
+
+/** @cond */
+template <typename F>
+static void range_trampoline(size_t begin, size_t end, void *arg)
+{
+    (*static_cast<F *>(arg))(begin, end);
+}
+
+template <typename F>
+static void task_trampoline(void *arg)
+{
+    (*static_cast<F *>(arg))();
+}
+/** @endcond */
+
+/**
+ * @brief esp_parallel_for() with a callable, e.g. a lambda, called as f(begin, end)
+ *
+ * Exceptions must not leave f.
+ */
+template <typename F>
+esp_err_t parallel_for(size_t begin, size_t end, size_t grain, F &&f)
+{
+    typedef typename std::remove_reference<F>::type Fn;
+    return esp_parallel_for(begin, end, grain, range_trampoline<Fn>,
+                            const_cast<void *>(static_cast<const void *>(&f)));
+}
+
+/**
+ * @brief Task group running callables, waited for on destruction
+ *
+ * Exceptions must not leave the callables.
+ */
+class task_group {
+public:
+    task_group()
+    {
+        esp_parallel_group_init(&group);
+    }
+
+    ~task_group()
+    {
+        wait();
+    }
+
+    task_group(const task_group &) = delete;
+    task_group &operator=(const task_group &) = delete;
+
+    /**
+     * @brief Run f() as a task of the group, see esp_parallel_group_run()
+     *
+     * task and f must stay valid until wait() returns.
+     */
+    template <typename F>
+    esp_err_t run(esp_parallel_task_t &task, F &f)
+    {
+        return esp_parallel_group_run(&group, &task, task_trampoline<F>,
+                                      const_cast<void *>(static_cast<const void *>(&f)));
+    }
+
+    /** @brief Wait until all tasks of the group are done */
+    void wait()
+    {
+        esp_parallel_group_wait(&group);
+    }
+
+private:
+    esp_parallel_group_t group;
+};
+
+} // namespace esp_parallel
+
+#endif
@@ -0,0 +1,242 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "unity.h"
+#include "test_utils.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_parallel.h"
+
+#define N_INDEXES 2000
+
+/* Unity assertions can only fail in the test task, the workers count errors */
+static atomic_uchar s_hits[N_INDEXES];
+static atomic_int s_errors;
+
+static void mark_range(size_t begin, size_t end, void *arg)
+{
+    size_t grain = (size_t) arg;
+    if (end <= begin || (grain != 0 && end - begin > grain)) {
+        atomic_fetch_add(&s_errors, 1);
+    }
+    for (size_t i = begin; i < end; i++) {
+        atomic_fetch_add(&s_hits[i], 1);
+    }
+}
+
+static void check_hits(size_t begin, size_t end, int count)
+{
+    for (size_t i = 0; i < N_INDEXES; i++) {
+        TEST_ASSERT_EQUAL((i >= begin && i < end) ? count : 0, atomic_load(&s_hits[i]));
+        atomic_store(&s_hits[i], 0);
+    }
+    TEST_ASSERT_EQUAL(0, atomic_exchange(&s_errors, 0));
+}
+
+TEST_CASE("esp_parallel_for runs each index once", "[esp_parallel]")
+{
+    const size_t grains[] = { 1, 3, 16, 100, N_INDEXES, 0 };
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, esp_parallel_for(0, 10, 1, mark_range, NULL));
+    TEST_ESP_OK(esp_parallel_init(NULL));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, esp_parallel_init(NULL));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_parallel_for(0, 10, 1, NULL, NULL));
+
+    for (int i = 0; i < sizeof(grains) / sizeof(grains[0]); i++) {
+        TEST_ESP_OK(esp_parallel_for(0, N_INDEXES, grains[i], mark_range, (void *) grains[i]));
+        check_hits(0, N_INDEXES, 1);
+        TEST_ESP_OK(esp_parallel_for(7, N_INDEXES - 13, grains[i], mark_range, (void *) grains[i]));
+        check_hits(7, N_INDEXES - 13, 1);
+    }
+    TEST_ESP_OK(esp_parallel_for(5, 5, 1, mark_range, (void *) 1));
+    check_hits(0, 0, 0);
+
+    TEST_ESP_OK(esp_parallel_deinit());
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, esp_parallel_deinit());
+}
+
+#ifndef CONFIG_FREERTOS_UNICORE
+static atomic_int s_cores_seen;
+
+static void record_core(size_t begin, size_t end, void *arg)
+{
+    atomic_fetch_or(&s_cores_seen, 1 << xPortGetCoreID());
+    /* long enough for the other worker to steal */
+    vTaskDelay(1);
+}
+
+TEST_CASE("esp_parallel_for runs on both cores", "[esp_parallel]")
+{
+    TEST_ESP_OK(esp_parallel_init(NULL));
+    atomic_store(&s_cores_seen, 0);
+    TEST_ESP_OK(esp_parallel_for(0, 16, 1, record_core, NULL));
+    TEST_ASSERT_EQUAL(3, atomic_load(&s_cores_seen));
+    TEST_ESP_OK(esp_parallel_deinit());
+}
+#endif
+
+/* Each index of the outer range runs an inner esp_parallel_for() from a worker */
+static void nested_range(size_t begin, size_t end, void *arg)
+{
+    if (!esp_parallel_in_worker()) {
+        atomic_fetch_add(&s_errors, 1);
+    }
+    for (size_t i = begin; i < end; i++) {
+        if (esp_parallel_for(i * 20, (i + 1) * 20, 3, mark_range, (void *) 3) != ESP_OK) {
+            atomic_fetch_add(&s_errors, 1);
+        }
+    }
+}
+
+static atomic_int s_tasks_done;
+
+static void count_task(void *arg)
+{
+    atomic_fetch_add(&s_tasks_done, 1);
+}
+
+static void nested_group_task(void *arg)
+{
+    esp_parallel_group_t group;
+    esp_parallel_task_t tasks[10];
+
+    esp_parallel_group_init(&group);
+    for (int i = 0; i < 10; i++) {
+        if (esp_parallel_group_run(&group, &tasks[i], count_task, NULL) != ESP_OK) {
+            atomic_fetch_add(&s_errors, 1);
+        }
+    }
+    esp_parallel_group_wait(&group);
+}
+
+TEST_CASE("esp_parallel nested parallel_for and task groups", "[esp_parallel]")
+{
+    esp_parallel_group_t group;
+    esp_parallel_task_t tasks[20];
+
+    TEST_ESP_OK(esp_parallel_init(NULL));
+    TEST_ASSERT_FALSE(esp_parallel_in_worker());
+
+    TEST_ESP_OK(esp_parallel_for(0, N_INDEXES / 20, 2, nested_range, NULL));
+    check_hits(0, N_INDEXES, 1);
+
+    esp_parallel_group_init(&group);
+    for (int round = 0; round < 10; round++) {
+        atomic_store(&s_tasks_done, 0);
+        for (int i = 0; i < 20; i++) {
+            TEST_ESP_OK(esp_parallel_group_run(&group, &tasks[i], (i % 2) ? count_task : nested_group_task, NULL));
+        }
+        esp_parallel_group_wait(&group);
+        TEST_ASSERT_EQUAL(10 + 10 * 10, atomic_load(&s_tasks_done));
+        TEST_ASSERT_EQUAL(0, atomic_load(&s_errors));
+        /* waiting again for a done group returns immediately */
+        esp_parallel_group_wait(&group);
+    }
+    TEST_ESP_OK(esp_parallel_deinit());
+}
+
+static void parallel_for_task(void *arg)
+{
+    SemaphoreHandle_t done = (SemaphoreHandle_t) arg;
+    for (int i = 0; i < 50; i++) {
+        if (esp_parallel_for(0, N_INDEXES / 2, 7, mark_range, (void *) 7) != ESP_OK) {
+            atomic_fetch_add(&s_errors, 1);
+        }
+    }
+    xSemaphoreGive(done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("esp_parallel_for from several tasks at once", "[esp_parallel]")
+{
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(2, 0);
+    TEST_ASSERT_NOT_NULL(done);
+    TEST_ESP_OK(esp_parallel_init(NULL));
+
+    xTaskCreatePinnedToCore(parallel_for_task, "pfor0", 2048, done, UNITY_FREERTOS_PRIORITY - 1, NULL, 0);
+    xTaskCreatePinnedToCore(parallel_for_task, "pfor1", 2048, done, UNITY_FREERTOS_PRIORITY - 1, NULL, portNUM_PROCESSORS - 1);
+    for (int i = 0; i < 50; i++) {
+        TEST_ESP_OK(esp_parallel_for(N_INDEXES / 2, N_INDEXES, 5, mark_range, (void *) 5));
+    }
+    TEST_ASSERT_TRUE(xSemaphoreTake(done, portMAX_DELAY));
+    TEST_ASSERT_TRUE(xSemaphoreTake(done, portMAX_DELAY));
+    for (size_t i = 0; i < N_INDEXES; i++) {
+        TEST_ASSERT_EQUAL(i < N_INDEXES / 2 ? 100 : 50, atomic_load(&s_hits[i]));
+        atomic_store(&s_hits[i], 0);
+    }
+    TEST_ASSERT_EQUAL(0, atomic_exchange(&s_errors, 0));
+
+    TEST_ESP_OK(esp_parallel_deinit());
+    vSemaphoreDelete(done);
+}
+
+static void empty_range(size_t begin, size_t end, void *arg)
+{
+}
+
+#define CHECKSUM_LEN (64 * 1024)
+
+static atomic_uint s_checksum;
+
+static void checksum_range(size_t begin, size_t end, void *arg)
+{
+    const uint32_t *words = (const uint32_t *) arg;
+    uint32_t sum = 0;
+    for (size_t i = begin; i < end; i++) {
+        sum += words[i] * (uint32_t) i;
+    }
+    atomic_fetch_add(&s_checksum, sum);
+}
+
+TEST_CASE("esp_parallel dispatch overhead", "[esp_parallel][perf]")
+{
+    const int reps = 1000;
+    esp_parallel_group_t group;
+    esp_parallel_task_t task;
+
+    TEST_ESP_OK(esp_parallel_init(NULL));
+    /* let the workers go to sleep */
+    vTaskDelay(2);
+
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < reps; i++) {
+        esp_parallel_for(0, 2, 1, empty_range, NULL);
+    }
+    int64_t us = esp_timer_get_time() - start;
+    TEST_PERFORMANCE_LESS_THAN(ESP_PARALLEL_FOR_DISPATCH_US, "%d us", (int) (us / reps));
+
+    esp_parallel_group_init(&group);
+    start = esp_timer_get_time();
+    for (int i = 0; i < reps; i++) {
+        esp_parallel_group_run(&group, &task, count_task, NULL);
+        esp_parallel_group_wait(&group);
+    }
+    us = esp_timer_get_time() - start;
+    IDF_LOG_PERFORMANCE("esp_parallel_group_run_wait", "%d us", (int) (us / reps));
+
+    /* the checksum on one core (single chunk) and on all cores */
+    uint32_t *words = malloc(CHECKSUM_LEN);
+    TEST_ASSERT_NOT_NULL(words);
+    for (int i = 0; i < CHECKSUM_LEN / 4; i++) {
+        words[i] = esp_random();
+    }
+    atomic_store(&s_checksum, 0);
+    start = esp_timer_get_time();
+    checksum_range(0, CHECKSUM_LEN / 4, words);
+    int64_t us_serial = esp_timer_get_time() - start;
+    unsigned serial_sum = atomic_exchange(&s_checksum, 0);
+
+    start = esp_timer_get_time();
+    TEST_ESP_OK(esp_parallel_for(0, CHECKSUM_LEN / 4, 0, checksum_range, words));
+    int64_t us_parallel = esp_timer_get_time() - start;
+    TEST_ASSERT_EQUAL_HEX32(serial_sum, atomic_load(&s_checksum));
+    IDF_LOG_PERFORMANCE("esp_parallel_for 64KB checksum serial", "%d us", (int) us_serial);
+    IDF_LOG_PERFORMANCE("esp_parallel_for 64KB checksum parallel", "%d us", (int) us_parallel);
+
+    free(words);
+    TEST_ESP_OK(esp_parallel_deinit());
+}
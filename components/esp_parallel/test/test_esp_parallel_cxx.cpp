@@ -0,0 +1,36 @@
+#include <atomic>
+#include <vector>
+#include "unity.h"
+#include "esp_parallel.h"
+
+TEST_CASE("esp_parallel C++ parallel_for and task_group", "[esp_parallel][cxx]")
+{
+    std::vector<int> squares(500);
+    std::atomic<int> calls(0);
+
+    TEST_ESP_OK(esp_parallel_init(NULL));
+
+    TEST_ESP_OK(esp_parallel::parallel_for(0, squares.size(), 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            squares[i] = i * i;
+        }
+    }));
+    for (size_t i = 0; i < squares.size(); i++) {
+        TEST_ASSERT_EQUAL(i * i, squares[i]);
+    }
+
+    {
+        esp_parallel_task_t tasks[8];
+        auto count = [&]() {
+            calls++;
+        };
+        esp_parallel::task_group group;
+        for (auto &task : tasks) {
+            TEST_ESP_OK(group.run(task, count));
+        }
+        // the destructor waits for the tasks
+    }
+    TEST_ASSERT_EQUAL(8, calls.load());
+
+    TEST_ESP_OK(esp_parallel_deinit());
+}
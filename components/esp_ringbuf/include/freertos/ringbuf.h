@@ -52,9 +52,60 @@ typedef enum {
 	 * sequence of byte and any number of bytes can be sent or retrieved each
 	 * time.
 	 */
-	RINGBUF_TYPE_BYTEBUF
+	RINGBUF_TYPE_BYTEBUF,
+	/**
+	 * Single-producer/single-consumer no-split buffers store items in the
+	 * same way as no-split buffers, but sending, retrieving and returning
+	 * items is lock-free. Only one task (or ISR) may send to the buffer and
+	 * only one task (or ISR) may retrieve and return items, which must be
+	 * returned in the order they were retrieved. Semaphores are only used
+	 * when a task blocks on an empty or full buffer. Queue sets, split
+	 * retrieval and xRingbufferSendAcquire() are not supported.
+	 */
+	RINGBUF_TYPE_NOSPLIT_SPSC
 } ringbuf_type_t;
 
+/**
+ * @brief Struct that is equivalent in size to the ring buffer's data structure
+ *
+ * The contents of this struct are not meant to be used directly. This
+ * structure is meant to be used when creating a statically allocated ring
+ * buffer where this struct is of the exact size required to store a ring
+ * buffer's control data structure.
+ */
+typedef struct xSTATIC_RINGBUFFER {
+	/** @cond */	//Doxygen command to hide this structure from API Reference
+	size_t xDummy1;
+	UBaseType_t uxDummy2;
+	size_t xDummy3;
+	void *pvDummy4[11];
+	BaseType_t xDummy5;
+	void *pvDummy6[2];
+	portMUX_TYPE muxDummy;
+	size_t xDummy7[3];
+	int iDummy8[2];
+	size_t xDummy9;
+	UBaseType_t uxDummy10[2];
+	TickType_t xDummy11[3];
+#if ( configSUPPORT_STATIC_ALLOCATION == 1 )
+	StaticSemaphore_t xDummy12[2];
+#endif
+	/** @endcond */
+} StaticRingbuffer_t;
+
+/**
+ * @brief Ring buffer usage statistics, see vRingbufferGetStats()
+ */
+typedef struct {
+	size_t xPeakUsedSize;               /**< Largest amount of storage (in bytes, including item headers) that has been in use at once */
+	UBaseType_t uxItemsSent;            /**< Number of items (or xRingbufferSend() calls for byte buffers) sent */
+	UBaseType_t uxItemsReceived;        /**< Number of items (or retrievals for byte buffers) received */
+	UBaseType_t uxItemsPerSecond;       /**< Average number of items received per second */
+	TickType_t xSendBlockedTicks;       /**< Total ticks spent by senders blocked on a full ring buffer */
+	TickType_t xReceiveBlockedTicks;    /**< Total ticks spent by receivers blocked on an empty ring buffer */
+	TickType_t xElapsedTicks;           /**< Ticks since the ring buffer was created or the statistics were reset */
+} ringbuf_stats_t;
+
 /**
  * @brief       Create a ring buffer
  *
@@ -81,6 +132,47 @@ RingbufHandle_t xRingbufferCreate(size_t xBufferSize, ringbuf_type_t xBufferType
  */
 RingbufHandle_t xRingbufferCreateNoSplit(size_t xItemSize, size_t xItemNum);
 
+/**
+ * @brief       Create a ring buffer with its storage allocated from memory with specific capabilities
+ *
+ * This API is similar to xRingbufferCreate(), but the storage area of the
+ * ring buffer is allocated with heap_caps_malloc() so that large ring buffers
+ * can be placed in e.g. external RAM. The ring buffer's control data structure
+ * is always allocated from internal memory.
+ *
+ * @param[in]   xBufferSize     Size of the buffer in bytes. Note that items require
+ *                              space for overhead in no-split/allow-split buffers
+ * @param[in]   xBufferType     Type of ring buffer, see documentation.
+ * @param[in]   uxMemoryCaps    Bitwise OR of MALLOC_CAP_* flags for the storage area
+ *
+ * @note    The ring buffer must not be accessed while the flash cache is disabled
+ *          if its storage is placed in external RAM.
+ *
+ * @return  A handle to the created ring buffer, or NULL in case of error.
+ */
+RingbufHandle_t xRingbufferCreateWithCaps(size_t xBufferSize, ringbuf_type_t xBufferType, uint32_t uxMemoryCaps);
+
+#if ( configSUPPORT_STATIC_ALLOCATION == 1 )
+/**
+ * @brief       Create a ring buffer using statically allocated memory
+ *
+ * This API is similar to xRingbufferCreate(), but no memory is allocated.
+ * The storage area and the control data structure are provided by the caller
+ * and must remain valid until the ring buffer is deleted.
+ *
+ * @param[in]   xBufferSize             Size of the storage area in bytes. Must be 32-bit aligned for
+ *                                      no-split/allow-split buffers
+ * @param[in]   xBufferType             Type of ring buffer, see documentation.
+ * @param[in]   pucRingbufferStorage    Storage area of at least xBufferSize bytes. Must be 32-bit aligned
+ * @param[in]   pxStaticRingbuffer      Memory used to hold the ring buffer's control data structure
+ *
+ * @note    This function is only available if CONFIG_SUPPORT_STATIC_ALLOCATION is enabled.
+ *
+ * @return  A handle to the created ring buffer
+ */
+RingbufHandle_t xRingbufferCreateStatic(size_t xBufferSize, ringbuf_type_t xBufferType, uint8_t *pucRingbufferStorage, StaticRingbuffer_t *pxStaticRingbuffer);
+#endif
+
 /**
  * @brief       Insert an item into the ring buffer
  *
@@ -125,6 +217,49 @@ BaseType_t xRingbufferSend(RingbufHandle_t xRingbuffer, const void *pvItem, size
  */
 BaseType_t xRingbufferSendFromISR(RingbufHandle_t xRingbuffer, const void *pvItem, size_t xItemSize, BaseType_t *pxHigherPriorityTaskWoken);
 
+/**
+ * @brief       Acquire memory from the ring buffer to be written to by an external source and to be sent later.
+ *
+ * Attempt to allocate buffer for an item to be sent into the ring buffer. This
+ * function will block until enough free space is available or until it
+ * timesout.
+ *
+ * The item, as well as the following items ``SendAcquire`` or ``Send`` after it,
+ * will not be able to be read from the ring buffer until this item is actually
+ * sent into the ring buffer.
+ *
+ * @param[in]   xRingbuffer     Ring buffer to allocate the memory
+ * @param[out]  ppvItem         Double pointer to memory acquired (set to NULL if no memory were retrieved)
+ * @param[in]   xItemSize       Size of item to acquire.
+ * @param[in]   xTicksToWait    Ticks to wait for room in the ring buffer.
+ *
+ * @note    Only applicable for no-split ring buffers now, the actual size of
+ *          memory that the item will occupy will be rounded up to the nearest 32-bit
+ *          aligned size. This is done to ensure all items are always stored in 32-bit
+ *          aligned fashion.
+ *
+ * @return
+ *      - pdTRUE if succeeded
+ *      - pdFALSE on time-out or when the data is larger than the maximum permissible size of the buffer
+ */
+BaseType_t xRingbufferSendAcquire(RingbufHandle_t xRingbuffer, void **ppvItem, size_t xItemSize, TickType_t xTicksToWait);
+
+/**
+ * @brief       Actually send an item into the ring buffer allocated before by
+ *              ``xRingbufferSendAcquire``.
+ *
+ * @param[in]   xRingbuffer     Ring buffer to insert the item into
+ * @param[in]   pvItem          Pointer to item in allocated memory to insert.
+ *
+ * @note    Only applicable for no-split ring buffers. Only call for items
+ *          allocated by ``xRingbufferSendAcquire``.
+ *
+ * @return
+ *      - pdTRUE if succeeded
+ *      - pdFALSE if fail for some reason.
+ */
+BaseType_t xRingbufferSendComplete(RingbufHandle_t xRingbuffer, void *pvItem);
+
 /**
  * @brief   Retrieve an item from the ring buffer
  *
@@ -143,6 +278,26 @@ BaseType_t xRingbufferSendFromISR(RingbufHandle_t xRingbuffer, const void *pvIte
  */
 void *xRingbufferReceive(RingbufHandle_t xRingbuffer, size_t *pxItemSize, TickType_t xTicksToWait);
 
+/**
+ * @brief   Retrieve several items from a no-split ring buffer at once
+ *
+ * Block until at least one item is available or until it timesout, then
+ * retrieve every available item up to uxMaxItems in a single critical section.
+ * The items are written to ppvItems in the order they were sent.
+ *
+ * @param[in]   xRingbuffer     Ring buffer to retrieve the items from
+ * @param[out]  ppvItems        Array of at least uxMaxItems pointers to which the retrieved items will be written
+ * @param[out]  pxItemSizes     Array of at least uxMaxItems sizes to which the item lengths will be written. Can be NULL.
+ * @param[in]   uxMaxItems      Maximum number of items to retrieve
+ * @param[in]   xTicksToWait    Ticks to wait for the first item in the ring buffer.
+ *
+ * @note    This function should only be called on no-split buffers (including RINGBUF_TYPE_NOSPLIT_SPSC)
+ * @note    The items can be freed with a single call to vRingbufferReturnItems() or individually with vRingbufferReturnItem()
+ *
+ * @return  Number of items retrieved, 0 on timeout
+ */
+UBaseType_t xRingbufferReceiveMany(RingbufHandle_t xRingbuffer, void **ppvItems, size_t *pxItemSizes, UBaseType_t uxMaxItems, TickType_t xTicksToWait);
+
 /**
  * @brief   Retrieve an item from the ring buffer in an ISR
  *
@@ -265,6 +420,21 @@ void *xRingbufferReceiveUpToFromISR(RingbufHandle_t xRingbuffer, size_t *pxItemS
  */
 void vRingbufferReturnItem(RingbufHandle_t xRingbuffer, void *pvItem);
 
+/**
+ * @brief   Return several previously-retrieved items to a no-split ring buffer at once
+ *
+ * All items are marked as free and the free pointer is moved once, in a single
+ * critical section, instead of once per item.
+ *
+ * @param[in]   xRingbuffer Ring buffer the items were retrieved from
+ * @param[in]   ppvItems    Items that were received earlier
+ * @param[in]   uxItemCount Number of items in ppvItems
+ *
+ * @note    This function should only be called on no-split buffers
+ * @note    For RINGBUF_TYPE_NOSPLIT_SPSC buffers the items must be the oldest retrieved items, in the order they were retrieved
+ */
+void vRingbufferReturnItems(RingbufHandle_t xRingbuffer, void **ppvItems, UBaseType_t uxItemCount);
+
 /**
  * @brief   Return a previously-retrieved item to the ring buffer from an ISR
  *
@@ -375,6 +545,29 @@ BaseType_t xRingbufferRemoveFromQueueSetRead(RingbufHandle_t xRingbuffer, QueueS
  */
 void vRingbufferGetInfo(RingbufHandle_t xRingbuffer, UBaseType_t *uxFree, UBaseType_t *uxRead, UBaseType_t *uxWrite, UBaseType_t *uxItemsWaiting);
 
+/**
+ * @brief   Get usage statistics of a ring buffer
+ *
+ * Statistics are collected from the creation of the ring buffer or from the
+ * last call to vRingbufferResetStats(). Blocked times are only accumulated by
+ * the task (non-ISR) send and receive functions.
+ *
+ * @param[in]   xRingbuffer     Ring buffer to get the statistics of
+ * @param[out]  pxStats         Pointer to a structure to which the statistics will be written
+ */
+void vRingbufferGetStats(RingbufHandle_t xRingbuffer, ringbuf_stats_t *pxStats);
+
+/**
+ * @brief   Reset usage statistics of a ring buffer
+ *
+ * The peak used size is reset to the amount of storage currently in use.
+ *
+ * @param[in]   xRingbuffer     Ring buffer to reset the statistics of
+ *
+ * @note    For RINGBUF_TYPE_NOSPLIT_SPSC buffers, counter updates racing with the reset may be lost.
+ */
+void vRingbufferResetStats(RingbufHandle_t xRingbuffer);
+
 /**
  * @brief   Debugging function to print the internal pointers in the ring buffer
  *
@@ -14,10 +14,12 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include "freertos/ringbuf.h"
+#include "esp_heap_caps.h"
 
 //32-bit alignment macros
 #define rbALIGN_SIZE( xSize )       ( ( xSize + portBYTE_ALIGNMENT_MASK ) & ~portBYTE_ALIGNMENT_MASK )
@@ -27,11 +29,14 @@
 #define rbALLOW_SPLIT_FLAG          ( ( UBaseType_t ) 1 )   //The ring buffer allows items to be split
 #define rbBYTE_BUFFER_FLAG          ( ( UBaseType_t ) 2 )   //The ring buffer is a byte buffer
 #define rbBUFFER_FULL_FLAG          ( ( UBaseType_t ) 4 )   //The ring buffer is currently full (write pointer == free pointer)
+#define rbSPSC_FLAG                 ( ( UBaseType_t ) 8 )   //The ring buffer is a single-producer/single-consumer buffer using the lock-free indices
+#define rbBUFFER_STATIC_FLAG        ( ( UBaseType_t ) 16 )  //The ring buffer's control structure and storage were provided by the application
 
 //Item flags
 #define rbITEM_FREE_FLAG            ( ( UBaseType_t ) 1 )   //Item has been retrieved and returned by application, free to overwrite
 #define rbITEM_DUMMY_DATA_FLAG      ( ( UBaseType_t ) 2 )   //Data from here to end of the ring buffer is dummy data. Restart reading at start of head of the buffer
 #define rbITEM_SPLIT_FLAG           ( ( UBaseType_t ) 4 )   //Valid for RINGBUF_TYPE_ALLOWSPLIT, indicating that rest of the data is wrapped around
+#define rbITEM_WRITTEN_FLAG         ( ( UBaseType_t ) 8 )   //Item has been written by the application (see xRingbufferSendComplete()), free to be read
 
 typedef struct {
     //This size of this structure must be 32-bit aligned
@@ -59,7 +64,8 @@ struct Ringbuffer_t {
     ReturnItemFunction_t vReturnItem;           //Function to return item to ring buffer
     GetCurMaxSizeFunction_t xGetCurMaxSize;     //Function to get current free size
 
-    uint8_t *pucWrite;                          //Write Pointer. Points to where the next item should be written
+    uint8_t *pucAcquire;                        //Acquire Pointer. Points to where the next item should be acquired
+    uint8_t *pucWrite;                          //Write Pointer. Points past the last item that has been completely written
     uint8_t *pucRead;                           //Read Pointer. Points to where the next item should be read from
     uint8_t *pucFree;                           //Free Pointer. Points to the last item that has yet to be returned to the ring buffer
     uint8_t *pucHead;                           //Pointer to the start of the ring buffer storage area
@@ -69,8 +75,30 @@ struct Ringbuffer_t {
     SemaphoreHandle_t xFreeSpaceSemaphore;      //Binary semaphore, wakes up writing threads when more free space becomes available or when another thread times out attempting to write
     SemaphoreHandle_t xItemsBufferedSemaphore;  //Binary semaphore, indicates there are new packets in the circular buffer. See remark.
     portMUX_TYPE mux;                           //Spinlock required for SMP
+
+    //Used by single-producer/single-consumer buffers instead of the pointers above (see prvSpscTrySend())
+    atomic_size_t xSpscWrite;                   //Write index. Only updated by the producer
+    atomic_size_t xSpscFree;                    //Free index. Only updated by the consumer
+    size_t xSpscRead;                           //Read index. Only used by the consumer
+    atomic_int xSpscReaderWaiting;              //Consumer is (about to be) blocked on xItemsBufferedSemaphore
+    atomic_int xSpscWriterWaiting;              //Producer is (about to be) blocked on xFreeSpaceSemaphore
+
+    //Statistics (see vRingbufferGetStats()). For single-producer/single-consumer buffers each field is only updated by one side
+    size_t xPeakUsedSize;                       //Largest amount of storage in use at once
+    UBaseType_t uxItemsSent;                    //Number of items sent
+    UBaseType_t uxItemsReceived;                //Number of items received
+    TickType_t xSendBlockedTicks;               //Ticks spent blocked in send functions
+    TickType_t xReceiveBlockedTicks;            //Ticks spent blocked in receive functions
+    TickType_t xStatsStartTick;                 //Tick count when the statistics were last reset
+
+#if ( configSUPPORT_STATIC_ALLOCATION == 1 )
+    StaticSemaphore_t xFreeSpaceSemaphoreStatic;        //Storage for xFreeSpaceSemaphore of statically allocated ring buffers
+    StaticSemaphore_t xItemsBufferedSemaphoreStatic;    //Storage for xItemsBufferedSemaphore of statically allocated ring buffers
+#endif
 };
 
+_Static_assert(sizeof(StaticRingbuffer_t) == sizeof(Ringbuffer_t), "StaticRingbuffer_t != Ringbuffer_t");
+
 /*
 Remark: A counting semaphore for items_buffered_sem would be more logical, but counting semaphores in
 FreeRTOS need a maximum count, and allocate more memory the larger the maximum count is. Here, we
@@ -100,6 +128,12 @@ static BaseType_t prvCheckItemFitsByteBuffer( Ringbuffer_t *pxRingbuffer, size_t
 //Copies an item to a no-split ring buffer. Only call this function after calling prvCheckItemFitsDefault()
 static void prvCopyItemNoSplit(Ringbuffer_t *pxRingbuffer, const uint8_t *pucItem, size_t xItemSize);
 
+//Reserves space for an item in a no-split ring buffer. Only call this function after calling prvCheckItemFitsDefault()
+static uint8_t *prvAcquireItemNoSplit(Ringbuffer_t *pxRingbuffer, size_t xItemSize);
+
+//Marks an acquired item of a no-split ring buffer as written, and advances the write pointer past all written items
+static void prvSendItemDoneNoSplit(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem);
+
 //Copies an item to a allow-split ring buffer. Only call this function after calling prvCheckItemFitsDefault()
 static void prvCopyItemAllowSplit(Ringbuffer_t *pxRingbuffer, const uint8_t *pucItem, size_t xItemSize);
 
@@ -115,6 +149,12 @@ static void *prvGetItemByteBuf(Ringbuffer_t *pxRingbuffer, BaseType_t *pxUnusedP
 //Return an item to a split/no-split ring buffer
 static void prvReturnItemDefault(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem);
 
+//Mark an item of a split/no-split ring buffer as free, without moving the free pointer
+static void prvMarkItemFreeDefault(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem);
+
+//Advance the free pointer of a split/no-split ring buffer past all items that have been marked as free
+static void prvAdvanceFreeDefault(Ringbuffer_t *pxRingbuffer);
+
 //Return data to a byte buffer
 static void prvReturnItemByteBuf(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem);
 
@@ -138,15 +178,167 @@ static BaseType_t prvReceiveGeneric(Ringbuffer_t *pxRingbuffer, void **pvItem1,
 //Generic function used to retrieve an item/data from ring buffers in an ISR
 static BaseType_t prvReceiveGenericFromISR(Ringbuffer_t *pxRingbuffer, void **pvItem1, void **pvItem2, size_t *xItemSize1, size_t *xItemSize2, size_t xMaxSize);
 
+/*
+ * The following functions are used by single-producer/single-consumer buffers. They are thread
+ * safe as long as only one task sends and only one task receives and returns items.
+ */
+
+//Send an item to a single-producer/single-consumer buffer if it fits, waking the consumer if it is blocked
+static BaseType_t prvSpscTrySend(Ringbuffer_t *pxRingbuffer, const uint8_t *pucItem, size_t xItemSize, BaseType_t *pxHigherPriorityTaskWoken);
+
+//Retrieve an item from a single-producer/single-consumer buffer, returns NULL if the buffer is empty
+static void *prvSpscTryReceive(Ringbuffer_t *pxRingbuffer, size_t *pxItemSize);
+
+//Return the oldest retrieved item to a single-producer/single-consumer buffer, waking the producer if it is blocked
+static void prvSpscReturnItems(Ringbuffer_t *pxRingbuffer, void **ppvItems, UBaseType_t uxItemCount, BaseType_t *pxHigherPriorityTaskWoken);
+
+//Get the maximum size an item that can currently have if sent to a single-producer/single-consumer buffer
+static size_t prvSpscGetCurMaxSize(Ringbuffer_t *pxRingbuffer);
+
+//Get the amount of storage in use (including dummy data) of a single-producer/single-consumer buffer
+static size_t prvSpscUsedSize(Ringbuffer_t *pxRingbuffer, size_t xWrite, size_t xFree);
+
+//Initialize the pointers, statistics and type dependent function pointers of a new ring buffer. Semaphores are created by the caller
+static void prvInitializeNewRingbuffer(size_t xBufferSize, ringbuf_type_t xBufferType, Ringbuffer_t *pxNewRingbuffer, uint8_t *pucRingbufferStorage);
+
+//Shared by xRingbufferCreate() and xRingbufferCreateWithCaps() once both memory areas are allocated. Frees them on failure
+static RingbufHandle_t prvCreateDynamicRingbuffer(size_t xBufferSize, ringbuf_type_t xBufferType, Ringbuffer_t *pxRingbuffer, uint8_t *pucRingbufferStorage);
+
+//Update the send statistics after an item has been sent (or acquired) with xUsedSize bytes of storage now in use
+static inline void prvRecordSend(Ringbuffer_t *pxRingbuffer, size_t xUsedSize);
+
+//Add the ticks elapsed since xTicksStart to a blocked time statistic
+static void prvRecordBlocked(Ringbuffer_t *pxRingbuffer, TickType_t *pxBlockedTicks, TickType_t xTicksStart);
+
 /* ------------------------------------------------ Static Definitions ------------------------------------------- */
 
+static void prvInitializeNewRingbuffer(size_t xBufferSize, ringbuf_type_t xBufferType, Ringbuffer_t *pxNewRingbuffer, uint8_t *pucRingbufferStorage)
+{
+    //Initialize values
+    pxNewRingbuffer->xSize = xBufferSize;
+    pxNewRingbuffer->pucHead = pucRingbufferStorage;
+    pxNewRingbuffer->pucTail = pucRingbufferStorage + xBufferSize;
+    pxNewRingbuffer->pucFree = pucRingbufferStorage;
+    pxNewRingbuffer->pucRead = pucRingbufferStorage;
+    pxNewRingbuffer->pucWrite = pucRingbufferStorage;
+    pxNewRingbuffer->pucAcquire = pucRingbufferStorage;
+    pxNewRingbuffer->xItemsWaiting = 0;
+    pxNewRingbuffer->uxRingbufferFlags = 0;
+
+    //Initialize type dependent values and function pointers
+    if (xBufferType == RINGBUF_TYPE_NOSPLIT) {
+        pxNewRingbuffer->xCheckItemFits = prvCheckItemFitsDefault;
+        pxNewRingbuffer->vCopyItem = prvCopyItemNoSplit;
+        pxNewRingbuffer->pvGetItem = prvGetItemDefault;
+        pxNewRingbuffer->vReturnItem = prvReturnItemDefault;
+        /*
+         * Buffer lengths are always aligned. No-split buffer (read/write/free)
+         * pointers are also always aligned. Therefore worse case scenario is
+         * the write pointer is at the most aligned halfway point.
+         */
+        pxNewRingbuffer->xMaxItemSize = rbALIGN_SIZE(pxNewRingbuffer->xSize / 2) - rbHEADER_SIZE;
+        pxNewRingbuffer->xGetCurMaxSize = prvGetCurMaxSizeNoSplit;
+    } else if (xBufferType == RINGBUF_TYPE_ALLOWSPLIT) {
+        pxNewRingbuffer->uxRingbufferFlags |= rbALLOW_SPLIT_FLAG;
+        pxNewRingbuffer->xCheckItemFits = prvCheckItemFitsDefault;
+        pxNewRingbuffer->vCopyItem = prvCopyItemAllowSplit;
+        pxNewRingbuffer->pvGetItem = prvGetItemDefault;
+        pxNewRingbuffer->vReturnItem = prvReturnItemDefault;
+        //Worst case an item is split into two, incurring two headers of overhead
+        pxNewRingbuffer->xMaxItemSize = pxNewRingbuffer->xSize - (sizeof(ItemHeader_t) * 2);
+        pxNewRingbuffer->xGetCurMaxSize = prvGetCurMaxSizeAllowSplit;
+    } else if (xBufferType == RINGBUF_TYPE_NOSPLIT_SPSC) {
+        pxNewRingbuffer->uxRingbufferFlags |= rbSPSC_FLAG;
+        //Items are stored as in no-split buffers, but are sent and retrieved by the prvSpsc functions
+        pxNewRingbuffer->xMaxItemSize = rbALIGN_SIZE(pxNewRingbuffer->xSize / 2) - rbHEADER_SIZE;
+        pxNewRingbuffer->xGetCurMaxSize = prvSpscGetCurMaxSize;
+        atomic_init(&pxNewRingbuffer->xSpscWrite, 0);
+        atomic_init(&pxNewRingbuffer->xSpscFree, 0);
+        atomic_init(&pxNewRingbuffer->xSpscReaderWaiting, 0);
+        atomic_init(&pxNewRingbuffer->xSpscWriterWaiting, 0);
+    } else if (xBufferType == RINGBUF_TYPE_BYTEBUF) {
+        pxNewRingbuffer->uxRingbufferFlags |= rbBYTE_BUFFER_FLAG;
+        pxNewRingbuffer->xCheckItemFits = prvCheckItemFitsByteBuffer;
+        pxNewRingbuffer->vCopyItem = prvCopyItemByteBuf;
+        pxNewRingbuffer->pvGetItem = prvGetItemByteBuf;
+        pxNewRingbuffer->vReturnItem = prvReturnItemByteBuf;
+        //Byte buffers do not incur any overhead
+        pxNewRingbuffer->xMaxItemSize = pxNewRingbuffer->xSize;
+        pxNewRingbuffer->xGetCurMaxSize = prvGetCurMaxSizeByteBuf;
+    } else {
+        //Unsupported type
+        configASSERT(0);
+    }
+
+    pxNewRingbuffer->xPeakUsedSize = 0;
+    pxNewRingbuffer->uxItemsSent = 0;
+    pxNewRingbuffer->uxItemsReceived = 0;
+    pxNewRingbuffer->xSendBlockedTicks = 0;
+    pxNewRingbuffer->xReceiveBlockedTicks = 0;
+    pxNewRingbuffer->xStatsStartTick = xTaskGetTickCount();
+    vPortCPUInitializeMutex(&pxNewRingbuffer->mux);
+}
+
+static RingbufHandle_t prvCreateDynamicRingbuffer(size_t xBufferSize, ringbuf_type_t xBufferType, Ringbuffer_t *pxRingbuffer, uint8_t *pucRingbufferStorage)
+{
+    if (pxRingbuffer == NULL || pucRingbufferStorage == NULL) {
+        goto err;
+    }
+    prvInitializeNewRingbuffer(xBufferSize, xBufferType, pxRingbuffer, pucRingbufferStorage);
+    pxRingbuffer->xFreeSpaceSemaphore = xSemaphoreCreateBinary();
+    pxRingbuffer->xItemsBufferedSemaphore = xSemaphoreCreateBinary();
+    if (pxRingbuffer->xFreeSpaceSemaphore == NULL || pxRingbuffer->xItemsBufferedSemaphore == NULL) {
+        goto err;
+    }
+    xSemaphoreGive(pxRingbuffer->xFreeSpaceSemaphore);
+
+    return (RingbufHandle_t)pxRingbuffer;
+
+err:
+    //Some error has happened. Free/destroy all allocated things and return NULL.
+    if (pxRingbuffer) {
+        if (pxRingbuffer->xFreeSpaceSemaphore) {
+            vSemaphoreDelete(pxRingbuffer->xFreeSpaceSemaphore);
+        }
+        if (pxRingbuffer->xItemsBufferedSemaphore) {
+            vSemaphoreDelete(pxRingbuffer->xItemsBufferedSemaphore);
+        }
+    }
+    free(pucRingbufferStorage);
+    free(pxRingbuffer);
+    return NULL;
+}
+
+static inline void prvRecordSend(Ringbuffer_t *pxRingbuffer, size_t xUsedSize)
+{
+    pxRingbuffer->uxItemsSent++;
+    if (xUsedSize > pxRingbuffer->xPeakUsedSize) {
+        pxRingbuffer->xPeakUsedSize = xUsedSize;
+    }
+}
+
+static void prvRecordBlocked(Ringbuffer_t *pxRingbuffer, TickType_t *pxBlockedTicks, TickType_t xTicksStart)
+{
+    TickType_t xBlockedTicks = xTaskGetTickCount() - xTicksStart;
+    if (xBlockedTicks == 0) {
+        return;
+    }
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        *pxBlockedTicks += xBlockedTicks;   //Only updated by the side that owns the statistic
+    } else {
+        portENTER_CRITICAL(&pxRingbuffer->mux);
+        *pxBlockedTicks += xBlockedTicks;
+        portEXIT_CRITICAL(&pxRingbuffer->mux);
+    }
+}
+
 static size_t prvGetFreeSize(Ringbuffer_t *pxRingbuffer)
 {
     size_t xReturn;
     if (pxRingbuffer->uxRingbufferFlags & rbBUFFER_FULL_FLAG) {
         xReturn =  0;
     } else {
-        BaseType_t xFreeSize = pxRingbuffer->pucFree - pxRingbuffer->pucWrite;
+        BaseType_t xFreeSize = pxRingbuffer->pucFree - pxRingbuffer->pucAcquire;
         //Check if xFreeSize has underflowed
         if (xFreeSize <= 0) {
             xFreeSize += pxRingbuffer->xSize;
@@ -160,26 +352,26 @@ static size_t prvGetFreeSize(Ringbuffer_t *pxRingbuffer)
 static BaseType_t prvCheckItemFitsDefault( Ringbuffer_t *pxRingbuffer, size_t xItemSize)
 {
     //Check arguments and buffer state
-    configASSERT(rbCHECK_ALIGNED(pxRingbuffer->pucWrite));              //pucWrite is always aligned in no-split ring buffers
-    configASSERT(pxRingbuffer->pucWrite >= pxRingbuffer->pucHead && pxRingbuffer->pucWrite < pxRingbuffer->pucTail);    //Check write pointer is within bounds
+    configASSERT(rbCHECK_ALIGNED(pxRingbuffer->pucAcquire));              //pucAcquire is always aligned in no-split/allow-split ring buffers
+    configASSERT(pxRingbuffer->pucAcquire >= pxRingbuffer->pucHead && pxRingbuffer->pucAcquire < pxRingbuffer->pucTail);    //Check acquire pointer is within bounds
 
     size_t xTotalItemSize = rbALIGN_SIZE(xItemSize) + rbHEADER_SIZE;    //Rounded up aligned item size with header
-    if (pxRingbuffer->pucWrite == pxRingbuffer->pucFree) {
+    if (pxRingbuffer->pucAcquire == pxRingbuffer->pucFree) {
         //Buffer is either complete empty or completely full
         return (pxRingbuffer->uxRingbufferFlags & rbBUFFER_FULL_FLAG) ? pdFALSE : pdTRUE;
     }
-    if (pxRingbuffer->pucFree > pxRingbuffer->pucWrite) {
+    if (pxRingbuffer->pucFree > pxRingbuffer->pucAcquire) {
         //Free space does not wrap around
-        return (xTotalItemSize <= pxRingbuffer->pucFree - pxRingbuffer->pucWrite) ? pdTRUE : pdFALSE;
+        return (xTotalItemSize <= pxRingbuffer->pucFree - pxRingbuffer->pucAcquire) ? pdTRUE : pdFALSE;
     }
     //Free space wraps around
-    if (xTotalItemSize <= pxRingbuffer->pucTail - pxRingbuffer->pucWrite) {
+    if (xTotalItemSize <= pxRingbuffer->pucTail - pxRingbuffer->pucAcquire) {
         return pdTRUE;      //Item fits without wrapping around
     }
     //Check if item fits by wrapping
     if (pxRingbuffer->uxRingbufferFlags & rbALLOW_SPLIT_FLAG) {
         //Allow split wrapping incurs an extra header
-        return (xTotalItemSize + rbHEADER_SIZE <= pxRingbuffer->xSize - (pxRingbuffer->pucWrite - pxRingbuffer->pucFree)) ? pdTRUE : pdFALSE;
+        return (xTotalItemSize + rbHEADER_SIZE <= pxRingbuffer->xSize - (pxRingbuffer->pucAcquire - pxRingbuffer->pucFree)) ? pdTRUE : pdFALSE;
     } else {
         return (xTotalItemSize <= pxRingbuffer->pucFree - pxRingbuffer->pucHead) ? pdTRUE : pdFALSE;
     }
@@ -202,41 +394,89 @@ static BaseType_t prvCheckItemFitsByteBuffer( Ringbuffer_t *pxRingbuffer, size_t
     return (xItemSize <= pxRingbuffer->xSize - (pxRingbuffer->pucWrite - pxRingbuffer->pucFree)) ? pdTRUE : pdFALSE;
 }
 
-static void prvCopyItemNoSplit(Ringbuffer_t *pxRingbuffer, const uint8_t *pucItem, size_t xItemSize)
+static uint8_t *prvAcquireItemNoSplit(Ringbuffer_t *pxRingbuffer, size_t xItemSize)
 {
     //Check arguments and buffer state
     size_t xAlignedItemSize = rbALIGN_SIZE(xItemSize);                  //Rounded up aligned item size
-    size_t xRemLen = pxRingbuffer->pucTail - pxRingbuffer->pucWrite;    //Length from pucWrite until end of buffer
-    configASSERT(rbCHECK_ALIGNED(pxRingbuffer->pucWrite));              //pucWrite is always aligned in no-split ring buffers
-    configASSERT(pxRingbuffer->pucWrite >= pxRingbuffer->pucHead && pxRingbuffer->pucWrite < pxRingbuffer->pucTail);    //Check write pointer is within bounds
+    size_t xRemLen = pxRingbuffer->pucTail - pxRingbuffer->pucAcquire;  //Length from pucAcquire until end of buffer
+    configASSERT(rbCHECK_ALIGNED(pxRingbuffer->pucAcquire));            //pucAcquire is always aligned in no-split ring buffers
+    configASSERT(pxRingbuffer->pucAcquire >= pxRingbuffer->pucHead && pxRingbuffer->pucAcquire < pxRingbuffer->pucTail);    //Check acquire pointer is within bounds
     configASSERT(xRemLen >= rbHEADER_SIZE);                             //Remaining length must be able to at least fit an item header
 
     //If remaining length can't fit item, set as dummy data and wrap around
     if (xRemLen < xAlignedItemSize + rbHEADER_SIZE) {
-        ItemHeader_t *pxDummy = (ItemHeader_t *)pxRingbuffer->pucWrite;
+        ItemHeader_t *pxDummy = (ItemHeader_t *)pxRingbuffer->pucAcquire;
         pxDummy->uxItemFlags = rbITEM_DUMMY_DATA_FLAG;      //Set remaining length as dummy data
         pxDummy->xItemLen = 0;                              //Dummy data should have no length
-        pxRingbuffer->pucWrite = pxRingbuffer->pucHead;     //Reset write pointer to wrap around
+        pxRingbuffer->pucAcquire = pxRingbuffer->pucHead;   //Reset acquire pointer to wrap around
     }
 
-    //Item should be guaranteed to fit at this point. Set item header and copy data
-    ItemHeader_t *pxHeader = (ItemHeader_t *)pxRingbuffer->pucWrite;
+    //Item should be guaranteed to fit at this point. Set item header, the data is written by the caller
+    ItemHeader_t *pxHeader = (ItemHeader_t *)pxRingbuffer->pucAcquire;
     pxHeader->xItemLen = xItemSize;
     pxHeader->uxItemFlags = 0;
-    pxRingbuffer->pucWrite += rbHEADER_SIZE;    //Advance pucWrite past header
-    memcpy(pxRingbuffer->pucWrite, pucItem, xItemSize);
-    pxRingbuffer->xItemsWaiting++;
-    pxRingbuffer->pucWrite += xAlignedItemSize; //Advance pucWrite past item to next aligned address
+    uint8_t *pucItem = pxRingbuffer->pucAcquire + rbHEADER_SIZE;
+    pxRingbuffer->pucAcquire += rbHEADER_SIZE + xAlignedItemSize;   //Advance pucAcquire past header and item to next aligned address
 
-    //If current remaining length can't fit a header, wrap around write pointer
-    if (pxRingbuffer->pucTail - pxRingbuffer->pucWrite < rbHEADER_SIZE) {
-        pxRingbuffer->pucWrite = pxRingbuffer->pucHead;   //Wrap around pucWrite
+    //If current remaining length can't fit a header, wrap around acquire pointer
+    if (pxRingbuffer->pucTail - pxRingbuffer->pucAcquire < rbHEADER_SIZE) {
+        pxRingbuffer->pucAcquire = pxRingbuffer->pucHead;   //Wrap around pucAcquire
     }
     //Check if buffer is full
-    if (pxRingbuffer->pucWrite == pxRingbuffer->pucFree) {
+    if (pxRingbuffer->pucAcquire == pxRingbuffer->pucFree) {
         //Mark the buffer as full to distinguish with an empty buffer
         pxRingbuffer->uxRingbufferFlags |= rbBUFFER_FULL_FLAG;
     }
+    return pucItem;
+}
+
+static void prvSendItemDoneNoSplit(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem)
+{
+    //Check arguments and buffer state
+    configASSERT(rbCHECK_ALIGNED(pucItem));
+    configASSERT(pucItem >= pxRingbuffer->pucHead);
+    configASSERT(pucItem <= pxRingbuffer->pucTail);     //Inclusive of pucTail in the case of zero length item at the very end
+
+    //Get and check header of the item
+    ItemHeader_t *pxCurHeader = (ItemHeader_t *)(pucItem - rbHEADER_SIZE);
+    configASSERT(pxCurHeader->xItemLen <= pxRingbuffer->xMaxItemSize);
+    configASSERT((pxCurHeader->uxItemFlags & rbITEM_DUMMY_DATA_FLAG) == 0); //Dummy items are never acquired
+    configASSERT((pxCurHeader->uxItemFlags & rbITEM_WRITTEN_FLAG) == 0);    //Indicates item has already been completed before
+    pxCurHeader->uxItemFlags |= rbITEM_WRITTEN_FLAG;                        //Mark as written
+
+    /*
+     * Items might not be completed in the order they were acquired. Move the write pointer
+     * up to the next item that has not been marked as written (by written flag) or up
+     * till the acquire pointer. When advancing the write pointer, dummy items are
+     * skipped over. The item being completed lies between the write and acquire pointers,
+     * so if they are equal here the whole (full) buffer is still being written.
+     */
+    BaseType_t xWholeBuffer = (pxRingbuffer->pucWrite == pxRingbuffer->pucAcquire) ? pdTRUE : pdFALSE;
+    pxCurHeader = (ItemHeader_t *)pxRingbuffer->pucWrite;
+    while (((pxCurHeader->uxItemFlags & rbITEM_WRITTEN_FLAG) || (pxCurHeader->uxItemFlags & rbITEM_DUMMY_DATA_FLAG)) &&
+           (pxRingbuffer->pucWrite != pxRingbuffer->pucAcquire || xWholeBuffer == pdTRUE)) {
+        xWholeBuffer = pdFALSE;
+        if (pxCurHeader->uxItemFlags & rbITEM_DUMMY_DATA_FLAG) {
+            pxRingbuffer->pucWrite = pxRingbuffer->pucHead;     //Wrap around due to dummy data
+        } else {
+            //Item has been written, advance write pointer past this item
+            pxRingbuffer->pucWrite += rbHEADER_SIZE + rbALIGN_SIZE(pxCurHeader->xItemLen);
+            pxRingbuffer->xItemsWaiting++;
+            //Check if pucWrite requires wrap around
+            if ((pxRingbuffer->pucTail - pxRingbuffer->pucWrite) < rbHEADER_SIZE) {
+                pxRingbuffer->pucWrite = pxRingbuffer->pucHead;
+            }
+        }
+        pxCurHeader = (ItemHeader_t *)pxRingbuffer->pucWrite;   //Update header to point to item
+    }
+}
+
+static void prvCopyItemNoSplit(Ringbuffer_t *pxRingbuffer, const uint8_t *pucItem, size_t xItemSize)
+{
+    //Acquire space for the item, copy the data and complete it in one go
+    uint8_t *pucDest = prvAcquireItemNoSplit(pxRingbuffer, xItemSize);
+    memcpy(pucDest, pucItem, xItemSize);
+    prvSendItemDoneNoSplit(pxRingbuffer, pucDest);
 }
 
 static void prvCopyItemAllowSplit(Ringbuffer_t *pxRingbuffer, const uint8_t *pucItem, size_t xItemSize)
@@ -284,6 +524,7 @@ static void prvCopyItemAllowSplit(Ringbuffer_t *pxRingbuffer, const uint8_t *puc
     if (pxRingbuffer->pucTail - pxRingbuffer->pucWrite < rbHEADER_SIZE) {
         pxRingbuffer->pucWrite = pxRingbuffer->pucHead;   //Wrap around pucWrite
     }
+    pxRingbuffer->pucAcquire = pxRingbuffer->pucWrite;    //Items are never acquired in allow-split buffers
     //Check if buffer is full
     if (pxRingbuffer->pucWrite == pxRingbuffer->pucFree) {
         //Mark the buffer as full to distinguish with an empty buffer
@@ -315,6 +556,7 @@ static void prvCopyItemByteBuf(Ringbuffer_t *pxRingbuffer, const uint8_t *pucIte
     if (pxRingbuffer->pucWrite == pxRingbuffer->pucTail) {
         pxRingbuffer->pucWrite = pxRingbuffer->pucHead;
     }
+    pxRingbuffer->pucAcquire = pxRingbuffer->pucWrite;    //Data is never acquired in byte buffers
     //Check if buffer is full
     if (pxRingbuffer->pucWrite == pxRingbuffer->pucFree) {
         pxRingbuffer->uxRingbufferFlags |= rbBUFFER_FULL_FLAG;      //Mark the buffer as full to avoid confusion with an empty buffer
@@ -410,6 +652,12 @@ static void *prvGetItemByteBuf(Ringbuffer_t *pxRingbuffer, BaseType_t *pxUnusedP
 }
 
 static void prvReturnItemDefault(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem)
+{
+    prvMarkItemFreeDefault(pxRingbuffer, pucItem);
+    prvAdvanceFreeDefault(pxRingbuffer);
+}
+
+static void prvMarkItemFreeDefault(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem)
 {
     //Check arguments and buffer state
     configASSERT(rbCHECK_ALIGNED(pucItem));
@@ -423,16 +671,26 @@ static void prvReturnItemDefault(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem)
     configASSERT((pxCurHeader->uxItemFlags & rbITEM_FREE_FLAG) == 0);       //Indicates item has already been returned before
     pxCurHeader->uxItemFlags &= ~rbITEM_SPLIT_FLAG;                         //Clear wrap flag if set (not strictly necessary)
     pxCurHeader->uxItemFlags |= rbITEM_FREE_FLAG;                           //Mark as free
+}
 
+static void prvAdvanceFreeDefault(Ringbuffer_t *pxRingbuffer)
+{
     /*
      * Items might not be returned in the order they were retrieved. Move the free pointer
      * up to the next item that has not been marked as free (by free flag) or up
      * till the read pointer. When advancing the free pointer, items that have already been
-     * freed or items with dummy data should be skipped over
+     * freed or items with dummy data should be skipped over. The item(s) being returned lie
+     * between the free and read pointers, so if they are equal here every item of a full
+     * buffer has been retrieved.
      */
-    pxCurHeader = (ItemHeader_t *)pxRingbuffer->pucFree;
+    BaseType_t xWholeBuffer = (pxRingbuffer->pucFree == pxRingbuffer->pucRead) ? pdTRUE : pdFALSE;
+    BaseType_t xFreeMoved = pdFALSE;
+    ItemHeader_t *pxCurHeader = (ItemHeader_t *)pxRingbuffer->pucFree;
     //Skip over Items that have already been freed or are dummy items
-    while (((pxCurHeader->uxItemFlags & rbITEM_FREE_FLAG) || (pxCurHeader->uxItemFlags & rbITEM_DUMMY_DATA_FLAG)) && pxRingbuffer->pucFree != pxRingbuffer->pucRead) {
+    while (((pxCurHeader->uxItemFlags & rbITEM_FREE_FLAG) || (pxCurHeader->uxItemFlags & rbITEM_DUMMY_DATA_FLAG)) &&
+           (pxRingbuffer->pucFree != pxRingbuffer->pucRead || xWholeBuffer == pdTRUE)) {
+        xWholeBuffer = pdFALSE;
+        xFreeMoved = pdTRUE;
         if (pxCurHeader->uxItemFlags & rbITEM_DUMMY_DATA_FLAG) {
             pxCurHeader->uxItemFlags |= rbITEM_FREE_FLAG;   //Mark as freed (not strictly necessary but adds redundancy)
             pxRingbuffer->pucFree = pxRingbuffer->pucHead;    //Wrap around due to dummy data
@@ -452,10 +710,11 @@ static void prvReturnItemDefault(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem)
 
     //Check if the buffer full flag should be reset
     if (pxRingbuffer->uxRingbufferFlags & rbBUFFER_FULL_FLAG) {
-        if (pxRingbuffer->pucFree != pxRingbuffer->pucWrite) {
+        if (pxRingbuffer->pucFree != pxRingbuffer->pucAcquire) {
             pxRingbuffer->uxRingbufferFlags &= ~rbBUFFER_FULL_FLAG;
-        } else if (pxRingbuffer->pucFree == pxRingbuffer->pucWrite && pxRingbuffer->pucFree == pxRingbuffer->pucRead) {
-            //Special case where a full buffer is completely freed in one go
+        } else if (pxRingbuffer->pucFree == pxRingbuffer->pucAcquire && pxRingbuffer->pucFree == pxRingbuffer->pucRead && xFreeMoved == pdTRUE) {
+            //Special case where a full buffer is completely freed in one go. If the free pointer
+            //has not moved, an item other than the oldest was returned and the buffer is still full
             pxRingbuffer->uxRingbufferFlags &= ~rbBUFFER_FULL_FLAG;
         }
     }
@@ -481,13 +740,13 @@ static size_t prvGetCurMaxSizeNoSplit(Ringbuffer_t *pxRingbuffer)
     if (pxRingbuffer->uxRingbufferFlags & rbBUFFER_FULL_FLAG) {
         return 0;
     }
-    if (pxRingbuffer->pucWrite < pxRingbuffer->pucFree) {
-        //Free space is contiguous between pucWrite and pucFree
-        xFreeSize = pxRingbuffer->pucFree - pxRingbuffer->pucWrite;
+    if (pxRingbuffer->pucAcquire < pxRingbuffer->pucFree) {
+        //Free space is contiguous between pucAcquire and pucFree
+        xFreeSize = pxRingbuffer->pucFree - pxRingbuffer->pucAcquire;
     } else {
         //Free space wraps around (or overlapped at pucHead), select largest
         //contiguous free space as no-split items require contiguous space
-        size_t xSize1 = pxRingbuffer->pucTail - pxRingbuffer->pucWrite;
+        size_t xSize1 = pxRingbuffer->pucTail - pxRingbuffer->pucAcquire;
         size_t xSize2 = pxRingbuffer->pucFree - pxRingbuffer->pucHead;
         xFreeSize = (xSize1 > xSize2) ? xSize1 : xSize2;
     }
@@ -556,7 +815,8 @@ static BaseType_t prvReceiveGeneric(Ringbuffer_t *pxRingbuffer, void **pvItem1,
 {
     BaseType_t xReturn = pdFALSE;
     BaseType_t xReturnSemaphore = pdFALSE;
-    TickType_t xTicksEnd = xTaskGetTickCount() + xTicksToWait;
+    TickType_t xTicksStart = xTaskGetTickCount();
+    TickType_t xTicksEnd = xTicksStart + xTicksToWait;
     TickType_t xTicksRemaining = xTicksToWait;
     while (xTicksRemaining <= xTicksToWait) {   //xTicksToWait will underflow once xTaskGetTickCount() > ticks_end
         //Block until more free space becomes available or timeout
@@ -588,6 +848,7 @@ static BaseType_t prvReceiveGeneric(Ringbuffer_t *pxRingbuffer, void **pvItem1,
                 }
             }
             xReturn = pdTRUE;
+            pxRingbuffer->uxItemsReceived++;
             if (pxRingbuffer->xItemsWaiting > 0) {
                 xReturnSemaphore = pdTRUE;
             }
@@ -604,6 +865,7 @@ static BaseType_t prvReceiveGeneric(Ringbuffer_t *pxRingbuffer, void **pvItem1,
          * semaphore is given now, priority inversion might occur (see docs)
          */
     }
+    prvRecordBlocked(pxRingbuffer, &pxRingbuffer->xReceiveBlockedTicks, xTicksStart);
 
     if (xReturnSemaphore == pdTRUE) {
         xSemaphoreGive(pxRingbuffer->xItemsBufferedSemaphore);  //Give semaphore back so other tasks can retrieve
@@ -637,6 +899,7 @@ static BaseType_t prvReceiveGenericFromISR(Ringbuffer_t *pxRingbuffer, void **pv
             }
         }
         xReturn = pdTRUE;
+        pxRingbuffer->uxItemsReceived++;
         if (pxRingbuffer->xItemsWaiting > 0) {
             xReturnSemaphore = pdTRUE;
         }
@@ -649,92 +912,288 @@ static BaseType_t prvReceiveGenericFromISR(Ringbuffer_t *pxRingbuffer, void **pv
     return xReturn;
 }
 
-/* ------------------------------------------------- Public Definitions -------------------------------------------- */
+/*
+ * Single-producer/single-consumer buffers store items in the same way as no-split buffers, but
+ * without the spinlock. Each index has only one writer: the producer owns xSpscWrite, the
+ * consumer owns xSpscRead and xSpscFree, so publishing an index with an atomic store is enough
+ * to hand over the items (or the free space) behind it. Indices run from 0 to 2 * xSize, i.e.
+ * over two laps of the buffer, so that a full buffer (indices one lap apart) can be told apart
+ * from an empty one (indices equal) without a shared full flag.
+ *
+ * The semaphores are only used when a task has to block on an empty or full buffer. The blocking
+ * task sets its waiting flag and checks the buffer once more before taking the semaphore, and
+ * the other task checks the flag after publishing its index, so a wake up can't be missed.
+ */
 
-RingbufHandle_t xRingbufferCreate(size_t xBufferSize, ringbuf_type_t xBufferType)
+static inline uint8_t *prvSpscPointer(Ringbuffer_t *pxRingbuffer, size_t xIndex)
 {
-    //Allocate memory
-    Ringbuffer_t *pxRingbuffer = calloc(1, sizeof(Ringbuffer_t));
-    if (pxRingbuffer == NULL) {
-        goto err;
+    return pxRingbuffer->pucHead + ((xIndex < pxRingbuffer->xSize) ? xIndex : xIndex - pxRingbuffer->xSize);
+}
+
+//Index of the start of the buffer in the lap following xIndex
+static inline size_t prvSpscNextLap(Ringbuffer_t *pxRingbuffer, size_t xIndex)
+{
+    return (xIndex < pxRingbuffer->xSize) ? pxRingbuffer->xSize : 0;
+}
+
+//Advance an index past an item, wrapping around if the remaining length can't fit a header
+static size_t prvSpscAdvance(Ringbuffer_t *pxRingbuffer, size_t xIndex, size_t xItemLen)
+{
+    size_t xNextLap = prvSpscNextLap(pxRingbuffer, xIndex);
+    uint8_t *pucNext = prvSpscPointer(pxRingbuffer, xIndex) + rbHEADER_SIZE + rbALIGN_SIZE(xItemLen);
+    configASSERT(pucNext <= pxRingbuffer->pucTail);
+    if (pxRingbuffer->pucTail - pucNext < rbHEADER_SIZE) {
+        return xNextLap;
     }
-    if (xBufferType != RINGBUF_TYPE_BYTEBUF) {
-        xBufferSize = rbALIGN_SIZE(xBufferSize);    //xBufferSize is rounded up for no-split/allow-split buffers
+    return xIndex + rbHEADER_SIZE + rbALIGN_SIZE(xItemLen);
+}
+
+static inline void prvSpscWake(atomic_int *pxWaiting, SemaphoreHandle_t xSemaphore, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    if (atomic_load(pxWaiting) && atomic_exchange(pxWaiting, 0)) {
+        if (xPortInIsrContext()) {
+            xSemaphoreGiveFromISR(xSemaphore, pxHigherPriorityTaskWoken);
+        } else {
+            xSemaphoreGive(xSemaphore);
+        }
     }
-    pxRingbuffer->pucHead = malloc(xBufferSize);
-    if (pxRingbuffer->pucHead == NULL) {
-        goto err;
+}
+
+static size_t prvSpscUsedSize(Ringbuffer_t *pxRingbuffer, size_t xWrite, size_t xFree)
+{
+    BaseType_t xUsedSize = prvSpscPointer(pxRingbuffer, xWrite) - prvSpscPointer(pxRingbuffer, xFree);
+    //Check if xUsedSize has underflowed, or the buffer is full
+    if (xUsedSize < 0 || (xUsedSize == 0 && xWrite != xFree)) {
+        xUsedSize += pxRingbuffer->xSize;
     }
+    return xUsedSize;
+}
 
-    //Initialize values
-    pxRingbuffer->xSize = xBufferSize;
-    pxRingbuffer->pucTail = pxRingbuffer->pucHead + xBufferSize;
-    pxRingbuffer->pucFree = pxRingbuffer->pucHead;
-    pxRingbuffer->pucRead = pxRingbuffer->pucHead;
-    pxRingbuffer->pucWrite = pxRingbuffer->pucHead;
-    pxRingbuffer->xItemsWaiting = 0;
-    pxRingbuffer->xFreeSpaceSemaphore = xSemaphoreCreateBinary();
-    pxRingbuffer->xItemsBufferedSemaphore = xSemaphoreCreateBinary();
-    pxRingbuffer->uxRingbufferFlags = 0;
+static BaseType_t prvSpscTrySend(Ringbuffer_t *pxRingbuffer, const uint8_t *pucItem, size_t xItemSize, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    size_t xWrite = atomic_load_explicit(&pxRingbuffer->xSpscWrite, memory_order_relaxed);
+    size_t xFree = atomic_load_explicit(&pxRingbuffer->xSpscFree, memory_order_acquire);
+    size_t xUsed = (xWrite >= xFree) ? xWrite - xFree : xWrite + 2 * pxRingbuffer->xSize - xFree;
+    uint8_t *pucWrite = prvSpscPointer(pxRingbuffer, xWrite);
+    uint8_t *pucFree = prvSpscPointer(pxRingbuffer, xFree);
+    size_t xTotalItemSize = rbALIGN_SIZE(xItemSize) + rbHEADER_SIZE;    //Rounded up aligned item size with header
+    configASSERT(xUsed <= pxRingbuffer->xSize);
 
-    //Initialize type dependent values and function pointers
-    if (xBufferType == RINGBUF_TYPE_NOSPLIT) {
-        pxRingbuffer->xCheckItemFits = prvCheckItemFitsDefault;
-        pxRingbuffer->vCopyItem = prvCopyItemNoSplit;
-        pxRingbuffer->pvGetItem = prvGetItemDefault;
-        pxRingbuffer->vReturnItem = prvReturnItemDefault;
-        /*
-         * Buffer lengths are always aligned. No-split buffer (read/write/free)
-         * pointers are also always aligned. Therefore worse case scenario is
-         * the write pointer is at the most aligned halfway point.
-         */
-        pxRingbuffer->xMaxItemSize = rbALIGN_SIZE(pxRingbuffer->xSize / 2) - rbHEADER_SIZE;
-        pxRingbuffer->xGetCurMaxSize = prvGetCurMaxSizeNoSplit;
-    } else if (xBufferType == RINGBUF_TYPE_ALLOWSPLIT) {
-        pxRingbuffer->uxRingbufferFlags |= rbALLOW_SPLIT_FLAG;
-        pxRingbuffer->xCheckItemFits = prvCheckItemFitsDefault;
-        pxRingbuffer->vCopyItem = prvCopyItemAllowSplit;
-        pxRingbuffer->pvGetItem = prvGetItemDefault;
-        pxRingbuffer->vReturnItem = prvReturnItemDefault;
-        //Worst case an item is split into two, incurring two headers of overhead
-        pxRingbuffer->xMaxItemSize = pxRingbuffer->xSize - (sizeof(ItemHeader_t) * 2);
-        pxRingbuffer->xGetCurMaxSize = prvGetCurMaxSizeAllowSplit;
-    } else if (xBufferType == RINGBUF_TYPE_BYTEBUF) {
-        pxRingbuffer->uxRingbufferFlags |= rbBYTE_BUFFER_FLAG;
-        pxRingbuffer->xCheckItemFits = prvCheckItemFitsByteBuffer;
-        pxRingbuffer->vCopyItem = prvCopyItemByteBuf;
-        pxRingbuffer->pvGetItem = prvGetItemByteBuf;
-        pxRingbuffer->vReturnItem = prvReturnItemByteBuf;
-        //Byte buffers do not incur any overhead
-        pxRingbuffer->xMaxItemSize = pxRingbuffer->xSize;
-        pxRingbuffer->xGetCurMaxSize = prvGetCurMaxSizeByteBuf;
+    //Check if the item fits, either at the write pointer or after wrapping around
+    BaseType_t xWrap = pdFALSE;
+    if (xUsed == pxRingbuffer->xSize) {
+        return pdFALSE;     //Buffer is full
+    } else if (pucWrite < pucFree) {
+        //Free space does not wrap around
+        if (xTotalItemSize > pucFree - pucWrite) {
+            return pdFALSE;
+        }
+    } else if (xTotalItemSize > pxRingbuffer->pucTail - pucWrite) {
+        //Item does not fit without wrapping around
+        if (xTotalItemSize > pucFree - pxRingbuffer->pucHead) {
+            return pdFALSE;
+        }
+        xWrap = pdTRUE;
+    }
+
+    if (xWrap == pdTRUE) {
+        ItemHeader_t *pxDummy = (ItemHeader_t *)pucWrite;
+        pxDummy->uxItemFlags = rbITEM_DUMMY_DATA_FLAG;      //Set remaining length as dummy data
+        pxDummy->xItemLen = 0;                              //Dummy data should have no length
+        xWrite = prvSpscNextLap(pxRingbuffer, xWrite);
+        pucWrite = pxRingbuffer->pucHead;
+    }
+    ItemHeader_t *pxHeader = (ItemHeader_t *)pucWrite;
+    pxHeader->xItemLen = xItemSize;
+    pxHeader->uxItemFlags = rbITEM_WRITTEN_FLAG;
+    memcpy(pucWrite + rbHEADER_SIZE, pucItem, xItemSize);
+
+    //Publish the item. The store must be ordered before checking the waiting flag
+    xWrite = prvSpscAdvance(pxRingbuffer, xWrite, xItemSize);
+    atomic_store(&pxRingbuffer->xSpscWrite, xWrite);
+    prvRecordSend(pxRingbuffer, prvSpscUsedSize(pxRingbuffer, xWrite, xFree));
+    prvSpscWake(&pxRingbuffer->xSpscReaderWaiting, pxRingbuffer->xItemsBufferedSemaphore, pxHigherPriorityTaskWoken);
+    return pdTRUE;
+}
+
+static void *prvSpscTryReceive(Ringbuffer_t *pxRingbuffer, size_t *pxItemSize)
+{
+    size_t xRead = pxRingbuffer->xSpscRead;
+    if (xRead == atomic_load(&pxRingbuffer->xSpscWrite)) {
+        return NULL;        //Buffer is empty
+    }
+    ItemHeader_t *pxHeader = (ItemHeader_t *)prvSpscPointer(pxRingbuffer, xRead);
+    //Wrap around if dummy data (dummy data indicates wrap around in no-split buffers)
+    if (pxHeader->uxItemFlags & rbITEM_DUMMY_DATA_FLAG) {
+        xRead = prvSpscNextLap(pxRingbuffer, xRead);
+        pxHeader = (ItemHeader_t *)pxRingbuffer->pucHead;
+    }
+    configASSERT(pxHeader->xItemLen <= pxRingbuffer->xMaxItemSize);
+    configASSERT(pxHeader->uxItemFlags == rbITEM_WRITTEN_FLAG);
+    *pxItemSize = pxHeader->xItemLen;
+    pxRingbuffer->xSpscRead = prvSpscAdvance(pxRingbuffer, xRead, pxHeader->xItemLen);
+    pxRingbuffer->uxItemsReceived++;
+    return (uint8_t *)pxHeader + rbHEADER_SIZE;
+}
+
+static void prvSpscReturnItems(Ringbuffer_t *pxRingbuffer, void **ppvItems, UBaseType_t uxItemCount, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    size_t xFree = atomic_load_explicit(&pxRingbuffer->xSpscFree, memory_order_relaxed);
+    for (UBaseType_t i = 0; i < uxItemCount; i++) {
+        configASSERT(xFree != pxRingbuffer->xSpscRead);     //No items have been retrieved
+
+        //Items must be returned in the order they were retrieved. Skip over dummy data to the oldest item
+        ItemHeader_t *pxHeader = (ItemHeader_t *)prvSpscPointer(pxRingbuffer, xFree);
+        if (pxHeader->uxItemFlags & rbITEM_DUMMY_DATA_FLAG) {
+            xFree = prvSpscNextLap(pxRingbuffer, xFree);
+            pxHeader = (ItemHeader_t *)pxRingbuffer->pucHead;
+        }
+        configASSERT((uint8_t *)ppvItems[i] == (uint8_t *)pxHeader + rbHEADER_SIZE);
+        configASSERT(pxHeader->uxItemFlags == rbITEM_WRITTEN_FLAG);
+        pxHeader->uxItemFlags |= rbITEM_FREE_FLAG;
+        xFree = prvSpscAdvance(pxRingbuffer, xFree, pxHeader->xItemLen);
+    }
+
+    //Publish the free space. The store must be ordered before checking the waiting flag
+    atomic_store(&pxRingbuffer->xSpscFree, xFree);
+    prvSpscWake(&pxRingbuffer->xSpscWriterWaiting, pxRingbuffer->xFreeSpaceSemaphore, pxHigherPriorityTaskWoken);
+}
+
+static size_t prvSpscGetCurMaxSize(Ringbuffer_t *pxRingbuffer)
+{
+    size_t xWrite = atomic_load(&pxRingbuffer->xSpscWrite);
+    size_t xFree = atomic_load(&pxRingbuffer->xSpscFree);
+    uint8_t *pucWrite = prvSpscPointer(pxRingbuffer, xWrite);
+    uint8_t *pucFree = prvSpscPointer(pxRingbuffer, xFree);
+    BaseType_t xFreeSize;
+    if (xWrite != xFree && pucWrite == pucFree) {
+        return 0;           //Buffer is full
+    } else if (pucWrite < pucFree) {
+        xFreeSize = pucFree - pucWrite;
     } else {
-        //Unsupported type
-        configASSERT(0);
+        //Free space wraps around (or the buffer is empty), select largest contiguous free space
+        size_t xSize1 = pxRingbuffer->pucTail - pucWrite;
+        size_t xSize2 = pucFree - pxRingbuffer->pucHead;
+        xFreeSize = (xSize1 > xSize2) ? xSize1 : xSize2;
     }
 
-    if (pxRingbuffer->xFreeSpaceSemaphore == NULL || pxRingbuffer->xItemsBufferedSemaphore == NULL) {
-        goto err;
+    //Items need space for a header. Limit free size to be within bounds
+    xFreeSize -= rbHEADER_SIZE;
+    if (xFreeSize > pxRingbuffer->xMaxItemSize) {
+        xFreeSize = pxRingbuffer->xMaxItemSize;
+    } else if (xFreeSize < 0) {
+        xFreeSize = 0;
     }
-    xSemaphoreGive(pxRingbuffer->xFreeSpaceSemaphore);
-    vPortCPUInitializeMutex(&pxRingbuffer->mux);
+    return xFreeSize;
+}
 
-    return (RingbufHandle_t)pxRingbuffer;
+static BaseType_t prvSpscSend(Ringbuffer_t *pxRingbuffer, const uint8_t *pucItem, size_t xItemSize, TickType_t xTicksToWait)
+{
+    TickType_t xTicksStart = xTaskGetTickCount();
+    TickType_t xTicksEnd = xTicksStart + xTicksToWait;
+    TickType_t xTicksRemaining = xTicksToWait;
+    BaseType_t xReturn = pdFALSE;
+    while (xTicksRemaining <= xTicksToWait) {   //xTicksToWait will underflow once xTaskGetTickCount() > ticks_end
+        xReturn = prvSpscTrySend(pxRingbuffer, pucItem, xItemSize, NULL);
+        if (xReturn == pdTRUE || xTicksToWait == 0) {
+            break;
+        }
+        //Buffer is full. Announce that we are waiting, then check again in case the consumer freed space in between
+        atomic_store(&pxRingbuffer->xSpscWriterWaiting, 1);
+        xReturn = prvSpscTrySend(pxRingbuffer, pucItem, xItemSize, NULL);
+        if (xReturn == pdTRUE) {
+            atomic_store(&pxRingbuffer->xSpscWriterWaiting, 0);
+            break;
+        }
+        if (xSemaphoreTake(pxRingbuffer->xFreeSpaceSemaphore, xTicksRemaining) != pdTRUE) {
+            atomic_store(&pxRingbuffer->xSpscWriterWaiting, 0);
+            break;
+        }
+        if (xTicksToWait != portMAX_DELAY) {
+            xTicksRemaining = xTicksEnd - xTaskGetTickCount();
+        }
+    }
+    prvRecordBlocked(pxRingbuffer, &pxRingbuffer->xSendBlockedTicks, xTicksStart);
+    return xReturn;
+}
 
-err:
-    //Some error has happened. Free/destroy all allocated things and return NULL.
-    if (pxRingbuffer) {
-        free(pxRingbuffer->pucHead);
-        if (pxRingbuffer->xFreeSpaceSemaphore) {
-            vSemaphoreDelete(pxRingbuffer->xFreeSpaceSemaphore);
+static void *prvSpscReceive(Ringbuffer_t *pxRingbuffer, size_t *pxItemSize, TickType_t xTicksToWait)
+{
+    TickType_t xTicksStart = xTaskGetTickCount();
+    TickType_t xTicksEnd = xTicksStart + xTicksToWait;
+    TickType_t xTicksRemaining = xTicksToWait;
+    void *pvItem = NULL;
+    while (xTicksRemaining <= xTicksToWait) {   //xTicksToWait will underflow once xTaskGetTickCount() > ticks_end
+        pvItem = prvSpscTryReceive(pxRingbuffer, pxItemSize);
+        if (pvItem != NULL || xTicksToWait == 0) {
+            break;
         }
-        if (pxRingbuffer->xItemsBufferedSemaphore) {
-            vSemaphoreDelete(pxRingbuffer->xItemsBufferedSemaphore);
+        //Buffer is empty. Announce that we are waiting, then check again in case the producer sent an item in between
+        atomic_store(&pxRingbuffer->xSpscReaderWaiting, 1);
+        pvItem = prvSpscTryReceive(pxRingbuffer, pxItemSize);
+        if (pvItem != NULL) {
+            atomic_store(&pxRingbuffer->xSpscReaderWaiting, 0);
+            break;
+        }
+        if (xSemaphoreTake(pxRingbuffer->xItemsBufferedSemaphore, xTicksRemaining) != pdTRUE) {
+            atomic_store(&pxRingbuffer->xSpscReaderWaiting, 0);
+            break;
+        }
+        if (xTicksToWait != portMAX_DELAY) {
+            xTicksRemaining = xTicksEnd - xTaskGetTickCount();
         }
     }
-    free(pxRingbuffer);
-    return NULL;
+    prvRecordBlocked(pxRingbuffer, &pxRingbuffer->xReceiveBlockedTicks, xTicksStart);
+    return pvItem;
+}
+
+/* ------------------------------------------------- Public Definitions -------------------------------------------- */
+
+RingbufHandle_t xRingbufferCreate(size_t xBufferSize, ringbuf_type_t xBufferType)
+{
+    if (xBufferType != RINGBUF_TYPE_BYTEBUF) {
+        xBufferSize = rbALIGN_SIZE(xBufferSize);    //xBufferSize is rounded up for no-split/allow-split buffers
+    }
+    //Allocate memory
+    Ringbuffer_t *pxRingbuffer = calloc(1, sizeof(Ringbuffer_t));
+    uint8_t *pucRingbufferStorage = malloc(xBufferSize);
+    return prvCreateDynamicRingbuffer(xBufferSize, xBufferType, pxRingbuffer, pucRingbufferStorage);
+}
+
+RingbufHandle_t xRingbufferCreateWithCaps(size_t xBufferSize, ringbuf_type_t xBufferType, uint32_t uxMemoryCaps)
+{
+    if (xBufferType != RINGBUF_TYPE_BYTEBUF) {
+        xBufferSize = rbALIGN_SIZE(xBufferSize);    //xBufferSize is rounded up for no-split/allow-split buffers
+    }
+    //Control structure holds the spinlock, so it always lives in internal memory
+    Ringbuffer_t *pxRingbuffer = heap_caps_calloc(1, sizeof(Ringbuffer_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    uint8_t *pucRingbufferStorage = heap_caps_malloc(xBufferSize, uxMemoryCaps);
+    return prvCreateDynamicRingbuffer(xBufferSize, xBufferType, pxRingbuffer, pucRingbufferStorage);
+}
+
+#if ( configSUPPORT_STATIC_ALLOCATION == 1 )
+RingbufHandle_t xRingbufferCreateStatic(size_t xBufferSize, ringbuf_type_t xBufferType, uint8_t *pucRingbufferStorage, StaticRingbuffer_t *pxStaticRingbuffer)
+{
+    //Check arguments
+    configASSERT(pucRingbufferStorage != NULL && pxStaticRingbuffer != NULL);
+    if (xBufferType != RINGBUF_TYPE_BYTEBUF) {
+        //No-split/allow-split buffers require an aligned storage area
+        configASSERT(rbCHECK_ALIGNED(pucRingbufferStorage));
+        configASSERT(rbALIGN_SIZE(xBufferSize) == xBufferSize);
+    }
+
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)pxStaticRingbuffer;
+    memset(pxRingbuffer, 0, sizeof(Ringbuffer_t));
+    prvInitializeNewRingbuffer(xBufferSize, xBufferType, pxRingbuffer, pucRingbufferStorage);
+    pxRingbuffer->uxRingbufferFlags |= rbBUFFER_STATIC_FLAG;
+    pxRingbuffer->xFreeSpaceSemaphore = xSemaphoreCreateBinaryStatic(&pxRingbuffer->xFreeSpaceSemaphoreStatic);
+    pxRingbuffer->xItemsBufferedSemaphore = xSemaphoreCreateBinaryStatic(&pxRingbuffer->xItemsBufferedSemaphoreStatic);
+    configASSERT(pxRingbuffer->xFreeSpaceSemaphore && pxRingbuffer->xItemsBufferedSemaphore);
+    xSemaphoreGive(pxRingbuffer->xFreeSpaceSemaphore);
+
+    return (RingbufHandle_t)pxRingbuffer;
 }
+#endif
 
 RingbufHandle_t xRingbufferCreateNoSplit(size_t xItemSize, size_t xItemNum)
 {
@@ -753,11 +1212,15 @@ BaseType_t xRingbufferSend(RingbufHandle_t xRingbuffer, const void *pvItem, size
     if ((pxRingbuffer->uxRingbufferFlags & rbBYTE_BUFFER_FLAG) && xItemSize == 0) {
         return pdTRUE;      //Sending 0 bytes to byte buffer has no effect
     }
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        return prvSpscSend(pxRingbuffer, pvItem, xItemSize, xTicksToWait);
+    }
 
     //Attempt to send an item
     BaseType_t xReturn = pdFALSE;
     BaseType_t xReturnSemaphore = pdFALSE;
-    TickType_t xTicksEnd = xTaskGetTickCount() + xTicksToWait;
+    TickType_t xTicksStart = xTaskGetTickCount();
+    TickType_t xTicksEnd = xTicksStart + xTicksToWait;
     TickType_t xTicksRemaining = xTicksToWait;
     while (xTicksRemaining <= xTicksToWait) {   //xTicksToWait will underflow once xTaskGetTickCount() > ticks_end
         //Block until more free space becomes available or timeout
@@ -770,6 +1233,7 @@ BaseType_t xRingbufferSend(RingbufHandle_t xRingbuffer, const void *pvItem, size
         if(pxRingbuffer->xCheckItemFits(pxRingbuffer, xItemSize) == pdTRUE) {
             //Item will fit, copy item
             pxRingbuffer->vCopyItem(pxRingbuffer, pvItem, xItemSize);
+            prvRecordSend(pxRingbuffer, pxRingbuffer->xSize - prvGetFreeSize(pxRingbuffer));
             xReturn = pdTRUE;
             //Check if the free semaphore should be returned to allow other tasks to send
             if (prvGetFreeSize(pxRingbuffer) > 0) {
@@ -788,6 +1252,7 @@ BaseType_t xRingbufferSend(RingbufHandle_t xRingbuffer, const void *pvItem, size
          * semaphore is given now, priority inversion might occur (see docs)
          */
     }
+    prvRecordBlocked(pxRingbuffer, &pxRingbuffer->xSendBlockedTicks, xTicksStart);
 
     if (xReturn == pdTRUE) {
         //Indicate item was successfully sent
@@ -811,6 +1276,9 @@ BaseType_t xRingbufferSendFromISR(RingbufHandle_t xRingbuffer, const void *pvIte
     if ((pxRingbuffer->uxRingbufferFlags & rbBYTE_BUFFER_FLAG) && xItemSize == 0) {
         return pdTRUE;      //Sending 0 bytes to byte buffer has no effect
     }
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        return prvSpscTrySend(pxRingbuffer, pvItem, xItemSize, pxHigherPriorityTaskWoken);
+    }
 
     //Attempt to send an item
     BaseType_t xReturn;
@@ -818,6 +1286,7 @@ BaseType_t xRingbufferSendFromISR(RingbufHandle_t xRingbuffer, const void *pvIte
     portENTER_CRITICAL_ISR(&pxRingbuffer->mux);
     if (pxRingbuffer->xCheckItemFits(xRingbuffer, xItemSize) == pdTRUE) {
         pxRingbuffer->vCopyItem(xRingbuffer, pvItem, xItemSize);
+        prvRecordSend(pxRingbuffer, pxRingbuffer->xSize - prvGetFreeSize(pxRingbuffer));
         xReturn = pdTRUE;
         //Check if the free semaphore should be returned to allow other tasks to send
         if (prvGetFreeSize(pxRingbuffer) > 0) {
@@ -838,6 +1307,79 @@ BaseType_t xRingbufferSendFromISR(RingbufHandle_t xRingbuffer, const void *pvIte
     return xReturn;
 }
 
+BaseType_t xRingbufferSendAcquire(RingbufHandle_t xRingbuffer, void **ppvItem, size_t xItemSize, TickType_t xTicksToWait)
+{
+    //Check arguments
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT(ppvItem != NULL);
+    configASSERT((pxRingbuffer->uxRingbufferFlags & (rbBYTE_BUFFER_FLAG | rbALLOW_SPLIT_FLAG | rbSPSC_FLAG)) == 0);  //Send acquire currently only supported in NoSplit buffers
+    *ppvItem = NULL;
+    if (xItemSize > pxRingbuffer->xMaxItemSize) {
+        return pdFALSE;     //Data will never ever fit in the queue.
+    }
+
+    //Attempt to acquire space for an item
+    BaseType_t xReturn = pdFALSE;
+    BaseType_t xReturnSemaphore = pdFALSE;
+    TickType_t xTicksStart = xTaskGetTickCount();
+    TickType_t xTicksEnd = xTicksStart + xTicksToWait;
+    TickType_t xTicksRemaining = xTicksToWait;
+    while (xTicksRemaining <= xTicksToWait) {   //xTicksToWait will underflow once xTaskGetTickCount() > ticks_end
+        //Block until more free space becomes available or timeout
+        if (xSemaphoreTake(pxRingbuffer->xFreeSpaceSemaphore, xTicksRemaining) != pdTRUE) {
+            xReturn = pdFALSE;
+            break;
+        }
+        //Semaphore obtained, check if item can fit
+        portENTER_CRITICAL(&pxRingbuffer->mux);
+        if (pxRingbuffer->xCheckItemFits(pxRingbuffer, xItemSize) == pdTRUE) {
+            //Item will fit, reserve space for it
+            *ppvItem = prvAcquireItemNoSplit(pxRingbuffer, xItemSize);
+            prvRecordSend(pxRingbuffer, pxRingbuffer->xSize - prvGetFreeSize(pxRingbuffer));
+            xReturn = pdTRUE;
+            //Check if the free semaphore should be returned to allow other tasks to send
+            if (prvGetFreeSize(pxRingbuffer) > 0) {
+                xReturnSemaphore = pdTRUE;
+            }
+            portEXIT_CRITICAL(&pxRingbuffer->mux);
+            break;
+        }
+        //Item doesn't fit, adjust ticks and take the semaphore again
+        if (xTicksToWait != portMAX_DELAY) {
+            xTicksRemaining = xTicksEnd - xTaskGetTickCount();
+        }
+        portEXIT_CRITICAL(&pxRingbuffer->mux);
+        /*
+         * Gap between critical section and re-acquiring of the semaphore. If
+         * semaphore is given now, priority inversion might occur (see docs)
+         */
+    }
+    prvRecordBlocked(pxRingbuffer, &pxRingbuffer->xSendBlockedTicks, xTicksStart);
+
+    if (xReturnSemaphore == pdTRUE) {
+        xSemaphoreGive(pxRingbuffer->xFreeSpaceSemaphore);  //Give back semaphore so other tasks can send
+    }
+    return xReturn;
+}
+
+BaseType_t xRingbufferSendComplete(RingbufHandle_t xRingbuffer, void *pvItem)
+{
+    //Check arguments
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT(pvItem != NULL);
+    configASSERT((pxRingbuffer->uxRingbufferFlags & (rbBYTE_BUFFER_FLAG | rbALLOW_SPLIT_FLAG)) == 0);  //Send acquire currently only supported in NoSplit buffers
+
+    portENTER_CRITICAL(&pxRingbuffer->mux);
+    prvSendItemDoneNoSplit(pxRingbuffer, (uint8_t *)pvItem);
+    portEXIT_CRITICAL(&pxRingbuffer->mux);
+
+    //Indicate item was successfully sent
+    xSemaphoreGive(pxRingbuffer->xItemsBufferedSemaphore);
+    return pdTRUE;
+}
+
 void *xRingbufferReceive(RingbufHandle_t xRingbuffer, size_t *pxItemSize, TickType_t xTicksToWait)
 {
     //Check arguments
@@ -847,6 +1389,13 @@ void *xRingbufferReceive(RingbufHandle_t xRingbuffer, size_t *pxItemSize, TickTy
     //Attempt to retrieve an item
     void *pvTempItem;
     size_t xTempSize;
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        pvTempItem = prvSpscReceive(pxRingbuffer, &xTempSize, xTicksToWait);
+        if (pvTempItem != NULL && pxItemSize != NULL) {
+            *pxItemSize = xTempSize;
+        }
+        return pvTempItem;
+    }
     if (prvReceiveGeneric(pxRingbuffer, &pvTempItem, NULL, &xTempSize, NULL, 0, xTicksToWait) == pdTRUE) {
         if (pxItemSize != NULL) {
             *pxItemSize = xTempSize;
@@ -857,6 +1406,74 @@ void *xRingbufferReceive(RingbufHandle_t xRingbuffer, size_t *pxItemSize, TickTy
     }
 }
 
+UBaseType_t xRingbufferReceiveMany(RingbufHandle_t xRingbuffer, void **ppvItems, size_t *pxItemSizes, UBaseType_t uxMaxItems, TickType_t xTicksToWait)
+{
+    //Check arguments
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT(ppvItems != NULL && uxMaxItems > 0);
+    configASSERT((pxRingbuffer->uxRingbufferFlags & (rbBYTE_BUFFER_FLAG | rbALLOW_SPLIT_FLAG)) == 0);    //Only no-split buffers hold whole items
+
+    UBaseType_t uxCount = 0;
+    size_t xTempSize;
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        //Block for the first item only, then take whatever else has already been sent
+        void *pvTempItem = prvSpscReceive(pxRingbuffer, &xTempSize, xTicksToWait);
+        while (pvTempItem != NULL) {
+            ppvItems[uxCount] = pvTempItem;
+            if (pxItemSizes != NULL) {
+                pxItemSizes[uxCount] = xTempSize;
+            }
+            if (++uxCount == uxMaxItems) {
+                break;
+            }
+            pvTempItem = prvSpscTryReceive(pxRingbuffer, &xTempSize);
+        }
+        return uxCount;
+    }
+
+    BaseType_t xReturnSemaphore = pdFALSE;
+    TickType_t xTicksStart = xTaskGetTickCount();
+    TickType_t xTicksEnd = xTicksStart + xTicksToWait;
+    TickType_t xTicksRemaining = xTicksToWait;
+    while (xTicksRemaining <= xTicksToWait) {   //xTicksToWait will underflow once xTaskGetTickCount() > ticks_end
+        //Block until an item becomes available or timeout
+        if (xSemaphoreTake(pxRingbuffer->xItemsBufferedSemaphore, xTicksRemaining) != pdTRUE) {
+            break;      //Timed out attempting to get semaphore
+        }
+
+        //Semaphore obtained, retrieve as many items as are available in one critical section
+        portENTER_CRITICAL(&pxRingbuffer->mux);
+        while (uxCount < uxMaxItems && prvCheckItemAvail(pxRingbuffer) == pdTRUE) {
+            BaseType_t xIsSplit;
+            ppvItems[uxCount] = pxRingbuffer->pvGetItem(pxRingbuffer, &xIsSplit, 0, &xTempSize);
+            if (pxItemSizes != NULL) {
+                pxItemSizes[uxCount] = xTempSize;
+            }
+            uxCount++;
+        }
+        if (uxCount > 0) {
+            pxRingbuffer->uxItemsReceived += uxCount;
+            if (pxRingbuffer->xItemsWaiting > 0) {
+                xReturnSemaphore = pdTRUE;
+            }
+            portEXIT_CRITICAL(&pxRingbuffer->mux);
+            break;
+        }
+        //No item available for retrieval, adjust ticks and take the semaphore again
+        if (xTicksToWait != portMAX_DELAY) {
+            xTicksRemaining = xTicksEnd - xTaskGetTickCount();
+        }
+        portEXIT_CRITICAL(&pxRingbuffer->mux);
+    }
+    prvRecordBlocked(pxRingbuffer, &pxRingbuffer->xReceiveBlockedTicks, xTicksStart);
+
+    if (xReturnSemaphore == pdTRUE) {
+        xSemaphoreGive(pxRingbuffer->xItemsBufferedSemaphore);  //Give semaphore back so other tasks can retrieve
+    }
+    return uxCount;
+}
+
 void *xRingbufferReceiveFromISR(RingbufHandle_t xRingbuffer, size_t *pxItemSize)
 {
     //Check arguments
@@ -866,6 +1483,13 @@ void *xRingbufferReceiveFromISR(RingbufHandle_t xRingbuffer, size_t *pxItemSize)
     //Attempt to retrieve an item
     void *pvTempItem;
     size_t xTempSize;
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        pvTempItem = prvSpscTryReceive(pxRingbuffer, &xTempSize);
+        if (pvTempItem != NULL && pxItemSize != NULL) {
+            *pxItemSize = xTempSize;
+        }
+        return pvTempItem;
+    }
     if (prvReceiveGenericFromISR(pxRingbuffer, &pvTempItem, NULL, &xTempSize, NULL, 0) == pdTRUE) {
         if (pxItemSize != NULL) {
             *pxItemSize = xTempSize;
@@ -997,18 +1621,51 @@ void vRingbufferReturnItem(RingbufHandle_t xRingbuffer, void *pvItem)
     configASSERT(pxRingbuffer);
     configASSERT(pvItem != NULL);
 
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        prvSpscReturnItems(pxRingbuffer, &pvItem, 1, NULL);
+        return;
+    }
     portENTER_CRITICAL(&pxRingbuffer->mux);
     pxRingbuffer->vReturnItem(pxRingbuffer, (uint8_t *)pvItem);
     portEXIT_CRITICAL(&pxRingbuffer->mux);
     xSemaphoreGive(pxRingbuffer->xFreeSpaceSemaphore);
 }
 
+void vRingbufferReturnItems(RingbufHandle_t xRingbuffer, void **ppvItems, UBaseType_t uxItemCount)
+{
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT(ppvItems != NULL);
+    configASSERT((pxRingbuffer->uxRingbufferFlags & (rbBYTE_BUFFER_FLAG | rbALLOW_SPLIT_FLAG)) == 0);
+
+    if (uxItemCount == 0) {
+        return;
+    }
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        prvSpscReturnItems(pxRingbuffer, ppvItems, uxItemCount, NULL);
+        return;
+    }
+    //Mark every item as free, then move the free pointer once
+    portENTER_CRITICAL(&pxRingbuffer->mux);
+    for (UBaseType_t i = 0; i < uxItemCount; i++) {
+        configASSERT(ppvItems[i] != NULL);
+        prvMarkItemFreeDefault(pxRingbuffer, (uint8_t *)ppvItems[i]);
+    }
+    prvAdvanceFreeDefault(pxRingbuffer);
+    portEXIT_CRITICAL(&pxRingbuffer->mux);
+    xSemaphoreGive(pxRingbuffer->xFreeSpaceSemaphore);
+}
+
 void vRingbufferReturnItemFromISR(RingbufHandle_t xRingbuffer, void *pvItem, BaseType_t *pxHigherPriorityTaskWoken)
 {
     Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
     configASSERT(pxRingbuffer);
     configASSERT(pvItem != NULL);
 
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        prvSpscReturnItems(pxRingbuffer, &pvItem, 1, pxHigherPriorityTaskWoken);
+        return;
+    }
     portENTER_CRITICAL_ISR(&pxRingbuffer->mux);
     pxRingbuffer->vReturnItem(pxRingbuffer, (uint8_t *)pvItem);
     portEXIT_CRITICAL_ISR(&pxRingbuffer->mux);
@@ -1021,13 +1678,16 @@ void vRingbufferDelete(RingbufHandle_t xRingbuffer)
     configASSERT(pxRingbuffer);
 
     if (pxRingbuffer) {
-        free(pxRingbuffer->pucHead);
         if (pxRingbuffer->xFreeSpaceSemaphore) {
             vSemaphoreDelete(pxRingbuffer->xFreeSpaceSemaphore);
         }
         if (pxRingbuffer->xItemsBufferedSemaphore) {
             vSemaphoreDelete(pxRingbuffer->xItemsBufferedSemaphore);
         }
+        if (pxRingbuffer->uxRingbufferFlags & rbBUFFER_STATIC_FLAG) {
+            return;     //Memory belongs to the application
+        }
+        free(pxRingbuffer->pucHead);
     }
     free(pxRingbuffer);
 }
@@ -1055,6 +1715,7 @@ BaseType_t xRingbufferAddToQueueSetRead(RingbufHandle_t xRingbuffer, QueueSetHan
 {
     Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
     configASSERT(pxRingbuffer);
+    configASSERT((pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) == 0);    //Single-producer/single-consumer buffers only give the semaphore to a blocked consumer
 
     BaseType_t xReturn;
     portENTER_CRITICAL(&pxRingbuffer->mux);
@@ -1100,6 +1761,24 @@ void vRingbufferGetInfo(RingbufHandle_t xRingbuffer, UBaseType_t *uxFree, UBaseT
     Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
     configASSERT(pxRingbuffer);
 
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        //Only the indices are tracked, items waiting are not counted to keep the data path lock-free
+        size_t xWrite = atomic_load(&pxRingbuffer->xSpscWrite);
+        size_t xFree = atomic_load(&pxRingbuffer->xSpscFree);
+        if (uxFree != NULL) {
+            *uxFree = (UBaseType_t)(prvSpscPointer(pxRingbuffer, xFree) - pxRingbuffer->pucHead);
+        }
+        if (uxRead != NULL) {
+            *uxRead = (UBaseType_t)(prvSpscPointer(pxRingbuffer, pxRingbuffer->xSpscRead) - pxRingbuffer->pucHead);
+        }
+        if (uxWrite != NULL) {
+            *uxWrite = (UBaseType_t)(prvSpscPointer(pxRingbuffer, xWrite) - pxRingbuffer->pucHead);
+        }
+        if (uxItemsWaiting != NULL) {
+            *uxItemsWaiting = 0;
+        }
+        return;
+    }
     portENTER_CRITICAL(&pxRingbuffer->mux);
     if (uxFree != NULL) {
         *uxFree = (UBaseType_t)(pxRingbuffer->pucFree - pxRingbuffer->pucHead);
@@ -1116,15 +1795,64 @@ void vRingbufferGetInfo(RingbufHandle_t xRingbuffer, UBaseType_t *uxFree, UBaseT
     portEXIT_CRITICAL(&pxRingbuffer->mux);
 }
 
+void vRingbufferGetStats(RingbufHandle_t xRingbuffer, ringbuf_stats_t *pxStats)
+{
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT(pxStats);
+
+    portENTER_CRITICAL(&pxRingbuffer->mux);
+    pxStats->xPeakUsedSize = pxRingbuffer->xPeakUsedSize;
+    pxStats->uxItemsSent = pxRingbuffer->uxItemsSent;
+    pxStats->uxItemsReceived = pxRingbuffer->uxItemsReceived;
+    pxStats->xSendBlockedTicks = pxRingbuffer->xSendBlockedTicks;
+    pxStats->xReceiveBlockedTicks = pxRingbuffer->xReceiveBlockedTicks;
+    pxStats->xElapsedTicks = xTaskGetTickCount() - pxRingbuffer->xStatsStartTick;
+    portEXIT_CRITICAL(&pxRingbuffer->mux);
+
+    if (pxStats->xElapsedTicks > 0) {
+        pxStats->uxItemsPerSecond = (UBaseType_t)(((uint64_t)pxStats->uxItemsReceived * configTICK_RATE_HZ) / pxStats->xElapsedTicks);
+    } else {
+        pxStats->uxItemsPerSecond = 0;
+    }
+}
+
+void vRingbufferResetStats(RingbufHandle_t xRingbuffer)
+{
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+
+    portENTER_CRITICAL(&pxRingbuffer->mux);
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        pxRingbuffer->xPeakUsedSize = prvSpscUsedSize(pxRingbuffer, atomic_load(&pxRingbuffer->xSpscWrite), atomic_load(&pxRingbuffer->xSpscFree));
+    } else {
+        pxRingbuffer->xPeakUsedSize = pxRingbuffer->xSize - prvGetFreeSize(pxRingbuffer);
+    }
+    pxRingbuffer->uxItemsSent = 0;
+    pxRingbuffer->uxItemsReceived = 0;
+    pxRingbuffer->xSendBlockedTicks = 0;
+    pxRingbuffer->xReceiveBlockedTicks = 0;
+    pxRingbuffer->xStatsStartTick = xTaskGetTickCount();
+    portEXIT_CRITICAL(&pxRingbuffer->mux);
+}
+
 void xRingbufferPrintInfo(RingbufHandle_t xRingbuffer)
 {
     Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
     configASSERT(pxRingbuffer);
-    printf("Rb size:%d\tfree: %d\trptr: %d\tfreeptr: %d\twptr: %d\n",
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        printf("Rb size:%d\tfree: %d\trindex: %d\tfreeindex: %d\twindex: %d\n",
+               pxRingbuffer->xSize, prvSpscGetCurMaxSize(pxRingbuffer),
+               pxRingbuffer->xSpscRead, atomic_load(&pxRingbuffer->xSpscFree),
+               atomic_load(&pxRingbuffer->xSpscWrite));
+        return;
+    }
+    printf("Rb size:%d\tfree: %d\trptr: %d\tfreeptr: %d\twptr: %d\taptr: %d\n",
            pxRingbuffer->xSize, prvGetFreeSize(pxRingbuffer),
            pxRingbuffer->pucRead - pxRingbuffer->pucHead,
            pxRingbuffer->pucFree - pxRingbuffer->pucHead,
-           pxRingbuffer->pucWrite - pxRingbuffer->pucHead);
+           pxRingbuffer->pucWrite - pxRingbuffer->pucHead,
+           pxRingbuffer->pucAcquire - pxRingbuffer->pucHead);
 }
 
 /* --------------------------------- Deprecated Functions ------------------------------ */
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
@@ -7,6 +8,7 @@
 #include "freertos/ringbuf.h"
 #include "driver/timer.h"
 #include "esp_spi_flash.h"
+#include "esp_heap_caps.h"
 #include "unity.h"
 #include "test_utils.h"
 
@@ -196,6 +198,39 @@ TEST_CASE("Test ring buffer No-Split", "[freertos]")
     vRingbufferDelete(buffer_handle);
 }
 
+TEST_CASE("Test ring buffer No-Split SPSC", "[freertos]")
+{
+    //Create buffer
+    RingbufHandle_t buffer_handle = xRingbufferCreate(BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT_SPSC);
+    TEST_ASSERT_MESSAGE(buffer_handle != NULL, "Failed to create ring buffer");
+    //Calculate number of items to send. Aim to almost fill buffer to setup for wrap around
+    int no_of_items = (BUFFER_SIZE - (ITEM_HDR_SIZE + SMALL_ITEM_SIZE)) / (ITEM_HDR_SIZE + SMALL_ITEM_SIZE);
+
+    //Test sending items
+    for (int i = 0; i < no_of_items; i++) {
+        send_item_and_check(buffer_handle, small_item, SMALL_ITEM_SIZE, TIMEOUT_TICKS, false);
+    }
+    //Test receiving items
+    for (int i = 0; i < no_of_items; i++) {
+        receive_check_and_return_item_no_split(buffer_handle, small_item, SMALL_ITEM_SIZE, TIMEOUT_TICKS, false);
+    }
+
+    //Write pointer should be near the end, test wrap around
+    uint32_t write_pos_before, write_pos_after;
+    vRingbufferGetInfo(buffer_handle, NULL, NULL, &write_pos_before, NULL);
+    //Send large item that causes wrap around
+    send_item_and_check(buffer_handle, large_item, LARGE_ITEM_SIZE, TIMEOUT_TICKS, false);
+    //Receive wrapped item
+    receive_check_and_return_item_no_split(buffer_handle, large_item, LARGE_ITEM_SIZE, TIMEOUT_TICKS, false);
+    vRingbufferGetInfo(buffer_handle, NULL, NULL, &write_pos_after, NULL);
+    TEST_ASSERT_MESSAGE(write_pos_after < write_pos_before, "Failed to wrap around");
+    //All items have been returned
+    TEST_ASSERT_EQUAL(xRingbufferGetMaxItemSize(buffer_handle), xRingbufferGetCurFreeSize(buffer_handle));
+
+    //Cleanup
+    vRingbufferDelete(buffer_handle);
+}
+
 TEST_CASE("Test ring buffer Allow-Split", "[freertos]")
 {
     //Create buffer
@@ -258,6 +293,163 @@ TEST_CASE("Test ring buffer Byte Buffer", "[freertos]")
     vRingbufferDelete(buffer_handle);
 }
 
+/* ------------------------ Test ring buffer send acquire ----------------------
+ * The following test case will test acquiring and completing items in a
+ * no-split ring buffer. The test case will do the following
+ * 1) Acquire two items that completely fill the buffer
+ * 2) Complete the items in reverse order, checking that neither can be read until the first is complete
+ * 3) Receive both items and return them in reverse order, checking that the buffer only becomes empty once both are returned
+ */
+
+TEST_CASE("Test ring buffer No-Split send acquire", "[freertos]")
+{
+    //Create buffer that exactly fits two large items
+    RingbufHandle_t buffer_handle = xRingbufferCreate(2 * (ITEM_HDR_SIZE + LARGE_ITEM_SIZE), RINGBUF_TYPE_NOSPLIT);
+    TEST_ASSERT_MESSAGE(buffer_handle != NULL, "Failed to create ring buffer");
+
+    uint8_t *first, *second, *extra;
+    TEST_ASSERT_EQUAL(pdTRUE, xRingbufferSendAcquire(buffer_handle, (void **)&first, LARGE_ITEM_SIZE, TIMEOUT_TICKS));
+    TEST_ASSERT_EQUAL(pdTRUE, xRingbufferSendAcquire(buffer_handle, (void **)&second, LARGE_ITEM_SIZE, TIMEOUT_TICKS));
+    TEST_ASSERT_EQUAL(0, xRingbufferGetCurFreeSize(buffer_handle));
+    TEST_ASSERT_EQUAL(pdFALSE, xRingbufferSendAcquire(buffer_handle, (void **)&extra, SMALL_ITEM_SIZE, 0));
+    TEST_ASSERT_NULL(extra);
+
+    //Write items in place and complete them in reverse order
+    memcpy(first, large_item, LARGE_ITEM_SIZE);
+    memcpy(second, small_item, SMALL_ITEM_SIZE);
+    memcpy(second + SMALL_ITEM_SIZE, small_item, SMALL_ITEM_SIZE);
+    TEST_ASSERT_EQUAL(pdTRUE, xRingbufferSendComplete(buffer_handle, second));
+    size_t item_size;
+    TEST_ASSERT_NULL(xRingbufferReceive(buffer_handle, &item_size, 0));
+    TEST_ASSERT_EQUAL(pdTRUE, xRingbufferSendComplete(buffer_handle, first));
+
+    //Both items are now readable in the order they were acquired
+    uint8_t *item1 = (uint8_t *)xRingbufferReceive(buffer_handle, &item_size, TIMEOUT_TICKS);
+    TEST_ASSERT_EQUAL_PTR(first, item1);
+    TEST_ASSERT_EQUAL(LARGE_ITEM_SIZE, item_size);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(large_item, item1, LARGE_ITEM_SIZE);
+    uint8_t *item2 = (uint8_t *)xRingbufferReceive(buffer_handle, &item_size, TIMEOUT_TICKS);
+    TEST_ASSERT_EQUAL_PTR(second, item2);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(small_item, item2 + SMALL_ITEM_SIZE, SMALL_ITEM_SIZE);
+
+    //Buffer stays full until the oldest item is returned
+    vRingbufferReturnItem(buffer_handle, item2);
+    TEST_ASSERT_EQUAL(0, xRingbufferGetCurFreeSize(buffer_handle));
+    vRingbufferReturnItem(buffer_handle, item1);
+    TEST_ASSERT_EQUAL(xRingbufferGetMaxItemSize(buffer_handle), xRingbufferGetCurFreeSize(buffer_handle));
+
+    //Cleanup
+    vRingbufferDelete(buffer_handle);
+}
+
+/* ----------------------- Test ring buffer receive many ----------------------
+ * The following test case will test batched retrieval and return of items from
+ * no-split ring buffers of both kinds. The test case will do the following
+ * 1) Send enough small items to wrap the buffer several times
+ * 2) Retrieve up to four items per call, check their contents and return them with one call
+ * 3) Check that the buffer is empty and fully free at the end
+ */
+
+TEST_CASE("Test ring buffer receive many", "[freertos]")
+{
+    const ringbuf_type_t types[] = {RINGBUF_TYPE_NOSPLIT, RINGBUF_TYPE_NOSPLIT_SPSC};
+    for (int t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+        RingbufHandle_t buffer_handle = xRingbufferCreate(BUFFER_SIZE, types[t]);
+        TEST_ASSERT_MESSAGE(buffer_handle != NULL, "Failed to create ring buffer");
+        size_t max_free = xRingbufferGetCurFreeSize(buffer_handle);
+
+        void *items[4];
+        size_t sizes[4];
+        //Nothing to retrieve yet
+        TEST_ASSERT_EQUAL(0, xRingbufferReceiveMany(buffer_handle, items, sizes, 4, 0));
+
+        int sent = 0, received = 0;
+        const int total = 4 * BUFFER_SIZE / (ITEM_HDR_SIZE + SMALL_ITEM_SIZE);
+        while (received < total) {
+            //Top up the buffer, then drain it in batches
+            while (sent < total && xRingbufferSend(buffer_handle, (void *)small_item, SMALL_ITEM_SIZE, 0) == pdTRUE) {
+                sent++;
+            }
+            UBaseType_t count = xRingbufferReceiveMany(buffer_handle, items, sizes, 4, TIMEOUT_TICKS);
+            TEST_ASSERT_TRUE(count > 0 && count <= 4);
+            for (int i = 0; i < count; i++) {
+                TEST_ASSERT_EQUAL(SMALL_ITEM_SIZE, sizes[i]);
+                TEST_ASSERT_EQUAL_HEX8_ARRAY(small_item, items[i], SMALL_ITEM_SIZE);
+            }
+            vRingbufferReturnItems(buffer_handle, items, count);
+            received += count;
+        }
+        TEST_ASSERT_EQUAL(sent, received);
+        TEST_ASSERT_EQUAL(0, xRingbufferReceiveMany(buffer_handle, items, NULL, 4, 0));
+        TEST_ASSERT_EQUAL(max_free, xRingbufferGetCurFreeSize(buffer_handle));
+
+        //Cleanup
+        vRingbufferDelete(buffer_handle);
+    }
+}
+
+/* ---------------------- Test ring buffer creation variants ---------------------
+ * The following test case will test ring buffers created with caps-aware and
+ * statically allocated storage, and the ring buffer statistics. For each variant
+ * 1) Fill the buffer with small items and check the peak used size and items sent
+ * 2) Time out sending to the full buffer and check the send blocked time
+ * 3) Retrieve and return all items, then time out receiving from the empty buffer
+ */
+
+static void check_ring_buffer_stats(RingbufHandle_t buffer_handle)
+{
+    ringbuf_stats_t stats;
+    vRingbufferGetStats(buffer_handle, &stats);
+    TEST_ASSERT_EQUAL(0, stats.uxItemsSent);
+    TEST_ASSERT_EQUAL(0, stats.xPeakUsedSize);
+
+    int no_of_items = 0;
+    while (xRingbufferSend(buffer_handle, (void *)small_item, SMALL_ITEM_SIZE, 0) == pdTRUE) {
+        no_of_items++;
+    }
+    TEST_ASSERT_EQUAL(pdFALSE, xRingbufferSend(buffer_handle, (void *)small_item, SMALL_ITEM_SIZE, TIMEOUT_TICKS));
+    vRingbufferGetStats(buffer_handle, &stats);
+    TEST_ASSERT_EQUAL(no_of_items, stats.uxItemsSent);
+    TEST_ASSERT_EQUAL(no_of_items * (ITEM_HDR_SIZE + SMALL_ITEM_SIZE), stats.xPeakUsedSize);
+    TEST_ASSERT_TRUE(stats.xSendBlockedTicks >= TIMEOUT_TICKS - 1);
+
+    for (int i = 0; i < no_of_items; i++) {
+        receive_check_and_return_item_no_split(buffer_handle, small_item, SMALL_ITEM_SIZE, 0, false);
+    }
+    TEST_ASSERT_NULL(xRingbufferReceive(buffer_handle, NULL, TIMEOUT_TICKS));
+    vRingbufferGetStats(buffer_handle, &stats);
+    TEST_ASSERT_EQUAL(no_of_items, stats.uxItemsReceived);
+    TEST_ASSERT_TRUE(stats.xReceiveBlockedTicks >= TIMEOUT_TICKS - 1);
+
+    vRingbufferResetStats(buffer_handle);
+    vRingbufferGetStats(buffer_handle, &stats);
+    TEST_ASSERT_EQUAL(0, stats.uxItemsSent);
+    TEST_ASSERT_EQUAL(0, stats.uxItemsReceived);
+    TEST_ASSERT_EQUAL(0, stats.xSendBlockedTicks);
+}
+
+TEST_CASE("Test ring buffer creation variants and statistics", "[freertos]")
+{
+    RingbufHandle_t buffer_handle = xRingbufferCreate(BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT);
+    TEST_ASSERT_MESSAGE(buffer_handle != NULL, "Failed to create ring buffer");
+    check_ring_buffer_stats(buffer_handle);
+    vRingbufferDelete(buffer_handle);
+
+    buffer_handle = xRingbufferCreateWithCaps(BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    TEST_ASSERT_MESSAGE(buffer_handle != NULL, "Failed to create ring buffer");
+    check_ring_buffer_stats(buffer_handle);
+    vRingbufferDelete(buffer_handle);
+
+#if CONFIG_SUPPORT_STATIC_ALLOCATION
+    static StaticRingbuffer_t buffer_struct;
+    static uint8_t buffer_storage[BUFFER_SIZE] __attribute__((aligned(4)));
+    buffer_handle = xRingbufferCreateStatic(BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT, buffer_storage, &buffer_struct);
+    TEST_ASSERT_EQUAL_PTR(&buffer_struct, buffer_handle);
+    check_ring_buffer_stats(buffer_handle);
+    vRingbufferDelete(buffer_handle);
+#endif
+}
+
 /* ----------------------- Ring buffer queue sets test ------------------------
  * The following test case will test receiving from ring buffers that have been
  * added to a queue set. The test case will do the following...
@@ -503,7 +695,7 @@ static void read_from_buffer(RingbufHandle_t buffer, ringbuf_type_t buf_type, si
             char *item_data, *item_data2;
 
             //Select appropriate receive function for type of ring buffer
-            if (buf_type ==  RINGBUF_TYPE_NOSPLIT) {
+            if (buf_type ==  RINGBUF_TYPE_NOSPLIT || buf_type == RINGBUF_TYPE_NOSPLIT_SPSC) {
                 item_data = (char *)xRingbufferReceive(buffer, &item_size, TIMEOUT_TICKS);
             } else if (buf_type == RINGBUF_TYPE_ALLOWSPLIT) {
                 BaseType_t ret = xRingbufferReceiveSplit(buffer, (void **)&item_data, (void **)&item_data2, &item_size, &item_size2, TIMEOUT_TICKS);
@@ -576,8 +768,8 @@ TEST_CASE("Test ring buffer SMP", "[freertos]")
     tasks_done = xSemaphoreCreateBinary();                //Semaphore used to to indicate send and receive tasks completed running
     srand(SRAND_SEED);                                  //Seed RNG
 
-    //Iterate through buffer types (No split, split, then byte buff)
-    for (ringbuf_type_t buf_type = 0; buf_type <= RINGBUF_TYPE_BYTEBUF; buf_type++) {
+    //Iterate through buffer types (No split, split, byte buff, then single-producer/single-consumer no split)
+    for (ringbuf_type_t buf_type = 0; buf_type <= RINGBUF_TYPE_NOSPLIT_SPSC; buf_type++) {
         //Create buffer
         task_args_t task_args;
         task_args.buffer = xRingbufferCreate(CONT_DATA_TEST_BUFF_LEN, buf_type); //Create buffer of selected type
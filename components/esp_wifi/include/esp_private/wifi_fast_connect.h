@@ -0,0 +1,73 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/**
+ * @file esp_private/wifi_fast_connect.h
+ *
+ * Hooks through which the PHY init code, the DHCP client and the default event
+ * handlers feed the fast connect profile of esp_wifi_fast_connect.h.
+ * They are only called when CONFIG_ESP32_WIFI_FAST_CONNECT is enabled.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_phy_init.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Get the PHY calibration data kept in RTC memory
+ * @param[out] cal_data  filled with the data
+ * @return true if the data is valid
+ */
+bool wifi_fast_connect_load_cal_data(esp_phy_calibration_data_t *cal_data);
+
+/**
+ * @brief Keep the PHY calibration data in RTC memory, after the PHY was initialized with it
+ * @param cal_data  calibration data
+ * @param init_us  time the PHY initialization took, in microseconds
+ */
+void wifi_fast_connect_store_cal_data(const esp_phy_calibration_data_t *cal_data, int64_t init_us);
+
+/**
+ * @brief Get the station address of the last DHCP lease
+ * @param[out] ip_addr  the address, in network byte order
+ * @return true if there is a lease for the AP the station is connected to
+ */
+bool wifi_fast_connect_get_lease(uint32_t *ip_addr);
+
+/**
+ * @brief Keep the station address of a DHCP lease, 0 to forget it
+ */
+void wifi_fast_connect_set_lease(uint32_t ip_addr);
+
+/** @brief Called on SYSTEM_EVENT_STA_START */
+void wifi_fast_connect_sta_start(void);
+
+/** @brief Called on SYSTEM_EVENT_STA_CONNECTED */
+void wifi_fast_connect_sta_connected(void);
+
+/** @brief Called on SYSTEM_EVENT_STA_DISCONNECTED */
+void wifi_fast_connect_sta_disconnected(void);
+
+/** @brief Called on SYSTEM_EVENT_STA_GOT_IP; saves the association data of the AP */
+void wifi_fast_connect_sta_got_ip(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,90 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Time spent in each phase of the last connection, and what was restored for it
+ *
+ * Times are in microseconds. The Wi-Fi events are timestamped when the event task
+ * handles them.
+ */
+typedef struct {
+    int64_t phy_init_us;    /*!< PHY initialization, including calibration */
+    int64_t connect_us;     /*!< From SYSTEM_EVENT_STA_START, or the last SYSTEM_EVENT_STA_DISCONNECTED, to SYSTEM_EVENT_STA_CONNECTED: scan, authentication, association and 4-way handshake */
+    int64_t dhcp_us;        /*!< From SYSTEM_EVENT_STA_CONNECTED to SYSTEM_EVENT_STA_GOT_IP */
+    int64_t got_ip_us;      /*!< From boot to SYSTEM_EVENT_STA_GOT_IP */
+    bool cal_restored;      /*!< PHY calibration data was restored from RTC memory */
+    bool assoc_restored;    /*!< esp_wifi_fast_connect_apply set the BSSID and channel of the last AP */
+    bool pmk_restored;      /*!< esp_wifi_fast_connect_apply replaced the passphrase with the PMK */
+    bool lease_restored;    /*!< The DHCP client asked for the address restored from RTC memory */
+} esp_wifi_fast_connect_stats_t;
+
+/**
+ * @brief Apply the association data of the last AP to a station configuration
+ *
+ * If the station got an IP address from an AP with the same SSID and password before,
+ * the BSSID and channel of that AP are set in the configuration, so that the station
+ * connects without a full scan, and the passphrase is replaced with the PMK derived
+ * from it, so that the 4-way handshake does not need to derive it again.
+ *
+ * Call this before esp_wifi_set_config. The data is restored from RTC memory, or from
+ * NVS after a power-on reset. It is updated when the station gets an IP address, and
+ * forgotten if the station disconnects before getting one.
+ *
+ * @param[inout] config  station configuration; left unchanged unless ESP_OK is returned
+ *
+ * @return
+ *    - ESP_OK: the configuration was changed
+ *    - ESP_ERR_NOT_FOUND: no association data for this SSID and password
+ *    - ESP_ERR_INVALID_ARG: config is NULL
+ *    - ESP_ERR_NOT_SUPPORTED: CONFIG_ESP32_WIFI_FAST_CONNECT is disabled
+ */
+esp_err_t esp_wifi_fast_connect_apply(wifi_config_t *config);
+
+/**
+ * @brief Forget the association data and the DHCP lease of the last AP
+ *
+ * The PHY calibration data is kept.
+ *
+ * @return
+ *    - ESP_OK
+ *    - ESP_ERR_NOT_SUPPORTED: CONFIG_ESP32_WIFI_FAST_CONNECT is disabled
+ */
+esp_err_t esp_wifi_fast_connect_invalidate(void);
+
+/**
+ * @brief Get the time spent in each phase of the last connection
+ *
+ * @param[out] stats  filled with the times; the phases not done yet are zero
+ *
+ * @return
+ *    - ESP_OK
+ *    - ESP_ERR_INVALID_ARG: stats is NULL
+ *    - ESP_ERR_NOT_SUPPORTED: CONFIG_ESP32_WIFI_FAST_CONNECT is disabled
+ */
+esp_err_t esp_wifi_fast_connect_get_stats(esp_wifi_fast_connect_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,417 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Fast connect profile.
+ *
+ * The association data of the last AP the station got an IP address from (BSSID,
+ * channel, PMK), the address of the DHCP lease and the PHY calibration data are
+ * kept in RTC memory, which keeps its contents across all resets but power-on.
+ * The association data and the lease are also saved to NVS, from where they are
+ * restored when the RTC copy is not valid. The PHY calibration data already has
+ * its own copy in NVS, see phy_init.c.
+ *
+ * Each copy is checked with a CRC, so that the random contents of RTC memory after
+ * a power-on reset, or data written by a different version of this file, are never
+ * used.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "esp_wifi.h"
+#include "esp_wifi_fast_connect.h"
+
+#if CONFIG_ESP32_WIFI_FAST_CONNECT
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_private/wifi_fast_connect.h"
+#include "esp32/rom/crc.h"
+#include "freertos/FreeRTOS.h"
+#include "nvs.h"
+#include "crypto/common.h"
+#include "crypto/sha1.h"
+
+#define FAST_CONNECT_NAMESPACE  "fast_connect"
+#define FAST_CONNECT_KEY        "profile"
+
+/* Both change whenever the layout of the structures below changes */
+#define PROFILE_MAGIC           0xfc5a0001
+#define CAL_MAGIC               0xfcca0001
+
+#define PROFILE_ASSOC           (1 << 0)    /* bssid, channel and config_hash are valid */
+#define PROFILE_PMK             (1 << 1)    /* pmk is valid */
+#define PROFILE_LEASE           (1 << 2)    /* ip_addr is valid */
+
+#define PMK_LEN                 32
+#define PMK_ITERATIONS          4096
+
+typedef struct {
+    uint32_t magic;
+    uint32_t flags;
+    uint32_t config_hash;   /* hash of the SSID and password the profile is for */
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t reserved;
+    uint8_t pmk[PMK_LEN];
+    uint32_t ip_addr;
+    uint32_t crc;           /* of the fields above; the NVS copy ends here */
+    uint32_t nvs_crc;       /* crc of the NVS copy, 0 if unknown */
+} fast_connect_profile_t;
+
+#define PROFILE_NVS_SIZE        offsetof(fast_connect_profile_t, nvs_crc)
+
+typedef struct {
+    uint32_t magic;
+    esp_phy_calibration_data_t data;
+    uint32_t crc;
+} fast_connect_cal_t;
+
+static RTC_NOINIT_ATTR fast_connect_profile_t s_profile;
+static RTC_NOINIT_ATTR fast_connect_cal_t s_cal;
+
+static portMUX_TYPE s_profile_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool s_profile_checked;  /* s_profile was checked, or restored from NVS, since boot */
+
+/* Set by esp_wifi_fast_connect_apply until the station gets an IP address */
+static bool s_applied;
+static uint32_t s_applied_hash;
+static wifi_sta_config_t s_orig_config;
+
+static esp_wifi_fast_connect_stats_t s_stats;
+static int64_t s_connect_start_us;
+static int64_t s_connected_us;
+
+static const char *TAG = "fast_connect";
+
+static uint32_t profile_crc(const fast_connect_profile_t *profile)
+{
+    return crc32_le(0, (const uint8_t *) profile, offsetof(fast_connect_profile_t, crc));
+}
+
+static bool profile_valid(const fast_connect_profile_t *profile)
+{
+    return profile->magic == PROFILE_MAGIC && profile->crc == profile_crc(profile);
+}
+
+static void profile_get(fast_connect_profile_t *profile)
+{
+    portENTER_CRITICAL(&s_profile_lock);
+    *profile = s_profile;
+    portEXIT_CRITICAL(&s_profile_lock);
+}
+
+static void profile_set(fast_connect_profile_t *profile)
+{
+    profile->magic = PROFILE_MAGIC;
+    profile->crc = profile_crc(profile);
+    portENTER_CRITICAL(&s_profile_lock);
+    s_profile = *profile;
+    portEXIT_CRITICAL(&s_profile_lock);
+}
+
+static void profile_load(fast_connect_profile_t *profile)
+{
+    profile_get(profile);
+    if (s_profile_checked) {
+        return;
+    }
+    if (!profile_valid(profile)) {
+        nvs_handle handle;
+        size_t size = PROFILE_NVS_SIZE;
+        memset(profile, 0, sizeof(*profile));
+        if (nvs_open(FAST_CONNECT_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+            if (nvs_get_blob(handle, FAST_CONNECT_KEY, profile, &size) != ESP_OK ||
+                    size != PROFILE_NVS_SIZE || !profile_valid(profile)) {
+                memset(profile, 0, sizeof(*profile));
+            }
+            nvs_close(handle);
+        }
+        profile->nvs_crc = profile->crc;
+        profile_set(profile);
+        ESP_LOGD(TAG, "profile restored from NVS, flags 0x%x", profile->flags);
+    }
+    s_profile_checked = true;
+}
+
+static void profile_save(fast_connect_profile_t *profile)
+{
+    nvs_handle handle;
+
+    profile_set(profile);
+    if (profile->nvs_crc == profile->crc) {
+        return;
+    }
+    esp_err_t err = nvs_open(FAST_CONNECT_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        if (profile->flags == 0) {
+            err = nvs_erase_key(handle, FAST_CONNECT_KEY);
+            if (err == ESP_ERR_NVS_NOT_FOUND) {
+                err = ESP_OK;
+            }
+        } else {
+            err = nvs_set_blob(handle, FAST_CONNECT_KEY, profile, PROFILE_NVS_SIZE);
+        }
+        if (err == ESP_OK) {
+            err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "failed to save the profile to NVS (0x%x)", err);
+        return;
+    }
+    portENTER_CRITICAL(&s_profile_lock);
+    s_profile.nvs_crc = profile->crc;
+    portEXIT_CRITICAL(&s_profile_lock);
+}
+
+static uint32_t config_hash(const wifi_sta_config_t *config)
+{
+    uint8_t ssid_len = strnlen((const char *) config->ssid, sizeof(config->ssid));
+    size_t password_len = strnlen((const char *) config->password, sizeof(config->password));
+    uint32_t hash = crc32_le(0, &ssid_len, 1);
+
+    hash = crc32_le(hash, config->ssid, ssid_len);
+    return crc32_le(hash, config->password, password_len);
+}
+
+static bool config_uses_passphrase(const wifi_sta_config_t *config, wifi_auth_mode_t authmode)
+{
+    size_t password_len = strnlen((const char *) config->password, sizeof(config->password));
+
+    if (authmode != WIFI_AUTH_WPA_PSK && authmode != WIFI_AUTH_WPA2_PSK &&
+            authmode != WIFI_AUTH_WPA_WPA2_PSK) {
+        return false;
+    }
+    /* 64 characters are the PMK already, in hex */
+    return password_len >= 8 && password_len < sizeof(config->password);
+}
+
+esp_err_t esp_wifi_fast_connect_apply(wifi_config_t *config)
+{
+    static const char hex[] = "0123456789abcdef";
+    fast_connect_profile_t profile;
+
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    profile_load(&profile);
+
+    uint32_t hash = config_hash(&config->sta);
+    if (!(profile.flags & PROFILE_ASSOC) || profile.config_hash != hash) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    s_orig_config = config->sta;
+    s_applied_hash = hash;
+    s_applied = true;
+
+    config->sta.bssid_set = true;
+    memcpy(config->sta.bssid, profile.bssid, sizeof(config->sta.bssid));
+    config->sta.channel = profile.channel;
+    s_stats.assoc_restored = true;
+    s_stats.pmk_restored = false;
+    if (profile.flags & PROFILE_PMK) {
+        for (int i = 0; i < PMK_LEN; i++) {
+            config->sta.password[2 * i] = hex[profile.pmk[i] >> 4];
+            config->sta.password[2 * i + 1] = hex[profile.pmk[i] & 0xf];
+        }
+        s_stats.pmk_restored = true;
+    }
+    ESP_LOGD(TAG, "applied " MACSTR " channel %d%s", MAC2STR(profile.bssid), profile.channel,
+             s_stats.pmk_restored ? ", pmk" : "");
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_fast_connect_invalidate(void)
+{
+    fast_connect_profile_t profile;
+
+    profile_load(&profile);
+    profile.flags = 0;
+    memset(profile.pmk, 0, sizeof(profile.pmk));
+    profile_save(&profile);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_fast_connect_get_stats(esp_wifi_fast_connect_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *stats = s_stats;
+    return ESP_OK;
+}
+
+bool wifi_fast_connect_load_cal_data(esp_phy_calibration_data_t *cal_data)
+{
+    if (s_cal.magic != CAL_MAGIC ||
+            s_cal.crc != crc32_le(0, (const uint8_t *) &s_cal.data, sizeof(s_cal.data))) {
+        return false;
+    }
+    memcpy(cal_data, &s_cal.data, sizeof(*cal_data));
+    s_stats.cal_restored = true;
+    return true;
+}
+
+void wifi_fast_connect_store_cal_data(const esp_phy_calibration_data_t *cal_data, int64_t init_us)
+{
+    memcpy(&s_cal.data, cal_data, sizeof(s_cal.data));
+    s_cal.crc = crc32_le(0, (const uint8_t *) &s_cal.data, sizeof(s_cal.data));
+    s_cal.magic = CAL_MAGIC;
+    s_stats.phy_init_us = init_us;
+}
+
+bool wifi_fast_connect_get_lease(uint32_t *ip_addr)
+{
+    fast_connect_profile_t profile;
+    wifi_ap_record_t ap;
+
+    profile_load(&profile);
+    if ((profile.flags & (PROFILE_ASSOC | PROFILE_LEASE)) != (PROFILE_ASSOC | PROFILE_LEASE) ||
+            esp_wifi_sta_get_ap_info(&ap) != ESP_OK ||
+            memcmp(ap.bssid, profile.bssid, sizeof(ap.bssid)) != 0) {
+        return false;
+    }
+    *ip_addr = profile.ip_addr;
+    s_stats.lease_restored = true;
+    return true;
+}
+
+void wifi_fast_connect_set_lease(uint32_t ip_addr)
+{
+    fast_connect_profile_t profile;
+
+    profile_load(&profile);
+    profile.ip_addr = ip_addr;
+    if (ip_addr != 0) {
+        profile.flags |= PROFILE_LEASE;
+    } else {
+        profile.flags &= ~PROFILE_LEASE;
+    }
+    profile_set(&profile);
+}
+
+void wifi_fast_connect_sta_start(void)
+{
+    s_connect_start_us = esp_timer_get_time();
+    s_connected_us = 0;
+    s_stats.connect_us = 0;
+    s_stats.dhcp_us = 0;
+    s_stats.got_ip_us = 0;
+}
+
+void wifi_fast_connect_sta_connected(void)
+{
+    s_connected_us = esp_timer_get_time();
+    s_stats.connect_us = s_connected_us - s_connect_start_us;
+}
+
+void wifi_fast_connect_sta_disconnected(void)
+{
+    wifi_fast_connect_sta_start();
+    if (!s_applied) {
+        return;
+    }
+    /* The AP moved to another channel, or the password changed: forget it, and
+     * let the next esp_wifi_connect scan as if esp_wifi_fast_connect_apply was not called.
+     */
+    ESP_LOGW(TAG, "failed to connect to the last AP, forgetting it");
+    s_applied = false;
+    s_stats.assoc_restored = false;
+    s_stats.pmk_restored = false;
+    s_stats.lease_restored = false;
+    esp_wifi_fast_connect_invalidate();
+
+    wifi_config_t config = { .sta = s_orig_config };
+    esp_err_t err = esp_wifi_set_config(ESP_IF_WIFI_STA, &config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to restore the station configuration (0x%x)", err);
+    }
+}
+
+void wifi_fast_connect_sta_got_ip(void)
+{
+    fast_connect_profile_t profile;
+    wifi_config_t config;
+    wifi_ap_record_t ap;
+    int64_t now = esp_timer_get_time();
+
+    if (s_connected_us != 0) {
+        s_stats.dhcp_us = now - s_connected_us;
+    }
+    s_stats.got_ip_us = now;
+    ESP_LOGI(TAG, "phy init %lld us%s, connect %lld us%s%s, dhcp %lld us%s, got ip %lld us after boot",
+             s_stats.phy_init_us, s_stats.cal_restored ? " (cal restored)" : "",
+             s_stats.connect_us, s_stats.assoc_restored ? " (assoc restored)" : "",
+             s_stats.pmk_restored ? " (pmk restored)" : "",
+             s_stats.dhcp_us, s_stats.lease_restored ? " (lease restored)" : "",
+             s_stats.got_ip_us);
+
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK ||
+            esp_wifi_get_config(ESP_IF_WIFI_STA, &config) != ESP_OK) {
+        return;
+    }
+    /* With the PMK applied, the configuration has it in place of the passphrase */
+    uint32_t hash = s_applied ? s_applied_hash : config_hash(&config.sta);
+    const wifi_sta_config_t *sta = s_applied ? &s_orig_config : &config.sta;
+    s_applied = false;
+
+    profile_load(&profile);
+    if (profile.config_hash != hash) {
+        profile.flags &= ~PROFILE_PMK;
+    }
+    profile.flags |= PROFILE_ASSOC;
+    profile.config_hash = hash;
+    memcpy(profile.bssid, ap.bssid, sizeof(profile.bssid));
+    profile.channel = ap.primary;
+
+    if (!config_uses_passphrase(sta, ap.authmode)) {
+        profile.flags &= ~PROFILE_PMK;
+        memset(profile.pmk, 0, sizeof(profile.pmk));
+    } else if (!(profile.flags & PROFILE_PMK)) {
+        char passphrase[sizeof(sta->password) + 1] = { 0 };
+        memcpy(passphrase, sta->password, sizeof(sta->password));
+        if (pbkdf2_sha1(passphrase, (const char *) sta->ssid,
+                        strnlen((const char *) sta->ssid, sizeof(sta->ssid)),
+                        PMK_ITERATIONS, profile.pmk, PMK_LEN) == 0) {
+            profile.flags |= PROFILE_PMK;
+        }
+        memset(passphrase, 0, sizeof(passphrase));
+    }
+    profile_save(&profile);
+}
+
+#else // CONFIG_ESP32_WIFI_FAST_CONNECT
+
+esp_err_t esp_wifi_fast_connect_apply(wifi_config_t *config)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_wifi_fast_connect_invalidate(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_wifi_fast_connect_get_stats(esp_wifi_fast_connect_stats_t *stats)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_ESP32_WIFI_FAST_CONNECT
@@ -39,6 +39,7 @@
 #include "esp_coexist_internal.h"
 #include "driver/periph_ctrl.h"
 #include "esp_private/wifi.h"
+#include "esp_private/wifi_fast_connect.h"
 
 extern wifi_mac_time_update_cb_t s_wifi_mac_time_update_cb;
 
@@ -634,7 +635,20 @@ void esp_phy_load_cal_and_init(phy_rf_module_t module)
     if (rtc_get_reset_reason(0) == DEEPSLEEP_RESET) {
         calibration_mode = PHY_RF_CAL_NONE;
     }
+#if CONFIG_ESP32_WIFI_FAST_CONNECT
+    int64_t init_start_us = esp_timer_get_time();
+    esp_err_t err = ESP_OK;
+    if (wifi_fast_connect_load_cal_data(cal_data)) {
+        /* RTC memory kept the data of the last initialization, no need to read NVS */
+#if CONFIG_ESP32_WIFI_FAST_CONNECT_SKIP_CAL
+        calibration_mode = PHY_RF_CAL_NONE;
+#endif
+    } else {
+        err = esp_phy_load_cal_data_from_nvs(cal_data);
+    }
+#else
     esp_err_t err = esp_phy_load_cal_data_from_nvs(cal_data);
+#endif
     if (err != ESP_OK) {
         ESP_LOGW(TAG, "failed to load RF calibration data (0x%x), falling back to full calibration", err);
         calibration_mode = PHY_RF_CAL_FULL;
@@ -649,6 +663,9 @@ void esp_phy_load_cal_and_init(phy_rf_module_t module)
     } else {
         err = ESP_OK;
     }
+#if CONFIG_ESP32_WIFI_FAST_CONNECT
+    wifi_fast_connect_store_cal_data(cal_data, esp_timer_get_time() - init_start_us);
+#endif
 #else
     esp_phy_rf_init(init_data, PHY_RF_CAL_FULL, cal_data, module);
 #endif
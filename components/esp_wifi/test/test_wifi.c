@@ -8,6 +8,7 @@
 #include "esp_event_loop.h"
 #include "esp_wifi.h"
 #include "esp_wifi_types.h"
+#include "esp_wifi_fast_connect.h"
 #include "esp_log.h"
 #include "nvs_flash.h"
 #include "test_utils.h"
@@ -312,3 +313,81 @@ static void test_wifi_connection_softap(void)
 }
 
 TEST_CASE_MULTIPLE_DEVICES("test wifi retain connection for 60s", "[wifi][test_env=UT_T2_1][timeout=90]", test_wifi_connection_sta, test_wifi_connection_softap);
+
+#if CONFIG_ESP32_WIFI_FAST_CONNECT
+static void wifi_connect_and_wait(wifi_config_t *w_config)
+{
+    EventBits_t bits;
+
+    TEST_ESP_OK(esp_wifi_set_config(WIFI_IF_STA, w_config));
+    TEST_ESP_OK(esp_wifi_connect());
+    bits = xEventGroupWaitBits(wifi_events, GOT_IP_EVENT, 1, 0, 10000/portTICK_RATE_MS);
+    TEST_ASSERT(bits == GOT_IP_EVENT);
+}
+
+static void test_wifi_fast_connect_sta(void)
+{
+    char mac_str[19];
+    uint8_t mac[6];
+    esp_wifi_fast_connect_stats_t stats;
+    wifi_config_t w_config = {
+        .sta.ssid = DEFAULT_SSID,
+        .sta.password = DEFAULT_PWD,
+    };
+
+    test_case_uses_tcpip();
+
+    start_wifi_as_sta();
+
+    unity_wait_for_signal_param("SoftAP mac", mac_str, 19);
+    TEST_ASSERT_TRUE(unity_util_convert_mac_from_string(mac_str, mac));
+
+    TEST_ESP_OK(esp_wifi_fast_connect_invalidate());
+    TEST_ESP_ERR(ESP_ERR_NOT_FOUND, esp_wifi_fast_connect_apply(&w_config));
+    TEST_ASSERT_FALSE(w_config.sta.bssid_set);
+    wifi_connect_and_wait(&w_config);
+    TEST_ESP_OK(esp_wifi_fast_connect_get_stats(&stats));
+    TEST_ASSERT_FALSE(stats.assoc_restored);
+    TEST_ASSERT(stats.connect_us > 0 && stats.dhcp_us > 0 && stats.got_ip_us > 0);
+
+    ESP_LOGI(TAG, "reconnect with the saved AP");
+    TEST_ESP_OK(esp_wifi_disconnect());
+    xEventGroupWaitBits(wifi_events, DISCONNECT_EVENT, 1, 0, 5000/portTICK_RATE_MS);
+    TEST_ESP_OK(esp_wifi_fast_connect_apply(&w_config));
+    TEST_ASSERT_TRUE(w_config.sta.bssid_set);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(mac, w_config.sta.bssid, 6);
+    TEST_ASSERT_EQUAL(1, w_config.sta.channel);
+    TEST_ASSERT_EQUAL(64, strnlen((const char *) w_config.sta.password, sizeof(w_config.sta.password)));
+    wifi_connect_and_wait(&w_config);
+    TEST_ESP_OK(esp_wifi_fast_connect_get_stats(&stats));
+    TEST_ASSERT_TRUE(stats.assoc_restored);
+    TEST_ASSERT_TRUE(stats.pmk_restored);
+    TEST_ASSERT_TRUE(stats.lease_restored);
+
+    unity_send_signal("STA connected");
+
+    TEST_ESP_OK(esp_wifi_fast_connect_invalidate());
+    stop_wifi();
+}
+
+static void test_wifi_fast_connect_softap(void)
+{
+    char mac_str[19] = {0};
+    uint8_t mac[6];
+
+    test_case_uses_tcpip();
+
+    start_wifi_as_softap();
+
+    TEST_ESP_OK(esp_wifi_get_mac(ESP_IF_WIFI_AP, mac));
+    sprintf(mac_str, MACSTR, MAC2STR(mac));
+
+    unity_send_signal_param("SoftAP mac", mac_str);
+
+    unity_wait_for_signal("STA connected");
+
+    stop_wifi();
+}
+
+TEST_CASE_MULTIPLE_DEVICES("wifi fast connect reconnects to the saved AP", "[wifi][test_env=UT_T2_1][timeout=60]", test_wifi_fast_connect_sta, test_wifi_fast_connect_softap);
+#endif // CONFIG_ESP32_WIFI_FAST_CONNECT
@@ -458,7 +458,10 @@ class ESPCoreDumpLoaderError(ESPCoreDumpError):
 class ESPCoreDumpLoader(object):
     """Core dump loader base class
     """
-    ESP32_COREDUMP_VESION       = 1
+    ESP32_COREDUMP_VESION       = 2
+    # version from which TCBs and stacks are compressed
+    ESP32_COREDUMP_LZ4_VESION   = 2
+    ESP32_COREDUMP_LZ4_BLOCK_MAX = 64 * 1024
     ESP32_COREDUMP_HDR_FMT      = '<4L'
     ESP32_COREDUMP_HDR_SZ       = struct.calcsize(ESP32_COREDUMP_HDR_FMT)
     ESP32_COREDUMP_TSK_HDR_FMT  = '<3L'
@@ -577,6 +580,77 @@ class ESPCoreDumpLoader(object):
             if self.fcore_name:
                 self.remove_tmp_file(self.fcore_name)
 
+    @staticmethod
+    def _lz4_decompress_block(src, off, size):
+        """Decompresses LZ4 block of known uncompressed size, returns data and offset of the next block
+        """
+        out = bytearray()
+        try:
+            while True:
+                token = src[off]
+                off += 1
+                lit_len = token >> 4
+                if lit_len == 15:
+                    while True:
+                        b = src[off]
+                        off += 1
+                        lit_len += b
+                        if b != 255:
+                            break
+                out += src[off:off + lit_len]
+                off += lit_len
+                if len(out) >= size:
+                    break
+                offset = src[off] | (src[off + 1] << 8)
+                off += 2
+                if offset == 0 or offset > len(out):
+                    raise ESPCoreDumpLoaderError("Invalid LZ4 match offset %d!" % offset)
+                match_len = token & 0xf
+                if match_len == 15:
+                    while True:
+                        b = src[off]
+                        off += 1
+                        match_len += b
+                        if b != 255:
+                            break
+                match_len += 4
+                # match can overlap with the data being copied
+                for _ in range(match_len):
+                    out.append(out[-offset])
+        except IndexError:
+            raise ESPCoreDumpLoaderError("Truncated LZ4 data!")
+        if len(out) != size:
+            raise ESPCoreDumpLoaderError("Invalid LZ4 block size %d, should be %d!" % (len(out), size))
+        return bytes(out), off
+
+    def _lz4_decompress_region(self, src, off, size):
+        """Decompresses data compressed to LZ4 blocks, returns data padded to multiple of 4 bytes
+        """
+        data = b''
+        while True:
+            blk_sz = min(size - len(data), self.ESP32_COREDUMP_LZ4_BLOCK_MAX)
+            blk, off = self._lz4_decompress_block(src, off, blk_sz)
+            data += blk
+            if len(data) == size:
+                break
+        if size % 4:
+            data += b'\0' * (4 - size % 4)
+        return data, off
+
+    def _decompress_data(self, off, tot_len, task_num, tcbsz):
+        """Converts compressed core dump data to uncompressed ones (version 1)
+        """
+        src = bytearray(self.read_data(off, tot_len - self.ESP32_COREDUMP_HDR_SZ))
+        src_off = 0
+        data = b''
+        for i in range(task_num):
+            hdr, src_off = self._lz4_decompress_region(src, src_off, self.ESP32_COREDUMP_TSK_HDR_SZ)
+            tcb_addr,stack_top,stack_end = struct.unpack_from(self.ESP32_COREDUMP_TSK_HDR_FMT, hdr)
+            tcb, src_off = self._lz4_decompress_region(src, src_off, tcbsz)
+            stack, src_off = self._lz4_decompress_region(src, src_off, abs(stack_end - stack_top))
+            data += hdr + tcb + stack
+        return data
+
     def create_corefile(self, core_fname=None, off=0, rom_elf=None):
         """Creates core dump ELF file
         """
@@ -589,10 +663,18 @@ class ESPCoreDumpLoader(object):
         if tcbsz_aligned % 4:
             tcbsz_aligned = 4 * (old_div(tcbsz_aligned,4) + 1)
         core_off += self.ESP32_COREDUMP_HDR_SZ
+        read_data = self.read_data
+        if coredump_ver >= self.ESP32_COREDUMP_LZ4_VESION:
+            uncomp_data = self._decompress_data(core_off, tot_len, task_num, tcbsz)
+            logging.info("Decompressed %d bytes of core dump data to %d" % (tot_len - self.ESP32_COREDUMP_HDR_SZ, len(uncomp_data)))
+            core_off = 0
+
+            def read_data(off, sz):
+                return uncomp_data[off:off + sz]
         core_elf = ESPCoreDumpElfFile()
         notes = b''
         for i in range(task_num):
-            data = self.read_data(core_off, self.ESP32_COREDUMP_TSK_HDR_SZ)
+            data = read_data(core_off, self.ESP32_COREDUMP_TSK_HDR_SZ)
             tcb_addr,stack_top,stack_end = struct.unpack_from(self.ESP32_COREDUMP_TSK_HDR_FMT, data)
             if stack_end > stack_top:
                 stack_len = stack_end - stack_top
@@ -607,7 +689,7 @@ class ESPCoreDumpLoader(object):
 
             core_off += self.ESP32_COREDUMP_TSK_HDR_SZ
             logging.info("Read TCB %d bytes @ 0x%x" % (tcbsz_aligned, tcb_addr))
-            data = self.read_data(core_off, tcbsz_aligned)
+            data = read_data(core_off, tcbsz_aligned)
             try:
                 if tcbsz != tcbsz_aligned:
                     core_elf.add_program_segment(tcb_addr, data[:tcbsz - tcbsz_aligned],
@@ -619,7 +701,7 @@ class ESPCoreDumpLoader(object):
 
             core_off += tcbsz_aligned
             logging.info("Read stack %d bytes @ 0x%x" % (stack_len_aligned, stack_base))
-            data = self.read_data(core_off, stack_len_aligned)
+            data = read_data(core_off, stack_len_aligned)
             if stack_len != stack_len_aligned:
                 data = data[:stack_len - stack_len_aligned]
             try:
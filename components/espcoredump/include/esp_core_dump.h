@@ -57,6 +57,14 @@ void esp_core_dump_init();
  * 3) Task header is followed by TCB data. Size is TCB_SIZE bytes.
  * 4) Task's stack is placed after TCB data. Size is (STACK_END - STACK_TOP) bytes.
  * 5) CRC is placed at the end of the data.
+ * TCBs and stacks are padded with zeros to multiple of 4 bytes.
+ *
+ * If compression is enabled in menuconfig, VERSION is 2 and every task header, TCB and stack is
+ * compressed to LZ4 blocks of at most 64 KB of source data. Only the core dump header is not compressed.
+ * Blocks are not padded, the end of the compressed data is padded with zeros to multiple of 4 bytes.
+ *
+ * If not all tasks are saved (see menuconfig), the crashed task comes first and is followed by the tasks
+ * which were running on other CPUs.
  */
 void esp_core_dump_to_flash(XtExcFrame *frame);
 
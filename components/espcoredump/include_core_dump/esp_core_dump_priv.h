@@ -33,7 +33,16 @@
 #endif
 
 #define COREDUMP_MAX_TASK_STACK_SIZE        (64*1024)
+#if CONFIG_ESP32_CORE_DUMP_COMPRESS
+// TCBs and stacks are compressed
+#define COREDUMP_VERSION                    2
+#else
 #define COREDUMP_VERSION                    1
+#endif
+// Data are passed to emitter in chunks of this size, it is multiple of flash page size and of base64 line length
+#define COREDUMP_OUT_BUF_SIZE               1536
+// Max size of data compressed to one LZ4 block
+#define COREDUMP_LZ4_BLOCK_MAX              (64*1024)
 
 typedef uint32_t core_dump_crc_t;
 
@@ -62,6 +71,21 @@ typedef struct _core_dump_write_config_t
     void *                              priv;
 } core_dump_write_config_t;
 
+/** buffered output of core dump data to emitter */
+typedef struct _core_dump_out_t
+{
+    core_dump_write_config_t *  cfg;
+    // number of bytes output
+    uint32_t                    len;
+    // number of bytes in buffer
+    uint32_t                    fill;
+    // only count bytes, do not pass them to emitter
+    bool                        count_only;
+    // first error returned by emitter
+    esp_err_t                   err;
+    uint8_t                     buf[COREDUMP_OUT_BUF_SIZE] __attribute__((aligned(4)));
+} core_dump_out_t;
+
 /** core dump data header */
 typedef struct _core_dump_header_t
 {
@@ -89,6 +113,22 @@ void esp_core_dump_flash_init();
 // Common core dump write function
 void esp_core_dump_write(void *frame, core_dump_write_config_t *write_cfg);
 
+// Buffered output of core dump data
+void esp_core_dump_out(core_dump_out_t *out, const void *data, uint32_t data_len);
+
+static inline void esp_core_dump_out_byte(core_dump_out_t *out, uint8_t byte)
+{
+    esp_core_dump_out(out, &byte, 1);
+}
+
+#if CONFIG_ESP32_CORE_DUMP_COMPRESS
+// Compresses data as LZ4 block and outputs the result. Data length must not exceed COREDUMP_LZ4_BLOCK_MAX.
+void esp_core_dump_lz4_compress(core_dump_out_t *out, const void *data, uint32_t data_len);
+#endif
+
+// Moves crashed task and the tasks running on other CPUs to the beginning of the snapshot, returns new tasks number
+uint32_t esp_core_dump_select_tasks(core_dump_task_header_t *tasks, uint32_t task_num, uint32_t max_num);
+
 // Gets RTOS tasks snapshot
 uint32_t esp_core_dump_get_tasks_snapshot(core_dump_task_header_t* const tasks,
                         const uint32_t snapshot_size, uint32_t* const tcb_sz);
@@ -22,6 +22,94 @@ const static DRAM_ATTR char TAG[] __attribute__((unused)) = "esp_core_dump_commo
 
 #if CONFIG_ESP32_ENABLE_COREDUMP
 
+static core_dump_out_t s_core_dump_out;
+
+static void esp_core_dump_out_init(core_dump_out_t *out, core_dump_write_config_t *write_cfg, bool count_only)
+{
+    out->cfg = write_cfg;
+    out->len = 0;
+    out->fill = 0;
+    out->count_only = count_only;
+    out->err = ESP_OK;
+}
+
+static void esp_core_dump_out_flush(core_dump_out_t *out)
+{
+    if (out->fill && out->err == ESP_OK) {
+        out->err = out->cfg->write(out->cfg->priv, out->buf, out->fill);
+    }
+    out->fill = 0;
+}
+
+void esp_core_dump_out(core_dump_out_t *out, const void *data, uint32_t data_len)
+{
+    const uint8_t *src = (const uint8_t *)data;
+
+    out->len += data_len;
+    if (out->count_only) {
+        return;
+    }
+    while (data_len) {
+        uint32_t len = COREDUMP_OUT_BUF_SIZE - out->fill;
+        if (len > data_len) {
+            len = data_len;
+        }
+        memcpy(out->buf + out->fill, src, len);
+        out->fill += len;
+        src += len;
+        data_len -= len;
+        if (out->fill == COREDUMP_OUT_BUF_SIZE) {
+            esp_core_dump_out_flush(out);
+        }
+    }
+}
+
+static void esp_core_dump_out_pad(core_dump_out_t *out)
+{
+    const uint32_t zero = 0;
+    esp_core_dump_out(out, &zero, (sizeof(uint32_t) - out->len % sizeof(uint32_t)) % sizeof(uint32_t));
+}
+
+static void esp_core_dump_out_region(core_dump_out_t *out, const void *data, uint32_t data_len)
+{
+#if CONFIG_ESP32_CORE_DUMP_COMPRESS
+    const uint8_t *src = (const uint8_t *)data;
+    // every region is compressed to independent LZ4 blocks of at most 64 KB
+    do {
+        uint32_t len = data_len > COREDUMP_LZ4_BLOCK_MAX ? COREDUMP_LZ4_BLOCK_MAX : data_len;
+        esp_core_dump_lz4_compress(out, src, len);
+        src += len;
+        data_len -= len;
+    } while (data_len);
+#else
+    esp_core_dump_out(out, data, data_len);
+    // actual TCB len can be retrieved by espcoredump from core dump header
+    esp_core_dump_out_pad(out);
+#endif
+}
+
+static void esp_core_dump_out_tasks(core_dump_out_t *out, core_dump_task_header_t *tasks,
+                                    uint32_t task_num, uint32_t tcb_sz)
+{
+    for (uint32_t i = 0; i < task_num; i++) {
+        if (!esp_tcb_addr_is_sane((uint32_t)tasks[i].tcb_addr, tcb_sz)) {
+            ESP_COREDUMP_LOG_PROCESS("Skip TCB with bad addr %x!", tasks[i].tcb_addr);
+            continue;
+        }
+        ESP_COREDUMP_LOG_PROCESS("Dump task %x", tasks[i].tcb_addr);
+        // Save TCB address, stack base and stack top addr
+        esp_core_dump_out_region(out, &tasks[i], sizeof(core_dump_task_header_t));
+        // Save TCB
+        esp_core_dump_out_region(out, tasks[i].tcb_addr, tcb_sz);
+        // Save task stack
+        if (tasks[i].stack_start != 0 && tasks[i].stack_end != 0) {
+            esp_core_dump_out_region(out, (void*)tasks[i].stack_start, tasks[i].stack_end - tasks[i].stack_start);
+        } else {
+            ESP_COREDUMP_LOG_PROCESS("Skip corrupted task %x stack!", tasks[i].tcb_addr);
+        }
+    }
+}
+
 static esp_err_t esp_core_dump_write_binary(void *frame, core_dump_write_config_t *write_cfg)
 {
     esp_err_t err;
@@ -29,14 +117,13 @@ static esp_err_t esp_core_dump_write_binary(void *frame, core_dump_write_config_
     uint32_t tcb_sz, task_num, tcb_sz_padded;
     bool task_is_valid = false;
     uint32_t data_len = 0, i;
-    union
-    {
-        core_dump_header_t      hdr;
-        core_dump_task_header_t task_hdr;
-    } dump_data;
+    core_dump_header_t hdr;
 
     task_num = esp_core_dump_get_tasks_snapshot(tasks, CONFIG_ESP32_CORE_DUMP_MAX_TASKS_NUM, &tcb_sz);
     ESP_COREDUMP_LOGI("Found tasks: (%d)!", task_num);
+#if !CONFIG_ESP32_CORE_DUMP_ALL_TASKS
+    task_num = esp_core_dump_select_tasks(tasks, task_num, CONFIG_ESP32_CORE_DUMP_OTHER_TASKS_NUM + 1);
+#endif
 
     // Take TCB padding into account, actual TCB size will be stored in header
     if (tcb_sz % sizeof(uint32_t))
@@ -64,6 +151,14 @@ static esp_err_t esp_core_dump_write_binary(void *frame, core_dump_write_config_
             write_cfg->bad_tasks_num++;
         }
     }
+#if CONFIG_ESP32_CORE_DUMP_COMPRESS
+    // Compress data once to get their size, so that only the space really needed is erased in flash
+    esp_core_dump_out_init(&s_core_dump_out, write_cfg, true);
+    esp_core_dump_out_tasks(&s_core_dump_out, tasks, task_num, tcb_sz);
+    esp_core_dump_out_pad(&s_core_dump_out);
+    ESP_COREDUMP_LOG_PROCESS("Compressed %lu bytes to %lu", data_len, s_core_dump_out.len);
+    data_len = s_core_dump_out.len;
+#endif
     // Add core dump header size
     data_len += sizeof(core_dump_header_t);
     ESP_COREDUMP_LOG_PROCESS("Core dump len = %lu (%d %d)", data_len, task_num, write_cfg->bad_tasks_num);
@@ -84,50 +179,21 @@ static esp_err_t esp_core_dump_write_binary(void *frame, core_dump_write_config_
             return err;
         }
     }
-    // Write header
-    dump_data.hdr.data_len  = data_len;
-    dump_data.hdr.version   = COREDUMP_VERSION;
-    dump_data.hdr.tasks_num = task_num - write_cfg->bad_tasks_num;
-    dump_data.hdr.tcb_sz    = tcb_sz;
-    err = write_cfg->write(write_cfg->priv, &dump_data, sizeof(core_dump_header_t));
+    // Write header and tasks
+    esp_core_dump_out_init(&s_core_dump_out, write_cfg, false);
+    hdr.data_len  = data_len;
+    hdr.version   = COREDUMP_VERSION;
+    hdr.tasks_num = task_num - write_cfg->bad_tasks_num;
+    hdr.tcb_sz    = tcb_sz;
+    esp_core_dump_out(&s_core_dump_out, &hdr, sizeof(core_dump_header_t));
+    esp_core_dump_out_tasks(&s_core_dump_out, tasks, task_num, tcb_sz);
+    esp_core_dump_out_pad(&s_core_dump_out);
+    esp_core_dump_out_flush(&s_core_dump_out);
+    err = s_core_dump_out.err;
     if (err != ESP_OK) {
-        ESP_COREDUMP_LOGE("Failed to write core dump header (%d)!", err);
+        ESP_COREDUMP_LOGE("Failed to write core dump data (%d)!", err);
         return err;
     }
-    // Write tasks
-    for (i = 0; i < task_num; i++) {
-        if (!esp_tcb_addr_is_sane((uint32_t)tasks[i].tcb_addr, tcb_sz)) {
-            ESP_COREDUMP_LOG_PROCESS("Skip TCB with bad addr %x!", tasks[i].tcb_addr);
-            continue;
-        }
-        ESP_COREDUMP_LOG_PROCESS("Dump task %x", tasks[i].tcb_addr);
-        // Save TCB address, stack base and stack top addr
-        dump_data.task_hdr.tcb_addr    = tasks[i].tcb_addr;
-        dump_data.task_hdr.stack_start = tasks[i].stack_start;
-        dump_data.task_hdr.stack_end   = tasks[i].stack_end;
-        err = write_cfg->write(write_cfg->priv, (void*)&dump_data, sizeof(core_dump_task_header_t));
-        if (err != ESP_OK) {
-            ESP_COREDUMP_LOGE("Failed to write task header (%d)!", err);
-            return err;
-        }
-        // Save TCB
-        err = write_cfg->write(write_cfg->priv, tasks[i].tcb_addr, tcb_sz);
-        if (err != ESP_OK) {
-            ESP_COREDUMP_LOGE("Failed to write TCB (%d)!", err);
-            return err;
-        }
-        // Save task stack
-        if (tasks[i].stack_start != 0 && tasks[i].stack_end != 0) {
-            err = write_cfg->write(write_cfg->priv, (void*)tasks[i].stack_start,
-                    tasks[i].stack_end - tasks[i].stack_start);
-            if (err != ESP_OK) {
-                ESP_COREDUMP_LOGE("Failed to write task stack (%d)!", err);
-                return err;
-            }
-        } else {
-            ESP_COREDUMP_LOG_PROCESS("Skip corrupted task %x stack!", tasks[i].tcb_addr);
-        }
-    }
 
     // write end
     if (write_cfg->end) {
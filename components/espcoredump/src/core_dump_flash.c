@@ -66,46 +66,6 @@ void esp_core_dump_flash_init()
     s_core_flash_config.partition_config_crc = esp_core_dump_calc_flash_config_crc();
 }
 
-static uint32_t esp_core_dump_write_flash_padded(size_t off, uint8_t *data, uint32_t data_size)
-{
-    esp_err_t err;
-    uint32_t data_len = 0, k, len;
-    union
-    {
-        uint8_t    data8[4];
-        uint32_t   data32;
-    } rom_data;
-
-    data_len = (data_size / sizeof(uint32_t)) * sizeof(uint32_t);
-
-    assert(off >= s_core_flash_config.partition.start);
-    assert((off + data_len + (data_size % sizeof(uint32_t) ? sizeof(uint32_t) : 0)) <=
-        s_core_flash_config.partition.start + s_core_flash_config.partition.size);
-
-    err = spi_flash_write(off, data, data_len);
-    if (err != ESP_OK) {
-        ESP_COREDUMP_LOGE("Failed to write data to flash (%d)!", err);
-        return 0;
-    }
-
-    len = data_size % sizeof(uint32_t);
-    if (len) {
-        // write last bytes with padding, actual TCB len can be retrieved by esptool from core dump header
-        rom_data.data32 = 0;
-        for (k = 0; k < len; k++) {
-            rom_data.data8[k] = *(data + data_len + k);
-        }
-        err = spi_flash_write(off + data_len, &rom_data, sizeof(uint32_t));
-        if (err != ESP_OK) {
-            ESP_COREDUMP_LOGE("Failed to finish write data to flash (%d)!", err);
-            return 0;
-        }
-        data_len += sizeof(uint32_t);
-    }
-
-    return data_len;
-}
-
 static esp_err_t esp_core_dump_flash_write_prepare(void *priv, uint32_t *data_len)
 {
     esp_err_t err;
@@ -187,12 +147,17 @@ static esp_err_t esp_core_dump_flash_write_data(void *priv, void * data, uint32_
     esp_err_t err = ESP_OK;
     core_dump_write_flash_data_t *wr_data = (core_dump_write_flash_data_t *)priv;
 
-    uint32_t len = esp_core_dump_write_flash_padded(s_core_flash_config.partition.start + wr_data->off, data, data_len);
-    if (len != data_len) {
-        return ESP_FAIL;
+    // data are passed in buffered chunks, only the last one can be shorter and it is padded to word size
+    assert(data_len % sizeof(uint32_t) == 0);
+    assert(wr_data->off + data_len <= s_core_flash_config.partition.size);
+
+    err = spi_flash_write(s_core_flash_config.partition.start + wr_data->off, data, data_len);
+    if (err != ESP_OK) {
+        ESP_COREDUMP_LOGE("Failed to write data to flash (%d)!", err);
+        return err;
     }
 
-    wr_data->off += len;
+    wr_data->off += data_len;
     wr_data->crc = crc32_le(wr_data->crc, data, data_len);
 
     return err;
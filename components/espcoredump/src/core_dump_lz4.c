@@ -0,0 +1,103 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <string.h>
+#include "esp_core_dump_priv.h"
+
+#if CONFIG_ESP32_CORE_DUMP_COMPRESS
+
+// LZ4 block format, see https://github.com/lz4/lz4/blob/master/doc/lz4_Block_format.md
+// Matches are searched in the source memory itself, so no window buffer is needed.
+#define LZ4_MIN_MATCH           4
+#define LZ4_LAST_LITERALS       5   // last bytes of block are always literals
+#define LZ4_MATCH_LIMIT         12  // last match starts at least this number of bytes before end of block
+#define LZ4_MAX_OFFSET          65535
+#define LZ4_HASH_BITS           10
+
+// positions of 4-byte sequences in the source, indexed by their hash
+static DRAM_ATTR uint16_t s_hash_table[1 << LZ4_HASH_BITS];
+
+static inline uint32_t lz4_read32(const uint8_t *p)
+{
+    // source is not always word aligned, unaligned loads cause exceptions
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint32_t lz4_hash(uint32_t seq)
+{
+    return (seq * 2654435761U) >> (32 - LZ4_HASH_BITS);
+}
+
+static void lz4_put_length(core_dump_out_t *out, uint32_t len)
+{
+    while (len >= 255) {
+        esp_core_dump_out_byte(out, 255);
+        len -= 255;
+    }
+    esp_core_dump_out_byte(out, len);
+}
+
+static void lz4_put_sequence(core_dump_out_t *out, const uint8_t *literals, uint32_t lit_len,
+                             uint32_t offset, uint32_t match_len)
+{
+    uint32_t ml = match_len ? match_len - LZ4_MIN_MATCH : 0;
+    uint8_t token = ((lit_len < 15 ? lit_len : 15) << 4) | (ml < 15 ? ml : 15);
+
+    esp_core_dump_out_byte(out, token);
+    if (lit_len >= 15) {
+        lz4_put_length(out, lit_len - 15);
+    }
+    esp_core_dump_out(out, literals, lit_len);
+    if (match_len) {
+        esp_core_dump_out_byte(out, offset & 0xff);
+        esp_core_dump_out_byte(out, offset >> 8);
+        if (ml >= 15) {
+            lz4_put_length(out, ml - 15);
+        }
+    }
+}
+
+void esp_core_dump_lz4_compress(core_dump_out_t *out, const void *data, uint32_t len)
+{
+    const uint8_t *src = (const uint8_t *)data;
+    uint32_t anchor = 0, pos = 0;
+
+    assert(len <= UINT16_MAX + 1);
+    // positions are relative to this block, so matches never point to memory outside of it
+    memset(s_hash_table, 0, sizeof(s_hash_table));
+    if (len > LZ4_MATCH_LIMIT) {
+        uint32_t match_limit = len - LZ4_MATCH_LIMIT;
+        uint32_t match_end_limit = len - LZ4_LAST_LITERALS;
+        while (pos < match_limit) {
+            uint32_t seq = lz4_read32(src + pos);
+            uint32_t h = lz4_hash(seq);
+            uint32_t ref = s_hash_table[h];
+            s_hash_table[h] = pos;
+            if (ref >= pos || pos - ref > LZ4_MAX_OFFSET || lz4_read32(src + ref) != seq) {
+                pos++;
+                continue;
+            }
+            uint32_t match_len = LZ4_MIN_MATCH;
+            while (pos + match_len < match_end_limit && src[ref + match_len] == src[pos + match_len]) {
+                match_len++;
+            }
+            lz4_put_sequence(out, src + anchor, pos - anchor, pos - ref, match_len);
+            pos += match_len;
+            anchor = pos;
+        }
+    }
+    // last sequence consists of literals only
+    lz4_put_sequence(out, src + anchor, len - anchor, 0, 0);
+}
+
+#endif
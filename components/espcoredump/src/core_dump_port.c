@@ -38,6 +38,33 @@ uint32_t esp_core_dump_get_tasks_snapshot(core_dump_task_header_t* const tasks,
     return task_num;
 }
 
+static void esp_core_dump_move_task(core_dump_task_header_t *tasks, uint32_t task_num, void *tcb_addr, uint32_t pos)
+{
+    for (uint32_t i = pos; i < task_num; i++) {
+        if (tasks[i].tcb_addr == tcb_addr) {
+            core_dump_task_header_t tmp = tasks[pos];
+            tasks[pos] = tasks[i];
+            tasks[i] = tmp;
+            break;
+        }
+    }
+}
+
+uint32_t esp_core_dump_select_tasks(core_dump_task_header_t *tasks, uint32_t task_num, uint32_t max_num)
+{
+    uint32_t pos = 0;
+    int core = xPortGetCoreID();
+
+    // crashed task goes first, then the tasks which were running on other CPUs
+    esp_core_dump_move_task(tasks, task_num, xTaskGetCurrentTaskHandleForCPU(core), pos++);
+    for (int i = 0; i < portNUM_PROCESSORS; i++) {
+        if (i != core && pos < task_num) {
+            esp_core_dump_move_task(tasks, task_num, xTaskGetCurrentTaskHandleForCPU(i), pos++);
+        }
+    }
+    return task_num > max_num ? max_num : task_num;
+}
+
 bool esp_core_dump_process_tcb(void *frame, core_dump_task_header_t *task_snaphort, uint32_t tcb_sz)
 {
     XtExcFrame *exc_frame = (XtExcFrame*)frame;
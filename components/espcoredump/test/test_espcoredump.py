@@ -47,6 +47,19 @@ class TestESPCoreDumpFileLoader(unittest.TestCase):
     def test_create_corefile(self):
         self.assertEqual(self.dloader.create_corefile(core_fname=self.tmp_file, off=0, rom_elf=None), self.tmp_file)
 
+    def test_create_corefile_compressed(self):
+        # coredump_lz4.b64 holds the same data as coredump.b64 compressed with LZ4 (core dump version 2)
+        t = espcoredump.ESPCoreDumpFileLoader(path='coredump_lz4.b64', b64=True)
+        tmp_file_lz4 = self.tmp_file + '_lz4'
+        try:
+            self.assertEqual(t.create_corefile(core_fname=tmp_file_lz4, off=0, rom_elf=None), tmp_file_lz4)
+            self.dloader.create_corefile(core_fname=self.tmp_file, off=0, rom_elf=None)
+            with open(self.tmp_file, 'rb') as f, open(tmp_file_lz4, 'rb') as f_lz4:
+                self.assertEqual(f.read(), f_lz4.read())
+        finally:
+            t.cleanup()
+            t.remove_tmp_file(tmp_file_lz4)
+
 
 if __name__ == '__main__':
     # The purpose of these tests is to increase the code coverage at places which are sensitive to issues related to
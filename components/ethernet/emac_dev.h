@@ -96,6 +96,12 @@ static inline void emac_enable_rx_unavail_intr(void)
     REG_SET_BIT(EMAC_DMAIN_EN_REG, EMAC_DMAIN_RBUE);
 }
 
+static inline void emac_set_rx_intr_delay(uint32_t delay)
+{
+    //delay is in units of 256 APB clock cycles, applies to descriptors with interrupt on completion disabled
+    REG_SET_FIELD(EMAC_DMARINTWDTIMER_REG, EMAC_RIWTC, delay);
+}
+
 static inline void IRAM_ATTR emac_send_pause_frame_enable(void)
 {
     REG_SET_BIT(EMAC_EX_PHYINF_CONF_REG, EMAC_EX_SBD_FLOWCTRL);
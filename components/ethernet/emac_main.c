@@ -62,11 +62,22 @@ static struct emac_config_data emac_config;
 
 static dma_extended_desc_t *emac_dma_rx_chain_buf;
 static dma_extended_desc_t *emac_dma_tx_chain_buf;
-static uint8_t *emac_dma_rx_buf[DMA_RX_BUF_NUM];
+#if CONFIG_EMAC_RX_BUF_SWAP
+#define EMAC_RX_BUF_TOTAL (DMA_RX_BUF_NUM + CONFIG_EMAC_RX_SPARE_BUF_NUM)
+#else
+#define EMAC_RX_BUF_TOTAL DMA_RX_BUF_NUM
+#endif
+
+static uint8_t *emac_dma_rx_buf[EMAC_RX_BUF_TOTAL];
 static uint8_t *emac_dma_tx_buf[DMA_TX_BUF_NUM];
 
 static SemaphoreHandle_t emac_g_sem = NULL;
 static portMUX_TYPE g_emac_mux = portMUX_INITIALIZER_UNLOCKED;
+#if CONFIG_EMAC_RX_BUF_SWAP
+static uint8_t *emac_rx_spare_buf[CONFIG_EMAC_RX_SPARE_BUF_NUM];
+static int emac_rx_spare_cnt = 0;
+static bool emac_rx_buf_lent[EMAC_RX_BUF_TOTAL];    /* Buffer is held by the IP layer */
+#endif
 static xTaskHandle emac_task_hdl = NULL;
 static xQueueHandle emac_xqueue = NULL;
 static uint8_t emac_sig_cnt[EMAC_SIG_MAX] = {0};
@@ -76,6 +87,10 @@ static SemaphoreHandle_t emac_tx_xMutex = NULL;
 static intr_handle_t eth_intr_handle = NULL;
 static const char *TAG = "emac";
 static bool pause_send = false;
+static esp_eth_rx_stats_t emac_rx_stats;
+#if CONFIG_EMAC_RX_COALESCE
+static bool emac_rx_coalesce = false;
+#endif
 #ifdef CONFIG_PM_ENABLE
 static esp_pm_lock_handle_t s_pm_lock;
 #endif
@@ -127,6 +142,12 @@ static void emac_clean_rx_desc(dma_extended_desc_t *rx_desc, uint32_t buf_ptr)
         rx_desc->basic.desc2 = buf_ptr;
     }
     rx_desc->basic.desc1 = EMAC_DESC_RX_SECOND_ADDR_CHAIN | DMA_RX_BUF_SIZE;
+#if CONFIG_EMAC_RX_COALESCE
+    if (emac_rx_coalesce) {
+        //the rx interrupt is raised by the interrupt watchdog timer instead
+        rx_desc->basic.desc1 |= EMAC_DESC_DIS_INT_ON_COMPLET;
+    }
+#endif
     rx_desc->basic.desc0 = EMAC_DESC_RX_OWN;
 }
 
@@ -428,6 +449,82 @@ static void emac_process_tx(void)
     xSemaphoreGiveRecursive(emac_tx_xMutex);
 }
 
+#if CONFIG_EMAC_RX_BUF_SWAP
+static int emac_rx_buf_index(const void *buf)
+{
+    for (int i = 0; i < EMAC_RX_BUF_TOTAL; i++) {
+        if (emac_dma_rx_buf[i] == buf) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void emac_rx_pool_init(void)
+{
+    portENTER_CRITICAL(&g_emac_mux);
+    for (int i = 0; i < CONFIG_EMAC_RX_SPARE_BUF_NUM; i++) {
+        emac_rx_spare_buf[i] = emac_dma_rx_buf[DMA_RX_BUF_NUM + i];
+    }
+    emac_rx_spare_cnt = CONFIG_EMAC_RX_SPARE_BUF_NUM;
+    memset(emac_rx_buf_lent, 0, sizeof(emac_rx_buf_lent));
+    portEXIT_CRITICAL(&g_emac_mux);
+}
+
+/* Frees the pool, buffers still held by the IP layer are freed when they are returned */
+static void emac_rx_pool_deinit(void)
+{
+    uint8_t *unused[EMAC_RX_BUF_TOTAL];
+    int cnt = 0;
+
+    portENTER_CRITICAL(&g_emac_mux);
+    for (int i = 0; i < EMAC_RX_BUF_TOTAL; i++) {
+        if (!emac_rx_buf_lent[i]) {
+            unused[cnt++] = emac_dma_rx_buf[i];
+        }
+        emac_dma_rx_buf[i] = NULL;
+        emac_rx_buf_lent[i] = false;
+    }
+    emac_rx_spare_cnt = 0;
+    portEXIT_CRITICAL(&g_emac_mux);
+
+    for (int i = 0; i < cnt; i++) {
+        free(unused[i]);
+    }
+}
+
+/* Takes a spare buffer to replace the filled one, which is lent to the IP layer */
+static uint8_t *emac_rx_spare_take(void *filled)
+{
+    uint8_t *spare = NULL;
+
+    portENTER_CRITICAL(&g_emac_mux);
+    int i = emac_rx_buf_index(filled);
+    if (emac_rx_spare_cnt > 0 && i >= 0) {
+        spare = emac_rx_spare_buf[--emac_rx_spare_cnt];
+        emac_rx_buf_lent[i] = true;
+    }
+    portEXIT_CRITICAL(&g_emac_mux);
+    return spare;
+}
+
+void esp_eth_free_rx_buf(void *buf)
+{
+    portENTER_CRITICAL(&g_emac_mux);
+    int i = emac_rx_buf_index(buf);
+    if (i >= 0) {
+        if (emac_rx_buf_lent[i]) {
+            emac_rx_buf_lent[i] = false;
+            emac_rx_spare_buf[emac_rx_spare_cnt++] = buf;
+        }
+        buf = NULL;
+    }
+    portEXIT_CRITICAL(&g_emac_mux);
+
+    /* Not part of the pool any more, it was lent before esp_eth_deinit() */
+    free(buf);
+}
+#else
 void esp_eth_free_rx_buf(void *buf)
 {
     xSemaphoreTakeRecursive(emac_rx_xMutex, portMAX_DELAY);
@@ -451,6 +548,7 @@ void esp_eth_free_rx_buf(void *buf)
         portEXIT_CRITICAL(&g_emac_mux);
     }
 }
+#endif
 
 static uint32_t IRAM_ATTR emac_get_rxbuf_count_in_intr(void)
 {
@@ -465,26 +563,107 @@ static uint32_t IRAM_ATTR emac_get_rxbuf_count_in_intr(void)
     return cnt;
 }
 
+static void emac_rx_pass_done(uint32_t frames)
+{
+    emac_rx_stats.rx_polls++;
+    emac_rx_stats.rx_frames += frames;
+#if CONFIG_EMAC_RX_COALESCE
+    //coalesce under load, go back to an interrupt per frame when the traffic is light
+    if (frames >= CONFIG_EMAC_RX_COALESCE_THRESHOLD) {
+        emac_rx_coalesce = true;
+    } else if (frames <= 1) {
+        emac_rx_coalesce = false;
+    }
+#endif
+}
+
+esp_err_t esp_eth_get_rx_stats(esp_eth_rx_stats_t *stats, bool reset)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&g_emac_mux);
+    *stats = emac_rx_stats;
+    if (reset) {
+        memset(&emac_rx_stats, 0, sizeof(emac_rx_stats));
+    }
+    portEXIT_CRITICAL(&g_emac_mux);
+    return ESP_OK;
+}
+
 #if CONFIG_EMAC_L2_TO_L3_RX_BUF_MODE
+#if CONFIG_EMAC_RX_POLL_BUDGET
+/* Queue another pass over the rx ring, the rx interrupt stays disabled until the ring is empty */
+static void emac_rx_poll_again(void)
+{
+    bool post = false;
+
+    portENTER_CRITICAL(&g_emac_mux);
+    if (emac_sig_cnt[SIG_EMAC_RX_DONE] == 0) {
+        emac_sig_cnt[SIG_EMAC_RX_DONE]++;
+        post = true;
+    }
+    portEXIT_CRITICAL(&g_emac_mux);
+
+    if (post) {
+        emac_event_t evt = {
+            .sig = SIG_EMAC_RX_DONE,
+            .par = 0,
+        };
+        if (xQueueSend(emac_xqueue, &evt, 0) != pdTRUE) {
+            portENTER_CRITICAL(&g_emac_mux);
+            emac_sig_cnt[SIG_EMAC_RX_DONE]--;
+            portEXIT_CRITICAL(&g_emac_mux);
+            //let the interrupt trigger the next pass
+            emac_enable_rx_intr();
+        }
+    }
+}
+#endif
+
+static void emac_rx_deliver(dma_extended_desc_t *desc)
+{
+    void *buf = (void *)(desc->basic.desc2);
+    uint16_t len = ((desc->basic.desc0) >> EMAC_DESC_FRAME_LENGTH_S) & EMAC_DESC_FRAME_LENGTH;
+
+#if CONFIG_EMAC_RX_BUF_SWAP
+    uint8_t *spare = emac_rx_spare_take(buf);
+    if (spare != NULL) {
+        //pass the buffer to lwip, it comes back through esp_eth_free_rx_buf()
+        emac_clean_rx_desc(desc, (uint32_t)spare);
+        emac_config.emac_tcpip_input(buf, len, buf);
+        return;
+    }
+#endif
+    //copy data to lwip
+    emac_config.emac_tcpip_input(buf, len, NULL);
+    emac_clean_rx_desc(desc, desc->basic.desc2);
+}
+
 static void emac_process_rx(void)
 {
     if (emac_config.emac_status == EMAC_RUNTIME_STOP) {
         return;
     }
     uint32_t cur_rx_desc = emac_read_rx_cur_reg();
+    uint32_t frames = 0;
 
     while (((uint32_t) & (emac_config.dma_erx[emac_config.dirty_rx])) != cur_rx_desc) {
-        //copy data to lwip
-        emac_config.emac_tcpip_input((void *)(emac_config.dma_erx[emac_config.dirty_rx].basic.desc2),
-                                     (((emac_config.dma_erx[emac_config.dirty_rx].basic.desc0) >> EMAC_DESC_FRAME_LENGTH_S) &
-                                      EMAC_DESC_FRAME_LENGTH), NULL);
-
-        emac_clean_rx_desc(&(emac_config.dma_erx[emac_config.dirty_rx]), (emac_config.dma_erx[emac_config.dirty_rx].basic.desc2));
+#if CONFIG_EMAC_RX_POLL_BUDGET
+        if (frames == CONFIG_EMAC_RX_POLL_BUDGET) {
+            emac_rx_pass_done(frames);
+            emac_rx_poll_again();
+            return;
+        }
+#endif
+        emac_rx_deliver(&(emac_config.dma_erx[emac_config.dirty_rx]));
         emac_config.dirty_rx = (emac_config.dirty_rx + 1) % DMA_RX_BUF_NUM;
+        frames++;
 
         cur_rx_desc = emac_read_rx_cur_reg();
     }
 
+    emac_rx_pass_done(frames);
     emac_enable_rx_intr();
 }
 
@@ -500,14 +679,10 @@ static void emac_process_rx_unavail(void)
             break;
         }
         dirty_cnt++;
-        //copy data to lwip
-        emac_config.emac_tcpip_input((void *)(emac_config.dma_erx[emac_config.dirty_rx].basic.desc2),
-                                     (((emac_config.dma_erx[emac_config.dirty_rx].basic.desc0) >> EMAC_DESC_FRAME_LENGTH_S) &
-                                      EMAC_DESC_FRAME_LENGTH), NULL);
-
-        emac_clean_rx_desc(&(emac_config.dma_erx[emac_config.dirty_rx]), (emac_config.dma_erx[emac_config.dirty_rx].basic.desc2));
+        emac_rx_deliver(&(emac_config.dma_erx[emac_config.dirty_rx]));
         emac_config.dirty_rx = (emac_config.dirty_rx + 1) % DMA_RX_BUF_NUM;
     }
+    emac_rx_pass_done(dirty_cnt);
     emac_enable_rx_intr();
     emac_enable_rx_unavail_intr();
     emac_poll_rx_cmd();
@@ -522,6 +697,7 @@ static void emac_process_rx_unavail(void)
 
     xSemaphoreTakeRecursive(emac_rx_xMutex, portMAX_DELAY);
 
+    uint32_t frames = 0;
     while (emac_config.cnt_rx < DMA_RX_BUF_NUM) {
         if (emac_config.dma_erx[emac_config.dirty_rx].basic.desc0 & EMAC_DESC_RX_OWN) {
             break;
@@ -537,7 +713,9 @@ static void emac_process_rx_unavail(void)
         emac_config.emac_tcpip_input((void *)(emac_config.dma_erx[tmp_dirty].basic.desc2),
                                      (((emac_config.dma_erx[tmp_dirty].basic.desc0) >> EMAC_DESC_FRAME_LENGTH_S) &
                                       EMAC_DESC_FRAME_LENGTH), NULL);
+        frames++;
     }
+    emac_rx_pass_done(frames);
     emac_enable_rx_intr();
     emac_enable_rx_unavail_intr();
     xSemaphoreGiveRecursive(emac_rx_xMutex);
@@ -553,6 +731,7 @@ static void emac_process_rx(void)
 
     xSemaphoreTakeRecursive(emac_rx_xMutex, portMAX_DELAY);
 
+    uint32_t frames = 0;
     if ((((uint32_t) & (emac_config.dma_erx[emac_config.dirty_rx])) != cur_rx_desc)) {
         while ((((uint32_t) & (emac_config.dma_erx[emac_config.dirty_rx])) != cur_rx_desc) &&
                 emac_config.cnt_rx < DMA_RX_BUF_NUM) {
@@ -567,6 +746,7 @@ static void emac_process_rx(void)
             emac_config.emac_tcpip_input((void *)(emac_config.dma_erx[tmp_dirty].basic.desc2),
                                          (((emac_config.dma_erx[tmp_dirty].basic.desc0) >> EMAC_DESC_FRAME_LENGTH_S) &
                                           EMAC_DESC_FRAME_LENGTH), NULL);
+            frames++;
 
             cur_rx_desc = emac_read_rx_cur_reg();
         }
@@ -588,10 +768,12 @@ static void emac_process_rx(void)
                     emac_config.emac_tcpip_input((void *)(emac_config.dma_erx[tmp_dirty].basic.desc2),
                                                  (((emac_config.dma_erx[tmp_dirty].basic.desc0) >> EMAC_DESC_FRAME_LENGTH_S) &
                                                   EMAC_DESC_FRAME_LENGTH), NULL);
+                    frames++;
                 }
             }
         }
     }
+    emac_rx_pass_done(frames);
     emac_enable_rx_intr();
     xSemaphoreGiveRecursive(emac_rx_xMutex);
 }
@@ -607,6 +789,7 @@ static void IRAM_ATTR emac_process_intr(void *arg)
     REG_WRITE(EMAC_DMASTATUS_REG, event);
 
     if (event & EMAC_RECV_INT) {
+        emac_rx_stats.rx_interrupts++;
         emac_disable_rx_intr();
         if (emac_config.emac_flow_ctrl_partner_support) {
             if (emac_get_rxbuf_count_in_intr() < FLOW_CONTROL_HIGH_WATERMARK && !pause_send) {
@@ -705,8 +888,18 @@ static void emac_hw_init(void)
 }
 
 esp_err_t esp_eth_tx(uint8_t *buf, uint16_t size)
+{
+    esp_eth_tx_segment_t segment = {
+        .buf = buf,
+        .len = size,
+    };
+    return esp_eth_tx_segments(&segment, 1);
+}
+
+esp_err_t esp_eth_tx_segments(const esp_eth_tx_segment_t *segments, int count)
 {
     esp_err_t ret = ESP_OK;
+    uint32_t size = 0;
 
     if (emac_config.emac_status != EMAC_RUNTIME_START) {
         ESP_LOGE(TAG, "tx netif is not ready, emac_status=%d", emac_config.emac_status);
@@ -714,6 +907,14 @@ esp_err_t esp_eth_tx(uint8_t *buf, uint16_t size)
         return ret;
     }
 
+    for (int i = 0; i < count; i++) {
+        size += segments[i].len;
+    }
+    if (size > DMA_TX_BUF_SIZE) {
+        ESP_LOGE(TAG, "tx frame too long, size=%u", size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
     xSemaphoreTakeRecursive(emac_tx_xMutex, portMAX_DELAY);
     if (emac_config.cnt_tx == DMA_TX_BUF_NUM - 1) {
         ESP_LOGD(TAG, "tx buf full");
@@ -721,7 +922,12 @@ esp_err_t esp_eth_tx(uint8_t *buf, uint16_t size)
         goto _exit;
     }
 
-    memcpy((void *)(emac_config.dma_etx[emac_config.cur_tx].basic.desc2), buf, size);
+    /* The segments are gathered straight into the DMA buffer of the descriptor */
+    uint8_t *dma_buf = (uint8_t *)(emac_config.dma_etx[emac_config.cur_tx].basic.desc2);
+    for (int i = 0; i < count; i++) {
+        memcpy(dma_buf, segments[i].buf, segments[i].len);
+        dma_buf += segments[i].len;
+    }
 
     emac_setup_tx_desc(&(emac_config.dma_etx[emac_config.cur_tx]), size);
 
@@ -815,6 +1021,9 @@ static void emac_start(void *param)
     }
     emac_reset_dma_chain();
     emac_dma_init();
+#if CONFIG_EMAC_RX_COALESCE
+    emac_set_rx_intr_delay(CONFIG_EMAC_RX_COALESCE_DELAY);
+#endif
 
     emac_set_macaddr_reg();
 
@@ -1082,14 +1291,21 @@ esp_err_t esp_eth_init_internal(eth_config_t *config)
     /* dynamically alloc memory for ethernet dma */
     emac_dma_rx_chain_buf = (dma_extended_desc_t *)heap_caps_malloc(sizeof(dma_extended_desc_t) * DMA_RX_BUF_NUM, MALLOC_CAP_DMA);
     emac_dma_tx_chain_buf = (dma_extended_desc_t *)heap_caps_malloc(sizeof(dma_extended_desc_t) * DMA_TX_BUF_NUM, MALLOC_CAP_DMA);
-    for (i = 0; i < DMA_RX_BUF_NUM; i++) {
+    for (i = 0; i < EMAC_RX_BUF_TOTAL; i++) {
         emac_dma_rx_buf[i] = (uint8_t *)heap_caps_malloc(DMA_RX_BUF_SIZE, MALLOC_CAP_DMA);
     }
+#if CONFIG_EMAC_RX_BUF_SWAP
+    emac_rx_pool_init();
+#endif
     for (i = 0; i < DMA_TX_BUF_NUM; i++) {
         emac_dma_tx_buf[i] = (uint8_t *)heap_caps_malloc(DMA_TX_BUF_SIZE, MALLOC_CAP_DMA);
     }
 
     emac_init_default_data();
+    memset(&emac_rx_stats, 0, sizeof(emac_rx_stats));
+#if CONFIG_EMAC_RX_COALESCE
+    emac_rx_coalesce = false;
+#endif
 
     if (config) {
         emac_set_user_config_data(config);
@@ -1185,10 +1401,14 @@ _verify_err:
     free(emac_dma_tx_chain_buf);
     emac_dma_rx_chain_buf = NULL;
     emac_dma_tx_chain_buf = NULL;
+#if CONFIG_EMAC_RX_BUF_SWAP
+    emac_rx_pool_deinit();
+#else
     for (i = 0; i < DMA_RX_BUF_NUM; i++) {
         free(emac_dma_rx_buf[i]);
         emac_dma_rx_buf[i] = NULL;
     }
+#endif
     for (i = 0; i < DMA_TX_BUF_NUM; i++) {
         free(emac_dma_tx_buf[i]);
         emac_dma_tx_buf[i] = NULL;
@@ -1230,10 +1450,14 @@ esp_err_t esp_eth_deinit(void)
     free(emac_dma_tx_chain_buf);
     emac_dma_rx_chain_buf = NULL;
     emac_dma_tx_chain_buf = NULL;
+#if CONFIG_EMAC_RX_BUF_SWAP
+    emac_rx_pool_deinit();
+#else
     for (i = 0; i < DMA_RX_BUF_NUM; i++) {
         free(emac_dma_rx_buf[i]);
         emac_dma_rx_buf[i] = NULL;
     }
+#endif
     for (i = 0; i < DMA_TX_BUF_NUM; i++) {
         free(emac_dma_tx_buf[i]);
         emac_dma_tx_buf[i] = NULL;
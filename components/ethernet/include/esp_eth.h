@@ -186,6 +186,32 @@ esp_err_t esp_eth_init_internal(eth_config_t *config);
  */
 esp_err_t esp_eth_tx(uint8_t *buf, uint16_t size);
 
+/**
+ * @brief  One segment of a packet passed to esp_eth_tx_segments()
+ */
+typedef struct {
+    const void *buf;    /*!< Start address of the segment data */
+    uint16_t len;       /*!< Size (byte) of the segment data */
+} esp_eth_tx_segment_t;
+
+/**
+ * @brief  Send a packet made of several segments from tcp/ip to mac
+ *
+ * The segments are copied, in order, directly into the DMA buffer of the packet,
+ * so that chained buffers don't need to be flattened first.
+ *
+ * @param[in] segments:  the segments of the packet
+ *
+ * @param[in] count:  number of segments
+ *
+ * @return
+ *      - ESP_OK
+ *      - ESP_ERR_INVALID_STATE if the interface is not started
+ *      - ESP_ERR_INVALID_SIZE if the packet is larger than a DMA buffer
+ *      - ESP_ERR_NO_MEM if all the DMA buffers are in use
+ */
+esp_err_t esp_eth_tx_segments(const esp_eth_tx_segment_t *segments, int count);
+
 /**
  * @brief  Enable ethernet interface
  *
@@ -300,6 +326,29 @@ esp_err_t esp_eth_set_mac(const uint8_t mac[6]);
  */
 eth_speed_mode_t esp_eth_get_speed(void);
 
+/**
+ * @brief  Receive statistics of the Ethernet MAC
+ */
+typedef struct {
+    uint32_t rx_interrupts;     /*!< Number of receive interrupts */
+    uint32_t rx_polls;          /*!< Number of passes over the receive ring */
+    uint32_t rx_frames;         /*!< Number of packets passed to the IP layer */
+} esp_eth_rx_stats_t;
+
+/**
+ * @brief  Get the receive statistics
+ *
+ * @note rx_interrupts / rx_frames is the number of interrupts taken per received packet.
+ *
+ * @param[out] stats: the statistics since esp_eth_init()
+ * @param[in] reset: clear the statistics after reading them
+ *
+ * @return
+ *    - ESP_OK: succeed
+ *    - ESP_ERR_INVALID_ARG: stats is NULL
+ */
+esp_err_t esp_eth_get_rx_stats(esp_eth_rx_stats_t *stats, bool reset);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,324 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+#include <stdbool.h>
+#include "esp_expat_arena.h"
+#include "freertos/FreeRTOS.h"
+
+#define ARENA_ALIGN             8
+#define ARENA_ALIGN_UP(x)       (((x) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+#define ARENA_MIN_BLOCK         16
+#define ARENA_NUM_CLASSES       8       // 16, 32, ... ESP_EXPAT_ARENA_MAX_BLOCK bytes
+#define ARENA_CLASS_SIZE(cls)   ((size_t)ARENA_MIN_BLOCK << (cls))
+#define ARENA_LARGE             0xff    // class of a block allocated from the heap
+
+_Static_assert(ARENA_CLASS_SIZE(ARENA_NUM_CLASSES - 1) == ESP_EXPAT_ARENA_MAX_BLOCK,
+               "size classes do not match ESP_EXPAT_ARENA_MAX_BLOCK");
+
+/* Header in front of every block */
+typedef struct {
+    uint32_t size;              // usable size of the block
+    uint32_t cls;               // size class or ARENA_LARGE
+} arena_block_t;
+
+/* Link in front of the header of a large block */
+typedef struct arena_large {
+    struct arena_large *prev;
+    struct arena_large *next;
+} arena_large_t;
+
+typedef struct arena_chunk {
+    struct arena_chunk *next;
+    size_t size;                // bytes available after the chunk header
+    size_t used;
+} arena_chunk_t;
+
+/* Free block in a free list, the link occupies the block data */
+typedef struct arena_free {
+    struct arena_free *next;
+} arena_free_t;
+
+#define ARENA_BLOCK_HDR_SIZE    ARENA_ALIGN_UP(sizeof(arena_block_t))
+#define ARENA_LARGE_HDR_SIZE    ARENA_ALIGN_UP(sizeof(arena_large_t))
+#define ARENA_CHUNK_HDR_SIZE    ARENA_ALIGN_UP(sizeof(arena_chunk_t))
+
+#define ARENA_BLOCK(ptr)        ((arena_block_t *)((uint8_t *)(ptr) - ARENA_BLOCK_HDR_SIZE))
+#define ARENA_DATA(block)       ((void *)((uint8_t *)(block) + ARENA_BLOCK_HDR_SIZE))
+#define ARENA_CHUNK_DATA(chunk) ((uint8_t *)(chunk) + ARENA_CHUNK_HDR_SIZE)
+
+struct esp_expat_arena {
+    XML_Memory_Handling_Suite suite;
+    bool in_use;
+    uint32_t caps;
+    size_t chunk_size;
+    arena_chunk_t *chunks;              // the first one is the current chunk
+    arena_large_t *large;
+    arena_free_t *free_list[ARENA_NUM_CLASSES];
+    esp_expat_arena_stats_t stats;
+};
+
+/*
+ * Expat memory suite functions do not take a context argument, so every arena
+ * slot has its own set of functions which pass the slot to the common code.
+ */
+static struct esp_expat_arena s_arenas[ESP_EXPAT_ARENA_MAX_NUM];
+static portMUX_TYPE s_arenas_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void *arena_malloc(esp_expat_arena_handle_t arena, size_t size);
+static void *arena_realloc(esp_expat_arena_handle_t arena, void *ptr, size_t size);
+static void arena_free(esp_expat_arena_handle_t arena, void *ptr);
+
+#define ARENA_SLOT_FUNCTIONS(n) \
+    static void *arena_malloc_##n(size_t size) { return arena_malloc(&s_arenas[n], size); } \
+    static void *arena_realloc_##n(void *ptr, size_t size) { return arena_realloc(&s_arenas[n], ptr, size); } \
+    static void arena_free_##n(void *ptr) { arena_free(&s_arenas[n], ptr); }
+
+#define ARENA_SLOT_SUITE(n) { arena_malloc_##n, arena_realloc_##n, arena_free_##n }
+
+ARENA_SLOT_FUNCTIONS(0)
+ARENA_SLOT_FUNCTIONS(1)
+ARENA_SLOT_FUNCTIONS(2)
+ARENA_SLOT_FUNCTIONS(3)
+
+static const XML_Memory_Handling_Suite s_slot_suites[ESP_EXPAT_ARENA_MAX_NUM] = {
+    ARENA_SLOT_SUITE(0),
+    ARENA_SLOT_SUITE(1),
+    ARENA_SLOT_SUITE(2),
+    ARENA_SLOT_SUITE(3),
+};
+
+static arena_chunk_t *arena_chunk_alloc(esp_expat_arena_handle_t arena)
+{
+    arena_chunk_t *chunk = heap_caps_malloc(arena->chunk_size, arena->caps);
+    if (!chunk) {
+        return NULL;
+    }
+    chunk->size = arena->chunk_size - ARENA_CHUNK_HDR_SIZE;
+    chunk->used = 0;
+    chunk->next = arena->chunks;
+    arena->chunks = chunk;
+    arena->stats.heap_allocs++;
+    arena->stats.chunks++;
+    arena->stats.total_bytes += arena->chunk_size;
+    return chunk;
+}
+
+static void arena_push_free(esp_expat_arena_handle_t arena, arena_block_t *block)
+{
+    arena_free_t *item = ARENA_DATA(block);
+    item->next = arena->free_list[block->cls];
+    arena->free_list[block->cls] = item;
+}
+
+/* Puts the unused tail of the current chunk into free lists before a new chunk is taken */
+static void arena_chunk_retire(esp_expat_arena_handle_t arena, arena_chunk_t *chunk)
+{
+    for (int cls = ARENA_NUM_CLASSES - 1; cls >= 0; cls--) {
+        size_t need = ARENA_BLOCK_HDR_SIZE + ARENA_CLASS_SIZE(cls);
+        while (chunk->size - chunk->used >= need) {
+            arena_block_t *block = (arena_block_t *)(ARENA_CHUNK_DATA(chunk) + chunk->used);
+            block->size = ARENA_CLASS_SIZE(cls);
+            block->cls = cls;
+            chunk->used += need;
+            arena_push_free(arena, block);
+        }
+    }
+}
+
+static void *arena_malloc_large(esp_expat_arena_handle_t arena, size_t size)
+{
+    if (size > UINT32_MAX - ARENA_LARGE_HDR_SIZE - ARENA_BLOCK_HDR_SIZE) {
+        return NULL;
+    }
+    size_t total = ARENA_LARGE_HDR_SIZE + ARENA_BLOCK_HDR_SIZE + size;
+    arena_large_t *large = heap_caps_malloc(total, arena->caps);
+    if (!large) {
+        return NULL;
+    }
+    large->prev = NULL;
+    large->next = arena->large;
+    if (arena->large) {
+        arena->large->prev = large;
+    }
+    arena->large = large;
+    arena->stats.heap_allocs++;
+    arena->stats.large_blocks++;
+    arena->stats.total_bytes += total;
+
+    arena_block_t *block = (arena_block_t *)((uint8_t *)large + ARENA_LARGE_HDR_SIZE);
+    block->size = size;
+    block->cls = ARENA_LARGE;
+    return ARENA_DATA(block);
+}
+
+static void arena_free_large(esp_expat_arena_handle_t arena, arena_block_t *block)
+{
+    arena_large_t *large = (arena_large_t *)((uint8_t *)block - ARENA_LARGE_HDR_SIZE);
+    if (large->prev) {
+        large->prev->next = large->next;
+    } else {
+        arena->large = large->next;
+    }
+    if (large->next) {
+        large->next->prev = large->prev;
+    }
+    arena->stats.large_blocks--;
+    arena->stats.total_bytes -= ARENA_LARGE_HDR_SIZE + ARENA_BLOCK_HDR_SIZE + block->size;
+    heap_caps_free(large);
+}
+
+static void *arena_malloc(esp_expat_arena_handle_t arena, size_t size)
+{
+    if (size > ESP_EXPAT_ARENA_MAX_BLOCK) {
+        return arena_malloc_large(arena, size);
+    }
+
+    int cls = 0;
+    while (ARENA_CLASS_SIZE(cls) < size) {
+        cls++;
+    }
+    arena_free_t *item = arena->free_list[cls];
+    if (item) {
+        arena->free_list[cls] = item->next;
+        return item;
+    }
+
+    size_t need = ARENA_BLOCK_HDR_SIZE + ARENA_CLASS_SIZE(cls);
+    arena_chunk_t *chunk = arena->chunks;
+    if (!chunk || chunk->size - chunk->used < need) {
+        if (chunk) {
+            arena_chunk_retire(arena, chunk);
+        }
+        chunk = arena_chunk_alloc(arena);
+        if (!chunk) {
+            return NULL;
+        }
+    }
+    arena_block_t *block = (arena_block_t *)(ARENA_CHUNK_DATA(chunk) + chunk->used);
+    chunk->used += need;
+    block->size = ARENA_CLASS_SIZE(cls);
+    block->cls = cls;
+    return ARENA_DATA(block);
+}
+
+static void *arena_realloc(esp_expat_arena_handle_t arena, void *ptr, size_t size)
+{
+    if (!ptr) {
+        return arena_malloc(arena, size);
+    }
+    arena_block_t *block = ARENA_BLOCK(ptr);
+    if (size <= block->size) {
+        return ptr;
+    }
+    void *new_ptr = arena_malloc(arena, size);
+    if (new_ptr) {
+        memcpy(new_ptr, ptr, block->size);
+        arena_free(arena, ptr);
+    }
+    return new_ptr;
+}
+
+static void arena_free(esp_expat_arena_handle_t arena, void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+    arena_block_t *block = ARENA_BLOCK(ptr);
+    if (block->cls == ARENA_LARGE) {
+        arena_free_large(arena, block);
+    } else {
+        arena_push_free(arena, block);
+    }
+}
+
+/* Frees large blocks and all chunks except the last one, which is the first allocated */
+static void arena_release(esp_expat_arena_handle_t arena, bool keep_first)
+{
+    while (arena->large) {
+        arena_free_large(arena, (arena_block_t *)((uint8_t *)arena->large + ARENA_LARGE_HDR_SIZE));
+    }
+    arena_chunk_t *chunk = arena->chunks;
+    while (chunk && (chunk->next || !keep_first)) {
+        arena_chunk_t *next = chunk->next;
+        heap_caps_free(chunk);
+        arena->stats.chunks--;
+        arena->stats.total_bytes -= arena->chunk_size;
+        chunk = next;
+    }
+    arena->chunks = chunk;
+    if (chunk) {
+        chunk->used = 0;
+    }
+    memset(arena->free_list, 0, sizeof(arena->free_list));
+}
+
+esp_err_t esp_expat_arena_create(const esp_expat_arena_config_t *config, esp_expat_arena_handle_t *out_arena)
+{
+    if (!config || !out_arena ||
+            config->chunk_size < ARENA_CHUNK_HDR_SIZE + ARENA_BLOCK_HDR_SIZE + ESP_EXPAT_ARENA_MAX_BLOCK) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_expat_arena_handle_t arena = NULL;
+    portENTER_CRITICAL(&s_arenas_lock);
+    for (int i = 0; i < ESP_EXPAT_ARENA_MAX_NUM; i++) {
+        if (!s_arenas[i].in_use) {
+            arena = &s_arenas[i];
+            memset(arena, 0, sizeof(*arena));
+            arena->in_use = true;
+            arena->suite = s_slot_suites[i];
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_arenas_lock);
+    if (!arena) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    arena->chunk_size = config->chunk_size;
+    arena->caps = config->caps;
+    if (!arena_chunk_alloc(arena)) {
+        esp_expat_arena_delete(arena);
+        return ESP_ERR_NO_MEM;
+    }
+    *out_arena = arena;
+    return ESP_OK;
+}
+
+const XML_Memory_Handling_Suite *esp_expat_arena_get_suite(esp_expat_arena_handle_t arena)
+{
+    return &arena->suite;
+}
+
+void esp_expat_arena_reset(esp_expat_arena_handle_t arena)
+{
+    arena_release(arena, true);
+}
+
+void esp_expat_arena_delete(esp_expat_arena_handle_t arena)
+{
+    if (!arena) {
+        return;
+    }
+    arena_release(arena, false);
+    portENTER_CRITICAL(&s_arenas_lock);
+    arena->in_use = false;
+    portEXIT_CRITICAL(&s_arenas_lock);
+}
+
+void esp_expat_arena_get_stats(esp_expat_arena_handle_t arena, esp_expat_arena_stats_t *stats)
+{
+    *stats = arena->stats;
+}
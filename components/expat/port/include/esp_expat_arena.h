@@ -0,0 +1,142 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "expat.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file esp_expat_arena.h
+ * @brief Arena memory handling suite for the Expat parser
+ *
+ * The default memory suite of Expat calls malloc() for every element, attribute
+ * and string pool block. An arena serves these small allocations from large chunks,
+ * keeps freed blocks in free lists of power of two sizes and returns the chunks
+ * to the heap only when it is reset or deleted.
+ *
+ * Typical usage:
+ *
+ * @code{c}
+ * esp_expat_arena_config_t config = ESP_EXPAT_ARENA_CONFIG_DEFAULT();
+ * esp_expat_arena_handle_t arena;
+ * ESP_ERROR_CHECK(esp_expat_arena_create(&config, &arena));
+ * XML_Parser parser = XML_ParserCreate_MM(NULL, esp_expat_arena_get_suite(arena), NULL);
+ * // parse the first document
+ * XML_ParserReset(parser, NULL);  // keeps parser buffers for the next document
+ * // parse the next document
+ * XML_ParserFree(parser);
+ * esp_expat_arena_delete(arena);
+ * @endcode
+ *
+ * An arena is not thread safe: it may be used by several parsers,
+ * but only from one task at a time.
+ */
+
+/** Maximal number of arenas which may exist at the same time */
+#define ESP_EXPAT_ARENA_MAX_NUM     4
+
+/** Largest block served from arena chunks, larger blocks are allocated from the heap */
+#define ESP_EXPAT_ARENA_MAX_BLOCK   2048
+
+#if CONFIG_EXPAT_ARENA_SPIRAM
+#define ESP_EXPAT_ARENA_DEFAULT_CAPS    (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define ESP_EXPAT_ARENA_DEFAULT_CAPS    (MALLOC_CAP_8BIT)
+#endif
+
+/** Default arena configuration */
+#define ESP_EXPAT_ARENA_CONFIG_DEFAULT() {              \
+    .chunk_size = CONFIG_EXPAT_ARENA_CHUNK_SIZE,        \
+    .caps = ESP_EXPAT_ARENA_DEFAULT_CAPS,               \
+}
+
+/** Arena handle */
+typedef struct esp_expat_arena *esp_expat_arena_handle_t;
+
+/** Arena configuration */
+typedef struct {
+    size_t chunk_size;      /*!< Size of memory chunks allocated from the heap, at least ESP_EXPAT_ARENA_MAX_BLOCK */
+    uint32_t caps;          /*!< Heap capabilities of chunks and large blocks, e.g. MALLOC_CAP_SPIRAM */
+} esp_expat_arena_config_t;
+
+/** Arena statistics */
+typedef struct {
+    size_t heap_allocs;     /*!< Number of heap allocations done by the arena since it was created */
+    size_t chunks;          /*!< Number of chunks owned by the arena */
+    size_t large_blocks;    /*!< Number of large blocks allocated from the heap and not freed yet */
+    size_t total_bytes;     /*!< Heap memory owned by the arena, chunks and large blocks */
+} esp_expat_arena_stats_t;
+
+/**
+ * @brief Create an arena
+ *
+ * The first chunk is allocated at once.
+ *
+ * @param config Arena configuration
+ * @param[out] out_arena Handle of the new arena
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Incorrect configuration
+ *     - ESP_ERR_NO_MEM Not enough memory or ESP_EXPAT_ARENA_MAX_NUM arenas already exist
+ */
+esp_err_t esp_expat_arena_create(const esp_expat_arena_config_t *config, esp_expat_arena_handle_t *out_arena);
+
+/**
+ * @brief Get memory handling suite of an arena to pass to XML_ParserCreate_MM()
+ *
+ * @param arena Arena handle
+ *
+ * @return Memory suite, valid until the arena is deleted
+ */
+const XML_Memory_Handling_Suite *esp_expat_arena_get_suite(esp_expat_arena_handle_t arena);
+
+/**
+ * @brief Release all memory allocated from an arena
+ *
+ * The first chunk is kept, all other chunks and large blocks are returned to the heap.
+ * Parsers using the arena must be freed (or must not be used any more) before the reset.
+ * To reuse a parser and its buffers for the next document call XML_ParserReset() instead.
+ *
+ * @param arena Arena handle
+ */
+void esp_expat_arena_reset(esp_expat_arena_handle_t arena);
+
+/**
+ * @brief Delete an arena and return all its memory to the heap
+ *
+ * @param arena Arena handle
+ */
+void esp_expat_arena_delete(esp_expat_arena_handle_t arena);
+
+/**
+ * @brief Get arena statistics
+ *
+ * @param arena Arena handle
+ * @param[out] stats Statistics
+ */
+void esp_expat_arena_get_stats(esp_expat_arena_handle_t arena, esp_expat_arena_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -13,8 +13,11 @@
 // limitations under the License.
 
 #include <expat.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "unity.h"
+#include "esp_expat_arena.h"
 
 typedef struct {
     int depth;
@@ -125,3 +128,70 @@ TEST_CASE("Expat parses XML", "[expat]")
     TEST_ASSERT_EQUAL(strlen(test_expected), strlen(user_data.output));
     TEST_ASSERT_EQUAL_STRING(test_expected, user_data.output);
 }
+
+static void XMLCALL count_element(void *userData, const XML_Char *name, const XML_Char **atts)
+{
+    ++*(int *) userData;
+}
+
+static void parse_in_pieces(XML_Parser parser, const char *doc, size_t len, size_t piece)
+{
+    for (size_t off = 0; off < len; off += piece) {
+        size_t size = (len - off < piece) ? len - off : piece;
+        TEST_ASSERT_NOT_EQUAL(XML_STATUS_ERROR, XML_Parse(parser, doc + off, size, off + size == len));
+    }
+}
+
+TEST_CASE("Expat parses large XML with arena memory", "[expat]")
+{
+    const int items = 800;
+    const size_t doc_size = 64 * 1024;
+    char *doc = malloc(doc_size);
+    TEST_ASSERT_NOT_NULL(doc);
+    size_t len = snprintf(doc, doc_size, "<root>");
+    for (int i = 0; i < items; i++) {
+        len += snprintf(doc + len, doc_size - len, "<item id=\"%d\"><name>Item %d</name><value>%d</value></item>",
+                        i, i, i * 3);
+    }
+    len += snprintf(doc + len, doc_size - len, "</root>");
+    TEST_ASSERT_LESS_THAN(doc_size, len);
+
+    esp_expat_arena_config_t config = ESP_EXPAT_ARENA_CONFIG_DEFAULT();
+    esp_expat_arena_handle_t arena;
+    TEST_ESP_OK(esp_expat_arena_create(&config, &arena));
+    esp_expat_arena_stats_t stats;
+    esp_expat_arena_get_stats(arena, &stats);
+    const size_t initial_allocs = stats.heap_allocs;
+
+    int elements = 0;
+    XML_Parser parser = XML_ParserCreate_MM(NULL, esp_expat_arena_get_suite(arena), NULL);
+    TEST_ASSERT_NOT_NULL(parser);
+    XML_SetUserData(parser, &elements);
+    XML_SetStartElementHandler(parser, count_element);
+    parse_in_pieces(parser, doc, len, 1024);
+    TEST_ASSERT_EQUAL(1 + items * 3, elements);
+
+    esp_expat_arena_get_stats(arena, &stats);
+    printf("arena: %d heap allocations, %d bytes for %d bytes document\n",
+           (int) (stats.heap_allocs - initial_allocs), (int) stats.total_bytes, (int) len);
+    TEST_ASSERT_LESS_OR_EQUAL(8, stats.heap_allocs - initial_allocs);
+
+    // reset parser keeps its buffers, the next document does not allocate
+    const size_t allocs = stats.heap_allocs;
+    TEST_ASSERT_TRUE(XML_ParserReset(parser, NULL));
+    elements = 0;
+    XML_SetUserData(parser, &elements);
+    XML_SetStartElementHandler(parser, count_element);
+    parse_in_pieces(parser, doc, len, 1024);
+    TEST_ASSERT_EQUAL(1 + items * 3, elements);
+    esp_expat_arena_get_stats(arena, &stats);
+    TEST_ASSERT_EQUAL(allocs, stats.heap_allocs);
+
+    XML_ParserFree(parser);
+    esp_expat_arena_reset(arena);
+    esp_expat_arena_get_stats(arena, &stats);
+    TEST_ASSERT_EQUAL(1, stats.chunks);
+    TEST_ASSERT_EQUAL(0, stats.large_blocks);
+    esp_expat_arena_delete(arena);
+    free(doc);
+}
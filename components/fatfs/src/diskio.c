@@ -9,14 +9,333 @@
 /*-----------------------------------------------------------------------*/
 
 #include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
 #include <time.h>
 #include <sys/time.h>
 #include "diskio.h"		/* FatFs lower layer API */
 #include "ffconf.h"
 #include "ff.h"
+#if CONFIG_FATFS_SECTOR_CACHE_IN_EXTRAM
+#include "esp_heap_caps.h"
+#endif
 
 static ff_diskio_impl_t * s_impls[FF_VOLUMES] = { NULL };
 
+#if CONFIG_FATFS_SECTOR_CACHE
+/* Sector cache between FatFs and the diskio drivers.
+ * Single sector accesses, as done by FatFs for FAT and directory sectors and for
+ * the sector buffer of each file, go through an LRU cache. Multi-sector accesses
+ * transfer file data directly to or from the buffer of the application and are
+ * not cached, but they see and update the cached sectors.
+ */
+
+#define CACHE_SECTOR_NONE   0xFFFFFFFF
+
+/* Number of sectors read at once on sequential reads, and written back at once */
+#define CACHE_BURST_SECTORS (MIN(CONFIG_FATFS_SECTOR_CACHE_READ_AHEAD, CONFIG_FATFS_SECTOR_CACHE_SECTORS - 1) + 1)
+
+typedef struct {
+    DWORD sector;       /* sector held by this entry, CACHE_SECTOR_NONE if the entry is free */
+    uint32_t last_use;  /* value of use_counter at the last access to this entry */
+    bool dirty;         /* written by FatFs, but not written back to the disk yet */
+} ff_cache_entry_t;
+
+typedef struct {
+    UINT sector_size;
+    DWORD sector_count;     /* sectors on the disk, 0 if unknown; no read-ahead goes beyond */
+    DWORD next_read;        /* sector following the last read, to detect sequential reads */
+    uint32_t use_counter;
+    BYTE* data;             /* data of entries[i] is at data + i * sector_size */
+    BYTE* burst;            /* CACHE_BURST_SECTORS sectors for read-ahead and merged write-back */
+    ff_cache_entry_t entries[CONFIG_FATFS_SECTOR_CACHE_SECTORS];
+} ff_sector_cache_t;
+
+static ff_sector_cache_t* s_caches[FF_VOLUMES] = { NULL };
+
+static void* cache_alloc(size_t size)
+{
+#if CONFIG_FATFS_SECTOR_CACHE_IN_EXTRAM
+    return heap_caps_malloc_prefer(size, 2, MALLOC_CAP_DEFAULT | MALLOC_CAP_SPIRAM,
+                                            MALLOC_CAP_DEFAULT | MALLOC_CAP_INTERNAL);
+#else
+    return malloc(size);
+#endif
+}
+
+static inline BYTE* cache_data(ff_sector_cache_t* cache, ff_cache_entry_t* entry)
+{
+    return cache->data + (entry - cache->entries) * cache->sector_size;
+}
+
+static ff_cache_entry_t* cache_find(ff_sector_cache_t* cache, DWORD sector)
+{
+    if (sector == CACHE_SECTOR_NONE) {
+        return NULL;
+    }
+    for (int i = 0; i < CONFIG_FATFS_SECTOR_CACHE_SECTORS; i++) {
+        if (cache->entries[i].sector == sector) {
+            return &cache->entries[i];
+        }
+    }
+    return NULL;
+}
+
+static inline void cache_touch(ff_sector_cache_t* cache, ff_cache_entry_t* entry)
+{
+    entry->last_use = ++cache->use_counter;
+}
+
+/* Write back a dirty entry. If merge is set, the dirty entries of the sectors around
+ * it are written back in the same disk operation, through the burst buffer.
+ */
+static DRESULT cache_write_back(BYTE pdrv, ff_sector_cache_t* cache, ff_cache_entry_t* entry, bool merge)
+{
+    const UINT ss = cache->sector_size;
+    DWORD first = entry->sector;
+    DWORD last = entry->sector;
+    ff_cache_entry_t* e;
+    if (merge) {
+        while (first > 0 && last - first + 1 < CACHE_BURST_SECTORS
+                && (e = cache_find(cache, first - 1)) != NULL && e->dirty) {
+            first--;
+        }
+        while (last - first + 1 < CACHE_BURST_SECTORS
+                && (e = cache_find(cache, last + 1)) != NULL && e->dirty) {
+            last++;
+        }
+    }
+    const UINT count = last - first + 1;
+    const BYTE* buf = cache_data(cache, entry);
+    if (count > 1) {
+        for (UINT i = 0; i < count; i++) {
+            memcpy(cache->burst + i * ss, cache_data(cache, cache_find(cache, first + i)), ss);
+        }
+        buf = cache->burst;
+    }
+    DRESULT res = s_impls[pdrv]->write(pdrv, buf, first, count);
+    if (res == RES_OK) {
+        for (UINT i = 0; i < count; i++) {
+            cache_find(cache, first + i)->dirty = false;
+        }
+    }
+    return res;
+}
+
+/* Get a free entry, evicting the least recently used one if needed */
+static DRESULT cache_get_free(BYTE pdrv, ff_sector_cache_t* cache, bool merge, ff_cache_entry_t** out_entry)
+{
+    ff_cache_entry_t* lru = &cache->entries[0];
+    for (int i = 0; i < CONFIG_FATFS_SECTOR_CACHE_SECTORS; i++) {
+        ff_cache_entry_t* e = &cache->entries[i];
+        if (e->sector == CACHE_SECTOR_NONE) {
+            lru = e;
+            break;
+        }
+        if ((int32_t) (e->last_use - lru->last_use) < 0) {
+            lru = e;
+        }
+    }
+    if (lru->dirty) {
+        DRESULT res = cache_write_back(pdrv, cache, lru, merge);
+        if (res != RES_OK) {
+            return res;
+        }
+    }
+    lru->sector = CACHE_SECTOR_NONE;
+    *out_entry = lru;
+    return RES_OK;
+}
+
+static DRESULT cache_flush(BYTE pdrv, ff_sector_cache_t* cache)
+{
+    // Write back in ascending order, for runs of consecutive sectors to be merged
+    while (true) {
+        ff_cache_entry_t* first = NULL;
+        for (int i = 0; i < CONFIG_FATFS_SECTOR_CACHE_SECTORS; i++) {
+            ff_cache_entry_t* e = &cache->entries[i];
+            if (e->dirty && (first == NULL || e->sector < first->sector)) {
+                first = e;
+            }
+        }
+        if (first == NULL) {
+            return RES_OK;
+        }
+        DRESULT res = cache_write_back(pdrv, cache, first, true);
+        if (res != RES_OK) {
+            return res;
+        }
+    }
+}
+
+static DRESULT cache_read(BYTE pdrv, ff_sector_cache_t* cache, BYTE* buff, DWORD sector, UINT count)
+{
+    const UINT ss = cache->sector_size;
+    const bool sequential = (sector == cache->next_read);
+    cache->next_read = sector + count;
+    DRESULT res;
+    if (count > 1) {
+        res = s_impls[pdrv]->read(pdrv, buff, sector, count);
+        if (res != RES_OK) {
+            return res;
+        }
+        // The cache holds newer data of dirty sectors
+        for (int i = 0; i < CONFIG_FATFS_SECTOR_CACHE_SECTORS; i++) {
+            ff_cache_entry_t* e = &cache->entries[i];
+            if (e->dirty && e->sector - sector < count) {
+                memcpy(buff + (e->sector - sector) * ss, cache_data(cache, e), ss);
+            }
+        }
+        return RES_OK;
+    }
+
+    ff_cache_entry_t* entry = cache_find(cache, sector);
+    if (entry != NULL) {
+        memcpy(buff, cache_data(cache, entry), ss);
+        cache_touch(cache, entry);
+        return RES_OK;
+    }
+    UINT burst = 1;
+    if (sequential && sector < cache->sector_count) {
+        burst = MIN(CACHE_BURST_SECTORS, cache->sector_count - sector);
+    }
+    if (burst == 1) {
+        res = cache_get_free(pdrv, cache, true, &entry);
+        if (res != RES_OK) {
+            return res;
+        }
+        res = s_impls[pdrv]->read(pdrv, cache_data(cache, entry), sector, 1);
+        if (res != RES_OK) {
+            return res;
+        }
+        entry->sector = sector;
+        memcpy(buff, cache_data(cache, entry), ss);
+        cache_touch(cache, entry);
+        return RES_OK;
+    }
+    // Read ahead: read the following sectors in the same operation, and cache them all
+    res = s_impls[pdrv]->read(pdrv, cache->burst, sector, burst);
+    if (res != RES_OK) {
+        return res;
+    }
+    memcpy(buff, cache->burst, ss);
+    // The sectors which are already cached may hold newer data, and may get evicted below
+    for (int i = 0; i < CONFIG_FATFS_SECTOR_CACHE_SECTORS; i++) {
+        ff_cache_entry_t* e = &cache->entries[i];
+        if (e->sector != CACHE_SECTOR_NONE && e->sector - sector < burst) {
+            memcpy(cache->burst + (e->sector - sector) * ss, cache_data(cache, e), ss);
+        }
+    }
+    for (UINT i = 0; i < burst; i++) {
+        if (cache_find(cache, sector + i) != NULL) {
+            continue;
+        }
+        // the burst buffer is in use, so evicted entries are written back one by one
+        res = cache_get_free(pdrv, cache, false, &entry);
+        if (res != RES_OK) {
+            return res;
+        }
+        memcpy(cache_data(cache, entry), cache->burst + i * ss, ss);
+        entry->sector = sector + i;
+        cache_touch(cache, entry);
+    }
+    return RES_OK;
+}
+
+static DRESULT cache_write(BYTE pdrv, ff_sector_cache_t* cache, const BYTE* buff, DWORD sector, UINT count)
+{
+    const UINT ss = cache->sector_size;
+    DRESULT res;
+#if CONFIG_FATFS_SECTOR_CACHE_WRITE_BACK
+    if (count == 1) {
+        ff_cache_entry_t* entry = cache_find(cache, sector);
+        if (entry == NULL) {
+            res = cache_get_free(pdrv, cache, true, &entry);
+            if (res != RES_OK) {
+                return res;
+            }
+            entry->sector = sector;
+        }
+        memcpy(cache_data(cache, entry), buff, ss);
+        entry->dirty = true;
+        cache_touch(cache, entry);
+        return RES_OK;
+    }
+#endif
+    res = s_impls[pdrv]->write(pdrv, buff, sector, count);
+    if (res != RES_OK) {
+        return res;
+    }
+    // Keep the cached copies of the written sectors up to date
+    for (int i = 0; i < CONFIG_FATFS_SECTOR_CACHE_SECTORS; i++) {
+        ff_cache_entry_t* e = &cache->entries[i];
+        if (e->sector != CACHE_SECTOR_NONE && e->sector - sector < count) {
+            memcpy(cache_data(cache, e), buff + (e->sector - sector) * ss, ss);
+            e->dirty = false;
+        }
+    }
+    return RES_OK;
+}
+
+static void cache_invalidate(ff_sector_cache_t* cache, DWORD first, DWORD last)
+{
+    for (int i = 0; i < CONFIG_FATFS_SECTOR_CACHE_SECTORS; i++) {
+        ff_cache_entry_t* e = &cache->entries[i];
+        if (e->sector != CACHE_SECTOR_NONE && e->sector >= first && e->sector <= last) {
+            e->sector = CACHE_SECTOR_NONE;
+            e->dirty = false;
+        }
+    }
+}
+
+static void cache_create(BYTE pdrv)
+{
+    WORD sector_size = FF_MAX_SS;
+#if FF_MAX_SS != FF_MIN_SS
+    if (s_impls[pdrv]->ioctl(pdrv, GET_SECTOR_SIZE, &sector_size) != RES_OK || sector_size > FF_MAX_SS) {
+        return;
+    }
+#endif
+    DWORD sector_count = 0;
+    if (s_impls[pdrv]->ioctl(pdrv, GET_SECTOR_COUNT, &sector_count) != RES_OK) {
+        sector_count = 0;
+    }
+    ff_sector_cache_t* cache = calloc(1, sizeof(ff_sector_cache_t));
+    if (cache == NULL) {
+        return;
+    }
+    cache->sector_size = sector_size;
+    cache->sector_count = sector_count;
+    cache->next_read = CACHE_SECTOR_NONE;
+    cache->data = cache_alloc(CONFIG_FATFS_SECTOR_CACHE_SECTORS * sector_size);
+    cache->burst = (CACHE_BURST_SECTORS > 1) ? cache_alloc(CACHE_BURST_SECTORS * sector_size) : NULL;
+    if (cache->data == NULL || (CACHE_BURST_SECTORS > 1 && cache->burst == NULL)) {
+        // run without the cache
+        free(cache->data);
+        free(cache->burst);
+        free(cache);
+        return;
+    }
+    for (int i = 0; i < CONFIG_FATFS_SECTOR_CACHE_SECTORS; i++) {
+        cache->entries[i].sector = CACHE_SECTOR_NONE;
+    }
+    s_caches[pdrv] = cache;
+}
+
+static void cache_delete(BYTE pdrv)
+{
+    ff_sector_cache_t* cache = s_caches[pdrv];
+    if (cache == NULL) {
+        return;
+    }
+    cache_flush(pdrv, cache);
+    s_caches[pdrv] = NULL;
+    free(cache->data);
+    free(cache->burst);
+    free(cache);
+}
+#endif // CONFIG_FATFS_SECTOR_CACHE
+
 #if FF_MULTI_PARTITION		/* Multiple partition configuration */
 PARTITION VolToPart[] = {
     {0, 0},    /* Logical drive 0 ==> Physical drive 0, auto detection */
@@ -41,6 +360,10 @@ void ff_diskio_register(BYTE pdrv, const ff_diskio_impl_t* discio_impl)
     assert(pdrv < FF_VOLUMES);
 
     if (s_impls[pdrv]) {
+#if CONFIG_FATFS_SECTOR_CACHE
+        // write back the cached sectors with the driver they were read from
+        cache_delete(pdrv);
+#endif
         ff_diskio_impl_t* im = s_impls[pdrv];
         s_impls[pdrv] = NULL;
         free(im);
@@ -58,7 +381,13 @@ void ff_diskio_register(BYTE pdrv, const ff_diskio_impl_t* discio_impl)
 
 DSTATUS ff_disk_initialize (BYTE pdrv)
 {
-    return s_impls[pdrv]->init(pdrv);
+    DSTATUS status = s_impls[pdrv]->init(pdrv);
+#if CONFIG_FATFS_SECTOR_CACHE
+    if (!(status & STA_NOINIT) && s_caches[pdrv] == NULL) {
+        cache_create(pdrv);
+    }
+#endif
+    return status;
 }
 DSTATUS ff_disk_status (BYTE pdrv)
 {
@@ -66,14 +395,35 @@ DSTATUS ff_disk_status (BYTE pdrv)
 }
 DRESULT ff_disk_read (BYTE pdrv, BYTE* buff, DWORD sector, UINT count)
 {
+#if CONFIG_FATFS_SECTOR_CACHE
+    if (s_caches[pdrv]) {
+        return cache_read(pdrv, s_caches[pdrv], buff, sector, count);
+    }
+#endif
     return s_impls[pdrv]->read(pdrv, buff, sector, count);
 }
 DRESULT ff_disk_write (BYTE pdrv, const BYTE* buff, DWORD sector, UINT count)
 {
+#if CONFIG_FATFS_SECTOR_CACHE
+    if (s_caches[pdrv]) {
+        return cache_write(pdrv, s_caches[pdrv], buff, sector, count);
+    }
+#endif
     return s_impls[pdrv]->write(pdrv, buff, sector, count);
 }
 DRESULT ff_disk_ioctl (BYTE pdrv, BYTE cmd, void* buff)
 {
+#if CONFIG_FATFS_SECTOR_CACHE
+    ff_sector_cache_t* cache = s_caches[pdrv];
+    if (cache && cmd == CTRL_SYNC) {
+        DRESULT res = cache_flush(pdrv, cache);
+        if (res != RES_OK) {
+            return res;
+        }
+    } else if (cache && cmd == CTRL_TRIM) {
+        cache_invalidate(cache, ((DWORD*) buff)[0], ((DWORD*) buff)[1]);
+    }
+#endif
     return s_impls[pdrv]->ioctl(pdrv, cmd, buff);
 }
 
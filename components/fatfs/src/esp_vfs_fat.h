@@ -83,6 +83,25 @@ esp_err_t esp_vfs_fat_unregister() __attribute__((deprecated));
  */
 esp_err_t esp_vfs_fat_unregister_path(const char* base_path);
 
+/**
+ * @brief Set the memory placement of files opened next on a FATFS partition
+ *
+ * The FIL structure of a file, which includes its sector buffer when
+ * CONFIG_FATFS_PER_FILE_CACHE is enabled, is allocated when the file is opened,
+ * and freed when it is closed. This function sets the heap capabilities used
+ * for files opened after the call, e.g. MALLOC_CAP_SPIRAM for files transferred
+ * in bulk and MALLOC_CAP_INTERNAL for frequently accessed ones. Files which are
+ * already open are not moved.
+ *
+ * @param base_path  path prefix where FATFS is registered
+ * @param caps       heap capabilities (MALLOC_CAP_*); 0 to use the default placement,
+ *                   the same as for other memory allocated by FATFS
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_STATE if FATFS is not registered at base_path
+ */
+esp_err_t esp_vfs_fat_set_file_caps(const char* base_path, uint32_t caps);
+
 
 /**
  * @brief Configuration arguments for esp_vfs_fat_sdmmc_mount and esp_vfs_fat_spiflash_mount functions
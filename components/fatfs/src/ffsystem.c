@@ -4,6 +4,7 @@
 /*------------------------------------------------------------------------*/
 
 
+#include <stdlib.h>
 #include <string.h>
 #include "ff.h"
 #include "sdkconfig.h"
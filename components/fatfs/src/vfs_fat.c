@@ -21,6 +21,7 @@
 #include <sys/lock.h>
 #include "esp_vfs.h"
 #include "esp_log.h"
+#include "esp_heap_caps.h"
 #include "ff.h"
 #include "diskio.h"
 
@@ -28,12 +29,18 @@ typedef struct {
     char fat_drive[8];  /* FAT drive name */
     char base_path[ESP_VFS_PATH_MAX];   /* base path in VFS where partition is registered */
     size_t max_files;   /* max number of simultaneously open files; size of files[] array */
+    uint32_t file_caps; /* heap capabilities of FIL structures allocated for files opened next; 0 for the default placement */
     _lock_t lock;       /* guard for access to this structure */
     FATFS fs;           /* fatfs library FS structure */
     char tmp_path_buf[FILENAME_MAX+3];  /* temporary buffer used to prepend drive name to the path */
     char tmp_path_buf2[FILENAME_MAX+3]; /* as above; used in functions which take two path arguments */
     bool *o_append;  /* O_APPEND is stored here for each max_files entries (because O_APPEND is not compatible with FA_OPEN_APPEND) */
-    FIL files[0];   /* array with max_files entries; must be the final member of the structure */
+#if FF_USE_FASTSEEK
+    bool *no_link_map;  /* set for each of max_files entries whose cluster link map doesn't fit into CONFIG_FATFS_FAST_SEEK_BUFFER_SIZE */
+#endif
+    size_t *free_fds;   /* stack of the max_files entries of files[] which are not in use */
+    size_t free_fds_count;  /* number of items on the free_fds stack */
+    FIL* files[0];  /* array with max_files entries, NULL unless open; must be the final member of the structure */
 } vfs_fat_ctx_t;
 
 typedef struct {
@@ -65,9 +72,18 @@ typedef union {
 
 static const char* TAG = "vfs_fat";
 
+#if FF_USE_FASTSEEK
+/* Number of items of the cluster link map tried first, enough for a file in 7 fragments */
+#define LINK_MAP_INITIAL_ITEMS  16
+#endif
+
 static ssize_t vfs_fat_write(void* p, int fd, const void * data, size_t size);
 static off_t vfs_fat_lseek(void* p, int fd, off_t size, int mode);
 static ssize_t vfs_fat_read(void* ctx, int fd, void * dst, size_t size);
+static ssize_t vfs_fat_pread(void* ctx, int fd, void * dst, size_t size, off_t offset);
+static ssize_t vfs_fat_pwrite(void* ctx, int fd, const void * src, size_t size, off_t offset);
+static ssize_t vfs_fat_readv(void* ctx, int fd, const struct iovec * iov, int iovcnt);
+static ssize_t vfs_fat_writev(void* ctx, int fd, const struct iovec * iov, int iovcnt);
 static int vfs_fat_open(void* ctx, const char * path, int flags, int mode);
 static int vfs_fat_close(void* ctx, int fd);
 static int vfs_fat_fstat(void* ctx, int fd, struct stat * st);
@@ -129,6 +145,10 @@ esp_err_t esp_vfs_fat_register(const char* base_path, const char* fat_drive, siz
         .write_p = &vfs_fat_write,
         .lseek_p = &vfs_fat_lseek,
         .read_p = &vfs_fat_read,
+        .pread_p = &vfs_fat_pread,
+        .pwrite_p = &vfs_fat_pwrite,
+        .readv_p = &vfs_fat_readv,
+        .writev_p = &vfs_fat_writev,
         .open_p = &vfs_fat_open,
         .close_p = &vfs_fat_close,
         .fstat_p = &vfs_fat_fstat,
@@ -149,7 +169,7 @@ esp_err_t esp_vfs_fat_register(const char* base_path, const char* fat_drive, siz
         .truncate_p = &vfs_fat_truncate,
         .utime_p = &vfs_fat_utime,
     };
-    size_t ctx_size = sizeof(vfs_fat_ctx_t) + max_files * sizeof(FIL);
+    size_t ctx_size = sizeof(vfs_fat_ctx_t) + max_files * sizeof(FIL*);
     vfs_fat_ctx_t* fat_ctx = (vfs_fat_ctx_t*) ff_memcalloc(1, ctx_size);
     if (fat_ctx == NULL) {
         return ESP_ERR_NO_MEM;
@@ -159,12 +179,38 @@ esp_err_t esp_vfs_fat_register(const char* base_path, const char* fat_drive, siz
         free(fat_ctx);
         return ESP_ERR_NO_MEM;
     }
+#if FF_USE_FASTSEEK
+    fat_ctx->no_link_map = ff_memcalloc(max_files, sizeof(bool));
+    if (fat_ctx->no_link_map == NULL) {
+        free(fat_ctx->o_append);
+        free(fat_ctx);
+        return ESP_ERR_NO_MEM;
+    }
+#endif
+    fat_ctx->free_fds = ff_memalloc(max_files * sizeof(size_t));
+    if (fat_ctx->free_fds == NULL) {
+#if FF_USE_FASTSEEK
+        free(fat_ctx->no_link_map);
+#endif
+        free(fat_ctx->o_append);
+        free(fat_ctx);
+        return ESP_ERR_NO_MEM;
+    }
+    // the lowest descriptor is on top of the stack
+    for (size_t i = 0; i < max_files; ++i) {
+        fat_ctx->free_fds[i] = max_files - 1 - i;
+    }
+    fat_ctx->free_fds_count = max_files;
     fat_ctx->max_files = max_files;
     strlcpy(fat_ctx->fat_drive, fat_drive, sizeof(fat_ctx->fat_drive) - 1);
     strlcpy(fat_ctx->base_path, base_path, sizeof(fat_ctx->base_path) - 1);
 
     esp_err_t err = esp_vfs_register(base_path, &vfs, fat_ctx);
     if (err != ESP_OK) {
+        free(fat_ctx->free_fds);
+#if FF_USE_FASTSEEK
+        free(fat_ctx->no_link_map);
+#endif
         free(fat_ctx->o_append);
         free(fat_ctx);
         return err;
@@ -193,12 +239,37 @@ esp_err_t esp_vfs_fat_unregister_path(const char* base_path)
         return err;
     }
     _lock_close(&fat_ctx->lock);
+    for (size_t i = 0; i < fat_ctx->max_files; ++i) {
+        if (fat_ctx->files[i] != NULL) {
+#if FF_USE_FASTSEEK
+            free(fat_ctx->files[i]->cltbl);
+#endif
+            free(fat_ctx->files[i]);
+        }
+    }
+    free(fat_ctx->free_fds);
+#if FF_USE_FASTSEEK
+    free(fat_ctx->no_link_map);
+#endif
     free(fat_ctx->o_append);
     free(fat_ctx);
     s_fat_ctxs[ctx] = NULL;
     return ESP_OK;
 }
 
+esp_err_t esp_vfs_fat_set_file_caps(const char* base_path, uint32_t caps)
+{
+    size_t ctx = find_context_index_by_path(base_path);
+    if (ctx == FF_VOLUMES) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    vfs_fat_ctx_t* fat_ctx = s_fat_ctxs[ctx];
+    _lock_acquire(&fat_ctx->lock);
+    fat_ctx->file_caps = caps;
+    _lock_release(&fat_ctx->lock);
+    return ESP_OK;
+}
+
 esp_err_t esp_vfs_fat_unregister()
 {
     if (s_fat_ctx == NULL) {
@@ -212,14 +283,30 @@ esp_err_t esp_vfs_fat_unregister()
     return ESP_OK;
 }
 
+/**
+ * @brief Take a free file descriptor and allocate its FIL structure
+ * @return file descriptor; -1 with errno set if there are no free descriptors or no memory
+ */
 static int get_next_fd(vfs_fat_ctx_t* fat_ctx)
 {
-    for (size_t i = 0; i < fat_ctx->max_files; ++i) {
-        if (fat_ctx->files[i].obj.fs == NULL) {
-            return (int) i;
-        }
+    if (fat_ctx->free_fds_count == 0) {
+        ESP_LOGE(TAG, "open: no free file descriptors");
+        errno = ENFILE;
+        return -1;
     }
-    return -1;
+    FIL* file;
+    if (fat_ctx->file_caps != 0) {
+        file = heap_caps_calloc(1, sizeof(FIL), fat_ctx->file_caps);
+    } else {
+        file = ff_memcalloc(1, sizeof(FIL));
+    }
+    if (file == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    size_t fd = fat_ctx->free_fds[--fat_ctx->free_fds_count];
+    fat_ctx->files[fd] = file;
+    return (int) fd;
 }
 
 static int fat_mode_conv(int m)
@@ -277,9 +364,68 @@ static int fresult_to_errno(FRESULT fr)
 
 static void file_cleanup(vfs_fat_ctx_t* ctx, int fd)
 {
-    memset(&ctx->files[fd], 0, sizeof(FIL));
+#if FF_USE_FASTSEEK
+    free(ctx->files[fd]->cltbl);
+    ctx->no_link_map[fd] = false;
+#endif
+    free(ctx->files[fd]);
+    ctx->files[fd] = NULL;
+    ctx->free_fds[ctx->free_fds_count++] = fd;
 }
 
+#if FF_USE_FASTSEEK
+/**
+ * @brief Create the cluster link map of an open file, if it doesn't have one yet
+ * Seeks and reads then find the clusters of the file in this map, instead of
+ * following the cluster chain from the start of the file. If the map doesn't fit
+ * into CONFIG_FATFS_FAST_SEEK_BUFFER_SIZE, the file keeps using the cluster chain.
+ */
+static void file_create_link_map(vfs_fat_ctx_t* ctx, int fd)
+{
+    FIL* file = ctx->files[fd];
+    if (file->cltbl != NULL || ctx->no_link_map[fd]) {
+        return;
+    }
+    const DWORD max_items = CONFIG_FATFS_FAST_SEEK_BUFFER_SIZE / sizeof(DWORD);
+    DWORD items = (LINK_MAP_INITIAL_ITEMS < max_items) ? LINK_MAP_INITIAL_ITEMS : max_items;
+    while (true) {
+        DWORD* map = ff_memalloc(items * sizeof(DWORD));
+        if (map == NULL) {
+            return;
+        }
+        map[0] = items;
+        file->cltbl = map;
+        FRESULT res = f_lseek(file, CREATE_LINKMAP);
+        if (res == FR_OK) {
+            return;
+        }
+        // on FR_NOT_ENOUGH_CORE, the number of items required is returned in map[0]
+        const DWORD required = map[0];
+        file->cltbl = NULL;
+        free(map);
+        if (res != FR_NOT_ENOUGH_CORE || required > max_items) {
+            ESP_LOGD(TAG, "%s: fresult=%d, %u items required", __func__, res, (unsigned) required);
+            ctx->no_link_map[fd] = true;
+            return;
+        }
+        items = required;
+    }
+}
+
+/**
+ * @brief Drop the cluster link map of an open file before it grows to end_pos
+ * FATFS can't allocate new clusters to a file which has a link map.
+ */
+static void file_drop_link_map(vfs_fat_ctx_t* ctx, int fd, FSIZE_t end_pos)
+{
+    FIL* file = ctx->files[fd];
+    if (file->cltbl != NULL && end_pos > f_size(file)) {
+        free(file->cltbl);
+        file->cltbl = NULL;
+    }
+}
+#endif // FF_USE_FASTSEEK
+
 /**
  * @brief Prepend drive letters to path names
  * This function returns new path path pointers, pointing to a temporary buffer
@@ -308,11 +454,9 @@ static int vfs_fat_open(void* ctx, const char * path, int flags, int mode)
     int fd = get_next_fd(fat_ctx);
     if (fd < 0) {
         _lock_release(&fat_ctx->lock);
-        ESP_LOGE(TAG, "open: no free file descriptors");
-        errno = ENFILE;
         return -1;
     }
-    FRESULT res = f_open(&fat_ctx->files[fd], path, fat_mode_conv(flags));
+    FRESULT res = f_open(fat_ctx->files[fd], path, fat_mode_conv(flags));
     if (res != FR_OK) {
         file_cleanup(fat_ctx, fd);
         _lock_release(&fat_ctx->lock);
@@ -334,7 +478,7 @@ static int vfs_fat_open(void* ctx, const char * path, int flags, int mode)
 static ssize_t vfs_fat_write(void* ctx, int fd, const void * data, size_t size)
 {
     vfs_fat_ctx_t* fat_ctx = (vfs_fat_ctx_t*) ctx;
-    FIL* file = &fat_ctx->files[fd];
+    FIL* file = fat_ctx->files[fd];
     FRESULT res;
     if (fat_ctx->o_append[fd]) {
         if ((res = f_lseek(file, f_size(file))) != FR_OK) {
@@ -343,6 +487,9 @@ static ssize_t vfs_fat_write(void* ctx, int fd, const void * data, size_t size)
             return -1;
         }
     }
+#if FF_USE_FASTSEEK
+    file_drop_link_map(fat_ctx, fd, f_tell(file) + size);
+#endif
     unsigned written = 0;
     res = f_write(file, data, size, &written);
     if (res != FR_OK) {
@@ -358,7 +505,7 @@ static ssize_t vfs_fat_write(void* ctx, int fd, const void * data, size_t size)
 static ssize_t vfs_fat_read(void* ctx, int fd, void * dst, size_t size)
 {
     vfs_fat_ctx_t* fat_ctx = (vfs_fat_ctx_t*) ctx;
-    FIL* file = &fat_ctx->files[fd];
+    FIL* file = fat_ctx->files[fd];
     unsigned read = 0;
     FRESULT res = f_read(file, dst, size, &read);
     if (res != FR_OK) {
@@ -371,11 +518,126 @@ static ssize_t vfs_fat_read(void* ctx, int fd, void * dst, size_t size)
     return read;
 }
 
+static ssize_t vfs_fat_pread(void* ctx, int fd, void * dst, size_t size, off_t offset)
+{
+    vfs_fat_ctx_t* fat_ctx = (vfs_fat_ctx_t*) ctx;
+    FIL* file = fat_ctx->files[fd];
+    const FSIZE_t pos = f_tell(file);
+#if FF_USE_FASTSEEK
+    if (offset >= 0 && offset <= f_size(file) && offset != pos) {
+        file_create_link_map(fat_ctx, fd);
+    }
+#endif
+    FRESULT res = f_lseek(file, offset);
+    unsigned read = 0;
+    if (res == FR_OK) {
+        res = f_read(file, dst, size, &read);
+    }
+    // pread doesn't change the file position
+    const FRESULT seek_res = f_lseek(file, pos);
+    if (res == FR_OK) {
+        res = seek_res;
+    }
+    if (res != FR_OK) {
+        ESP_LOGD(TAG, "%s: fresult=%d", __func__, res);
+        errno = fresult_to_errno(res);
+        if (read == 0) {
+            return -1;
+        }
+    }
+    return read;
+}
+
+static ssize_t vfs_fat_pwrite(void* ctx, int fd, const void * src, size_t size, off_t offset)
+{
+    vfs_fat_ctx_t* fat_ctx = (vfs_fat_ctx_t*) ctx;
+    FIL* file = fat_ctx->files[fd];
+    const FSIZE_t pos = f_tell(file);
+#if FF_USE_FASTSEEK
+    file_drop_link_map(fat_ctx, fd, offset + size);
+#endif
+    FRESULT res = f_lseek(file, offset);
+    unsigned written = 0;
+    if (res == FR_OK) {
+        res = f_write(file, src, size, &written);
+    }
+    // pwrite doesn't change the file position
+    const FRESULT seek_res = f_lseek(file, pos);
+    if (res == FR_OK) {
+        res = seek_res;
+    }
+    if (res != FR_OK) {
+        ESP_LOGD(TAG, "%s: fresult=%d", __func__, res);
+        errno = fresult_to_errno(res);
+        if (written == 0) {
+            return -1;
+        }
+    }
+    return written;
+}
+
+static ssize_t vfs_fat_readv(void* ctx, int fd, const struct iovec * iov, int iovcnt)
+{
+    vfs_fat_ctx_t* fat_ctx = (vfs_fat_ctx_t*) ctx;
+    FIL* file = fat_ctx->files[fd];
+    ssize_t total = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        unsigned read = 0;
+        FRESULT res = f_read(file, iov[i].iov_base, iov[i].iov_len, &read);
+        total += read;
+        if (res != FR_OK) {
+            ESP_LOGD(TAG, "%s: fresult=%d", __func__, res);
+            errno = fresult_to_errno(res);
+            return (total > 0) ? total : -1;
+        }
+        if (read < iov[i].iov_len) {
+            break;
+        }
+    }
+    return total;
+}
+
+static ssize_t vfs_fat_writev(void* ctx, int fd, const struct iovec * iov, int iovcnt)
+{
+    vfs_fat_ctx_t* fat_ctx = (vfs_fat_ctx_t*) ctx;
+    FIL* file = fat_ctx->files[fd];
+    FRESULT res;
+    if (fat_ctx->o_append[fd]) {
+        if ((res = f_lseek(file, f_size(file))) != FR_OK) {
+            ESP_LOGD(TAG, "%s: fresult=%d", __func__, res);
+            errno = fresult_to_errno(res);
+            return -1;
+        }
+    }
+#if FF_USE_FASTSEEK
+    FSIZE_t end_pos = f_tell(file);
+    for (int i = 0; i < iovcnt; ++i) {
+        end_pos += iov[i].iov_len;
+    }
+    file_drop_link_map(fat_ctx, fd, end_pos);
+#endif
+    ssize_t total = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        unsigned written = 0;
+        res = f_write(file, iov[i].iov_base, iov[i].iov_len, &written);
+        total += written;
+        if (res != FR_OK) {
+            ESP_LOGD(TAG, "%s: fresult=%d", __func__, res);
+            errno = fresult_to_errno(res);
+            return (total > 0) ? total : -1;
+        }
+        if (written < iov[i].iov_len) {
+            break;
+        }
+    }
+    return total;
+}
+
 static int vfs_fat_fsync(void* ctx, int fd)
 {
     vfs_fat_ctx_t* fat_ctx = (vfs_fat_ctx_t*) ctx;
     _lock_acquire(&fat_ctx->lock);
-    FIL* file = &fat_ctx->files[fd];
+    FIL* file = fat_ctx->files[fd];
     FRESULT res = f_sync(file);
     _lock_release(&fat_ctx->lock);
     int rc = 0;
@@ -391,7 +653,7 @@ static int vfs_fat_close(void* ctx, int fd)
 {
     vfs_fat_ctx_t* fat_ctx = (vfs_fat_ctx_t*) ctx;
     _lock_acquire(&fat_ctx->lock);
-    FIL* file = &fat_ctx->files[fd];
+    FIL* file = fat_ctx->files[fd];
     FRESULT res = f_close(file);
     file_cleanup(fat_ctx, fd);
     _lock_release(&fat_ctx->lock);
@@ -407,7 +669,7 @@ static int vfs_fat_close(void* ctx, int fd)
 static off_t vfs_fat_lseek(void* ctx, int fd, off_t offset, int mode)
 {
     vfs_fat_ctx_t* fat_ctx = (vfs_fat_ctx_t*) ctx;
-    FIL* file = &fat_ctx->files[fd];
+    FIL* file = fat_ctx->files[fd];
     off_t new_pos;
     if (mode == SEEK_SET) {
         new_pos = offset;
@@ -421,6 +683,16 @@ static off_t vfs_fat_lseek(void* ctx, int fd, off_t offset, int mode)
         errno = EINVAL;
         return -1;
     }
+#if FF_USE_FASTSEEK
+    // A seek past the end of the file extends it, which the link map doesn't allow
+    if (new_pos >= 0 && new_pos <= f_size(file)) {
+        if (new_pos != f_tell(file)) {
+            file_create_link_map(fat_ctx, fd);
+        }
+    } else {
+        file_drop_link_map(fat_ctx, fd, new_pos);
+    }
+#endif
     FRESULT res = f_lseek(file, new_pos);
     if (res != FR_OK) {
         ESP_LOGD(TAG, "%s: fresult=%d", __func__, res);
@@ -433,7 +705,7 @@ static off_t vfs_fat_lseek(void* ctx, int fd, off_t offset, int mode)
 static int vfs_fat_fstat(void* ctx, int fd, struct stat * st)
 {
     vfs_fat_ctx_t* fat_ctx = (vfs_fat_ctx_t*) ctx;
-    FIL* file = &fat_ctx->files[fd];
+    FIL* file = fat_ctx->files[fd];
     st->st_size = f_size(file);
     st->st_mode = S_IRWXU | S_IRWXG | S_IRWXO | S_IFREG;
     st->st_mtime = 0;
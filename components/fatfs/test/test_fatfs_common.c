@@ -18,6 +18,8 @@
 #include <time.h>
 #include <sys/time.h>
 #include <sys/unistd.h>
+#include <sys/fcntl.h>
+#include <sys/uio.h>
 #include <errno.h>
 #include <utime.h>
 #include "unity.h"
@@ -139,6 +141,103 @@ void test_fatfs_lseek(const char* filename)
     TEST_ASSERT_EQUAL(0, fclose(f));
 }
 
+void test_fatfs_lseek_fragmented(const char* filename_prefix)
+{
+    const size_t chunk_size = 4096;
+    const size_t chunks = 16;
+    const size_t words = chunks * chunk_size / sizeof(uint32_t);
+    char name_a[64];
+    char name_b[64];
+    snprintf(name_a, sizeof(name_a), "%s_a.bin", filename_prefix);
+    snprintf(name_b, sizeof(name_b), "%s_b.bin", filename_prefix);
+    uint32_t* buf = malloc(chunk_size);
+    TEST_ASSERT_NOT_NULL(buf);
+
+    // interleave the writes to both files, for the cluster chain of each to be fragmented
+    FILE* fa = fopen(name_a, "wb+");
+    TEST_ASSERT_NOT_NULL(fa);
+    FILE* fb = fopen(name_b, "wb");
+    TEST_ASSERT_NOT_NULL(fb);
+    for (size_t c = 0; c < chunks; ++c) {
+        for (size_t i = 0; i < chunk_size / sizeof(uint32_t); ++i) {
+            buf[i] = c * chunk_size / sizeof(uint32_t) + i;
+        }
+        TEST_ASSERT_EQUAL(chunk_size, fwrite(buf, 1, chunk_size, fa));
+        TEST_ASSERT_EQUAL(0, fflush(fa));
+        TEST_ASSERT_EQUAL(chunk_size, fwrite(buf, 1, chunk_size, fb));
+        TEST_ASSERT_EQUAL(0, fflush(fb));
+    }
+    TEST_ASSERT_EQUAL(0, fclose(fb));
+
+    // seek back and forth
+    uint32_t val;
+    for (size_t n = 0; n < 64; ++n) {
+        size_t index = (n * 7919) % words;
+        TEST_ASSERT_EQUAL(0, fseek(fa, index * sizeof(uint32_t), SEEK_SET));
+        TEST_ASSERT_EQUAL(1, fread(&val, sizeof(val), 1, fa));
+        TEST_ASSERT_EQUAL(index, val);
+    }
+
+    // the file can still grow after seeking into it, by writing or by seeking past its end
+    TEST_ASSERT_EQUAL(0, fseek(fa, 0, SEEK_END));
+    val = words;
+    TEST_ASSERT_EQUAL(1, fwrite(&val, sizeof(val), 1, fa));
+    TEST_ASSERT_EQUAL(0, fseek(fa, 2 * chunk_size, SEEK_END));
+    val = words + 1;
+    TEST_ASSERT_EQUAL(1, fwrite(&val, sizeof(val), 1, fa));
+    TEST_ASSERT_EQUAL(0, fseek(fa, 7, SEEK_SET));
+    TEST_ASSERT_EQUAL(0, fseek(fa, words * sizeof(uint32_t), SEEK_SET));
+    TEST_ASSERT_EQUAL(1, fread(&val, sizeof(val), 1, fa));
+    TEST_ASSERT_EQUAL(words, val);
+    TEST_ASSERT_EQUAL(0, fseek(fa, -(long) sizeof(val), SEEK_END));
+    TEST_ASSERT_EQUAL(1, fread(&val, sizeof(val), 1, fa));
+    TEST_ASSERT_EQUAL(words + 1, val);
+    TEST_ASSERT_EQUAL((words + 2) * sizeof(uint32_t) + 2 * chunk_size, ftell(fa));
+
+    TEST_ASSERT_EQUAL(0, fclose(fa));
+    TEST_ASSERT_EQUAL(0, unlink(name_a));
+    TEST_ASSERT_EQUAL(0, unlink(name_b));
+    free(buf);
+}
+
+void test_fatfs_pread_pwrite_readv_writev(const char* filename)
+{
+    int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC);
+    TEST_ASSERT_NOT_EQUAL(-1, fd);
+
+    char a[] = "0123";
+    char b[] = "456789";
+    const struct iovec wr_iov[] = {
+        { .iov_base = a, .iov_len = 4 },
+        { .iov_base = NULL, .iov_len = 0 },
+        { .iov_base = b, .iov_len = 6 },
+    };
+    TEST_ASSERT_EQUAL(10, writev(fd, wr_iov, 3));
+    TEST_ASSERT_EQUAL(10, lseek(fd, 0, SEEK_CUR));
+
+    // pwrite and pread don't move the file position
+    TEST_ASSERT_EQUAL(2, pwrite(fd, "ab", 2, 3));
+    TEST_ASSERT_EQUAL(10, lseek(fd, 0, SEEK_CUR));
+    char buf[11] = { 0 };
+    TEST_ASSERT_EQUAL(4, pread(fd, buf, 4, 2));
+    TEST_ASSERT_EQUAL_STRING("2ab5", buf);
+    TEST_ASSERT_EQUAL(10, lseek(fd, 0, SEEK_CUR));
+    TEST_ASSERT_EQUAL(0, pread(fd, buf, 4, 10));
+
+    TEST_ASSERT_EQUAL(0, lseek(fd, 0, SEEK_SET));
+    memset(buf, 0, sizeof(buf));
+    const struct iovec rd_iov[] = {
+        { .iov_base = buf, .iov_len = 3 },
+        { .iov_base = buf + 3, .iov_len = 8 },
+    };
+    TEST_ASSERT_EQUAL(10, readv(fd, rd_iov, 2));
+    TEST_ASSERT_EQUAL_STRING("012ab56789", buf);
+
+    TEST_ASSERT_EQUAL(-1, pread(fd, buf, 1, -1));
+    TEST_ASSERT_EQUAL(EINVAL, errno);
+    TEST_ASSERT_EQUAL(0, close(fd));
+}
+
 void test_fatfs_truncate_file(const char* filename)
 {
     int read = 0;
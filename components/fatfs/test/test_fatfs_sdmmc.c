@@ -102,6 +102,20 @@ TEST_CASE("(SD) can lseek", "[fatfs][sd][test_env=UT_T1_SDMODE]")
     test_teardown();
 }
 
+TEST_CASE("(SD) can lseek in fragmented files", "[fatfs][sd][test_env=UT_T1_SDMODE]")
+{
+    test_setup();
+    test_fatfs_lseek_fragmented("/sdcard/frag");
+    test_teardown();
+}
+
+TEST_CASE("(SD) can do positional and vectored I/O", "[fatfs][sd][test_env=UT_T1_SDMODE]")
+{
+    test_setup();
+    test_fatfs_pread_pwrite_readv_writev("/sdcard/iov.txt");
+    test_teardown();
+}
+
 TEST_CASE("(SD) can truncate", "[fatfs][sd][test_env=UT_T1_SDMODE]")
 {
     test_setup();
@@ -18,10 +18,12 @@
 #include <time.h>
 #include <sys/time.h>
 #include <sys/unistd.h>
+#include <sys/fcntl.h>
 #include "unity.h"
 #include "test_utils.h"
 #include "esp_log.h"
 #include "esp_system.h"
+#include "esp_heap_caps.h"
 #include "esp_vfs.h"
 #include "esp_vfs_fat.h"
 #include "freertos/FreeRTOS.h"
@@ -82,6 +84,29 @@ TEST_CASE("(WL) can open maximum number of files", "[fatfs][wear_levelling]")
     TEST_ESP_OK(esp_vfs_fat_spiflash_unmount("/spiflash", s_test_wl_handle));
 }
 
+TEST_CASE("(WL) file structures are only allocated while files are open", "[fatfs][wear_levelling]")
+{
+    test_setup();
+    test_fatfs_create_file_with_text("/spiflash/hello.txt", fatfs_test_hello_str);
+
+    size_t free_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    int fd = open("/spiflash/hello.txt", O_RDONLY);
+    TEST_ASSERT_NOT_EQUAL(-1, fd);
+    TEST_ASSERT(free_before - heap_caps_get_free_size(MALLOC_CAP_8BIT) >= sizeof(FIL));
+    TEST_ASSERT_EQUAL(0, close(fd));
+    TEST_ASSERT_EQUAL(free_before, heap_caps_get_free_size(MALLOC_CAP_8BIT));
+
+    TEST_ESP_OK(esp_vfs_fat_set_file_caps("/spiflash", MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    free_before = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    fd = open("/spiflash/hello.txt", O_RDONLY);
+    TEST_ASSERT_NOT_EQUAL(-1, fd);
+    TEST_ASSERT(free_before - heap_caps_get_free_size(MALLOC_CAP_INTERNAL) >= sizeof(FIL));
+    TEST_ASSERT_EQUAL(0, close(fd));
+    TEST_ESP_OK(esp_vfs_fat_set_file_caps("/spiflash", 0));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, esp_vfs_fat_set_file_caps("/nonexistent", 0));
+    test_teardown();
+}
+
 TEST_CASE("(WL) overwrite and append file", "[fatfs][wear_levelling]")
 {
     test_setup();
@@ -96,6 +121,20 @@ TEST_CASE("(WL) can lseek", "[fatfs][wear_levelling]")
     test_teardown();
 }
 
+TEST_CASE("(WL) can lseek in fragmented files", "[fatfs][wear_levelling]")
+{
+    test_setup();
+    test_fatfs_lseek_fragmented("/spiflash/frag");
+    test_teardown();
+}
+
+TEST_CASE("(WL) can do positional and vectored I/O", "[fatfs][wear_levelling]")
+{
+    test_setup();
+    test_fatfs_pread_pwrite_readv_writev("/spiflash/iov.txt");
+    test_teardown();
+}
+
 TEST_CASE("(WL) can truncate", "[fatfs][wear_levelling]")
 {
     test_setup();
@@ -0,0 +1,668 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// mbcontroller_master.c
+// Implementation of the Modbus RTU master controller
+// The master sends requests to slaves and waits for responses. The end of response frame
+// is detected by the UART RX TOUT interrupt (line is idle for ~3.5 characters) or when
+// the expected number of bytes is received, so no protocol timer is needed.
+// Poll list is converted into a minimal set of read requests which are executed
+// back to back by the poll task.
+
+#include <stdlib.h>                 // for qsort
+#include <string.h>                 // for memcpy
+#include <sys/param.h>              // for MIN/MAX
+#include "esp_log.h"                // for log_write
+#include "esp_timer.h"              // for esp_timer_get_time
+#include "esp32/rom/ets_sys.h"      // for ets_delay_us
+#include "freertos/FreeRTOS.h"      // for task creation and queue access
+#include "freertos/task.h"          // for task api access
+#include "freertos/semphr.h"        // for bus mutex
+#include "freertos/event_groups.h"  // for event groups
+#include "freertos/queue.h"         // for queue api access
+#include "mb.h"                     // for mb types definition
+#include "mbcrc.h"                  // for CRC calculation
+#include "sdkconfig.h"              // for KConfig values
+#include "mbcontroller_master.h"
+
+static const char* TAG = "MB_MASTER";
+
+#define MB_CHECK(a, ret_val, str, ...) \
+    if (!(a)) { \
+        ESP_LOGE(TAG, "%s(%u): " str, __FUNCTION__, __LINE__, ##__VA_ARGS__); \
+        return (ret_val); \
+    }
+
+#define MB_MASTER_FRAME_SIZE_MAX        (256)   // Maximal size of RTU frame
+#define MB_MASTER_EXCEPTION_SIZE        (5)     // Size of exception response: address, function, code, CRC
+#define MB_MASTER_WRITE_RESP_SIZE       (8)     // Size of write response: address, function, address, value, CRC
+#define MB_MASTER_SERIAL_TOUT           (3)     // RX TOUT in characters, ~T3.5 (see portserial.c)
+#define MB_MASTER_SLAVE_ADDR_MAX        (247)
+
+#define MB_FUNC_EXCEPTION_BIT           (0x80)
+
+#define MB_MASTER_EVENT_CYCLE_DONE      (BIT0)
+#define MB_MASTER_EVENT_POLL_STOPPED    (BIT1)
+
+// One read request of the poll cycle, covers items [first_item, first_item + items_num)
+typedef struct {
+    uint8_t slave_addr;
+    mb_param_type_t type;
+    uint16_t reg_start;
+    uint16_t reg_size;
+    uint16_t first_item;
+    uint16_t items_num;
+} mb_master_poll_req_t;
+
+typedef struct {
+    uint8_t slave_addr;                     // 0 - free entry
+    uint32_t requests;
+    uint32_t errors;
+    uint32_t timeouts;
+    uint32_t latency_min_us;
+    uint32_t latency_max_us;
+    uint64_t latency_sum_us;
+} mb_master_stats_entry_t;
+
+typedef struct {
+    mb_communication_info_t comm;
+    bool started;
+    QueueHandle_t uart_queue;
+    SemaphoreHandle_t bus_lock;             // serializes transactions of the poll task and application
+    EventGroupHandle_t event_group;
+    int64_t last_frame_us;                  // end of the last frame on the bus
+    uint32_t t35_us;                        // silent interval between frames
+    uint8_t frame[MB_MASTER_FRAME_SIZE_MAX];
+    uint8_t resp[MB_MASTER_FRAME_SIZE_MAX];
+    // poll list
+    TaskHandle_t poll_task;
+    volatile bool poll_stop;
+    uint32_t poll_period_ms;
+    mb_master_poll_item_t* poll_items;
+    mb_master_poll_req_t* poll_reqs;
+    size_t poll_reqs_num;
+    // statistics
+    mb_master_stats_entry_t* stats;
+    portMUX_TYPE stats_lock;
+} mb_master_t;
+
+static mb_master_t* s_master = NULL;
+
+static bool master_type_is_bits(mb_param_type_t type)
+{
+    return (type == MB_PARAM_COIL) || (type == MB_PARAM_DISCRETE);
+}
+
+static uint8_t master_read_func(mb_param_type_t type)
+{
+    switch (type) {
+        case MB_PARAM_HOLDING:
+            return MB_FUNC_READ_HOLDING_REGISTER;
+        case MB_PARAM_INPUT:
+            return MB_FUNC_READ_INPUT_REGISTER;
+        case MB_PARAM_COIL:
+            return MB_FUNC_READ_COILS;
+        default:
+            return MB_FUNC_READ_DISCRETE_INPUTS;
+    }
+}
+
+// Size of data in response or write request (bytes)
+static uint16_t master_data_size(mb_param_type_t type, uint16_t reg_size)
+{
+    return master_type_is_bits(type) ? (reg_size + 7) / 8 : reg_size * 2;
+}
+
+static void master_stats_update(uint8_t slave_addr, esp_err_t err, uint32_t latency_us)
+{
+    mb_master_stats_entry_t* entry = NULL;
+
+    portENTER_CRITICAL(&s_master->stats_lock);
+    for (int i = 0; i < MB_MASTER_STATS_SLAVES; i++) {
+        if (s_master->stats[i].slave_addr == slave_addr) {
+            entry = &s_master->stats[i];
+            break;
+        }
+        if (s_master->stats[i].slave_addr == 0) {
+            // entries are allocated in order, so the slave is not in the table
+            entry = &s_master->stats[i];
+            entry->slave_addr = slave_addr;
+            entry->latency_min_us = UINT32_MAX;
+            break;
+        }
+    }
+    if (entry != NULL) {
+        entry->requests++;
+        if (err == ESP_ERR_TIMEOUT) {
+            entry->timeouts++;
+        } else if (err != ESP_OK) {
+            entry->errors++;
+        } else {
+            entry->latency_sum_us += latency_us;
+            entry->latency_min_us = MIN(entry->latency_min_us, latency_us);
+            entry->latency_max_us = MAX(entry->latency_max_us, latency_us);
+        }
+    }
+    portEXIT_CRITICAL(&s_master->stats_lock);
+}
+
+// Sends request in s_master->frame and receives response into s_master->resp, called with bus lock taken
+static esp_err_t master_transaction(size_t req_len, size_t resp_expected, size_t* resp_len, uint32_t* latency_us)
+{
+    uart_port_t port = s_master->comm.port;
+    uart_event_t event;
+    size_t pos = 0;
+    bool rx_error = false;
+    esp_err_t err = ESP_ERR_TIMEOUT;
+
+    USHORT crc = usMBCRC16(s_master->frame, req_len);
+    s_master->frame[req_len++] = (uint8_t)(crc & 0xFF);
+    s_master->frame[req_len++] = (uint8_t)(crc >> 8);
+
+    // Response completed by length is not followed by the RX TOUT, so keep the silent interval here
+    int64_t idle_us = esp_timer_get_time() - s_master->last_frame_us;
+    if (idle_us < s_master->t35_us) {
+        ets_delay_us(s_master->t35_us - idle_us);
+    }
+    // Drop late responses and noise received since the last transaction
+    uart_flush_input(port);
+    xQueueReset(s_master->uart_queue);
+
+    int64_t start_us = esp_timer_get_time();
+    uart_write_bytes(port, (const char*)s_master->frame, req_len);
+    TickType_t timeout = pdMS_TO_TICKS(MB_MASTER_RESPONSE_TIMEOUT);
+    if (uart_wait_tx_done(port, timeout) != ESP_OK) {
+        ESP_LOGD(TAG, "request transmission timeout");
+        s_master->last_frame_us = esp_timer_get_time();
+        return ESP_ERR_TIMEOUT;
+    }
+    // Response timeout is counted from the end of the request
+    TickType_t start_tick = xTaskGetTickCount();
+    for (;;) {
+        TickType_t elapsed = xTaskGetTickCount() - start_tick;
+        if (elapsed >= timeout
+                || xQueueReceive(s_master->uart_queue, &event, timeout - elapsed) != pdTRUE) {
+            break;
+        }
+        if (event.type == UART_DATA) {
+            size_t len = MIN(event.size, sizeof(s_master->resp) - pos);
+            int read = uart_read_bytes(port, &s_master->resp[pos], len, 0);
+            if (read > 0) {
+                pos += read;
+            }
+            if ((pos >= resp_expected)
+                    || ((pos >= MB_MASTER_EXCEPTION_SIZE) && (s_master->resp[1] & MB_FUNC_EXCEPTION_BIT))
+                    || (event.timeout_flag && (pos > 0))) {
+                err = ESP_OK;
+                break;
+            }
+        } else if ((event.type == UART_FIFO_OVF) || (event.type == UART_BUFFER_FULL)) {
+            ESP_LOGD(TAG, "rx overflow, event: %d", event.type);
+            uart_flush_input(port);
+            err = ESP_ERR_INVALID_RESPONSE;
+            break;
+        } else if ((event.type == UART_FRAME_ERR) || (event.type == UART_PARITY_ERR)) {
+            ESP_LOGD(TAG, "rx frame or parity error, event: %d", event.type);
+            rx_error = true;
+        }
+    }
+    s_master->last_frame_us = esp_timer_get_time();
+    *latency_us = (uint32_t)(s_master->last_frame_us - start_us);
+    *resp_len = pos;
+    if ((err == ESP_ERR_TIMEOUT && pos > 0) || (err == ESP_OK && rx_error)) {
+        // part of the frame has been received or it is corrupted
+        err = ESP_ERR_INVALID_RESPONSE;
+    }
+    return err;
+}
+
+// Executes request, checks the response header and CRC, called with bus lock taken
+static esp_err_t master_request(uint8_t slave_addr, size_t req_len, size_t resp_expected)
+{
+    size_t resp_len = 0;
+    uint32_t latency_us = 0;
+    uint8_t func = s_master->frame[1];
+
+    esp_err_t err = master_transaction(req_len, resp_expected, &resp_len, &latency_us);
+    if (err == ESP_OK) {
+        uint8_t* resp = s_master->resp;
+        if (resp_len < MB_MASTER_EXCEPTION_SIZE || usMBCRC16(resp, resp_len) != 0) {
+            ESP_LOGD(TAG, "slave %d: response CRC error, length %d", slave_addr, (int)resp_len);
+            err = ESP_ERR_INVALID_CRC;
+        } else if (resp[0] != slave_addr) {
+            ESP_LOGD(TAG, "slave %d: response from slave %d", slave_addr, resp[0]);
+            err = ESP_ERR_INVALID_RESPONSE;
+        } else if (resp[1] == (func | MB_FUNC_EXCEPTION_BIT)) {
+            ESP_LOGD(TAG, "slave %d: exception 0x%x for function 0x%x", slave_addr, resp[2], func);
+            err = ESP_ERR_NOT_SUPPORTED;
+        } else if (resp[1] != func || resp_len != resp_expected) {
+            ESP_LOGD(TAG, "slave %d: unexpected response, function 0x%x, length %d",
+                        slave_addr, resp[1], (int)resp_len);
+            err = ESP_ERR_INVALID_RESPONSE;
+        }
+    }
+    master_stats_update(slave_addr, err, latency_us);
+    return err;
+}
+
+// Sends read request, the data is left in s_master->resp at offset 3
+static esp_err_t master_read_regs(uint8_t slave_addr, mb_param_type_t type,
+                                    uint16_t reg_start, uint16_t reg_size)
+{
+    uint8_t* frame = s_master->frame;
+    uint16_t data_size = master_data_size(type, reg_size);
+
+    frame[0] = slave_addr;
+    frame[1] = master_read_func(type);
+    frame[2] = (uint8_t)(reg_start >> 8);
+    frame[3] = (uint8_t)(reg_start & 0xFF);
+    frame[4] = (uint8_t)(reg_size >> 8);
+    frame[5] = (uint8_t)(reg_size & 0xFF);
+    esp_err_t err = master_request(slave_addr, 6, data_size + 5);
+    if (err == ESP_OK && s_master->resp[2] != data_size) {
+        ESP_LOGD(TAG, "slave %d: incorrect byte count %d", slave_addr, s_master->resp[2]);
+        err = ESP_ERR_INVALID_RESPONSE;
+    }
+    return err;
+}
+
+// Copies reg_size values starting from offset in response data into the storage
+static void master_copy_data(mb_param_type_t type, const uint8_t* src, uint16_t offset,
+                                uint16_t reg_size, void* dst)
+{
+    if (master_type_is_bits(type)) {
+        uint8_t* bits = (uint8_t*)dst;
+        for (uint16_t i = 0; i < reg_size; i++) {
+            uint16_t bit = offset + i;
+            if (src[bit >> 3] & (1 << (bit & 7))) {
+                bits[i >> 3] |= (1 << (i & 7));
+            } else {
+                bits[i >> 3] &= ~(1 << (i & 7));
+            }
+        }
+    } else {
+        uint16_t* regs = (uint16_t*)dst;
+        src += offset * 2;
+        for (uint16_t i = 0; i < reg_size; i++, src += 2) {
+            regs[i] = (src[0] << 8) | src[1];
+        }
+    }
+}
+
+static bool master_check_regs(uint8_t slave_addr, mb_param_type_t type, uint16_t reg_start,
+                                uint16_t reg_size, uint16_t max_size)
+{
+    return (slave_addr > 0) && (slave_addr <= MB_MASTER_SLAVE_ADDR_MAX)
+            && (type < MB_PARAM_COUNT)
+            && (reg_size > 0) && (reg_size <= max_size)
+            && ((uint32_t)reg_start + reg_size <= UINT16_MAX + 1);
+}
+
+esp_err_t mbcontroller_master_read(uint8_t slave_addr, mb_param_type_t type,
+                                    uint16_t reg_start, uint16_t reg_size, void* data)
+{
+    MB_CHECK((s_master != NULL && s_master->started), ESP_ERR_INVALID_STATE, "mb master is not started.");
+    MB_CHECK((data != NULL), ESP_ERR_INVALID_ARG, "mb data pointer is NULL.");
+    MB_CHECK(master_check_regs(slave_addr, type, reg_start, reg_size,
+                master_type_is_bits(type) ? MB_MASTER_MAX_READ_BITS : MB_MASTER_MAX_READ_REGS),
+                ESP_ERR_INVALID_ARG, "mb incorrect request, slave %d, type %d, start %d, size %d.",
+                slave_addr, type, reg_start, reg_size);
+
+    xSemaphoreTake(s_master->bus_lock, portMAX_DELAY);
+    esp_err_t err = master_read_regs(slave_addr, type, reg_start, reg_size);
+    if (err == ESP_OK) {
+        master_copy_data(type, &s_master->resp[3], 0, reg_size, data);
+    }
+    xSemaphoreGive(s_master->bus_lock);
+    return err;
+}
+
+esp_err_t mbcontroller_master_write(uint8_t slave_addr, mb_param_type_t type,
+                                    uint16_t reg_start, uint16_t reg_size, const void* data)
+{
+    MB_CHECK((s_master != NULL && s_master->started), ESP_ERR_INVALID_STATE, "mb master is not started.");
+    MB_CHECK((data != NULL), ESP_ERR_INVALID_ARG, "mb data pointer is NULL.");
+    MB_CHECK(((type == MB_PARAM_HOLDING) || (type == MB_PARAM_COIL)), ESP_ERR_INVALID_ARG,
+                "mb registers of type %d are read only.", type);
+    MB_CHECK(master_check_regs(slave_addr, type, reg_start, reg_size,
+                (type == MB_PARAM_COIL) ? MB_MASTER_MAX_WRITE_BITS : MB_MASTER_MAX_WRITE_REGS),
+                ESP_ERR_INVALID_ARG, "mb incorrect request, slave %d, type %d, start %d, size %d.",
+                slave_addr, type, reg_start, reg_size);
+
+    xSemaphoreTake(s_master->bus_lock, portMAX_DELAY);
+    uint8_t* frame = s_master->frame;
+    size_t len = 0;
+    frame[len++] = slave_addr;
+    frame[len++] = 0; // function code
+    frame[len++] = (uint8_t)(reg_start >> 8);
+    frame[len++] = (uint8_t)(reg_start & 0xFF);
+    if (reg_size == 1) {
+        uint16_t value;
+        if (type == MB_PARAM_COIL) {
+            frame[1] = MB_FUNC_WRITE_SINGLE_COIL;
+            value = (*(const uint8_t*)data & 1) ? 0xFF00 : 0x0000;
+        } else {
+            frame[1] = MB_FUNC_WRITE_REGISTER;
+            value = *(const uint16_t*)data;
+        }
+        frame[len++] = (uint8_t)(value >> 8);
+        frame[len++] = (uint8_t)(value & 0xFF);
+    } else {
+        uint16_t data_size = master_data_size(type, reg_size);
+        frame[1] = (type == MB_PARAM_COIL) ? MB_FUNC_WRITE_MULTIPLE_COILS : MB_FUNC_WRITE_MULTIPLE_REGISTERS;
+        frame[len++] = (uint8_t)(reg_size >> 8);
+        frame[len++] = (uint8_t)(reg_size & 0xFF);
+        frame[len++] = (uint8_t)data_size;
+        if (type == MB_PARAM_COIL) {
+            memcpy(&frame[len], data, data_size);
+            len += data_size;
+        } else {
+            const uint16_t* regs = (const uint16_t*)data;
+            for (uint16_t i = 0; i < reg_size; i++) {
+                frame[len++] = (uint8_t)(regs[i] >> 8);
+                frame[len++] = (uint8_t)(regs[i] & 0xFF);
+            }
+        }
+    }
+    // the response echoes address and value (single write) or address and quantity (multiple write)
+    uint8_t echo[4];
+    memcpy(echo, &frame[2], sizeof(echo));
+    esp_err_t err = master_request(slave_addr, len, MB_MASTER_WRITE_RESP_SIZE);
+    if (err == ESP_OK && memcmp(echo, &s_master->resp[2], sizeof(echo)) != 0) {
+        ESP_LOGD(TAG, "slave %d: write response does not match request", slave_addr);
+        err = ESP_ERR_INVALID_RESPONSE;
+    }
+    xSemaphoreGive(s_master->bus_lock);
+    return err;
+}
+
+static void master_poll_task(void* param)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (!s_master->poll_stop) {
+        for (size_t r = 0; r < s_master->poll_reqs_num && !s_master->poll_stop; r++) {
+            const mb_master_poll_req_t* req = &s_master->poll_reqs[r];
+            // bus is released between requests, so application requests are not delayed by whole cycle
+            xSemaphoreTake(s_master->bus_lock, portMAX_DELAY);
+            esp_err_t err = master_read_regs(req->slave_addr, req->type, req->reg_start, req->reg_size);
+            if (err == ESP_OK) {
+                for (uint16_t i = 0; i < req->items_num; i++) {
+                    const mb_master_poll_item_t* item = &s_master->poll_items[req->first_item + i];
+                    master_copy_data(item->type, &s_master->resp[3], item->reg_start - req->reg_start,
+                                        item->reg_size, item->data);
+                }
+            } else {
+                ESP_LOGD(TAG, "poll of slave %d, start %d, size %d failed (0x%x).",
+                            req->slave_addr, req->reg_start, req->reg_size, err);
+            }
+            xSemaphoreGive(s_master->bus_lock);
+        }
+        xEventGroupSetBits(s_master->event_group, MB_MASTER_EVENT_CYCLE_DONE);
+        if (s_master->poll_period_ms) {
+            TickType_t period = pdMS_TO_TICKS(s_master->poll_period_ms);
+            if (xTaskGetTickCount() - last_wake >= period) {
+                // cycle is longer than the period, do not try to catch up
+                last_wake = xTaskGetTickCount();
+            } else {
+                vTaskDelayUntil(&last_wake, period);
+            }
+        } else {
+            // let lower priority tasks run between cycles
+            vTaskDelay(1);
+        }
+    }
+    xEventGroupSetBits(s_master->event_group, MB_MASTER_EVENT_POLL_STOPPED);
+    vTaskDelete(NULL);
+}
+
+static int master_poll_item_cmp(const void* a, const void* b)
+{
+    const mb_master_poll_item_t* x = (const mb_master_poll_item_t*)a;
+    const mb_master_poll_item_t* y = (const mb_master_poll_item_t*)b;
+    if (x->slave_addr != y->slave_addr) {
+        return x->slave_addr - y->slave_addr;
+    }
+    if (x->type != y->type) {
+        return (int)x->type - (int)y->type;
+    }
+    return (int)x->reg_start - (int)y->reg_start;
+}
+
+// Sorts items and merges the ones of the same slave and type into requests
+static size_t master_poll_build(mb_master_poll_item_t* items, size_t count, mb_master_poll_req_t* reqs)
+{
+    size_t reqs_num = 0;
+    mb_master_poll_req_t* req = NULL;
+
+    qsort(items, count, sizeof(mb_master_poll_item_t), master_poll_item_cmp);
+    for (size_t i = 0; i < count; i++) {
+        const mb_master_poll_item_t* item = &items[i];
+        uint32_t item_end = (uint32_t)item->reg_start + item->reg_size;
+        if (req != NULL && req->slave_addr == item->slave_addr && req->type == item->type) {
+            uint32_t req_end = (uint32_t)req->reg_start + req->reg_size;
+            uint32_t new_size = MAX(req_end, item_end) - req->reg_start;
+            uint32_t max_size = master_type_is_bits(item->type) ? MB_MASTER_MAX_READ_BITS : MB_MASTER_MAX_READ_REGS;
+            if (item->reg_start <= req_end + MB_MASTER_POLL_MERGE_GAP && new_size <= max_size) {
+                req->reg_size = new_size;
+                req->items_num++;
+                continue;
+            }
+        }
+        req = &reqs[reqs_num++];
+        req->slave_addr = item->slave_addr;
+        req->type = item->type;
+        req->reg_start = item->reg_start;
+        req->reg_size = item->reg_size;
+        req->first_item = i;
+        req->items_num = 1;
+    }
+    return reqs_num;
+}
+
+static void master_poll_free(void)
+{
+    free(s_master->poll_items);
+    free(s_master->poll_reqs);
+    s_master->poll_items = NULL;
+    s_master->poll_reqs = NULL;
+    s_master->poll_reqs_num = 0;
+}
+
+esp_err_t mbcontroller_master_poll_start(const mb_master_poll_item_t* items, size_t count, uint32_t period_ms)
+{
+    MB_CHECK((s_master != NULL && s_master->started), ESP_ERR_INVALID_STATE, "mb master is not started.");
+    MB_CHECK((s_master->poll_task == NULL), ESP_ERR_INVALID_STATE, "mb polling is already running.");
+    MB_CHECK((items != NULL && count > 0 && count <= UINT16_MAX), ESP_ERR_INVALID_ARG, "mb incorrect poll list.");
+    for (size_t i = 0; i < count; i++) {
+        MB_CHECK((items[i].data != NULL), ESP_ERR_INVALID_ARG, "mb poll item %d data pointer is NULL.", (int)i);
+        MB_CHECK(master_check_regs(items[i].slave_addr, items[i].type, items[i].reg_start, items[i].reg_size,
+                    master_type_is_bits(items[i].type) ? MB_MASTER_MAX_READ_BITS : MB_MASTER_MAX_READ_REGS),
+                    ESP_ERR_INVALID_ARG, "mb incorrect poll item %d.", (int)i);
+    }
+
+    s_master->poll_items = malloc(count * sizeof(mb_master_poll_item_t));
+    s_master->poll_reqs = malloc(count * sizeof(mb_master_poll_req_t));
+    if (s_master->poll_items == NULL || s_master->poll_reqs == NULL) {
+        master_poll_free();
+        MB_CHECK(false, ESP_ERR_NO_MEM, "mb poll list allocation error.");
+    }
+    memcpy(s_master->poll_items, items, count * sizeof(mb_master_poll_item_t));
+    s_master->poll_reqs_num = master_poll_build(s_master->poll_items, count, s_master->poll_reqs);
+    ESP_LOGD(TAG, "%d poll items merged into %d requests", (int)count, (int)s_master->poll_reqs_num);
+
+    s_master->poll_period_ms = period_ms;
+    s_master->poll_stop = false;
+    xEventGroupClearBits(s_master->event_group, MB_MASTER_EVENT_CYCLE_DONE | MB_MASTER_EVENT_POLL_STOPPED);
+    BaseType_t status = xTaskCreate(master_poll_task, "mb_master_poll", MB_CONTROLLER_STACK_SIZE,
+                                    NULL, MB_CONTROLLER_PRIORITY, &s_master->poll_task);
+    if (status != pdPASS) {
+        s_master->poll_task = NULL;
+        master_poll_free();
+        MB_CHECK(false, ESP_ERR_NO_MEM, "mb poll task creation error, xTaskCreate() returns (0x%x).",
+                    (uint32_t)status);
+    }
+    return ESP_OK;
+}
+
+esp_err_t mbcontroller_master_poll_wait(uint32_t timeout)
+{
+    MB_CHECK((s_master != NULL && s_master->poll_task != NULL), ESP_ERR_INVALID_STATE, "mb polling is not running.");
+    xEventGroupClearBits(s_master->event_group, MB_MASTER_EVENT_CYCLE_DONE);
+    EventBits_t bits = xEventGroupWaitBits(s_master->event_group, MB_MASTER_EVENT_CYCLE_DONE,
+                                            pdTRUE, pdFALSE, pdMS_TO_TICKS(timeout));
+    return (bits & MB_MASTER_EVENT_CYCLE_DONE) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t mbcontroller_master_poll_stop(void)
+{
+    MB_CHECK((s_master != NULL && s_master->poll_task != NULL), ESP_ERR_INVALID_STATE, "mb polling is not running.");
+    s_master->poll_stop = true;
+    xEventGroupWaitBits(s_master->event_group, MB_MASTER_EVENT_POLL_STOPPED, pdTRUE, pdFALSE, portMAX_DELAY);
+    s_master->poll_task = NULL;
+    master_poll_free();
+    return ESP_OK;
+}
+
+esp_err_t mbcontroller_master_get_slave_stats(uint8_t slave_addr, mb_master_slave_stats_t* stats)
+{
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+    MB_CHECK((s_master != NULL), ESP_ERR_INVALID_STATE, "mb master is not initialized.");
+    MB_CHECK((stats != NULL && slave_addr != 0), ESP_ERR_INVALID_ARG, "mb incorrect argument.");
+
+    portENTER_CRITICAL(&s_master->stats_lock);
+    for (int i = 0; i < MB_MASTER_STATS_SLAVES && s_master->stats[i].slave_addr != 0; i++) {
+        const mb_master_stats_entry_t* entry = &s_master->stats[i];
+        if (entry->slave_addr == slave_addr) {
+            uint32_t responses = entry->requests - entry->errors - entry->timeouts;
+            stats->requests = entry->requests;
+            stats->errors = entry->errors;
+            stats->timeouts = entry->timeouts;
+            stats->latency_min_us = responses ? entry->latency_min_us : 0;
+            stats->latency_max_us = entry->latency_max_us;
+            stats->latency_avg_us = responses ? (uint32_t)(entry->latency_sum_us / responses) : 0;
+            err = ESP_OK;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_master->stats_lock);
+    return err;
+}
+
+void mbcontroller_master_reset_stats(void)
+{
+    if (s_master != NULL) {
+        portENTER_CRITICAL(&s_master->stats_lock);
+        memset(s_master->stats, 0, MB_MASTER_STATS_SLAVES * sizeof(mb_master_stats_entry_t));
+        portEXIT_CRITICAL(&s_master->stats_lock);
+    }
+}
+
+esp_err_t mbcontroller_master_setup(mb_communication_info_t comm_info)
+{
+    MB_CHECK((s_master != NULL), ESP_ERR_INVALID_STATE, "mb master is not initialized.");
+    MB_CHECK((!s_master->started), ESP_ERR_INVALID_STATE, "mb master is already started.");
+    MB_CHECK((comm_info.mode == MB_MODE_RTU), ESP_ERR_INVALID_ARG,
+                "mb incorrect mode = (0x%x), only RTU is supported by master.", (uint32_t)comm_info.mode);
+    MB_CHECK((comm_info.port < UART_NUM_MAX), ESP_ERR_INVALID_ARG,
+                "mb wrong port to set = (0x%x).", (uint32_t)comm_info.port);
+    MB_CHECK((comm_info.parity <= UART_PARITY_EVEN), ESP_ERR_INVALID_ARG,
+                "mb wrong parity option = (0x%x).", (uint32_t)comm_info.parity);
+    MB_CHECK((comm_info.baudrate > 0), ESP_ERR_INVALID_ARG, "mb wrong baudrate.");
+    s_master->comm = comm_info;
+    // 3.5 characters of 11 bits, fixed 1750 uS for baudrates above 19200 (Modbus over serial line spec.)
+    s_master->t35_us = (comm_info.baudrate > 19200) ? 1750 : (35 * 11 * 1000000UL) / (10 * comm_info.baudrate);
+    return ESP_OK;
+}
+
+esp_err_t mbcontroller_master_start(void)
+{
+    MB_CHECK((s_master != NULL), ESP_ERR_INVALID_STATE, "mb master is not initialized.");
+    MB_CHECK((!s_master->started), ESP_ERR_INVALID_STATE, "mb master is already started.");
+    uart_port_t port = s_master->comm.port;
+    uart_config_t uart_config = {
+        .baud_rate = s_master->comm.baudrate,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = s_master->comm.parity,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .rx_flow_ctrl_thresh = 2,
+    };
+    esp_err_t err = uart_param_config(port, &uart_config);
+    MB_CHECK((err == ESP_OK), err, "mb config failure, uart_param_config() returned (0x%x).", (uint32_t)err);
+    err = uart_driver_install(port, CONFIG_MB_SERIAL_BUF_SIZE, CONFIG_MB_SERIAL_BUF_SIZE,
+                                CONFIG_MB_QUEUE_LENGTH, &s_master->uart_queue, ESP_INTR_FLAG_LOWMED);
+    MB_CHECK((err == ESP_OK), err, "mb serial driver failure, uart_driver_install() returned (0x%x).",
+                (uint32_t)err);
+    // TOUT interrupt marks the end of response frame
+    err = uart_set_rx_timeout(port, MB_MASTER_SERIAL_TOUT);
+    if (err != ESP_OK) {
+        uart_driver_delete(port);
+        MB_CHECK(false, err, "mb serial set rx timeout failure, uart_set_rx_timeout() returned (0x%x).",
+                    (uint32_t)err);
+    }
+    s_master->last_frame_us = esp_timer_get_time();
+    s_master->started = true;
+    return ESP_OK;
+}
+
+esp_err_t mbcontroller_master_init(void)
+{
+    MB_CHECK((s_master == NULL), ESP_ERR_INVALID_STATE, "mb master is already initialized.");
+    s_master = calloc(1, sizeof(mb_master_t));
+    MB_CHECK((s_master != NULL), ESP_ERR_NO_MEM, "mb master allocation error.");
+    s_master->stats = calloc(MB_MASTER_STATS_SLAVES, sizeof(mb_master_stats_entry_t));
+    s_master->bus_lock = xSemaphoreCreateMutex();
+    s_master->event_group = xEventGroupCreate();
+    if (s_master->stats == NULL || s_master->bus_lock == NULL || s_master->event_group == NULL) {
+        if (s_master->bus_lock) {
+            vSemaphoreDelete(s_master->bus_lock);
+        }
+        if (s_master->event_group) {
+            vEventGroupDelete(s_master->event_group);
+        }
+        free(s_master->stats);
+        free(s_master);
+        s_master = NULL;
+        MB_CHECK(false, ESP_ERR_NO_MEM, "mb master resources allocation error.");
+    }
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    s_master->stats_lock = lock;
+    s_master->comm.mode = MB_MODE_RTU;
+    s_master->comm.port = MB_UART_PORT;
+    s_master->comm.parity = MB_PARITY_NONE;
+    s_master->comm.baudrate = MB_DEVICE_SPEED;
+    s_master->t35_us = 1750;
+    return ESP_OK;
+}
+
+esp_err_t mbcontroller_master_destroy(void)
+{
+    MB_CHECK((s_master != NULL), ESP_ERR_INVALID_STATE, "mb master is not initialized.");
+    if (s_master->poll_task != NULL) {
+        mbcontroller_master_poll_stop();
+    }
+    if (s_master->started) {
+        // wait for application request in progress
+        xSemaphoreTake(s_master->bus_lock, portMAX_DELAY);
+        uart_driver_delete(s_master->comm.port);
+        xSemaphoreGive(s_master->bus_lock);
+    }
+    vSemaphoreDelete(s_master->bus_lock);
+    vEventGroupDelete(s_master->event_group);
+    free(s_master->stats);
+    free(s_master);
+    s_master = NULL;
+    return ESP_OK;
+}
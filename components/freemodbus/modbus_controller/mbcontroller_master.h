@@ -0,0 +1,204 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//  mbcontroller_master.h
+//  Implementation of the Modbus RTU master controller
+
+#ifndef _MODBUS_CONTROLLER_MASTER
+#define _MODBUS_CONTROLLER_MASTER
+
+#include <stdint.h>                 // for standard int types definition
+#include <stddef.h>                 // for NULL and std defines
+#include "sdkconfig.h"              // for KConfig options
+#include "mbcontroller.h"           // for common Modbus controller types
+
+/* ----------------------- Defines ------------------------------------------*/
+#define MB_MASTER_RESPONSE_TIMEOUT      (CONFIG_MB_MASTER_RESPONSE_TIMEOUT) // Slave response timeout (ms)
+#define MB_MASTER_STATS_SLAVES          (CONFIG_MB_MASTER_STATS_SLAVES) // Number of slaves statistics is kept for
+#define MB_MASTER_POLL_MERGE_GAP        (CONFIG_MB_MASTER_POLL_MERGE_GAP) // Max gap between merged poll items
+
+#define MB_MASTER_MAX_READ_REGS         (125)   // Max number of registers in one read request
+#define MB_MASTER_MAX_READ_BITS         (2000)  // Max number of coils or discrete inputs in one read request
+#define MB_MASTER_MAX_WRITE_REGS        (123)   // Max number of registers in one write request
+#define MB_MASTER_MAX_WRITE_BITS        (1968)  // Max number of coils in one write request
+
+/**
+ * @brief Item of the poll list
+ *
+ * Registers are stored into data as uint16_t values in host byte order,
+ * coils and discrete inputs are packed into bytes, the first one into LSB of the first byte.
+ */
+typedef struct {
+    uint8_t slave_addr;                     /*!< Modbus slave address (1 - 247) */
+    mb_param_type_t type;                   /*!< Type of polled registers */
+    uint16_t reg_start;                     /*!< Modbus address of the first register */
+    uint16_t reg_size;                      /*!< Number of registers or bits */
+    void* data;                             /*!< Storage for polled values, updated by the poll task */
+} mb_master_poll_item_t;
+
+/**
+ * @brief Communication statistics for a slave
+ */
+typedef struct {
+    uint32_t requests;                      /*!< Number of requests sent to the slave */
+    uint32_t errors;                        /*!< Number of failed requests: CRC, exception or malformed response */
+    uint32_t timeouts;                      /*!< Number of requests without response */
+    uint32_t latency_min_us;                /*!< Minimal request to response time (uS) */
+    uint32_t latency_avg_us;                /*!< Average request to response time (uS) */
+    uint32_t latency_max_us;                /*!< Maximal request to response time (uS) */
+} mb_master_slave_stats_t;
+
+/**
+ * @brief Initialize Modbus master controller
+ *
+ * @return
+ *     - ESP_OK   Success
+ *     - ESP_ERR_NO_MEM Not enough memory
+ *     - ESP_ERR_INVALID_STATE Master is already initialized
+ */
+esp_err_t mbcontroller_master_init(void);
+
+/**
+ * @brief Destroy Modbus master controller, stops polling and deletes UART driver
+ *
+ * @return
+ *     - ESP_OK   Success
+ *     - ESP_ERR_INVALID_STATE Master is not initialized
+ */
+esp_err_t mbcontroller_master_destroy(void);
+
+/**
+ * @brief Set Modbus communication parameters for the master controller
+ *
+ * @param comm_info Communication parameters structure, slave_addr field is not used.
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Incorrect parameter data
+ */
+esp_err_t mbcontroller_master_setup(mb_communication_info_t comm_info);
+
+/**
+ * @brief Start Modbus master: configure UART and install its driver
+ *
+ * UART pins and RS485 mode should be set by application after this call.
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_STATE Master is not initialized or already started
+ *     - other UART driver errors
+ */
+esp_err_t mbcontroller_master_start(void);
+
+/**
+ * @brief Read registers or bits from a slave
+ *
+ * Blocks until the response is received or the response timeout expires.
+ *
+ * @param slave_addr Slave address (1 - 247)
+ * @param type Type of registers
+ * @param reg_start Modbus address of the first register
+ * @param reg_size Number of registers or bits
+ * @param[out] data Storage for values, the format is the same as for mb_master_poll_item_t
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Incorrect argument
+ *     - ESP_ERR_TIMEOUT No response from the slave
+ *     - ESP_ERR_INVALID_CRC Response CRC error
+ *     - ESP_ERR_INVALID_RESPONSE Malformed response
+ *     - ESP_ERR_NOT_SUPPORTED Slave returned exception
+ */
+esp_err_t mbcontroller_master_read(uint8_t slave_addr, mb_param_type_t type,
+                                    uint16_t reg_start, uint16_t reg_size, void* data);
+
+/**
+ * @brief Write holding registers or coils of a slave
+ *
+ * Single register and single coil write functions are used for reg_size = 1.
+ *
+ * @param slave_addr Slave address (1 - 247)
+ * @param type MB_PARAM_HOLDING or MB_PARAM_COIL
+ * @param reg_start Modbus address of the first register
+ * @param reg_size Number of registers or bits
+ * @param data Values to write, the format is the same as for mb_master_poll_item_t
+ *
+ * @return the same as mbcontroller_master_read()
+ */
+esp_err_t mbcontroller_master_write(uint8_t slave_addr, mb_param_type_t type,
+                                    uint16_t reg_start, uint16_t reg_size, const void* data);
+
+/**
+ * @brief Start periodic polling of the list of items
+ *
+ * Items of the same slave and type which are adjacent (or separated by at most
+ * CONFIG_MB_MASTER_POLL_MERGE_GAP registers) are read with one request.
+ * All requests of the poll cycle are sent back to back, the cycle is repeated every period_ms.
+ *
+ * @param items Array of poll items, it is copied, but storage pointed by items must stay valid
+ * @param count Number of items
+ * @param period_ms Poll cycle period in milliseconds, 0 - start the next cycle at once
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Incorrect item
+ *     - ESP_ERR_INVALID_STATE Master is not started or polling is already running
+ *     - ESP_ERR_NO_MEM Not enough memory
+ */
+esp_err_t mbcontroller_master_poll_start(const mb_master_poll_item_t* items, size_t count, uint32_t period_ms);
+
+/**
+ * @brief Wait for the end of the next poll cycle
+ *
+ * Storage of poll items is not updated until the next cycle starts.
+ *
+ * @param timeout Timeout in milliseconds
+ *
+ * @return
+ *     - ESP_OK Poll cycle is completed
+ *     - ESP_ERR_TIMEOUT Timeout expired
+ *     - ESP_ERR_INVALID_STATE Polling is not running
+ */
+esp_err_t mbcontroller_master_poll_wait(uint32_t timeout);
+
+/**
+ * @brief Stop polling, waits for the end of current poll cycle
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_STATE Polling is not running
+ */
+esp_err_t mbcontroller_master_poll_stop(void);
+
+/**
+ * @brief Get communication statistics for a slave
+ *
+ * Statistics is kept for up to CONFIG_MB_MASTER_STATS_SLAVES slaves.
+ *
+ * @param slave_addr Slave address
+ * @param[out] stats Statistics
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_NOT_FOUND No requests have been sent to the slave
+ *     - ESP_ERR_INVALID_ARG Incorrect argument
+ */
+esp_err_t mbcontroller_master_get_slave_stats(uint8_t slave_addr, mb_master_slave_stats_t* stats);
+
+/**
+ * @brief Reset communication statistics of all slaves
+ */
+void mbcontroller_master_reset_stats(void);
+
+#endif
@@ -89,7 +89,7 @@ void vMBPortSerialEnable(BOOL bRxEnable, BOOL bTxEnable)
     }
 }
 
-static void vMBPortSerialRxPoll(size_t xEventSize)
+static void vMBPortSerialRxPoll(size_t xEventSize, BOOL bTimeout)
 {
     USHORT usLength;
 
@@ -103,14 +103,14 @@ static void vMBPortSerialRxPoll(size_t xEventSize)
                 // Call the Modbus stack callback function and let it fill the buffers.
                 ( void )pxMBFrameCBByteReceived(); // calls callback xMBRTUReceiveFSM() to execute MB state machine
             }
-            // The buffer is transferred into Modbus stack and is not needed here any more
-            uart_flush_input(ucUartNumber);
-            // Send event EV_FRAME_RECEIVED to allow stack process packet
-#ifndef MB_TIMER_PORT_ENABLED
-            // Let the stack know that T3.5 time is expired and data is received
-            (void)pxMBPortCBTimerExpired(); // calls callback xMBRTUTimerT35Expired();
-#endif
-            ESP_LOGD(TAG, "RX_T35_timeout: %d(bytes in buffer)\n", (uint32_t)usLength);
+            // Bytes left in the ring buffer belong to the same or the next frame, so they are not flushed here.
+            // The frame is complete only when the line has been idle for RX TOUT,
+            // the event caused by RX FIFO full is followed by the rest of the frame.
+            if (bTimeout) {
+                // Let the stack know that T3.5 time is expired and data is received
+                (void)pxMBPortCBTimerExpired(); // calls callback xMBRTUTimerT35Expired();
+                ESP_LOGD(TAG, "RX_T35_timeout: %d(bytes in buffer)\n", (uint32_t)usLength);
+            }
         }
     }
 }
@@ -145,7 +145,7 @@ static void vUartTask(void *pvParameters)
                 case UART_DATA:
                     ESP_LOGD(TAG,"Receive data, len: %d", xEvent.size);
                     // Read received data and send it to modbus stack
-                    vMBPortSerialRxPoll(xEvent.size);
+                    vMBPortSerialRxPoll(xEvent.size, xEvent.timeout_flag);
                     break;
                 //Event of HW FIFO overflow detected
                 case UART_FIFO_OVF:
@@ -234,12 +234,10 @@ BOOL xMBPortSerialInit(UCHAR ucPORT, ULONG ulBaudRate,
             MB_QUEUE_LENGTH, &xMbUartQueue, ESP_INTR_FLAG_LOWMED);
     MB_PORT_CHECK((xErr == ESP_OK), FALSE,
             "mb serial driver failure, uart_driver_install() returned (0x%x).", (uint32_t)xErr);
-#ifndef MB_TIMER_PORT_ENABLED
-    // Set timeout for TOUT interrupt (T3.5 modbus time)
+    // Set timeout for TOUT interrupt (T3.5 modbus time), it is used to detect end of frame
     xErr = uart_set_rx_timeout(ucUartNumber, MB_SERIAL_TOUT);
     MB_PORT_CHECK((xErr == ESP_OK), FALSE,
             "mb serial set rx timeout failure, uart_set_rx_timeout() returned (0x%x).", (uint32_t)xErr);
-#endif
     // Create a task to handle UART events
     BaseType_t xStatus = xTaskCreate(vUartTask, "uart_queue_task", MB_SERIAL_TASK_STACK_SIZE,
                                         NULL, MB_SERIAL_TASK_PRIO, &xMbTaskHandle);
@@ -662,6 +662,14 @@ extern "C" {
 	#define configGENERATE_RUN_TIME_STATS 0
 #endif
 
+#ifndef configUSE_TASK_CPU_CYCLES
+	#define configUSE_TASK_CPU_CYCLES 0
+#endif
+
+#ifndef configTASK_SWITCH_SAMPLES
+	#define configTASK_SWITCH_SAMPLES 0
+#endif
+
 #if ( configGENERATE_RUN_TIME_STATS == 1 )
 
 	#ifndef portCONFIGURE_TIMER_FOR_RUN_TIME_STATS
@@ -932,6 +940,9 @@ typedef struct xSTATIC_TCB
 	#if ( configGENERATE_RUN_TIME_STATS == 1 )
 		uint32_t		ulDummy16;
 	#endif
+	#if ( configUSE_TASK_CPU_CYCLES == 1 )
+		uint32_t		ulDummyCpuCycles;
+	#endif
 	#if ( configUSE_NEWLIB_REENTRANT == 1 )
 		struct	_reent	xDummy17;
 	#endif
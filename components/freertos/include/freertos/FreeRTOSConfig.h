@@ -218,6 +218,11 @@ int xt_clock_freq(void) __attribute__((deprecated));
 #define configGENERATE_RUN_TIME_STATS   1       /* Used by vTaskGetRunTimeStats() */
 #endif
 
+#ifdef CONFIG_FREERTOS_TASK_CPU_CYCLES
+#define configUSE_TASK_CPU_CYCLES       1       /* Used by ulTaskGetCpuCycles() */
+#define configTASK_SWITCH_SAMPLES       CONFIG_FREERTOS_TASK_SWITCH_SAMPLES
+#endif
+
 #define configUSE_TRACE_FACILITY_2      0		/* Provided by Xtensa port patch */
 #define configBENCHMARK					0		/* Provided by Xtensa port patch */
 #define configUSE_16_BIT_TICKS			0
@@ -263,8 +263,9 @@ static inline unsigned portENTER_CRITICAL_NESTED() {
 
 #define pvPortMallocTcbMem(size) heap_caps_malloc(size, portTcbMemoryCaps)
 #define pvPortMallocStackMem(size)  heap_caps_malloc(size, portStackMemoryCaps)
+#define pvPortMallocStackMemCaps(size, caps)  heap_caps_malloc(size, caps)
 
-//xTaskCreateStatic uses these functions to check incoming memory.
+//xTaskCreateStatic and xTaskCreatePinnedToCoreWithCaps use these functions to check the task memory.
 #define portVALID_TCB_MEM(ptr) (esp_ptr_internal(ptr) && esp_ptr_byte_accessible(ptr))
 #ifdef CONFIG_SPIRAM_ALLOW_STACK_EXTERNAL_MEMORY
 #define portVALID_STACK_MEM(ptr) esp_ptr_byte_accessible(ptr)
@@ -612,6 +612,34 @@ typedef void * QueueSetMemberHandle_t;
  */
 BaseType_t xQueueGenericSend( QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait, const BaseType_t xCopyPosition ) PRIVILEGED_FUNCTION;
 
+/**
+ * Post up to uxItemCount items on the back of a queue in one call.  The items
+ * are queued by copy, not by reference.  This function must not be called
+ * from an interrupt service routine.
+ *
+ * The call blocks (for at most xTicksToWait) until there is space for at least
+ * one item, then copies as many of the items as fit and unblocks the tasks
+ * waiting to receive them.  Compared to calling xQueueSend() for each item,
+ * the queue is locked and the waiting tasks are woken only once.
+ *
+ * @param xQueue The handle to the queue on which the items are to be posted.
+ *
+ * @param pvItems A pointer to the first of uxItemCount items, stored
+ * contiguously.  Each item has the size the queue was created with.
+ *
+ * @param uxItemCount The number of items to post.
+ *
+ * @param xTicksToWait The maximum amount of time the task should block
+ * waiting for space to become available on the queue, should it be full.
+ *
+ * @return The number of items posted, 0 if the queue stayed full until the
+ * block time expired.  The items that were not posted are the last ones of
+ * pvItems.
+ *
+ * \ingroup QueueManagement
+ */
+BaseType_t xQueueSendMultiple( QueueHandle_t xQueue, const void * const pvItems, const UBaseType_t uxItemCount, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
 /**
  * This is a macro that calls the xQueueGenericReceive() function.
  *
@@ -905,6 +933,37 @@ BaseType_t xQueuePeekFromISR( QueueHandle_t xQueue, void * const pvBuffer ) PRIV
  */
 BaseType_t xQueueGenericReceive( QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait, const BaseType_t xJustPeek ) PRIVILEGED_FUNCTION;
 
+/**
+ * Receive up to uxMaxItems items from a queue in one call.  The items are
+ * received by copy so a buffer of adequate size must be provided.  This
+ * function must not be called from an interrupt service routine.
+ *
+ * The call blocks (for at most xTicksToWait) until at least one item is
+ * available, then copies as many of the available items as fit into pvBuffer
+ * and unblocks the tasks waiting to send.  Compared to calling xQueueReceive()
+ * for each item, the queue is locked and the waiting tasks are woken only once.
+ *
+ * Must not be used on a queue that is a member of a queue set, as each item
+ * in such a queue has to be received after selecting it from the set.
+ *
+ * @param xQueue The handle to the queue from which the items are to be
+ * received.
+ *
+ * @param pvBuffer Pointer to the buffer into which the received items will
+ * be copied.  It must have room for uxMaxItems items.
+ *
+ * @param uxMaxItems The maximum number of items to receive.
+ *
+ * @param xTicksToWait The maximum amount of time the task should block
+ * waiting for an item to receive should the queue be empty.
+ *
+ * @return The number of items received, 0 if the queue stayed empty until
+ * the block time expired.
+ *
+ * \ingroup QueueManagement
+ */
+BaseType_t xQueueReceiveMultiple( QueueHandle_t xQueue, void * const pvBuffer, const UBaseType_t uxMaxItems, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
 /**
  * Return the number of messages stored in a queue.
  *
@@ -442,6 +442,58 @@ is used in assert() statements. */
 
 #endif
 
+/**
+ * Create a new task with its stack allocated from memory with the given
+ * capabilities.
+ *
+ * This is the same as xTaskCreatePinnedToCore(), except that the stack is
+ * allocated with heap_caps_malloc() using uxStackMemoryCaps instead of always
+ * coming from internal memory.  The task's data structures are still
+ * allocated from internal memory.
+ *
+ * The stack must be byte accessible, so IRAM can't be used.  External memory
+ * (MALLOC_CAP_SPIRAM) can only be used if
+ * CONFIG_SPIRAM_ALLOW_STACK_EXTERNAL_MEMORY is enabled, and then only by tasks
+ * that don't call ROM code and don't read, write or erase the flash: the cache,
+ * and with it external memory, is disabled during flash operations.
+ *
+ * @param uxStackMemoryCaps Bitwise OR of MALLOC_CAP_* flags for the stack
+ * memory, e.g. MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT.
+ *
+ * See xTaskCreatePinnedToCore() for the other parameters.
+ *
+ * @return pdPASS if the task was successfully created and added to a ready
+ * list, errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY if the memory could not be
+ * allocated or the capabilities selected memory which can't hold a stack.
+ *
+ * \ingroup Tasks
+ */
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+	BaseType_t xTaskCreatePinnedToCoreWithCaps(	TaskFunction_t pvTaskCode,
+										const char * const pcName,
+										const uint32_t usStackDepth,
+										void * const pvParameters,
+										UBaseType_t uxPriority,
+										TaskHandle_t * const pvCreatedTask,
+										const BaseType_t xCoreID,
+										const UBaseType_t uxStackMemoryCaps);
+
+	/**
+	 * Same as xTaskCreatePinnedToCoreWithCaps() with no core affinity.
+	 */
+	static inline IRAM_ATTR BaseType_t xTaskCreateWithCaps(
+			TaskFunction_t pvTaskCode,
+			const char * const pcName,
+			const uint32_t usStackDepth,
+			void * const pvParameters,
+			UBaseType_t uxPriority,
+			TaskHandle_t * const pvCreatedTask,
+			const UBaseType_t uxStackMemoryCaps)
+	{
+		return xTaskCreatePinnedToCoreWithCaps( pvTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pvCreatedTask, tskNO_AFFINITY, uxStackMemoryCaps );
+	}
+#endif
+
 
 
 
@@ -1687,6 +1739,56 @@ void vTaskList( char * pcWriteBuffer ) PRIVILEGED_FUNCTION; /*lint !e971 Unquali
  */
 void vTaskGetRunTimeStats( char *pcWriteBuffer ) PRIVILEGED_FUNCTION; /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
 
+/**
+ * Sample of the task switch history of a core
+ *
+ * @see uxTaskGetSwitchSamples
+ */
+typedef struct xTASK_SWITCH_SAMPLE
+{
+	TaskHandle_t xHandle;		/*!< Task which was switched out. It may have been deleted since. */
+	uint32_t ulCycles;			/*!< Number of CPU cycles the task has run for before it was switched out. */
+} TaskSwitchSample_t;
+
+/**
+ * Get the number of CPU cycles a task has spent in the Running state
+ *
+ * configUSE_TASK_CPU_CYCLES must be defined as 1 for this function to be
+ * available. The counter is updated from CCOUNT each time the task is switched
+ * out, and wraps around at 2^32, so the CPU load of a task is found from the
+ * difference between two readings. Unlike the run time stats, reading it does
+ * not suspend the scheduler or disable interrupts.
+ *
+ * @note The counter counts CPU cycles, not time, so with Dynamic Frequency
+ * Scaling cycles spent at different CPU frequencies have different durations.
+ *
+ * @param xTask Handle of the task, or NULL for the calling task.
+ *
+ * @return Number of CPU cycles the task has run for, not including the time
+ * since it was last switched in.
+ */
+uint32_t ulTaskGetCpuCycles( TaskHandle_t xTask );
+
+/**
+ * Get the latest task switches of a core
+ *
+ * configUSE_TASK_CPU_CYCLES must be defined as 1, and configTASK_SWITCH_SAMPLES
+ * greater than 0 for this function to be available. Each core records a sample
+ * into a ring buffer of configTASK_SWITCH_SAMPLES entries each time it switches
+ * tasks. The samples can be read without suspending the scheduler. If the
+ * reader is too slow, the oldest samples are overwritten and skipped.
+ *
+ * @param xCoreID Core to read the samples of.
+ * @param pulSequence Sequence number of the first sample to read, 0 to start
+ * with the oldest sample available. It is updated to the sequence number of the
+ * next sample, to be passed to the following call.
+ * @param pxSamples Array to store the samples into.
+ * @param uxMaxSamples Size of the array.
+ *
+ * @return Number of samples stored in pxSamples.
+ */
+UBaseType_t uxTaskGetSwitchSamples( BaseType_t xCoreID, uint32_t *pulSequence, TaskSwitchSample_t *pxSamples, UBaseType_t uxMaxSamples );
+
 /**
  * Send task notification.
  *
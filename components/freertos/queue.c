@@ -236,6 +236,19 @@ static BaseType_t prvCopyDataToQueue( Queue_t * const pxQueue, const void *pvIte
  */
 static void prvCopyDataFromQueue( Queue_t * const pxQueue, void * const pvBuffer ) PRIVILEGED_FUNCTION;
 
+/*
+ * Copy uxCount items to the back of / out of the front of a queue.  The
+ * caller checks that there is enough space / there are enough items.
+ */
+static void prvCopyMultipleToQueue( Queue_t * const pxQueue, const int8_t *pcItems, UBaseType_t uxCount ) PRIVILEGED_FUNCTION;
+static void prvCopyMultipleFromQueue( Queue_t * const pxQueue, int8_t *pcBuffer, UBaseType_t uxCount ) PRIVILEGED_FUNCTION;
+
+/*
+ * Unblocks up to uxCount of the tasks waiting on pxEventList.  Returns pdTRUE
+ * if any of them has a higher priority than the calling task.
+ */
+static BaseType_t prvUnblockWaitingTasks( List_t * const pxEventList, UBaseType_t uxCount ) PRIVILEGED_FUNCTION;
+
 #if ( configUSE_QUEUE_SETS == 1 )
 	/*
 	 * Checks to see if a queue is a member of a queue set, and if so, notifies
@@ -905,6 +918,124 @@ Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 }
 /*-----------------------------------------------------------*/
 
+BaseType_t xQueueSendMultiple( QueueHandle_t xQueue, const void * const pvItems, const UBaseType_t uxItemCount, TickType_t xTicksToWait )
+{
+BaseType_t xEntryTimeSet = pdFALSE, xYieldRequired;
+TimeOut_t xTimeOut;
+UBaseType_t uxCopied;
+Queue_t * const pxQueue = ( Queue_t * ) xQueue;
+
+	configASSERT( pxQueue );
+	configASSERT( pxQueue->uxItemSize != ( UBaseType_t ) 0U );
+	configASSERT( !( ( pvItems == NULL ) && ( uxItemCount != ( UBaseType_t ) 0U ) ) );
+	#if ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) )
+	{
+		configASSERT( !( ( xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED ) && ( xTicksToWait != 0 ) ) );
+	}
+	#endif
+
+	if( uxItemCount == ( UBaseType_t ) 0U )
+	{
+		return 0;
+	}
+
+	for( ;; )
+	{
+		taskENTER_CRITICAL(&pxQueue->mux);
+		{
+			if( pxQueue->uxMessagesWaiting < pxQueue->uxLength )
+			{
+				uxCopied = pxQueue->uxLength - pxQueue->uxMessagesWaiting;
+				if( uxCopied > uxItemCount )
+				{
+					uxCopied = uxItemCount;
+				}
+				traceQUEUE_SEND( pxQueue );
+				prvCopyMultipleToQueue( pxQueue, ( const int8_t * ) pvItems, uxCopied );
+
+				#if ( configUSE_QUEUE_SETS == 1 )
+				if( pxQueue->pxQueueSetContainer != NULL )
+				{
+					/* The queue set holds one entry per item. */
+					xYieldRequired = pdFALSE;
+					for( UBaseType_t ux = 0; ux < uxCopied; ux++ )
+					{
+						if( prvNotifyQueueSetContainer( pxQueue, queueSEND_TO_BACK ) == pdTRUE )
+						{
+							xYieldRequired = pdTRUE;
+						}
+					}
+				}
+				else
+				#endif /* configUSE_QUEUE_SETS */
+				{
+					/* Each of the items can unblock one waiting task. */
+					xYieldRequired = prvUnblockWaitingTasks( &( pxQueue->xTasksWaitingToReceive ), uxCopied );
+				}
+
+				if( xYieldRequired != pdFALSE )
+				{
+					queueYIELD_IF_USING_PREEMPTION();
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+
+				taskEXIT_CRITICAL(&pxQueue->mux);
+				return ( BaseType_t ) uxCopied;
+			}
+			else
+			{
+				if( xTicksToWait == ( TickType_t ) 0 )
+				{
+					/* The queue was full and no block time is specified (or
+					the block time has expired) so leave now. */
+					taskEXIT_CRITICAL(&pxQueue->mux);
+					traceQUEUE_SEND_FAILED( pxQueue );
+					return 0;
+				}
+				else if( xEntryTimeSet == pdFALSE )
+				{
+					vTaskSetTimeOutState( &xTimeOut );
+					xEntryTimeSet = pdTRUE;
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+		}
+		taskEXIT_CRITICAL(&pxQueue->mux);
+
+		taskENTER_CRITICAL(&pxQueue->mux);
+
+		if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE )
+		{
+			if( prvIsQueueFull( pxQueue ) != pdFALSE )
+			{
+				traceBLOCKING_ON_QUEUE_SEND( pxQueue );
+				vTaskPlaceOnEventList( &( pxQueue->xTasksWaitingToSend ), xTicksToWait );
+				taskEXIT_CRITICAL(&pxQueue->mux);
+				portYIELD_WITHIN_API();
+			}
+			else
+			{
+				/* Try again. */
+				taskEXIT_CRITICAL(&pxQueue->mux);
+			}
+		}
+		else
+		{
+			/* The timeout has expired. */
+			taskEXIT_CRITICAL(&pxQueue->mux);
+			traceQUEUE_SEND_FAILED( pxQueue );
+			return 0;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
 #if ( configUSE_ALTERNATIVE_API == 1 )
 
 	BaseType_t xQueueAltGenericSend( QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait, BaseType_t xCopyPosition )
@@ -1613,6 +1744,109 @@ Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 }
 /*-----------------------------------------------------------*/
 
+BaseType_t xQueueReceiveMultiple( QueueHandle_t xQueue, void * const pvBuffer, const UBaseType_t uxMaxItems, TickType_t xTicksToWait )
+{
+BaseType_t xEntryTimeSet = pdFALSE;
+TimeOut_t xTimeOut;
+UBaseType_t uxCopied;
+Queue_t * const pxQueue = ( Queue_t * ) xQueue;
+
+	configASSERT( pxQueue );
+	configASSERT( pxQueue->uxItemSize != ( UBaseType_t ) 0U );
+	configASSERT( !( ( pvBuffer == NULL ) && ( uxMaxItems != ( UBaseType_t ) 0U ) ) );
+	#if ( configUSE_QUEUE_SETS == 1 )
+	{
+		configASSERT( pxQueue->pxQueueSetContainer == NULL );
+	}
+	#endif
+	#if ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) )
+	{
+		configASSERT( !( ( xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED ) && ( xTicksToWait != 0 ) ) );
+	}
+	#endif
+
+	if( uxMaxItems == ( UBaseType_t ) 0U )
+	{
+		return 0;
+	}
+
+	for( ;; )
+	{
+		taskENTER_CRITICAL(&pxQueue->mux);
+		{
+			if( pxQueue->uxMessagesWaiting > ( UBaseType_t ) 0 )
+			{
+				uxCopied = pxQueue->uxMessagesWaiting;
+				if( uxCopied > uxMaxItems )
+				{
+					uxCopied = uxMaxItems;
+				}
+				traceQUEUE_RECEIVE( pxQueue );
+				prvCopyMultipleFromQueue( pxQueue, ( int8_t * ) pvBuffer, uxCopied );
+
+				/* Each of the freed slots can unblock one waiting task. */
+				if( prvUnblockWaitingTasks( &( pxQueue->xTasksWaitingToSend ), uxCopied ) != pdFALSE )
+				{
+					queueYIELD_IF_USING_PREEMPTION();
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+
+				taskEXIT_CRITICAL(&pxQueue->mux);
+				return ( BaseType_t ) uxCopied;
+			}
+			else
+			{
+				if( xTicksToWait == ( TickType_t ) 0 )
+				{
+					/* The queue was empty and no block time is specified (or
+					the block time has expired) so leave now. */
+					traceQUEUE_RECEIVE_FAILED( pxQueue );
+					taskEXIT_CRITICAL(&pxQueue->mux);
+					return 0;
+				}
+				else if( xEntryTimeSet == pdFALSE )
+				{
+					vTaskSetTimeOutState( &xTimeOut );
+					xEntryTimeSet = pdTRUE;
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+		}
+		taskEXIT_CRITICAL(&pxQueue->mux);
+
+		taskENTER_CRITICAL(&pxQueue->mux);
+
+		if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE )
+		{
+			if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
+			{
+				traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue );
+				vTaskPlaceOnEventList( &( pxQueue->xTasksWaitingToReceive ), xTicksToWait );
+				taskEXIT_CRITICAL(&pxQueue->mux);
+				portYIELD_WITHIN_API();
+			}
+			else
+			{
+				/* Try again. */
+				taskEXIT_CRITICAL(&pxQueue->mux);
+			}
+		}
+		else
+		{
+			taskEXIT_CRITICAL(&pxQueue->mux);
+			traceQUEUE_RECEIVE_FAILED( pxQueue );
+			return 0;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
 BaseType_t xQueueReceiveFromISR( QueueHandle_t xQueue, void * const pvBuffer, BaseType_t * const pxHigherPriorityTaskWoken )
 {
 BaseType_t xReturn;
@@ -1961,6 +2195,80 @@ static void prvCopyDataFromQueue( Queue_t * const pxQueue, void * const pvBuffer
 
 /*-----------------------------------------------------------*/
 
+static void prvCopyMultipleToQueue( Queue_t * const pxQueue, const int8_t *pcItems, UBaseType_t uxCount )
+{
+	/* At most two copies are needed, split where the storage area wraps. */
+	while( uxCount > ( UBaseType_t ) 0 )
+	{
+		UBaseType_t uxChunk = ( UBaseType_t ) ( pxQueue->pcTail - pxQueue->pcWriteTo ) / pxQueue->uxItemSize;
+		size_t xBytes;
+
+		if( uxChunk > uxCount )
+		{
+			uxChunk = uxCount;
+		}
+		xBytes = ( size_t ) uxChunk * pxQueue->uxItemSize;
+		( void ) memcpy( ( void * ) pxQueue->pcWriteTo, ( const void * ) pcItems, xBytes );
+		pxQueue->pcWriteTo += xBytes;
+		if( pxQueue->pcWriteTo >= pxQueue->pcTail ) /*lint !e946 MISRA exception justified as comparison of pointers is the cleanest solution. */
+		{
+			pxQueue->pcWriteTo = pxQueue->pcHead;
+		}
+		pcItems += xBytes;
+		uxCount -= uxChunk;
+		pxQueue->uxMessagesWaiting += uxChunk;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvCopyMultipleFromQueue( Queue_t * const pxQueue, int8_t *pcBuffer, UBaseType_t uxCount )
+{
+	while( uxCount > ( UBaseType_t ) 0 )
+	{
+		/* u.pcReadFrom points to the last item read. */
+		int8_t *pcNext = pxQueue->u.pcReadFrom + pxQueue->uxItemSize;
+		UBaseType_t uxChunk;
+		size_t xBytes;
+
+		if( pcNext >= pxQueue->pcTail ) /*lint !e946 MISRA exception justified as use of the relational operator is the cleanest solutions. */
+		{
+			pcNext = pxQueue->pcHead;
+		}
+		uxChunk = ( UBaseType_t ) ( pxQueue->pcTail - pcNext ) / pxQueue->uxItemSize;
+		if( uxChunk > uxCount )
+		{
+			uxChunk = uxCount;
+		}
+		xBytes = ( size_t ) uxChunk * pxQueue->uxItemSize;
+		( void ) memcpy( ( void * ) pcBuffer, ( void * ) pcNext, xBytes );
+		pxQueue->u.pcReadFrom = pcNext + xBytes - pxQueue->uxItemSize;
+		pcBuffer += xBytes;
+		uxCount -= uxChunk;
+		pxQueue->uxMessagesWaiting -= uxChunk;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvUnblockWaitingTasks( List_t * const pxEventList, UBaseType_t uxCount )
+{
+BaseType_t xReturn = pdFALSE;
+
+	while( ( uxCount-- > ( UBaseType_t ) 0 ) && ( listLIST_IS_EMPTY( pxEventList ) == pdFALSE ) )
+	{
+		if( xTaskRemoveFromEventList( pxEventList ) != pdFALSE )
+		{
+			xReturn = pdTRUE;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
 static BaseType_t prvIsQueueEmpty( Queue_t *pxQueue )
 {
 BaseType_t xReturn;
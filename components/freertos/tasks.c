@@ -209,6 +209,10 @@ typedef struct tskTaskControlBlock
 		uint32_t		ulRunTimeCounter;	/*< Stores the amount of time the task has spent in the Running state. */
 	#endif
 
+	#if ( configUSE_TASK_CPU_CYCLES == 1 )
+		volatile uint32_t	ulCpuCycles;	/*< Number of CPU cycles the task has spent in the Running state, wraps around. */
+	#endif
+
 	#if ( configUSE_NEWLIB_REENTRANT == 1 )
 		/* Allocate a Newlib reent structure that is specific to this task.
 		Note Newlib support has been included by popular demand, but is not
@@ -302,9 +306,14 @@ when the scheduler is unsuspended.  The pending ready list itself can only be
 accessed from a critical section. */
 PRIVILEGED_DATA static volatile UBaseType_t uxSchedulerSuspended[ portNUM_PROCESSORS ]	= { ( UBaseType_t ) pdFALSE };
 
-/* We use just one spinlock for all the critical sections. */
+/* We use just one spinlock for most of the critical sections. */
 PRIVILEGED_DATA static portMUX_TYPE xTaskQueueMutex = portMUX_INITIALIZER_UNLOCKED;
 
+/* xTickCount and xNumOfOverflows are also updated under this spinlock, so that
+xTaskCheckForTimeOut() can read them consistently without taking xTaskQueueMutex.
+It is always taken after xTaskQueueMutex, never the other way around. */
+PRIVILEGED_DATA static portMUX_TYPE xTickCountMutex = portMUX_INITIALIZER_UNLOCKED;
+
 #if ( configGENERATE_RUN_TIME_STATS == 1 )
 
 	PRIVILEGED_DATA static uint32_t ulTaskSwitchedInTime[portNUM_PROCESSORS] = {0U};	/*< Holds the value of a timer/counter the last time a task was switched in on a particular core. */
@@ -312,6 +321,20 @@ PRIVILEGED_DATA static portMUX_TYPE xTaskQueueMutex = portMUX_INITIALIZER_UNLOCK
 
 #endif
 
+#if ( configUSE_TASK_CPU_CYCLES == 1 )
+
+	PRIVILEGED_DATA static uint32_t ulTaskSwitchedInCycles[ portNUM_PROCESSORS ] = { 0U };	/*< CCOUNT of each core when the current task was switched in. */
+
+	#if ( configTASK_SWITCH_SAMPLES > 0 )
+		/* Ring buffers of task switches, written only by their own core with interrupts disabled.
+		The sequence number is incremented after the sample is written, so readers can detect
+		the samples which have been overwritten while they were reading. */
+		PRIVILEGED_DATA static TaskSwitchSample_t xTaskSwitchSamples[ portNUM_PROCESSORS ][ configTASK_SWITCH_SAMPLES ];
+		PRIVILEGED_DATA static volatile uint32_t ulTaskSwitchSequence[ portNUM_PROCESSORS ] = { 0U };
+	#endif
+
+#endif
+
 
 // per-CPU flags indicating that we are doing context switch, it is used by apptrace and sysview modules
 // in order to avoid calls of vPortYield from traceTASK_SWITCHED_IN/OUT when waiting
@@ -768,6 +791,19 @@ void taskYIELD_OTHER_CORE( BaseType_t xCoreID, UBaseType_t uxPriority )
 							UBaseType_t uxPriority,
 							TaskHandle_t * const pxCreatedTask,
                             const BaseType_t xCoreID )
+	{
+		return xTaskCreatePinnedToCoreWithCaps( pxTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pxCreatedTask, xCoreID, portStackMemoryCaps );
+	}
+/*-----------------------------------------------------------*/
+
+	BaseType_t xTaskCreatePinnedToCoreWithCaps(	TaskFunction_t pxTaskCode,
+							const char * const pcName,
+							const uint32_t usStackDepth,
+							void * const pvParameters,
+							UBaseType_t uxPriority,
+							TaskHandle_t * const pxCreatedTask,
+							const BaseType_t xCoreID,
+							const UBaseType_t uxStackMemoryCaps )
 	{
 	TCB_t *pxNewTCB;
 	BaseType_t xReturn;
@@ -787,7 +823,7 @@ void taskYIELD_OTHER_CORE( BaseType_t xCoreID, UBaseType_t uxPriority )
 				/* Allocate space for the stack used by the task being created.
 				The base of the stack memory stored in the TCB so the task can
 				be deleted later if required. */
-				pxNewTCB->pxStack = ( StackType_t * ) pvPortMallocStackMem( ( ( ( size_t ) usStackDepth ) * sizeof( StackType_t ) ) ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+				pxNewTCB->pxStack = ( StackType_t * ) pvPortMallocStackMemCaps( ( ( ( size_t ) usStackDepth ) * sizeof( StackType_t ) ), uxStackMemoryCaps ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
 
 				if( pxNewTCB->pxStack == NULL )
 				{
@@ -802,7 +838,7 @@ void taskYIELD_OTHER_CORE( BaseType_t xCoreID, UBaseType_t uxPriority )
 		StackType_t *pxStack;
 
 			/* Allocate space for the stack used by the task being created. */
-			pxStack = ( StackType_t * ) pvPortMallocStackMem( ( ( ( size_t ) usStackDepth ) * sizeof( StackType_t ) ) ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+			pxStack = ( StackType_t * ) pvPortMallocStackMemCaps( ( ( ( size_t ) usStackDepth ) * sizeof( StackType_t ) ), uxStackMemoryCaps ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
 
 			if( pxStack != NULL )
 			{
@@ -828,6 +864,14 @@ void taskYIELD_OTHER_CORE( BaseType_t xCoreID, UBaseType_t uxPriority )
 		}
 		#endif /* portSTACK_GROWTH */
 
+		if( ( pxNewTCB != NULL ) && !portVALID_STACK_MEM( pxNewTCB->pxStack ) )
+		{
+			/* The capabilities allowed memory the task can't run from. */
+			vPortFree( pxNewTCB->pxStack );
+			vPortFree( pxNewTCB );
+			pxNewTCB = NULL;
+		}
+
 		if( pxNewTCB != NULL )
 		{
 			#if( tskSTATIC_AND_DYNAMIC_ALLOCATION_POSSIBLE != 0 )
@@ -983,6 +1027,12 @@ UBaseType_t x;
 	}
 	#endif /* configUSE_APPLICATION_TASK_TAG */
 
+	#if ( configUSE_TASK_CPU_CYCLES == 1 )
+	{
+		pxNewTCB->ulCpuCycles = 0UL;
+	}
+	#endif /* configUSE_TASK_CPU_CYCLES */
+
 	#if ( configGENERATE_RUN_TIME_STATS == 1 )
 	{
 		pxNewTCB->ulRunTimeCounter = 0UL;
@@ -2446,7 +2496,9 @@ implementations require configUSE_TICKLESS_IDLE to be set to a value other than
 		each stepped tick. */
 		portENTER_CRITICAL( &xTaskQueueMutex );
 		configASSERT( ( xTickCount + xTicksToJump ) <= xNextTaskUnblockTime );
+		portENTER_CRITICAL( &xTickCountMutex );
 		xTickCount += xTicksToJump;
+		portEXIT_CRITICAL( &xTickCountMutex );
 		portEXIT_CRITICAL( &xTaskQueueMutex );
 		traceINCREASE_TICK_COUNT( xTicksToJump );
 	}
@@ -2492,6 +2544,7 @@ BaseType_t xSwitchRequired = pdFALSE;
 		taskENTER_CRITICAL_ISR( &xTaskQueueMutex );
 		/* Increment the RTOS tick, switching the delayed and overflowed
 		delayed lists if it wraps to 0. */
+		taskENTER_CRITICAL_ISR( &xTickCountMutex );
 		++xTickCount;
 		{
 			/* Minor optimisation.  The tick count cannot change in this
@@ -2506,6 +2559,7 @@ BaseType_t xSwitchRequired = pdFALSE;
 			{
 				mtCOVERAGE_TEST_MARKER();
 			}
+			taskEXIT_CRITICAL_ISR( &xTickCountMutex );
 
 			/* See if this tick has made a timeout expire.  Tasks are stored in
 			the	queue in the order of their wake time - meaning once one task
@@ -2795,6 +2849,27 @@ void vTaskSwitchContext( void )
 		}
 		#endif /* configGENERATE_RUN_TIME_STATS */
 
+		#if ( configUSE_TASK_CPU_CYCLES == 1 )
+		{
+			/* Only this core runs (and switches out) the current task, no lock is needed */
+			BaseType_t xCoreID = xPortGetCoreID();
+			uint32_t ulNow = xthal_get_ccount();
+			uint32_t ulCycles = ulNow - ulTaskSwitchedInCycles[ xCoreID ];
+			ulTaskSwitchedInCycles[ xCoreID ] = ulNow;
+			pxCurrentTCB[ xCoreID ]->ulCpuCycles += ulCycles;
+			#if ( configTASK_SWITCH_SAMPLES > 0 )
+			{
+				uint32_t ulSequence = ulTaskSwitchSequence[ xCoreID ];
+				TaskSwitchSample_t *pxSample = &xTaskSwitchSamples[ xCoreID ][ ulSequence % configTASK_SWITCH_SAMPLES ];
+				pxSample->xHandle = ( TaskHandle_t ) pxCurrentTCB[ xCoreID ];
+				pxSample->ulCycles = ulCycles;
+				__sync_synchronize();
+				ulTaskSwitchSequence[ xCoreID ] = ulSequence + 1;
+			}
+			#endif
+		}
+		#endif /* configUSE_TASK_CPU_CYCLES */
+
 		/* Check for stack overflow, if configured. */
 		taskFIRST_CHECK_FOR_STACK_OVERFLOW();
 		taskSECOND_CHECK_FOR_STACK_OVERFLOW();
@@ -3249,8 +3324,10 @@ BaseType_t xReturn;
 void vTaskSetTimeOutState( TimeOut_t * const pxTimeOut )
 {
 	configASSERT( pxTimeOut );
+	taskENTER_CRITICAL( &xTickCountMutex );
 	pxTimeOut->xOverflowCount = xNumOfOverflows;
 	pxTimeOut->xTimeOnEntering = xTickCount;
+	taskEXIT_CRITICAL( &xTickCountMutex );
 }
 /*-----------------------------------------------------------*/
 
@@ -3261,7 +3338,7 @@ BaseType_t xReturn;
 	configASSERT( pxTimeOut );
 	configASSERT( pxTicksToWait );
 
-	taskENTER_CRITICAL(&xTaskQueueMutex);
+	taskENTER_CRITICAL(&xTickCountMutex);
 	{
 		/* Minor optimisation.  The tick count cannot change in this block. */
 		const TickType_t xConstTickCount = xTickCount;
@@ -3289,7 +3366,8 @@ BaseType_t xReturn;
 		{
 			/* Not a genuine timeout. Adjust parameters for time remaining. */
 			*pxTicksToWait -= ( xConstTickCount -  pxTimeOut->xTimeOnEntering );
-			vTaskSetTimeOutState( pxTimeOut );
+			pxTimeOut->xOverflowCount = xNumOfOverflows;
+			pxTimeOut->xTimeOnEntering = xConstTickCount;
 			xReturn = pdFALSE;
 		}
 		else
@@ -3297,7 +3375,7 @@ BaseType_t xReturn;
 			xReturn = pdTRUE;
 		}
 	}
-	taskEXIT_CRITICAL(&xTaskQueueMutex);
+	taskEXIT_CRITICAL(&xTickCountMutex);
 
 	return xReturn;
 }
@@ -4595,16 +4673,18 @@ TickType_t uxReturn;
 	void *pvTaskIncrementMutexHeldCount( void )
 	{
 	TCB_t *curTCB;
+	unsigned state;
 
 		/* If xSemaphoreCreateMutex() is called before any tasks have been created
-		then pxCurrentTCB will be NULL. */
-		taskENTER_CRITICAL(&xTaskQueueMutex);
+		then pxCurrentTCB will be NULL.  The mutex count is only changed by the
+		task holding the mutexes, so disabling interrupts on this core is enough. */
+		state = portENTER_CRITICAL_NESTED();
 		if( pxCurrentTCB[ xPortGetCoreID() ] != NULL )
 		{
 			( pxCurrentTCB[ xPortGetCoreID() ]->uxMutexesHeld )++;
 		}
 		curTCB = pxCurrentTCB[ xPortGetCoreID() ];
-		taskEXIT_CRITICAL(&xTaskQueueMutex);
+		portEXIT_CRITICAL_NESTED(state);
 
 		return curTCB;
 	}
@@ -5178,6 +5258,51 @@ TickType_t uxReturn;
 
 #endif
 
+#if ( configUSE_TASK_CPU_CYCLES == 1 )
+
+	uint32_t ulTaskGetCpuCycles( TaskHandle_t xTask )
+	{
+		TCB_t *pxTCB = prvGetTCBFromHandle( xTask );
+		return pxTCB->ulCpuCycles;
+	}
+
+	#if ( configTASK_SWITCH_SAMPLES > 0 )
+
+	UBaseType_t uxTaskGetSwitchSamples( BaseType_t xCoreID, uint32_t *pulSequence, TaskSwitchSample_t *pxSamples, UBaseType_t uxMaxSamples )
+	{
+		uint32_t ulFirst;
+		UBaseType_t uxCount;
+
+		configASSERT( xCoreID >= 0 && xCoreID < portNUM_PROCESSORS );
+		for( ;; )
+		{
+			uint32_t ulEnd = ulTaskSwitchSequence[ xCoreID ];
+			__sync_synchronize();
+			/* The slot of the sample being written is the one of sample ulEnd - configTASK_SWITCH_SAMPLES */
+			ulFirst = *pulSequence;
+			if( ( uint32_t ) ( ulEnd - ulFirst ) >= configTASK_SWITCH_SAMPLES )
+			{
+				ulFirst = ulEnd - configTASK_SWITCH_SAMPLES + 1;
+			}
+			for( uxCount = 0; uxCount < uxMaxSamples && ulFirst + uxCount != ulEnd; uxCount++ )
+			{
+				pxSamples[ uxCount ] = xTaskSwitchSamples[ xCoreID ][ ( ulFirst + uxCount ) % configTASK_SWITCH_SAMPLES ];
+			}
+			__sync_synchronize();
+			/* Done unless the core has overwritten some of the copied samples meanwhile */
+			if( ( uint32_t ) ( ulTaskSwitchSequence[ xCoreID ] - ulFirst ) < configTASK_SWITCH_SAMPLES )
+			{
+				break;
+			}
+		}
+		*pulSequence = ulFirst + uxCount;
+		return uxCount;
+	}
+
+	#endif /* configTASK_SWITCH_SAMPLES */
+
+#endif /* configUSE_TASK_CPU_CYCLES */
+
 #ifdef FREERTOS_MODULE_TEST
 	#include "tasks_test_access_functions.h"
 #endif
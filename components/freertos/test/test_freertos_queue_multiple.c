@@ -0,0 +1,106 @@
+/*
+ Tests for sending and receiving several queue items in one call
+*/
+
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "unity.h"
+#include "test_utils.h"
+
+#define QUEUE_LEN       10
+#define BATCH_LEN       4
+#define ITEMS_TOTAL     1000
+
+TEST_CASE("xQueueSendMultiple and xQueueReceiveMultiple keep items in order", "[freertos]")
+{
+    QueueHandle_t queue = xQueueCreate(QUEUE_LEN, sizeof(uint32_t));
+    uint32_t items[QUEUE_LEN + 2];
+    uint32_t next_sent = 0, next_received = 0;
+
+    TEST_ASSERT_NOT_NULL(queue);
+    /* Batches of varying size wrap around the end of the storage area */
+    for (int round = 0; round < 50; round++) {
+        int count = 1 + round % (QUEUE_LEN - 1);
+        for (int i = 0; i < count; i++) {
+            items[i] = next_sent + i;
+        }
+        TEST_ASSERT_EQUAL(count, xQueueSendMultiple(queue, items, count, 0));
+        next_sent += count;
+        /* Mix in single item operations */
+        if (round % 3 == 0) {
+            TEST_ASSERT_EQUAL(pdTRUE, xQueueReceive(queue, &items[0], 0));
+            TEST_ASSERT_EQUAL(next_received++, items[0]);
+        }
+        int received = xQueueReceiveMultiple(queue, items, QUEUE_LEN, 0);
+        TEST_ASSERT_EQUAL(next_sent - next_received, received);
+        for (int i = 0; i < received; i++) {
+            TEST_ASSERT_EQUAL(next_received++, items[i]);
+        }
+    }
+
+    /* Only the items that fit are sent, and nothing is received from an empty queue */
+    for (int i = 0; i < QUEUE_LEN + 2; i++) {
+        items[i] = i;
+    }
+    TEST_ASSERT_EQUAL(QUEUE_LEN, xQueueSendMultiple(queue, items, QUEUE_LEN + 2, 0));
+    TEST_ASSERT_EQUAL(0, xQueueSendMultiple(queue, items, 1, 1));
+    TEST_ASSERT_EQUAL(QUEUE_LEN, xQueueReceiveMultiple(queue, items, QUEUE_LEN + 2, 0));
+    TEST_ASSERT_EQUAL(QUEUE_LEN - 1, items[QUEUE_LEN - 1]);
+    TEST_ASSERT_EQUAL(0, xQueueReceiveMultiple(queue, items, QUEUE_LEN, 1));
+
+    vQueueDelete(queue);
+}
+
+typedef struct {
+    QueueHandle_t queue;
+    SemaphoreHandle_t done;
+} producer_args_t;
+
+static void batch_producer(void *arg)
+{
+    producer_args_t *args = (producer_args_t *) arg;
+    uint32_t items[BATCH_LEN];
+    uint32_t next = 0;
+
+    while (next < ITEMS_TOTAL) {
+        int count = (ITEMS_TOTAL - next < BATCH_LEN) ? ITEMS_TOTAL - next : BATCH_LEN;
+        for (int i = 0; i < count; i++) {
+            items[i] = next + i;
+        }
+        /* Blocks until the consumer makes space, then sends what fits */
+        int sent = xQueueSendMultiple(args->queue, items, count, portMAX_DELAY);
+        TEST_ASSERT_GREATER_THAN(0, sent);
+        next += sent;
+    }
+    xSemaphoreGive(args->done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("xQueueSendMultiple and xQueueReceiveMultiple block and wake each other", "[freertos]")
+{
+    producer_args_t args = {
+        .queue = xQueueCreate(BATCH_LEN + 1, sizeof(uint32_t)),
+        .done = xSemaphoreCreateBinary(),
+    };
+    uint32_t items[BATCH_LEN * 2];
+    uint32_t next = 0;
+
+    TEST_ASSERT_NOT_NULL(args.queue);
+    for (int cpu = 0; cpu < portNUM_PROCESSORS; cpu++) {
+        next = 0;
+        xTaskCreatePinnedToCore(batch_producer, "producer", 2048, &args, UNITY_FREERTOS_PRIORITY, NULL, cpu);
+        while (next < ITEMS_TOTAL) {
+            int received = xQueueReceiveMultiple(args.queue, items, BATCH_LEN * 2, 1000 / portTICK_PERIOD_MS);
+            TEST_ASSERT_GREATER_THAN(0, received);
+            for (int i = 0; i < received; i++) {
+                TEST_ASSERT_EQUAL(next++, items[i]);
+            }
+        }
+        TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(args.done, 1000 / portTICK_PERIOD_MS));
+    }
+    vSemaphoreDelete(args.done);
+    vQueueDelete(args.queue);
+}
@@ -0,0 +1,146 @@
+/*
+ Benchmarks for context switch and queue send latency, with and without a
+ queue heavy load running on the other core.
+*/
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "unity.h"
+#include "soc/cpu.h"
+#include "test_utils.h"
+
+#define SWITCH_ROUNDS   2000
+#define SEND_OPS        1000
+
+static volatile bool s_load_running;
+
+static void queue_load_receiver(void *arg)
+{
+    QueueHandle_t queue = (QueueHandle_t) arg;
+    uint32_t item;
+
+    while (xQueueReceive(queue, &item, portMAX_DELAY) == pdTRUE && item != UINT32_MAX) {
+    }
+    vTaskDelete(NULL);
+}
+
+/* Keeps the scheduler lock busy from the other core: each item sent wakes up
+   the receiver task, which blocks again on the empty queue */
+static void queue_load_task(void *arg)
+{
+    SemaphoreHandle_t done = (SemaphoreHandle_t) arg;
+    QueueHandle_t queue = xQueueCreate(1, sizeof(uint32_t));
+    uint32_t item = 0;
+
+    xTaskCreatePinnedToCore(queue_load_receiver, "queue_load_rx", 2048, queue, UNITY_FREERTOS_PRIORITY, NULL, !UNITY_FREERTOS_CPU);
+    while (s_load_running) {
+        xQueueSend(queue, &item, portMAX_DELAY);
+        item = (item + 1) % UINT32_MAX;
+    }
+    item = UINT32_MAX;
+    xQueueSend(queue, &item, portMAX_DELAY);
+    vTaskDelay(1);
+    vQueueDelete(queue);
+    xSemaphoreGive(done);
+    vTaskDelete(NULL);
+}
+
+static SemaphoreHandle_t start_load(void)
+{
+    SemaphoreHandle_t done = xSemaphoreCreateBinary();
+    s_load_running = true;
+    xTaskCreatePinnedToCore(queue_load_task, "queue_load", 2048, done, UNITY_FREERTOS_PRIORITY - 1, NULL, !UNITY_FREERTOS_CPU);
+    vTaskDelay(2);
+    return done;
+}
+
+static void stop_load(SemaphoreHandle_t done)
+{
+    s_load_running = false;
+    xSemaphoreTake(done, portMAX_DELAY);
+    vSemaphoreDelete(done);
+}
+
+typedef struct {
+    TaskHandle_t peer;
+    SemaphoreHandle_t done;
+} ping_pong_t;
+
+static void pong_task(void *arg)
+{
+    ping_pong_t *pp = (ping_pong_t *) arg;
+
+    for (int i = 0; i < SWITCH_ROUNDS; i++) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        xTaskNotifyGive(pp->peer);
+    }
+    xSemaphoreGive(pp->done);
+    vTaskDelete(NULL);
+}
+
+/* Returns the average number of cycles per context switch between two tasks on this core */
+static uint32_t measure_context_switch(void)
+{
+    ping_pong_t pp = {
+        .peer = xTaskGetCurrentTaskHandle(),
+        .done = xSemaphoreCreateBinary(),
+    };
+    TaskHandle_t pong;
+    uint32_t start, end;
+
+    xTaskCreatePinnedToCore(pong_task, "pong", 2048, &pp, UNITY_FREERTOS_PRIORITY + 1, &pong, UNITY_FREERTOS_CPU);
+    RSR(CCOUNT, start);
+    for (int i = 0; i < SWITCH_ROUNDS; i++) {
+        xTaskNotifyGive(pong);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+    RSR(CCOUNT, end);
+    xSemaphoreTake(pp.done, portMAX_DELAY);
+    vSemaphoreDelete(pp.done);
+    /* Each round switches to the pong task and back */
+    return (end - start) / (SWITCH_ROUNDS * 2);
+}
+
+/* Returns the average number of cycles per xQueueSend into a queue with free space */
+static uint32_t measure_queue_send(void)
+{
+    QueueHandle_t queue = xQueueCreate(SEND_OPS, sizeof(uint32_t));
+    uint32_t start, end;
+
+    TEST_ASSERT_NOT_NULL(queue);
+    RSR(CCOUNT, start);
+    for (uint32_t i = 0; i < SEND_OPS; i++) {
+        xQueueSend(queue, &i, 0);
+    }
+    RSR(CCOUNT, end);
+    vQueueDelete(queue);
+    return (end - start) / SEND_OPS;
+}
+
+TEST_CASE("context switch latency", "[freertos]")
+{
+    uint32_t idle = measure_context_switch();
+    printf("context switch: %d cycles\n", idle);
+#if portNUM_PROCESSORS == 2
+    SemaphoreHandle_t load = start_load();
+    uint32_t loaded = measure_context_switch();
+    stop_load(load);
+    printf("context switch, queue load on other core: %d cycles\n", loaded);
+#endif
+}
+
+TEST_CASE("xQueueSend latency", "[freertos]")
+{
+    uint32_t idle = measure_queue_send();
+    printf("xQueueSend: %d cycles\n", idle);
+#if portNUM_PROCESSORS == 2
+    SemaphoreHandle_t load = start_load();
+    uint32_t loaded = measure_queue_send();
+    stop_load(load);
+    printf("xQueueSend, queue load on other core: %d cycles\n", loaded);
+#endif
+}
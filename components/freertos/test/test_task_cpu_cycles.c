@@ -0,0 +1,71 @@
+/*
+ Test per-task CPU cycle counters and task switch samples
+*/
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "unity.h"
+#include "test_utils.h"
+#include "esp32/clk.h"
+
+#ifdef CONFIG_FREERTOS_TASK_CPU_CYCLES
+
+#define BUSY_TIME_MS    100
+
+static void busy_task(void *arg)
+{
+    uint32_t start = xthal_get_ccount();
+    uint32_t busy_cycles = esp_clk_cpu_freq() / 1000 * BUSY_TIME_MS;
+    while (xthal_get_ccount() - start < busy_cycles) {
+        ;
+    }
+    xSemaphoreGive((SemaphoreHandle_t) arg);
+    vTaskSuspend(NULL);
+}
+
+TEST_CASE("Task CPU cycles count the time a task has been running", "[freertos]")
+{
+    SemaphoreHandle_t done = xSemaphoreCreateBinary();
+    TaskHandle_t task;
+    xTaskCreatePinnedToCore(busy_task, "busy", 2048, done, UNITY_FREERTOS_PRIORITY + 1, &task, UNITY_FREERTOS_CPU);
+    TEST_ASSERT_TRUE(xSemaphoreTake(done, 1000 / portTICK_PERIOD_MS));
+    vTaskDelay(1);
+
+    uint32_t expected = esp_clk_cpu_freq() / 1000 * BUSY_TIME_MS;
+    uint32_t cycles = ulTaskGetCpuCycles(task);
+    printf("busy task ran for %u cycles, expected %u\n", cycles, expected);
+    TEST_ASSERT_UINT32_WITHIN(expected / 10, expected, cycles);
+    vTaskDelete(task);
+    vSemaphoreDelete(done);
+}
+
+#if CONFIG_FREERTOS_TASK_SWITCH_SAMPLES > 0
+TEST_CASE("Task switch samples can be read without suspending the scheduler", "[freertos]")
+{
+    TaskSwitchSample_t samples[CONFIG_FREERTOS_TASK_SWITCH_SAMPLES];
+    uint32_t sequence = 0;
+    /* Skip the samples recorded before */
+    while (uxTaskGetSwitchSamples(xPortGetCoreID(), &sequence, samples, CONFIG_FREERTOS_TASK_SWITCH_SAMPLES) > 0) {
+        ;
+    }
+    uint32_t start = sequence;
+    vTaskDelay(2);
+    UBaseType_t count = uxTaskGetSwitchSamples(xPortGetCoreID(), &sequence, samples, CONFIG_FREERTOS_TASK_SWITCH_SAMPLES);
+    TEST_ASSERT_GREATER_THAN(0, count);
+    TEST_ASSERT_EQUAL(start + count, sequence);
+
+    /* the test task has blocked, so it is switched out at least once */
+    bool found = false;
+    for (int i = 0; i < count; ++i) {
+        if (samples[i].xHandle == xTaskGetCurrentTaskHandle()) {
+            found = true;
+        }
+    }
+    TEST_ASSERT_TRUE(found);
+}
+#endif // CONFIG_FREERTOS_TASK_SWITCH_SAMPLES > 0
+
+#endif // CONFIG_FREERTOS_TASK_CPU_CYCLES
@@ -0,0 +1,61 @@
+/*
+ Tests for creating tasks with the stack allocated using heap capabilities
+*/
+
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "soc/soc_memory_layout.h"
+#include "unity.h"
+#include "test_utils.h"
+
+static void stack_check_task(void *arg)
+{
+    SemaphoreHandle_t done = (SemaphoreHandle_t) arg;
+    volatile uint8_t buf[256];
+
+    /* Use some of the stack */
+    for (int i = 0; i < sizeof(buf); i++) {
+        buf[i] = i;
+    }
+    xSemaphoreGive(done);
+    vTaskDelete(NULL);
+}
+
+static void test_create_with_caps(uint32_t caps, bool (*check)(const void *))
+{
+    SemaphoreHandle_t done = xSemaphoreCreateBinary();
+    TaskHandle_t task;
+
+    vTaskSuspendAll();
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreateWithCaps(stack_check_task, "caps", 2048, done, UNITY_FREERTOS_PRIORITY, &task, caps));
+    TEST_ASSERT_TRUE(check(pxTaskGetStackStart(task)));
+    xTaskResumeAll();
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(done, 1000 / portTICK_PERIOD_MS));
+    vTaskDelay(2); /* let the idle task free the task memory */
+    vSemaphoreDelete(done);
+}
+
+TEST_CASE("xTaskCreateWithCaps allocates the stack with the given caps", "[freertos]")
+{
+    test_create_with_caps(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, esp_ptr_internal);
+#if CONFIG_SPIRAM_ALLOW_STACK_EXTERNAL_MEMORY
+    test_create_with_caps(MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT, esp_ptr_external_ram);
+#endif
+}
+
+TEST_CASE("xTaskCreateWithCaps rejects memory that can't hold a stack", "[freertos]")
+{
+    TaskHandle_t task = NULL;
+
+    /* IRAM is not byte accessible */
+    TEST_ASSERT_EQUAL(errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY,
+                      xTaskCreateWithCaps(stack_check_task, "caps", 2048, NULL, UNITY_FREERTOS_PRIORITY, &task, MALLOC_CAP_EXEC));
+#if CONFIG_SPIRAM_SUPPORT && !CONFIG_SPIRAM_ALLOW_STACK_EXTERNAL_MEMORY
+    TEST_ASSERT_EQUAL(errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY,
+                      xTaskCreateWithCaps(stack_check_task, "caps", 2048, NULL, UNITY_FREERTOS_PRIORITY, &task, MALLOC_CAP_SPIRAM));
+#endif
+    TEST_ASSERT_NULL(task);
+}
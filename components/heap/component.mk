@@ -2,7 +2,13 @@
 # Component Makefile
 #
 
-COMPONENT_OBJS := heap_caps_init.o heap_caps.o multi_heap.o
+COMPONENT_OBJS := heap_caps_init.o heap_caps.o heap_caps_pool.o heap_caps_arena.o heap_caps_trend.o
+
+ifdef CONFIG_HEAP_ALLOCATOR_TLSF
+COMPONENT_OBJS += multi_heap_tlsf.o
+else
+COMPONENT_OBJS += multi_heap.o
+endif
 
 ifndef CONFIG_HEAP_POISONING_DISABLED
 COMPONENT_OBJS += multi_heap_poisoning.o
@@ -18,6 +24,12 @@ COMPONENT_OBJS += heap_trace_standalone.o
 
 endif
 
+ifdef CONFIG_HEAP_TRACING_SAMPLING
+
+COMPONENT_OBJS += heap_trace_sampling.o
+
+endif
+
 ifdef CONFIG_HEAP_TRACING
 
 WRAP_FUNCTIONS = calloc malloc free realloc heap_caps_malloc heap_caps_free heap_caps_realloc heap_caps_malloc_default heap_caps_realloc_default
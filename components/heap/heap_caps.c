@@ -21,6 +21,10 @@
 #include "multi_heap.h"
 #include "esp_log.h"
 #include "heap_private.h"
+#include "multi_heap_internal.h"
+#ifdef CONFIG_HEAP_SMALL_CACHE
+#include "freertos/task.h"
+#endif
 
 /*
 This file, combined with a region allocator that supports multiple heaps, solves the problem that the ESP32 has RAM
@@ -52,13 +56,16 @@ IRAM_ATTR static void *dram_alloc_to_iram_addr(void *addr, size_t len)
 
 bool heap_caps_match(const heap_t *heap, uint32_t caps)
 {
+    caps &= ~MALLOC_CAP_HINTS;
     return heap->heap != NULL && ((get_all_caps(heap) & caps) == caps);
 }
 
+static heap_t *find_containing_heap(void *ptr);
+
 /*
-Routine to allocate a bit of memory with certain capabilities. caps is a bitfield of MALLOC_CAP_* bits.
+Allocate memory with certain capabilities from the heaps, without going through the small object cache.
 */
-IRAM_ATTR void *heap_caps_malloc( size_t size, uint32_t caps )
+IRAM_ATTR static void *heap_caps_malloc_base( size_t size, uint32_t caps )
 {
     void *ret = NULL;
 
@@ -121,6 +128,252 @@ IRAM_ATTR void *heap_caps_malloc( size_t size, uint32_t caps )
     return NULL;
 }
 
+#ifdef CONFIG_HEAP_SMALL_CACHE
+/*
+Small object cache.
+
+Each CPU core keeps a small stack ("magazine") of free blocks for each size class, so most malloc/free
+calls for small sizes only take that core's own spinlock and never the heap's lock, which both cores contend on.
+Magazines are refilled from the heap, and spilled back to it, half a magazine at a time.
+
+Cached blocks stay allocated as far as the heap is concerned. They are returned to the heaps by
+heap_caps_small_cache_flush(), which also happens automatically before an allocation fails.
+*/
+
+/* Only requests which any internal default heap can satisfy are served from the cache */
+#define SMALL_CACHE_CAPS (MALLOC_CAP_DEFAULT | MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT | MALLOC_CAP_32BIT)
+#define SMALL_CACHE_CLASS_COUNT 8
+#define SMALL_CACHE_MAX_SIZE 256
+#define SMALL_CACHE_BATCH (CONFIG_HEAP_SMALL_CACHE_DEPTH / 2)
+
+static const uint16_t s_small_cache_class_size[SMALL_CACHE_CLASS_COUNT] = { 16, 32, 48, 64, 96, 128, 192, SMALL_CACHE_MAX_SIZE };
+
+typedef struct {
+    portMUX_TYPE mux;
+    uint8_t count[SMALL_CACHE_CLASS_COUNT];
+    void *blocks[SMALL_CACHE_CLASS_COUNT][CONFIG_HEAP_SMALL_CACHE_DEPTH];
+} small_cache_t;
+
+static small_cache_t s_small_cache[portNUM_PROCESSORS] = {
+    [0 ... portNUM_PROCESSORS - 1] = { .mux = portMUX_INITIALIZER_UNLOCKED }
+};
+
+/* Smallest class which can hold 'size' bytes, or -1 */
+IRAM_ATTR static int small_cache_class_for_request(size_t size)
+{
+    for (int i = 0; i < SMALL_CACHE_CLASS_COUNT; i++) {
+        if (size <= s_small_cache_class_size[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Largest class which a block of 'size' bytes can serve, or -1 */
+IRAM_ATTR static int small_cache_class_for_block(size_t size)
+{
+    if (size > SMALL_CACHE_MAX_SIZE) {
+        return -1;
+    }
+    for (int i = SMALL_CACHE_CLASS_COUNT - 1; i >= 0; i--) {
+        if (size >= s_small_cache_class_size[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Free blocks straight to their heaps */
+IRAM_ATTR static void small_cache_release(void **blocks, int count)
+{
+    for (int i = 0; i < count; i++) {
+        heap_t *heap = find_containing_heap(blocks[i]);
+        assert(heap != NULL);
+        multi_heap_free(heap->heap, blocks[i]);
+    }
+}
+
+IRAM_ATTR static void *small_cache_malloc(size_t size)
+{
+    int cls = small_cache_class_for_request(size);
+    small_cache_t *cache = &s_small_cache[xPortGetCoreID()];
+    void *ret = NULL;
+
+    portENTER_CRITICAL(&cache->mux);
+    if (cache->count[cls] > 0) {
+        ret = cache->blocks[cls][--cache->count[cls]];
+    }
+    portEXIT_CRITICAL(&cache->mux);
+    if (ret != NULL) {
+        return ret;
+    }
+
+    /* Magazine is empty, allocate a batch from the heap the first block comes from, holding its lock once */
+    const size_t class_size = s_small_cache_class_size[cls];
+    ret = heap_caps_malloc_base(class_size, SMALL_CACHE_CAPS);
+    if (ret == NULL) {
+        return NULL;
+    }
+    void *batch[SMALL_CACHE_BATCH];
+    int batch_count = 0;
+    heap_t *heap = find_containing_heap(ret);
+    multi_heap_internal_lock(heap->heap);
+    while (batch_count < SMALL_CACHE_BATCH) {
+        void *p = multi_heap_malloc(heap->heap, class_size);
+        if (p == NULL) {
+            break;
+        }
+        batch[batch_count++] = p;
+    }
+    multi_heap_internal_unlock(heap->heap);
+
+    /* The task may run on the other core by now, that's fine as the spinlock protects either magazine */
+    cache = &s_small_cache[xPortGetCoreID()];
+    portENTER_CRITICAL(&cache->mux);
+    while (batch_count > 0 && cache->count[cls] < CONFIG_HEAP_SMALL_CACHE_DEPTH) {
+        cache->blocks[cls][cache->count[cls]++] = batch[--batch_count];
+    }
+    portEXIT_CRITICAL(&cache->mux);
+    small_cache_release(batch, batch_count);
+
+    return ret;
+}
+
+/* Returns true if 'ptr' was taken by the cache */
+IRAM_ATTR static bool small_cache_free(heap_t *heap, void *ptr)
+{
+    if (!heap_caps_match(heap, SMALL_CACHE_CAPS)) {
+        return false;
+    }
+    int cls = small_cache_class_for_block(multi_heap_get_allocated_size(heap->heap, ptr));
+    if (cls < 0) {
+        return false;
+    }
+
+    void *spill[SMALL_CACHE_BATCH];
+    int spill_count = 0;
+    small_cache_t *cache = &s_small_cache[xPortGetCoreID()];
+    portENTER_CRITICAL(&cache->mux);
+    if (cache->count[cls] == CONFIG_HEAP_SMALL_CACHE_DEPTH) {
+        /* Magazine is full, return the older half to the heap */
+        spill_count = SMALL_CACHE_BATCH;
+        memcpy(spill, cache->blocks[cls], sizeof(spill));
+        memmove(cache->blocks[cls], cache->blocks[cls] + spill_count,
+                (CONFIG_HEAP_SMALL_CACHE_DEPTH - spill_count) * sizeof(void *));
+        cache->count[cls] -= spill_count;
+    }
+    cache->blocks[cls][cache->count[cls]++] = ptr;
+    portEXIT_CRITICAL(&cache->mux);
+    small_cache_release(spill, spill_count);
+    return true;
+}
+
+/* Return every cached block to its heap, returns the number of blocks returned */
+IRAM_ATTR static int small_cache_flush(void)
+{
+    void *blocks[CONFIG_HEAP_SMALL_CACHE_DEPTH];
+    int total = 0;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        small_cache_t *cache = &s_small_cache[core];
+        for (int cls = 0; cls < SMALL_CACHE_CLASS_COUNT; cls++) {
+            portENTER_CRITICAL(&cache->mux);
+            int count = cache->count[cls];
+            memcpy(blocks, cache->blocks[cls], count * sizeof(void *));
+            cache->count[cls] = 0;
+            portEXIT_CRITICAL(&cache->mux);
+            small_cache_release(blocks, count);
+            total += count;
+        }
+    }
+    return total;
+}
+#endif // CONFIG_HEAP_SMALL_CACHE
+
+void heap_caps_small_cache_flush(void)
+{
+#ifdef CONFIG_HEAP_SMALL_CACHE
+    small_cache_flush();
+#endif
+}
+
+/*
+Placement hints are not heap capabilities: they select the kind of memory which is tried first.
+Returns 0 if the other caps already fix the placement.
+*/
+IRAM_ATTR static inline uint32_t hint_preferred_caps( uint32_t caps )
+{
+    if (caps & (MALLOC_CAP_INTERNAL | MALLOC_CAP_SPIRAM)) {
+        return 0;
+    }
+    return (caps & MALLOC_CAP_HOT) ? MALLOC_CAP_INTERNAL : MALLOC_CAP_SPIRAM;
+}
+
+IRAM_ATTR static void *heap_caps_malloc_hinted( size_t size, uint32_t caps )
+{
+    uint32_t preferred = hint_preferred_caps(caps);
+    void *ret = NULL;
+
+    caps &= ~MALLOC_CAP_HINTS;
+    if (preferred != 0) {
+        ret = heap_caps_malloc(size, caps | preferred);
+    }
+    if (ret == NULL) {
+        ret = heap_caps_malloc(size, caps);
+    }
+    return ret;
+}
+
+/*
+Allocate memory, serving small requests from the cache. Doesn't count the block for the task.
+*/
+IRAM_ATTR static void *heap_caps_malloc_untracked( size_t size, uint32_t caps )
+{
+#ifdef CONFIG_HEAP_SMALL_CACHE
+    void *ret = NULL;
+    if (size > 0 && size <= SMALL_CACHE_MAX_SIZE && (caps & ~SMALL_CACHE_CAPS) == 0) {
+        ret = small_cache_malloc(size);
+        if (ret != NULL) {
+            return ret;
+        }
+    }
+    ret = heap_caps_malloc_base(size, caps);
+    if (ret == NULL && size > 0 && small_cache_flush() > 0) {
+        // memory held in the cache may be enough to satisfy this request
+        ret = heap_caps_malloc_base(size, caps);
+    }
+    return ret;
+#else
+    return heap_caps_malloc_base(size, caps);
+#endif
+}
+
+/* Count a block returned by heap_caps_malloc for the current task */
+IRAM_ATTR static inline void *track_alloc(void *ptr)
+{
+#ifdef CONFIG_HEAP_TASK_TRACKING
+    if (ptr != NULL) {
+        void *block = ptr;
+        if (esp_ptr_in_diram_iram(block)) {
+            // see dram_alloc_to_iram_addr
+            block = (void *)((uint32_t *)block)[-1];
+        }
+        heap_task_track_alloc(find_containing_heap(block), block);
+    }
+#endif
+    return ptr;
+}
+
+/*
+Routine to allocate a bit of memory with certain capabilities. caps is a bitfield of MALLOC_CAP_* bits.
+*/
+IRAM_ATTR void *heap_caps_malloc( size_t size, uint32_t caps )
+{
+    if (caps & MALLOC_CAP_HINTS) {
+        return heap_caps_malloc_hinted(size, caps);
+    }
+    return track_alloc(heap_caps_malloc_untracked(size, caps));
+}
+
 
 #define MALLOC_DISABLE_EXTERNAL_ALLOCS -1
 //Dual-use: -1 (=MALLOC_DISABLE_EXTERNAL_ALLOCS) disables allocations in external memory, >=0 sets the limit for allocations preferring internal memory.
@@ -241,6 +494,28 @@ IRAM_ATTR static heap_t *find_containing_heap(void *ptr )
 {
     intptr_t p = (intptr_t)ptr;
     heap_t *heap;
+
+    const heap_lookup_table_t *table = heap_lookup_table;
+    if (table != NULL && table->count > 0) {
+        /* binary search for the last heap starting at or before ptr */
+        size_t lo = 0;
+        size_t hi = table->count;
+        while (hi - lo > 1) {
+            size_t mid = (lo + hi) / 2;
+            if (table->heaps[mid]->start <= p) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        heap = table->heaps[lo];
+        if (heap->heap != NULL && p >= heap->start && p < heap->end) {
+            return heap;
+        }
+    }
+
+    /* Not found in the table. ptr is outside every heap, or is in a heap's region past the end
+       of another heap added inside that region at runtime, or the table is out of date. */
     SLIST_FOREACH(heap, &registered_heaps, next) {
         if (heap->heap != NULL && p >= heap->start && p < heap->end) {
             return heap;
@@ -265,10 +540,18 @@ IRAM_ATTR void heap_caps_free( void *ptr)
 
     heap_t *heap = find_containing_heap(ptr);
     assert(heap != NULL && "free() target pointer is outside heap areas");
+#ifdef CONFIG_HEAP_TASK_TRACKING
+    heap_task_track_free(heap, ptr);
+#endif
+#ifdef CONFIG_HEAP_SMALL_CACHE
+    if (small_cache_free(heap, ptr)) {
+        return;
+    }
+#endif
     multi_heap_free(heap->heap, ptr);
 }
 
-IRAM_ATTR void *heap_caps_realloc( void *ptr, size_t size, int caps)
+IRAM_ATTR static void *heap_caps_realloc_base( void *ptr, size_t size, uint32_t caps)
 {
     if (ptr == NULL) {
         return heap_caps_malloc(size, caps);
@@ -294,7 +577,13 @@ IRAM_ATTR void *heap_caps_realloc( void *ptr, size_t size, int caps)
     if (compatible_caps) {
         // try to reallocate this memory within the same heap
         // (which will resize the block if it can)
+#ifdef CONFIG_HEAP_TASK_TRACKING
+        heap_task_track_free(heap, ptr);
+        void *r = multi_heap_realloc(heap->heap, ptr, size);
+        heap_task_track_alloc(heap, (r != NULL) ? r : ptr);
+#else
         void *r = multi_heap_realloc(heap->heap, ptr, size);
+#endif
         if (r != NULL) {
             return r;
         }
@@ -313,6 +602,26 @@ IRAM_ATTR void *heap_caps_realloc( void *ptr, size_t size, int caps)
     return NULL;
 }
 
+IRAM_ATTR void *heap_caps_realloc( void *ptr, size_t size, int caps)
+{
+    if (ptr != NULL && size > 0 && (caps & MALLOC_CAP_HINTS)) {
+        // keep the block in place if it is already in the preferred memory,
+        // otherwise move it there, and only then consider any other memory
+        uint32_t preferred = hint_preferred_caps(caps);
+        void *r = NULL;
+
+        caps &= ~MALLOC_CAP_HINTS;
+        if (preferred != 0) {
+            r = heap_caps_realloc_base(ptr, size, caps | preferred);
+        }
+        if (r == NULL) {
+            r = heap_caps_realloc_base(ptr, size, caps);
+        }
+        return r;
+    }
+    return heap_caps_realloc_base(ptr, size, caps);
+}
+
 IRAM_ATTR void *heap_caps_calloc( size_t n, size_t size, uint32_t caps)
 {
     void *result;
@@ -378,8 +687,13 @@ void heap_caps_get_info( multi_heap_info_t *info, uint32_t caps )
             info->allocated_blocks += hinfo.allocated_blocks;
             info->free_blocks += hinfo.free_blocks;
             info->total_blocks += hinfo.total_blocks;
+            for (int i = 0; i < MULTI_HEAP_HISTOGRAM_BUCKETS; i++) {
+                info->free_block_histogram[i] += hinfo.free_block_histogram[i];
+            }
+            heap_caps_pool_add_info(heap, info);
         }
     }
+    multi_heap_update_fragmentation(info);
 }
 
 void heap_caps_print_heap_info( uint32_t caps )
@@ -393,15 +707,24 @@ void heap_caps_print_heap_info( uint32_t caps )
 
             printf("  At 0x%08x len %d free %d allocated %d min_free %d\n",
                    heap->start, heap->end - heap->start, info.total_free_bytes, info.total_allocated_bytes, info.minimum_free_bytes);
-            printf("    largest_free_block %d alloc_blocks %d free_blocks %d total_blocks %d\n",
+            printf("    largest_free_block %d alloc_blocks %d free_blocks %d total_blocks %d fragmentation %d%%\n",
                    info.largest_free_block, info.allocated_blocks,
-                   info.free_blocks, info.total_blocks);
+                   info.free_blocks, info.total_blocks, info.fragmentation);
+            heap_caps_pool_print_info(heap);
         }
     }
     printf("  Totals:\n");
     heap_caps_get_info(&info, caps);
 
-    printf("    free %d allocated %d min_free %d largest_free_block %d\n", info.total_free_bytes, info.total_allocated_bytes, info.minimum_free_bytes, info.largest_free_block);
+    printf("    free %d allocated %d min_free %d largest_free_block %d fragmentation %d%%\n", info.total_free_bytes, info.total_allocated_bytes, info.minimum_free_bytes, info.largest_free_block, info.fragmentation);
+    printf("    free blocks by size:");
+    for (int i = 0; i < MULTI_HEAP_HISTOGRAM_BUCKETS; i++) {
+        printf(" %d", info.free_block_histogram[i]);
+    }
+    printf(" (<32, <64 ... >=32K)\n");
+    if (info.pool_allocated_bytes != 0 || info.pool_free_bytes != 0) {
+        printf("    pools allocated %d free %d\n", info.pool_allocated_bytes, info.pool_free_bytes);
+    }
 }
 
 bool heap_caps_check_integrity(uint32_t caps, bool print_errors)
@@ -0,0 +1,153 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <stdint.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+
+/*
+Arenas of bump-pointer allocations which are freed together.
+
+Chunks are kept in a singly linked list with the chunk currently being carved up at the head.
+Allocations too big to share a chunk get a dedicated chunk, inserted after the head so the rest
+of the head chunk can still be used.
+*/
+
+#define ARENA_ALIGN 4
+#define ARENA_ALIGN_UP(X) (((X) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+typedef struct arena_chunk {
+    struct arena_chunk *next;
+    size_t size;                /* bytes of data[] */
+    size_t used;                /* bytes of data[] handed out */
+    uint8_t data[];
+} arena_chunk_t;
+
+struct heap_caps_arena {
+    uint32_t caps;
+    size_t chunk_size;
+    arena_chunk_t *chunks;
+};
+
+static arena_chunk_t *arena_chunk_new(heap_caps_arena_handle_t arena, size_t size)
+{
+    arena_chunk_t *chunk = heap_caps_malloc(sizeof(arena_chunk_t) + size, arena->caps);
+    if (chunk != NULL) {
+        chunk->size = size;
+        chunk->used = 0;
+    }
+    return chunk;
+}
+
+heap_caps_arena_handle_t heap_caps_arena_create(size_t chunk_size, uint32_t caps)
+{
+    if (chunk_size < ARENA_ALIGN || chunk_size > SIZE_MAX / 2) {
+        return NULL;
+    }
+    heap_caps_arena_handle_t arena = heap_caps_malloc(sizeof(struct heap_caps_arena), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (arena == NULL) {
+        return NULL;
+    }
+    arena->caps = caps;
+    arena->chunk_size = ARENA_ALIGN_UP(chunk_size);
+    arena->chunks = NULL;
+    return arena;
+}
+
+void *heap_caps_arena_alloc(heap_caps_arena_handle_t arena, size_t size)
+{
+    if (size == 0 || size > SIZE_MAX / 2) {
+        return NULL;
+    }
+    size = ARENA_ALIGN_UP(size);
+
+    arena_chunk_t *head = arena->chunks;
+    if (head != NULL && head->size - head->used >= size) {
+        void *ret = head->data + head->used;
+        head->used += size;
+        return ret;
+    }
+
+    if (size > arena->chunk_size / 4) {
+        /* big allocation, give it a chunk of its own and keep using the current one */
+        arena_chunk_t *chunk = arena_chunk_new(arena, size);
+        if (chunk == NULL) {
+            return NULL;
+        }
+        chunk->used = size;
+        if (head != NULL) {
+            chunk->next = head->next;
+            head->next = chunk;
+        } else {
+            chunk->next = NULL;
+            arena->chunks = chunk;
+        }
+        return chunk->data;
+    }
+
+    arena_chunk_t *chunk = arena_chunk_new(arena, arena->chunk_size);
+    if (chunk == NULL) {
+        return NULL;
+    }
+    chunk->next = head;
+    arena->chunks = chunk;
+    chunk->used = size;
+    return chunk->data;
+}
+
+void *heap_caps_arena_calloc(heap_caps_arena_handle_t arena, size_t n, size_t size)
+{
+    size_t size_bytes;
+    if (__builtin_mul_overflow(n, size, &size_bytes)) {
+        return NULL;
+    }
+    void *ret = heap_caps_arena_alloc(arena, size_bytes);
+    if (ret != NULL) {
+        memset(ret, 0, size_bytes);
+    }
+    return ret;
+}
+
+void heap_caps_arena_reset(heap_caps_arena_handle_t arena)
+{
+    arena_chunk_t *keep = NULL;
+    arena_chunk_t *chunk = arena->chunks;
+    while (chunk != NULL) {
+        arena_chunk_t *next = chunk->next;
+        if (keep == NULL && chunk->size == arena->chunk_size) {
+            keep = chunk;
+        } else {
+            heap_caps_free(chunk);
+        }
+        chunk = next;
+    }
+    if (keep != NULL) {
+        keep->next = NULL;
+        keep->used = 0;
+    }
+    arena->chunks = keep;
+}
+
+void heap_caps_arena_destroy(heap_caps_arena_handle_t arena)
+{
+    if (arena == NULL) {
+        return;
+    }
+    arena_chunk_t *chunk = arena->chunks;
+    while (chunk != NULL) {
+        arena_chunk_t *next = chunk->next;
+        heap_caps_free(chunk);
+        chunk = next;
+    }
+    heap_caps_free(arena);
+}
@@ -29,6 +29,43 @@ static const char *TAG = "heap_init";
 /* Linked-list of registered heaps */
 struct registered_heap_ll registered_heaps;
 
+/* Sorted table of registered heaps, for find_containing_heap() */
+heap_lookup_table_t *volatile heap_lookup_table;
+
+/* Build a new lookup table from registered_heaps and publish it.
+
+   The previous table isn't freed, as a concurrent free() may still be searching it. New tables
+   are only built at startup and by heap_caps_add_region(), so this leaks very little.
+*/
+static void update_heap_lookup_table(void)
+{
+    size_t count = 0;
+    heap_t *heap;
+    SLIST_FOREACH(heap, &registered_heaps, next) {
+        count++;
+    }
+
+    heap_lookup_table_t *table = heap_caps_malloc(sizeof(heap_lookup_table_t) + count * sizeof(heap_t *),
+                                                  MALLOC_CAP_INTERNAL|MALLOC_CAP_8BIT);
+    if (table == NULL) {
+        return; /* lookups fall back to walking registered_heaps */
+    }
+
+    /* insertion sort by start address, keeping list order for equal starts */
+    table->count = 0;
+    SLIST_FOREACH(heap, &registered_heaps, next) {
+        size_t i = table->count++;
+        while (i > 0 && table->heaps[i - 1]->start > heap->start) {
+            table->heaps[i] = table->heaps[i - 1];
+            i--;
+        }
+        table->heaps[i] = heap;
+    }
+
+    __sync_synchronize();
+    heap_lookup_table = table;
+}
+
 static void register_heap(heap_t *region)
 {
     size_t heap_size = region->end - region->start;
@@ -152,6 +189,8 @@ void heap_caps_init()
             SLIST_INSERT_AFTER(&heaps_array[i-1], &heaps_array[i], next);
         }
     }
+
+    update_heap_lookup_table();
 }
 
 esp_err_t heap_caps_add_region(intptr_t start, intptr_t end)
@@ -231,6 +270,7 @@ esp_err_t heap_caps_add_region_with_caps(const uint32_t caps[], intptr_t start,
     static _lock_t registered_heaps_write_lock;
     _lock_acquire(&registered_heaps_write_lock);
     SLIST_INSERT_HEAD(&registered_heaps, p_new, next);
+    update_heap_lookup_table();
     _lock_release(&registered_heaps_write_lock);
 
     err = ESP_OK;
@@ -0,0 +1,171 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <sys/lock.h>
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "heap_private.h"
+
+/*
+Pools of fixed size objects.
+
+All objects of a pool live in one block allocated with the requested capabilities. Free objects
+are kept in a singly linked list threaded through the objects themselves, so there is no per-object
+overhead and alloc/free are a list push or pop under the pool's spinlock.
+
+The pool control structure is always in internal RAM, so its spinlock works even if the objects
+are in SPI RAM.
+*/
+
+typedef struct pool_free_obj {
+    struct pool_free_obj *next;
+} pool_free_obj_t;
+
+struct heap_caps_pool {
+    portMUX_TYPE mux;
+    uint8_t *storage;
+    size_t obj_size;
+    size_t count;
+    size_t free_count;
+    pool_free_obj_t *free_list;
+    SLIST_ENTRY(heap_caps_pool) next;
+};
+
+/* All pools, for reporting usage. Protected by s_pools_lock. */
+static SLIST_HEAD(pool_ll, heap_caps_pool) s_pools = SLIST_HEAD_INITIALIZER(s_pools);
+static _lock_t s_pools_lock;
+
+heap_caps_pool_handle_t heap_caps_pool_create(size_t obj_size, size_t count, uint32_t caps)
+{
+    size_t storage_size;
+
+    if (obj_size == 0 || count == 0) {
+        return NULL;
+    }
+    obj_size = (obj_size + 3) & ~3;
+    if (obj_size < sizeof(pool_free_obj_t) || __builtin_mul_overflow(obj_size, count, &storage_size)) {
+        return NULL;
+    }
+
+    heap_caps_pool_handle_t pool = heap_caps_malloc(sizeof(struct heap_caps_pool), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->storage = heap_caps_malloc(storage_size, caps);
+    if (pool->storage == NULL) {
+        heap_caps_free(pool);
+        return NULL;
+    }
+    vPortCPUInitializeMutex(&pool->mux);
+    pool->obj_size = obj_size;
+    pool->count = count;
+    pool->free_count = count;
+
+    /* thread the free list in address order, so objects are handed out from the start of the block */
+    pool->free_list = NULL;
+    for (size_t i = count; i > 0; i--) {
+        pool_free_obj_t *obj = (pool_free_obj_t *)(pool->storage + (i - 1) * obj_size);
+        obj->next = pool->free_list;
+        pool->free_list = obj;
+    }
+
+    _lock_acquire(&s_pools_lock);
+    SLIST_INSERT_HEAD(&s_pools, pool, next);
+    _lock_release(&s_pools_lock);
+    return pool;
+}
+
+void heap_caps_pool_delete(heap_caps_pool_handle_t pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+    _lock_acquire(&s_pools_lock);
+    SLIST_REMOVE(&s_pools, pool, heap_caps_pool, next);
+    _lock_release(&s_pools_lock);
+    heap_caps_free(pool->storage);
+    heap_caps_free(pool);
+}
+
+IRAM_ATTR void *heap_caps_pool_alloc(heap_caps_pool_handle_t pool)
+{
+    portENTER_CRITICAL(&pool->mux);
+    pool_free_obj_t *obj = pool->free_list;
+    if (obj != NULL) {
+        pool->free_list = obj->next;
+        pool->free_count--;
+    }
+    portEXIT_CRITICAL(&pool->mux);
+    return obj;
+}
+
+IRAM_ATTR void heap_caps_pool_free(heap_caps_pool_handle_t pool, void *obj)
+{
+    if (obj == NULL) {
+        return;
+    }
+    size_t offset = (uint8_t *)obj - pool->storage;
+    assert((uint8_t *)obj >= pool->storage && offset < pool->count * pool->obj_size
+           && "heap_caps_pool_free() object is outside the pool");
+    assert(offset % pool->obj_size == 0 && "heap_caps_pool_free() object is not at the start of an object");
+    (void)offset;
+
+    portENTER_CRITICAL(&pool->mux);
+    assert(pool->free_count < pool->count && "heap_caps_pool_free() called more times than heap_caps_pool_alloc()");
+    pool_free_obj_t *free_obj = obj;
+    free_obj->next = pool->free_list;
+    pool->free_list = free_obj;
+    pool->free_count++;
+    portEXIT_CRITICAL(&pool->mux);
+}
+
+size_t heap_caps_pool_get_free_count(heap_caps_pool_handle_t pool)
+{
+    return pool->free_count;
+}
+
+static bool pool_in_heap(heap_caps_pool_handle_t pool, const heap_t *heap)
+{
+    return (intptr_t)pool->storage >= heap->start && (intptr_t)pool->storage < heap->end;
+}
+
+void heap_caps_pool_add_info(const heap_t *heap, multi_heap_info_t *info)
+{
+    heap_caps_pool_handle_t pool;
+    _lock_acquire(&s_pools_lock);
+    SLIST_FOREACH(pool, &s_pools, next) {
+        if (pool_in_heap(pool, heap)) {
+            size_t free_count = pool->free_count;
+            info->pool_allocated_bytes += (pool->count - free_count) * pool->obj_size;
+            info->pool_free_bytes += free_count * pool->obj_size;
+        }
+    }
+    _lock_release(&s_pools_lock);
+}
+
+void heap_caps_pool_print_info(const heap_t *heap)
+{
+    heap_caps_pool_handle_t pool;
+    _lock_acquire(&s_pools_lock);
+    SLIST_FOREACH(pool, &s_pools, next) {
+        if (pool_in_heap(pool, heap)) {
+            printf("    pool at %p object size %d used %d of %d objects\n",
+                   pool->storage, pool->obj_size, pool->count - pool->free_count, pool->count);
+        }
+    }
+    _lock_release(&s_pools_lock);
+}
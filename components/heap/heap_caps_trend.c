@@ -0,0 +1,92 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <stdbool.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/*
+Heap trends.
+
+A trend is a ring buffer of heap_caps_get_info() snapshots for one set of capabilities, taken
+whenever the application calls heap_caps_trend_sample(). Once the buffer is full the oldest
+sample is overwritten.
+*/
+
+struct heap_caps_trend {
+    portMUX_TYPE mux;
+    uint32_t caps;
+    size_t length;
+    size_t count;   /* number of valid samples */
+    size_t next;    /* index the next sample is written to */
+    heap_caps_trend_sample_t samples[];
+};
+
+heap_caps_trend_handle_t heap_caps_trend_create(uint32_t caps, size_t length)
+{
+    if (length == 0) {
+        return NULL;
+    }
+    heap_caps_trend_handle_t trend = heap_caps_calloc(1, sizeof(struct heap_caps_trend) + length * sizeof(heap_caps_trend_sample_t),
+                                                      MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (trend == NULL) {
+        return NULL;
+    }
+    vPortCPUInitializeMutex(&trend->mux);
+    trend->caps = caps;
+    trend->length = length;
+    return trend;
+}
+
+void heap_caps_trend_delete(heap_caps_trend_handle_t trend)
+{
+    heap_caps_free(trend);
+}
+
+void heap_caps_trend_sample(heap_caps_trend_handle_t trend)
+{
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, trend->caps);
+
+    heap_caps_trend_sample_t sample = {
+        .timestamp = xTaskGetTickCount(),
+        .total_free_bytes = info.total_free_bytes,
+        .largest_free_block = info.largest_free_block,
+        .minimum_free_bytes = info.minimum_free_bytes,
+        .free_blocks = info.free_blocks,
+        .fragmentation = info.fragmentation,
+    };
+
+    portENTER_CRITICAL(&trend->mux);
+    trend->samples[trend->next] = sample;
+    trend->next = (trend->next + 1) % trend->length;
+    if (trend->count < trend->length) {
+        trend->count++;
+    }
+    portEXIT_CRITICAL(&trend->mux);
+}
+
+size_t heap_caps_trend_get(heap_caps_trend_handle_t trend, heap_caps_trend_sample_t *samples, size_t max_samples)
+{
+    portENTER_CRITICAL(&trend->mux);
+    size_t count = (trend->count < max_samples) ? trend->count : max_samples;
+    /* return the newest 'count' samples, oldest first */
+    size_t start = (trend->next + trend->length - count) % trend->length;
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = trend->samples[(start + i) % trend->length];
+    }
+    portEXIT_CRITICAL(&trend->mux);
+    return count;
+}
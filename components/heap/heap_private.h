@@ -48,6 +48,20 @@ typedef struct heap_t_ {
 */
 extern SLIST_HEAD(registered_heap_ll, heap_t_) registered_heaps;
 
+/* All registered heaps sorted by start address, so the heap containing
+   an address can be found by binary search.
+
+   Rebuilt whenever a heap is added. May be NULL or out of date if
+   allocating a new table failed, so a lookup which finds nothing here
+   must fall back to walking registered_heaps.
+*/
+typedef struct {
+    size_t count;
+    heap_t *heaps[];
+} heap_lookup_table_t;
+
+extern heap_lookup_table_t *volatile heap_lookup_table;
+
 bool heap_caps_match(const heap_t *heap, uint32_t caps);
 
 /* return all possible capabilities (across all priorities) for a given heap */
@@ -63,6 +77,18 @@ inline static IRAM_ATTR uint32_t get_all_caps(const heap_t *heap)
     return all_caps;
 }
 
+/* Add usage of the pools whose storage is in 'heap' to 'info' (pool_allocated_bytes, pool_free_bytes) */
+void heap_caps_pool_add_info(const heap_t *heap, multi_heap_info_t *info);
+
+/* Print the pools whose storage is in 'heap' */
+void heap_caps_pool_print_info(const heap_t *heap);
+
+#ifdef CONFIG_HEAP_TASK_TRACKING
+/* Update the per-task counters for the block 'p' of 'heap' handed to the current task, or freed */
+void heap_task_track_alloc(heap_t *heap, void *p);
+void heap_task_track_free(heap_t *heap, void *p);
+#endif
+
 /*
  Because we don't want to add _another_ known allocation method to the stack of functions to trace wrt memory tracing,
  these are declared private. The newlib malloc()/realloc() implementation also calls these, so they are declared 
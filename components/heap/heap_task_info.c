@@ -12,9 +12,14 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <string.h>
+#include <sys/param.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <multi_heap.h>
+#include "esp_attr.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
 #include "multi_heap_internal.h"
 #include "heap_private.h"
 #include "esp_heap_task_info.h"
@@ -126,4 +131,148 @@ size_t heap_caps_get_per_task_info(heap_task_info_params_t *params)
     return params->max_blocks - remaining;
 }
 
+/*
+ * Incremental per-task totals.
+ *
+ * heap_caps.c reports every block handed to or returned by the application
+ * (blocks held by the small object cache count as free). The totals are kept in
+ * an open addressing hash table indexed by the task handle, so both updating
+ * and querying them is O(1) unless the table is nearly full. Entries are never
+ * removed, an entry whose task has no blocks left is reused for another task.
+ * If the table is full, the allocation isn't counted for any task.
+ */
+
+#define TASK_STATS_TABLE_SIZE CONFIG_HEAP_TASK_TRACKING_MAX_TASKS
+
+typedef struct {
+    bool used;
+    heap_task_stats_t stats;
+} task_stats_entry_t;
+
+static task_stats_entry_t s_task_stats[TASK_STATS_TABLE_SIZE];
+static size_t s_task_stats_untracked;
+static portMUX_TYPE s_task_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static IRAM_ATTR inline size_t task_stats_hash(TaskHandle_t task)
+{
+    return (((uintptr_t)task >> 2) * 2654435761u) % TASK_STATS_TABLE_SIZE;
+}
+
+static IRAM_ATTR inline bool task_stats_idle(const heap_task_stats_t *stats)
+{
+    for (int i = 0; i < HEAP_TASK_STATS_CAPS; i++) {
+        if (stats->count[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Find the entry of 'task'. If there is none and 'create' is set, make one. Call within critical. */
+static IRAM_ATTR heap_task_stats_t *task_stats_find(TaskHandle_t task, bool create)
+{
+    size_t index = task_stats_hash(task);
+    task_stats_entry_t *reusable = NULL;
+
+    for (size_t n = 0; n < TASK_STATS_TABLE_SIZE; n++) {
+        task_stats_entry_t *entry = &s_task_stats[index];
+        if (!entry->used) {
+            if (reusable == NULL) {
+                reusable = entry;
+            }
+            break;
+        }
+        if (entry->stats.task == task) {
+            return &entry->stats;
+        }
+        if (reusable == NULL && task_stats_idle(&entry->stats)) {
+            reusable = entry;
+        }
+        index = (index + 1) % TASK_STATS_TABLE_SIZE;
+    }
+    if (!create || reusable == NULL) {
+        return NULL;
+    }
+    reusable->used = true;
+    memset(&reusable->stats, 0, sizeof(reusable->stats));
+    reusable->stats.task = task;
+    return &reusable->stats;
+}
+
+static IRAM_ATTR inline int task_stats_caps_index(const heap_t *heap)
+{
+    return (get_all_caps(heap) & MALLOC_CAP_SPIRAM) ? HEAP_TASK_STATS_SPIRAM : HEAP_TASK_STATS_INTERNAL;
+}
+
+IRAM_ATTR void heap_task_track_alloc(heap_t *heap, void *p)
+{
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    size_t size = multi_heap_get_allocated_size(heap->heap, p);
+    int i = task_stats_caps_index(heap);
+
+    // Blocks handed out again by the small object cache still name their previous owner
+    multi_heap_set_allocated_owner(p);
+
+    portENTER_CRITICAL(&s_task_stats_mux);
+    heap_task_stats_t *stats = task_stats_find(task, true);
+    if (stats != NULL) {
+        stats->size[i] += size;
+        stats->count[i]++;
+        if (stats->size[i] > stats->peak_size[i]) {
+            stats->peak_size[i] = stats->size[i];
+        }
+    } else {
+        s_task_stats_untracked++;
+    }
+    portEXIT_CRITICAL(&s_task_stats_mux);
+}
+
+IRAM_ATTR void heap_task_track_free(heap_t *heap, void *p)
+{
+    TaskHandle_t task = (TaskHandle_t)multi_heap_get_allocated_owner(p);
+    size_t size = multi_heap_get_allocated_size(heap->heap, p);
+    int i = task_stats_caps_index(heap);
+
+    portENTER_CRITICAL(&s_task_stats_mux);
+    heap_task_stats_t *stats = task_stats_find(task, false);
+    // Blocks allocated while the table was full belong to no entry
+    if (stats != NULL && stats->count[i] > 0) {
+        stats->size[i] -= MIN(size, stats->size[i]);
+        stats->count[i]--;
+    }
+    portEXIT_CRITICAL(&s_task_stats_mux);
+}
+
+esp_err_t heap_caps_get_task_stats(TaskHandle_t task, heap_task_stats_t *stats)
+{
+    if (task == NULL) {
+        task = xTaskGetCurrentTaskHandle();
+    }
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+    portENTER_CRITICAL(&s_task_stats_mux);
+    heap_task_stats_t *found = task_stats_find(task, false);
+    if (found != NULL) {
+        *stats = *found;
+        err = ESP_OK;
+    }
+    portEXIT_CRITICAL(&s_task_stats_mux);
+    return err;
+}
+
+size_t heap_caps_get_all_task_stats(heap_task_stats_t *stats, size_t max_stats, size_t *untracked)
+{
+    size_t count = 0;
+    portENTER_CRITICAL(&s_task_stats_mux);
+    for (size_t i = 0; i < TASK_STATS_TABLE_SIZE && count < max_stats; i++) {
+        if (s_task_stats[i].used && !task_stats_idle(&s_task_stats[i].stats)) {
+            stats[count++] = s_task_stats[i].stats;
+        }
+    }
+    if (untracked != NULL) {
+        *untracked = s_task_stats_untracked;
+    }
+    portEXIT_CRITICAL(&s_task_stats_mux);
+    return count;
+}
+
 #endif // CONFIG_HEAP_TASK_TRACKING
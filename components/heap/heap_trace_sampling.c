@@ -0,0 +1,339 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <string.h>
+#include <stdio.h>
+#include <sdkconfig.h>
+
+#define HEAP_TRACE_SRCFILE /* don't warn on inclusion here */
+#include "esp_heap_trace.h"
+#undef HEAP_TRACE_SRCFILE
+
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+
+#define STACK_DEPTH CONFIG_HEAP_TRACING_STACK_DEPTH
+
+#if CONFIG_HEAP_TRACING_SAMPLING
+
+/* Sampling heap tracing
+
+   Instead of recording every allocation, a countdown of bytes is kept. Each allocation subtracts its size and
+   the allocation which takes the countdown to zero is sampled: its call stack is read and it is added to the
+   call site with the same call stack. The countdown is then restarted from a random value with a mean of
+   sample_interval, so that allocation patterns which repeat with a fixed period can't alias with the sampling.
+
+   An allocation of size S < sample_interval is therefore sampled with probability of about S / sample_interval,
+   so each sample stands for sample_interval bytes. Allocations of at least sample_interval bytes are always
+   sampled and stand for their own size.
+
+   Sampled allocations which have not been freed are kept in an open addressing hash table, keyed by address,
+   so that a free can be attributed back to the call site in constant time.
+*/
+
+#define CALLSITE_COUNT CONFIG_HEAP_TRACING_SAMPLING_CALLSITES
+#define SAMPLE_SLOTS CONFIG_HEAP_TRACING_SAMPLING_RECORDS
+/* Keep the hash table at most 3/4 full so probe sequences stay short */
+#define SAMPLE_MAX_LIVE (SAMPLE_SLOTS * 3 / 4)
+
+typedef struct {
+    void *address;       ///< Address of the sampled allocation, NULL if the slot is empty
+    uint32_t callsite;   ///< Index into callsites[]
+    size_t weight;       ///< Bytes this sample stands for
+} sample_t;
+
+static portMUX_TYPE trace_mux = portMUX_INITIALIZER_UNLOCKED;
+static bool tracing;
+
+static size_t sample_interval = CONFIG_HEAP_TRACING_SAMPLING_INTERVAL;
+
+/* Bytes left to allocate until the next sample. Decremented without taking trace_mux, the odd lost update only
+   moves the next sample by a few bytes. */
+static size_t bytes_until_sample;
+static uint32_t rng_state = 1;
+
+static heap_trace_callsite_t callsites[CALLSITE_COUNT];
+static size_t callsite_count;
+
+static sample_t samples[SAMPLE_SLOTS];
+static size_t live_count;
+
+/* Samples which could not be recorded because callsites[] or samples[] was full */
+static size_t dropped_samples;
+
+static IRAM_ATTR size_t next_sample_gap(void)
+{
+    /* xorshift32 */
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return 1 + rng_state % (2 * sample_interval);
+}
+
+/* Return true if an allocation of this size should be recorded. Called for every allocation while tracing,
+   so does as little as possible. */
+static inline IRAM_ATTR bool sample_allocation(size_t size)
+{
+    if (!tracing) {
+        return false;
+    }
+    if (size < bytes_until_sample) {
+        bytes_until_sample -= size;
+        return false;
+    }
+    return true;
+}
+
+#define TRACE_SAMPLE_ALLOCATION(size) sample_allocation(size)
+#define TRACE_FREE_CALLERS 0
+
+static inline IRAM_ATTR size_t sample_slot(const void *address)
+{
+    return (((uint32_t)address >> 2) * 2654435761u) % SAMPLE_SLOTS;
+}
+
+esp_err_t heap_trace_init_sampling(size_t interval)
+{
+    if (tracing) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (interval == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    sample_interval = interval;
+    return ESP_OK;
+}
+
+esp_err_t heap_trace_start(heap_trace_mode_t mode_param)
+{
+    (void) mode_param; // live bytes are always tracked per call site, so both modes are the same here
+
+    portENTER_CRITICAL(&trace_mux);
+
+    tracing = false;
+    memset(callsites, 0, sizeof(callsites));
+    memset(samples, 0, sizeof(samples));
+    callsite_count = 0;
+    live_count = 0;
+    dropped_samples = 0;
+    rng_state = (rng_state ^ xthal_get_ccount()) | 1; // xorshift32 gets stuck at zero
+    bytes_until_sample = next_sample_gap();
+    heap_trace_resume();
+
+    portEXIT_CRITICAL(&trace_mux);
+    return ESP_OK;
+}
+
+static esp_err_t set_tracing(bool enable)
+{
+    if (tracing == enable) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    tracing = enable;
+    return ESP_OK;
+}
+
+esp_err_t heap_trace_stop(void)
+{
+    return set_tracing(false);
+}
+
+esp_err_t heap_trace_resume(void)
+{
+    return set_tracing(true);
+}
+
+size_t heap_trace_get_count(void)
+{
+    return live_count;
+}
+
+esp_err_t heap_trace_get(size_t index, heap_trace_record_t *record)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+size_t heap_trace_get_callsite_count(void)
+{
+    return callsite_count;
+}
+
+esp_err_t heap_trace_get_callsite(size_t index, heap_trace_callsite_t *callsite)
+{
+    if (callsite == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t result = ESP_OK;
+
+    portENTER_CRITICAL(&trace_mux);
+    if (index >= callsite_count) {
+        result = ESP_ERR_INVALID_ARG;
+    } else {
+        memcpy(callsite, &callsites[index], sizeof(heap_trace_callsite_t));
+    }
+    portEXIT_CRITICAL(&trace_mux);
+    return result;
+}
+
+/* Return true if call site 'a' should be printed before call site 'b' */
+static bool dump_before(const heap_trace_callsite_t *a, size_t a_index, const heap_trace_callsite_t *b, size_t b_index)
+{
+    return a->live_bytes > b->live_bytes || (a->live_bytes == b->live_bytes && a_index < b_index);
+}
+
+void heap_trace_dump(void)
+{
+    size_t total_live = 0;
+    size_t count = heap_trace_get_callsite_count();
+
+    printf("%u call sites sampled every %u bytes\n", count, sample_interval);
+
+    /* Print in order of decreasing live bytes. Selecting the next call site each time is quadratic, but doesn't
+       need any memory and the number of call sites is small. */
+    heap_trace_callsite_t prev = { .live_bytes = 0 };
+    size_t prev_index = 0;
+    for (size_t n = 0; n < count; n++) {
+        heap_trace_callsite_t next = { .live_bytes = 0 }, site;
+        size_t next_index = SIZE_MAX;
+        for (size_t i = 0; i < count; i++) {
+            if (heap_trace_get_callsite(i, &site) != ESP_OK) {
+                break;
+            }
+            if (n > 0 && !dump_before(&prev, prev_index, &site, i)) {
+                continue; // already printed
+            }
+            if (next_index == SIZE_MAX || dump_before(&site, i, &next, next_index)) {
+                next = site;
+                next_index = i;
+            }
+        }
+        if (next_index == SIZE_MAX) {
+            break;
+        }
+
+        printf("%u bytes live (%u samples) %u bytes total caller ",
+               next.live_bytes, next.live_samples, next.total_bytes);
+        for (int j = 0; j < STACK_DEPTH && next.alloced_by[j] != 0; j++) {
+            printf("%p%s", next.alloced_by[j],
+                   (j < STACK_DEPTH - 1) ? ":" : "");
+        }
+        printf("\n");
+        total_live += next.live_bytes;
+        prev = next;
+        prev_index = next_index;
+    }
+    printf("%u bytes estimated alive in trace (%u sampled allocations)\n", total_live, heap_trace_get_count());
+    if (dropped_samples) {
+        printf("(NB: %u samples were dropped as the call site or sample table was full, so trace data is incomplete.)\n",
+               dropped_samples);
+    }
+}
+
+/* Return the index of the call site with this call stack, adding it if necessary.
+   Returns -1 if the call site table is full. */
+static IRAM_ATTR int find_callsite(void * const *callers)
+{
+    for (size_t i = 0; i < callsite_count; i++) {
+        if (memcmp(callsites[i].alloced_by, callers, sizeof(void *) * STACK_DEPTH) == 0) {
+            return i;
+        }
+    }
+    if (callsite_count == CALLSITE_COUNT) {
+        return -1;
+    }
+    memcpy(callsites[callsite_count].alloced_by, callers, sizeof(void *) * STACK_DEPTH);
+    return callsite_count++;
+}
+
+/* Add a new sampled allocation to its call site */
+static IRAM_ATTR void record_allocation(const heap_trace_record_t *record)
+{
+    portENTER_CRITICAL(&trace_mux);
+    if (tracing) {
+        bytes_until_sample = next_sample_gap();
+        if (record->address != NULL) {
+            size_t weight = (record->size > sample_interval) ? record->size : sample_interval;
+            int site = find_callsite(record->alloced_by);
+            if (site < 0) {
+                dropped_samples++;
+            } else {
+                callsites[site].total_bytes += weight;
+                if (live_count == SAMPLE_MAX_LIVE) {
+                    dropped_samples++;
+                } else {
+                    size_t i = sample_slot(record->address);
+                    while (samples[i].address != NULL) {
+                        i = (i + 1) % SAMPLE_SLOTS;
+                    }
+                    samples[i].address = record->address;
+                    samples[i].callsite = site;
+                    samples[i].weight = weight;
+                    live_count++;
+                    callsites[site].live_bytes += weight;
+                    callsites[site].live_samples++;
+                }
+            }
+        }
+    }
+    portEXIT_CRITICAL(&trace_mux);
+}
+
+/* Remove the sample in slot 'i', moving back any later entries of the probe sequence which would otherwise
+   become unreachable. */
+static IRAM_ATTR void remove_sample(size_t i)
+{
+    size_t j = i;
+    while (true) {
+        j = (j + 1) % SAMPLE_SLOTS;
+        if (samples[j].address == NULL) {
+            break;
+        }
+        size_t home = sample_slot(samples[j].address);
+        /* entry j can move to i if its home slot is not cyclically in (i, j] */
+        bool home_in_range = (i < j) ? (home > i && home <= j) : (home > i || home <= j);
+        if (!home_in_range) {
+            samples[i] = samples[j];
+            i = j;
+        }
+    }
+    samples[i].address = NULL;
+    live_count--;
+}
+
+/* If the memory being freed was sampled, remove it from its call site's live bytes */
+static IRAM_ATTR void record_free(void *p, void **callers)
+{
+    if (!tracing || p == NULL || live_count == 0) {
+        return;
+    }
+
+    portENTER_CRITICAL(&trace_mux);
+    if (tracing) {
+        for (size_t i = sample_slot(p); samples[i].address != NULL; i = (i + 1) % SAMPLE_SLOTS) {
+            if (samples[i].address == p) {
+                heap_trace_callsite_t *site = &callsites[samples[i].callsite];
+                site->live_bytes -= samples[i].weight;
+                site->live_samples--;
+                remove_sample(i);
+                break;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&trace_mux);
+}
+
+#include "heap_trace.inc"
+
+#endif /*CONFIG_HEAP_TRACING_SAMPLING*/
@@ -37,8 +37,24 @@ extern "C" {
 #define MALLOC_CAP_SPIRAM           (1<<10) ///< Memory must be in SPI RAM
 #define MALLOC_CAP_INTERNAL         (1<<11) ///< Memory must be internal; specifically it should not disappear when flash/spiram cache is switched off
 #define MALLOC_CAP_DEFAULT          (1<<12) ///< Memory can be returned in a non-capability-specific memory allocation (e.g. malloc(), calloc()) call
+#define MALLOC_CAP_HOT              (1<<13) ///< Placement hint: frequently accessed data, prefer internal memory over external SPI RAM
+#define MALLOC_CAP_COLD             (1<<14) ///< Placement hint: rarely accessed data, prefer external SPI RAM over internal memory
 #define MALLOC_CAP_INVALID          (1<<31) ///< Memory can't be used / list end marker
 
+/**
+ * @brief Placement hint flags
+ *
+ * Unlike the other flags, hints are not memory capabilities. An allocation with a hint
+ * first tries the preferred kind of memory and, if there is none left, falls back to any
+ * memory with the other requested capabilities. Hints are ignored if MALLOC_CAP_INTERNAL
+ * or MALLOC_CAP_SPIRAM is requested as well. If both hints are set, MALLOC_CAP_HOT wins.
+ *
+ * Without hints, malloc() places allocations by size only (see heap_caps_malloc_extmem_enable()).
+ * Hints let data which is accessed often stay out of the SPI RAM cache, which is shared by
+ * both cores, and large buffers which are rarely accessed leave internal memory free.
+ */
+#define MALLOC_CAP_HINTS            (MALLOC_CAP_HOT | MALLOC_CAP_COLD)
+
 /**
  * @brief Allocate a chunk of memory which has the given capabilities
  *
@@ -310,6 +326,195 @@ void heap_caps_dump(uint32_t caps);
  */
 void heap_caps_dump_all();
 
+/**
+ * @brief Handle to a pool of fixed size objects, see heap_caps_pool_create()
+ */
+typedef struct heap_caps_pool *heap_caps_pool_handle_t;
+
+/**
+ * @brief Create a pool of fixed size objects with certain capabilities.
+ *
+ * Storage for all objects is allocated up front as a single block with heap_caps_malloc(),
+ * and objects carry no per-object header. heap_caps_pool_alloc() and heap_caps_pool_free()
+ * take constant time. Pool usage is reported by heap_caps_get_info() and heap_caps_print_heap_info().
+ *
+ * @param obj_size Size in bytes of each object. Rounded up to a multiple of 4 bytes.
+ * @param count    Number of objects in the pool
+ * @param caps     Bitwise OR of MALLOC_CAP_* flags indicating the type of memory for the objects
+ *
+ * @return Handle to the new pool, or NULL if there is not enough memory with these capabilities.
+ */
+heap_caps_pool_handle_t heap_caps_pool_create(size_t obj_size, size_t count, uint32_t caps);
+
+/**
+ * @brief Delete a pool and free its storage.
+ *
+ * All objects allocated from the pool become invalid.
+ *
+ * @param pool Pool to delete, may be NULL
+ */
+void heap_caps_pool_delete(heap_caps_pool_handle_t pool);
+
+/**
+ * @brief Allocate an object from a pool.
+ *
+ * @param pool Pool to allocate from
+ *
+ * @return Pointer to an object of the pool's object size, or NULL if all objects are in use.
+ */
+void *heap_caps_pool_alloc(heap_caps_pool_handle_t pool);
+
+/**
+ * @brief Return an object to the pool it was allocated from.
+ *
+ * @param pool Pool which the object was allocated from
+ * @param obj  Object returned by heap_caps_pool_alloc(), may be NULL
+ */
+void heap_caps_pool_free(heap_caps_pool_handle_t pool, void *obj);
+
+/**
+ * @brief Get the number of free objects in a pool.
+ *
+ * @param pool Pool to query
+ *
+ * @return Number of objects which can still be allocated
+ */
+size_t heap_caps_pool_get_free_count(heap_caps_pool_handle_t pool);
+
+/**
+ * @brief Handle to an arena, see heap_caps_arena_create()
+ */
+typedef struct heap_caps_arena *heap_caps_arena_handle_t;
+
+/**
+ * @brief Create an arena for allocations which are all freed together.
+ *
+ * Memory is allocated from the arena by moving a pointer forward through chunks of
+ * chunk_size bytes, which are allocated with heap_caps_malloc() as they are needed.
+ * Allocations are not freed one by one: heap_caps_arena_reset() frees all of them at once,
+ * keeping one chunk for reuse, and heap_caps_arena_destroy() frees the arena.
+ *
+ * An arena must only be used by one task at a time.
+ *
+ * @param chunk_size Size in bytes of each chunk. Allocations larger than a quarter of this get a chunk of their own.
+ * @param caps       Bitwise OR of MALLOC_CAP_* flags indicating the type of memory for the chunks
+ *
+ * @return Handle to the new arena, or NULL if out of memory. No chunk is allocated until the first allocation.
+ */
+heap_caps_arena_handle_t heap_caps_arena_create(size_t chunk_size, uint32_t caps);
+
+/**
+ * @brief Allocate memory from an arena.
+ *
+ * The memory is 4 byte aligned, and stays valid until the arena is reset or destroyed.
+ *
+ * @param arena Arena to allocate from
+ * @param size  Size in bytes of the allocation
+ *
+ * @return Pointer to the memory, or NULL if size is 0 or a new chunk couldn't be allocated.
+ */
+void *heap_caps_arena_alloc(heap_caps_arena_handle_t arena, size_t size);
+
+/**
+ * @brief Allocate zeroed memory for an array from an arena.
+ *
+ * @param arena Arena to allocate from
+ * @param n     Number of elements
+ * @param size  Size in bytes of each element
+ *
+ * @return Pointer to the memory, or NULL if n * size is 0 or too large, or a new chunk couldn't be allocated.
+ */
+void *heap_caps_arena_calloc(heap_caps_arena_handle_t arena, size_t n, size_t size);
+
+/**
+ * @brief Free every allocation made from an arena.
+ *
+ * One chunk is kept, so an arena which is reset after each use stops allocating from the heap
+ * once its allocations fit in a single chunk.
+ *
+ * @param arena Arena to reset
+ */
+void heap_caps_arena_reset(heap_caps_arena_handle_t arena);
+
+/**
+ * @brief Free every allocation made from an arena and the arena itself.
+ *
+ * @param arena Arena to destroy, may be NULL
+ */
+void heap_caps_arena_destroy(heap_caps_arena_handle_t arena);
+
+/**
+ * @brief Handle to a heap trend, see heap_caps_trend_create()
+ */
+typedef struct heap_caps_trend *heap_caps_trend_handle_t;
+
+/**
+ * @brief One sample of a heap trend, taken from heap_caps_get_info()
+ */
+typedef struct {
+    uint32_t timestamp;          ///< Tick count (xTaskGetTickCount()) when the sample was taken
+    size_t total_free_bytes;     ///< Total free bytes in matching heaps
+    size_t largest_free_block;   ///< Largest free block in matching heaps, the largest allocation which can succeed
+    size_t minimum_free_bytes;   ///< Lifetime minimum of free bytes in matching heaps
+    size_t free_blocks;          ///< Number of free blocks in matching heaps
+    size_t fragmentation;        ///< Fragmentation index in percent, see multi_heap_info_t
+} heap_caps_trend_sample_t;
+
+/**
+ * @brief Create a trend which records the state of heaps with certain capabilities over time
+ *
+ * Call heap_caps_trend_sample() periodically, for example from a timer or a monitoring task,
+ * and read the history with heap_caps_trend_get(). A shrinking largest_free_block while
+ * total_free_bytes stays level means the heap is fragmenting, and can be used to predict when
+ * large allocations will start to fail.
+ *
+ * @param caps   Bitwise OR of MALLOC_CAP_* flags, as passed to heap_caps_get_info()
+ * @param length Number of samples to keep. Once full, each sample replaces the oldest.
+ *
+ * @return Handle to the new trend, or NULL if length is 0 or out of memory
+ */
+heap_caps_trend_handle_t heap_caps_trend_create(uint32_t caps, size_t length);
+
+/**
+ * @brief Delete a trend created with heap_caps_trend_create()
+ *
+ * @param trend Trend to delete, may be NULL
+ */
+void heap_caps_trend_delete(heap_caps_trend_handle_t trend);
+
+/**
+ * @brief Add a sample of the current heap state to a trend
+ *
+ * Takes as long as heap_caps_get_info(), which walks all blocks of the matching heaps,
+ * so it shouldn't be called from an interrupt or a time critical task.
+ *
+ * @param trend Trend to add the sample to
+ */
+void heap_caps_trend_sample(heap_caps_trend_handle_t trend);
+
+/**
+ * @brief Read the samples of a trend
+ *
+ * @param trend       Trend to read
+ * @param[out] samples Array to copy the samples to, oldest first
+ * @param max_samples Size of the samples array. If the trend holds more samples, the newest ones are copied.
+ *
+ * @return Number of samples copied
+ */
+size_t heap_caps_trend_get(heap_caps_trend_handle_t trend, heap_caps_trend_sample_t *samples, size_t max_samples);
+
+/**
+ * @brief Return all blocks held by the small object cache to their heaps.
+ *
+ * With CONFIG_HEAP_SMALL_CACHE enabled, small blocks freed by the application are kept
+ * in per-core caches and still count as allocated in heap_caps_get_free_size(),
+ * heap_caps_get_info() and friends. Call this before measuring free heap to get exact numbers.
+ * An allocation which can't otherwise be satisfied also flushes the caches first.
+ *
+ * Does nothing if CONFIG_HEAP_SMALL_CACHE is not enabled.
+ */
+void heap_caps_small_cache_flush(void);
+
 #ifdef __cplusplus
 }
 #endif
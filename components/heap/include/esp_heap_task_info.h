@@ -15,6 +15,8 @@
 
 #ifdef CONFIG_HEAP_TASK_TRACKING
 
+#include "esp_err.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -76,6 +78,19 @@ typedef struct {
     size_t max_blocks;                ///< Capacity of array of task block info structs
 } heap_task_info_params_t;
 
+/** @brief Indexes of the memory kinds in heap_task_stats_t */
+#define HEAP_TASK_STATS_INTERNAL    0   ///< Heaps without MALLOC_CAP_SPIRAM
+#define HEAP_TASK_STATS_SPIRAM      1   ///< External RAM heaps
+#define HEAP_TASK_STATS_CAPS        2
+
+/** @brief Counters of the memory a task holds, kept up to date on every allocation and free */
+typedef struct {
+    TaskHandle_t task;                        ///< Task the counters belong to
+    size_t size[HEAP_TASK_STATS_CAPS];        ///< Bytes currently allocated, by memory kind
+    size_t count[HEAP_TASK_STATS_CAPS];       ///< Blocks currently allocated, by memory kind
+    size_t peak_size[HEAP_TASK_STATS_CAPS];   ///< Highest number of bytes allocated at the same time, by memory kind
+} heap_task_stats_t;
+
 /**
  * @brief Return per-task heap allocation totals and lists of blocks.
  *
@@ -91,6 +106,38 @@ typedef struct {
  */
 extern size_t heap_caps_get_per_task_info(heap_task_info_params_t *params);
 
+/**
+ * @brief Get the counters of the memory allocated by a task
+ *
+ * Unlike heap_caps_get_per_task_info(), this doesn't walk the heaps: the
+ * counters are updated on every allocation and free, so this is cheap enough to
+ * be called periodically, for instance to raise an alarm when a task keeps
+ * allocating more memory.
+ *
+ * A block counts for the task which allocated it (or reallocated it last),
+ * until it is freed by any task. At most CONFIG_HEAP_TASK_TRACKING_MAX_TASKS
+ * tasks holding memory at the same time are tracked.
+ *
+ * @param task Task to get the counters of, NULL for the current task
+ * @param[out] stats Counters of the task
+ * @return
+ *     - ESP_OK on success
+ *     - ESP_ERR_NOT_FOUND if the task has not allocated memory
+ */
+esp_err_t heap_caps_get_task_stats(TaskHandle_t task, heap_task_stats_t *stats);
+
+/**
+ * @brief Get the counters of all tasks holding memory
+ *
+ * @param[out] stats Array to fill with the counters
+ * @param max_stats Capacity of the stats array
+ * @param[out] untracked If not NULL, set to the number of allocations which
+ *                       were not counted for any task because too many tasks
+ *                       held memory at the time
+ * @return Number of entries filled into the stats array
+ */
+size_t heap_caps_get_all_task_stats(heap_task_stats_t *stats, size_t max_stats, size_t *untracked);
+
 #ifdef __cplusplus
 }
 #endif
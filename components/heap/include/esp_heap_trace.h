@@ -45,6 +45,18 @@ typedef struct {
     void *freed_by[CONFIG_HEAP_TRACING_STACK_DEPTH];   ///< Call stack of the caller which freed the memory (all zero if not freed.)
 } heap_trace_record_t;
 
+/**
+ * @brief Call site data type used in sampling mode. Aggregates the sampled allocations made from one call stack.
+ *
+ * Byte counts are estimates: each sampled allocation stands for the bytes allocated since the previous sample.
+ */
+typedef struct {
+    void *alloced_by[CONFIG_HEAP_TRACING_STACK_DEPTH]; ///< Call stack of the caller which allocated the memory.
+    size_t live_bytes;       ///< Estimated bytes allocated from this call stack which have not been freed
+    size_t live_samples;     ///< Number of sampled allocations from this call stack which have not been freed
+    size_t total_bytes;      ///< Estimated bytes allocated from this call stack since heap_trace_start()
+} heap_trace_callsite_t;
+
 /**
  * @brief Initialise heap tracing in standalone mode.
  *
@@ -73,6 +85,26 @@ esp_err_t heap_trace_init_standalone(heap_trace_record_t *record_buffer, size_t
  */
 esp_err_t heap_trace_init_tohost(void);
 
+/**
+ * @brief Initialise heap tracing in sampling mode.
+ *
+ * @note Only available if "Sampling" is selected as the heap tracing destination in menuconfig.
+ *
+ * In sampling mode, only about one allocation in every sample_interval bytes allocated has its call stack
+ * recorded. Sampled allocations are aggregated into a fixed size table of call sites (see
+ * CONFIG_HEAP_TRACING_SAMPLING_CALLSITES), which can be read with heap_trace_get_callsite().
+ *
+ * Calling this function is optional, the sampling interval defaults to CONFIG_HEAP_TRACING_SAMPLING_INTERVAL.
+ *
+ * @param sample_interval Average number of bytes allocated between two samples. Allocations of at least
+ * this size are always sampled.
+ * @return
+ *  - ESP_ERR_INVALID_STATE Heap tracing is currently in progress.
+ *  - ESP_ERR_INVALID_ARG sample_interval is zero.
+ *  - ESP_OK Heap tracing initialised successfully.
+ */
+esp_err_t heap_trace_init_sampling(size_t sample_interval);
+
 /**
  * @brief Start heap tracing. All heap allocations & frees will be traced, until heap_trace_stop() is called.
  *
@@ -119,6 +151,8 @@ esp_err_t heap_trace_resume(void);
 /**
  * @brief Return number of records in the heap trace buffer
  *
+ * In sampling mode, this is the number of sampled allocations which have not been freed.
+ *
  * It is safe to call this function while heap tracing is running.
  */
 size_t heap_trace_get_count(void);
@@ -129,10 +163,12 @@ size_t heap_trace_get_count(void);
  * @note It is safe to call this function while heap tracing is running, however in HEAP_TRACE_LEAK mode record indexing may
  * skip entries unless heap tracing is stopped first.
  *
+ * @note Not supported in sampling mode, use heap_trace_get_callsite() instead.
+ *
  * @param index Index (zero-based) of the record to return.
  * @param[out] record Record where the heap trace record will be copied.
  * @return
- * - ESP_ERR_NOT_SUPPORTED Project was compiled without heap tracing enabled in menuconfig.
+ * - ESP_ERR_NOT_SUPPORTED Project was compiled without heap tracing enabled in menuconfig, or with sampling mode selected.
  * - ESP_ERR_INVALID_STATE Heap tracing was not initialised.
  * - ESP_ERR_INVALID_ARG Index is out of bounds for current heap trace record count.
  * - ESP_OK Record returned successfully.
@@ -149,6 +185,38 @@ esp_err_t heap_trace_get(size_t index, heap_trace_record_t *record);
  */
 void heap_trace_dump(void);
 
+/**
+ * @brief Return number of call sites recorded in sampling mode
+ *
+ * @note Only available in sampling mode, like heap_trace_get_callsite() and heap_trace_dump_to_host().
+ *
+ * It is safe to call this function while heap tracing is running.
+ */
+size_t heap_trace_get_callsite_count(void);
+
+/**
+ * @brief Return a call site recorded in sampling mode
+ *
+ * @param index Index (zero-based) of the call site to return.
+ * @param[out] callsite Where the call site will be copied.
+ * @return
+ * - ESP_ERR_INVALID_STATE callsite is NULL.
+ * - ESP_ERR_INVALID_ARG Index is out of bounds for current call site count.
+ * - ESP_OK Call site returned successfully.
+ */
+esp_err_t heap_trace_get_callsite(size_t index, heap_trace_callsite_t *callsite);
+
+/**
+ * @brief Send the call sites recorded in sampling mode to the host via app_trace
+ *
+ * One line of text is written per call site, like the lines printed by heap_trace_dump(), followed by a summary line.
+ *
+ * @param tmo Timeout for writing each line and for the final flush, in us.
+ * @return
+ * - ESP_OK Data sent successfully, otherwise the error returned by app_trace.
+ */
+esp_err_t heap_trace_dump_to_host(uint32_t tmo);
+
 #ifdef __cplusplus
 }
 #endif
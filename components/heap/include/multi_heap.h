@@ -146,6 +146,9 @@ size_t multi_heap_free_size(multi_heap_handle_t heap);
  */
 size_t multi_heap_minimum_free_size(multi_heap_handle_t heap);
 
+/** @brief Number of buckets in multi_heap_info_t free_block_histogram */
+#define MULTI_HEAP_HISTOGRAM_BUCKETS 12
+
 /** @brief Structure to access heap metadata via multi_heap_get_info */
 typedef struct {
     size_t total_free_bytes;      ///<  Total free bytes in the heap. Equivalent to multi_free_heap_size().
@@ -155,6 +158,10 @@ typedef struct {
     size_t allocated_blocks;      ///<  Number of (variable size) blocks allocated in the heap.
     size_t free_blocks;           ///<  Number of (variable size) free blocks in the heap.
     size_t total_blocks;          ///<  Total number of (variable size) blocks in the heap.
+    size_t pool_allocated_bytes;  ///<  Bytes of objects allocated from heap_caps pools in the heap. Only set by heap_caps_get_info().
+    size_t pool_free_bytes;       ///<  Bytes of free objects in heap_caps pools in the heap, included in total_allocated_bytes. Only set by heap_caps_get_info().
+    size_t fragmentation;         ///<  Fragmentation index in percent, 100 * (1 - largest_free_block / total_free_bytes). 0 if all free memory is in a single block.
+    size_t free_block_histogram[MULTI_HEAP_HISTOGRAM_BUCKETS]; ///< Number of free blocks by size. Bucket 0 counts blocks smaller than 32 bytes, bucket N blocks of 2^(N+4) to 2^(N+5)-1 bytes, and the last bucket all blocks of 32KB or more.
 } multi_heap_info_t;
 
 /** @brief Return metadata about a given heap
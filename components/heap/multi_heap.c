@@ -564,15 +564,18 @@ void *multi_heap_realloc_impl(multi_heap_handle_t heap, void *p, size_t size)
         }
 
         // Can grow into previous block?
-        // (try this even if we're already big enough from growing into 'next', as it reduces fragmentation)
-        if (prev_grow_size > 0 && (block_data_size(pb) + prev_grow_size >= size)) {
+        // (only if growing into 'next' wasn't enough. Growing in place avoids moving the data, and leaves any
+        // free space after the block where the next realloc of a buffer which grows incrementally can use it.)
+        if (prev_grow_size > 0 && block_data_size(pb) < size && (block_data_size(pb) + prev_grow_size >= size)) {
             pb = merge_adjacent(heap, prev, pb);
             // this doesn't guarantee we'll be left with a big enough block, as it's
             // possible for the merge to fail if prev == heap->first_block
         }
 
         if (block_data_size(pb) >= size) {
-            memmove(pb->data, orig_pb->data, orig_size);
+            if (pb != orig_pb) {
+                memmove(pb->data, orig_pb->data, orig_size);
+            }
             split_if_necessary(heap, pb, size, NULL);
             result = pb->data;
         }
@@ -733,6 +736,7 @@ void multi_heap_get_info_impl(multi_heap_handle_t heap, multi_heap_info_t *info)
                 info->largest_free_block = s;
             }
             info->free_blocks++;
+            info->free_block_histogram[multi_heap_histogram_bucket(s)]++;
         } else {
             info->total_allocated_bytes += block_data_size(b);
             info->allocated_blocks++;
@@ -740,6 +744,7 @@ void multi_heap_get_info_impl(multi_heap_handle_t heap, multi_heap_info_t *info)
     }
 
     info->minimum_free_bytes = heap->minimum_free_bytes;
+    multi_heap_update_fragmentation(info);
     // heap has wrong total size (address printed here is not indicative of the real error)
     MULTI_HEAP_ASSERT(info->total_free_bytes == heap->free_bytes, heap);
 
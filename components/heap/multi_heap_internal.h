@@ -33,6 +33,26 @@ size_t multi_heap_minimum_free_size_impl(multi_heap_handle_t heap);
 size_t multi_heap_get_allocated_size_impl(multi_heap_handle_t heap, void *p);
 void *multi_heap_get_block_address_impl(multi_heap_block_handle_t block);
 
+/* Return the multi_heap_info_t free_block_histogram bucket for a free block of this size */
+static inline size_t multi_heap_histogram_bucket(size_t size)
+{
+    if (size < 32) {
+        return 0;
+    }
+    size_t bucket = (sizeof(unsigned long) * 8 - 1 - __builtin_clzl(size)) - 4; // log2(size) - 4
+    return (bucket < MULTI_HEAP_HISTOGRAM_BUCKETS) ? bucket : MULTI_HEAP_HISTOGRAM_BUCKETS - 1;
+}
+
+/* Set info->fragmentation from the largest free block and total free bytes */
+static inline void multi_heap_update_fragmentation(multi_heap_info_t *info)
+{
+    if (info->total_free_bytes == 0) {
+        info->fragmentation = 0;
+    } else {
+        info->fragmentation = 100 - (size_t)(100ULL * info->largest_free_block / info->total_free_bytes);
+    }
+}
+
 /* Some internal functions for heap poisoning use */
 
 /* Check an allocated block's poison bytes are correct. Called by multi_heap_check(). */
@@ -66,3 +86,11 @@ void *multi_heap_get_block_address(multi_heap_block_handle_t block);
 
 /* Get the owner identification for a heap block */
 void *multi_heap_get_block_owner(multi_heap_block_handle_t block);
+
+#ifdef CONFIG_HEAP_TASK_TRACKING
+/* Get the owner identification of the allocated block at 'p', as returned by multi_heap_malloc() */
+void *multi_heap_get_allocated_owner(void *p);
+
+/* Make the current task the owner of the allocated block at 'p' */
+void multi_heap_set_allocated_owner(void *p);
+#endif
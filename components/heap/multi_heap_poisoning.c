@@ -300,6 +300,20 @@ void *multi_heap_get_block_owner(multi_heap_block_handle_t block)
     return MULTI_HEAP_GET_BLOCK_OWNER((poison_head_t*)multi_heap_get_block_address_impl(block));
 }
 
+#ifdef CONFIG_HEAP_TASK_TRACKING
+void *multi_heap_get_allocated_owner(void *p)
+{
+    poison_head_t *head = (poison_head_t *)((intptr_t)p - sizeof(poison_head_t));
+    return MULTI_HEAP_GET_BLOCK_OWNER(head);
+}
+
+void multi_heap_set_allocated_owner(void *p)
+{
+    poison_head_t *head = (poison_head_t *)((intptr_t)p - sizeof(poison_head_t));
+    MULTI_HEAP_SET_BLOCK_OWNER(head);
+}
+#endif
+
 multi_heap_handle_t multi_heap_register(void *start, size_t size)
 {
     if (start != NULL) {
@@ -327,6 +341,7 @@ void multi_heap_get_info(multi_heap_handle_t heap, multi_heap_info_t *info)
        a block this big may be available. */
     subtract_poison_overhead(&info->total_free_bytes);
     subtract_poison_overhead(&info->minimum_free_bytes);
+    multi_heap_update_fragmentation(info);
 }
 
 size_t multi_heap_free_size(multi_heap_handle_t heap)
@@ -0,0 +1,856 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/* Segregated fit ("TLSF") implementation of the multi_heap API.
+
+   This file is a drop-in replacement for multi_heap.c, selected with
+   CONFIG_HEAP_ALLOCATOR_TLSF. It implements the same *_impl functions, so
+   the heap poisoning layer in multi_heap_poisoning.c works unchanged on top of it.
+
+   Free blocks are kept in a two-level array of doubly linked lists. The first
+   level splits sizes by power of two, the second level splits each power of
+   two into SL_INDEX_COUNT linear ranges. A bitmap per level tracks which lists
+   are non-empty, so finding a free block and inserting or removing one never
+   walks the heap. Free blocks also store a pointer to themselves in their last
+   word and mark the following block as PREV_FREE, so a freed block can be
+   coalesced with both neighbours in constant time.
+*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <multi_heap.h>
+#include "multi_heap_internal.h"
+
+/* Note: Keep platform-specific parts in this header, this source
+   file should depend on libc only */
+#include "multi_heap_platform.h"
+
+/* Defines compile-time configuration macros */
+#include "multi_heap_config.h"
+
+#ifndef MULTI_HEAP_POISONING
+/* if no heap poisoning, public API aliases directly to these implementations */
+void *multi_heap_malloc(multi_heap_handle_t heap, size_t size)
+    __attribute__((alias("multi_heap_malloc_impl")));
+
+void multi_heap_free(multi_heap_handle_t heap, void *p)
+    __attribute__((alias("multi_heap_free_impl")));
+
+void *multi_heap_realloc(multi_heap_handle_t heap, void *p, size_t size)
+    __attribute__((alias("multi_heap_realloc_impl")));
+
+size_t multi_heap_get_allocated_size(multi_heap_handle_t heap, void *p)
+    __attribute__((alias("multi_heap_get_allocated_size_impl")));
+
+multi_heap_handle_t multi_heap_register(void *start, size_t size)
+    __attribute__((alias("multi_heap_register_impl")));
+
+void multi_heap_get_info(multi_heap_handle_t heap, multi_heap_info_t *info)
+    __attribute__((alias("multi_heap_get_info_impl")));
+
+size_t multi_heap_free_size(multi_heap_handle_t heap)
+    __attribute__((alias("multi_heap_free_size_impl")));
+
+size_t multi_heap_minimum_free_size(multi_heap_handle_t heap)
+    __attribute__((alias("multi_heap_minimum_free_size_impl")));
+
+void *multi_heap_get_block_address(multi_heap_block_handle_t block)
+    __attribute__((alias("multi_heap_get_block_address_impl")));
+
+void *multi_heap_get_block_owner(multi_heap_block_handle_t block)
+{
+    return NULL;
+}
+
+#endif
+
+#define ALIGN(X) ((X) & ~(sizeof(void *)-1))
+#define ALIGN_UP(X) ALIGN((X)+sizeof(void *)-1)
+
+/* log2 of the number of second level lists for each power of two */
+#define SL_INDEX_COUNT_LOG2 3
+#define SL_INDEX_COUNT (1 << SL_INDEX_COUNT_LOG2)
+
+/* Sizes below SMALL_BLOCK_SIZE all go to first level list 0, which is split linearly in steps of ALIGN */
+#define ALIGN_SIZE_LOG2 (sizeof(void *) == 8 ? 3 : 2)
+#define FL_INDEX_SHIFT (SL_INDEX_COUNT_LOG2 + ALIGN_SIZE_LOG2)
+#define SMALL_BLOCK_SIZE ((size_t)1 << FL_INDEX_SHIFT)
+
+/* Largest first level index, blocks must be smaller than 2^(FL_INDEX_MAX + 1) bytes */
+#define FL_INDEX_MAX 23
+#define FL_INDEX_COUNT (FL_INDEX_MAX - FL_INDEX_SHIFT + 2)
+
+/* Block in the heap
+
+   'header' holds a pointer to the next block (used or free) ORed with a free flag and a "previous block is free" flag.
+   is_free() and get_next_block() utility functions allow typed access to these values.
+
+   'next_free' and 'prev_free' are valid if the block is free and link the block into the free list for its size class.
+   A free block also holds a pointer to itself in the last word of its data, which lets the next block find it
+   when they are merged.
+
+   All blocks have room for these three words of data, so any block can be freed.
+*/
+typedef struct heap_block {
+    intptr_t header;                  /* Encodes next block in heap (used or unused) and the free/prev free flags */
+    union {
+        uint8_t data[1];              /* First byte of data, valid if block is used. Actual size of data is 'block_data_size(block)' */
+        struct heap_block *next_free; /* Pointer to next free block in the same list, valid if block is free */
+    };
+    struct heap_block *prev_free;     /* Pointer to previous free block in the same list, valid if block is free */
+} heap_block_t;
+
+/* These masks apply to the 'header' field of heap_block_t */
+#define BLOCK_FREE_FLAG 0x1  /* If set, this block is free & next_free/prev_free pointers are valid */
+#define PREV_FREE_FLAG 0x2   /* If set, the previous block in the heap is free & ends with a pointer to itself */
+#define NEXT_BLOCK_MASK (~3) /* AND header with this mask to get pointer to next block (free or used) */
+
+/* Smallest data size of any block, a free block needs room for both list pointers and the trailing self pointer */
+#define MIN_BLOCK_DATA_SIZE (sizeof(heap_block_t) - sizeof(intptr_t) + sizeof(heap_block_t *))
+
+/* Metadata header for the heap, stored at the beginning of heap space.
+
+   'first_block' is a "fake" first block, minimum length, used to provide a pointer to the first used & free block in
+   the heap. This block is never allocated or merged into an adjacent block. The free list heads follow it
+   and are counted as part of its data.
+
+   'last_block' is a pointer to a final free block of length 0, which is added at the end of the heap when it is
+   registered. This block is also never allocated or merged into an adjacent block.
+
+   'free_lists' has 'fl_count' * SL_INDEX_COUNT entries, 'fl_count' depends on the size of the heap.
+ */
+typedef struct multi_heap_info {
+    void *lock;
+    size_t free_bytes;
+    size_t minimum_free_bytes;
+    heap_block_t *last_block;
+    heap_block_t **free_lists;
+    uint32_t fl_bitmap;
+    int fl_count;
+    uint8_t sl_bitmap[FL_INDEX_COUNT];
+    heap_block_t first_block; /* initial 'free block', never allocated */
+} heap_t;
+
+_Static_assert(SL_INDEX_COUNT <= 8, "sl_bitmap entries are 8 bits wide");
+_Static_assert(FL_INDEX_COUNT <= 32, "fl_bitmap is 32 bits wide");
+
+/* Given a pointer to the 'data' field of a block (ie the previous malloc/realloc result), return a pointer to the
+   containing block.
+*/
+static inline heap_block_t *get_block(const void *data_ptr)
+{
+    return (heap_block_t *)((char *)data_ptr - offsetof(heap_block_t, data));
+}
+
+/* Return the next sequential block in the heap.
+ */
+static inline heap_block_t *get_next_block(const heap_block_t *block)
+{
+    intptr_t next = block->header & NEXT_BLOCK_MASK;
+    if (next == 0) {
+        return NULL; /* last_block */
+    }
+    assert(next > (intptr_t)block);
+    return (heap_block_t *)next;
+}
+
+/* Return true if this block is free. */
+static inline bool is_free(const heap_block_t *block)
+{
+    return block->header & BLOCK_FREE_FLAG;
+}
+
+/* Return true if the block before this one in the heap is free (never true for the block after first_block) */
+static inline bool is_prev_free(const heap_block_t *block)
+{
+    return block->header & PREV_FREE_FLAG;
+}
+
+/* Return true if this block is the first in the heap */
+static inline bool is_first_block(const heap_t *heap, const heap_block_t *block)
+{
+    return (block == &heap->first_block);
+}
+
+/* Return true if this block is the last_block in the heap
+   (the only block with no next pointer) */
+static inline bool is_last_block(const heap_block_t *block)
+{
+    return (block->header & NEXT_BLOCK_MASK) == 0;
+}
+
+/* Data size of the block (excludes this block's header) */
+static inline size_t block_data_size(const heap_block_t *block)
+{
+    intptr_t next = (intptr_t)block->header & NEXT_BLOCK_MASK;
+    intptr_t this = (intptr_t)block;
+    if (next == 0) {
+        return 0; /* this is the last block in the heap */
+    }
+    return next - this - sizeof(block->header);
+}
+
+/* Pointer to the word at the end of a free block which points back to the block */
+static inline heap_block_t **get_block_footer(const heap_block_t *block)
+{
+    return (heap_block_t **)(block->header & NEXT_BLOCK_MASK) - 1;
+}
+
+/* Return the previous block in the heap, only valid if is_prev_free(block) is true */
+static inline heap_block_t *get_prev_block(const heap_block_t *block)
+{
+    return ((heap_block_t **)block)[-1];
+}
+
+/* Check a block is valid for this heap. Used to verify parameters. */
+static void assert_valid_block(const heap_t *heap, const heap_block_t *block)
+{
+    MULTI_HEAP_ASSERT(block >= &heap->first_block && block <= heap->last_block,
+                      block); // block not in heap
+    if (heap < (const heap_t *)heap->last_block) {
+        const heap_block_t *next = get_next_block(block);
+        MULTI_HEAP_ASSERT(next >= &heap->first_block && next <= heap->last_block, block); // Next block not in heap
+    }
+}
+
+static inline int fls_size(size_t size)
+{
+    return (int)(sizeof(unsigned long) * 8) - 1 - __builtin_clzl((unsigned long)size);
+}
+
+/* Find the list which holds free blocks of exactly 'size' data bytes */
+static inline void mapping_insert(size_t size, int *fl, int *sl)
+{
+    if (size < SMALL_BLOCK_SIZE) {
+        *fl = 0;
+        *sl = size >> ALIGN_SIZE_LOG2;
+    } else {
+        int f = fls_size(size);
+        *sl = (size >> (f - SL_INDEX_COUNT_LOG2)) ^ SL_INDEX_COUNT;
+        *fl = f - FL_INDEX_SHIFT + 1;
+    }
+}
+
+/* Find the first list where every free block can hold 'size' data bytes */
+static inline void mapping_search(size_t size, int *fl, int *sl)
+{
+    if (size >= SMALL_BLOCK_SIZE) {
+        size += ((size_t)1 << (fls_size(size) - SL_INDEX_COUNT_LOG2)) - 1;
+    }
+    mapping_insert(size, fl, sl);
+}
+
+static inline heap_block_t **get_list(heap_t *heap, int fl, int sl)
+{
+    return &heap->free_lists[fl * SL_INDEX_COUNT + sl];
+}
+
+/* Return the head of the first non-empty list at or above (fl, sl), updating fl & sl. */
+static heap_block_t *find_free_list(heap_t *heap, int *fl, int *sl)
+{
+    if (*fl >= heap->fl_count) {
+        return NULL;
+    }
+    uint32_t sl_map = heap->sl_bitmap[*fl] & (~0U << *sl);
+    if (sl_map == 0) {
+        uint32_t fl_map = heap->fl_bitmap & (~0U << (*fl + 1));
+        if (fl_map == 0) {
+            return NULL;
+        }
+        *fl = __builtin_ctz(fl_map);
+        sl_map = heap->sl_bitmap[*fl];
+    }
+    *sl = __builtin_ctz(sl_map);
+    return *get_list(heap, *fl, *sl);
+}
+
+/* Add a free block to the list for its size and make it visible to the following block. */
+static void insert_free_block(heap_t *heap, heap_block_t *block)
+{
+    int fl, sl;
+    mapping_insert(block_data_size(block), &fl, &sl);
+    heap_block_t **list = get_list(heap, fl, sl);
+
+    block->header |= BLOCK_FREE_FLAG;
+    block->prev_free = NULL;
+    block->next_free = *list;
+    if (*list != NULL) {
+        (*list)->prev_free = block;
+    }
+    *list = block;
+    heap->fl_bitmap |= 1U << fl;
+    heap->sl_bitmap[fl] |= 1U << sl;
+
+    *get_block_footer(block) = block;
+    get_next_block(block)->header |= PREV_FREE_FLAG;
+}
+
+/* Remove a free block from its list. 'block' is still marked free when this returns. */
+static void remove_free_block(heap_t *heap, heap_block_t *block)
+{
+    int fl, sl;
+    mapping_insert(block_data_size(block), &fl, &sl);
+    heap_block_t **list = get_list(heap, fl, sl);
+
+    MULTI_HEAP_ASSERT(is_free(block), block); // block should be free
+    if (block->next_free != NULL) {
+        MULTI_HEAP_ASSERT(block->next_free->prev_free == block, &block->next_free); // free list should be linked both ways
+        block->next_free->prev_free = block->prev_free;
+    }
+    if (block->prev_free != NULL) {
+        MULTI_HEAP_ASSERT(block->prev_free->next_free == block, &block->prev_free); // free list should be linked both ways
+        block->prev_free->next_free = block->next_free;
+    } else {
+        MULTI_HEAP_ASSERT(*list == block, block); // block should be the head of its list
+        *list = block->next_free;
+        if (*list == NULL) {
+            heap->sl_bitmap[fl] &= ~(1U << sl);
+            if (heap->sl_bitmap[fl] == 0) {
+                heap->fl_bitmap &= ~(1U << fl);
+            }
+        }
+    }
+
+    get_next_block(block)->header &= ~PREV_FREE_FLAG;
+#ifdef MULTI_HEAP_POISONING_SLOW
+    /* the footer will be part of some block's data, so it needs the free fill pattern back */
+    multi_heap_internal_poison_fill_region(get_block_footer(block), sizeof(heap_block_t *), true);
+#endif
+}
+
+/* Merge 'block', which is not in any free list, with free neighbours and add the result to the free lists.
+
+   Caller must already have added block_data_size(block) to heap->free_bytes.
+*/
+static void free_block_and_merge(heap_t *heap, heap_block_t *block)
+{
+    if (is_prev_free(block)) {
+        heap_block_t *prev = get_prev_block(block);
+        MULTI_HEAP_ASSERT(prev > &heap->first_block && get_next_block(prev) == block, block); // prev free block should be adjacent
+        remove_free_block(heap, prev);
+        prev->header = (block->header & NEXT_BLOCK_MASK) | (prev->header & ~NEXT_BLOCK_MASK);
+        heap->free_bytes += sizeof(block->header);
+#ifdef MULTI_HEAP_POISONING_SLOW
+        multi_heap_internal_poison_fill_region(block, sizeof(heap_block_t), true);
+#endif
+        block = prev;
+    }
+
+    heap_block_t *next = get_next_block(block);
+    if (is_free(next) && !is_last_block(next)) {
+        remove_free_block(heap, next);
+        block->header = (next->header & NEXT_BLOCK_MASK) | (block->header & ~NEXT_BLOCK_MASK);
+        heap->free_bytes += sizeof(next->header);
+#ifdef MULTI_HEAP_POISONING_SLOW
+        multi_heap_internal_poison_fill_region(next, sizeof(heap_block_t), true);
+#endif
+    }
+
+    insert_free_block(heap, block);
+}
+
+/* Split a used block so it holds 'size' bytes of data, making any spare space into a new free block
+   (merged with the following block if that one is free).
+*/
+static void split_if_necessary(heap_t *heap, heap_block_t *block, size_t size)
+{
+    const size_t block_size = block_data_size(block);
+    MULTI_HEAP_ASSERT(!is_free(block), block); // split block shouldn't be free
+    MULTI_HEAP_ASSERT(size <= block_size, block); // size should be valid
+
+    if (block_size < size + sizeof(intptr_t) + MIN_BLOCK_DATA_SIZE) {
+        /* Can't split 'block' if we're not going to get a usable free block afterwards */
+        return;
+    }
+
+    heap_block_t *new_block = (heap_block_t *)(block->data + size);
+    new_block->header = block->header & NEXT_BLOCK_MASK;
+    block->header = (intptr_t)new_block | (block->header & ~NEXT_BLOCK_MASK);
+    heap->free_bytes += block_data_size(new_block);
+    free_block_and_merge(heap, new_block);
+}
+
+/* Round a request up to the size of data it will get */
+static inline size_t block_size_for(size_t size)
+{
+    size = ALIGN_UP(size);
+    return (size < MIN_BLOCK_DATA_SIZE) ? MIN_BLOCK_DATA_SIZE : size;
+}
+
+void *multi_heap_get_block_address_impl(multi_heap_block_handle_t block)
+{
+    return ((char *)block + offsetof(heap_block_t, data));
+}
+
+size_t multi_heap_get_allocated_size_impl(multi_heap_handle_t heap, void *p)
+{
+    heap_block_t *pb = get_block(p);
+
+    assert_valid_block(heap, pb);
+    MULTI_HEAP_ASSERT(!is_free(pb), pb); // block shouldn't be free
+    return block_data_size(pb);
+}
+
+multi_heap_handle_t multi_heap_register_impl(void *start_ptr, size_t size)
+{
+    uintptr_t start = ALIGN_UP((uintptr_t)start_ptr);
+    uintptr_t end = ALIGN((uintptr_t)start_ptr + size);
+    heap_t *heap = (heap_t *)start;
+    size = end - start;
+
+    if (end < start || size < sizeof(heap_t) + 2*sizeof(heap_block_t)) {
+        return NULL; /* 'size' is too small to fit a heap here */
+    }
+    if (fls_size(size) > FL_INDEX_MAX) {
+        return NULL; /* 'size' is too large for the first level lists */
+    }
+
+    /* enough lists for the largest block this heap could hold */
+    int fl, sl;
+    mapping_insert(size, &fl, &sl);
+    size_t lists_size = (fl + 1) * SL_INDEX_COUNT * sizeof(heap_block_t *);
+    if (size < sizeof(heap_t) + lists_size + sizeof(intptr_t) + MIN_BLOCK_DATA_SIZE + sizeof(heap_block_t)) {
+        return NULL;
+    }
+
+    heap->lock = NULL;
+    heap->free_lists = (heap_block_t **)(start + sizeof(heap_t));
+    heap->fl_count = fl + 1;
+    heap->fl_bitmap = 0;
+    memset(heap->sl_bitmap, 0, sizeof(heap->sl_bitmap));
+    memset(heap->free_lists, 0, lists_size);
+    heap->last_block = (heap_block_t *)(end - sizeof(heap_block_t));
+
+    /* first 'real' (allocatable) free block goes after the free list heads */
+    heap_block_t *first_free_block = (heap_block_t *)(start + sizeof(heap_t) + lists_size);
+    first_free_block->header = (intptr_t)heap->last_block;
+
+    /* last block is 'free' but has a NULL next pointer */
+    heap->last_block->header = BLOCK_FREE_FLAG;
+    heap->last_block->next_free = NULL;
+    heap->last_block->prev_free = NULL;
+
+    /* first block also 'free' but is in no list,
+       malloc will never allocate into this block. */
+    heap->first_block.header = (intptr_t)first_free_block | BLOCK_FREE_FLAG;
+    heap->first_block.next_free = NULL;
+    heap->first_block.prev_free = NULL;
+
+    insert_free_block(heap, first_free_block);
+
+    /* free bytes is:
+       - total bytes in heap
+       - minus heap_t header at top (includes heap->first_block) and the free list heads
+       - minus header of first_free_block
+       - minus whole block at heap->last_block
+    */
+    heap->free_bytes = size - sizeof(heap_t) - lists_size - sizeof(first_free_block->header) - sizeof(heap_block_t);
+    heap->minimum_free_bytes = heap->free_bytes;
+
+    return heap;
+}
+
+void multi_heap_set_lock(multi_heap_handle_t heap, void *lock)
+{
+    heap->lock = lock;
+}
+
+void inline multi_heap_internal_lock(multi_heap_handle_t heap)
+{
+    MULTI_HEAP_LOCK(heap->lock);
+}
+
+void inline multi_heap_internal_unlock(multi_heap_handle_t heap)
+{
+    MULTI_HEAP_UNLOCK(heap->lock);
+}
+
+multi_heap_block_handle_t multi_heap_get_first_block(multi_heap_handle_t heap)
+{
+    return &heap->first_block;
+}
+
+multi_heap_block_handle_t multi_heap_get_next_block(multi_heap_handle_t heap, multi_heap_block_handle_t block)
+{
+    heap_block_t *next = get_next_block(block);
+    /* check for valid free last block to avoid assert in assert_valid_block */
+    if (next == heap->last_block && is_last_block(next) && is_free(next)) {
+        return NULL;
+    }
+    assert_valid_block(heap, next);
+    return next;
+}
+
+bool multi_heap_is_free(multi_heap_block_handle_t block)
+{
+    return is_free(block);
+}
+
+void *multi_heap_malloc_impl(multi_heap_handle_t heap, size_t size)
+{
+    int fl, sl;
+
+    if (size == 0 || heap == NULL) {
+        return NULL;
+    }
+    size = block_size_for(size);
+
+    multi_heap_internal_lock(heap);
+
+    /* Note: this check must be done while holding the lock as both
+       malloc & realloc may temporarily shrink the free_bytes value
+       before they split a large block. This can result in false negatives,
+       especially if the heap is unfragmented.
+    */
+    if (heap->free_bytes < size) {
+        multi_heap_internal_unlock(heap);
+        return NULL;
+    }
+
+    /* Any block in the list found by mapping_search() is big enough */
+    mapping_search(size, &fl, &sl);
+    heap_block_t *block = find_free_list(heap, &fl, &sl);
+    if (block == NULL) {
+        /* Rounding up may have skipped the only big enough blocks, which are in the
+           list for 'size' itself. Only this one list is searched. */
+        mapping_insert(size, &fl, &sl);
+        if (fl < heap->fl_count) {
+            for (block = *get_list(heap, fl, sl); block != NULL; block = block->next_free) {
+                if (block_data_size(block) >= size) {
+                    break;
+                }
+            }
+        }
+    }
+
+    if (block == NULL) {
+        multi_heap_internal_unlock(heap);
+        return NULL; /* No room in heap */
+    }
+
+    remove_free_block(heap, block);
+    block->header &= ~BLOCK_FREE_FLAG;
+    heap->free_bytes -= block_data_size(block);
+
+    split_if_necessary(heap, block, size);
+
+    if (heap->free_bytes < heap->minimum_free_bytes) {
+        heap->minimum_free_bytes = heap->free_bytes;
+    }
+
+    multi_heap_internal_unlock(heap);
+
+    return block->data;
+}
+
+void multi_heap_free_impl(multi_heap_handle_t heap, void *p)
+{
+    heap_block_t *pb = get_block(p);
+
+    if (heap == NULL || p == NULL) {
+        return;
+    }
+
+    multi_heap_internal_lock(heap);
+
+    assert_valid_block(heap, pb);
+    MULTI_HEAP_ASSERT(!is_free(pb), pb); // block should not be free
+    MULTI_HEAP_ASSERT(!is_last_block(pb), pb); // block should not be last block
+    MULTI_HEAP_ASSERT(!is_first_block(heap, pb), pb); // block should not be first block
+
+    heap->free_bytes += block_data_size(pb);
+    free_block_and_merge(heap, pb);
+
+    multi_heap_internal_unlock(heap);
+}
+
+
+void *multi_heap_realloc_impl(multi_heap_handle_t heap, void *p, size_t size)
+{
+    heap_block_t *pb = get_block(p);
+    void *result;
+
+    assert(heap != NULL);
+
+    if (p == NULL) {
+        return multi_heap_malloc_impl(heap, size);
+    }
+
+    assert_valid_block(heap, pb);
+    // non-null realloc arg should be allocated
+    MULTI_HEAP_ASSERT(!is_free(pb), pb);
+
+    if (size == 0) {
+        /* note: calling multi_free_impl() here as we've already been
+           through any poison-unwrapping */
+        multi_heap_free_impl(heap, p);
+        return NULL;
+    }
+
+    if (heap == NULL) {
+        return NULL;
+    }
+
+    size = block_size_for(size);
+
+    multi_heap_internal_lock(heap);
+    result = NULL;
+
+    if (size <= block_data_size(pb)) {
+        // Shrinking....
+        split_if_necessary(heap, pb, size);
+        result = pb->data;
+    }
+    else if (heap->free_bytes < size - block_data_size(pb)) {
+        // Growing, but there's not enough total free space in the heap
+        multi_heap_internal_unlock(heap);
+        return NULL;
+    }
+
+    // New size is larger than existing block
+    if (result == NULL) {
+        // See if we can grow into one or both adjacent blocks
+        heap_block_t *orig_pb = pb;
+        size_t orig_size = block_data_size(orig_pb);
+        heap_block_t *next = get_next_block(pb);
+        size_t next_grow_size = (is_free(next) && !is_last_block(next)) ? block_data_size(next) + sizeof(next->header) : 0;
+        heap_block_t *prev = is_prev_free(pb) ? get_prev_block(pb) : NULL;
+        size_t prev_grow_size = (prev != NULL) ? block_data_size(prev) + sizeof(pb->header) : 0;
+
+        if (orig_size + next_grow_size + prev_grow_size >= size) {
+            if (next_grow_size > 0) {
+                remove_free_block(heap, next);
+                pb->header = (next->header & NEXT_BLOCK_MASK) | (pb->header & ~NEXT_BLOCK_MASK);
+                heap->free_bytes -= block_data_size(next);
+            }
+            // Grow into the previous block only if growing in place isn't enough, so the data needn't be moved
+            if (prev != NULL && orig_size + next_grow_size < size) {
+                remove_free_block(heap, prev);
+                heap->free_bytes -= block_data_size(prev);
+                prev->header = (pb->header & NEXT_BLOCK_MASK) | (prev->header & ~(NEXT_BLOCK_MASK | BLOCK_FREE_FLAG));
+                pb = prev;
+                memmove(pb->data, orig_pb->data, orig_size);
+            }
+            split_if_necessary(heap, pb, size);
+            result = pb->data;
+        }
+    }
+
+    if (result == NULL) {
+        // Need to allocate elsewhere and copy data over
+        //
+        // (Calling _impl versions here as we've already been through any
+        // unwrapping for heap poisoning features.)
+        result = multi_heap_malloc_impl(heap, size);
+        if (result != NULL) {
+            memcpy(result, pb->data, block_data_size(pb));
+            multi_heap_free_impl(heap, pb->data);
+        }
+    }
+
+    if (heap->free_bytes < heap->minimum_free_bytes) {
+        heap->minimum_free_bytes = heap->free_bytes;
+    }
+
+    multi_heap_internal_unlock(heap);
+    return result;
+}
+
+#define FAIL_PRINT(MSG, ...) do {                                       \
+        if (print_errors) {                                             \
+            MULTI_HEAP_STDERR_PRINTF(MSG, __VA_ARGS__);                 \
+        }                                                               \
+        valid = false;                                                  \
+    }                                                                   \
+    while(0)
+
+bool multi_heap_check(multi_heap_handle_t heap, bool print_errors)
+{
+    bool valid = true;
+    size_t total_free_bytes = 0;
+    size_t free_block_count = 0;
+    assert(heap != NULL);
+
+    multi_heap_internal_lock(heap);
+
+    heap_block_t *prev = NULL;
+
+    /* note: not using get_next_block() in loop, so that assertions aren't checked here */
+    for(heap_block_t *b = &heap->first_block; b != NULL; b = (heap_block_t *)(b->header & NEXT_BLOCK_MASK)) {
+        if (b == prev) {
+            FAIL_PRINT("CORRUPT HEAP: Block %p points to itself\n", b);
+            goto done;
+        }
+        if (b < prev) {
+            FAIL_PRINT("CORRUPT HEAP: Block %p is before prev block %p\n", b, prev);
+            goto done;
+        }
+        if (b > heap->last_block || b < &heap->first_block) {
+            FAIL_PRINT("CORRUPT HEAP: Block %p is outside heap (last valid block %p)\n", b, prev);
+            goto done;
+        }
+        bool prev_free = prev != NULL && is_free(prev) && !is_first_block(heap, prev);
+        if (is_prev_free(b) != prev_free) {
+            FAIL_PRINT("CORRUPT HEAP: Block %p previous free flag doesn't match block %p\n", b, prev);
+        }
+        if (is_free(b) && !is_first_block(heap, b) && !is_last_block(b)) {
+            if (prev_free) {
+                FAIL_PRINT("CORRUPT HEAP: Two adjacent free blocks found, %p and %p\n", prev, b);
+            }
+            if (*get_block_footer(b) != b) {
+                FAIL_PRINT("CORRUPT HEAP: Free block %p has footer %p\n", b, *get_block_footer(b));
+            }
+            total_free_bytes += block_data_size(b);
+            free_block_count++;
+        }
+        prev = b;
+
+#ifdef MULTI_HEAP_POISONING
+        if (!is_last_block(b) && !is_first_block(heap, b)) {
+            /* For slow heap poisoning, any block should contain correct poisoning patterns and/or fills */
+            bool poison_ok;
+            if (is_free(b)) {
+                uint32_t block_len = (intptr_t)get_next_block(b) - (intptr_t)b - sizeof(heap_block_t) - sizeof(heap_block_t *);
+                poison_ok = multi_heap_internal_check_block_poisoning(&b[1], block_len, true, print_errors);
+            }
+            else {
+                poison_ok = multi_heap_internal_check_block_poisoning(b->data, block_data_size(b), false, print_errors);
+            }
+            valid = poison_ok && valid;
+        }
+#endif
+
+    } /* for(heap_block_t b = ... */
+
+    if (prev != heap->last_block) {
+        FAIL_PRINT("CORRUPT HEAP: Last block %p not %p\n", prev, heap->last_block);
+    }
+    if (!is_free(heap->last_block)) {
+        FAIL_PRINT("CORRUPT HEAP: Expected prev block %p to be free\n", heap->last_block);
+    }
+
+    if (heap->free_bytes != total_free_bytes) {
+        FAIL_PRINT("CORRUPT HEAP: Expected %u free bytes counted %u\n", (unsigned)heap->free_bytes, (unsigned)total_free_bytes);
+    }
+
+    /* every free block should be in the list for its size, and the bitmaps should match the lists */
+    for (int fl = 0; fl < heap->fl_count; fl++) {
+        for (int sl = 0; sl < SL_INDEX_COUNT; sl++) {
+            heap_block_t *list = *get_list(heap, fl, sl);
+            bool bit_set = (heap->sl_bitmap[fl] & (1U << sl)) != 0;
+            if (bit_set != (list != NULL)) {
+                FAIL_PRINT("CORRUPT HEAP: Free list %d/%d bitmap doesn't match head %p\n", fl, sl, list);
+            }
+            heap_block_t *prev_free = NULL;
+            for (heap_block_t *b = list; b != NULL; b = b->next_free) {
+                int b_fl, b_sl;
+                if (b <= &heap->first_block || b >= heap->last_block || !is_free(b)) {
+                    FAIL_PRINT("CORRUPT HEAP: Free list %d/%d has invalid block %p\n", fl, sl, b);
+                    goto done;
+                }
+                mapping_insert(block_data_size(b), &b_fl, &b_sl);
+                if (b_fl != fl || b_sl != sl || b->prev_free != prev_free) {
+                    FAIL_PRINT("CORRUPT HEAP: Free block %p is in the wrong place in free list %d/%d\n", b, fl, sl);
+                }
+                if (free_block_count-- == 0) {
+                    FAIL_PRINT("CORRUPT HEAP: Free list %d/%d has more blocks than the heap\n", fl, sl);
+                    goto done;
+                }
+                prev_free = b;
+            }
+        }
+        if (((heap->fl_bitmap & (1U << fl)) != 0) != (heap->sl_bitmap[fl] != 0)) {
+            FAIL_PRINT("CORRUPT HEAP: First level bitmap 0x%08x doesn't match list %d\n", (unsigned)heap->fl_bitmap, fl);
+        }
+    }
+    if (free_block_count != 0) {
+        FAIL_PRINT("CORRUPT HEAP: %u free blocks are not in any free list\n", (unsigned)free_block_count);
+    }
+
+ done:
+    multi_heap_internal_unlock(heap);
+
+    return valid;
+}
+
+void multi_heap_dump(multi_heap_handle_t heap)
+{
+    assert(heap != NULL);
+
+    multi_heap_internal_lock(heap);
+    MULTI_HEAP_STDERR_PRINTF("Heap start %p end %p\nFree list bitmap 0x%08x\n", &heap->first_block, heap->last_block, (unsigned)heap->fl_bitmap);
+    for(heap_block_t *b = &heap->first_block; b != NULL; b = get_next_block(b)) {
+        MULTI_HEAP_STDERR_PRINTF("Block %p data size 0x%08x bytes next block %p", b, block_data_size(b), get_next_block(b));
+        if (is_free(b)) {
+            MULTI_HEAP_STDERR_PRINTF(" FREE. Next free %p prev free %p\n", b->next_free, b->prev_free);
+        } else {
+            MULTI_HEAP_STDERR_PRINTF("%s", "\n"); /* C macros & optional __VA_ARGS__ */
+        }
+    }
+    multi_heap_internal_unlock(heap);
+}
+
+size_t multi_heap_free_size_impl(multi_heap_handle_t heap)
+{
+    if (heap == NULL) {
+        return 0;
+    }
+    return heap->free_bytes;
+}
+
+size_t multi_heap_minimum_free_size_impl(multi_heap_handle_t heap)
+{
+    if (heap == NULL) {
+        return 0;
+    }
+    return heap->minimum_free_bytes;
+}
+
+void multi_heap_get_info_impl(multi_heap_handle_t heap, multi_heap_info_t *info)
+{
+    memset(info, 0, sizeof(multi_heap_info_t));
+
+    if (heap == NULL) {
+        return;
+    }
+
+    multi_heap_internal_lock(heap);
+    for(heap_block_t *b = get_next_block(&heap->first_block); !is_last_block(b); b = get_next_block(b)) {
+        info->total_blocks++;
+        if (is_free(b)) {
+            size_t s = block_data_size(b);
+            info->total_free_bytes += s;
+            if (s > info->largest_free_block) {
+                info->largest_free_block = s;
+            }
+            info->free_blocks++;
+            info->free_block_histogram[multi_heap_histogram_bucket(s)]++;
+        } else {
+            info->total_allocated_bytes += block_data_size(b);
+            info->allocated_blocks++;
+        }
+    }
+
+    info->minimum_free_bytes = heap->minimum_free_bytes;
+    multi_heap_update_fragmentation(info);
+    // heap has wrong total size (address printed here is not indicative of the real error)
+    MULTI_HEAP_ASSERT(info->total_free_bytes == heap->free_bytes, heap);
+
+    multi_heap_internal_unlock(heap);
+
+}
@@ -0,0 +1,85 @@
+/*
+ Tests for the per-task heap counters
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "esp_heap_task_info.h"
+#include "sdkconfig.h"
+
+#ifdef CONFIG_HEAP_TASK_TRACKING
+
+static void *s_block;
+
+static void alloc_task(void *arg)
+{
+    s_block = heap_caps_malloc(1000, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    xSemaphoreGive((SemaphoreHandle_t)arg);
+    vTaskSuspend(NULL);
+}
+
+TEST_CASE("heap task counters follow malloc and free", "[heap]")
+{
+    heap_task_stats_t before, stats;
+    if (heap_caps_get_task_stats(NULL, &before) != ESP_OK) {
+        memset(&before, 0, sizeof(before));
+    }
+
+    void *p = heap_caps_malloc(100, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(p);
+    TEST_ASSERT_EQUAL(ESP_OK, heap_caps_get_task_stats(NULL, &stats));
+    TEST_ASSERT_EQUAL(xTaskGetCurrentTaskHandle(), stats.task);
+    TEST_ASSERT_EQUAL(before.count[HEAP_TASK_STATS_INTERNAL] + 1, stats.count[HEAP_TASK_STATS_INTERNAL]);
+    TEST_ASSERT(stats.size[HEAP_TASK_STATS_INTERNAL] >= before.size[HEAP_TASK_STATS_INTERNAL] + 100);
+
+    p = heap_caps_realloc(p, 2000, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(p);
+    TEST_ASSERT_EQUAL(ESP_OK, heap_caps_get_task_stats(NULL, &stats));
+    TEST_ASSERT_EQUAL(before.count[HEAP_TASK_STATS_INTERNAL] + 1, stats.count[HEAP_TASK_STATS_INTERNAL]);
+    TEST_ASSERT(stats.size[HEAP_TASK_STATS_INTERNAL] >= before.size[HEAP_TASK_STATS_INTERNAL] + 2000);
+    TEST_ASSERT(stats.peak_size[HEAP_TASK_STATS_INTERNAL] >= stats.size[HEAP_TASK_STATS_INTERNAL]);
+
+    heap_caps_free(p);
+    TEST_ASSERT_EQUAL(ESP_OK, heap_caps_get_task_stats(NULL, &stats));
+    TEST_ASSERT_EQUAL(before.count[HEAP_TASK_STATS_INTERNAL], stats.count[HEAP_TASK_STATS_INTERNAL]);
+    TEST_ASSERT_EQUAL(before.size[HEAP_TASK_STATS_INTERNAL], stats.size[HEAP_TASK_STATS_INTERNAL]);
+}
+
+TEST_CASE("heap task counters charge the allocating task", "[heap]")
+{
+    SemaphoreHandle_t done = xSemaphoreCreateBinary();
+    TaskHandle_t task;
+    heap_task_stats_t stats;
+
+    TEST_ASSERT(xTaskCreate(alloc_task, "alloc_task", 2048, done, 5, &task));
+    TEST_ASSERT(xSemaphoreTake(done, 1000 / portTICK_PERIOD_MS));
+    TEST_ASSERT_NOT_NULL(s_block);
+    TEST_ASSERT_EQUAL(ESP_OK, heap_caps_get_task_stats(task, &stats));
+    TEST_ASSERT_EQUAL(1, stats.count[HEAP_TASK_STATS_INTERNAL]);
+    TEST_ASSERT(stats.size[HEAP_TASK_STATS_INTERNAL] >= 1000);
+
+    heap_task_stats_t all[CONFIG_HEAP_TASK_TRACKING_MAX_TASKS];
+    size_t count = heap_caps_get_all_task_stats(all, CONFIG_HEAP_TASK_TRACKING_MAX_TASKS, NULL);
+    bool found = false;
+    for (size_t i = 0; i < count; i++) {
+        found |= (all[i].task == task);
+    }
+    TEST_ASSERT_TRUE(found);
+
+    // freeing from another task still credits the task which allocated the block
+    heap_caps_free(s_block);
+    TEST_ASSERT_EQUAL(ESP_OK, heap_caps_get_task_stats(task, &stats));
+    TEST_ASSERT_EQUAL(0, stats.count[HEAP_TASK_STATS_INTERNAL]);
+    TEST_ASSERT_EQUAL(0, stats.size[HEAP_TASK_STATS_INTERNAL]);
+
+    vTaskDelete(task);
+    vSemaphoreDelete(done);
+    vTaskDelay(10); // let the idle task free the task
+}
+
+#endif // CONFIG_HEAP_TASK_TRACKING
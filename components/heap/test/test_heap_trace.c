@@ -14,8 +14,8 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
-#ifdef CONFIG_HEAP_TRACING
-// only compile in heap tracing tests if tracing is enabled
+#if defined(CONFIG_HEAP_TRACING) && !defined(CONFIG_HEAP_TRACING_SAMPLING)
+// only compile in heap tracing tests if tracing is enabled, sampling mode has its own tests below
 
 #include "esp_heap_trace.h"
 
@@ -161,4 +161,77 @@ TEST_CASE("can trace allocations made by newlib", "[heap]")
 }
 
 
+#endif
+
+#ifdef CONFIG_HEAP_TRACING_SAMPLING
+
+#include "esp_heap_trace.h"
+
+static void *sampled_malloc(size_t size) __attribute__((noinline));
+static void *sampled_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+/* Return the index of the call site with most live bytes, which sampled_malloc() allocations are recorded under.
+   Call sites are never reordered, so the index stays valid as long as tracing isn't restarted. */
+static size_t get_largest_callsite(void)
+{
+    size_t largest = 0;
+    size_t largest_bytes = 0;
+    for (int i = 0; i < heap_trace_get_callsite_count(); i++) {
+        heap_trace_callsite_t site;
+        TEST_ESP_OK(heap_trace_get_callsite(i, &site));
+        if (site.live_bytes >= largest_bytes) {
+            largest = i;
+            largest_bytes = site.live_bytes;
+        }
+    }
+    return largest;
+}
+
+TEST_CASE("sampling heap trace attributes live bytes to call sites", "[heap]")
+{
+    const size_t N = 32;
+    const size_t SIZE = 2048;
+    void *ptrs[N];
+
+    TEST_ESP_OK(heap_trace_init_sampling(SIZE)); // allocations of at least SIZE are always sampled
+    TEST_ESP_OK(heap_trace_start(HEAP_TRACE_LEAKS));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, heap_trace_init_sampling(SIZE));
+
+    for (int i = 0; i < N; i++) {
+        ptrs[i] = sampled_malloc(SIZE);
+        TEST_ASSERT_NOT_NULL(ptrs[i]);
+    }
+    heap_trace_dump();
+
+    size_t index = get_largest_callsite();
+    heap_trace_callsite_t site;
+    TEST_ESP_OK(heap_trace_get_callsite(index, &site));
+    TEST_ASSERT_EQUAL(N * SIZE, site.live_bytes);
+    TEST_ASSERT_EQUAL(N, site.live_samples);
+    TEST_ASSERT_EQUAL(N * SIZE, site.total_bytes);
+    TEST_ASSERT(heap_trace_get_count() >= N);
+
+    for (int i = 0; i < N; i += 2) {
+        free(ptrs[i]);
+    }
+    TEST_ESP_OK(heap_trace_get_callsite(index, &site));
+    TEST_ASSERT_EQUAL(N / 2 * SIZE, site.live_bytes);
+    TEST_ASSERT_EQUAL(N * SIZE, site.total_bytes);
+
+    for (int i = 1; i < N; i += 2) {
+        free(ptrs[i]);
+    }
+    TEST_ESP_OK(heap_trace_get_callsite(index, &site));
+    TEST_ASSERT_EQUAL(0, site.live_bytes);
+    TEST_ASSERT_EQUAL(0, site.live_samples);
+
+    heap_trace_record_t rec;
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, heap_trace_get(0, &rec));
+    TEST_ESP_OK(heap_trace_stop());
+    TEST_ESP_OK(heap_trace_init_sampling(CONFIG_HEAP_TRACING_SAMPLING_INTERVAL));
+}
+
 #endif
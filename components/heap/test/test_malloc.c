@@ -4,6 +4,7 @@
 
 #include <esp_types.h>
 #include <stdio.h>
+#include <string.h>
 #include "esp32/rom/ets_sys.h"
 
 #include "freertos/FreeRTOS.h"
@@ -132,3 +133,62 @@ TEST_CASE("unreasonable allocs should all fail", "[heap]")
     TEST_ASSERT_NULL(test_malloc_wrapper(xPortGetFreeHeapSize() - 1));
 }
 
+
+#ifdef CONFIG_HEAP_SMALL_CACHE
+TEST_CASE("small allocations are served from the per-core cache", "[heap]")
+{
+    heap_caps_small_cache_flush();
+    size_t free_before = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+
+    void *p[64];
+    for (int i = 0; i < 64; i++) {
+        p[i] = malloc(1 + (i * 37) % 256);
+        TEST_ASSERT_NOT_NULL(p[i]);
+    }
+    for (int i = 0; i < 63; i++) {
+        free(p[i]);
+    }
+
+    /* the most recently freed block of a size class is handed out first */
+    vTaskSuspendAll(); // stay on this core
+    free(p[63]);
+    void *again = malloc(1 + (63 * 37) % 256);
+    xTaskResumeAll();
+    TEST_ASSERT_EQUAL_PTR(p[63], again);
+    free(again);
+
+    /* cached blocks count as allocated until they are flushed */
+    TEST_ASSERT(heap_caps_get_free_size(MALLOC_CAP_DEFAULT) < free_before);
+    heap_caps_small_cache_flush();
+    TEST_ASSERT_EQUAL(free_before, heap_caps_get_free_size(MALLOC_CAP_DEFAULT));
+    TEST_ASSERT(heap_caps_check_integrity_all(true));
+}
+#endif
+
+TEST_CASE("arena allocations are released by reset and destroy", "[heap]")
+{
+    size_t free_before = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    heap_caps_arena_handle_t arena = heap_caps_arena_create(512, MALLOC_CAP_DEFAULT);
+    TEST_ASSERT_NOT_NULL(arena);
+
+    for (int round = 0; round < 4; round++) {
+        uint8_t *prev = NULL;
+        for (int i = 0; i < 100; i++) {
+            uint8_t *p = heap_caps_arena_alloc(arena, 1 + i % 30);
+            TEST_ASSERT_NOT_NULL(p);
+            TEST_ASSERT_EQUAL(0, (intptr_t)p % 4);
+            TEST_ASSERT(p != prev);
+            memset(p, 0xEE, 1 + i % 30);
+            prev = p;
+        }
+        uint32_t *z = heap_caps_arena_calloc(arena, 100, sizeof(uint32_t)); // larger than a quarter chunk
+        TEST_ASSERT_NOT_NULL(z);
+        for (int i = 0; i < 100; i++) {
+            TEST_ASSERT_EQUAL(0, z[i]);
+        }
+        heap_caps_arena_reset(arena);
+    }
+
+    heap_caps_arena_destroy(arena);
+    TEST_ASSERT_EQUAL(free_before, heap_caps_get_free_size(MALLOC_CAP_DEFAULT));
+}
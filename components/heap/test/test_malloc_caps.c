@@ -9,7 +9,10 @@
 #include "esp_heap_caps.h"
 #include "esp_spi_flash.h"
 #include <stdlib.h>
+#include <string.h>
 #include <sys/param.h>
+#include "soc/soc_memory_layout.h"
+#include "sdkconfig.h"
 
 TEST_CASE("Capabilities allocator test", "[heap]")
 {
@@ -134,3 +137,110 @@ TEST_CASE("heap_caps_xxx functions work with flash cache disabled", "[heap]")
 {
     TEST_ASSERT( iram_malloc_test() );
 }
+
+TEST_CASE("heap_caps pool allocates fixed size objects with the pool's capabilities", "[heap]")
+{
+    const size_t OBJ_SIZE = 30;
+    const size_t COUNT = 10;
+    void *objs[COUNT];
+    multi_heap_info_t info;
+
+    heap_caps_pool_handle_t pool = heap_caps_pool_create(OBJ_SIZE, COUNT, MALLOC_CAP_DMA);
+    TEST_ASSERT_NOT_NULL(pool);
+    TEST_ASSERT_EQUAL(COUNT, heap_caps_pool_get_free_count(pool));
+
+    for (int i = 0; i < COUNT; i++) {
+        objs[i] = heap_caps_pool_alloc(pool);
+        TEST_ASSERT_NOT_NULL(objs[i]);
+        TEST_ASSERT(esp_ptr_dma_capable(objs[i]));
+        TEST_ASSERT_EQUAL(0, (intptr_t)objs[i] % 4);
+        memset(objs[i], i, OBJ_SIZE);
+    }
+    TEST_ASSERT_NULL(heap_caps_pool_alloc(pool));
+    TEST_ASSERT_EQUAL(0, heap_caps_pool_get_free_count(pool));
+    for (int i = 0; i < COUNT; i++) {
+        for (int j = 0; j < OBJ_SIZE; j++) {
+            TEST_ASSERT_EQUAL(i, ((uint8_t *)objs[i])[j]);
+        }
+    }
+
+    heap_caps_get_info(&info, MALLOC_CAP_DMA);
+    TEST_ASSERT(info.pool_allocated_bytes >= COUNT * OBJ_SIZE);
+
+    heap_caps_pool_free(pool, objs[3]);
+    TEST_ASSERT_EQUAL(1, heap_caps_pool_get_free_count(pool));
+    TEST_ASSERT_EQUAL_PTR(objs[3], heap_caps_pool_alloc(pool));
+
+    for (int i = 0; i < COUNT; i++) {
+        heap_caps_pool_free(pool, objs[i]);
+    }
+    TEST_ASSERT_EQUAL(COUNT, heap_caps_pool_get_free_count(pool));
+    heap_caps_get_info(&info, MALLOC_CAP_DMA);
+    TEST_ASSERT(info.pool_free_bytes >= COUNT * OBJ_SIZE);
+
+    heap_caps_pool_delete(pool);
+}
+
+TEST_CASE("heap_caps placement hints prefer memory but fall back", "[heap]")
+{
+    void *hot = heap_caps_malloc(64, MALLOC_CAP_8BIT | MALLOC_CAP_HOT);
+    TEST_ASSERT_NOT_NULL(hot);
+    TEST_ASSERT(esp_ptr_internal(hot));
+
+    void *cold = heap_caps_malloc(64, MALLOC_CAP_8BIT | MALLOC_CAP_COLD);
+    TEST_ASSERT_NOT_NULL(cold);
+#if CONFIG_SPIRAM_USE_CAPS_ALLOC || CONFIG_SPIRAM_USE_MALLOC
+    TEST_ASSERT(esp_ptr_external_ram(cold));
+#else
+    TEST_ASSERT(esp_ptr_internal(cold));
+#endif
+    memset(cold, 0x5a, 64);
+    // realloc moves the block into the preferred memory
+    cold = heap_caps_realloc(cold, 128, MALLOC_CAP_8BIT | MALLOC_CAP_HOT);
+    TEST_ASSERT_NOT_NULL(cold);
+    TEST_ASSERT(esp_ptr_internal(cold));
+    TEST_ASSERT_EQUAL_HEX8(0x5a, ((uint8_t *)cold)[63]);
+
+    // DMA capable memory is never external, so the hint falls back
+    void *dma = heap_caps_malloc(64, MALLOC_CAP_DMA | MALLOC_CAP_COLD);
+    TEST_ASSERT_NOT_NULL(dma);
+    TEST_ASSERT(esp_ptr_dma_capable(dma));
+
+    // hints are not capabilities
+    TEST_ASSERT_EQUAL(heap_caps_get_free_size(MALLOC_CAP_8BIT), heap_caps_get_free_size(MALLOC_CAP_8BIT | MALLOC_CAP_HOT));
+
+    heap_caps_free(hot);
+    heap_caps_free(cold);
+    heap_caps_free(dma);
+}
+
+TEST_CASE("heap trend keeps the newest samples", "[heap]")
+{
+    const size_t LENGTH = 4;
+    heap_caps_trend_sample_t samples[LENGTH + 1];
+    heap_caps_trend_handle_t trend = heap_caps_trend_create(MALLOC_CAP_8BIT, LENGTH);
+    TEST_ASSERT_NOT_NULL(trend);
+    TEST_ASSERT_EQUAL(0, heap_caps_trend_get(trend, samples, LENGTH));
+
+    void *p[LENGTH + 2];
+    for (int i = 0; i < LENGTH + 2; i++) {
+        p[i] = heap_caps_malloc(4096, MALLOC_CAP_8BIT);
+        TEST_ASSERT_NOT_NULL(p[i]);
+        heap_caps_trend_sample(trend);
+    }
+
+    TEST_ASSERT_EQUAL(LENGTH, heap_caps_trend_get(trend, samples, LENGTH + 1));
+    for (int i = 1; i < LENGTH; i++) {
+        /* oldest first, and each sample was taken with another 4KB allocated */
+        TEST_ASSERT(samples[i].total_free_bytes + 4096 <= samples[i - 1].total_free_bytes);
+        TEST_ASSERT(samples[i].timestamp >= samples[i - 1].timestamp);
+        TEST_ASSERT(samples[i].fragmentation <= 100);
+    }
+    TEST_ASSERT_EQUAL(2, heap_caps_trend_get(trend, samples, 2));
+    TEST_ASSERT_EQUAL(heap_caps_get_free_size(MALLOC_CAP_8BIT), samples[1].total_free_bytes);
+
+    for (int i = 0; i < LENGTH + 2; i++) {
+        heap_caps_free(p[i]);
+    }
+    heap_caps_trend_delete(trend);
+}
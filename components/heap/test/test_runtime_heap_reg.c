@@ -66,3 +66,28 @@ TEST_CASE("Add .bss memory to heap region runtime", "[heap][ignore]")
     /* Twice add must be failed */
     TEST_ASSERT( (heap_caps_add_region((intptr_t)s_buffer, (intptr_t)s_buffer + BUF_SZ) != ESP_OK) );
 }
+
+/* NOTE: This is not a well-formed unit test, it leaks memory */
+TEST_CASE("Free blocks from a heap added inside another heap's region", "[heap][ignore]")
+{
+    const size_t BUF_SZ = 1000;
+    const uint32_t MALLOC_CAP_INVENTED = (1<<30); /* this must be unused in esp_heap_caps.h */
+
+    void *buffer = malloc(BUF_SZ);
+    TEST_ASSERT_NOT_NULL(buffer);
+    /* allocated after buffer, so likely at a higher address in the same heap */
+    void *after = malloc(100);
+    TEST_ASSERT_NOT_NULL(after);
+
+    uint32_t caps[SOC_MEMORY_TYPE_NO_PRIOS] = { MALLOC_CAP_INVENTED };
+    TEST_ESP_OK( heap_caps_add_region_with_caps(caps, (intptr_t)buffer, (intptr_t)buffer + BUF_SZ) );
+
+    /* blocks in the new heap and past its end in the enclosing heap are both freed to the right heap */
+    void *inner = heap_caps_malloc(100, MALLOC_CAP_INVENTED);
+    TEST_ASSERT_NOT_NULL(inner);
+    TEST_ASSERT(inner >= buffer && (intptr_t)inner < (intptr_t)buffer + BUF_SZ);
+    TEST_ASSERT(heap_caps_check_integrity_addr((intptr_t)inner, true));
+    heap_caps_free(inner);
+    free(after);
+    TEST_ASSERT(heap_caps_check_integrity_all(true));
+}
@@ -10,6 +10,12 @@ for FLAGS in "CONFIG_HEAP_POISONING_NONE" "CONFIG_HEAP_POISONING_LIGHT" "CONFIG_
     CPPFLAGS="-D${FLAGS}" make clean test || FAIL=1
 done
 
+for FLAGS in "CONFIG_HEAP_POISONING_NONE" "CONFIG_HEAP_POISONING_LIGHT" "CONFIG_HEAP_POISONING_COMPREHENSIVE"; do
+    echo "==== Testing TLSF allocator with config: ${FLAGS} ===="
+    CPPFLAGS="-D${FLAGS} -DCONFIG_HEAP_ALLOCATOR_TLSF" HEAP_SOURCE=multi_heap_tlsf.c TEST_ARGS="~[best_fit]" \
+        make clean test || FAIL=1
+done
+
 make clean
 
 if [ $FAIL == 0 ]; then
@@ -16,7 +16,10 @@
 #undef realloc
 #define realloc #error
 
-TEST_CASE("multi_heap simple allocations", "[multi_heap]")
+/* Tests tagged [best_fit] use heaps too small for the TLSF allocator's free list heads,
+   or rely on where the default best fit allocator places each block. */
+
+TEST_CASE("multi_heap simple allocations", "[multi_heap][best_fit]")
 {
     uint8_t small_heap[128];
 
@@ -57,7 +60,7 @@ TEST_CASE("multi_heap simple allocations", "[multi_heap]")
 }
 
 
-TEST_CASE("multi_heap fragmentation", "[multi_heap]")
+TEST_CASE("multi_heap fragmentation", "[multi_heap][best_fit]")
 {
     uint8_t small_heap[256];
     multi_heap_handle_t heap = multi_heap_register(small_heap, sizeof(small_heap));
@@ -106,7 +109,7 @@ TEST_CASE("multi_heap fragmentation", "[multi_heap]")
 }
 
 /* Test that malloc/free does not leave free space fragmented */
-TEST_CASE("multi_heap defrag", "[multi_heap]")
+TEST_CASE("multi_heap defrag", "[multi_heap][best_fit]")
 {
     void *p[4];
     uint8_t small_heap[512];
@@ -156,7 +159,7 @@ TEST_CASE("multi_heap defrag", "[multi_heap]")
    Note: With fancy poisoning, realloc is implemented as malloc-copy-free and this test does not apply.
  */
 #ifndef MULTI_HEAP_POISONING_SLOW
-TEST_CASE("multi_heap defrag realloc", "[multi_heap]")
+TEST_CASE("multi_heap defrag realloc", "[multi_heap][best_fit]")
 {
     void *p[4];
     uint8_t small_heap[512];
@@ -294,7 +297,7 @@ TEST_CASE("multi_heap many random allocations", "[multi_heap]")
     REQUIRE( initial_free == multi_heap_free_size(heap) );
 }
 
-TEST_CASE("multi_heap_get_info() function", "[multi_heap]")
+TEST_CASE("multi_heap_get_info() function", "[multi_heap][best_fit]")
 {
     uint8_t heapdata[256];
     multi_heap_handle_t heap = multi_heap_register(heapdata, sizeof(heapdata));
@@ -388,7 +391,7 @@ TEST_CASE("multi_heap minimum-size allocations", "[multi_heap]")
     REQUIRE( before_free == multi_heap_free_size(heap) );
 }
 
-TEST_CASE("multi_heap_realloc()", "[multi_heap]")
+TEST_CASE("multi_heap_realloc()", "[multi_heap][best_fit]")
 {
     const uint32_t PATTERN = 0xABABDADA;
     uint8_t small_heap[300];
@@ -443,7 +446,7 @@ TEST_CASE("multi_heap_realloc()", "[multi_heap]")
 #endif
 }
 
-TEST_CASE("corrupt heap block", "[multi_heap]")
+TEST_CASE("corrupt heap block", "[multi_heap][best_fit]")
 {
     uint8_t small_heap[256];
     multi_heap_handle_t heap = multi_heap_register(small_heap, sizeof(small_heap));
@@ -454,7 +457,7 @@ TEST_CASE("corrupt heap block", "[multi_heap]")
     REQUIRE( !multi_heap_check(heap, true) );
 }
 
-TEST_CASE("unaligned heaps", "[multi_heap]")
+TEST_CASE("unaligned heaps", "[multi_heap][best_fit]")
 {
     const size_t CHUNK_LEN = 256;
     const size_t CANARY_LEN = 16;
@@ -494,3 +497,134 @@ TEST_CASE("unaligned heaps", "[multi_heap]")
         }
     }
 }
+
+TEST_CASE("multi_heap freeing everything leaves a single free block", "[multi_heap]")
+{
+    uint8_t heapdata[8192];
+    void *p[128] = { 0 };
+    const size_t NUM_P = sizeof(p) / sizeof(void *);
+    multi_heap_handle_t heap = multi_heap_register(heapdata, sizeof(heapdata));
+    multi_heap_info_t info;
+
+    size_t before_free = multi_heap_free_size(heap);
+
+    for (int iteration = 0; iteration < 100; iteration++) {
+        for (size_t i = 0; i < NUM_P; i++) {
+            p[i] = multi_heap_malloc(heap, 1 + rand() % 200);
+        }
+        REQUIRE( multi_heap_check(heap, true) );
+
+        /* Free in random order, every free should be merged with its free neighbours */
+        for (size_t i = 0; i < NUM_P; i++) {
+            size_t j = i + rand() % (NUM_P - i);
+            void *tmp = p[j];
+            p[j] = p[i];
+            multi_heap_free(heap, tmp);
+            p[i] = NULL;
+        }
+        REQUIRE( multi_heap_check(heap, true) );
+
+        multi_heap_get_info(heap, &info);
+        REQUIRE( 1 == info.free_blocks );
+        REQUIRE( before_free == info.largest_free_block );
+        REQUIRE( before_free == multi_heap_free_size(heap) );
+    }
+}
+
+TEST_CASE("multi_heap can always allocate the largest free block", "[multi_heap]")
+{
+    uint8_t heapdata[8192];
+    void *p[64] = { 0 };
+    const size_t NUM_P = sizeof(p) / sizeof(void *);
+    multi_heap_handle_t heap = multi_heap_register(heapdata, sizeof(heapdata));
+    multi_heap_info_t info;
+
+    for (int iteration = 0; iteration < 1000; iteration++) {
+        size_t i = rand() % NUM_P;
+        multi_heap_free(heap, p[i]);
+        p[i] = multi_heap_malloc(heap, 1 + rand() % 400);
+
+        multi_heap_get_info(heap, &info);
+        if (info.largest_free_block > 0) {
+            void *largest = multi_heap_malloc(heap, info.largest_free_block);
+            REQUIRE( largest != NULL );
+            REQUIRE( info.largest_free_block <= multi_heap_get_allocated_size(heap, largest) );
+            multi_heap_free(heap, largest);
+        }
+        REQUIRE( multi_heap_check(heap, true) );
+    }
+    for (size_t i = 0; i < NUM_P; i++) {
+        multi_heap_free(heap, p[i]);
+    }
+}
+
+TEST_CASE("multi_heap_get_info() reports fragmentation and free block sizes", "[multi_heap]")
+{
+    uint8_t heapdata[8192];
+    void *p[16];
+    multi_heap_handle_t heap = multi_heap_register(heapdata, sizeof(heapdata));
+    multi_heap_info_t info;
+
+    multi_heap_get_info(heap, &info);
+    REQUIRE( 0 == info.fragmentation );
+    REQUIRE( 1 == info.free_block_histogram[8] ); /* the heap is a single free block of 4KB to 8KB */
+
+    for (int i = 0; i < 16; i++) {
+        p[i] = multi_heap_malloc(heap, 100);
+        REQUIRE( p[i] != NULL );
+    }
+    for (int i = 0; i < 16; i += 2) {
+        multi_heap_free(heap, p[i]);
+    }
+
+    multi_heap_get_info(heap, &info);
+    size_t histogram_blocks = 0;
+    for (int i = 0; i < MULTI_HEAP_HISTOGRAM_BUCKETS; i++) {
+        histogram_blocks += info.free_block_histogram[i];
+    }
+    REQUIRE( info.free_blocks == histogram_blocks );
+    REQUIRE( info.free_block_histogram[2] >= 8 ); /* the freed 100 byte blocks, 64 to 127 bytes */
+    REQUIRE( info.fragmentation > 0 );
+    REQUIRE( info.fragmentation == 100 - 100 * info.largest_free_block / info.total_free_bytes );
+
+    for (int i = 1; i < 16; i += 2) {
+        multi_heap_free(heap, p[i]);
+    }
+    multi_heap_get_info(heap, &info);
+    REQUIRE( 0 == info.fragmentation );
+    REQUIRE( multi_heap_check(heap, true) );
+}
+
+#ifndef MULTI_HEAP_POISONING_SLOW
+TEST_CASE("multi_heap_realloc() grows in place before moving into the previous block", "[multi_heap]")
+{
+    const uint32_t PATTERN = 0xABABDADA;
+    uint8_t heapdata[4096];
+    multi_heap_handle_t heap = multi_heap_register(heapdata, sizeof(heapdata));
+
+    uint32_t *a = (uint32_t *)multi_heap_malloc(heap, 64);
+    uint32_t *b = (uint32_t *)multi_heap_malloc(heap, 64);
+    uint32_t *c = (uint32_t *)multi_heap_malloc(heap, 64);
+    uint32_t *d = (uint32_t *)multi_heap_malloc(heap, 64);
+    REQUIRE( (a < b && b < c && c < d) ); /* blocks are allocated in address order */
+
+    *b = PATTERN;
+    multi_heap_free(heap, a);
+    multi_heap_free(heap, c);
+
+    /* growing into 'c' is enough, so 'b' doesn't move even though 'a' is also free */
+    uint32_t *e = (uint32_t *)multi_heap_realloc(heap, b, 96);
+    REQUIRE( multi_heap_check(heap, true) );
+    REQUIRE( e == b );
+    REQUIRE( *e == PATTERN );
+
+    /* growing into what is left of 'c' isn't enough any more, so 'e' also takes over 'a' */
+    uint32_t *f = (uint32_t *)multi_heap_realloc(heap, e, 184);
+    REQUIRE( multi_heap_check(heap, true) );
+    REQUIRE( f == a );
+    REQUIRE( *f == PATTERN );
+
+    multi_heap_free(heap, f);
+    multi_heap_free(heap, d);
+}
+#endif
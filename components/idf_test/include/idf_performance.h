@@ -25,3 +25,7 @@
 // esp_sha() time to process 32KB of input data from RAM
 #define IDF_PERFORMANCE_MAX_ESP32_TIME_SHA1_32KB 5000
 #define IDF_PERFORMANCE_MAX_ESP32_TIME_SHA512_32KB 4500
+// esp_crc32_le() time to process 4KB of input data from RAM
+#define IDF_PERFORMANCE_MAX_ESP_CRC32_4KB_TIME 150
+// esp_parallel_for() of two chunks from a task which is not a worker, woken workers
+#define IDF_PERFORMANCE_MAX_ESP_PARALLEL_FOR_DISPATCH_US 100
@@ -0,0 +1,6 @@
+#
+# Component Makefile
+#
+
+COMPONENT_ADD_INCLUDEDIRS := include/
+COMPONENT_SRCDIRS := src/
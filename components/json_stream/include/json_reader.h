@@ -0,0 +1,137 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Events reported by the streaming reader */
+typedef enum {
+    JSON_READER_OBJECT_START,   ///< '{'
+    JSON_READER_OBJECT_END,     ///< '}'
+    JSON_READER_ARRAY_START,    ///< '['
+    JSON_READER_ARRAY_END,      ///< ']'
+    JSON_READER_KEY,            ///< Key of an object member, value is the unescaped key
+    JSON_READER_STRING,         ///< String value, value is the unescaped string
+    JSON_READER_NUMBER,         ///< Number, value is the number as written in the document
+    JSON_READER_TRUE,           ///< true
+    JSON_READER_FALSE,          ///< false
+    JSON_READER_NULL,           ///< null
+} json_reader_event_t;
+
+/**
+ * @brief Function called by the reader for each event
+ *
+ * @param event Event
+ * @param value For keys, strings and numbers, the NUL terminated text in the buffer
+ *              of the reader, valid until the callback returns. NULL for other events.
+ * @param len Length of value, without the NUL terminator
+ * @param depth Number of objects and arrays which contain the event. For start and
+ *              end events, the depth outside of the object or array.
+ * @param ctx Context passed to json_reader_init()
+ *
+ * @return ESP_OK to continue, another code stops the reader and is returned by
+ *         json_reader_feed()
+ */
+typedef esp_err_t (*json_reader_cb_t)(json_reader_event_t event, const char *value, size_t len,
+                                      int depth, void *ctx);
+
+/**
+ * @brief Streaming reader
+ *
+ * The contents are private, a reader is initialized with json_reader_init().
+ */
+typedef struct {
+    /** @cond */    //Doxygen command to hide this structure from API Reference
+    json_reader_cb_t cb;
+    void *ctx;
+    char *buf;
+    size_t buf_size;
+    size_t len;
+    esp_err_t err;
+    uint8_t state;
+    uint8_t token;
+    uint8_t literal;
+    uint8_t hex_count;
+    uint16_t code;
+    uint16_t high_surrogate;
+    int depth;
+    uint32_t stack[(CONFIG_JSON_STREAM_MAX_DEPTH + 31) / 32];
+    /** @endcond */
+} json_reader_t;
+
+/**
+ * @brief Initialize a streaming reader
+ *
+ * The reader does not allocate memory. buf holds the key, string or number which
+ * is being read, so the longest key, string or number of the document must be
+ * shorter than buf_size.
+ *
+ * @param reader Reader
+ * @param buf Buffer for keys, strings and numbers
+ * @param buf_size Size of buf
+ * @param cb Function called for each event
+ * @param ctx Context passed to cb
+ *
+ * @return
+ *      - ESP_OK Success
+ *      - ESP_ERR_INVALID_ARG reader, buf or cb is NULL, or buf_size is 0
+ */
+esp_err_t json_reader_init(json_reader_t *reader, char *buf, size_t buf_size,
+                           json_reader_cb_t cb, void *ctx);
+
+/**
+ * @brief Read the next part of a document
+ *
+ * The document may be split at any byte, e.g. in the chunks returned by
+ * httpd_req_recv(). The callback is called for each complete event. After an
+ * error, the reader returns the same error until it is initialized again.
+ *
+ * @param reader Reader
+ * @param data Next part of the document
+ * @param len Length of data
+ *
+ * @return
+ *      - ESP_OK Success
+ *      - ESP_FAIL The document is not valid JSON, or there is data after the document
+ *      - ESP_ERR_INVALID_SIZE A key, string or number does not fit in the buffer, or
+ *        the document is nested deeper than CONFIG_JSON_STREAM_MAX_DEPTH
+ *      - Other codes returned by the callback
+ */
+esp_err_t json_reader_feed(json_reader_t *reader, const char *data, size_t len);
+
+/**
+ * @brief Signal the end of the document
+ *
+ * Reports a number which ends the document, e.g. "42".
+ *
+ * @param reader Reader
+ *
+ * @return
+ *      - ESP_OK The document is complete
+ *      - ESP_ERR_INVALID_STATE The document is empty or incomplete
+ *      - Errors of json_reader_feed()
+ */
+esp_err_t json_reader_finish(json_reader_t *reader);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,191 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "jsmn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Document tokenized by jsmn
+ *
+ * The getters below take the index of a token, 0 being the top level value, and
+ * match the cJSON getters. Like cJSON getters accept NULL, they accept an index of
+ * -1, which is returned when an item is not found, so calls can be chained.
+ */
+typedef struct {
+    const char *js;             ///< Document, not necessarily NUL terminated
+    const jsmntok_t *tokens;    ///< Tokens of the document
+    int count;                  ///< Number of tokens
+} json_tokens_t;
+
+/**
+ * @brief Tokenize a document with jsmn
+ *
+ * The document and the tokens are not copied, and must stay valid while doc is used.
+ * A value takes one token, an object member takes two. For example, a document of
+ * 20 KB typically needs a few hundred tokens.
+ *
+ * jsmn is not built with JSMN_STRICT and accepts some invalid documents, such as
+ * unquoted strings. The getters check the values they read, json_reader_t can be
+ * used when a document must be validated.
+ *
+ * @param doc Tokenized document
+ * @param js Document
+ * @param len Length of js
+ * @param tokens Array of tokens
+ * @param num_tokens Number of tokens in the array
+ *
+ * @return
+ *      - ESP_OK Success
+ *      - ESP_ERR_NO_MEM The document has more than num_tokens tokens
+ *      - ESP_ERR_INVALID_STATE The document is empty or incomplete
+ *      - ESP_FAIL The document is not valid JSON
+ */
+esp_err_t json_tokens_parse(json_tokens_t *doc, const char *js, size_t len,
+                            jsmntok_t *tokens, unsigned int num_tokens);
+
+/**
+ * @brief Index of the token after a value and all its children
+ *
+ * @param doc Tokenized document
+ * @param index Token of the value
+ *
+ * @return Index of the next token, doc->count at the end of the document, -1 if index is -1
+ */
+int json_tokens_skip(const json_tokens_t *doc, int index);
+
+/**
+ * @brief Value of an object member, like cJSON_GetObjectItemCaseSensitive()
+ *
+ * Keys are compared as written in the document, escape sequences are not decoded.
+ *
+ * @param doc Tokenized document
+ * @param object Token of the object
+ * @param key Key
+ *
+ * @return Index of the value, -1 if object is not an object or has no member key
+ */
+int json_tokens_get_object_item(const json_tokens_t *doc, int object, const char *key);
+
+/**
+ * @brief Number of items of an array or members of an object, like cJSON_GetArraySize()
+ *
+ * @param doc Tokenized document
+ * @param index Token of the array or object
+ *
+ * @return Number of items, 0 if index is not an array or an object
+ */
+int json_tokens_get_array_size(const json_tokens_t *doc, int index);
+
+/**
+ * @brief Item of an array, like cJSON_GetArrayItem()
+ *
+ * @param doc Tokenized document
+ * @param array Token of the array
+ * @param item Position of the item, from 0
+ *
+ * @return Index of the item, -1 if array is not an array or is too short
+ */
+int json_tokens_get_array_item(const json_tokens_t *doc, int array, int item);
+
+/** @brief true if the token is an object, like cJSON_IsObject() */
+bool json_tokens_is_object(const json_tokens_t *doc, int index);
+
+/** @brief true if the token is an array, like cJSON_IsArray() */
+bool json_tokens_is_array(const json_tokens_t *doc, int index);
+
+/** @brief true if the token is a string, like cJSON_IsString() */
+bool json_tokens_is_string(const json_tokens_t *doc, int index);
+
+/** @brief true if the token is a number, like cJSON_IsNumber() */
+bool json_tokens_is_number(const json_tokens_t *doc, int index);
+
+/** @brief true if the token is true or false, like cJSON_IsBool() */
+bool json_tokens_is_bool(const json_tokens_t *doc, int index);
+
+/** @brief true if the token is null, like cJSON_IsNull() */
+bool json_tokens_is_null(const json_tokens_t *doc, int index);
+
+/**
+ * @brief Read a string value, like cJSON_GetStringValue()
+ *
+ * Escape sequences are decoded, and the string is NUL terminated.
+ *
+ * @param doc Tokenized document
+ * @param index Token of the string
+ * @param buf Buffer for the string
+ * @param size Size of buf
+ *
+ * @return
+ *      - ESP_OK Success
+ *      - ESP_ERR_NOT_FOUND index is -1
+ *      - ESP_ERR_INVALID_ARG The token is not a string, or has an invalid escape sequence
+ *      - ESP_ERR_INVALID_SIZE The string does not fit in buf
+ */
+esp_err_t json_tokens_get_string(const json_tokens_t *doc, int index, char *buf, size_t size);
+
+/**
+ * @brief Read a number, like the valuedouble member of cJSON
+ *
+ * @param doc Tokenized document
+ * @param index Token of the number
+ * @param value Value of the number
+ *
+ * @return
+ *      - ESP_OK Success
+ *      - ESP_ERR_NOT_FOUND index is -1
+ *      - ESP_ERR_INVALID_ARG The token is not a number
+ */
+esp_err_t json_tokens_get_double(const json_tokens_t *doc, int index, double *value);
+
+/**
+ * @brief Read an integer number, like the valueint member of cJSON
+ *
+ * @param doc Tokenized document
+ * @param index Token of the number
+ * @param value Value of the number
+ *
+ * @return
+ *      - ESP_OK Success
+ *      - ESP_ERR_NOT_FOUND index is -1
+ *      - ESP_ERR_INVALID_ARG The token is not an integer number
+ *      - ESP_ERR_INVALID_SIZE The number does not fit in int64_t
+ */
+esp_err_t json_tokens_get_int(const json_tokens_t *doc, int index, int64_t *value);
+
+/**
+ * @brief Read a boolean, like cJSON_IsTrue()
+ *
+ * @param doc Tokenized document
+ * @param index Token of the boolean
+ * @param value Value of the boolean
+ *
+ * @return
+ *      - ESP_OK Success
+ *      - ESP_ERR_NOT_FOUND index is -1
+ *      - ESP_ERR_INVALID_ARG The token is not true or false
+ */
+esp_err_t json_tokens_get_bool(const json_tokens_t *doc, int index, bool *value);
+
+#ifdef __cplusplus
+}
+#endif
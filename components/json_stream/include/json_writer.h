@@ -0,0 +1,248 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Function called by the writer when its buffer is full, and by json_writer_finish()
+ *
+ * For example, a function calling httpd_resp_send_chunk(ctx, data, len).
+ *
+ * @param data Output, not NUL terminated
+ * @param len Length of data
+ * @param ctx Context passed to json_writer_init()
+ *
+ * @return ESP_OK on success, another code is returned by the writer functions
+ */
+typedef esp_err_t (*json_writer_flush_t)(const char *data, size_t len, void *ctx);
+
+/**
+ * @brief Incremental writer
+ *
+ * The contents are private, a writer is initialized with json_writer_init().
+ */
+typedef struct {
+    /** @cond */    //Doxygen command to hide this structure from API Reference
+    json_writer_flush_t flush;
+    void *ctx;
+    char *buf;
+    size_t buf_size;
+    size_t len;
+    size_t flushed;
+    esp_err_t err;
+    bool need_comma;
+    bool after_key;
+    int depth;
+    uint32_t stack[(CONFIG_JSON_STREAM_MAX_DEPTH + 31) / 32];
+    /** @endcond */
+} json_writer_t;
+
+/**
+ * @brief Initialize an incremental writer
+ *
+ * The writer does not allocate memory, the output is written to buf. Without a flush
+ * function, the whole document must fit in buf, and buf holds the NUL terminated
+ * document after json_writer_finish(). With a flush function, buf is flushed each
+ * time it is full, so it may be much smaller than the document.
+ *
+ * The writer checks that keys and values are written in a valid order. After an
+ * error, all functions return the same error until the writer is initialized again.
+ *
+ * @param writer Writer
+ * @param buf Output buffer
+ * @param buf_size Size of buf, at least 2
+ * @param flush Function called with the output when buf is full, or NULL
+ * @param ctx Context passed to flush
+ *
+ * @return
+ *      - ESP_OK Success
+ *      - ESP_ERR_INVALID_ARG writer or buf is NULL, or buf_size is less than 2
+ */
+esp_err_t json_writer_init(json_writer_t *writer, char *buf, size_t buf_size,
+                           json_writer_flush_t flush, void *ctx);
+
+/**
+ * @brief Start an object
+ *
+ * @param writer Writer
+ *
+ * @return
+ *      - ESP_OK Success
+ *      - ESP_ERR_INVALID_STATE A key is expected, or the document is complete
+ *      - ESP_ERR_INVALID_SIZE More than CONFIG_JSON_STREAM_MAX_DEPTH objects and arrays are open
+ *      - ESP_ERR_NO_MEM The buffer is full and there is no flush function
+ *      - Errors returned by the flush function
+ */
+esp_err_t json_writer_object_start(json_writer_t *writer);
+
+/**
+ * @brief End the current object
+ *
+ * @param writer Writer
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no object is open or the
+ *         value of the last key is missing, or errors of json_writer_object_start()
+ */
+esp_err_t json_writer_object_end(json_writer_t *writer);
+
+/**
+ * @brief Start an array
+ *
+ * @param writer Writer
+ *
+ * @return See json_writer_object_start()
+ */
+esp_err_t json_writer_array_start(json_writer_t *writer);
+
+/**
+ * @brief End the current array
+ *
+ * @param writer Writer
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no array is open, or errors
+ *         of json_writer_object_start()
+ */
+esp_err_t json_writer_array_end(json_writer_t *writer);
+
+/**
+ * @brief Write the key of the next member of the current object
+ *
+ * @param writer Writer
+ * @param key NUL terminated key, escaped as needed
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no object is open or a value
+ *         is expected, or errors of json_writer_object_start()
+ */
+esp_err_t json_writer_key(json_writer_t *writer, const char *key);
+
+/**
+ * @brief Write a string
+ *
+ * Quotes, backslashes and control characters are escaped, other characters are
+ * written unchanged.
+ *
+ * @param writer Writer
+ * @param str NUL terminated string
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if a key is expected or the
+ *         document is complete, or errors of json_writer_object_start()
+ */
+esp_err_t json_writer_string(json_writer_t *writer, const char *str);
+
+/**
+ * @brief Write a string of a given length
+ *
+ * @param writer Writer
+ * @param str String, may contain NUL characters
+ * @param len Length of str
+ *
+ * @return See json_writer_string()
+ */
+esp_err_t json_writer_string_len(json_writer_t *writer, const char *str, size_t len);
+
+/**
+ * @brief Write an integer
+ *
+ * @param writer Writer
+ * @param value Value
+ *
+ * @return See json_writer_string()
+ */
+esp_err_t json_writer_int(json_writer_t *writer, int64_t value);
+
+/**
+ * @brief Write a floating point number
+ *
+ * Like cJSON, the shortest of 15 and 17 significant digits which reads back as the
+ * same value is used. NaN and infinities, which JSON cannot represent, are
+ * written as null.
+ *
+ * @param writer Writer
+ * @param value Value
+ *
+ * @return See json_writer_string()
+ */
+esp_err_t json_writer_double(json_writer_t *writer, double value);
+
+/**
+ * @brief Write true or false
+ *
+ * @param writer Writer
+ * @param value Value
+ *
+ * @return See json_writer_string()
+ */
+esp_err_t json_writer_bool(json_writer_t *writer, bool value);
+
+/**
+ * @brief Write null
+ *
+ * @param writer Writer
+ *
+ * @return See json_writer_string()
+ */
+esp_err_t json_writer_null(json_writer_t *writer);
+
+/**
+ * @brief Write a value which is already valid JSON, e.g. a cached fragment
+ *
+ * The value is not checked.
+ *
+ * @param writer Writer
+ * @param json Value
+ * @param len Length of json
+ *
+ * @return See json_writer_string()
+ */
+esp_err_t json_writer_raw(json_writer_t *writer, const char *json, size_t len);
+
+/**
+ * @brief Complete the document
+ *
+ * Without a flush function, NUL terminates the document in the buffer. With a
+ * flush function, flushes the rest of the buffer. The flush function is not
+ * called with a length of 0, so a chunked HTTP response still needs to be ended
+ * with httpd_resp_send_chunk(req, NULL, 0).
+ *
+ * @param writer Writer
+ *
+ * @return
+ *      - ESP_OK Success
+ *      - ESP_ERR_INVALID_STATE The document is empty, or an object or array is open
+ *      - Errors of the other writer functions
+ */
+esp_err_t json_writer_finish(json_writer_t *writer);
+
+/**
+ * @brief Number of bytes written so far, flushed or not, without the NUL terminator
+ *
+ * @param writer Writer
+ *
+ * @return Length of the output
+ */
+size_t json_writer_length(const json_writer_t *writer);
+
+#ifdef __cplusplus
+}
+#endif
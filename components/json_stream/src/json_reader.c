@@ -0,0 +1,454 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+#include <stdbool.h>
+#include "json_reader.h"
+
+/* What the reader expects outside of a token */
+enum {
+    ST_VALUE,           // top level value, value after ':' or after ',' in an array
+    ST_VALUE_OR_END,    // first value of an array or ']'
+    ST_KEY_OR_END,      // first key of an object or '}'
+    ST_KEY,             // key after ',' in an object
+    ST_COLON,
+    ST_COMMA_OR_END,
+    ST_DONE,            // after the top level value, only whitespace is allowed
+};
+
+/* Token being read, it may span several calls to json_reader_feed() */
+enum {
+    TOK_NONE,
+    TOK_STRING,
+    TOK_ESCAPE,         // after '\' in a string
+    TOK_HEX,            // in the 4 digits of '\u'
+    TOK_NUMBER,
+    TOK_LITERAL,        // true, false or null, r->len is the position in the literal
+};
+
+static const char *const s_literals[] = { "true", "false", "null" };
+static const json_reader_event_t s_literal_events[] = {
+    JSON_READER_TRUE, JSON_READER_FALSE, JSON_READER_NULL
+};
+
+esp_err_t json_reader_init(json_reader_t *r, char *buf, size_t buf_size,
+                           json_reader_cb_t cb, void *ctx)
+{
+    if (r == NULL || buf == NULL || buf_size == 0 || cb == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(r, 0, sizeof(*r));
+    r->cb = cb;
+    r->ctx = ctx;
+    r->buf = buf;
+    r->buf_size = buf_size;
+    r->state = ST_VALUE;
+    r->token = TOK_NONE;
+    return ESP_OK;
+}
+
+static inline bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static inline bool in_object(const json_reader_t *r)
+{
+    int level = r->depth - 1;
+    return (r->stack[level / 32] >> (level % 32)) & 1;
+}
+
+static inline esp_err_t append(json_reader_t *r, char c)
+{
+    /* keep room for the NUL terminator */
+    if (r->len >= r->buf_size - 1) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    r->buf[r->len++] = c;
+    return ESP_OK;
+}
+
+static esp_err_t append_utf8(json_reader_t *r, uint32_t code)
+{
+    char utf8[4];
+    size_t n;
+
+    if (code < 0x80) {
+        utf8[0] = code;
+        n = 1;
+    } else if (code < 0x800) {
+        utf8[0] = 0xC0 | (code >> 6);
+        utf8[1] = 0x80 | (code & 0x3F);
+        n = 2;
+    } else if (code < 0x10000) {
+        utf8[0] = 0xE0 | (code >> 12);
+        utf8[1] = 0x80 | ((code >> 6) & 0x3F);
+        utf8[2] = 0x80 | (code & 0x3F);
+        n = 3;
+    } else {
+        utf8[0] = 0xF0 | (code >> 18);
+        utf8[1] = 0x80 | ((code >> 12) & 0x3F);
+        utf8[2] = 0x80 | ((code >> 6) & 0x3F);
+        utf8[3] = 0x80 | (code & 0x3F);
+        n = 4;
+    }
+    if (r->len + n >= r->buf_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(r->buf + r->len, utf8, n);
+    r->len += n;
+    return ESP_OK;
+}
+
+static inline esp_err_t emit(json_reader_t *r, json_reader_event_t event, const char *value, size_t len)
+{
+    return r->cb(event, value, len, r->depth, r->ctx);
+}
+
+static inline void value_done(json_reader_t *r)
+{
+    r->state = (r->depth == 0) ? ST_DONE : ST_COMMA_OR_END;
+}
+
+static esp_err_t start_container(json_reader_t *r, bool object)
+{
+    if (r->depth == CONFIG_JSON_STREAM_MAX_DEPTH) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    esp_err_t err = emit(r, object ? JSON_READER_OBJECT_START : JSON_READER_ARRAY_START, NULL, 0);
+    if (err != ESP_OK) {
+        return err;
+    }
+    uint32_t bit = 1U << (r->depth % 32);
+    if (object) {
+        r->stack[r->depth / 32] |= bit;
+    } else {
+        r->stack[r->depth / 32] &= ~bit;
+    }
+    r->depth++;
+    r->state = object ? ST_KEY_OR_END : ST_VALUE_OR_END;
+    return ESP_OK;
+}
+
+static esp_err_t end_container(json_reader_t *r, bool object)
+{
+    r->depth--;
+    esp_err_t err = emit(r, object ? JSON_READER_OBJECT_END : JSON_READER_ARRAY_END, NULL, 0);
+    value_done(r);
+    return err;
+}
+
+static esp_err_t end_string(json_reader_t *r)
+{
+    esp_err_t err;
+
+    r->buf[r->len] = '\0';
+    r->token = TOK_NONE;
+    if (r->state == ST_KEY || r->state == ST_KEY_OR_END) {
+        err = emit(r, JSON_READER_KEY, r->buf, r->len);
+        r->state = ST_COLON;
+    } else {
+        err = emit(r, JSON_READER_STRING, r->buf, r->len);
+        value_done(r);
+    }
+    return err;
+}
+
+static size_t skip_digits(const char *s, size_t len, size_t i)
+{
+    while (i < len && is_digit(s[i])) {
+        i++;
+    }
+    return i;
+}
+
+/* -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)? */
+static bool number_valid(const char *s, size_t len)
+{
+    size_t i = 0, j;
+
+    if (s[i] == '-') {
+        i++;
+    }
+    if (i < len && s[i] == '0') {
+        i++;
+    } else {
+        j = skip_digits(s, len, i);
+        if (j == i) {
+            return false;
+        }
+        i = j;
+    }
+    if (i < len && s[i] == '.') {
+        j = skip_digits(s, len, ++i);
+        if (j == i) {
+            return false;
+        }
+        i = j;
+    }
+    if (i < len && (s[i] == 'e' || s[i] == 'E')) {
+        i++;
+        if (i < len && (s[i] == '+' || s[i] == '-')) {
+            i++;
+        }
+        j = skip_digits(s, len, i);
+        if (j == i) {
+            return false;
+        }
+        i = j;
+    }
+    return i == len;
+}
+
+static esp_err_t end_number(json_reader_t *r)
+{
+    r->token = TOK_NONE;
+    if (!number_valid(r->buf, r->len)) {
+        return ESP_FAIL;
+    }
+    r->buf[r->len] = '\0';
+    esp_err_t err = emit(r, JSON_READER_NUMBER, r->buf, r->len);
+    value_done(r);
+    return err;
+}
+
+static esp_err_t start_value(json_reader_t *r, char c)
+{
+    switch (c) {
+    case '{':
+        return start_container(r, true);
+    case '[':
+        return start_container(r, false);
+    case '"':
+        r->token = TOK_STRING;
+        r->len = 0;
+        return ESP_OK;
+    case 't':
+    case 'f':
+    case 'n':
+        r->token = TOK_LITERAL;
+        r->literal = (c == 't') ? 0 : (c == 'f') ? 1 : 2;
+        r->len = 1;
+        return ESP_OK;
+    default:
+        if (c == '-' || is_digit(c)) {
+            r->token = TOK_NUMBER;
+            r->len = 0;
+            return append(r, c);
+        }
+        return ESP_FAIL;
+    }
+}
+
+static esp_err_t read_escape(json_reader_t *r, char c)
+{
+    static const char escapes[] = "\"\"\\\\//b\bf\fn\nr\rt\t";
+
+    if (c == 'u') {
+        r->token = TOK_HEX;
+        r->hex_count = 0;
+        r->code = 0;
+        return ESP_OK;
+    }
+    if (r->high_surrogate != 0) {
+        return ESP_FAIL;
+    }
+    r->token = TOK_STRING;
+    for (int i = 0; i < sizeof(escapes) - 1; i += 2) {
+        if (escapes[i] == c) {
+            return append(r, escapes[i + 1]);
+        }
+    }
+    return ESP_FAIL;
+}
+
+static esp_err_t read_hex(json_reader_t *r, char c)
+{
+    int digit;
+
+    if (is_digit(c)) {
+        digit = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        digit = c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        digit = c - 'A' + 10;
+    } else {
+        return ESP_FAIL;
+    }
+    r->code = (r->code << 4) | digit;
+    if (++r->hex_count < 4) {
+        return ESP_OK;
+    }
+
+    r->token = TOK_STRING;
+    uint16_t code = r->code;
+    if (r->high_surrogate != 0) {
+        if (code < 0xDC00 || code > 0xDFFF) {
+            return ESP_FAIL;
+        }
+        uint32_t pair = 0x10000 + ((uint32_t) (r->high_surrogate - 0xD800) << 10) + (code - 0xDC00);
+        r->high_surrogate = 0;
+        return append_utf8(r, pair);
+    }
+    if (code >= 0xD800 && code <= 0xDBFF) {
+        /* the low surrogate must follow as '\uXXXX' */
+        r->high_surrogate = code;
+        return ESP_OK;
+    }
+    if (code >= 0xDC00 && code <= 0xDFFF) {
+        return ESP_FAIL;
+    }
+    return append_utf8(r, code);
+}
+
+static esp_err_t read_literal(json_reader_t *r, char c)
+{
+    const char *literal = s_literals[r->literal];
+
+    if (c != literal[r->len]) {
+        return ESP_FAIL;
+    }
+    if (literal[++r->len] != '\0') {
+        return ESP_OK;
+    }
+    r->token = TOK_NONE;
+    esp_err_t err = emit(r, s_literal_events[r->literal], NULL, 0);
+    value_done(r);
+    return err;
+}
+
+static esp_err_t read_structure(json_reader_t *r, char c)
+{
+    if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+        return ESP_OK;
+    }
+    switch (r->state) {
+    case ST_VALUE_OR_END:
+        if (c == ']') {
+            return end_container(r, false);
+        }
+        return start_value(r, c);
+    case ST_VALUE:
+        return start_value(r, c);
+    case ST_KEY_OR_END:
+        if (c == '}') {
+            return end_container(r, true);
+        }
+    /* fall through */
+    case ST_KEY:
+        if (c != '"') {
+            return ESP_FAIL;
+        }
+        r->token = TOK_STRING;
+        r->len = 0;
+        return ESP_OK;
+    case ST_COLON:
+        if (c != ':') {
+            return ESP_FAIL;
+        }
+        r->state = ST_VALUE;
+        return ESP_OK;
+    case ST_COMMA_OR_END:
+        if (c == ',') {
+            r->state = in_object(r) ? ST_KEY : ST_VALUE;
+            return ESP_OK;
+        }
+        if (c == '}' && in_object(r)) {
+            return end_container(r, true);
+        }
+        if (c == ']' && !in_object(r)) {
+            return end_container(r, false);
+        }
+        return ESP_FAIL;
+    default:
+        return ESP_FAIL;
+    }
+}
+
+esp_err_t json_reader_feed(json_reader_t *r, const char *data, size_t len)
+{
+    esp_err_t err = r->err;
+
+    for (size_t i = 0; i < len && err == ESP_OK; i++) {
+        char c = data[i];
+
+        switch (r->token) {
+        case TOK_STRING:
+            if (r->high_surrogate == 0) {
+                /* copy plain characters in one go, strings are most of a document */
+                size_t run = i;
+                while (run < len && data[run] != '"' && data[run] != '\\' && (uint8_t) data[run] >= 0x20) {
+                    run++;
+                }
+                if (run != i) {
+                    if (r->len + (run - i) >= r->buf_size) {
+                        err = ESP_ERR_INVALID_SIZE;
+                        break;
+                    }
+                    memcpy(r->buf + r->len, data + i, run - i);
+                    r->len += run - i;
+                    i = run - 1;
+                    continue;
+                }
+            }
+            if (c == '\\') {
+                r->token = TOK_ESCAPE;
+            } else if (c == '"' && r->high_surrogate == 0) {
+                err = end_string(r);
+            } else {
+                /* control character, or a high surrogate without its low surrogate */
+                err = ESP_FAIL;
+            }
+            break;
+        case TOK_ESCAPE:
+            err = read_escape(r, c);
+            break;
+        case TOK_HEX:
+            err = read_hex(r, c);
+            break;
+        case TOK_LITERAL:
+            err = read_literal(r, c);
+            break;
+        case TOK_NUMBER:
+            if (is_digit(c) || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+                err = append(r, c);
+                break;
+            }
+            err = end_number(r);
+            if (err == ESP_OK) {
+                err = read_structure(r, c);
+            }
+            break;
+        default:
+            err = read_structure(r, c);
+            break;
+        }
+    }
+    r->err = err;
+    return err;
+}
+
+esp_err_t json_reader_finish(json_reader_t *r)
+{
+    if (r->err == ESP_OK && r->token == TOK_NUMBER) {
+        r->err = end_number(r);
+    }
+    if (r->err != ESP_OK) {
+        return r->err;
+    }
+    if (r->token != TOK_NONE || r->state != ST_DONE) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return ESP_OK;
+}
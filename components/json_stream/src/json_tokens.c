@@ -0,0 +1,258 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "json_tokens.h"
+#include "json_reader.h"
+
+/* Longest number accepted by the number getters, longer ones are not useful as doubles */
+#define NUMBER_MAX_LEN 40
+
+esp_err_t json_tokens_parse(json_tokens_t *doc, const char *js, size_t len,
+                            jsmntok_t *tokens, unsigned int num_tokens)
+{
+    jsmn_parser parser;
+
+    jsmn_init(&parser);
+    int count = jsmn_parse(&parser, js, len, tokens, num_tokens);
+    switch (count) {
+    case JSMN_ERROR_NOMEM:
+        return ESP_ERR_NO_MEM;
+    case JSMN_ERROR_PART:
+        return ESP_ERR_INVALID_STATE;
+    case 0:
+        return ESP_ERR_INVALID_STATE;
+    default:
+        if (count < 0) {
+            return ESP_FAIL;
+        }
+        break;
+    }
+    doc->js = js;
+    doc->tokens = tokens;
+    doc->count = count;
+    return ESP_OK;
+}
+
+static inline const jsmntok_t *token(const json_tokens_t *doc, int index)
+{
+    return (index >= 0 && index < doc->count) ? &doc->tokens[index] : NULL;
+}
+
+int json_tokens_skip(const json_tokens_t *doc, int index)
+{
+    const jsmntok_t *t = token(doc, index);
+    if (t == NULL) {
+        return -1;
+    }
+    /* tokens are in document order, the children of a token start before its end */
+    int next = index + 1;
+    while (next < doc->count && doc->tokens[next].start < t->end) {
+        next++;
+    }
+    return next;
+}
+
+int json_tokens_get_object_item(const json_tokens_t *doc, int object, const char *key)
+{
+    const jsmntok_t *t = token(doc, object);
+    if (t == NULL || t->type != JSMN_OBJECT) {
+        return -1;
+    }
+    size_t key_len = strlen(key);
+    int index = object + 1;
+    for (int i = 0; i < t->size && index + 1 < doc->count; i++) {
+        const jsmntok_t *k = &doc->tokens[index];
+        if (k->type == JSMN_STRING && k->end - k->start == key_len
+                && memcmp(doc->js + k->start, key, key_len) == 0) {
+            return index + 1;
+        }
+        index = json_tokens_skip(doc, index + 1);
+    }
+    return -1;
+}
+
+int json_tokens_get_array_size(const json_tokens_t *doc, int index)
+{
+    const jsmntok_t *t = token(doc, index);
+    if (t == NULL || (t->type != JSMN_ARRAY && t->type != JSMN_OBJECT)) {
+        return 0;
+    }
+    return t->size;
+}
+
+int json_tokens_get_array_item(const json_tokens_t *doc, int array, int item)
+{
+    const jsmntok_t *t = token(doc, array);
+    if (t == NULL || t->type != JSMN_ARRAY || item < 0 || item >= t->size) {
+        return -1;
+    }
+    int index = array + 1;
+    for (int i = 0; i < item && index >= 0; i++) {
+        index = json_tokens_skip(doc, index);
+    }
+    return (index < doc->count) ? index : -1;
+}
+
+static bool is_type(const json_tokens_t *doc, int index, jsmntype_t type)
+{
+    const jsmntok_t *t = token(doc, index);
+    return t != NULL && t->type == type;
+}
+
+/* First character of a primitive, 0 if the token is not a primitive */
+static char primitive(const json_tokens_t *doc, int index)
+{
+    const jsmntok_t *t = token(doc, index);
+    if (t == NULL || t->type != JSMN_PRIMITIVE || t->end <= t->start) {
+        return 0;
+    }
+    return doc->js[t->start];
+}
+
+static bool primitive_is(const json_tokens_t *doc, int index, const char *literal)
+{
+    const jsmntok_t *t = token(doc, index);
+    return primitive(doc, index) != 0 && t->end - t->start == strlen(literal)
+           && memcmp(doc->js + t->start, literal, t->end - t->start) == 0;
+}
+
+bool json_tokens_is_object(const json_tokens_t *doc, int index)
+{
+    return is_type(doc, index, JSMN_OBJECT);
+}
+
+bool json_tokens_is_array(const json_tokens_t *doc, int index)
+{
+    return is_type(doc, index, JSMN_ARRAY);
+}
+
+bool json_tokens_is_string(const json_tokens_t *doc, int index)
+{
+    return is_type(doc, index, JSMN_STRING);
+}
+
+bool json_tokens_is_number(const json_tokens_t *doc, int index)
+{
+    char c = primitive(doc, index);
+    return c == '-' || (c >= '0' && c <= '9');
+}
+
+bool json_tokens_is_bool(const json_tokens_t *doc, int index)
+{
+    return primitive_is(doc, index, "true") || primitive_is(doc, index, "false");
+}
+
+bool json_tokens_is_null(const json_tokens_t *doc, int index)
+{
+    return primitive_is(doc, index, "null");
+}
+
+static esp_err_t ignore_event(json_reader_event_t event, const char *value, size_t len, int depth, void *ctx)
+{
+    return ESP_OK;
+}
+
+esp_err_t json_tokens_get_string(const json_tokens_t *doc, int index, char *buf, size_t size)
+{
+    const jsmntok_t *t = token(doc, index);
+    json_reader_t reader;
+
+    if (t == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (t->type != JSMN_STRING) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    /* the reader decodes the string with its quotes straight into buf */
+    esp_err_t err = json_reader_init(&reader, buf, size, ignore_event, NULL);
+    if (err == ESP_OK) {
+        err = json_reader_feed(&reader, doc->js + t->start - 1, t->end - t->start + 2);
+    }
+    if (err == ESP_OK) {
+        err = json_reader_finish(&reader);
+    }
+    return (err == ESP_OK || err == ESP_ERR_INVALID_SIZE) ? err : ESP_ERR_INVALID_ARG;
+}
+
+/* Copy a number token to a NUL terminated buffer, strtod() and strtoll() need one */
+static esp_err_t copy_number(const json_tokens_t *doc, int index, char *number)
+{
+    const jsmntok_t *t = token(doc, index);
+
+    if (t == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (!json_tokens_is_number(doc, index) || t->end - t->start >= NUMBER_MAX_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(number, doc->js + t->start, t->end - t->start);
+    number[t->end - t->start] = '\0';
+    return ESP_OK;
+}
+
+esp_err_t json_tokens_get_double(const json_tokens_t *doc, int index, double *value)
+{
+    char number[NUMBER_MAX_LEN];
+    char *end;
+
+    esp_err_t err = copy_number(doc, index, number);
+    if (err != ESP_OK) {
+        return err;
+    }
+    double d = strtod(number, &end);
+    if (*end != '\0') {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *value = d;
+    return ESP_OK;
+}
+
+esp_err_t json_tokens_get_int(const json_tokens_t *doc, int index, int64_t *value)
+{
+    char number[NUMBER_MAX_LEN];
+    char *end;
+
+    esp_err_t err = copy_number(doc, index, number);
+    if (err != ESP_OK) {
+        return err;
+    }
+    errno = 0;
+    long long i = strtoll(number, &end, 10);
+    if (*end != '\0') {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (errno == ERANGE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *value = i;
+    return ESP_OK;
+}
+
+esp_err_t json_tokens_get_bool(const json_tokens_t *doc, int index, bool *value)
+{
+    if (token(doc, index) == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (primitive_is(doc, index, "true")) {
+        *value = true;
+    } else if (primitive_is(doc, index, "false")) {
+        *value = false;
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
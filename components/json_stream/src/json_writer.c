@@ -0,0 +1,325 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "json_writer.h"
+
+esp_err_t json_writer_init(json_writer_t *w, char *buf, size_t buf_size,
+                           json_writer_flush_t flush, void *ctx)
+{
+    if (w == NULL || buf == NULL || buf_size < 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(w, 0, sizeof(*w));
+    w->flush = flush;
+    w->ctx = ctx;
+    w->buf = buf;
+    w->buf_size = buf_size;
+    return ESP_OK;
+}
+
+static inline bool in_object(const json_writer_t *w)
+{
+    int level = w->depth - 1;
+    return (w->stack[level / 32] >> (level % 32)) & 1;
+}
+
+static esp_err_t put(json_writer_t *w, const char *data, size_t len)
+{
+    /* without a flush function, keep room for the NUL terminator */
+    size_t cap = w->flush ? w->buf_size : w->buf_size - 1;
+
+    while (len > 0) {
+        if (w->len == cap) {
+            if (w->flush == NULL) {
+                return ESP_ERR_NO_MEM;
+            }
+            esp_err_t err = w->flush(w->buf, w->len, w->ctx);
+            if (err != ESP_OK) {
+                return err;
+            }
+            w->flushed += w->len;
+            w->len = 0;
+        }
+        size_t n = cap - w->len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(w->buf + w->len, data, n);
+        w->len += n;
+        data += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+static inline esp_err_t put_char(json_writer_t *w, char c)
+{
+    size_t cap = w->flush ? w->buf_size : w->buf_size - 1;
+
+    if (w->len < cap) {
+        w->buf[w->len++] = c;
+        return ESP_OK;
+    }
+    return put(w, &c, 1);
+}
+
+static esp_err_t put_escaped(json_writer_t *w, const char *str, size_t len)
+{
+    static const char hex[] = "0123456789abcdef";
+    esp_err_t err = put_char(w, '"');
+    size_t run = 0;
+
+    for (size_t i = 0; i < len && err == ESP_OK; i++) {
+        uint8_t c = str[i];
+        char esc[6] = { '\\', 0 };
+        size_t esc_len = 2;
+
+        switch (c) {
+        case '"':  esc[1] = '"'; break;
+        case '\\': esc[1] = '\\'; break;
+        case '\b': esc[1] = 'b'; break;
+        case '\f': esc[1] = 'f'; break;
+        case '\n': esc[1] = 'n'; break;
+        case '\r': esc[1] = 'r'; break;
+        case '\t': esc[1] = 't'; break;
+        default:
+            if (c >= 0x20) {
+                run++;
+                continue;
+            }
+            memcpy(esc + 1, "u00", 3);
+            esc[4] = hex[c >> 4];
+            esc[5] = hex[c & 0xF];
+            esc_len = 6;
+            break;
+        }
+        err = put(w, str + i - run, run);
+        run = 0;
+        if (err == ESP_OK) {
+            err = put(w, esc, esc_len);
+        }
+    }
+    if (err == ESP_OK) {
+        err = put(w, str + len - run, run);
+    }
+    if (err == ESP_OK) {
+        err = put_char(w, '"');
+    }
+    return err;
+}
+
+/* Check that a value may be written here, and write the comma before it */
+static esp_err_t begin_value(json_writer_t *w)
+{
+    if (w->err != ESP_OK) {
+        return w->err;
+    }
+    if (w->depth == 0) {
+        if (w->need_comma) {
+            return ESP_ERR_INVALID_STATE;
+        }
+    } else if (in_object(w)) {
+        if (!w->after_key) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        w->after_key = false;
+    } else if (w->need_comma) {
+        esp_err_t err = put_char(w, ',');
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    w->need_comma = true;
+    return ESP_OK;
+}
+
+static inline esp_err_t done(json_writer_t *w, esp_err_t err)
+{
+    w->err = err;
+    return err;
+}
+
+static esp_err_t container_start(json_writer_t *w, bool object)
+{
+    esp_err_t err = begin_value(w);
+    if (err != ESP_OK) {
+        return done(w, err);
+    }
+    if (w->depth == CONFIG_JSON_STREAM_MAX_DEPTH) {
+        return done(w, ESP_ERR_INVALID_SIZE);
+    }
+    uint32_t bit = 1U << (w->depth % 32);
+    if (object) {
+        w->stack[w->depth / 32] |= bit;
+    } else {
+        w->stack[w->depth / 32] &= ~bit;
+    }
+    w->depth++;
+    w->need_comma = false;
+    return done(w, put_char(w, object ? '{' : '['));
+}
+
+static esp_err_t container_end(json_writer_t *w, bool object)
+{
+    if (w->err != ESP_OK) {
+        return w->err;
+    }
+    if (w->depth == 0 || in_object(w) != object || w->after_key) {
+        return done(w, ESP_ERR_INVALID_STATE);
+    }
+    w->depth--;
+    w->need_comma = true;
+    return done(w, put_char(w, object ? '}' : ']'));
+}
+
+esp_err_t json_writer_object_start(json_writer_t *w)
+{
+    return container_start(w, true);
+}
+
+esp_err_t json_writer_object_end(json_writer_t *w)
+{
+    return container_end(w, true);
+}
+
+esp_err_t json_writer_array_start(json_writer_t *w)
+{
+    return container_start(w, false);
+}
+
+esp_err_t json_writer_array_end(json_writer_t *w)
+{
+    return container_end(w, false);
+}
+
+esp_err_t json_writer_key(json_writer_t *w, const char *key)
+{
+    esp_err_t err = w->err;
+
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (w->depth == 0 || !in_object(w) || w->after_key) {
+        return done(w, ESP_ERR_INVALID_STATE);
+    }
+    if (w->need_comma) {
+        err = put_char(w, ',');
+    }
+    if (err == ESP_OK) {
+        err = put_escaped(w, key, strlen(key));
+    }
+    if (err == ESP_OK) {
+        err = put_char(w, ':');
+    }
+    w->after_key = true;
+    w->need_comma = true;
+    return done(w, err);
+}
+
+esp_err_t json_writer_string_len(json_writer_t *w, const char *str, size_t len)
+{
+    esp_err_t err = begin_value(w);
+    if (err == ESP_OK) {
+        err = put_escaped(w, str, len);
+    }
+    return done(w, err);
+}
+
+esp_err_t json_writer_string(json_writer_t *w, const char *str)
+{
+    return json_writer_string_len(w, str, strlen(str));
+}
+
+esp_err_t json_writer_raw(json_writer_t *w, const char *json, size_t len)
+{
+    esp_err_t err = begin_value(w);
+    if (err == ESP_OK) {
+        err = put(w, json, len);
+    }
+    return done(w, err);
+}
+
+esp_err_t json_writer_int(json_writer_t *w, int64_t value)
+{
+    char digits[20];
+    size_t i = sizeof(digits);
+    /* negate as unsigned, INT64_MIN has no positive counterpart */
+    uint64_t u = (value < 0) ? 0 - (uint64_t) value : (uint64_t) value;
+
+    do {
+        digits[--i] = '0' + u % 10;
+        u /= 10;
+    } while (u != 0);
+    if (value < 0) {
+        digits[--i] = '-';
+    }
+    return json_writer_raw(w, digits + i, sizeof(digits) - i);
+}
+
+esp_err_t json_writer_double(json_writer_t *w, double value)
+{
+    char number[32];
+    int len;
+
+    if (!isfinite(value)) {
+        return json_writer_null(w);
+    }
+    /* same format as cJSON_Print() */
+    len = snprintf(number, sizeof(number), "%1.15g", value);
+    if (strtod(number, NULL) != value) {
+        len = snprintf(number, sizeof(number), "%1.17g", value);
+    }
+    return json_writer_raw(w, number, len);
+}
+
+esp_err_t json_writer_bool(json_writer_t *w, bool value)
+{
+    return value ? json_writer_raw(w, "true", 4) : json_writer_raw(w, "false", 5);
+}
+
+esp_err_t json_writer_null(json_writer_t *w)
+{
+    return json_writer_raw(w, "null", 4);
+}
+
+esp_err_t json_writer_finish(json_writer_t *w)
+{
+    esp_err_t err = w->err;
+
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (w->depth != 0 || !w->need_comma) {
+        return done(w, ESP_ERR_INVALID_STATE);
+    }
+    if (w->flush == NULL) {
+        w->buf[w->len] = '\0';
+    } else if (w->len > 0) {
+        err = w->flush(w->buf, w->len, w->ctx);
+        if (err == ESP_OK) {
+            w->flushed += w->len;
+            w->len = 0;
+        }
+    }
+    return done(w, err);
+}
+
+size_t json_writer_length(const json_writer_t *w)
+{
+    return w->flushed + w->len;
+}
@@ -0,0 +1,343 @@
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "test_utils.h"
+#include "esp_timer.h"
+#include "json_reader.h"
+#include "json_writer.h"
+#include "json_tokens.h"
+
+typedef struct {
+    char events[512];
+    size_t len;
+} event_log_t;
+
+/* Logs events as e.g. "{ K(a) S(b) N(1) [ T F Z ] }" */
+static esp_err_t log_event(json_reader_event_t event, const char *value, size_t len, int depth, void *ctx)
+{
+    static const char *const names[] = { "{", "}", "[", "]", "K", "S", "N", "T", "F", "Z" };
+    event_log_t *log = (event_log_t *) ctx;
+
+    if (value != NULL && strlen(value) != len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (value != NULL) {
+        log->len += snprintf(log->events + log->len, sizeof(log->events) - log->len,
+                             "%s(%s)%d ", names[event], value, depth);
+    } else {
+        log->len += snprintf(log->events + log->len, sizeof(log->events) - log->len,
+                             "%s%d ", names[event], depth);
+    }
+    return ESP_OK;
+}
+
+/* Reads a document in chunks of chunk bytes */
+static esp_err_t read_doc(const char *doc, size_t chunk, char *buf, size_t buf_size, event_log_t *log)
+{
+    json_reader_t reader;
+    size_t len = strlen(doc);
+
+    memset(log, 0, sizeof(*log));
+    TEST_ESP_OK(json_reader_init(&reader, buf, buf_size, log_event, log));
+    for (size_t i = 0; i < len; i += chunk) {
+        esp_err_t err = json_reader_feed(&reader, doc + i, (len - i < chunk) ? len - i : chunk);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return json_reader_finish(&reader);
+}
+
+TEST_CASE("json_reader reports events in any chunk size", "[json_stream]")
+{
+    const char *doc = " {\"a\": \"b\", \"list\" : [1, -2.5e+3, true, false, null, {}, []],\n"
+                      "\"esc\": \"q\\\"\\\\\\/\\b\\f\\n\\r\\t\\u00e9\\u20ac\\ud83d\\ude00\", \"\": 0} ";
+    const char *expected = "{0 K(a)1 S(b)1 K(list)1 [1 N(1)2 N(-2.5e+3)2 T2 F2 Z2 {2 }2 [2 ]2 ]1 "
+                           "K(esc)1 S(q\"\\/\b\f\n\r\t\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80)1 K()1 N(0)1 }0 ";
+    char buf[32];
+    event_log_t log;
+
+    for (size_t chunk = 1; chunk <= strlen(doc); chunk++) {
+        TEST_ESP_OK(read_doc(doc, chunk, buf, sizeof(buf), &log));
+        TEST_ASSERT_EQUAL_STRING(expected, log.events);
+    }
+
+    TEST_ESP_OK(read_doc("42", 1, buf, sizeof(buf), &log));
+    TEST_ASSERT_EQUAL_STRING("N(42)0 ", log.events);
+    TEST_ESP_OK(read_doc("\"x\"", 1, buf, sizeof(buf), &log));
+    TEST_ASSERT_EQUAL_STRING("S(x)0 ", log.events);
+}
+
+TEST_CASE("json_reader rejects invalid documents", "[json_stream]")
+{
+    const char *invalid[] = {
+        "{,}", "[1,]", "{\"a\":1,}", "{\"a\" 1}", "{1:2}", "[1 2]", "[}", "{]", "]",
+        "01", "1.", "-", "1e", ".5", "+1", "nul ", "[True]", "\"\\x\"", "\"\\u12G4\"",
+        "\"\\ud83d\"", "\"\\ud83dx\"", "\"\\ude00\"", "\"a\nb\"", "{} {}", "1 2",
+    };
+    const char *incomplete[] = { "", " ", "{", "[1,", "{\"a\":", "\"abc", "tr" };
+    char buf[32];
+    event_log_t log;
+
+    for (int i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        TEST_ASSERT_EQUAL_MESSAGE(ESP_FAIL, read_doc(invalid[i], 1, buf, sizeof(buf), &log), invalid[i]);
+    }
+    for (int i = 0; i < sizeof(incomplete) / sizeof(incomplete[0]); i++) {
+        TEST_ASSERT_EQUAL_MESSAGE(ESP_ERR_INVALID_STATE, read_doc(incomplete[i], 1, buf, sizeof(buf), &log), incomplete[i]);
+    }
+
+    /* a string of 7 bytes and its NUL terminator fit in 8 bytes */
+    TEST_ESP_OK(read_doc("[\"1234567\"]", 3, buf, 8, &log));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, read_doc("[\"12345678\"]", 3, buf, 8, &log));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, read_doc("123456789", 3, buf, 8, &log));
+
+    char deep[2 * CONFIG_JSON_STREAM_MAX_DEPTH + 3] = { 0 };
+    memset(deep, '[', CONFIG_JSON_STREAM_MAX_DEPTH);
+    memset(deep + CONFIG_JSON_STREAM_MAX_DEPTH, ']', CONFIG_JSON_STREAM_MAX_DEPTH);
+    TEST_ESP_OK(read_doc(deep, 16, buf, sizeof(buf), &log));
+    memset(deep, '[', CONFIG_JSON_STREAM_MAX_DEPTH + 1);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, read_doc(deep, 16, buf, sizeof(buf), &log));
+}
+
+typedef struct {
+    char out[256];
+    size_t len;
+    int calls;
+} flush_log_t;
+
+static esp_err_t flush_to_log(const char *data, size_t len, void *ctx)
+{
+    flush_log_t *log = (flush_log_t *) ctx;
+    if (len == 0 || log->len + len >= sizeof(log->out)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(log->out + log->len, data, len);
+    log->len += len;
+    log->out[log->len] = '\0';
+    log->calls++;
+    return ESP_OK;
+}
+
+static esp_err_t write_doc(json_writer_t *w)
+{
+    json_writer_object_start(w);
+    json_writer_key(w, "name");
+    json_writer_string(w, "q\"\\\n\x01\xc3\xa9");
+    json_writer_key(w, "values");
+    json_writer_array_start(w);
+    json_writer_int(w, 0);
+    json_writer_int(w, -42);
+    json_writer_int(w, INT64_MIN);
+    json_writer_double(w, 0.1);
+    json_writer_double(w, 1.0 / 3);
+    json_writer_double(w, 1e300 * 1e300);
+    json_writer_bool(w, true);
+    json_writer_bool(w, false);
+    json_writer_null(w);
+    json_writer_object_start(w);
+    json_writer_object_end(w);
+    json_writer_array_start(w);
+    json_writer_array_end(w);
+    json_writer_array_end(w);
+    json_writer_key(w, "raw");
+    json_writer_raw(w, "[1,2]", 5);
+    json_writer_object_end(w);
+    return json_writer_finish(w);
+}
+
+TEST_CASE("json_writer writes to a buffer or flushes it", "[json_stream]")
+{
+    const char *expected = "{\"name\":\"q\\\"\\\\\\n\\u0001\xc3\xa9\",\"values\":[0,-42,-9223372036854775808,"
+                           "0.1,0.33333333333333331,null,true,false,null,{},[]],\"raw\":[1,2]}";
+    char buf[256];
+    json_writer_t w;
+
+    TEST_ESP_OK(json_writer_init(&w, buf, sizeof(buf), NULL, NULL));
+    TEST_ESP_OK(write_doc(&w));
+    TEST_ASSERT_EQUAL_STRING(expected, buf);
+    TEST_ASSERT_EQUAL(strlen(expected), json_writer_length(&w));
+
+    /* exactly the size of the document and its NUL terminator, then one byte less */
+    TEST_ESP_OK(json_writer_init(&w, buf, strlen(expected) + 1, NULL, NULL));
+    TEST_ESP_OK(write_doc(&w));
+    TEST_ASSERT_EQUAL_STRING(expected, buf);
+    TEST_ESP_OK(json_writer_init(&w, buf, strlen(expected), NULL, NULL));
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, write_doc(&w));
+
+    for (size_t size = 2; size < 40; size++) {
+        flush_log_t log = { 0 };
+        TEST_ESP_OK(json_writer_init(&w, buf, size, flush_to_log, &log));
+        TEST_ESP_OK(write_doc(&w));
+        TEST_ASSERT_EQUAL_STRING(expected, log.out);
+        TEST_ASSERT_EQUAL((strlen(expected) + size - 1) / size, log.calls);
+        TEST_ASSERT_EQUAL(strlen(expected), json_writer_length(&w));
+    }
+}
+
+TEST_CASE("json_writer checks the order of keys and values", "[json_stream]")
+{
+    char buf[64];
+    json_writer_t w;
+
+    TEST_ESP_OK(json_writer_init(&w, buf, sizeof(buf), NULL, NULL));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, json_writer_key(&w, "a"));
+    /* errors are sticky */
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, json_writer_int(&w, 1));
+
+    TEST_ESP_OK(json_writer_init(&w, buf, sizeof(buf), NULL, NULL));
+    TEST_ESP_OK(json_writer_object_start(&w));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, json_writer_int(&w, 1));
+
+    TEST_ESP_OK(json_writer_init(&w, buf, sizeof(buf), NULL, NULL));
+    TEST_ESP_OK(json_writer_object_start(&w));
+    TEST_ESP_OK(json_writer_key(&w, "a"));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, json_writer_object_end(&w));
+
+    TEST_ESP_OK(json_writer_init(&w, buf, sizeof(buf), NULL, NULL));
+    TEST_ESP_OK(json_writer_array_start(&w));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, json_writer_key(&w, "a"));
+
+    TEST_ESP_OK(json_writer_init(&w, buf, sizeof(buf), NULL, NULL));
+    TEST_ESP_OK(json_writer_array_start(&w));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, json_writer_object_end(&w));
+
+    TEST_ESP_OK(json_writer_init(&w, buf, sizeof(buf), NULL, NULL));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, json_writer_finish(&w));
+
+    TEST_ESP_OK(json_writer_init(&w, buf, sizeof(buf), NULL, NULL));
+    TEST_ESP_OK(json_writer_array_start(&w));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, json_writer_finish(&w));
+
+    TEST_ESP_OK(json_writer_init(&w, buf, sizeof(buf), NULL, NULL));
+    TEST_ESP_OK(json_writer_int(&w, 1));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, json_writer_int(&w, 2));
+
+    TEST_ESP_OK(json_writer_init(&w, buf, sizeof(buf), NULL, NULL));
+    for (int i = 0; i < CONFIG_JSON_STREAM_MAX_DEPTH; i++) {
+        TEST_ESP_OK(json_writer_array_start(&w));
+    }
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, json_writer_array_start(&w));
+}
+
+TEST_CASE("json_tokens getters", "[json_stream]")
+{
+    const char *js = "{\"id\": 17, \"big\": 12345678901234, \"ratio\": -0.25, \"ok\": true, \"off\": false,"
+                     " \"none\": null, \"name\": \"a\\nb\\u00e9\", \"nested\": {\"list\": [1, [2, 3], {\"x\": 4}, \"s\"]},"
+                     " \"last\": 5}";
+    jsmntok_t tokens[32];
+    json_tokens_t doc;
+    char str[8];
+    int64_t i;
+    double d;
+    bool b;
+
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, json_tokens_parse(&doc, js, strlen(js), tokens, 4));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, json_tokens_parse(&doc, js, 20, tokens, 32));
+    TEST_ESP_OK(json_tokens_parse(&doc, js, strlen(js), tokens, 32));
+    TEST_ASSERT_TRUE(json_tokens_is_object(&doc, 0));
+    TEST_ASSERT_EQUAL(9, json_tokens_get_array_size(&doc, 0));
+    TEST_ASSERT_EQUAL(doc.count, json_tokens_skip(&doc, 0));
+
+    TEST_ESP_OK(json_tokens_get_int(&doc, json_tokens_get_object_item(&doc, 0, "id"), &i));
+    TEST_ASSERT_EQUAL(17, i);
+    TEST_ESP_OK(json_tokens_get_int(&doc, json_tokens_get_object_item(&doc, 0, "big"), &i));
+    TEST_ASSERT_TRUE(i == 12345678901234LL);
+    TEST_ESP_OK(json_tokens_get_double(&doc, json_tokens_get_object_item(&doc, 0, "ratio"), &d));
+    TEST_ASSERT_TRUE(d == -0.25);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, json_tokens_get_int(&doc, json_tokens_get_object_item(&doc, 0, "ratio"), &i));
+    TEST_ESP_OK(json_tokens_get_bool(&doc, json_tokens_get_object_item(&doc, 0, "ok"), &b));
+    TEST_ASSERT_TRUE(b);
+    TEST_ESP_OK(json_tokens_get_bool(&doc, json_tokens_get_object_item(&doc, 0, "off"), &b));
+    TEST_ASSERT_FALSE(b);
+    TEST_ASSERT_TRUE(json_tokens_is_null(&doc, json_tokens_get_object_item(&doc, 0, "none")));
+    TEST_ASSERT_FALSE(json_tokens_is_bool(&doc, json_tokens_get_object_item(&doc, 0, "none")));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, json_tokens_get_bool(&doc, json_tokens_get_object_item(&doc, 0, "none"), &b));
+
+    int name = json_tokens_get_object_item(&doc, 0, "name");
+    TEST_ASSERT_TRUE(json_tokens_is_string(&doc, name));
+    TEST_ESP_OK(json_tokens_get_string(&doc, name, str, sizeof(str)));
+    TEST_ASSERT_EQUAL_STRING("a\nb\xc3\xa9", str);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, json_tokens_get_string(&doc, name, str, 5));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, json_tokens_get_string(&doc, 0, str, sizeof(str)));
+
+    /* chained lookups, like cJSON getters accepting NULL */
+    int list = json_tokens_get_object_item(&doc, json_tokens_get_object_item(&doc, 0, "nested"), "list");
+    TEST_ASSERT_TRUE(json_tokens_is_array(&doc, list));
+    TEST_ASSERT_EQUAL(4, json_tokens_get_array_size(&doc, list));
+    TEST_ESP_OK(json_tokens_get_int(&doc, json_tokens_get_array_item(&doc, json_tokens_get_array_item(&doc, list, 1), 1), &i));
+    TEST_ASSERT_EQUAL(3, i);
+    TEST_ESP_OK(json_tokens_get_int(&doc, json_tokens_get_object_item(&doc, json_tokens_get_array_item(&doc, list, 2), "x"), &i));
+    TEST_ASSERT_EQUAL(4, i);
+    TEST_ESP_OK(json_tokens_get_string(&doc, json_tokens_get_array_item(&doc, list, 3), str, sizeof(str)));
+    TEST_ASSERT_EQUAL_STRING("s", str);
+    TEST_ASSERT_EQUAL(-1, json_tokens_get_array_item(&doc, list, 4));
+    TEST_ESP_OK(json_tokens_get_int(&doc, json_tokens_get_object_item(&doc, 0, "last"), &i));
+    TEST_ASSERT_EQUAL(5, i);
+
+    TEST_ASSERT_EQUAL(-1, json_tokens_get_object_item(&doc, 0, "missing"));
+    TEST_ASSERT_EQUAL(-1, json_tokens_get_object_item(&doc, -1, "id"));
+    TEST_ASSERT_EQUAL(-1, json_tokens_get_object_item(&doc, list, "id"));
+    TEST_ASSERT_EQUAL(0, json_tokens_get_array_size(&doc, -1));
+    TEST_ASSERT_FALSE(json_tokens_is_number(&doc, -1));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, json_tokens_get_int(&doc, -1, &i));
+}
+
+static esp_err_t write_to_buf(const char *data, size_t len, void *ctx)
+{
+    return ESP_OK;
+}
+
+static esp_err_t count_event(json_reader_event_t event, const char *value, size_t len, int depth, void *ctx)
+{
+    (*(int *) ctx)++;
+    return ESP_OK;
+}
+
+TEST_CASE("json_stream write and read a 20 KB document", "[json_stream][perf]")
+{
+    const int records = 280;
+    static char doc[24 * 1024];
+    char buf[64];
+    json_writer_t w;
+    json_reader_t r;
+    int events = 0;
+
+    int64_t start = esp_timer_get_time();
+    TEST_ESP_OK(json_writer_init(&w, doc, sizeof(doc), NULL, NULL));
+    json_writer_array_start(&w);
+    for (int i = 0; i < records; i++) {
+        json_writer_object_start(&w);
+        json_writer_key(&w, "id");
+        json_writer_int(&w, i);
+        json_writer_key(&w, "name");
+        json_writer_string(&w, "sensor \"outdoor\" north");
+        json_writer_key(&w, "value");
+        json_writer_double(&w, i * 0.5);
+        json_writer_key(&w, "enabled");
+        json_writer_bool(&w, i % 2);
+        json_writer_object_end(&w);
+    }
+    json_writer_array_end(&w);
+    TEST_ESP_OK(json_writer_finish(&w));
+    int64_t write_us = esp_timer_get_time() - start;
+    size_t len = json_writer_length(&w);
+    TEST_ASSERT_GREATER_THAN(16 * 1024, len);
+
+    /* the same document, through a small buffer which is flushed */
+    TEST_ESP_OK(json_writer_init(&w, buf, sizeof(buf), write_to_buf, NULL));
+    TEST_ESP_OK(json_writer_raw(&w, doc, len));
+    TEST_ESP_OK(json_writer_finish(&w));
+
+    start = esp_timer_get_time();
+    TEST_ESP_OK(json_reader_init(&r, buf, sizeof(buf), count_event, &events));
+    /* in chunks, as received from a socket */
+    for (size_t i = 0; i < len; i += 1460) {
+        TEST_ESP_OK(json_reader_feed(&r, doc + i, (len - i < 1460) ? len - i : 1460));
+    }
+    TEST_ESP_OK(json_reader_finish(&r));
+    int64_t read_us = esp_timer_get_time() - start;
+    TEST_ASSERT_EQUAL(2 + records * 10, events);
+
+    IDF_LOG_PERFORMANCE("json_writer 20KB", "%d us", (int) write_us);
+    IDF_LOG_PERFORMANCE("json_reader 20KB", "%d us", (int) read_us);
+}
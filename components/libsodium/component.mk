@@ -66,6 +66,18 @@ COMPONENT_SRCDIRS += \
     $(LSRC)/crypto_hash/sha512/cp
 endif
 
+# The ESP32 implementations take the symbol names of the upstream implementations,
+# which are renamed to *_upstream_implementation (see port/upstream_impl.h)
+ifdef CONFIG_LIBSODIUM_CHACHA20_ESP32
+COMPONENT_SRCDIRS += port/crypto_stream_chacha20_esp32
+$(LSRC)/crypto_stream/chacha20/ref/chacha20_ref.o: CFLAGS += -Dcrypto_stream_chacha20_ref_implementation=crypto_stream_chacha20_ref_upstream_implementation
+endif
+
+ifdef CONFIG_LIBSODIUM_CURVE25519_ESP32
+COMPONENT_SRCDIRS += port/crypto_scalarmult_curve25519_esp32
+$(LSRC)/crypto_scalarmult/curve25519/ref10/x25519_ref10.o: CFLAGS += -Dcrypto_scalarmult_curve25519_ref10_implementation=crypto_scalarmult_curve25519_ref10_upstream_implementation
+endif
+
 # Fix some warnings in current libsodium source files
 # (not applied to whole component as we compile some of our own files, also.)
 $(LSRC)/crypto_pwhash/argon2/argon2-fill-block-ref.o: CFLAGS += -Wno-unknown-pragmas
@@ -75,7 +87,7 @@ $(LSRC)/crypto_pwhash/scryptsalsa208sha256/pwhash_scryptsalsa208sha256.o: CFLAGS
 $(LSRC)/sodium/utils.o: CFLAGS += -Wno-unused-variable
 
 COMPONENT_ADD_INCLUDEDIRS := $(LSRC)/include port_include
-COMPONENT_PRIV_INCLUDEDIRS := $(LSRC)/include/sodium port_include/sodium port
+COMPONENT_PRIV_INCLUDEDIRS := $(LSRC)/include/sodium $(LSRC) port_include/sodium port
 
 
 # Not using autoconf, but this needs to be set
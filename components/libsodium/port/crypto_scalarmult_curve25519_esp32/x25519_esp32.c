@@ -0,0 +1,363 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/* X25519 for the ESP32, replacing crypto_scalarmult/curve25519/ref10.
+
+   Field elements have ten unsigned limbs of alternately 26 and 25 bits
+   (radix 2^25.5), so that every partial product is a 32x32->64 bit unsigned
+   multiplication, which is one MULL and one MULUH instruction, and a column
+   of ten products fits a 64-bit accumulator. The field operations are inline
+   in the Montgomery ladder, with dedicated squaring and multiplication by
+   a24, instead of calls into crypto_core/curve25519/ref10.
+
+   Limbs are kept non-negative: a subtraction adds 2p first. The value bounds
+   are noted with each operation. Every multiplication input is a reduced
+   value or the sum or difference of two reduced values, so its limbs are
+   below 3 * 2^26 (even limbs) or 3 * 2^25 (odd limbs) and each column
+   stays below 2^62.2.
+
+   The ladder, conditional swaps and inversion run in constant time. The base
+   point multiplication stays the upstream one, which uses the precomputed
+   Ed25519 tables and is faster than a ladder.
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include "crypto_scalarmult_curve25519.h"
+#include "utils.h"
+#include "upstream_impl.h"
+
+#define MASK26 0x3ffffffu
+#define MASK25 0x1ffffffu
+
+/* Limb i holds bits [26 * ceil(i / 2) + 25 * floor(i / 2)...] of the value */
+typedef uint32_t fe[10];
+
+#define MUL(a, b) ((uint64_t) (a) * (b))
+
+static inline uint32_t load32_le(const uint8_t *p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+/* The top bit of s is ignored, as in the reference */
+static void fe_frombytes(fe h, const uint8_t *s)
+{
+    h[0] = load32_le(s + 0) & MASK26;
+    h[1] = (load32_le(s + 3) >> 2) & MASK25;
+    h[2] = (load32_le(s + 6) >> 3) & MASK26;
+    h[3] = (load32_le(s + 9) >> 5) & MASK25;
+    h[4] = (load32_le(s + 12) >> 6) & MASK26;
+    h[5] = load32_le(s + 16) & MASK25;
+    h[6] = (load32_le(s + 19) >> 1) & MASK26;
+    h[7] = (load32_le(s + 22) >> 3) & MASK25;
+    h[8] = (load32_le(s + 25) >> 4) & MASK26;
+    h[9] = (load32_le(s + 28) >> 6) & MASK25;
+}
+
+static inline void fe_add(fe h, const fe f, const fe g)
+{
+    for (int i = 0; i < 10; i++) {
+        h[i] = f[i] + g[i];
+    }
+}
+
+/* h = f + 2p - g, g reduced */
+static inline void fe_sub(fe h, const fe f, const fe g)
+{
+    h[0] = f[0] + 0x7ffffda - g[0];
+    h[1] = f[1] + 0x3fffffe - g[1];
+    h[2] = f[2] + 0x7fffffe - g[2];
+    h[3] = f[3] + 0x3fffffe - g[3];
+    h[4] = f[4] + 0x7fffffe - g[4];
+    h[5] = f[5] + 0x3fffffe - g[5];
+    h[6] = f[6] + 0x7fffffe - g[6];
+    h[7] = f[7] + 0x3fffffe - g[7];
+    h[8] = f[8] + 0x7fffffe - g[8];
+    h[9] = f[9] + 0x3fffffe - g[9];
+}
+
+/* Reduces the columns to limbs below 2^26 / 2^25, except h[1] which may
+   exceed 2^25 by a small carry */
+static inline void fe_carry(fe out, uint64_t h0, uint64_t h1, uint64_t h2, uint64_t h3, uint64_t h4,
+                            uint64_t h5, uint64_t h6, uint64_t h7, uint64_t h8, uint64_t h9)
+{
+    h1 += h0 >> 26; h0 &= MASK26;
+    h2 += h1 >> 25; h1 &= MASK25;
+    h3 += h2 >> 26; h2 &= MASK26;
+    h4 += h3 >> 25; h3 &= MASK25;
+    h5 += h4 >> 26; h4 &= MASK26;
+    h6 += h5 >> 25; h5 &= MASK25;
+    h7 += h6 >> 26; h6 &= MASK26;
+    h8 += h7 >> 25; h7 &= MASK25;
+    h9 += h8 >> 26; h8 &= MASK26;
+    h0 += (h9 >> 25) * 19; h9 &= MASK25;
+    h1 += h0 >> 26; h0 &= MASK26;
+
+    out[0] = h0;
+    out[1] = h1;
+    out[2] = h2;
+    out[3] = h3;
+    out[4] = h4;
+    out[5] = h5;
+    out[6] = h6;
+    out[7] = h7;
+    out[8] = h8;
+    out[9] = h9;
+}
+
+static inline void fe_mul(fe h, const fe f, const fe g)
+{
+    uint32_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+    uint32_t f5 = f[5], f6 = f[6], f7 = f[7], f8 = f[8], f9 = f[9];
+    uint32_t g0 = g[0], g1 = g[1], g2 = g[2], g3 = g[3], g4 = g[4];
+    uint32_t g5 = g[5], g6 = g[6], g7 = g[7], g8 = g[8], g9 = g[9];
+    /* odd x odd limb products carry an extra factor of 2 */
+    uint32_t f1_2 = 2 * f1, f3_2 = 2 * f3, f5_2 = 2 * f5, f7_2 = 2 * f7, f9_2 = 2 * f9;
+    /* 2^255 = 19 mod p */
+    uint32_t g1_19 = 19 * g1, g2_19 = 19 * g2, g3_19 = 19 * g3, g4_19 = 19 * g4, g5_19 = 19 * g5;
+    uint32_t g6_19 = 19 * g6, g7_19 = 19 * g7, g8_19 = 19 * g8, g9_19 = 19 * g9;
+
+    uint64_t h0 = MUL(f0, g0) + MUL(f1_2, g9_19) + MUL(f2, g8_19) + MUL(f3_2, g7_19) + MUL(f4, g6_19) +
+                  MUL(f5_2, g5_19) + MUL(f6, g4_19) + MUL(f7_2, g3_19) + MUL(f8, g2_19) + MUL(f9_2, g1_19);
+    uint64_t h1 = MUL(f0, g1) + MUL(f1, g0) + MUL(f2, g9_19) + MUL(f3, g8_19) + MUL(f4, g7_19) +
+                  MUL(f5, g6_19) + MUL(f6, g5_19) + MUL(f7, g4_19) + MUL(f8, g3_19) + MUL(f9, g2_19);
+    uint64_t h2 = MUL(f0, g2) + MUL(f1_2, g1) + MUL(f2, g0) + MUL(f3_2, g9_19) + MUL(f4, g8_19) +
+                  MUL(f5_2, g7_19) + MUL(f6, g6_19) + MUL(f7_2, g5_19) + MUL(f8, g4_19) + MUL(f9_2, g3_19);
+    uint64_t h3 = MUL(f0, g3) + MUL(f1, g2) + MUL(f2, g1) + MUL(f3, g0) + MUL(f4, g9_19) +
+                  MUL(f5, g8_19) + MUL(f6, g7_19) + MUL(f7, g6_19) + MUL(f8, g5_19) + MUL(f9, g4_19);
+    uint64_t h4 = MUL(f0, g4) + MUL(f1_2, g3) + MUL(f2, g2) + MUL(f3_2, g1) + MUL(f4, g0) +
+                  MUL(f5_2, g9_19) + MUL(f6, g8_19) + MUL(f7_2, g7_19) + MUL(f8, g6_19) + MUL(f9_2, g5_19);
+    uint64_t h5 = MUL(f0, g5) + MUL(f1, g4) + MUL(f2, g3) + MUL(f3, g2) + MUL(f4, g1) +
+                  MUL(f5, g0) + MUL(f6, g9_19) + MUL(f7, g8_19) + MUL(f8, g7_19) + MUL(f9, g6_19);
+    uint64_t h6 = MUL(f0, g6) + MUL(f1_2, g5) + MUL(f2, g4) + MUL(f3_2, g3) + MUL(f4, g2) +
+                  MUL(f5_2, g1) + MUL(f6, g0) + MUL(f7_2, g9_19) + MUL(f8, g8_19) + MUL(f9_2, g7_19);
+    uint64_t h7 = MUL(f0, g7) + MUL(f1, g6) + MUL(f2, g5) + MUL(f3, g4) + MUL(f4, g3) +
+                  MUL(f5, g2) + MUL(f6, g1) + MUL(f7, g0) + MUL(f8, g9_19) + MUL(f9, g8_19);
+    uint64_t h8 = MUL(f0, g8) + MUL(f1_2, g7) + MUL(f2, g6) + MUL(f3_2, g5) + MUL(f4, g4) +
+                  MUL(f5_2, g3) + MUL(f6, g2) + MUL(f7_2, g1) + MUL(f8, g0) + MUL(f9_2, g9_19);
+    uint64_t h9 = MUL(f0, g9) + MUL(f1, g8) + MUL(f2, g7) + MUL(f3, g6) + MUL(f4, g5) +
+                  MUL(f5, g4) + MUL(f6, g3) + MUL(f7, g2) + MUL(f8, g1) + MUL(f9, g0);
+
+    fe_carry(h, h0, h1, h2, h3, h4, h5, h6, h7, h8, h9);
+}
+
+/* 55 products instead of 100 */
+static inline void fe_sq(fe h, const fe f)
+{
+    uint32_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+    uint32_t f5 = f[5], f6 = f[6], f7 = f[7], f8 = f[8], f9 = f[9];
+    uint32_t f0_2 = 2 * f0, f1_2 = 2 * f1, f2_2 = 2 * f2, f3_2 = 2 * f3, f4_2 = 2 * f4;
+    uint32_t f5_2 = 2 * f5, f6_2 = 2 * f6, f7_2 = 2 * f7, f8_2 = 2 * f8, f9_2 = 2 * f9;
+    uint32_t f5_19 = 19 * f5, f6_19 = 19 * f6, f7_19 = 19 * f7, f8_19 = 19 * f8, f9_19 = 19 * f9;
+    uint32_t f7_38 = 38 * f7, f9_38 = 38 * f9;
+
+    uint64_t h0 = MUL(f0, f0) + MUL(f1_2, f9_38) + MUL(f2_2, f8_19) + MUL(f3_2, f7_38) + MUL(f4_2, f6_19) +
+                  MUL(f5_2, f5_19);
+    uint64_t h1 = MUL(f0_2, f1) + MUL(f2_2, f9_19) + MUL(f3_2, f8_19) + MUL(f4_2, f7_19) + MUL(f5_2, f6_19);
+    uint64_t h2 = MUL(f0_2, f2) + MUL(f1_2, f1) + MUL(f3_2, f9_38) + MUL(f4_2, f8_19) + MUL(f5_2, f7_38) +
+                  MUL(f6, f6_19);
+    uint64_t h3 = MUL(f0_2, f3) + MUL(f1_2, f2) + MUL(f4_2, f9_19) + MUL(f5_2, f8_19) + MUL(f6_2, f7_19);
+    uint64_t h4 = MUL(f0_2, f4) + MUL(f1_2, f3_2) + MUL(f2, f2) + MUL(f5_2, f9_38) + MUL(f6_2, f8_19) +
+                  MUL(f7_2, f7_19);
+    uint64_t h5 = MUL(f0_2, f5) + MUL(f1_2, f4) + MUL(f2_2, f3) + MUL(f6_2, f9_19) + MUL(f7_2, f8_19);
+    uint64_t h6 = MUL(f0_2, f6) + MUL(f1_2, f5_2) + MUL(f2_2, f4) + MUL(f3_2, f3) + MUL(f7_2, f9_38) +
+                  MUL(f8, f8_19);
+    uint64_t h7 = MUL(f0_2, f7) + MUL(f1_2, f6) + MUL(f2_2, f5) + MUL(f3_2, f4) + MUL(f8_2, f9_19);
+    uint64_t h8 = MUL(f0_2, f8) + MUL(f1_2, f7_2) + MUL(f2_2, f6) + MUL(f3_2, f5_2) + MUL(f4, f4) +
+                  MUL(f9_2, f9_19);
+    uint64_t h9 = MUL(f0_2, f9) + MUL(f1_2, f8) + MUL(f2_2, f7) + MUL(f3_2, f6) + MUL(f4_2, f5);
+
+    fe_carry(h, h0, h1, h2, h3, h4, h5, h6, h7, h8, h9);
+}
+
+static void fe_sqn(fe h, const fe f, int n)
+{
+    fe_sq(h, f);
+    for (int i = 1; i < n; i++) {
+        fe_sq(h, h);
+    }
+}
+
+/* h = f * (A - 2) / 4 */
+static inline void fe_mul_a24(fe h, const fe f)
+{
+    const uint32_t a24 = 121665;
+    fe_carry(h, MUL(f[0], a24), MUL(f[1], a24), MUL(f[2], a24), MUL(f[3], a24), MUL(f[4], a24),
+             MUL(f[5], a24), MUL(f[6], a24), MUL(f[7], a24), MUL(f[8], a24), MUL(f[9], a24));
+}
+
+/* Swaps f and g if b is 1, b is 0 or 1 */
+static inline void fe_cswap(fe f, fe g, uint32_t b)
+{
+    uint32_t mask = 0 - b;
+    for (int i = 0; i < 10; i++) {
+        uint32_t x = (f[i] ^ g[i]) & mask;
+        f[i] ^= x;
+        g[i] ^= x;
+    }
+}
+
+/* h = z^(p - 2) = 1 / z */
+static void fe_invert(fe h, const fe z)
+{
+    fe t0, t1, t2, t3;
+
+    fe_sq(t0, z);                   // z^2
+    fe_sqn(t1, t0, 2);              // z^8
+    fe_mul(t1, z, t1);              // z^9
+    fe_mul(t0, t0, t1);             // z^11
+    fe_sq(t2, t0);                  // z^22
+    fe_mul(t1, t1, t2);             // z^(2^5 - 1)
+    fe_sqn(t2, t1, 5);
+    fe_mul(t1, t2, t1);             // z^(2^10 - 1)
+    fe_sqn(t2, t1, 10);
+    fe_mul(t2, t2, t1);             // z^(2^20 - 1)
+    fe_sqn(t3, t2, 20);
+    fe_mul(t2, t3, t2);             // z^(2^40 - 1)
+    fe_sqn(t2, t2, 10);
+    fe_mul(t1, t2, t1);             // z^(2^50 - 1)
+    fe_sqn(t2, t1, 50);
+    fe_mul(t2, t2, t1);             // z^(2^100 - 1)
+    fe_sqn(t3, t2, 100);
+    fe_mul(t2, t3, t2);             // z^(2^200 - 1)
+    fe_sqn(t2, t2, 50);
+    fe_mul(t1, t2, t1);             // z^(2^250 - 1)
+    fe_sqn(t1, t1, 5);
+    fe_mul(h, t1, t0);              // z^(2^255 - 21)
+}
+
+/* Canonical little endian encoding of h mod p */
+static void fe_tobytes(uint8_t *s, const fe f)
+{
+    fe h;
+    uint32_t q;
+
+    /* limbs below 2^26 / 2^25 and h < 2^255 + 2^26 < 2p */
+    fe_carry(h, f[0], f[1], f[2], f[3], f[4], f[5], f[6], f[7], f[8], f[9]);
+    fe_carry(h, h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7], h[8], h[9]);
+
+    /* q = 1 if h >= p, i.e. h + 19 >= 2^255 */
+    q = (h[0] + 19) >> 26;
+    q = (h[1] + q) >> 25;
+    q = (h[2] + q) >> 26;
+    q = (h[3] + q) >> 25;
+    q = (h[4] + q) >> 26;
+    q = (h[5] + q) >> 25;
+    q = (h[6] + q) >> 26;
+    q = (h[7] + q) >> 25;
+    q = (h[8] + q) >> 26;
+    q = (h[9] + q) >> 25;
+
+    /* h - q * p = h + 19 * q - q * 2^255 */
+    h[0] += 19 * q;
+    h[1] += h[0] >> 26; h[0] &= MASK26;
+    h[2] += h[1] >> 25; h[1] &= MASK25;
+    h[3] += h[2] >> 26; h[2] &= MASK26;
+    h[4] += h[3] >> 25; h[3] &= MASK25;
+    h[5] += h[4] >> 26; h[4] &= MASK26;
+    h[6] += h[5] >> 25; h[5] &= MASK25;
+    h[7] += h[6] >> 26; h[6] &= MASK26;
+    h[8] += h[7] >> 25; h[7] &= MASK25;
+    h[9] += h[8] >> 26; h[8] &= MASK26;
+    h[9] &= MASK25;
+
+    static const uint8_t bits[10] = { 26, 25, 26, 25, 26, 25, 26, 25, 26, 25 };
+    uint64_t acc = 0;
+    int acc_bits = 0;
+    int pos = 0;
+    for (int i = 0; i < 10; i++) {
+        acc |= (uint64_t) h[i] << acc_bits;
+        acc_bits += bits[i];
+        while (acc_bits >= 8) {
+            s[pos++] = (uint8_t) acc;
+            acc >>= 8;
+            acc_bits -= 8;
+        }
+    }
+    s[pos] = (uint8_t) acc;     // the last 7 bits
+    sodium_memzero(h, sizeof(h));
+}
+
+static int crypto_scalarmult_curve25519_esp32(unsigned char *q, const unsigned char *n,
+                                              const unsigned char *p)
+{
+    uint8_t e[32];
+    fe x1, x2, z2, x3, z3;
+    fe a, b, c, d, aa, bb, da, cb, t;
+    uint32_t swap = 0;
+
+    memcpy(e, n, sizeof(e));
+    e[0] &= 248;
+    e[31] &= 127;
+    e[31] |= 64;
+
+    fe_frombytes(x1, p);
+    memset(x2, 0, sizeof(x2));
+    x2[0] = 1;
+    memset(z2, 0, sizeof(z2));
+    memcpy(x3, x1, sizeof(x3));
+    memset(z3, 0, sizeof(z3));
+    z3[0] = 1;
+
+    for (int pos = 254; pos >= 0; pos--) {
+        uint32_t bit = (e[pos >> 3] >> (pos & 7)) & 1;
+        swap ^= bit;
+        fe_cswap(x2, x3, swap);
+        fe_cswap(z2, z3, swap);
+        swap = bit;
+
+        fe_add(a, x2, z2);
+        fe_sub(b, x2, z2);
+        fe_add(c, x3, z3);
+        fe_sub(d, x3, z3);
+        fe_mul(da, d, a);
+        fe_mul(cb, c, b);
+        fe_sq(aa, a);
+        fe_sq(bb, b);
+        fe_add(t, da, cb);
+        fe_sq(x3, t);
+        fe_sub(t, da, cb);
+        fe_sq(t, t);
+        fe_mul(z3, x1, t);
+        fe_mul(x2, aa, bb);
+        fe_sub(bb, aa, bb);         // E = AA - BB
+        fe_mul_a24(t, bb);
+        fe_add(t, aa, t);
+        fe_mul(z2, bb, t);
+    }
+    fe_cswap(x2, x3, swap);
+    fe_cswap(z2, z3, swap);
+
+    fe_invert(z2, z2);
+    fe_mul(x2, x2, z2);
+    fe_tobytes(q, x2);
+
+    sodium_memzero(e, sizeof(e));
+    sodium_memzero(x2, sizeof(x2));
+    sodium_memzero(z2, sizeof(z2));
+    sodium_memzero(x3, sizeof(x3));
+    sodium_memzero(z3, sizeof(z3));
+    return 0;
+}
+
+static int crypto_scalarmult_curve25519_esp32_base(unsigned char *q, const unsigned char *n)
+{
+    return crypto_scalarmult_curve25519_ref10_upstream_implementation.mult_base(q, n);
+}
+
+struct crypto_scalarmult_curve25519_implementation crypto_scalarmult_curve25519_ref10_implementation = {
+    .mult = crypto_scalarmult_curve25519_esp32,
+    .mult_base = crypto_scalarmult_curve25519_esp32_base,
+};
@@ -0,0 +1,191 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/* ChaCha20 for the ESP32, replacing crypto_stream/chacha20/ref.
+
+   The state is kept in 16 local words and the double round is unrolled twice,
+   so GCC keeps most of the state in registers, and each rotation is a funnel
+   shift (SSAI and SRC). Words of the key stream are XORed with the message
+   a word at a time when both buffers are aligned. The reference
+   implementation assembles and stores every word byte by byte.
+
+   The output is the same as the reference implementation, including the carry
+   of the 32-bit block counter into the next state word.
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include "crypto_stream_chacha20.h"
+#include "utils.h"
+#include "upstream_impl.h"
+
+#ifndef NATIVE_LITTLE_ENDIAN
+#error "chacha20_esp32.c uses the key stream words as little endian bytes"
+#endif
+
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+#define QUARTERROUND(a, b, c, d)            \
+    a += b; d = ROTL32(d ^ a, 16);          \
+    c += d; b = ROTL32(b ^ c, 12);          \
+    a += b; d = ROTL32(d ^ a, 8);           \
+    c += d; b = ROTL32(b ^ c, 7);
+
+#define DOUBLEROUND()                       \
+    QUARTERROUND(x0, x4, x8,  x12)          \
+    QUARTERROUND(x1, x5, x9,  x13)          \
+    QUARTERROUND(x2, x6, x10, x14)          \
+    QUARTERROUND(x3, x7, x11, x15)          \
+    QUARTERROUND(x0, x5, x10, x15)          \
+    QUARTERROUND(x1, x6, x11, x12)          \
+    QUARTERROUND(x2, x7, x8,  x13)          \
+    QUARTERROUND(x3, x4, x9,  x14)
+
+static inline uint32_t load32_le(const uint8_t *p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static void chacha20_block(const uint32_t in[16], uint32_t out[16])
+{
+    uint32_t x0 = in[0], x1 = in[1], x2 = in[2], x3 = in[3];
+    uint32_t x4 = in[4], x5 = in[5], x6 = in[6], x7 = in[7];
+    uint32_t x8 = in[8], x9 = in[9], x10 = in[10], x11 = in[11];
+    uint32_t x12 = in[12], x13 = in[13], x14 = in[14], x15 = in[15];
+
+    for (int i = 0; i < 10; i += 2) {
+        DOUBLEROUND()
+        DOUBLEROUND()
+    }
+
+    out[0] = x0 + in[0];
+    out[1] = x1 + in[1];
+    out[2] = x2 + in[2];
+    out[3] = x3 + in[3];
+    out[4] = x4 + in[4];
+    out[5] = x5 + in[5];
+    out[6] = x6 + in[6];
+    out[7] = x7 + in[7];
+    out[8] = x8 + in[8];
+    out[9] = x9 + in[9];
+    out[10] = x10 + in[10];
+    out[11] = x11 + in[11];
+    out[12] = x12 + in[12];
+    out[13] = x13 + in[13];
+    out[14] = x14 + in[14];
+    out[15] = x15 + in[15];
+}
+
+static void chacha20_keysetup(uint32_t state[16], const unsigned char *k)
+{
+    state[0] = 0x61707865;  // "expand 32-byte k"
+    state[1] = 0x3320646e;
+    state[2] = 0x79622d32;
+    state[3] = 0x6b206574;
+    for (int i = 0; i < 8; i++) {
+        state[4 + i] = load32_le(k + 4 * i);
+    }
+}
+
+/* m may be NULL for the key stream alone */
+static void chacha20_xor(uint32_t state[16], unsigned char *c, const unsigned char *m, unsigned long long len)
+{
+    uint32_t ks[16];
+
+    while (len > 0) {
+        chacha20_block(state, ks);
+        if (++state[12] == 0) {
+            state[13]++;
+        }
+
+        size_t n = len < 64 ? (size_t) len : 64;
+        if (n == 64 && (((uintptr_t) c | (uintptr_t) m) & 3) == 0) {
+            uint32_t *c32 = (uint32_t *) c;
+            const uint32_t *m32 = (const uint32_t *) m;
+            if (m32) {
+                for (int i = 0; i < 16; i++) {
+                    c32[i] = m32[i] ^ ks[i];
+                }
+            } else {
+                memcpy(c32, ks, 64);
+            }
+        } else {
+            const uint8_t *ks8 = (const uint8_t *) ks;
+            for (size_t i = 0; i < n; i++) {
+                c[i] = (m ? m[i] : 0) ^ ks8[i];
+            }
+        }
+        c += n;
+        if (m) {
+            m += n;
+        }
+        len -= n;
+    }
+    sodium_memzero(ks, sizeof(ks));
+}
+
+static int stream_esp32_xor_ic(unsigned char *c, const unsigned char *m, unsigned long long mlen,
+                               const unsigned char *n, uint64_t ic, const unsigned char *k)
+{
+    uint32_t state[16];
+
+    if (!mlen) {
+        return 0;
+    }
+    chacha20_keysetup(state, k);
+    state[12] = (uint32_t) ic;
+    state[13] = (uint32_t) (ic >> 32);
+    state[14] = load32_le(n);
+    state[15] = load32_le(n + 4);
+    chacha20_xor(state, c, m, mlen);
+    sodium_memzero(state, sizeof(state));
+    return 0;
+}
+
+static int stream_ietf_esp32_xor_ic(unsigned char *c, const unsigned char *m, unsigned long long mlen,
+                                    const unsigned char *n, uint32_t ic, const unsigned char *k)
+{
+    uint32_t state[16];
+
+    if (!mlen) {
+        return 0;
+    }
+    chacha20_keysetup(state, k);
+    state[12] = ic;
+    state[13] = load32_le(n);
+    state[14] = load32_le(n + 4);
+    state[15] = load32_le(n + 8);
+    chacha20_xor(state, c, m, mlen);
+    sodium_memzero(state, sizeof(state));
+    return 0;
+}
+
+static int stream_esp32(unsigned char *c, unsigned long long clen,
+                        const unsigned char *n, const unsigned char *k)
+{
+    return stream_esp32_xor_ic(c, NULL, clen, n, 0, k);
+}
+
+static int stream_ietf_esp32(unsigned char *c, unsigned long long clen,
+                             const unsigned char *n, const unsigned char *k)
+{
+    return stream_ietf_esp32_xor_ic(c, NULL, clen, n, 0, k);
+}
+
+struct crypto_stream_chacha20_implementation crypto_stream_chacha20_ref_implementation = {
+    .stream = stream_esp32,
+    .stream_ietf = stream_ietf_esp32,
+    .stream_xor_ic = stream_esp32_xor_ic,
+    .stream_ietf_xor_ic = stream_ietf_esp32_xor_ic,
+};
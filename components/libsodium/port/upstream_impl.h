@@ -0,0 +1,44 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/* When an ESP32 implementation is enabled, it takes the symbol name of the
+   upstream implementation it replaces, so that libsodium picks it without
+   patching the submodule. The upstream files are still built, with their
+   implementation renamed to *_upstream_implementation (see CMakeLists.txt
+   and component.mk).
+
+   The ESP32 X25519 implementation calls the upstream mult_base, which uses
+   the precomputed Ed25519 base point tables. The unit tests compare both
+   implementations and benchmark them against each other.
+*/
+
+#include "sdkconfig.h"
+#include "crypto_stream/chacha20/stream_chacha20.h"
+#include "crypto_scalarmult/curve25519/scalarmult_curve25519.h"
+
+#ifdef CONFIG_LIBSODIUM_CHACHA20_ESP32
+/* ESP32 implementation, chacha20_esp32.c */
+extern struct crypto_stream_chacha20_implementation crypto_stream_chacha20_ref_implementation;
+/* Upstream crypto_stream/chacha20/ref/chacha20_ref.c */
+extern struct crypto_stream_chacha20_implementation crypto_stream_chacha20_ref_upstream_implementation;
+#endif
+
+#ifdef CONFIG_LIBSODIUM_CURVE25519_ESP32
+/* ESP32 implementation, x25519_esp32.c */
+extern struct crypto_scalarmult_curve25519_implementation crypto_scalarmult_curve25519_ref10_implementation;
+/* Upstream crypto_scalarmult/curve25519/ref10/x25519_ref10.c */
+extern struct crypto_scalarmult_curve25519_implementation crypto_scalarmult_curve25519_ref10_upstream_implementation;
+#endif
@@ -16,6 +16,8 @@ endif # TESTS_ALL
 COMPONENT_SRCDIRS := . $(LS_TESTDIR)
 
 COMPONENT_PRIV_INCLUDEDIRS := $(LS_TESTDIR)/../quirks
+# for port/upstream_impl.h
+COMPONENT_PRIV_INCLUDEDIRS += ../port ../libsodium/src/libsodium ../libsodium/src/libsodium/include/sodium
 
 COMPONENT_OBJS := test_sodium.o
 
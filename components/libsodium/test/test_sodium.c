@@ -1,6 +1,19 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
 #include "unity.h"
+#include "test_utils.h"
+#include "esp_timer.h"
+#include "freertos/xtensa_api.h"
+#include "sodium/core.h"
 #include "sodium/crypto_hash_sha256.h"
 #include "sodium/crypto_hash_sha512.h"
+#include "sodium/crypto_aead_chacha20poly1305.h"
+#include "sodium/crypto_scalarmult.h"
+#include "sodium/crypto_sign.h"
+#include "sodium/randombytes.h"
+#include "upstream_impl.h"
 
 /* Note: a lot of these libsodium test programs assert() things, but they're not complete unit tests - most expect
    output to be compared to the matching .exp file.
@@ -117,3 +130,217 @@ TEST_CASE("sha512 sanity check", "[libsodium]")
     crypto_hash_sha512_final(&state, calculated);
     TEST_ASSERT_EQUAL_MEMORY(expected, calculated, crypto_hash_sha512_bytes());
 }
+
+/* Benchmarks of the libsodium software implementations, to compare with
+   the mbedTLS benchmarks in components/mbedtls/test/test_crypto_perf.c */
+
+#ifdef CONFIG_LIBSODIUM_USE_MBEDTLS_SHA
+#define SODIUM_SHA_BACKEND "mbedtls"
+#else
+#define SODIUM_SHA_BACKEND "sodium"
+#endif
+
+#define BENCH_MAX_LEN 4096
+#define BENCH_BYTES 32768
+
+static void bench_sodium_bytes(const char *name, void (*op)(uint8_t *buf, size_t len))
+{
+    const size_t sizes[] = { 16, 64, 256, 1024, BENCH_MAX_LEN };
+    char item[64];
+    /* room for the output, tag or digest after the input */
+    uint8_t *buf = calloc(1, BENCH_MAX_LEN + 64);
+    TEST_ASSERT_NOT_NULL(buf);
+    for (int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        size_t len = sizes[i];
+        int reps = MAX(8, BENCH_BYTES / len);
+        op(buf, len);
+        int64_t start_us = esp_timer_get_time();
+        uint32_t start = xthal_get_ccount();
+        for (int r = 0; r < reps; r++) {
+            op(buf, len);
+        }
+        uint32_t cycles = xthal_get_ccount() - start;
+        int64_t us = esp_timer_get_time() - start_us;
+        snprintf(item, sizeof(item), "%s %dB", name, (int)len);
+        IDF_LOG_PERFORMANCE(item, "%.1f cycles/byte", (double)cycles / ((double)reps * len));
+        IDF_LOG_PERFORMANCE(item, "%d ops/s", (int)(reps * 1000000LL / us));
+    }
+    free(buf);
+}
+
+static void chacha20poly1305_op(uint8_t *buf, size_t len)
+{
+    static const uint8_t key[crypto_aead_chacha20poly1305_IETF_KEYBYTES];
+    static const uint8_t nonce[crypto_aead_chacha20poly1305_IETF_NPUBBYTES];
+    unsigned long long clen;
+    crypto_aead_chacha20poly1305_ietf_encrypt(buf, &clen, buf, len, NULL, 0, NULL, nonce, key);
+}
+
+static void sha256_op(uint8_t *buf, size_t len)
+{
+    crypto_hash_sha256(buf + BENCH_MAX_LEN, buf, len);
+}
+
+static void sha512_op(uint8_t *buf, size_t len)
+{
+    crypto_hash_sha512(buf + BENCH_MAX_LEN, buf, len);
+}
+
+TEST_CASE("libsodium symmetric performance", "[libsodium][perf]")
+{
+    TEST_ASSERT_NOT_EQUAL(-1, sodium_init());
+    bench_sodium_bytes("ChaCha20-Poly1305", chacha20poly1305_op);
+    bench_sodium_bytes("SHA-256 " SODIUM_SHA_BACKEND, sha256_op);
+    bench_sodium_bytes("SHA-512 " SODIUM_SHA_BACKEND, sha512_op);
+}
+
+TEST_CASE("libsodium public key performance", "[libsodium][perf][timeout=60]")
+{
+    uint8_t pk[crypto_sign_PUBLICKEYBYTES];
+    uint8_t sk[crypto_sign_SECRETKEYBYTES];
+    uint8_t sig[crypto_sign_BYTES];
+    uint8_t q[crypto_scalarmult_BYTES];
+    const uint8_t msg[32] = { 0 };
+    const int reps = 8;
+
+    TEST_ASSERT_NOT_EQUAL(-1, sodium_init());
+    TEST_ASSERT_EQUAL(0, crypto_sign_keypair(pk, sk));
+
+    int64_t start_us = esp_timer_get_time();
+    for (int r = 0; r < reps; r++) {
+        TEST_ASSERT_EQUAL(0, crypto_sign_detached(sig, NULL, msg, sizeof(msg), sk));
+    }
+    IDF_LOG_PERFORMANCE("Ed25519 sign", "%.1f ops/s", reps * 1000000.0 / (esp_timer_get_time() - start_us));
+
+    start_us = esp_timer_get_time();
+    for (int r = 0; r < reps; r++) {
+        TEST_ASSERT_EQUAL(0, crypto_sign_verify_detached(sig, msg, sizeof(msg), pk));
+    }
+    IDF_LOG_PERFORMANCE("Ed25519 verify", "%.1f ops/s", reps * 1000000.0 / (esp_timer_get_time() - start_us));
+
+    start_us = esp_timer_get_time();
+    for (int r = 0; r < reps; r++) {
+        TEST_ASSERT_EQUAL(0, crypto_scalarmult_base(q, sk));
+    }
+    IDF_LOG_PERFORMANCE("X25519 base point mult", "%.1f ops/s", reps * 1000000.0 / (esp_timer_get_time() - start_us));
+
+    start_us = esp_timer_get_time();
+    for (int r = 0; r < reps; r++) {
+        TEST_ASSERT_EQUAL(0, crypto_scalarmult(q, sk, q));
+    }
+    IDF_LOG_PERFORMANCE("X25519 mult", "%.1f ops/s", reps * 1000000.0 / (esp_timer_get_time() - start_us));
+}
+
+#ifdef CONFIG_LIBSODIUM_CHACHA20_ESP32
+TEST_CASE("ESP32 ChaCha20 matches the reference implementation", "[libsodium]")
+{
+    const size_t max_len = 300;
+    uint8_t key[32], nonce[12];
+    uint8_t *msg = malloc(max_len + 4);
+    uint8_t *out_esp32 = malloc(max_len + 4);
+    uint8_t *out_upstream = malloc(max_len + 4);
+    TEST_ASSERT_NOT_NULL(msg);
+    TEST_ASSERT_NOT_NULL(out_esp32);
+    TEST_ASSERT_NOT_NULL(out_upstream);
+    TEST_ASSERT_NOT_EQUAL(-1, sodium_init());
+
+    const struct crypto_stream_chacha20_implementation *esp32 = &crypto_stream_chacha20_ref_implementation;
+    const struct crypto_stream_chacha20_implementation *upstream = &crypto_stream_chacha20_ref_upstream_implementation;
+    const uint64_t counters[] = { 0, 1, 0xffffffff, 0x1ffffffff };
+
+    for (int i = 0; i < 200; i++) {
+        size_t len = (i < 130) ? i : 1 + randombytes_uniform(max_len);
+        /* unaligned input and output buffers */
+        uint8_t *m = msg + (i & 3);
+        uint8_t *c = out_esp32 + ((i >> 2) & 3);
+        uint64_t ic = counters[i % 4];
+        randombytes_buf(key, sizeof(key));
+        randombytes_buf(nonce, sizeof(nonce));
+        randombytes_buf(m, len);
+
+        TEST_ASSERT_EQUAL(0, esp32->stream_xor_ic(c, m, len, nonce, ic, key));
+        TEST_ASSERT_EQUAL(0, upstream->stream_xor_ic(out_upstream, m, len, nonce, ic, key));
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(out_upstream, c, len);
+
+        TEST_ASSERT_EQUAL(0, esp32->stream_ietf_xor_ic(c, m, len, nonce, (uint32_t) ic, key));
+        TEST_ASSERT_EQUAL(0, upstream->stream_ietf_xor_ic(out_upstream, m, len, nonce, (uint32_t) ic, key));
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(out_upstream, c, len);
+
+        TEST_ASSERT_EQUAL(0, esp32->stream(c, len, nonce, key));
+        TEST_ASSERT_EQUAL(0, upstream->stream(out_upstream, len, nonce, key));
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(out_upstream, c, len);
+
+        TEST_ASSERT_EQUAL(0, esp32->stream_ietf(c, len, nonce, key));
+        TEST_ASSERT_EQUAL(0, upstream->stream_ietf(out_upstream, len, nonce, key));
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(out_upstream, c, len);
+    }
+    free(msg);
+    free(out_esp32);
+    free(out_upstream);
+}
+
+static void chacha20_esp32_op(uint8_t *buf, size_t len)
+{
+    static const uint8_t key[32];
+    static const uint8_t nonce[12];
+    crypto_stream_chacha20_ref_implementation.stream_ietf_xor_ic(buf, buf, len, nonce, 0, key);
+}
+
+static void chacha20_upstream_op(uint8_t *buf, size_t len)
+{
+    static const uint8_t key[32];
+    static const uint8_t nonce[12];
+    crypto_stream_chacha20_ref_upstream_implementation.stream_ietf_xor_ic(buf, buf, len, nonce, 0, key);
+}
+
+TEST_CASE("ESP32 ChaCha20 performance", "[libsodium][perf]")
+{
+    TEST_ASSERT_NOT_EQUAL(-1, sodium_init());
+    bench_sodium_bytes("ChaCha20 esp32", chacha20_esp32_op);
+    bench_sodium_bytes("ChaCha20 upstream", chacha20_upstream_op);
+}
+#endif // CONFIG_LIBSODIUM_CHACHA20_ESP32
+
+#ifdef CONFIG_LIBSODIUM_CURVE25519_ESP32
+TEST_CASE("ESP32 X25519 matches the reference implementation", "[libsodium]")
+{
+    uint8_t n[32], p[32], q_esp32[32], q_upstream[32];
+
+    TEST_ASSERT_NOT_EQUAL(-1, sodium_init());
+    for (int i = 0; i < 32; i++) {
+        randombytes_buf(n, sizeof(n));
+        randombytes_buf(p, sizeof(p));
+        if (i == 0) {
+            /* u = p - 1, non-canonical encodings of other points are covered by random inputs */
+            memset(p, 0xff, sizeof(p));
+            p[0] = 0xec;
+            p[31] = 0x7f;
+        }
+        TEST_ASSERT_EQUAL(0, crypto_scalarmult_curve25519_ref10_implementation.mult(q_esp32, n, p));
+        TEST_ASSERT_EQUAL(0, crypto_scalarmult_curve25519_ref10_upstream_implementation.mult(q_upstream, n, p));
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(q_upstream, q_esp32, sizeof(q_esp32));
+    }
+}
+
+TEST_CASE("ESP32 X25519 performance", "[libsodium][perf][timeout=60]")
+{
+    uint8_t n[32], p[32], q[32];
+    const int reps = 8;
+
+    TEST_ASSERT_NOT_EQUAL(-1, sodium_init());
+    randombytes_buf(n, sizeof(n));
+    randombytes_buf(p, sizeof(p));
+
+    int64_t start_us = esp_timer_get_time();
+    for (int r = 0; r < reps; r++) {
+        crypto_scalarmult_curve25519_ref10_implementation.mult(q, n, p);
+    }
+    IDF_LOG_PERFORMANCE("X25519 mult esp32", "%.1f ops/s", reps * 1000000.0 / (esp_timer_get_time() - start_us));
+
+    start_us = esp_timer_get_time();
+    for (int r = 0; r < reps; r++) {
+        crypto_scalarmult_curve25519_ref10_upstream_implementation.mult(q, n, p);
+    }
+    IDF_LOG_PERFORMANCE("X25519 mult upstream", "%.1f ops/s", reps * 1000000.0 / (esp_timer_get_time() - start_us));
+}
+#endif // CONFIG_LIBSODIUM_CURVE25519_ESP32
@@ -17,6 +17,7 @@
 
 #include <stdint.h>
 #include <stdarg.h>
+#include <stdbool.h>
 #include "sdkconfig.h"
 #include <esp32/rom/ets_sys.h>
 
@@ -72,6 +73,43 @@ void esp_log_level_set(const char* tag, esp_log_level_t level);
  */
 vprintf_like_t esp_log_set_vprintf(vprintf_like_t func);
 
+/**
+ * @brief Get the number of dropped log messages
+ *
+ * With CONFIG_LOG_ASYNC enabled, log messages are discarded instead of
+ * blocking the caller when the ring buffer of the calling CPU is full.
+ *
+ * @return number of log messages dropped since startup, 0 if CONFIG_LOG_ASYNC is disabled
+ */
+uint32_t esp_log_async_dropped_count();
+
+/**
+ * @brief State of a rate limited logging statement
+ *
+ * Used by ESP_LOGx_RATELIMIT macros, one per statement.
+ */
+typedef struct {
+    uint32_t last;          /*!< time of the last output, in milliseconds */
+    uint32_t suppressed;    /*!< number of messages suppressed since the last output */
+    bool started;           /*!< true once a message has been output */
+} esp_log_ratelimit_t;
+
+/**
+ * @brief Check whether a rate limited logging statement may output a message
+ *
+ * This function is not intended to be used directly. Instead, use one of
+ * ESP_LOGE_RATELIMIT, ESP_LOGW_RATELIMIT, ESP_LOGI_RATELIMIT, ESP_LOGD_RATELIMIT,
+ * ESP_LOGV_RATELIMIT macros.
+ *
+ * @param state state of the logging statement
+ * @param interval_ms minimum time between two messages, in milliseconds
+ * @param[out] suppressed number of messages suppressed since the last output,
+ *             set if the function returns true
+ *
+ * @return true if the message should be output
+ */
+bool esp_log_ratelimit_check(esp_log_ratelimit_t* state, uint32_t interval_ms, uint32_t* suppressed);
+
 /**
  * @brief Function which returns timestamp to be used in log output
  *
@@ -118,6 +156,27 @@ void esp_log_write(esp_log_level_t level, const char* tag, const char* format, .
 #endif
 #endif
 
+#if CONFIG_LOG_TAG_LEVELS && !defined(BOOTLOADER_BUILD)
+/* Maximum level of the tag, from ESP_LOG_TAG_LEVEL(tag, level) entries of the
+ * table header. Folded to a constant by the compiler when the tag is a
+ * constant string, so the comparison in ESP_LOG_TAG_ENABLED costs nothing
+ * at run time.
+ */
+static inline __attribute__((always_inline, pure)) esp_log_level_t esp_log_tag_max_level(const char* tag)
+{
+#define ESP_LOG_TAG_LEVEL(name, level) if (__builtin_strcmp(tag, name) == 0) { return (level); }
+#include CONFIG_LOG_TAG_LEVELS_FILE
+#undef ESP_LOG_TAG_LEVEL
+    return ESP_LOG_VERBOSE;
+}
+
+/* Tags which are not known at compile time are not filtered here */
+#define ESP_LOG_TAG_ENABLED(level, tag) \
+        (!__builtin_constant_p(esp_log_tag_max_level(tag)) || esp_log_tag_max_level(tag) >= (level))
+#else
+#define ESP_LOG_TAG_ENABLED(level, tag) 1
+#endif
+
 /** @endcond */
 
 /**
@@ -303,14 +362,59 @@ void esp_log_write(esp_log_level_t level, const char* tag, const char* format, .
         else                                { esp_log_write(ESP_LOG_INFO,       tag, LOG_FORMAT(I, format), esp_log_timestamp(), tag, ##__VA_ARGS__); } \
     } while(0)
 
-/** runtime macro to output logs at a specified level. Also check the level with ``LOG_LOCAL_LEVEL``.
+/** runtime macro to output logs at a specified level. Also check the level with ``LOG_LOCAL_LEVEL``
+ * and, if ``CONFIG_LOG_TAG_LEVELS`` is enabled, with the compile time level of the tag.
  *
  * @see ``printf``, ``ESP_LOG_LEVEL``
  */
 #define ESP_LOG_LEVEL_LOCAL(level, tag, format, ...) do {               \
-        if ( LOG_LOCAL_LEVEL >= level ) ESP_LOG_LEVEL(level, tag, format, ##__VA_ARGS__); \
+        if ( LOG_LOCAL_LEVEL >= level && ESP_LOG_TAG_ENABLED(level, tag) ) ESP_LOG_LEVEL(level, tag, format, ##__VA_ARGS__); \
     } while(0)
 
+#ifndef BOOTLOADER_BUILD
+/**
+ * macro to output logs at ESP_LOG_ERROR level, at most once per ``interval_ms`` milliseconds.
+ *
+ * Messages of this statement which come sooner are suppressed, and their number
+ * is written before the next message.
+ *
+ * @param tag tag of the log
+ * @param interval_ms minimum time between two messages of this statement, in milliseconds
+ *
+ * @see ``ESP_LOGE``
+ */
+#define ESP_LOGE_RATELIMIT( tag, interval_ms, format, ... ) ESP_LOG_LEVEL_RATELIMIT(ESP_LOG_ERROR,   tag, interval_ms, format, ##__VA_ARGS__)
+/// macro to output rate limited logs at ``ESP_LOG_WARN`` level.  @see ``ESP_LOGE_RATELIMIT``
+#define ESP_LOGW_RATELIMIT( tag, interval_ms, format, ... ) ESP_LOG_LEVEL_RATELIMIT(ESP_LOG_WARN,    tag, interval_ms, format, ##__VA_ARGS__)
+/// macro to output rate limited logs at ``ESP_LOG_INFO`` level.  @see ``ESP_LOGE_RATELIMIT``
+#define ESP_LOGI_RATELIMIT( tag, interval_ms, format, ... ) ESP_LOG_LEVEL_RATELIMIT(ESP_LOG_INFO,    tag, interval_ms, format, ##__VA_ARGS__)
+/// macro to output rate limited logs at ``ESP_LOG_DEBUG`` level.  @see ``ESP_LOGE_RATELIMIT``
+#define ESP_LOGD_RATELIMIT( tag, interval_ms, format, ... ) ESP_LOG_LEVEL_RATELIMIT(ESP_LOG_DEBUG,   tag, interval_ms, format, ##__VA_ARGS__)
+/// macro to output rate limited logs at ``ESP_LOG_VERBOSE`` level.  @see ``ESP_LOGE_RATELIMIT``
+#define ESP_LOGV_RATELIMIT( tag, interval_ms, format, ... ) ESP_LOG_LEVEL_RATELIMIT(ESP_LOG_VERBOSE, tag, interval_ms, format, ##__VA_ARGS__)
+
+/** runtime macro to output logs at a specified level, at most once per ``interval_ms`` milliseconds.
+ *
+ * @see ``ESP_LOGE_RATELIMIT``, ``ESP_LOG_LEVEL_LOCAL``
+ */
+#define ESP_LOG_LEVEL_RATELIMIT(level, tag, interval_ms, format, ...) do {                       \
+        static esp_log_ratelimit_t s_log_ratelimit_state;                                        \
+        uint32_t log_suppressed_count;                                                           \
+        if ( LOG_LOCAL_LEVEL >= level && ESP_LOG_TAG_ENABLED(level, tag) &&                      \
+                esp_log_ratelimit_check(&s_log_ratelimit_state, (interval_ms), &log_suppressed_count) ) { \
+            if (log_suppressed_count != 0) {                                                     \
+                ESP_LOG_LEVEL(level, tag, "%u messages suppressed", (unsigned) log_suppressed_count); \
+            }                                                                                    \
+            ESP_LOG_LEVEL(level, tag, format, ##__VA_ARGS__);                                    \
+        }} while(0)
+#else
+#define ESP_LOGE_RATELIMIT( tag, interval_ms, format, ... ) ESP_LOGE(tag, format, ##__VA_ARGS__)
+#define ESP_LOGW_RATELIMIT( tag, interval_ms, format, ... ) ESP_LOGW(tag, format, ##__VA_ARGS__)
+#define ESP_LOGI_RATELIMIT( tag, interval_ms, format, ... ) ESP_LOGI(tag, format, ##__VA_ARGS__)
+#define ESP_LOGD_RATELIMIT( tag, interval_ms, format, ... ) ESP_LOGD(tag, format, ##__VA_ARGS__)
+#define ESP_LOGV_RATELIMIT( tag, interval_ms, format, ... ) ESP_LOGV(tag, format, ##__VA_ARGS__)
+#endif  // BOOTLOADER_BUILD
+
 #ifdef __cplusplus
 }
 #endif
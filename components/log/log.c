@@ -59,6 +59,14 @@
 #include "sys/queue.h"
 #include "soc/soc_memory_layout.h"
 
+#ifndef BOOTLOADER_BUILD
+#include <sys/param.h>
+#endif
+
+#if !defined(BOOTLOADER_BUILD) && CONFIG_LOG_ASYNC
+#include "freertos/ringbuf.h"
+#endif
+
 //print number of bytes per line for esp_log_buffer_char and esp_log_buffer_hex
 #define BYTES_PER_LINE 16
 
@@ -98,6 +106,61 @@ static SemaphoreHandle_t s_log_mutex = NULL;
 static uint32_t s_log_cache_misses = 0;
 #endif
 
+#if CONFIG_LOG_ASYNC
+// Messages formatted by the tasks running on each CPU, waiting for the log task
+static RingbufHandle_t s_log_async_buf[portNUM_PROCESSORS];
+static TaskHandle_t s_log_async_task = NULL;
+static bool s_log_async_failed = false;
+static uint32_t s_log_async_dropped = 0;
+static portMUX_TYPE s_log_async_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool log_async_write(const char* format, va_list list);
+#endif
+
+#if CONFIG_LOG_RATE_LIMIT
+// Token bucket of a tag, tokens are counted in 1/1000 of a message
+typedef struct {
+    const char* tag;
+    uint32_t last;
+    uint32_t tokens;
+    uint32_t suppressed;
+} log_rate_entry_t;
+
+#define LOG_RATE_LIMIT_BURST_TOKENS (CONFIG_LOG_RATE_LIMIT_BURST * 1000)
+
+static log_rate_entry_t s_log_rate[CONFIG_LOG_RATE_LIMIT_TAGS];
+
+static inline bool log_rate_take(const char* tag, uint32_t* suppressed);
+#endif
+
+static portMUX_TYPE s_log_ratelimit_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#if CONFIG_LOG_BINARY
+/* Binary log frame: ESC 'b' <length of encoded payload> <COBS encoded payload>.
+ * The payload is the address of the format string, followed by the arguments:
+ * 4 bytes (little endian) for integers and pointers, 8 bytes for 64-bit integers
+ * and doubles. String arguments in flash are sent as 0x01 and the address, other
+ * strings as 0x02 and the characters including the terminating zero.
+ * COBS encoding removes zero bytes from the payload, so the frame can be passed
+ * to the vprintf-like output function as a "%s" argument.
+ */
+#define LOG_BINARY_FRAME_HEADER_LEN 3
+#if CONFIG_LOG_ASYNC && CONFIG_LOG_ASYNC_MAX_LINE_LEN < 245
+// frames must not be truncated by log_async_write
+#define LOG_BINARY_MAX_PAYLOAD (CONFIG_LOG_ASYNC_MAX_LINE_LEN - LOG_BINARY_FRAME_HEADER_LEN - 2)
+#else
+#define LOG_BINARY_MAX_PAYLOAD 240
+#endif
+// header, one COBS code byte (the payload is shorter than a COBS block), payload, zero
+#define LOG_BINARY_FRAME_SIZE (LOG_BINARY_FRAME_HEADER_LEN + 1 + LOG_BINARY_MAX_PAYLOAD + 1)
+
+static bool log_binary_encode(char* frame, const char* format, va_list list);
+#endif
+
+#if CONFIG_LOG_BINARY || CONFIG_LOG_RATE_LIMIT
+static void log_output(const char* format, ...);
+#endif
+static void log_output_v(const char* format, va_list list);
 static inline bool get_cached_log_level(const char* tag, esp_log_level_t* level);
 static inline bool get_uncached_log_level(const char* tag, esp_log_level_t* level);
 static inline void add_to_cache(const char* tag, esp_log_level_t level);
@@ -205,16 +268,398 @@ void IRAM_ATTR esp_log_write(esp_log_level_t level,
         ++s_log_cache_misses;
 #endif
     }
+    bool output = should_output(level, level_for_tag);
+#if CONFIG_LOG_RATE_LIMIT
+    uint32_t suppressed = 0;
+    if (output) {
+        output = log_rate_take(tag, &suppressed);
+    }
+#endif
     xSemaphoreGive(s_log_mutex);
-    if (!should_output(level, level_for_tag)) {
+    if (!output) {
         return;
     }
+#if CONFIG_LOG_RATE_LIMIT
+    if (suppressed != 0) {
+        log_output(LOG_FORMAT(W, "%u messages suppressed"), esp_log_timestamp(), tag, suppressed);
+    }
+#endif
 
     va_list list;
     va_start(list, format);
+#if CONFIG_LOG_BINARY
+    char frame[LOG_BINARY_FRAME_SIZE];
+    if (log_binary_encode(frame, format, list)) {
+        va_end(list);
+        log_output("%s", frame);
+        return;
+    }
+#endif
+    log_output_v(format, list);
+    va_end(list);
+}
+
+static void log_output_v(const char* format, va_list list)
+{
+#if CONFIG_LOG_ASYNC
+    if (log_async_write(format, list)) {
+        return;
+    }
+#endif
     (*s_log_print_func)(format, list);
+}
+
+#if CONFIG_LOG_BINARY || CONFIG_LOG_RATE_LIMIT
+static void log_output(const char* format, ...)
+{
+    va_list list;
+    va_start(list, format);
+    log_output_v(format, list);
     va_end(list);
 }
+#endif
+
+#if CONFIG_LOG_RATE_LIMIT
+/* Take a token from the bucket of the tag, refilling it for the time since
+ * the last message first. Called with s_log_mutex taken.
+ */
+static inline bool log_rate_take(const char* tag, uint32_t* suppressed)
+{
+    const uint32_t now = esp_log_timestamp();
+    // Find the bucket of the tag, or reuse the one which was idle for the longest time
+    log_rate_entry_t* entry = &s_log_rate[0];
+    for (int i = 0; i < CONFIG_LOG_RATE_LIMIT_TAGS; ++i) {
+        if (s_log_rate[i].tag == tag) {
+            entry = &s_log_rate[i];
+            break;
+        }
+        if (s_log_rate[i].tag == NULL || now - s_log_rate[i].last > now - entry->last) {
+            entry = &s_log_rate[i];
+        }
+    }
+    if (entry->tag != tag) {
+        *entry = (log_rate_entry_t) {
+            .tag = tag,
+            .tokens = LOG_RATE_LIMIT_BURST_TOKENS,
+        };
+    } else {
+        const uint32_t elapsed = now - entry->last;
+        if (elapsed >= LOG_RATE_LIMIT_BURST_TOKENS / CONFIG_LOG_RATE_LIMIT_PER_SEC) {
+            entry->tokens = LOG_RATE_LIMIT_BURST_TOKENS;
+        } else {
+            entry->tokens = MIN(entry->tokens + elapsed * CONFIG_LOG_RATE_LIMIT_PER_SEC, LOG_RATE_LIMIT_BURST_TOKENS);
+        }
+    }
+    entry->last = now;
+    if (entry->tokens < 1000) {
+        ++entry->suppressed;
+        return false;
+    }
+    entry->tokens -= 1000;
+    *suppressed = entry->suppressed;
+    entry->suppressed = 0;
+    return true;
+}
+#endif // CONFIG_LOG_RATE_LIMIT
+
+bool esp_log_ratelimit_check(esp_log_ratelimit_t* state, uint32_t interval_ms, uint32_t* suppressed)
+{
+    const uint32_t now = esp_log_timestamp();
+    portENTER_CRITICAL(&s_log_ratelimit_lock);
+    const bool output = !state->started || now - state->last >= interval_ms;
+    if (output) {
+        *suppressed = state->suppressed;
+        state->suppressed = 0;
+        state->last = now;
+        state->started = true;
+    } else {
+        ++state->suppressed;
+    }
+    portEXIT_CRITICAL(&s_log_ratelimit_lock);
+    return output;
+}
+
+#if CONFIG_LOG_BINARY
+
+static inline bool log_binary_put(uint8_t* payload, size_t* len, const void* data, size_t size)
+{
+    if (*len + size > LOG_BINARY_MAX_PAYLOAD) {
+        return false;
+    }
+    memcpy(payload + *len, data, size);
+    *len += size;
+    return true;
+}
+
+static bool log_binary_put_args(uint8_t* payload, size_t* len, const char* format, va_list list)
+{
+    for (const char* p = format; *p != 0; ++p) {
+        if (*p != '%') {
+            continue;
+        }
+        ++p;
+        if (*p == '%') {
+            continue;
+        }
+        while (*p != 0 && strchr("-+ #0", *p) != NULL) {
+            ++p;
+        }
+        if (*p == '*') {
+            int width = va_arg(list, int);
+            if (!log_binary_put(payload, len, &width, sizeof(width))) {
+                return false;
+            }
+            ++p;
+        }
+        while (isdigit((int) *p)) {
+            ++p;
+        }
+        if (*p == '.') {
+            ++p;
+            if (*p == '*') {
+                int precision = va_arg(list, int);
+                if (!log_binary_put(payload, len, &precision, sizeof(precision))) {
+                    return false;
+                }
+                ++p;
+            }
+            while (isdigit((int) *p)) {
+                ++p;
+            }
+        }
+        bool is_64bit = false;
+        bool is_long_double = false;
+        while (*p != 0 && strchr("hlLjzt", *p) != NULL) {
+            is_64bit = is_64bit || *p == 'j' || (*p == 'l' && p[1] == 'l');
+            is_long_double = is_long_double || *p == 'L';
+            p += (*p == 'l' && p[1] == 'l') ? 2 : 1;
+        }
+
+        bool ok;
+        switch (*p) {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+            if (is_64bit) {
+                long long value = va_arg(list, long long);
+                ok = log_binary_put(payload, len, &value, sizeof(value));
+            } else {
+                int value = va_arg(list, int);
+                ok = log_binary_put(payload, len, &value, sizeof(value));
+            }
+            break;
+        case 'p': {
+            uint32_t value = (uint32_t) va_arg(list, void*);
+            ok = log_binary_put(payload, len, &value, sizeof(value));
+            break;
+        }
+        case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A': {
+            double value = is_long_double ? (double) va_arg(list, long double) : va_arg(list, double);
+            ok = log_binary_put(payload, len, &value, sizeof(value));
+            break;
+        }
+        case 's': {
+            const char* str = va_arg(list, const char*);
+            if (str == NULL || esp_ptr_in_drom(str)) {
+                const uint8_t kind = 1;
+                uint32_t addr = (uint32_t) str;
+                ok = log_binary_put(payload, len, &kind, sizeof(kind)) &&
+                     log_binary_put(payload, len, &addr, sizeof(addr));
+            } else {
+                const uint8_t kind = 2;
+                ok = log_binary_put(payload, len, &kind, sizeof(kind)) &&
+                     log_binary_put(payload, len, str, strlen(str) + 1);
+            }
+            break;
+        }
+        case 'n':
+            va_arg(list, void*);
+            ok = true;
+            break;
+        default:
+            // unsupported conversion, or the end of the string
+            ok = false;
+            break;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Builds a binary frame for the message, returns false if the message has to be
+ * output as text instead (format string not in flash, arguments too long).
+ */
+static bool log_binary_encode(char* frame, const char* format, va_list list)
+{
+    if (!esp_ptr_in_drom(format)) {
+        return false;
+    }
+    // The payload is built one byte behind the place of the COBS code byte at the
+    // start of the encoded data, so that it can be encoded in place: the encoded
+    // byte is never written ahead of the payload byte which is being read.
+    uint8_t* encoded = (uint8_t*) frame + LOG_BINARY_FRAME_HEADER_LEN;
+    uint8_t* payload = encoded + 1;
+    size_t len = 0;
+    uint32_t format_addr = (uint32_t) format;
+    log_binary_put(payload, &len, &format_addr, sizeof(format_addr));
+
+    va_list list_copy;
+    va_copy(list_copy, list);
+    bool ok = log_binary_put_args(payload, &len, format, list_copy);
+    va_end(list_copy);
+    if (!ok) {
+        return false;
+    }
+
+    size_t code_pos = 0;
+    size_t out = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < len; ++i) {
+        const uint8_t b = payload[i];
+        if (b == 0) {
+            encoded[code_pos] = code;
+            code_pos = out++;
+            code = 1;
+        } else {
+            encoded[out++] = b;
+            ++code;
+        }
+    }
+    encoded[code_pos] = code;
+
+    frame[0] = '\033';
+    frame[1] = 'b';
+    frame[2] = (char) out;
+    frame[LOG_BINARY_FRAME_HEADER_LEN + out] = 0;
+    return true;
+}
+#endif // CONFIG_LOG_BINARY
+
+#if CONFIG_LOG_ASYNC
+static void log_print(const char* format, ...)
+{
+    va_list list;
+    va_start(list, format);
+    (*s_log_print_func)(format, list);
+    va_end(list);
+}
+
+static void log_async_task(void* arg)
+{
+    uint32_t dropped_reported = 0;
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        // Take messages from the buffers of both CPUs in turns until they are all empty
+        bool received;
+        do {
+            received = false;
+            for (int i = 0; i < portNUM_PROCESSORS; ++i) {
+                size_t size;
+                char* item = (char*) xRingbufferReceive(s_log_async_buf[i], &size, 0);
+                if (item != NULL) {
+                    log_print("%s", item);
+                    vRingbufferReturnItem(s_log_async_buf[i], item);
+                    received = true;
+                }
+            }
+        } while (received);
+
+        portENTER_CRITICAL(&s_log_async_lock);
+        uint32_t dropped = s_log_async_dropped;
+        portEXIT_CRITICAL(&s_log_async_lock);
+        if (dropped != dropped_reported) {
+            log_print(LOG_FORMAT(W, "%u messages dropped"), esp_log_timestamp(), "log", dropped - dropped_reported);
+            dropped_reported = dropped;
+        }
+    }
+}
+
+static bool log_async_start()
+{
+    if (xSemaphoreTake(s_log_mutex, MAX_MUTEX_WAIT_TICKS) == pdFALSE) {
+        return false;
+    }
+    if (s_log_async_task == NULL && !s_log_async_failed) {
+        bool ok = true;
+        for (int i = 0; i < portNUM_PROCESSORS; ++i) {
+            s_log_async_buf[i] = xRingbufferCreate(CONFIG_LOG_ASYNC_BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT);
+            ok = ok && s_log_async_buf[i] != NULL;
+        }
+        if (ok) {
+            ok = xTaskCreate(log_async_task, "log", CONFIG_LOG_ASYNC_TASK_STACK_SIZE, NULL,
+                    CONFIG_LOG_ASYNC_TASK_PRIORITY, &s_log_async_task) == pdPASS;
+        }
+        if (!ok) {
+            // keep writing synchronously
+            for (int i = 0; i < portNUM_PROCESSORS; ++i) {
+                if (s_log_async_buf[i] != NULL) {
+                    vRingbufferDelete(s_log_async_buf[i]);
+                    s_log_async_buf[i] = NULL;
+                }
+            }
+            s_log_async_task = NULL;
+            s_log_async_failed = true;
+        }
+    }
+    xSemaphoreGive(s_log_mutex);
+    return s_log_async_task != NULL;
+}
+
+/* Format the message into the ring buffer of the current CPU. Returns false if
+ * the message has to be written synchronously.
+ */
+static bool log_async_write(const char* format, va_list list)
+{
+    if (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING) {
+        return false;
+    }
+    if (s_log_async_task == NULL && !log_async_start()) {
+        return false;
+    }
+    if (xTaskGetCurrentTaskHandle() == s_log_async_task) {
+        // logging from the output function
+        return false;
+    }
+
+    va_list list_copy;
+    va_copy(list_copy, list);
+    const int len = vsnprintf(NULL, 0, format, list_copy);
+    va_end(list_copy);
+    if (len < 0) {
+        return true;
+    }
+    const size_t size = MIN(len + 1, CONFIG_LOG_ASYNC_MAX_LINE_LEN);
+
+    RingbufHandle_t buf = s_log_async_buf[xPortGetCoreID()];
+    char* item;
+    if (xRingbufferSendAcquire(buf, (void**) &item, size, 0) != pdTRUE) {
+        portENTER_CRITICAL(&s_log_async_lock);
+        ++s_log_async_dropped;
+        portEXIT_CRITICAL(&s_log_async_lock);
+        return true;
+    }
+    vsnprintf(item, size, format, list);
+    if (size < (size_t) len + 1) {
+        // truncated, keep the line break
+        item[size - 2] = '\n';
+    }
+    xRingbufferSendComplete(buf, item);
+    xTaskNotifyGive(s_log_async_task);
+    return true;
+}
+#endif // CONFIG_LOG_ASYNC
+
+uint32_t esp_log_async_dropped_count()
+{
+#if CONFIG_LOG_ASYNC
+    portENTER_CRITICAL(&s_log_async_lock);
+    uint32_t dropped = s_log_async_dropped;
+    portEXIT_CRITICAL(&s_log_async_lock);
+    return dropped;
+#else
+    return 0;
+#endif
+}
 
 static inline bool get_cached_log_level(const char* tag, esp_log_level_t* level)
 {
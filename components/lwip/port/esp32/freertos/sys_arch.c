@@ -39,6 +39,7 @@
 #include "lwip/mem.h"
 #include "arch/sys_arch.h"
 #include "lwip/stats.h"
+#include "lwip/tcpip.h"
 #include "esp_log.h"
 
 /* This is the number of threads that can be started with sys_thread_new() */
@@ -541,6 +542,20 @@ void sys_thread_sem_deinit(void)
   }
 }
 
+/*
+ * assert that the calling task holds the tcpip core lock
+ */
+void sys_check_core_locking(void)
+{
+#if LWIP_TCPIP_CORE_LOCKING
+  /* The lock doesn't exist before tcpip_init(), when there is only one task using lwIP */
+  if (lock_tcpip_core != NULL) {
+    LWIP_ASSERT("Required to lock TCPIP core functionality!",
+                xSemaphoreGetMutexHolder(lock_tcpip_core) == xTaskGetCurrentTaskHandle());
+  }
+#endif
+}
+
 void sys_delay_ms(uint32_t ms)
 {
   vTaskDelay(ms / portTICK_PERIOD_MS);
@@ -89,6 +89,7 @@ void sys_delay_ms(uint32_t ms);
 sys_sem_t* sys_thread_sem_init(void);
 void sys_thread_sem_deinit(void);
 sys_sem_t* sys_thread_sem_get(void);
+void sys_check_core_locking(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,41 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _LWIP_CHKSUM_H_
+#define _LWIP_CHKSUM_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Internet checksum of up to 65535 bytes, calculated on 32-bit words.
+ * Same result as lwip_standard_chksum(): the 16-bit one's complement sum,
+ * not inverted, in network byte order.
+ */
+uint16_t lwip_fast_chksum(const void *dataptr, int len);
+
+/**
+ * Copies len bytes from src to dst and returns their checksum, like
+ * lwip_fast_chksum(), in one pass when src and dst are equally aligned.
+ */
+uint16_t lwip_fast_chksum_copy(void *dst, const void *src, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LWIP_CHKSUM_H_ */
@@ -0,0 +1,53 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _LWIP_SLAB_H_
+#define _LWIP_SLAB_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Size of the buffers in the pool, enough for a full sized frame with its pbuf header */
+#define LWIP_SLAB_BLOCK_SIZE    1600
+
+typedef struct {
+    uint32_t total;         /*!< Number of buffers in the pool */
+    uint32_t in_use;        /*!< Number of buffers currently allocated */
+    uint32_t high_water;    /*!< Highest number of buffers allocated at the same time */
+    uint32_t overflows;     /*!< Number of packet sized allocations made from the heap because the pool was empty */
+} lwip_slab_stats_t;
+
+/**
+ * Allocators lwIP uses instead of malloc(), calloc() and free() with
+ * CONFIG_LWIP_PBUF_SLAB. Packet sized allocations are served from a pool
+ * of buffers in internal RAM, the others from the heap.
+ */
+void *lwip_slab_malloc(size_t size);
+void *lwip_slab_calloc(size_t count, size_t size);
+void lwip_slab_free(void *ptr);
+
+/**
+ * Gets the usage statistics of the pool.
+ */
+void lwip_slab_get_stats(lwip_slab_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LWIP_SLAB_H_ */
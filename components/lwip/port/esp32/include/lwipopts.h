@@ -40,6 +40,7 @@
 #include <sys/ioctl.h>
 #include <sys/types.h>
 #include <sys/select.h>
+#include <sys/uio.h>
 #include "esp_task.h"
 #include "esp_system.h"
 #include "sdkconfig.h"
@@ -93,6 +94,14 @@
 */
 #define MEMP_MEM_MALLOC                 1
 
+#if CONFIG_LWIP_PBUF_SLAB
+#include "lwip_slab.h"
+/* Serve packet sized allocations from a pool in internal RAM */
+#define mem_clib_malloc                 lwip_slab_malloc
+#define mem_clib_calloc                 lwip_slab_calloc
+#define mem_clib_free                   lwip_slab_free
+#endif
+
 /**
  * MEM_ALIGNMENT: should be set to the alignment of the CPU
  *    4 byte alignment -> #define MEM_ALIGNMENT 4
@@ -496,10 +505,28 @@
    ----------------------------------------------
 */
 /**
- * LWIP_TCPIP_CORE_LOCKING: (EXPERIMENTAL!)
- * Don't use it if you're not an active lwIP project member
+ * LWIP_TCPIP_CORE_LOCKING: Sockets and netconns lock the core with a mutex
+ * and call it directly, instead of posting messages to the tcpip thread.
  */
+#ifdef CONFIG_LWIP_TCPIP_CORE_LOCKING
+#define LWIP_TCPIP_CORE_LOCKING         1
+#else
 #define LWIP_TCPIP_CORE_LOCKING         0
+#endif
+
+/**
+ * LWIP_TCPIP_CORE_LOCKING_INPUT: tcpip_input() processes received packets
+ * with the core locked, instead of posting them to the tcpip thread.
+ */
+#ifdef CONFIG_LWIP_TCPIP_CORE_LOCKING_INPUT
+#define LWIP_TCPIP_CORE_LOCKING_INPUT   1
+#else
+#define LWIP_TCPIP_CORE_LOCKING_INPUT   0
+#endif
+
+#ifdef CONFIG_LWIP_CHECK_THREAD_SAFETY
+#define LWIP_ASSERT_CORE_LOCKED()       sys_check_core_locking()
+#endif
 
 /*
    ------------------------------------
@@ -814,6 +841,14 @@ enum {
 #define CHECKSUM_CHECK_UDP              0
 #define CHECKSUM_CHECK_IP               0
 
+#if CONFIG_LWIP_FAST_CHKSUM
+#include "lwip_chksum.h"
+#define LWIP_CHKSUM                     lwip_fast_chksum
+/* Checksum the data of TCP writes while copying it into the segments */
+#define LWIP_CHECKSUM_ON_COPY           1
+#define LWIP_CHKSUM_COPY(dst, src, len) lwip_fast_chksum_copy(dst, src, len)
+#endif
+
 #define LWIP_NETCONN_FULLDUPLEX         1
 #define LWIP_NETCONN_SEM_PER_THREAD     1
 
@@ -0,0 +1,43 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _NETIF_RX_BATCH_H_
+#define _NETIF_RX_BATCH_H_
+
+#include "lwip/err.h"
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Like tcpip_inpkt(), but packets received while the TCP/IP task hasn't
+ * processed the previous ones yet join them instead of being posted to
+ * its mailbox one by one.
+ */
+err_t netif_rx_batch_inpkt(struct pbuf *p, struct netif *inp, netif_input_fn input_fn);
+
+/**
+ * Like tcpip_input(), with the batching of netif_rx_batch_inpkt(). Can be
+ * passed as the input function to netif_add().
+ */
+err_t netif_rx_batch_input(struct pbuf *p, struct netif *inp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _NETIF_RX_BATCH_H_ */
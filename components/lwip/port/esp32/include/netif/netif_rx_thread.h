@@ -0,0 +1,44 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _NETIF_RX_THREAD_H_
+#define _NETIF_RX_THREAD_H_
+
+#include "lwip/err.h"
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Creates the receive task of the netif, if it doesn't have one yet.
+ * Pass netif_rx_thread_input() as the input function to netif_add().
+ * The task passes the packets to input_fn, or to ethernet_input() or
+ * ip_input() if input_fn is NULL.
+ */
+err_t netif_rx_thread_start(struct netif *netif, netif_input_fn input_fn);
+
+/**
+ * Queues a received packet to the receive task of its netif, which passes
+ * it to the stack with the core locked.
+ */
+err_t netif_rx_thread_input(struct pbuf *p, struct netif *inp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _NETIF_RX_THREAD_H_ */
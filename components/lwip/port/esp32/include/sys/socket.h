@@ -31,3 +31,34 @@
  */
 
 #include "lwip/sockets.h"
+
+#ifndef _ESP_SYS_SOCKET_MMSG_H_
+#define _ESP_SYS_SOCKET_MMSG_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MSG_WAITFORONE
+#define MSG_WAITFORONE  0x10000 /* recvmmsg(): block for the first message only */
+#endif
+
+/** A message of recvmmsg() or sendmmsg() */
+struct mmsghdr {
+  struct msghdr msg_hdr;  /* Message */
+  unsigned int msg_len;   /* Number of bytes received or sent */
+};
+
+int lwip_recvmmsg(int s, struct mmsghdr *msgvec, unsigned int vlen, int flags, struct timeval *timeout);
+int lwip_sendmmsg(int s, struct mmsghdr *msgvec, unsigned int vlen, int flags);
+
+#if LWIP_COMPAT_SOCKETS
+#define recvmmsg(s,msgvec,vlen,flags,timeout) lwip_recvmmsg(s,msgvec,vlen,flags,timeout)
+#define sendmmsg(s,msgvec,vlen,flags)         lwip_sendmmsg(s,msgvec,vlen,flags)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_SYS_SOCKET_MMSG_H_ */
@@ -0,0 +1,125 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "lwip_chksum.h"
+
+/* Xtensa has no add with carry, so each 32-bit word is added as two halves
+ * instead: the 32-bit sum can't overflow for less than 128KB of data. */
+#define CHKSUM_ADD_WORD(sum, w)     ((sum) + ((w) & 0xffff) + ((w) >> 16))
+#define CHKSUM_FOLD(sum)            (((sum) >> 16) + ((sum) & 0xffff))
+#define CHKSUM_SWAP(w)              ((((w) & 0xff) << 8) | (((w) & 0xff00) >> 8))
+
+static inline __attribute__((always_inline))
+uint16_t chksum(uint8_t *db, const uint8_t *pb, int len, const bool copy)
+{
+    uint32_t sum = 0;
+    uint16_t t = 0;
+    uint16_t h;
+    /* Sum the halfwords in memory order and swap the result if they were odd aligned */
+    bool odd = ((uintptr_t)pb & 1);
+
+    if (odd && len > 0) {
+        ((uint8_t *)&t)[1] = *pb;
+        if (copy) {
+            *db++ = *pb;
+        }
+        pb++;
+        len--;
+    }
+    if (((uintptr_t)pb & 2) && len > 1) {
+        h = *(const uint16_t *)pb;
+        if (copy) {
+            *(uint16_t *)db = h;
+            db += 2;
+        }
+        sum += h;
+        pb += 2;
+        len -= 2;
+    }
+
+    const uint32_t *pl = (const uint32_t *)pb;
+    uint32_t *dl = (uint32_t *)db;
+    while (len >= 16) {
+        uint32_t w0 = pl[0];
+        uint32_t w1 = pl[1];
+        uint32_t w2 = pl[2];
+        uint32_t w3 = pl[3];
+        if (copy) {
+            dl[0] = w0;
+            dl[1] = w1;
+            dl[2] = w2;
+            dl[3] = w3;
+            dl += 4;
+        }
+        sum = CHKSUM_ADD_WORD(sum, w0);
+        sum = CHKSUM_ADD_WORD(sum, w1);
+        sum = CHKSUM_ADD_WORD(sum, w2);
+        sum = CHKSUM_ADD_WORD(sum, w3);
+        pl += 4;
+        len -= 16;
+    }
+    while (len >= 4) {
+        uint32_t w = *pl++;
+        if (copy) {
+            *dl++ = w;
+        }
+        sum = CHKSUM_ADD_WORD(sum, w);
+        len -= 4;
+    }
+
+    pb = (const uint8_t *)pl;
+    db = (uint8_t *)dl;
+    if (len >= 2) {
+        h = *(const uint16_t *)pb;
+        if (copy) {
+            *(uint16_t *)db = h;
+            db += 2;
+        }
+        sum += h;
+        pb += 2;
+        len -= 2;
+    }
+    if (len > 0) {
+        ((uint8_t *)&t)[0] = *pb;
+        if (copy) {
+            *db = *pb;
+        }
+    }
+    sum += t;
+
+    sum = CHKSUM_FOLD(sum);
+    sum = CHKSUM_FOLD(sum);
+    if (odd) {
+        sum = CHKSUM_SWAP(sum);
+    }
+    return (uint16_t)sum;
+}
+
+uint16_t lwip_fast_chksum(const void *dataptr, int len)
+{
+    return chksum(NULL, (const uint8_t *)dataptr, len, false);
+}
+
+uint16_t lwip_fast_chksum_copy(void *dst, const void *src, uint16_t len)
+{
+    if (((uintptr_t)dst ^ (uintptr_t)src) & 3) {
+        /* The words can't be stored where they were loaded from */
+        memcpy(dst, src, len);
+        return chksum(NULL, (const uint8_t *)src, len, false);
+    }
+    return chksum((uint8_t *)dst, (const uint8_t *)src, len, true);
+}
@@ -0,0 +1,83 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <errno.h>
+#include <stddef.h>
+#include <sys/socket.h>
+
+#include "lwip/sys.h"
+
+int lwip_recvmmsg(int s, struct mmsghdr *msgvec, unsigned int vlen, int flags, struct timeval *timeout)
+{
+    u32_t start = sys_now();
+    u32_t timeout_ms = 0;
+    unsigned int count = 0;
+
+    if (msgvec == NULL) {
+        errno = EFAULT;
+        return -1;
+    }
+    if (timeout) {
+        if (timeout->tv_sec < 0 || timeout->tv_usec < 0 || timeout->tv_usec >= 1000000) {
+            errno = EINVAL;
+            return -1;
+        }
+        timeout_ms = timeout->tv_sec * 1000 + timeout->tv_usec / 1000;
+    }
+
+    int msg_flags = flags & ~MSG_WAITFORONE;
+    while (count < vlen) {
+        ssize_t len = lwip_recvmsg(s, &msgvec[count].msg_hdr, msg_flags);
+        if (len < 0) {
+            /* Return the received messages, a lasting error is reported by the next call */
+            if (count == 0) {
+                return -1;
+            }
+            break;
+        }
+        msgvec[count++].msg_len = len;
+
+        if (flags & MSG_WAITFORONE) {
+            /* Take the messages that are already queued */
+            msg_flags |= MSG_DONTWAIT;
+        }
+        /* Like Linux, the timeout is only checked after each message */
+        if (timeout && sys_now() - start >= timeout_ms) {
+            break;
+        }
+    }
+    return count;
+}
+
+int lwip_sendmmsg(int s, struct mmsghdr *msgvec, unsigned int vlen, int flags)
+{
+    unsigned int count = 0;
+
+    if (msgvec == NULL) {
+        errno = EFAULT;
+        return -1;
+    }
+
+    while (count < vlen) {
+        ssize_t len = lwip_sendmsg(s, &msgvec[count].msg_hdr, flags);
+        if (len < 0) {
+            if (count == 0) {
+                return -1;
+            }
+            break;
+        }
+        msgvec[count++].msg_len = len;
+    }
+    return count;
+}
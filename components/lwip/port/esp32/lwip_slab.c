@@ -0,0 +1,130 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
+
+#include "lwip_slab.h"
+
+#if CONFIG_LWIP_PBUF_SLAB
+
+#define LWIP_SLAB_NUM           CONFIG_LWIP_PBUF_SLAB_NUM
+/* Smaller allocations would waste most of a buffer, leave them to the heap */
+#define LWIP_SLAB_MIN_SIZE      (LWIP_SLAB_BLOCK_SIZE / 2)
+
+typedef union lwip_slab_block {
+    union lwip_slab_block *next;
+    uint8_t data[LWIP_SLAB_BLOCK_SIZE];
+} lwip_slab_block_t;
+
+static lwip_slab_block_t s_blocks[LWIP_SLAB_NUM];
+static lwip_slab_block_t *s_free_list;
+static bool s_initialized;
+static lwip_slab_stats_t s_stats;
+static portMUX_TYPE s_slab_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static inline bool lwip_slab_owns(const void *ptr)
+{
+    return (const uint8_t *)ptr >= (const uint8_t *)s_blocks
+           && (const uint8_t *)ptr < (const uint8_t *)(s_blocks + LWIP_SLAB_NUM);
+}
+
+/* Must be called in the critical section */
+static void lwip_slab_init(void)
+{
+    for (int i = 0; i < LWIP_SLAB_NUM; i++) {
+        s_blocks[i].next = (i + 1 < LWIP_SLAB_NUM) ? &s_blocks[i + 1] : NULL;
+    }
+    s_free_list = &s_blocks[0];
+    s_initialized = true;
+}
+
+static void *lwip_slab_overflow_malloc(size_t size)
+{
+#if CONFIG_LWIP_PBUF_SLAB_SPIRAM
+    void *ptr = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (ptr) {
+        return ptr;
+    }
+#endif
+    return malloc(size);
+}
+
+void *lwip_slab_malloc(size_t size)
+{
+    lwip_slab_block_t *block = NULL;
+
+    if (size < LWIP_SLAB_MIN_SIZE || size > LWIP_SLAB_BLOCK_SIZE) {
+        return malloc(size);
+    }
+
+    portENTER_CRITICAL(&s_slab_mux);
+    if (!s_initialized) {
+        lwip_slab_init();
+    }
+    block = s_free_list;
+    if (block) {
+        s_free_list = block->next;
+        if (++s_stats.in_use > s_stats.high_water) {
+            s_stats.high_water = s_stats.in_use;
+        }
+    } else {
+        s_stats.overflows++;
+    }
+    portEXIT_CRITICAL(&s_slab_mux);
+
+    return block ? (void *)block : lwip_slab_overflow_malloc(size);
+}
+
+void *lwip_slab_calloc(size_t count, size_t size)
+{
+    if (size && count > SIZE_MAX / size) {
+        return NULL;
+    }
+    void *ptr = lwip_slab_malloc(count * size);
+    if (ptr) {
+        memset(ptr, 0, count * size);
+    }
+    return ptr;
+}
+
+void lwip_slab_free(void *ptr)
+{
+    if (!lwip_slab_owns(ptr)) {
+        free(ptr);
+        return;
+    }
+
+    lwip_slab_block_t *block = (lwip_slab_block_t *)ptr;
+    portENTER_CRITICAL(&s_slab_mux);
+    block->next = s_free_list;
+    s_free_list = block;
+    s_stats.in_use--;
+    portEXIT_CRITICAL(&s_slab_mux);
+}
+
+void lwip_slab_get_stats(lwip_slab_stats_t *stats)
+{
+    portENTER_CRITICAL(&s_slab_mux);
+    *stats = s_stats;
+    stats->total = LWIP_SLAB_NUM;
+    portEXIT_CRITICAL(&s_slab_mux);
+}
+
+#endif /* CONFIG_LWIP_PBUF_SLAB */
@@ -21,6 +21,10 @@
 #include "esp_interface.h"
 #include "tcpip_adapter.h"
 #include "netif/dhcp_state.h"
+#include "sdkconfig.h"
+#if CONFIG_ESP32_WIFI_FAST_CONNECT
+#include "esp_private/wifi_fast_connect.h"
+#endif
 
 #define DHCP_NAMESPACE "dhcp_state"
 #define VALID_NETIF_ID(id) ((id < ESP_IF_MAX) && (id != ESP_IF_WIFI_AP))
@@ -41,6 +45,13 @@ bool dhcp_ip_addr_restore(void *netif)
 
     if(VALID_NETIF_ID(netif_id)) {
         uint32_t *ip_addr = &dhcp->offered_ip_addr.addr;
+#if CONFIG_ESP32_WIFI_FAST_CONNECT
+        /* The lease kept in RTC memory is for the AP the station is connected to */
+        if (netif_id == ESP_IF_WIFI_STA && wifi_fast_connect_get_lease(ip_addr)) {
+            restored_ip_addr[netif_id] = *ip_addr;
+            return true;
+        }
+#endif
         if (nvs_open(DHCP_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK) {
             if (nvs_get_u32(nvs, interface_key[netif_id], ip_addr) == ESP_OK) {
                 restored_ip_addr[netif_id] = *ip_addr;
@@ -61,6 +72,11 @@ void dhcp_ip_addr_store(void *netif)
     esp_interface_t netif_id = tcpip_adapter_get_esp_if(net);
 
     if(VALID_NETIF_ID(netif_id)) {
+#if CONFIG_ESP32_WIFI_FAST_CONNECT
+        if (netif_id == ESP_IF_WIFI_STA) {
+            wifi_fast_connect_set_lease(ip_addr);
+        }
+#endif
         if (restored_ip_addr[netif_id] != ip_addr) {
             if (nvs_open(DHCP_NAMESPACE, NVS_READWRITE, &nvs) == ESP_OK) {
                 nvs_set_u32(nvs, interface_key[netif_id], ip_addr);
@@ -78,6 +94,11 @@ void dhcp_ip_addr_erase(void *netif)
     esp_interface_t netif_id = tcpip_adapter_get_esp_if(net);
 
     if(VALID_NETIF_ID(netif_id)) {
+#if CONFIG_ESP32_WIFI_FAST_CONNECT
+        if (netif_id == ESP_IF_WIFI_STA) {
+            wifi_fast_connect_set_lease(0);
+        }
+#endif
         if (nvs_open(DHCP_NAMESPACE, NVS_READWRITE, &nvs) == ESP_OK) {
             nvs_erase_key(nvs, interface_key[netif_id]);
             nvs_commit(nvs);
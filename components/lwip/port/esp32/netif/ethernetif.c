@@ -55,6 +55,9 @@
 #define IFNAME0 'e'
 #define IFNAME1 'n'
 
+/* Longest pbuf chain that is gathered by the driver without flattening it first */
+#define ETHERNETIF_TX_MAX_SEGMENTS 8
+
 /**
  * In this function, the hardware should be initialized.
  * Called from ethernetif_init().
@@ -83,7 +86,7 @@ ethernet_low_level_init(struct netif *netif)
 #endif
 #endif
 
-#ifndef CONFIG_EMAC_L2_TO_L3_RX_BUF_MODE
+#if !defined(CONFIG_EMAC_L2_TO_L3_RX_BUF_MODE) || defined(CONFIG_EMAC_RX_BUF_SWAP)
   netif->l2_buffer_free_notify = esp_eth_free_rx_buf;
 #endif
 }
@@ -118,8 +121,18 @@ ethernet_low_level_output(struct netif *netif, struct pbuf *p)
 
   if (q->next == NULL) {
     ret = esp_eth_tx(q->payload, q->len);
+  } else if (pbuf_clen(p) <= ETHERNETIF_TX_MAX_SEGMENTS) {
+    /* Gather the chain into the DMA buffer, instead of flattening it into a new pbuf first */
+    esp_eth_tx_segment_t segments[ETHERNETIF_TX_MAX_SEGMENTS];
+    int count = 0;
+    for (; q != NULL; q = q->next) {
+      segments[count].buf = q->payload;
+      segments[count].len = q->len;
+      count++;
+    }
+    ret = esp_eth_tx_segments(segments, count);
   } else {
-    LWIP_DEBUGF(PBUF_DEBUG, ("low_level_output: pbuf is a list, application may has bug"));
+    LWIP_DEBUGF(PBUF_DEBUG, ("low_level_output: pbuf is a long list, application may has bug"));
     q = pbuf_alloc(PBUF_RAW_TX, p->tot_len, PBUF_RAM);
     if (q != NULL) {
       q->l2_owner = NULL;
@@ -149,56 +162,54 @@ ethernet_low_level_output(struct netif *netif, struct pbuf *p)
  * @param netif the lwip network interface structure for this ethernetif
  * @param buffer the ethernet buffer
  * @param len the len of buffer
+ * @param eb the buffer to free with esp_eth_free_rx_buf() when the packet is
+ *        freed, NULL if ethernet reuses the buffer after this call
  *
  * @note When CONFIG_EMAC_L2_TO_L3_RX_BUF_MODE is enabled, a copy of buffer
  *       will be made for high layer (LWIP) and ethernet is responsible for
- *       freeing the buffer. Otherwise, high layer and ethernet share the
- *       same buffer and high layer is responsible for freeing the buffer.
+ *       freeing the buffer, unless ethernet passes it with CONFIG_EMAC_RX_BUF_SWAP.
+ *       Otherwise, high layer and ethernet share the same buffer and high
+ *       layer is responsible for freeing the buffer.
  */
 void ESP_IRAM_ATTR
-ethernetif_input(struct netif *netif, void *buffer, uint16_t len)
+ethernetif_input(struct netif *netif, void *buffer, uint16_t len, void *eb)
 {
   struct pbuf *p;
 
-  if(buffer== NULL || !netif_is_up(netif)) {
 #ifndef CONFIG_EMAC_L2_TO_L3_RX_BUF_MODE
-    if (buffer) {
-      esp_eth_free_rx_buf(buffer);
-    }
+  eb = buffer;
 #endif
-    return;
-  }
 
-#ifdef CONFIG_EMAC_L2_TO_L3_RX_BUF_MODE
-  p = pbuf_alloc(PBUF_RAW, len, PBUF_RAM);
-  if (p == NULL) {
+  if(buffer== NULL || !netif_is_up(netif)) {
+    if (eb) {
+      esp_eth_free_rx_buf(eb);
+    }
     return;
   }
-  p->l2_owner = NULL;
-  memcpy(p->payload, buffer, len);
 
-/* full packet send to tcpip_thread to process */
-if (netif->input(p, netif) != ERR_OK) {
-  LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: IP input error\n"));
-  pbuf_free(p);
-}
-
-#else
-  p = pbuf_alloc(PBUF_RAW, len, PBUF_REF);
-  if (p == NULL){
-    esp_eth_free_rx_buf(buffer);
-    return;
+  if (eb == NULL) {
+    p = pbuf_alloc(PBUF_RAW, len, PBUF_RAM);
+    if (p == NULL) {
+      return;
+    }
+    p->l2_owner = NULL;
+    memcpy(p->payload, buffer, len);
+  } else {
+    p = pbuf_alloc(PBUF_RAW, len, PBUF_REF);
+    if (p == NULL){
+      esp_eth_free_rx_buf(eb);
+      return;
+    }
+    p->payload = buffer;
+    p->l2_owner = netif;
+    p->l2_buf = eb;
   }
-  p->payload = buffer;
-  p->l2_owner = netif;
-  p->l2_buf = buffer;
 
   /* full packet send to tcpip_thread to process */
-if (netif->input(p, netif) != ERR_OK) {
-  LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: IP input error\n"));
-  pbuf_free(p);
-}
-#endif
+  if (netif->input(p, netif) != ERR_OK) {
+    LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: IP input error\n"));
+    pbuf_free(p);
+  }
 }
 
 /**
@@ -0,0 +1,139 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "lwip/opt.h"
+#include "lwip/ip.h"
+#include "lwip/tcpip.h"
+#include "netif/ethernet.h"
+#include "netif/netif_rx_batch.h"
+
+#include "freertos/FreeRTOS.h"
+#include "sdkconfig.h"
+
+#if CONFIG_LWIP_NETIF_RX_BATCH
+
+/* Station, soft-AP and Ethernet */
+#define NETIF_RX_BATCH_MAX          3
+#define NETIF_RX_BATCH_QUEUE_SIZE   CONFIG_LWIP_NETIF_RX_BATCH_QUEUE_SIZE
+
+typedef struct {
+    struct pbuf     *p;
+    netif_input_fn  input_fn;
+} netif_rx_batch_entry_t;
+
+typedef struct {
+    struct netif            *netif;
+    bool                    posted;     /* The TCP/IP task has been asked to process the queue, it's empty otherwise */
+    uint16_t                head;
+    uint16_t                count;
+    netif_rx_batch_entry_t  queue[NETIF_RX_BATCH_QUEUE_SIZE];
+} netif_rx_batch_t;
+
+static netif_rx_batch_t s_rx_batches[NETIF_RX_BATCH_MAX];
+static portMUX_TYPE s_rx_batch_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/* Must be called in the critical section */
+static netif_rx_batch_t *netif_rx_batch_get(struct netif *netif)
+{
+    netif_rx_batch_t *free_batch = NULL;
+
+    for (int i = 0; i < NETIF_RX_BATCH_MAX; i++) {
+        if (s_rx_batches[i].netif == netif) {
+            return &s_rx_batches[i];
+        }
+        if (free_batch == NULL && s_rx_batches[i].netif == NULL) {
+            free_batch = &s_rx_batches[i];
+        }
+    }
+    if (free_batch) {
+        free_batch->netif = netif;
+    }
+    return free_batch;
+}
+
+/* Runs in the TCP/IP task, until the queue is empty */
+static void netif_rx_batch_process(void *ctx)
+{
+    netif_rx_batch_t *batch = (netif_rx_batch_t *)ctx;
+    netif_rx_batch_entry_t entry;
+
+    for (;;) {
+        portENTER_CRITICAL(&s_rx_batch_mux);
+        if (batch->count == 0) {
+            batch->posted = false;
+            portEXIT_CRITICAL(&s_rx_batch_mux);
+            return;
+        }
+        entry = batch->queue[batch->head];
+        batch->head = (batch->head + 1) % NETIF_RX_BATCH_QUEUE_SIZE;
+        batch->count--;
+        portEXIT_CRITICAL(&s_rx_batch_mux);
+
+        if (entry.input_fn(entry.p, batch->netif) != ERR_OK) {
+            pbuf_free(entry.p);
+        }
+    }
+}
+
+err_t netif_rx_batch_inpkt(struct pbuf *p, struct netif *inp, netif_input_fn input_fn)
+{
+    netif_rx_batch_t *batch;
+    bool post;
+
+    portENTER_CRITICAL(&s_rx_batch_mux);
+    batch = netif_rx_batch_get(inp);
+    if (batch == NULL) {
+        portEXIT_CRITICAL(&s_rx_batch_mux);
+        return tcpip_inpkt(p, inp, input_fn);
+    }
+    if (batch->count == NETIF_RX_BATCH_QUEUE_SIZE) {
+        portEXIT_CRITICAL(&s_rx_batch_mux);
+        return ERR_MEM;
+    }
+    netif_rx_batch_entry_t *entry = &batch->queue[(batch->head + batch->count) % NETIF_RX_BATCH_QUEUE_SIZE];
+    entry->p = p;
+    entry->input_fn = input_fn;
+    batch->count++;
+    post = !batch->posted;
+    batch->posted = true;
+    portEXIT_CRITICAL(&s_rx_batch_mux);
+
+    if (post && tcpip_try_callback(netif_rx_batch_process, batch) != ERR_OK) {
+        /* The queue was empty before p, as long as nothing was posted. The caller frees p. */
+        portENTER_CRITICAL(&s_rx_batch_mux);
+        batch->head = 0;
+        batch->count = 0;
+        batch->posted = false;
+        portEXIT_CRITICAL(&s_rx_batch_mux);
+        return ERR_MEM;
+    }
+    return ERR_OK;
+}
+
+static err_t netif_rx_batch_default_input(struct pbuf *p, struct netif *inp)
+{
+#if LWIP_ETHERNET
+    if (inp->flags & (NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET)) {
+        return ethernet_input(p, inp);
+    }
+#endif
+    return ip_input(p, inp);
+}
+
+err_t netif_rx_batch_input(struct pbuf *p, struct netif *inp)
+{
+    return netif_rx_batch_inpkt(p, inp, netif_rx_batch_default_input);
+}
+
+#endif /* CONFIG_LWIP_NETIF_RX_BATCH */
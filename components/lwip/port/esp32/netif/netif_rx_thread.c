@@ -0,0 +1,126 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+
+#include "lwip/opt.h"
+#include "lwip/ip.h"
+#include "lwip/sys.h"
+#include "lwip/tcpip.h"
+#include "netif/ethernet.h"
+#include "netif/netif_rx_thread.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+#if CONFIG_LWIP_NETIF_RX_THREADS
+
+/* Station, soft-AP and Ethernet */
+#define NETIF_RX_THREAD_MAX         3
+/* Packets passed to the stack per lock of the core */
+#define NETIF_RX_THREAD_BATCH       8
+
+typedef struct {
+    struct netif    *netif;
+    netif_input_fn  input_fn;
+    sys_mbox_t      mbox;
+} netif_rx_thread_t;
+
+static netif_rx_thread_t s_rx_threads[NETIF_RX_THREAD_MAX];
+
+static void netif_rx_thread_deliver(netif_rx_thread_t *rx, struct pbuf *p)
+{
+    struct netif *netif = rx->netif;
+    err_t err;
+
+    if (rx->input_fn) {
+        err = rx->input_fn(p, netif);
+    } else
+#if LWIP_ETHERNET
+    if (netif->flags & (NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET)) {
+        err = ethernet_input(p, netif);
+    } else
+#endif
+    {
+        err = ip_input(p, netif);
+    }
+    if (err != ERR_OK) {
+        pbuf_free(p);
+    }
+}
+
+static void netif_rx_thread(void *arg)
+{
+    netif_rx_thread_t *rx = (netif_rx_thread_t *)arg;
+    void *msg;
+
+    for (;;) {
+        sys_arch_mbox_fetch(&rx->mbox, &msg, 0);
+
+        /* Take the core once for the packets that queued up meanwhile */
+        LOCK_TCPIP_CORE();
+        int n = 0;
+        do {
+            netif_rx_thread_deliver(rx, (struct pbuf *)msg);
+        } while (++n < NETIF_RX_THREAD_BATCH && sys_arch_mbox_tryfetch(&rx->mbox, &msg) != SYS_MBOX_EMPTY);
+        UNLOCK_TCPIP_CORE();
+    }
+}
+
+err_t netif_rx_thread_start(struct netif *netif, netif_input_fn input_fn)
+{
+    netif_rx_thread_t *rx = NULL;
+
+    for (int i = 0; i < NETIF_RX_THREAD_MAX; i++) {
+        if (s_rx_threads[i].netif == netif) {
+            return ERR_OK;
+        }
+        if (rx == NULL && s_rx_threads[i].netif == NULL) {
+            rx = &s_rx_threads[i];
+        }
+    }
+    if (rx == NULL) {
+        return ERR_MEM;
+    }
+
+    if (sys_mbox_new(&rx->mbox, CONFIG_LWIP_NETIF_RX_THREAD_MBOX_SIZE) != ERR_OK) {
+        return ERR_MEM;
+    }
+
+    char name[configMAX_TASK_NAME_LEN];
+    snprintf(name, sizeof(name), "tiT_%c%c%d", netif->name[0], netif->name[1], netif->num);
+    if (xTaskCreatePinnedToCore(netif_rx_thread, name, CONFIG_LWIP_NETIF_RX_THREAD_STACK_SIZE, rx,
+                                TCPIP_THREAD_PRIO, NULL, CONFIG_LWIP_NETIF_RX_THREAD_AFFINITY) != pdPASS) {
+        sys_mbox_free(&rx->mbox);
+        return ERR_MEM;
+    }
+    rx->input_fn = input_fn;
+    rx->netif = netif;
+    return ERR_OK;
+}
+
+err_t netif_rx_thread_input(struct pbuf *p, struct netif *inp)
+{
+    for (int i = 0; i < NETIF_RX_THREAD_MAX; i++) {
+        if (s_rx_threads[i].netif == inp) {
+            return sys_mbox_trypost(&s_rx_threads[i].mbox, p);
+        }
+    }
+
+    /* No task of its own, let the TCP/IP task process it */
+    return tcpip_input(p, inp);
+}
+
+#endif /* CONFIG_LWIP_NETIF_RX_THREADS */
@@ -59,6 +59,8 @@ void esp_vfs_lwip_sockets_register()
         .fstat = NULL,
         .close = &lwip_close_r,
         .read = &lwip_read_r,
+        .readv = &lwip_readv_r,
+        .writev = &lwip_writev_r,
         .fcntl = &lwip_fcntl_r_wrapper,
         .ioctl = &lwip_ioctl_r_wrapper,
         .socket_select = &lwip_select,
@@ -0,0 +1,116 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "lwip/def.h"
+#include "lwip_chksum.h"
+
+#include "unity.h"
+
+#define TEST_BUF_SIZE   1600
+#define TEST_ITERATIONS 1000
+
+/* Byte by byte, as lwIP's LWIP_CHKSUM_ALGORITHM 1 */
+static uint16_t ref_chksum(const void *dataptr, int len)
+{
+    const uint8_t *p = (const uint8_t *)dataptr;
+    uint32_t acc = 0;
+
+    while (len > 1) {
+        acc += (p[0] << 8) | p[1];
+        p += 2;
+        len -= 2;
+    }
+    if (len > 0) {
+        acc += p[0] << 8;
+    }
+    while (acc >> 16) {
+        acc = (acc >> 16) + (acc & 0xffff);
+    }
+    return lwip_htons((uint16_t)acc);
+}
+
+TEST_CASE("fast checksum matches the reference", "[lwip]")
+{
+    uint8_t *src = malloc(TEST_BUF_SIZE + 8);
+    uint8_t *dst = malloc(TEST_BUF_SIZE + 8);
+    TEST_ASSERT_NOT_NULL(src);
+    TEST_ASSERT_NOT_NULL(dst);
+    esp_fill_random(src, TEST_BUF_SIZE + 8);
+
+    for (int src_off = 0; src_off < 4; src_off++) {
+        for (int dst_off = 0; dst_off < 4; dst_off++) {
+            for (int len = 0; len <= TEST_BUF_SIZE; len += (len < 64) ? 1 : 61) {
+                uint16_t expected = ref_chksum(src + src_off, len);
+                TEST_ASSERT_EQUAL_HEX16(expected, lwip_fast_chksum(src + src_off, len));
+
+                memset(dst, 0, TEST_BUF_SIZE + 8);
+                TEST_ASSERT_EQUAL_HEX16(expected, lwip_fast_chksum_copy(dst + dst_off, src + src_off, len));
+                TEST_ASSERT_EQUAL_MEMORY(src + src_off, dst + dst_off, len);
+                TEST_ASSERT_EQUAL(0, dst[dst_off + len]);
+            }
+        }
+    }
+    free(src);
+    free(dst);
+}
+
+TEST_CASE("fast checksum performance", "[lwip]")
+{
+    /* A full sized TCP segment */
+    const int len = 1460;
+    uint8_t *src = malloc(len);
+    uint8_t *dst = malloc(len);
+    TEST_ASSERT_NOT_NULL(src);
+    TEST_ASSERT_NOT_NULL(dst);
+    esp_fill_random(src, len);
+    volatile uint16_t sum;
+
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < TEST_ITERATIONS; i++) {
+        sum = ref_chksum(src, len);
+    }
+    int64_t ref_us = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (int i = 0; i < TEST_ITERATIONS; i++) {
+        sum = lwip_fast_chksum(src, len);
+    }
+    int64_t fast_us = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (int i = 0; i < TEST_ITERATIONS; i++) {
+        memcpy(dst, src, len);
+        sum = lwip_fast_chksum(dst, len);
+    }
+    int64_t copy_then_sum_us = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (int i = 0; i < TEST_ITERATIONS; i++) {
+        sum = lwip_fast_chksum_copy(dst, src, len);
+    }
+    int64_t copy_sum_us = esp_timer_get_time() - start;
+    (void)sum;
+
+    printf("%d bytes: reference %d ns, fast %d ns, memcpy + fast %d ns, fast copy %d ns\n", len,
+           (int)(ref_us * 1000 / TEST_ITERATIONS), (int)(fast_us * 1000 / TEST_ITERATIONS),
+           (int)(copy_then_sum_us * 1000 / TEST_ITERATIONS), (int)(copy_sum_us * 1000 / TEST_ITERATIONS));
+    TEST_ASSERT_LESS_THAN(ref_us, fast_us);
+    free(src);
+    free(dst);
+}
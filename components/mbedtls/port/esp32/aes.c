@@ -37,6 +37,9 @@
 #include "soc/cpu.h"
 #include <stdio.h>
 #include "driver/periph_ctrl.h"
+#if defined(MBEDTLS_GCM_ALT)
+#include "mbedtls/gcm.h"
+#endif
 
 
 /* AES uses a spinlock mux not a lock as the underlying block operation
@@ -360,6 +363,26 @@ int esp_aes_crypt_ctr( esp_aes_context *ctx,
 
     esp_aes_setkey_hardware(ctx, ESP_AES_ENCRYPT);
 
+    /* Whole blocks, without checking the stream offset for each byte */
+    if ( n == 0 ) {
+        while ( length >= 16 ) {
+            esp_aes_block(nonce_counter, stream_block);
+
+            for ( i = 16; i > 0; i-- )
+                if ( ++nonce_counter[i - 1] != 0 ) {
+                    break;
+                }
+
+            for ( i = 0; i < 16; i++ ) {
+                output[i] = (unsigned char)( input[i] ^ stream_block[i] );
+            }
+
+            input += 16;
+            output += 16;
+            length -= 16;
+        }
+    }
+
     while ( length-- ) {
         if ( n == 0 ) {
             esp_aes_block(nonce_counter, stream_block);
@@ -624,3 +647,385 @@ int esp_aes_crypt_xts( esp_aes_xts_context *ctx,
 
     return( 0 );
 }
+
+#if defined(MBEDTLS_GCM_ALT)
+
+/* AES-GCM, using the AES hardware for the counter mode encryption.
+ * GHASH is the 4-bit table implementation from mbedTLS gcm.c, done outside
+ * of the AES hardware critical section.
+ */
+
+#define GET_UINT32_BE(n, b, i)                              \
+    (n) = ( (uint32_t) (b)[(i)    ] << 24 )                 \
+        | ( (uint32_t) (b)[(i) + 1] << 16 )                 \
+        | ( (uint32_t) (b)[(i) + 2] <<  8 )                 \
+        | ( (uint32_t) (b)[(i) + 3]       )
+
+#define PUT_UINT32_BE(n, b, i)                              \
+    (b)[(i)    ] = (unsigned char) ( (n) >> 24 );           \
+    (b)[(i) + 1] = (unsigned char) ( (n) >> 16 );           \
+    (b)[(i) + 2] = (unsigned char) ( (n) >>  8 );           \
+    (b)[(i) + 3] = (unsigned char) ( (n)       )
+
+void esp_aes_gcm_init( esp_gcm_context *ctx )
+{
+    bzero( ctx, sizeof( esp_gcm_context ) );
+}
+
+void esp_aes_gcm_free( esp_gcm_context *ctx )
+{
+    if ( ctx == NULL ) {
+        return;
+    }
+
+    bzero( ctx, sizeof( esp_gcm_context ) );
+}
+
+/*
+ * Precompute the GHASH tables of H = E(K, 0^128), the multiples of H by
+ * all 4-bit values, see mbedTLS gcm.c
+ */
+static void esp_gcm_gen_table( esp_gcm_context *ctx, const unsigned char h[16] )
+{
+    int i, j;
+    uint32_t hi, lo;
+    uint64_t vh, vl;
+
+    GET_UINT32_BE( hi, h,  0  );
+    GET_UINT32_BE( lo, h,  4  );
+    vh = (uint64_t) hi << 32 | lo;
+
+    GET_UINT32_BE( hi, h,  8  );
+    GET_UINT32_BE( lo, h,  12 );
+    vl = (uint64_t) hi << 32 | lo;
+
+    /* 8 = 1000 corresponds to 1 in GF(2^128) */
+    ctx->HL[8] = vl;
+    ctx->HH[8] = vh;
+
+    /* 0 corresponds to 0 in GF(2^128) */
+    ctx->HH[0] = 0;
+    ctx->HL[0] = 0;
+
+    for ( i = 4; i > 0; i >>= 1 ) {
+        uint32_t T = ( vl & 1 ) * 0xe1000000U;
+        vl  = ( vh << 63 ) | ( vl >> 1 );
+        vh  = ( vh >> 1 ) ^ ( (uint64_t) T << 32);
+
+        ctx->HL[i] = vl;
+        ctx->HH[i] = vh;
+    }
+
+    for ( i = 2; i <= 8; i *= 2 ) {
+        uint64_t *HiL = ctx->HL + i, *HiH = ctx->HH + i;
+        vh = *HiH;
+        vl = *HiL;
+        for ( j = 1; j < i; j++ ) {
+            HiH[j] = vh ^ ctx->HH[j];
+            HiL[j] = vl ^ ctx->HL[j];
+        }
+    }
+}
+
+/*
+ * Shoup's method for multiplication use this table with
+ *      last4[x] = x times P^128
+ * where x and last4[x] are seen as elements of GF(2^128) as in [MGV]
+ */
+static const uint64_t last4[16] = {
+    0x0000, 0x1c20, 0x3840, 0x2460,
+    0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560,
+    0x9180, 0x8da0, 0xa9c0, 0xb5e0
+};
+
+/*
+ * Sets output to x times H using the precomputed tables.
+ * x and output are seen as elements of GF(2^128) as in [MGV].
+ */
+static void esp_gcm_mult( const esp_gcm_context *ctx, const unsigned char x[16],
+                          unsigned char output[16] )
+{
+    int i = 0;
+    unsigned char lo, hi, rem;
+    uint64_t zh, zl;
+
+    lo = x[15] & 0xf;
+
+    zh = ctx->HH[lo];
+    zl = ctx->HL[lo];
+
+    for ( i = 15; i >= 0; i-- ) {
+        lo = x[i] & 0xf;
+        hi = ( x[i] >> 4 ) & 0xf;
+
+        if ( i != 15 ) {
+            rem = (unsigned char) zl & 0xf;
+            zl = ( zh << 60 ) | ( zl >> 4 );
+            zh = ( zh >> 4 );
+            zh ^= (uint64_t) last4[rem] << 48;
+            zh ^= ctx->HH[lo];
+            zl ^= ctx->HL[lo];
+        }
+
+        rem = (unsigned char) zl & 0xf;
+        zl = ( zh << 60 ) | ( zl >> 4 );
+        zh = ( zh >> 4 );
+        zh ^= (uint64_t) last4[rem] << 48;
+        zh ^= ctx->HH[hi];
+        zl ^= ctx->HL[hi];
+    }
+
+    PUT_UINT32_BE( zh >> 32, output, 0 );
+    PUT_UINT32_BE( zh, output, 4 );
+    PUT_UINT32_BE( zl >> 32, output, 8 );
+    PUT_UINT32_BE( zl, output, 12 );
+}
+
+/* Add data to a GHASH, a last partial block is padded with zeroes */
+static void esp_gcm_ghash( const esp_gcm_context *ctx, unsigned char state[16],
+                           const unsigned char *data, size_t length )
+{
+    while ( length > 0 ) {
+        size_t use_len = ( length < 16 ) ? length : 16;
+
+        for ( size_t i = 0; i < use_len; i++ ) {
+            state[i] ^= data[i];
+        }
+        esp_gcm_mult( ctx, state, state );
+
+        length -= use_len;
+        data += use_len;
+    }
+}
+
+int esp_aes_gcm_setkey( esp_gcm_context *ctx,
+                        mbedtls_cipher_id_t cipher,
+                        const unsigned char *key,
+                        unsigned int keybits )
+{
+    unsigned char h[16] = { 0 };
+    int ret;
+
+    /* the AES hardware only does AES */
+    if ( cipher != MBEDTLS_CIPHER_ID_AES ) {
+        return ( MBEDTLS_ERR_GCM_BAD_INPUT );
+    }
+
+    ret = esp_aes_setkey( &ctx->aes_ctx, key, keybits );
+    if ( ret != 0 ) {
+        return ( ret );
+    }
+
+    esp_aes_crypt_ecb( &ctx->aes_ctx, ESP_AES_ENCRYPT, h, h );
+    esp_gcm_gen_table( ctx, h );
+    bzero( h, sizeof( h ) );
+
+    return ( 0 );
+}
+
+int esp_aes_gcm_starts( esp_gcm_context *ctx,
+                        int mode,
+                        const unsigned char *iv,
+                        size_t iv_len,
+                        const unsigned char *add,
+                        size_t add_len )
+{
+    unsigned char work_buf[16];
+
+    /* IV and AD are limited to 2^64 bits, so 2^61 bytes */
+    /* IV is not allowed to be zero length */
+    if ( iv_len == 0 ||
+            ( (uint64_t) iv_len  ) >> 61 != 0 ||
+            ( (uint64_t) add_len ) >> 61 != 0 ) {
+        return ( MBEDTLS_ERR_GCM_BAD_INPUT );
+    }
+
+    memset( ctx->y, 0x00, sizeof( ctx->y ) );
+    memset( ctx->buf, 0x00, sizeof( ctx->buf ) );
+
+    ctx->mode = mode;
+    ctx->len = 0;
+    ctx->add_len = 0;
+
+    if ( iv_len == 12 ) {
+        memcpy( ctx->y, iv, iv_len );
+        ctx->y[15] = 1;
+    } else {
+        memset( work_buf, 0x00, 16 );
+        PUT_UINT32_BE( iv_len * 8, work_buf, 12 );
+
+        esp_gcm_ghash( ctx, ctx->y, iv, iv_len );
+        esp_gcm_ghash( ctx, ctx->y, work_buf, 16 );
+    }
+
+    esp_aes_crypt_ecb( &ctx->aes_ctx, ESP_AES_ENCRYPT, ctx->y, ctx->base_ectr );
+
+    ctx->add_len = add_len;
+    esp_gcm_ghash( ctx, ctx->buf, add, add_len );
+
+    return ( 0 );
+}
+
+int esp_aes_gcm_update( esp_gcm_context *ctx,
+                        size_t length,
+                        const unsigned char *input,
+                        unsigned char *output )
+{
+    unsigned char ectr[16];
+    const unsigned char *p = input;
+    unsigned char *out_p = output;
+    size_t remaining = length;
+
+    if ( output > input && (size_t) ( output - input ) < length ) {
+        return ( MBEDTLS_ERR_GCM_BAD_INPUT );
+    }
+
+    /* Total length is restricted to 2^39 - 256 bits, ie 2^36 - 2^5 bytes
+     * Also check for possible overflow */
+    if ( ctx->len + length < ctx->len ||
+            (uint64_t) ctx->len + length > 0xFFFFFFFE0ull ) {
+        return ( MBEDTLS_ERR_GCM_BAD_INPUT );
+    }
+
+    ctx->len += length;
+
+    /* The GHASH is over the ciphertext, which is overwritten by in place decryption */
+    if ( ctx->mode == ESP_AES_DECRYPT ) {
+        esp_gcm_ghash( ctx, ctx->buf, input, length );
+    }
+
+    /* Hold the AES hardware for the whole buffer, and only run the counter mode on it */
+    esp_aes_acquire_hardware();
+
+    esp_aes_setkey_hardware( &ctx->aes_ctx, ESP_AES_ENCRYPT );
+
+    while ( remaining > 0 ) {
+        size_t use_len = ( remaining < 16 ) ? remaining : 16;
+
+        for ( int i = 16; i > 12; i-- ) {
+            if ( ++ctx->y[i - 1] != 0 ) {
+                break;
+            }
+        }
+
+        esp_aes_block( ctx->y, ectr );
+
+        for ( size_t i = 0; i < use_len; i++ ) {
+            out_p[i] = ectr[i] ^ p[i];
+        }
+
+        remaining -= use_len;
+        p += use_len;
+        out_p += use_len;
+    }
+
+    esp_aes_release_hardware();
+
+    if ( ctx->mode == ESP_AES_ENCRYPT ) {
+        esp_gcm_ghash( ctx, ctx->buf, output, length );
+    }
+
+    bzero( ectr, sizeof( ectr ) );
+
+    return ( 0 );
+}
+
+int esp_aes_gcm_finish( esp_gcm_context *ctx,
+                        unsigned char *tag,
+                        size_t tag_len )
+{
+    unsigned char work_buf[16];
+    size_t i;
+    uint64_t orig_len = ctx->len * 8;
+    uint64_t orig_add_len = ctx->add_len * 8;
+
+    if ( tag_len > 16 || tag_len < 4 ) {
+        return ( MBEDTLS_ERR_GCM_BAD_INPUT );
+    }
+
+    memcpy( tag, ctx->base_ectr, tag_len );
+
+    if ( orig_len || orig_add_len ) {
+        memset( work_buf, 0x00, 16 );
+
+        PUT_UINT32_BE( ( orig_add_len >> 32 ), work_buf, 0  );
+        PUT_UINT32_BE( ( orig_add_len       ), work_buf, 4  );
+        PUT_UINT32_BE( ( orig_len     >> 32 ), work_buf, 8  );
+        PUT_UINT32_BE( ( orig_len           ), work_buf, 12 );
+
+        esp_gcm_ghash( ctx, ctx->buf, work_buf, 16 );
+
+        for ( i = 0; i < tag_len; i++ ) {
+            tag[i] ^= ctx->buf[i];
+        }
+    }
+
+    return ( 0 );
+}
+
+int esp_aes_gcm_crypt_and_tag( esp_gcm_context *ctx,
+                               int mode,
+                               size_t length,
+                               const unsigned char *iv,
+                               size_t iv_len,
+                               const unsigned char *add,
+                               size_t add_len,
+                               const unsigned char *input,
+                               unsigned char *output,
+                               size_t tag_len,
+                               unsigned char *tag )
+{
+    int ret;
+
+    if ( ( ret = esp_aes_gcm_starts( ctx, mode, iv, iv_len, add, add_len ) ) != 0 ) {
+        return ( ret );
+    }
+
+    if ( ( ret = esp_aes_gcm_update( ctx, length, input, output ) ) != 0 ) {
+        return ( ret );
+    }
+
+    if ( ( ret = esp_aes_gcm_finish( ctx, tag, tag_len ) ) != 0 ) {
+        return ( ret );
+    }
+
+    return ( 0 );
+}
+
+int esp_aes_gcm_auth_decrypt( esp_gcm_context *ctx,
+                              size_t length,
+                              const unsigned char *iv,
+                              size_t iv_len,
+                              const unsigned char *add,
+                              size_t add_len,
+                              const unsigned char *tag,
+                              size_t tag_len,
+                              const unsigned char *input,
+                              unsigned char *output )
+{
+    int ret;
+    unsigned char check_tag[16];
+    size_t i;
+    int diff;
+
+    if ( ( ret = esp_aes_gcm_crypt_and_tag( ctx, ESP_AES_DECRYPT, length,
+                                            iv, iv_len, add, add_len,
+                                            input, output, tag_len, check_tag ) ) != 0 ) {
+        return ( ret );
+    }
+
+    /* Check tag in "constant-time" */
+    for ( diff = 0, i = 0; i < tag_len; i++ ) {
+        diff |= tag[i] ^ check_tag[i];
+    }
+
+    if ( diff != 0 ) {
+        bzero( output, length );
+        return ( MBEDTLS_ERR_GCM_AUTH_FAILED );
+    }
+
+    return ( 0 );
+}
+
+#endif /* MBEDTLS_GCM_ALT */
@@ -78,6 +78,31 @@ static uint8_t engines_in_use;
 */
 static portMUX_TYPE engines_in_use_lock = portMUX_INITIALIZER_UNLOCKED;
 
+/* Digest which owns each engine through the esp_sha_shared_*() functions,
+   identified by its state buffer. NULL if the engine is free or was locked
+   with esp_sha_lock_engine()/esp_sha_try_lock_engine().
+
+   Indexes are the same as engine_states. Protected by memory_block_lock.
+*/
+static void *engine_owner[3];
+static esp_sha_type engine_owner_type[3];
+static uint32_t engine_owner_blocks[3];
+
+/* A digest which has run fewer blocks than this on its engine hands the
+   engine over to a newly started digest, and continues in software from
+   the state read out of the engine. Digests which have only just started
+   (like an HMAC context which has been reset and hashed its inner pad,
+   then waits for the next TLS record) are cheap to move, while a long
+   digest such as an OTA image hash keeps the engine.
+*/
+#define SHA_HANDOVER_MAX_BLOCKS 4
+
+static esp_sha_usage_t usage[SHA2_512 + 1];
+
+/* Spinlock for the usage counters
+*/
+static portMUX_TYPE usage_lock = portMUX_INITIALIZER_UNLOCKED;
+
 /* Index into the engine_states array */
 inline static size_t sha_engine_index(esp_sha_type type) {
     switch(type) {
@@ -228,22 +253,11 @@ void esp_sha_wait_idle(void)
     }
 }
 
-void esp_sha_read_digest_state(esp_sha_type sha_type, void *digest_state)
+/* Call with memory_block_lock held */
+static void sha_read_digest_locked(esp_sha_type sha_type, void *digest_state)
 {
     uint32_t *digest_state_words = NULL;
     uint32_t *reg_addr_buf = NULL;
-#ifndef NDEBUG
-    {
-        SemaphoreHandle_t *engine_state = sha_get_engine_state(sha_type);
-        assert(uxSemaphoreGetCount(engine_state) == 0 &&
-               "SHA engine should be locked" );
-    }
-#endif
-
-    // preemptively do this before entering the critical section, then re-check once in it
-    esp_sha_wait_idle();
-
-    esp_sha_lock_memory_block();
 
     esp_sha_wait_idle();
 
@@ -262,25 +276,13 @@ void esp_sha_read_digest_state(esp_sha_type sha_type, void *digest_state)
     } else {
         esp_dport_access_read_buffer(digest_state_words, (uint32_t)&reg_addr_buf[0], sha_length(sha_type)/4);
     }
-    esp_sha_unlock_memory_block();
 }
 
-void esp_sha_block(esp_sha_type sha_type, const void *data_block, bool is_first_block)
+/* Call with memory_block_lock held */
+static void sha_block_locked(esp_sha_type sha_type, const void *data_block, bool is_first_block)
 {
     uint32_t *reg_addr_buf = NULL;
     uint32_t *data_words = NULL;
-#ifndef NDEBUG
-    {
-        SemaphoreHandle_t *engine_state = sha_get_engine_state(sha_type);
-        assert(uxSemaphoreGetCount(engine_state) == 0 &&
-               "SHA engine should be locked" );
-    }
-#endif
-
-    // preemptively do this before entering the critical section, then re-check once in it
-    esp_sha_wait_idle();
-
-    esp_sha_lock_memory_block();
 
     esp_sha_wait_idle();
 
@@ -298,6 +300,47 @@ void esp_sha_block(esp_sha_type sha_type, const void *data_block, bool is_first_
         DPORT_REG_WRITE(SHA_CONTINUE_REG(sha_type), 1);
     }
 
+    /* also under memory_block_lock */
+    usage[sha_type].hardware_blocks++;
+}
+
+void esp_sha_read_digest_state(esp_sha_type sha_type, void *digest_state)
+{
+#ifndef NDEBUG
+    {
+        SemaphoreHandle_t *engine_state = sha_get_engine_state(sha_type);
+        assert(uxSemaphoreGetCount(engine_state) == 0 &&
+               "SHA engine should be locked" );
+    }
+#endif
+
+    // preemptively do this before entering the critical section, then re-check once in it
+    esp_sha_wait_idle();
+
+    esp_sha_lock_memory_block();
+
+    sha_read_digest_locked(sha_type, digest_state);
+
+    esp_sha_unlock_memory_block();
+}
+
+void esp_sha_block(esp_sha_type sha_type, const void *data_block, bool is_first_block)
+{
+#ifndef NDEBUG
+    {
+        SemaphoreHandle_t *engine_state = sha_get_engine_state(sha_type);
+        assert(uxSemaphoreGetCount(engine_state) == 0 &&
+               "SHA engine should be locked" );
+    }
+#endif
+
+    // preemptively do this before entering the critical section, then re-check once in it
+    esp_sha_wait_idle();
+
+    esp_sha_lock_memory_block();
+
+    sha_block_locked(sha_type, data_block, is_first_block);
+
     esp_sha_unlock_memory_block();
 
     /* Note: deliberately not waiting for this operation to complete,
@@ -306,6 +349,118 @@ void esp_sha_block(esp_sha_type sha_type, const void *data_block, bool is_first_
     */
 }
 
+/* SHA-384 runs on the SHA-512 state, read all of it to continue the digest */
+inline static esp_sha_type sha_interim_type(esp_sha_type type) {
+    return (type == SHA2_384) ? SHA2_512 : type;
+}
+
+bool esp_sha_shared_block(esp_sha_type sha_type, void *digest_state, const void *data_block, bool is_first_block)
+{
+    unsigned idx = sha_engine_index(sha_type);
+    bool locked = false;
+    bool result = false;
+
+    if (is_first_block) {
+        locked = esp_sha_try_lock_engine(sha_type);
+    }
+
+    esp_sha_wait_idle();
+
+    esp_sha_lock_memory_block();
+
+    if (is_first_block) {
+        if (!locked && engine_owner[idx] != NULL
+            && engine_owner_blocks[idx] < SHA_HANDOVER_MAX_BLOCKS) {
+            /* save the state of the owner, it continues the digest in software */
+            sha_read_digest_locked(sha_interim_type(engine_owner_type[idx]), engine_owner[idx]);
+            usage[engine_owner_type[idx]].handovers++;
+            locked = true;
+        }
+        if (locked) {
+            engine_owner[idx] = digest_state;
+            engine_owner_type[idx] = sha_type;
+            engine_owner_blocks[idx] = 0;
+        }
+    }
+
+    if (engine_owner[idx] == digest_state) {
+        sha_block_locked(sha_type, data_block, is_first_block);
+        engine_owner_blocks[idx]++;
+        result = true;
+    }
+
+    esp_sha_unlock_memory_block();
+
+    return result;
+}
+
+bool esp_sha_shared_read_digest_state(esp_sha_type sha_type, const void *owner_state, void *digest_state)
+{
+    unsigned idx = sha_engine_index(sha_type);
+    bool result;
+
+    esp_sha_wait_idle();
+
+    esp_sha_lock_memory_block();
+
+    result = (engine_owner[idx] == owner_state);
+    if (result) {
+        sha_read_digest_locked(sha_type, digest_state);
+    } else if (digest_state != owner_state) {
+        /* the state was saved when the engine was handed over */
+        memcpy(digest_state, owner_state, sha_length(sha_type));
+    }
+
+    esp_sha_unlock_memory_block();
+
+    return result;
+}
+
+void esp_sha_shared_release(esp_sha_type sha_type, const void *digest_state)
+{
+    unsigned idx = sha_engine_index(sha_type);
+    bool owner;
+
+    esp_sha_lock_memory_block();
+
+    owner = (engine_owner[idx] == digest_state);
+    if (owner) {
+        engine_owner[idx] = NULL;
+    }
+
+    esp_sha_unlock_memory_block();
+
+    if (owner) {
+        esp_sha_unlock_engine(sha_type);
+    }
+}
+
+void esp_sha_count_software_block(esp_sha_type sha_type)
+{
+    portENTER_CRITICAL(&usage_lock);
+    usage[sha_type].software_blocks++;
+    portEXIT_CRITICAL(&usage_lock);
+}
+
+void esp_sha_get_usage(esp_sha_type sha_type, esp_sha_usage_t *sha_usage)
+{
+    /* hardware counters are updated under memory_block_lock */
+    esp_sha_lock_memory_block();
+    portENTER_CRITICAL(&usage_lock);
+    *sha_usage = usage[sha_type];
+    portEXIT_CRITICAL(&usage_lock);
+    esp_sha_unlock_memory_block();
+}
+
+void esp_sha_reset_usage(void)
+{
+    esp_sha_lock_memory_block();
+    portENTER_CRITICAL(&usage_lock);
+    memset(usage, 0, sizeof(usage));
+    portEXIT_CRITICAL(&usage_lock);
+    esp_sha_unlock_memory_block();
+}
+
 void esp_sha(esp_sha_type sha_type, const unsigned char *input, size_t ilen, unsigned char *output)
 {
     size_t block_len = block_length(sha_type);
@@ -337,6 +492,7 @@ void esp_sha(esp_sha_type sha_type, const unsigned char *input, size_t ilen, uns
             // (can accept max one SHA block each call)
             size_t update_len = (chunk_len > block_len) ? block_len : chunk_len;
             ets_sha_update(&ctx, sha_type, input, update_len * 8);
+            usage[sha_type].hardware_blocks++;
 
             input += update_len;
             chunk_len -= update_len;
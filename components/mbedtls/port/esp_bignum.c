@@ -36,6 +36,12 @@
 #include "esp_attr.h"
 
 #include <mbedtls/bignum.h>
+#if defined(MBEDTLS_ECP_INTERNAL_ALT)
+#include <mbedtls/ecp.h>
+#include <mbedtls/ecp_internal.h>
+#include <mbedtls/platform.h>
+#include <mbedtls/platform_util.h>
+#endif
 
 #include "soc/dport_reg.h"
 
@@ -661,3 +667,665 @@ static int mpi_mult_mpi_overlong(mbedtls_mpi *Z, const mbedtls_mpi *X, const mbe
 
 #endif /* MBEDTLS_MPI_MUL_MPI_ALT */
 
+
+#if defined(MBEDTLS_ECP_INTERNAL_ALT)
+
+/* Elliptic curve point arithmetic for short Weierstrass curves (jacobian
+ * coordinates) and Montgomery curves (x/z coordinates), using the modular
+ * multiplication of the RSA accelerator.
+ *
+ * mbedtls_internal_ecp_init() takes the hardware for a whole point
+ * multiplication, calculates Rinv once and loads P and Mprime, which stay
+ * loaded until mbedtls_internal_ecp_free(). The Rinv memory block is also
+ * the Z (result) memory block, so each field multiplication loads Rinv
+ * and its two factors, all no longer than P, and reads back the product.
+ *
+ * Coordinates are copied into fixed length word arrays for each point
+ * operation, so modular additions and subtractions are done in place
+ * without allocating. Inversions use the modular exponentiation with
+ * exponent P - 2.
+ *
+ * Only the formulas of the software implementation in ecp.c are replaced,
+ * the scalar multiplication (comb method or Montgomery ladder, with their
+ * countermeasures) is unchanged.
+ */
+
+#define ECP_MAX_WORDS ((MBEDTLS_ECP_MAX_BITS + 31) / 32)
+
+/* State of the point multiplication holding the hardware, protected by mpi_lock */
+static struct {
+    size_t words;                       /* words of P, length of all field elements */
+    uint32_t p[ECP_MAX_WORDS];
+    uint32_t p_minus_2[ECP_MAX_WORDS];  /* exponent for inversion */
+    uint32_t rinv[ECP_MAX_WORDS];       /* see calculate_rinv() */
+    uint32_t a[ECP_MAX_WORDS];
+    bool a_is_minus_3;                  /* grp->A is not set */
+    bool a_is_zero;
+} ecp_hw;
+
+static inline void words_to_mem_block(uint32_t mem_base, const uint32_t *words, size_t num_words)
+{
+    uint32_t *pbase = (uint32_t *)mem_base;
+
+    for (int i = 0; i < num_words; i++) {
+        pbase[i] = words[i];
+    }
+}
+
+static void mpi_to_fe(uint32_t *a, const mbedtls_mpi *X)
+{
+    size_t copy_words = MIN(X->n, ecp_hw.words);
+
+    memcpy(a, X->p, copy_words * ciL);
+    memset(a + copy_words, 0, (ecp_hw.words - copy_words) * ciL);
+}
+
+static int fe_to_mpi(mbedtls_mpi *X, const uint32_t *a)
+{
+    int ret;
+
+    MBEDTLS_MPI_CHK( mbedtls_mpi_grow(X, ecp_hw.words) );
+    memcpy(X->p, a, ecp_hw.words * ciL);
+    memset(X->p + ecp_hw.words, 0, (X->n - ecp_hw.words) * ciL);
+    X->s = 1;
+
+ cleanup:
+    return ret;
+}
+
+static bool fe_is_zero(const uint32_t *a)
+{
+    uint32_t bits = 0;
+
+    for (int i = 0; i < ecp_hw.words; i++) {
+        bits |= a[i];
+    }
+    return bits == 0;
+}
+
+/* z = x + y mod P */
+static void fe_add(uint32_t *z, const uint32_t *x, const uint32_t *y)
+{
+    uint32_t t[ECP_MAX_WORDS];
+    uint64_t carry = 0;
+    int64_t borrow = 0;
+    uint32_t mask;
+
+    for (int i = 0; i < ecp_hw.words; i++) {
+        carry += (uint64_t)x[i] + y[i];
+        z[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    for (int i = 0; i < ecp_hw.words; i++) {
+        borrow += (int64_t)z[i] - ecp_hw.p[i];
+        t[i] = (uint32_t)borrow;
+        borrow >>= 32;
+    }
+    /* the sum is reduced unless it overflowed or is at least P */
+    mask = -(uint32_t)(carry != 0 || borrow == 0);
+    for (int i = 0; i < ecp_hw.words; i++) {
+        z[i] = (t[i] & mask) | (z[i] & ~mask);
+    }
+}
+
+/* z = x - y mod P */
+static void fe_sub(uint32_t *z, const uint32_t *x, const uint32_t *y)
+{
+    int64_t borrow = 0;
+    uint64_t carry = 0;
+    uint32_t mask;
+
+    for (int i = 0; i < ecp_hw.words; i++) {
+        borrow += (int64_t)x[i] - y[i];
+        z[i] = (uint32_t)borrow;
+        borrow >>= 32;
+    }
+    /* add P back if the difference is negative */
+    mask = -(uint32_t)(borrow != 0);
+    for (int i = 0; i < ecp_hw.words; i++) {
+        carry += (uint64_t)z[i] + (ecp_hw.p[i] & mask);
+        z[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+}
+
+/* z = x * y mod P, in the two steps of esp_mpi_mul_mpi_mod()
+
+   Words of the memory blocks above ecp_hw.words stay zero, as all results are less than P.
+*/
+static void fe_mul(uint32_t *z, const uint32_t *x, const uint32_t *y)
+{
+    words_to_mem_block(RSA_MEM_RB_BLOCK_BASE, ecp_hw.rinv, ecp_hw.words);
+    words_to_mem_block(RSA_MEM_X_BLOCK_BASE, x, ecp_hw.words);
+    start_op(RSA_MULT_START_REG);
+    wait_op_complete(RSA_MULT_START_REG);
+
+    words_to_mem_block(RSA_MEM_X_BLOCK_BASE, y, ecp_hw.words);
+    start_op(RSA_MULT_START_REG);
+    wait_op_complete(RSA_MULT_START_REG);
+
+    esp_dport_access_read_buffer(z, RSA_MEM_Z_BLOCK_BASE, ecp_hw.words);
+}
+
+/* z = x^-1 mod P = x^(P - 2) mod P */
+static void fe_inv(uint32_t *z, const uint32_t *x)
+{
+    words_to_mem_block(RSA_MEM_RB_BLOCK_BASE, ecp_hw.rinv, ecp_hw.words);
+    words_to_mem_block(RSA_MEM_X_BLOCK_BASE, x, ecp_hw.words);
+    words_to_mem_block(RSA_MEM_Y_BLOCK_BASE, ecp_hw.p_minus_2, ecp_hw.words);
+    start_op(RSA_START_MODEXP_REG);
+    wait_op_complete(RSA_START_MODEXP_REG);
+
+    esp_dport_access_read_buffer(z, RSA_MEM_Z_BLOCK_BASE, ecp_hw.words);
+}
+
+/* Random field element l such that 1 < l < P, for the coordinate randomization */
+static int fe_random(const mbedtls_ecp_group *grp, uint32_t *l,
+                     int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
+{
+    int ret;
+    mbedtls_mpi L;
+    size_t p_size = (grp->pbits + 7) / 8;
+    int count = 0;
+
+    mbedtls_mpi_init(&L);
+
+    do {
+        MBEDTLS_MPI_CHK( mbedtls_mpi_fill_random(&L, p_size, f_rng, p_rng) );
+
+        while (mbedtls_mpi_cmp_mpi(&L, &grp->P) >= 0) {
+            MBEDTLS_MPI_CHK( mbedtls_mpi_shift_r(&L, 1) );
+        }
+
+        if (count++ > 10) {
+            ret = MBEDTLS_ERR_ECP_RANDOM_FAILED;
+            goto cleanup;
+        }
+    } while (mbedtls_mpi_cmp_int(&L, 1) <= 0);
+
+    mpi_to_fe(l, &L);
+
+ cleanup:
+    mbedtls_mpi_free(&L);
+    return ret;
+}
+
+unsigned char mbedtls_internal_ecp_grp_capable(const mbedtls_ecp_group *grp)
+{
+    /* short Weierstrass curves use the jacobian hooks, Montgomery curves
+       (Curve25519, G has no Y coordinate) the x/z ones */
+    return grp->G.X.p != NULL;
+}
+
+int mbedtls_internal_ecp_init(const mbedtls_ecp_group *grp)
+{
+    int ret;
+    size_t words = word_length(&grp->P);
+    size_t hw_words = hardware_words(words);
+    int64_t borrow = -2;
+    mbedtls_mpi Rinv;
+
+    /* calculate_rinv() can't run while holding the hardware */
+    mbedtls_mpi_init(&Rinv);
+    ret = calculate_rinv(&Rinv, &grp->P, hw_words);
+
+    /* mbedtls_internal_ecp_free() is called for any capable group, even if this fails */
+    esp_mpi_acquire_hardware();
+    MBEDTLS_MPI_CHK( ret );
+
+    ecp_hw.words = words;
+    mpi_to_fe(ecp_hw.p, &grp->P);
+    for (int i = 0; i < words; i++) {
+        borrow += ecp_hw.p[i];
+        ecp_hw.p_minus_2[i] = (uint32_t)borrow;
+        borrow >>= 32;
+    }
+    ecp_hw.a_is_minus_3 = (grp->A.p == NULL);
+    ecp_hw.a_is_zero = !ecp_hw.a_is_minus_3 && mbedtls_mpi_cmp_int(&grp->A, 0) == 0;
+    if (!ecp_hw.a_is_minus_3) {
+        mpi_to_fe(ecp_hw.a, &grp->A);
+    }
+    mpi_to_fe(ecp_hw.rinv, &Rinv);
+
+    /* X, Y and Z blocks above 'words' stay zero from the hardware reset */
+    mpi_to_mem_block(RSA_MEM_M_BLOCK_BASE, &grp->P, hw_words);
+    DPORT_REG_WRITE(RSA_M_DASH_REG, (uint32_t)modular_inverse(&grp->P));
+
+    /* "mode" registers loaded with number of 512-bit blocks, minus 1 */
+    DPORT_REG_WRITE(RSA_MULT_MODE_REG, (hw_words / 16) - 1);
+    DPORT_REG_WRITE(RSA_MODEXP_MODE_REG, (hw_words / 16) - 1);
+
+ cleanup:
+    mbedtls_mpi_free(&Rinv);
+    return ret;
+}
+
+void mbedtls_internal_ecp_free(const mbedtls_ecp_group *grp)
+{
+    esp_mpi_release_hardware();
+}
+
+#if defined(MBEDTLS_ECP_RANDOMIZE_JAC_ALT)
+/* Randomize jacobian coordinates: (X, Y, Z) -> (l^2 X, l^3 Y, l Z) for random l */
+int mbedtls_internal_ecp_randomize_jac(const mbedtls_ecp_group *grp, mbedtls_ecp_point *pt,
+                                       int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
+{
+    int ret;
+    struct {
+        uint32_t X[ECP_MAX_WORDS], Y[ECP_MAX_WORDS], Z[ECP_MAX_WORDS];
+        uint32_t l[ECP_MAX_WORDS], ll[ECP_MAX_WORDS];
+    } v;
+
+    MBEDTLS_MPI_CHK( fe_random(grp, v.l, f_rng, p_rng) );
+
+    mpi_to_fe(v.X, &pt->X);
+    mpi_to_fe(v.Y, &pt->Y);
+    mpi_to_fe(v.Z, &pt->Z);
+
+    fe_mul(v.Z, v.Z, v.l);
+    fe_mul(v.ll, v.l, v.l);
+    fe_mul(v.X, v.X, v.ll);
+    fe_mul(v.ll, v.ll, v.l);
+    fe_mul(v.Y, v.Y, v.ll);
+
+    MBEDTLS_MPI_CHK( fe_to_mpi(&pt->X, v.X) );
+    MBEDTLS_MPI_CHK( fe_to_mpi(&pt->Y, v.Y) );
+    MBEDTLS_MPI_CHK( fe_to_mpi(&pt->Z, v.Z) );
+
+ cleanup:
+    mbedtls_platform_zeroize(&v, sizeof(v));
+    return ret;
+}
+#endif /* MBEDTLS_ECP_RANDOMIZE_JAC_ALT */
+
+#if defined(MBEDTLS_ECP_DOUBLE_JAC_ALT)
+/* R = 2P in jacobian coordinates, same formulas as ecp_double_jac() in ecp.c */
+int mbedtls_internal_ecp_double_jac(const mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
+                                    const mbedtls_ecp_point *P)
+{
+    int ret;
+    struct {
+        uint32_t X[ECP_MAX_WORDS], Y[ECP_MAX_WORDS], Z[ECP_MAX_WORDS];
+        uint32_t M[ECP_MAX_WORDS], S[ECP_MAX_WORDS], T[ECP_MAX_WORDS], U[ECP_MAX_WORDS];
+    } v;
+
+    mpi_to_fe(v.X, &P->X);
+    mpi_to_fe(v.Y, &P->Y);
+    mpi_to_fe(v.Z, &P->Z);
+
+    if (ecp_hw.a_is_minus_3) {
+        /* M = 3(X + Z^2)(X - Z^2) */
+        fe_mul(v.S, v.Z, v.Z);
+        fe_add(v.T, v.X, v.S);
+        fe_sub(v.U, v.X, v.S);
+        fe_mul(v.S, v.T, v.U);
+    } else {
+        /* M = 3.X^2 + A.Z^4 */
+        fe_mul(v.S, v.X, v.X);
+    }
+    fe_add(v.M, v.S, v.S);
+    fe_add(v.M, v.M, v.S);
+    if (!ecp_hw.a_is_minus_3 && !ecp_hw.a_is_zero) {
+        fe_mul(v.S, v.Z, v.Z);
+        fe_mul(v.T, v.S, v.S);
+        fe_mul(v.S, v.T, ecp_hw.a);
+        fe_add(v.M, v.M, v.S);
+    }
+
+    /* S = 4.X.Y^2 */
+    fe_mul(v.T, v.Y, v.Y);
+    fe_add(v.T, v.T, v.T);
+    fe_mul(v.S, v.X, v.T);
+    fe_add(v.S, v.S, v.S);
+
+    /* U = 8.Y^4 */
+    fe_mul(v.U, v.T, v.T);
+    fe_add(v.U, v.U, v.U);
+
+    /* T = M^2 - 2.S */
+    fe_mul(v.T, v.M, v.M);
+    fe_sub(v.T, v.T, v.S);
+    fe_sub(v.T, v.T, v.S);
+
+    /* S = M(S - T) - U */
+    fe_sub(v.S, v.S, v.T);
+    fe_mul(v.S, v.S, v.M);
+    fe_sub(v.S, v.S, v.U);
+
+    /* U = 2.Y.Z */
+    fe_mul(v.U, v.Y, v.Z);
+    fe_add(v.U, v.U, v.U);
+
+    MBEDTLS_MPI_CHK( fe_to_mpi(&R->X, v.T) );
+    MBEDTLS_MPI_CHK( fe_to_mpi(&R->Y, v.S) );
+    MBEDTLS_MPI_CHK( fe_to_mpi(&R->Z, v.U) );
+
+ cleanup:
+    mbedtls_platform_zeroize(&v, sizeof(v));
+    return ret;
+}
+#endif /* MBEDTLS_ECP_DOUBLE_JAC_ALT */
+
+#if defined(MBEDTLS_ECP_ADD_MIXED_ALT)
+/* R = P + Q with Q normalized (Z = 1), same formulas as ecp_add_mixed() in ecp.c */
+int mbedtls_internal_ecp_add_mixed(const mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
+                                   const mbedtls_ecp_point *P, const mbedtls_ecp_point *Q)
+{
+    int ret;
+    struct {
+        uint32_t X1[ECP_MAX_WORDS], Y1[ECP_MAX_WORDS], Z1[ECP_MAX_WORDS];
+        uint32_t X2[ECP_MAX_WORDS], Y2[ECP_MAX_WORDS];
+        uint32_t T1[ECP_MAX_WORDS], T2[ECP_MAX_WORDS], T3[ECP_MAX_WORDS], T4[ECP_MAX_WORDS];
+        uint32_t X[ECP_MAX_WORDS], Y[ECP_MAX_WORDS], Z[ECP_MAX_WORDS];
+    } v;
+
+    /* Trivial cases: P == 0 or Q == 0 */
+    if (mbedtls_mpi_cmp_int(&P->Z, 0) == 0) {
+        return mbedtls_ecp_copy(R, Q);
+    }
+    if (Q->Z.p != NULL && mbedtls_mpi_cmp_int(&Q->Z, 0) == 0) {
+        return mbedtls_ecp_copy(R, P);
+    }
+    /* Make sure Q coordinates are normalized */
+    if (Q->Z.p != NULL && mbedtls_mpi_cmp_int(&Q->Z, 1) != 0) {
+        return MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+    }
+
+    mpi_to_fe(v.X1, &P->X);
+    mpi_to_fe(v.Y1, &P->Y);
+    mpi_to_fe(v.Z1, &P->Z);
+    mpi_to_fe(v.X2, &Q->X);
+    mpi_to_fe(v.Y2, &Q->Y);
+
+    fe_mul(v.T1, v.Z1, v.Z1);
+    fe_mul(v.T2, v.T1, v.Z1);
+    fe_mul(v.T1, v.T1, v.X2);
+    fe_mul(v.T2, v.T2, v.Y2);
+    fe_sub(v.T1, v.T1, v.X1);
+    fe_sub(v.T2, v.T2, v.Y1);
+
+    /* Special cases: P == Q or P == -Q */
+    if (fe_is_zero(v.T1)) {
+        if (fe_is_zero(v.T2)) {
+            ret = mbedtls_internal_ecp_double_jac(grp, R, P);
+        } else {
+            ret = mbedtls_ecp_set_zero(R);
+        }
+        goto cleanup;
+    }
+
+    fe_mul(v.Z, v.Z1, v.T1);
+    fe_mul(v.T3, v.T1, v.T1);
+    fe_mul(v.T4, v.T3, v.T1);
+    fe_mul(v.T3, v.T3, v.X1);
+    fe_add(v.T1, v.T3, v.T3);
+    fe_mul(v.X, v.T2, v.T2);
+    fe_sub(v.X, v.X, v.T1);
+    fe_sub(v.X, v.X, v.T4);
+    fe_sub(v.T3, v.T3, v.X);
+    fe_mul(v.T3, v.T3, v.T2);
+    fe_mul(v.T4, v.T4, v.Y1);
+    fe_sub(v.Y, v.T3, v.T4);
+
+    MBEDTLS_MPI_CHK( fe_to_mpi(&R->X, v.X) );
+    MBEDTLS_MPI_CHK( fe_to_mpi(&R->Y, v.Y) );
+    MBEDTLS_MPI_CHK( fe_to_mpi(&R->Z, v.Z) );
+
+ cleanup:
+    mbedtls_platform_zeroize(&v, sizeof(v));
+    return ret;
+}
+#endif /* MBEDTLS_ECP_ADD_MIXED_ALT */
+
+#if defined(MBEDTLS_ECP_NORMALIZE_JAC_ALT)
+/* Normalize jacobian coordinates so that Z == 0 || Z == 1 */
+int mbedtls_internal_ecp_normalize_jac(const mbedtls_ecp_group *grp, mbedtls_ecp_point *pt)
+{
+    int ret;
+    struct {
+        uint32_t X[ECP_MAX_WORDS], Y[ECP_MAX_WORDS], Z[ECP_MAX_WORDS];
+        uint32_t Zi[ECP_MAX_WORDS], ZZi[ECP_MAX_WORDS];
+    } v;
+
+    if (mbedtls_mpi_cmp_int(&pt->Z, 0) == 0) {
+        return 0;
+    }
+
+    mpi_to_fe(v.X, &pt->X);
+    mpi_to_fe(v.Y, &pt->Y);
+    mpi_to_fe(v.Z, &pt->Z);
+
+    /* X = X / Z^2, Y = Y / Z^3 */
+    fe_inv(v.Zi, v.Z);
+    fe_mul(v.ZZi, v.Zi, v.Zi);
+    fe_mul(v.X, v.X, v.ZZi);
+    fe_mul(v.Y, v.Y, v.ZZi);
+    fe_mul(v.Y, v.Y, v.Zi);
+
+    MBEDTLS_MPI_CHK( fe_to_mpi(&pt->X, v.X) );
+    MBEDTLS_MPI_CHK( fe_to_mpi(&pt->Y, v.Y) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_lset(&pt->Z, 1) );
+
+ cleanup:
+    mbedtls_platform_zeroize(&v, sizeof(v));
+    return ret;
+}
+#endif /* MBEDTLS_ECP_NORMALIZE_JAC_ALT */
+
+#if defined(MBEDTLS_ECP_NORMALIZE_JAC_MANY_ALT)
+/* Normalize jacobian coordinates of an array of (pointers to) points,
+ * using Montgomery's trick to perform only one inversion mod P, like
+ * ecp_normalize_jac_many() in ecp.c. All Z coordinates must be non-zero.
+ */
+int mbedtls_internal_ecp_normalize_jac_many(const mbedtls_ecp_group *grp,
+                                            mbedtls_ecp_point *T[], size_t t_len)
+{
+    int ret = 0;
+    size_t words = ecp_hw.words;
+    uint32_t *c;
+    struct {
+        uint32_t X[ECP_MAX_WORDS], Y[ECP_MAX_WORDS], Z[ECP_MAX_WORDS];
+        uint32_t u[ECP_MAX_WORDS], Zi[ECP_MAX_WORDS], ZZi[ECP_MAX_WORDS];
+    } v;
+
+    if (t_len < 2) {
+        return mbedtls_internal_ecp_normalize_jac(grp, *T);
+    }
+
+    /* c[i] = Z_0 * ... * Z_i */
+    c = mbedtls_calloc(t_len, words * ciL);
+    if (c == NULL) {
+        return MBEDTLS_ERR_ECP_ALLOC_FAILED;
+    }
+    mpi_to_fe(c, &T[0]->Z);
+    for (size_t i = 1; i < t_len; i++) {
+        mpi_to_fe(v.Z, &T[i]->Z);
+        fe_mul(&c[i * words], &c[(i - 1) * words], v.Z);
+    }
+
+    /* u = 1 / (Z_0 * ... * Z_n) mod P */
+    fe_inv(v.u, &c[(t_len - 1) * words]);
+
+    for (size_t i = t_len - 1; ; i--) {
+        mpi_to_fe(v.X, &T[i]->X);
+        mpi_to_fe(v.Y, &T[i]->Y);
+
+        /* Zi = 1 / Z_i mod p
+         * u = 1 / (Z_0 * ... * Z_i) mod P
+         */
+        if (i == 0) {
+            memcpy(v.Zi, v.u, words * ciL);
+        } else {
+            mpi_to_fe(v.Z, &T[i]->Z);
+            fe_mul(v.Zi, v.u, &c[(i - 1) * words]);
+            fe_mul(v.u, v.u, v.Z);
+        }
+
+        /* proceed as in normalize() */
+        fe_mul(v.ZZi, v.Zi, v.Zi);
+        fe_mul(v.X, v.X, v.ZZi);
+        fe_mul(v.Y, v.Y, v.ZZi);
+        fe_mul(v.Y, v.Y, v.Zi);
+
+        MBEDTLS_MPI_CHK( fe_to_mpi(&T[i]->X, v.X) );
+        MBEDTLS_MPI_CHK( fe_to_mpi(&T[i]->Y, v.Y) );
+
+        /* Post-processing: reclaim some memory by shrinking coordinates */
+        MBEDTLS_MPI_CHK( mbedtls_mpi_shrink(&T[i]->X, grp->P.n) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_shrink(&T[i]->Y, grp->P.n) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_lset(&T[i]->Z, 1) );
+
+        if (i == 0) {
+            break;
+        }
+    }
+
+ cleanup:
+    mbedtls_platform_zeroize(c, t_len * words * ciL);
+    mbedtls_free(c);
+    mbedtls_platform_zeroize(&v, sizeof(v));
+    return ret;
+}
+#endif /* MBEDTLS_ECP_NORMALIZE_JAC_MANY_ALT */
+
+#if defined(MBEDTLS_ECP_RANDOMIZE_MXZ_ALT)
+/* Randomize projective x/z coordinates: (X, Z) -> (l X, l Z) for random l */
+int mbedtls_internal_ecp_randomize_mxz(const mbedtls_ecp_group *grp, mbedtls_ecp_point *pt,
+                                       int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
+{
+    int ret;
+    struct {
+        uint32_t X[ECP_MAX_WORDS], Z[ECP_MAX_WORDS], l[ECP_MAX_WORDS];
+    } v;
+
+    MBEDTLS_MPI_CHK( fe_random(grp, v.l, f_rng, p_rng) );
+
+    mpi_to_fe(v.X, &pt->X);
+    mpi_to_fe(v.Z, &pt->Z);
+
+    fe_mul(v.X, v.X, v.l);
+    fe_mul(v.Z, v.Z, v.l);
+
+    MBEDTLS_MPI_CHK( fe_to_mpi(&pt->X, v.X) );
+    MBEDTLS_MPI_CHK( fe_to_mpi(&pt->Z, v.Z) );
+
+ cleanup:
+    mbedtls_platform_zeroize(&v, sizeof(v));
+    return ret;
+}
+#endif /* MBEDTLS_ECP_RANDOMIZE_MXZ_ALT */
+
+#if defined(MBEDTLS_ECP_DOUBLE_ADD_MXZ_ALT)
+/* d is the x coordinate of the input point of the Montgomery ladder, which
+   ecp.c doesn't reduce (X25519 public keys can be up to 2^255 - 1) */
+static int mpi_to_fe_reduced(uint32_t *a, const mbedtls_mpi *X, const mbedtls_ecp_group *grp)
+{
+    int ret = 0;
+    mbedtls_mpi T;
+
+    if (mbedtls_mpi_cmp_mpi(X, &grp->P) < 0) {
+        mpi_to_fe(a, X);
+        return 0;
+    }
+
+    mbedtls_mpi_init(&T);
+    MBEDTLS_MPI_CHK( mbedtls_mpi_copy(&T, X) );
+    while (mbedtls_mpi_cmp_mpi(&T, &grp->P) >= 0) {
+        MBEDTLS_MPI_CHK( mbedtls_mpi_sub_abs(&T, &T, &grp->P) );
+    }
+    mpi_to_fe(a, &T);
+
+ cleanup:
+    mbedtls_mpi_free(&T);
+    return ret;
+}
+
+/* One step of the Montgomery ladder, same formulas as ecp_double_add_mxz() in ecp.c:
+   R = 2P, S = P + Q, with d = X(P - Q) and grp->A = (A + 2) / 4.
+   P and Q may be the same points as R and S.
+*/
+int mbedtls_internal_ecp_double_add_mxz(const mbedtls_ecp_group *grp,
+                                        mbedtls_ecp_point *R, mbedtls_ecp_point *S,
+                                        const mbedtls_ecp_point *P, const mbedtls_ecp_point *Q,
+                                        const mbedtls_mpi *d)
+{
+    int ret;
+    struct {
+        uint32_t PX[ECP_MAX_WORDS], PZ[ECP_MAX_WORDS], QX[ECP_MAX_WORDS], QZ[ECP_MAX_WORDS];
+        uint32_t d[ECP_MAX_WORDS];
+        uint32_t A[ECP_MAX_WORDS], AA[ECP_MAX_WORDS], B[ECP_MAX_WORDS], BB[ECP_MAX_WORDS];
+        uint32_t E[ECP_MAX_WORDS], C[ECP_MAX_WORDS], D[ECP_MAX_WORDS];
+        uint32_t DA[ECP_MAX_WORDS], CB[ECP_MAX_WORDS], T[ECP_MAX_WORDS];
+    } v;
+
+    MBEDTLS_MPI_CHK( mpi_to_fe_reduced(v.d, d, grp) );
+    mpi_to_fe(v.PX, &P->X);
+    mpi_to_fe(v.PZ, &P->Z);
+    mpi_to_fe(v.QX, &Q->X);
+    mpi_to_fe(v.QZ, &Q->Z);
+
+    fe_add(v.A, v.PX, v.PZ);
+    fe_mul(v.AA, v.A, v.A);
+    fe_sub(v.B, v.PX, v.PZ);
+    fe_mul(v.BB, v.B, v.B);
+    fe_sub(v.E, v.AA, v.BB);
+    fe_add(v.C, v.QX, v.QZ);
+    fe_sub(v.D, v.QX, v.QZ);
+    fe_mul(v.DA, v.D, v.A);
+    fe_mul(v.CB, v.C, v.B);
+
+    /* S.X = (DA + CB)^2, S.Z = d (DA - CB)^2 */
+    fe_add(v.T, v.DA, v.CB);
+    fe_mul(v.T, v.T, v.T);
+    MBEDTLS_MPI_CHK( fe_to_mpi(&S->X, v.T) );
+    fe_sub(v.T, v.DA, v.CB);
+    fe_mul(v.T, v.T, v.T);
+    fe_mul(v.T, v.d, v.T);
+    MBEDTLS_MPI_CHK( fe_to_mpi(&S->Z, v.T) );
+
+    /* R.X = AA.BB, R.Z = E (BB + A.E) */
+    fe_mul(v.T, v.AA, v.BB);
+    MBEDTLS_MPI_CHK( fe_to_mpi(&R->X, v.T) );
+    fe_mul(v.T, ecp_hw.a, v.E);
+    fe_add(v.T, v.BB, v.T);
+    fe_mul(v.T, v.E, v.T);
+    MBEDTLS_MPI_CHK( fe_to_mpi(&R->Z, v.T) );
+
+ cleanup:
+    mbedtls_platform_zeroize(&v, sizeof(v));
+    return ret;
+}
+#endif /* MBEDTLS_ECP_DOUBLE_ADD_MXZ_ALT */
+
+#if defined(MBEDTLS_ECP_NORMALIZE_MXZ_ALT)
+/* Normalize Montgomery x/z coordinates: X = X/Z, Z = 1 */
+int mbedtls_internal_ecp_normalize_mxz(const mbedtls_ecp_group *grp, mbedtls_ecp_point *pt)
+{
+    int ret;
+    struct {
+        uint32_t X[ECP_MAX_WORDS], Z[ECP_MAX_WORDS], Zi[ECP_MAX_WORDS];
+    } v;
+
+    mpi_to_fe(v.X, &pt->X);
+    mpi_to_fe(v.Z, &pt->Z);
+
+    /* Z^(P - 2) of zero is zero, fail like mbedtls_mpi_inv_mod() does in software,
+       so a result at infinity isn't taken for a point with X = 0 */
+    if (fe_is_zero(v.Z)) {
+        ret = MBEDTLS_ERR_MPI_NOT_ACCEPTABLE;
+        goto cleanup;
+    }
+
+    fe_inv(v.Zi, v.Z);
+    fe_mul(v.X, v.X, v.Zi);
+
+    MBEDTLS_MPI_CHK( fe_to_mpi(&pt->X, v.X) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_lset(&pt->Z, 1) );
+
+ cleanup:
+    mbedtls_platform_zeroize(&v, sizeof(v));
+    return ret;
+}
+#endif /* MBEDTLS_ECP_NORMALIZE_MXZ_ALT */
+
+#endif /* MBEDTLS_ECP_INTERNAL_ALT */
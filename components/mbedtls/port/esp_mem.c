@@ -1,4 +1,4 @@
-// Copyright 2018 Espressif Systems (Shanghai) PTE LTD
+// Copyright 2018-2019 Espressif Systems (Shanghai) PTE LTD
 //
 // Licensed under the Apache License, Version 2.0 (the "License");
 // you may not use this file except in compliance with the License.
@@ -12,14 +12,16 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <string.h>
 #include <esp_attr.h>
 #include <esp_heap_caps.h>
 #include <sdkconfig.h>
+#include "freertos/FreeRTOS.h"
 #include "esp_mem.h"
 
 #ifndef CONFIG_MBEDTLS_CUSTOM_MEM_ALLOC
 
-IRAM_ATTR void *esp_mbedtls_mem_calloc(size_t n, size_t size)
+static IRAM_ATTR void *heap_calloc(size_t n, size_t size)
 {
 #ifdef CONFIG_MBEDTLS_INTERNAL_MEM_ALLOC
     return heap_caps_calloc(n, size, MALLOC_CAP_INTERNAL|MALLOC_CAP_8BIT);
@@ -30,9 +32,181 @@ IRAM_ATTR void *esp_mbedtls_mem_calloc(size_t n, size_t size)
 #endif
 }
 
+#ifndef CONFIG_MBEDTLS_MEM_POOL
+
+IRAM_ATTR void *esp_mbedtls_mem_calloc(size_t n, size_t size)
+{
+    return heap_calloc(n, size);
+}
+
 IRAM_ATTR void esp_mbedtls_mem_free(void *ptr)
 {
     return heap_caps_free(ptr);
 }
 
+#else /* CONFIG_MBEDTLS_MEM_POOL */
+
+/* Small allocations (bignum limbs, ASN.1 and X.509 parsing, handshake
+ * state) are served from chunks of CONFIG_MBEDTLS_MEM_POOL_CHUNK_SIZE bytes,
+ * each split into blocks of one size class. A chunk is given back to the
+ * heap as soon as its last block is freed, which for handshake temporaries
+ * is at the end of the handshake, so they don't leave holes between the
+ * long lived record buffers of the sessions.
+ *
+ * Every allocation is preceded by one word pointing to its chunk, or NULL
+ * if it came from the heap directly.
+ */
+
+typedef struct pool_chunk {
+    struct pool_chunk *next;
+    void *free_blocks;          /* blocks are linked through their first payload word */
+    uint16_t block_size;        /* including the header word */
+    uint16_t used;
+} pool_chunk_t;
+
+#define HEADER_SIZE sizeof(pool_chunk_t *)
+
+static const uint16_t class_sizes[] = { 32, 64, 128, 256, 512 };
+#define NUM_CLASSES (sizeof(class_sizes) / sizeof(class_sizes[0]))
+
+/* chunks with at least one free block, per size class */
+static pool_chunk_t *partial_chunks[NUM_CLASSES];
+static esp_mbedtls_mem_pool_stats_t stats;
+static portMUX_TYPE pool_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static IRAM_ATTR void *heap_alloc_with_header(size_t size)
+{
+    pool_chunk_t **block = heap_calloc(1, HEADER_SIZE + size);
+    if (block == NULL) {
+        return NULL;
+    }
+    *block = NULL;
+    return block + 1;
+}
+
+/* Take a block from the first partial chunk of a class, called with pool_lock held */
+static IRAM_ATTR void *take_block(int class)
+{
+    pool_chunk_t *chunk = partial_chunks[class];
+    if (chunk == NULL) {
+        return NULL;
+    }
+    pool_chunk_t **block = chunk->free_blocks;
+    chunk->free_blocks = block[1];
+    chunk->used++;
+    if (chunk->free_blocks == NULL) {
+        partial_chunks[class] = chunk->next;
+    }
+    stats.blocks++;
+    *block = chunk;
+    return block + 1;
+}
+
+static IRAM_ATTR pool_chunk_t *new_chunk(int class)
+{
+    pool_chunk_t *chunk = heap_calloc(1, CONFIG_MBEDTLS_MEM_POOL_CHUNK_SIZE);
+    if (chunk == NULL) {
+        return NULL;
+    }
+    chunk->block_size = class_sizes[class] + HEADER_SIZE;
+    uint8_t *first = (uint8_t *)(chunk + 1);
+    int num_blocks = (CONFIG_MBEDTLS_MEM_POOL_CHUNK_SIZE - sizeof(pool_chunk_t)) / chunk->block_size;
+    void *next = NULL;
+    /* link the blocks so that they are handed out in address order */
+    for (int i = num_blocks - 1; i >= 0; i--) {
+        void **block = (void **)(first + i * chunk->block_size);
+        block[1] = next;
+        next = block;
+    }
+    chunk->free_blocks = next;
+    return chunk;
+}
+
+IRAM_ATTR void *esp_mbedtls_mem_calloc(size_t n, size_t size)
+{
+    if (size != 0 && n > (SIZE_MAX - HEADER_SIZE) / size) {
+        return NULL;
+    }
+    size_t total = n * size;
+    int class = 0;
+    while (class < NUM_CLASSES && total > class_sizes[class]) {
+        class++;
+    }
+    if (class == NUM_CLASSES) {
+        return heap_alloc_with_header(total);
+    }
+
+    portENTER_CRITICAL(&pool_lock);
+    void *ptr = take_block(class);
+    portEXIT_CRITICAL(&pool_lock);
+    if (ptr == NULL) {
+        /* allocate the chunk outside of the critical section */
+        pool_chunk_t *chunk = new_chunk(class);
+        if (chunk == NULL) {
+            return heap_alloc_with_header(total);
+        }
+        portENTER_CRITICAL(&pool_lock);
+        chunk->next = partial_chunks[class];
+        partial_chunks[class] = chunk;
+        stats.chunks++;
+        if (stats.chunks > stats.peak_chunks) {
+            stats.peak_chunks = stats.chunks;
+        }
+        ptr = take_block(class);
+        portEXIT_CRITICAL(&pool_lock);
+    }
+    memset(ptr, 0, total);
+    return ptr;
+}
+
+IRAM_ATTR void esp_mbedtls_mem_free(void *ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+    pool_chunk_t **block = (pool_chunk_t **)ptr - 1;
+    pool_chunk_t *chunk = *block;
+    if (chunk == NULL) {
+        heap_caps_free(block);
+        return;
+    }
+
+    int class = 0;
+    while (class_sizes[class] + HEADER_SIZE != chunk->block_size) {
+        class++;
+    }
+    portENTER_CRITICAL(&pool_lock);
+    stats.blocks--;
+    if (chunk->free_blocks == NULL) {
+        /* the chunk was full, it has a free block again */
+        chunk->next = partial_chunks[class];
+        partial_chunks[class] = chunk;
+    }
+    block[1] = chunk->free_blocks;
+    chunk->free_blocks = block;
+    if (--chunk->used == 0) {
+        pool_chunk_t **p = &partial_chunks[class];
+        while (*p != chunk) {
+            p = &(*p)->next;
+        }
+        *p = chunk->next;
+        stats.chunks--;
+    } else {
+        chunk = NULL;
+    }
+    portEXIT_CRITICAL(&pool_lock);
+    if (chunk != NULL) {
+        heap_caps_free(chunk);
+    }
+}
+
+void esp_mbedtls_mem_pool_get_stats(esp_mbedtls_mem_pool_stats_t *out)
+{
+    portENTER_CRITICAL(&pool_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&pool_lock);
+}
+
+#endif /* CONFIG_MBEDTLS_MEM_POOL */
+
 #endif /* !CONFIG_MBEDTLS_CUSTOM_MEM_ALLOC */
@@ -88,7 +88,7 @@ void mbedtls_sha1_free( mbedtls_sha1_context *ctx )
         return;
 
     if (ctx->mode == ESP_MBEDTLS_SHA1_HARDWARE) {
-        esp_sha_unlock_engine(SHA1);
+        esp_sha_shared_release(SHA1, ctx->state);
     }
     mbedtls_zeroize( ctx, sizeof( mbedtls_sha1_context ) );
 }
@@ -102,7 +102,7 @@ void mbedtls_sha1_clone( mbedtls_sha1_context *dst,
         /* Copy hardware digest state out to cloned state,
            which will be a software digest.
         */
-        esp_sha_read_digest_state(SHA1, dst->state);
+        esp_sha_shared_read_digest_state(SHA1, src->state, dst->state);
         dst->mode = ESP_MBEDTLS_SHA1_SOFTWARE;
     }
 }
@@ -123,7 +123,7 @@ int mbedtls_sha1_starts_ret( mbedtls_sha1_context *ctx )
     ctx->state[4] = 0xC3D2E1F0;
 
     if (ctx->mode == ESP_MBEDTLS_SHA1_HARDWARE) {
-        esp_sha_unlock_engine(SHA1);
+        esp_sha_shared_release(SHA1, ctx->state);
     }
     ctx->mode = ESP_MBEDTLS_SHA1_UNUSED;
 
@@ -144,20 +144,21 @@ int mbedtls_internal_sha1_process( mbedtls_sha1_context *ctx, const unsigned cha
     bool first_block = false;
     if (ctx->mode == ESP_MBEDTLS_SHA1_UNUSED) {
         /* try to use hardware for this digest */
-        if (esp_sha_try_lock_engine(SHA1)) {
-            ctx->mode = ESP_MBEDTLS_SHA1_HARDWARE;
-            first_block = true;
-        } else {
-            ctx->mode = ESP_MBEDTLS_SHA1_SOFTWARE;
-        }
+        ctx->mode = ESP_MBEDTLS_SHA1_HARDWARE;
+        first_block = true;
     }
 
     if (ctx->mode == ESP_MBEDTLS_SHA1_HARDWARE) {
-        esp_sha_block(SHA1, data, first_block);
-    } else {
-        mbedtls_sha1_software_process(ctx, data);
+        if (esp_sha_shared_block(SHA1, ctx->state, data, first_block)) {
+            return 0;
+        }
+        /* engine is in use, or was handed over and ctx->state holds the digest so far */
+        ctx->mode = ESP_MBEDTLS_SHA1_SOFTWARE;
     }
 
+    mbedtls_sha1_software_process(ctx, data);
+    esp_sha_count_software_block(SHA1);
+
     return 0;
 }
 
@@ -422,7 +423,7 @@ int mbedtls_sha1_finish_ret( mbedtls_sha1_context *ctx, unsigned char output[20]
 
     /* if state is in hardware, read it out */
     if (ctx->mode == ESP_MBEDTLS_SHA1_HARDWARE) {
-        esp_sha_read_digest_state(SHA1, ctx->state);
+        esp_sha_shared_read_digest_state(SHA1, ctx->state, ctx->state);
     }
 
     PUT_UINT32_BE( ctx->state[0], output,  0 );
@@ -433,7 +434,7 @@ int mbedtls_sha1_finish_ret( mbedtls_sha1_context *ctx, unsigned char output[20]
 
 out:
     if (ctx->mode == ESP_MBEDTLS_SHA1_HARDWARE) {
-        esp_sha_unlock_engine(SHA1);
+        esp_sha_shared_release(SHA1, ctx->state);
         ctx->mode = ESP_MBEDTLS_SHA1_SOFTWARE;
     }
 
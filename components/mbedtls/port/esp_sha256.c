@@ -89,7 +89,7 @@ void mbedtls_sha256_free( mbedtls_sha256_context *ctx )
         return;
 
     if (ctx->mode == ESP_MBEDTLS_SHA256_HARDWARE) {
-        esp_sha_unlock_engine(SHA2_256);
+        esp_sha_shared_release(SHA2_256, ctx->state);
     }
     mbedtls_zeroize( ctx, sizeof( mbedtls_sha256_context ) );
 }
@@ -103,7 +103,7 @@ void mbedtls_sha256_clone( mbedtls_sha256_context *dst,
         /* Copy hardware digest state out to cloned state,
            which will become a software digest.
         */
-        esp_sha_read_digest_state(SHA2_256, dst->state);
+        esp_sha_shared_read_digest_state(SHA2_256, src->state, dst->state);
         dst->mode = ESP_MBEDTLS_SHA256_SOFTWARE;
     }
 }
@@ -143,7 +143,7 @@ int mbedtls_sha256_starts_ret( mbedtls_sha256_context *ctx, int is224 )
 
     ctx->is224 = is224;
     if (ctx->mode == ESP_MBEDTLS_SHA256_HARDWARE) {
-        esp_sha_unlock_engine(SHA2_256);
+        esp_sha_shared_release(SHA2_256, ctx->state);
     }
     ctx->mode = ESP_MBEDTLS_SHA256_UNUSED;
     return 0;
@@ -209,21 +209,22 @@ int mbedtls_internal_sha256_process( mbedtls_sha256_context *ctx, const unsigned
     bool first_block = false;
 
     if (ctx->mode == ESP_MBEDTLS_SHA256_UNUSED) {
-        /* try to use hardware for this digest */
-        if (!ctx->is224 && esp_sha_try_lock_engine(SHA2_256)) {
-            ctx->mode = ESP_MBEDTLS_SHA256_HARDWARE;
-            first_block = true;
-        } else {
-            ctx->mode = ESP_MBEDTLS_SHA256_SOFTWARE;
-        }
+        /* try to use hardware for this digest, the engine doesn't support SHA-224 */
+        ctx->mode = ctx->is224 ? ESP_MBEDTLS_SHA256_SOFTWARE : ESP_MBEDTLS_SHA256_HARDWARE;
+        first_block = true;
     }
 
     if (ctx->mode == ESP_MBEDTLS_SHA256_HARDWARE) {
-        esp_sha_block(SHA2_256, data, first_block);
-    } else {
-        mbedtls_sha256_software_process(ctx, data);
+        if (esp_sha_shared_block(SHA2_256, ctx->state, data, first_block)) {
+            return 0;
+        }
+        /* engine is in use, or was handed over and ctx->state holds the digest so far */
+        ctx->mode = ESP_MBEDTLS_SHA256_SOFTWARE;
     }
 
+    mbedtls_sha256_software_process(ctx, data);
+    esp_sha_count_software_block(SHA2_256);
+
     return 0;
 }
 
@@ -388,7 +389,7 @@ int mbedtls_sha256_finish_ret( mbedtls_sha256_context *ctx, unsigned char output
 
     /* if state is in hardware, read it out */
     if (ctx->mode == ESP_MBEDTLS_SHA256_HARDWARE) {
-        esp_sha_read_digest_state(SHA2_256, ctx->state);
+        esp_sha_shared_read_digest_state(SHA2_256, ctx->state, ctx->state);
     }
 
     PUT_UINT32_BE( ctx->state[0], output,  0 );
@@ -404,7 +405,7 @@ int mbedtls_sha256_finish_ret( mbedtls_sha256_context *ctx, unsigned char output
 
 out:
     if (ctx->mode == ESP_MBEDTLS_SHA256_HARDWARE) {
-        esp_sha_unlock_engine(SHA2_256);
+        esp_sha_shared_release(SHA2_256, ctx->state);
         ctx->mode = ESP_MBEDTLS_SHA256_SOFTWARE;
     }
 
@@ -108,7 +108,7 @@ void mbedtls_sha512_free( mbedtls_sha512_context *ctx )
         return;
 
     if (ctx->mode == ESP_MBEDTLS_SHA512_HARDWARE) {
-        esp_sha_unlock_engine(sha_type(ctx));
+        esp_sha_shared_release(sha_type(ctx), ctx->state);
     }
     mbedtls_zeroize( ctx, sizeof( mbedtls_sha512_context ) );
 }
@@ -126,7 +126,7 @@ void mbedtls_sha512_clone( mbedtls_sha512_context *dst,
            (SHA-384 state is identical to SHA-512, only
            digest is truncated.)
         */
-        esp_sha_read_digest_state(SHA2_512, dst->state);
+        esp_sha_shared_read_digest_state(SHA2_512, src->state, dst->state);
         dst->mode = ESP_MBEDTLS_SHA512_SOFTWARE;
     }
 }
@@ -167,7 +167,7 @@ int mbedtls_sha512_starts_ret( mbedtls_sha512_context *ctx, int is384 )
 
     ctx->is384 = is384;
     if (ctx->mode == ESP_MBEDTLS_SHA512_HARDWARE) {
-        esp_sha_unlock_engine(sha_type(ctx));
+        esp_sha_shared_release(sha_type(ctx), ctx->state);
     }
     ctx->mode = ESP_MBEDTLS_SHA512_UNUSED;
 
@@ -237,20 +237,21 @@ int mbedtls_internal_sha512_process( mbedtls_sha512_context *ctx, const unsigned
 
     if (ctx->mode == ESP_MBEDTLS_SHA512_UNUSED) {
         /* try to use hardware for this digest */
-        if (esp_sha_try_lock_engine(sha_type(ctx))) {
-            ctx->mode = ESP_MBEDTLS_SHA512_HARDWARE;
-            first_block = true;
-        } else {
-            ctx->mode = ESP_MBEDTLS_SHA512_SOFTWARE;
-        }
+        ctx->mode = ESP_MBEDTLS_SHA512_HARDWARE;
+        first_block = true;
     }
 
     if (ctx->mode == ESP_MBEDTLS_SHA512_HARDWARE) {
-        esp_sha_block(sha_type(ctx), data, first_block);
-    } else {
-        mbedtls_sha512_software_process(ctx, data);
+        if (esp_sha_shared_block(sha_type(ctx), ctx->state, data, first_block)) {
+            return 0;
+        }
+        /* engine is in use, or was handed over and ctx->state holds the digest so far */
+        ctx->mode = ESP_MBEDTLS_SHA512_SOFTWARE;
     }
 
+    mbedtls_sha512_software_process(ctx, data);
+    esp_sha_count_software_block(sha_type(ctx));
+
     return 0;
 }
 
@@ -433,7 +434,7 @@ int mbedtls_sha512_finish_ret( mbedtls_sha512_context *ctx, unsigned char output
 
     /* if state is in hardware, read it out */
     if (ctx->mode == ESP_MBEDTLS_SHA512_HARDWARE) {
-        esp_sha_read_digest_state(sha_type(ctx), ctx->state);
+        esp_sha_shared_read_digest_state(sha_type(ctx), ctx->state, ctx->state);
     }
 
     PUT_UINT64_BE( ctx->state[0], output,  0 );
@@ -451,7 +452,7 @@ int mbedtls_sha512_finish_ret( mbedtls_sha512_context *ctx, unsigned char output
 
 out:
     if (ctx->mode == ESP_MBEDTLS_SHA512_HARDWARE) {
-        esp_sha_unlock_engine(sha_type(ctx));
+        esp_sha_shared_release(sha_type(ctx), ctx->state);
         ctx->mode = ESP_MBEDTLS_SHA512_SOFTWARE;
     }
 
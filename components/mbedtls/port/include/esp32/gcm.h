@@ -0,0 +1,193 @@
+/**
+ * \brief AES-GCM, ESP32 hardware accelerated version
+ * Based on mbedTLS GCM implementation.
+ *
+ *  Copyright (C) 2006-2015, ARM Limited, All Rights Reserved
+ *  Additions Copyright (C) 2019, Espressif Systems (Shanghai) PTE Ltd
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#ifndef ESP_GCM_H
+#define ESP_GCM_H
+
+#include "mbedtls/cipher.h"
+#include "esp32/aes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief          AES-GCM context structure
+ */
+typedef struct {
+    esp_aes_context aes_ctx;    /*!< The AES key */
+    uint64_t HL[16];            /*!< Precalculated HTable low */
+    uint64_t HH[16];            /*!< Precalculated HTable high */
+    uint64_t len;               /*!< The total length of the encrypted data */
+    uint64_t add_len;           /*!< The total length of the additional data */
+    unsigned char base_ectr[16];/*!< The first ECTR for tag */
+    unsigned char y[16];        /*!< The Y working value */
+    unsigned char buf[16];      /*!< The buf working value */
+    int mode;                   /*!< ESP_AES_ENCRYPT or ESP_AES_DECRYPT */
+} esp_gcm_context;
+
+/**
+ * \brief          Initialize AES-GCM context
+ *
+ * \param ctx      AES-GCM context to be initialized
+ */
+void esp_aes_gcm_init( esp_gcm_context *ctx );
+
+/**
+ * \brief          AES-GCM key schedule
+ *
+ * \param ctx      AES-GCM context to be set up
+ * \param cipher   Cipher to use, only MBEDTLS_CIPHER_ID_AES is supported
+ * \param key      Encryption key
+ * \param keybits  Must be 128, 192 or 256
+ *
+ * \return         0 if successful, MBEDTLS_ERR_GCM_BAD_INPUT or ERR_ESP_AES_INVALID_KEY_LENGTH on failure
+ */
+int esp_aes_gcm_setkey( esp_gcm_context *ctx,
+                        mbedtls_cipher_id_t cipher,
+                        const unsigned char *key,
+                        unsigned int keybits );
+
+/**
+ * \brief          AES-GCM buffer encryption/decryption with authentication tag
+ *
+ * Same as mbedtls_gcm_crypt_and_tag(). For decryption, use esp_aes_gcm_auth_decrypt() instead,
+ * which checks the tag.
+ *
+ * \param ctx       AES-GCM context
+ * \param mode      ESP_AES_ENCRYPT or ESP_AES_DECRYPT
+ * \param length    Length of the input data
+ * \param iv        Initialization vector
+ * \param iv_len    Length of the IV
+ * \param add       Additional data
+ * \param add_len   Length of the additional data
+ * \param input     Input data
+ * \param output    Output data, can be the same as input
+ * \param tag_len   Length of the tag to generate, 4 to 16 bytes
+ * \param tag       Buffer to write the tag to
+ *
+ * \return         0 if successful, MBEDTLS_ERR_GCM_BAD_INPUT on invalid arguments
+ */
+int esp_aes_gcm_crypt_and_tag( esp_gcm_context *ctx,
+                               int mode,
+                               size_t length,
+                               const unsigned char *iv,
+                               size_t iv_len,
+                               const unsigned char *add,
+                               size_t add_len,
+                               const unsigned char *input,
+                               unsigned char *output,
+                               size_t tag_len,
+                               unsigned char *tag );
+
+/**
+ * \brief          AES-GCM buffer decryption and authentication
+ *
+ * Same as mbedtls_gcm_auth_decrypt().
+ *
+ * \param ctx       AES-GCM context
+ * \param length    Length of the input data
+ * \param iv        Initialization vector
+ * \param iv_len    Length of the IV
+ * \param add       Additional data
+ * \param add_len   Length of the additional data
+ * \param tag       Tag to verify
+ * \param tag_len   Length of the tag
+ * \param input     Input data
+ * \param output    Output data, can be the same as input
+ *
+ * \return         0 if successful and authenticated, MBEDTLS_ERR_GCM_AUTH_FAILED if the tag does not match
+ *                 (output is zeroed then), MBEDTLS_ERR_GCM_BAD_INPUT on invalid arguments
+ */
+int esp_aes_gcm_auth_decrypt( esp_gcm_context *ctx,
+                              size_t length,
+                              const unsigned char *iv,
+                              size_t iv_len,
+                              const unsigned char *add,
+                              size_t add_len,
+                              const unsigned char *tag,
+                              size_t tag_len,
+                              const unsigned char *input,
+                              unsigned char *output );
+
+/**
+ * \brief          Start an AES-GCM encryption or decryption operation
+ *
+ * \param ctx       AES-GCM context
+ * \param mode      ESP_AES_ENCRYPT or ESP_AES_DECRYPT
+ * \param iv        Initialization vector
+ * \param iv_len    Length of the IV
+ * \param add       Additional data
+ * \param add_len   Length of the additional data
+ *
+ * \return         0 if successful, MBEDTLS_ERR_GCM_BAD_INPUT on invalid arguments
+ */
+int esp_aes_gcm_starts( esp_gcm_context *ctx,
+                        int mode,
+                        const unsigned char *iv,
+                        size_t iv_len,
+                        const unsigned char *add,
+                        size_t add_len );
+
+/**
+ * \brief          Encrypt or decrypt data in an AES-GCM operation
+ *
+ * The data is encrypted or decrypted with the AES hardware, which is held for the whole call.
+ * All calls but the last must have a multiple of 16 bytes.
+ *
+ * \param ctx       AES-GCM context
+ * \param length    Length of the input data
+ * \param input     Input data
+ * \param output    Output data, can be the same as input
+ *
+ * \return         0 if successful, MBEDTLS_ERR_GCM_BAD_INPUT on invalid arguments
+ */
+int esp_aes_gcm_update( esp_gcm_context *ctx,
+                        size_t length,
+                        const unsigned char *input,
+                        unsigned char *output );
+
+/**
+ * \brief          Finish an AES-GCM operation and generate the tag
+ *
+ * \param ctx       AES-GCM context
+ * \param tag       Buffer to write the tag to
+ * \param tag_len   Length of the tag to generate, 4 to 16 bytes
+ *
+ * \return         0 if successful, MBEDTLS_ERR_GCM_BAD_INPUT on invalid arguments
+ */
+int esp_aes_gcm_finish( esp_gcm_context *ctx,
+                        unsigned char *tag,
+                        size_t tag_len );
+
+/**
+ * \brief          Clear AES-GCM context
+ *
+ * \param ctx      AES-GCM context to be cleared
+ */
+void esp_aes_gcm_free( esp_gcm_context *ctx );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* gcm.h */
@@ -36,6 +36,9 @@
  * - The memory block SHA_TEXT_BASE is shared between all SHA digest
  *   engines, so all engines must be idle before this memory block is
  *   modified.
+ * - Digests using esp_sha_shared_block() can hand an engine over to each
+ *   other by reading out the state of the current digest, which then
+ *   continues in software.
  *
  */
 
@@ -203,6 +206,72 @@ void esp_sha_unlock_memory_block(void);
  */
 void esp_sha_wait_idle(void);
 
+/** @brief Process a SHA block for a digest which shares the SHA engine
+ *
+ * Unlike esp_sha_block(), the engine does not need to be locked
+ * beforehand. The digest takes the engine with its first block, either
+ * because the engine is free or because the engine is handed over from
+ * another shared digest which has only processed a few blocks so far.
+ * In that case, the state of the other digest is read out into its
+ * digest_state buffer, and the other digest continues in software.
+ *
+ * @note The SHA engine can't restore a saved digest state, so a digest
+ * which lost the engine can't get it back until it starts again.
+ *
+ * @param sha_type SHA algorithm to use.
+ * @param digest_state State buffer of the digest, which identifies it.
+ * It must stay valid until esp_sha_shared_release() is called, and it
+ * has the layout returned by esp_sha_read_digest_state() for the
+ * interim state (SHA2_512 for SHA2_384 digests).
+ * @param data_block Pointer to block of data, see esp_sha_block().
+ * @param is_first_block True for the first block of the digest.
+ *
+ * @return true if the block was processed by the SHA engine. false if the
+ * digest doesn't own the engine, the caller should process this and any
+ * following blocks in software starting from digest_state.
+ */
+bool esp_sha_shared_block(esp_sha_type sha_type, void *digest_state, const void *data_block, bool is_first_block);
+
+/** @brief Read out the state of a digest which uses esp_sha_shared_block()
+ *
+ * @param sha_type SHA algorithm in use, see esp_sha_read_digest_state().
+ * @param owner_state State buffer passed to esp_sha_shared_block().
+ * @param digest_state Buffer for the state, may be the same as owner_state.
+ * If the engine was handed over, the state saved in owner_state is copied.
+ *
+ * @return true if the digest still owns the engine.
+ */
+bool esp_sha_shared_read_digest_state(esp_sha_type sha_type, const void *owner_state, void *digest_state);
+
+/** @brief Release the SHA engine from a digest which uses esp_sha_shared_block()
+ *
+ * Does nothing if the engine was handed over to another digest.
+ *
+ * @param sha_type SHA algorithm in use.
+ * @param digest_state State buffer passed to esp_sha_shared_block().
+ */
+void esp_sha_shared_release(esp_sha_type sha_type, const void *digest_state);
+
+/** @brief SHA engine usage counters, see esp_sha_get_usage() */
+typedef struct {
+    uint32_t hardware_blocks;   /*!< Blocks processed by the SHA engine */
+    uint32_t software_blocks;   /*!< Blocks processed in software by the mbedTLS SHA port */
+    uint32_t handovers;         /*!< Times a digest handed its engine over to another digest */
+} esp_sha_usage_t;
+
+/** @brief Count a block which the mbedTLS SHA port processed in software */
+void esp_sha_count_software_block(esp_sha_type sha_type);
+
+/** @brief Read the usage counters of a SHA algorithm
+ *
+ * @param sha_type SHA algorithm.
+ * @param usage Counters since boot or the last esp_sha_reset_usage().
+ */
+void esp_sha_get_usage(esp_sha_type sha_type, esp_sha_usage_t *usage);
+
+/** @brief Reset the usage counters of all SHA algorithms */
+void esp_sha_reset_usage(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,4 +1,4 @@
-// Copyright 2018 Espressif Systems (Shanghai) PTE LTD
+// Copyright 2018-2019 Espressif Systems (Shanghai) PTE LTD
 //
 // Licensed under the Apache License, Version 2.0 (the "License");
 // you may not use this file except in compliance with the License.
@@ -18,3 +18,21 @@
 
 void *esp_mbedtls_mem_calloc(size_t n, size_t size);
 void esp_mbedtls_mem_free(void *ptr);
+
+/**
+ * @brief Usage of the mbedTLS memory pool, see CONFIG_MBEDTLS_MEM_POOL
+ */
+typedef struct {
+    size_t chunks;          /*!< Chunks currently allocated from the heap */
+    size_t peak_chunks;     /*!< Largest number of chunks allocated at the same time */
+    size_t blocks;          /*!< Blocks currently handed out from the chunks */
+} esp_mbedtls_mem_pool_stats_t;
+
+/**
+ * @brief Get the usage of the mbedTLS memory pool
+ *
+ * Only available if CONFIG_MBEDTLS_MEM_POOL is enabled.
+ *
+ * @param[out] stats Current usage of the pool
+ */
+void esp_mbedtls_mem_pool_get_stats(esp_mbedtls_mem_pool_stats_t *stats);
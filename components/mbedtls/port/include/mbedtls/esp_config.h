@@ -254,6 +254,10 @@
 #define MBEDTLS_AES_ALT
 #endif
 
+#ifdef CONFIG_MBEDTLS_HARDWARE_GCM
+#define MBEDTLS_GCM_ALT
+#endif
+
 /* MBEDTLS_SHAxx_ALT to enable hardware SHA support
    with software fallback.
 */
@@ -272,6 +276,21 @@
 #define MBEDTLS_MPI_MUL_MPI_ALT
 #endif
 
+/* Elliptic curve point arithmetic using the MPI hardware, see
+   esp_bignum.c. The scalar multiplication itself stays in ecp.c.
+*/
+#ifdef CONFIG_MBEDTLS_HARDWARE_ECP
+#define MBEDTLS_ECP_INTERNAL_ALT
+#define MBEDTLS_ECP_RANDOMIZE_JAC_ALT
+#define MBEDTLS_ECP_ADD_MIXED_ALT
+#define MBEDTLS_ECP_DOUBLE_JAC_ALT
+#define MBEDTLS_ECP_NORMALIZE_JAC_MANY_ALT
+#define MBEDTLS_ECP_NORMALIZE_JAC_ALT
+#define MBEDTLS_ECP_RANDOMIZE_MXZ_ALT
+#define MBEDTLS_ECP_DOUBLE_ADD_MXZ_ALT
+#define MBEDTLS_ECP_NORMALIZE_MXZ_ALT
+#endif
+
 /**
  * \def MBEDTLS_MD2_PROCESS_ALT
  *
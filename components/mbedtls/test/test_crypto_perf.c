@@ -0,0 +1,399 @@
+/* mbedTLS crypto benchmarks
+
+   Report cycles per byte and operations per second of the ESP32 crypto
+   ports (or of the mbedTLS software implementations, if the hardware
+   acceleration is disabled in config), at several message sizes, and the
+   throughput when both cores run crypto at the same time.
+
+   The item names include "hw" or "sw" for the backend. Build the unit test
+   app with the "crypto_no_hw" config to get the software numbers of the
+   same cases.
+*/
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <sys/param.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/xtensa_api.h"
+#include "mbedtls/aes.h"
+#include "mbedtls/gcm.h"
+#include "mbedtls/sha1.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/sha512.h"
+#include "mbedtls/bignum.h"
+#include "mbedtls/ecdsa.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "esp32/sha.h"
+#include "unity.h"
+#include "test_utils.h"
+#include "sdkconfig.h"
+
+#ifdef CONFIG_MBEDTLS_HARDWARE_AES
+#define AES_BACKEND "hw"
+#else
+#define AES_BACKEND "sw"
+#endif
+#ifdef CONFIG_MBEDTLS_HARDWARE_GCM
+#define GCM_BACKEND "hw"
+#else
+#define GCM_BACKEND "sw"
+#endif
+#ifdef CONFIG_MBEDTLS_HARDWARE_SHA
+#define SHA_BACKEND "hw"
+#else
+#define SHA_BACKEND "sw"
+#endif
+#ifdef CONFIG_MBEDTLS_HARDWARE_MPI
+#define MPI_BACKEND "hw"
+#else
+#define MPI_BACKEND "sw"
+#endif
+#ifdef CONFIG_MBEDTLS_HARDWARE_ECP
+#define ECP_BACKEND "hw"
+#else
+#define ECP_BACKEND MPI_BACKEND
+#endif
+
+#define BENCH_MAX_LEN 4096
+/* bytes processed per measurement, at least */
+#define BENCH_BYTES 32768
+
+static const size_t bench_sizes[] = { 16, 64, 256, 1024, BENCH_MAX_LEN };
+
+typedef void (*bench_op_t)(uint8_t *buf, size_t len);
+
+static uint8_t *alloc_buf(void)
+{
+    uint8_t *buf = heap_caps_malloc(BENCH_MAX_LEN + 64, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(buf);
+    for (int i = 0; i < BENCH_MAX_LEN + 64; i++) {
+        buf[i] = i;
+    }
+    return buf;
+}
+
+static void bench_bytes(const char *name, const char *backend, bench_op_t op)
+{
+    char item[64];
+    uint8_t *buf = alloc_buf();
+    for (int i = 0; i < sizeof(bench_sizes) / sizeof(bench_sizes[0]); i++) {
+        size_t len = bench_sizes[i];
+        int reps = MAX(8, BENCH_BYTES / len);
+        op(buf, len); /* warm up the cache and any lazy initialisation */
+        int64_t start_us = esp_timer_get_time();
+        uint32_t start = xthal_get_ccount();
+        for (int r = 0; r < reps; r++) {
+            op(buf, len);
+        }
+        uint32_t cycles = xthal_get_ccount() - start;
+        int64_t us = esp_timer_get_time() - start_us;
+        snprintf(item, sizeof(item), "%s %s %dB", name, backend, (int)len);
+        IDF_LOG_PERFORMANCE(item, "%.1f cycles/byte", (double)cycles / ((double)reps * len));
+        IDF_LOG_PERFORMANCE(item, "%d ops/s", (int)(reps * 1000000LL / us));
+    }
+    free(buf);
+}
+
+/* Run op for at least min_us, return operations per second */
+static double bench_ops_per_sec(void (*op)(void *), void *ctx, int64_t min_us)
+{
+    op(ctx);
+    int reps = 0;
+    int64_t start_us = esp_timer_get_time();
+    int64_t us;
+    do {
+        op(ctx);
+        reps++;
+        us = esp_timer_get_time() - start_us;
+    } while (us < min_us);
+    return reps * 1000000.0 / us;
+}
+
+static mbedtls_aes_context bench_aes;
+static mbedtls_gcm_context bench_gcm;
+static const uint8_t bench_key[32] = "benchmark key benchmark key 1234";
+
+static void aes_ecb_op(uint8_t *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i += 16) {
+        mbedtls_aes_crypt_ecb(&bench_aes, MBEDTLS_AES_ENCRYPT, buf + i, buf + i);
+    }
+}
+
+static void aes_cbc_op(uint8_t *buf, size_t len)
+{
+    uint8_t iv[16] = { 0 };
+    mbedtls_aes_crypt_cbc(&bench_aes, MBEDTLS_AES_ENCRYPT, len, iv, buf, buf);
+}
+
+static void aes_ctr_op(uint8_t *buf, size_t len)
+{
+    uint8_t nonce[16] = { 0 };
+    uint8_t stream[16];
+    size_t nc_off = 0;
+    mbedtls_aes_crypt_ctr(&bench_aes, len, &nc_off, nonce, stream, buf, buf);
+}
+
+static void gcm_op(uint8_t *buf, size_t len)
+{
+    uint8_t iv[12] = { 0 };
+    uint8_t tag[16];
+    mbedtls_gcm_crypt_and_tag(&bench_gcm, MBEDTLS_GCM_ENCRYPT, len, iv, sizeof(iv), NULL, 0, buf, buf, sizeof(tag), tag);
+}
+
+TEST_CASE("mbedtls AES performance", "[aes][perf]")
+{
+    mbedtls_aes_init(&bench_aes);
+    TEST_ASSERT_EQUAL(0, mbedtls_aes_setkey_enc(&bench_aes, bench_key, 128));
+    bench_bytes("AES-128-ECB", AES_BACKEND, aes_ecb_op);
+    bench_bytes("AES-128-CBC", AES_BACKEND, aes_cbc_op);
+    bench_bytes("AES-128-CTR", AES_BACKEND, aes_ctr_op);
+    TEST_ASSERT_EQUAL(0, mbedtls_aes_setkey_enc(&bench_aes, bench_key, 256));
+    bench_bytes("AES-256-CBC", AES_BACKEND, aes_cbc_op);
+    mbedtls_aes_free(&bench_aes);
+
+    mbedtls_gcm_init(&bench_gcm);
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_setkey(&bench_gcm, MBEDTLS_CIPHER_ID_AES, bench_key, 128));
+    bench_bytes("AES-128-GCM", GCM_BACKEND, gcm_op);
+    mbedtls_gcm_free(&bench_gcm);
+}
+
+static void sha1_op(uint8_t *buf, size_t len)
+{
+    mbedtls_sha1_ret(buf, len, buf + BENCH_MAX_LEN);
+}
+
+static void sha256_op(uint8_t *buf, size_t len)
+{
+    mbedtls_sha256_ret(buf, len, buf + BENCH_MAX_LEN, false);
+}
+
+static void sha512_op(uint8_t *buf, size_t len)
+{
+    mbedtls_sha512_ret(buf, len, buf + BENCH_MAX_LEN, false);
+}
+
+TEST_CASE("mbedtls SHA performance", "[hw_crypto][perf]")
+{
+    bench_bytes("SHA-1", SHA_BACKEND, sha1_op);
+    bench_bytes("SHA-256", SHA_BACKEND, sha256_op);
+    bench_bytes("SHA-512", SHA_BACKEND, sha512_op);
+}
+
+typedef struct {
+    mbedtls_mpi X, E, N, Z;
+} exp_mod_bench_t;
+
+static void exp_mod_op(void *ctx)
+{
+    exp_mod_bench_t *b = ctx;
+    TEST_ASSERT_EQUAL(0, mbedtls_mpi_exp_mod(&b->Z, &b->X, &b->E, &b->N, NULL));
+}
+
+static int myrand(void *rng_state, unsigned char *output, size_t len)
+{
+    esp_fill_random(output, len);
+    return 0;
+}
+
+static void bench_exp_mod(int bits, bool private_key)
+{
+    exp_mod_bench_t b;
+    char item[64];
+    mbedtls_mpi_init(&b.X);
+    mbedtls_mpi_init(&b.E);
+    mbedtls_mpi_init(&b.N);
+    mbedtls_mpi_init(&b.Z);
+    /* a random odd modulus performs like an RSA modulus of the same size */
+    TEST_ASSERT_EQUAL(0, mbedtls_mpi_fill_random(&b.N, bits / 8, myrand, NULL));
+    TEST_ASSERT_EQUAL(0, mbedtls_mpi_set_bit(&b.N, bits - 1, 1));
+    TEST_ASSERT_EQUAL(0, mbedtls_mpi_set_bit(&b.N, 0, 1));
+    TEST_ASSERT_EQUAL(0, mbedtls_mpi_fill_random(&b.X, bits / 8 - 1, myrand, NULL));
+    if (private_key) {
+        TEST_ASSERT_EQUAL(0, mbedtls_mpi_fill_random(&b.E, bits / 8 - 1, myrand, NULL));
+    } else {
+        TEST_ASSERT_EQUAL(0, mbedtls_mpi_lset(&b.E, 65537));
+    }
+    snprintf(item, sizeof(item), "RSA-%d %s %s", bits, private_key ? "private (no CRT)" : "public", MPI_BACKEND);
+    IDF_LOG_PERFORMANCE(item, "%.1f ops/s", bench_ops_per_sec(exp_mod_op, &b, 1000000));
+    mbedtls_mpi_free(&b.X);
+    mbedtls_mpi_free(&b.E);
+    mbedtls_mpi_free(&b.N);
+    mbedtls_mpi_free(&b.Z);
+}
+
+TEST_CASE("mbedtls RSA performance", "[bignum][perf][timeout=60]")
+{
+    bench_exp_mod(1024, false);
+    bench_exp_mod(1024, true);
+    bench_exp_mod(2048, false);
+    bench_exp_mod(2048, true);
+    bench_exp_mod(4096, false);
+}
+
+typedef struct {
+    mbedtls_ecdsa_context ecdsa;
+    mbedtls_ctr_drbg_context ctr_drbg;
+    mbedtls_mpi r, s;
+    uint8_t hash[32];
+} ecdsa_bench_t;
+
+static void ecdsa_sign_op(void *ctx)
+{
+    ecdsa_bench_t *b = ctx;
+    TEST_ASSERT_EQUAL(0, mbedtls_ecdsa_sign(&b->ecdsa.grp, &b->r, &b->s, &b->ecdsa.d, b->hash, sizeof(b->hash),
+                                            mbedtls_ctr_drbg_random, &b->ctr_drbg));
+}
+
+static void ecdsa_verify_op(void *ctx)
+{
+    ecdsa_bench_t *b = ctx;
+    TEST_ASSERT_EQUAL(0, mbedtls_ecdsa_verify(&b->ecdsa.grp, b->hash, sizeof(b->hash), &b->ecdsa.Q, &b->r, &b->s));
+}
+
+static void ecdh_gen_op(void *ctx)
+{
+    ecdsa_bench_t *b = ctx;
+    mbedtls_mpi d;
+    mbedtls_ecp_point Q;
+    mbedtls_mpi_init(&d);
+    mbedtls_ecp_point_init(&Q);
+    TEST_ASSERT_EQUAL(0, mbedtls_ecp_gen_keypair(&b->ecdsa.grp, &d, &Q, mbedtls_ctr_drbg_random, &b->ctr_drbg));
+    mbedtls_mpi_free(&d);
+    mbedtls_ecp_point_free(&Q);
+}
+
+TEST_CASE("mbedtls ECC performance", "[mbedtls][perf][timeout=60]")
+{
+    const struct {
+        mbedtls_ecp_group_id id;
+        const char *name;
+    } curves[] = {
+        { MBEDTLS_ECP_DP_SECP256R1, "P-256" },
+        { MBEDTLS_ECP_DP_SECP384R1, "P-384" },
+    };
+    mbedtls_entropy_context entropy;
+    ecdsa_bench_t *b = calloc(1, sizeof(ecdsa_bench_t));
+    TEST_ASSERT_NOT_NULL(b);
+    char item[64];
+
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&b->ctr_drbg);
+    TEST_ASSERT_EQUAL(0, mbedtls_ctr_drbg_seed(&b->ctr_drbg, mbedtls_entropy_func, &entropy, NULL, 0));
+    for (int c = 0; c < sizeof(curves) / sizeof(curves[0]); c++) {
+        mbedtls_ecdsa_init(&b->ecdsa);
+        mbedtls_mpi_init(&b->r);
+        mbedtls_mpi_init(&b->s);
+        TEST_ASSERT_EQUAL(0, mbedtls_ecdsa_genkey(&b->ecdsa, curves[c].id, mbedtls_ctr_drbg_random, &b->ctr_drbg));
+
+        snprintf(item, sizeof(item), "ECDH %s keypair %s", curves[c].name, ECP_BACKEND);
+        IDF_LOG_PERFORMANCE(item, "%.1f ops/s", bench_ops_per_sec(ecdh_gen_op, b, 1000000));
+        snprintf(item, sizeof(item), "ECDSA %s sign %s", curves[c].name, ECP_BACKEND);
+        IDF_LOG_PERFORMANCE(item, "%.1f ops/s", bench_ops_per_sec(ecdsa_sign_op, b, 1000000));
+        snprintf(item, sizeof(item), "ECDSA %s verify %s", curves[c].name, ECP_BACKEND);
+        IDF_LOG_PERFORMANCE(item, "%.1f ops/s", bench_ops_per_sec(ecdsa_verify_op, b, 1000000));
+
+        mbedtls_mpi_free(&b->r);
+        mbedtls_mpi_free(&b->s);
+        mbedtls_ecdsa_free(&b->ecdsa);
+    }
+
+    /* X25519, as used by protocomm security1 */
+    mbedtls_ecdsa_init(&b->ecdsa);
+    TEST_ASSERT_EQUAL(0, mbedtls_ecp_group_load(&b->ecdsa.grp, MBEDTLS_ECP_DP_CURVE25519));
+    snprintf(item, sizeof(item), "ECDH Curve25519 keypair %s", ECP_BACKEND);
+    IDF_LOG_PERFORMANCE(item, "%.1f ops/s", bench_ops_per_sec(ecdh_gen_op, b, 1000000));
+    mbedtls_ecdsa_free(&b->ecdsa);
+
+    mbedtls_ctr_drbg_free(&b->ctr_drbg);
+    mbedtls_entropy_free(&entropy);
+    free(b);
+}
+
+#ifndef CONFIG_FREERTOS_UNICORE
+
+typedef struct {
+    bench_op_t op;
+    size_t len;
+    int reps;
+    SemaphoreHandle_t start;
+    SemaphoreHandle_t done;
+} contention_task_t;
+
+static void contention_task(void *arg)
+{
+    contention_task_t *t = arg;
+    uint8_t *buf = alloc_buf();
+    xSemaphoreTake(t->start, portMAX_DELAY);
+    for (int r = 0; r < t->reps; r++) {
+        t->op(buf, t->len);
+    }
+    free(buf);
+    xSemaphoreGive(t->done);
+    vTaskDelete(NULL);
+}
+
+/* Report the throughput of op on one core, and on both cores at the same time */
+static void bench_contention(const char *name, const char *backend, bench_op_t op, size_t len)
+{
+    char item[64];
+    const int reps = MAX(8, 4 * BENCH_BYTES / len);
+    contention_task_t t = {
+        .op = op,
+        .len = len,
+        .reps = reps,
+        .start = xSemaphoreCreateCounting(2, 0),
+        .done = xSemaphoreCreateCounting(2, 0),
+    };
+    TEST_ASSERT_NOT_NULL(t.start);
+    TEST_ASSERT_NOT_NULL(t.done);
+
+    /* one task, then one task per core */
+    for (int tasks = 1; tasks <= 2; tasks++) {
+        for (int core = 0; core < tasks; core++) {
+            xTaskCreatePinnedToCore(contention_task, "crypto_bench", 4096, &t, UNITY_FREERTOS_PRIORITY + 1, NULL, core);
+        }
+        int64_t start_us = esp_timer_get_time();
+        for (int i = 0; i < tasks; i++) {
+            xSemaphoreGive(t.start);
+        }
+        for (int i = 0; i < tasks; i++) {
+            xSemaphoreTake(t.done, portMAX_DELAY);
+        }
+        int64_t us = esp_timer_get_time() - start_us;
+        snprintf(item, sizeof(item), "%s %s %dB %s", name, backend, (int)len, tasks == 1 ? "one core" : "both cores");
+        IDF_LOG_PERFORMANCE(item, "%d KB/s", (int)((int64_t)tasks * reps * len * 1000000 / 1024 / us));
+    }
+    vSemaphoreDelete(t.start);
+    vSemaphoreDelete(t.done);
+}
+
+TEST_CASE("mbedtls crypto performance when both cores use the accelerators", "[hw_crypto][perf]")
+{
+    mbedtls_aes_init(&bench_aes);
+    TEST_ASSERT_EQUAL(0, mbedtls_aes_setkey_enc(&bench_aes, bench_key, 128));
+    bench_contention("AES-128-CBC", AES_BACKEND, aes_cbc_op, 1024);
+    mbedtls_aes_free(&bench_aes);
+
+#ifdef CONFIG_MBEDTLS_HARDWARE_SHA
+    esp_sha_reset_usage();
+#endif
+    bench_contention("SHA-256", SHA_BACKEND, sha256_op, 64);
+    bench_contention("SHA-256", SHA_BACKEND, sha256_op, 1024);
+#ifdef CONFIG_MBEDTLS_HARDWARE_SHA
+    /* a digest which doesn't get the SHA engine continues in software */
+    esp_sha_usage_t usage;
+    esp_sha_get_usage(SHA2_256, &usage);
+    IDF_LOG_PERFORMANCE("SHA-256 blocks in hardware", "%u", usage.hardware_blocks);
+    IDF_LOG_PERFORMANCE("SHA-256 blocks in software", "%u", usage.software_blocks);
+#endif
+}
+
+#endif /* CONFIG_FREERTOS_UNICORE */
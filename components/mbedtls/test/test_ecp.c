@@ -75,3 +75,161 @@ TEST_CASE("mbedtls ECP mul w/ koblitz", "[mbedtls]")
     mbedtls_entropy_free(&ctxEntropy);
 }
 
+
+TEST_CASE("mbedtls ECDH P-256 known answer", "[mbedtls]")
+{
+    /* Test vector from RFC 5903 section 8.1 */
+    mbedtls_ecp_group grp;
+    mbedtls_ecp_point Qi, Qr;
+    mbedtls_mpi i, r, z, expected;
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context ctr_drbg;
+
+    mbedtls_ecp_group_init(&grp);
+    mbedtls_ecp_point_init(&Qi);
+    mbedtls_ecp_point_init(&Qr);
+    mbedtls_mpi_init(&i);
+    mbedtls_mpi_init(&r);
+    mbedtls_mpi_init(&z);
+    mbedtls_mpi_init(&expected);
+    mbedtls_ctr_drbg_init(&ctr_drbg);
+    mbedtls_entropy_init(&entropy);
+    TEST_ASSERT_MBEDTLS_OK( mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func, &entropy, NULL, 0) );
+
+    TEST_ASSERT_MBEDTLS_OK( mbedtls_ecp_group_load(&grp, MBEDTLS_ECP_DP_SECP256R1) );
+    TEST_ASSERT_MBEDTLS_OK( mbedtls_mpi_read_string(&i, 16, "C88F01F510D9AC3F70A292DAA2316DE544E9AAB8AFE84049C62A9C57862D1433") );
+    TEST_ASSERT_MBEDTLS_OK( mbedtls_mpi_read_string(&r, 16, "C6EF9C5D78AE012A011164ACB397CE2088685D8F06BF9BE0B283AB46476BEE53") );
+
+    TEST_ASSERT_MBEDTLS_OK( mbedtls_ecp_mul(&grp, &Qi, &i, &grp.G, mbedtls_ctr_drbg_random, &ctr_drbg) );
+    TEST_ASSERT_MBEDTLS_OK( mbedtls_mpi_read_string(&expected, 16, "DAD0B65394221CF9B051E1FECA5787D098DFE637FC90B9EF945D0C3772581180") );
+    TEST_ASSERT_EQUAL(0, mbedtls_mpi_cmp_mpi(&Qi.X, &expected));
+    TEST_ASSERT_MBEDTLS_OK( mbedtls_mpi_read_string(&expected, 16, "5271A0461CDB8252D61F1C456FA3E59AB1F45B33ACCF5F58389E0577B8990BB3") );
+    TEST_ASSERT_EQUAL(0, mbedtls_mpi_cmp_mpi(&Qi.Y, &expected));
+
+    TEST_ASSERT_MBEDTLS_OK( mbedtls_ecp_mul(&grp, &Qr, &r, &grp.G, mbedtls_ctr_drbg_random, &ctr_drbg) );
+    TEST_ASSERT_MBEDTLS_OK( mbedtls_mpi_read_string(&expected, 16, "D12DFB5289C8D4F81208B70270398C342296970A0BCCB74C736FC7554494BF63") );
+    TEST_ASSERT_EQUAL(0, mbedtls_mpi_cmp_mpi(&Qr.X, &expected));
+    TEST_ASSERT_MBEDTLS_OK( mbedtls_mpi_read_string(&expected, 16, "56FBF3CA366CC23E8157854C13C58D6AAC23F046ADA30F8353E74F33039872AB") );
+    TEST_ASSERT_EQUAL(0, mbedtls_mpi_cmp_mpi(&Qr.Y, &expected));
+
+    /* both sides derive the same secret */
+    TEST_ASSERT_MBEDTLS_OK( mbedtls_mpi_read_string(&expected, 16, "D6840F6B42F6EDAFD13116E0E12565202FEF8E9ECE7DCE03812464D04B9442DE") );
+    TEST_ASSERT_MBEDTLS_OK( mbedtls_ecdh_compute_shared(&grp, &z, &Qr, &i, mbedtls_ctr_drbg_random, &ctr_drbg) );
+    TEST_ASSERT_EQUAL(0, mbedtls_mpi_cmp_mpi(&z, &expected));
+    TEST_ASSERT_MBEDTLS_OK( mbedtls_ecdh_compute_shared(&grp, &z, &Qi, &r, mbedtls_ctr_drbg_random, &ctr_drbg) );
+    TEST_ASSERT_EQUAL(0, mbedtls_mpi_cmp_mpi(&z, &expected));
+
+    mbedtls_ecp_group_free(&grp);
+    mbedtls_ecp_point_free(&Qi);
+    mbedtls_ecp_point_free(&Qr);
+    mbedtls_mpi_free(&i);
+    mbedtls_mpi_free(&r);
+    mbedtls_mpi_free(&z);
+    mbedtls_mpi_free(&expected);
+    mbedtls_ctr_drbg_free(&ctr_drbg);
+    mbedtls_entropy_free(&entropy);
+}
+
+TEST_CASE("mbedtls ECDH Curve25519 known answer", "[mbedtls]")
+{
+    /* Test vectors from RFC 7748 section 5.2, as big endian numbers, scalars clamped.
+       The u coordinate of the second one is not masked, so it is larger than P. */
+    const struct {
+        const char *d, *u, *z;
+    } vectors[] = {
+        {
+            "449A44BA44226A50185AFCC10A4C1462DD5E46824B15163B9D7C52F06BE346A0",
+            "4C1CABD0A603A9103B35B326EC2466727C5FB124A4C19435DB3030586768DBE6",
+            "5285A2775507B454F7711C4903CFEC324F088DF24DEA948E90C6E99D3755DAC3",
+        },
+        {
+            "4DBA18799E16A42CD401EAE021641BC1F56A7D959126D25A3C67B4D1D4E96648",
+            "93A415C749D54CFC3E3CC06F10E7DB312CAE38059D95B7F4D3116878120F21E5",
+            "4A7EA5AD7CB83704D3D0006BAF413C5DE934251ECEAC839412B8F6C97335F3D5",
+        },
+    };
+    mbedtls_ecp_group grp;
+    mbedtls_ecp_point Q;
+    mbedtls_mpi d, z, expected;
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context ctr_drbg;
+
+    mbedtls_ecp_group_init(&grp);
+    mbedtls_ecp_point_init(&Q);
+    mbedtls_mpi_init(&d);
+    mbedtls_mpi_init(&z);
+    mbedtls_mpi_init(&expected);
+    mbedtls_ctr_drbg_init(&ctr_drbg);
+    mbedtls_entropy_init(&entropy);
+    TEST_ASSERT_MBEDTLS_OK( mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func, &entropy, NULL, 0) );
+
+    TEST_ASSERT_MBEDTLS_OK( mbedtls_ecp_group_load(&grp, MBEDTLS_ECP_DP_CURVE25519) );
+    for (int i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+        TEST_ASSERT_MBEDTLS_OK( mbedtls_mpi_read_string(&d, 16, vectors[i].d) );
+        TEST_ASSERT_MBEDTLS_OK( mbedtls_mpi_read_string(&Q.X, 16, vectors[i].u) );
+        TEST_ASSERT_MBEDTLS_OK( mbedtls_mpi_lset(&Q.Z, 1) );
+        TEST_ASSERT_MBEDTLS_OK( mbedtls_mpi_read_string(&expected, 16, vectors[i].z) );
+
+        /* with and without the randomization of the coordinates */
+        TEST_ASSERT_MBEDTLS_OK( mbedtls_ecdh_compute_shared(&grp, &z, &Q, &d, mbedtls_ctr_drbg_random, &ctr_drbg) );
+        TEST_ASSERT_EQUAL(0, mbedtls_mpi_cmp_mpi(&z, &expected));
+        TEST_ASSERT_MBEDTLS_OK( mbedtls_ecdh_compute_shared(&grp, &z, &Q, &d, NULL, NULL) );
+        TEST_ASSERT_EQUAL(0, mbedtls_mpi_cmp_mpi(&z, &expected));
+    }
+
+    /* a point of small order gives the point at infinity, which is rejected */
+    TEST_ASSERT_MBEDTLS_OK( mbedtls_mpi_lset(&Q.X, 0) );
+    TEST_ASSERT_NOT_EQUAL(0, mbedtls_ecdh_compute_shared(&grp, &z, &Q, &d, mbedtls_ctr_drbg_random, &ctr_drbg));
+
+    mbedtls_ecp_group_free(&grp);
+    mbedtls_ecp_point_free(&Q);
+    mbedtls_mpi_free(&d);
+    mbedtls_mpi_free(&z);
+    mbedtls_mpi_free(&expected);
+    mbedtls_ctr_drbg_free(&ctr_drbg);
+    mbedtls_entropy_free(&entropy);
+}
+
+TEST_CASE("mbedtls ECDSA sign and verify", "[mbedtls]")
+{
+    /* covers the A = -3, A = 0 and general A point doubling formulas */
+    const mbedtls_ecp_group_id curves[] = {
+        MBEDTLS_ECP_DP_SECP384R1,
+        MBEDTLS_ECP_DP_SECP256K1,
+        MBEDTLS_ECP_DP_BP256R1,
+    };
+    const unsigned char hash[32] = "esp32 ecdsa sign and verify test";
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context ctr_drbg;
+
+    mbedtls_ctr_drbg_init(&ctr_drbg);
+    mbedtls_entropy_init(&entropy);
+    TEST_ASSERT_MBEDTLS_OK( mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func, &entropy, NULL, 0) );
+
+    for (int c = 0; c < sizeof(curves) / sizeof(curves[0]); c++) {
+        mbedtls_ecdsa_context ecdsa;
+        mbedtls_mpi r, s;
+        mbedtls_ecdsa_init(&ecdsa);
+        mbedtls_mpi_init(&r);
+        mbedtls_mpi_init(&s);
+
+        TEST_ASSERT_MBEDTLS_OK( mbedtls_ecdsa_genkey(&ecdsa, curves[c], mbedtls_ctr_drbg_random, &ctr_drbg) );
+        TEST_ASSERT_MBEDTLS_OK( mbedtls_ecp_check_pubkey(&ecdsa.grp, &ecdsa.Q) );
+        TEST_ASSERT_MBEDTLS_OK( mbedtls_ecdsa_sign(&ecdsa.grp, &r, &s, &ecdsa.d, hash, sizeof(hash),
+                                                   mbedtls_ctr_drbg_random, &ctr_drbg) );
+        TEST_ASSERT_MBEDTLS_OK( mbedtls_ecdsa_verify(&ecdsa.grp, hash, sizeof(hash), &ecdsa.Q, &r, &s) );
+
+        /* a signature over another hash doesn't verify */
+        unsigned char other[sizeof(hash)];
+        memcpy(other, hash, sizeof(hash));
+        other[0] ^= 1;
+        TEST_ASSERT_EQUAL_HEX32(-MBEDTLS_ERR_ECP_VERIFY_FAILED,
+                                -mbedtls_ecdsa_verify(&ecdsa.grp, other, sizeof(other), &ecdsa.Q, &r, &s));
+
+        mbedtls_mpi_free(&r);
+        mbedtls_mpi_free(&s);
+        mbedtls_ecdsa_free(&ecdsa);
+    }
+    mbedtls_ctr_drbg_free(&ctr_drbg);
+    mbedtls_entropy_free(&entropy);
+}
@@ -7,20 +7,24 @@
 */
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <esp_system.h>
 #include "mbedtls/sha1.h"
 #include "mbedtls/sha256.h"
 #include "mbedtls/sha512.h"
 #include "mbedtls/aes.h"
+#include "mbedtls/gcm.h"
 #include "mbedtls/bignum.h"
 #include "mbedtls/rsa.h"
+#include "mbedtls/platform.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include "unity.h"
 #include "sdkconfig.h"
 #include "test_apb_dport_access.h"
+#include "esp_mem.h"
 
 TEST_CASE("mbedtls AES self-tests", "[aes]")
 {
@@ -29,6 +33,60 @@ TEST_CASE("mbedtls AES self-tests", "[aes]")
     verify_apb_access_loop();
 }
 
+TEST_CASE("mbedtls GCM self-tests", "[aes]")
+{
+    start_apb_access_loop();
+    TEST_ASSERT_FALSE_MESSAGE(mbedtls_gcm_self_test(1), "GCM self-tests should pass.");
+    verify_apb_access_loop();
+}
+
+TEST_CASE("mbedtls GCM encrypts a record in parts and decrypts it in place", "[aes]")
+{
+    const size_t RECORD_LEN = 1600;
+    const unsigned char key[32] = { 0x01, 0x02, 0x03, 0x04, 0x05 };
+    const unsigned char iv[12] = { 0xa0, 0xa1, 0xa2 };
+    const unsigned char add[13] = { 0x17, 0x03, 0x03 };
+    unsigned char tag[16], tag_parts[16];
+    unsigned char *plaintext = malloc(RECORD_LEN);
+    unsigned char *ciphertext = malloc(RECORD_LEN);
+    unsigned char *ciphertext_parts = malloc(RECORD_LEN);
+    TEST_ASSERT_NOT_NULL(plaintext);
+    TEST_ASSERT_NOT_NULL(ciphertext);
+    TEST_ASSERT_NOT_NULL(ciphertext_parts);
+    for (int i = 0; i < RECORD_LEN; i++) {
+        plaintext[i] = i * 7;
+    }
+
+    mbedtls_gcm_context ctx;
+    mbedtls_gcm_init(&ctx);
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_setkey(&ctx, MBEDTLS_CIPHER_ID_AES, key, 256));
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_crypt_and_tag(&ctx, MBEDTLS_GCM_ENCRYPT, RECORD_LEN, iv, sizeof(iv),
+                                                   add, sizeof(add), plaintext, ciphertext, sizeof(tag), tag));
+
+    /* parts of multiples of 16 bytes, then the rest */
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_starts(&ctx, MBEDTLS_GCM_ENCRYPT, iv, sizeof(iv), add, sizeof(add)));
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_update(&ctx, 16, plaintext, ciphertext_parts));
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_update(&ctx, 1024, plaintext + 16, ciphertext_parts + 16));
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_update(&ctx, RECORD_LEN - 1040, plaintext + 1040, ciphertext_parts + 1040));
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_finish(&ctx, tag_parts, sizeof(tag_parts)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(ciphertext, ciphertext_parts, RECORD_LEN);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(tag, tag_parts, sizeof(tag));
+
+    TEST_ASSERT_EQUAL(0, mbedtls_gcm_auth_decrypt(&ctx, RECORD_LEN, iv, sizeof(iv), add, sizeof(add),
+                                                  tag, sizeof(tag), ciphertext, ciphertext));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(plaintext, ciphertext, RECORD_LEN);
+
+    tag[0] ^= 1;
+    TEST_ASSERT_EQUAL(MBEDTLS_ERR_GCM_AUTH_FAILED,
+                      mbedtls_gcm_auth_decrypt(&ctx, RECORD_LEN, iv, sizeof(iv), add, sizeof(add),
+                                               tag, sizeof(tag), ciphertext_parts, ciphertext_parts));
+
+    mbedtls_gcm_free(&ctx);
+    free(plaintext);
+    free(ciphertext);
+    free(ciphertext_parts);
+}
+
 TEST_CASE("mbedtls MPI self-tests", "[bignum]")
 {
     start_apb_access_loop();
@@ -43,3 +101,41 @@ TEST_CASE("mbedtls RSA self-tests", "[bignum]")
     verify_apb_access_loop();
 }
 
+#ifdef CONFIG_MBEDTLS_MEM_POOL
+TEST_CASE("mbedtls memory pool frees chunks when they are empty", "[mbedtls]")
+{
+    esp_mbedtls_mem_pool_stats_t before, stats;
+    esp_mbedtls_mem_pool_get_stats(&before);
+
+    /* small allocations come from the pool, large ones from the heap */
+    uint8_t *small[16];
+    for (int i = 0; i < 16; i++) {
+        small[i] = mbedtls_calloc(1, 24 + i * 20);
+        TEST_ASSERT_NOT_NULL(small[i]);
+        for (int j = 0; j < 24 + i * 20; j++) {
+            TEST_ASSERT_EQUAL(0, small[i][j]);
+        }
+        memset(small[i], 0xa5, 24 + i * 20);
+    }
+    uint8_t *large = mbedtls_calloc(2, 4096);
+    TEST_ASSERT_NOT_NULL(large);
+    esp_mbedtls_mem_pool_get_stats(&stats);
+    TEST_ASSERT_EQUAL(before.blocks + 16, stats.blocks);
+    TEST_ASSERT_GREATER_THAN(before.chunks, stats.chunks);
+
+    mbedtls_free(large);
+    for (int i = 0; i < 16; i++) {
+        mbedtls_free(small[i]);
+    }
+    esp_mbedtls_mem_pool_get_stats(&stats);
+    TEST_ASSERT_EQUAL(before.blocks, stats.blocks);
+    TEST_ASSERT_EQUAL(before.chunks, stats.chunks);
+
+    /* the RSA self-test releases everything it allocates */
+    TEST_ASSERT_FALSE(mbedtls_rsa_self_test(0));
+    esp_mbedtls_mem_pool_get_stats(&stats);
+    TEST_ASSERT_EQUAL(before.blocks, stats.blocks);
+    TEST_ASSERT_EQUAL(before.chunks, stats.chunks);
+    TEST_ASSERT_GREATER_THAN(before.chunks, stats.peak_chunks);
+}
+#endif
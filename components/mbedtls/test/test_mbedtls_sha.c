@@ -14,6 +14,9 @@
 #include "unity.h"
 #include "sdkconfig.h"
 #include "test_apb_dport_access.h"
+#if CONFIG_MBEDTLS_HARDWARE_SHA
+#include "esp32/sha.h"
+#endif
 
 TEST_CASE("mbedtls SHA self-tests", "[mbedtls]")
 {
@@ -299,3 +302,54 @@ TEST_CASE("mbedtls SHA session passed between tasks" , "[mbedtls]")
     TEST_ASSERT_EQUAL(0, param.ret);
     TEST_ASSERT_EQUAL_MEMORY_MESSAGE(sha256_thousand_as, param.result, 32, "SHA256 result from other task");
 }
+
+#if CONFIG_MBEDTLS_HARDWARE_SHA
+TEST_CASE("mbedtls SHA256 engine handed over between digests", "[mbedtls]")
+{
+    mbedtls_sha256_context idle, ctx, late;
+    esp_sha_usage_t before, after;
+    unsigned char sha256[32];
+
+    esp_sha_get_usage(SHA2_256, &before);
+
+    /* 'idle' takes the engine with its first block, then waits */
+    mbedtls_sha256_init(&idle);
+    TEST_ASSERT_EQUAL(0, mbedtls_sha256_starts_ret(&idle, false));
+    TEST_ASSERT_EQUAL(0, mbedtls_sha256_update_ret(&idle, one_hundred_as, 100));
+
+    /* a new digest takes the engine over */
+    mbedtls_sha256_init(&ctx);
+    TEST_ASSERT_EQUAL(0, mbedtls_sha256_starts_ret(&ctx, false));
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL(0, mbedtls_sha256_update_ret(&ctx, one_hundred_as, 100));
+    }
+
+    /* 'ctx' has processed too many blocks to hand the engine over again */
+    mbedtls_sha256_init(&late);
+    TEST_ASSERT_EQUAL(0, mbedtls_sha256_starts_ret(&late, false));
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL(0, mbedtls_sha256_update_ret(&late, one_hundred_bs, 100));
+    }
+
+    for (int i = 0; i < 9; i++) {
+        TEST_ASSERT_EQUAL(0, mbedtls_sha256_update_ret(&idle, one_hundred_as, 100));
+    }
+
+    TEST_ASSERT_EQUAL(0, mbedtls_sha256_finish_ret(&idle, sha256));
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(sha256_thousand_as, sha256, 32, "SHA256 digest which handed the engine over");
+    TEST_ASSERT_EQUAL(0, mbedtls_sha256_finish_ret(&ctx, sha256));
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(sha256_thousand_as, sha256, 32, "SHA256 digest which took the engine over");
+    TEST_ASSERT_EQUAL(0, mbedtls_sha256_finish_ret(&late, sha256));
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(sha256_thousand_bs, sha256, 32, "SHA256 software digest");
+
+    mbedtls_sha256_free(&idle);
+    mbedtls_sha256_free(&ctx);
+    mbedtls_sha256_free(&late);
+
+    /* each digest is 16 blocks with the padding */
+    esp_sha_get_usage(SHA2_256, &after);
+    TEST_ASSERT_EQUAL(before.handovers + 1, after.handovers);
+    TEST_ASSERT_EQUAL(before.hardware_blocks + 1 + 16, after.hardware_blocks);
+    TEST_ASSERT_EQUAL(before.software_blocks + 15 + 16, after.software_blocks);
+}
+#endif
@@ -17,6 +17,7 @@
 #include "mdns_networking.h"
 #include "esp_log.h"
 #include <string.h>
+#include <ctype.h>
 
 #ifdef MDNS_ENABLE_DEBUG
 void mdns_debug_packet(const uint8_t * data, size_t len);
@@ -38,6 +39,12 @@ static void _mdns_search_result_add_ip(mdns_search_once_t * search, const char *
 static void _mdns_search_result_add_srv(mdns_search_once_t * search, const char * hostname, uint16_t port, tcpip_adapter_if_t tcpip_if, mdns_ip_protocol_t ip_protocol);
 static void _mdns_search_result_add_txt(mdns_search_once_t * search, mdns_txt_item_t * txt, size_t txt_count, tcpip_adapter_if_t tcpip_if, mdns_ip_protocol_t ip_protocol);
 static mdns_result_t * _mdns_search_result_add_ptr(mdns_search_once_t * search, const char * instance, tcpip_adapter_if_t tcpip_if, mdns_ip_protocol_t ip_protocol);
+static void _mdns_search_result_add_record(mdns_search_once_t * search, mdns_record_t * record);
+#if CONFIG_MDNS_RECORD_CACHE
+static void _mdns_cache_add(mdns_record_t * record, bool flush);
+static void _mdns_cache_flush_pcb(tcpip_adapter_if_t tcpip_if, mdns_ip_protocol_t ip_protocol);
+static void _mdns_cache_free();
+#endif
 
 static inline bool _str_null_or_empty(const char * str){
     return (str == NULL || *str == 0);
@@ -352,6 +359,142 @@ static inline uint8_t _mdns_append_string(uint8_t * packet, uint16_t * index, co
     return len + 1;
 }
 
+/*
+ * Name compression dictionary of the outgoing packet.
+ * Every name suffix written to the packet is remembered with its offset and hash,
+ * so that the following records can point to it without searching the packet.
+ * */
+typedef struct {
+    uint32_t hash;
+    uint16_t offset;
+    uint8_t next;                           // index of next entry in the bucket + 1, 0 for the last one
+} mdns_fqdn_dict_entry_t;
+
+static struct {
+    uint8_t buckets[MDNS_FQDN_DICT_BUCKETS];
+    mdns_fqdn_dict_entry_t entries[MDNS_FQDN_DICT_SIZE];
+    uint8_t len;
+    bool full;                              // some names are not in the dictionary, search the packet for them
+} _mdns_fqdn_dict;
+
+/**
+ * @brief  Clear the dictionary, called when building new packet
+ */
+static void _mdns_fqdn_dict_reset()
+{
+    memset(_mdns_fqdn_dict.buckets, 0, sizeof(_mdns_fqdn_dict.buckets));
+    _mdns_fqdn_dict.len = 0;
+    _mdns_fqdn_dict.full = false;
+}
+
+/**
+ * @brief  Forget names written at or after the index, called when data is removed from the packet
+ */
+static void _mdns_fqdn_dict_truncate(uint16_t index)
+{
+    // entries are added with growing offsets, so the last one is also the first in its bucket
+    while (_mdns_fqdn_dict.len && _mdns_fqdn_dict.entries[_mdns_fqdn_dict.len - 1].offset >= index) {
+        mdns_fqdn_dict_entry_t * e = &_mdns_fqdn_dict.entries[--_mdns_fqdn_dict.len];
+        _mdns_fqdn_dict.buckets[e->hash % MDNS_FQDN_DICT_BUCKETS] = e->next;
+    }
+}
+
+static void _mdns_fqdn_dict_add(uint16_t offset, uint32_t hash)
+{
+    if (_mdns_fqdn_dict.len == MDNS_FQDN_DICT_SIZE) {
+        _mdns_fqdn_dict.full = true;
+        return;
+    }
+    mdns_fqdn_dict_entry_t * e = &_mdns_fqdn_dict.entries[_mdns_fqdn_dict.len++];
+    e->hash = hash;
+    e->offset = offset;
+    e->next = _mdns_fqdn_dict.buckets[hash % MDNS_FQDN_DICT_BUCKETS];
+    _mdns_fqdn_dict.buckets[hash % MDNS_FQDN_DICT_BUCKETS] = _mdns_fqdn_dict.len;
+}
+
+/**
+ * @brief  Case insensitive FNV-1a hash of the label, continuing from the hash of the labels after it
+ */
+static uint32_t _mdns_fqdn_hash(const char * label, uint32_t hash)
+{
+    while (*label) {
+        hash ^= (uint8_t)tolower((unsigned char)*label++);
+        hash *= 16777619;
+    }
+    hash ^= '.';
+    hash *= 16777619;
+    return hash;
+}
+
+/**
+ * @brief  Check if the FQDN at the offset consists of the strings
+ */
+static bool _mdns_fqdn_matches(const uint8_t * packet, uint16_t offset, const char * strings[], uint8_t count)
+{
+    mdns_name_t name;
+    static char buf[MDNS_NAME_BUF_LEN];
+    uint8_t i;
+
+    name.parts = 0;
+    name.sub = 0;
+    name.host[0] = 0;
+    name.service[0] = 0;
+    name.proto[0] = 0;
+    name.domain[0] = 0;
+    if (!_mdns_read_fqdn(packet, packet + offset, &name, buf) || name.parts != count) {
+        return false;
+    }
+    for (i=0; i<count; i++) {
+        if (strcasecmp(strings[i], (const char *)&name + (i * (MDNS_NAME_BUF_LEN)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief  Search the packet for previous occurrence of the FQDN
+ *
+ * @return offset of the FQDN or -1 if not found
+ */
+static int _mdns_fqdn_search(const uint8_t * packet, uint16_t index, const char * strings[], uint8_t count)
+{
+    uint8_t len = strlen(strings[0]);
+    //try to find first the string length in the packet (if it exists)
+    const uint8_t * len_location = (const uint8_t *)memchr(packet, (char)len, index);
+    while (len_location) {
+        //check if the string after len_location is the string that we are looking for
+        if ((len_location + 1 + len) <= (packet + index) && !memcmp(len_location+1, strings[0], len)
+          && _mdns_fqdn_matches(packet, len_location - packet, strings, count)) {
+            return len_location - packet;
+        }
+        //try and find the length byte further in the packet
+        len_location = (const uint8_t *)memchr(len_location+1, (char)len, index - (len_location+1 - packet));
+    }
+    return -1;
+}
+
+/**
+ * @brief  Find previous occurrence of the FQDN in the packet using the dictionary
+ *
+ * @return offset of the FQDN or -1 if not found
+ */
+static int _mdns_fqdn_find(const uint8_t * packet, uint16_t index, const char * strings[], uint8_t count, uint32_t hash)
+{
+    uint8_t i = _mdns_fqdn_dict.buckets[hash % MDNS_FQDN_DICT_BUCKETS];
+    while (i) {
+        mdns_fqdn_dict_entry_t * e = &_mdns_fqdn_dict.entries[i - 1];
+        if (e->hash == hash && _mdns_fqdn_matches(packet, e->offset, strings, count)) {
+            return e->offset;
+        }
+        i = e->next;
+    }
+    if (_mdns_fqdn_dict.full) {
+        return _mdns_fqdn_search(packet, index, strings, count);
+    }
+    return -1;
+}
+
 /**
  * @brief  appends FQDN to a packet, incrementing the index and
  *         compressing the output if previous occurrence of the string (or part of it) has been found
@@ -365,64 +508,39 @@ static inline uint8_t _mdns_append_string(uint8_t * packet, uint16_t * index, co
  */
 static uint16_t _mdns_append_fqdn(uint8_t * packet, uint16_t * index, const char * strings[], uint8_t count)
 {
-    if (!count) {
-        //empty string so terminate
-        return _mdns_append_u8(packet, index, 0);
+    uint32_t hashes[count + 1];
+    uint16_t written = 0;
+    uint8_t i;
+
+    //hashes of all suffixes of the name
+    hashes[count] = 2166136261U;
+    for (i=count; i>0; i--) {
+        hashes[i - 1] = _mdns_fqdn_hash(strings[i - 1], hashes[i]);
     }
-    mdns_name_t name;
-    static char buf[MDNS_NAME_BUF_LEN];
-    uint8_t len = strlen(strings[0]);
-    //try to find first the string length in the packet (if it exists)
-    uint8_t * len_location = (uint8_t *)memchr(packet, (char)len, *index);
-    while (len_location) {
-        //check if the string after len_location is the string that we are looking for
-        if (memcmp(len_location+1, strings[0], len)) { //not continuing with our string
-search_next:
-            //try and find the length byte further in the packet
-            len_location = (uint8_t *)memchr(len_location+1, (char)len, *index - (len_location+1 - packet));
-            continue;
-        }
-        //seems that we might have found the string that we are looking for
-        //read the destination into name and compare
-        name.parts = 0;
-        name.sub = 0;
-        name.host[0] = 0;
-        name.service[0] = 0;
-        name.proto[0] = 0;
-        name.domain[0] = 0;
-        const uint8_t * content = _mdns_read_fqdn(packet, len_location, &name, buf);
-        if (!content) {
-            //not a readable fqdn?
-            return 0;
-        }
-        if (name.parts == count) {
-            uint8_t i;
-            for (i=0; i<count; i++) {
-                if (strcasecmp(strings[i], (const char *)&name + (i * (MDNS_NAME_BUF_LEN)))) {
-                    //not our string! let's search more
-                    goto search_next;
-                }
+
+    for (i=0; i<count; i++) {
+        int offset = _mdns_fqdn_find(packet, *index, &strings[i], count - i, hashes[i]);
+        if (offset >= 0) {
+            //we have found the rest of the name so let's insert a pointer to it instead
+            if (!_mdns_append_u16(packet, index, offset | MDNS_NAME_REF)) {
+                return 0;
             }
-            //we actually have found the string
-            break;
-        } else {
-            goto search_next;
+            return written + 2;
         }
-    }
-    //string is not yet in the packet, so let's add it
-    if (!len_location) {
-        uint8_t written = _mdns_append_string(packet, index, strings[0]);
-        if (!written) {
+        //string is not yet in the packet, so let's add it
+        uint16_t label_offset = *index;
+        uint8_t part_length = _mdns_append_string(packet, index, strings[i]);
+        if (!part_length) {
             return 0;
         }
-        //run the same for the other strings in the name
-        return written + _mdns_append_fqdn(packet, index, &strings[1], count - 1);
+        _mdns_fqdn_dict_add(label_offset, hashes[i]);
+        written += part_length;
     }
-
-    //we have found the string so let's insert a pointer to it instead
-    uint16_t offset = len_location - packet;
-    offset |= MDNS_NAME_REF;
-    return _mdns_append_u16(packet, index, offset);
+    //terminate the name
+    if (!_mdns_append_u8(packet, index, 0)) {
+        return 0;
+    }
+    return written + 1;
 }
 
 /**
@@ -514,6 +632,78 @@ static uint16_t _mdns_append_sdptr_record(uint8_t * packet, uint16_t * index, md
     return record_length;
 }
 
+/**
+ * @brief  Get TXT record data of the service, serialising it on first use
+ *
+ * The data is kept until TXT items of the service change, see _mdns_service_txt_data_free()
+ *
+ * @param  service      the service
+ * @param  len          length of the data
+ *
+ * @return the data or NULL if the service has no TXT items or on error
+ */
+static const uint8_t * _mdns_get_service_txt_data(mdns_service_t * service, uint16_t * len)
+{
+    mdns_txt_linked_item_t * txt;
+    size_t data_len = 0, index = 0;
+
+    *len = 0;
+    if (service->txt_data) {
+        *len = service->txt_data_len;
+        return service->txt_data;
+    }
+    if (!service->txt) {
+        return NULL;
+    }
+    txt = service->txt;
+    while (txt) {
+        size_t item_len = strlen(txt->key) + 1 + strlen(txt->value);
+        data_len += 1 + (item_len > 255 ? 255 : item_len);
+        txt = txt->next;
+    }
+    if (data_len > UINT16_MAX) {
+        return NULL;
+    }
+    uint8_t * data = (uint8_t *)malloc(data_len);
+    if (!data) {
+        HOOK_MALLOC_FAILED;
+        return NULL;
+    }
+    txt = service->txt;
+    while (txt) {
+        size_t key_len = strlen(txt->key);
+        size_t value_len = strlen(txt->value);
+        //"key=value" as one string, longer items are truncated
+        if (key_len > 254) {
+            key_len = 254;
+        }
+        if (key_len + 1 + value_len > 255) {
+            value_len = 255 - 1 - key_len;
+        }
+        data[index++] = key_len + 1 + value_len;
+        memcpy(data + index, txt->key, key_len);
+        index += key_len;
+        data[index++] = '=';
+        memcpy(data + index, txt->value, value_len);
+        index += value_len;
+        txt = txt->next;
+    }
+    service->txt_data = data;
+    service->txt_data_len = data_len;
+    *len = data_len;
+    return data;
+}
+
+/**
+ * @brief  Free serialised TXT record data of the service, called when its TXT items change
+ */
+static void _mdns_service_txt_data_free(mdns_service_t * service)
+{
+    free(service->txt_data);
+    service->txt_data = NULL;
+    service->txt_data_len = 0;
+}
+
 /**
  * @brief  appends TXT record for service to a packet, incrementing the index
  *
@@ -554,25 +744,17 @@ static uint16_t _mdns_append_txt_record(uint8_t * packet, uint16_t * index, mdns
     uint16_t data_len_location = *index - 2;
     uint16_t data_len = 0;
 
-    char * tmp;
-    mdns_txt_linked_item_t * txt = service->txt;
-    while (txt) {
-        tmp = (char *)malloc(2 + strlen(txt->key) + strlen(txt->value));
-        if (tmp) {
-            sprintf(tmp, "%s=%s", txt->key, txt->value);
-            uint8_t l = _mdns_append_string(packet, index, tmp);
-            free(tmp);
-            if (!l) {
-                return 0;
-            }
-            data_len += l;
-        } else {
-            HOOK_MALLOC_FAILED;
-            // continue
-        }
-        txt = txt->next;
+    const uint8_t * data = _mdns_get_service_txt_data(service, &data_len);
+    if (service->txt && !data) {
+        return 0;
     }
-    if (!data_len) {
+    if (data_len) {
+        if ((*index + data_len) >= MDNS_MAX_PACKET_SIZE) {
+            return 0;
+        }
+        memcpy(packet + *index, data, data_len);
+        *index += data_len;
+    } else {
         data_len = 1;
         packet[*index] = 0;
         *index = *index + 1;
@@ -911,6 +1093,7 @@ static void _mdns_dispatch_tx_packet(mdns_tx_packet_t * p)
     static uint8_t packet[MDNS_MAX_PACKET_SIZE];
     uint16_t index = MDNS_HEAD_LEN;
     memset(packet, 0, MDNS_HEAD_LEN);
+    _mdns_fqdn_dict_reset();
     mdns_out_question_t * q;
     mdns_out_answer_t * a;
     uint8_t count;
@@ -930,7 +1113,14 @@ static void _mdns_dispatch_tx_packet(mdns_tx_packet_t * p)
     count = 0;
     a = p->answers;
     while (a) {
-        count += _mdns_append_answer(packet, &index, a, p->tcpip_if);
+        uint16_t start = index;
+        uint8_t added = _mdns_append_answer(packet, &index, a, p->tcpip_if);
+        if (!added) {
+            //record did not fit (many known answers), drop the part already written
+            index = start;
+            _mdns_fqdn_dict_truncate(start);
+        }
+        count += added;
         a = a->next;
     }
     _mdns_set_u16(packet, MDNS_HEAD_ANSWERS_OFFSET, count);
@@ -1852,6 +2042,8 @@ static mdns_service_t * _mdns_create_service(const char * service, const char *
     s->weight = 0;
     s->instance = instance?strndup(instance, MDNS_NAME_BUF_LEN - 1):NULL;
     s->txt = new_txt;
+    s->txt_data = NULL;
+    s->txt_data_len = 0;
     s->port = port;
 
     s->service = strndup(service, MDNS_NAME_BUF_LEN - 1);
@@ -2002,6 +2194,7 @@ static void _mdns_free_service(mdns_service_t * service)
         free(s);
     }
     free(service->txt);
+    free(service->txt_data);
     free(service);
 }
 
@@ -2072,7 +2265,6 @@ static int _mdns_check_srv_collision(mdns_service_t * service, uint16_t priority
  */
 static int _mdns_check_txt_collision(mdns_service_t * service, const uint8_t * data, size_t len)
 {
-    size_t data_len = 1;
     if (len == 1 && service->txt) {
         return -1;//we win
     } else if (len > 1 && !service->txt) {
@@ -2081,10 +2273,10 @@ static int _mdns_check_txt_collision(mdns_service_t * service, const uint8_t * d
         return 0;//same
     }
 
-    mdns_txt_linked_item_t * txt = service->txt;
-    while (txt) {
-        data_len += 2 + strlen(service->txt->key) + strlen(service->txt->value);
-        txt = txt->next;
+    uint16_t data_len = 0;
+    const uint8_t * ours = _mdns_get_service_txt_data(service, &data_len);
+    if (!ours) {
+        return 0;//can not compare
     }
 
     if (len > data_len) {
@@ -2093,24 +2285,6 @@ static int _mdns_check_txt_collision(mdns_service_t * service, const uint8_t * d
         return -1;//we win
     }
 
-    uint8_t ours[len];
-    uint16_t index = 0;
-    char * tmp;
-
-    txt = service->txt;
-    while (txt) {
-        tmp = (char *)malloc(2 + strlen(txt->key) + strlen(txt->value));
-        if (tmp) {
-            sprintf(tmp, "%s=%s", txt->key, txt->value);
-            _mdns_append_string(ours, &index, tmp);
-            free(tmp);
-        } else {
-            HOOK_MALLOC_FAILED;
-            // continue
-        }
-        txt = txt->next;
-    }
-
     int ret = memcmp(ours, data, len);
     if (ret > 0) {
         return -1;//we win
@@ -2541,6 +2715,58 @@ static esp_err_t _mdns_strdup_check(char ** out, char * in)
     return ESP_OK;
 }
 
+/**
+ * @brief  Called from parser to fill record structure from foreign answer
+ *
+ * @note   strings of the record point to the name and static buffer, valid until the next call
+ *
+ * @return true if the record is of supported type and valid
+ */
+static bool _mdns_record_parse(const uint8_t * packet, const uint8_t * data_ptr, uint16_t data_len, mdns_name_t * name, uint16_t type, mdns_record_t * record)
+{
+    static mdns_name_t target;
+
+    record->type = type;
+    record->port = 0;
+    record->txt_len = 0;
+    record->host = name->host;
+    record->service = name->service;
+    record->proto = name->proto;
+    record->target = NULL;
+    record->txt = NULL;
+
+    if (type == MDNS_TYPE_PTR) {
+        if (!name->service[0] || !name->proto[0] || !_mdns_parse_fqdn(packet, data_ptr, &target) || !target.host[0]) {
+            return false;
+        }
+        record->target = target.host;
+    } else if (type == MDNS_TYPE_SRV) {
+        if (data_len <= MDNS_SRV_FQDN_OFFSET || !_mdns_parse_fqdn(packet, data_ptr + MDNS_SRV_FQDN_OFFSET, &target)) {
+            return false;
+        }
+        record->port = _mdns_read_u16(data_ptr, MDNS_SRV_PORT_OFFSET);
+        record->target = target.host;
+    } else if (type == MDNS_TYPE_TXT) {
+        record->txt = (uint8_t *)data_ptr;
+        record->txt_len = data_len;
+    } else if (type == MDNS_TYPE_A) {
+        if (data_len < 4) {
+            return false;
+        }
+        record->addr.type = IPADDR_TYPE_V4;
+        memcpy(&(record->addr.u_addr.ip4.addr), data_ptr, 4);
+    } else if (type == MDNS_TYPE_AAAA) {
+        if (data_len < 16) {
+            return false;
+        }
+        record->addr.type = IPADDR_TYPE_V6;
+        memcpy(record->addr.u_addr.ip6.addr, data_ptr, 16);
+    } else {
+        return false;
+    }
+    return true;
+}
+
 /**
  * @brief  main packet parser
  *
@@ -2554,7 +2780,7 @@ void mdns_parse_packet(mdns_rx_packet_t * packet)
     size_t len = packet->pb->len;
     const uint8_t * content = data + MDNS_HEAD_LEN;
     bool do_not_reply = false;
-    mdns_search_once_t * search_result = NULL;
+    mdns_record_t record;
 
 #ifdef MDNS_ENABLE_DEBUG
     _mdns_dbg_printf("\nRX[%u][%u]: ", packet->tcpip_if, (uint32_t)packet->ip_protocol);
@@ -2693,6 +2919,9 @@ void mdns_parse_packet(mdns_rx_packet_t * packet)
             uint32_t ttl = _mdns_read_u32(content, MDNS_TTL_OFFSET);
             uint16_t data_len = _mdns_read_u16(content, MDNS_LEN_OFFSET);
             const uint8_t * data_ptr = content + MDNS_DATA_OFFSET;
+#if CONFIG_MDNS_RECORD_CACHE
+            bool flush = !!(clas & 0x8000);
+#endif
             clas &= 0x7FFF;
 
             content = data_ptr + data_len;
@@ -2729,16 +2958,29 @@ void mdns_parse_packet(mdns_rx_packet_t * packet)
                     //skip this record
                     continue;
                 }
-                search_result = _mdns_search_find_from(_mdns_server->search_once, name, type, packet->tcpip_if, packet->ip_protocol);
+                if (!_mdns_record_parse(data, data_ptr, data_len, name, type, &record)) {
+                    continue;//error or unsupported type
+                }
+                record.tcpip_if = packet->tcpip_if;
+                record.ip_protocol = packet->ip_protocol;
+                record.ttl = ttl;
+#if CONFIG_MDNS_RECORD_CACHE
+                _mdns_cache_add(&record, flush);
+#endif
+                //pass the record to all matching searches (PTR & A/AAAA at the same time, coalesced searches)
+                mdns_search_once_t * search = _mdns_search_find_from(_mdns_server->search_once, name, type, packet->tcpip_if, packet->ip_protocol);
+                while (search) {
+                    _mdns_search_result_add_record(search, &record);
+                    search = _mdns_search_find_from(search->next, name, type, packet->tcpip_if, packet->ip_protocol);
+                }
+                continue;
             }
 
             if (type == MDNS_TYPE_PTR) {
                 if (!_mdns_parse_fqdn(data, data_ptr, name)) {
                     continue;//error
                 }
-                if (search_result) {
-                    _mdns_search_result_add_ptr(search_result, name->host, packet->tcpip_if, packet->ip_protocol);
-                } else if ((discovery || ours) && !name->sub && _mdns_name_is_ours(name)) {
+                if (!name->sub && _mdns_name_is_ours(name)) {
                     if (discovery) {
                         service = _mdns_get_service_item(name->service, name->proto);
                         _mdns_remove_parsed_question(parsed_packet, MDNS_TYPE_SDPTR, service);
@@ -2752,25 +2994,6 @@ void mdns_parse_packet(mdns_rx_packet_t * packet)
                     }
                 }
             } else if (type == MDNS_TYPE_SRV) {
-                mdns_result_t * result = NULL;
-                if (search_result && search_result->type == MDNS_TYPE_PTR) {
-                    result = search_result->result;
-                    while (result) {
-                        if (packet->tcpip_if == result->tcpip_if
-                            && packet->ip_protocol == result->ip_protocol
-                            && result->instance_name && !strcmp(name->host, result->instance_name)) {
-                            break;
-                        }
-                        result = result->next;
-                    }
-                    if (!result) {
-                        result = _mdns_search_result_add_ptr(search_result, name->host, packet->tcpip_if, packet->ip_protocol);
-                        if (!result) {
-                            continue;//error
-                        }
-                    }
-                }
-
                 if (!_mdns_parse_fqdn(data, data_ptr + MDNS_SRV_FQDN_OFFSET, name)) {
                     continue;//error
                 }
@@ -2778,16 +3001,7 @@ void mdns_parse_packet(mdns_rx_packet_t * packet)
                 uint16_t weight = _mdns_read_u16(data_ptr, MDNS_SRV_WEIGHT_OFFSET);
                 uint16_t port = _mdns_read_u16(data_ptr, MDNS_SRV_PORT_OFFSET);
 
-                if (search_result) {
-                    if (search_result->type == MDNS_TYPE_PTR) {
-                        if (!result->hostname) { // assign host/port for this entry only if not previously set
-                            result->port = port;
-                            result->hostname = strdup(name->host);
-                        }
-                    } else {
-                        _mdns_search_result_add_srv(search_result, name->host, port, packet->tcpip_if, packet->ip_protocol);
-                    }
-                } else if (ours) {
+                if (ours) {
                     if (parsed_packet->questions && !parsed_packet->probe) {
                         _mdns_remove_parsed_question(parsed_packet, type, service);
                         continue;
@@ -2841,41 +3055,7 @@ void mdns_parse_packet(mdns_rx_packet_t * packet)
                     }
                 }
             } else if (type == MDNS_TYPE_TXT) {
-                if (search_result) {
-                    mdns_txt_item_t * txt = NULL;
-                    size_t txt_count = 0;
-
-                    mdns_result_t * result = NULL;
-                    if (search_result->type == MDNS_TYPE_PTR) {
-                        result = search_result->result;
-                        while (result) {
-                            if (packet->tcpip_if == result->tcpip_if
-                                && packet->ip_protocol == result->ip_protocol
-                                && result->instance_name && !strcmp(name->host, result->instance_name)) {
-                                break;
-                            }
-                            result = result->next;
-                        }
-                        if (!result) {
-                            result = _mdns_search_result_add_ptr(search_result, name->host, packet->tcpip_if, packet->ip_protocol);
-                            if (!result) {
-                                continue;//error
-                            }
-                        }
-                        if (!result->txt) {
-                            _mdns_result_txt_create(data_ptr, data_len, &txt, &txt_count);
-                            if (txt_count) {
-                                result->txt = txt;
-                                result->txt_count = txt_count;
-                            }
-                        }
-                    } else {
-                        _mdns_result_txt_create(data_ptr, data_len, &txt, &txt_count);
-                        if (txt_count) {
-                            _mdns_search_result_add_txt(search_result, txt, txt_count, packet->tcpip_if, packet->ip_protocol);
-                        }
-                    }
-                } else if (ours) {
+                if (ours) {
                     if (parsed_packet->questions && !parsed_packet->probe) {
                         _mdns_remove_parsed_question(parsed_packet, type, service);
                         continue;
@@ -2901,13 +3081,7 @@ void mdns_parse_packet(mdns_rx_packet_t * packet)
                 ip_addr_t ip6;
                 ip6.type = IPADDR_TYPE_V6;
                 memcpy(ip6.u_addr.ip6.addr, data_ptr, 16);
-                if (search_result) {
-                    //check for more applicable searches (PTR & A/AAAA at the same time)
-                    while (search_result) {
-                        _mdns_search_result_add_ip(search_result, name->host, &ip6, packet->tcpip_if, packet->ip_protocol);
-                        search_result = _mdns_search_find_from(search_result->next, name, type, packet->tcpip_if, packet->ip_protocol);
-                    }
-                } else if (ours) {
+                if (ours) {
                     if (parsed_packet->questions && !parsed_packet->probe) {
                         _mdns_remove_parsed_question(parsed_packet, type, NULL);
                         continue;
@@ -2947,13 +3121,7 @@ void mdns_parse_packet(mdns_rx_packet_t * packet)
                 ip_addr_t ip;
                 ip.type = IPADDR_TYPE_V4;
                 memcpy(&(ip.u_addr.ip4.addr), data_ptr, 4);
-                if (search_result) {
-                    //check for more applicable searches (PTR & A/AAAA at the same time)
-                    while (search_result) {
-                        _mdns_search_result_add_ip(search_result, name->host, &ip, packet->tcpip_if, packet->ip_protocol);
-                        search_result = _mdns_search_find_from(search_result->next, name, type, packet->tcpip_if, packet->ip_protocol);
-                    }
-                } else if (ours) {
+                if (ours) {
                     if (parsed_packet->questions && !parsed_packet->probe) {
                         _mdns_remove_parsed_question(parsed_packet, type, NULL);
                         continue;
@@ -3042,6 +3210,9 @@ void _mdns_disable_pcb(tcpip_adapter_if_t tcpip_if, mdns_ip_protocol_t ip_protoc
             _mdns_enable_pcb(other_if, ip_protocol);
         }
     }
+#if CONFIG_MDNS_RECORD_CACHE
+    _mdns_cache_flush_pcb(tcpip_if, ip_protocol);
+#endif
     _mdns_server->interfaces[tcpip_if].pcbs[ip_protocol].state = PCB_OFF;
 }
 
@@ -3489,12 +3660,282 @@ static mdns_search_once_t * _mdns_search_find_from(mdns_search_once_t * s, mdns_
     return NULL;
 }
 
+/**
+ * @brief  Called from parser and cache to add foreign record to search result
+ */
+static void _mdns_search_result_add_record(mdns_search_once_t * search, mdns_record_t * record)
+{
+    mdns_result_t * result = NULL;
+    mdns_txt_item_t * txt = NULL;
+    size_t txt_count = 0;
+
+    if (record->type == MDNS_TYPE_PTR) {
+        _mdns_search_result_add_ptr(search, record->target, record->tcpip_if, record->ip_protocol);
+    } else if (record->type == MDNS_TYPE_SRV) {
+        if (search->type != MDNS_TYPE_PTR) {
+            _mdns_search_result_add_srv(search, record->target, record->port, record->tcpip_if, record->ip_protocol);
+            return;
+        }
+        result = _mdns_search_result_add_ptr(search, record->host, record->tcpip_if, record->ip_protocol);
+        if (result && !result->hostname) { // assign host/port for this entry only if not previously set
+            result->port = record->port;
+            result->hostname = strdup(record->target);
+        }
+    } else if (record->type == MDNS_TYPE_TXT) {
+        if (search->type == MDNS_TYPE_PTR) {
+            result = _mdns_search_result_add_ptr(search, record->host, record->tcpip_if, record->ip_protocol);
+            if (!result || result->txt) {
+                return;
+            }
+        }
+        _mdns_result_txt_create(record->txt, record->txt_len, &txt, &txt_count);
+        if (!txt_count) {
+            return;
+        }
+        if (result) {
+            result->txt = txt;
+            result->txt_count = txt_count;
+        } else {
+            _mdns_search_result_add_txt(search, txt, txt_count, record->tcpip_if, record->ip_protocol);
+        }
+    } else if (record->type == MDNS_TYPE_A || record->type == MDNS_TYPE_AAAA) {
+        _mdns_search_result_add_ip(search, record->host, &record->addr, record->tcpip_if, record->ip_protocol);
+    }
+}
+
+#if CONFIG_MDNS_RECORD_CACHE
+/*
+ * MDNS Record Cache
+ * */
+
+static inline bool _mdns_cache_record_expired(mdns_record_t * c, uint32_t now)
+{
+    return (int32_t)(c->expires_at - now) <= 0;
+}
+
+/**
+ * @brief  Check if records belong to the same set (name, type and interface)
+ */
+static bool _mdns_cache_record_same_set(mdns_record_t * a, mdns_record_t * b)
+{
+    return a->type == b->type && a->tcpip_if == b->tcpip_if && a->ip_protocol == b->ip_protocol
+        && !strcasecmp(a->host, b->host) && !strcasecmp(a->service, b->service) && !strcasecmp(a->proto, b->proto);
+}
+
+/**
+ * @brief  Check if records of the same set carry the same data
+ */
+static bool _mdns_cache_record_same_data(mdns_record_t * a, mdns_record_t * b)
+{
+    if (a->type == MDNS_TYPE_PTR) {
+        return !strcasecmp(a->target, b->target);
+    } else if (a->type == MDNS_TYPE_SRV) {
+        return a->port == b->port && !strcasecmp(a->target, b->target);
+    } else if (a->type == MDNS_TYPE_TXT) {
+        return a->txt_len == b->txt_len && (!a->txt_len || !memcmp(a->txt, b->txt, a->txt_len));
+    } else if (a->type == MDNS_TYPE_A) {
+        return a->addr.u_addr.ip4.addr == b->addr.u_addr.ip4.addr;
+    }
+    return !memcmp(a->addr.u_addr.ip6.addr, b->addr.u_addr.ip6.addr, 16);
+}
+
+static void _mdns_cache_record_free(mdns_record_t * c)
+{
+    free(c->host);
+    free(c->service);
+    free(c->proto);
+    free(c->target);
+    free(c->txt);
+    free(c);
+}
+
+/**
+ * @brief  Allocate cache record (deep copy) from the parsed one
+ */
+static mdns_record_t * _mdns_cache_record_copy(mdns_record_t * record)
+{
+    mdns_record_t * c = (mdns_record_t *)malloc(sizeof(mdns_record_t));
+    if (!c) {
+        HOOK_MALLOC_FAILED;
+        return NULL;
+    }
+    memcpy(c, record, sizeof(mdns_record_t));
+    c->next = NULL;
+    c->host = strdup(record->host);
+    c->service = strdup(record->service);
+    c->proto = strdup(record->proto);
+    c->target = record->target ? strdup(record->target) : NULL;
+    c->txt = record->txt_len ? (uint8_t *)malloc(record->txt_len) : NULL;
+    if (!c->host || !c->service || !c->proto || (record->target && !c->target) || (record->txt_len && !c->txt)) {
+        HOOK_MALLOC_FAILED;
+        _mdns_cache_record_free(c);
+        return NULL;
+    }
+    if (c->txt) {
+        memcpy(c->txt, record->txt, record->txt_len);
+    }
+    return c;
+}
+
+static void _mdns_cache_remove(mdns_record_t * c)
+{
+    queueDetach(mdns_record_t, _mdns_server->cache, c);
+    _mdns_cache_record_free(c);
+    _mdns_server->cache_len--;
+}
+
+/**
+ * @brief  Called from parser to store or refresh foreign record in the cache
+ *
+ * Expired records are dropped on the way. Record with TTL 0 (goodbye) removes the cached one.
+ * Cache flush bit removes the other records of the set received more than a second ago (RFC 6762, 10.2).
+ */
+static void _mdns_cache_add(mdns_record_t * record, bool flush)
+{
+    uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    uint32_t ttl = record->ttl > MDNS_CACHE_MAX_TTL ? MDNS_CACHE_MAX_TTL : record->ttl;
+    mdns_record_t * found = NULL;
+    mdns_record_t * c = _mdns_server->cache;
+
+    while (c) {
+        mdns_record_t * next = c->next;
+        if (_mdns_cache_record_expired(c, now)) {
+            _mdns_cache_remove(c);
+        } else if (_mdns_cache_record_same_set(c, record)) {
+            if (_mdns_cache_record_same_data(c, record)) {
+                found = c;
+            } else if (flush && (now - (c->expires_at - c->ttl * 1000)) > 1000) {
+                _mdns_cache_remove(c);
+            }
+        }
+        c = next;
+    }
+
+    if (found) {
+        if (!ttl) {
+            _mdns_cache_remove(found);
+            return;
+        }
+        found->ttl = ttl;
+        found->expires_at = now + ttl * 1000;
+        return;
+    }
+    if (!ttl) {
+        return;
+    }
+    if (_mdns_server->cache_len >= MDNS_CACHE_MAX_RECORDS) {
+        //drop the record which would expire first
+        mdns_record_t * oldest = _mdns_server->cache;
+        c = oldest->next;
+        while (c) {
+            if ((int32_t)(c->expires_at - oldest->expires_at) < 0) {
+                oldest = c;
+            }
+            c = c->next;
+        }
+        _mdns_cache_remove(oldest);
+    }
+    c = _mdns_cache_record_copy(record);
+    if (!c) {
+        return;
+    }
+    c->ttl = ttl;
+    c->expires_at = now + ttl * 1000;
+    c->next = _mdns_server->cache;
+    _mdns_server->cache = c;
+    _mdns_server->cache_len++;
+}
+
+/**
+ * @brief  Called when new search is added to fill its results from the cache
+ *
+ * Records are passed in the order responders send them (PTR, SRV/TXT, A/AAAA),
+ * so that all parts of PTR search results are found.
+ * Search which reaches maximum results is finished without sending any question.
+ */
+static void _mdns_cache_search(mdns_search_once_t * search)
+{
+    static const uint16_t types[] = { MDNS_TYPE_PTR, MDNS_TYPE_SRV, MDNS_TYPE_TXT, MDNS_TYPE_A, MDNS_TYPE_AAAA };
+    static mdns_name_t name;
+    uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    size_t i;
+
+    for (i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        mdns_record_t * c = _mdns_server->cache;
+        while (c) {
+            if (c->type == types[i] && !_mdns_cache_record_expired(c, now)) {
+                strlcpy(name.host, c->host, sizeof(name.host));
+                strlcpy(name.service, c->service, sizeof(name.service));
+                strlcpy(name.proto, c->proto, sizeof(name.proto));
+                if (_mdns_search_find_from(search, &name, c->type, c->tcpip_if, c->ip_protocol) == search) {
+                    _mdns_search_result_add_record(search, c);
+                }
+            }
+            c = c->next;
+        }
+    }
+    _mdns_search_finish_done();
+}
+
+/**
+ * @brief  Remove records received on interface which goes down
+ */
+static void _mdns_cache_flush_pcb(tcpip_adapter_if_t tcpip_if, mdns_ip_protocol_t ip_protocol)
+{
+    mdns_record_t * c = _mdns_server->cache;
+    while (c) {
+        mdns_record_t * next = c->next;
+        if (c->tcpip_if == tcpip_if && c->ip_protocol == ip_protocol) {
+            _mdns_cache_remove(c);
+        }
+        c = next;
+    }
+}
+
+static void _mdns_cache_free()
+{
+    while (_mdns_server->cache) {
+        mdns_record_t * c = _mdns_server->cache;
+        _mdns_server->cache = c->next;
+        _mdns_cache_record_free(c);
+    }
+    _mdns_server->cache_len = 0;
+}
+#endif /* CONFIG_MDNS_RECORD_CACHE */
+
+/**
+ * @brief  Add PTR known answer to search packet
+ */
+static bool _mdns_search_add_known_answer(mdns_tx_packet_t * packet, const char * instance, const char * service, const char * proto)
+{
+    mdns_out_answer_t * a = (mdns_out_answer_t *)malloc(sizeof(mdns_out_answer_t));
+    if (!a) {
+        HOOK_MALLOC_FAILED;
+        return false;
+    }
+    a->type = MDNS_TYPE_PTR;
+    a->service = NULL;
+    a->custom_instance = instance;
+    a->custom_service = service;
+    a->custom_proto = proto;
+    a->bye = false;
+    a->flush = false;
+    a->next = NULL;
+    queueToEnd(mdns_out_answer_t, packet->answers, a);
+    return true;
+}
+
 /**
  * @brief  Create search packet for partidular interface
  */
 static mdns_tx_packet_t * _mdns_create_search_packet(mdns_search_once_t * search, tcpip_adapter_if_t tcpip_if, mdns_ip_protocol_t ip_protocol)
 {
+#if CONFIG_MDNS_RECORD_CACHE
+    mdns_record_t * c = NULL;
+    uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
+#else
     mdns_result_t * r = NULL;
+#endif
     mdns_tx_packet_t * packet = _mdns_alloc_packet_default(tcpip_if, ip_protocol);
     if (!packet) {
         return NULL;
@@ -3516,6 +3957,23 @@ static mdns_tx_packet_t * _mdns_create_search_packet(mdns_search_once_t * search
     queueToEnd(mdns_out_question_t, packet->questions, q);
 
     if (search->type == MDNS_TYPE_PTR) {
+#if CONFIG_MDNS_RECORD_CACHE
+        c = _mdns_server->cache;
+        while (c) {
+            //cached record with more than half of its TTL left (RFC 6762, 7.1)
+            if (c->type != MDNS_TYPE_PTR || c->tcpip_if != tcpip_if || c->ip_protocol != ip_protocol || c->host[0]
+              || strcasecmp(c->service, search->service) || strcasecmp(c->proto, search->proto)
+              || (int32_t)(c->expires_at - now) <= (int32_t)(c->ttl * 500)) {
+                c = c->next;
+                continue;
+            }
+            if (!_mdns_search_add_known_answer(packet, c->target, search->service, search->proto)) {
+                _mdns_free_tx_packet(packet);
+                return NULL;
+            }
+            c = c->next;
+        }
+#else
         r = search->result;
         while (r) {
             //full record on the same interface is available
@@ -3523,23 +3981,13 @@ static mdns_tx_packet_t * _mdns_create_search_packet(mdns_search_once_t * search
                 r = r->next;
                 continue;
             }
-            mdns_out_answer_t * a = (mdns_out_answer_t *)malloc(sizeof(mdns_out_answer_t));
-            if (!a) {
-                HOOK_MALLOC_FAILED;
+            if (!_mdns_search_add_known_answer(packet, r->instance_name, search->service, search->proto)) {
                 _mdns_free_tx_packet(packet);
                 return NULL;
             }
-            a->type = MDNS_TYPE_PTR;
-            a->service = NULL;
-            a->custom_instance = r->instance_name;
-            a->custom_service = search->service;
-            a->custom_proto = search->proto;
-            a->bye = false;
-            a->flush = false;
-            a->next = NULL;
-            queueToEnd(mdns_out_answer_t, packet->answers, a);
             r = r->next;
         }
+#endif
     }
 
     return packet;
@@ -3747,6 +4195,7 @@ static void _mdns_execute_action(mdns_action_t * action)
         break;
     case ACTION_SERVICE_TXT_REPLACE:
         service = action->data.srv_txt_replace.service->service;
+        _mdns_service_txt_data_free(service);
         txt = service->txt;
         service->txt = NULL;
         _mdns_free_linked_txt(txt);
@@ -3756,6 +4205,7 @@ static void _mdns_execute_action(mdns_action_t * action)
         break;
     case ACTION_SERVICE_TXT_SET:
         service = action->data.srv_txt_set.service->service;
+        _mdns_service_txt_data_free(service);
         key = action->data.srv_txt_set.key;
         value = action->data.srv_txt_set.value;
         txt = service->txt;
@@ -3786,6 +4236,7 @@ static void _mdns_execute_action(mdns_action_t * action)
         break;
     case ACTION_SERVICE_TXT_DEL:
         service = action->data.srv_txt_del.service->service;
+        _mdns_service_txt_data_free(service);
         key = action->data.srv_txt_del.key;
         txt = service->txt;
         if (!txt) {
@@ -3853,6 +4304,9 @@ static void _mdns_execute_action(mdns_action_t * action)
         break;
     case ACTION_SEARCH_ADD:
         _mdns_search_add(action->data.search_add.search);
+#if CONFIG_MDNS_RECORD_CACHE
+        _mdns_cache_search(action->data.search_add.search);
+#endif
         break;
     case ACTION_SEARCH_SEND:
         _mdns_search_send(action->data.search_add.search);
@@ -3945,8 +4399,39 @@ static void _mdns_scheduler_run()
     MDNS_SERVICE_UNLOCK();
 }
 
+/**
+ * @brief  Compare search parameters, which may be NULL
+ */
+static inline bool _mdns_search_str_eq(const char * a, const char * b)
+{
+    if (!a || !b) {
+        return a == b;
+    }
+    return !strcasecmp(a, b);
+}
+
+/**
+ * @brief  Find other running search with the same question, which has been sent recently
+ */
+static mdns_search_once_t * _mdns_search_find_same(mdns_search_once_t * search, uint32_t now)
+{
+    mdns_search_once_t * s = _mdns_server->search_once;
+    while (s) {
+        if (s != search && s->state == SEARCH_RUNNING && (now - s->sent_at) <= 1000
+          && s->type == search->type && _mdns_search_str_eq(s->instance, search->instance)
+          && _mdns_search_str_eq(s->service, search->service) && _mdns_search_str_eq(s->proto, search->proto)) {
+            return s;
+        }
+        s = s->next;
+    }
+    return NULL;
+}
+
 /**
  * @brief  Called from timer task to run active searches
+ *
+ * Identical searches are coalesced: only one of them sends the question,
+ * the parser passes answers to all matching searches.
  */
 static void _mdns_search_run()
 {
@@ -3965,10 +4450,15 @@ static void _mdns_search_run()
                     s->state = SEARCH_RUNNING;
                 }
             } else if (s->state == SEARCH_INIT || (now - s->sent_at) > 1000) {
+                mdns_search_once_t * same = _mdns_search_find_same(s, now);
                 s->state = SEARCH_RUNNING;
-                s->sent_at = now;
-                if (_mdns_send_search_action(ACTION_SEARCH_SEND, s) != ESP_OK) {
-                    s->sent_at -= 1000;
+                if (same) {
+                    s->sent_at = same->sent_at;
+                } else {
+                    s->sent_at = now;
+                    if (_mdns_send_search_action(ACTION_SEARCH_SEND, s) != ESP_OK) {
+                        s->sent_at -= 1000;
+                    }
                 }
             }
         }
@@ -4214,6 +4704,9 @@ void mdns_free()
         }
         free(h);
     }
+#if CONFIG_MDNS_RECORD_CACHE
+    _mdns_cache_free();
+#endif
     vSemaphoreDelete(_mdns_server->lock);
     free(_mdns_server);
     _mdns_server = NULL;
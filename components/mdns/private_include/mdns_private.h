@@ -23,6 +23,12 @@
 /** The maximum number of services */
 #define MDNS_MAX_SERVICES           CONFIG_MDNS_MAX_SERVICES
 
+#if CONFIG_MDNS_RECORD_CACHE
+/** The maximum number of records in the cache */
+#define MDNS_CACHE_MAX_RECORDS      CONFIG_MDNS_CACHE_MAX_RECORDS
+#endif
+#define MDNS_CACHE_MAX_TTL          86400                   // Received TTLs are clamped to this value (seconds)
+
 #define MDNS_ANSWER_PTR_TTL         4500
 #define MDNS_ANSWER_TXT_TTL         4500
 #define MDNS_ANSWER_SRV_TTL         120
@@ -59,6 +65,8 @@
 #define MDNS_NAME_MAX_LEN           64                      // Maximum string length of hostname, instance, service and proto
 #define MDNS_NAME_BUF_LEN           (MDNS_NAME_MAX_LEN+1)   // Maximum char buffer size to hold hostname, instance, service or proto
 #define MDNS_MAX_PACKET_SIZE        1460                    // Maximum size of mDNS  outgoing packet
+#define MDNS_FQDN_DICT_SIZE         64                      // Maximum names remembered for compression in outgoing packet
+#define MDNS_FQDN_DICT_BUCKETS      16                      // Number of hash buckets of the name compression dictionary
 
 #define MDNS_HEAD_LEN               12
 #define MDNS_HEAD_ID_OFFSET         0
@@ -209,6 +217,28 @@ typedef struct mdns_parsed_record_s {
     uint8_t *data;
 } mdns_parsed_record_t;
 
+/**
+ * @brief  Foreign record received in an authoritative answer
+ *
+ * Used by the parser to pass records to running searches and stored in the record cache.
+ */
+typedef struct mdns_record_s {
+    struct mdns_record_s * next;
+    tcpip_adapter_if_t tcpip_if;
+    mdns_ip_protocol_t ip_protocol;
+    uint16_t type;
+    uint16_t port;                          /*!< SRV: port of the service */
+    uint16_t txt_len;                       /*!< TXT: length of raw data */
+    uint32_t ttl;                           /*!< TTL as received (seconds) */
+    uint32_t expires_at;                    /*!< cache only: time of expiration (ms) */
+    char * host;                            /*!< instance for SRV/TXT, hostname for A/AAAA, NULL for PTR */
+    char * service;
+    char * proto;
+    char * target;                          /*!< PTR: instance, SRV: hostname */
+    uint8_t * txt;                          /*!< TXT: raw data */
+    ip_addr_t addr;                         /*!< A/AAAA: address */
+} mdns_record_t;
+
 typedef struct {
     tcpip_adapter_if_t tcpip_if;
     mdns_ip_protocol_t ip_protocol;
@@ -248,6 +278,8 @@ typedef struct {
     uint16_t weight;
     uint16_t port;
     mdns_txt_linked_item_t * txt;
+    uint8_t * txt_data;                     // TXT record data serialised on first use, freed when TXT items change
+    uint16_t txt_data_len;
 } mdns_service_t;
 
 typedef struct mdns_srv_item_s {
@@ -338,6 +370,10 @@ typedef struct mdns_server_s {
     mdns_tx_packet_t * tx_queue_head;
     mdns_search_once_t * search_once;
     esp_timer_handle_t timer_handle;
+#if CONFIG_MDNS_RECORD_CACHE
+    mdns_record_t * cache;
+    size_t cache_len;
+#endif
 } mdns_server_t;
 
 typedef struct {
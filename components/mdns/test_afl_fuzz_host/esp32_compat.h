@@ -35,6 +35,8 @@
 #include <sys/time.h>
 
 #define CONFIG_MDNS_MAX_SERVICES    25
+#define CONFIG_MDNS_RECORD_CACHE    1
+#define CONFIG_MDNS_CACHE_MAX_RECORDS   16
 
 #define ERR_OK                      0
 #define ESP_OK                      0
@@ -22,80 +22,173 @@
 #include "freertos/portmacro.h"
 #include "freertos/task.h"
 #include "freertos/portable.h"
+#include "soc/soc_memory_layout.h"
+#include "sdkconfig.h"
 
 /* Notes on our newlib lock implementation:
  *
- * - Use FreeRTOS mutex semaphores as locks.
- * - lock_t is int, but we store an xSemaphoreHandle there.
+ * - lock_t is int. It holds one of:
+ *   - 0: the lock is free and has never been contended.
+ *   - The handle of the owner task with LOCK_HELD set: the lock is held
+ *     and has never been contended. LOCK_WAITERS is set too once other
+ *     tasks wait for it.
+ *   - An xSemaphoreHandle: the lock is "inflated" into a FreeRTOS mutex
+ *     semaphore, used for all further operations.
+ * - Task handles and semaphores are at least 4 byte aligned, which leaves
+ *   the two low bits for LOCK_HELD and LOCK_WAITERS.
+ * - Locks which are never contended are taken and released with a single
+ *   compare and set, and never allocate a semaphore.
+ * - The owner inflates the lock when it releases it while other tasks wait,
+ *   or when it takes a recursive lock again. Until then the waiters block on
+ *   a binary semaphore of their own, listed in s_lock_waiters. From then on
+ *   the mutex semaphore provides priority inheritance, which the lock lacks
+ *   before the first contention.
+ * - In ISR context, a held lock can't be waited for and isn't inflated.
  * - Locks are no-ops until the FreeRTOS scheduler is running.
- * - Due to this, locks need to be lazily initialised the first time
- *   they are acquired. Initialisation/deinitialisation of locks is
- *   protected by lock_init_spinlock.
- * - Race conditions around lazy initialisation (via lock_acquire) are
- *   protected against.
  * - Anyone calling lock_close is reponsible for ensuring noone else
  *   is holding the lock at this time.
  * - Race conditions between lock_close & lock_init (for the same lock)
  *   are the responsibility of the caller.
  */
 
+#define LOCK_HELD       1
+#define LOCK_WAITERS    2
+#define LOCK_OWNER_MASK (~(uint32_t)(LOCK_HELD | LOCK_WAITERS))
+
+/* A task waiting for a lock which isn't inflated yet */
+typedef struct lock_waiter {
+    _lock_t *lock;
+    xSemaphoreHandle wake;
+    struct lock_waiter *next;
+} lock_waiter_t;
+
 static portMUX_TYPE lock_init_spinlock = portMUX_INITIALIZER_UNLOCKED;
+static portMUX_TYPE lock_waiters_spinlock = portMUX_INITIALIZER_UNLOCKED;
+static lock_waiter_t *s_lock_waiters;
 
-/* Initialize the given lock by allocating a new mutex semaphore
-   as the _lock_t value.
+/* Owner of the locks taken in ISR context, per CPU */
+static uint32_t s_isr_owner[portNUM_PROCESSORS];
 
-   Called by _lock_init*, also called by _lock_acquire* to lazily initialize locks that might have
-   been initialised (to zero only) before the RTOS scheduler started.
-*/
-static void IRAM_ATTR lock_init_generic(_lock_t *lock, uint8_t mutex_type) {
-    portENTER_CRITICAL(&lock_init_spinlock);
-    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {
-        /* nothing to do until the scheduler is running */
-        portEXIT_CRITICAL(&lock_init_spinlock);
-        return;
+/* Compare *lock with compare and set it to set if they are equal. Returns the previous value of *lock. */
+static inline uint32_t IRAM_ATTR lock_compare_set(_lock_t *lock, uint32_t compare, uint32_t set)
+{
+#if defined(CONFIG_SPIRAM_SUPPORT)
+    if (esp_ptr_external_ram(lock)) {
+        uxPortCompareSetExtram((volatile uint32_t *)lock, compare, &set);
+        return set;
+    }
+#endif
+    uxPortCompareSet((volatile uint32_t *)lock, compare, &set);
+    return set;
+}
+
+static inline uint32_t IRAM_ATTR lock_owner_self(void)
+{
+    if (xPortInIsrContext()) {
+        return (uint32_t)&s_isr_owner[xPortGetCoreID()];
     }
+    return (uint32_t)xTaskGetCurrentTaskHandle();
+}
+
+static xSemaphoreHandle IRAM_ATTR lock_create_mutex(uint8_t mutex_type)
+{
+    /* this is a bit of an API violation, as we're calling the
+       private function xQueueCreateMutex(x) directly instead of
+       the xSemaphoreCreateMutex / xSemaphoreCreateRecursiveMutex
+       wrapper functions...
 
-    if (*lock) {
-         /* Lock already initialised (either we didn't check earlier,
-          or it got initialised while we were waiting for the
-          spinlock.) */
+       The better alternative would be to pass pointers to one of
+       the two xSemaphoreCreate___Mutex functions, but as FreeRTOS
+       implements these as macros instead of inline functions
+       (*party like it's 1998!*) it's not possible to do this
+       without writing wrappers. Doing it this way seems much less
+       spaghetti-like.
+    */
+    xSemaphoreHandle new_sem = xQueueCreateMutex(mutex_type);
+    if (!new_sem) {
+        abort(); /* No more semaphores available or OOM */
     }
-    else
-    {
-        /* Create a new semaphore
+    return new_sem;
+}
 
-           this is a bit of an API violation, as we're calling the
-           private function xQueueCreateMutex(x) directly instead of
-           the xSemaphoreCreateMutex / xSemaphoreCreateRecursiveMutex
-           wrapper functions...
+/* Called by the owner of a lock which isn't inflated: replace the value of the lock, which
+   is owned|LOCK_WAITERS or owned, with new_value, and wake the tasks waiting for it. */
+static void IRAM_ATTR lock_replace_and_wake(_lock_t *lock, uint32_t owned, uint32_t new_value)
+{
+    lock_waiter_t *woken = NULL;
 
-           The better alternative would be to pass pointers to one of
-           the two xSemaphoreCreate___Mutex functions, but as FreeRTOS
-           implements these as macros instead of inline functions
-           (*party like it's 1998!*) it's not possible to do this
-           without writing wrappers. Doing it this way seems much less
-           spaghetti-like.
-        */
-        xSemaphoreHandle new_sem = xQueueCreateMutex(mutex_type);
-        if (!new_sem) {
-            abort(); /* No more semaphores available or OOM */
+    portENTER_CRITICAL(&lock_waiters_spinlock);
+    /* only the owner changes the lock once LOCK_WAITERS is set, and waiters set it with the spinlock held */
+    if (lock_compare_set(lock, owned, new_value) != owned) {
+        lock_compare_set(lock, owned | LOCK_WAITERS, new_value);
+    }
+    lock_waiter_t **p = &s_lock_waiters;
+    while (*p) {
+        lock_waiter_t *w = *p;
+        if (w->lock == lock) {
+            *p = w->next;
+            w->next = woken;
+            woken = w;
+        } else {
+            p = &w->next;
         }
-        *lock = (_lock_t)new_sem;
     }
-    portEXIT_CRITICAL(&lock_init_spinlock);
+    portEXIT_CRITICAL(&lock_waiters_spinlock);
+
+    while (woken) {
+        /* the waiter frees its record once woken */
+        lock_waiter_t *next = woken->next;
+        if (xPortInIsrContext()) {
+            BaseType_t higher_task_woken = false;
+            xSemaphoreGiveFromISR(woken->wake, &higher_task_woken);
+            if (higher_task_woken) {
+                portYIELD_FROM_ISR();
+            }
+        } else {
+            xSemaphoreGive(woken->wake);
+        }
+        woken = next;
+    }
+}
+
+/* Wait until the lock, whose value was held_value, is released or inflated by its owner */
+static void IRAM_ATTR lock_wait(_lock_t *lock, uint32_t held_value)
+{
+    lock_waiter_t waiter = {
+        .lock = lock,
+        .wake = xSemaphoreCreateBinary(),
+    };
+    if (!waiter.wake) {
+        abort(); /* OOM */
+    }
+
+    bool waiting = false;
+    portENTER_CRITICAL(&lock_waiters_spinlock);
+    /* wait only if the lock is still held by the same owner, who will see LOCK_WAITERS on release */
+    uint32_t waited_value = held_value | LOCK_WAITERS;
+    uint32_t value = lock_compare_set(lock, held_value, waited_value);
+    if (value == held_value || value == waited_value) {
+        waiter.next = s_lock_waiters;
+        s_lock_waiters = &waiter;
+        waiting = true;
+    }
+    portEXIT_CRITICAL(&lock_waiters_spinlock);
+
+    if (waiting) {
+        xSemaphoreTake(waiter.wake, portMAX_DELAY);
+    }
+    vSemaphoreDelete(waiter.wake);
 }
 
 void IRAM_ATTR _lock_init(_lock_t *lock) {
     *lock = 0; // In case lock's memory is uninitialized
-    lock_init_generic(lock, queueQUEUE_TYPE_MUTEX);
 }
 
 void IRAM_ATTR _lock_init_recursive(_lock_t *lock) {
     *lock = 0; // In case lock's memory is uninitialized
-    lock_init_generic(lock, queueQUEUE_TYPE_RECURSIVE_MUTEX);
 }
 
-/* Free the mutex semaphore pointed to by *lock, and zero it out.
+/* Free the mutex semaphore of an inflated lock, and zero it out.
 
    Note that FreeRTOS doesn't account for deleting mutexes while they
    are held, and neither do we... so take care not to delete newlib
@@ -107,35 +200,26 @@ void IRAM_ATTR _lock_init_recursive(_lock_t *lock) {
 */
 void IRAM_ATTR _lock_close(_lock_t *lock) {
     portENTER_CRITICAL(&lock_init_spinlock);
-    if (*lock) {
-        xSemaphoreHandle h = (xSemaphoreHandle)(*lock);
+    uint32_t value = (uint32_t)(*lock);
+    if (value & LOCK_HELD) {
+        configASSERT(false); /* lock should not be held */
+    } else if (value) {
+        xSemaphoreHandle h = (xSemaphoreHandle)value;
 #if (INCLUDE_xSemaphoreGetMutexHolder == 1)
         configASSERT(xSemaphoreGetMutexHolder(h) == NULL); /* mutex should not be held */
 #endif
         vSemaphoreDelete(h);
-        *lock = 0;
     }
+    *lock = 0;
     portEXIT_CRITICAL(&lock_init_spinlock);
 }
 
 void _lock_close_recursive(_lock_t *lock) __attribute__((alias("_lock_close")));
 
-/* Acquire the mutex semaphore for lock. wait up to delay ticks.
+/* Acquire the mutex semaphore of an inflated lock. wait up to delay ticks.
    mutex_type is queueQUEUE_TYPE_RECURSIVE_MUTEX or queueQUEUE_TYPE_MUTEX
 */
-static int IRAM_ATTR lock_acquire_generic(_lock_t *lock, uint32_t delay, uint8_t mutex_type) {
-    xSemaphoreHandle h = (xSemaphoreHandle)(*lock);
-    if (!h) {
-        if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {
-            return 0; /* locking is a no-op before scheduler is up, so this "succeeds" */
-        }
-        /* lazy initialise lock - might have had a static initializer in newlib (that we don't use),
-           or _lock_init might have been called before the scheduler was running... */
-        lock_init_generic(lock, mutex_type);
-        h = (xSemaphoreHandle)(*lock);
-        configASSERT(h != NULL);
-    }
-
+static int IRAM_ATTR lock_acquire_semaphore(xSemaphoreHandle h, uint32_t delay, uint8_t mutex_type) {
     BaseType_t success;
     if (xPortInIsrContext()) {
         /* In ISR Context */
@@ -163,6 +247,49 @@ static int IRAM_ATTR lock_acquire_generic(_lock_t *lock, uint32_t delay, uint8_t
     return (success == pdTRUE) ? 0 : -1;
 }
 
+/* Take a recursive lock which the current task holds again: inflate it, holding the mutex twice */
+static void IRAM_ATTR lock_inflate_held(_lock_t *lock, uint32_t owned)
+{
+    xSemaphoreHandle h = lock_create_mutex(queueQUEUE_TYPE_RECURSIVE_MUTEX);
+    xSemaphoreTakeRecursive(h, 0);
+    xSemaphoreTakeRecursive(h, 0);
+    lock_replace_and_wake(lock, owned, (uint32_t)h);
+}
+
+/* Acquire the lock. wait up to delay ticks, which is either 0 or portMAX_DELAY.
+   mutex_type is queueQUEUE_TYPE_RECURSIVE_MUTEX or queueQUEUE_TYPE_MUTEX
+*/
+static int IRAM_ATTR lock_acquire_generic(_lock_t *lock, uint32_t delay, uint8_t mutex_type) {
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {
+        return 0; /* locking is a no-op before scheduler is up, so this "succeeds" */
+    }
+    if (mutex_type == queueQUEUE_TYPE_RECURSIVE_MUTEX && xPortInIsrContext()) {
+        abort(); /* recursive mutexes make no sense in ISR context */
+    }
+
+    const uint32_t owned = lock_owner_self() | LOCK_HELD;
+    while (true) {
+        uint32_t value = lock_compare_set(lock, 0, owned);
+        if (value == 0) {
+            return 0; /* fast path, the lock was free */
+        }
+        if (!(value & LOCK_HELD)) {
+            return lock_acquire_semaphore((xSemaphoreHandle)value, delay, mutex_type);
+        }
+        if ((value & LOCK_OWNER_MASK) == (owned & LOCK_OWNER_MASK) && mutex_type == queueQUEUE_TYPE_RECURSIVE_MUTEX) {
+            lock_inflate_held(lock, owned);
+            return 0;
+        }
+        if (delay == 0) {
+            return -1;
+        }
+        if (xPortInIsrContext()) {
+            abort(); /* Tried to block on lock from ISR, couldn't... rewrite your program to avoid libc interactions in ISRs! */
+        }
+        lock_wait(lock, value);
+    }
+}
+
 void IRAM_ATTR _lock_acquire(_lock_t *lock) {
     lock_acquire_generic(lock, portMAX_DELAY, queueQUEUE_TYPE_MUTEX);
 }
@@ -179,18 +306,36 @@ int IRAM_ATTR _lock_try_acquire_recursive(_lock_t *lock) {
     return lock_acquire_generic(lock, 0, queueQUEUE_TYPE_RECURSIVE_MUTEX);
 }
 
-/* Release the mutex semaphore for lock.
+/* Release the lock.
    mutex_type is queueQUEUE_TYPE_RECURSIVE_MUTEX or queueQUEUE_TYPE_MUTEX
 */
 static void IRAM_ATTR lock_release_generic(_lock_t *lock, uint8_t mutex_type) {
-    xSemaphoreHandle h = (xSemaphoreHandle)(*lock);
-    if (h == NULL) {
+    uint32_t value = (uint32_t)(*lock);
+    if (value == 0) {
         /* This is probably because the scheduler isn't running yet,
            or the scheduler just started running and some code was
-           "holding" a not-yet-initialised lock... */
+           "holding" a lock while it was a no-op... */
+        return;
+    }
+
+    if (value & LOCK_HELD) {
+        const uint32_t owned = lock_owner_self() | LOCK_HELD;
+        if ((value & LOCK_OWNER_MASK) != (owned & LOCK_OWNER_MASK)) {
+            return; /* not held by the caller */
+        }
+        if (lock_compare_set(lock, owned, 0) == owned) {
+            return; /* fast path, nobody waits for the lock */
+        }
+        if (xPortInIsrContext()) {
+            /* can't create a semaphore here, release the lock and let the waiters retry */
+            lock_replace_and_wake(lock, owned, 0);
+        } else {
+            lock_replace_and_wake(lock, owned, (uint32_t)lock_create_mutex(mutex_type));
+        }
         return;
     }
 
+    xSemaphoreHandle h = (xSemaphoreHandle)value;
     if (xPortInIsrContext()) {
         if (mutex_type == queueQUEUE_TYPE_RECURSIVE_MUTEX) {
             abort(); /* indicates logic bug, it shouldn't be possible to lock recursively in ISR */
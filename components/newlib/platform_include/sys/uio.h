@@ -14,8 +14,25 @@
 #ifndef _ESP_PLATFORM_SYS_UIO_H_
 #define _ESP_PLATFORM_SYS_UIO_H_
 
-int writev(int s, const struct iovec *iov, int iovcnt);
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct iovec {
+    void *iov_base;
+    size_t iov_len;
+};
+// lwIP only defines its own struct iovec if this is not defined
+#define iovec iovec
+
+ssize_t writev(int fd, const struct iovec *iov, int iovcnt);
 
 ssize_t readv(int fd, const struct iovec *iov, int iovcnt);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif // _ESP_PLATFORM_SYS_UIO_H_
@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <sys/lock.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "unity.h"
+#include "test_utils.h"
+
+TEST_CASE("uncontended newlib locks don't allocate", "[newlib]")
+{
+    _lock_t lock;
+    _lock_t recursive_lock;
+
+    size_t free_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    _lock_init(&lock);
+    _lock_init_recursive(&recursive_lock);
+    for (int i = 0; i < 100; i++) {
+        _lock_acquire(&lock);
+        _lock_release(&lock);
+        TEST_ASSERT_EQUAL_INT(0, _lock_try_acquire(&lock));
+        TEST_ASSERT_EQUAL_INT(-1, _lock_try_acquire(&lock));
+        _lock_release(&lock);
+        _lock_acquire_recursive(&recursive_lock);
+        _lock_release_recursive(&recursive_lock);
+    }
+    TEST_ASSERT_EQUAL(free_before, heap_caps_get_free_size(MALLOC_CAP_8BIT));
+
+    /* Taking a recursive lock again needs a semaphore */
+    _lock_acquire_recursive(&recursive_lock);
+    _lock_acquire_recursive(&recursive_lock);
+    TEST_ASSERT_EQUAL_INT(0, _lock_try_acquire_recursive(&recursive_lock));
+    _lock_release_recursive(&recursive_lock);
+    _lock_release_recursive(&recursive_lock);
+    _lock_release_recursive(&recursive_lock);
+
+    _lock_close(&lock);
+    _lock_close_recursive(&recursive_lock);
+    TEST_ASSERT_EQUAL(free_before, heap_caps_get_free_size(MALLOC_CAP_8BIT));
+}
+
+typedef struct {
+    _lock_t lock;
+    volatile int inside;
+    volatile int count;
+    volatile bool failed;
+    SemaphoreHandle_t done;
+} lock_test_args_t;
+
+static const int s_lock_test_iterations = 10000;
+
+static void lock_test_task(void *arg)
+{
+    lock_test_args_t *args = (lock_test_args_t *) arg;
+
+    for (int i = 0; i < s_lock_test_iterations; i++) {
+        _lock_acquire(&args->lock);
+        if (args->inside++) {
+            args->failed = true;
+        }
+        args->count++;
+        if ((i & 0xff) == 0) {
+            /* let the other tasks wait for the lock */
+            vTaskDelay(1);
+        }
+        args->inside--;
+        _lock_release(&args->lock);
+    }
+    xSemaphoreGive(args->done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("contended newlib lock", "[newlib]")
+{
+    const int task_count = 4;
+    lock_test_args_t args = {
+        .done = xSemaphoreCreateCounting(task_count, 0),
+    };
+    TEST_ASSERT_NOT_NULL(args.done);
+    _lock_init(&args.lock);
+
+    for (int i = 0; i < task_count; i++) {
+        TEST_ASSERT(xTaskCreatePinnedToCore(lock_test_task, "lock_test", 2048, &args,
+                                            UNITY_FREERTOS_PRIORITY - 1 + (i & 1), NULL, i % portNUM_PROCESSORS));
+    }
+    for (int i = 0; i < task_count; i++) {
+        TEST_ASSERT(xSemaphoreTake(args.done, 10000 / portTICK_PERIOD_MS));
+    }
+
+    TEST_ASSERT_FALSE(args.failed);
+    TEST_ASSERT_EQUAL_INT(task_count * s_lock_test_iterations, args.count);
+    _lock_close(&args.lock);
+    vSemaphoreDelete(args.done);
+    /* let the idle tasks free the deleted tasks */
+    vTaskDelay(10);
+}
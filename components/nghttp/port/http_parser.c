@@ -462,6 +462,92 @@ do {                                                                 \
 
 /* Map errno values to strings for human-readable output */
 #define HTTP_STRERROR_GEN(n, s) { "HPE_" #n, s },
+/* Header scanning fast paths.
+ *
+ * Field names which are complete in the buffer are scanned in one pass and the
+ * few names the parser cares about are recognised by length and first/last
+ * character before comparing them, instead of running the matching state machine
+ * for every byte. Header values are scanned for CR/LF one 32-bit word at a time.
+ */
+
+/* Non-zero if any byte of the word is zero */
+#define WORD_HAS_ZERO(v)    (((v) - 0x01010101U) & ~(v) & 0x80808080U)
+/* Non-zero if any byte of the word is equal to b */
+#define WORD_HAS_BYTE(v, b) WORD_HAS_ZERO((v) ^ (0x01010101U * (uint8_t)(b)))
+
+/* Returns the first CR or LF in [p, end), or end */
+static const char *
+find_crlf(const char *p, const char *end)
+{
+  while (p != end && ((uintptr_t) p & 3)) {
+    if (*p == CR || *p == LF) return p;
+    p++;
+  }
+  for (; end - p >= 4; p += 4) {
+    uint32_t w;
+    memcpy(&w, p, sizeof(w)); /* aligned, compiles to a single load */
+    if (WORD_HAS_BYTE(w, CR) | WORD_HAS_BYTE(w, LF)) break;
+  }
+  for (; p != end; p++) {
+    if (*p == CR || *p == LF) return p;
+  }
+  return end;
+}
+
+/* Returns the end of the run of token characters (spaces excluded) starting at p */
+static const char *
+scan_header_field(const char *p, const char *end)
+{
+  char c;
+  while (p != end && (c = TOKEN(*p)) && c != ' ') p++;
+  return p;
+}
+
+/* Case insensitive compare of a header field with lower case name */
+static int
+header_field_is(const char *field, const char *name, size_t len)
+{
+  size_t i;
+  for (i = 0; i < len; i++) {
+    if (TOKEN(field[i]) != name[i]) return 0;
+  }
+  return 1;
+}
+
+/* Header state after a complete field name, the same as set by s_header_field */
+static enum header_states
+header_field_state(const char *field, size_t len)
+{
+  char first = TOKEN(field[0]);
+  char last = TOKEN(field[len - 1]);
+
+  switch (len) {
+    case sizeof(UPGRADE) - 1:
+      if (first == 'u' && last == 'e' && header_field_is(field, UPGRADE, len))
+        return h_upgrade;
+      break;
+    case sizeof(CONNECTION) - 1:
+      if (first == 'c' && last == 'n' && header_field_is(field, CONNECTION, len))
+        return h_connection;
+      break;
+    case sizeof(CONTENT_LENGTH) - 1:
+      if (first == 'c' && last == 'h' && header_field_is(field, CONTENT_LENGTH, len))
+        return h_content_length;
+      break;
+    case sizeof(PROXY_CONNECTION) - 1:
+      if (first == 'p' && last == 'n' && header_field_is(field, PROXY_CONNECTION, len))
+        return h_connection;
+      break;
+    case sizeof(TRANSFER_ENCODING) - 1:
+      if (first == 't' && last == 'g' && header_field_is(field, TRANSFER_ENCODING, len))
+        return h_transfer_encoding;
+      break;
+    default:
+      break;
+  }
+  return h_general;
+}
+
 static struct {
   const char *name;
   const char *description;
@@ -1271,6 +1357,33 @@ reexecute:
         parser->index = 0;
         UPDATE_STATE(s_header_field);
 
+        {
+          /* Fast path: the whole field name and the colon are in the buffer */
+          const char* field_end = scan_header_field(p + 1, data + len);
+          if (field_end != data + len && *field_end == ':') {
+            size_t field_len = field_end - p;
+
+            /* s_header_field sets the flag when the name starts with content-length */
+            if (field_len >= sizeof(CONTENT_LENGTH) - 1
+                && header_field_is(p, CONTENT_LENGTH, sizeof(CONTENT_LENGTH) - 1)) {
+              if (parser->flags & F_CONTENTLENGTH) {
+                /* Report the error at the last character of the name, as s_header_field does */
+                p += sizeof(CONTENT_LENGTH) - 2;
+                SET_ERRNO(HPE_UNEXPECTED_CONTENT_LENGTH);
+                goto error;
+              }
+              parser->flags |= F_CONTENTLENGTH;
+            }
+            parser->header_state = header_field_state(p, field_len);
+
+            COUNT_HEADER_SIZE(field_end - p);
+            p = field_end;
+            UPDATE_STATE(s_header_value_discard_ws);
+            CALLBACK_DATA(header_field);
+            break;
+          }
+        }
+
         switch (c) {
           case 'c':
             parser->header_state = h_C;
@@ -1533,21 +1646,14 @@ reexecute:
           switch (h_state) {
             case h_general:
             {
-              const char* p_cr;
-              const char* p_lf;
               size_t limit = data + len - p;
+              const char* p_crlf;
 
               limit = MIN(limit, HTTP_MAX_HEADER_SIZE);
 
-              p_cr = (const char*) memchr(p, CR, limit);
-              p_lf = (const char*) memchr(p, LF, limit);
-              if (p_cr != NULL) {
-                if (p_lf != NULL && p_cr >= p_lf)
-                  p = p_lf;
-                else
-                  p = p_cr;
-              } else if (UNLIKELY(p_lf != NULL)) {
-                p = p_lf;
+              p_crlf = find_crlf(p, p + limit);
+              if (p_crlf != p + limit) {
+                p = p_crlf;
               } else {
                 p = data + len;
               }
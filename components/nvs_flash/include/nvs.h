@@ -136,6 +136,36 @@ esp_err_t nvs_open(const char* name, nvs_open_mode open_mode, nvs_handle *out_ha
  */
 esp_err_t nvs_open_from_partition(const char *part_name, const char* name, nvs_open_mode open_mode, nvs_handle *out_handle);
 
+/**
+ * @brief      Open non-volatile storage with a given namespace, keeping recently read values in RAM
+ *
+ * The behaviour is same as nvs_open() API. In addition, values read through the returned
+ * handle are kept in a least recently used cache, so reading them again doesn't access flash.
+ * Cached values are dropped when they are changed or erased through any handle.
+ *
+ * @param[in]  name        Namespace name, same as for nvs_open().
+ * @param[in]  open_mode   NVS_READWRITE or NVS_READONLY, same as for nvs_open().
+ * @param[in]  cache_size  Maximal number of bytes used by the cache. Each cached value takes
+ *                         its size plus about 40 bytes of bookkeeping. If 0, no cache is used.
+ * @param[out] out_handle  If successful (return code is zero), handle will be
+ *                         returned in this argument.
+ *
+ * @return
+ *             - ESP_OK if storage handle was opened successfully
+ *             - ESP_ERR_NO_MEM if memory for the cache could not be allocated
+ *             - other error codes, same as for nvs_open()
+ */
+esp_err_t nvs_open_cached(const char* name, nvs_open_mode open_mode, size_t cache_size, nvs_handle *out_handle);
+
+/**
+ * @brief      Open non-volatile storage with a given namespace from specified partition,
+ *             keeping recently read values in RAM
+ *
+ * The behaviour is same as nvs_open_cached() API, but for the partition specified
+ * the same way as for nvs_open_from_partition().
+ */
+esp_err_t nvs_open_cached_from_partition(const char *part_name, const char* name, nvs_open_mode open_mode, size_t cache_size, nvs_handle *out_handle);
+
 /**@{*/
 /**
  * @brief      set value for given key
@@ -368,13 +398,195 @@ esp_err_t nvs_erase_all(nvs_handle handle);
  */
 esp_err_t nvs_commit(nvs_handle handle);
 
+/**
+ * @brief      Start collecting changes into a transaction
+ *
+ * After this call, nvs_set_*, nvs_set_blob and nvs_erase_key only stage the
+ * changes in RAM. Staged changes are written by nvs_transaction_commit (or
+ * nvs_commit), which packs consecutive values into as few flash writes as
+ * possible and erases the replaced values in bulk. Reading through the handle
+ * returns the values which are currently in flash, not the staged ones.
+ * nvs_erase_all can not be used while a transaction is open.
+ *
+ * @note       A transaction is not atomic: if power goes off during the commit,
+ *             some of the staged changes may be written and others not.
+ *             Each individual value is either old or new after re-initialization.
+ *
+ * @param[in]  handle  Storage handle obtained with nvs_open.
+ *                     Handles that were opened read only cannot be used.
+ *
+ * @return
+ *             - ESP_OK if the transaction has been started
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_READ_ONLY if handle was opened as read only
+ *             - ESP_ERR_NVS_INVALID_STATE if a transaction is already open for this handle
+ *             - ESP_ERR_NO_MEM if memory for the transaction could not be allocated
+ */
+esp_err_t nvs_transaction_begin(nvs_handle handle);
+
+/**
+ * @brief      Write all changes staged since nvs_transaction_begin, and end the transaction
+ *
+ * Staged erases of keys which don't exist are ignored. The transaction is ended
+ * even if writing fails; in that case changes staged before the failing one
+ * may have been written.
+ *
+ * @param[in]  handle  Storage handle obtained with nvs_open.
+ *
+ * @return
+ *             - ESP_OK if all changes have been written successfully
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_INVALID_STATE if no transaction is open for this handle
+ *             - ESP_ERR_NVS_NOT_ENOUGH_SPACE if there is not enough space in the
+ *               underlying storage to save the values
+ *             - ESP_ERR_NVS_REMOVE_FAILED if the new values were written, but
+ *               removing the old ones has failed. Update will be finished after
+ *               re-initialization of nvs, provided that flash operation doesn't fail again.
+ *             - other error codes from the underlying storage driver
+ */
+esp_err_t nvs_transaction_commit(nvs_handle handle);
+
+/**
+ * @brief      Discard all changes staged since nvs_transaction_begin, and end the transaction
+ *
+ * @param[in]  handle  Storage handle obtained with nvs_open.
+ *
+ * @return
+ *             - ESP_OK if the transaction has been discarded
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_INVALID_STATE if no transaction is open for this handle
+ */
+esp_err_t nvs_transaction_abort(nvs_handle handle);
+
+/**
+ * @brief      Open a blob stream, to read or write a blob one part at a time
+ *
+ * Blob streams allow storing and loading blobs larger than the available RAM.
+ * Data is read from or written to flash page by page, and at most one page
+ * worth of data (about 4000 bytes) is kept in RAM while writing. Each handle
+ * can have one blob stream open at a time.
+ *
+ * In NVS_READONLY mode, the stream reads the current value of the blob, which
+ * is then read with nvs_blob_read_chunk.
+ * In NVS_READWRITE mode, the stream writes a new value, passed to
+ * nvs_blob_write_chunk. The new value replaces the old one when the stream is
+ * closed with nvs_blob_close. Until then, readers see the old value, and other
+ * writes of the same blob fail with ESP_ERR_NVS_INVALID_STATE.
+ *
+ * @param[in]  handle      Storage handle obtained with nvs_open.
+ * @param[in]  key         Key name. Maximal length is (NVS_KEY_NAME_MAX_SIZE-1) characters. Shouldn't be empty.
+ * @param[in]  open_mode   NVS_READONLY to read the blob, NVS_READWRITE to write it.
+ * @param[out] out_length  Total length of the blob, in bytes. Only set in NVS_READONLY mode,
+ *                         may be NULL in NVS_READWRITE mode.
+ *
+ * @return
+ *             - ESP_OK if the stream has been opened
+ *             - ESP_ERR_NVS_NOT_FOUND if the blob doesn't exist (NVS_READONLY mode)
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_READ_ONLY if NVS_READWRITE mode is used with a read only handle
+ *             - ESP_ERR_NVS_INVALID_STATE if a blob stream is already open for this handle,
+ *               if the blob is being written through another handle, or if a transaction
+ *               is open for this handle (NVS_READWRITE mode)
+ *             - ESP_ERR_NVS_KEY_TOO_LONG if the key name is too long
+ *             - ESP_ERR_NVS_INVALID_LENGTH if out_length is NULL in NVS_READONLY mode
+ *             - ESP_ERR_NO_MEM if memory for the stream could not be allocated
+ */
+esp_err_t nvs_blob_open(nvs_handle handle, const char* key, nvs_open_mode open_mode, size_t* out_length);
+
+/**
+ * @brief      Read the next part of a blob opened with nvs_blob_open in NVS_READONLY mode
+ *
+ * The data of each chunk stored in flash is checked when the end of the chunk
+ * is read. If the check fails, or if the blob was modified or erased since the
+ * stream was opened, ESP_ERR_NVS_NOT_FOUND is returned, and the data read so far
+ * should be discarded. The stream can't be used for reading after an error.
+ *
+ * @param[in]     handle     Storage handle with an open read stream.
+ * @param[out]    out_value  Pointer to the output buffer.
+ * @param[inout]  length     Length of the output buffer on input; number of bytes
+ *                           read on output. Set to zero once the whole blob was read.
+ *
+ * @return
+ *             - ESP_OK if the data has been read
+ *             - ESP_ERR_NVS_NOT_FOUND if the blob has changed or is corrupted
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_INVALID_STATE if no read stream is open for this handle,
+ *               or if an earlier read has failed
+ *             - ESP_ERR_NVS_INVALID_LENGTH if length is NULL
+ *             - other error codes from the underlying storage driver
+ */
+esp_err_t nvs_blob_read_chunk(nvs_handle handle, void* out_value, size_t* length);
+
+/**
+ * @brief      Append data to a blob opened with nvs_blob_open in NVS_READWRITE mode
+ *
+ * Data is written to flash once it fills the free space of the current page.
+ * Data which fills a whole page is written directly from the given buffer.
+ * If writing fails, the stream can't be used any more and should be closed with
+ * nvs_blob_abort.
+ *
+ * @param[in]  handle  Storage handle with an open write stream.
+ * @param[in]  value   Pointer to the data.
+ * @param[in]  length  Length of the data, in bytes.
+ *
+ * @return
+ *             - ESP_OK if the data has been accepted
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_INVALID_STATE if no write stream is open for this handle,
+ *               or if an earlier write has failed
+ *             - ESP_ERR_NVS_VALUE_TOO_LONG if the blob would not fit into the partition
+ *             - ESP_ERR_NVS_NOT_ENOUGH_SPACE if there is not enough space in the
+ *               underlying storage to save the data
+ *             - ESP_ERR_NO_MEM if memory for the write buffer could not be allocated
+ *             - other error codes from the underlying storage driver
+ */
+esp_err_t nvs_blob_write_chunk(nvs_handle handle, const void* value, size_t length);
+
+/**
+ * @brief      Close the blob stream of the handle
+ *
+ * For a write stream, the remaining data and the blob index are written, and the
+ * new value replaces the old one. If power goes off before that, the old value is
+ * kept and the chunks written so far are removed on the next initialization.
+ * The stream is closed even if writing fails.
+ *
+ * @param[in]  handle  Storage handle with an open blob stream.
+ *
+ * @return
+ *             - ESP_OK if the stream has been closed and the new value, if any, stored
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_INVALID_STATE if no blob stream is open for this handle,
+ *               or if an earlier write has failed
+ *             - ESP_ERR_NVS_NOT_ENOUGH_SPACE if there is not enough space in the
+ *               underlying storage to save the value
+ *             - ESP_ERR_NVS_REMOVE_FAILED if the new value was written, but
+ *               removing the old one has failed. Update will be finished after
+ *               re-initialization of nvs, provided that flash operation doesn't fail again.
+ *             - other error codes from the underlying storage driver
+ */
+esp_err_t nvs_blob_close(nvs_handle handle);
+
+/**
+ * @brief      Close the blob stream of the handle, discarding the data written to it
+ *
+ * The old value of the blob is kept.
+ *
+ * @param[in]  handle  Storage handle with an open blob stream.
+ *
+ * @return
+ *             - ESP_OK if the stream has been closed
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_INVALID_STATE if no blob stream is open for this handle
+ */
+esp_err_t nvs_blob_abort(nvs_handle handle);
+
 /**
  * @brief      Close the storage handle and free any allocated resources
  *
  * This function should be called for each handle opened with nvs_open once
  * the handle is not in use any more. Closing the handle may not automatically
  * write the changes to nonvolatile storage. This has to be done explicitly using
- * nvs_commit function.
+ * nvs_commit function. A transaction or a blob stream which is still open is discarded.
  * Once this function is called on a handle, the handle should no longer be used.
  *
  * @param[in]  handle  Storage handle to close
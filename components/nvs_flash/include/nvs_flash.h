@@ -85,6 +85,24 @@ esp_err_t nvs_flash_deinit(void);
  */
 esp_err_t nvs_flash_deinit_partition(const char* partition_label);
 
+/**
+ * @brief Erase one NVS page which is waiting to be erased
+ *
+ * When NVS runs out of free pages, it moves the items of one of its pages to a new
+ * page and frees the old page. With CONFIG_NVS_BACKGROUND_GC, the flash sector of
+ * the freed page is not erased right away; a low priority task erases it later.
+ * This function can be called to erase such pages at a convenient time instead.
+ *
+ * @param[in]  partition_label   Label of the partition, or NULL for the default NVS partition
+ * @param[out] more              If not NULL, set to true if more pages wait to be erased
+ *
+ * @return
+ *      - ESP_OK on success, including when no page had to be erased
+ *      - ESP_ERR_NVS_NOT_INITIALIZED if the storage was not initialized prior to this call
+ *      - one of the error codes from the underlying flash storage driver
+ */
+esp_err_t nvs_flash_gc_step(const char* partition_label, bool* more);
+
 /**
  * @brief Erase the default NVS partition
  *
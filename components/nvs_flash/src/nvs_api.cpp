@@ -24,6 +24,7 @@
 
 #ifdef ESP_PLATFORM
 #include <esp32/rom/crc.h>
+#include "freertos/task.h"
 
 // Uncomment this line to force output from this module
 // #define LOG_LOCAL_LEVEL ESP_LOG_DEBUG
@@ -59,6 +60,9 @@ public:
     uint8_t mReadOnly;
     uint8_t mNsIndex;
     nvs::Storage* mStoragePtr;
+    nvs::Transaction* mTransaction = nullptr;   // owned, freed when the handle is closed
+    nvs::ValueCache* mCache = nullptr;          // owned, freed when the handle is closed
+    nvs::BlobStream* mBlobStream = nullptr;     // owned, discarded when the handle is closed
 };
 
 #ifdef ESP_PLATFORM
@@ -139,6 +143,32 @@ extern "C" esp_err_t nvs_flash_secure_init_custom(const char *partName, uint32_t
 
 
 #ifdef ESP_PLATFORM
+#ifdef CONFIG_NVS_BACKGROUND_GC
+static TaskHandle_t s_gc_task = NULL;
+
+static void nvs_gc_task(void* arg)
+{
+    while (true) {
+        vTaskDelay(CONFIG_NVS_BACKGROUND_GC_PERIOD_MS / portTICK_PERIOD_MS);
+        Lock lock;
+        for (auto it = begin(s_nvs_storage_list); it != end(s_nvs_storage_list); ++it) {
+            bool more;
+            esp_err_t err = it->eraseFreePage(more);
+            if (err != ESP_OK) {
+                ESP_LOGD(TAG, "background erase in partition \"%s\" failed: %d", it->getPartName(), err);
+            }
+        }
+    }
+}
+
+static void nvs_start_gc_task()
+{
+    if (s_gc_task == NULL) {
+        xTaskCreate(nvs_gc_task, "nvs_gc", 2048, NULL, CONFIG_NVS_BACKGROUND_GC_TASK_PRIORITY, &s_gc_task);
+    }
+}
+#endif // CONFIG_NVS_BACKGROUND_GC
+
 extern "C" esp_err_t nvs_flash_init_partition(const char *part_name)
 {
     Lock::init();
@@ -156,8 +186,14 @@ extern "C" esp_err_t nvs_flash_init_partition(const char *part_name)
         return ESP_ERR_NOT_FOUND;
     }
 
-    return nvs_flash_init_custom(part_name, partition->address / SPI_FLASH_SEC_SIZE,
+    esp_err_t err = nvs_flash_init_custom(part_name, partition->address / SPI_FLASH_SEC_SIZE,
             partition->size / SPI_FLASH_SEC_SIZE);
+#ifdef CONFIG_NVS_BACKGROUND_GC
+    if (err == ESP_OK) {
+        nvs_start_gc_task();
+    }
+#endif
+    return err;
 }
 
 extern "C" esp_err_t nvs_flash_init(void)
@@ -183,8 +219,14 @@ extern "C" esp_err_t nvs_flash_secure_init_partition(const char *part_name, nvs_
         return ESP_ERR_NOT_FOUND;
     }
 
-    return nvs_flash_secure_init_custom(part_name, partition->address / SPI_FLASH_SEC_SIZE,
+    esp_err_t err = nvs_flash_secure_init_custom(part_name, partition->address / SPI_FLASH_SEC_SIZE,
             partition->size / SPI_FLASH_SEC_SIZE, cfg);
+#ifdef CONFIG_NVS_BACKGROUND_GC
+    if (err == ESP_OK) {
+        nvs_start_gc_task();
+    }
+#endif
+    return err;
 }
 
 extern "C" esp_err_t nvs_flash_secure_init(nvs_sec_cfg_t* cfg)
@@ -236,6 +278,15 @@ extern "C" esp_err_t nvs_flash_deinit_partition(const char* partition_name)
             ESP_LOGD(TAG, "Deleting handle %d (ns=%d) related to partition \"%s\" (missing call to nvs_close?)",
                      it->mHandle, it->mNsIndex, partition_name);
             s_nvs_handles.erase(it);
+            delete it->mTransaction;
+            if (it->mCache) {
+                storage->unregisterValueCache(it->mCache);
+                delete it->mCache;
+            }
+            if (it->mBlobStream) {
+                storage->abortBlobStream(*it->mBlobStream);
+                delete it->mBlobStream;
+            }
             delete static_cast<HandleEntry*>(it);
         }
         it = next;
@@ -253,6 +304,34 @@ extern "C" esp_err_t nvs_flash_deinit(void)
     return nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME);
 }
 
+extern "C" esp_err_t nvs_flash_gc_step(const char* partition_name, bool* more)
+{
+    Lock lock;
+
+    nvs::Storage* storage = lookup_storage_from_name((partition_name == NULL) ? NVS_DEFAULT_PART_NAME : partition_name);
+    if (!storage) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    bool pending;
+    esp_err_t err = storage->eraseFreePage(pending);
+    if (more) {
+        *more = pending;
+    }
+    return err;
+}
+
+static HandleEntry* lookup_handle(nvs_handle handle)
+{
+    auto it = find_if(begin(s_nvs_handles), end(s_nvs_handles), [=](HandleEntry& e) -> bool {
+        return e.mHandle == handle;
+    });
+    if (it == end(s_nvs_handles)) {
+        return NULL;
+    }
+    return it;
+}
+
 static esp_err_t nvs_find_ns_handle(nvs_handle handle, HandleEntry& entry)
 {
     auto it = find_if(begin(s_nvs_handles), end(s_nvs_handles), [=](HandleEntry& e) -> bool {
@@ -265,10 +344,10 @@ static esp_err_t nvs_find_ns_handle(nvs_handle handle, HandleEntry& entry)
     return ESP_OK;
 }
 
-extern "C" esp_err_t nvs_open_from_partition(const char *part_name, const char* name, nvs_open_mode open_mode, nvs_handle *out_handle)
+static esp_err_t nvs_open_with_cache(const char *part_name, const char* name, nvs_open_mode open_mode, size_t cache_size, nvs_handle *out_handle)
 {
     Lock lock;
-    ESP_LOGD(TAG, "%s %s %d", __func__, name, open_mode);
+    ESP_LOGD(TAG, "%s %s %d %d", __func__, name, open_mode, cache_size);
     uint8_t nsIndex;
     nvs::Storage* sHandle;
 
@@ -282,7 +361,17 @@ extern "C" esp_err_t nvs_open_from_partition(const char *part_name, const char*
         return err;
     }
 
+    nvs::ValueCache* cache = NULL;
+    if (cache_size > 0) {
+        cache = new (std::nothrow) nvs::ValueCache(nsIndex, cache_size);
+        if (cache == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        sHandle->registerValueCache(cache);
+    }
+
     HandleEntry *handle_entry = new HandleEntry(open_mode==NVS_READONLY, nsIndex, sHandle);
+    handle_entry->mCache = cache;
     s_nvs_handles.push_back(handle_entry);
 
     *out_handle = handle_entry->mHandle;
@@ -290,6 +379,11 @@ extern "C" esp_err_t nvs_open_from_partition(const char *part_name, const char*
     return ESP_OK;
 }
 
+extern "C" esp_err_t nvs_open_from_partition(const char *part_name, const char* name, nvs_open_mode open_mode, nvs_handle *out_handle)
+{
+    return nvs_open_with_cache(part_name, name, open_mode, 0, out_handle);
+}
+
 extern "C" esp_err_t nvs_open(const char* name, nvs_open_mode open_mode, nvs_handle *out_handle)
 {
     if (s_nvs_storage_list.size() == 0) {
@@ -299,6 +393,20 @@ extern "C" esp_err_t nvs_open(const char* name, nvs_open_mode open_mode, nvs_han
     return nvs_open_from_partition(NVS_DEFAULT_PART_NAME, name, open_mode, out_handle);
 }
 
+extern "C" esp_err_t nvs_open_cached_from_partition(const char *part_name, const char* name, nvs_open_mode open_mode, size_t cache_size, nvs_handle *out_handle)
+{
+    return nvs_open_with_cache(part_name, name, open_mode, cache_size, out_handle);
+}
+
+extern "C" esp_err_t nvs_open_cached(const char* name, nvs_open_mode open_mode, size_t cache_size, nvs_handle *out_handle)
+{
+    if (s_nvs_storage_list.size() == 0) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    return nvs_open_with_cache(NVS_DEFAULT_PART_NAME, name, open_mode, cache_size, out_handle);
+}
+
 extern "C" void nvs_close(nvs_handle handle)
 {
     Lock lock;
@@ -310,6 +418,15 @@ extern "C" void nvs_close(nvs_handle handle)
         return;
     }
     s_nvs_handles.erase(it);
+    delete it->mTransaction;
+    if (it->mCache) {
+        it->mStoragePtr->unregisterValueCache(it->mCache);
+        delete it->mCache;
+    }
+    if (it->mBlobStream) {
+        it->mStoragePtr->abortBlobStream(*it->mBlobStream);
+        delete it->mBlobStream;
+    }
     delete static_cast<HandleEntry*>(it);
 }
 
@@ -325,6 +442,9 @@ extern "C" esp_err_t nvs_erase_key(nvs_handle handle, const char* key)
     if (entry.mReadOnly) {
         return ESP_ERR_NVS_READ_ONLY;
     }
+    if (entry.mTransaction) {
+        return entry.mTransaction->stageErase(key);
+    }
     return entry.mStoragePtr->eraseItem(entry.mNsIndex, key);
 }
 
@@ -340,6 +460,9 @@ extern "C" esp_err_t nvs_erase_all(nvs_handle handle)
     if (entry.mReadOnly) {
         return ESP_ERR_NVS_READ_ONLY;
     }
+    if (entry.mTransaction) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
     return entry.mStoragePtr->eraseNamespace(entry.mNsIndex);
 }
 
@@ -356,6 +479,9 @@ static esp_err_t nvs_set(nvs_handle handle, const char* key, T value)
     if (entry.mReadOnly) {
         return ESP_ERR_NVS_READ_ONLY;
     }
+    if (entry.mTransaction) {
+        return entry.mTransaction->stageWrite(itemTypeOf(value), key, &value, sizeof(value));
+    }
     return entry.mStoragePtr->writeItem(entry.mNsIndex, key, value);
 }
 
@@ -399,12 +525,78 @@ extern "C" esp_err_t nvs_set_u64 (nvs_handle handle, const char* key, uint64_t v
     return nvs_set(handle, key, value);
 }
 
+static esp_err_t nvs_write_transaction(HandleEntry* entry)
+{
+    nvs::Transaction* transaction = entry->mTransaction;
+    entry->mTransaction = nullptr;
+    auto err = entry->mStoragePtr->writeTransaction(entry->mNsIndex, *transaction);
+    delete transaction;
+    return err;
+}
+
 extern "C" esp_err_t nvs_commit(nvs_handle handle)
 {
     Lock lock;
-    // no-op for now, to be used when intermediate cache is added
-    HandleEntry entry;
-    return nvs_find_ns_handle(handle, entry);
+    // only staged transactions are written here, other changes are written immediately
+    HandleEntry* entry = lookup_handle(handle);
+    if (entry == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (entry->mTransaction) {
+        return nvs_write_transaction(entry);
+    }
+    return ESP_OK;
+}
+
+extern "C" esp_err_t nvs_transaction_begin(nvs_handle handle)
+{
+    Lock lock;
+    ESP_LOGD(TAG, "%s %d", __func__, handle);
+    HandleEntry* entry = lookup_handle(handle);
+    if (entry == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (entry->mReadOnly) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    if (entry->mTransaction) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+    entry->mTransaction = new (std::nothrow) nvs::Transaction;
+    if (entry->mTransaction == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+extern "C" esp_err_t nvs_transaction_commit(nvs_handle handle)
+{
+    Lock lock;
+    ESP_LOGD(TAG, "%s %d", __func__, handle);
+    HandleEntry* entry = lookup_handle(handle);
+    if (entry == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (entry->mTransaction == NULL) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+    return nvs_write_transaction(entry);
+}
+
+extern "C" esp_err_t nvs_transaction_abort(nvs_handle handle)
+{
+    Lock lock;
+    ESP_LOGD(TAG, "%s %d", __func__, handle);
+    HandleEntry* entry = lookup_handle(handle);
+    if (entry == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (entry->mTransaction == NULL) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+    delete entry->mTransaction;
+    entry->mTransaction = nullptr;
+    return ESP_OK;
 }
 
 extern "C" esp_err_t nvs_set_str(nvs_handle handle, const char* key, const char* value)
@@ -416,6 +608,9 @@ extern "C" esp_err_t nvs_set_str(nvs_handle handle, const char* key, const char*
     if (err != ESP_OK) {
         return err;
     }
+    if (entry.mTransaction) {
+        return entry.mTransaction->stageWrite(nvs::ItemType::SZ, key, value, strlen(value) + 1);
+    }
     return entry.mStoragePtr->writeItem(entry.mNsIndex, nvs::ItemType::SZ, key, value, strlen(value) + 1);
 }
 
@@ -428,6 +623,9 @@ extern "C" esp_err_t nvs_set_blob(nvs_handle handle, const char* key, const void
     if (err != ESP_OK) {
         return err;
     }
+    if (entry.mTransaction) {
+        return entry.mTransaction->stageWrite(nvs::ItemType::BLOB, key, value, length);
+    }
     return entry.mStoragePtr->writeItem(entry.mNsIndex, nvs::ItemType::BLOB, key, value, length);
 }
 
@@ -442,7 +640,19 @@ static esp_err_t nvs_get(nvs_handle handle, const char* key, T* out_value)
     if (err != ESP_OK) {
         return err;
     }
-    return entry.mStoragePtr->readItem(entry.mNsIndex, key, *out_value);
+    if (entry.mCache) {
+        size_t dataSize;
+        const uint8_t* data = entry.mCache->find(itemTypeOf(*out_value), key, dataSize);
+        if (data && dataSize == sizeof(T)) {
+            memcpy(out_value, data, sizeof(T));
+            return ESP_OK;
+        }
+    }
+    err = entry.mStoragePtr->readItem(entry.mNsIndex, key, *out_value);
+    if (err == ESP_OK && entry.mCache) {
+        entry.mCache->insert(itemTypeOf(*out_value), key, out_value, sizeof(T));
+    }
+    return err;
 }
 
 extern "C" esp_err_t nvs_get_i8  (nvs_handle handle, const char* key, int8_t* out_value)
@@ -496,9 +706,15 @@ static esp_err_t nvs_get_str_or_blob(nvs_handle handle, nvs::ItemType type, cons
     }
 
     size_t dataSize;
-    err = entry.mStoragePtr->getItemDataSize(entry.mNsIndex, type, key, dataSize);
-    if (err != ESP_OK) {
-        return err;
+    const uint8_t* cached = NULL;
+    if (entry.mCache) {
+        cached = entry.mCache->find(type, key, dataSize);
+    }
+    if (cached == NULL) {
+        err = entry.mStoragePtr->getItemDataSize(entry.mNsIndex, type, key, dataSize);
+        if (err != ESP_OK) {
+            return err;
+        }
     }
 
     if (length == nullptr) {
@@ -512,7 +728,15 @@ static esp_err_t nvs_get_str_or_blob(nvs_handle handle, nvs::ItemType type, cons
     }
 
     *length = dataSize;
-    return entry.mStoragePtr->readItem(entry.mNsIndex, type, key, out_value, dataSize);
+    if (cached) {
+        memcpy(out_value, cached, dataSize);
+        return ESP_OK;
+    }
+    err = entry.mStoragePtr->readItem(entry.mNsIndex, type, key, out_value, dataSize);
+    if (err == ESP_OK && entry.mCache) {
+        entry.mCache->insert(type, key, out_value, dataSize);
+    }
+    return err;
 }
 
 extern "C" esp_err_t nvs_get_str(nvs_handle handle, const char* key, char* out_value, size_t* length)
@@ -525,6 +749,112 @@ extern "C" esp_err_t nvs_get_blob(nvs_handle handle, const char* key, void* out_
     return nvs_get_str_or_blob(handle, nvs::ItemType::BLOB, key, out_value, length);
 }
 
+extern "C" esp_err_t nvs_blob_open(nvs_handle handle, const char* key, nvs_open_mode open_mode, size_t* out_length)
+{
+    Lock lock;
+    ESP_LOGD(TAG, "%s %s %d", __func__, key, open_mode);
+    HandleEntry* entry = lookup_handle(handle);
+    if (entry == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (open_mode == NVS_READWRITE && entry->mReadOnly) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    if (entry->mBlobStream || (open_mode == NVS_READWRITE && entry->mTransaction)) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+    if (open_mode == NVS_READONLY && out_length == NULL) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    if (strlen(key) > nvs::Item::MAX_KEY_LENGTH) {
+        return ESP_ERR_NVS_KEY_TOO_LONG;
+    }
+
+    auto mode = (open_mode == NVS_READWRITE) ? nvs::BlobStream::Mode::WRITE : nvs::BlobStream::Mode::READ;
+    nvs::BlobStream* stream = new (std::nothrow) nvs::BlobStream(mode, entry->mNsIndex, key);
+    if (stream == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    auto err = entry->mStoragePtr->openBlobStream(*stream);
+    if (err != ESP_OK) {
+        delete stream;
+        return err;
+    }
+    if (out_length) {
+        *out_length = stream->mDataSize;
+    }
+    entry->mBlobStream = stream;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t nvs_blob_read_chunk(nvs_handle handle, void* out_value, size_t* length)
+{
+    Lock lock;
+    HandleEntry* entry = lookup_handle(handle);
+    if (entry == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (entry->mBlobStream == NULL || entry->mBlobStream->mMode != nvs::BlobStream::Mode::READ) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+    if (length == NULL || (out_value == NULL && *length > 0)) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    return entry->mStoragePtr->readBlobStream(*entry->mBlobStream, out_value, *length);
+}
+
+extern "C" esp_err_t nvs_blob_write_chunk(nvs_handle handle, const void* value, size_t length)
+{
+    Lock lock;
+    HandleEntry* entry = lookup_handle(handle);
+    if (entry == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (entry->mBlobStream == NULL || entry->mBlobStream->mMode != nvs::BlobStream::Mode::WRITE) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+    if (value == NULL && length > 0) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    return entry->mStoragePtr->writeBlobStream(*entry->mBlobStream, value, length);
+}
+
+extern "C" esp_err_t nvs_blob_close(nvs_handle handle)
+{
+    Lock lock;
+    ESP_LOGD(TAG, "%s %d", __func__, handle);
+    HandleEntry* entry = lookup_handle(handle);
+    if (entry == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    nvs::BlobStream* stream = entry->mBlobStream;
+    if (stream == NULL) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+    entry->mBlobStream = nullptr;
+    auto err = entry->mStoragePtr->closeBlobStream(*stream);
+    delete stream;
+    return err;
+}
+
+extern "C" esp_err_t nvs_blob_abort(nvs_handle handle)
+{
+    Lock lock;
+    ESP_LOGD(TAG, "%s %d", __func__, handle);
+    HandleEntry* entry = lookup_handle(handle);
+    if (entry == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    nvs::BlobStream* stream = entry->mBlobStream;
+    if (stream == NULL) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+    entry->mBlobStream = nullptr;
+    entry->mStoragePtr->abortBlobStream(*stream);
+    delete stream;
+    return ESP_OK;
+}
+
 extern "C" esp_err_t nvs_get_stats(const char* part_name, nvs_stats_t* nvs_stats)
 {
     Lock lock;
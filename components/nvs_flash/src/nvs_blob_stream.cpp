@@ -0,0 +1,59 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "nvs_blob_stream.hpp"
+#include <cstring>
+#include <new>
+
+namespace nvs
+{
+
+BlobStream::BlobStream(Mode mode, uint8_t nsIndex, const char* key) : mMode(mode), mNsIndex(nsIndex)
+{
+    strncpy(mKey, key, sizeof(mKey) - 1);
+    mKey[sizeof(mKey) - 1] = 0;
+}
+
+BlobStream::~BlobStream()
+{
+    delete[] mBuffer;
+}
+
+esp_err_t BlobStream::reserveBuffer(size_t size)
+{
+    if (size <= mBufferCapacity) {
+        return ESP_OK;
+    }
+    uint8_t* buffer = new (std::nothrow) uint8_t[size];
+    if (!buffer) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (mBufferSize > 0) {
+        memcpy(buffer, mBuffer, mBufferSize);
+    }
+    delete[] mBuffer;
+    mBuffer = buffer;
+    mBufferCapacity = size;
+    return ESP_OK;
+}
+
+void BlobStream::consumeBuffer(size_t size)
+{
+    assert(size <= mBufferSize);
+    mBufferSize -= size;
+    if (mBufferSize > 0) {
+        memmove(mBuffer, mBuffer + size, mBufferSize);
+    }
+}
+
+} // namespace nvs
@@ -0,0 +1,77 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef nvs_blob_stream_hpp
+#define nvs_blob_stream_hpp
+
+#include "nvs.h"
+#include "nvs_types.hpp"
+#include "intrusive_list.h"
+
+namespace nvs
+{
+
+/**
+ * State of a blob which is read or written one part at a time.
+ *
+ * Reading and writing is done by Storage::readBlobStream and
+ * Storage::writeBlobStream, which walk the blob data chunks page by page.
+ * A stream being written keeps at most one chunk of data in RAM. Data which
+ * fills a whole chunk is written to flash directly from the caller's buffer.
+ * Streams being written are registered with Storage, which prevents other
+ * writes of the same blob until the stream is closed.
+ */
+class BlobStream : public intrusive_list_node<BlobStream>
+{
+public:
+    enum class Mode : uint8_t {
+        READ,
+        WRITE,
+    };
+
+    BlobStream(Mode mode, uint8_t nsIndex, const char* key);
+    ~BlobStream();
+
+    /** Make sure the write buffer can hold at least 'size' bytes */
+    esp_err_t reserveBuffer(size_t size);
+
+    /** Drop 'size' bytes from the start of the write buffer */
+    void consumeBuffer(size_t size);
+
+    Mode mMode;
+    uint8_t mNsIndex;
+    char mKey[Item::MAX_KEY_LENGTH + 1];
+    bool mFailed = false;           // set when the stream can't be used any more
+
+    ItemType mChunkType = ItemType::BLOB_DATA;  // ItemType::BLOB for blobs stored in the old format
+    VerOffset mChunkStart = VerOffset::VER_0_OFFSET;
+    uint8_t mChunkCount = 0;
+    size_t mDataSize = 0;           // total size when reading, size received so far when writing
+    size_t mOffset = 0;             // number of bytes read
+
+    uint8_t mChunkNum = 0;          // chunk being read
+    size_t mChunkOffset = 0;
+    uint32_t mChunkCrc = 0xffffffff;
+
+    uint8_t* mBuffer = nullptr;     // data waiting to be written
+    size_t mBufferCapacity = 0;
+    size_t mBufferSize = 0;
+
+private:
+    BlobStream(const BlobStream& other);
+    const BlobStream& operator= (const BlobStream& rhs);
+}; // class BlobStream
+
+} // namespace nvs
+
+#endif /* nvs_blob_stream_hpp */
@@ -0,0 +1,183 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "nvs_key_index.hpp"
+#include <new>
+
+namespace nvs
+{
+
+KeyIndex::KeyIndex()
+{
+}
+
+KeyIndex::~KeyIndex()
+{
+    delete[] mSlots;
+}
+
+void KeyIndex::reset(size_t expectedCount)
+{
+    delete[] mSlots;
+    mSlots = nullptr;
+    mCapacity = 0;
+    mCount = 0;
+    mUsedSlots = 0;
+    mValid = true;
+
+    size_t capacity = MIN_CAPACITY;
+    while (expectedCount * 4 >= capacity * 3) {
+        capacity *= 2;
+    }
+    grow(capacity);
+}
+
+void KeyIndex::invalidate()
+{
+    delete[] mSlots;
+    mSlots = nullptr;
+    mCapacity = 0;
+    mCount = 0;
+    mUsedSlots = 0;
+    mValid = false;
+}
+
+bool KeyIndex::grow(size_t capacity)
+{
+    Slot* slots = new (std::nothrow) Slot[capacity];
+    if (!slots) {
+        // Can't track new items any more, fall back to searching all pages
+        invalidate();
+        return false;
+    }
+    for (size_t i = 0; i < capacity; ++i) {
+        slots[i].mCount = 0;
+    }
+
+    Slot* oldSlots = mSlots;
+    size_t oldCapacity = mCapacity;
+    mSlots = slots;
+    mCapacity = capacity;
+    for (size_t i = 0; i < oldCapacity; ++i) {
+        if (oldSlots[i].mCount == 0) {
+            continue;
+        }
+        size_t j = home(oldSlots[i].mHash);
+        while (mSlots[j].mCount != 0) {
+            j = (j + 1) & (mCapacity - 1);
+        }
+        mSlots[j] = oldSlots[i];
+    }
+    delete[] oldSlots;
+    return true;
+}
+
+void KeyIndex::insert(const Item& item, size_t page)
+{
+    if (!mValid) {
+        return;
+    }
+    if ((mUsedSlots + 1) * 4 > mCapacity * 3 && !grow(mCapacity * 2)) {
+        return;
+    }
+
+    const uint32_t hash = hashOf(item);
+    size_t i = home(hash);
+    while (mSlots[i].mCount != 0) {
+        if (mSlots[i].mHash == hash && mSlots[i].mPage == page) {
+            ++mSlots[i].mCount;
+            ++mCount;
+            return;
+        }
+        i = (i + 1) & (mCapacity - 1);
+    }
+    mSlots[i].mHash = hash;
+    mSlots[i].mPage = static_cast<uint16_t>(page);
+    mSlots[i].mCount = 1;
+    ++mUsedSlots;
+    ++mCount;
+}
+
+void KeyIndex::erase(const Item& item, size_t page)
+{
+    if (!mValid) {
+        return;
+    }
+
+    const uint32_t hash = hashOf(item);
+    for (size_t i = home(hash); mSlots[i].mCount != 0; i = (i + 1) & (mCapacity - 1)) {
+        if (mSlots[i].mHash == hash && mSlots[i].mPage == page) {
+            --mCount;
+            if (--mSlots[i].mCount == 0) {
+                removeSlot(i);
+            }
+            return;
+        }
+    }
+}
+
+void KeyIndex::removeSlot(size_t index)
+{
+    // backward shift deletion keeps probe sequences intact without tombstones
+    const size_t mask = mCapacity - 1;
+    size_t hole = index;
+    for (size_t j = (index + 1) & mask; mSlots[j].mCount != 0; j = (j + 1) & mask) {
+        size_t h = home(mSlots[j].mHash);
+        if (((j - h) & mask) >= ((j - hole) & mask)) {
+            mSlots[hole] = mSlots[j];
+            hole = j;
+        }
+    }
+    mSlots[hole].mCount = 0;
+    --mUsedSlots;
+}
+
+size_t KeyIndex::find(size_t& pos, const Item& item) const
+{
+    if (!mValid) {
+        return SIZE_MAX;
+    }
+
+    const uint32_t hash = hashOf(item);
+    const size_t start = home(hash);
+    for (; pos < mCapacity; ++pos) {
+        const Slot& slot = mSlots[(start + pos) & (mCapacity - 1)];
+        if (slot.mCount == 0) {
+            break;
+        }
+        if (slot.mHash == hash) {
+            ++pos;
+            return slot.mPage;
+        }
+    }
+    pos = mCapacity;
+    return SIZE_MAX;
+}
+
+void KeyIndex::movePage(size_t from, size_t to)
+{
+    if (!mValid) {
+        return;
+    }
+
+    /* Slots with the same <hash, page> pair may coexist after this. It is fine:
+     * insert and erase operate on the first one found, and the total count stays right. */
+    for (size_t i = 0; i < mCapacity; ++i) {
+        if (mSlots[i].mCount != 0 && mSlots[i].mPage == from) {
+            mSlots[i].mPage = static_cast<uint16_t>(to);
+        }
+    }
+}
+
+} // namespace nvs
@@ -0,0 +1,108 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef nvs_key_index_hpp
+#define nvs_key_index_hpp
+
+#include "nvs.h"
+#include "nvs_types.hpp"
+
+namespace nvs
+{
+
+/**
+ * Storage-wide index of the items kept in all pages.
+ *
+ * Maps the hash of <nsIndex, key, chunkIndex> (same hash as used by HashList)
+ * to the numbers of the pages holding an item with that hash. The index may
+ * contain stale entries, so callers have to confirm each candidate page using
+ * Page::findItem. It never misses a page holding a live item, which means that
+ * if no candidate page contains the item, the item doesn't exist.
+ *
+ * Implemented as an open addressing table with linear probing. Each slot takes
+ * 8 bytes; the table grows to keep the load factor under 3/4.
+ */
+class KeyIndex
+{
+public:
+    KeyIndex();
+    ~KeyIndex();
+
+    /** Drop all entries and start accepting updates */
+    void reset(size_t expectedCount = 0);
+
+    /** Drop all entries and stop using the index until the next reset */
+    void invalidate();
+
+    bool isValid() const
+    {
+        return mValid;
+    }
+
+    size_t size() const
+    {
+        return mCount;
+    }
+
+    void insert(const Item& item, size_t page);
+
+    void erase(const Item& item, size_t page);
+
+    /**
+     * Find the next page which may hold the item.
+     * @param pos probe position, should be set to 0 before the first call
+     * @return page number, or SIZE_MAX if there are no more candidates
+     */
+    size_t find(size_t& pos, const Item& item) const;
+
+    /** Re-point all entries of page 'from' to page 'to', after the page was copied */
+    void movePage(size_t from, size_t to);
+
+private:
+    KeyIndex(const KeyIndex& other);
+    const KeyIndex& operator= (const KeyIndex& rhs);
+
+protected:
+    struct Slot {
+        uint32_t mHash;
+        uint16_t mPage;
+        uint16_t mCount;    // number of items with this hash on the page, 0 if slot is empty
+    };
+
+    static uint32_t hashOf(const Item& item)
+    {
+        return item.calculateCrc32WithoutValue();
+    }
+
+    size_t home(uint32_t hash) const
+    {
+        return hash & (mCapacity - 1);
+    }
+
+    bool grow(size_t capacity);
+
+    void removeSlot(size_t index);
+
+    static const size_t MIN_CAPACITY = 16;
+
+    Slot* mSlots = nullptr;
+    size_t mCapacity = 0;
+    size_t mCount = 0;
+    size_t mUsedSlots = 0;
+    bool mValid = false;
+}; // class KeyIndex
+
+} // namespace nvs
+
+#endif /* nvs_key_index_hpp */
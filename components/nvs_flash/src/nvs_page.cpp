@@ -12,11 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 #include "nvs_page.hpp"
-#if defined(ESP_PLATFORM)
-#include <esp32/rom/crc.h>
-#else
-#include "crc.h"
-#endif
+#include "esp_crc.h"
 #include <cstdio>
 #include <cstring>
 
@@ -27,9 +23,9 @@ namespace nvs
 
 uint32_t Page::Header::calculateCrc32()
 {
-    return crc32_le(0xffffffff,
-                    reinterpret_cast<uint8_t*>(this) + offsetof(Header, mSeqNumber),
-                    offsetof(Header, mCrc32) - offsetof(Header, mSeqNumber));
+    return esp_crc32_le(0xffffffff,
+                        reinterpret_cast<uint8_t*>(this) + offsetof(Header, mSeqNumber),
+                        offsetof(Header, mCrc32) - offsetof(Header, mSeqNumber));
 }
 
 esp_err_t Page::load(uint32_t sectorNumber)
@@ -37,6 +33,7 @@ esp_err_t Page::load(uint32_t sectorNumber)
     mBaseAddress = sectorNumber * SEC_SIZE;
     mUsedEntryCount = 0;
     mErasedEntryCount = 0;
+    mHashListLoaded = true;
 
     Header header;
     auto rc = spi_flash_read(mBaseAddress, &header, sizeof(header));
@@ -257,6 +254,44 @@ esp_err_t Page::writeItem(uint8_t nsIndex, ItemType datatype, const char* key, c
     return ESP_OK;
 }
 
+esp_err_t Page::writeItems(const Item* entries, size_t entryCount)
+{
+    esp_err_t err;
+
+    if (mState == PageState::INVALID) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+
+    if (mState == PageState::UNINITIALIZED) {
+        err = initialize();
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    if (mState == PageState::FULL) {
+        return ESP_ERR_NVS_PAGE_FULL;
+    }
+
+    assert(entryCount > 0 && entryCount <= BATCH_MAX_ENTRIES);
+    if (mNextFreeEntry == INVALID_ENTRY || mNextFreeEntry + entryCount > ENTRY_COUNT) {
+        return ESP_ERR_NVS_PAGE_FULL;
+    }
+
+    for (size_t i = 0; i < entryCount; i += entries[i].span) {
+        assert(entries[i].span > 0 && i + entries[i].span <= entryCount);
+        mHashList.insert(entries[i], mNextFreeEntry + i);
+    }
+
+    if (mFirstUsedEntry == INVALID_ENTRY) {
+        mFirstUsedEntry = mNextFreeEntry;
+    }
+
+    // Entries are written to flash at once and then marked as written with a single range update.
+    // If power goes off before that, entries are detected as half-written in mLoadEntryTable and erased.
+    return writeEntryData(reinterpret_cast<const uint8_t*>(entries), entryCount * ENTRY_SIZE);
+}
+
 esp_err_t Page::readItem(uint8_t nsIndex, ItemType datatype, const char* key, void* data, size_t dataSize, uint8_t chunkIdx, VerOffset chunkStart)
 {
     size_t index = 0;
@@ -284,19 +319,9 @@ esp_err_t Page::readItem(uint8_t nsIndex, ItemType datatype, const char* key, vo
         return ESP_ERR_NVS_INVALID_LENGTH;
     }
 
-    uint8_t* dst = reinterpret_cast<uint8_t*>(data);
-    size_t left = item.varLength.dataSize;
-    for (size_t i = index + 1; i < index + item.span; ++i) {
-        Item ditem;
-        rc = readEntry(i, ditem);
-        if (rc != ESP_OK) {
-            return rc;
-        }
-        size_t willCopy = ENTRY_SIZE;
-        willCopy = (left < willCopy)?left:willCopy;
-        memcpy(dst, ditem.rawData, willCopy);
-        left -= willCopy;
-        dst += willCopy;
+    rc = readEntryData(index + 1, 0, data, item.varLength.dataSize);
+    if (rc != ESP_OK) {
+        return rc;
     }
     if (Item::calculateCrc32(reinterpret_cast<uint8_t*>(data), item.varLength.dataSize) != item.varLength.dataCrc32) {
         rc = eraseEntryAndSpan(index);
@@ -308,6 +333,30 @@ esp_err_t Page::readItem(uint8_t nsIndex, ItemType datatype, const char* key, vo
     return ESP_OK;
 }
 
+esp_err_t Page::readItemPart(uint8_t nsIndex, ItemType datatype, const char* key, size_t offset, void* data, size_t dataSize, Item& item, uint8_t chunkIdx)
+{
+    size_t index = 0;
+
+    if (mState == PageState::INVALID) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+
+    if (!isVariableLengthType(datatype)) {
+        return ESP_ERR_NVS_TYPE_MISMATCH;
+    }
+
+    esp_err_t rc = findItem(nsIndex, datatype, key, index, item, chunkIdx);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+
+    if (offset + dataSize > static_cast<size_t>(item.varLength.dataSize)) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+
+    return readEntryData(index + 1, offset, data, dataSize);
+}
+
 esp_err_t Page::eraseItem(uint8_t nsIndex, ItemType datatype, const char* key, uint8_t chunkIdx, VerOffset chunkStart)
 {
     size_t index = 0;
@@ -339,7 +388,9 @@ esp_err_t Page::eraseEntryAndSpan(size_t index)
             return rc;
         }
         if (item.calculateCrc32() != item.crc32) {
-            mHashList.erase(index, false);
+            if (mHashListLoaded) {
+                mHashList.erase(index, false);
+            }
             rc = alterEntryState(index, EntryState::ERASED);
             --mUsedEntryCount;
             ++mErasedEntryCount;
@@ -347,7 +398,9 @@ esp_err_t Page::eraseEntryAndSpan(size_t index)
                 return rc;
             }
         } else {
-            mHashList.erase(index);
+            if (mHashListLoaded) {
+                mHashList.erase(index);
+            }
             span = item.span;
             for (ptrdiff_t i = index + span - 1; i >= static_cast<ptrdiff_t>(index); --i) {
                 if (mEntryTable.get(i) == EntryState::WRITTEN) {
@@ -382,6 +435,67 @@ esp_err_t Page::eraseEntryAndSpan(size_t index)
     return ESP_OK;
 }
 
+esp_err_t Page::eraseEntries(const size_t* indices, size_t count)
+{
+    size_t firstWord = SIZE_MAX;
+    size_t lastWord = 0;
+
+    for (size_t n = 0; n < count; ++n) {
+        const size_t index = indices[n];
+        assert(mEntryTable.get(index) == EntryState::WRITTEN);
+
+        Item item;
+        auto rc = readEntry(index, item);
+        if (rc != ESP_OK) {
+            return rc;
+        }
+
+        size_t span = 1;
+        if (item.calculateCrc32() != item.crc32) {
+            if (mHashListLoaded) {
+                mHashList.erase(index, false);
+            }
+            --mUsedEntryCount;
+            ++mErasedEntryCount;
+        } else {
+            if (mHashListLoaded) {
+                mHashList.erase(index);
+            }
+            span = item.span;
+            for (size_t i = index; i < index + span; ++i) {
+                if (mEntryTable.get(i) == EntryState::WRITTEN) {
+                    --mUsedEntryCount;
+                }
+                ++mErasedEntryCount;
+            }
+        }
+
+        for (size_t i = index; i < index + span; ++i) {
+            mEntryTable.set(i, EntryState::ERASED);
+        }
+        firstWord = std::min(firstWord, mEntryTable.getWordIndex(index));
+        lastWord = std::max(lastWord, mEntryTable.getWordIndex(index + span - 1));
+    }
+
+    if (firstWord == SIZE_MAX) {
+        return ESP_OK;
+    }
+
+    // Words between the modified ones are written with their current value, which is harmless
+    auto rc = spi_flash_write(mBaseAddress + ENTRY_TABLE_OFFSET + static_cast<uint32_t>(firstWord) * 4,
+            mEntryTable.data() + firstWord, (lastWord - firstWord + 1) * 4);
+    if (rc != ESP_OK) {
+        mState = PageState::INVALID;
+        return rc;
+    }
+
+    if (mFirstUsedEntry != INVALID_ENTRY && mEntryTable.get(mFirstUsedEntry) != EntryState::WRITTEN) {
+        updateFirstUsedEntry(mFirstUsedEntry, 1);
+    }
+
+    return ESP_OK;
+}
+
 void Page::updateFirstUsedEntry(size_t index, size_t span)
 {
     assert(index == mFirstUsedEntry);
@@ -411,6 +525,12 @@ esp_err_t Page::copyItems(Page& other)
         }
     }
 
+    // make sure entries with bad CRC are erased and not copied
+    auto rc = ensureHashListLoaded();
+    if (rc != ESP_OK) {
+        return rc;
+    }
+
     Item entry;
     size_t readEntryIndex = mFirstUsedEntry;
 
@@ -436,12 +556,20 @@ esp_err_t Page::copyItems(Page& other)
 
         assert(end <= ENTRY_COUNT);
 
-        for (size_t i = readEntryIndex + 1; i < end; ++i) {
-            readEntry(i, entry);
-            err = other.writeEntry(entry);
+        // copy the data entries several at a time
+        Item block[COPY_BLOCK_ENTRIES];
+        for (size_t i = readEntryIndex + 1; i < end; ) {
+            size_t count = end - i;
+            count = (count < COPY_BLOCK_ENTRIES) ? count : COPY_BLOCK_ENTRIES;
+            err = readEntries(i, block, count);
             if (err != ESP_OK) {
                 return err;
             }
+            err = other.writeEntryData(reinterpret_cast<const uint8_t*>(block), count * ENTRY_SIZE);
+            if (err != ESP_OK) {
+                return err;
+            }
+            i += count;
         }
         readEntryIndex = end;
 
@@ -596,50 +724,79 @@ esp_err_t Page::mLoadEntryTable()
     } else if (mState == PageState::FULL || mState == PageState::FREEING) {
         // We have already filled mHashList for page in active state.
         // Do the same for the case when page is in full or freeing state.
-        Item item;
-        for (size_t i = mFirstUsedEntry; i < ENTRY_COUNT; ++i) {
-            if (mEntryTable.get(i) != EntryState::WRITTEN) {
-                continue;
-            }
+#ifdef CONFIG_NVS_LAZY_LOAD
+        // Full pages are only read when an item is looked up by key
+        if (mState == PageState::FULL) {
+            mHashListLoaded = false;
+            return ESP_OK;
+        }
+#endif
+        return loadHashList();
+    }
 
-            auto err = readEntry(i, item);
+    return ESP_OK;
+}
+
+esp_err_t Page::loadHashList()
+{
+    mHashListLoaded = true;
+    Item item;
+    for (size_t i = mFirstUsedEntry; i < ENTRY_COUNT; ++i) {
+        if (mEntryTable.get(i) != EntryState::WRITTEN) {
+            continue;
+        }
+
+        auto err = readEntry(i, item);
+        if (err != ESP_OK) {
+            mState = PageState::INVALID;
+            return err;
+        }
+
+        if (item.crc32 != item.calculateCrc32()) {
+            err = eraseEntryAndSpan(i);
             if (err != ESP_OK) {
                 mState = PageState::INVALID;
                 return err;
             }
+            continue;
+        }
 
-            if (item.crc32 != item.calculateCrc32()) {
-                err = eraseEntryAndSpan(i);
-                if (err != ESP_OK) {
-                    mState = PageState::INVALID;
-                    return err;
-                }
-                continue;
-            }
-
-            assert(item.span > 0);
+        assert(item.span > 0);
 
-            mHashList.insert(item, i);
+        mHashList.insert(item, i);
 
-            size_t span = item.span;
+        size_t span = item.span;
 
-            if (isVariableLengthType(item.datatype)) {
-                for (size_t j = i + 1; j < i + span; ++j) {
-                    if (mEntryTable.get(j) != EntryState::WRITTEN) {
-                        eraseEntryAndSpan(i);
-                        break;
-                    }
-                }
-            }
-
-            i += span - 1;
+        if (isVariableLengthType(item.datatype) && !isSpanWritten(i, span)) {
+            eraseEntryAndSpan(i);
         }
 
+        i += span - 1;
     }
 
     return ESP_OK;
 }
 
+bool Page::isSpanWritten(size_t index, size_t span) const
+{
+    if (index + span > ENTRY_COUNT) {
+        return false;
+    }
+    for (size_t j = index + 1; j < index + span; ++j) {
+        if (mEntryTable.get(j) != EntryState::WRITTEN) {
+            return false;
+        }
+    }
+    return true;
+}
+
+esp_err_t Page::ensureHashListLoaded()
+{
+    if (mHashListLoaded) {
+        return ESP_OK;
+    }
+    return loadHashList();
+}
 
 esp_err_t Page::initialize()
 {
@@ -724,6 +881,57 @@ esp_err_t Page::readEntry(size_t index, Item& dst) const
     return ESP_OK;
 }
 
+esp_err_t Page::readEntries(size_t index, Item* dst, size_t count) const
+{
+    assert(index + count <= ENTRY_COUNT);
+    return nvs_flash_read(getEntryAddress(index), dst, count * sizeof(Item));
+}
+
+esp_err_t Page::readEntryData(size_t index, size_t offset, void* data, size_t dataSize) const
+{
+    uint8_t* dst = reinterpret_cast<uint8_t*>(data);
+    size_t i = index + offset / ENTRY_SIZE;
+    size_t skip = offset % ENTRY_SIZE;
+    Item ditem;
+
+    // partial entry at the start
+    if (skip > 0 && dataSize > 0) {
+        auto rc = readEntry(i, ditem);
+        if (rc != ESP_OK) {
+            return rc;
+        }
+        size_t willCopy = ENTRY_SIZE - skip;
+        willCopy = (dataSize < willCopy)?dataSize:willCopy;
+        memcpy(dst, ditem.rawData + skip, willCopy);
+        dataSize -= willCopy;
+        dst += willCopy;
+        ++i;
+    }
+
+    // whole entries are read (and decrypted) straight into the caller's buffer with one read
+    size_t count = dataSize / ENTRY_SIZE;
+    if (count > 0) {
+        assert(i + count <= ENTRY_COUNT);
+        auto rc = nvs_flash_read(getEntryAddress(i), dst, count * ENTRY_SIZE);
+        if (rc != ESP_OK) {
+            return rc;
+        }
+        dataSize -= count * ENTRY_SIZE;
+        dst += count * ENTRY_SIZE;
+        i += count;
+    }
+
+    // partial entry at the end
+    if (dataSize > 0) {
+        auto rc = readEntry(i, ditem);
+        if (rc != ESP_OK) {
+            return rc;
+        }
+        memcpy(dst, ditem.rawData, dataSize);
+    }
+    return ESP_OK;
+}
+
 esp_err_t Page::findItem(uint8_t nsIndex, ItemType datatype, const char* key, size_t &itemIndex, Item& item, uint8_t chunkIdx, VerOffset chunkStart)
 {
     if (mState == PageState::CORRUPT || mState == PageState::INVALID || mState == PageState::UNINITIALIZED) {
@@ -746,6 +954,10 @@ esp_err_t Page::findItem(uint8_t nsIndex, ItemType datatype, const char* key, si
     }
 
     if (nsIndex != NS_ANY && datatype != ItemType::ANY && key != NULL) {
+        auto rc = ensureHashListLoaded();
+        if (rc != ESP_OK) {
+            return rc;
+        }
         size_t cachedIndex = mHashList.find(start, Item(nsIndex, datatype, 0, key, chunkIdx));
         if (cachedIndex < ENTRY_COUNT) {
             start = cachedIndex;
@@ -779,6 +991,15 @@ esp_err_t Page::findItem(uint8_t nsIndex, ItemType datatype, const char* key, si
 
         if (isVariableLengthType(item.datatype)) {
             next = i + item.span;
+            // page which wasn't looked into yet may have items erased only partially
+            if (!mHashListLoaded && !isSpanWritten(i, item.span)) {
+                rc = eraseEntryAndSpan(i);
+                if (rc != ESP_OK) {
+                    mState = PageState::INVALID;
+                    return rc;
+                }
+                continue;
+            }
         }
 
         if (nsIndex != NS_ANY && item.nsIndex != nsIndex) {
@@ -865,6 +1086,7 @@ esp_err_t Page::erase()
     mNextFreeEntry = INVALID_ENTRY;
     mState = PageState::UNINITIALIZED;
     mHashList.clear();
+    mHashListLoaded = true;
     return ESP_OK;
 }
 
@@ -876,6 +1098,20 @@ esp_err_t Page::markFreeing()
     return alterPageState(PageState::FREEING);
 }
 
+esp_err_t Page::markForErase()
+{
+    if (mState != PageState::FREEING) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+    auto err = alterPageState(PageState::CORRUPT);
+    if (err != ESP_OK) {
+        return err;
+    }
+    mHashList.clear();
+    mHashListLoaded = true;
+    return ESP_OK;
+}
+
 esp_err_t Page::markFull()
 {
     if (mState != PageState::ACTIVE) {
@@ -884,6 +1120,16 @@ esp_err_t Page::markFull()
     return alterPageState(PageState::FULL);
 }
 
+size_t Page::getFreeEntryCount() const
+{
+    if (mState == PageState::UNINITIALIZED) {
+        return ENTRY_COUNT;
+    } else if (mState != PageState::ACTIVE || mNextFreeEntry >= ENTRY_COUNT) {
+        return 0;
+    }
+    return ENTRY_COUNT - mNextFreeEntry;
+}
+
 size_t Page::getVarDataTailroom() const
 {
     if (mState == PageState::UNINITIALIZED) {
@@ -48,6 +48,11 @@ public:
 
     static const size_t CHUNK_MAX_SIZE = ENTRY_SIZE * (ENTRY_COUNT - 1);
 
+    // Maximum number of entries written at once by writeItems.
+    // If power goes off before the old versions of these items are erased,
+    // duplicates are found among this many last items of the active page.
+    static const size_t BATCH_MAX_ENTRIES = 16;
+
     static const uint8_t NS_INDEX = 0;
     static const uint8_t NS_ANY = 255;
 
@@ -94,10 +99,17 @@ public:
 
     esp_err_t readItem(uint8_t nsIndex, ItemType datatype, const char* key, void* data, size_t dataSize, uint8_t chunkIdx = CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
 
+    // Read part of the data of a variable length item. Data CRC is not checked, item is set to the item header.
+    esp_err_t readItemPart(uint8_t nsIndex, ItemType datatype, const char* key, size_t offset, void* data, size_t dataSize, Item& item, uint8_t chunkIdx = CHUNK_ANY);
+
     esp_err_t eraseItem(uint8_t nsIndex, ItemType datatype, const char* key, uint8_t chunkIdx = CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
 
     esp_err_t findItem(uint8_t nsIndex, ItemType datatype, const char* key, uint8_t chunkIdx = CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
 
+    esp_err_t writeItems(const Item* entries, size_t entryCount);
+
+    esp_err_t eraseEntries(const size_t* indices, size_t count);
+
     esp_err_t findItem(uint8_t nsIndex, ItemType datatype, const char* key, size_t &itemIndex, Item& item, uint8_t chunkIdx = CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
 
     template<typename T>
@@ -129,10 +141,19 @@ public:
     }
     size_t getVarDataTailroom() const ;
 
+    size_t getFreeEntryCount() const;
+
     esp_err_t markFull();
 
     esp_err_t markFreeing();
 
+    /**
+     * Mark a FREEING page, which items were copied elsewhere, as CORRUPT, and
+     * drop its cached entries. The page goes back to the free list and is
+     * erased later by PageManager::eraseFreePage, or when it is activated.
+     */
+    esp_err_t markForErase();
+
     esp_err_t copyItems(Page& other);
 
     esp_err_t erase();
@@ -169,6 +190,12 @@ protected:
 
     esp_err_t mLoadEntryTable();
 
+    esp_err_t loadHashList();
+
+    esp_err_t ensureHashListLoaded();
+
+    bool isSpanWritten(size_t index, size_t span) const;
+
     esp_err_t initialize();
 
     esp_err_t alterEntryState(size_t index, EntryState state);
@@ -179,6 +206,11 @@ protected:
 
     esp_err_t readEntry(size_t index, Item& dst) const;
 
+    esp_err_t readEntries(size_t index, Item* dst, size_t count) const;
+
+    // Read dataSize bytes stored in consecutive entries, starting offset bytes into entry 'index'
+    esp_err_t readEntryData(size_t index, size_t offset, void* data, size_t dataSize) const;
+
     esp_err_t writeEntry(const Item& item);
     
     esp_err_t writeEntryData(const uint8_t* data, size_t size);
@@ -214,11 +246,14 @@ protected:
     uint16_t mErasedEntryCount = 0;
 
     HashList mHashList;
+    bool mHashListLoaded = true;    // false for full pages not looked into yet, see CONFIG_NVS_LAZY_LOAD
 
     static const uint32_t HEADER_OFFSET = 0;
     static const uint32_t ENTRY_TABLE_OFFSET = HEADER_OFFSET + 32;
     static const uint32_t ENTRY_DATA_OFFSET = ENTRY_TABLE_OFFSET + 32;
 
+    static const size_t COPY_BLOCK_ENTRIES = 8;     // entries read at once while copying items to another page
+
     static_assert(sizeof(Header) == 32, "header size must be 32 bytes");
     static_assert(ENTRY_TABLE_OFFSET % 32 == 0, "entry table offset should be aligned");
     static_assert(ENTRY_DATA_OFFSET % 32 == 0, "entry data offset should be aligned");
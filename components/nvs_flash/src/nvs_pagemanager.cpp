@@ -19,6 +19,8 @@ esp_err_t PageManager::load(uint32_t baseSector, uint32_t sectorCount)
 {
     mBaseSector = baseSector;
     mPageCount = sectorCount;
+    mRecentItems.reset();
+    mRecentItemCount = 0;
     mPageList.clear();
     mFreePageList.clear();
     mPages.reset(new Page[sectorCount]);
@@ -54,17 +56,45 @@ esp_err_t PageManager::load(uint32_t baseSector, uint32_t sectorCount)
     }
 
     // if power went out after a new item for the given key was written,
-    // but before the old one was erased, we end up with a duplicate item
+    // but before the old one was erased, we end up with a duplicate item.
+    // Items are written at most Page::BATCH_MAX_ENTRIES at a time, so only
+    // that many last items of the last page need to be checked.
     Page& lastPage = back();
-    size_t lastItemIndex = SIZE_MAX;
+    size_t itemCount = 0;
     Item item;
     size_t itemIndex = 0;
     while (lastPage.findItem(Page::NS_ANY, ItemType::ANY, nullptr, itemIndex, item) == ESP_OK) {
         itemIndex += item.span;
-        lastItemIndex = itemIndex;
+        ++itemCount;
     }
 
-    if (lastItemIndex != SIZE_MAX) {
+#ifdef CONFIG_NVS_LAZY_LOAD
+    // Full pages will be scanned by Storage::init, which checks them for duplicates
+    // of these items. If memory can't be allocated, fall back to looking up each item.
+    if (itemCount > 0 && lastPage.getSeqNumber(mRecentItemsSeqNumber) == ESP_OK) {
+        size_t recentCount = (itemCount < Page::BATCH_MAX_ENTRIES) ? itemCount : Page::BATCH_MAX_ENTRIES;
+        mRecentItems.reset(new (std::nothrow) RecentItem[recentCount]);
+    }
+#endif
+
+    itemIndex = 0;
+    for (size_t i = 0; i < itemCount; ++i) {
+        if (lastPage.findItem(Page::NS_ANY, ItemType::ANY, nullptr, itemIndex, item) != ESP_OK) {
+            break;
+        }
+        itemIndex += item.span;
+        if (i + Page::BATCH_MAX_ENTRIES < itemCount) {
+            continue;
+        }
+
+        if (mRecentItems) {
+            RecentItem& recent = mRecentItems[mRecentItemCount++];
+            recent.item = item;
+            recent.found = false;
+            recent.oldBlobPage = nullptr;
+            continue;
+        }
+
         auto last = PageManager::TPageListIterator(&lastPage);
         TPageListIterator it;
 
@@ -131,6 +161,51 @@ esp_err_t PageManager::load(uint32_t baseSector, uint32_t sectorCount)
     return ESP_OK;
 }
 
+esp_err_t PageManager::eraseOlderDuplicate(Page& page, size_t itemIndex, const Item& item, bool& erased)
+{
+    erased = false;
+    uint32_t seqNumber;
+    if (!mRecentItems || page.getSeqNumber(seqNumber) != ESP_OK || seqNumber >= mRecentItemsSeqNumber) {
+        return ESP_OK;
+    }
+
+    for (size_t i = 0; i < mRecentItemCount; ++i) {
+        RecentItem& recent = mRecentItems[i];
+        if (recent.item.nsIndex != item.nsIndex || recent.item.chunkIndex != item.chunkIndex ||
+                strncmp(recent.item.key, item.key, Item::MAX_KEY_LENGTH) != 0) {
+            continue;
+        }
+        if (recent.item.datatype == item.datatype && !recent.found) {
+            recent.found = true;
+            erased = true;
+            return page.eraseEntries(&itemIndex, 1);
+        }
+        if (recent.item.datatype == ItemType::BLOB_IDX && item.datatype == ItemType::BLOB && !recent.oldBlobPage) {
+            recent.oldBlobPage = &page;
+            recent.oldBlobIndex = itemIndex;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t PageManager::finishDuplicateCheck()
+{
+    for (size_t i = 0; i < mRecentItemCount; ++i) {
+        RecentItem& recent = mRecentItems[i];
+        /* Blob was stored using old format, and power went off just after writing
+         * blob index during modification. Delete the old version blob */
+        if (!recent.found && recent.oldBlobPage) {
+            auto err = recent.oldBlobPage->eraseEntries(&recent.oldBlobIndex, 1);
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+    }
+    mRecentItems.reset();
+    mRecentItemCount = 0;
+    return ESP_OK;
+}
+
 esp_err_t PageManager::requestNewPage()
 {
     if (mFreePageList.empty()) {
@@ -176,10 +251,22 @@ esp_err_t PageManager::requestNewPage()
     }
     err = erasedPage->copyItems(*newPage);
     if (err != ESP_OK && err != ESP_ERR_NVS_NOT_FOUND) {
+        if (mKeyIndex) {
+            mKeyIndex->invalidate();
+        }
         return err;
     }
 
+    if (mKeyIndex) {
+        mKeyIndex->movePage(getPageIndex(*erasedPage), getPageIndex(*newPage));
+    }
+
+#ifdef CONFIG_NVS_BACKGROUND_GC
+    // leave the slow sector erase to eraseFreePage
+    err = erasedPage->markForErase();
+#else
     err = erasedPage->erase();
+#endif
     if (err != ESP_OK) {
         return err;
     }
@@ -194,6 +281,26 @@ esp_err_t PageManager::requestNewPage()
     return ESP_OK;
 }
 
+esp_err_t PageManager::eraseFreePage(bool& more)
+{
+    more = false;
+    Page* pending = nullptr;
+    for (auto it = mFreePageList.begin(); it != mFreePageList.end(); ++it) {
+        if (it->state() != Page::PageState::CORRUPT) {
+            continue;
+        }
+        if (pending) {
+            more = true;
+            break;
+        }
+        pending = it;
+    }
+    if (!pending) {
+        return ESP_OK;
+    }
+    return pending->erase();
+}
+
 esp_err_t PageManager::activatePage()
 {
     if (mFreePageList.empty()) {
@@ -20,6 +20,7 @@
 #include "nvs_page.hpp"
 #include "nvs_pagemanager.hpp"
 #include "intrusive_list.h"
+#include "nvs_key_index.hpp"
 
 namespace nvs
 {
@@ -54,6 +55,13 @@ public:
 
     esp_err_t requestNewPage();
 
+    /**
+     * Erase one of the free pages which are waiting to be erased (pages left
+     * CORRUPT by requestNewPage with CONFIG_NVS_BACKGROUND_GC, or found CORRUPT
+     * by load). 'more' is set if other pages are still waiting.
+     */
+    esp_err_t eraseFreePage(bool& more);
+
     esp_err_t fillStats(nvs_stats_t& nvsStats);
 
     uint32_t getBaseSector()
@@ -61,6 +69,33 @@ public:
         return mBaseSector;
     }
 
+    size_t getPageIndex(const Page& page) const
+    {
+        return &page - mPages.get();
+    }
+
+    Page& getPage(size_t index)
+    {
+        assert(index < mPageCount);
+        return mPages[index];
+    }
+
+    void setKeyIndex(KeyIndex* keyIndex)
+    {
+        mKeyIndex = keyIndex;
+    }
+
+    /**
+     * With CONFIG_NVS_LAZY_LOAD, load doesn't read full pages to check for the items
+     * left duplicated by a power-off. Instead, Storage::init passes each item it finds
+     * to this function, which erases the item if it is an older version of one of the
+     * items written last to the active page. finishDuplicateCheck has to be called
+     * once all items were checked.
+     */
+    esp_err_t eraseOlderDuplicate(Page& page, size_t itemIndex, const Item& item, bool& erased);
+
+    esp_err_t finishDuplicateCheck();
+
 protected:
     friend class Iterator;
 
@@ -72,6 +107,18 @@ protected:
     uint32_t mBaseSector;
     uint32_t mPageCount;
     uint32_t mSeqNumber;
+    KeyIndex* mKeyIndex = nullptr;
+
+    struct RecentItem {
+        Item item;
+        bool found;
+        Page* oldBlobPage;      // old format blob with the same key, for BLOB_IDX items
+        size_t oldBlobIndex;
+    };
+
+    std::unique_ptr<RecentItem[]> mRecentItems;
+    size_t mRecentItemCount = 0;
+    uint32_t mRecentItemsSeqNumber;
 }; // class PageManager
 
 
@@ -31,80 +31,96 @@ void Storage::clearNamespaces()
     mNamespaces.clearAndFreeNodes();
 }
 
-void Storage::populateBlobIndices(TBlobIndexList& blobIdxList)
+void Storage::eraseOrphanDataBlobs(TBlobIndexList& blobIdxList, TBlobDataList& blobDataList)
 {
-    for (auto it = mPageManager.begin(); it != mPageManager.end(); ++it) {
-        Page& p = *it;
-        size_t itemIndex = 0;
-        Item item;
-
-        /* If the power went off just after writing a blob index, the duplicate detection
-         * logic in pagemanager will remove the earlier index. So we should never find a
-         * duplicate index at this point */
-
-        while (p.findItem(Page::NS_ANY, ItemType::BLOB_IDX, nullptr, itemIndex, item) == ESP_OK) {
-            BlobIndexNode* entry = new BlobIndexNode;
-
-            item.getKey(entry->key, sizeof(entry->key) - 1);
-            entry->nsIndex = item.nsIndex;
-            entry->chunkStart = item.blobIndex.chunkStart;
-            entry->chunkCount = item.blobIndex.chunkCount;
-
-            blobIdxList.push_back(entry);
-            itemIndex += item.span;
+    /* Chunks with same <ns,key> and with chunkIndex in the following ranges
+     * belong to same family.
+     * 1) VER_0_OFFSET <= chunkIndex < VER_1_OFFSET-1 => Version0 chunks
+     * 2) VER_1_OFFSET <= chunkIndex < VER_ANY => Version1 chunks
+     */
+    for (auto it = blobDataList.begin(); it != blobDataList.end(); ++it) {
+        BlobDataNode& data = *it;
+        auto iter = std::find_if(blobIdxList.begin(),
+                blobIdxList.end(),
+                [=] (const BlobIndexNode& e) -> bool
+                {return (strncmp(data.key, e.key, sizeof(e.key) - 1) == 0)
+                        && (data.nsIndex == e.nsIndex)
+                        && (data.chunkIndex >=  static_cast<uint8_t> (e.chunkStart))
+                        && (data.chunkIndex < static_cast<uint8_t> (e.chunkStart) + e.chunkCount);});
+        if (iter == std::end(blobIdxList)) {
+            auto err = data.page->eraseItem(data.nsIndex, ItemType::BLOB_DATA, data.key, data.chunkIndex);
+            updateKeyIndexOnErase(err, *data.page, data.nsIndex, data.key, data.chunkIndex);
         }
     }
 }
 
-void Storage::eraseOrphanDataBlobs(TBlobIndexList& blobIdxList)
+esp_err_t Storage::init(uint32_t baseSector, uint32_t sectorCount)
 {
-    for (auto it = mPageManager.begin(); it != mPageManager.end(); ++it) {
-        Page& p = *it;
-        size_t itemIndex = 0;
-        Item item;
-        /* Chunks with same <ns,key> and with chunkIndex in the following ranges
-         * belong to same family.
-         * 1) VER_0_OFFSET <= chunkIndex < VER_1_OFFSET-1 => Version0 chunks
-         * 2) VER_1_OFFSET <= chunkIndex < VER_ANY => Version1 chunks
-         */
-        while (p.findItem(Page::NS_ANY, ItemType::BLOB_DATA, nullptr, itemIndex, item) == ESP_OK) {
-
-            auto iter = std::find_if(blobIdxList.begin(),
-                    blobIdxList.end(),
-                    [=] (const BlobIndexNode& e) -> bool
-                    {return (strncmp(item.key, e.key, sizeof(e.key) - 1) == 0)
-                            && (item.nsIndex == e.nsIndex)
-                            && (item.chunkIndex >=  static_cast<uint8_t> (e.chunkStart))
-                            && (item.chunkIndex < static_cast<uint8_t> (e.chunkStart) + e.chunkCount);});
-            if (iter == std::end(blobIdxList)) {
-                p.eraseItem(item.nsIndex, item.datatype, item.key, item.chunkIndex);
-            }
-            itemIndex += item.span;
-        }
+    invalidateValueCaches(Page::NS_ANY, nullptr);
+    mKeyIndex.invalidate();
+    mPageManager.setKeyIndex(nullptr);
+
+    // chunks of unfinished blob streams are erased as orphans below
+    for (auto it = mBlobStreams.begin(); it != mBlobStreams.end(); ++it) {
+        it->mFailed = true;
     }
-}
 
-esp_err_t Storage::init(uint32_t baseSector, uint32_t sectorCount)
-{
     auto err = mPageManager.load(baseSector, sectorCount);
     if (err != ESP_OK) {
         mState = StorageState::INVALID;
         return err;
     }
 
-    // load namespaces list
+    // Load namespaces, blob indices and the key index in a single pass over all items
     clearNamespaces();
     std::fill_n(mNamespaceUsage.data(), mNamespaceUsage.byteSize() / 4, 0);
+    TBlobIndexList blobIdxList;
+    TBlobDataList blobDataList;
+#ifdef CONFIG_NVS_KEY_INDEX
+    mKeyIndex.reset();
+#endif
     for (auto it = mPageManager.begin(); it != mPageManager.end(); ++it) {
         Page& p = *it;
         size_t itemIndex = 0;
         Item item;
-        while (p.findItem(Page::NS_INDEX, ItemType::U8, nullptr, itemIndex, item) == ESP_OK) {
-            NamespaceEntry* entry = new NamespaceEntry;
-            item.getKey(entry->mName, sizeof(entry->mName) - 1);
-            item.getValue(entry->mIndex);
-            mNamespaces.push_back(entry);
-            mNamespaceUsage.set(entry->mIndex, true);
+        while (p.findItem(Page::NS_ANY, ItemType::ANY, nullptr, itemIndex, item) == ESP_OK) {
+            bool erased;
+            err = mPageManager.eraseOlderDuplicate(p, itemIndex, item, erased);
+            if (err != ESP_OK) {
+                mState = StorageState::INVALID;
+                blobIdxList.clearAndFreeNodes();
+                blobDataList.clearAndFreeNodes();
+                return err;
+            }
+            if (!erased) {
+                if (item.nsIndex == Page::NS_INDEX && item.datatype == ItemType::U8) {
+                    NamespaceEntry* entry = new NamespaceEntry;
+                    item.getKey(entry->mName, sizeof(entry->mName) - 1);
+                    item.getValue(entry->mIndex);
+                    mNamespaces.push_back(entry);
+                    mNamespaceUsage.set(entry->mIndex, true);
+                } else if (item.datatype == ItemType::BLOB_IDX && item.chunkIndex == Page::CHUNK_ANY) {
+                    /* If the power went off just after writing a blob index, the duplicate detection
+                     * logic in pagemanager will remove the earlier index. So we should never find a
+                     * duplicate index at this point */
+                    BlobIndexNode* entry = new BlobIndexNode;
+                    item.getKey(entry->key, sizeof(entry->key) - 1);
+                    entry->nsIndex = item.nsIndex;
+                    entry->chunkStart = item.blobIndex.chunkStart;
+                    entry->chunkCount = item.blobIndex.chunkCount;
+                    blobIdxList.push_back(entry);
+                } else if (item.datatype == ItemType::BLOB_DATA) {
+                    BlobDataNode* entry = new BlobDataNode;
+                    item.getKey(entry->key, sizeof(entry->key) - 1);
+                    entry->nsIndex = item.nsIndex;
+                    entry->chunkIndex = item.chunkIndex;
+                    entry->page = &p;
+                    blobDataList.push_back(entry);
+                }
+#ifdef CONFIG_NVS_KEY_INDEX
+                mKeyIndex.insert(item, mPageManager.getPageIndex(p));
+#endif
+            }
             itemIndex += item.span;
         }
     }
@@ -112,15 +128,24 @@ esp_err_t Storage::init(uint32_t baseSector, uint32_t sectorCount)
     mNamespaceUsage.set(255, true);
     mState = StorageState::ACTIVE;
 
-    // Populate list of multi-page index entries.
-    TBlobIndexList blobIdxList;
-    populateBlobIndices(blobIdxList);
+    err = mPageManager.finishDuplicateCheck();
+    if (err != ESP_OK) {
+        mState = StorageState::INVALID;
+        blobIdxList.clearAndFreeNodes();
+        blobDataList.clearAndFreeNodes();
+        return err;
+    }
 
     // Remove the entries for which there is no parent multi-page index.
-    eraseOrphanDataBlobs(blobIdxList);
+    eraseOrphanDataBlobs(blobIdxList, blobDataList);
 
-    // Purge the blob index list
+    // Purge the blob lists
     blobIdxList.clearAndFreeNodes();
+    blobDataList.clearAndFreeNodes();
+
+#ifdef CONFIG_NVS_KEY_INDEX
+    mPageManager.setKeyIndex(&mKeyIndex);
+#endif
 
 #ifndef ESP_PLATFORM
     debugCheck();
@@ -133,8 +158,67 @@ bool Storage::isValid() const
     return mState == StorageState::ACTIVE;
 }
 
+void Storage::invalidateValueCaches(uint8_t nsIndex, const char* key)
+{
+    for (auto it = mValueCaches.begin(); it != mValueCaches.end(); ++it) {
+        if (nsIndex == Page::NS_ANY || it->getNsIndex() == nsIndex) {
+            it->invalidate(key);
+        }
+    }
+}
+
+void Storage::rebuildKeyIndex()
+{
+    mKeyIndex.reset();
+    for (auto it = mPageManager.begin(); it != mPageManager.end(); ++it) {
+        Page& p = *it;
+        size_t itemIndex = 0;
+        Item item;
+        while (p.findItem(Page::NS_ANY, ItemType::ANY, nullptr, itemIndex, item) == ESP_OK) {
+            mKeyIndex.insert(item, mPageManager.getPageIndex(p));
+            itemIndex += item.span;
+        }
+    }
+    mPageManager.setKeyIndex(&mKeyIndex);
+}
+
+void Storage::updateKeyIndexOnWrite(esp_err_t err, Page& page, uint8_t nsIndex, const char* key, uint8_t chunkIdx)
+{
+    if (err == ESP_OK) {
+        mKeyIndex.insert(Item(nsIndex, ItemType::ANY, 0, key, chunkIdx), mPageManager.getPageIndex(page));
+    } else if (err != ESP_ERR_NVS_PAGE_FULL && err != ESP_ERR_NVS_KEY_TOO_LONG && err != ESP_ERR_NVS_VALUE_TOO_LONG) {
+        // item may have been written partially, stop trusting the index
+        mKeyIndex.invalidate();
+    }
+}
+
+void Storage::updateKeyIndexOnErase(esp_err_t err, Page& page, uint8_t nsIndex, const char* key, uint8_t chunkIdx)
+{
+    if (err == ESP_OK) {
+        mKeyIndex.erase(Item(nsIndex, ItemType::ANY, 0, key, chunkIdx), mPageManager.getPageIndex(page));
+    } else if (err != ESP_ERR_NVS_NOT_FOUND) {
+        mKeyIndex.invalidate();
+    }
+}
+
 esp_err_t Storage::findItem(uint8_t nsIndex, ItemType datatype, const char* key, Page* &page, Item& item, uint8_t chunkIdx, VerOffset chunkStart)
 {
+    if (mKeyIndex.isValid() && datatype != ItemType::ANY && key != nullptr) {
+        // Only the pages listed in the index may contain the item
+        Item hashItem(nsIndex, datatype, 0, key, chunkIdx);
+        size_t pos = 0;
+        size_t pageIndex;
+        while ((pageIndex = mKeyIndex.find(pos, hashItem)) != SIZE_MAX) {
+            Page& candidate = mPageManager.getPage(pageIndex);
+            size_t itemIndex = 0;
+            if (candidate.findItem(nsIndex, datatype, key, itemIndex, item, chunkIdx, chunkStart) == ESP_OK) {
+                page = &candidate;
+                return ESP_OK;
+            }
+        }
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
     for (auto it = std::begin(mPageManager); it != std::end(mPageManager); ++it) {
         size_t itemIndex = 0;
         auto err = it->findItem(nsIndex, datatype, key, itemIndex, item, chunkIdx, chunkStart);
@@ -146,22 +230,26 @@ esp_err_t Storage::findItem(uint8_t nsIndex, ItemType datatype, const char* key,
     return ESP_ERR_NVS_NOT_FOUND;
 }
 
-esp_err_t Storage::writeMultiPageBlob(uint8_t nsIndex, const char* key, const void* data, size_t dataSize, VerOffset chunkStart)
+size_t Storage::getMaxBlobSize()
 {
-    uint8_t chunkCount = 0;
-    TUsedPageList usedPages;
-    size_t remainingSize = dataSize;
-    size_t offset=0;
-    esp_err_t err = ESP_OK;
-
     /* Check how much maximum data can be accommodated**/
     uint32_t max_pages = mPageManager.getPageCount() - 1;
 
     if(max_pages > (Page::CHUNK_ANY-1)/2) {
        max_pages = (Page::CHUNK_ANY-1)/2;
     }
+    return max_pages * Page::CHUNK_MAX_SIZE;
+}
+
+esp_err_t Storage::writeMultiPageBlob(uint8_t nsIndex, const char* key, const void* data, size_t dataSize, VerOffset chunkStart)
+{
+    uint8_t chunkCount = 0;
+    TUsedPageList usedPages;
+    size_t remainingSize = dataSize;
+    size_t offset=0;
+    esp_err_t err = ESP_OK;
 
-    if (dataSize > max_pages * Page::CHUNK_MAX_SIZE) {
+    if (dataSize > getMaxBlobSize()) {
         return ESP_ERR_NVS_VALUE_TOO_LONG;
     }
 
@@ -198,6 +286,7 @@ esp_err_t Storage::writeMultiPageBlob(uint8_t nsIndex, const char* key, const vo
 
         err = page.writeItem(nsIndex, ItemType::BLOB_DATA, key,
                 static_cast<const uint8_t*> (data) + offset, chunkSize, static_cast<uint8_t> (chunkStart) + chunkCount);
+        updateKeyIndexOnWrite(err, page, nsIndex, key, static_cast<uint8_t> (chunkStart) + chunkCount);
         chunkCount++;
         assert(err != ESP_ERR_NVS_PAGE_FULL);
         if (err != ESP_OK) {
@@ -229,6 +318,7 @@ esp_err_t Storage::writeMultiPageBlob(uint8_t nsIndex, const char* key, const vo
             item.blobIndex.chunkStart = chunkStart;
 
             err = getCurrentPage().writeItem(nsIndex, ItemType::BLOB_IDX, key, item.data, sizeof(item.data));
+            updateKeyIndexOnWrite(err, getCurrentPage(), nsIndex, key);
             assert(err != ESP_ERR_NVS_PAGE_FULL);
             break;
         }
@@ -238,7 +328,9 @@ esp_err_t Storage::writeMultiPageBlob(uint8_t nsIndex, const char* key, const vo
         /* Anything failed, then we should erase all the written chunks*/
         int ii=0;
         for (auto it = std::begin(usedPages); it != std::end(usedPages); it++) {
-            it->mPage->eraseItem(nsIndex, ItemType::BLOB_DATA, key, ii++);
+            auto rc = it->mPage->eraseItem(nsIndex, ItemType::BLOB_DATA, key, ii);
+            updateKeyIndexOnErase(rc, *it->mPage, nsIndex, key, ii);
+            ii++;
         }
     }
     usedPages.clearAndFreeNodes();
@@ -251,6 +343,12 @@ esp_err_t Storage::writeItem(uint8_t nsIndex, ItemType datatype, const char* key
         return ESP_ERR_NVS_NOT_INITIALIZED;
     }
 
+    if (datatype == ItemType::BLOB && isBlobStreamOpen(nsIndex, key)) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+
+    invalidateValueCaches(nsIndex, key);
+
     Page* findPage = nullptr;
     Item item;
 
@@ -270,6 +368,7 @@ esp_err_t Storage::writeItem(uint8_t nsIndex, ItemType datatype, const char* key
         prevStart = nextStart = VerOffset::VER_0_OFFSET;
         if (findPage) {
             if (findPage->state() == Page::PageState::UNINITIALIZED ||
+                    findPage->state() == Page::PageState::CORRUPT ||
                     findPage->state() == Page::PageState::INVALID) {
                 ESP_ERROR_CHECK(findItem(nsIndex, datatype, key, findPage, item));
             }
@@ -314,6 +413,7 @@ esp_err_t Storage::writeItem(uint8_t nsIndex, ItemType datatype, const char* key
 
         Page& page = getCurrentPage();
         err = page.writeItem(nsIndex, datatype, key, data, dataSize);
+        updateKeyIndexOnWrite(err, page, nsIndex, key);
         if (err == ESP_ERR_NVS_PAGE_FULL) {
             if (page.state() != Page::PageState::FULL) {
                 err = page.markFull();
@@ -327,6 +427,7 @@ esp_err_t Storage::writeItem(uint8_t nsIndex, ItemType datatype, const char* key
             }
 
             err = getCurrentPage().writeItem(nsIndex, datatype, key, data, dataSize);
+            updateKeyIndexOnWrite(err, getCurrentPage(), nsIndex, key);
             if (err == ESP_ERR_NVS_PAGE_FULL) {
                 return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
             }
@@ -340,10 +441,12 @@ esp_err_t Storage::writeItem(uint8_t nsIndex, ItemType datatype, const char* key
 
     if (findPage) {
         if (findPage->state() == Page::PageState::UNINITIALIZED ||
+                findPage->state() == Page::PageState::CORRUPT ||
                 findPage->state() == Page::PageState::INVALID) {
             ESP_ERROR_CHECK(findItem(nsIndex, datatype, key, findPage, item));
         }
         err = findPage->eraseItem(nsIndex, datatype, key);
+        updateKeyIndexOnErase(err, *findPage, nsIndex, key);
         if (err == ESP_ERR_FLASH_OP_FAIL) {
             return ESP_ERR_NVS_REMOVE_FAILED;
         }
@@ -480,6 +583,7 @@ esp_err_t Storage::eraseMultiPageBlob(uint8_t nsIndex, const char* key, VerOffse
     }
     /* Erase the index first and make children blobs orphan*/
     err = findPage->eraseItem(nsIndex, ItemType::BLOB_IDX, key, Page::CHUNK_ANY, chunkStart);
+    updateKeyIndexOnErase(err, *findPage, nsIndex, key);
     if (err != ESP_OK) {
         return err;
     }
@@ -502,21 +606,381 @@ esp_err_t Storage::eraseMultiPageBlob(uint8_t nsIndex, const char* key, VerOffse
             continue; // Keep erasing other chunks
         }
         err = findPage->eraseItem(nsIndex, ItemType::BLOB_DATA, key, static_cast<uint8_t> (chunkStart) + chunkNum);
+        updateKeyIndexOnErase(err, *findPage, nsIndex, key, static_cast<uint8_t> (chunkStart) + chunkNum);
+        if (err != ESP_OK) {
+            return err;
+        }
+
+    }
+
+    return ESP_OK;
+}
+
+bool Storage::isBlobStreamOpen(uint8_t nsIndex, const char* key)
+{
+    auto it = std::find_if(mBlobStreams.begin(), mBlobStreams.end(), [=] (const BlobStream& e) -> bool {
+        return e.mNsIndex == nsIndex && strncmp(e.mKey, key, sizeof(e.mKey) - 1) == 0;
+    });
+    return it != mBlobStreams.end();
+}
+
+esp_err_t Storage::openBlobStream(BlobStream& stream)
+{
+    if (mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    Item item;
+    Page* findPage = nullptr;
+    auto err = findItem(stream.mNsIndex, ItemType::BLOB_IDX, stream.mKey, findPage, item);
+    if (err != ESP_OK && err != ESP_ERR_NVS_NOT_FOUND) {
+        return err;
+    }
+
+    if (stream.mMode == BlobStream::Mode::WRITE) {
+        if (isBlobStreamOpen(stream.mNsIndex, stream.mKey)) {
+            return ESP_ERR_NVS_INVALID_STATE;
+        }
+        /* Toggle the version, the index of the previous version is erased when the stream is closed */
+        stream.mChunkStart = (err == ESP_OK && item.blobIndex.chunkStart == VerOffset::VER_0_OFFSET)
+                ? VerOffset::VER_1_OFFSET : VerOffset::VER_0_OFFSET;
+        mBlobStreams.push_back(&stream);
+        return ESP_OK;
+    }
+
+    if (err == ESP_OK) {
+        stream.mChunkType = ItemType::BLOB_DATA;
+        stream.mChunkStart = item.blobIndex.chunkStart;
+        stream.mChunkCount = item.blobIndex.chunkCount;
+        stream.mDataSize = item.blobIndex.dataSize;
+        return ESP_OK;
+    }
+
+    /* Blob stored with earlier version format without index */
+    err = findItem(stream.mNsIndex, ItemType::BLOB, stream.mKey, findPage, item);
+    if (err != ESP_OK) {
+        return err;
+    }
+    stream.mChunkType = ItemType::BLOB;
+    stream.mChunkCount = 1;
+    stream.mDataSize = item.varLength.dataSize;
+    return ESP_OK;
+}
+
+esp_err_t Storage::readBlobStream(BlobStream& stream, void* data, size_t& dataSize)
+{
+    if (mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+    if (stream.mFailed) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+
+    uint8_t* dst = static_cast<uint8_t*>(data);
+    size_t done = 0;
+    esp_err_t err = ESP_OK;
+    while (done < dataSize && stream.mOffset < stream.mDataSize && stream.mChunkNum < stream.mChunkCount) {
+        const bool multiPage = (stream.mChunkType == ItemType::BLOB_DATA);
+        const uint8_t chunkIdx = multiPage ? static_cast<uint8_t> (stream.mChunkStart) + stream.mChunkNum : Page::CHUNK_ANY;
+        Item item;
+        Page* findPage = nullptr;
+
+        if (multiPage && stream.mChunkNum > 0 && stream.mChunkOffset == 0) {
+            /* Make sure the blob wasn't replaced while it was being read */
+            err = findItem(stream.mNsIndex, ItemType::BLOB_IDX, stream.mKey, findPage, item, Page::CHUNK_ANY, stream.mChunkStart);
+            if (err != ESP_OK) {
+                break;
+            }
+            if (item.blobIndex.dataSize != stream.mDataSize || item.blobIndex.chunkCount != stream.mChunkCount) {
+                err = ESP_ERR_NVS_NOT_FOUND;
+                break;
+            }
+        }
+
+        err = findItem(stream.mNsIndex, stream.mChunkType, stream.mKey, findPage, item, chunkIdx);
+        if (err != ESP_OK) {
+            break;
+        }
+        size_t chunkSize = item.varLength.dataSize;
+        if (chunkSize < stream.mChunkOffset || chunkSize - stream.mChunkOffset > stream.mDataSize - stream.mOffset) {
+            err = ESP_ERR_NVS_NOT_FOUND;
+            break;
+        }
+
+        size_t willRead = chunkSize - stream.mChunkOffset;
+        willRead = (dataSize - done < willRead) ? dataSize - done : willRead;
+        err = findPage->readItemPart(stream.mNsIndex, stream.mChunkType, stream.mKey, stream.mChunkOffset, dst + done, willRead, item, chunkIdx);
+        if (err != ESP_OK) {
+            break;
+        }
+        stream.mChunkCrc = Item::calculateCrc32(dst + done, willRead, stream.mChunkCrc);
+        stream.mChunkOffset += willRead;
+        stream.mOffset += willRead;
+        done += willRead;
+
+        if (stream.mChunkOffset == chunkSize) {
+            if (stream.mChunkCrc != item.varLength.dataCrc32) {
+                err = findPage->eraseItem(stream.mNsIndex, stream.mChunkType, stream.mKey, chunkIdx);
+                updateKeyIndexOnErase(err, *findPage, stream.mNsIndex, stream.mKey, chunkIdx);
+                err = ESP_ERR_NVS_NOT_FOUND;
+                break;
+            }
+            ++stream.mChunkNum;
+            stream.mChunkOffset = 0;
+            stream.mChunkCrc = 0xffffffff;
+        }
+    }
+
+    if (err != ESP_OK) {
+        stream.mFailed = true;
+        return err;
+    }
+    dataSize = done;
+    return ESP_OK;
+}
+
+esp_err_t Storage::getBlobChunkRoom(size_t dataSize, size_t& room)
+{
+    Page& page = getCurrentPage();
+    size_t tailroom = page.getVarDataTailroom();
+    /* Don't start small chunks at the end of a page, unless all the data fits there */
+    if (tailroom >= dataSize || tailroom >= Page::CHUNK_MAX_SIZE / 10) {
+        room = tailroom;
+        return ESP_OK;
+    }
+    if (page.state() != Page::PageState::FULL) {
+        auto err = page.markFull();
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    auto err = mPageManager.requestNewPage();
+    if (err != ESP_OK) {
+        return err;
+    }
+    room = getCurrentPage().getVarDataTailroom();
+    if (room <= tailroom) {
+        /* We got the same page or we are not improving.*/
+        return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+    }
+    return ESP_OK;
+}
+
+esp_err_t Storage::writeBlobChunk(BlobStream& stream, const void* data, size_t dataSize)
+{
+    if (stream.mChunkCount >= (Page::CHUNK_ANY - 1) / 2) {
+        return ESP_ERR_NVS_VALUE_TOO_LONG;
+    }
+    const uint8_t chunkIdx = static_cast<uint8_t> (stream.mChunkStart) + stream.mChunkCount;
+    Page& page = getCurrentPage();
+    auto err = page.writeItem(stream.mNsIndex, ItemType::BLOB_DATA, stream.mKey, data, dataSize, chunkIdx);
+    updateKeyIndexOnWrite(err, page, stream.mNsIndex, stream.mKey, chunkIdx);
+    if (err != ESP_OK) {
+        return err;
+    }
+    ++stream.mChunkCount;
+    return ESP_OK;
+}
+
+esp_err_t Storage::writeBlobStream(BlobStream& stream, const void* data, size_t dataSize)
+{
+    if (mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+    if (stream.mFailed) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+    if (stream.mDataSize + dataSize > getMaxBlobSize()) {
+        return ESP_ERR_NVS_VALUE_TOO_LONG;
+    }
+
+    const uint8_t* src = static_cast<const uint8_t*>(data);
+    size_t left = dataSize;
+    esp_err_t err = ESP_OK;
+    while (left > 0) {
+        size_t room;
+        err = getBlobChunkRoom(stream.mBufferSize + left, room);
+        if (err != ESP_OK) {
+            break;
+        }
+        if (stream.mBufferSize == 0 && left >= room) {
+            /* Whole chunk is available in the caller's buffer */
+            err = writeBlobChunk(stream, src, room);
+            if (err != ESP_OK) {
+                break;
+            }
+            src += room;
+            left -= room;
+            continue;
+        }
+
+        err = stream.reserveBuffer(room);
+        if (err != ESP_OK) {
+            break;
+        }
+        /* Chunk is written once the buffered data fills the page */
+        if (stream.mBufferSize < room) {
+            size_t willCopy = room - stream.mBufferSize;
+            willCopy = (left < willCopy) ? left : willCopy;
+            memcpy(stream.mBuffer + stream.mBufferSize, src, willCopy);
+            stream.mBufferSize += willCopy;
+            src += willCopy;
+            left -= willCopy;
+        }
+        if (stream.mBufferSize >= room) {
+            err = writeBlobChunk(stream, stream.mBuffer, room);
+            if (err != ESP_OK) {
+                break;
+            }
+            stream.consumeBuffer(room);
+        }
+    }
+
+    if (err != ESP_OK) {
+        stream.mFailed = true;
+        return err;
+    }
+    stream.mDataSize += dataSize;
+    return ESP_OK;
+}
+
+esp_err_t Storage::eraseBlobChunks(BlobStream& stream)
+{
+    for (uint8_t chunkNum = 0; chunkNum < stream.mChunkCount; chunkNum++) {
+        const uint8_t chunkIdx = static_cast<uint8_t> (stream.mChunkStart) + chunkNum;
+        Item item;
+        Page* findPage = nullptr;
+        auto err = findItem(stream.mNsIndex, ItemType::BLOB_DATA, stream.mKey, findPage, item, chunkIdx);
+        if (err == ESP_ERR_NVS_NOT_FOUND) {
+            continue;
+        } else if (err != ESP_OK) {
+            return err;
+        }
+        err = findPage->eraseItem(stream.mNsIndex, ItemType::BLOB_DATA, stream.mKey, chunkIdx);
+        updateKeyIndexOnErase(err, *findPage, stream.mNsIndex, stream.mKey, chunkIdx);
         if (err != ESP_OK) {
             return err;
         }
+    }
+    stream.mChunkCount = 0;
+    return ESP_OK;
+}
+
+esp_err_t Storage::closeBlobStream(BlobStream& stream)
+{
+    if (stream.mMode == BlobStream::Mode::READ) {
+        return ESP_OK;
+    }
+    if (mState != StorageState::ACTIVE) {
+        mBlobStreams.erase(&stream);
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+    if (stream.mFailed) {
+        abortBlobStream(stream);
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
 
+    esp_err_t err = ESP_OK;
+    while (stream.mBufferSize > 0) {
+        size_t room;
+        err = getBlobChunkRoom(stream.mBufferSize, room);
+        if (err != ESP_OK) {
+            break;
+        }
+        size_t chunkSize = (stream.mBufferSize < room) ? stream.mBufferSize : room;
+        err = writeBlobChunk(stream, stream.mBuffer, chunkSize);
+        if (err != ESP_OK) {
+            break;
+        }
+        stream.consumeBuffer(chunkSize);
     }
 
+    if (err == ESP_OK) {
+        /* All chunks are stored. Now store the index.*/
+        Item item;
+        std::fill_n(item.data, sizeof(item.data), 0xff);
+        item.blobIndex.dataSize = stream.mDataSize;
+        item.blobIndex.chunkCount = stream.mChunkCount;
+        item.blobIndex.chunkStart = stream.mChunkStart;
+
+        err = getCurrentPage().writeItem(stream.mNsIndex, ItemType::BLOB_IDX, stream.mKey, item.data, sizeof(item.data));
+        updateKeyIndexOnWrite(err, getCurrentPage(), stream.mNsIndex, stream.mKey);
+        if (err == ESP_ERR_NVS_PAGE_FULL) {
+            Page& page = getCurrentPage();
+            if (page.state() != Page::PageState::FULL) {
+                err = page.markFull();
+            } else {
+                err = ESP_OK;
+            }
+            if (err == ESP_OK) {
+                err = mPageManager.requestNewPage();
+            }
+            if (err == ESP_OK) {
+                err = getCurrentPage().writeItem(stream.mNsIndex, ItemType::BLOB_IDX, stream.mKey, item.data, sizeof(item.data));
+                updateKeyIndexOnWrite(err, getCurrentPage(), stream.mNsIndex, stream.mKey);
+                if (err == ESP_ERR_NVS_PAGE_FULL) {
+                    err = ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+                }
+            }
+        }
+    }
+
+    if (err != ESP_OK) {
+        abortBlobStream(stream);
+        return err;
+    }
+    mBlobStreams.erase(&stream);
+    invalidateValueCaches(stream.mNsIndex, stream.mKey);
+
+    /* Erase the blob with earlier version, or the blob stored without index */
+    const VerOffset prevStart = (stream.mChunkStart == VerOffset::VER_0_OFFSET)
+            ? VerOffset::VER_1_OFFSET : VerOffset::VER_0_OFFSET;
+    err = eraseMultiPageBlob(stream.mNsIndex, stream.mKey, prevStart);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        Item item;
+        Page* findPage = nullptr;
+        err = findItem(stream.mNsIndex, ItemType::BLOB, stream.mKey, findPage, item);
+        if (err == ESP_OK) {
+            err = findPage->eraseItem(stream.mNsIndex, ItemType::BLOB, stream.mKey);
+            updateKeyIndexOnErase(err, *findPage, stream.mNsIndex, stream.mKey);
+        }
+        if (err == ESP_ERR_NVS_NOT_FOUND) {
+            err = ESP_OK;
+        }
+    }
+    if (err == ESP_ERR_FLASH_OP_FAIL) {
+        return ESP_ERR_NVS_REMOVE_FAILED;
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+#ifndef ESP_PLATFORM
+    debugCheck();
+#endif
     return ESP_OK;
 }
 
+void Storage::abortBlobStream(BlobStream& stream)
+{
+    if (stream.mMode == BlobStream::Mode::READ) {
+        return;
+    }
+    mBlobStreams.erase(&stream);
+    if (mState == StorageState::ACTIVE) {
+        // chunks which can't be erased now are removed as orphans on the next init
+        eraseBlobChunks(stream);
+    }
+    stream.mFailed = true;
+}
+
 esp_err_t Storage::eraseItem(uint8_t nsIndex, ItemType datatype, const char* key)
 {
     if (mState != StorageState::ACTIVE) {
         return ESP_ERR_NVS_NOT_INITIALIZED;
     }
 
+    invalidateValueCaches(nsIndex, key);
+
     if (datatype == ItemType::BLOB) {
         return eraseMultiPageBlob(nsIndex, key);
     }
@@ -528,7 +992,9 @@ esp_err_t Storage::eraseItem(uint8_t nsIndex, ItemType datatype, const char* key
         return err;
     }
 
-    return findPage->eraseItem(nsIndex, datatype, key);
+    err = findPage->eraseItem(nsIndex, datatype, key);
+    updateKeyIndexOnErase(err, *findPage, nsIndex, key, item.chunkIndex);
+    return err;
 }
 
 esp_err_t Storage::eraseNamespace(uint8_t nsIndex)
@@ -537,6 +1003,15 @@ esp_err_t Storage::eraseNamespace(uint8_t nsIndex)
         return ESP_ERR_NVS_NOT_INITIALIZED;
     }
 
+    invalidateValueCaches(nsIndex, nullptr);
+
+    // chunks written so far by blob streams are erased too
+    for (auto it = mBlobStreams.begin(); it != mBlobStreams.end(); ++it) {
+        if (it->mNsIndex == nsIndex) {
+            it->mFailed = true;
+        }
+    }
+
     for (auto it = std::begin(mPageManager); it != std::end(mPageManager); ++it) {
         while (true) {
             auto err = it->eraseItem(nsIndex, ItemType::ANY, nullptr);
@@ -544,14 +1019,194 @@ esp_err_t Storage::eraseNamespace(uint8_t nsIndex)
                 break;
             }
             else if (err != ESP_OK) {
+                mKeyIndex.invalidate();
                 return err;
             }
         }
     }
+    if (mKeyIndex.isValid()) {
+        rebuildKeyIndex();
+    }
     return ESP_OK;
 
 }
 
+esp_err_t Storage::writeTransaction(uint8_t nsIndex, Transaction& transaction)
+{
+    if (mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    Transaction::Entry* batch[Page::BATCH_MAX_ENTRIES];
+    size_t batchCount = 0;
+    size_t batchEntryTotal = 0;
+    esp_err_t err;
+
+    for (auto it = transaction.entries().begin(); it != transaction.entries().end(); ++it) {
+        const size_t entryCount = batchEntryCount(*it);
+        if (batchCount > 0 && (entryCount == 0 ||
+                batchEntryTotal + entryCount > Page::BATCH_MAX_ENTRIES ||
+                batchEntryTotal + entryCount > getCurrentPage().getFreeEntryCount())) {
+            err = writeItemBatch(nsIndex, batch, batchCount, batchEntryTotal);
+            if (err != ESP_OK) {
+                return err;
+            }
+            batchCount = 0;
+            batchEntryTotal = 0;
+        }
+
+        if (entryCount > 0) {
+            batch[batchCount++] = it;
+            batchEntryTotal += entryCount;
+            continue;
+        }
+
+        // Blobs, values which don't fit into a batch, and erases are applied one by one
+        if (it->op == Transaction::Op::WRITE) {
+            err = writeItem(nsIndex, it->datatype, it->key, it->data, it->dataSize);
+        } else {
+            err = eraseItem(nsIndex, ItemType::ANY, it->key);
+            if (err == ESP_ERR_NVS_NOT_FOUND) {
+                err = ESP_OK;
+            }
+        }
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    if (batchCount > 0) {
+        err = writeItemBatch(nsIndex, batch, batchCount, batchEntryTotal);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+#ifndef ESP_PLATFORM
+    debugCheck();
+#endif
+    return ESP_OK;
+}
+
+size_t Storage::batchEntryCount(const Transaction::Entry& entry)
+{
+    if (entry.op != Transaction::Op::WRITE || entry.datatype == ItemType::BLOB) {
+        return 0;
+    }
+    size_t count = 1;
+    if (isVariableLengthType(entry.datatype)) {
+        count += (entry.dataSize + Page::ENTRY_SIZE - 1) / Page::ENTRY_SIZE;
+    }
+    return (count <= Page::BATCH_MAX_ENTRIES) ? count : 0;
+}
+
+esp_err_t Storage::writeItemBatch(uint8_t nsIndex, Transaction::Entry* const* entries, size_t count, size_t entryCount)
+{
+    esp_err_t err;
+
+    if (getCurrentPage().state() == Page::PageState::INVALID) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+    if (getCurrentPage().getFreeEntryCount() < entryCount) {
+        Page& page = getCurrentPage();
+        if (page.state() != Page::PageState::FULL) {
+            err = page.markFull();
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+        err = mPageManager.requestNewPage();
+        if (err != ESP_OK) {
+            return err;
+        }
+        if (getCurrentPage().getFreeEntryCount() < entryCount) {
+            return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        invalidateValueCaches(nsIndex, entries[i]->key);
+    }
+
+    // Locate the versions which are going to be replaced
+    Page* oldPages[Page::BATCH_MAX_ENTRIES];
+    size_t oldIndices[Page::BATCH_MAX_ENTRIES];
+    for (size_t i = 0; i < count; ++i) {
+        Item item;
+        oldPages[i] = nullptr;
+        err = findItem(nsIndex, entries[i]->datatype, entries[i]->key, oldPages[i], item);
+        if (err == ESP_OK) {
+            oldIndices[i] = 0;
+            err = oldPages[i]->findItem(nsIndex, entries[i]->datatype, entries[i]->key, oldIndices[i], item);
+        }
+        if (err == ESP_ERR_NVS_NOT_FOUND) {
+            oldPages[i] = nullptr;
+        } else if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    // Pack all items into consecutive entries, the same way Page::writeItem lays them out
+    Item items[Page::BATCH_MAX_ENTRIES];
+    size_t pos = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const Transaction::Entry& entry = *entries[i];
+        const size_t span = batchEntryCount(entry);
+        Item& item = items[pos];
+        item = Item(nsIndex, entry.datatype, span, entry.key);
+        if (!isVariableLengthType(entry.datatype)) {
+            memcpy(item.data, entry.data, entry.dataSize);
+        } else {
+            item.varLength.dataCrc32 = Item::calculateCrc32(entry.data, entry.dataSize);
+            item.varLength.dataSize = entry.dataSize;
+            item.varLength.reserved = 0xffff;
+            uint8_t* dst = items[pos + 1].rawData;
+            std::fill_n(dst, (span - 1) * Page::ENTRY_SIZE, 0xff);
+            memcpy(dst, entry.data, entry.dataSize);
+        }
+        item.crc32 = item.calculateCrc32();
+        pos += span;
+    }
+    assert(pos == entryCount);
+
+    Page& page = getCurrentPage();
+    err = page.writeItems(items, entryCount);
+    for (size_t i = 0; i < count; ++i) {
+        updateKeyIndexOnWrite(err, page, nsIndex, entries[i]->key);
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // Erase the old versions, with one entry table update per page
+    for (size_t i = 0; i < count; ++i) {
+        Page* oldPage = oldPages[i];
+        if (!oldPage) {
+            continue;
+        }
+        size_t indices[Page::BATCH_MAX_ENTRIES];
+        size_t indexCount = 0;
+        for (size_t j = i; j < count; ++j) {
+            if (oldPages[j] == oldPage) {
+                indices[indexCount++] = oldIndices[j];
+            }
+        }
+        err = oldPage->eraseEntries(indices, indexCount);
+        for (size_t j = i; j < count; ++j) {
+            if (oldPages[j] == oldPage) {
+                updateKeyIndexOnErase(err, *oldPage, nsIndex, entries[j]->key);
+                oldPages[j] = nullptr;
+            }
+        }
+        if (err == ESP_ERR_FLASH_OP_FAIL) {
+            return ESP_ERR_NVS_REMOVE_FAILED;
+        }
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
 esp_err_t Storage::getItemDataSize(uint8_t nsIndex, ItemType datatype, const char* key, size_t& dataSize)
 {
     if (mState != StorageState::ACTIVE) {
@@ -603,6 +1258,17 @@ void Storage::debugCheck()
                 assert(0);
             }
             keys.insert(std::make_pair(keystr, static_cast<Page*>(p)));
+            if (mKeyIndex.isValid()) {
+                size_t pos = 0;
+                size_t pageIndex;
+                while ((pageIndex = mKeyIndex.find(pos, item)) != SIZE_MAX &&
+                        pageIndex != mPageManager.getPageIndex(*p)) {
+                }
+                if (pageIndex == SIZE_MAX) {
+                    printf("Key missing from index: %s\n", keystr.c_str());
+                    assert(0);
+                }
+            }
             itemIndex += item.span;
             usedCount += item.span;
         }
@@ -617,6 +1283,15 @@ esp_err_t Storage::fillStats(nvs_stats_t& nvsStats)
     return mPageManager.fillStats(nvsStats);
 }
 
+esp_err_t Storage::eraseFreePage(bool& more)
+{
+    more = false;
+    if (mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+    return mPageManager.eraseFreePage(more);
+}
+
 esp_err_t Storage::calcEntriesInNamespace(uint8_t nsIndex, size_t& usedEntries)
 {
     usedEntries = 0;
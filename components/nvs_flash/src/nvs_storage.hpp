@@ -21,6 +21,10 @@
 #include "nvs_types.hpp"
 #include "nvs_page.hpp"
 #include "nvs_pagemanager.hpp"
+#include "nvs_key_index.hpp"
+#include "nvs_transaction.hpp"
+#include "nvs_value_cache.hpp"
+#include "nvs_blob_stream.hpp"
 
 //extern void dumpBytes(const uint8_t* data, size_t count);
 
@@ -58,6 +62,16 @@ class Storage : public intrusive_list_node<Storage>
 
     typedef intrusive_list<BlobIndexNode> TBlobIndexList;
 
+    struct BlobDataNode: public intrusive_list_node<BlobDataNode> {
+        public:
+            char key[Item::MAX_KEY_LENGTH + 1];
+            uint8_t nsIndex;
+            uint8_t chunkIndex;
+            Page* page;
+    };
+
+    typedef intrusive_list<BlobDataNode> TBlobDataList;
+
 public:
     ~Storage();
 
@@ -96,6 +110,28 @@ public:
     
     esp_err_t eraseNamespace(uint8_t nsIndex);
 
+    esp_err_t writeTransaction(uint8_t nsIndex, Transaction& transaction);
+
+    void registerValueCache(ValueCache* cache)
+    {
+        mValueCaches.push_back(cache);
+    }
+
+    void unregisterValueCache(ValueCache* cache)
+    {
+        mValueCaches.erase(cache);
+    }
+
+    esp_err_t openBlobStream(BlobStream& stream);
+
+    esp_err_t readBlobStream(BlobStream& stream, void* data, size_t& dataSize);
+
+    esp_err_t writeBlobStream(BlobStream& stream, const void* data, size_t dataSize);
+
+    esp_err_t closeBlobStream(BlobStream& stream);
+
+    void abortBlobStream(BlobStream& stream);
+
     const char *getPartName() const
     {
         return mPartitionName;
@@ -117,6 +153,8 @@ public:
 
     esp_err_t fillStats(nvs_stats_t& nvsStats);
 
+    esp_err_t eraseFreePage(bool& more);
+
     esp_err_t calcEntriesInNamespace(uint8_t nsIndex, size_t& usedEntries);
 
 protected:
@@ -128,13 +166,34 @@ protected:
 
     void clearNamespaces();
 
-    void populateBlobIndices(TBlobIndexList&);
 
-    void eraseOrphanDataBlobs(TBlobIndexList&);
+    void eraseOrphanDataBlobs(TBlobIndexList&, TBlobDataList&);
 
 
     esp_err_t findItem(uint8_t nsIndex, ItemType datatype, const char* key, Page* &page, Item& item, uint8_t chunkIdx = Page::CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
 
+    esp_err_t writeItemBatch(uint8_t nsIndex, Transaction::Entry* const* entries, size_t count, size_t entryCount);
+
+    static size_t batchEntryCount(const Transaction::Entry& entry);
+
+    void invalidateValueCaches(uint8_t nsIndex, const char* key);
+
+    bool isBlobStreamOpen(uint8_t nsIndex, const char* key);
+
+    size_t getMaxBlobSize();
+
+    esp_err_t getBlobChunkRoom(size_t dataSize, size_t& room);
+
+    esp_err_t writeBlobChunk(BlobStream& stream, const void* data, size_t dataSize);
+
+    esp_err_t eraseBlobChunks(BlobStream& stream);
+
+    void rebuildKeyIndex();
+
+    void updateKeyIndexOnWrite(esp_err_t err, Page& page, uint8_t nsIndex, const char* key, uint8_t chunkIdx = Page::CHUNK_ANY);
+
+    void updateKeyIndexOnErase(esp_err_t err, Page& page, uint8_t nsIndex, const char* key, uint8_t chunkIdx = Page::CHUNK_ANY);
+
 protected:
     const char *mPartitionName;
     size_t mPageCount;
@@ -142,6 +201,9 @@ protected:
     TNamespaces mNamespaces;
     CompressedEnumTable<bool, 1, 256> mNamespaceUsage;
     StorageState mState = StorageState::INVALID;
+    KeyIndex mKeyIndex;
+    intrusive_list<ValueCache> mValueCaches;
+    intrusive_list<BlobStream> mBlobStreams;    // streams being written
 };
 
 } // namespace nvs
@@ -0,0 +1,82 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "nvs_transaction.hpp"
+#include <cstring>
+#include <new>
+
+namespace nvs
+{
+
+Transaction::Transaction()
+{
+}
+
+Transaction::~Transaction()
+{
+    clear();
+}
+
+void Transaction::clear()
+{
+    mEntries.clearAndFreeNodes();
+}
+
+esp_err_t Transaction::stageWrite(ItemType datatype, const char* key, const void* data, size_t dataSize)
+{
+    return stage(Op::WRITE, datatype, key, data, dataSize);
+}
+
+esp_err_t Transaction::stageErase(const char* key)
+{
+    return stage(Op::ERASE, ItemType::ANY, key, nullptr, 0);
+}
+
+esp_err_t Transaction::stage(Op op, ItemType datatype, const char* key, const void* data, size_t dataSize)
+{
+    if (strlen(key) > Item::MAX_KEY_LENGTH) {
+        return ESP_ERR_NVS_KEY_TOO_LONG;
+    }
+
+    Entry* entry = new (std::nothrow) Entry;
+    if (!entry) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (dataSize > 0) {
+        entry->data = new (std::nothrow) uint8_t[dataSize];
+        if (!entry->data) {
+            delete entry;
+            return ESP_ERR_NO_MEM;
+        }
+        memcpy(entry->data, data, dataSize);
+    }
+    entry->op = op;
+    entry->datatype = datatype;
+    entry->dataSize = dataSize;
+    strncpy(entry->key, key, sizeof(entry->key) - 1);
+    entry->key[sizeof(entry->key) - 1] = 0;
+
+    // The new change supersedes an earlier one for the same key and type
+    for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+        if (it->datatype == datatype && strcmp(it->key, entry->key) == 0) {
+            mEntries.erase(it);
+            delete static_cast<Entry*>(it);
+            break;
+        }
+    }
+    mEntries.push_back(entry);
+    return ESP_OK;
+}
+
+} // namespace nvs
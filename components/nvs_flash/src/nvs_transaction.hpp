@@ -0,0 +1,83 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef nvs_transaction_hpp
+#define nvs_transaction_hpp
+
+#include "nvs.h"
+#include "nvs_types.hpp"
+#include "intrusive_list.h"
+
+namespace nvs
+{
+
+/**
+ * Set of changes to one namespace, kept in RAM until Storage::writeTransaction
+ * is called.
+ *
+ * Changes are kept in the order they were staged. Staging a change for a key
+ * and type which already has a staged change replaces the earlier one.
+ */
+class Transaction
+{
+public:
+    enum class Op : uint8_t {
+        WRITE,
+        ERASE,
+    };
+
+    struct Entry : public intrusive_list_node<Entry> {
+    public:
+        ~Entry()
+        {
+            delete[] data;
+        }
+
+        Op op;
+        ItemType datatype;
+        char key[Item::MAX_KEY_LENGTH + 1];
+        uint8_t* data = nullptr;
+        size_t dataSize = 0;
+    };
+
+    typedef intrusive_list<Entry> TEntryList;
+
+    Transaction();
+    ~Transaction();
+
+    esp_err_t stageWrite(ItemType datatype, const char* key, const void* data, size_t dataSize);
+
+    esp_err_t stageErase(const char* key);
+
+    /** Drop all staged changes */
+    void clear();
+
+    TEntryList& entries()
+    {
+        return mEntries;
+    }
+
+private:
+    Transaction(const Transaction& other);
+    const Transaction& operator= (const Transaction& rhs);
+
+protected:
+    esp_err_t stage(Op op, ItemType datatype, const char* key, const void* data, size_t dataSize);
+
+    TEntryList mEntries;
+}; // class Transaction
+
+} // namespace nvs
+
+#endif /* nvs_transaction_hpp */
@@ -13,11 +13,7 @@
 // limitations under the License.
 #include "nvs_types.hpp"
 
-#if defined(ESP_PLATFORM)
-#include <esp32/rom/crc.h>
-#else
-#include "crc.h"
-#endif
+#include "esp_crc.h"
 
 namespace nvs
 {
@@ -25,10 +21,11 @@ uint32_t Item::calculateCrc32() const
 {
     uint32_t result = 0xffffffff;
     const uint8_t* p = reinterpret_cast<const uint8_t*>(this);
-    result = crc32_le(result, p + offsetof(Item, nsIndex),
-                      offsetof(Item, crc32) - offsetof(Item, nsIndex));
-    result = crc32_le(result, p + offsetof(Item, key), sizeof(key));
-    result = crc32_le(result, p + offsetof(Item, data), sizeof(data));
+    result = esp_crc32_le(result, p + offsetof(Item, nsIndex),
+                          offsetof(Item, crc32) - offsetof(Item, nsIndex));
+    // key and data are contiguous, one call lets esp_crc32_le process them 8 bytes at a time
+    static_assert(offsetof(Item, data) == offsetof(Item, key) + sizeof(key), "key must be followed by data");
+    result = esp_crc32_le(result, p + offsetof(Item, key), sizeof(key) + sizeof(data));
     return result;
 }
 
@@ -36,18 +33,16 @@ uint32_t Item::calculateCrc32WithoutValue() const
 {
     uint32_t result = 0xffffffff;
     const uint8_t* p = reinterpret_cast<const uint8_t*>(this);
-    result = crc32_le(result, p + offsetof(Item, nsIndex),
-                      offsetof(Item, datatype) - offsetof(Item, nsIndex));
-    result = crc32_le(result, p + offsetof(Item, key), sizeof(key));
-    result = crc32_le(result, p + offsetof(Item, chunkIndex), sizeof(chunkIndex));
+    result = esp_crc32_le(result, p + offsetof(Item, nsIndex),
+                          offsetof(Item, datatype) - offsetof(Item, nsIndex));
+    result = esp_crc32_le(result, p + offsetof(Item, key), sizeof(key));
+    result = esp_crc32_le(result, p + offsetof(Item, chunkIndex), sizeof(chunkIndex));
     return result;
 }
 
-uint32_t Item::calculateCrc32(const uint8_t* data, size_t size)
+uint32_t Item::calculateCrc32(const uint8_t* data, size_t size, uint32_t crc)
 {
-    uint32_t result = 0xffffffff;
-    result = crc32_le(result, data, size);
-    return result;
+    return esp_crc32_le(crc, data, size);
 }
 
 } // namespace nvs
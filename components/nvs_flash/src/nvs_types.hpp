@@ -121,7 +121,8 @@ public:
 
     uint32_t calculateCrc32() const;
     uint32_t calculateCrc32WithoutValue() const;
-    static uint32_t calculateCrc32(const uint8_t* data, size_t size);
+    /* Pass the result for the preceding data as 'crc' to calculate the CRC of data in parts */
+    static uint32_t calculateCrc32(const uint8_t* data, size_t size, uint32_t crc = 0xffffffff);
 
     void getKey(char* dst, size_t dstSize)
     {
@@ -0,0 +1,104 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "nvs_value_cache.hpp"
+#include <cstring>
+#include <new>
+
+namespace nvs
+{
+
+ValueCache::ValueCache(uint8_t nsIndex, size_t budget) : mNsIndex(nsIndex), mBudget(budget)
+{
+}
+
+ValueCache::~ValueCache()
+{
+    mEntries.clearAndFreeNodes();
+}
+
+size_t ValueCache::getEntryCost(size_t dataSize)
+{
+    return sizeof(CacheEntry) + dataSize;
+}
+
+const uint8_t* ValueCache::find(ItemType datatype, const char* key, size_t& dataSize)
+{
+    for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+        if (it->datatype == datatype && strncmp(it->key, key, sizeof(it->key) - 1) == 0) {
+            CacheEntry* entry = it;
+            mEntries.erase(it);
+            mEntries.push_back(entry);
+            dataSize = entry->dataSize;
+            return entry->data;
+        }
+    }
+    return nullptr;
+}
+
+void ValueCache::insert(ItemType datatype, const char* key, const void* data, size_t dataSize)
+{
+    const size_t cost = getEntryCost(dataSize);
+    if (cost > mBudget) {
+        return;
+    }
+
+    for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+        if (it->datatype == datatype && strncmp(it->key, key, sizeof(it->key) - 1) == 0) {
+            eraseEntry(it);
+            break;
+        }
+    }
+    while (mUsedBytes + cost > mBudget) {
+        eraseEntry(mEntries.begin());
+    }
+
+    CacheEntry* entry = new (std::nothrow) CacheEntry;
+    if (!entry) {
+        return;
+    }
+    entry->data = new (std::nothrow) uint8_t[dataSize];
+    if (!entry->data) {
+        delete entry;
+        return;
+    }
+    memcpy(entry->data, data, dataSize);
+    entry->dataSize = dataSize;
+    entry->datatype = datatype;
+    strncpy(entry->key, key, sizeof(entry->key) - 1);
+    entry->key[sizeof(entry->key) - 1] = 0;
+    mEntries.push_back(entry);
+    mUsedBytes += cost;
+}
+
+void ValueCache::invalidate(const char* key)
+{
+    auto it = mEntries.begin();
+    while (it != mEntries.end()) {
+        CacheEntry* entry = it;
+        ++it;
+        if (key == nullptr || strncmp(entry->key, key, sizeof(entry->key) - 1) == 0) {
+            eraseEntry(entry);
+        }
+    }
+}
+
+void ValueCache::eraseEntry(CacheEntry* entry)
+{
+    mUsedBytes -= getEntryCost(entry->dataSize);
+    mEntries.erase(entry);
+    delete entry;
+}
+
+} // namespace nvs
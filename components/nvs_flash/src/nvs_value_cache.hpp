@@ -0,0 +1,92 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef nvs_value_cache_hpp
+#define nvs_value_cache_hpp
+
+#include "nvs.h"
+#include "nvs_types.hpp"
+#include "intrusive_list.h"
+
+namespace nvs
+{
+
+/**
+ * Least recently used cache of values read from one namespace.
+ *
+ * Total size of cached values, including per-value bookkeeping, is kept
+ * within the budget given to the constructor. Caches are registered with
+ * Storage, which invalidates the affected values on every write and erase.
+ */
+class ValueCache : public intrusive_list_node<ValueCache>
+{
+public:
+    ValueCache(uint8_t nsIndex, size_t budget);
+    ~ValueCache();
+
+    uint8_t getNsIndex() const
+    {
+        return mNsIndex;
+    }
+
+    size_t getUsedBytes() const
+    {
+        return mUsedBytes;
+    }
+
+    /**
+     * Find a cached value and mark it as most recently used.
+     * @return pointer to the value, or nullptr if it is not cached
+     */
+    const uint8_t* find(ItemType datatype, const char* key, size_t& dataSize);
+
+    /** Add a value, evicting the least recently used ones if it doesn't fit */
+    void insert(ItemType datatype, const char* key, const void* data, size_t dataSize);
+
+    /** Drop all cached values of the key, or all values if key is nullptr */
+    void invalidate(const char* key);
+
+    static size_t getEntryCost(size_t dataSize);
+
+private:
+    ValueCache(const ValueCache& other);
+    const ValueCache& operator= (const ValueCache& rhs);
+
+protected:
+    struct CacheEntry : public intrusive_list_node<CacheEntry> {
+    public:
+        ~CacheEntry()
+        {
+            delete[] data;
+        }
+
+        ItemType datatype;
+        char key[Item::MAX_KEY_LENGTH + 1];
+        uint8_t* data = nullptr;
+        size_t dataSize = 0;
+    };
+
+    typedef intrusive_list<CacheEntry> TEntryList;
+
+    void eraseEntry(CacheEntry* entry);
+
+    uint8_t mNsIndex;
+    size_t mBudget;
+    size_t mUsedBytes = 0;
+    TEntryList mEntries;       // least recently used first
+}; // class ValueCache
+
+} // namespace nvs
+
+#endif /* nvs_value_cache_hpp */
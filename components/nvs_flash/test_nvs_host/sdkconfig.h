@@ -0,0 +1 @@
+#define CONFIG_ESP_CRC_TABLES 1
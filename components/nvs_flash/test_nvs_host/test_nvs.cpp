@@ -547,6 +547,116 @@ TEST_CASE("can erase items", "[nvs]")
     CHECK(storage.readItem(3, "key00222", val) == ESP_ERR_NVS_NOT_FOUND);
 }
 
+TEST_CASE("KeyIndex returns every page an item was inserted for", "[nvs][index]")
+{
+    KeyIndex index;
+    size_t pos = 0;
+    Item foo(1, ItemType::ANY, 0, "foo");
+    Item bar(1, ItemType::ANY, 0, "bar");
+    CHECK(index.find(pos, foo) == SIZE_MAX);
+
+    index.reset();
+    index.insert(foo, 3);
+    index.insert(foo, 3);
+    index.insert(foo, 5);
+    for (size_t i = 0; i < 1000; ++i) {
+        char name[Item::MAX_KEY_LENGTH + 1];
+        snprintf(name, sizeof(name), "key%05d", static_cast<int>(i));
+        index.insert(Item(2, ItemType::ANY, 0, name), i % 7);
+    }
+    CHECK(index.size() == 1003);
+
+    bool found3 = false, found5 = false;
+    size_t page;
+    pos = 0;
+    while ((page = index.find(pos, foo)) != SIZE_MAX) {
+        found3 |= (page == 3);
+        found5 |= (page == 5);
+    }
+    CHECK(found3);
+    CHECK(found5);
+
+    index.erase(foo, 3);
+    index.erase(foo, 5);
+    found3 = found5 = false;
+    pos = 0;
+    while ((page = index.find(pos, foo)) != SIZE_MAX) {
+        found3 |= (page == 3);
+        found5 |= (page == 5);
+    }
+    CHECK(found3);
+    CHECK_FALSE(found5);
+
+    index.movePage(3, 4);
+    pos = 0;
+    CHECK(index.find(pos, foo) == 4);
+    index.erase(foo, 4);
+    pos = 0;
+    CHECK(index.find(pos, foo) == SIZE_MAX);
+    pos = 0;
+    CHECK(index.find(pos, bar) == SIZE_MAX);
+
+    for (size_t i = 0; i < 1000; ++i) {
+        char name[Item::MAX_KEY_LENGTH + 1];
+        snprintf(name, sizeof(name), "key%05d", static_cast<int>(i));
+        Item item(2, ItemType::ANY, 0, name);
+        size_t expectedPage = (i % 7 == 3) ? 4 : i % 7;
+        pos = 0;
+        CHECK(index.find(pos, item) == expectedPage);
+        index.erase(item, expectedPage);
+    }
+    CHECK(index.size() == 0);
+}
+
+TEST_CASE("storage key index keeps track of items moved to other pages", "[nvs][index]")
+{
+    const size_t pageCount = 16;
+    SpiFlashEmulator emu(pageCount);
+    Storage storage;
+    CHECK(storage.init(0, pageCount) == ESP_OK);
+    const size_t itemCount = Page::ENTRY_COUNT * 8;
+    for (size_t i = 0; i < itemCount; ++i) {
+        char name[Item::MAX_KEY_LENGTH + 1];
+        snprintf(name, sizeof(name), "key%05d", static_cast<int>(i));
+        REQUIRE(storage.writeItem(1, name, static_cast<int>(i)) == ESP_OK);
+    }
+    // keep rewriting some keys, so that pages get reclaimed and their items copied
+    for (size_t i = 0; i < Page::ENTRY_COUNT * 16; ++i) {
+        char name[Item::MAX_KEY_LENGTH + 1];
+        snprintf(name, sizeof(name), "key%05d", static_cast<int>(i % 64));
+        REQUIRE(storage.writeItem(1, name, static_cast<int>(i % 64)) == ESP_OK);
+    }
+    CHECK(emu.getEraseOps() > 0);
+
+    for (size_t i = 0; i < itemCount; i += 37) {
+        char name[Item::MAX_KEY_LENGTH + 1];
+        snprintf(name, sizeof(name), "key%05d", static_cast<int>(i));
+        int val;
+        REQUIRE(storage.readItem(1, name, val) == ESP_OK);
+        CHECK(val == static_cast<int>(i));
+    }
+
+    int val;
+#ifdef CONFIG_NVS_KEY_INDEX
+    // missing keys are rejected without scanning the pages
+    emu.clearStats();
+    CHECK(storage.readItem(1, "missing", val) == ESP_ERR_NVS_NOT_FOUND);
+    CHECK(emu.getReadOps() == 0);
+
+    // existing keys are read from a single page
+    emu.clearStats();
+    CHECK(storage.readItem(1, "key00100", val) == ESP_OK);
+    CHECK(emu.getReadOps() <= 4);
+#endif
+
+    Storage reloaded;
+    CHECK(reloaded.init(0, pageCount) == ESP_OK);
+    CHECK(reloaded.eraseItem(1, "key00100") == ESP_OK);
+    CHECK(reloaded.readItem(1, "key00100", val) == ESP_ERR_NVS_NOT_FOUND);
+    CHECK(reloaded.readItem(1, "key00101", val) == ESP_OK);
+    CHECK(val == 101);
+}
+
 TEST_CASE("nvs api tests", "[nvs]")
 {
     SpiFlashEmulator emu(10);
@@ -609,6 +719,489 @@ TEST_CASE("nvs api tests", "[nvs]")
     nvs_close(handle_2);
 }
 
+TEST_CASE("nvs transaction writes staged changes on commit", "[nvs][transaction]")
+{
+    SpiFlashEmulator emu(10);
+    const uint32_t NVS_FLASH_SECTOR = 2;
+    const uint32_t NVS_FLASH_SECTOR_COUNT_MIN = 8;
+    emu.setBounds(NVS_FLASH_SECTOR, NVS_FLASH_SECTOR + NVS_FLASH_SECTOR_COUNT_MIN);
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, NVS_FLASH_SECTOR, NVS_FLASH_SECTOR_COUNT_MIN));
+
+    nvs_handle handle;
+    TEST_ESP_OK(nvs_open("namespace1", NVS_READWRITE, &handle));
+    TEST_ESP_ERR(nvs_transaction_commit(handle), ESP_ERR_NVS_INVALID_STATE);
+    TEST_ESP_ERR(nvs_transaction_abort(handle), ESP_ERR_NVS_INVALID_STATE);
+
+    const int keyCount = 40;
+    char keys[keyCount][Item::MAX_KEY_LENGTH + 1];
+    for (int i = 0; i < keyCount; ++i) {
+        snprintf(keys[i], sizeof(keys[i]), "cfg%02d", i);
+        TEST_ESP_OK(nvs_set_i32(handle, keys[i], i));
+    }
+
+    emu.clearStats();
+    for (int i = 0; i < keyCount; ++i) {
+        TEST_ESP_OK(nvs_set_i32(handle, keys[i], i + 100));
+    }
+    const size_t singleWriteOps = emu.getWriteOps();
+
+    emu.clearStats();
+    TEST_ESP_OK(nvs_transaction_begin(handle));
+    TEST_ESP_ERR(nvs_transaction_begin(handle), ESP_ERR_NVS_INVALID_STATE);
+    for (int i = 0; i < keyCount; ++i) {
+        TEST_ESP_OK(nvs_set_i32(handle, keys[i], i + 200));
+    }
+    // a later change to the same key replaces the earlier one
+    TEST_ESP_OK(nvs_set_i32(handle, keys[0], 1000));
+    TEST_ESP_OK(nvs_set_str(handle, "str", "staged string value, longer than one entry"));
+    TEST_ESP_OK(nvs_erase_key(handle, keys[1]));
+    TEST_ESP_OK(nvs_erase_key(handle, "missing"));
+    TEST_ESP_ERR(nvs_erase_all(handle), ESP_ERR_NVS_INVALID_STATE);
+    CHECK(emu.getWriteOps() == 0);
+
+    // reads return the values which are in flash
+    int32_t val;
+    TEST_ESP_OK(nvs_get_i32(handle, keys[0], &val));
+    CHECK(val == 100);
+
+    TEST_ESP_OK(nvs_transaction_commit(handle));
+    CHECK(emu.getWriteOps() * 2 < singleWriteOps);
+
+    TEST_ESP_OK(nvs_get_i32(handle, keys[0], &val));
+    CHECK(val == 1000);
+    TEST_ESP_ERR(nvs_get_i32(handle, keys[1], &val), ESP_ERR_NVS_NOT_FOUND);
+    for (int i = 2; i < keyCount; ++i) {
+        TEST_ESP_OK(nvs_get_i32(handle, keys[i], &val));
+        CHECK(val == i + 200);
+    }
+    char buf[64];
+    size_t len = sizeof(buf);
+    TEST_ESP_OK(nvs_get_str(handle, "str", buf, &len));
+    CHECK(strcmp(buf, "staged string value, longer than one entry") == 0);
+
+    nvs_stats_t stats;
+    TEST_ESP_OK(nvs_get_stats(NVS_DEFAULT_PART_NAME, &stats));
+    nvs_close(handle);
+
+    // old versions are gone after re-initialization as well
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, NVS_FLASH_SECTOR, NVS_FLASH_SECTOR_COUNT_MIN));
+    nvs_stats_t statsAfterInit;
+    TEST_ESP_OK(nvs_get_stats(NVS_DEFAULT_PART_NAME, &statsAfterInit));
+    CHECK(statsAfterInit.used_entries == stats.used_entries);
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+}
+
+TEST_CASE("nvs transaction can be aborted", "[nvs][transaction]")
+{
+    SpiFlashEmulator emu(10);
+    const uint32_t NVS_FLASH_SECTOR = 6;
+    const uint32_t NVS_FLASH_SECTOR_COUNT_MIN = 3;
+    emu.setBounds(NVS_FLASH_SECTOR, NVS_FLASH_SECTOR + NVS_FLASH_SECTOR_COUNT_MIN);
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, NVS_FLASH_SECTOR, NVS_FLASH_SECTOR_COUNT_MIN));
+
+    nvs_handle handle;
+    TEST_ESP_OK(nvs_open("namespace1", NVS_READWRITE, &handle));
+    TEST_ESP_OK(nvs_set_u8(handle, "foo", 1));
+
+    TEST_ESP_OK(nvs_transaction_begin(handle));
+    TEST_ESP_OK(nvs_set_u8(handle, "foo", 2));
+    TEST_ESP_OK(nvs_set_u8(handle, "bar", 3));
+    TEST_ESP_OK(nvs_transaction_abort(handle));
+
+    uint8_t val;
+    TEST_ESP_OK(nvs_get_u8(handle, "foo", &val));
+    CHECK(val == 1);
+    TEST_ESP_ERR(nvs_get_u8(handle, "bar", &val), ESP_ERR_NVS_NOT_FOUND);
+
+    // nvs_commit writes an open transaction, nvs_close discards it
+    TEST_ESP_OK(nvs_transaction_begin(handle));
+    TEST_ESP_OK(nvs_set_u8(handle, "foo", 4));
+    TEST_ESP_OK(nvs_commit(handle));
+    TEST_ESP_ERR(nvs_transaction_commit(handle), ESP_ERR_NVS_INVALID_STATE);
+    TEST_ESP_OK(nvs_get_u8(handle, "foo", &val));
+    CHECK(val == 4);
+
+    TEST_ESP_OK(nvs_transaction_begin(handle));
+    TEST_ESP_OK(nvs_set_u8(handle, "foo", 5));
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_open("namespace1", NVS_READONLY, &handle));
+    TEST_ESP_ERR(nvs_transaction_begin(handle), ESP_ERR_NVS_READ_ONLY);
+    TEST_ESP_OK(nvs_get_u8(handle, "foo", &val));
+    CHECK(val == 4);
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+}
+
+TEST_CASE("duplicates left by an interrupted transaction are removed on init", "[nvs][transaction]")
+{
+    const size_t keyCount = 24;
+    const char str[] = "value 0123456789abcdef0123456789abcdef";
+    for (uint32_t errDelay = 0; ; ++errDelay) {
+        INFO(errDelay);
+        SpiFlashEmulator emu(4);
+        char keys[keyCount][Item::MAX_KEY_LENGTH + 1];
+        {
+            Storage storage;
+            TEST_ESP_OK(storage.init(0, 4));
+            for (size_t i = 0; i < keyCount; ++i) {
+                snprintf(keys[i], sizeof(keys[i]), "key%02d", static_cast<int>(i));
+                TEST_ESP_OK(storage.writeItem(1, keys[i], static_cast<uint32_t>(i)));
+            }
+            TEST_ESP_OK(storage.writeItem(1, ItemType::SZ, "str", str, strlen(str)));
+        }
+
+        emu.failAfter(errDelay);
+        esp_err_t err;
+        {
+            Storage storage;
+            TEST_ESP_OK(storage.init(0, 4));
+            Transaction transaction;
+            for (size_t i = 0; i < keyCount; ++i) {
+                uint32_t val = i + 1000;
+                TEST_ESP_OK(transaction.stageWrite(ItemType::U32, keys[i], &val, sizeof(val)));
+            }
+            TEST_ESP_OK(transaction.stageWrite(ItemType::SZ, "str", "new", 4));
+            err = storage.writeTransaction(1, transaction);
+        }
+        emu.failAfter(UINT32_MAX);
+
+        // Storage::init checks that there are no duplicate items left
+        Storage storage;
+        TEST_ESP_OK(storage.init(0, 4));
+        for (size_t i = 0; i < keyCount; ++i) {
+            uint32_t val;
+            TEST_ESP_OK(storage.readItem(1, keys[i], val));
+            CHECK((val == i || val == i + 1000));
+            if (err == ESP_OK) {
+                CHECK(val == i + 1000);
+            }
+        }
+        char buf[sizeof(str)];
+        TEST_ESP_OK(storage.readItem(1, ItemType::SZ, "str", buf, sizeof(buf)));
+        CHECK((strcmp(buf, str) == 0 || strcmp(buf, "new") == 0));
+
+        if (err == ESP_OK) {
+            CHECK(strcmp(buf, "new") == 0);
+            break;
+        }
+        REQUIRE(errDelay < 10000);
+    }
+}
+
+TEST_CASE("ValueCache evicts least recently used values", "[nvs][cache]")
+{
+    const uint32_t a = 1, b = 2, c = 3;
+    ValueCache cache(1, ValueCache::getEntryCost(sizeof(uint32_t)) * 2);
+    size_t size;
+    CHECK(cache.find(ItemType::U32, "a", size) == nullptr);
+
+    cache.insert(ItemType::U32, "a", &a, sizeof(a));
+    cache.insert(ItemType::U32, "b", &b, sizeof(b));
+    const uint8_t* data = cache.find(ItemType::U32, "a", size);
+    REQUIRE(data != nullptr);
+    CHECK(size == sizeof(a));
+    CHECK(memcmp(data, &a, sizeof(a)) == 0);
+    CHECK(cache.find(ItemType::I32, "a", size) == nullptr);
+
+    // "b" is the least recently used one now
+    cache.insert(ItemType::U32, "c", &c, sizeof(c));
+    CHECK(cache.getUsedBytes() == ValueCache::getEntryCost(sizeof(uint32_t)) * 2);
+    CHECK(cache.find(ItemType::U32, "b", size) == nullptr);
+    CHECK(cache.find(ItemType::U32, "a", size) != nullptr);
+    CHECK(cache.find(ItemType::U32, "c", size) != nullptr);
+
+    // values larger than the budget are not cached
+    uint8_t big[128] = {0};
+    cache.insert(ItemType::BLOB, "big", big, sizeof(big));
+    CHECK(cache.find(ItemType::BLOB, "big", size) == nullptr);
+    CHECK(cache.find(ItemType::U32, "c", size) != nullptr);
+
+    cache.invalidate("c");
+    CHECK(cache.find(ItemType::U32, "c", size) == nullptr);
+    cache.invalidate(nullptr);
+    CHECK(cache.getUsedBytes() == 0);
+}
+
+TEST_CASE("cached handle reads values from flash only once", "[nvs][cache]")
+{
+    SpiFlashEmulator emu(10);
+    const uint32_t NVS_FLASH_SECTOR = 6;
+    const uint32_t NVS_FLASH_SECTOR_COUNT_MIN = 3;
+    emu.setBounds(NVS_FLASH_SECTOR, NVS_FLASH_SECTOR + NVS_FLASH_SECTOR_COUNT_MIN);
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, NVS_FLASH_SECTOR, NVS_FLASH_SECTOR_COUNT_MIN));
+
+    nvs_handle writer, reader;
+    TEST_ESP_OK(nvs_open("namespace1", NVS_READWRITE, &writer));
+    TEST_ESP_OK(nvs_open_cached("namespace1", NVS_READONLY, 256, &reader));
+    TEST_ESP_OK(nvs_set_u32(writer, "calib", 0x12345678));
+    const char* str = "feature flags";
+    TEST_ESP_OK(nvs_set_str(writer, "flags", str));
+
+    uint32_t val;
+    char buf[32];
+    size_t len = sizeof(buf);
+    TEST_ESP_OK(nvs_get_u32(reader, "calib", &val));
+    TEST_ESP_OK(nvs_get_str(reader, "flags", buf, &len));
+
+    emu.clearStats();
+    for (int i = 0; i < 100; ++i) {
+        TEST_ESP_OK(nvs_get_u32(reader, "calib", &val));
+        CHECK(val == 0x12345678);
+        size_t needed;
+        TEST_ESP_OK(nvs_get_str(reader, "flags", NULL, &needed));
+        CHECK(needed == strlen(str) + 1);
+        len = sizeof(buf);
+        TEST_ESP_OK(nvs_get_str(reader, "flags", buf, &len));
+        CHECK(strcmp(buf, str) == 0);
+    }
+    CHECK(emu.getReadOps() == 0);
+
+    // changes through another handle are seen
+    TEST_ESP_OK(nvs_set_u32(writer, "calib", 0x23456789));
+    TEST_ESP_OK(nvs_get_u32(reader, "calib", &val));
+    CHECK(val == 0x23456789);
+    TEST_ESP_OK(nvs_erase_key(writer, "flags"));
+    len = sizeof(buf);
+    TEST_ESP_ERR(nvs_get_str(reader, "flags", buf, &len), ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_OK(nvs_erase_all(writer));
+    TEST_ESP_ERR(nvs_get_u32(reader, "calib", &val), ESP_ERR_NVS_NOT_FOUND);
+
+    nvs_close(reader);
+    nvs_close(writer);
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+}
+
+TEST_CASE("blob stream writes and reads blobs spanning several pages", "[nvs][blob_stream]")
+{
+    SpiFlashEmulator emu(10);
+    const uint32_t NVS_FLASH_SECTOR = 0;
+    const uint32_t NVS_FLASH_SECTOR_COUNT = 10;
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, NVS_FLASH_SECTOR, NVS_FLASH_SECTOR_COUNT));
+
+    nvs_handle handle;
+    TEST_ESP_OK(nvs_open("namespace1", NVS_READWRITE, &handle));
+    TEST_ESP_OK(nvs_set_i32(handle, "counter", 42));
+
+    const size_t blob_size = Page::CHUNK_MAX_SIZE * 3 + 123;
+    uint8_t* blob = new uint8_t[blob_size];
+    for (size_t i = 0; i < blob_size; ++i) {
+        blob[i] = static_cast<uint8_t>(i * 7 + i / 256);
+    }
+
+    // small parts are buffered, large parts are written directly
+    TEST_ESP_OK(nvs_blob_open(handle, "cert", NVS_READWRITE, NULL));
+    TEST_ESP_ERR(nvs_blob_open(handle, "other", NVS_READWRITE, NULL), ESP_ERR_NVS_INVALID_STATE);
+    size_t offset = 0;
+    for (size_t part = 1; offset < blob_size; part = part * 3 + 1) {
+        size_t len = std::min(part, blob_size - offset);
+        TEST_ESP_OK(nvs_blob_write_chunk(handle, blob + offset, len));
+        offset += len;
+    }
+    uint8_t* out = new uint8_t[blob_size];
+    size_t out_size = blob_size;
+    TEST_ESP_ERR(nvs_get_blob(handle, "cert", out, &out_size), ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_OK(nvs_blob_close(handle));
+
+    out_size = blob_size;
+    TEST_ESP_OK(nvs_get_blob(handle, "cert", out, &out_size));
+    CHECK(out_size == blob_size);
+    CHECK(memcmp(out, blob, blob_size) == 0);
+
+    // read back in odd sized parts
+    size_t length;
+    TEST_ESP_OK(nvs_blob_open(handle, "cert", NVS_READONLY, &length));
+    CHECK(length == blob_size);
+    memset(out, 0, blob_size);
+    offset = 0;
+    while (true) {
+        size_t len = std::min(static_cast<size_t>(77), blob_size - offset);
+        TEST_ESP_OK(nvs_blob_read_chunk(handle, out + offset, &len));
+        if (len == 0) {
+            break;
+        }
+        offset += len;
+    }
+    CHECK(offset == blob_size);
+    CHECK(memcmp(out, blob, blob_size) == 0);
+    TEST_ESP_OK(nvs_blob_close(handle));
+
+    // rewriting replaces the old value and frees its entries
+    nvs_stats_t stats_before;
+    TEST_ESP_OK(nvs_get_stats(NULL, &stats_before));
+    for (size_t i = 0; i < blob_size; ++i) {
+        blob[i] ^= 0x5a;
+    }
+    TEST_ESP_OK(nvs_blob_open(handle, "cert", NVS_READWRITE, NULL));
+    TEST_ESP_OK(nvs_blob_write_chunk(handle, blob, blob_size));
+    TEST_ESP_OK(nvs_blob_close(handle));
+    nvs_stats_t stats_after;
+    TEST_ESP_OK(nvs_get_stats(NULL, &stats_after));
+    CHECK(stats_after.used_entries == stats_before.used_entries);
+
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, NVS_FLASH_SECTOR, NVS_FLASH_SECTOR_COUNT));
+    out_size = blob_size;
+    TEST_ESP_OK(nvs_get_blob(handle, "cert", out, &out_size));
+    CHECK(memcmp(out, blob, blob_size) == 0);
+    int32_t counter;
+    TEST_ESP_OK(nvs_get_i32(handle, "counter", &counter));
+    CHECK(counter == 42);
+
+    delete[] out;
+    delete[] blob;
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+}
+
+TEST_CASE("blob stream keeps the old value until it is closed", "[nvs][blob_stream]")
+{
+    SpiFlashEmulator emu(10);
+    const uint32_t NVS_FLASH_SECTOR = 0;
+    const uint32_t NVS_FLASH_SECTOR_COUNT = 10;
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, NVS_FLASH_SECTOR, NVS_FLASH_SECTOR_COUNT));
+
+    nvs_handle writer, reader;
+    TEST_ESP_OK(nvs_open("namespace1", NVS_READWRITE, &writer));
+    TEST_ESP_OK(nvs_open("namespace1", NVS_READWRITE, &reader));
+    const char old_value[] = "old value";
+    TEST_ESP_OK(nvs_set_blob(writer, "cert", old_value, sizeof(old_value)));
+    nvs_stats_t stats_before;
+    TEST_ESP_OK(nvs_get_stats(NULL, &stats_before));
+
+    const size_t blob_size = Page::CHUNK_MAX_SIZE * 2;
+    uint8_t* blob = new uint8_t[blob_size];
+    memset(blob, 0xa5, blob_size);
+
+    // aborted stream leaves the old value
+    TEST_ESP_OK(nvs_blob_open(writer, "cert", NVS_READWRITE, NULL));
+    TEST_ESP_OK(nvs_blob_write_chunk(writer, blob, blob_size));
+    TEST_ESP_ERR(nvs_set_blob(reader, "cert", blob, 16), ESP_ERR_NVS_INVALID_STATE);
+    TEST_ESP_ERR(nvs_blob_open(reader, "cert", NVS_READWRITE, NULL), ESP_ERR_NVS_INVALID_STATE);
+    char buf[sizeof(old_value)];
+    size_t length;
+    TEST_ESP_OK(nvs_blob_open(reader, "cert", NVS_READONLY, &length));
+    CHECK(length == sizeof(old_value));
+    length = sizeof(buf);
+    TEST_ESP_OK(nvs_blob_read_chunk(reader, buf, &length));
+    CHECK(length == sizeof(old_value));
+    CHECK(memcmp(buf, old_value, sizeof(old_value)) == 0);
+    TEST_ESP_OK(nvs_blob_close(reader));
+    TEST_ESP_OK(nvs_blob_abort(writer));
+
+    nvs_stats_t stats_after;
+    TEST_ESP_OK(nvs_get_stats(NULL, &stats_after));
+    CHECK(stats_after.used_entries == stats_before.used_entries);
+    TEST_ESP_OK(nvs_set_blob(reader, "cert", old_value, sizeof(old_value)));
+
+    // power off before the stream is closed
+    TEST_ESP_OK(nvs_blob_open(writer, "cert", NVS_READWRITE, NULL));
+    TEST_ESP_OK(nvs_blob_write_chunk(writer, blob, blob_size));
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, NVS_FLASH_SECTOR, NVS_FLASH_SECTOR_COUNT));
+    TEST_ESP_ERR(nvs_blob_close(writer), ESP_ERR_NVS_INVALID_STATE);
+    length = sizeof(buf);
+    TEST_ESP_OK(nvs_get_blob(reader, "cert", buf, &length));
+    CHECK(memcmp(buf, old_value, sizeof(old_value)) == 0);
+    TEST_ESP_OK(nvs_get_stats(NULL, &stats_after));
+    CHECK(stats_after.used_entries == stats_before.used_entries);
+
+    // reading fails if the blob is replaced in the meantime
+    TEST_ESP_OK(nvs_set_blob(writer, "cert", blob, blob_size));
+    TEST_ESP_OK(nvs_blob_open(reader, "cert", NVS_READONLY, &length));
+    uint8_t* out = new uint8_t[blob_size];
+    length = Page::CHUNK_MAX_SIZE / 2;
+    TEST_ESP_OK(nvs_blob_read_chunk(reader, out, &length));
+    TEST_ESP_OK(nvs_set_blob(writer, "cert", old_value, sizeof(old_value)));
+    length = blob_size;
+    TEST_ESP_ERR(nvs_blob_read_chunk(reader, out, &length), ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_ERR(nvs_blob_read_chunk(reader, out, &length), ESP_ERR_NVS_INVALID_STATE);
+    TEST_ESP_OK(nvs_blob_close(reader));
+
+    delete[] out;
+    delete[] blob;
+    nvs_close(reader);
+    nvs_close(writer);
+    TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+}
+
+TEST_CASE("full pages are looked into on first lookup by key", "[nvs][lazy]")
+{
+    SpiFlashEmulator emu(1);
+    {
+        Page page;
+        CHECK(page.load(0) == ESP_OK);
+        for (size_t i = 0; ; ++i) {
+            char name[Item::MAX_KEY_LENGTH + 1];
+            snprintf(name, sizeof(name), "key%05d", static_cast<int>(i));
+            if (page.writeItem(1, name, static_cast<uint32_t>(i)) != ESP_OK) {
+                break;
+            }
+        }
+        CHECK(page.markFull() == ESP_OK);
+    }
+
+    emu.clearStats();
+    Page page;
+    CHECK(page.load(0) == ESP_OK);
+    CHECK(page.state() == Page::PageState::FULL);
+#ifdef CONFIG_NVS_LAZY_LOAD
+    // only the header and the entry state table are read
+    CHECK(emu.getReadOps() <= 2);
+#endif
+    uint32_t val;
+    CHECK(page.readItem(1, "key00042", val) == ESP_OK);
+    CHECK(val == 42);
+    CHECK(page.readItem(1, "missing", val) == ESP_ERR_NVS_NOT_FOUND);
+    CHECK(page.eraseItem<uint32_t>(1, "key00043") == ESP_OK);
+    CHECK(page.readItem(1, "key00043", val) == ESP_ERR_NVS_NOT_FOUND);
+
+    emu.clearStats();
+    CHECK(page.readItem(1, "key00044", val) == ESP_OK);
+    CHECK(val == 44);
+    CHECK(emu.getReadOps() <= 2);
+}
+
+TEST_CASE("freed pages can be erased outside of writes", "[nvs][gc]")
+{
+    SpiFlashEmulator emu(3);
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, 3));
+    nvs_handle handle;
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+
+    size_t gcErases = 0;
+    size_t writeErases = 0;
+    for (uint32_t i = 0; i < Page::ENTRY_COUNT * 8; ++i) {
+        bool more = true;
+        while (more) {
+            emu.clearStats();
+            TEST_ESP_OK(nvs_flash_gc_step(NULL, &more));
+            gcErases += emu.getEraseOps();
+        }
+        emu.clearStats();
+        TEST_ESP_OK(nvs_set_u32(handle, "counter", i));
+        writeErases += emu.getEraseOps();
+    }
+#ifdef CONFIG_NVS_BACKGROUND_GC
+    CHECK(gcErases > 0);
+    CHECK(writeErases == 0);
+#else
+    CHECK(gcErases == 0);
+    CHECK(writeErases > 0);
+#endif
+
+    // pages waiting to be erased are reused after a restart
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit());
+    TEST_ESP_OK(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, 3));
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+    uint32_t val;
+    TEST_ESP_OK(nvs_get_u32(handle, "counter", &val));
+    CHECK(val == Page::ENTRY_COUNT * 8 - 1);
+    for (uint32_t i = 0; i < Page::ENTRY_COUNT * 4; ++i) {
+        TEST_ESP_OK(nvs_set_u32(handle, "counter", i));
+    }
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit());
+}
+
 TEST_CASE("wifi test", "[nvs]")
 {
     SpiFlashEmulator emu(10);
@@ -2540,6 +3133,52 @@ TEST_CASE("test nvs apis with encryption enabled", "[nvs]")
 
 }
 
+TEST_CASE("encrypted multi-entry values are read and copied several entries at a time", "[nvs]")
+{
+    SpiFlashEmulator emu(3);
+
+    nvs_sec_cfg_t xts_cfg;
+    for(int count = 0; count < NVS_KEY_SIZE; count++) {
+        xts_cfg.eky[count] = 0x33;
+        xts_cfg.tky[count] = 0x44;
+    }
+    TEST_ESP_OK(nvs_flash_secure_init_custom(NVS_DEFAULT_PART_NAME, 0, 3, &xts_cfg));
+
+    nvs_handle handle;
+    TEST_ESP_OK(nvs_open("namespace1", NVS_READWRITE, &handle));
+    const size_t blob_size = 1000;
+    uint8_t blob[blob_size];
+    uint8_t out[blob_size];
+
+    // keep rewriting, so that pages get reclaimed and the blob is copied
+    for (int round = 0; round < 20; ++round) {
+        for (size_t i = 0; i < blob_size; ++i) {
+            blob[i] = static_cast<uint8_t>(i + round);
+        }
+        TEST_ESP_OK(nvs_set_blob(handle, "blob", blob, blob_size));
+        TEST_ESP_OK(nvs_set_i32(handle, "round", round));
+    }
+    CHECK(emu.getEraseOps() > 0);
+
+    emu.clearStats();
+    size_t out_size = blob_size;
+    TEST_ESP_OK(nvs_get_blob(handle, "blob", out, &out_size));
+    CHECK(memcmp(out, blob, blob_size) == 0);
+    CHECK(emu.getReadOps() < blob_size / Page::ENTRY_SIZE / 2);
+
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit());
+
+    // data is still readable after re-initialization
+    TEST_ESP_OK(nvs_flash_secure_init_custom(NVS_DEFAULT_PART_NAME, 0, 3, &xts_cfg));
+    TEST_ESP_OK(nvs_open("namespace1", NVS_READONLY, &handle));
+    out_size = blob_size;
+    TEST_ESP_OK(nvs_get_blob(handle, "blob", out, &out_size));
+    CHECK(memcmp(out, blob, blob_size) == 0);
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit());
+}
+
 TEST_CASE("test nvs apis for nvs partition generator utility with encryption enabled", "[nvs_part_gen]")
 {
     int status;
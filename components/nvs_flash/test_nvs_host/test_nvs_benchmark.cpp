@@ -0,0 +1,196 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Benchmarks of the storage layer over synthetic partitions.
+ *
+ * These tests are hidden and tagged [long], so they don't run as part of
+ * "make test" or "make long-test". Use "make benchmark" to run them.
+ * For each partition size, an image is filled with a large set of keys,
+ * then Storage::init, findItem, writeItem and the blob paths are timed on it.
+ * Every line reports the flash operations counted by SpiFlashEmulator and
+ * the emulated time they would take.
+ */
+#include "catch.hpp"
+#include "nvs.hpp"
+#include "spi_flash_emulation.h"
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace nvs;
+
+namespace
+{
+
+class BenchmarkStorage : public Storage
+{
+public:
+    using Storage::findItem;
+};
+
+struct BenchmarkKey {
+    uint8_t nsIndex;
+    char name[Item::MAX_KEY_LENGTH + 1];
+    bool isString;
+};
+
+const size_t NAMESPACE_COUNT = 4;
+const size_t BLOB_COUNT = 4;
+const size_t BLOB_SIZE = 6000;
+
+void report(const char* what, size_t opCount, const SpiFlashEmulator& emu)
+{
+    printf("  %-26s %6u ops %9u us %8.1f us/op  (%uE %uW %uR %uWb %uRb)\n",
+           what, static_cast<unsigned>(opCount),
+           static_cast<unsigned>(emu.getTotalTime()),
+           opCount ? static_cast<double>(emu.getTotalTime()) / opCount : 0.0,
+           static_cast<unsigned>(emu.getEraseOps()), static_cast<unsigned>(emu.getWriteOps()),
+           static_cast<unsigned>(emu.getReadOps()), static_cast<unsigned>(emu.getWriteBytes()),
+           static_cast<unsigned>(emu.getReadBytes()));
+}
+
+void fillString(char* str, size_t size, uint32_t seed)
+{
+    for (size_t i = 0; i < size - 1; ++i) {
+        str[i] = 'a' + (seed + i) % 26;
+    }
+    str[size - 1] = 0;
+}
+
+/* Fill about half of the partition with integers and strings */
+void generateImage(BenchmarkStorage& storage, size_t sectorCount, std::vector<BenchmarkKey>& keys, std::mt19937& gen)
+{
+    size_t keyCount = (sectorCount - 2) * Page::ENTRY_COUNT * 2 / 5;
+    keys.resize(keyCount);
+    for (uint32_t i = 0; i < keyCount; ++i) {
+        BenchmarkKey& key = keys[i];
+        key.nsIndex = 1 + i % NAMESPACE_COUNT;
+        snprintf(key.name, sizeof(key.name), "key%05u", static_cast<unsigned>(i));
+        key.isString = (gen() % 8 == 0);
+        if (key.isString) {
+            char str[41];
+            fillString(str, sizeof(str), i);
+            REQUIRE(storage.writeItem(key.nsIndex, ItemType::SZ, key.name, str, sizeof(str)) == ESP_OK);
+        } else {
+            REQUIRE(storage.writeItem(key.nsIndex, key.name, i) == ESP_OK);
+        }
+    }
+}
+
+void runBenchmark(size_t sectorCount)
+{
+    SpiFlashEmulator emu(sectorCount);
+    std::mt19937 gen(static_cast<uint32_t>(sectorCount));
+    std::vector<BenchmarkKey> keys;
+
+    printf("Partition of %u sectors\n", static_cast<unsigned>(sectorCount));
+    {
+        BenchmarkStorage storage;
+        REQUIRE(storage.init(0, sectorCount) == ESP_OK);
+        emu.clearStats();
+        generateImage(storage, sectorCount, keys, gen);
+        report("writeItem (new keys)", keys.size(), emu);
+    }
+
+    BenchmarkStorage storage;
+    emu.clearStats();
+    REQUIRE(storage.init(0, sectorCount) == ESP_OK);
+    report("Storage::init", 1, emu);
+
+    emu.clearStats();
+    for (const auto& key : keys) {
+        Page* page;
+        Item item;
+        ItemType type = key.isString ? ItemType::SZ : ItemType::U32;
+        REQUIRE(storage.findItem(key.nsIndex, type, key.name, page, item) == ESP_OK);
+    }
+    report("findItem (hit)", keys.size(), emu);
+
+    emu.clearStats();
+    for (const auto& key : keys) {
+        Page* page;
+        Item item;
+        REQUIRE(storage.findItem(key.nsIndex, ItemType::ANY, key.name, page, item) == ESP_OK);
+    }
+    report("findItem (hit, any type)", keys.size(), emu);
+
+    emu.clearStats();
+    for (size_t i = 0; i < keys.size(); ++i) {
+        char name[Item::MAX_KEY_LENGTH + 1];
+        snprintf(name, sizeof(name), "missing%05u", static_cast<unsigned>(i));
+        Page* page;
+        Item item;
+        REQUIRE(storage.findItem(keys[i].nsIndex, ItemType::U32, name, page, item) == ESP_ERR_NVS_NOT_FOUND);
+    }
+    report("findItem (miss)", keys.size(), emu);
+
+    emu.clearStats();
+    size_t readCount = 0;
+    for (uint32_t i = 0; i < keys.size(); i += 4) {
+        if (keys[i].isString) {
+            continue;
+        }
+        uint32_t value;
+        REQUIRE(storage.readItem(keys[i].nsIndex, keys[i].name, value) == ESP_OK);
+        CHECK(value == i);
+        ++readCount;
+    }
+    report("readItem (u32)", readCount, emu);
+
+    emu.clearStats();
+    size_t updateCount = 0;
+    for (uint32_t i = 0; i < keys.size(); i += 2) {
+        if (keys[i].isString) {
+            continue;
+        }
+        REQUIRE(storage.writeItem(keys[i].nsIndex, keys[i].name, i + 1) == ESP_OK);
+        ++updateCount;
+    }
+    report("writeItem (update)", updateCount, emu);
+
+    std::vector<uint8_t> blob(BLOB_SIZE);
+    emu.clearStats();
+    for (size_t i = 0; i < BLOB_COUNT; ++i) {
+        char name[Item::MAX_KEY_LENGTH + 1];
+        snprintf(name, sizeof(name), "blob%u", static_cast<unsigned>(i));
+        for (auto& b : blob) {
+            b = static_cast<uint8_t>(gen());
+        }
+        REQUIRE(storage.writeItem(1, ItemType::BLOB, name, blob.data(), blob.size()) == ESP_OK);
+    }
+    report("writeItem (6000 byte blob)", BLOB_COUNT, emu);
+
+    emu.clearStats();
+    for (size_t i = 0; i < BLOB_COUNT; ++i) {
+        char name[Item::MAX_KEY_LENGTH + 1];
+        snprintf(name, sizeof(name), "blob%u", static_cast<unsigned>(i));
+        REQUIRE(storage.readItem(1, ItemType::BLOB, name, blob.data(), blob.size()) == ESP_OK);
+    }
+    report("readItem (6000 byte blob)", BLOB_COUNT, emu);
+
+    BenchmarkStorage reloaded;
+    emu.clearStats();
+    REQUIRE(reloaded.init(0, sectorCount) == ESP_OK);
+    report("Storage::init (after use)", 1, emu);
+}
+
+} // namespace
+
+TEST_CASE("benchmark storage operations on large partitions", "[nvs][benchmark][long][.]")
+{
+    for (size_t sectorCount : {16, 64}) {
+        runBenchmark(sectorCount);
+    }
+}
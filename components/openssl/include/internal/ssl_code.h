@@ -32,6 +32,22 @@
 # define SSL_VERIFY_FAIL_IF_NO_PEER_CERT 0x02
 # define SSL_VERIFY_CLIENT_ONCE          0x04
 
+/* Used in SSL_CTX_set_session_cache_mode() */
+# define SSL_SESS_CACHE_OFF              0x0000
+# define SSL_SESS_CACHE_CLIENT           0x0001
+# define SSL_SESS_CACHE_SERVER           0x0002
+# define SSL_SESS_CACHE_BOTH             (SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_SERVER)
+/* Either flag disables the internal session ID cache, session tickets are still issued */
+# define SSL_SESS_CACHE_NO_INTERNAL_LOOKUP  0x0100
+# define SSL_SESS_CACHE_NO_INTERNAL_STORE   0x0200
+# define SSL_SESS_CACHE_NO_INTERNAL         (SSL_SESS_CACHE_NO_INTERNAL_LOOKUP | SSL_SESS_CACHE_NO_INTERNAL_STORE)
+
+# define SSL_SESSION_CACHE_MAX_SIZE_DEFAULT 8
+# define SSL_DEFAULT_SESSION_TIMEOUT     300
+
+/* Don't issue session tickets when the server session cache is enabled */
+# define SSL_OP_NO_TICKET                0x00004000L
+
 /*
  * The following 3 states are kept in ssl->rlayer.rstate when reads fail, you
  * should not need these
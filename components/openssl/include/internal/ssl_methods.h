@@ -31,7 +31,8 @@
                     set_fd, set_hostname, get_fd,	\
                     set_bufflen, \
                     get_verify_result, \
-                    get_state) \
+                    get_state, \
+                    ctx_free) \
         static const SSL_METHOD_FUNC func_name LOCAL_ATRR = { \
                 new, \
                 free, \
@@ -46,7 +47,8 @@
                 get_fd, \
                 set_bufflen, \
                 get_verify_result, \
-                get_state \
+                get_state, \
+                ctx_free \
         };
 
 #define IMPLEMENT_TLS_METHOD(ver, mode, fun, func_name) \
@@ -188,11 +188,23 @@ struct ssl_ctx_st
 
     long session_timeout;
 
+    int session_cache_mode;
+
+    long session_cache_size;
+
+    /* resumed handshakes, and sessions offered by the client but not found */
+    long sess_hits;
+
+    long sess_misses;
+
     int read_ahead;
 
     int read_buffer_len;
 
     X509_VERIFY_PARAM param;
+
+    /* SSL context platform private point, created on demand */
+    void *ssl_ctx_pm;
 };
 
 struct ssl_st
@@ -277,6 +289,8 @@ struct ssl_method_func_st {
     long (*ssl_get_verify_result)(const SSL *ssl);
 
     OSSL_HANDSHAKE_STATE (*ssl_get_state)(const SSL *ssl);
+
+    void (*ssl_ctx_free)(SSL_CTX *ctx);
 };
 
 struct x509_method_st {
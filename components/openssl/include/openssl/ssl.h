@@ -753,6 +753,67 @@ long SSL_CTX_set_timeout(SSL_CTX *ctx, long t);
  */
 long SSL_CTX_get_timeout(const SSL_CTX *ctx);
 
+/**
+ * @brief set the session cache mode, SSL_SESS_CACHE_SERVER makes the server
+ *        cache sessions and issue session tickets (unless SSL_OP_NO_TICKET is set)
+ *
+ * The mode must be set before the first SSL object of the context is created.
+ *
+ * @param ctx  - SSL context point
+ * @param mode - new session cache mode, default SSL_SESS_CACHE_OFF
+ *
+ * @return old session cache mode
+ */
+long SSL_CTX_set_session_cache_mode(SSL_CTX *ctx, long mode);
+
+/**
+ * @brief get the session cache mode
+ *
+ * @param ctx - SSL context point
+ *
+ * @return current session cache mode
+ */
+long SSL_CTX_get_session_cache_mode(const SSL_CTX *ctx);
+
+/**
+ * @brief set the maximum number of sessions in the session cache
+ *
+ * The size must be set before the first SSL object of the context is created.
+ *
+ * @param ctx - SSL context point
+ * @param t   - new maximum number of sessions, default SSL_SESSION_CACHE_MAX_SIZE_DEFAULT
+ *
+ * @return old maximum number of sessions
+ */
+long SSL_CTX_sess_set_cache_size(SSL_CTX *ctx, long t);
+
+/**
+ * @brief get the maximum number of sessions in the session cache
+ *
+ * @param ctx - SSL context point
+ *
+ * @return current maximum number of sessions
+ */
+long SSL_CTX_sess_get_cache_size(const SSL_CTX *ctx);
+
+/**
+ * @brief get the number of sessions resumed from the session cache or a session ticket
+ *
+ * @param ctx - SSL context point
+ *
+ * @return number of resumed sessions
+ */
+long SSL_CTX_sess_hits(const SSL_CTX *ctx);
+
+/**
+ * @brief get the number of sessions offered by clients which couldn't be resumed
+ *
+ * @param ctx - SSL context point
+ *
+ * @return number of sessions not found or expired
+ */
+long SSL_CTX_sess_misses(const SSL_CTX *ctx);
+
 /**
  * @brief set the SSL context cipher through the list string
  *
@@ -43,6 +43,8 @@ void ssl_pm_set_hostname(SSL *ssl, const char *hostname);
 
 OSSL_HANDSHAKE_STATE ssl_pm_get_state(const SSL *ssl);
 
+void ssl_pm_ctx_free(SSL_CTX *ctx);
+
 void ssl_pm_set_bufflen(SSL *ssl, int len);
 
 int x509_pm_show_info(X509 *x);
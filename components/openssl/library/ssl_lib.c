@@ -203,6 +203,8 @@ SSL_CTX* SSL_CTX_new(const SSL_METHOD *method)
 
     ctx->version = method->version;
 
+    ctx->session_cache_size = SSL_SESSION_CACHE_MAX_SIZE_DEFAULT;
+
     return ctx;
 
 failed3:
@@ -220,6 +222,8 @@ void SSL_CTX_free(SSL_CTX* ctx)
 {
     SSL_ASSERT3(ctx);
 
+    SSL_METHOD_CALL(ctx_free, ctx);
+
     ssl_cert_free(ctx->cert);
 
     X509_free(ctx->client_CA);
@@ -1426,6 +1430,76 @@ long SSL_CTX_get_timeout(const SSL_CTX *ctx)
     return ctx->session_timeout;
 }
 
+/**
+ * @brief set the SSL context session cache mode
+ */
+long SSL_CTX_set_session_cache_mode(SSL_CTX *ctx, long mode)
+{
+    long l;
+
+    SSL_ASSERT1(ctx);
+
+    l = ctx->session_cache_mode;
+    ctx->session_cache_mode = mode;
+
+    return l;
+}
+
+/**
+ * @brief get the SSL context session cache mode
+ */
+long SSL_CTX_get_session_cache_mode(const SSL_CTX *ctx)
+{
+    SSL_ASSERT1(ctx);
+
+    return ctx->session_cache_mode;
+}
+
+/**
+ * @brief set the maximum number of sessions in the SSL context session cache
+ */
+long SSL_CTX_sess_set_cache_size(SSL_CTX *ctx, long t)
+{
+    long l;
+
+    SSL_ASSERT1(ctx);
+
+    l = ctx->session_cache_size;
+    ctx->session_cache_size = t;
+
+    return l;
+}
+
+/**
+ * @brief get the maximum number of sessions in the SSL context session cache
+ */
+long SSL_CTX_sess_get_cache_size(const SSL_CTX *ctx)
+{
+    SSL_ASSERT1(ctx);
+
+    return ctx->session_cache_size;
+}
+
+/**
+ * @brief get the number of resumed sessions
+ */
+long SSL_CTX_sess_hits(const SSL_CTX *ctx)
+{
+    SSL_ASSERT1(ctx);
+
+    return ctx->sess_hits;
+}
+
+/**
+ * @brief get the number of sessions offered by clients which couldn't be resumed
+ */
+long SSL_CTX_sess_misses(const SSL_CTX *ctx)
+{
+    SSL_ASSERT1(ctx);
+
+    return ctx->sess_misses;
+}
+
 /**
  * @brief set the SSL if we can read as many as data
  */
@@ -25,7 +25,8 @@ IMPLEMENT_TLS_METHOD_FUNC(TLS_method_func,
         ssl_pm_set_fd, ssl_pm_set_hostname, ssl_pm_get_fd,
         ssl_pm_set_bufflen,
         ssl_pm_get_verify_result,
-        ssl_pm_get_state);
+        ssl_pm_get_state,
+        ssl_pm_ctx_free);
 
 /**
  * TLS or SSL client method collection
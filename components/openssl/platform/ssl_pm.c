@@ -24,9 +24,15 @@
 #include "mbedtls/ctr_drbg.h"
 #include "mbedtls/error.h"
 #include "mbedtls/certs.h"
+#include "mbedtls/ssl_cache.h"
+#include "mbedtls/ssl_ticket.h"
 
 #define X509_INFO_STRING_LENGTH 8192
 
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_TICKET_C)
+#define SSL_PM_SESSION_TICKETS
+#endif
+
 struct ssl_pm
 {
     /* local socket file description */
@@ -43,6 +49,24 @@ struct ssl_pm
     mbedtls_entropy_context entropy;
 };
 
+struct ssl_ctx_pm
+{
+    SSL_CTX *ctx;
+
+    /* server side session ID cache, shared by all SSL objects of the context */
+    mbedtls_ssl_cache_context cache;
+
+#ifdef SSL_PM_SESSION_TICKETS
+    int ticket_enabled;
+
+    mbedtls_ssl_ticket_context ticket;
+
+    mbedtls_ctr_drbg_context ctr_drbg;
+
+    mbedtls_entropy_context entropy;
+#endif
+};
+
 struct x509_pm
 {
     mbedtls_x509_crt *x509_crt;
@@ -87,6 +111,126 @@ static void ssl_platform_debug(void *ctx, int level,
 }
 #endif
 
+static int ssl_pm_cache_get(void *data, mbedtls_ssl_session *session)
+{
+    struct ssl_ctx_pm *ctx_pm = (struct ssl_ctx_pm *)data;
+    int ret;
+
+    ret = mbedtls_ssl_cache_get(&ctx_pm->cache, session);
+    if (ret)
+        ctx_pm->ctx->sess_misses++;
+    else
+        ctx_pm->ctx->sess_hits++;
+
+    return ret;
+}
+
+static int ssl_pm_cache_set(void *data, const mbedtls_ssl_session *session)
+{
+    struct ssl_ctx_pm *ctx_pm = (struct ssl_ctx_pm *)data;
+
+    return mbedtls_ssl_cache_set(&ctx_pm->cache, session);
+}
+
+#ifdef SSL_PM_SESSION_TICKETS
+static int ssl_pm_ticket_write(void *p_ticket, const mbedtls_ssl_session *session,
+                               unsigned char *start, const unsigned char *end,
+                               size_t *tlen, uint32_t *lifetime)
+{
+    struct ssl_ctx_pm *ctx_pm = (struct ssl_ctx_pm *)p_ticket;
+
+    return mbedtls_ssl_ticket_write(&ctx_pm->ticket, session, start, end, tlen, lifetime);
+}
+
+static int ssl_pm_ticket_parse(void *p_ticket, mbedtls_ssl_session *session,
+                               unsigned char *buf, size_t len)
+{
+    struct ssl_ctx_pm *ctx_pm = (struct ssl_ctx_pm *)p_ticket;
+    int ret;
+
+    ret = mbedtls_ssl_ticket_parse(&ctx_pm->ticket, session, buf, len);
+    if (ret)
+        ctx_pm->ctx->sess_misses++;
+    else
+        ctx_pm->ctx->sess_hits++;
+
+    return ret;
+}
+#endif
+
+/**
+ * @brief get the SSL context low-level object, creating it on first use
+ */
+static struct ssl_ctx_pm *ssl_pm_ctx_get(SSL_CTX *ctx)
+{
+    struct ssl_ctx_pm *ctx_pm = (struct ssl_ctx_pm *)ctx->ssl_ctx_pm;
+    long timeout;
+
+    if (ctx_pm)
+        return ctx_pm;
+
+    ctx_pm = ssl_mem_zalloc(sizeof(struct ssl_ctx_pm));
+    if (!ctx_pm) {
+        SSL_DEBUG(SSL_PLATFORM_ERROR_LEVEL, "no enough memory > (ctx_pm)");
+        return NULL;
+    }
+    ctx_pm->ctx = ctx;
+
+    timeout = ctx->session_timeout > 0 ? ctx->session_timeout : SSL_DEFAULT_SESSION_TIMEOUT;
+
+    mbedtls_ssl_cache_init(&ctx_pm->cache);
+    mbedtls_ssl_cache_set_timeout(&ctx_pm->cache, timeout);
+    mbedtls_ssl_cache_set_max_entries(&ctx_pm->cache, ctx->session_cache_size);
+
+#ifdef SSL_PM_SESSION_TICKETS
+    mbedtls_ssl_ticket_init(&ctx_pm->ticket);
+    mbedtls_ctr_drbg_init(&ctx_pm->ctr_drbg);
+    mbedtls_entropy_init(&ctx_pm->entropy);
+
+    if (!(ctx->options & SSL_OP_NO_TICKET)) {
+        const unsigned char pers[] = "OpenSSL PM ticket";
+        int ret;
+
+        ret = mbedtls_ctr_drbg_seed(&ctx_pm->ctr_drbg, mbedtls_entropy_func, &ctx_pm->entropy, pers, sizeof(pers));
+        if (!ret) {
+            ret = mbedtls_ssl_ticket_setup(&ctx_pm->ticket, mbedtls_ctr_drbg_random, &ctx_pm->ctr_drbg,
+                                           MBEDTLS_CIPHER_AES_256_GCM, timeout);
+        }
+        if (ret) {
+            /* resumption through the session ID cache still works */
+            SSL_DEBUG(SSL_PLATFORM_ERROR_LEVEL, "mbedtls_ssl_ticket_setup() return -0x%x", -ret);
+        } else {
+            ctx_pm->ticket_enabled = 1;
+        }
+    }
+#endif
+
+    ctx->ssl_ctx_pm = ctx_pm;
+
+    return ctx_pm;
+}
+
+/**
+ * @brief free SSL context low-level object
+ */
+void ssl_pm_ctx_free(SSL_CTX *ctx)
+{
+    struct ssl_ctx_pm *ctx_pm = (struct ssl_ctx_pm *)ctx->ssl_ctx_pm;
+
+    if (!ctx_pm)
+        return;
+
+    mbedtls_ssl_cache_free(&ctx_pm->cache);
+#ifdef SSL_PM_SESSION_TICKETS
+    mbedtls_ssl_ticket_free(&ctx_pm->ticket);
+    mbedtls_ctr_drbg_free(&ctx_pm->ctr_drbg);
+    mbedtls_entropy_free(&ctx_pm->entropy);
+#endif
+
+    ssl_mem_free(ctx_pm);
+    ctx->ssl_ctx_pm = NULL;
+}
+
 /**
  * @brief create SSL low-level object
  */
@@ -162,6 +306,19 @@ int ssl_pm_new(SSL *ssl)
     }
     mbedtls_ssl_conf_rng(&ssl_pm->conf, mbedtls_ctr_drbg_random, &ssl_pm->ctr_drbg);
 
+    if (endpoint == MBEDTLS_SSL_IS_SERVER && (ssl->ctx->session_cache_mode & SSL_SESS_CACHE_SERVER)) {
+        struct ssl_ctx_pm *ctx_pm = ssl_pm_ctx_get(ssl->ctx);
+        if (!ctx_pm)
+            goto mbedtls_err2;
+
+        if (!(ssl->ctx->session_cache_mode & SSL_SESS_CACHE_NO_INTERNAL))
+            mbedtls_ssl_conf_session_cache(&ssl_pm->conf, ctx_pm, ssl_pm_cache_get, ssl_pm_cache_set);
+#ifdef SSL_PM_SESSION_TICKETS
+        if (ctx_pm->ticket_enabled)
+            mbedtls_ssl_conf_session_tickets_cb(&ssl_pm->conf, ssl_pm_ticket_write, ssl_pm_ticket_parse, ctx_pm);
+#endif
+    }
+
 #ifdef CONFIG_OPENSSL_LOWLEVEL_DEBUG
     mbedtls_debug_set_threshold(MBEDTLS_DEBUG_LEVEL);
     mbedtls_ssl_conf_dbg(&ssl_pm->conf, ssl_platform_debug, NULL);
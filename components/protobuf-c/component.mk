@@ -1,8 +1,8 @@
 #
 # Component Makefile
 #
-COMPONENT_ADD_INCLUDEDIRS := protobuf-c
+COMPONENT_ADD_INCLUDEDIRS := protobuf-c port/include
 
-COMPONENT_SRCDIRS := protobuf-c/protobuf-c
+COMPONENT_SRCDIRS := protobuf-c/protobuf-c port
 
 COMPONENT_SUBMODULES += protobuf-c
@@ -0,0 +1,107 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "esp_protobuf_arena.h"
+
+#define ARENA_ALIGN_UP(x)       (((x) + ESP_PROTOBUF_ARENA_ALIGN - 1) & ~(size_t)(ESP_PROTOBUF_ARENA_ALIGN - 1))
+
+/* Header in front of an allocation which did not fit in the buffer */
+typedef struct esp_protobuf_arena_heap_block {
+    struct esp_protobuf_arena_heap_block *next;
+} arena_heap_block_t;
+
+#define ARENA_HEAP_HDR_SIZE     ARENA_ALIGN_UP(sizeof(arena_heap_block_t))
+
+static void *arena_allocator_alloc(void *allocator_data, size_t size)
+{
+    return esp_protobuf_arena_alloc((esp_protobuf_arena_t *) allocator_data, size);
+}
+
+/* Everything is freed by esp_protobuf_arena_release() */
+static void arena_allocator_free(void *allocator_data, void *ptr)
+{
+}
+
+void esp_protobuf_arena_init(esp_protobuf_arena_t *arena, void *buf, size_t size)
+{
+    arena->allocator.alloc = arena_allocator_alloc;
+    arena->allocator.free = arena_allocator_free;
+    arena->allocator.allocator_data = arena;
+    arena->buf = buf;
+    arena->size = buf ? size : 0;
+    arena->used = 0;
+    arena->heap_blocks = NULL;
+    arena->heap_allocs = 0;
+}
+
+void *esp_protobuf_arena_alloc(esp_protobuf_arena_t *arena, size_t size)
+{
+    size_t need = ARENA_ALIGN_UP(size);
+    if (need >= size && arena->size - arena->used >= need) {
+        void *ptr = arena->buf + arena->used;
+        arena->used += need;
+        return ptr;
+    }
+
+    if (size > SIZE_MAX - ARENA_HEAP_HDR_SIZE) {
+        return NULL;
+    }
+    arena_heap_block_t *block = malloc(ARENA_HEAP_HDR_SIZE + size);
+    if (!block) {
+        return NULL;
+    }
+    block->next = arena->heap_blocks;
+    arena->heap_blocks = block;
+    arena->heap_allocs++;
+    return (uint8_t *) block + ARENA_HEAP_HDR_SIZE;
+}
+
+void esp_protobuf_arena_release(esp_protobuf_arena_t *arena)
+{
+    while (arena->heap_blocks) {
+        arena_heap_block_t *next = arena->heap_blocks->next;
+        free(arena->heap_blocks);
+        arena->heap_blocks = next;
+    }
+    arena->used = 0;
+}
+
+esp_err_t esp_protobuf_pack_to_buffer(const ProtobufCMessage *message, uint8_t *buf, size_t size, size_t *outlen)
+{
+    *outlen = protobuf_c_message_get_packed_size(message);
+    if (*outlen > size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    protobuf_c_message_pack(message, buf);
+    return ESP_OK;
+}
+
+esp_err_t esp_protobuf_pack_alloc(const ProtobufCMessage *message, uint8_t **outbuf, ssize_t *outlen)
+{
+    size_t len = protobuf_c_message_get_packed_size(message);
+    *outbuf = NULL;
+    *outlen = 0;
+    if (len == 0) {
+        return ESP_OK;
+    }
+    *outbuf = (uint8_t *) malloc(len);
+    if (!*outbuf) {
+        return ESP_ERR_NO_MEM;
+    }
+    protobuf_c_message_pack(message, *outbuf);
+    *outlen = len;
+    return ESP_OK;
+}
@@ -0,0 +1,127 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "esp_err.h"
+#include <protobuf-c/protobuf-c.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file esp_protobuf_arena.h
+ * @brief Arena allocator for protobuf-c messages
+ *
+ * With the default allocator, unpacking a message calls malloc() for the message,
+ * every sub-message, string and bytes field. An arena serves these allocations
+ * from a buffer owned by the caller, typically on the stack of a request handler,
+ * and releases them all at once. Allocations which do not fit in the buffer are
+ * taken from the heap and freed when the arena is released.
+ *
+ * Typical usage:
+ *
+ * @code{c}
+ * uint8_t arena_buf[256] __attribute__((aligned(8)));
+ * esp_protobuf_arena_t arena;
+ * esp_protobuf_arena_init(&arena, arena_buf, sizeof(arena_buf));
+ * SessionData *req = session_data__unpack(&arena.allocator, inlen, inbuf);
+ * // handle req, response sub-messages may be allocated with esp_protobuf_arena_alloc()
+ * esp_protobuf_arena_release(&arena);  // instead of session_data__free_unpacked()
+ * @endcode
+ *
+ * The free function of the allocator does nothing, so calling *_free_unpacked()
+ * with the arena allocator is not needed. An arena is not thread safe.
+ */
+
+/** Alignment of the blocks allocated from an arena */
+#define ESP_PROTOBUF_ARENA_ALIGN    8
+
+/** Arena, the fields other than allocator are private */
+typedef struct {
+    ProtobufCAllocator allocator;   /*!< Allocator to pass to *_unpack() */
+    uint8_t *buf;
+    size_t size;
+    size_t used;
+    struct esp_protobuf_arena_heap_block *heap_blocks;
+    size_t heap_allocs;             /*!< Number of allocations taken from the heap since the arena was initialized */
+} esp_protobuf_arena_t;
+
+/**
+ * @brief Initialize an arena
+ *
+ * @param arena Arena
+ * @param buf Buffer to allocate from, aligned to ESP_PROTOBUF_ARENA_ALIGN bytes. May be NULL,
+ *            then all allocations are taken from the heap.
+ * @param size Size of the buffer
+ */
+void esp_protobuf_arena_init(esp_protobuf_arena_t *arena, void *buf, size_t size);
+
+/**
+ * @brief Allocate memory from an arena
+ *
+ * @param arena Arena
+ * @param size Number of bytes
+ *
+ * @return Memory aligned to ESP_PROTOBUF_ARENA_ALIGN bytes, valid until the arena is
+ *         released, or NULL if it does not fit in the buffer and heap allocation failed
+ */
+void *esp_protobuf_arena_alloc(esp_protobuf_arena_t *arena, size_t size);
+
+/**
+ * @brief Release all memory allocated from an arena
+ *
+ * Heap allocations are freed and the buffer is empty again, the arena may be reused.
+ *
+ * @param arena Arena
+ */
+void esp_protobuf_arena_release(esp_protobuf_arena_t *arena);
+
+/**
+ * @brief Pack a message into a buffer provided by the caller
+ *
+ * @param message Message
+ * @param buf Buffer
+ * @param size Size of the buffer
+ * @param[out] outlen Packed length of the message
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_SIZE The buffer is smaller than the packed message, outlen is set to the required size
+ */
+esp_err_t esp_protobuf_pack_to_buffer(const ProtobufCMessage *message, uint8_t *buf, size_t size, size_t *outlen);
+
+/**
+ * @brief Pack a message into an allocated buffer of its packed size
+ *
+ * This is the response convention of protocomm request handlers: the buffer is
+ * returned to the caller, which frees it with free().
+ *
+ * @param message Message
+ * @param[out] outbuf Allocated buffer, NULL if the message packs to zero bytes
+ * @param[out] outlen Packed length of the message
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_NO_MEM Allocation failed
+ */
+esp_err_t esp_protobuf_pack_alloc(const ProtobufCMessage *message, uint8_t **outbuf, ssize_t *outlen);
+
+#ifdef __cplusplus
+}
+#endif
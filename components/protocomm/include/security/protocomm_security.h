@@ -82,14 +82,18 @@ typedef struct protocomm_security {
                                       void *priv_data);
 
     /**
-     * Function which implements the encryption algorithm
+     * Function which implements the encryption algorithm.
+     * May be called with outbuf equal to inbuf, to process data in place,
+     * so the output must not be longer than the input
      */
     esp_err_t (*encrypt)(uint32_t session_id,
                          const uint8_t *inbuf, ssize_t inlen,
                          uint8_t *outbuf, ssize_t *outlen);
 
     /**
-     * Function which implements the decryption algorithm
+     * Function which implements the decryption algorithm.
+     * May be called with outbuf equal to inbuf, to process data in place,
+     * so the output must not be longer than the input
      */
     esp_err_t (*decrypt)(uint32_t session_id,
                          const uint8_t *inbuf, ssize_t inlen,
@@ -149,9 +149,12 @@ esp_err_t protocomm_remove_endpoint(protocomm_t *pc, const char *ep_name)
     return ESP_ERR_NOT_FOUND;
 }
 
-esp_err_t protocomm_req_handle(protocomm_t *pc, const char *ep_name, uint32_t session_id,
-                               const uint8_t *inbuf, ssize_t inlen,
-                               uint8_t **outbuf, ssize_t *outlen)
+/* Calls the endpoint handler. Encrypted requests are decrypted into decbuf,
+ * which may be the same as inbuf, or into an internal buffer if it is NULL.
+ * Responses are encrypted in the buffer returned by the handler. */
+static esp_err_t protocomm_req_handle_internal(protocomm_t *pc, const char *ep_name, uint32_t session_id,
+                                               const uint8_t *inbuf, uint8_t *decbuf, ssize_t inlen,
+                                               uint8_t **outbuf, ssize_t *outlen)
 {
     if (!pc || !ep_name || !outbuf || !outlen) {
         ESP_LOGE(TAG, "Invalid params %p %p", pc, ep_name);
@@ -175,17 +178,22 @@ esp_err_t protocomm_req_handle(protocomm_t *pc, const char *ep_name, uint32_t se
     } else if (ep->flag & REQ_EP) {
         if (pc->sec && pc->sec->decrypt) {
             /* Decrypt the data first */
-            uint8_t *dec_inbuf = (uint8_t *) malloc(inlen);
+            uint8_t *dec_inbuf = decbuf;
             if (!dec_inbuf) {
-                ESP_LOGE(TAG, "Failed to allocate decrypt buf len %d", inlen);
-                return ESP_ERR_NO_MEM;
+                dec_inbuf = (uint8_t *) malloc(inlen);
+                if (!dec_inbuf) {
+                    ESP_LOGE(TAG, "Failed to allocate decrypt buf len %d", inlen);
+                    return ESP_ERR_NO_MEM;
+                }
             }
 
             ssize_t dec_inbuf_len = inlen;
             ret = pc->sec->decrypt(session_id, inbuf, inlen, dec_inbuf, &dec_inbuf_len);
             if (ret != ESP_OK) {
                 ESP_LOGE(TAG, "Decryption of response failed for endpoint %s", ep_name);
-                free(dec_inbuf);
+                if (dec_inbuf != decbuf) {
+                    free(dec_inbuf);
+                }
                 return ret;
             }
 
@@ -196,39 +204,29 @@ esp_err_t protocomm_req_handle(protocomm_t *pc, const char *ep_name, uint32_t se
                                   dec_inbuf, dec_inbuf_len,
                                   &plaintext_resp, &plaintext_resp_len,
                                   ep->priv_data);
+            /* We don't need decrypted data anymore */
+            if (dec_inbuf != decbuf) {
+                free(dec_inbuf);
+            }
             if (ret != ESP_OK) {
                 ESP_LOGE(TAG, "Request handler for %s failed", ep_name);
                 free(plaintext_resp);
-                free(dec_inbuf);
                 return ret;
             }
-            /* We don't need decrypted data anymore */
-            free(dec_inbuf);
-
-            /* Encrypt response to be sent back */
-            uint8_t *enc_resp = (uint8_t *) malloc(plaintext_resp_len);
-            if (!enc_resp) {
-                ESP_LOGE(TAG, "Failed to allocate decrypt buf len %d", inlen);
-                free(plaintext_resp);
-                return ESP_ERR_NO_MEM;
-            }
 
+            /* Encrypt response to be sent back, in place */
             ssize_t enc_resp_len = plaintext_resp_len;
             ret = pc->sec->encrypt(session_id, plaintext_resp, plaintext_resp_len,
-                                   enc_resp, &enc_resp_len);
+                                   plaintext_resp, &enc_resp_len);
 
             if (ret != ESP_OK) {
                 ESP_LOGE(TAG, "Encryption of response failed for endpoint %s", ep_name);
-                free(enc_resp);
                 free(plaintext_resp);
                 return ret;
             }
 
-            /* We no more need plaintext response */
-            free(plaintext_resp);
-
             /* Set outbuf and outlen appropriately */
-            *outbuf = enc_resp;
+            *outbuf = plaintext_resp;
             *outlen = enc_resp_len;
         } else {
             /* No encryption */
@@ -245,6 +243,20 @@ esp_err_t protocomm_req_handle(protocomm_t *pc, const char *ep_name, uint32_t se
     return ret;
 }
 
+esp_err_t protocomm_req_handle(protocomm_t *pc, const char *ep_name, uint32_t session_id,
+                               const uint8_t *inbuf, ssize_t inlen,
+                               uint8_t **outbuf, ssize_t *outlen)
+{
+    return protocomm_req_handle_internal(pc, ep_name, session_id, inbuf, NULL, inlen, outbuf, outlen);
+}
+
+esp_err_t protocomm_req_handle_inplace(protocomm_t *pc, const char *ep_name, uint32_t session_id,
+                                       uint8_t *buf, ssize_t len,
+                                       uint8_t **outbuf, ssize_t *outlen)
+{
+    return protocomm_req_handle_internal(pc, ep_name, session_id, buf, buf, len, outbuf, outlen);
+}
+
 static int protocomm_common_security_handler(uint32_t session_id,
                                              const uint8_t *inbuf, ssize_t inlen,
                                              uint8_t **outbuf, ssize_t *outlen,
@@ -77,3 +77,24 @@ struct protocomm {
     /* Application specific version string */
     const char* ver;
 };
+
+/**
+ * @brief   Same as protocomm_req_handle(), but decrypts the request in place
+ *
+ * For transports which own the buffer of the received request and don't
+ * need its content after the call. This saves allocating and filling a
+ * separate buffer for the decrypted request.
+ *
+ * @param[in]    pc         Pointer to the protocomm instance
+ * @param[in]    ep_name    Endpoint identifier(name) string
+ * @param[in]    session_id Unique ID for a communication session
+ * @param[inout] buf        Buffer with the request, overwritten by the handling
+ * @param[in]    len        Length of the request
+ * @param[out]   outbuf     Pointer to internally allocated output buffer
+ * @param[out]   outlen     Buffer length of the allocated output buffer
+ *
+ * @return  Same as for protocomm_req_handle()
+ */
+esp_err_t protocomm_req_handle_inplace(protocomm_t *pc, const char *ep_name, uint32_t session_id,
+                                       uint8_t *buf, ssize_t len,
+                                       uint8_t **outbuf, ssize_t *outlen);
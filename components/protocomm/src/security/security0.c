@@ -25,19 +25,22 @@
 #include "session.pb-c.h"
 #include "sec0.pb-c.h"
 #include "constants.pb-c.h"
+#include "esp_protobuf_arena.h"
 
 static const char* TAG = "security0";
 
+/* Request and response messages are allocated from this arena on the stack */
+#define SEC0_ARENA_SIZE     128
+
 static esp_err_t sec0_session_setup(uint32_t session_id,
                                     SessionData *req, SessionData *resp,
-                                    const protocomm_security_pop_t *pop)
+                                    const protocomm_security_pop_t *pop,
+                                    esp_protobuf_arena_t *arena)
 {
-    Sec0Payload *out = (Sec0Payload *) malloc(sizeof(Sec0Payload));
-    S0SessionResp *s0resp = (S0SessionResp *) malloc(sizeof(S0SessionResp));
+    Sec0Payload *out = (Sec0Payload *) esp_protobuf_arena_alloc(arena, sizeof(Sec0Payload));
+    S0SessionResp *s0resp = (S0SessionResp *) esp_protobuf_arena_alloc(arena, sizeof(S0SessionResp));
     if (!out || !s0resp) {
         ESP_LOGE(TAG, "Error allocating response");
-        free(out);
-        free(s0resp);
         return ESP_ERR_NO_MEM;
     }
     sec0_payload__init(out);
@@ -54,58 +57,47 @@ static esp_err_t sec0_session_setup(uint32_t session_id,
     return ESP_OK;
 }
 
-static void sec0_session_setup_cleanup(uint32_t session_id, SessionData *resp)
-{
-    if (!resp) {
-        return;
-    }
-
-    free(resp->sec0->sr);
-    free(resp->sec0);
-    return;
-}
-
 static esp_err_t sec0_req_handler(const protocomm_security_pop_t *pop, uint32_t session_id,
                                   const uint8_t *inbuf, ssize_t inlen,
                                   uint8_t **outbuf, ssize_t *outlen,
                                   void *priv_data)
 {
+    uint8_t arena_buf[SEC0_ARENA_SIZE] __attribute__((aligned(ESP_PROTOBUF_ARENA_ALIGN)));
+    esp_protobuf_arena_t arena;
     SessionData *req;
     SessionData resp;
     esp_err_t ret;
 
-    req = session_data__unpack(NULL, inlen, inbuf);
+    esp_protobuf_arena_init(&arena, arena_buf, sizeof(arena_buf));
+    req = session_data__unpack(&arena.allocator, inlen, inbuf);
     if (!req) {
         ESP_LOGE(TAG, "Unable to unpack setup_req");
-        return ESP_ERR_INVALID_ARG;
+        ret = ESP_ERR_INVALID_ARG;
+        goto exit;
     }
     if (req->sec_ver != protocomm_security0.ver) {
         ESP_LOGE(TAG, "Security version mismatch. Closing connection");
-        session_data__free_unpacked(req, NULL);
-        return ESP_ERR_INVALID_ARG;
+        ret = ESP_ERR_INVALID_ARG;
+        goto exit;
     }
 
     session_data__init(&resp);
-    ret = sec0_session_setup(session_id, req, &resp, pop);
+    ret = sec0_session_setup(session_id, req, &resp, pop, &arena);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Session setup error %d", ret);
-        session_data__free_unpacked(req, NULL);
-        return ESP_FAIL;
+        ret = ESP_FAIL;
+        goto exit;
     }
 
     resp.sec_ver = req->sec_ver;
-    session_data__free_unpacked(req, NULL);
-
-    *outlen = session_data__get_packed_size(&resp);
-    *outbuf = (uint8_t *) malloc(*outlen);
-    if (!*outbuf) {
+    ret = esp_protobuf_pack_alloc(&resp.base, outbuf, outlen);
+    if (ret != ESP_OK) {
         ESP_LOGE(TAG, "System out of memory");
-        return ESP_ERR_NO_MEM;
     }
-    session_data__pack(&resp, *outbuf);
 
-    sec0_session_setup_cleanup(session_id, &resp);
-    return ESP_OK;
+exit:
+    esp_protobuf_arena_release(&arena);
+    return ret;
 }
 
 const protocomm_security_t protocomm_security0 = {
@@ -32,12 +32,16 @@
 #include "session.pb-c.h"
 #include "sec1.pb-c.h"
 #include "constants.pb-c.h"
+#include "esp_protobuf_arena.h"
 
 static const char* TAG = "security1";
 
 #define PUBLIC_KEY_LEN  32
 #define SZ_RANDOM       16
 
+/* Request and response messages are allocated from this arena on the stack */
+#define SEC1_ARENA_SIZE 256
+
 #define SESSION_STATE_CMD0  0 /* Session is not setup */
 #define SESSION_STATE_CMD1  1 /* Session is not setup */
 #define SESSION_STATE_DONE  2 /* Session setup successful */
@@ -59,6 +63,14 @@ typedef struct session {
 
 static session_t *cur_session;
 
+/* Random number generator for all sessions, seeded once in sec1_init() */
+typedef struct {
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context ctr_drbg;
+} sec1_rng_t;
+
+static sec1_rng_t *sec1_rng;
+
 static void flip_endian(uint8_t *data, size_t len)
 {
     uint8_t swp_buf;
@@ -76,7 +88,8 @@ static void hexdump(const char *msg, uint8_t *buf, int len)
 }
 
 static esp_err_t handle_session_command1(uint32_t session_id,
-                                         SessionData *req, SessionData *resp)
+                                         SessionData *req, SessionData *resp,
+                                         esp_protobuf_arena_t *arena)
 {
     ESP_LOGD(TAG, "Request to handle setup1_command");
     Sec1Payload *in = (Sec1Payload *) req->sec1;
@@ -124,12 +137,11 @@ static esp_err_t handle_session_command1(uint32_t session_id,
         return ESP_FAIL;
     }
 
-    Sec1Payload *out = (Sec1Payload *) malloc(sizeof(Sec1Payload));
-    SessionResp1 *out_resp = (SessionResp1 *) malloc(sizeof(SessionResp1));
-    if (!out || !out_resp) {
+    Sec1Payload *out = (Sec1Payload *) esp_protobuf_arena_alloc(arena, sizeof(Sec1Payload));
+    SessionResp1 *out_resp = (SessionResp1 *) esp_protobuf_arena_alloc(arena, sizeof(SessionResp1));
+    uint8_t *outbuf = (uint8_t *) esp_protobuf_arena_alloc(arena, PUBLIC_KEY_LEN);
+    if (!out || !out_resp || !outbuf) {
         ESP_LOGE(TAG, "Error allocating memory for response1");
-        free(out);
-        free(out_resp);
         mbedtls_aes_free(&cur_session->ctx_aes);
         return ESP_ERR_NO_MEM;
     }
@@ -138,24 +150,12 @@ static esp_err_t handle_session_command1(uint32_t session_id,
     session_resp1__init(out_resp);
     out_resp->status = STATUS__Success;
 
-    uint8_t *outbuf = (uint8_t *) malloc(PUBLIC_KEY_LEN);
-    if (!outbuf) {
-        ESP_LOGE(TAG, "Error allocating ciphertext buffer");
-        free(out);
-        free(out_resp);
-        mbedtls_aes_free(&cur_session->ctx_aes);
-        return ESP_ERR_NO_MEM;
-    }
-
     mbed_err = mbedtls_aes_crypt_ctr(&cur_session->ctx_aes,
                                      PUBLIC_KEY_LEN, &cur_session->nc_off,
                                      cur_session->rand, cur_session->stb,
                                      cur_session->client_pubkey, outbuf);
     if (mbed_err != 0) {
         ESP_LOGE(TAG, "Failure at mbedtls_aes_crypt_ctr with error code : -0x%x", -mbed_err);
-        free(outbuf);
-        free(out);
-        free(out_resp);
         mbedtls_aes_free(&cur_session->ctx_aes);
         return ESP_FAIL;
     }
@@ -178,13 +178,20 @@ static esp_err_t handle_session_command1(uint32_t session_id,
 
 static esp_err_t handle_session_command0(uint32_t session_id,
                                          SessionData *req, SessionData *resp,
-                                         const protocomm_security_pop_t *pop)
+                                         const protocomm_security_pop_t *pop,
+                                         esp_protobuf_arena_t *arena)
 {
     ESP_LOGD(TAG, "Request to handle setup0_command");
     Sec1Payload *in = (Sec1Payload *) req->sec1;
     esp_err_t ret;
     int mbed_err;
 
+    if (!sec1_rng) {
+        ESP_LOGE(TAG, "Security not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+    mbedtls_ctr_drbg_context *ctr_drbg = &sec1_rng->ctr_drbg;
+
     if (cur_session->state != SESSION_STATE_CMD0) {
         ESP_LOGE(TAG, "Invalid state of session %d (expected %d)", SESSION_STATE_CMD0, cur_session->state);
         return ESP_ERR_INVALID_STATE;
@@ -195,28 +202,13 @@ static esp_err_t handle_session_command0(uint32_t session_id,
         return ESP_ERR_INVALID_ARG;
     }
 
-    mbedtls_ecdh_context     *ctx_server = malloc(sizeof(mbedtls_ecdh_context));
-    mbedtls_entropy_context  *entropy    = malloc(sizeof(mbedtls_entropy_context));
-    mbedtls_ctr_drbg_context *ctr_drbg   = malloc(sizeof(mbedtls_ctr_drbg_context));
-    if (!ctx_server || !ctx_server || !ctr_drbg) {
+    mbedtls_ecdh_context *ctx_server = malloc(sizeof(mbedtls_ecdh_context));
+    if (!ctx_server) {
         ESP_LOGE(TAG, "Failed to allocate memory for mbedtls context");
-        free(ctx_server);
-        free(entropy);
-        free(ctr_drbg);
         return ESP_ERR_NO_MEM;
     }
 
     mbedtls_ecdh_init(ctx_server);
-    mbedtls_ctr_drbg_init(ctr_drbg);
-    mbedtls_entropy_init(entropy);
-
-    mbed_err = mbedtls_ctr_drbg_seed(ctr_drbg, mbedtls_entropy_func,
-                                     entropy, NULL, 0);
-    if (mbed_err != 0) {
-        ESP_LOGE(TAG, "Failed at mbedtls_ctr_drbg_seed with error code : -0x%x", -mbed_err);
-        ret = ESP_FAIL;
-        goto exit_cmd0;
-    }
 
     mbed_err = mbedtls_ecp_group_load(&ctx_server->grp, MBEDTLS_ECP_DP_CURVE25519);
     if (mbed_err != 0) {
@@ -309,13 +301,11 @@ static esp_err_t handle_session_command0(uint32_t session_id,
 
     hexdump("Device random", cur_session->rand, SZ_RANDOM);
 
-    Sec1Payload *out = (Sec1Payload *) malloc(sizeof(Sec1Payload));
-    SessionResp0 *out_resp = (SessionResp0 *) malloc(sizeof(SessionResp0));
+    Sec1Payload *out = (Sec1Payload *) esp_protobuf_arena_alloc(arena, sizeof(Sec1Payload));
+    SessionResp0 *out_resp = (SessionResp0 *) esp_protobuf_arena_alloc(arena, sizeof(SessionResp0));
     if (!out || !out_resp) {
         ESP_LOGE(TAG, "Error allocating memory for response0");
         ret = ESP_ERR_NO_MEM;
-        free(out);
-        free(out_resp);
         goto exit_cmd0;
     }
 
@@ -346,18 +336,13 @@ exit_cmd0:
     mbedtls_ecdh_free(ctx_server);
     free(ctx_server);
 
-    mbedtls_ctr_drbg_free(ctr_drbg);
-    free(ctr_drbg);
-
-    mbedtls_entropy_free(entropy);
-    free(entropy);
-
     return ret;
 }
 
 static esp_err_t sec1_session_setup(uint32_t session_id,
                                     SessionData *req, SessionData *resp,
-                                    const protocomm_security_pop_t *pop)
+                                    const protocomm_security_pop_t *pop,
+                                    esp_protobuf_arena_t *arena)
 {
     Sec1Payload *in = (Sec1Payload *) req->sec1;
     esp_err_t ret;
@@ -379,10 +364,10 @@ static esp_err_t sec1_session_setup(uint32_t session_id,
 
     switch (in->msg) {
         case SEC1_MSG_TYPE__Session_Command0:
-            ret = handle_session_command0(session_id, req, resp, pop);
+            ret = handle_session_command0(session_id, req, resp, pop, arena);
             break;
         case SEC1_MSG_TYPE__Session_Command1:
-            ret = handle_session_command1(session_id, req, resp);
+            ret = handle_session_command1(session_id, req, resp, arena);
             break;
         default:
             ESP_LOGE(TAG, "Invalid security message type");
@@ -393,40 +378,6 @@ static esp_err_t sec1_session_setup(uint32_t session_id,
 
 }
 
-static void sec1_session_setup_cleanup(uint32_t session_id, SessionData *resp)
-{
-    Sec1Payload *out = resp->sec1;
-
-    if (!out) {
-        return;
-    }
-
-    switch (out->msg) {
-        case SEC1_MSG_TYPE__Session_Response0:
-            {
-                SessionResp0 *out_resp0 = out->sr0;
-                if (out_resp0) {
-                    free(out_resp0);
-                }
-                break;
-            }
-        case SEC1_MSG_TYPE__Session_Response1:
-            {
-                SessionResp1 *out_resp1 = out->sr1;
-                if (out_resp1) {
-                    free(out_resp1->device_verify_data.data);
-                    free(out_resp1);
-                }
-                break;
-            }
-        default:
-            break;
-    }
-    free(out);
-
-    return;
-}
-
 static esp_err_t sec1_close_session(uint32_t session_id)
 {
     if (!cur_session || cur_session->id != session_id) {
@@ -465,6 +416,31 @@ static esp_err_t sec1_new_session(uint32_t session_id)
 
 static esp_err_t sec1_init()
 {
+    if (sec1_rng) {
+        return ESP_OK;
+    }
+
+    /* Seeding gathers entropy and runs the DRBG derivation, do it once
+     * rather than for every session. The DRBG reseeds itself as needed. */
+    sec1_rng = (sec1_rng_t *) malloc(sizeof(sec1_rng_t));
+    if (!sec1_rng) {
+        ESP_LOGE(TAG, "Failed to allocate memory for mbedtls context");
+        return ESP_ERR_NO_MEM;
+    }
+
+    mbedtls_ctr_drbg_init(&sec1_rng->ctr_drbg);
+    mbedtls_entropy_init(&sec1_rng->entropy);
+
+    int mbed_err = mbedtls_ctr_drbg_seed(&sec1_rng->ctr_drbg, mbedtls_entropy_func,
+                                         &sec1_rng->entropy, NULL, 0);
+    if (mbed_err != 0) {
+        ESP_LOGE(TAG, "Failed at mbedtls_ctr_drbg_seed with error code : -0x%x", -mbed_err);
+        mbedtls_ctr_drbg_free(&sec1_rng->ctr_drbg);
+        mbedtls_entropy_free(&sec1_rng->entropy);
+        free(sec1_rng);
+        sec1_rng = NULL;
+        return ESP_FAIL;
+    }
     return ESP_OK;
 }
 
@@ -474,6 +450,12 @@ static esp_err_t sec1_cleanup()
         ESP_LOGD(TAG, "Closing current session with id %u", cur_session->id);
         sec1_close_session(cur_session->id);
     }
+    if (sec1_rng) {
+        mbedtls_ctr_drbg_free(&sec1_rng->ctr_drbg);
+        mbedtls_entropy_free(&sec1_rng->entropy);
+        free(sec1_rng);
+        sec1_rng = NULL;
+    }
     return ESP_OK;
 }
 
@@ -510,42 +492,42 @@ static esp_err_t sec1_req_handler(const protocomm_security_pop_t *pop, uint32_t
                                   uint8_t **outbuf, ssize_t *outlen,
                                   void *priv_data)
 {
+    uint8_t arena_buf[SEC1_ARENA_SIZE] __attribute__((aligned(ESP_PROTOBUF_ARENA_ALIGN)));
+    esp_protobuf_arena_t arena;
     SessionData *req;
     SessionData resp;
     esp_err_t ret;
 
-    req = session_data__unpack(NULL, inlen, inbuf);
+    esp_protobuf_arena_init(&arena, arena_buf, sizeof(arena_buf));
+    req = session_data__unpack(&arena.allocator, inlen, inbuf);
     if (!req) {
         ESP_LOGE(TAG, "Unable to unpack setup_req");
-        return ESP_ERR_INVALID_ARG;
+        ret = ESP_ERR_INVALID_ARG;
+        goto exit;
     }
     if (req->sec_ver != protocomm_security1.ver) {
         ESP_LOGE(TAG, "Security version mismatch. Closing connection");
-        session_data__free_unpacked(req, NULL);
-        return ESP_ERR_INVALID_ARG;
+        ret = ESP_ERR_INVALID_ARG;
+        goto exit;
     }
 
     session_data__init(&resp);
-    ret = sec1_session_setup(session_id, req, &resp, pop);
+    ret = sec1_session_setup(session_id, req, &resp, pop, &arena);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Session setup error %d", ret);
-        session_data__free_unpacked(req, NULL);
-        return ESP_FAIL;
+        ret = ESP_FAIL;
+        goto exit;
     }
 
     resp.sec_ver = req->sec_ver;
-    session_data__free_unpacked(req, NULL);
-
-    *outlen = session_data__get_packed_size(&resp);
-    *outbuf = (uint8_t *) malloc(*outlen);
-    if (!*outbuf) {
+    ret = esp_protobuf_pack_alloc(&resp.base, outbuf, outlen);
+    if (ret != ESP_OK) {
         ESP_LOGE(TAG, "System out of memory");
-        return ESP_ERR_NO_MEM;
     }
-    session_data__pack(&resp, *outbuf);
 
-    sec1_session_setup_cleanup(session_id, &resp);
-    return ESP_OK;
+exit:
+    esp_protobuf_arena_release(&arena);
+    return ret;
 }
 
 const protocomm_security_t protocomm_security1 = {
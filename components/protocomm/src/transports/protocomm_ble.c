@@ -237,12 +237,13 @@ static void transport_simple_ble_exec_write(esp_gatts_cb_event_t event, esp_gatt
     if ((param->exec_write.exec_write_flag == ESP_GATT_PREP_WRITE_EXEC)
             &&
             prepare_write_env.prepare_buf) {
-        err = protocomm_req_handle(protoble_internal->pc_ble,
-                                   handle_to_handler(prepare_write_env.handle),
-                                   param->exec_write.conn_id,
-                                   prepare_write_env.prepare_buf,
-                                   prepare_write_env.prepare_len,
-                                   &outbuf, &outlen);
+        /* Prepare buffer is freed below, so the request can be decrypted in it */
+        err = protocomm_req_handle_inplace(protoble_internal->pc_ble,
+                                           handle_to_handler(prepare_write_env.handle),
+                                           param->exec_write.conn_id,
+                                           prepare_write_env.prepare_buf,
+                                           prepare_write_env.prepare_len,
+                                           &outbuf, &outlen);
 
         if (err != ESP_OK) {
             ESP_LOGE(TAG, "Invalid content received, killing connection");
@@ -152,7 +152,7 @@ static int common_cmd_handler(int argc, char** argv)
         }
     }
 
-    ret = protocomm_req_handle(pc_console, argv[0], cur_session_id, buf, len, &outbuf, &outlen);
+    ret = protocomm_req_handle_inplace(pc_console, argv[0], cur_session_id, buf, len, &outbuf, &outlen);
     free(buf);
 
     if (ret == ESP_OK) {
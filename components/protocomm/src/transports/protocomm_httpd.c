@@ -29,13 +29,23 @@ static protocomm_t *pc_httpd; /* The global protocomm instance for HTTPD */
 static bool pc_ext_httpd_handle_provided = false;
 static uint32_t session_id = PROTOCOMM_NO_SESSION_ID;
 
+/* Request body buffer, reused for all requests of a session */
+static uint8_t *session_buf;
+static size_t session_buf_len;
+
 #define MAX_REQ_BODY_LEN 4096
 
+static void free_session_buf(void)
+{
+    free(session_buf);
+    session_buf = NULL;
+    session_buf_len = 0;
+}
+
 static esp_err_t common_post_handler(httpd_req_t *req)
 {
     esp_err_t ret;
     uint8_t *outbuf = NULL;
-    char *req_body = NULL;
     const char *ep_name = NULL;
     ssize_t outlen;
 
@@ -56,6 +66,7 @@ static esp_err_t common_post_handler(httpd_req_t *req)
                 }
             }
             session_id = PROTOCOMM_NO_SESSION_ID;
+            free_session_buf();
         }
         if (pc_httpd->sec && pc_httpd->sec->new_transport_session) {
             ret = pc_httpd->sec->new_transport_session(cur_session_id);
@@ -79,16 +90,20 @@ static esp_err_t common_post_handler(httpd_req_t *req)
         goto out;
     }
 
-    req_body = (char *) malloc(req->content_len);
-    if (!req_body) {
-        ESP_LOGE(TAG, "Unable to allocate for request length %d", req->content_len);
-        ret = ESP_ERR_NO_MEM;
-        goto out;
+    if (req->content_len > session_buf_len) {
+        uint8_t *buf = (uint8_t *) realloc(session_buf, req->content_len);
+        if (!buf) {
+            ESP_LOGE(TAG, "Unable to allocate for request length %d", req->content_len);
+            ret = ESP_ERR_NO_MEM;
+            goto out;
+        }
+        session_buf = buf;
+        session_buf_len = req->content_len;
     }
 
     size_t recv_size = 0;
     while (recv_size < req->content_len) {
-        ret = httpd_req_recv(req, req_body + recv_size, req->content_len - recv_size);
+        ret = httpd_req_recv(req, (char *)session_buf + recv_size, req->content_len - recv_size);
         if (ret < 0) {
             ret = ESP_FAIL;
             goto out;
@@ -99,8 +114,9 @@ static esp_err_t common_post_handler(httpd_req_t *req)
     /* Extract the endpoint name from URI string of type "/ep_name" */
     ep_name = req->uri + 1;
 
-    ret = protocomm_req_handle(pc_httpd, ep_name, session_id,
-                               (uint8_t *)req_body, recv_size, &outbuf, &outlen);
+    /* Request is decrypted in the session buffer, it isn't needed afterwards */
+    ret = protocomm_req_handle_inplace(pc_httpd, ep_name, session_id,
+                                       session_buf, recv_size, &outbuf, &outlen);
 
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Data handler failed");
@@ -116,9 +132,6 @@ static esp_err_t common_post_handler(httpd_req_t *req)
     }
     ret = ESP_OK;
 out:
-    if (req_body) {
-        free(req_body);
-    }
     if (outbuf) {
         free(outbuf);
     }
@@ -254,6 +267,8 @@ esp_err_t protocomm_httpd_stop(protocomm_t *pc)
         } else {
             pc_ext_httpd_handle_provided = false;
         }
+        free_session_buf();
+        session_id = PROTOCOMM_NO_SESSION_ID;
         pc_httpd->priv = NULL;
         pc_httpd = NULL;
         return ESP_OK;
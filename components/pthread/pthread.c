@@ -30,6 +30,14 @@
 #include "pthread_internal.h"
 #include "esp_pthread.h"
 
+/* Index of the FreeRTOS thread local storage pointer to the pthread running in a task.
+   Index 0 holds the pthread keys, see pthread_local_storage.c */
+#define PTHREAD_DESC_TLS_INDEX 1
+
+#if configNUM_THREAD_LOCAL_STORAGE_POINTERS <= PTHREAD_DESC_TLS_INDEX
+#error "pthread needs CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS to be at least 2"
+#endif
+
 #define LOG_LOCAL_LEVEL CONFIG_LOG_DEFAULT_LEVEL
 #include "esp_log.h"
 const static char *TAG = "pthread";
@@ -43,14 +51,23 @@ enum esp_pthread_task_state {
 /** pthread thread FreeRTOS wrapper */
 typedef struct esp_pthread_entry {
     SLIST_ENTRY(esp_pthread_entry)  list_node;  ///< Tasks list node struct.
-    TaskHandle_t                handle;         ///< FreeRTOS task handle
+    TaskHandle_t                handle;         ///< FreeRTOS task handle, NULL once the task went back to the pool
     TaskHandle_t                join_task;      ///< Handle of the task waiting to join
     enum esp_pthread_task_state state;          ///< pthread task state
     bool                        detached;       ///< True if pthread is detached
     void                       *retval;         ///< Value supplied to calling thread during join
     void                       *task_arg;       ///< Task arguments
+    uint32_t                    stack_size;     ///< Stack size of the task in bytes
+    BaseType_t                  core_id;        ///< Core the task is pinned to
 } esp_pthread_t;
 
+/** idle task of the pool */
+typedef struct {
+    TaskHandle_t    handle;         ///< FreeRTOS task handle
+    uint32_t        stack_size;     ///< Stack size of the task in bytes
+    BaseType_t      core_id;        ///< Core the task is pinned to
+} esp_pthread_pool_task_t;
+
 /** pthread wrapper task arg */
 typedef struct {
     void *(*func)(void *);  ///< user task entry
@@ -70,6 +87,10 @@ static portMUX_TYPE s_mutex_init_lock   = portMUX_INITIALIZER_UNLOCKED;
 static SLIST_HEAD(esp_thread_list_head, esp_pthread_entry) s_threads_list
                                         = SLIST_HEAD_INITIALIZER(s_threads_list);
 static pthread_key_t s_pthread_cfg_key;
+#if CONFIG_PTHREAD_TASK_POOL_SIZE > 0
+static esp_pthread_pool_task_t s_pool[CONFIG_PTHREAD_TASK_POOL_SIZE];
+static size_t s_pool_count;
+#endif
 
 
 static int IRAM_ATTR pthread_mutex_lock_internal(esp_pthread_mutex_t *mux, TickType_t tmo);
@@ -92,49 +113,64 @@ esp_err_t esp_pthread_init(void)
     return ESP_OK;
 }
 
-static void *pthread_list_find_item(void *(*item_check)(esp_pthread_t *, void *arg), void *check_arg)
+static bool pthread_list_contains(esp_pthread_t *pthread)
 {
     esp_pthread_t *it;
     SLIST_FOREACH(it, &s_threads_list, list_node) {
-        void *val = item_check(it, check_arg);
-        if (val) {
-            return val;
+        if (it == pthread) {
+            return true;
         }
     }
-    return NULL;
+    return false;
 }
 
-static void *pthread_get_handle_by_desc(esp_pthread_t *item, void *desc)
+/* The pthread running in a task, NULL if the task isn't a pthread */
+static inline esp_pthread_t *pthread_find(TaskHandle_t task_handle)
 {
-    if (item == desc) {
-        return item->handle;
-    }
-    return NULL;
+    return pvTaskGetThreadLocalStoragePointer(task_handle, PTHREAD_DESC_TLS_INDEX);
 }
 
-static void *pthread_get_desc_by_handle(esp_pthread_t *item, void *hnd)
-{
-    if (hnd == item->handle) {
-        return item;
-    }
-    return NULL;
-}
-
-static inline TaskHandle_t pthread_find_handle(pthread_t thread)
+static void pthread_delete(esp_pthread_t *pthread)
 {
-    return pthread_list_find_item(pthread_get_handle_by_desc, (void *)thread);
+    SLIST_REMOVE(&s_threads_list, pthread, esp_pthread_entry, list_node);
+    free(pthread);
 }
 
-static esp_pthread_t *pthread_find(TaskHandle_t task_handle)
+#if CONFIG_PTHREAD_TASK_POOL_SIZE > 0
+/* Take an idle task able to run a pthread with these parameters from the pool.
+   Call with s_threads_mux taken. */
+static TaskHandle_t pthread_pool_take(uint32_t stack_size, BaseType_t core_id, const char *task_name, uint32_t *task_stack_size)
 {
-    return pthread_list_find_item(pthread_get_desc_by_handle, task_handle);
+    for (size_t i = 0; i < s_pool_count; i++) {
+        esp_pthread_pool_task_t *task = &s_pool[i];
+        if (task->stack_size >= stack_size && task->core_id == core_id &&
+            strncmp(pcTaskGetTaskName(task->handle), task_name, configMAX_TASK_NAME_LEN - 1) == 0) {
+            TaskHandle_t handle = task->handle;
+            *task_stack_size = task->stack_size;
+            *task = s_pool[--s_pool_count];
+            return handle;
+        }
+    }
+    return NULL;
 }
 
-static void pthread_delete(esp_pthread_t *pthread)
+/* Put the current task, whose pthread has finished, into the pool if there is room.
+   Call with s_threads_mux taken. */
+static bool pthread_pool_put(esp_pthread_t *pthread)
 {
-    SLIST_REMOVE(&s_threads_list, pthread, esp_pthread_entry, list_node);
-    free(pthread);
+    if (s_pool_count == CONFIG_PTHREAD_TASK_POOL_SIZE) {
+        return false;
+    }
+    s_pool[s_pool_count++] = (esp_pthread_pool_task_t) {
+        .handle = pthread->handle,
+        .stack_size = pthread->stack_size,
+        .core_id = pthread->core_id,
+    };
+    vTaskSetThreadLocalStoragePointer(NULL, PTHREAD_DESC_TLS_INDEX, NULL);
+    pthread->handle = NULL;
+    return true;
 }
+#endif
 
 /* Call this function to configure pthread stacks in Pthreads */
 esp_err_t esp_pthread_set_cfg(const esp_pthread_cfg_t *cfg)
@@ -185,30 +221,38 @@ esp_pthread_cfg_t esp_pthread_get_default_config()
     return cfg;
 }
 
+static bool pthread_exit_internal(void *value_ptr, bool can_reuse_task);
+
 static void pthread_task_func(void *arg)
 {
     void *rval = NULL;
-    esp_pthread_task_arg_t *task_arg = (esp_pthread_task_arg_t *)arg;
-
-    ESP_LOGV(TAG, "%s ENTER %p", __FUNCTION__, task_arg->func);
+    uint32_t notify_value;
+
+    do {
+        // wait for start, the notification value is the argument of the pthread to run
+        xTaskNotifyWait(0, UINT32_MAX, &notify_value, portMAX_DELAY);
+        esp_pthread_task_arg_t *task_arg = (esp_pthread_task_arg_t *)notify_value;
+        if (task_arg == NULL) {
+            continue;
+        }
 
-    // wait for start
-    xTaskNotifyWait(0, 0, NULL, portMAX_DELAY);
+        ESP_LOGV(TAG, "%s ENTER %p", __FUNCTION__, task_arg->func);
 
-    if (task_arg->cfg.inherit_cfg) {
-        /* If inherit option is set, then do a set_cfg() ourselves for future forks,
-        but first set thread_name to NULL to enable inheritance of the name too.
-        (This also to prevents dangling pointers to name of tasks that might
-        possibly have been deleted when we use the configuration).*/
-        esp_pthread_cfg_t *cfg = &task_arg->cfg;
-        cfg->thread_name = NULL;
-        esp_pthread_set_cfg(cfg);
-    }
-    ESP_LOGV(TAG, "%s START %p", __FUNCTION__, task_arg->func);
-    rval = task_arg->func(task_arg->arg);
-    ESP_LOGV(TAG, "%s END %p", __FUNCTION__, task_arg->func);
+        if (task_arg->cfg.inherit_cfg) {
+            /* If inherit option is set, then do a set_cfg() ourselves for future forks,
+            but first set thread_name to NULL to enable inheritance of the name too.
+            (This also to prevents dangling pointers to name of tasks that might
+            possibly have been deleted when we use the configuration).*/
+            esp_pthread_cfg_t *cfg = &task_arg->cfg;
+            cfg->thread_name = NULL;
+            esp_pthread_set_cfg(cfg);
+        }
+        ESP_LOGV(TAG, "%s START %p", __FUNCTION__, task_arg->func);
+        rval = task_arg->func(task_arg->arg);
+        ESP_LOGV(TAG, "%s END %p", __FUNCTION__, task_arg->func);
 
-    pthread_exit(rval);
+        /* Returns only if the task went back to the pool */
+    } while (pthread_exit_internal(rval, true));
 
     ESP_LOGV(TAG, "%s EXIT", __FUNCTION__);
 }
@@ -284,29 +328,46 @@ int pthread_create(pthread_t *thread, const pthread_attr_t *attr,
     task_arg->func = start_routine;
     task_arg->arg = arg;
     pthread->task_arg = task_arg;
-    BaseType_t res = xTaskCreatePinnedToCore(&pthread_task_func,
-                                             task_name,
-                                             // stack_size is in bytes. This transformation ensures that the units are
-                                             // transformed to the units used in FreeRTOS.
-                                             // Note: float division of ceil(m / n) ==
-                                             //       integer division of (m + n - 1) / n
-                                             (stack_size + sizeof(StackType_t) - 1) / sizeof(StackType_t),
-                                             task_arg,
-                                             prio,
-                                             &xHandle,
-                                             core_id);
-
-    if (res != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create task!");
-        free(pthread);
-        free(task_arg);
-        if (res == errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY) {
-            return ENOMEM;
-        } else {
-            return EAGAIN;
+    pthread->stack_size = stack_size;
+    pthread->core_id = core_id;
+
+#if CONFIG_PTHREAD_TASK_POOL_SIZE > 0
+    if (xSemaphoreTake(s_threads_mux, portMAX_DELAY) != pdTRUE) {
+        assert(false && "Failed to lock threads list!");
+    }
+    xHandle = pthread_pool_take(stack_size, core_id, task_name, &pthread->stack_size);
+    xSemaphoreGive(s_threads_mux);
+    if (xHandle) {
+        vTaskPrioritySet(xHandle, prio);
+    }
+#endif
+
+    if (xHandle == NULL) {
+        BaseType_t res = xTaskCreatePinnedToCore(&pthread_task_func,
+                                                 task_name,
+                                                 // stack_size is in bytes. This transformation ensures that the units are
+                                                 // transformed to the units used in FreeRTOS.
+                                                 // Note: float division of ceil(m / n) ==
+                                                 //       integer division of (m + n - 1) / n
+                                                 (stack_size + sizeof(StackType_t) - 1) / sizeof(StackType_t),
+                                                 NULL,
+                                                 prio,
+                                                 &xHandle,
+                                                 core_id);
+
+        if (res != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create task!");
+            free(pthread);
+            free(task_arg);
+            if (res == errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY) {
+                return ENOMEM;
+            } else {
+                return EAGAIN;
+            }
         }
     }
     pthread->handle = xHandle;
+    vTaskSetThreadLocalStoragePointer(xHandle, PTHREAD_DESC_TLS_INDEX, pthread);
 
     if (xSemaphoreTake(s_threads_mux, portMAX_DELAY) != pdTRUE) {
         assert(false && "Failed to lock threads list!");
@@ -315,7 +376,7 @@ int pthread_create(pthread_t *thread, const pthread_attr_t *attr,
     xSemaphoreGive(s_threads_mux);
 
     // start task
-    xTaskNotify(xHandle, 0, eNoAction);
+    xTaskNotify(xHandle, (uint32_t)task_arg, eSetValueWithOverwrite);
 
     *thread = (pthread_t)pthread; // pointer value fit into pthread_t (uint32_t)
 
@@ -330,6 +391,7 @@ int pthread_join(pthread_t thread, void **retval)
     int ret = 0;
     bool wait = false;
     void *child_task_retval = 0;
+    TaskHandle_t handle = NULL;
 
     ESP_LOGV(TAG, "%s %p", __FUNCTION__, pthread);
 
@@ -337,8 +399,7 @@ int pthread_join(pthread_t thread, void **retval)
     if (xSemaphoreTake(s_threads_mux, portMAX_DELAY) != pdTRUE) {
         assert(false && "Failed to lock threads list!");
     }
-    TaskHandle_t handle = pthread_find_handle(thread);
-    if (!handle) {
+    if (!pthread_list_contains(pthread)) {
         // not found
         ret = ESRCH;
     } else if (pthread->detached) {
@@ -347,12 +408,12 @@ int pthread_join(pthread_t thread, void **retval)
     } else if (pthread->join_task) {
         // already have waiting task to join
         ret = EINVAL;
-    } else if (handle == xTaskGetCurrentTaskHandle()) {
+    } else if (pthread->handle == xTaskGetCurrentTaskHandle()) {
         // join to self not allowed
         ret = EDEADLK;
     } else {
         esp_pthread_t *cur_pthread = pthread_find(xTaskGetCurrentTaskHandle());
-        if (cur_pthread && cur_pthread->join_task == handle) {
+        if (cur_pthread && pthread->handle && cur_pthread->join_task == pthread->handle) {
             // join to each other not allowed
             ret = EDEADLK;
         } else {
@@ -361,6 +422,7 @@ int pthread_join(pthread_t thread, void **retval)
                 wait = true;
             } else {
                 child_task_retval = pthread->retval;
+                handle = pthread->handle;
                 pthread_delete(pthread);
             }
         }
@@ -374,10 +436,14 @@ int pthread_join(pthread_t thread, void **retval)
                 assert(false && "Failed to lock threads list!");
             }
             child_task_retval = pthread->retval;
+            handle = pthread->handle;
             pthread_delete(pthread);
             xSemaphoreGive(s_threads_mux);
         }
-        vTaskDelete(handle);
+        // no task to delete if it went back to the pool
+        if (handle) {
+            vTaskDelete(handle);
+        }
     }
 
     if (retval) {
@@ -396,8 +462,7 @@ int pthread_detach(pthread_t thread)
     if (xSemaphoreTake(s_threads_mux, portMAX_DELAY) != pdTRUE) {
         assert(false && "Failed to lock threads list!");
     }
-    TaskHandle_t handle = pthread_find_handle(thread);
-    if (!handle) {
+    if (!pthread_list_contains(pthread)) {
         ret = ESRCH;
     } else if (pthread->detached) {
         // already detached
@@ -410,17 +475,24 @@ int pthread_detach(pthread_t thread)
         pthread->detached = true;
     } else {
         // pthread already stopped
+        TaskHandle_t handle = pthread->handle;
         pthread_delete(pthread);
-        vTaskDelete(handle);
+        if (handle) {
+            vTaskDelete(handle);
+        }
     }
     xSemaphoreGive(s_threads_mux);
     ESP_LOGV(TAG, "%s %p EXIT %d", __FUNCTION__, pthread, ret);
     return ret;
 }
 
-void pthread_exit(void *value_ptr)
+/* Finish the pthread of the current task. The task may go back to the pool only when it is
+   called on return from the pthread function, and the function returns true then. Otherwise
+   the task is deleted, or suspended until it is joined, and the function doesn't return. */
+static bool pthread_exit_internal(void *value_ptr, bool can_reuse_task)
 {
     bool detached = false;
+    bool reused = false;
     /* preemptively clean up thread local storage, rather than
        waiting for the idle task to clean up the thread */
     pthread_internal_local_storage_destructor_callback();
@@ -434,7 +506,13 @@ void pthread_exit(void *value_ptr)
     }
     if (pthread->task_arg) {
         free(pthread->task_arg);
+        pthread->task_arg = NULL;
+    }
+#if CONFIG_PTHREAD_TASK_POOL_SIZE > 0
+    if (can_reuse_task) {
+        reused = pthread_pool_put(pthread);
     }
+#endif
     if (pthread->detached) {
         // auto-free for detached threads
         pthread_delete(pthread);
@@ -454,11 +532,21 @@ void pthread_exit(void *value_ptr)
 
     ESP_LOGD(TAG, "Task stk_wm = %d", uxTaskGetStackHighWaterMark(NULL));
 
+    if (reused) {
+        return true;
+    }
     if (detached) {
         vTaskDelete(NULL);
     } else {
         vTaskSuspend(NULL);
     }
+    return false;
+}
+
+void pthread_exit(void *value_ptr)
+{
+    /* The task can't go back to the pool from here, the frames of the pthread function are still on its stack */
+    pthread_exit_internal(value_ptr, false);
 
     ESP_LOGV(TAG, "%s EXIT", __FUNCTION__);
 }
@@ -477,14 +565,10 @@ int sched_yield( void )
 
 pthread_t pthread_self(void)
 {
-    if (xSemaphoreTake(s_threads_mux, portMAX_DELAY) != pdTRUE) {
-        assert(false && "Failed to lock threads list!");
-    }
     esp_pthread_t *pthread = pthread_find(xTaskGetCurrentTaskHandle());
     if (!pthread) {
         assert(false && "Failed to find current thread ID!");
     }
-    xSemaphoreGive(s_threads_mux);
     return (pthread_t)pthread;
 }
 
@@ -129,6 +129,49 @@ TEST_CASE("pthread detach", "[pthread]")
     }
 }
 
+static void *get_self(void *arg)
+{
+    *(pthread_t *) arg = pthread_self();
+    return (void *) xTaskGetCurrentTaskHandle();
+}
+
+TEST_CASE("pthread self matches created thread", "[pthread]")
+{
+    pthread_t threads[4];
+    pthread_t self[4];
+    void *task_handle;
+
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL, get_self, &self[i]));
+    }
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL_INT(0, pthread_join(threads[i], &task_handle));
+        TEST_ASSERT_NOT_NULL(task_handle);
+        TEST_ASSERT(pthread_equal(threads[i], self[i]));
+    }
+}
+
+#if CONFIG_PTHREAD_TASK_POOL_SIZE > 0
+/* Ignored in CI: the task kept in the pool is reported as a leak by the test runner */
+TEST_CASE("pthread reuses the task of a finished thread", "[pthread][ignore]")
+{
+    pthread_t thread, self;
+    void *first_task, *task;
+
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&thread, NULL, get_self, &self));
+    TEST_ASSERT_EQUAL_INT(0, pthread_join(thread, &first_task));
+    const int task_count = uxTaskGetNumberOfTasks();
+
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&thread, NULL, get_self, &self));
+        TEST_ASSERT_EQUAL_INT(0, pthread_join(thread, &task));
+        TEST_ASSERT_EQUAL_PTR(first_task, task);
+        TEST_ASSERT(pthread_equal(thread, self));
+    }
+    TEST_ASSERT_EQUAL_INT(task_count, uxTaskGetNumberOfTasks());
+}
+#endif
+
 TEST_CASE("pthread attr init destroy", "[pthread]")
 {
     int res = 0;
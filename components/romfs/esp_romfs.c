@@ -0,0 +1,512 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/errno.h>
+#include <sys/fcntl.h>
+#include <sys/lock.h>
+#include <sys/stat.h>
+#include "esp_romfs.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_spi_flash.h"
+#include "esp_vfs.h"
+#include "esp_err.h"
+#include "esp_crc.h"
+#include "sdkconfig.h"
+
+static const char* TAG = "ROMFS";
+
+/**
+ * @brief Open file in a ROMFS image
+ */
+typedef struct {
+    const esp_romfs_entry_t* entry; /*!< Entry of the file, NULL if the descriptor is free */
+    size_t pos;                     /*!< Current position in the file */
+} romfs_fd_t;
+
+/**
+ * @brief Mounted ROMFS image
+ */
+typedef struct {
+    const esp_partition_t* partition;       /*!< The partition holding the image */
+    spi_flash_mmap_handle_t mmap_handle;    /*!< Mapping of the image */
+    const uint8_t* image;                   /*!< Start of the mapped image */
+    const esp_romfs_header_t* header;       /*!< Header of the image */
+    const esp_romfs_entry_t* entries;       /*!< Entries of the image, sorted by name */
+    char base_path[ESP_VFS_PATH_MAX+1];     /*!< Mount point */
+    size_t max_files;                       /*!< Number of file descriptors */
+    _lock_t fd_lock;                        /*!< Protects allocation of file descriptors */
+    romfs_fd_t fds[];                       /*!< File descriptors */
+} esp_romfs_t;
+
+/**
+ * @brief ROMFS DIR structure
+ */
+typedef struct {
+    DIR dir;            /*!< VFS DIR struct */
+    struct dirent e;    /*!< Last open dirent */
+    uint32_t next;      /*!< Index of the entry to look at next */
+    size_t path_len;    /*!< Length of the directory name, without trailing slash */
+    char path[ESP_VFS_PATH_MAX+1]; /*!< Requested directory name */
+} vfs_romfs_dir_t;
+
+static esp_romfs_t* s_romfs[CONFIG_ROMFS_MAX_PARTITIONS];
+
+static const char* romfs_entry_name(const esp_romfs_t* efs, const esp_romfs_entry_t* entry)
+{
+    return (const char*) efs->image + entry->name_offset;
+}
+
+static const esp_romfs_entry_t* romfs_find(const esp_romfs_t* efs, const char* path)
+{
+    uint32_t lo = 0;
+    uint32_t hi = efs->header->file_count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int cmp = strcmp(path, romfs_entry_name(efs, &efs->entries[mid]));
+        if (cmp == 0) {
+            return &efs->entries[mid];
+        } else if (cmp < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t romfs_by_label(const char* label, int* out_index)
+{
+    for (int i = 0; i < CONFIG_ROMFS_MAX_PARTITIONS; i++) {
+        if (s_romfs[i] && strcmp(s_romfs[i]->partition->label, label) == 0) {
+            *out_index = i;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+/* Checks that all offsets of the image are inside it, and that the entries are sorted */
+static esp_err_t romfs_check_image(const esp_romfs_t* efs)
+{
+    const esp_romfs_header_t* header = efs->header;
+    if (header->index_size > header->image_size - header->header_size ||
+            header->file_count > header->index_size / sizeof(esp_romfs_entry_t)) {
+        ESP_LOGE(TAG, "invalid index size");
+        return ESP_FAIL;
+    }
+    const uint32_t index_end = header->header_size + header->index_size;
+    const uint32_t names_start = header->header_size + header->file_count * sizeof(esp_romfs_entry_t);
+    uint32_t crc = esp_crc32_le(0, efs->image + header->header_size, header->index_size);
+    if (crc != header->index_crc) {
+        ESP_LOGE(TAG, "index CRC mismatch (0x%08x, expected 0x%08x)", crc, header->index_crc);
+        return ESP_FAIL;
+    }
+    const char* prev_name = NULL;
+    for (uint32_t i = 0; i < header->file_count; i++) {
+        const esp_romfs_entry_t* entry = &efs->entries[i];
+        if (entry->name_offset < names_start || entry->name_offset >= index_end ||
+                memchr(efs->image + entry->name_offset, 0, index_end - entry->name_offset) == NULL) {
+            ESP_LOGE(TAG, "invalid name of entry %u", i);
+            return ESP_FAIL;
+        }
+        if (entry->data_offset > header->image_size || entry->size > header->image_size - entry->data_offset) {
+            ESP_LOGE(TAG, "invalid data of entry %u", i);
+            return ESP_FAIL;
+        }
+        const char* name = romfs_entry_name(efs, entry);
+        if (prev_name && strcmp(prev_name, name) >= 0) {
+            ESP_LOGE(TAG, "entries are not sorted at %s", name);
+            return ESP_FAIL;
+        }
+        prev_name = name;
+    }
+    return ESP_OK;
+}
+
+static void romfs_free(esp_romfs_t** efs)
+{
+    esp_romfs_t* e = *efs;
+    if (e == NULL) {
+        return;
+    }
+    *efs = NULL;
+    if (e->image) {
+        spi_flash_munmap(e->mmap_handle);
+    }
+    _lock_close(&e->fd_lock);
+    free(e);
+}
+
+static esp_err_t romfs_init(const esp_vfs_romfs_conf_t* conf, int* out_index)
+{
+    int index;
+    if (conf->partition_label == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (romfs_by_label(conf->partition_label, &index) == ESP_OK) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (index = 0; index < CONFIG_ROMFS_MAX_PARTITIONS && s_romfs[index]; index++) {
+    }
+    if (index == CONFIG_ROMFS_MAX_PARTITIONS) {
+        ESP_LOGE(TAG, "max mounted partitions reached");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const esp_partition_t* partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+            ESP_PARTITION_SUBTYPE_ANY, conf->partition_label);
+    if (!partition) {
+        ESP_LOGE(TAG, "partition \"%s\" could not be found", conf->partition_label);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_romfs_header_t header;
+    esp_err_t err = esp_partition_read(partition, 0, &header, sizeof(header));
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (header.magic != ESP_ROMFS_MAGIC || header.version != ESP_ROMFS_VERSION ||
+            header.header_size < sizeof(header) || header.header_size % 4 != 0 ||
+            header.image_size > partition->size || header.header_size > header.image_size) {
+        ESP_LOGE(TAG, "partition \"%s\" does not hold a ROMFS image", conf->partition_label);
+        return ESP_FAIL;
+    }
+
+    esp_romfs_t* efs = calloc(1, sizeof(esp_romfs_t) + conf->max_files * sizeof(romfs_fd_t));
+    if (efs == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    efs->partition = partition;
+    efs->max_files = conf->max_files;
+    err = esp_partition_mmap(partition, 0, header.image_size, SPI_FLASH_MMAP_DATA,
+            (const void**) &efs->image, &efs->mmap_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "mapping the image failed (0x%x)", err);
+        efs->image = NULL;
+        romfs_free(&efs);
+        return ESP_FAIL;
+    }
+    efs->header = (const esp_romfs_header_t*) efs->image;
+    efs->entries = (const esp_romfs_entry_t*) (efs->image + header.header_size);
+    if (romfs_check_image(efs) != ESP_OK) {
+        romfs_free(&efs);
+        return ESP_FAIL;
+    }
+
+    s_romfs[index] = efs;
+    *out_index = index;
+    return ESP_OK;
+}
+
+static romfs_fd_t* romfs_get_fd(esp_romfs_t* efs, int fd)
+{
+    if (fd < 0 || fd >= efs->max_files || efs->fds[fd].entry == NULL) {
+        errno = EBADF;
+        return NULL;
+    }
+    return &efs->fds[fd];
+}
+
+static int vfs_romfs_open(void* ctx, const char * path, int flags, int mode)
+{
+    esp_romfs_t* efs = (esp_romfs_t*) ctx;
+    if ((flags & O_ACCMODE) != O_RDONLY || (flags & (O_CREAT | O_TRUNC | O_APPEND))) {
+        errno = EROFS;
+        return -1;
+    }
+    const esp_romfs_entry_t* entry = romfs_find(efs, path);
+    if (entry == NULL) {
+        errno = ENOENT;
+        return -1;
+    }
+    int fd = -1;
+    _lock_acquire(&efs->fd_lock);
+    for (int i = 0; i < efs->max_files; i++) {
+        if (efs->fds[i].entry == NULL) {
+            efs->fds[i].entry = entry;
+            efs->fds[i].pos = 0;
+            fd = i;
+            break;
+        }
+    }
+    _lock_release(&efs->fd_lock);
+    if (fd < 0) {
+        errno = ENFILE;
+    }
+    return fd;
+}
+
+static ssize_t romfs_copy(esp_romfs_t* efs, const esp_romfs_entry_t* entry, void* dst, size_t size, size_t pos)
+{
+    if (pos >= entry->size) {
+        return 0;
+    }
+    if (size > entry->size - pos) {
+        size = entry->size - pos;
+    }
+    memcpy(dst, efs->image + entry->data_offset + pos, size);
+    return size;
+}
+
+static ssize_t vfs_romfs_read(void* ctx, int fd, void * dst, size_t size)
+{
+    esp_romfs_t* efs = (esp_romfs_t*) ctx;
+    romfs_fd_t* f = romfs_get_fd(efs, fd);
+    if (f == NULL) {
+        return -1;
+    }
+    ssize_t res = romfs_copy(efs, f->entry, dst, size, f->pos);
+    f->pos += res;
+    return res;
+}
+
+static ssize_t vfs_romfs_pread(void* ctx, int fd, void * dst, size_t size, off_t offset)
+{
+    esp_romfs_t* efs = (esp_romfs_t*) ctx;
+    romfs_fd_t* f = romfs_get_fd(efs, fd);
+    if (f == NULL) {
+        return -1;
+    }
+    if (offset < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return romfs_copy(efs, f->entry, dst, size, offset);
+}
+
+static ssize_t vfs_romfs_write(void* ctx, int fd, const void * data, size_t size)
+{
+    errno = EBADF;
+    return -1;
+}
+
+static off_t vfs_romfs_lseek(void* ctx, int fd, off_t offset, int mode)
+{
+    esp_romfs_t* efs = (esp_romfs_t*) ctx;
+    romfs_fd_t* f = romfs_get_fd(efs, fd);
+    if (f == NULL) {
+        return -1;
+    }
+    off_t base;
+    switch (mode) {
+    case SEEK_SET:
+        base = 0;
+        break;
+    case SEEK_CUR:
+        base = f->pos;
+        break;
+    case SEEK_END:
+        base = f->entry->size;
+        break;
+    default:
+        errno = EINVAL;
+        return -1;
+    }
+    if (base + offset < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    f->pos = base + offset;
+    return f->pos;
+}
+
+static int vfs_romfs_close(void* ctx, int fd)
+{
+    esp_romfs_t* efs = (esp_romfs_t*) ctx;
+    romfs_fd_t* f = romfs_get_fd(efs, fd);
+    if (f == NULL) {
+        return -1;
+    }
+    _lock_acquire(&efs->fd_lock);
+    f->entry = NULL;
+    _lock_release(&efs->fd_lock);
+    return 0;
+}
+
+static void romfs_fill_stat(const esp_romfs_entry_t* entry, struct stat * st)
+{
+    memset(st, 0, sizeof(*st));
+    st->st_size = entry->size;
+    st->st_mode = S_IRUSR | S_IRGRP | S_IROTH | S_IFREG;
+}
+
+static int vfs_romfs_fstat(void* ctx, int fd, struct stat * st)
+{
+    esp_romfs_t* efs = (esp_romfs_t*) ctx;
+    romfs_fd_t* f = romfs_get_fd(efs, fd);
+    if (f == NULL) {
+        return -1;
+    }
+    romfs_fill_stat(f->entry, st);
+    return 0;
+}
+
+static int vfs_romfs_stat(void* ctx, const char * path, struct stat * st)
+{
+    esp_romfs_t* efs = (esp_romfs_t*) ctx;
+    const esp_romfs_entry_t* entry = romfs_find(efs, path);
+    if (entry == NULL) {
+        errno = ENOENT;
+        return -1;
+    }
+    romfs_fill_stat(entry, st);
+    return 0;
+}
+
+static DIR* vfs_romfs_opendir(void* ctx, const char* name)
+{
+    assert(name);
+    vfs_romfs_dir_t* dir = calloc(1, sizeof(vfs_romfs_dir_t));
+    if (!dir) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    strlcpy(dir->path, name, sizeof(dir->path));
+    dir->path_len = strlen(dir->path);
+    if (dir->path_len > 0 && dir->path[dir->path_len - 1] == '/') {
+        dir->path[--dir->path_len] = 0;
+    }
+    return (DIR*) dir;
+}
+
+static int vfs_romfs_closedir(void* ctx, DIR* pdir)
+{
+    assert(pdir);
+    free(pdir);
+    return 0;
+}
+
+static int vfs_romfs_readdir_r(void* ctx, DIR* pdir, struct dirent* entry,
+                               struct dirent** out_dirent)
+{
+    assert(pdir);
+    esp_romfs_t* efs = (esp_romfs_t*) ctx;
+    vfs_romfs_dir_t* dir = (vfs_romfs_dir_t*) pdir;
+    while (dir->next < efs->header->file_count) {
+        const char* name = romfs_entry_name(efs, &efs->entries[dir->next++]);
+        // files of the directory and of its subdirectories, like in SPIFFS
+        if (strncmp(name, dir->path, dir->path_len) == 0 && name[dir->path_len] == '/') {
+            entry->d_ino = 0;
+            entry->d_type = DT_REG;
+            strlcpy(entry->d_name, name + dir->path_len + 1, sizeof(entry->d_name));
+            *out_dirent = entry;
+            return 0;
+        }
+    }
+    *out_dirent = NULL;
+    return 0;
+}
+
+static struct dirent* vfs_romfs_readdir(void* ctx, DIR* pdir)
+{
+    assert(pdir);
+    vfs_romfs_dir_t* dir = (vfs_romfs_dir_t*) pdir;
+    struct dirent* out_dirent;
+    vfs_romfs_readdir_r(ctx, pdir, &dir->e, &out_dirent);
+    return out_dirent;
+}
+
+static long vfs_romfs_telldir(void* ctx, DIR* pdir)
+{
+    assert(pdir);
+    return ((vfs_romfs_dir_t*) pdir)->next;
+}
+
+static void vfs_romfs_seekdir(void* ctx, DIR* pdir, long offset)
+{
+    assert(pdir);
+    // entries of the image don't move, so the index of the next entry is a stable position
+    ((vfs_romfs_dir_t*) pdir)->next = offset;
+}
+
+esp_err_t esp_vfs_romfs_register(const esp_vfs_romfs_conf_t * conf)
+{
+    assert(conf->base_path);
+    const esp_vfs_t vfs = {
+        .flags = ESP_VFS_FLAG_CONTEXT_PTR,
+        .write_p = &vfs_romfs_write,
+        .lseek_p = &vfs_romfs_lseek,
+        .read_p = &vfs_romfs_read,
+        .pread_p = &vfs_romfs_pread,
+        .open_p = &vfs_romfs_open,
+        .close_p = &vfs_romfs_close,
+        .fstat_p = &vfs_romfs_fstat,
+        .stat_p = &vfs_romfs_stat,
+        .opendir_p = &vfs_romfs_opendir,
+        .closedir_p = &vfs_romfs_closedir,
+        .readdir_p = &vfs_romfs_readdir,
+        .readdir_r_p = &vfs_romfs_readdir_r,
+        .seekdir_p = &vfs_romfs_seekdir,
+        .telldir_p = &vfs_romfs_telldir,
+    };
+
+    int index;
+    esp_err_t err = romfs_init(conf, &index);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    strlcpy(s_romfs[index]->base_path, conf->base_path, sizeof(s_romfs[index]->base_path));
+    err = esp_vfs_register(conf->base_path, &vfs, s_romfs[index]);
+    if (err != ESP_OK) {
+        romfs_free(&s_romfs[index]);
+        return err;
+    }
+    ESP_LOGD(TAG, "mounted \"%s\" with %u files at %s", conf->partition_label,
+            s_romfs[index]->header->file_count, conf->base_path);
+    return ESP_OK;
+}
+
+esp_err_t esp_vfs_romfs_unregister(const char* partition_label)
+{
+    int index;
+    if (partition_label == NULL || romfs_by_label(partition_label, &index) != ESP_OK) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t err = esp_vfs_unregister(s_romfs[index]->base_path);
+    if (err != ESP_OK) {
+        return err;
+    }
+    romfs_free(&s_romfs[index]);
+    return ESP_OK;
+}
+
+esp_err_t esp_romfs_get_file(const char* path, esp_romfs_file_t* out_file)
+{
+    for (int i = 0; i < CONFIG_ROMFS_MAX_PARTITIONS; i++) {
+        const esp_romfs_t* efs = s_romfs[i];
+        if (efs == NULL) {
+            continue;
+        }
+        size_t base_len = strlen(efs->base_path);
+        if (strncmp(path, efs->base_path, base_len) != 0 || path[base_len] != '/') {
+            continue;
+        }
+        const esp_romfs_entry_t* entry = romfs_find(efs, path + base_len);
+        if (entry) {
+            out_file->data = efs->image + entry->data_offset;
+            out_file->size = entry->size;
+            out_file->partition = efs->partition;
+            out_file->offset = entry->data_offset;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
@@ -0,0 +1,127 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _ESP_ROMFS_H_
+#define _ESP_ROMFS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_ROMFS_MAGIC     0x53464f52  /*!< "ROFS", first word of a ROMFS image */
+#define ESP_ROMFS_VERSION   1           /*!< Version of the image format */
+
+/**
+ * @brief Header at the start of a ROMFS image, as written by romfsgen.py
+ *
+ * All fields are little endian. The header is followed by file_count entries
+ * sorted by name, then by the zero-terminated file names. The data of the files
+ * follows, each file aligned to the alignment given to romfsgen.py.
+ */
+typedef struct {
+    uint32_t magic;         /*!< ESP_ROMFS_MAGIC */
+    uint16_t version;       /*!< ESP_ROMFS_VERSION */
+    uint16_t header_size;   /*!< Size of this header, the entries start at this offset */
+    uint32_t file_count;    /*!< Number of entries */
+    uint32_t index_size;    /*!< Size of the entries and the file names, in bytes */
+    uint32_t index_crc;     /*!< CRC32 of the entries and the file names */
+    uint32_t image_size;    /*!< Size of the whole image, in bytes */
+} esp_romfs_header_t;
+
+/**
+ * @brief Entry of a file in a ROMFS image
+ */
+typedef struct {
+    uint32_t name_offset;   /*!< Offset of the file name, e.g. "/css/style.css", from the start of the image */
+    uint32_t data_offset;   /*!< Offset of the file data from the start of the image */
+    uint32_t size;          /*!< Size of the file, in bytes */
+} esp_romfs_entry_t;
+
+/**
+ * @brief Configuration structure for esp_vfs_romfs_register
+ */
+typedef struct {
+        const char* base_path;          /*!< File path prefix associated with the filesystem. */
+        const char* partition_label;    /*!< Label of the data partition holding the image. */
+        size_t max_files;               /*!< Maximum files that could be open at the same time. */
+} esp_vfs_romfs_conf_t;
+
+/**
+ * @brief Location of a file in a mounted ROMFS image, see esp_romfs_get_file
+ */
+typedef struct {
+        const void* data;                   /*!< File data, mapped into the data address space */
+        size_t size;                        /*!< Size of the file, in bytes */
+        const esp_partition_t* partition;   /*!< Partition holding the image */
+        size_t offset;                      /*!< Offset of the file data in the partition */
+} esp_romfs_file_t;
+
+/**
+ * Mount a ROMFS image and register it to VFS with given path prefix.
+ *
+ * The whole image is mapped into the data address space with esp_partition_mmap(),
+ * so reading a file copies from the flash cache without going through the
+ * SPI flash driver. The image is read only: files can't be created, written or removed.
+ *
+ * @param   conf                      Pointer to esp_vfs_romfs_conf_t configuration structure
+ *
+ * @return
+ *          - ESP_OK                  if success
+ *          - ESP_ERR_INVALID_ARG     if partition_label is not set
+ *          - ESP_ERR_NO_MEM          if objects could not be allocated
+ *          - ESP_ERR_INVALID_STATE   if already mounted
+ *          - ESP_ERR_NOT_FOUND       if the partition was not found
+ *          - ESP_FAIL                if the partition does not hold a valid image, or it can't be mapped
+ */
+esp_err_t esp_vfs_romfs_register(const esp_vfs_romfs_conf_t * conf);
+
+/**
+ * Unregister ROMFS from VFS and unmap the image
+ *
+ * Pointers returned by esp_romfs_get_file are no longer valid afterwards.
+ *
+ * @param partition_label  Label of the partition to unregister.
+ *
+ * @return
+ *          - ESP_OK if successful
+ *          - ESP_ERR_INVALID_STATE already unregistered
+ */
+esp_err_t esp_vfs_romfs_unregister(const char* partition_label);
+
+/**
+ * Get the data of a file in a mounted ROMFS image, without copying it
+ *
+ * The data can be used directly, for example sent with httpd_send(), or the partition
+ * and offset passed to httpd_resp_send_partition(). It stays valid while the
+ * image is mounted.
+ *
+ * @param path           Path of the file in VFS, including the base path, e.g. "/www/index.html"
+ * @param[out] out_file  Location of the file
+ *
+ * @return
+ *          - ESP_OK                  if success
+ *          - ESP_ERR_NOT_FOUND       if no mounted ROMFS image has this file
+ */
+esp_err_t esp_romfs_get_file(const char* path, esp_romfs_file_t* out_file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_ROMFS_H_ */
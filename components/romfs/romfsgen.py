@@ -0,0 +1,129 @@
+#!/usr/bin/env python
+#
+# romfsgen is a tool used to generate a ROMFS image from a directory
+#
+# Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http:#www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from __future__ import division
+import os
+import struct
+import argparse
+import zlib
+
+# Based on esp_romfs_header_t and esp_romfs_entry_t in esp_romfs.h
+ROMFS_MAGIC = 0x53464f52
+ROMFS_VERSION = 1
+ROMFS_HEADER_FORMAT = "<IHHIIII"
+ROMFS_ENTRY_FORMAT = "<III"
+ROMFS_HEADER_SIZE = struct.calcsize(ROMFS_HEADER_FORMAT)
+ROMFS_ENTRY_SIZE = struct.calcsize(ROMFS_ENTRY_FORMAT)
+ROMFS_NAME_MAX = 255  # d_name of struct dirent holds 255 characters
+
+
+def align_up(value, alignment):
+    return (value + alignment - 1) // alignment * alignment
+
+
+class RomFS():
+    def __init__(self, image_size, alignment):
+        if alignment < 4 or alignment & (alignment - 1):
+            raise RuntimeError("alignment should be a power of two, at least 4")
+        self.image_size = image_size
+        self.alignment = alignment
+        self.files = {}
+
+    def create_file(self, name, file_path):
+        name = name.replace(os.sep, "/")
+        encoded = name.encode("utf-8")
+        if len(encoded) > ROMFS_NAME_MAX:
+            raise RuntimeError("file name %s is too long" % name)
+        if encoded in self.files:
+            raise RuntimeError("file %s added twice" % name)
+        with open(file_path, "rb") as f:
+            self.files[encoded] = f.read()
+
+    def to_binary(self):
+        # entries are sorted by the bytes of the name, as compared by strcmp()
+        names = sorted(self.files.keys())
+
+        names_start = ROMFS_HEADER_SIZE + len(names) * ROMFS_ENTRY_SIZE
+        name_offsets = []
+        name_table = b""
+        for name in names:
+            name_offsets.append(names_start + len(name_table))
+            name_table += name + b"\0"
+        index_size = align_up(len(names) * ROMFS_ENTRY_SIZE + len(name_table), 4)
+        name_table += b"\0" * (index_size - len(names) * ROMFS_ENTRY_SIZE - len(name_table))
+
+        entries = b""
+        data = b""
+        data_start = align_up(ROMFS_HEADER_SIZE + index_size, self.alignment)
+        for name, name_offset in zip(names, name_offsets):
+            content = self.files[name]
+            data_offset = data_start + len(data)
+            entries += struct.pack(ROMFS_ENTRY_FORMAT, name_offset, data_offset, len(content))
+            data += content
+            data += b"\0" * (align_up(len(data), self.alignment) - len(data))
+
+        index = entries + name_table
+        image_size = data_start + len(data)
+        if image_size > self.image_size:
+            raise RuntimeError("files need %d bytes, which is more than the image size %d" %
+                               (image_size, self.image_size))
+
+        header = struct.pack(ROMFS_HEADER_FORMAT, ROMFS_MAGIC, ROMFS_VERSION, ROMFS_HEADER_SIZE,
+                             len(names), index_size, zlib.crc32(index) & 0xFFFFFFFF, image_size)
+        padding = b"\0" * (data_start - ROMFS_HEADER_SIZE - index_size)
+        return header + index + padding + data
+
+
+def main():
+    parser = argparse.ArgumentParser(description="ROMFS Image Generator",
+                                     formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+
+    parser.add_argument("image_size",
+                        help="Size of the partition the image will be flashed to")
+
+    parser.add_argument("base_dir",
+                        help="Path to directory from which the image will be created")
+
+    parser.add_argument("output_file",
+                        help="Created image output file path")
+
+    parser.add_argument("--align",
+                        help="Alignment of the data of each file, in bytes.",
+                        type=int,
+                        default=4)
+
+    args = parser.parse_args()
+
+    if not os.path.exists(args.base_dir):
+        raise RuntimeError("given base directory %s does not exist" % args.base_dir)
+
+    romfs = RomFS(int(args.image_size, 0), args.align)
+
+    for root, dirs, files in os.walk(args.base_dir):
+        for f in files:
+            full_path = os.path.join(root, f)
+            romfs.create_file("/" + os.path.relpath(full_path, args.base_dir), full_path)
+
+    image = romfs.to_binary()
+
+    with open(args.output_file, "wb") as image_file:
+        image_file.write(image)
+
+
+if __name__ == "__main__":
+    main()
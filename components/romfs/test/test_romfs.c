@@ -0,0 +1,252 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/unistd.h>
+#include "unity.h"
+#include "test_utils.h"
+#include "esp_partition.h"
+#include "esp_romfs.h"
+#include "esp_vfs.h"
+#include "esp32/rom/crc.h"
+
+static const char* romfs_test_partition_label = "flash_test";
+
+typedef struct {
+    const char* name;
+    size_t size;
+} test_file_t;
+
+/* Same layout as romfsgen.py creates, names sorted. File i is filled with bytes i + offset. */
+static const test_file_t s_test_files[] = {
+    { "/empty", 0 },
+    { "/index.html", 100 },
+    { "/js/app.js", 5000 },
+    { "/js/lib/util.js", 33 },
+};
+#define TEST_FILE_COUNT (sizeof(s_test_files) / sizeof(s_test_files[0]))
+
+static void create_image(bool corrupt)
+{
+    const size_t names_start = sizeof(esp_romfs_header_t) + TEST_FILE_COUNT * sizeof(esp_romfs_entry_t);
+    size_t names_size = 0;
+    size_t data_size = 0;
+    for (int i = 0; i < TEST_FILE_COUNT; ++i) {
+        names_size += strlen(s_test_files[i].name) + 1;
+        data_size += (s_test_files[i].size + 3) & ~3;
+    }
+    names_size = (names_size + 3) & ~3;
+    const size_t data_start = names_start + names_size;
+    uint8_t* image = calloc(1, data_start + data_size);
+    TEST_ASSERT_NOT_NULL(image);
+
+    esp_romfs_header_t* header = (esp_romfs_header_t*) image;
+    esp_romfs_entry_t* entries = (esp_romfs_entry_t*) (image + sizeof(esp_romfs_header_t));
+    size_t name_offset = names_start;
+    size_t data_offset = data_start;
+    for (int i = 0; i < TEST_FILE_COUNT; ++i) {
+        entries[i].name_offset = name_offset;
+        entries[i].data_offset = data_offset;
+        entries[i].size = s_test_files[i].size;
+        strcpy((char*) image + name_offset, s_test_files[i].name);
+        for (int j = 0; j < s_test_files[i].size; ++j) {
+            image[data_offset + j] = (uint8_t) (i + j);
+        }
+        name_offset += strlen(s_test_files[i].name) + 1;
+        data_offset += (s_test_files[i].size + 3) & ~3;
+    }
+    header->magic = ESP_ROMFS_MAGIC;
+    header->version = ESP_ROMFS_VERSION;
+    header->header_size = sizeof(esp_romfs_header_t);
+    header->file_count = TEST_FILE_COUNT;
+    header->index_size = data_start - sizeof(esp_romfs_header_t);
+    header->index_crc = crc32_le(0, image + sizeof(esp_romfs_header_t), header->index_size);
+    header->image_size = data_offset;
+    if (corrupt) {
+        entries[1].size++;
+    }
+
+    const esp_partition_t* part = get_test_data_partition();
+    TEST_ASSERT_NOT_NULL(part);
+    TEST_ESP_OK(esp_partition_erase_range(part, 0, (data_offset + SPI_FLASH_SEC_SIZE - 1) & ~(SPI_FLASH_SEC_SIZE - 1)));
+    TEST_ESP_OK(esp_partition_write(part, 0, image, data_offset));
+    free(image);
+}
+
+static void test_setup()
+{
+    esp_vfs_romfs_conf_t conf = {
+      .base_path = "/romfs",
+      .partition_label = romfs_test_partition_label,
+      .max_files = 2,
+    };
+    create_image(false);
+    TEST_ESP_OK(esp_vfs_romfs_register(&conf));
+}
+
+static void test_teardown()
+{
+    TEST_ESP_OK(esp_vfs_romfs_unregister(romfs_test_partition_label));
+}
+
+static void check_file_data(const uint8_t* data, int file, size_t offset, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) {
+        TEST_ASSERT_EQUAL_HEX8((uint8_t) (file + offset + i), data[i]);
+    }
+}
+
+TEST_CASE("files can be read from ROMFS image", "[romfs]")
+{
+    test_setup();
+    uint8_t buf[600];
+    FILE* f = fopen("/romfs/js/app.js", "r");
+    TEST_ASSERT_NOT_NULL(f);
+    TEST_ASSERT_EQUAL(sizeof(buf), fread(buf, 1, sizeof(buf), f));
+    check_file_data(buf, 2, 0, sizeof(buf));
+    TEST_ASSERT_EQUAL(0, fseek(f, -100, SEEK_END));
+    TEST_ASSERT_EQUAL(100, fread(buf, 1, sizeof(buf), f));
+    check_file_data(buf, 2, 4900, 100);
+    TEST_ASSERT_TRUE(feof(f));
+    TEST_ASSERT_EQUAL(0, fclose(f));
+
+    int fd = open("/romfs/index.html", O_RDONLY);
+    TEST_ASSERT_TRUE(fd >= 0);
+    TEST_ASSERT_EQUAL(10, pread(fd, buf, 10, 50));
+    check_file_data(buf, 1, 50, 10);
+    TEST_ASSERT_EQUAL(0, pread(fd, buf, 10, 100));
+    TEST_ASSERT_EQUAL(100, read(fd, buf, sizeof(buf)));
+    check_file_data(buf, 1, 0, 100);
+    TEST_ASSERT_EQUAL(0, read(fd, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL(0, close(fd));
+
+    fd = open("/romfs/empty", O_RDONLY);
+    TEST_ASSERT_TRUE(fd >= 0);
+    TEST_ASSERT_EQUAL(0, read(fd, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL(0, close(fd));
+    test_teardown();
+}
+
+TEST_CASE("ROMFS image is read only", "[romfs]")
+{
+    test_setup();
+    TEST_ASSERT_NULL(fopen("/romfs/index.html", "w"));
+    TEST_ASSERT_EQUAL(EROFS, errno);
+    TEST_ASSERT_NULL(fopen("/romfs/new.txt", "a"));
+    TEST_ASSERT_EQUAL(EROFS, errno);
+    TEST_ASSERT_EQUAL(-1, open("/romfs/index.html", O_RDWR));
+    TEST_ASSERT_EQUAL(EROFS, errno);
+    TEST_ASSERT_NULL(fopen("/romfs/missing.txt", "r"));
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+    TEST_ASSERT_EQUAL(-1, unlink("/romfs/index.html"));
+
+    int fd = open("/romfs/index.html", O_RDONLY);
+    TEST_ASSERT_TRUE(fd >= 0);
+    TEST_ASSERT_EQUAL(-1, write(fd, "x", 1));
+    TEST_ASSERT_EQUAL(0, close(fd));
+    test_teardown();
+}
+
+TEST_CASE("number of open files in ROMFS image is limited", "[romfs]")
+{
+    test_setup();
+    int fd1 = open("/romfs/index.html", O_RDONLY);
+    int fd2 = open("/romfs/index.html", O_RDONLY);
+    TEST_ASSERT_TRUE(fd1 >= 0);
+    TEST_ASSERT_TRUE(fd2 >= 0);
+    TEST_ASSERT_EQUAL(-1, open("/romfs/empty", O_RDONLY));
+    TEST_ASSERT_EQUAL(ENFILE, errno);
+    TEST_ASSERT_EQUAL(0, close(fd1));
+    fd1 = open("/romfs/empty", O_RDONLY);
+    TEST_ASSERT_TRUE(fd1 >= 0);
+    TEST_ASSERT_EQUAL(0, close(fd1));
+    TEST_ASSERT_EQUAL(0, close(fd2));
+    test_teardown();
+}
+
+TEST_CASE("stat and readdir work in ROMFS image", "[romfs]")
+{
+    test_setup();
+    struct stat st;
+    TEST_ASSERT_EQUAL(0, stat("/romfs/js/lib/util.js", &st));
+    TEST_ASSERT_EQUAL(33, st.st_size);
+    TEST_ASSERT_TRUE(S_ISREG(st.st_mode));
+    TEST_ASSERT_EQUAL(-1, stat("/romfs/js", &st));
+
+    DIR* dir = opendir("/romfs/js");
+    TEST_ASSERT_NOT_NULL(dir);
+    struct dirent* de = readdir(dir);
+    TEST_ASSERT_NOT_NULL(de);
+    TEST_ASSERT_EQUAL_STRING("app.js", de->d_name);
+    long pos = telldir(dir);
+    de = readdir(dir);
+    TEST_ASSERT_NOT_NULL(de);
+    TEST_ASSERT_EQUAL_STRING("lib/util.js", de->d_name);
+    TEST_ASSERT_NULL(readdir(dir));
+    seekdir(dir, pos);
+    de = readdir(dir);
+    TEST_ASSERT_NOT_NULL(de);
+    TEST_ASSERT_EQUAL_STRING("lib/util.js", de->d_name);
+    TEST_ASSERT_EQUAL(0, closedir(dir));
+
+    dir = opendir("/romfs");
+    TEST_ASSERT_NOT_NULL(dir);
+    int count = 0;
+    while ((de = readdir(dir)) != NULL) {
+        TEST_ASSERT_EQUAL_STRING(s_test_files[count].name + 1, de->d_name);
+        ++count;
+    }
+    TEST_ASSERT_EQUAL(TEST_FILE_COUNT, count);
+    TEST_ASSERT_EQUAL(0, closedir(dir));
+    test_teardown();
+}
+
+TEST_CASE("ROMFS file data can be used without copying", "[romfs]")
+{
+    test_setup();
+    esp_romfs_file_t file;
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, esp_romfs_get_file("/romfs/missing.txt", &file));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, esp_romfs_get_file("/romfsjs/app.js", &file));
+    TEST_ESP_OK(esp_romfs_get_file("/romfs/js/app.js", &file));
+    TEST_ASSERT_EQUAL(5000, file.size);
+    TEST_ASSERT_EQUAL_PTR(get_test_data_partition(), file.partition);
+    check_file_data(file.data, 2, 0, file.size);
+
+    uint8_t buf[16];
+    TEST_ESP_OK(esp_partition_read(file.partition, file.offset + 1000, buf, sizeof(buf)));
+    check_file_data(buf, 2, 1000, sizeof(buf));
+    test_teardown();
+}
+
+TEST_CASE("invalid ROMFS image is not mounted", "[romfs]")
+{
+    esp_vfs_romfs_conf_t conf = {
+      .base_path = "/romfs",
+      .partition_label = romfs_test_partition_label,
+      .max_files = 2,
+    };
+    create_image(true);
+    TEST_ASSERT_EQUAL(ESP_FAIL, esp_vfs_romfs_register(&conf));
+
+    const esp_partition_t* part = get_test_data_partition();
+    TEST_ESP_OK(esp_partition_erase_range(part, 0, SPI_FLASH_SEC_SIZE));
+    TEST_ASSERT_EQUAL(ESP_FAIL, esp_vfs_romfs_register(&conf));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, esp_vfs_romfs_unregister(romfs_test_partition_label));
+}
@@ -335,6 +335,17 @@ esp_err_t sdmmc_send_cmd_set_bus_width(sdmmc_card_t* card, int width)
     return sdmmc_send_app_cmd(card, &cmd);
 }
 
+esp_err_t sdmmc_send_cmd_set_wr_blk_erase_count(sdmmc_card_t* card, size_t block_count)
+{
+    sdmmc_command_t cmd = {
+            .opcode = SD_APP_SET_WR_BLK_ERASE_COUNT,
+            .flags = SCF_RSP_R1 | SCF_CMD_AC,
+            .arg = block_count & 0x7fffff,  // 23 bits
+    };
+
+    return sdmmc_send_app_cmd(card, &cmd);
+}
+
 esp_err_t sdmmc_send_cmd_crc_on_off(sdmmc_card_t* card, bool crc_enable)
 {
     assert(host_is_spi(card) && "CRC_ON_OFF can only be used in SPI mode");
@@ -363,26 +374,75 @@ esp_err_t sdmmc_send_cmd_send_status(sdmmc_card_t* card, uint32_t* out_status)
     return ESP_OK;
 }
 
+static void* alloc_bounce_buffer(size_t block_size, size_t block_count, size_t* out_blocks)
+{
+    size_t blocks = SDMMC_MAX_BOUNCE_BUF_SIZE / block_size;
+    if (blocks == 0) {
+        blocks = 1;
+    }
+    if (blocks > block_count) {
+        blocks = block_count;
+    }
+    while (true) {
+        void* buf = heap_caps_malloc(blocks * block_size, MALLOC_CAP_DMA);
+        if (buf != NULL || blocks == 1) {
+            *out_blocks = blocks;
+            return buf;
+        }
+        blocks /= 2;
+    }
+}
+
+typedef struct {
+    sdmmc_card_t* card;
+    size_t start_block;
+} bounce_stream_arg_t;
+
+static esp_err_t bounce_write_chunk(void* buf, size_t offset, size_t len, void* arg)
+{
+    bounce_stream_arg_t* s = (bounce_stream_arg_t*) arg;
+    size_t block_size = s->card->csd.sector_size;
+    return sdmmc_write_sectors_dma(s->card, buf, s->start_block + offset / block_size, len / block_size);
+}
+
+static esp_err_t bounce_read_chunk(void* buf, size_t offset, size_t len, void* arg)
+{
+    bounce_stream_arg_t* s = (bounce_stream_arg_t*) arg;
+    size_t block_size = s->card->csd.sector_size;
+    return sdmmc_read_sectors_dma(s->card, buf, s->start_block + offset / block_size, len / block_size);
+}
+
 esp_err_t sdmmc_write_sectors(sdmmc_card_t* card, const void* src,
         size_t start_block, size_t block_count)
 {
-    esp_err_t err = ESP_OK;
+    esp_err_t err = ESP_ERR_NO_MEM;
     size_t block_size = card->csd.sector_size;
     if (esp_ptr_dma_capable(src) && (intptr_t)src % 4 == 0) {
-        err = sdmmc_write_sectors_dma(card, src, start_block, block_count);
-    } else {
+        return sdmmc_write_sectors_dma(card, src, start_block, block_count);
+    }
+    // Prefer the chunks of the shared bounce pool, if there is one
+    if (esp_dma_bounce_chunk_size() >= block_size) {
+        bounce_stream_arg_t arg = { .card = card, .start_block = start_block };
+        esp_dma_bounce_stream_t stream = { .start = &bounce_write_chunk, .arg = &arg, .align = block_size };
+        err = esp_dma_bounce_tx(&stream, src, block_count * block_size);
+    }
+    // ESP_ERR_NO_MEM: no pool, or all of its chunks are in use
+    if (err == ESP_ERR_NO_MEM) {
+        err = ESP_OK;
         // SDMMC peripheral needs DMA-capable buffers. Split the write into
-        // separate single block writes, if needed, and allocate a temporary
-        // DMA-capable buffer.
-        void* tmp_buf = heap_caps_malloc(block_size, MALLOC_CAP_DMA);
+        // chunks which fit into a temporary DMA-capable buffer, so that
+        // multi-block writes can still be used.
+        size_t chunk_blocks = 0;
+        void* tmp_buf = alloc_bounce_buffer(block_size, block_count, &chunk_blocks);
         if (tmp_buf == NULL) {
             return ESP_ERR_NO_MEM;
         }
         const uint8_t* cur_src = (const uint8_t*) src;
-        for (size_t i = 0; i < block_count; ++i) {
-            memcpy(tmp_buf, cur_src, block_size);
-            cur_src += block_size;
-            err = sdmmc_write_sectors_dma(card, tmp_buf, start_block + i, 1);
+        for (size_t i = 0; i < block_count; i += chunk_blocks) {
+            size_t count = MIN(chunk_blocks, block_count - i);
+            memcpy(tmp_buf, cur_src, count * block_size);
+            cur_src += count * block_size;
+            err = sdmmc_write_sectors_dma(card, tmp_buf, start_block + i, count);
             if (err != ESP_OK) {
                 ESP_LOGD(TAG, "%s: error 0x%x writing block %d+%d",
                         __func__, err, start_block, i);
@@ -412,6 +472,15 @@ esp_err_t sdmmc_write_sectors_dma(sdmmc_card_t* card, const void* src,
         cmd.opcode = MMC_WRITE_BLOCK_SINGLE;
     } else {
         cmd.opcode = MMC_WRITE_BLOCK_MULTIPLE;
+        if (!card->is_mmc) {
+            // Let the SD card erase the blocks before they are written,
+            // which speeds up multi-block writes. This is only a hint,
+            // so the write goes ahead if the card rejects it.
+            esp_err_t err = sdmmc_send_cmd_set_wr_blk_erase_count(card, block_count);
+            if (err != ESP_OK) {
+                ESP_LOGD(TAG, "%s: SET_WR_BLK_ERASE_COUNT returned 0x%x", __func__, err);
+            }
+        }
     }
     if (card->ocr & SD_OCR_SDHC_CAP) {
         cmd.arg = start_block;
@@ -441,28 +510,37 @@ esp_err_t sdmmc_write_sectors_dma(sdmmc_card_t* card, const void* src,
 esp_err_t sdmmc_read_sectors(sdmmc_card_t* card, void* dst,
         size_t start_block, size_t block_count)
 {
-    esp_err_t err = ESP_OK;
+    esp_err_t err = ESP_ERR_NO_MEM;
     size_t block_size = card->csd.sector_size;
     if (esp_ptr_dma_capable(dst) && (intptr_t)dst % 4 == 0) {
-        err = sdmmc_read_sectors_dma(card, dst, start_block, block_count);
-    } else {
+        return sdmmc_read_sectors_dma(card, dst, start_block, block_count);
+    }
+    if (esp_dma_bounce_chunk_size() >= block_size) {
+        bounce_stream_arg_t arg = { .card = card, .start_block = start_block };
+        esp_dma_bounce_stream_t stream = { .start = &bounce_read_chunk, .arg = &arg, .align = block_size };
+        err = esp_dma_bounce_rx(&stream, dst, block_count * block_size);
+    }
+    if (err == ESP_ERR_NO_MEM) {
+        err = ESP_OK;
         // SDMMC peripheral needs DMA-capable buffers. Split the read into
-        // separate single block reads, if needed, and allocate a temporary
-        // DMA-capable buffer.
-        void* tmp_buf = heap_caps_malloc(block_size, MALLOC_CAP_DMA);
+        // chunks which fit into a temporary DMA-capable buffer, so that
+        // multi-block reads can still be used.
+        size_t chunk_blocks = 0;
+        void* tmp_buf = alloc_bounce_buffer(block_size, block_count, &chunk_blocks);
         if (tmp_buf == NULL) {
             return ESP_ERR_NO_MEM;
         }
         uint8_t* cur_dst = (uint8_t*) dst;
-        for (size_t i = 0; i < block_count; ++i) {
-            err = sdmmc_read_sectors_dma(card, tmp_buf, start_block + i, 1);
+        for (size_t i = 0; i < block_count; i += chunk_blocks) {
+            size_t count = MIN(chunk_blocks, block_count - i);
+            err = sdmmc_read_sectors_dma(card, tmp_buf, start_block + i, count);
             if (err != ESP_OK) {
-                ESP_LOGD(TAG, "%s: error 0x%x writing block %d+%d",
+                ESP_LOGD(TAG, "%s: error 0x%x reading block %d+%d",
                         __func__, err, start_block, i);
                 break;
             }
-            memcpy(cur_dst, tmp_buf, block_size);
-            cur_dst += block_size;
+            memcpy(cur_dst, tmp_buf, count * block_size);
+            cur_dst += count * block_size;
         }
         free(tmp_buf);
     }
@@ -26,6 +26,7 @@
 #include "sdmmc_cmd.h"
 #include "sys/param.h"
 #include "soc/soc_memory_layout.h"
+#include "esp32/dma_bounce.h"
 
 #define SDMMC_GO_IDLE_DELAY_MS              20
 #define SDMMC_IO_SEND_OP_COND_DELAY_MS      10
@@ -44,6 +45,12 @@
 #define SDMMC_SEND_OP_COND_MAX_RETRIES  100
 #define SDMMC_SEND_OP_COND_MAX_ERRORS   3
 
+/* Maximum size of the DMA-capable buffer used to read and write sectors
+ * from/to buffers which are not DMA-capable. Allocation falls back to smaller
+ * sizes, down to a single sector, if there is not enough free DMA memory.
+ */
+#define SDMMC_MAX_BOUNCE_BUF_SIZE       4096
+
 /* Functions to send individual commands */
 esp_err_t sdmmc_send_cmd(sdmmc_card_t* card, sdmmc_command_t* cmd);
 esp_err_t sdmmc_send_app_cmd(sdmmc_card_t* card, sdmmc_command_t* cmd);
@@ -62,6 +69,7 @@ esp_err_t sdmmc_send_cmd_send_csd(sdmmc_card_t* card, sdmmc_csd_t* out_csd);
 esp_err_t sdmmc_send_cmd_select_card(sdmmc_card_t* card, uint32_t rca);
 esp_err_t sdmmc_send_cmd_send_scr(sdmmc_card_t* card, sdmmc_scr_t *out_scr);
 esp_err_t sdmmc_send_cmd_set_bus_width(sdmmc_card_t* card, int width);
+esp_err_t sdmmc_send_cmd_set_wr_blk_erase_count(sdmmc_card_t* card, size_t block_count);
 esp_err_t sdmmc_send_cmd_send_status(sdmmc_card_t* card, uint32_t* out_status);
 esp_err_t sdmmc_send_cmd_crc_on_off(sdmmc_card_t* card, bool crc_enable);
 
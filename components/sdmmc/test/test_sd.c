@@ -367,6 +367,40 @@ TEST_CASE("reads and writes with an unaligned buffer", "[sd][test_env=UT_T1_SDMO
     sd_test_board_power_off();
 }
 
+TEST_CASE("reads and writes with an unaligned buffer larger than the bounce buffer", "[sd][test_env=UT_T1_SDMODE]")
+{
+    sd_test_board_power_on();
+    sdmmc_host_t config = SDMMC_HOST_DEFAULT();
+    sdmmc_slot_config_t slot_config = SDMMC_SLOT_CONFIG_DEFAULT();
+    TEST_ESP_OK(sdmmc_host_init());
+
+    TEST_ESP_OK(sdmmc_host_init_slot(SDMMC_HOST_SLOT_1, &slot_config));
+    sdmmc_card_t* card = malloc(sizeof(sdmmc_card_t));
+    TEST_ASSERT_NOT_NULL(card);
+    TEST_ESP_OK(sdmmc_card_init(&config, card));
+
+    // 20 blocks: several full chunks of the bounce buffer and a partial one
+    const size_t block_count = 20;
+    const size_t buffer_size = block_count * 512;
+    uint8_t* buffer = heap_caps_malloc(buffer_size + 4, MALLOC_CAP_DMA);
+    TEST_ASSERT_NOT_NULL(buffer);
+
+    const uint32_t seed = 0x01234567;
+    fill_buffer(seed, buffer + 1, buffer_size / sizeof(uint32_t));
+    TEST_ESP_OK(sdmmc_write_sectors(card, buffer + 1, 16, block_count));
+    memset(buffer, 0xcc, buffer_size + 4);
+    TEST_ESP_OK(sdmmc_read_sectors(card, buffer, 16, block_count));
+    check_buffer(seed, buffer, buffer_size / sizeof(uint32_t));
+    memset(buffer, 0xcc, buffer_size + 4);
+    TEST_ESP_OK(sdmmc_read_sectors(card, buffer + 3, 16, block_count));
+    check_buffer(seed, buffer + 3, buffer_size / sizeof(uint32_t));
+
+    free(buffer);
+    free(card);
+    TEST_ESP_OK(sdmmc_host_deinit());
+    sd_test_board_power_off();
+}
+
 static void test_cd_input(int gpio_cd_num, const sdmmc_host_t* config)
 {
     sdmmc_card_t* card = malloc(sizeof(sdmmc_card_t));
@@ -24,12 +24,18 @@
 #include <esp32/rom/cache.h>
 #include <soc/soc.h>
 #include <soc/dport_reg.h>
+#include <soc/cpu.h>
+#include <soc/soc_memory_layout.h>
 #include "sdkconfig.h"
 #include "esp_ipc.h"
 #include "esp_attr.h"
 #include "esp_intr_alloc.h"
 #include "esp_spi_flash.h"
 #include "esp_log.h"
+#include "cache_utils.h"
+#if CONFIG_SPI_FLASH_ENABLE_HISTOGRAMS
+#include "esp32/clk.h"
+#endif
 
 
 static void IRAM_ATTR spi_flash_disable_cache(uint32_t cpuid, uint32_t* saved_state);
@@ -37,6 +43,14 @@ static void IRAM_ATTR spi_flash_restore_cache(uint32_t cpuid, uint32_t saved_sta
 
 static uint32_t s_flash_op_cache_state[2];
 
+#if defined(CONFIG_SPIRAM_ALLOW_STACK_EXTERNAL_MEMORY) && !defined(NDEBUG)
+// The stack of the task disabling the cache can't be in external memory. This
+// catches tasks with a stack in PSRAM (xTaskCreateWithCaps) using the flash.
+#define spi_flash_check_task_stack()    assert(esp_ptr_internal(get_sp()))
+#else
+#define spi_flash_check_task_stack()
+#endif
+
 #ifndef CONFIG_FREERTOS_UNICORE
 static SemaphoreHandle_t s_flash_op_mutex;
 static volatile bool s_flash_op_can_start = false;
@@ -69,6 +83,9 @@ void spi_flash_op_unlock()
 
 void IRAM_ATTR spi_flash_op_block_func(void* arg)
 {
+#if CONFIG_SPI_FLASH_ENABLE_HISTOGRAMS
+    uint32_t ts_begin = xthal_get_ccount();
+#endif
     // Disable scheduler on this CPU
     vTaskSuspendAll();
     // Restore interrupts that aren't located in IRAM
@@ -84,6 +101,9 @@ void IRAM_ATTR spi_flash_op_block_func(void* arg)
     }
     // Flash operation is complete, re-enable cache
     spi_flash_restore_cache(cpuid, s_flash_op_cache_state[cpuid]);
+#if CONFIG_SPI_FLASH_ENABLE_HISTOGRAMS
+    spi_flash_histogram_add_stall((xthal_get_ccount() - ts_begin) / (esp_clk_cpu_freq() / 1000000));
+#endif
     // Restore interrupts that aren't located in IRAM
     esp_intr_noniram_enable();
     // Re-enable scheduler
@@ -93,6 +113,7 @@ void IRAM_ATTR spi_flash_op_block_func(void* arg)
 void IRAM_ATTR spi_flash_disable_interrupts_caches_and_other_cpu()
 {
     spi_flash_op_lock();
+    spi_flash_check_task_stack();
 
     const uint32_t cpuid = xPortGetCoreID();
     const uint32_t other_cpuid = (cpuid == 0) ? 1 : 0;
@@ -221,6 +242,7 @@ void spi_flash_op_unlock()
 void IRAM_ATTR spi_flash_disable_interrupts_caches_and_other_cpu()
 {
     spi_flash_op_lock();
+    spi_flash_check_task_stack();
     esp_intr_noniram_disable();
     spi_flash_disable_cache(0, &s_flash_op_cache_state[0]);
 }
@@ -54,4 +54,9 @@ void spi_flash_enable_interrupts_caches_no_os();
 // Returns true if cache was flushed, false otherwise
 bool spi_flash_check_and_flush_cache(uint32_t start_addr, uint32_t length);
 
+#if CONFIG_SPI_FLASH_ENABLE_HISTOGRAMS
+// Record time spent by the other CPU blocked while a flash operation was in progress
+void spi_flash_histogram_add_stall(uint32_t time_us);
+#endif
+
 #endif //ESP_SPI_FLASH_CACHE_UTILS_H
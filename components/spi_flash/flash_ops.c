@@ -34,10 +34,19 @@
 #include "esp_flash_partitions.h"
 #include "esp_ota_ops.h"
 #include "cache_utils.h"
+#if CONFIG_SPI_FLASH_READ_CACHE
+#include "esp_heap_caps.h"
+#endif
+#if CONFIG_SPI_FLASH_MMAP_READ
+#include "esp_flash_encrypt.h"
+#endif
 
 /* bytes erased by SPIEraseBlock() ROM function */
 #define BLOCK_ERASE_SIZE 65536
 
+/* bytes programmed by spi_flash_writev in one guarded section */
+#define WRITEV_PAGE_SIZE 256
+
 /* Limit number of bytes written/read in a single SPI operation,
    as these operations disable all higher priority tasks from running.
 */
@@ -50,10 +59,12 @@ static const char *TAG __attribute__((unused)) = "spi_flash";
 static spi_flash_counters_t s_flash_stats;
 
 #define COUNTER_START()     uint32_t ts_begin = xthal_get_ccount()
-#define COUNTER_STOP(counter)  \
+#define COUNTER_STOP(counter, size)  \
     do{ \
+        uint32_t op_time = (xthal_get_ccount() - ts_begin) / (esp_clk_cpu_freq() / 1000000); \
         s_flash_stats.counter.count++; \
-        s_flash_stats.counter.time += (xthal_get_ccount() - ts_begin) / (esp_clk_cpu_freq() / 1000000); \
+        s_flash_stats.counter.time += op_time; \
+        HISTOGRAM_ADD(counter, size, op_time); \
     } while(0)
 
 #define COUNTER_ADD_BYTES(counter, size) \
@@ -61,15 +72,48 @@ static spi_flash_counters_t s_flash_stats;
         s_flash_stats.counter.bytes += size; \
     } while (0)
 
+#if CONFIG_SPI_FLASH_ENABLE_HISTOGRAMS
+static spi_flash_histograms_t s_flash_hist;
+
+static inline spi_flash_size_class_t IRAM_ATTR spi_flash_size_class(size_t size)
+{
+    if (size <= 256) {
+        return SPI_FLASH_SIZE_CLASS_SMALL;
+    } else if (size <= SPI_FLASH_SEC_SIZE) {
+        return SPI_FLASH_SIZE_CLASS_SECTOR;
+    }
+    return SPI_FLASH_SIZE_CLASS_LARGE;
+}
+
+static inline void IRAM_ATTR spi_flash_histogram_add(spi_flash_histogram_t *hist, uint32_t time)
+{
+    int bucket = (time < 2) ? 0 : 31 - __builtin_clz(time);
+    hist->bucket[MIN(bucket, SPI_FLASH_HISTOGRAM_BUCKETS - 1)]++;
+    hist->max_time = MAX(hist->max_time, time);
+}
+
+#define HISTOGRAM_ADD(counter, size, time) \
+    spi_flash_histogram_add(&s_flash_hist.counter[spi_flash_size_class(size)], time)
+#else
+#define HISTOGRAM_ADD(counter, size, time)
+#endif //CONFIG_SPI_FLASH_ENABLE_HISTOGRAMS
+
 #else
 #define COUNTER_START()
-#define COUNTER_STOP(counter)
+#define COUNTER_STOP(counter, size)
 #define COUNTER_ADD_BYTES(counter, size)
 
 #endif //CONFIG_SPI_FLASH_ENABLE_COUNTERS
 
 static esp_err_t spi_flash_translate_rc(esp_rom_spiflash_result_t rc);
 static bool is_safe_write_address(size_t addr, size_t size);
+static esp_err_t spi_flash_read_uncached(size_t src, void *dstv, size_t size);
+
+#if CONFIG_SPI_FLASH_READ_CACHE
+static void spi_flash_read_cache_invalidate(size_t start_addr, size_t size);
+#else
+#define spi_flash_read_cache_invalidate(start_addr, size)
+#endif
 
 const DRAM_ATTR spi_flash_guard_funcs_t g_flash_guard_default_ops = {
     .start                  = spi_flash_disable_interrupts_caches_and_other_cpu,
@@ -237,15 +281,225 @@ esp_err_t IRAM_ATTR spi_flash_erase_range(uint32_t start_addr, uint32_t size)
             spi_flash_guard_end();
         }
     }
-    COUNTER_STOP(erase);
+    COUNTER_STOP(erase, size);
+
+    spi_flash_guard_start();
+    spi_flash_check_and_flush_cache(start_addr, size);
+    spi_flash_guard_end();
+    spi_flash_read_cache_invalidate(start_addr, size);
+
+    return spi_flash_translate_rc(rc);
+}
+
+#if CONFIG_SPI_FLASH_ERASE_SUSPEND
+/* Erase suspend and resume commands, supported by most GigaDevice, Winbond
+   and ISSI flash chips. Chips which don't support them ignore the commands,
+   which makes the erase below run to completion in one window.
+*/
+#define CMD_ERASE_SUSPEND 0x75
+#define CMD_ERASE_RESUME  0x7A
+
+extern uint8_t g_rom_spiflash_dummy_len_plus[];
+
+/* Read the status register once. Unlike esp_rom_spiflash_read_status,
+   this doesn't wait for the flash chip to become idle. */
+static uint32_t IRAM_ATTR spi_flash_read_status_once()
+{
+    uint32_t status;
+    if (g_rom_spiflash_dummy_len_plus[1] == 0) {
+        WRITE_PERI_REG(PERIPHS_SPI_FLASH_STATUS, 0);
+        WRITE_PERI_REG(PERIPHS_SPI_FLASH_CMD, SPI_FLASH_RDSR);
+        while (READ_PERI_REG(PERIPHS_SPI_FLASH_CMD) != 0) {
+        }
+        status = READ_PERI_REG(PERIPHS_SPI_FLASH_STATUS) & g_rom_flashchip.status_mask;
+    } else {
+        esp_rom_spiflash_read_user_cmd(&status, 0x05);
+    }
+    return status;
+}
+
+/* Send a command which has no address and no data phase */
+static void IRAM_ATTR spi_flash_send_cmd(uint8_t command)
+{
+    uint32_t user = READ_PERI_REG(PERIPHS_SPI_FLASH_USRREG);
+    uint32_t user2 = READ_PERI_REG(PERIPHS_SPI_FLASH_USRREG2);
+    WRITE_PERI_REG(PERIPHS_SPI_FLASH_USRREG, SPI_USR_COMMAND);
+    WRITE_PERI_REG(PERIPHS_SPI_FLASH_USRREG2, (7 << SPI_USR_COMMAND_BITLEN_S) | command);
+    WRITE_PERI_REG(PERIPHS_SPI_FLASH_CMD, SPI_USR);
+    while (READ_PERI_REG(PERIPHS_SPI_FLASH_CMD) != 0) {
+    }
+    WRITE_PERI_REG(PERIPHS_SPI_FLASH_USRREG, user);
+    WRITE_PERI_REG(PERIPHS_SPI_FLASH_USRREG2, user2);
+}
+
+/* Start erasing a sector or a block, without waiting for the erase to finish */
+static void IRAM_ATTR spi_flash_erase_begin(uint32_t addr, bool block)
+{
+    REG_CLR_BIT(PERIPHS_SPI_FLASH_USRREG, SPI_USR_DUMMY);
+    REG_SET_FIELD(PERIPHS_SPI_FLASH_USRREG1, SPI_USR_ADDR_BITLEN, ESP_ROM_SPIFLASH_W_SIO_ADDR_BITSLEN);
+    esp_rom_spiflash_wait_idle(&g_rom_flashchip);
+
+    WRITE_PERI_REG(PERIPHS_SPI_FLASH_CMD, SPI_FLASH_WREN);
+    while (READ_PERI_REG(PERIPHS_SPI_FLASH_CMD) != 0) {
+    }
+    while ((spi_flash_read_status_once() & ESP_ROM_SPIFLASH_WRENABLE_FLAG) == 0) {
+    }
+
+    WRITE_PERI_REG(PERIPHS_SPI_FLASH_ADDR, addr & 0xffffff);
+    WRITE_PERI_REG(PERIPHS_SPI_FLASH_CMD, block ? SPI_FLASH_BE : SPI_FLASH_SE);
+    while (READ_PERI_REG(PERIPHS_SPI_FLASH_CMD) != 0) {
+    }
+}
+
+/* Erase one sector or block. The flash chip is polled for at most
+   window_cycles CPU cycles at a time. If the erase isn't done by then, it is
+   suspended and the cache is re-enabled, so that other tasks and interrupts
+   can run until the erase is resumed. Must be called holding the op lock, so
+   that no other flash operation starts while the erase is suspended.
+*/
+static void IRAM_ATTR spi_flash_erase_suspendable(uint32_t addr, bool block, uint32_t window_cycles)
+{
+    spi_flash_guard_start();
+    spi_flash_erase_begin(addr, block);
+    while (true) {
+        uint32_t begin = xthal_get_ccount();
+        bool busy;
+        do {
+            busy = (spi_flash_read_status_once() & ESP_ROM_SPIFLASH_BUSY_FLAG) != 0;
+        } while (busy && xthal_get_ccount() - begin < window_cycles);
+        if (!busy) {
+            break;
+        }
+        spi_flash_send_cmd(CMD_ERASE_SUSPEND);
+        // chip becomes idle once suspended (or once the erase is done,
+        // if it doesn't support suspend)
+        while (spi_flash_read_status_once() & ESP_ROM_SPIFLASH_BUSY_FLAG) {
+        }
+        spi_flash_guard_end();
+        taskYIELD();
+        spi_flash_guard_start();
+        spi_flash_send_cmd(CMD_ERASE_RESUME);
+    }
+    spi_flash_guard_end();
+}
+#endif // CONFIG_SPI_FLASH_ERASE_SUSPEND
+
+/* Erase a range of sectors without keeping the other CPU and the cache
+   disabled for the whole operation. Called from the async erase task.
+*/
+static esp_err_t IRAM_ATTR spi_flash_erase_range_preemptible(uint32_t start_addr, uint32_t size)
+{
+    size_t start = start_addr / SPI_FLASH_SEC_SIZE;
+    size_t end = start + size / SPI_FLASH_SEC_SIZE;
+    COUNTER_START();
+    esp_rom_spiflash_result_t rc;
+    rc = spi_flash_unlock();
+#if CONFIG_SPI_FLASH_ERASE_SUSPEND
+    const size_t sectors_per_block = BLOCK_ERASE_SIZE / SPI_FLASH_SEC_SIZE;
+    const uint32_t window_cycles = CONFIG_SPI_FLASH_ERASE_SUSPEND_WINDOW_US * (esp_clk_cpu_freq() / 1000000);
+    spi_flash_guard_op_lock();
+    for (size_t sector = start; sector != end && rc == ESP_ROM_SPIFLASH_RESULT_OK; ) {
+        if (sector % sectors_per_block == 0 && end - sector >= sectors_per_block) {
+            spi_flash_erase_suspendable(sector * SPI_FLASH_SEC_SIZE, true, window_cycles);
+            sector += sectors_per_block;
+            COUNTER_ADD_BYTES(erase, sectors_per_block * SPI_FLASH_SEC_SIZE);
+        } else {
+            spi_flash_erase_suspendable(sector * SPI_FLASH_SEC_SIZE, false, window_cycles);
+            ++sector;
+            COUNTER_ADD_BYTES(erase, SPI_FLASH_SEC_SIZE);
+        }
+    }
+    spi_flash_guard_op_unlock();
+#else
+    // Without erase suspend, use sector erase only, which keeps each
+    // guarded window to the duration of a single sector erase.
+    for (size_t sector = start; sector != end && rc == ESP_ROM_SPIFLASH_RESULT_OK; ++sector) {
+        spi_flash_guard_start();
+        rc = esp_rom_spiflash_erase_sector(sector);
+        spi_flash_guard_end();
+        COUNTER_ADD_BYTES(erase, SPI_FLASH_SEC_SIZE);
+        taskYIELD();
+    }
+#endif
+    COUNTER_STOP(erase, size);
 
     spi_flash_guard_start();
     spi_flash_check_and_flush_cache(start_addr, size);
     spi_flash_guard_end();
+    spi_flash_read_cache_invalidate(start_addr, size);
 
     return spi_flash_translate_rc(rc);
 }
 
+typedef struct {
+    uint32_t start_addr;
+    uint32_t size;
+    spi_flash_erase_done_cb_t done_cb;
+    void *arg;
+} erase_request_t;
+
+#define ERASE_QUEUE_LENGTH 4
+
+static QueueHandle_t s_erase_queue;
+
+static void spi_flash_erase_task(void *arg)
+{
+    erase_request_t req;
+    while (true) {
+        if (xQueueReceive(s_erase_queue, &req, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        esp_err_t err = spi_flash_erase_range_preemptible(req.start_addr, req.size);
+        if (req.done_cb) {
+            req.done_cb(err, req.arg);
+        }
+    }
+}
+
+esp_err_t spi_flash_erase_range_async(size_t start_addr, size_t size, spi_flash_erase_done_cb_t done_cb, void *arg)
+{
+    CHECK_WRITE_ADDRESS(start_addr, size);
+    if (start_addr % SPI_FLASH_SEC_SIZE != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (size % SPI_FLASH_SEC_SIZE != 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (size + start_addr > spi_flash_get_chip_size()) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    spi_flash_op_lock();
+    if (s_erase_queue == NULL) {
+        QueueHandle_t queue = xQueueCreate(ERASE_QUEUE_LENGTH, sizeof(erase_request_t));
+        if (queue == NULL) {
+            spi_flash_op_unlock();
+            return ESP_ERR_NO_MEM;
+        }
+        s_erase_queue = queue;
+        if (xTaskCreate(spi_flash_erase_task, "spi_flash_erase", 2048, NULL,
+                        CONFIG_SPI_FLASH_ERASE_TASK_PRIORITY, NULL) != pdPASS) {
+            s_erase_queue = NULL;
+            vQueueDelete(queue);
+            spi_flash_op_unlock();
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    spi_flash_op_unlock();
+
+    erase_request_t req = {
+        .start_addr = start_addr,
+        .size = size,
+        .done_cb = done_cb,
+        .arg = arg,
+    };
+    xQueueSend(s_erase_queue, &req, portMAX_DELAY);
+    return ESP_OK;
+}
+
 /* Wrapper around esp_rom_spiflash_write() that verifies data as written if CONFIG_SPI_FLASH_VERIFY_WRITE is set.
 
    If CONFIG_SPI_FLASH_VERIFY_WRITE is not set, this is esp_rom_spiflash_write().
@@ -407,11 +661,86 @@ esp_err_t IRAM_ATTR spi_flash_write(size_t dst, const void *srcv, size_t size)
         COUNTER_ADD_BYTES(write, 4);
     }
 out:
-    COUNTER_STOP(write);
+    COUNTER_STOP(write, size);
+
+    spi_flash_guard_start();
+    spi_flash_check_and_flush_cache(dst, size);
+    spi_flash_guard_end();
+    spi_flash_read_cache_invalidate(dst, size);
+
+    return spi_flash_translate_rc(rc);
+}
+
+esp_err_t IRAM_ATTR spi_flash_writev(size_t dst, const spi_flash_iovec_t *iov, int iovcnt)
+{
+    size_t size = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        size += iov[i].iov_len;
+    }
+    CHECK_WRITE_ADDRESS(dst, size);
+    if (dst + size > g_rom_flashchip.chip_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (size == 0) {
+        return ESP_OK;
+    }
+
+    esp_rom_spiflash_result_t rc = ESP_ROM_SPIFLASH_RESULT_OK;
+    COUNTER_START();
+#if CONFIG_SPI_FLASH_ENABLE_COUNTERS
+    s_flash_stats.writev_segment.count += iovcnt;
+    s_flash_stats.writev_segment.bytes += size;
+#endif
+    /*
+     * Data is gathered into a buffer covering (part of) one flash page, so
+     * that segments may be in flash or external RAM. Bytes of the buffer not
+     * covered by data are left at 0xff, which doesn't change flash contents.
+     */
+    uint32_t page_buf[WRITEV_PAGE_SIZE / sizeof(uint32_t)];
+    const size_t end = dst + size;
+    size_t addr = dst;
+    int seg = 0;
+    size_t seg_off = 0;
+
+    rc = spi_flash_unlock();
+    if (rc != ESP_ROM_SPIFLASH_RESULT_OK) {
+        goto out;
+    }
+    while (addr < end) {
+        size_t prog_start = addr & ~3U;
+        size_t prog_end = MIN((prog_start & ~(WRITEV_PAGE_SIZE - 1)) + WRITEV_PAGE_SIZE, end);
+        memset(page_buf, 0xff, sizeof(page_buf));
+        while (addr < prog_end) {
+            while (seg_off == iov[seg].iov_len) {
+                ++seg;
+                seg_off = 0;
+            }
+            size_t copy_size = MIN(iov[seg].iov_len - seg_off, prog_end - addr);
+            memcpy((uint8_t *) page_buf + (addr - prog_start),
+                   (const uint8_t *) iov[seg].iov_base + seg_off, copy_size);
+            seg_off += copy_size;
+            addr += copy_size;
+        }
+        size_t prog_size = (prog_end - prog_start + 3) & ~3U;
+        spi_flash_guard_start();
+        rc = spi_flash_write_inner(prog_start, page_buf, prog_size);
+        spi_flash_guard_end();
+        if (rc != ESP_ROM_SPIFLASH_RESULT_OK) {
+            goto out;
+        }
+        COUNTER_ADD_BYTES(write, prog_size);
+#if CONFIG_SPI_FLASH_ENABLE_COUNTERS
+        s_flash_stats.writev_program.count++;
+        s_flash_stats.writev_program.bytes += prog_size;
+#endif
+    }
+out:
+    COUNTER_STOP(write, size);
 
     spi_flash_guard_start();
     spi_flash_check_and_flush_cache(dst, size);
     spi_flash_guard_end();
+    spi_flash_read_cache_invalidate(dst, size);
 
     return spi_flash_translate_rc(rc);
 }
@@ -473,16 +802,203 @@ esp_err_t IRAM_ATTR spi_flash_write_encrypted(size_t dest_addr, const void *src,
         bzero(encrypt_buf, sizeof(encrypt_buf));
     }
     COUNTER_ADD_BYTES(write, size);
-    COUNTER_STOP(write);
+    COUNTER_STOP(write, size);
 
     spi_flash_guard_start();
     spi_flash_check_and_flush_cache(dest_addr, size);
     spi_flash_guard_end();
+    spi_flash_read_cache_invalidate(dest_addr, size);
 
     return spi_flash_translate_rc(rc);
 }
 
+#if CONFIG_SPI_FLASH_READ_CACHE
+/* Sector-granular cache of data read with spi_flash_read. A line is filled
+   with the whole sector on a miss, lines are replaced in LRU order, and every
+   write or erase invalidates the lines of the sectors it touches.
+   All cache state is accessed while holding the flash op lock.
+*/
+#define READ_CACHE_LINES        CONFIG_SPI_FLASH_READ_CACHE_SECTORS
+#define READ_CACHE_NO_SECTOR    UINT32_MAX
+
+typedef struct {
+    uint32_t sector;
+    uint32_t last_use;
+} read_cache_line_t;
+
+static read_cache_line_t s_read_cache_lines[READ_CACHE_LINES];
+static uint8_t *s_read_cache_data;
+static uint32_t s_read_cache_clock;
+static bool s_read_cache_unavailable;
+
+static void spi_flash_read_cache_alloc()
+{
+#if CONFIG_SPI_FLASH_READ_CACHE_IN_PSRAM
+    s_read_cache_data = heap_caps_malloc(READ_CACHE_LINES * SPI_FLASH_SEC_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#endif
+    if (s_read_cache_data == NULL) {
+        s_read_cache_data = heap_caps_malloc(READ_CACHE_LINES * SPI_FLASH_SEC_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (s_read_cache_data == NULL) {
+        s_read_cache_unavailable = true;
+        return;
+    }
+    for (int i = 0; i < READ_CACHE_LINES; ++i) {
+        s_read_cache_lines[i].sector = READ_CACHE_NO_SECTOR;
+        s_read_cache_lines[i].last_use = 0;
+    }
+}
+
+static void IRAM_ATTR spi_flash_read_cache_invalidate(size_t start_addr, size_t size)
+{
+    if (s_read_cache_data == NULL || size == 0) {
+        return;
+    }
+    const uint32_t first = start_addr / SPI_FLASH_SEC_SIZE;
+    const uint32_t last = (start_addr + size - 1) / SPI_FLASH_SEC_SIZE;
+    spi_flash_guard_op_lock();
+    for (int i = 0; i < READ_CACHE_LINES; ++i) {
+        read_cache_line_t *line = &s_read_cache_lines[i];
+        if (line->sector != READ_CACHE_NO_SECTOR && line->sector >= first && line->sector <= last) {
+            line->sector = READ_CACHE_NO_SECTOR;
+            line->last_use = 0;
+        }
+    }
+    spi_flash_guard_op_unlock();
+}
+
+/* Read data which doesn't cross a sector boundary */
+static esp_err_t IRAM_ATTR spi_flash_read_cached(size_t src, void *dstv, size_t size)
+{
+    const uint32_t sector = src / SPI_FLASH_SEC_SIZE;
+    esp_err_t err = ESP_OK;
+
+    spi_flash_guard_op_lock();
+    if (s_read_cache_data == NULL && !s_read_cache_unavailable) {
+        spi_flash_read_cache_alloc();
+    }
+    if (s_read_cache_data == NULL) {
+        spi_flash_guard_op_unlock();
+        return spi_flash_read_uncached(src, dstv, size);
+    }
+
+    read_cache_line_t *line = NULL;
+    read_cache_line_t *victim = &s_read_cache_lines[0];
+    for (int i = 0; i < READ_CACHE_LINES; ++i) {
+        if (s_read_cache_lines[i].sector == sector) {
+            line = &s_read_cache_lines[i];
+            break;
+        }
+        if (s_read_cache_lines[i].last_use < victim->last_use) {
+            victim = &s_read_cache_lines[i];
+        }
+    }
+
+    if (line == NULL) {
+        line = victim;
+        line->sector = READ_CACHE_NO_SECTOR;
+        line->last_use = 0;
+        err = spi_flash_read_uncached(sector * SPI_FLASH_SEC_SIZE,
+                s_read_cache_data + (line - s_read_cache_lines) * SPI_FLASH_SEC_SIZE, SPI_FLASH_SEC_SIZE);
+        if (err == ESP_OK) {
+            line->sector = sector;
+        }
+#if CONFIG_SPI_FLASH_ENABLE_COUNTERS
+        s_flash_stats.read_cache_miss.count++;
+        s_flash_stats.read_cache_miss.bytes += size;
+#endif
+    } else {
+#if CONFIG_SPI_FLASH_ENABLE_COUNTERS
+        s_flash_stats.read_cache_hit.count++;
+        s_flash_stats.read_cache_hit.bytes += size;
+#endif
+    }
+
+    if (err == ESP_OK) {
+        if (++s_read_cache_clock == 0) {
+            // clock wrapped around, restart the LRU order
+            for (int i = 0; i < READ_CACHE_LINES; ++i) {
+                s_read_cache_lines[i].last_use = 0;
+            }
+            s_read_cache_clock = 1;
+        }
+        line->last_use = s_read_cache_clock;
+        memcpy(dstv, s_read_cache_data + (line - s_read_cache_lines) * SPI_FLASH_SEC_SIZE
+                + src % SPI_FLASH_SEC_SIZE, size);
+    }
+    spi_flash_guard_op_unlock();
+    return err;
+}
+#endif // CONFIG_SPI_FLASH_READ_CACHE
+
+#if CONFIG_SPI_FLASH_MMAP_READ
+/* Maximum number of MMU pages mapped at a time by spi_flash_read_mmap */
+#define MMAP_READ_MAX_PAGES     4
+
+/* Read data by mapping it into the data address space and copying it from
+   there. Mappings are made with spi_flash_mmap, so pages which are already
+   mapped by someone else (e.g. a partition mapped by the application) are
+   reused instead of taking up more MMU entries. Returns ESP_ERR_NO_MEM
+   without touching dstv if no mapping could be made, so the caller can fall
+   back to reading via ROM functions.
+*/
+static esp_err_t IRAM_ATTR spi_flash_read_mmap(size_t src, void *dstv, size_t size)
+{
+    uint8_t *dstc = (uint8_t *) dstv;
+    size_t remaining = size;
+    bool first = true;
+    COUNTER_START();
+    while (remaining > 0) {
+        size_t map_src = src & ~(SPI_FLASH_MMU_PAGE_SIZE - 1);
+        size_t map_size = MIN(remaining + (src - map_src), MMAP_READ_MAX_PAGES * SPI_FLASH_MMU_PAGE_SIZE);
+        size_t copy_size = map_size - (src - map_src);
+        const uint8_t *map;
+        spi_flash_mmap_handle_t map_handle;
+        esp_err_t err = spi_flash_mmap(map_src, map_size, SPI_FLASH_MMAP_DATA, (const void **) &map, &map_handle);
+        if (err != ESP_OK) {
+            if (first) {
+                return err;
+            }
+            // part of the data is already copied, read the rest via ROM
+            return spi_flash_read_uncached(src, dstc, remaining);
+        }
+        memcpy(dstc, map + (src - map_src), copy_size);
+        spi_flash_munmap(map_handle);
+        COUNTER_ADD_BYTES(read, copy_size);
+        src += copy_size;
+        dstc += copy_size;
+        remaining -= copy_size;
+        first = false;
+    }
+    COUNTER_STOP(read, size);
+    return ESP_OK;
+}
+#endif // CONFIG_SPI_FLASH_MMAP_READ
+
 esp_err_t IRAM_ATTR spi_flash_read(size_t src, void *dstv, size_t size)
+{
+#if CONFIG_SPI_FLASH_READ_CACHE
+    // reads done without the OS (e.g. from the panic handler) bypass the cache
+    if (size > 0 && src + size <= g_rom_flashchip.chip_size
+            && src / SPI_FLASH_SEC_SIZE == (src + size - 1) / SPI_FLASH_SEC_SIZE
+            && s_flash_guard_ops == &g_flash_guard_default_ops) {
+        return spi_flash_read_cached(src, dstv, size);
+    }
+#endif
+#if CONFIG_SPI_FLASH_MMAP_READ
+    // with flash encryption enabled, reading through the cache would decrypt the data
+    if (size >= CONFIG_SPI_FLASH_MMAP_READ_THRESHOLD && src + size <= g_rom_flashchip.chip_size
+            && s_flash_guard_ops == &g_flash_guard_default_ops
+            && !esp_flash_encryption_enabled()) {
+        if (spi_flash_read_mmap(src, dstv, size) == ESP_OK) {
+            return ESP_OK;
+        }
+    }
+#endif
+    return spi_flash_read_uncached(src, dstv, size);
+}
+
+static esp_err_t IRAM_ATTR spi_flash_read_uncached(size_t src, void *dstv, size_t size)
 {
     // Out of bound reads are checked in ROM code, but we can give better
     // error code here
@@ -620,7 +1136,7 @@ esp_err_t IRAM_ATTR spi_flash_read(size_t src, void *dstv, size_t size)
     }
 out:
     spi_flash_guard_end();
-    COUNTER_STOP(read);
+    COUNTER_STOP(read, size);
     return spi_flash_translate_rc(rc);
 }
 
@@ -678,6 +1194,9 @@ const spi_flash_counters_t *spi_flash_get_counters()
 void spi_flash_reset_counters()
 {
     memset(&s_flash_stats, 0, sizeof(s_flash_stats));
+#if CONFIG_SPI_FLASH_ENABLE_HISTOGRAMS
+    memset(&s_flash_hist, 0, sizeof(s_flash_hist));
+#endif
 }
 
 void spi_flash_dump_counters()
@@ -685,6 +1204,63 @@ void spi_flash_dump_counters()
     dump_counter(&s_flash_stats.read,  "read ");
     dump_counter(&s_flash_stats.write, "write");
     dump_counter(&s_flash_stats.erase, "erase");
+    dump_counter(&s_flash_stats.writev_segment, "writev seg ");
+    dump_counter(&s_flash_stats.writev_program, "writev prog");
+#if CONFIG_SPI_FLASH_READ_CACHE
+    dump_counter(&s_flash_stats.read_cache_hit,  "cache hit ");
+    dump_counter(&s_flash_stats.read_cache_miss, "cache miss");
+#endif
+}
+
+#if CONFIG_SPI_FLASH_ENABLE_HISTOGRAMS
+
+void IRAM_ATTR spi_flash_histogram_add_stall(uint32_t time_us)
+{
+    spi_flash_histogram_add(&s_flash_hist.stall, time_us);
+}
+
+void spi_flash_get_histograms(spi_flash_histograms_t *out)
+{
+    memcpy(out, &s_flash_hist, sizeof(*out));
 }
 
+static void dump_histogram(const spi_flash_histogram_t *hist, const char *name)
+{
+    uint32_t count = 0;
+    for (int i = 0; i < SPI_FLASH_HISTOGRAM_BUCKETS; ++i) {
+        count += hist->bucket[i];
+    }
+    if (count == 0) {
+        return;
+    }
+    printf("%-14s count=%8u  max=%8uus\n", name, count, hist->max_time);
+    for (int i = 0; i < SPI_FLASH_HISTOGRAM_BUCKETS; ++i) {
+        if (hist->bucket[i] == 0) {
+            continue;
+        }
+        if (i == SPI_FLASH_HISTOGRAM_BUCKETS - 1) {
+            printf("  >= %7uus  %8u\n", 1U << i, hist->bucket[i]);
+        } else {
+            printf("  <  %7uus  %8u\n", 2U << i, hist->bucket[i]);
+        }
+    }
+}
+
+void spi_flash_dump_histograms()
+{
+    static const char *size_names[SPI_FLASH_SIZE_CLASS_MAX] = { "<=256", "<=4k", ">4k" };
+    char name[16];
+    for (int i = 0; i < SPI_FLASH_SIZE_CLASS_MAX; ++i) {
+        snprintf(name, sizeof(name), "read  %s", size_names[i]);
+        dump_histogram(&s_flash_hist.read[i], name);
+        snprintf(name, sizeof(name), "write %s", size_names[i]);
+        dump_histogram(&s_flash_hist.write[i], name);
+        snprintf(name, sizeof(name), "erase %s", size_names[i]);
+        dump_histogram(&s_flash_hist.erase[i], name);
+    }
+    dump_histogram(&s_flash_hist.stall, "other CPU");
+}
+
+#endif //CONFIG_SPI_FLASH_ENABLE_HISTOGRAMS
+
 #endif //CONFIG_SPI_FLASH_ENABLE_COUNTERS
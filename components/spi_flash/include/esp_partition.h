@@ -240,6 +240,36 @@ esp_err_t esp_partition_read(const esp_partition_t* partition,
 esp_err_t esp_partition_write(const esp_partition_t* partition,
                              size_t dst_offset, const void* src, size_t size);
 
+/**
+ * @brief Write data from multiple buffers to the partition
+ *
+ * Segments are written back to back, starting at dst_offset. For
+ * unencrypted partitions this is done with spi_flash_writev(), which
+ * combines small segments into whole flash page programs.
+ *
+ * Encrypted partitions are written one segment at a time, via the
+ * spi_flash_write_encrypted() function. In this case the length of
+ * each segment and dst_offset must be multiples of 16 bytes.
+ *
+ * @param partition Pointer to partition structure obtained using
+ *                  esp_partition_find_first or esp_partition_get.
+ *                  Must be non-NULL.
+ * @param dst_offset Address where the data should be written, relative to the
+ *                   beginning of the partition.
+ * @param iov Array of segments to write.
+ * @param iovcnt Number of elements in iov.
+ *
+ * @note Prior to writing to flash memory, make sure it has been erased with
+ *       esp_partition_erase_range call.
+ *
+ * @return ESP_OK, if data was written successfully;
+ *         ESP_ERR_INVALID_ARG, if dst_offset exceeds partition size;
+ *         ESP_ERR_INVALID_SIZE, if write would go out of bounds of the partition;
+ *         or one of error codes from lower-level flash driver.
+ */
+esp_err_t esp_partition_writev(const esp_partition_t* partition,
+                               size_t dst_offset, const spi_flash_iovec_t* iov, int iovcnt);
+
 /**
  * @brief Erase part of the partition
  *
@@ -73,6 +73,43 @@ esp_err_t spi_flash_erase_sector(size_t sector);
  */
 esp_err_t spi_flash_erase_range(size_t start_address, size_t size);
 
+/**
+ * @brief Callback called when an erase started by spi_flash_erase_range_async is done
+ *
+ * @param err  ESP_OK if the range was erased, or an error code from the flash driver
+ * @param arg  Argument passed to spi_flash_erase_range_async
+ */
+typedef void (*spi_flash_erase_done_cb_t)(esp_err_t err, void *arg);
+
+/**
+ * @brief  Erase a range of flash sectors in the background
+ *
+ * The erase is done by a dedicated task, and the calling task continues
+ * immediately. Unlike spi_flash_erase_range, which keeps the other CPU and the
+ * flash cache disabled for each whole sector or 64kB block erase, this keeps
+ * them disabled for the duration of a single sector erase at most.
+ * If CONFIG_SPI_FLASH_ERASE_SUSPEND is enabled, the erase is also suspended
+ * every CONFIG_SPI_FLASH_ERASE_SUSPEND_WINDOW_US microseconds, so that cached
+ * code and interrupts can run while a 64kB block is erased.
+ *
+ * Other flash operations may be started while the erase is in progress, they
+ * are serialized with it. Do not read the erased range until done_cb is called.
+ *
+ * @param  start_address  Address where erase operation has to start.
+ *                                  Must be 4kB-aligned
+ * @param  size  Size of erased range, in bytes. Must be divisible by 4kB.
+ * @param  done_cb  Function called from the erase task once the range is erased,
+ *                  may be NULL. It may give a semaphore the caller waits for.
+ * @param  arg  Argument passed to done_cb
+ *
+ * @return
+ *      - ESP_OK if the erase was started
+ *      - ESP_ERR_INVALID_ARG, ESP_ERR_INVALID_SIZE if the range is not valid
+ *      - ESP_ERR_INVALID_STATE if the scheduler is not running
+ *      - ESP_ERR_NO_MEM if the erase task could not be created
+ */
+esp_err_t spi_flash_erase_range_async(size_t start_address, size_t size, spi_flash_erase_done_cb_t done_cb, void *arg);
+
 
 /**
  * @brief  Write data to Flash.
@@ -92,6 +129,35 @@ esp_err_t spi_flash_erase_range(size_t start_address, size_t size);
  */
 esp_err_t spi_flash_write(size_t dest_addr, const void *src, size_t size);
 
+/**
+ * @brief Segment of data written by spi_flash_writev
+ */
+typedef struct {
+    const void *iov_base;   /*!< Pointer to the segment data */
+    size_t iov_len;         /*!< Length of the segment, in bytes */
+} spi_flash_iovec_t;
+
+/**
+ * @brief  Write data from multiple buffers to consecutive Flash addresses.
+ *
+ * Writes the contents of all segments back to back, starting at dest_addr,
+ * as if they were concatenated into one buffer and passed to spi_flash_write.
+ * Data of adjacent segments is combined into whole 256-byte flash page
+ * programs, and each page is programmed with interrupts and the other CPU
+ * disabled only once. This is faster than calling spi_flash_write for each
+ * segment when segments are small.
+ *
+ * @note Segment buffers may be located anywhere, including in flash and in
+ * external RAM.
+ *
+ * @param  dest_addr Destination address in Flash.
+ * @param  iov       Array of segments to write. Segments may have zero length.
+ * @param  iovcnt    Number of elements in iov.
+ *
+ * @return esp_err_t
+ */
+esp_err_t spi_flash_writev(size_t dest_addr, const spi_flash_iovec_t *iov, int iovcnt);
+
 
 /**
  * @brief  Write data encrypted to Flash.
@@ -405,6 +471,12 @@ typedef struct {
     spi_flash_counter_t read;
     spi_flash_counter_t write;
     spi_flash_counter_t erase;
+    spi_flash_counter_t writev_segment;     // segments passed to spi_flash_writev, time is not measured
+    spi_flash_counter_t writev_program;     // page programs done by spi_flash_writev, time is not measured
+#if CONFIG_SPI_FLASH_READ_CACHE
+    spi_flash_counter_t read_cache_hit;     // reads served from the RAM read cache, time is not measured
+    spi_flash_counter_t read_cache_miss;    // reads which filled a line of the RAM read cache, time is not measured
+#endif
 } spi_flash_counters_t;
 
 /**
@@ -425,6 +497,59 @@ void spi_flash_dump_counters();
  */
 const spi_flash_counters_t* spi_flash_get_counters();
 
+#if CONFIG_SPI_FLASH_ENABLE_HISTOGRAMS
+
+/**
+ * Number of buckets in each latency histogram. Bucket 0 counts operations
+ * which took less than 2 us, bucket i counts operations which took
+ * from 2^i to 2^(i+1) - 1 us, and the last bucket counts all longer ones.
+ */
+#define SPI_FLASH_HISTOGRAM_BUCKETS 20
+
+/**
+ * @brief Classes of operation sizes, for which separate histograms are kept
+ */
+typedef enum {
+    SPI_FLASH_SIZE_CLASS_SMALL,     /*!< Up to 256 bytes */
+    SPI_FLASH_SIZE_CLASS_SECTOR,    /*!< Up to 4 kB */
+    SPI_FLASH_SIZE_CLASS_LARGE,     /*!< More than 4 kB */
+    SPI_FLASH_SIZE_CLASS_MAX,
+} spi_flash_size_class_t;
+
+/**
+ * @brief Histogram of operation latencies
+ */
+typedef struct {
+    uint32_t bucket[SPI_FLASH_HISTOGRAM_BUCKETS];   /*!< Number of operations in each bucket */
+    uint32_t max_time;                              /*!< Longest time taken, in microseconds */
+} spi_flash_histogram_t;
+
+/**
+ * @brief Latency histograms of SPI flash operations
+ */
+typedef struct {
+    spi_flash_histogram_t read[SPI_FLASH_SIZE_CLASS_MAX];     /*!< Reads, by size class */
+    spi_flash_histogram_t write[SPI_FLASH_SIZE_CLASS_MAX];    /*!< Writes, by size class */
+    spi_flash_histogram_t erase[SPI_FLASH_SIZE_CLASS_MAX];    /*!< Erases, by size class */
+    spi_flash_histogram_t stall;    /*!< Time the other CPU spent blocked, per guarded section */
+} spi_flash_histograms_t;
+
+/**
+ * @brief  Get a copy of the latency histograms
+ *
+ * Histograms are reset by spi_flash_reset_counters.
+ *
+ * @param  out  Structure to be filled with the histograms
+ */
+void spi_flash_get_histograms(spi_flash_histograms_t *out);
+
+/**
+ * @brief  Print non-empty latency histograms
+ */
+void spi_flash_dump_histograms();
+
+#endif //CONFIG_SPI_FLASH_ENABLE_HISTOGRAMS
+
 #endif //CONFIG_SPI_FLASH_ENABLE_COUNTERS
 
 #ifdef __cplusplus
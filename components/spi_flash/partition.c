@@ -48,33 +48,68 @@ typedef struct esp_partition_iterator_opaque_ {
 } esp_partition_iterator_opaque_t;
 
 
-static esp_partition_iterator_opaque_t* iterator_create(esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label);
+/* Entry of the partition lookup index. The index holds each partition under
+   the keys (type, subtype, label), (type, subtype), (type, any subtype, label)
+   and (type, any subtype), unless a partition which comes before it in the
+   partition table was already entered under the same key. A lookup therefore
+   returns the first match in table order, like a search of the list does.
+*/
+typedef struct {
+    partition_list_item_t* item;    // NULL for unused entries
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    bool by_label;                  // key includes item->info.label
+} partition_index_entry_t;
+
+
+static esp_partition_iterator_opaque_t* iterator_create(esp_partition_type_t type, esp_partition_subtype_t subtype,
+        const char* label, partition_list_item_t* first);
 static esp_err_t load_partitions();
+static esp_err_t build_index();
+static partition_list_item_t* index_find(esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label);
 
 
 static SLIST_HEAD(partition_list_head_, partition_list_item_) s_partition_list =
         SLIST_HEAD_INITIALIZER(s_partition_list);
 static _lock_t s_partition_list_lock;
+static partition_index_entry_t* s_partition_index;
+static size_t s_partition_index_size;     // number of entries, a power of 2
 
 
-esp_partition_iterator_t esp_partition_find(esp_partition_type_t type,
-        esp_partition_subtype_t subtype, const char* label)
+static esp_err_t ensure_partitions_loaded()
 {
-    if (SLIST_EMPTY(&s_partition_list)) {
-        // only lock if list is empty (and check again after acquiring lock)
+    if (s_partition_index == NULL) {
+        // only lock if the index is not built yet (and check again after acquiring lock)
         _lock_acquire(&s_partition_list_lock);
         esp_err_t err = ESP_OK;
         if (SLIST_EMPTY(&s_partition_list)) {
             err = load_partitions();
         }
-        _lock_release(&s_partition_list_lock);
-        if (err != ESP_OK) {
-            return NULL;
+        if (err == ESP_OK && s_partition_index == NULL) {
+            err = build_index();
         }
+        _lock_release(&s_partition_list_lock);
+        return err;
+    }
+    return ESP_OK;
+}
+
+esp_partition_iterator_t esp_partition_find(esp_partition_type_t type,
+        esp_partition_subtype_t subtype, const char* label)
+{
+    if (ensure_partitions_loaded() != ESP_OK) {
+        return NULL;
+    }
+    partition_list_item_t* first = index_find(type, subtype, label);
+    if (first == NULL) {
+        return NULL;
+    }
+    // create an iterator pointing to the first matching item
+    // (next item will be this one)
+    esp_partition_iterator_t it = iterator_create(type, subtype, label, first);
+    if (it == NULL) {
+        return NULL;
     }
-    // create an iterator pointing to the start of the list
-    // (next item will be the first one)
-    esp_partition_iterator_t it = iterator_create(type, subtype, label);
     // advance iterator to the next item which matches constraints
     it = esp_partition_next(it);
     // if nothing found, it == NULL and iterator has been released
@@ -117,28 +152,114 @@ esp_partition_iterator_t esp_partition_next(esp_partition_iterator_t it)
 const esp_partition_t* esp_partition_find_first(esp_partition_type_t type,
         esp_partition_subtype_t subtype, const char* label)
 {
-    esp_partition_iterator_t it = esp_partition_find(type, subtype, label);
-    if (it == NULL) {
+    if (ensure_partitions_loaded() != ESP_OK) {
+        return NULL;
+    }
+    partition_list_item_t* item = index_find(type, subtype, label);
+    if (item == NULL) {
         return NULL;
     }
-    const esp_partition_t* res = esp_partition_get(it);
-    esp_partition_iterator_release(it);
-    return res;
+    return &item->info;
 }
 
 static esp_partition_iterator_opaque_t* iterator_create(esp_partition_type_t type,
-        esp_partition_subtype_t subtype, const char* label)
+        esp_partition_subtype_t subtype, const char* label, partition_list_item_t* first)
 {
     esp_partition_iterator_opaque_t* it =
             (esp_partition_iterator_opaque_t*) malloc(sizeof(esp_partition_iterator_opaque_t));
+    if (it == NULL) {
+        return NULL;
+    }
     it->type = type;
     it->subtype = subtype;
     it->label = label;
-    it->next_item = SLIST_FIRST(&s_partition_list);
+    it->next_item = first;
     it->info = NULL;
     return it;
 }
 
+static uint32_t index_hash(esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261U;
+    hash = (hash ^ (uint8_t) type) * 16777619U;
+    hash = (hash ^ (uint8_t) subtype) * 16777619U;
+    if (label != NULL) {
+        for (const char* c = label; *c != 0; ++c) {
+            hash = (hash ^ (uint8_t) *c) * 16777619U;
+        }
+    }
+    return hash;
+}
+
+static bool index_entry_matches(const partition_index_entry_t* entry, esp_partition_type_t type,
+        esp_partition_subtype_t subtype, const char* label)
+{
+    if (entry->type != type || entry->subtype != subtype || entry->by_label != (label != NULL)) {
+        return false;
+    }
+    return label == NULL || strcmp(entry->item->info.label, label) == 0;
+}
+
+static partition_list_item_t* index_find(esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label)
+{
+    const size_t mask = s_partition_index_size - 1;
+    for (size_t i = index_hash(type, subtype, label) & mask; s_partition_index[i].item != NULL; i = (i + 1) & mask) {
+        if (index_entry_matches(&s_partition_index[i], type, subtype, label)) {
+            return s_partition_index[i].item;
+        }
+    }
+    return NULL;
+}
+
+static void index_insert(partition_index_entry_t* index, size_t size,
+        partition_list_item_t* item, esp_partition_subtype_t subtype, bool by_label)
+{
+    const char* label = by_label ? item->info.label : NULL;
+    const size_t mask = size - 1;
+    size_t i;
+    for (i = index_hash(item->info.type, subtype, label) & mask; index[i].item != NULL; i = (i + 1) & mask) {
+        if (index_entry_matches(&index[i], item->info.type, subtype, label)) {
+            return; // preceding partition already has this key
+        }
+    }
+    index[i].item = item;
+    index[i].type = item->info.type;
+    index[i].subtype = subtype;
+    index[i].by_label = by_label;
+}
+
+// Build the lookup index from the list of partitions.
+// This function is called only once, with s_partition_list_lock taken.
+static esp_err_t build_index()
+{
+    size_t count = 0;
+    partition_list_item_t* item;
+    SLIST_FOREACH(item, &s_partition_list, next) {
+        ++count;
+    }
+    // each partition has up to 4 keys, keep the index at most half full
+    size_t size = 4;
+    while (size < count * 4 * 2) {
+        size *= 2;
+    }
+    partition_index_entry_t* index = (partition_index_entry_t*) calloc(size, sizeof(partition_index_entry_t));
+    if (index == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    SLIST_FOREACH(item, &s_partition_list, next) {
+        index_insert(index, size, item, item->info.subtype, true);
+        index_insert(index, size, item, item->info.subtype, false);
+        index_insert(index, size, item, ESP_PARTITION_SUBTYPE_ANY, true);
+        index_insert(index, size, item, ESP_PARTITION_SUBTYPE_ANY, false);
+    }
+    // readers don't take the lock, so publish the index once it is complete
+    s_partition_index_size = size;
+    __sync_synchronize();
+    s_partition_index = index;
+    return ESP_OK;
+}
+
 // Create linked list of partition_list_item_t structures.
 // This function is called only once, with s_partition_list_lock taken.
 static esp_err_t load_partitions()
@@ -208,21 +329,23 @@ const esp_partition_t *esp_partition_verify(const esp_partition_t *partition)
 {
     assert(partition != NULL);
     const char *label = (strlen(partition->label) > 0) ? partition->label : NULL;
-    esp_partition_iterator_t it = esp_partition_find(partition->type,
-                                                     partition->subtype,
-                                                     label);
-    while (it != NULL) {
-        const esp_partition_t *p = esp_partition_get(it);
+    if (ensure_partitions_loaded() != ESP_OK) {
+        return NULL;
+    }
+    partition_list_item_t *item = index_find(partition->type, partition->subtype, label);
+    for (; item != NULL; item = SLIST_NEXT(item, next)) {
+        const esp_partition_t *p = &item->info;
+        if (p->type != partition->type || p->subtype != partition->subtype
+            || (label != NULL && strcmp(label, p->label) != 0)) {
+            continue;
+        }
         /* Can't memcmp() whole structure here as padding contents may be different */
         if (p->address == partition->address
             && partition->size == p->size
             && partition->encrypted == p->encrypted) {
-            esp_partition_iterator_release(it);
             return p;
         }
-        it = esp_partition_next(it);
     }
-    esp_partition_iterator_release(it);
     return NULL;
 }
 
@@ -282,6 +405,39 @@ esp_err_t esp_partition_write(const esp_partition_t* partition,
     }
 }
 
+esp_err_t esp_partition_writev(const esp_partition_t* partition,
+                               size_t dst_offset, const spi_flash_iovec_t* iov, int iovcnt)
+{
+    assert(partition != NULL);
+    size_t size = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        size += iov[i].iov_len;
+    }
+    if (dst_offset > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (dst_offset + size > partition->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    dst_offset = partition->address + dst_offset;
+    if (!partition->encrypted) {
+        return spi_flash_writev(dst_offset, iov, iovcnt);
+    } else {
+#if CONFIG_FLASH_ENCRYPTION_ENABLED
+        for (int i = 0; i < iovcnt; ++i) {
+            esp_err_t err = spi_flash_write_encrypted(dst_offset, iov[i].iov_base, iov[i].iov_len);
+            if (err != ESP_OK) {
+                return err;
+            }
+            dst_offset += iov[i].iov_len;
+        }
+        return ESP_OK;
+#else
+        return ESP_ERR_NOT_SUPPORTED;
+#endif // CONFIG_FLASH_ENCRYPTION_ENABLED
+    }
+}
+
 esp_err_t esp_partition_erase_range(const esp_partition_t* partition,
                                     size_t start_addr, size_t size)
 {
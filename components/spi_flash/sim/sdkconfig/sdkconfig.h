@@ -1,3 +1,4 @@
 #pragma once
 
 #define CONFIG_PARTITION_TABLE_OFFSET   0x8000
+#define CONFIG_SPI_FLASH_ERASE_TASK_PRIORITY 5
@@ -5,6 +5,12 @@ extern "C" {
 #endif
 
 #define pdTRUE              1
+#define pdFALSE             0
+#define pdPASS              pdTRUE
+#define pdFAIL              pdFALSE
+
+#define portMAX_DELAY       0xffffffff
+#define portTICK_PERIOD_MS  1
 
 #if defined(__cplusplus)
 }
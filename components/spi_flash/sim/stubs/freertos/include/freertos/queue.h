@@ -0,0 +1,18 @@
+#pragma once
+
+#include "projdefs.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define xQueueCreate( uxQueueLength, uxItemSize )               ((void*)(0))
+#define vQueueDelete( xQueue )
+#define xQueueSend( xQueue, pvItemToQueue, xTicksToWait )       ((void)(pvItemToQueue), pdFAIL)
+#define xQueueReceive( xQueue, pvBuffer, xTicksToWait )         ((void)(pvBuffer), pdFAIL)
+
+typedef void* QueueHandle_t;
+
+#if defined(__cplusplus)
+}
+#endif
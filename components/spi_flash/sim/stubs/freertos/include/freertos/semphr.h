@@ -1,5 +1,7 @@
 #pragma once
 
+#include "queue.h"
+
 #if defined(__cplusplus)
 extern "C" {
 #endif
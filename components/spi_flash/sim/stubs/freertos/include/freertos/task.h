@@ -1 +1,18 @@
-#pragma once
\ No newline at end of file
+#pragma once
+
+#include "projdefs.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define taskSCHEDULER_NOT_STARTED   1
+
+// Flash operations in the simulator run synchronously, there is no scheduler
+#define xTaskGetSchedulerState()    taskSCHEDULER_NOT_STARTED
+#define xTaskCreate( pvTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pxCreatedTask )    pdFAIL
+#define taskYIELD()
+
+#if defined(__cplusplus)
+}
+#endif
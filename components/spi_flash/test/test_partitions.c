@@ -66,3 +66,72 @@ TEST_CASE("Test erase partition", "[spi_flash]")
         }
     }
 }
+
+#if CONFIG_SPI_FLASH_ENABLE_HISTOGRAMS
+static uint32_t histogram_count(const spi_flash_histogram_t *hist)
+{
+    uint32_t count = 0;
+    for (int i = 0; i < SPI_FLASH_HISTOGRAM_BUCKETS; ++i) {
+        count += hist->bucket[i];
+    }
+    return count;
+}
+
+TEST_CASE("flash operations are recorded in latency histograms", "[spi_flash]")
+{
+    const esp_partition_t *part = get_test_data_partition();
+    static spi_flash_histograms_t hist;
+    char buf[16];
+
+    spi_flash_reset_counters();
+    ESP_ERROR_CHECK( esp_partition_erase_range(part, 0, SPI_FLASH_SEC_SIZE) );
+    for (int i = 0; i < 10; ++i) {
+        ESP_ERROR_CHECK( esp_partition_read(part, i * sizeof(buf), buf, sizeof(buf)) );
+    }
+    ESP_ERROR_CHECK( esp_partition_write(part, 0, buf, sizeof(buf)) );
+    spi_flash_dump_histograms();
+
+    spi_flash_get_histograms(&hist);
+    TEST_ASSERT_EQUAL(1, histogram_count(&hist.erase[SPI_FLASH_SIZE_CLASS_SECTOR]));
+    TEST_ASSERT_EQUAL(10, histogram_count(&hist.read[SPI_FLASH_SIZE_CLASS_SMALL]));
+    TEST_ASSERT_EQUAL(1, histogram_count(&hist.write[SPI_FLASH_SIZE_CLASS_SMALL]));
+    TEST_ASSERT_EQUAL(0, histogram_count(&hist.read[SPI_FLASH_SIZE_CLASS_LARGE]));
+    // an erase of a sector takes at least several milliseconds
+    TEST_ASSERT(hist.erase[SPI_FLASH_SIZE_CLASS_SECTOR].max_time > 1000);
+#ifndef CONFIG_FREERTOS_UNICORE
+    TEST_ASSERT(histogram_count(&hist.stall) > 0);
+#endif
+
+    spi_flash_reset_counters();
+    spi_flash_get_histograms(&hist);
+    TEST_ASSERT_EQUAL(0, histogram_count(&hist.erase[SPI_FLASH_SIZE_CLASS_SECTOR]));
+}
+#endif // CONFIG_SPI_FLASH_ENABLE_HISTOGRAMS
+
+static void check_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label)
+{
+    const esp_partition_t *expected = NULL;
+    esp_partition_iterator_t it = esp_partition_find(type, subtype, label);
+    if (it != NULL) {
+        expected = esp_partition_get(it);
+        esp_partition_iterator_release(it);
+    }
+    TEST_ASSERT_EQUAL_PTR(expected, esp_partition_find_first(type, subtype, label));
+}
+
+TEST_CASE("esp_partition_find_first returns the same partitions as esp_partition_find", "[spi_flash]")
+{
+    esp_partition_iterator_t it = esp_partition_find(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, NULL);
+    TEST_ASSERT_NOT_NULL(it);
+    for (; it != NULL; it = esp_partition_next(it)) {
+        const esp_partition_t *p = esp_partition_get(it);
+        check_find_first(p->type, p->subtype, NULL);
+        check_find_first(p->type, p->subtype, p->label);
+        check_find_first(p->type, ESP_PARTITION_SUBTYPE_ANY, p->label);
+        TEST_ASSERT_EQUAL_PTR(p, esp_partition_verify(p));
+    }
+    check_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_ANY, NULL);
+    check_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, NULL);
+    check_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "no such label");
+    check_find_first(0x40, ESP_PARTITION_SUBTYPE_ANY, NULL);
+}
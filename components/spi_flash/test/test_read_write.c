@@ -41,6 +41,9 @@ static void setup_tests()
     }
 }
 
+/* Size of the page programs done by spi_flash_writev */
+#define WRITEV_TEST_PAGE_SIZE 256
+
 #ifndef CONFIG_SPI_FLASH_MINIMAL_TEST
 #define CONFIG_SPI_FLASH_MINIMAL_TEST 1
 #endif
@@ -266,3 +269,124 @@ TEST_CASE("spi_flash_write can write from external RAM buffer", "[spi_flash]")
 }
 
 #endif // CONFIG_SPIRAM_SUPPORT
+
+TEST_CASE("spi_flash_writev writes segments back to back", "[spi_flash]")
+{
+    setup_tests();
+    const size_t seg_count = 64;
+    const size_t size = 1024;
+    char *src_buf = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    char *dst_buf = heap_caps_malloc(size + 8, MALLOC_CAP_8BIT);
+    spi_flash_iovec_t *iov = heap_caps_malloc(seg_count * sizeof(spi_flash_iovec_t), MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(src_buf);
+    TEST_ASSERT_NOT_NULL(dst_buf);
+    TEST_ASSERT_NOT_NULL(iov);
+    fill(src_buf, 0x33, size);
+
+    // segments of varying, unaligned sizes, including empty ones
+    size_t total = 0;
+    for (size_t i = 0; i < seg_count; ++i) {
+        size_t len = (i % 5 == 0) ? 0 : (i * 7) % 29 + 1;
+        if (total + len > size) {
+            len = 0;
+        }
+        iov[i].iov_base = src_buf + total;
+        iov[i].iov_len = len;
+        total += len;
+    }
+
+    TEST_ESP_OK(spi_flash_erase_range(start, SPI_FLASH_SEC_SIZE));
+#if CONFIG_SPI_FLASH_ENABLE_COUNTERS
+    spi_flash_reset_counters();
+#endif
+    TEST_ESP_OK(spi_flash_writev(start + 3, iov, seg_count));
+#if CONFIG_SPI_FLASH_ENABLE_COUNTERS
+    TEST_ASSERT_EQUAL(seg_count, spi_flash_get_counters()->writev_segment.count);
+    TEST_ASSERT_EQUAL(total, spi_flash_get_counters()->writev_segment.bytes);
+    TEST_ASSERT_EQUAL((3 + total + WRITEV_TEST_PAGE_SIZE - 1) / WRITEV_TEST_PAGE_SIZE,
+                      spi_flash_get_counters()->writev_program.count);
+#endif
+
+    TEST_ESP_OK(spi_flash_read(start, dst_buf, total + 8));
+    for (int i = 0; i < 3; ++i) {
+        TEST_ASSERT_EQUAL_HEX8(0xff, dst_buf[i]);
+    }
+    TEST_ASSERT_EQUAL(0, cmp_or_dump(src_buf, dst_buf + 3, total));
+    for (size_t i = total + 3; i < total + 8; ++i) {
+        TEST_ASSERT_EQUAL_HEX8(0xff, dst_buf[i]);
+    }
+
+    free(iov);
+    free(src_buf);
+    free(dst_buf);
+}
+
+#if CONFIG_SPI_FLASH_READ_CACHE
+TEST_CASE("spi_flash_read cache is invalidated by writes and erases", "[spi_flash]")
+{
+    setup_tests();
+    const uint32_t pattern[2] = { 0x01234567, 0x89abcdef };
+    uint32_t val[2];
+
+    TEST_ESP_OK(spi_flash_erase_range(start, 2 * SPI_FLASH_SEC_SIZE));
+    TEST_ESP_OK(spi_flash_read(start + 32, val, sizeof(val)));
+    TEST_ASSERT_EQUAL_HEX32(0xffffffff, val[0]);
+
+#if CONFIG_SPI_FLASH_ENABLE_COUNTERS
+    spi_flash_reset_counters();
+#endif
+    TEST_ESP_OK(spi_flash_write(start + 32, pattern, sizeof(pattern)));
+    TEST_ESP_OK(spi_flash_read(start + 32, val, sizeof(val)));
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(pattern, val, 2);
+    TEST_ESP_OK(spi_flash_read(start + 36, val, sizeof(uint32_t)));
+    TEST_ASSERT_EQUAL_HEX32(pattern[1], val[0]);
+#if CONFIG_SPI_FLASH_ENABLE_COUNTERS
+    TEST_ASSERT_EQUAL(1, spi_flash_get_counters()->read_cache_miss.count);
+    TEST_ASSERT_EQUAL(1, spi_flash_get_counters()->read_cache_hit.count);
+#endif
+
+    // a read crossing a sector boundary bypasses the cache
+    TEST_ESP_OK(spi_flash_write(start + SPI_FLASH_SEC_SIZE, pattern, sizeof(pattern)));
+    TEST_ESP_OK(spi_flash_read(start + SPI_FLASH_SEC_SIZE - 4, val, sizeof(val)));
+    TEST_ASSERT_EQUAL_HEX32(0xffffffff, val[0]);
+    TEST_ASSERT_EQUAL_HEX32(pattern[0], val[1]);
+
+    TEST_ESP_OK(spi_flash_erase_sector(start / SPI_FLASH_SEC_SIZE));
+    TEST_ESP_OK(spi_flash_read(start + 32, val, sizeof(val)));
+    TEST_ASSERT_EQUAL_HEX32(0xffffffff, val[0]);
+    TEST_ASSERT_EQUAL_HEX32(0xffffffff, val[1]);
+}
+#endif // CONFIG_SPI_FLASH_READ_CACHE
+
+#if CONFIG_SPI_FLASH_MMAP_READ
+TEST_CASE("large spi_flash_read through the flash cache returns the same data", "[spi_flash]")
+{
+    setup_tests();
+    const size_t size = 3 * SPI_FLASH_SEC_SIZE;
+    char *src_buf = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    char *dst_buf = heap_caps_malloc(size + 1, MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(src_buf);
+    TEST_ASSERT_NOT_NULL(dst_buf);
+    fill(src_buf, 0x55, size);
+
+    TEST_ESP_OK(spi_flash_erase_range(start, size + SPI_FLASH_SEC_SIZE));
+    TEST_ESP_OK(spi_flash_write(start, src_buf, size));
+
+    uint32_t free_pages = spi_flash_mmap_get_free_pages(SPI_FLASH_MMAP_DATA);
+    // unaligned source and destination, so the ROM path would need a bounce buffer
+    const size_t read_size = size - 3;
+    TEST_ASSERT(read_size >= CONFIG_SPI_FLASH_MMAP_READ_THRESHOLD);
+    TEST_ESP_OK(spi_flash_read(start + 3, dst_buf + 1, read_size));
+    TEST_ASSERT_EQUAL(0, cmp_or_dump(src_buf + 3, dst_buf + 1, read_size));
+    TEST_ASSERT_EQUAL(free_pages, spi_flash_mmap_get_free_pages(SPI_FLASH_MMAP_DATA));
+
+    // data written after a read is seen by the next one
+    src_buf[16] = 0;
+    TEST_ESP_OK(spi_flash_write(start + 16, src_buf + 16, 4));
+    TEST_ESP_OK(spi_flash_read(start + 3, dst_buf + 1, read_size));
+    TEST_ASSERT_EQUAL(0, cmp_or_dump(src_buf + 3, dst_buf + 1, read_size));
+
+    free(src_buf);
+    free(dst_buf);
+}
+#endif // CONFIG_SPI_FLASH_MMAP_READ
@@ -9,6 +9,7 @@
 #include "driver/timer.h"
 #include "esp_intr_alloc.h"
 #include "test_utils.h"
+#include "esp_partition.h"
 
 struct flash_test_ctx {
     uint32_t offset;
@@ -226,3 +227,42 @@ TEST_CASE("spi_flash deadlock with high priority busy-waiting task", "[spi_flash
     TEST_ASSERT_EQUAL_INT(uxTaskPriorityGet(NULL), UNITY_FREERTOS_PRIORITY);
 }
 #endif // portNUM_PROCESSORS > 1
+
+static void erase_done_cb(esp_err_t err, void *arg)
+{
+    TEST_ESP_OK(err);
+    xSemaphoreGive((SemaphoreHandle_t) arg);
+}
+
+TEST_CASE("spi_flash_erase_range_async erases the range and lets other tasks run", "[spi_flash]")
+{
+    const esp_partition_t *part = get_test_data_partition();
+    const size_t size = 64 * 1024;
+    TEST_ASSERT(part->size >= size);
+
+    const uint32_t pattern = 0x12345678;
+    for (size_t offset = 0; offset < size; offset += SPI_FLASH_SEC_SIZE) {
+        TEST_ESP_OK(spi_flash_write(part->address + offset, &pattern, sizeof(pattern)));
+    }
+
+    SemaphoreHandle_t done = xSemaphoreCreateBinary();
+    TEST_ESP_OK(spi_flash_erase_range_async(part->address, size, erase_done_cb, done));
+    // this task runs from flash, so it only gets here if the erase doesn't
+    // keep the cache disabled all the time
+    int iterations = 0;
+    while (xSemaphoreTake(done, 0) != pdTRUE) {
+        ++iterations;
+        vTaskDelay(1);
+    }
+    TEST_ASSERT(iterations > 0);
+    vSemaphoreDelete(done);
+
+    for (size_t offset = 0; offset < size; offset += SPI_FLASH_SEC_SIZE) {
+        uint32_t val;
+        TEST_ESP_OK(spi_flash_read(part->address + offset, &val, sizeof(val)));
+        TEST_ASSERT_EQUAL_HEX32(0xffffffff, val);
+    }
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, spi_flash_erase_range_async(part->address + 1, size, NULL, NULL));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, spi_flash_erase_range_async(part->address, 1, NULL, NULL));
+}
@@ -27,8 +27,10 @@
 #include <sys/errno.h>
 #include <sys/fcntl.h>
 #include <sys/lock.h>
+#include <sys/param.h>
 #include "esp_vfs.h"
 #include "esp_err.h"
+#include "esp_timer.h"
 #include "esp32/rom/spi_flash.h"
 #include "spiffs_api.h"
 
@@ -72,6 +74,16 @@ static int vfs_spiffs_rmdir(void* ctx, const char* name);
 static void vfs_spiffs_update_mtime(spiffs *fs, spiffs_file f);
 static time_t vfs_spiffs_get_mtime(const spiffs_stat* s);
 static int vfs_spiffs_utime(void *ctx, const char *path, const struct utimbuf *times);
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+static void esp_spiffs_index_build(esp_spiffs_t *efs);
+static bool esp_spiffs_index_open(esp_spiffs_t *efs, const char *path, spiffs_flags flags,
+        spiffs_mode mode, spiffs_stat *s, spiffs_file *out_fd);
+static void esp_spiffs_index_update(esp_spiffs_t *efs, spiffs_file fd);
+static s32_t esp_spiffs_index_find(esp_spiffs_t *efs, const char *path, spiffs_obj_id *out_obj_id);
+static void esp_spiffs_index_remove(esp_spiffs_t *efs, const char *path, spiffs_obj_id obj_id);
+static void esp_spiffs_index_rename(esp_spiffs_t *efs, const char *src, const char *dst,
+        spiffs_obj_id obj_id);
+#endif
 
 static esp_spiffs_t * _efs[CONFIG_SPIFFS_MAX_PARTITIONS];
 
@@ -83,6 +95,16 @@ static void esp_spiffs_free(esp_spiffs_t ** efs)
     }
     *efs = NULL;
 
+#ifdef CONFIG_SPIFFS_GC_TASK
+    if (e->gc_task) {
+        e->gc_stop = true;
+        xTaskNotifyGive(e->gc_task);
+        xSemaphoreTake(e->gc_done, portMAX_DELAY);
+    }
+    if (e->gc_done) {
+        vSemaphoreDelete(e->gc_done);
+    }
+#endif
     if (e->fs) {
         SPIFFS_unmount(e->fs);
         free(e->fs);
@@ -91,6 +113,10 @@ static void esp_spiffs_free(esp_spiffs_t ** efs)
     free(e->fds);
     free(e->cache);
     free(e->work);
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    free(e->index);
+    _lock_close(&e->index_lock);
+#endif
     free(e);
 }
 
@@ -124,6 +150,66 @@ static esp_err_t esp_spiffs_get_empty(int * index){
     return ESP_ERR_NOT_FOUND;
 }
 
+/* Number of bytes which can be written without garbage collection, as SPIFFS counts them */
+static uint32_t esp_spiffs_gc_free_bytes(spiffs *fs)
+{
+    s32_t free_pages = (SPIFFS_PAGES_PER_BLOCK(fs) - SPIFFS_OBJ_LOOKUP_PAGES(fs)) * (fs->block_count - 2)
+            - fs->stats_p_allocated - fs->stats_p_deleted;
+    return (free_pages > 0) ? free_pages * SPIFFS_DATA_PAGE_SIZE(fs) : 0;
+}
+
+/* Collects garbage in one block */
+static s32_t esp_spiffs_gc_step(esp_spiffs_t *efs)
+{
+    xSemaphoreTake(efs->lock, portMAX_DELAY);
+    const bool garbage = SPIFFS_mounted(efs->fs) && efs->fs->stats_p_deleted > 0;
+    const uint32_t free_bytes = esp_spiffs_gc_free_bytes(efs->fs);
+    xSemaphoreGive(efs->lock);
+    if (!garbage) {
+        return SPIFFS_ERR_NO_DELETED_BLOCKS;
+    }
+
+    // Asking for as many bytes as are free already makes SPIFFS collect one block
+    int64_t start = esp_timer_get_time();
+    s32_t res = SPIFFS_gc(efs->fs, free_bytes);
+    uint32_t time_us = (uint32_t) (esp_timer_get_time() - start);
+    SPIFFS_clearerr(efs->fs);
+    if (res != SPIFFS_OK) {
+        return res;
+    }
+
+    xSemaphoreTake(efs->lock, portMAX_DELAY);
+    efs->gc_stats.runs++;
+    efs->gc_stats.total_time_us += time_us;
+    efs->gc_stats.max_time_us = MAX(efs->gc_stats.max_time_us, time_us);
+    xSemaphoreGive(efs->lock);
+    ESP_LOGD(TAG, "collected one block in %u us", time_us);
+    return SPIFFS_OK;
+}
+
+#ifdef CONFIG_SPIFFS_GC_TASK
+static bool esp_spiffs_gc_needed(esp_spiffs_t *efs)
+{
+    return efs->fs->free_blocks < 2 + CONFIG_SPIFFS_GC_TASK_FREE_BLOCKS;
+}
+
+static void esp_spiffs_gc_task(void *arg)
+{
+    esp_spiffs_t *efs = (esp_spiffs_t *) arg;
+    while (!efs->gc_stop) {
+        ulTaskNotifyTake(pdTRUE, CONFIG_SPIFFS_GC_TASK_PERIOD_MS / portTICK_PERIOD_MS);
+        // Moving the used pages of a block can take a free block, so limit the number of tries
+        for (uint32_t i = 0; i < efs->fs->block_count && !efs->gc_stop && esp_spiffs_gc_needed(efs); i++) {
+            if (esp_spiffs_gc_step(efs) != SPIFFS_OK) {
+                break;
+            }
+        }
+    }
+    xSemaphoreGive(efs->gc_done);
+    vTaskDelete(NULL);
+}
+#endif // CONFIG_SPIFFS_GC_TASK
+
 static esp_err_t esp_spiffs_init(const esp_vfs_spiffs_conf_t* conf)
 {
     int index;
@@ -194,7 +280,10 @@ static esp_err_t esp_spiffs_init(const esp_vfs_spiffs_conf_t* conf)
     memset(efs->fds, 0, efs->fds_sz);
 
 #if SPIFFS_CACHE
-    efs->cache_sz = sizeof(spiffs_cache) + conf->max_files * (sizeof(spiffs_cache_page)
+    size_t cache_pages = conf->cache_pages ? conf->cache_pages : conf->max_files;
+    // SPIFFS tracks the use of cache pages in a 32 bit mask
+    cache_pages = MIN(cache_pages, 32);
+    efs->cache_sz = sizeof(spiffs_cache) + cache_pages * (sizeof(spiffs_cache_page)
                           + efs->cfg.log_page_size);
     efs->cache = malloc(efs->cache_sz);
     if (efs->cache == NULL) {
@@ -247,6 +336,19 @@ static esp_err_t esp_spiffs_init(const esp_vfs_spiffs_conf_t* conf)
         esp_spiffs_free(&efs);
         return ESP_FAIL;
     }
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    esp_spiffs_index_build(efs);
+#endif
+#ifdef CONFIG_SPIFFS_GC_TASK
+    efs->gc_done = xSemaphoreCreateBinary();
+    if (efs->gc_done == NULL || xTaskCreate(&esp_spiffs_gc_task, "spiffs_gc", CONFIG_SPIFFS_GC_TASK_STACK_SIZE,
+            efs, CONFIG_SPIFFS_GC_TASK_PRIORITY, &efs->gc_task) != pdPASS) {
+        ESP_LOGE(TAG, "garbage collection task could not be created");
+        efs->gc_task = NULL;
+        esp_spiffs_free(&efs);
+        return ESP_ERR_NO_MEM;
+    }
+#endif
     _efs[index] = efs;
     return ESP_OK;
 }
@@ -320,12 +422,52 @@ esp_err_t esp_spiffs_format(const char* partition_label)
             SPIFFS_clearerr(_efs[index]->fs);
             return ESP_FAIL;
         }
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+        esp_spiffs_index_build(_efs[index]);
+#endif
     } else {
         esp_spiffs_free(&_efs[index]);
     }
     return ESP_OK;
 }
 
+esp_err_t esp_spiffs_gc(const char* partition_label, size_t size_to_gc)
+{
+    int index;
+    if (esp_spiffs_by_label(partition_label, &index) != ESP_OK) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_spiffs_t *efs = _efs[index];
+    for (uint32_t i = 0; i <= efs->fs->block_count; i++) {
+        xSemaphoreTake(efs->lock, portMAX_DELAY);
+        const bool done = esp_spiffs_gc_free_bytes(efs->fs) >= size_to_gc;
+        xSemaphoreGive(efs->lock);
+        if (done) {
+            return ESP_OK;
+        }
+        s32_t res = esp_spiffs_gc_step(efs);
+        if (res == SPIFFS_ERR_NO_DELETED_BLOCKS || res == SPIFFS_ERR_FULL) {
+            break;
+        } else if (res != SPIFFS_OK) {
+            ESP_LOGE(TAG, "garbage collection failed, %i", res);
+            return ESP_FAIL;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t esp_spiffs_gc_stats(const char* partition_label, esp_spiffs_gc_stats_t* out_stats)
+{
+    int index;
+    if (esp_spiffs_by_label(partition_label, &index) != ESP_OK) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(_efs[index]->lock, portMAX_DELAY);
+    *out_stats = _efs[index]->gc_stats;
+    xSemaphoreGive(_efs[index]->lock);
+    return ESP_OK;
+}
+
 esp_err_t esp_vfs_spiffs_register(const esp_vfs_spiffs_conf_t * conf)
 {
     assert(conf->base_path);
@@ -454,7 +596,27 @@ static int vfs_spiffs_open(void* ctx, const char * path, int flags, int mode)
     assert(path);
     esp_spiffs_t * efs = (esp_spiffs_t *)ctx;
     int spiffs_flags = spiffs_mode_conv(flags);
-    int fd = SPIFFS_open(efs->fs, path, spiffs_flags, mode);
+    int fd = -1;
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    spiffs_stat s;
+    spiffs_file index_fd;
+    if (!(spiffs_flags & (SPIFFS_O_TRUNC | SPIFFS_O_EXCL))
+            && esp_spiffs_index_open(efs, path, spiffs_flags, mode, &s, &index_fd)) {
+        if (index_fd == SPIFFS_ERR_NOT_FOUND && !(spiffs_flags & SPIFFS_O_CREAT)) {
+            errno = ENOENT;
+            return -1;
+        }
+        if (index_fd < 0 && index_fd != SPIFFS_ERR_NOT_FOUND) {
+            errno = spiffs_res_to_errno(index_fd);
+            return -1;
+        }
+        fd = index_fd;
+    }
+    const bool by_name = fd < 0;
+#endif
+    if (fd < 0) {
+        fd = SPIFFS_open(efs->fs, path, spiffs_flags, mode);
+    }
     if (fd < 0) {
         errno = spiffs_res_to_errno(SPIFFS_errno(efs->fs));
         SPIFFS_clearerr(efs->fs);
@@ -463,6 +625,11 @@ static int vfs_spiffs_open(void* ctx, const char * path, int flags, int mode)
     if (!(spiffs_flags & SPIFFS_RDONLY)) {
         vfs_spiffs_update_mtime(efs->fs, fd);
     }
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    if (by_name || !(spiffs_flags & SPIFFS_RDONLY)) {
+        esp_spiffs_index_update(efs, fd);
+    }
+#endif
     return fd;
 }
 
@@ -475,6 +642,11 @@ static ssize_t vfs_spiffs_write(void* ctx, int fd, const void * data, size_t siz
         SPIFFS_clearerr(efs->fs);
         return -1;
     }
+#ifdef CONFIG_SPIFFS_GC_TASK
+    if (esp_spiffs_gc_needed(efs)) {
+        xTaskNotifyGive(efs->gc_task);
+    }
+#endif
     return res;
 }
 
@@ -493,6 +665,13 @@ static ssize_t vfs_spiffs_read(void* ctx, int fd, void * dst, size_t size)
 static int vfs_spiffs_close(void* ctx, int fd)
 {
     esp_spiffs_t * efs = (esp_spiffs_t *)ctx;
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    // Writes move the object index header, record where it ends up
+    if (SPIFFS_fflush(efs->fs, fd) == SPIFFS_OK) {
+        esp_spiffs_index_update(efs, fd);
+    }
+    SPIFFS_clearerr(efs->fs);
+#endif
     int res = SPIFFS_close(efs->fs, fd);
     if (res < 0) {
         errno = spiffs_res_to_errno(SPIFFS_errno(efs->fs));
@@ -539,7 +718,24 @@ static int vfs_spiffs_stat(void* ctx, const char * path, struct stat * st)
     assert(st);
     spiffs_stat s;
     esp_spiffs_t * efs = (esp_spiffs_t *)ctx;
-    off_t res = SPIFFS_stat(efs->fs, path, &s);
+    off_t res = -1;
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    spiffs_file fd;
+    if (esp_spiffs_index_open(efs, path, SPIFFS_O_RDONLY, 0, &s, &fd)) {
+        if (fd == SPIFFS_ERR_NOT_FOUND) {
+            errno = ENOENT;
+            return -1;
+        }
+        if (fd >= 0) {
+            SPIFFS_close(efs->fs, fd);
+            res = SPIFFS_OK;
+        }
+    }
+    if (res < 0)
+#endif
+    {
+        res = SPIFFS_stat(efs->fs, path, &s);
+    }
     if (res < 0) {
         errno = spiffs_res_to_errno(SPIFFS_errno(efs->fs));
         SPIFFS_clearerr(efs->fs);
@@ -560,12 +756,23 @@ static int vfs_spiffs_rename(void* ctx, const char *src, const char *dst)
     assert(src);
     assert(dst);
     esp_spiffs_t * efs = (esp_spiffs_t *)ctx;
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    spiffs_obj_id obj_id;
+    s32_t err = esp_spiffs_index_find(efs, src, &obj_id);
+    if (err != SPIFFS_OK) {
+        errno = spiffs_res_to_errno(err);
+        return -1;
+    }
+#endif
     int res = SPIFFS_rename(efs->fs, src, dst);
     if (res < 0) {
         errno = spiffs_res_to_errno(SPIFFS_errno(efs->fs));
         SPIFFS_clearerr(efs->fs);
         return -1;
     }
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    esp_spiffs_index_rename(efs, src, dst, obj_id);
+#endif
     return res;
 }
 
@@ -573,12 +780,23 @@ static int vfs_spiffs_unlink(void* ctx, const char *path)
 {
     assert(path);
     esp_spiffs_t * efs = (esp_spiffs_t *)ctx;
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    spiffs_obj_id obj_id;
+    s32_t err = esp_spiffs_index_find(efs, path, &obj_id);
+    if (err != SPIFFS_OK) {
+        errno = spiffs_res_to_errno(err);
+        return -1;
+    }
+#endif
     int res = SPIFFS_remove(efs->fs, path);
     if (res < 0) {
         errno = spiffs_res_to_errno(SPIFFS_errno(efs->fs));
         SPIFFS_clearerr(efs->fs);
         return -1;
     }
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    esp_spiffs_index_remove(efs, path, obj_id);
+#endif
     return res;
 }
 
@@ -796,3 +1014,273 @@ static int vfs_spiffs_utime(void *ctx, const char *path, const struct utimbuf *t
     return 0;
 }
 #endif //CONFIG_SPIFFS_USE_MTIME
+
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+/*
+ * The name index maps hashes of file names to object ids and to pages of object
+ * index headers, so that files can be opened by page instead of scanning the
+ * object lookup pages of all blocks for the name. SPIFFS moves the header of a
+ * file when it is modified or garbage collected, so the page is only a hint:
+ * files opened by page are verified against the name and the object id, and
+ * looked up by name if the page is outdated. The index does contain all files
+ * of the partition, so files which are not in it don't exist.
+ */
+
+static uint32_t esp_spiffs_index_hash(const char *name)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261;
+    while (*name) {
+        hash = (hash ^ (uint8_t) *name++) * 16777619;
+    }
+    return hash;
+}
+
+static int esp_spiffs_index_compare(const void *a, const void *b)
+{
+    uint32_t ha = ((const esp_spiffs_index_entry_t *) a)->hash;
+    uint32_t hb = ((const esp_spiffs_index_entry_t *) b)->hash;
+    return (ha > hb) - (ha < hb);
+}
+
+/* Returns the position of the first entry with the hash, or of the first greater one */
+static uint32_t esp_spiffs_index_first(const esp_spiffs_t *efs, uint32_t hash)
+{
+    uint32_t lo = 0, hi = efs->index_count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (efs->index[mid].hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void esp_spiffs_index_invalidate(esp_spiffs_t *efs)
+{
+    ESP_LOGW(TAG, "file name index disabled, out of memory");
+    free(efs->index);
+    efs->index = NULL;
+    efs->index_count = 0;
+    efs->index_size = 0;
+    efs->index_valid = false;
+}
+
+static bool esp_spiffs_index_reserve(esp_spiffs_t *efs)
+{
+    if (efs->index_count < efs->index_size) {
+        return true;
+    }
+    uint32_t size = efs->index_size ? efs->index_size * 2 : 16;
+    esp_spiffs_index_entry_t *index = realloc(efs->index, size * sizeof(esp_spiffs_index_entry_t));
+    if (index == NULL) {
+        esp_spiffs_index_invalidate(efs);
+        return false;
+    }
+    efs->index = index;
+    efs->index_size = size;
+    return true;
+}
+
+/* Sets the page of the file, adding it to the index if it isn't there yet. Index lock must be held. */
+static void esp_spiffs_index_set(esp_spiffs_t *efs, uint32_t hash, spiffs_obj_id obj_id, spiffs_page_ix pix)
+{
+    if (!efs->index_valid) {
+        return;
+    }
+    uint32_t i = esp_spiffs_index_first(efs, hash);
+    for (uint32_t j = i; j < efs->index_count && efs->index[j].hash == hash; j++) {
+        if (efs->index[j].obj_id == obj_id) {
+            efs->index[j].pix = pix;
+            return;
+        }
+    }
+    if (!esp_spiffs_index_reserve(efs)) {
+        return;
+    }
+    memmove(&efs->index[i + 1], &efs->index[i], (efs->index_count - i) * sizeof(esp_spiffs_index_entry_t));
+    efs->index[i] = (esp_spiffs_index_entry_t) {
+        .hash = hash,
+        .obj_id = obj_id,
+        .pix = pix
+    };
+    efs->index_count++;
+}
+
+/* Removes the file from the index. Index lock must be held. */
+static void esp_spiffs_index_erase(esp_spiffs_t *efs, uint32_t hash, spiffs_obj_id obj_id)
+{
+    for (uint32_t i = esp_spiffs_index_first(efs, hash);
+            i < efs->index_count && efs->index[i].hash == hash; i++) {
+        if (efs->index[i].obj_id == obj_id) {
+            efs->index_count--;
+            memmove(&efs->index[i], &efs->index[i + 1], (efs->index_count - i) * sizeof(esp_spiffs_index_entry_t));
+            return;
+        }
+    }
+}
+
+static void esp_spiffs_index_build(esp_spiffs_t *efs)
+{
+    spiffs_DIR d;
+    struct spiffs_dirent e;
+
+    _lock_acquire(&efs->index_lock);
+    efs->index_count = 0;
+    efs->index_valid = false;
+    if (!SPIFFS_opendir(efs->fs, "/", &d)) {
+        SPIFFS_clearerr(efs->fs);
+        _lock_release(&efs->index_lock);
+        return;
+    }
+    bool ok = true;
+    while (ok && SPIFFS_readdir(&d, &e)) {
+        ok = esp_spiffs_index_reserve(efs);
+        if (ok) {
+            efs->index[efs->index_count++] = (esp_spiffs_index_entry_t) {
+                .hash = esp_spiffs_index_hash((const char *) e.name),
+                .obj_id = e.obj_id & ~SPIFFS_OBJ_ID_IX_FLAG,
+                .pix = e.pix
+            };
+        }
+    }
+    SPIFFS_closedir(&d);
+    if (ok && SPIFFS_errno(efs->fs) == SPIFFS_OK) {
+        qsort(efs->index, efs->index_count, sizeof(esp_spiffs_index_entry_t), &esp_spiffs_index_compare);
+        efs->index_valid = true;
+    }
+    SPIFFS_clearerr(efs->fs);
+    _lock_release(&efs->index_lock);
+}
+
+/* Opens the object index header at pix, if it is the one of the file at path */
+static spiffs_file esp_spiffs_index_open_page(esp_spiffs_t *efs, spiffs_page_ix pix, spiffs_obj_id obj_id,
+        const char *path, spiffs_flags flags, spiffs_mode mode, spiffs_stat *s)
+{
+    if (pix == 0) {
+        return SPIFFS_ERR_NOT_A_FILE;
+    }
+    spiffs_file fd = SPIFFS_open_by_page(efs->fs, pix, flags, mode);
+    if (fd < 0) {
+        fd = SPIFFS_errno(efs->fs);
+        SPIFFS_clearerr(efs->fs);
+        return fd;
+    }
+    if (SPIFFS_fstat(efs->fs, fd, s) != SPIFFS_OK || (s->obj_id & ~SPIFFS_OBJ_ID_IX_FLAG) != obj_id
+            || strcmp((const char *) s->name, path) != 0) {
+        SPIFFS_close(efs->fs, fd);
+        SPIFFS_clearerr(efs->fs);
+        return SPIFFS_ERR_NOT_A_FILE;
+    }
+    return fd;
+}
+
+/*
+ * Opens an existing file through the index. flags must not contain SPIFFS_O_TRUNC
+ * or SPIFFS_O_EXCL. Returns false if the index can't be used, then the file should
+ * be opened by name. Otherwise *out_fd is the file descriptor, SPIFFS_ERR_NOT_FOUND
+ * if the file doesn't exist, or another SPIFFS error.
+ */
+static bool esp_spiffs_index_open(esp_spiffs_t *efs, const char *path, spiffs_flags flags,
+        spiffs_mode mode, spiffs_stat *s, spiffs_file *out_fd)
+{
+    const uint32_t hash = esp_spiffs_index_hash(path);
+    bool outdated = false;
+
+    _lock_acquire(&efs->index_lock);
+    if (!efs->index_valid) {
+        _lock_release(&efs->index_lock);
+        return false;
+    }
+    for (uint32_t i = esp_spiffs_index_first(efs, hash);
+            i < efs->index_count && efs->index[i].hash == hash; i++) {
+        spiffs_file fd = esp_spiffs_index_open_page(efs, efs->index[i].pix, efs->index[i].obj_id,
+                path, flags, mode, s);
+        if (fd >= 0) {
+            efs->index[i].pix = s->pix;
+            _lock_release(&efs->index_lock);
+            *out_fd = fd;
+            return true;
+        }
+        if (fd == SPIFFS_ERR_OUT_OF_FILE_DESCS) {
+            _lock_release(&efs->index_lock);
+            *out_fd = fd;
+            return true;
+        }
+        outdated = true;
+    }
+    if (outdated) {
+        // One of the files with this hash was moved: find its header by name
+        spiffs_stat st;
+        if (SPIFFS_stat(efs->fs, path, &st) == SPIFFS_OK) {
+            spiffs_obj_id obj_id = st.obj_id & ~SPIFFS_OBJ_ID_IX_FLAG;
+            esp_spiffs_index_set(efs, hash, obj_id, st.pix);
+            *out_fd = esp_spiffs_index_open_page(efs, st.pix, obj_id, path, flags, mode, s);
+        } else {
+            *out_fd = SPIFFS_errno(efs->fs);
+            SPIFFS_clearerr(efs->fs);
+        }
+    } else {
+        *out_fd = SPIFFS_ERR_NOT_FOUND;
+    }
+    _lock_release(&efs->index_lock);
+    return true;
+}
+
+/* Records the current header page of an open file */
+static void esp_spiffs_index_update(esp_spiffs_t *efs, spiffs_file fd)
+{
+    spiffs_stat s;
+    if (SPIFFS_fstat(efs->fs, fd, &s) != SPIFFS_OK) {
+        SPIFFS_clearerr(efs->fs);
+        return;
+    }
+    _lock_acquire(&efs->index_lock);
+    esp_spiffs_index_set(efs, esp_spiffs_index_hash((const char *) s.name),
+            s.obj_id & ~SPIFFS_OBJ_ID_IX_FLAG, s.pix);
+    _lock_release(&efs->index_lock);
+}
+
+/* Finds the object id of an existing file, using the index if possible */
+static s32_t esp_spiffs_index_find(esp_spiffs_t *efs, const char *path, spiffs_obj_id *out_obj_id)
+{
+    spiffs_stat s;
+    spiffs_file fd;
+    if (esp_spiffs_index_open(efs, path, SPIFFS_O_RDONLY, 0, &s, &fd)) {
+        if (fd == SPIFFS_ERR_NOT_FOUND) {
+            return fd;
+        }
+        if (fd >= 0) {
+            SPIFFS_close(efs->fs, fd);
+            *out_obj_id = s.obj_id & ~SPIFFS_OBJ_ID_IX_FLAG;
+            return SPIFFS_OK;
+        }
+    }
+    if (SPIFFS_stat(efs->fs, path, &s) != SPIFFS_OK) {
+        s32_t res = SPIFFS_errno(efs->fs);
+        SPIFFS_clearerr(efs->fs);
+        return res;
+    }
+    *out_obj_id = s.obj_id & ~SPIFFS_OBJ_ID_IX_FLAG;
+    return SPIFFS_OK;
+}
+
+static void esp_spiffs_index_remove(esp_spiffs_t *efs, const char *path, spiffs_obj_id obj_id)
+{
+    _lock_acquire(&efs->index_lock);
+    esp_spiffs_index_erase(efs, esp_spiffs_index_hash(path), obj_id);
+    _lock_release(&efs->index_lock);
+}
+
+static void esp_spiffs_index_rename(esp_spiffs_t *efs, const char *src, const char *dst,
+        spiffs_obj_id obj_id)
+{
+    _lock_acquire(&efs->index_lock);
+    esp_spiffs_index_erase(efs, esp_spiffs_index_hash(src), obj_id);
+    // Renaming rewrites the header, its new page is found on the next lookup
+    esp_spiffs_index_set(efs, esp_spiffs_index_hash(dst), obj_id, 0);
+    _lock_release(&efs->index_lock);
+}
+#endif // CONFIG_SPIFFS_NAME_INDEX
@@ -16,6 +16,8 @@
 #define _ESP_SPIFFS_H_
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include "esp_err.h"
 
 #ifdef __cplusplus
@@ -30,8 +32,18 @@ typedef struct {
         const char* partition_label;    /*!< Optional, label of SPIFFS partition to use. If set to NULL, first partition with subtype=spiffs will be used. */
         size_t max_files;               /*!< Maximum files that could be open at the same time. */
         bool format_if_mount_failed;    /*!< If true, it will format the file system if it fails to mount. */
+        size_t cache_pages;             /*!< Optional, number of pages in the SPIFFS cache (at most 32) if CONFIG_SPIFFS_CACHE is enabled. If set to 0, max_files pages are cached. */
 } esp_vfs_spiffs_conf_t;
 
+/**
+ * @brief Garbage collection statistics, see esp_spiffs_gc_stats
+ */
+typedef struct {
+        uint32_t runs;                  /*!< Number of blocks collected by esp_spiffs_gc and the garbage collection task */
+        uint64_t total_time_us;         /*!< Total time spent collecting these blocks, in microseconds */
+        uint32_t max_time_us;           /*!< Longest time collecting one block took, in microseconds. Other operations on the partition wait for that long. */
+} esp_spiffs_gc_stats_t;
+
 /**
  * Register and mount SPIFFS to VFS with given path prefix.
  *
@@ -95,6 +107,43 @@ esp_err_t esp_spiffs_format(const char* partition_label);
  */
 esp_err_t esp_spiffs_info(const char* partition_label, size_t *total_bytes, size_t *used_bytes);
 
+/**
+ * Collect garbage in the SPIFFS partition
+ *
+ * SPIFFS marks pages which are overwritten or removed as deleted, and needs to
+ * collect garbage, i.e. move the used pages of a block and erase it, before
+ * the deleted pages can be written again. SPIFFS does this when a write finds too
+ * few free pages, which makes that write take long. This function collects garbage
+ * one block at a time, until size_to_gc bytes can be written without garbage
+ * collection. Other operations on the partition wait only while one block is
+ * collected, so this function can be called from a low priority task.
+ * See also CONFIG_SPIFFS_GC_TASK.
+ *
+ * @param partition_label  Optional, label of the partition to collect garbage in.
+ *                         If not specified, first partition with subtype=spiffs is used.
+ * @param size_to_gc       Number of bytes which should be writable without garbage collection
+ * @return
+ *          - ESP_OK                  if size_to_gc bytes can be written
+ *          - ESP_ERR_NOT_FOUND       if there is not enough garbage to collect
+ *          - ESP_ERR_INVALID_STATE   if not mounted
+ *          - ESP_FAIL                on error
+ */
+esp_err_t esp_spiffs_gc(const char* partition_label, size_t size_to_gc);
+
+/**
+ * Get garbage collection statistics of the SPIFFS partition
+ *
+ * Garbage collection which SPIFFS does during writes is not included.
+ *
+ * @param partition_label  Optional, label of the partition.
+ *                         If not specified, first partition with subtype=spiffs is used.
+ * @param[out] out_stats   Statistics since the partition was mounted
+ * @return
+ *          - ESP_OK                  if success
+ *          - ESP_ERR_INVALID_STATE   if not mounted
+ */
+esp_err_t esp_spiffs_gc_stats(const char* partition_label, esp_spiffs_gc_stats_t* out_stats);
+
 #ifdef __cplusplus
 }
 #endif
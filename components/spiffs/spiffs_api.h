@@ -16,16 +16,28 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <sys/lock.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include "spiffs.h"
 #include "esp_vfs.h"
+#include "esp_spiffs.h"
+#include "sdkconfig.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief Entry of the file name index
+ */
+typedef struct {
+    uint32_t hash;                          /*!< Hash of the file name */
+    spiffs_obj_id obj_id;                   /*!< Object id of the file */
+    spiffs_page_ix pix;                     /*!< Page of the object index header when last seen, 0 if not known */
+} esp_spiffs_index_entry_t;
+
 /**
  * @brief SPIFFS definition structure
  */
@@ -41,6 +53,19 @@ typedef struct {
     uint32_t fds_sz;                        /*!< File Descriptor Buffer Length */
     uint8_t *cache;                         /*!< Cache Buffer */
     uint32_t cache_sz;                      /*!< Cache Buffer Length */
+    esp_spiffs_gc_stats_t gc_stats;         /*!< Statistics of esp_spiffs_gc and the GC task, protected by lock */
+#ifdef CONFIG_SPIFFS_GC_TASK
+    TaskHandle_t gc_task;                   /*!< Task collecting garbage in the background */
+    SemaphoreHandle_t gc_done;              /*!< Given by the GC task when it stops */
+    volatile bool gc_stop;                  /*!< Set to stop the GC task */
+#endif
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    esp_spiffs_index_entry_t *index;        /*!< File name index, sorted by hash */
+    uint32_t index_count;                   /*!< Number of entries in the index */
+    uint32_t index_size;                    /*!< Number of entries the index buffer can hold */
+    bool index_valid;                       /*!< All files of the partition are in the index */
+    _lock_t index_lock;                     /*!< Protects the index */
+#endif
 } esp_spiffs_t;
 
 s32_t spiffs_api_read(spiffs *fs, uint32_t addr, uint32_t size, uint8_t *dst);
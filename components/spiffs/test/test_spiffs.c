@@ -15,6 +15,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <time.h>
 #include <sys/time.h>
 #include <sys/unistd.h>
@@ -715,3 +716,131 @@ TEST_CASE("utime() works well", "[spiffs]")
     test_teardown();
 }
 #endif // CONFIG_SPIFFS_USE_MTIME
+
+static void test_spiffs_check_file_size(const char* name, int size)
+{
+    struct stat st;
+    if (size < 0) {
+        TEST_ASSERT_EQUAL(-1, stat(name, &st));
+        TEST_ASSERT_EQUAL(ENOENT, errno);
+        TEST_ASSERT_NULL(fopen(name, "r"));
+        return;
+    }
+    TEST_ASSERT_EQUAL(0, stat(name, &st));
+    TEST_ASSERT_EQUAL(size, st.st_size);
+    FILE* f = fopen(name, "r");
+    TEST_ASSERT_NOT_NULL(f);
+    TEST_ASSERT_EQUAL(0, fseek(f, 0, SEEK_END));
+    TEST_ASSERT_EQUAL(size, ftell(f));
+    TEST_ASSERT_EQUAL(0, fclose(f));
+}
+
+TEST_CASE("files are found after they are written, renamed and removed", "[spiffs]")
+{
+    const int n_files = 16;
+    char name[64];
+    char new_name[64];
+    char data[300];
+    memset(data, 'x', sizeof(data));
+    test_setup();
+    for (int i = 0; i < n_files; ++i) {
+        snprintf(name, sizeof(name), "/spiffs/idx%d.txt", i);
+        unlink(name);
+        snprintf(name, sizeof(name), "/spiffs/idx%d_new.txt", i);
+        unlink(name);
+    }
+    for (int i = 0; i < n_files; ++i) {
+        snprintf(name, sizeof(name), "/spiffs/idx%d.txt", i);
+        FILE* f = fopen(name, "w");
+        TEST_ASSERT_NOT_NULL(f);
+        TEST_ASSERT_EQUAL(i, fwrite(data, 1, i, f));
+        TEST_ASSERT_EQUAL(0, fclose(f));
+    }
+    // appending moves the object index header of the file
+    for (int i = 0; i < n_files; i += 2) {
+        snprintf(name, sizeof(name), "/spiffs/idx%d.txt", i);
+        FILE* f = fopen(name, "a");
+        TEST_ASSERT_NOT_NULL(f);
+        TEST_ASSERT_EQUAL(300, fwrite(data, 1, 300, f));
+        TEST_ASSERT_EQUAL(0, fclose(f));
+    }
+    for (int i = 0; i < n_files; i += 4) {
+        snprintf(name, sizeof(name), "/spiffs/idx%d.txt", i);
+        snprintf(new_name, sizeof(new_name), "/spiffs/idx%d_new.txt", i);
+        TEST_ASSERT_EQUAL(0, rename(name, new_name));
+    }
+    for (int i = 1; i < n_files; i += 4) {
+        snprintf(name, sizeof(name), "/spiffs/idx%d.txt", i);
+        TEST_ASSERT_EQUAL(0, unlink(name));
+        TEST_ASSERT_EQUAL(-1, unlink(name));
+        TEST_ASSERT_EQUAL(ENOENT, errno);
+    }
+    // check twice, the second time after the index is built again on mount
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int i = 0; i < n_files; ++i) {
+            int size = i + ((i % 2 == 0) ? 300 : 0);
+            snprintf(name, sizeof(name), "/spiffs/idx%d.txt", i);
+            snprintf(new_name, sizeof(new_name), "/spiffs/idx%d_new.txt", i);
+            if (i % 4 == 0) {
+                test_spiffs_check_file_size(name, -1);
+                test_spiffs_check_file_size(new_name, size);
+            } else {
+                test_spiffs_check_file_size(name, (i % 4 == 1) ? -1 : size);
+                test_spiffs_check_file_size(new_name, -1);
+            }
+        }
+        test_teardown();
+        test_setup();
+    }
+    test_teardown();
+}
+
+TEST_CASE("can mount with a given number of cache pages", "[spiffs]")
+{
+    esp_vfs_spiffs_conf_t conf = {
+        .base_path = "/spiffs",
+        .partition_label = spiffs_test_partition_label,
+        .max_files = 2,
+        .format_if_mount_failed = true,
+        .cache_pages = 8
+    };
+    TEST_ESP_OK(esp_vfs_spiffs_register(&conf));
+    test_spiffs_create_file_with_text("/spiffs/cache.txt", spiffs_test_hello_str);
+    test_spiffs_read_file("/spiffs/cache.txt");
+    test_teardown();
+}
+
+TEST_CASE("garbage can be collected in advance", "[spiffs][timeout=60]")
+{
+    const esp_partition_t* part = get_test_data_partition();
+    TEST_ASSERT_NOT_NULL(part);
+    TEST_ESP_OK(esp_spiffs_format(part->label));
+    test_setup();
+    size_t total = 0, used = 0;
+    TEST_ESP_OK(esp_spiffs_info(spiffs_test_partition_label, &total, &used));
+
+    // fill half of the free space with a file which is then removed
+    const char* filename = "/spiffs/garbage.bin";
+    char data[512];
+    memset(data, 0xa5, sizeof(data));
+    FILE* f = fopen(filename, "wb");
+    TEST_ASSERT_NOT_NULL(f);
+    for (size_t written = 0; written < (total - used) / 2; written += sizeof(data)) {
+        TEST_ASSERT_EQUAL(sizeof(data), fwrite(data, 1, sizeof(data), f));
+    }
+    TEST_ASSERT_EQUAL(0, fclose(f));
+    TEST_ASSERT_EQUAL(0, unlink(filename));
+
+    TEST_ESP_OK(esp_spiffs_info(spiffs_test_partition_label, &total, &used));
+    TEST_ESP_OK(esp_spiffs_gc(spiffs_test_partition_label, (total - used) * 3 / 4));
+    esp_spiffs_gc_stats_t stats;
+    TEST_ESP_OK(esp_spiffs_gc_stats(spiffs_test_partition_label, &stats));
+    printf("collected %u blocks in %u ms, at most %u ms per block\n",
+            stats.runs, (uint32_t) (stats.total_time_us / 1000), stats.max_time_us / 1000);
+    TEST_ASSERT_GREATER_THAN(0, stats.runs);
+
+    // there is never that much garbage
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, esp_spiffs_gc(spiffs_test_partition_label, total + 1));
+    test_teardown();
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, esp_spiffs_gc(spiffs_test_partition_label, 0));
+}
@@ -15,5 +15,6 @@
 #define CONFIG_WL_SECTOR_SIZE 4096
 #define CONFIG_LOG_DEFAULT_LEVEL 3
 #define CONFIG_PARTITION_TABLE_OFFSET 0x8000
+#define CONFIG_SPI_FLASH_ERASE_TASK_PRIORITY 5
 
 #define CONFIG_ESPTOOLPY_FLASHSIZE "8MB"
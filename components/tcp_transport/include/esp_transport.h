@@ -33,6 +33,16 @@ typedef int (*poll_func)(esp_transport_handle_t t, int timeout_ms);
 typedef int (*connect_async_func)(esp_transport_handle_t t, const char *host, int port, int timeout_ms);
 typedef esp_transport_handle_t (*payload_transfer_func)(esp_transport_handle_t);
 
+/**
+ * One buffer of a scatter/gather write
+ */
+typedef struct {
+    const char  *buffer;        /*!< Data to write */
+    int         len;            /*!< Length of the data */
+} esp_transport_iovec_t;
+
+typedef int (*io_vec_func)(esp_transport_handle_t t, const esp_transport_iovec_t *iov, int iovcnt, int timeout_ms);
+
 /**
  * @brief      Create transport list
  *
@@ -64,6 +74,20 @@ esp_err_t esp_transport_list_destroy(esp_transport_list_handle_t list);
  */
 esp_err_t esp_transport_list_add(esp_transport_list_handle_t list, esp_transport_handle_t t, const char *scheme);
 
+/**
+ * @brief      Remove a transport from the list without destroying it,
+ *             the caller becomes responsible for calling esp_transport_destroy
+ *
+ * @param[in]  list  The list
+ * @param[in]  t     The transport
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_ARG
+ *     - ESP_ERR_NOT_FOUND if the transport isn't in the list
+ */
+esp_err_t esp_transport_list_remove(esp_transport_list_handle_t list, esp_transport_handle_t t);
+
 /**
  * @brief      This function will remove all transport from the list,
  *             invoke esp_transport_destroy of every transport have added this the list
@@ -94,7 +118,8 @@ esp_transport_handle_t esp_transport_list_get_transport(esp_transport_list_handl
 esp_transport_handle_t esp_transport_init();
 
 /**
- * @brief      Cleanup and free memory the transport
+ * @brief      Cleanup and free memory the transport, including the data of
+ *             the transport type (closing the connection if it is open)
  *
  * @param[in]  t     The transport handle
  *
@@ -194,6 +219,24 @@ int esp_transport_poll_read(esp_transport_handle_t t, int timeout_ms);
  */
 int esp_transport_write(esp_transport_handle_t t, const char *buffer, int len, int timeout_ms);
 
+/**
+ * @brief      Transport scatter/gather write function, writes several buffers with as few
+ *             segments (or records) as the transport allows
+ *
+ *             Transports without a writev function write the buffers one by one.
+ *             Like esp_transport_write(), this may write less than the total length.
+ *
+ * @param      t           The transport handle
+ * @param[in]  iov         The buffers to write, in order
+ * @param[in]  iovcnt      Number of buffers
+ * @param[in]  timeout_ms  The timeout milliseconds
+ *
+ * @return
+ *  - Number of bytes was written, counted across all buffers
+ *  - (-1) if there are any errors, should check errno
+ */
+int esp_transport_writev(esp_transport_handle_t t, const esp_transport_iovec_t *iov, int iovcnt, int timeout_ms);
+
 /**
  * @brief      Poll the transport until writeable or timeout
  *
@@ -286,6 +329,19 @@ esp_err_t esp_transport_set_func(esp_transport_handle_t t,
  */
 esp_err_t esp_transport_set_async_connect_func(esp_transport_handle_t t, connect_async_func _connect_async_func);
 
+/**
+ * @brief      Set scatter/gather write function for the transport handle,
+ *             must be called after esp_transport_set_func()
+ *
+ * @param[in]  t          The transport handle
+ * @param[in]  _writev    The writev function pointer
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL
+ */
+esp_err_t esp_transport_set_writev_func(esp_transport_handle_t t, io_vec_func _writev);
+
 /**
  * @brief      Set parent transport function to the handle
  *
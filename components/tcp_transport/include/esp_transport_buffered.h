@@ -0,0 +1,60 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _ESP_TRANSPORT_BUFFERED_H_
+#define _ESP_TRANSPORT_BUFFERED_H_
+
+#include "esp_transport.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief      Create a buffered transport on top of another transport
+ *
+ *             Writes to the buffered transport are collected in a buffer of `buffer_size` bytes
+ *             and sent to the parent transport in one write when the buffer is full, when
+ *             esp_transport_buffered_flush() is called, or before reading or polling for read.
+ *             Over SSL, this turns a series of small writes into full TLS records.
+ *             Writes larger than the buffer bypass it.
+ *
+ *             The parent transport is not destroyed with the buffered transport.
+ *
+ * @param[in]  parent_handle  The transport to write to
+ * @param[in]  buffer_size    Size of the write buffer
+ *
+ * @return
+ *  - transport
+ *  - NULL
+ */
+esp_transport_handle_t esp_transport_buffered_init(esp_transport_handle_t parent_handle, int buffer_size);
+
+/**
+ * @brief      Send the buffered data to the parent transport
+ *
+ * @param[in]  t           The buffered transport handle
+ * @param[in]  timeout_ms  The timeout milliseconds
+ *
+ * @return
+ *     - 0 if all the buffered data was sent
+ *     - (-1) if there are any errors, the buffered data is kept
+ */
+int esp_transport_buffered_flush(esp_transport_handle_t t, int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_TRANSPORT_BUFFERED_H_ */
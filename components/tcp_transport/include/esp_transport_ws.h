@@ -7,12 +7,36 @@
 #ifndef _ESP_TRANSPORT_WS_H_
 #define _ESP_TRANSPORT_WS_H_
 
+#include <stdbool.h>
+#include <stdint.h>
 #include "esp_transport.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+typedef enum ws_transport_opcodes {
+    WS_TRANSPORT_OPCODES_CONT   = 0x00,
+    WS_TRANSPORT_OPCODES_TEXT   = 0x01,
+    WS_TRANSPORT_OPCODES_BINARY = 0x02,
+    WS_TRANSPORT_OPCODES_CLOSE  = 0x08,
+    WS_TRANSPORT_OPCODES_PING   = 0x09,
+    WS_TRANSPORT_OPCODES_PONG   = 0x0a,
+} ws_transport_opcodes_t;
+
+/**
+ * @brief      Called by esp_transport_ws_read_message() for each piece of a message
+ *
+ * @param[in]  t         The web socket transport handle
+ * @param[in]  opcode    Opcode of the message, WS_TRANSPORT_OPCODES_TEXT or WS_TRANSPORT_OPCODES_BINARY
+ * @param[in]  data      Unmasked payload, valid until the callback returns
+ * @param[in]  len       Length of the payload
+ * @param[in]  fin       True for the last piece of the message
+ * @param[in]  user_ctx  The user context
+ *
+ * @return     0 to continue, other values abort the read
+ */
+typedef int (*esp_transport_ws_message_cb_t)(esp_transport_handle_t t, uint8_t opcode, const char *data, int len, bool fin, void *user_ctx);
 
 /**
  * @brief      Create web socket transport
@@ -25,6 +49,30 @@ esp_transport_handle_t esp_transport_ws_init(esp_transport_handle_t parent_handl
 
 void esp_transport_ws_set_path(esp_transport_handle_t t, const char *path);
 
+/**
+ * @brief      Read a whole message, which may be fragmented over several frames
+ *             and larger than the buffer, without buffering it
+ *
+ *             The payload is read into `buffer` as it arrives, unmasked in place and passed to
+ *             `callback`, so `len` only limits the size of each piece. Pings that arrive
+ *             meanwhile are answered. esp_transport_read() on a web socket transport returns
+ *             the payload of the current frame in the same way, over as many calls as needed.
+ *
+ * @param[in]  t           The web socket transport handle
+ * @param      buffer      Scratch buffer for the payload
+ * @param[in]  len         Size of the buffer
+ * @param[in]  callback    Called for each piece of the message
+ * @param[in]  user_ctx    Passed to the callback
+ * @param[in]  timeout_ms  The timeout milliseconds, for each read
+ *
+ * @return
+ *  - Length of the message
+ *  - 0 if no message started before the timeout
+ *  - (-1) on errors, if the server closed the connection or if the callback aborted the read
+ */
+int esp_transport_ws_read_message(esp_transport_handle_t t, char *buffer, int len,
+                                  esp_transport_ws_message_cb_t callback, void *user_ctx, int timeout_ms);
+
 
 
 #ifdef __cplusplus
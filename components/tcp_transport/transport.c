@@ -36,6 +36,7 @@ struct esp_transport_item_t {
     connect_func    _connect;       /*!< Connect function of this transport */
     io_read_func    _read;          /*!< Read */
     io_func         _write;         /*!< Write */
+    io_vec_func     _writev;        /*!< Scatter/gather write, NULL to write buffer by buffer */
     trans_func      _close;         /*!< Close */
     poll_func       _poll_read;     /*!< Poll and read */
     poll_func       _poll_write;    /*!< Poll and write */
@@ -97,6 +98,21 @@ esp_transport_handle_t esp_transport_list_get_transport(esp_transport_list_handl
     return NULL;
 }
 
+esp_err_t esp_transport_list_remove(esp_transport_list_handle_t list, esp_transport_handle_t t)
+{
+    if (list == NULL || t == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_transport_handle_t item;
+    STAILQ_FOREACH(item, list, next) {
+        if (item == t) {
+            STAILQ_REMOVE(list, t, esp_transport_item_t, next);
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
 esp_err_t esp_transport_list_destroy(esp_transport_list_handle_t list)
 {
     esp_transport_list_clean(list);
@@ -110,9 +126,6 @@ esp_err_t esp_transport_list_clean(esp_transport_list_handle_t list)
     esp_transport_handle_t tmp;
     while (item != NULL) {
         tmp = STAILQ_NEXT(item, next);
-        if (item->_destroy) {
-            item->_destroy(item);
-        }
         esp_transport_destroy(item);
         item = tmp;
     }
@@ -137,6 +150,9 @@ esp_transport_handle_t esp_transport_get_payload_transport_handle(esp_transport_
 
 esp_err_t esp_transport_destroy(esp_transport_handle_t t)
 {
+    if (t->_destroy) {
+        t->_destroy(t);
+    }
     if (t->scheme) {
         free(t->scheme);
     }
@@ -178,6 +194,31 @@ int esp_transport_write(esp_transport_handle_t t, const char *buffer, int len, i
     return -1;
 }
 
+int esp_transport_writev(esp_transport_handle_t t, const esp_transport_iovec_t *iov, int iovcnt, int timeout_ms)
+{
+    if (t && t->_writev) {
+        return t->_writev(t, iov, iovcnt, timeout_ms);
+    }
+    if (t == NULL || t->_write == NULL) {
+        return -1;
+    }
+    int total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].len <= 0) {
+            continue;
+        }
+        int wlen = t->_write(t, iov[i].buffer, iov[i].len, timeout_ms);
+        if (wlen <= 0) {
+            return total ? total : wlen;
+        }
+        total += wlen;
+        if (wlen < iov[i].len) {
+            break;
+        }
+    }
+    return total;
+}
+
 int esp_transport_poll_read(esp_transport_handle_t t, int timeout_ms)
 {
     if (t && t->_poll_read) {
@@ -239,6 +280,7 @@ esp_err_t esp_transport_set_func(esp_transport_handle_t t,
     t->_poll_write = _poll_write;
     t->_destroy = _destroy;
     t->_connect_async = NULL;
+    t->_writev = NULL;
     t->_parent_transfer = esp_transport_get_default_parent;
     return ESP_OK;
 }
@@ -269,6 +311,15 @@ esp_err_t esp_transport_set_async_connect_func(esp_transport_handle_t t, connect
     return ESP_OK;
 }
 
+esp_err_t esp_transport_set_writev_func(esp_transport_handle_t t, io_vec_func _writev)
+{
+    if (t == NULL) {
+        return ESP_FAIL;
+    }
+    t->_writev = _writev;
+    return ESP_OK;
+}
+
 esp_err_t esp_transport_set_parent_transport_func(esp_transport_handle_t t, payload_transfer_func _parent_transport)
 {
     if (t == NULL) {
@@ -0,0 +1,174 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "esp_transport_utils.h"
+#include "esp_transport.h"
+#include "esp_transport_buffered.h"
+
+static const char *TAG = "TRANS_BUF";
+
+typedef struct {
+    esp_transport_handle_t parent;
+    char *buffer;
+    int size;
+    int len;                        /*!< Bytes waiting in the buffer */
+    int sent;                       /*!< Bytes of the buffer already written to the parent */
+} transport_buffered_t;
+
+static int buffered_connect(esp_transport_handle_t t, const char *host, int port, int timeout_ms)
+{
+    transport_buffered_t *buf = esp_transport_get_context_data(t);
+    buf->len = buf->sent = 0;
+    return esp_transport_connect(buf->parent, host, port, timeout_ms);
+}
+
+static int buffered_connect_async(esp_transport_handle_t t, const char *host, int port, int timeout_ms)
+{
+    transport_buffered_t *buf = esp_transport_get_context_data(t);
+    buf->len = buf->sent = 0;
+    return esp_transport_connect_async(buf->parent, host, port, timeout_ms);
+}
+
+int esp_transport_buffered_flush(esp_transport_handle_t t, int timeout_ms)
+{
+    transport_buffered_t *buf = esp_transport_get_context_data(t);
+    if (buf == NULL) {
+        return -1;
+    }
+    while (buf->sent < buf->len) {
+        int wlen = esp_transport_write(buf->parent, buf->buffer + buf->sent, buf->len - buf->sent, timeout_ms);
+        if (wlen <= 0) {
+            ESP_LOGD(TAG, "Error flushing %d bytes", buf->len - buf->sent);
+            return -1;
+        }
+        buf->sent += wlen;
+    }
+    buf->len = buf->sent = 0;
+    return 0;
+}
+
+/* Buffers what fits; flushes first when the data would not fit. Returns the bytes consumed */
+static int buffered_append(esp_transport_handle_t t, const char *data, int len, int timeout_ms)
+{
+    transport_buffered_t *buf = esp_transport_get_context_data(t);
+    if (buf->len + len > buf->size && esp_transport_buffered_flush(t, timeout_ms) < 0) {
+        return -1;
+    }
+    if (len >= buf->size) {
+        return esp_transport_write(buf->parent, data, len, timeout_ms);
+    }
+    memcpy(buf->buffer + buf->len, data, len);
+    buf->len += len;
+    return len;
+}
+
+static int buffered_write(esp_transport_handle_t t, const char *buffer, int len, int timeout_ms)
+{
+    return buffered_append(t, buffer, len, timeout_ms);
+}
+
+static int buffered_writev(esp_transport_handle_t t, const esp_transport_iovec_t *iov, int iovcnt, int timeout_ms)
+{
+    int total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        int wlen = buffered_append(t, iov[i].buffer, iov[i].len, timeout_ms);
+        if (wlen < 0) {
+            return total ? total : wlen;
+        }
+        total += wlen;
+        if (wlen < iov[i].len) {
+            break;
+        }
+    }
+    return total;
+}
+
+static int buffered_read(esp_transport_handle_t t, char *buffer, int len, int timeout_ms)
+{
+    transport_buffered_t *buf = esp_transport_get_context_data(t);
+    /* The peer can't answer a request that is still in the buffer */
+    if (esp_transport_buffered_flush(t, timeout_ms) < 0) {
+        return -1;
+    }
+    return esp_transport_read(buf->parent, buffer, len, timeout_ms);
+}
+
+static int buffered_poll_read(esp_transport_handle_t t, int timeout_ms)
+{
+    transport_buffered_t *buf = esp_transport_get_context_data(t);
+    if (esp_transport_buffered_flush(t, timeout_ms) < 0) {
+        return -1;
+    }
+    return esp_transport_poll_read(buf->parent, timeout_ms);
+}
+
+static int buffered_poll_write(esp_transport_handle_t t, int timeout_ms)
+{
+    transport_buffered_t *buf = esp_transport_get_context_data(t);
+    if (buf->len < buf->size) {
+        return 1;
+    }
+    return esp_transport_poll_write(buf->parent, timeout_ms);
+}
+
+static int buffered_close(esp_transport_handle_t t)
+{
+    transport_buffered_t *buf = esp_transport_get_context_data(t);
+    if (buf->len > buf->sent) {
+        ESP_LOGD(TAG, "Dropping %d unflushed bytes", buf->len - buf->sent);
+    }
+    buf->len = buf->sent = 0;
+    return esp_transport_close(buf->parent);
+}
+
+static int buffered_destroy(esp_transport_handle_t t)
+{
+    transport_buffered_t *buf = esp_transport_get_context_data(t);
+    free(buf->buffer);
+    free(buf);
+    return 0;
+}
+
+esp_transport_handle_t esp_transport_buffered_init(esp_transport_handle_t parent_handle, int buffer_size)
+{
+    if (parent_handle == NULL || buffer_size <= 0) {
+        return NULL;
+    }
+    esp_transport_handle_t t = esp_transport_init();
+    ESP_TRANSPORT_MEM_CHECK(TAG, t, return NULL);
+    transport_buffered_t *buf = calloc(1, sizeof(transport_buffered_t));
+    ESP_TRANSPORT_MEM_CHECK(TAG, buf, {
+        esp_transport_destroy(t);
+        return NULL;
+    });
+    buf->buffer = malloc(buffer_size);
+    ESP_TRANSPORT_MEM_CHECK(TAG, buf->buffer, {
+        free(buf);
+        esp_transport_destroy(t);
+        return NULL;
+    });
+    buf->parent = parent_handle;
+    buf->size = buffer_size;
+
+    esp_transport_set_func(t, buffered_connect, buffered_read, buffered_write, buffered_close, buffered_poll_read, buffered_poll_write, buffered_destroy);
+    esp_transport_set_async_connect_func(t, buffered_connect_async);
+    esp_transport_set_writev_func(t, buffered_writev);
+    esp_transport_set_context_data(t, buf);
+    return t;
+}
@@ -28,6 +28,8 @@
 
 static const char *TAG = "TRANS_TCP";
 
+#define TCP_WRITEV_MAX_IOV (8)
+
 typedef struct {
     int sock;
 } transport_tcp_t;
@@ -98,6 +100,25 @@ static int tcp_write(esp_transport_handle_t t, const char *buffer, int len, int
     return write(tcp->sock, buffer, len);
 }
 
+static int tcp_writev(esp_transport_handle_t t, const esp_transport_iovec_t *iov, int iovcnt, int timeout_ms)
+{
+    int poll;
+    struct iovec vec[TCP_WRITEV_MAX_IOV];
+    transport_tcp_t *tcp = esp_transport_get_context_data(t);
+    if ((poll = esp_transport_poll_write(t, timeout_ms)) <= 0) {
+        return poll;
+    }
+    /* A partial write is reported to the caller, which writes the rest */
+    if (iovcnt > TCP_WRITEV_MAX_IOV) {
+        iovcnt = TCP_WRITEV_MAX_IOV;
+    }
+    for (int i = 0; i < iovcnt; i++) {
+        vec[i].iov_base = (void *)iov[i].buffer;
+        vec[i].iov_len = iov[i].len;
+    }
+    return writev(tcp->sock, vec, iovcnt);
+}
+
 static int tcp_read(esp_transport_handle_t t, char *buffer, int len, int timeout_ms)
 {
     transport_tcp_t *tcp = esp_transport_get_context_data(t);
@@ -160,6 +181,7 @@ esp_transport_handle_t esp_transport_tcp_init()
     ESP_TRANSPORT_MEM_CHECK(TAG, tcp, return NULL);
     tcp->sock = -1;
     esp_transport_set_func(t, tcp_connect, tcp_read, tcp_write, tcp_close, tcp_poll_read, tcp_poll_write, tcp_destroy);
+    esp_transport_set_writev_func(t, tcp_writev);
     esp_transport_set_context_data(t, tcp);
 
     return t;
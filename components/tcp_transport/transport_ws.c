@@ -16,22 +16,34 @@ static const char *TAG = "TRANSPORT_WS";
 
 #define DEFAULT_WS_BUFFER (1024)
 #define WS_FIN            0x80
-#define WS_OPCODE_TEXT    0x01
-#define WS_OPCODE_BINARY  0x02
-#define WS_OPCODE_CLOSE   0x08
-#define WS_OPCODE_PING    0x09
-#define WS_OPCODE_PONG    0x0a
+#define WS_OPCODE_MASK    0x0F
+#define WS_CONTROL_FRAME  0x08
 // Second byte
 #define WS_MASK           0x80
 #define WS_SIZE16         126
 #define WS_SIZE64         127
-#define MAX_WEBSOCKET_HEADER_SIZE 10
+#define MAX_WEBSOCKET_HEADER_SIZE 14
+#define MAX_CONTROL_PAYLOAD_SIZE  125
 #define WS_RESPONSE_OK    101
+#define WS_FRAME_CONTROL  2
+
+typedef uint32_t __attribute__((__may_alias__)) ws_word_t;
+
+/* State of the frame being read, so that a frame can be read over several calls */
+typedef struct {
+    uint8_t opcode;                 /*!< Opcode of the frame */
+    bool fin;                       /*!< Last frame of the message */
+    bool masked;
+    uint8_t mask_key[4];
+    int mask_offset;                /*!< Position in mask_key of the next payload byte */
+    int bytes_remaining;            /*!< Payload bytes not read yet */
+} ws_frame_t;
 
 typedef struct {
     char *path;
     char *buffer;
     esp_transport_handle_t parent;
+    ws_frame_t frame;
 } transport_ws_t;
 
 static esp_transport_handle_t ws_get_payload_transport_handle(esp_transport_handle_t t)
@@ -79,6 +91,7 @@ static char *get_http_header(const char *buffer, const char *key)
 static int ws_connect(esp_transport_handle_t t, const char *host, int port, int timeout_ms)
 {
     transport_ws_t *ws = esp_transport_get_context_data(t);
+    memset(&ws->frame, 0, sizeof(ws->frame));
     if (esp_transport_connect(ws->parent, host, port, timeout_ms) < 0) {
         ESP_LOGE(TAG, "Error connect to the server");
         return -1;
@@ -145,114 +158,274 @@ static int ws_connect(esp_transport_handle_t t, const char *host, int port, int
     return 0;
 }
 
-static int ws_write(esp_transport_handle_t t, const char *buff, int len, int timeout_ms)
+/* XORs the mask onto data in place, a 32-bit word at a time once data is aligned */
+static void ws_mask_payload(char *data, int len, const uint8_t *mask_key, int *mask_offset)
+{
+    int off = *mask_offset;
+    int i = 0;
+    while (i < len && ((uintptr_t)(data + i) & 3)) {
+        data[i++] ^= mask_key[off++ & 3];
+    }
+    if (len - i >= 4) {
+        uint8_t rotated[4];
+        ws_word_t mask;
+        for (int k = 0; k < 4; k++) {
+            rotated[k] = mask_key[(off + k) & 3];
+        }
+        memcpy(&mask, rotated, sizeof(mask));
+        for (; i + 4 <= len; i += 4) {
+            *(ws_word_t *)(data + i) ^= mask;
+        }
+    }
+    while (i < len) {
+        data[i++] ^= mask_key[off++ & 3];
+    }
+    *mask_offset = off & 3;
+}
+
+static int ws_write_frame(esp_transport_handle_t t, uint8_t opcode, const char *buff, int len, int timeout_ms)
 {
     transport_ws_t *ws = esp_transport_get_context_data(t);
     char ws_header[MAX_WEBSOCKET_HEADER_SIZE];
-    char *mask;
-    int header_len = 0, i;
+    uint8_t mask_key[4];
+    int header_len = 0, mask_offset = 0;
     char *buffer = (char *)buff;
     int poll_write;
     if ((poll_write = esp_transport_poll_write(ws->parent, timeout_ms)) <= 0) {
         return poll_write;
     }
 
-    ws_header[header_len++] = WS_OPCODE_BINARY | WS_FIN;
-
-    // NOTE: no support for > 16-bit sized messages
-    if (len > 125) {
+    ws_header[header_len++] = opcode | WS_FIN;
+    if (len > 0xFFFF) {
+        ws_header[header_len++] = WS_SIZE64 | WS_MASK;
+        memset(ws_header + header_len, 0, 4);
+        header_len += 4;
+        ws_header[header_len++] = (uint8_t)(len >> 24);
+        ws_header[header_len++] = (uint8_t)(len >> 16);
+        ws_header[header_len++] = (uint8_t)(len >> 8);
+        ws_header[header_len++] = (uint8_t)(len & 0xFF);
+    } else if (len > 125) {
         ws_header[header_len++] = WS_SIZE16 | WS_MASK;
         ws_header[header_len++] = (uint8_t)(len >> 8);
         ws_header[header_len++] = (uint8_t)(len & 0xFF);
     } else {
         ws_header[header_len++] = (uint8_t)(len | WS_MASK);
     }
-    mask = &ws_header[header_len];
-    getrandom(ws_header + header_len, 4, 0);
-    header_len += 4;
-
-    for (i = 0; i < len; ++i) {
-        buffer[i] = (buffer[i] ^ mask[i % 4]);
+    getrandom(mask_key, sizeof(mask_key), 0);
+    memcpy(ws_header + header_len, mask_key, sizeof(mask_key));
+    header_len += sizeof(mask_key);
+
+    // The payload is masked in place, to avoid a copy
+    ws_mask_payload(buffer, len, mask_key, &mask_offset);
+
+    // Send the header and the payload together, so they can share a segment
+    esp_transport_iovec_t iov[2] = {
+        { .buffer = ws_header, .len = header_len },
+        { .buffer = buffer, .len = len },
+    };
+    int wlen;
+    while ((wlen = esp_transport_writev(ws->parent, iov, 2, timeout_ms)) < iov[0].len) {
+        if (wlen <= 0) {
+            ESP_LOGE(TAG, "Error write header");
+            return -1;
+        }
+        iov[0].buffer += wlen;
+        iov[0].len -= wlen;
     }
-    if (esp_transport_write(ws->parent, ws_header, header_len, timeout_ms) != header_len) {
-        ESP_LOGE(TAG, "Error write header");
-        return -1;
+    return wlen - iov[0].len;
+}
+
+static int ws_write(esp_transport_handle_t t, const char *buff, int len, int timeout_ms)
+{
+    return ws_write_frame(t, WS_TRANSPORT_OPCODES_BINARY, buff, len, timeout_ms);
+}
+
+static int ws_read_exact(transport_ws_t *ws, char *buffer, int len, int timeout_ms)
+{
+    int done = 0;
+    while (done < len) {
+        int rlen = esp_transport_read(ws->parent, buffer + done, len - done, timeout_ms);
+        if (rlen <= 0) {
+            ESP_LOGE(TAG, "Error read data");
+            return rlen;
+        }
+        done += rlen;
     }
-    return esp_transport_write(ws->parent, buffer, len, timeout_ms);
+    return done;
 }
 
-static int ws_read(esp_transport_handle_t t, char *buffer, int len, int timeout_ms)
+static int ws_read_header(transport_ws_t *ws, int timeout_ms)
 {
-    transport_ws_t *ws = esp_transport_get_context_data(t);
-    int payload_len;
-    int payload_len_buff = len;
-    char *data_ptr = buffer, opcode, mask, *mask_key = NULL;
+    uint8_t header[8];
+    uint64_t payload_len;
     int rlen;
-    int poll_read;
-    if ((poll_read = esp_transport_poll_read(ws->parent, timeout_ms)) <= 0) {
-        return poll_read;
-    }
 
-    // Receive and process header first (based on header size)
-    int header = 2;
-    if ((rlen = esp_transport_read(ws->parent, buffer, header, timeout_ms)) <= 0) {
-        ESP_LOGE(TAG, "Error read data");
+    if ((rlen = ws_read_exact(ws, (char *)header, 2, timeout_ms)) <= 0) {
         return rlen;
     }
-    opcode = (*data_ptr & 0x0F);
-    data_ptr ++;
-    mask = ((*data_ptr >> 7) & 0x01);
-    payload_len = (*data_ptr & 0x7F);
-    data_ptr++;
-    ESP_LOGD(TAG, "Opcode: %d, mask: %d, len: %d\r\n", opcode, mask, payload_len);
-    if (payload_len == 126) {
-        // headerLen += 2;
-        if ((rlen = esp_transport_read(ws->parent, data_ptr, header, timeout_ms)) <= 0) {
-            ESP_LOGE(TAG, "Error read data");
+    ws->frame.opcode = header[0] & WS_OPCODE_MASK;
+    ws->frame.fin = (header[0] & WS_FIN) != 0;
+    ws->frame.masked = (header[1] & WS_MASK) != 0;
+    payload_len = header[1] & 0x7F;
+    if (payload_len == WS_SIZE16) {
+        if ((rlen = ws_read_exact(ws, (char *)header, 2, timeout_ms)) <= 0) {
             return rlen;
         }
-        payload_len = data_ptr[0] << 8 | data_ptr[1];
-        payload_len_buff = len - 4;
-        data_ptr += 2;
-    } else if (payload_len == 127) {
-        // headerLen += 8;
-        header = 8;
-        if ((rlen = esp_transport_read(ws->parent, data_ptr, header, timeout_ms)) <= 0) {
-            ESP_LOGE(TAG, "Error read data");
+        payload_len = header[0] << 8 | header[1];
+    } else if (payload_len == WS_SIZE64) {
+        if ((rlen = ws_read_exact(ws, (char *)header, 8, timeout_ms)) <= 0) {
             return rlen;
         }
-
-        if (data_ptr[0] != 0 || data_ptr[1] != 0 || data_ptr[2] != 0 || data_ptr[3] != 0) {
-            // really too big!
-            payload_len = 0xFFFFFFFF;
-        } else {
-            payload_len = data_ptr[4] << 24 | data_ptr[5] << 16 | data_ptr[6] << 8 | data_ptr[7];
+        payload_len = 0;
+        for (int i = 0; i < 8; i++) {
+            payload_len = payload_len << 8 | header[i];
+        }
+        if (payload_len > INT32_MAX) {
+            ESP_LOGE(TAG, "Frame too large");
+            return -1;
         }
-        data_ptr += 8;
-        payload_len_buff = len - 10;
     }
-
-    if (payload_len > payload_len_buff) {
-        ESP_LOGD(TAG, "Actual data to receive (%d) are longer than ws buffer (%d)", payload_len, payload_len_buff);
-        payload_len = payload_len_buff;
+    if (ws->frame.masked && (rlen = ws_read_exact(ws, (char *)ws->frame.mask_key, 4, timeout_ms)) <= 0) {
+        return rlen;
     }
+    ws->frame.mask_offset = 0;
+    ws->frame.bytes_remaining = (int)payload_len;
+    ESP_LOGD(TAG, "Opcode: %d, fin: %d, mask: %d, len: %d", ws->frame.opcode, ws->frame.fin, ws->frame.masked, ws->frame.bytes_remaining);
+    return 1;
+}
 
-    // Then receive and process payload
-    if ((rlen = esp_transport_read(ws->parent, data_ptr, payload_len, timeout_ms)) <= 0) {
+/* Reads the payload of the current frame into buffer and unmasks it in place */
+static int ws_read_payload(transport_ws_t *ws, char *buffer, int len, int timeout_ms)
+{
+    if (len > ws->frame.bytes_remaining) {
+        len = ws->frame.bytes_remaining;
+    }
+    if (len == 0) {
+        return 0;
+    }
+    int rlen = esp_transport_read(ws->parent, buffer, len, timeout_ms);
+    if (rlen <= 0) {
         ESP_LOGE(TAG, "Error read data");
         return rlen;
     }
+    ws->frame.bytes_remaining -= rlen;
+    if (ws->frame.masked) {
+        ws_mask_payload(buffer, rlen, ws->frame.mask_key, &ws->frame.mask_offset);
+    }
+    return rlen;
+}
+
+/* Answers a ping or a close, returns 0 if the connection is still usable */
+static int ws_handle_control_frame(esp_transport_handle_t t, int timeout_ms)
+{
+    transport_ws_t *ws = esp_transport_get_context_data(t);
+    char payload[MAX_CONTROL_PAYLOAD_SIZE];
+    int len = ws->frame.bytes_remaining;
+
+    if (len > MAX_CONTROL_PAYLOAD_SIZE || !ws->frame.fin) {
+        ESP_LOGE(TAG, "Invalid control frame");
+        return -1;
+    }
+    if (ws_read_exact(ws, payload, len, timeout_ms) < 0) {
+        return -1;
+    }
+    ws->frame.bytes_remaining = 0;
+    if (ws->frame.masked) {
+        ws_mask_payload(payload, len, ws->frame.mask_key, &ws->frame.mask_offset);
+    }
+    switch (ws->frame.opcode) {
+        case WS_TRANSPORT_OPCODES_PING:
+            ESP_LOGD(TAG, "Got ping, sending pong");
+            return ws_write_frame(t, WS_TRANSPORT_OPCODES_PONG, payload, len, timeout_ms) < 0 ? -1 : 0;
+        case WS_TRANSPORT_OPCODES_CLOSE:
+            ESP_LOGD(TAG, "Got close frame");
+            ws_write_frame(t, WS_TRANSPORT_OPCODES_CLOSE, payload, len < 2 ? len : 2, timeout_ms);
+            return -1;
+        default:
+            return 0;
+    }
+}
+
+/* Makes sure a data frame is being read. Returns 1 if there is one, 0 on timeout
+   and WS_FRAME_CONTROL after answering a control frame */
+static int ws_next_data_frame(esp_transport_handle_t t, int timeout_ms)
+{
+    transport_ws_t *ws = esp_transport_get_context_data(t);
+    int ret;
+    if (ws->frame.bytes_remaining > 0) {
+        return 1;
+    }
+    if ((ret = esp_transport_poll_read(ws->parent, timeout_ms)) <= 0) {
+        return ret;
+    }
+    if ((ret = ws_read_header(ws, timeout_ms)) <= 0) {
+        return ret;
+    }
+    if (ws->frame.opcode & WS_CONTROL_FRAME) {
+        return ws_handle_control_frame(t, timeout_ms) < 0 ? -1 : WS_FRAME_CONTROL;
+    }
+    return 1;
+}
 
-    if (mask) {
-        mask_key = data_ptr;
-        data_ptr += 4;
-        for (int i = 0; i < payload_len; i++) {
-            buffer[i] = (data_ptr[i] ^ mask_key[i % 4]);
+static int ws_read(esp_transport_handle_t t, char *buffer, int len, int timeout_ms)
+{
+    transport_ws_t *ws = esp_transport_get_context_data(t);
+    int ret;
+    if ((ret = ws_next_data_frame(t, timeout_ms)) != 1) {
+        return ret == WS_FRAME_CONTROL ? 0 : ret;
+    }
+    return ws_read_payload(ws, buffer, len, timeout_ms);
+}
+
+int esp_transport_ws_read_message(esp_transport_handle_t t, char *buffer, int len,
+                                  esp_transport_ws_message_cb_t callback, void *user_ctx, int timeout_ms)
+{
+    transport_ws_t *ws = esp_transport_get_context_data(t);
+    uint8_t opcode = 0;
+    int total = 0;
+    bool first = true;
+    int ret;
+
+    if (ws == NULL || callback == NULL || buffer == NULL || len <= 0) {
+        return -1;
+    }
+    while (1) {
+        ret = ws_next_data_frame(t, timeout_ms);
+        if (ret == WS_FRAME_CONTROL) {
+            continue;
         }
-    } else {
-        memmove(buffer, data_ptr, payload_len);
+        if (ret <= 0) {
+            // A timeout before the message started is not an error
+            return first ? ret : -1;
+        }
+        if (first) {
+            if (ws->frame.opcode == WS_TRANSPORT_OPCODES_CONT) {
+                ESP_LOGE(TAG, "Continuation frame without a message");
+                return -1;
+            }
+            opcode = ws->frame.opcode;
+            first = false;
+        } else if (ws->frame.opcode != WS_TRANSPORT_OPCODES_CONT) {
+            ESP_LOGE(TAG, "Expected a continuation frame");
+            return -1;
+        }
+        do {
+            int rlen = ws_read_payload(ws, buffer, len, timeout_ms);
+            if (rlen < 0 || (rlen == 0 && ws->frame.bytes_remaining > 0)) {
+                return -1;
+            }
+            bool fin = ws->frame.fin && ws->frame.bytes_remaining == 0;
+            if (rlen > 0 || fin) {
+                total += rlen;
+                if (callback(t, opcode, buffer, rlen, fin, user_ctx) != 0) {
+                    return -1;
+                }
+            }
+            if (fin) {
+                return total;
+            }
+        } while (ws->frame.bytes_remaining > 0);
     }
-    return payload_len;
 }
 
 static int ws_poll_read(esp_transport_handle_t t, int timeout_ms)
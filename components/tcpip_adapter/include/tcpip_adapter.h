@@ -82,6 +82,24 @@ typedef struct {
 
 #endif
 
+/** @brief Traffic counters of an interface
+ *
+ * @note See tcpip_adapter_get_if_stats()
+ */
+typedef struct {
+    uint32_t rx_packets;            /**< Packets received */
+    uint64_t rx_bytes;              /**< Bytes received */
+    uint32_t tx_packets;            /**< Packets sent */
+    uint64_t tx_bytes;              /**< Bytes sent */
+    uint32_t rx_drop_queue_full;    /**< Received packets dropped because the mailbox of the TCP/IP task was full */
+    uint32_t tx_drop_driver;        /**< Packets the network driver failed to send */
+    uint32_t rx_queued;             /**< Received packets currently waiting to be processed */
+    uint32_t rx_queued_max;         /**< Highest number of received packets waiting at the same time */
+    uint32_t rx_latency_samples;    /**< Number of received packets timed */
+    uint32_t rx_latency_avg_us;     /**< Average time from receiving a packet to handing it to its socket, in microseconds */
+    uint32_t rx_latency_max_us;     /**< Longest time from receiving a packet to handing it to its socket, in microseconds */
+} tcpip_adapter_if_stats_t;
+
 #define ESP_ERR_TCPIP_ADAPTER_BASE                  0x5000
 #define ESP_ERR_TCPIP_ADAPTER_INVALID_PARAMS        ESP_ERR_TCPIP_ADAPTER_BASE + 0x01
 #define ESP_ERR_TCPIP_ADAPTER_IF_NOT_READY          ESP_ERR_TCPIP_ADAPTER_BASE + 0x02
@@ -650,6 +668,35 @@ esp_err_t tcpip_adapter_get_hostname(tcpip_adapter_if_t tcpip_if, const char **h
  */
 esp_err_t tcpip_adapter_get_netif(tcpip_adapter_if_t tcpip_if, void ** netif);
 
+/**
+ * @brief  Get the traffic counters of an interface
+ *
+ * The counters are kept with CONFIG_TCPIP_ADAPTER_IF_STATS since the interface was started
+ * the first time, or since they were reset. Received packets are timed one at a time
+ * from the network driver to the end of their processing by the TCP/IP stack.
+ *
+ * @param[in]  tcpip_if Interface to get the counters of
+ * @param[out] stats Counters of the interface
+ *
+ * @return
+ *         - ESP_OK - success
+ *         - ESP_ERR_TCPIP_ADAPTER_INVALID_PARAMS - parameter error
+ *         - ESP_ERR_NOT_SUPPORTED - CONFIG_TCPIP_ADAPTER_IF_STATS is disabled
+ */
+esp_err_t tcpip_adapter_get_if_stats(tcpip_adapter_if_t tcpip_if, tcpip_adapter_if_stats_t *stats);
+
+/**
+ * @brief  Reset the traffic counters of an interface
+ *
+ * @param[in]  tcpip_if Interface to reset the counters of
+ *
+ * @return
+ *         - ESP_OK - success
+ *         - ESP_ERR_TCPIP_ADAPTER_INVALID_PARAMS - parameter error
+ *         - ESP_ERR_NOT_SUPPORTED - CONFIG_TCPIP_ADAPTER_IF_STATS is disabled
+ */
+esp_err_t tcpip_adapter_reset_if_stats(tcpip_adapter_if_t tcpip_if);
+
 /**
  * @brief  Test if supplied interface is up or down
  *
@@ -30,14 +30,18 @@
 #if LWIP_DNS /* don't build if not configured for use in lwipopts.h */
 #include "lwip/dns.h"
 #endif
+#include "netif/ethernet.h"
 #include "netif/wlanif.h"
 #include "netif/ethernetif.h"
+#include "netif/netif_rx_batch.h"
+#include "netif/netif_rx_thread.h"
 
 #include "dhcpserver/dhcpserver.h"
 #include "dhcpserver/dhcpserver_options.h"
 
 #include "esp_event.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 static struct netif *esp_netif[TCPIP_ADAPTER_IF_MAX];
 static tcpip_adapter_ip_info_t esp_ip[TCPIP_ADAPTER_IF_MAX];
@@ -45,6 +49,25 @@ static tcpip_adapter_ip_info_t esp_ip_old[TCPIP_ADAPTER_IF_MAX];
 static tcpip_adapter_ip6_info_t esp_ip6[TCPIP_ADAPTER_IF_MAX];
 static netif_init_fn esp_netif_init_fn[TCPIP_ADAPTER_IF_MAX];
 static tcpip_adapter_ip_lost_timer_t esp_ip_lost_timer[TCPIP_ADAPTER_IF_MAX];
+#if CONFIG_LWIP_NETIF_RX_BATCH
+#define TCPIP_ADAPTER_INPKT     netif_rx_batch_inpkt
+#else
+#define TCPIP_ADAPTER_INPKT     tcpip_inpkt
+#endif
+
+#if CONFIG_TCPIP_ADAPTER_IF_STATS
+typedef struct {
+    tcpip_adapter_if_stats_t stats;
+    uint64_t rx_latency_sum_us;
+    struct pbuf *rx_probe;          /* Received packet being timed, NULL if none */
+    int64_t rx_probe_time;
+    netif_linkoutput_fn linkoutput; /* Output function of the driver */
+    bool rx_thread;
+} tcpip_adapter_if_counters_t;
+
+static tcpip_adapter_if_counters_t esp_if_counters[TCPIP_ADAPTER_IF_MAX];
+static portMUX_TYPE esp_if_counters_mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
 
 static tcpip_adapter_dhcp_status_t dhcps_status = TCPIP_ADAPTER_DHCP_INIT;
 static tcpip_adapter_dhcp_status_t dhcpc_status[TCPIP_ADAPTER_IF_MAX] = {TCPIP_ADAPTER_DHCP_INIT};
@@ -70,6 +93,130 @@ static sys_sem_t api_lock_sem = NULL;
 extern sys_thread_t g_lwip_task;
 static const char* TAG = "tcpip_adapter";
 
+#if CONFIG_TCPIP_ADAPTER_IF_STATS
+static tcpip_adapter_if_counters_t *tcpip_adapter_if_counters(struct netif *netif)
+{
+    for (int i = 0; i < TCPIP_ADAPTER_IF_MAX; i++) {
+        if (esp_netif[i] == netif) {
+            return &esp_if_counters[i];
+        }
+    }
+    return NULL;
+}
+
+/* Runs in the TCP/IP task (or the receive task of the interface) for every received packet */
+static err_t tcpip_adapter_input_done(struct pbuf *p, struct netif *inp)
+{
+    tcpip_adapter_if_counters_t *c = tcpip_adapter_if_counters(inp);
+    bool probe = false;
+    int64_t start = 0;
+    err_t err;
+
+    if (c) {
+        portENTER_CRITICAL(&esp_if_counters_mux);
+        c->stats.rx_queued--;
+        if (c->rx_probe == p) {
+            probe = true;
+            start = c->rx_probe_time;
+        }
+        portEXIT_CRITICAL(&esp_if_counters_mux);
+    }
+
+    /* Processing the packet hands its data to the socket that receives it */
+    err = ethernet_input(p, inp);
+
+    if (probe) {
+        uint32_t latency = esp_timer_get_time() - start;
+        portENTER_CRITICAL(&esp_if_counters_mux);
+        c->rx_probe = NULL;
+        c->stats.rx_latency_samples++;
+        c->rx_latency_sum_us += latency;
+        if (latency > c->stats.rx_latency_max_us) {
+            c->stats.rx_latency_max_us = latency;
+        }
+        portEXIT_CRITICAL(&esp_if_counters_mux);
+    }
+    return err;
+}
+
+static err_t tcpip_adapter_input(struct pbuf *p, struct netif *inp)
+{
+    tcpip_adapter_if_counters_t *c = tcpip_adapter_if_counters(inp);
+    bool probe = false;
+    err_t err;
+
+    if (c == NULL) {
+        return tcpip_input(p, inp);
+    }
+
+    portENTER_CRITICAL(&esp_if_counters_mux);
+    c->stats.rx_packets++;
+    c->stats.rx_bytes += p->tot_len;
+    if (++c->stats.rx_queued > c->stats.rx_queued_max) {
+        c->stats.rx_queued_max = c->stats.rx_queued;
+    }
+    /* Time one packet at a time, that's enough for the average and cheap */
+    if (c->rx_probe == NULL) {
+        c->rx_probe = p;
+        c->rx_probe_time = esp_timer_get_time();
+        probe = true;
+    }
+    portEXIT_CRITICAL(&esp_if_counters_mux);
+
+#if CONFIG_LWIP_NETIF_RX_THREADS
+    if (c->rx_thread) {
+        err = netif_rx_thread_input(p, inp);
+    } else
+#endif
+    {
+        err = TCPIP_ADAPTER_INPKT(p, inp, tcpip_adapter_input_done);
+    }
+
+    if (err != ERR_OK) {
+        portENTER_CRITICAL(&esp_if_counters_mux);
+        c->stats.rx_queued--;
+        c->stats.rx_drop_queue_full++;
+        if (probe) {
+            c->rx_probe = NULL;
+        }
+        portEXIT_CRITICAL(&esp_if_counters_mux);
+    }
+    return err;
+}
+
+static err_t tcpip_adapter_linkoutput(struct netif *netif, struct pbuf *p)
+{
+    tcpip_adapter_if_counters_t *c = tcpip_adapter_if_counters(netif);
+    err_t err = c->linkoutput(netif, p);
+
+    portENTER_CRITICAL(&esp_if_counters_mux);
+    if (err == ERR_OK) {
+        c->stats.tx_packets++;
+        c->stats.tx_bytes += p->tot_len;
+    } else {
+        c->stats.tx_drop_driver++;
+    }
+    portEXIT_CRITICAL(&esp_if_counters_mux);
+    return err;
+}
+
+/* Counts the traffic of a netif that has just been added */
+static void tcpip_adapter_if_counters_attach(tcpip_adapter_if_t tcpip_if)
+{
+    tcpip_adapter_if_counters_t *c = &esp_if_counters[tcpip_if];
+    struct netif *netif = esp_netif[tcpip_if];
+
+    c->rx_thread = (netif->input != tcpip_input);
+    netif->input = tcpip_adapter_input;
+    c->linkoutput = netif->linkoutput;
+    netif->linkoutput = tcpip_adapter_linkoutput;
+}
+
+#define TCPIP_ADAPTER_INPUT_DONE    tcpip_adapter_input_done
+#else
+#define TCPIP_ADAPTER_INPUT_DONE    NULL
+#endif
+
 static void tcpip_adapter_api_cb(void* api_msg)
 {
     tcpip_adapter_api_msg_t *msg = (tcpip_adapter_api_msg_t*)api_msg;
@@ -187,6 +334,21 @@ static esp_err_t tcpip_adapter_start(tcpip_adapter_if_t tcpip_if, uint8_t *mac,
         netif_init = tcpip_if_to_netif_init_fn(tcpip_if);
         assert(netif_init != NULL);
         netif_add(esp_netif[tcpip_if], &ip_info->ip, &ip_info->netmask, &ip_info->gw, NULL, netif_init, tcpip_input);
+#if CONFIG_LWIP_NETIF_RX_THREADS
+        if (netif_rx_thread_start(esp_netif[tcpip_if], TCPIP_ADAPTER_INPUT_DONE) == ERR_OK) {
+            esp_netif[tcpip_if]->input = netif_rx_thread_input;
+        } else {
+            ESP_LOGE(TAG, "no receive task for interface %d, using the TCP/IP task", tcpip_if);
+        }
+#endif
+#if CONFIG_TCPIP_ADAPTER_IF_STATS
+        tcpip_adapter_if_counters_attach(tcpip_if);
+#endif
+#if CONFIG_LWIP_NETIF_RX_BATCH
+        if (esp_netif[tcpip_if]->input == tcpip_input) {
+            esp_netif[tcpip_if]->input = netif_rx_batch_input;
+        }
+#endif
 #if ESP_GRATUITOUS_ARP
         if (tcpip_if == TCPIP_ADAPTER_IF_STA || tcpip_if == TCPIP_ADAPTER_IF_ETH) {
             netif_set_garp_flag(esp_netif[tcpip_if]);
@@ -1093,7 +1255,7 @@ static esp_err_t tcpip_adapter_dhcpc_stop_api(tcpip_adapter_api_msg_t * msg)
 
 esp_err_t tcpip_adapter_eth_input(void *buffer, uint16_t len, void *eb)
 {
-    ethernetif_input(esp_netif[TCPIP_ADAPTER_IF_ETH], buffer, len);
+    ethernetif_input(esp_netif[TCPIP_ADAPTER_IF_ETH], buffer, len, eb);
     return ESP_OK;
 }
 
@@ -1228,6 +1390,47 @@ esp_err_t tcpip_adapter_get_netif(tcpip_adapter_if_t tcpip_if, void ** netif)
     return ESP_OK;
 }
 
+esp_err_t tcpip_adapter_get_if_stats(tcpip_adapter_if_t tcpip_if, tcpip_adapter_if_stats_t *stats)
+{
+#if CONFIG_TCPIP_ADAPTER_IF_STATS
+    if (tcpip_if >= TCPIP_ADAPTER_IF_MAX || stats == NULL) {
+        return ESP_ERR_TCPIP_ADAPTER_INVALID_PARAMS;
+    }
+
+    tcpip_adapter_if_counters_t *c = &esp_if_counters[tcpip_if];
+    portENTER_CRITICAL(&esp_if_counters_mux);
+    *stats = c->stats;
+    if (c->stats.rx_latency_samples) {
+        stats->rx_latency_avg_us = c->rx_latency_sum_us / c->stats.rx_latency_samples;
+    }
+    portEXIT_CRITICAL(&esp_if_counters_mux);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t tcpip_adapter_reset_if_stats(tcpip_adapter_if_t tcpip_if)
+{
+#if CONFIG_TCPIP_ADAPTER_IF_STATS
+    if (tcpip_if >= TCPIP_ADAPTER_IF_MAX) {
+        return ESP_ERR_TCPIP_ADAPTER_INVALID_PARAMS;
+    }
+
+    tcpip_adapter_if_counters_t *c = &esp_if_counters[tcpip_if];
+    portENTER_CRITICAL(&esp_if_counters_mux);
+    /* Packets still in the mailbox are taken out of it later */
+    uint32_t rx_queued = c->stats.rx_queued;
+    memset(&c->stats, 0, sizeof(c->stats));
+    c->stats.rx_queued = rx_queued;
+    c->rx_latency_sum_us = 0;
+    portEXIT_CRITICAL(&esp_if_counters_mux);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
 bool tcpip_adapter_is_netif_up(tcpip_adapter_if_t tcpip_if)
 {
     if (esp_netif[tcpip_if] != NULL && netif_is_up(esp_netif[tcpip_if])) {
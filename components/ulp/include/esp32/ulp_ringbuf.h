@@ -0,0 +1,195 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/**
+ * @file ulp_ringbuf.h
+ * @brief Ring buffer in RTC slow memory, filled by the ULP and drained by the main CPU
+ *
+ * The ULP pushes 16-bit values into the ring buffer and wakes up the main CPU
+ * only when the number of values in the buffer reaches a threshold. The main CPU
+ * reads all values at once, so a single wakeup handles a batch of samples.
+ *
+ * The ring buffer is a block of 32-bit words: a header followed by the data slots.
+ * Only the 16 LSBs of each word are used, ULP ST instruction writes the upper half
+ * of the word with the PC value. The head index is written only by the ULP and the
+ * tail index only by the main CPU, so no locking is needed. The number of slots
+ * is a power of two and one slot is always kept empty to tell a full buffer
+ * from an empty one, so a buffer of N slots holds up to N - 1 values.
+ *
+ * This header may be included both from C sources and from ULP assembly sources.
+ */
+
+/** @defgroup ulp_ringbuf_layout Word offsets of the ring buffer header fields
+ * @{
+ */
+#define ULP_RINGBUF_HEAD        0   /*!< Index of the slot written next, updated by the ULP */
+#define ULP_RINGBUF_TAIL        1   /*!< Index of the slot read next, updated by the main CPU */
+#define ULP_RINGBUF_SIZE        2   /*!< Number of slots, power of two */
+#define ULP_RINGBUF_THRESHOLD   3   /*!< Number of values at which the ULP wakes up the main CPU */
+#define ULP_RINGBUF_OVERFLOW    4   /*!< Number of values dropped because the buffer was full, incremented by the ULP */
+#define ULP_RINGBUF_WAKE        5   /*!< Set by the ULP when it wakes up the main CPU, cleared when the values are read */
+#define ULP_RINGBUF_DATA        6   /*!< First data slot */
+/**@}*/
+
+/** Size of a ring buffer with the given number of slots, in 32-bit words */
+#define ULP_RINGBUF_WORDS(size) (ULP_RINGBUF_DATA + (size))
+
+#ifdef __ASSEMBLER__
+
+/* Push the value in r1 into the ring buffer at address 'ringbuf' which has 'size' slots.
+ * If the buffer is full, the value is dropped and the overflow counter is incremented.
+ * The main CPU is woken up when the buffer fill level reaches the threshold.
+ * Registers r0-r3 are clobbered.
+ */
+    .macro ringbuf_push ringbuf, size
+    move r3, \ringbuf
+    ld r2, r3, ULP_RINGBUF_HEAD * 4
+    add r2, r2, r3
+    st r1, r2, ULP_RINGBUF_DATA * 4
+    sub r2, r2, r3
+    add r2, r2, 1
+    and r2, r2, (\size) - 1
+    ld r1, r3, ULP_RINGBUF_TAIL * 4
+    sub r0, r2, r1
+    jump 1f, eq
+    st r2, r3, ULP_RINGBUF_HEAD * 4
+    sub r2, r2, r1
+    and r2, r2, (\size) - 1
+    ld r1, r3, ULP_RINGBUF_THRESHOLD * 4
+    sub r0, r2, r1
+    jump 2f, ov
+    ld r0, r3, ULP_RINGBUF_WAKE * 4
+    jumpr 2f, 1, ge
+    move r0, 1
+    st r0, r3, ULP_RINGBUF_WAKE * 4
+    wake
+    jump 2f
+1:
+    ld r2, r3, ULP_RINGBUF_OVERFLOW * 4
+    add r2, r2, 1
+    st r2, r3, ULP_RINGBUF_OVERFLOW * 4
+2:
+    .endm
+
+#else // __ASSEMBLER__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp32/ulp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Macro: push the value in R1 into the ring buffer
+ *
+ * If the buffer is full, the value is dropped and the overflow counter is incremented.
+ * The main CPU is woken up when the buffer fill level reaches the threshold and
+ * ULP_RINGBUF_WAKE is not set yet.
+ *
+ * Registers R0, R1, R2 and R3 are clobbered.
+ *
+ * @param ringbuf_addr  address of the ring buffer in RTC slow memory, in 32-bit words
+ * @param size  number of slots, must match the size passed to ulp_ringbuf_init
+ * @param label_full  label number used internally by the macro
+ * @param label_done  label number used internally by the macro
+ */
+#define M_RINGBUF_PUSH(ringbuf_addr, size, label_full, label_done) \
+    I_MOVI(R3, ringbuf_addr), \
+    I_LD(R2, R3, ULP_RINGBUF_HEAD), \
+    I_ADDR(R2, R2, R3), \
+    I_ST(R1, R2, ULP_RINGBUF_DATA), \
+    I_SUBR(R2, R2, R3), \
+    I_ADDI(R2, R2, 1), \
+    I_ANDI(R2, R2, (size) - 1), \
+    I_LD(R1, R3, ULP_RINGBUF_TAIL), \
+    I_SUBR(R0, R2, R1), \
+    M_BXZ(label_full), \
+    I_ST(R2, R3, ULP_RINGBUF_HEAD), \
+    I_SUBR(R2, R2, R1), \
+    I_ANDI(R2, R2, (size) - 1), \
+    I_LD(R1, R3, ULP_RINGBUF_THRESHOLD), \
+    I_SUBR(R0, R2, R1), \
+    M_BXF(label_done), \
+    I_LD(R0, R3, ULP_RINGBUF_WAKE), \
+    M_BGE(label_done, 1), \
+    I_MOVI(R0, 1), \
+    I_ST(R0, R3, ULP_RINGBUF_WAKE), \
+    I_WAKE(), \
+    M_BX(label_done), \
+    M_LABEL(label_full), \
+    I_LD(R2, R3, ULP_RINGBUF_OVERFLOW), \
+    I_ADDI(R2, R2, 1), \
+    I_ST(R2, R3, ULP_RINGBUF_OVERFLOW), \
+    M_LABEL(label_done)
+
+/**
+ * @brief Initialize a ring buffer in RTC slow memory
+ *
+ * Must be called before the ULP program which pushes values is started.
+ * For ULP assembly programs, reserve ULP_RINGBUF_WORDS(size) words in .bss and pass
+ * the address of the exported variable, e.g. &ulp_samples. For programs built with
+ * ULP macros, pass &RTC_SLOW_MEM[ringbuf_addr].
+ *
+ * @param ringbuf  pointer to the ring buffer in the reserved RTC slow memory
+ * @param size  number of slots, power of two between 2 and 4096
+ * @param threshold  number of values at which the main CPU is woken up, between 1 and size - 1
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if size or threshold are invalid, or the ring buffer
+ *        is outside of the memory reserved for the ULP
+ */
+esp_err_t ulp_ringbuf_init(uint32_t* ringbuf, size_t size, size_t threshold);
+
+/**
+ * @brief Get the number of values in a ring buffer
+ *
+ * @param ringbuf  pointer to the ring buffer
+ * @return number of values which can be read
+ */
+size_t ulp_ringbuf_count(const uint32_t* ringbuf);
+
+/**
+ * @brief Read values from a ring buffer
+ *
+ * Values are copied starting from the oldest one, then the tail index is advanced
+ * and ULP_RINGBUF_WAKE is cleared, so that the ULP wakes up the main CPU again
+ * when the threshold is reached.
+ *
+ * @param ringbuf  pointer to the ring buffer
+ * @param[out] data  buffer for the values
+ * @param max_count  maximal number of values to read
+ * @return number of values read
+ */
+size_t ulp_ringbuf_read(uint32_t* ringbuf, uint16_t* data, size_t max_count);
+
+/**
+ * @brief Get the number of values dropped by the ULP because the buffer was full
+ *
+ * The counter is only incremented by the ULP and wraps around at 65536.
+ *
+ * @param ringbuf  pointer to the ring buffer
+ * @return number of dropped values
+ */
+uint32_t ulp_ringbuf_get_overflow(const uint32_t* ringbuf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __ASSEMBLER__
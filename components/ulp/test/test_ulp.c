@@ -25,6 +25,7 @@
 #include "esp_sleep.h"
 
 #include "esp32/ulp.h"
+#include "esp32/ulp_ringbuf.h"
 
 #include "soc/soc.h"
 #include "soc/rtc.h"
@@ -96,6 +97,47 @@ TEST_CASE("ulp branch test", "[ulp]")
     TEST_ASSERT_EQUAL(0, RTC_SLOW_MEM[64]);
 }
 
+TEST_CASE("ulp ring buffer test", "[ulp]")
+{
+    assert(CONFIG_ULP_COPROC_RESERVE_MEM >= 512 && "this test needs ULP_COPROC_RESERVE_MEM option set in menuconfig");
+    memset(RTC_SLOW_MEM, 0, CONFIG_ULP_COPROC_RESERVE_MEM);
+    const size_t ringbuf_addr = 96;
+    const size_t counter_addr = 95;
+    const ulp_insn_t program[] = {
+        M_LABEL(1),
+        I_MOVI(R3, counter_addr),
+        I_LD(R1, R3, 0),
+        I_ADDI(R1, R1, 1),
+        I_ST(R1, R3, 0),            // R1 = ++counter
+        M_RINGBUF_PUSH(ringbuf_addr, 16, 2, 3),
+        I_MOVI(R3, counter_addr),
+        I_LD(R0, R3, 0),
+        M_BL(1, 20),                // push values 1 to 20
+        I_END(),
+        I_HALT()
+    };
+    uint32_t* ringbuf = &RTC_SLOW_MEM[ringbuf_addr];
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, ulp_ringbuf_init(ringbuf, 12, 8));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, ulp_ringbuf_init(ringbuf, 16, 16));
+    TEST_ASSERT_EQUAL(ESP_OK, ulp_ringbuf_init(ringbuf, 16, 8));
+    size_t size = sizeof(program)/sizeof(ulp_insn_t);
+    TEST_ASSERT_EQUAL(ESP_OK, ulp_process_macros_and_load(0, program, &size));
+    TEST_ASSERT_EQUAL(ESP_OK, ulp_run(0));
+    ets_delay_us(1000);
+    hexdump(ringbuf, ULP_RINGBUF_WORDS(16));
+    // 16 slots hold 15 values, the other 5 are dropped
+    TEST_ASSERT_EQUAL(15, ulp_ringbuf_count(ringbuf));
+    TEST_ASSERT_EQUAL(5, ulp_ringbuf_get_overflow(ringbuf));
+    TEST_ASSERT_EQUAL(1, ringbuf[ULP_RINGBUF_WAKE] & 0xffff);
+    uint16_t values[16];
+    TEST_ASSERT_EQUAL(15, ulp_ringbuf_read(ringbuf, values, 16));
+    for (int i = 0; i < 15; ++i) {
+        TEST_ASSERT_EQUAL(i + 1, values[i]);
+    }
+    TEST_ASSERT_EQUAL(0, ulp_ringbuf_count(ringbuf));
+    TEST_ASSERT_EQUAL(0, ringbuf[ULP_RINGBUF_WAKE] & 0xffff);
+}
+
 TEST_CASE("ulp wakeup test", "[ulp][ignore]")
 {
     assert(CONFIG_ULP_COPROC_RESERVE_MEM >= 260 && "this test needs ULP_COPROC_RESERVE_MEM option set in menuconfig");
@@ -0,0 +1,89 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp32/ulp.h"
+#include "esp32/ulp_ringbuf.h"
+
+#include "sdkconfig.h"
+
+static const char* TAG = "ulp_ringbuf";
+
+#define ULP_RINGBUF_MAX_SIZE    4096
+
+/* Only the 16 LSBs of RTC slow memory words written by the ULP hold data */
+#define ULP_RINGBUF_FIELD(ringbuf, field) ((ringbuf)[field] & 0xffff)
+
+esp_err_t ulp_ringbuf_init(uint32_t* ringbuf, size_t size, size_t threshold)
+{
+    if (size < 2 || size > ULP_RINGBUF_MAX_SIZE || (size & (size - 1)) != 0) {
+        ESP_LOGW(TAG, "invalid size: %u, must be a power of two", (unsigned) size);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (threshold < 1 || threshold >= size) {
+        ESP_LOGW(TAG, "invalid threshold: %u", (unsigned) threshold);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (ringbuf < RTC_SLOW_MEM ||
+            ringbuf + ULP_RINGBUF_WORDS(size) > RTC_SLOW_MEM + CONFIG_ULP_COPROC_RESERVE_MEM / sizeof(uint32_t)) {
+        ESP_LOGW(TAG, "ring buffer %p doesn't fit into ULP memory", ringbuf);
+        return ESP_ERR_INVALID_ARG;
+    }
+    volatile uint32_t* p = ringbuf;
+    p[ULP_RINGBUF_HEAD] = 0;
+    p[ULP_RINGBUF_TAIL] = 0;
+    p[ULP_RINGBUF_SIZE] = size;
+    p[ULP_RINGBUF_THRESHOLD] = threshold;
+    p[ULP_RINGBUF_OVERFLOW] = 0;
+    p[ULP_RINGBUF_WAKE] = 0;
+    return ESP_OK;
+}
+
+size_t ulp_ringbuf_count(const uint32_t* ringbuf)
+{
+    const volatile uint32_t* p = ringbuf;
+    uint32_t mask = ULP_RINGBUF_FIELD(p, ULP_RINGBUF_SIZE) - 1;
+    return (ULP_RINGBUF_FIELD(p, ULP_RINGBUF_HEAD) - ULP_RINGBUF_FIELD(p, ULP_RINGBUF_TAIL)) & mask;
+}
+
+size_t ulp_ringbuf_read(uint32_t* ringbuf, uint16_t* data, size_t max_count)
+{
+    volatile uint32_t* p = ringbuf;
+    uint32_t mask = ULP_RINGBUF_FIELD(p, ULP_RINGBUF_SIZE) - 1;
+    uint32_t tail = ULP_RINGBUF_FIELD(p, ULP_RINGBUF_TAIL);
+    /* Head is read once: values pushed by the ULP from now on are left for the next call */
+    uint32_t count = (ULP_RINGBUF_FIELD(p, ULP_RINGBUF_HEAD) - tail) & mask;
+    if (count > max_count) {
+        count = max_count;
+    }
+    const volatile uint32_t* slots = p + ULP_RINGBUF_DATA;
+    for (uint32_t i = 0; i < count; ++i) {
+        data[i] = slots[tail] & 0xffff;
+        tail = (tail + 1) & mask;
+    }
+    /* The slots are free once the tail is updated. The wake flag is cleared after that,
+     * otherwise the ULP could see the old tail and wake up the main CPU once more. */
+    p[ULP_RINGBUF_TAIL] = tail;
+    p[ULP_RINGBUF_WAKE] = 0;
+    return count;
+}
+
+uint32_t ulp_ringbuf_get_overflow(const uint32_t* ringbuf)
+{
+    return ULP_RINGBUF_FIELD((const volatile uint32_t*) ringbuf, ULP_RINGBUF_OVERFLOW);
+}
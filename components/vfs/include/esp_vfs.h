@@ -29,6 +29,7 @@
 #include <sys/time.h>
 #include <sys/termios.h>
 #include <sys/poll.h>
+#include <sys/uio.h>
 #include <dirent.h>
 #include <string.h>
 #include "sdkconfig.h"
@@ -86,6 +87,9 @@ typedef int esp_vfs_id_t;
  *
  * If the FS driver doesn't provide some of the functions, set corresponding
  * members to NULL.
+ *
+ * pread, pwrite, readv and writev are optional. If they are NULL, VFS
+ * implements them using lseek, read and write of the driver.
  */
 typedef struct
 {
@@ -102,6 +106,22 @@ typedef struct
         ssize_t (*read_p)(void* ctx, int fd, void * dst, size_t size);
         ssize_t (*read)(int fd, void * dst, size_t size);
     };
+    union {
+        ssize_t (*pread_p)(void* ctx, int fd, void * dst, size_t size, off_t offset);
+        ssize_t (*pread)(int fd, void * dst, size_t size, off_t offset);
+    };
+    union {
+        ssize_t (*pwrite_p)(void* ctx, int fd, const void * src, size_t size, off_t offset);
+        ssize_t (*pwrite)(int fd, const void * src, size_t size, off_t offset);
+    };
+    union {
+        ssize_t (*readv_p)(void* ctx, int fd, const struct iovec * iov, int iovcnt);
+        ssize_t (*readv)(int fd, const struct iovec * iov, int iovcnt);
+    };
+    union {
+        ssize_t (*writev_p)(void* ctx, int fd, const struct iovec * iov, int iovcnt);
+        ssize_t (*writev)(int fd, const struct iovec * iov, int iovcnt);
+    };
     union {
         int (*open_p)(void* ctx, const char * path, int flags, int mode);
         int (*open)(const char * path, int flags, int mode);
@@ -339,6 +359,28 @@ int esp_vfs_rename(struct _reent *r, const char *src, const char *dst);
 int esp_vfs_utime(const char *path, const struct utimbuf *times);
 /**@}*/
 
+/**
+ * @brief Positional and vectored I/O
+ *
+ * These functions implement pread(), pwrite(), readv() and writev(). The
+ * driver's pread, pwrite, readv and writev members are used if they are set,
+ * so that e.g. a scatter write is passed to the driver as a single operation.
+ * Otherwise the operation is emulated: pread and pwrite with lseek to the
+ * offset, read or write and lseek back to the original position; readv and
+ * writev with one read or write call per buffer. The emulation is not atomic
+ * with respect to other users of the same file descriptor.
+ *
+ * The semantics otherwise follow POSIX. An emulated readv or writev returns
+ * the number of bytes transferred before the error or short transfer, if any
+ * bytes were transferred.
+ */
+/**@{*/
+ssize_t esp_vfs_pread(int fd, void * dst, size_t size, off_t offset);
+ssize_t esp_vfs_pwrite(int fd, const void * src, size_t size, off_t offset);
+ssize_t esp_vfs_readv(int fd, const struct iovec * iov, int iovcnt);
+ssize_t esp_vfs_writev(int fd, const struct iovec * iov, int iovcnt);
+/**@}*/
+
 /**
  * @brief Synchronous I/O multiplexing which implements the functionality of POSIX select() for VFS
  * @param nfds      Specifies the range of descriptors which should be checked.
@@ -402,6 +444,90 @@ void esp_vfs_select_triggered_isr(SemaphoreHandle_t *signal_sem, BaseType_t *wok
  */
 int esp_vfs_poll(struct pollfd *fds, nfds_t nfds, int timeout);
 
+/**
+ * Events of a file descriptor observed by an interest set, see esp_vfs_epoll_ctl
+ */
+#define ESP_VFS_EPOLLIN     (1 << 0)    /*!< ready to read */
+#define ESP_VFS_EPOLLOUT    (1 << 1)    /*!< ready to write */
+#define ESP_VFS_EPOLLERR    (1 << 2)    /*!< error condition */
+
+/**
+ * Operations on an interest set, see esp_vfs_epoll_ctl
+ */
+#define ESP_VFS_EPOLL_CTL_ADD   1       /*!< start observing a file descriptor */
+#define ESP_VFS_EPOLL_CTL_DEL   2       /*!< stop observing a file descriptor */
+#define ESP_VFS_EPOLL_CTL_MOD   3       /*!< change the observed events of a file descriptor */
+
+/**
+ * Handle of an interest set created by esp_vfs_epoll_create
+ */
+typedef struct esp_vfs_epoll *esp_vfs_epoll_handle_t;
+
+/**
+ * Ready file descriptor returned by esp_vfs_epoll_wait
+ */
+typedef struct {
+    int fd;             /*!< the file descriptor */
+    uint32_t events;    /*!< ESP_VFS_EPOLLIN, ESP_VFS_EPOLLOUT and/or ESP_VFS_EPOLLERR, the observed events which are ready */
+} esp_vfs_epoll_event_t;
+
+/**
+ * @brief Create an interest set for waiting on many file descriptors
+ *
+ * Unlike esp_vfs_select and esp_vfs_poll, the file descriptors to observe are registered once with
+ * esp_vfs_epoll_ctl. The interest set keeps them translated to the FD sets of each VFS driver, together
+ * with the semaphore used for waiting, so every call of esp_vfs_epoll_wait only copies the FD sets of the
+ * VFS drivers in use and reports the ready file descriptors.
+ *
+ * @param handle    Location to store the handle of the new interest set
+ *
+ * @return  ESP_OK on success, ESP_ERR_INVALID_ARG if handle is NULL, ESP_ERR_NO_MEM if out of memory
+ */
+esp_err_t esp_vfs_epoll_create(esp_vfs_epoll_handle_t *handle);
+
+/**
+ * @brief Delete an interest set
+ *
+ * The interest set must not be used by esp_vfs_epoll_wait when it is deleted.
+ *
+ * @param handle    Interest set created by esp_vfs_epoll_create
+ *
+ * @return  ESP_OK on success, ESP_ERR_INVALID_ARG if handle is NULL
+ */
+esp_err_t esp_vfs_epoll_delete(esp_vfs_epoll_handle_t handle);
+
+/**
+ * @brief Add, modify or remove a file descriptor of an interest set
+ *
+ * A file descriptor must be removed from all interest sets before it is closed.
+ *
+ * @param handle    Interest set created by esp_vfs_epoll_create
+ * @param op        ESP_VFS_EPOLL_CTL_ADD, ESP_VFS_EPOLL_CTL_MOD or ESP_VFS_EPOLL_CTL_DEL
+ * @param fd        File descriptor
+ * @param events    Events to observe: ESP_VFS_EPOLLIN, ESP_VFS_EPOLLOUT and/or ESP_VFS_EPOLLERR; ignored by
+ *                  ESP_VFS_EPOLL_CTL_DEL
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if an argument is invalid or fd is not open
+ *      - ESP_ERR_INVALID_STATE if fd is already in the interest set (ESP_VFS_EPOLL_CTL_ADD) or is not in it
+ *        (ESP_VFS_EPOLL_CTL_MOD and ESP_VFS_EPOLL_CTL_DEL)
+ */
+esp_err_t esp_vfs_epoll_ctl(esp_vfs_epoll_handle_t handle, int op, int fd, uint32_t events);
+
+/**
+ * @brief Wait until file descriptors of an interest set are ready
+ *
+ * @param handle        Interest set created by esp_vfs_epoll_create
+ * @param events        Array to store the ready file descriptors in
+ * @param max_events    Number of items in the array events
+ * @param timeout       Timeout in milliseconds; 0 to return immediately, -1 to wait without timeout
+ *
+ * @return  The number of ready file descriptors stored in events, 0 if the timeout expired first, or -1 on
+ *          failure with errno set accordingly
+ */
+int esp_vfs_epoll_wait(esp_vfs_epoll_handle_t handle, esp_vfs_epoll_event_t *events, int max_events, int timeout);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -29,6 +29,36 @@ typedef enum {
     ESP_LINE_ENDINGS_LF,  //!< LF
 } esp_line_endings_t;
 
+/**
+ * @brief When the output buffer of esp_vfs_dev_uart_use_buffered is sent to the UART
+ */
+typedef enum {
+    ESP_VFS_UART_BUFFER_LINE,   //!< Whenever a newline is written
+    ESP_VFS_UART_BUFFER_BLOCK,  //!< Whenever the buffer is half full
+} esp_vfs_uart_buffer_mode_t;
+
+/**
+ * @brief Configuration of esp_vfs_dev_uart_use_buffered
+ */
+typedef struct {
+    size_t buffer_size;                 //!< Size of the output buffer in bytes, at least 128
+    esp_vfs_uart_buffer_mode_t mode;    //!< When the buffer is sent, in addition to every flush_interval_ms
+    uint32_t flush_interval_ms;         //!< Longest time data waits in the buffer, 0 to wait for the mode condition or fsync
+    int task_priority;                  //!< Priority of the task which sends the buffer to the UART driver
+    uint32_t task_stack_size;           //!< Stack size of the task, in bytes
+} esp_vfs_dev_uart_buffered_config_t;
+
+/**
+ * @brief Default configuration of esp_vfs_dev_uart_use_buffered
+ */
+#define ESP_VFS_DEV_UART_BUFFERED_CONFIG_DEFAULT() { \
+    .buffer_size = 2048, \
+    .mode = ESP_VFS_UART_BUFFER_LINE, \
+    .flush_interval_ms = 10, \
+    .task_priority = 2, \
+    .task_stack_size = 2048, \
+}
+
 /**
  * @brief add /dev/uart virtual filesystem driver
  *
@@ -80,10 +110,44 @@ void esp_vfs_dev_uart_use_nonblocking(int uart_num);
  * @brief set VFS to use UART driver for reading and writing
  * @note application must configure UART driver before calling these functions
  * With these functions, read and write are blocking and interrupt-driven.
+ * Writes are passed to the driver in blocks, and read returns the data
+ * available in the receive buffer of the driver, up to the requested size.
  * @param uart_num UART peripheral number
  */
 void esp_vfs_dev_uart_use_driver(int uart_num);
 
+/**
+ * @brief set VFS to buffer the output of a UART and use UART driver for reading and writing
+ *
+ * Writes go to an output buffer, which a task sends to the UART driver as
+ * configured, so that writers do not wait for the UART. Reading works as with
+ * esp_vfs_dev_uart_use_driver. fsync and tcdrain wait until the buffer is sent.
+ *
+ * When the buffer is full, writes wait for the task to make room. If O_NONBLOCK
+ * is set on the UART (see fcntl), the data which does not fit is dropped
+ * instead, and counted by esp_vfs_dev_uart_get_dropped_bytes. The flag applies
+ * to reading from the UART too.
+ *
+ * Calling esp_vfs_dev_uart_use_driver or esp_vfs_dev_uart_use_nonblocking sends
+ * the buffer and frees it.
+ *
+ * @note application must configure UART driver before calling this function
+ * @param uart_num UART peripheral number
+ * @param config buffer configuration, see ESP_VFS_DEV_UART_BUFFERED_CONFIG_DEFAULT
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if uart_num or the configuration is invalid
+ *      - ESP_ERR_NO_MEM if the buffer or the task could not be created
+ */
+esp_err_t esp_vfs_dev_uart_use_buffered(int uart_num, const esp_vfs_dev_uart_buffered_config_t* config);
+
+/**
+ * @brief Get the number of bytes dropped by non-blocking writes to a full output buffer
+ * @param uart_num UART peripheral number
+ * @return number of bytes dropped since startup
+ */
+size_t esp_vfs_dev_uart_get_dropped_bytes(int uart_num);
+
 #ifdef __cplusplus
 }
 #endif
@@ -23,6 +23,9 @@ extern "C" {
 /**
  * @brief add virtual filesystem semihosting driver
  *
+ * Each read, write and seek halts the CPU for a semihosting call. Set
+ * CONFIG_SEMIHOSTFS_BUFFER_SIZE to buffer small reads and writes of host files.
+ *
  * @param base_path VFS path to mount host directory
  * @param host_path host path to mount; if NULL default dirctory will be used (see OpenOCD configuration)
  * @return
@@ -267,3 +267,54 @@ TEST_CASE("Open & write & close through VFS passes performance test", "[vfs]")
 #endif
 
 }
+
+static int churn_test_vfs_open(const char *path, int flags, int mode)
+{
+    return 1;
+}
+
+static int churn_test_vfs_close(int fd)
+{
+    return 0;
+}
+
+TEST_CASE("VFS allocates the lowest free FD after FD churn", "[vfs]")
+{
+    esp_vfs_t desc = {
+        .flags = ESP_VFS_FLAG_DEFAULT,
+        .open = churn_test_vfs_open,
+        .close = churn_test_vfs_close,
+    };
+
+    TEST_ESP_OK( esp_vfs_register(VFS_PREF1, &desc, NULL) );
+
+    static int fds[MAX_FDS];
+    int count = 0;
+
+    // Fill the FD table
+    while (count < MAX_FDS) {
+        const int fd = open(VFS_PREF1 FILE1, 0, 0);
+        if (fd == -1) {
+            TEST_ASSERT_EQUAL(ENOMEM, errno);
+            break;
+        }
+        fds[count++] = fd;
+    }
+    TEST_ASSERT_GREATER_THAN(4, count);
+
+    // Released FDs are handed out again lowest first
+    TEST_ASSERT_NOT_EQUAL(close(fds[count - 1]), -1);
+    TEST_ASSERT_NOT_EQUAL(close(fds[count / 2]), -1);
+    TEST_ASSERT_NOT_EQUAL(close(fds[1]), -1);
+
+    TEST_ASSERT_EQUAL(fds[1], open(VFS_PREF1 FILE1, 0, 0));
+    TEST_ASSERT_EQUAL(fds[count / 2], open(VFS_PREF1 FILE1, 0, 0));
+    TEST_ASSERT_EQUAL(fds[count - 1], open(VFS_PREF1 FILE1, 0, 0));
+    TEST_ASSERT_EQUAL(-1, open(VFS_PREF1 FILE1, 0, 0));
+
+    for (int i = 0; i < count; ++i) {
+        TEST_ASSERT_NOT_EQUAL(close(fds[i]), -1);
+    }
+
+    TEST_ESP_OK( esp_vfs_unregister(VFS_PREF1) );
+}
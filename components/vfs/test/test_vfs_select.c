@@ -421,6 +421,74 @@ TEST_CASE("poll() timeout", "[vfs]")
     deinit(uart_fd, socket_fd);
 }
 
+TEST_CASE("UART and socket can do esp_vfs_epoll_wait()", "[vfs]")
+{
+    int uart_fd;
+    int socket_fd;
+    char recv_message[sizeof(message)];
+    esp_vfs_epoll_handle_t epoll;
+    esp_vfs_epoll_event_t events[2];
+
+    init(&uart_fd, &socket_fd);
+
+    TEST_ESP_OK(esp_vfs_epoll_create(&epoll));
+    TEST_ESP_OK(esp_vfs_epoll_ctl(epoll, ESP_VFS_EPOLL_CTL_ADD, uart_fd, ESP_VFS_EPOLLIN));
+    TEST_ESP_OK(esp_vfs_epoll_ctl(epoll, ESP_VFS_EPOLL_CTL_ADD, socket_fd, ESP_VFS_EPOLLIN));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, esp_vfs_epoll_ctl(epoll, ESP_VFS_EPOLL_CTL_ADD, uart_fd, ESP_VFS_EPOLLIN));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_vfs_epoll_ctl(epoll, ESP_VFS_EPOLL_CTL_ADD, -1, ESP_VFS_EPOLLIN));
+
+    int s = esp_vfs_epoll_wait(epoll, events, 2, 100);
+    TEST_ASSERT_EQUAL(0, s);
+
+    const test_task_param_t test_task_param = {
+        .fd = uart_fd,
+        .delay_ms = 50,
+        .sem = xSemaphoreCreateBinary(),
+    };
+    TEST_ASSERT_NOT_NULL(test_task_param.sem);
+
+    for (int i = 0; i < 2; ++i) {
+        // the interest set is kept between the calls
+        start_task(&test_task_param);
+
+        s = esp_vfs_epoll_wait(epoll, events, 2, 1000);
+        TEST_ASSERT_EQUAL(1, s);
+        TEST_ASSERT_EQUAL(uart_fd, events[0].fd);
+        TEST_ASSERT_EQUAL(ESP_VFS_EPOLLIN, events[0].events);
+
+        int read_bytes = read(uart_fd, recv_message, sizeof(message));
+        TEST_ASSERT_EQUAL(read_bytes, sizeof(message));
+        TEST_ASSERT_EQUAL_MEMORY(message, recv_message, sizeof(message));
+
+        TEST_ASSERT_EQUAL(xSemaphoreTake(test_task_param.sem, 1000 / portTICK_PERIOD_MS), pdTRUE);
+    }
+
+    TEST_ESP_OK(esp_vfs_epoll_ctl(epoll, ESP_VFS_EPOLL_CTL_DEL, uart_fd, 0));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, esp_vfs_epoll_ctl(epoll, ESP_VFS_EPOLL_CTL_DEL, uart_fd, 0));
+
+    const test_task_param_t socket_task_param = {
+        .fd = socket_fd,
+        .delay_ms = 50,
+        .sem = test_task_param.sem,
+    };
+    start_task(&socket_task_param);
+
+    s = esp_vfs_epoll_wait(epoll, events, 2, 1000);
+    TEST_ASSERT_EQUAL(1, s);
+    TEST_ASSERT_EQUAL(socket_fd, events[0].fd);
+    TEST_ASSERT_EQUAL(ESP_VFS_EPOLLIN, events[0].events);
+
+    int read_bytes = read(socket_fd, recv_message, sizeof(message));
+    TEST_ASSERT_EQUAL(read_bytes, sizeof(message));
+    TEST_ASSERT_EQUAL_MEMORY(message, recv_message, sizeof(message));
+
+    TEST_ASSERT_EQUAL(xSemaphoreTake(test_task_param.sem, 1000 / portTICK_PERIOD_MS), pdTRUE);
+    vSemaphoreDelete(test_task_param.sem);
+
+    TEST_ESP_OK(esp_vfs_epoll_delete(epoll));
+    deinit(uart_fd, socket_fd);
+}
+
 static void select_task(void *param)
 {
     const test_task_param_t *test_task_param = param;
@@ -16,6 +16,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <fcntl.h>
+#include <unistd.h>
 #include <sys/termios.h>
 #include <sys/errno.h>
 #include "unity.h"
@@ -203,6 +204,46 @@ TEST_CASE("can write to UART while another task is reading", "[vfs]")
     vSemaphoreDelete(write_arg.done);
 }
 
+TEST_CASE("can write to UART through the output buffer", "[vfs]")
+{
+    const char* str = "buffered output 0123456789\n";
+    char out_buffer[32] = { 0 };
+
+    flush_stdin_stdout();
+    ESP_ERROR_CHECK( uart_driver_install(CONFIG_CONSOLE_UART_NUM,
+            256, 0, 0, NULL, 0) );
+    esp_vfs_dev_uart_buffered_config_t config = ESP_VFS_DEV_UART_BUFFERED_CONFIG_DEFAULT();
+    TEST_ESP_OK(esp_vfs_dev_uart_use_buffered(CONFIG_CONSOLE_UART_NUM, &config));
+
+    UART0.conf0.loopback = 1;
+    fwrite(str, 1, strlen(str), stdout);
+    fflush(stdout);
+    fsync(fileno(stdout));
+    vTaskDelay(2 / portTICK_PERIOD_MS);
+    UART0.conf0.loopback = 0;
+    fgets(out_buffer, sizeof(out_buffer), stdin);
+    TEST_ASSERT_EQUAL_STRING(str, out_buffer);
+
+    /* non-blocking writes to a full buffer are dropped */
+    config.buffer_size = 128;
+    config.flush_interval_ms = 0;
+    config.mode = ESP_VFS_UART_BUFFER_BLOCK;
+    TEST_ESP_OK(esp_vfs_dev_uart_use_buffered(CONFIG_CONSOLE_UART_NUM, &config));
+    size_t dropped = esp_vfs_dev_uart_get_dropped_bytes(CONFIG_CONSOLE_UART_NUM);
+    int flags = fcntl(fileno(stdout), F_GETFL);
+    fcntl(fileno(stdout), F_SETFL, flags | O_NONBLOCK);
+    for (int i = 0; i < 32; ++i) {
+        TEST_ASSERT_EQUAL(strlen(str), write(fileno(stdout), str, strlen(str)));
+    }
+    fcntl(fileno(stdout), F_SETFL, flags);
+    TEST_ASSERT_GREATER_THAN(dropped, esp_vfs_dev_uart_get_dropped_bytes(CONFIG_CONSOLE_UART_NUM));
+    fsync(fileno(stdout));
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_vfs_dev_uart_use_buffered(CONFIG_CONSOLE_UART_NUM, NULL));
+    esp_vfs_dev_uart_use_nonblocking(CONFIG_CONSOLE_UART_NUM);
+    uart_driver_delete(CONFIG_CONSOLE_UART_NUM);
+}
+
 #ifdef CONFIG_SUPPORT_TERMIOS
 TEST_CASE("Can use termios for UART", "[vfs]")
 {
@@ -69,9 +69,66 @@ typedef struct {
 static vfs_entry_t* s_vfs[VFS_MAX_COUNT] = { 0 };
 static size_t s_vfs_count = 0;
 
+/* VFS entries which have a path prefix, longest prefix first, so that the first
+ * matching entry is the best match. Rebuilt whenever s_vfs changes. */
+static const vfs_entry_t* s_vfs_by_prefix[VFS_MAX_COUNT] = { 0 };
+static size_t s_vfs_by_prefix_count = 0;
+
+static void update_vfs_by_prefix(void)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < s_vfs_count; ++i) {
+        const vfs_entry_t* vfs = s_vfs[i];
+        if (!vfs || vfs->path_prefix_len == LEN_PATH_PREFIX_IGNORED) {
+            continue;
+        }
+        // insertion sort; entries with equal prefix lengths keep their s_vfs order
+        size_t pos = count;
+        while (pos > 0 && s_vfs_by_prefix[pos - 1]->path_prefix_len < vfs->path_prefix_len) {
+            s_vfs_by_prefix[pos] = s_vfs_by_prefix[pos - 1];
+            --pos;
+        }
+        s_vfs_by_prefix[pos] = vfs;
+        ++count;
+    }
+    s_vfs_by_prefix_count = count;
+}
+
 static fd_table_t s_fd_table[MAX_FDS] = { [0 ... MAX_FDS-1] = FD_TABLE_ENTRY_UNUSED };
 static _lock_t s_fd_table_lock;
 
+#define FD_USED_WORDS   ((MAX_FDS + 31) / 32)
+
+/* Bit i is set when s_fd_table[i] is in use, so the lowest free FD is found a word at a time.
+ * It is kept in step with s_fd_table by fd_table_set() and fd_table_clear(), under s_fd_table_lock. */
+static uint32_t s_fd_used[FD_USED_WORDS] = { 0 };
+
+static inline void fd_table_set(int fd, bool permanent, int vfs_index, int local_fd)
+{
+    s_fd_table[fd].permanent = permanent;
+    s_fd_table[fd].vfs_index = vfs_index;
+    s_fd_table[fd].local_fd = local_fd;
+    s_fd_used[fd / 32] |= 1u << (fd % 32);
+}
+
+static inline void fd_table_clear(int fd)
+{
+    s_fd_table[fd] = FD_TABLE_ENTRY_UNUSED;
+    s_fd_used[fd / 32] &= ~(1u << (fd % 32));
+}
+
+/* Returns the lowest unused FD, or -1 if the table is full */
+static int fd_table_find_free(void)
+{
+    for (int i = 0; i < FD_USED_WORDS; ++i) {
+        if (s_fd_used[i] != UINT32_MAX) {
+            const int fd = i * 32 + __builtin_ctz(~s_fd_used[i]);
+            return (fd < MAX_FDS) ? fd : -1;
+        }
+    }
+    return -1;
+}
+
 static esp_err_t esp_vfs_register_common(const char* base_path, size_t len, const esp_vfs_t* vfs, void* ctx, int *vfs_index)
 {
     if (len != LEN_PATH_PREFIX_IGNORED) {
@@ -114,6 +171,8 @@ static esp_err_t esp_vfs_register_common(const char* base_path, size_t len, cons
         *vfs_index = index;
     }
 
+    update_vfs_by_prefix();
+
     return ESP_OK;
 }
 
@@ -136,20 +195,19 @@ esp_err_t esp_vfs_register_fd_range(const esp_vfs_t *vfs, void *ctx, int min_fd,
         _lock_acquire(&s_fd_table_lock);
         for (int i = min_fd; i < max_fd; ++i) {
             if (s_fd_table[i].vfs_index != -1) {
-                free(s_vfs[i]);
-                s_vfs[i] = NULL;
+                free(s_vfs[index]);
+                s_vfs[index] = NULL;
+                update_vfs_by_prefix();
                 for (int j = min_fd; j < i; ++j) {
                     if (s_fd_table[j].vfs_index == index) {
-                        s_fd_table[j] = FD_TABLE_ENTRY_UNUSED;
+                        fd_table_clear(j);
                     }
                 }
                 _lock_release(&s_fd_table_lock);
                 ESP_LOGD(TAG, "esp_vfs_register_fd_range cannot set fd %d (used by other VFS)", i);
                 return ESP_ERR_INVALID_ARG;
             }
-            s_fd_table[i].permanent = true;
-            s_fd_table[i].vfs_index = index;
-            s_fd_table[i].local_fd = i;
+            fd_table_set(i, true, index, i);
         }
         _lock_release(&s_fd_table_lock);
     }
@@ -181,12 +239,13 @@ esp_err_t esp_vfs_unregister(const char* base_path)
                 memcmp(base_path, vfs->path_prefix, vfs->path_prefix_len) == 0) {
             free(vfs);
             s_vfs[i] = NULL;
+            update_vfs_by_prefix();
 
             _lock_acquire(&s_fd_table_lock);
             // Delete all references from the FD lookup-table
             for (int j = 0; j < MAX_FDS; ++j) {
                 if (s_fd_table[j].vfs_index == i) {
-                    s_fd_table[j] = FD_TABLE_ENTRY_UNUSED;
+                    fd_table_clear(j);
                 }
             }
             _lock_release(&s_fd_table_lock);
@@ -206,15 +265,11 @@ esp_err_t esp_vfs_register_fd(esp_vfs_id_t vfs_id, int *fd)
 
     esp_err_t ret = ESP_ERR_NO_MEM;
     _lock_acquire(&s_fd_table_lock);
-    for (int i = 0; i < MAX_FDS; ++i) {
-        if (s_fd_table[i].vfs_index == -1) {
-            s_fd_table[i].permanent = true;
-            s_fd_table[i].vfs_index = vfs_id;
-            s_fd_table[i].local_fd = i;
-            *fd = i;
-            ret = ESP_OK;
-            break;
-        }
+    const int i = fd_table_find_free();
+    if (i >= 0) {
+        fd_table_set(i, true, vfs_id, i);
+        *fd = i;
+        ret = ESP_OK;
     }
     _lock_release(&s_fd_table_lock);
 
@@ -235,7 +290,7 @@ esp_err_t esp_vfs_unregister_fd(esp_vfs_id_t vfs_id, int fd)
     _lock_acquire(&s_fd_table_lock);
     fd_table_t *item = s_fd_table + fd;
     if (item->permanent == true && item->vfs_index == vfs_id && item->local_fd == fd) {
-        *item = FD_TABLE_ENTRY_UNUSED;
+        fd_table_clear(fd);
         ret = ESP_OK;
     }
     _lock_release(&s_fd_table_lock);
@@ -283,7 +338,7 @@ static inline int get_local_fd(const vfs_entry_t *vfs, int fd)
 static const char* translate_path(const vfs_entry_t* vfs, const char* src_path)
 {
     assert(strncmp(src_path, vfs->path_prefix, vfs->path_prefix_len) == 0);
-    if (strlen(src_path) == vfs->path_prefix_len) {
+    if (src_path[vfs->path_prefix_len] == '\0') {
         // special case when src_path matches the path prefix exactly
         return "/";
     }
@@ -292,42 +347,24 @@ static const char* translate_path(const vfs_entry_t* vfs, const char* src_path)
 
 static const vfs_entry_t* get_vfs_for_path(const char* path)
 {
-    const vfs_entry_t* best_match = NULL;
-    ssize_t best_match_prefix_len = -1;
-    size_t len = strlen(path);
-    for (size_t i = 0; i < s_vfs_count; ++i) {
-        const vfs_entry_t* vfs = s_vfs[i];
-        if (!vfs || vfs->path_prefix_len == LEN_PATH_PREFIX_IGNORED) {
-            continue;
-        }
-        // match path prefix
-        if (len < vfs->path_prefix_len ||
-            memcmp(path, vfs->path_prefix, vfs->path_prefix_len) != 0) {
-            continue;
-        }
-        // this is the default VFS and we don't have a better match yet.
-        if (vfs->path_prefix_len == 0 && !best_match) {
-            best_match = vfs;
+    // Prefixes are checked longest first, so the first match is the best one;
+    // i.e. if "/dev" and "/dev/uart" both match, for "/dev/uart/1" path,
+    // "/dev/uart" is found first. The default VFS, with an empty prefix, comes last.
+    for (size_t i = 0; i < s_vfs_by_prefix_count; ++i) {
+        const vfs_entry_t* vfs = s_vfs_by_prefix[i];
+        // match path prefix; strncmp stops at the end of a shorter path
+        if (strncmp(path, vfs->path_prefix, vfs->path_prefix_len) != 0) {
             continue;
         }
         // if path is not equal to the prefix, expect to see a path separator
         // i.e. don't match "/data" prefix for "/data1/foo.txt" path
-        if (len > vfs->path_prefix_len &&
-                path[vfs->path_prefix_len] != '/') {
+        const char next = path[vfs->path_prefix_len];
+        if (vfs->path_prefix_len != 0 && next != '\0' && next != '/') {
             continue;
         }
-        // Out of all matching path prefixes, select the longest one;
-        // i.e. if "/dev" and "/dev/uart" both match, for "/dev/uart/1" path,
-        // choose "/dev/uart",
-        // This causes all s_vfs_count VFS entries to be scanned when opening
-        // a file by name. This can be optimized by introducing a table for
-        // FS search order, sorted so that longer prefixes are checked first.
-        if (best_match_prefix_len < (ssize_t) vfs->path_prefix_len) {
-            best_match_prefix_len = (ssize_t) vfs->path_prefix_len;
-            best_match = vfs;
-        }
+        return vfs;
     }
-    return best_match;
+    return NULL;
 }
 
 /*
@@ -388,14 +425,11 @@ int esp_vfs_open(struct _reent *r, const char * path, int flags, int mode)
     CHECK_AND_CALL(fd_within_vfs, r, vfs, open, path_within_vfs, flags, mode);
     if (fd_within_vfs >= 0) {
         _lock_acquire(&s_fd_table_lock);
-        for (int i = 0; i < MAX_FDS; ++i) {
-            if (s_fd_table[i].vfs_index == -1) {
-                s_fd_table[i].permanent = false;
-                s_fd_table[i].vfs_index = vfs->offset;
-                s_fd_table[i].local_fd = fd_within_vfs;
-                _lock_release(&s_fd_table_lock);
-                return i;
-            }
+        const int i = fd_table_find_free();
+        if (i >= 0) {
+            fd_table_set(i, false, vfs->offset, fd_within_vfs);
+            _lock_release(&s_fd_table_lock);
+            return i;
         }
         _lock_release(&s_fd_table_lock);
         int ret;
@@ -461,7 +495,7 @@ int esp_vfs_close(struct _reent *r, int fd)
 
     _lock_acquire(&s_fd_table_lock);
     if (!s_fd_table[fd].permanent) {
-        s_fd_table[fd] = FD_TABLE_ENTRY_UNUSED;
+        fd_table_clear(fd);
     }
     _lock_release(&s_fd_table_lock);
     return ret;
@@ -739,6 +773,160 @@ int truncate(const char *path, off_t length)
     return ret;
 }
 
+static ssize_t read_local(struct _reent *r, const vfs_entry_t *vfs, int local_fd, void *dst, size_t size)
+{
+    ssize_t ret;
+    CHECK_AND_CALL(ret, r, vfs, read, local_fd, dst, size);
+    return ret;
+}
+
+static ssize_t write_local(struct _reent *r, const vfs_entry_t *vfs, int local_fd, const void *src, size_t size)
+{
+    ssize_t ret;
+    CHECK_AND_CALL(ret, r, vfs, write, local_fd, src, size);
+    return ret;
+}
+
+static off_t lseek_local(struct _reent *r, const vfs_entry_t *vfs, int local_fd, off_t offset, int mode)
+{
+    off_t ret;
+    CHECK_AND_CALL(ret, r, vfs, lseek, local_fd, offset, mode);
+    return ret;
+}
+
+/* pread/pwrite emulation for drivers which don't implement them */
+static ssize_t transfer_at(struct _reent *r, const vfs_entry_t *vfs, int local_fd,
+        void *buf, size_t size, off_t offset, bool is_write)
+{
+    const off_t pos = lseek_local(r, vfs, local_fd, 0, SEEK_CUR);
+    if (pos < 0 || lseek_local(r, vfs, local_fd, offset, SEEK_SET) < 0) {
+        return -1;
+    }
+    const ssize_t ret = is_write ? write_local(r, vfs, local_fd, buf, size)
+                                 : read_local(r, vfs, local_fd, buf, size);
+    // the file position is restored even if the transfer failed, keeping its errno
+    const int err = __errno_r(r);
+    lseek_local(r, vfs, local_fd, pos, SEEK_SET);
+    __errno_r(r) = err;
+    return ret;
+}
+
+/* readv/writev emulation for drivers which don't implement them */
+static ssize_t transfer_iov(struct _reent *r, const vfs_entry_t *vfs, int local_fd,
+        const struct iovec *iov, int iovcnt, bool is_write)
+{
+    ssize_t total = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        if (iov[i].iov_len == 0) {
+            continue;
+        }
+        const ssize_t ret = is_write ? write_local(r, vfs, local_fd, iov[i].iov_base, iov[i].iov_len)
+                                     : read_local(r, vfs, local_fd, iov[i].iov_base, iov[i].iov_len);
+        if (ret < 0) {
+            return (total > 0) ? total : -1;
+        }
+        total += ret;
+        if ((size_t) ret < iov[i].iov_len) {
+            break;
+        }
+    }
+    return total;
+}
+
+ssize_t esp_vfs_pread(int fd, void * dst, size_t size, off_t offset)
+{
+    const vfs_entry_t* vfs = get_vfs_for_fd(fd);
+    const int local_fd = get_local_fd(vfs, fd);
+    struct _reent* r = __getreent();
+    if (vfs == NULL || local_fd < 0) {
+        __errno_r(r) = EBADF;
+        return -1;
+    }
+    if (offset < 0) {
+        __errno_r(r) = EINVAL;
+        return -1;
+    }
+    if (vfs->vfs.pread == NULL) {
+        return transfer_at(r, vfs, local_fd, dst, size, offset, false);
+    }
+    ssize_t ret;
+    CHECK_AND_CALL(ret, r, vfs, pread, local_fd, dst, size, offset);
+    return ret;
+}
+
+ssize_t esp_vfs_pwrite(int fd, const void * src, size_t size, off_t offset)
+{
+    const vfs_entry_t* vfs = get_vfs_for_fd(fd);
+    const int local_fd = get_local_fd(vfs, fd);
+    struct _reent* r = __getreent();
+    if (vfs == NULL || local_fd < 0) {
+        __errno_r(r) = EBADF;
+        return -1;
+    }
+    if (offset < 0) {
+        __errno_r(r) = EINVAL;
+        return -1;
+    }
+    if (vfs->vfs.pwrite == NULL) {
+        return transfer_at(r, vfs, local_fd, (void *) src, size, offset, true);
+    }
+    ssize_t ret;
+    CHECK_AND_CALL(ret, r, vfs, pwrite, local_fd, src, size, offset);
+    return ret;
+}
+
+ssize_t esp_vfs_readv(int fd, const struct iovec * iov, int iovcnt)
+{
+    const vfs_entry_t* vfs = get_vfs_for_fd(fd);
+    const int local_fd = get_local_fd(vfs, fd);
+    struct _reent* r = __getreent();
+    if (vfs == NULL || local_fd < 0) {
+        __errno_r(r) = EBADF;
+        return -1;
+    }
+    if (iovcnt < 0 || (iov == NULL && iovcnt > 0)) {
+        __errno_r(r) = EINVAL;
+        return -1;
+    }
+    if (vfs->vfs.readv == NULL) {
+        return transfer_iov(r, vfs, local_fd, iov, iovcnt, false);
+    }
+    ssize_t ret;
+    CHECK_AND_CALL(ret, r, vfs, readv, local_fd, iov, iovcnt);
+    return ret;
+}
+
+ssize_t esp_vfs_writev(int fd, const struct iovec * iov, int iovcnt)
+{
+    const vfs_entry_t* vfs = get_vfs_for_fd(fd);
+    const int local_fd = get_local_fd(vfs, fd);
+    struct _reent* r = __getreent();
+    if (vfs == NULL || local_fd < 0) {
+        __errno_r(r) = EBADF;
+        return -1;
+    }
+    if (iovcnt < 0 || (iov == NULL && iovcnt > 0)) {
+        __errno_r(r) = EINVAL;
+        return -1;
+    }
+    if (vfs->vfs.writev == NULL) {
+        return transfer_iov(r, vfs, local_fd, iov, iovcnt, true);
+    }
+    ssize_t ret;
+    CHECK_AND_CALL(ret, r, vfs, writev, local_fd, iov, iovcnt);
+    return ret;
+}
+
+ssize_t pread(int fd, void *dst, size_t size, off_t offset)
+{
+    return esp_vfs_pread(fd, dst, size, offset);
+}
+
+ssize_t pwrite(int fd, const void *src, size_t size, off_t offset)
+{
+    return esp_vfs_pwrite(fd, src, size, offset);
+}
+
 static void call_end_selects(int end_index, const fds_triple_t *vfs_fds_triple)
 {
     for (int i = 0; i < end_index; ++i) {
@@ -1003,6 +1191,246 @@ void esp_vfs_select_triggered_isr(SemaphoreHandle_t *signal_sem, BaseType_t *wok
     }
 }
 
+/* Interest set of esp_vfs_epoll_*(). The observed FDs are kept translated to local FD sets
+ * of their VFS drivers (and global FD sets for socket FDs, as in esp_vfs_select()), so that
+ * esp_vfs_epoll_wait() only copies them instead of going through all FDs. */
+typedef struct {
+    int8_t vfs_index;       // VFS of the FD, -1 if the FD is not observed
+    local_fd_t local_fd;    // FD within the VFS
+    uint8_t events;         // observed ESP_VFS_EPOLL* events
+    bool is_socket;         // the FD belongs to the socket VFS
+    local_fd_t position;    // index of the FD in esp_vfs_epoll.observed
+} epoll_item_t;
+
+struct esp_vfs_epoll {
+    _lock_t lock;
+    epoll_item_t items[MAX_FDS];                        // indexed by global FD
+    local_fd_t observed[MAX_FDS];                       // observed global FDs, in no particular order
+    size_t observed_count;
+    uint8_t vfs_fd_count[VFS_MAX_COUNT];                // number of observed FDs of each VFS
+    fds_triple_t vfs_fds[VFS_MAX_COUNT];                // observed local FDs of each non-socket VFS
+    fds_triple_t socket_fds;                            // observed socket FDs
+    size_t socket_fd_count;
+    int (*socket_select)(int, fd_set *, fd_set *, fd_set *, struct timeval *);
+    int nfds;                                           // upper bound of observed global and local FDs
+    SemaphoreHandle_t sem;                              // used for waiting when no socket FD is observed
+};
+
+static void epoll_fds_update(fds_triple_t *fds, int fd, uint32_t events)
+{
+    if (events & ESP_VFS_EPOLLIN) {
+        FD_SET(fd, &fds->readfds);
+    } else {
+        FD_CLR(fd, &fds->readfds);
+    }
+    if (events & ESP_VFS_EPOLLOUT) {
+        FD_SET(fd, &fds->writefds);
+    } else {
+        FD_CLR(fd, &fds->writefds);
+    }
+    if (events & ESP_VFS_EPOLLERR) {
+        FD_SET(fd, &fds->errorfds);
+    } else {
+        FD_CLR(fd, &fds->errorfds);
+    }
+}
+
+esp_err_t esp_vfs_epoll_create(esp_vfs_epoll_handle_t *handle)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_vfs_epoll_handle_t epoll = calloc(1, sizeof(struct esp_vfs_epoll));
+    if (epoll == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if ((epoll->sem = xSemaphoreCreateBinary()) == NULL) {
+        free(epoll);
+        return ESP_ERR_NO_MEM;
+    }
+    for (int fd = 0; fd < MAX_FDS; ++fd) {
+        epoll->items[fd].vfs_index = -1;
+    }
+
+    *handle = epoll;
+    return ESP_OK;
+}
+
+esp_err_t esp_vfs_epoll_delete(esp_vfs_epoll_handle_t handle)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    vSemaphoreDelete(handle->sem);
+    _lock_close(&handle->lock);
+    free(handle);
+    return ESP_OK;
+}
+
+esp_err_t esp_vfs_epoll_ctl(esp_vfs_epoll_handle_t handle, int op, int fd, uint32_t events)
+{
+    if (handle == NULL || !fd_valid(fd) ||
+            (events & ~(ESP_VFS_EPOLLIN | ESP_VFS_EPOLLOUT | ESP_VFS_EPOLLERR)) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (op != ESP_VFS_EPOLL_CTL_ADD && op != ESP_VFS_EPOLL_CTL_MOD && op != ESP_VFS_EPOLL_CTL_DEL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    _lock_acquire(&s_fd_table_lock);
+    const bool is_socket_fd = s_fd_table[fd].permanent;
+    const int vfs_index = s_fd_table[fd].vfs_index;
+    const int local_fd = s_fd_table[fd].local_fd;
+    _lock_release(&s_fd_table_lock);
+
+    if (vfs_index < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_OK;
+    _lock_acquire(&handle->lock);
+    epoll_item_t *item = &handle->items[fd];
+
+    if ((op == ESP_VFS_EPOLL_CTL_ADD) != (item->vfs_index < 0)) {
+        ret = ESP_ERR_INVALID_STATE;
+    } else if (op == ESP_VFS_EPOLL_CTL_ADD) {
+        item->vfs_index = vfs_index;
+        item->local_fd = local_fd;
+        item->is_socket = is_socket_fd;
+        item->position = handle->observed_count;
+        handle->observed[handle->observed_count++] = fd;
+        ++handle->vfs_fd_count[vfs_index];
+        if (is_socket_fd) {
+            ++handle->socket_fd_count;
+            handle->socket_select = s_vfs[vfs_index]->vfs.socket_select;
+        }
+        handle->nfds = MAX(handle->nfds, MAX(fd, local_fd) + 1);
+    } else if (op == ESP_VFS_EPOLL_CTL_DEL) {
+        events = 0;
+        // move the last observed FD into the place of the removed one
+        const int last_fd = handle->observed[--handle->observed_count];
+        handle->observed[item->position] = last_fd;
+        handle->items[last_fd].position = item->position;
+        --handle->vfs_fd_count[item->vfs_index];
+        if (item->is_socket) {
+            --handle->socket_fd_count;
+        }
+    }
+
+    if (ret == ESP_OK) {
+        // socket FDs are observed through their global FD, as socket_select() works with those
+        if (item->is_socket) {
+            epoll_fds_update(&handle->socket_fds, fd, events);
+            handle->socket_fds.isset = handle->socket_fd_count > 0;
+        } else {
+            fds_triple_t *vfs_fds = &handle->vfs_fds[item->vfs_index];
+            epoll_fds_update(vfs_fds, item->local_fd, events);
+            vfs_fds->isset = handle->vfs_fd_count[item->vfs_index] > 0;
+        }
+        item->events = events;
+        if (op == ESP_VFS_EPOLL_CTL_DEL) {
+            item->vfs_index = -1;
+        }
+    }
+    _lock_release(&handle->lock);
+
+    ESP_LOGD(TAG, "esp_vfs_epoll_ctl(%p, %d, %d, 0x%x) finished with %s", handle, op, fd, events, esp_err_to_name(ret));
+
+    return ret;
+}
+
+int esp_vfs_epoll_wait(esp_vfs_epoll_handle_t handle, esp_vfs_epoll_event_t *events, int max_events, int timeout)
+{
+    struct _reent* r = __getreent();
+
+    if (handle == NULL || events == NULL || max_events <= 0) {
+        __errno_r(r) = EINVAL;
+        return -1;
+    }
+
+    // The drivers report ready FDs by updating the FD sets, so they work on a copy
+    fds_triple_t vfs_fds[VFS_MAX_COUNT];
+    fds_triple_t socket_fds;
+
+    _lock_acquire(&handle->lock);
+    memcpy(vfs_fds, handle->vfs_fds, sizeof(vfs_fds));
+    socket_fds = handle->socket_fds;
+    const int nfds = handle->nfds;
+    int (*socket_select)(int, fd_set *, fd_set *, fd_set *, struct timeval *) =
+        socket_fds.isset ? handle->socket_select : NULL;
+    _lock_release(&handle->lock);
+
+    /* As in esp_vfs_select(), the semaphore is used only when socket_select() is not,
+     * otherwise the drivers interrupt socket_select() through the socket VFS. */
+    SemaphoreHandle_t select_sem = socket_select ? NULL : handle->sem;
+    if (select_sem) {
+        // drop a notification which arrived after the previous wait was finished
+        xSemaphoreTake(select_sem, 0);
+    }
+
+    for (int i = 0; i < s_vfs_count; ++i) {
+        const vfs_entry_t *vfs = get_vfs_for_index(i);
+        fds_triple_t *item = &vfs_fds[i];
+
+        if (vfs && vfs->vfs.start_select && item->isset) {
+            esp_err_t err = vfs->vfs.start_select(nfds, &item->readfds, &item->writefds, &item->errorfds, &select_sem);
+
+            if (err != ESP_OK) {
+                call_end_selects(i, vfs_fds);
+                __errno_r(r) = EINTR;
+                ESP_LOGD(TAG, "start_select failed");
+                return -1;
+            }
+        }
+    }
+
+    int ret = 0;
+    if (socket_select) {
+        struct timeval tv = {
+            .tv_sec = timeout / 1000,
+            .tv_usec = (timeout % 1000) * 1000,
+        };
+        ret = socket_select(nfds, &socket_fds.readfds, &socket_fds.writefds, &socket_fds.errorfds, timeout < 0 ? NULL : &tv);
+    } else {
+        xSemaphoreTake(select_sem, timeout < 0 ? portMAX_DELAY : timeout / portTICK_PERIOD_MS);
+    }
+
+    call_end_selects(s_vfs_count, vfs_fds);
+    if (ret < 0) {
+        return -1;
+    }
+
+    int count = 0;
+    _lock_acquire(&handle->lock);
+    for (size_t i = 0; i < handle->observed_count && count < max_events; ++i) {
+        const int fd = handle->observed[i];
+        const epoll_item_t *item = &handle->items[fd];
+        const fds_triple_t *ready = item->is_socket ? &socket_fds : &vfs_fds[item->vfs_index];
+        const int ready_fd = item->is_socket ? fd : item->local_fd;
+        uint32_t ready_events = 0;
+        if ((item->events & ESP_VFS_EPOLLIN) && FD_ISSET(ready_fd, &ready->readfds)) {
+            ready_events |= ESP_VFS_EPOLLIN;
+        }
+        if ((item->events & ESP_VFS_EPOLLOUT) && FD_ISSET(ready_fd, &ready->writefds)) {
+            ready_events |= ESP_VFS_EPOLLOUT;
+        }
+        if ((item->events & ESP_VFS_EPOLLERR) && FD_ISSET(ready_fd, &ready->errorfds)) {
+            ready_events |= ESP_VFS_EPOLLERR;
+        }
+        if (ready_events) {
+            events[count].fd = fd;
+            events[count].events = ready_events;
+            ++count;
+        }
+    }
+    _lock_release(&handle->lock);
+
+    ESP_LOGD(TAG, "esp_vfs_epoll_wait returns %d", count);
+    return count;
+}
+
 #ifdef CONFIG_SUPPORT_TERMIOS
 int tcgetattr(int fd, struct termios *p)
 {
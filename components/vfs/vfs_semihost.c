@@ -12,12 +12,14 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <stdarg.h>
 #include <sys/errno.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <sys/lock.h>
 #include "soc/cpu.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -44,6 +46,22 @@ typedef struct {
 
 static vfs_semihost_ctx_t s_semhost_ctx[CONFIG_SEMIHOSTFS_MAX_MOUNT_POINTS];
 
+#if CONFIG_SEMIHOSTFS_BUFFER_SIZE > 0
+#define SEMIHOST_BUFFER_SIZE    CONFIG_SEMIHOSTFS_BUFFER_SIZE
+
+typedef struct {
+    int fd;             /* host file descriptor */
+    uint8_t *buf;       /* NULL if the entry is free */
+    size_t len;         /* bytes in buf, read ahead or (if dirty) to be written */
+    size_t pos;         /* position of the next read in buf */
+    bool dirty;
+    _lock_t lock;
+} vfs_semihost_file_t;
+
+static vfs_semihost_file_t s_files[CONFIG_SEMIHOSTFS_MAX_BUFFERED_FILES];
+static _lock_t s_files_lock;
+#endif
+
 
 static inline int generic_syscall(int sys_nr, int arg1, int arg2, int arg3, int arg4, int* ret_errno)
 {
@@ -79,6 +97,212 @@ inline bool ctx_uses_abspath(const vfs_semihost_ctx_t* ctx)
     return ctx->host_path[0];
 }
 
+static ssize_t host_write(int fd, const void * data, size_t size)
+{
+    int host_err = 0;
+    int ret = generic_syscall(SYS_WRITE, fd, (int)data, size, 0, &host_err);
+    if (ret == -1) {
+        errno = host_err;
+    }
+    return ret;
+}
+
+static ssize_t host_read(int fd, void * data, size_t size)
+{
+    int host_err = 0;
+    int ret = generic_syscall(SYS_READ, fd, (int)data, size, 0, &host_err);
+    if (ret == -1) {
+        errno = host_err;
+    }
+    return ret;
+}
+
+static off_t host_lseek(int fd, off_t offset, int mode)
+{
+    int host_err = 0;
+    int ret = generic_syscall(SYS_SEEK, fd, offset, mode, 0, &host_err);
+    if (ret == -1) {
+        errno = host_err;
+    }
+    return ret;
+}
+
+#if CONFIG_SEMIHOSTFS_BUFFER_SIZE > 0
+static void file_add(int fd)
+{
+    uint8_t *buf = malloc(SEMIHOST_BUFFER_SIZE);
+    if (buf == NULL) {
+        ESP_LOGD(TAG, "no memory to buffer %d", fd);
+        return;
+    }
+    _lock_acquire(&s_files_lock);
+    for (int i = 0; i < CONFIG_SEMIHOSTFS_MAX_BUFFERED_FILES; i++) {
+        vfs_semihost_file_t *file = &s_files[i];
+        if (file->buf == NULL) {
+            file->fd = fd;
+            file->len = 0;
+            file->pos = 0;
+            file->dirty = false;
+            file->buf = buf;
+            buf = NULL;
+            break;
+        }
+    }
+    _lock_release(&s_files_lock);
+    /* all entries are used, the file is not buffered */
+    free(buf);
+}
+
+/* Returns the locked entry of a buffered file, NULL if the file is not buffered */
+static vfs_semihost_file_t *file_get(int fd)
+{
+    vfs_semihost_file_t *found = NULL;
+
+    _lock_acquire(&s_files_lock);
+    for (int i = 0; i < CONFIG_SEMIHOSTFS_MAX_BUFFERED_FILES; i++) {
+        if (s_files[i].buf != NULL && s_files[i].fd == fd) {
+            found = &s_files[i];
+            break;
+        }
+    }
+    _lock_release(&s_files_lock);
+    if (found != NULL) {
+        _lock_acquire(&found->lock);
+    }
+    return found;
+}
+
+static void file_put(vfs_semihost_file_t *file)
+{
+    _lock_release(&file->lock);
+}
+
+/* Writes the write-behind data */
+static int file_flush(vfs_semihost_file_t *file)
+{
+    if (!file->dirty) {
+        return 0;
+    }
+    size_t len = file->len;
+    file->dirty = false;
+    file->len = 0;
+    ssize_t ret = host_write(file->fd, file->buf, len);
+    if (ret == -1) {
+        return -1;
+    }
+    if (ret != len) {
+        errno = EIO;
+        return -1;
+    }
+    return 0;
+}
+
+/* Moves the host file position back to the first byte read ahead but not read */
+static int file_drop_read_ahead(vfs_semihost_file_t *file)
+{
+    size_t unread = file->len - file->pos;
+
+    file->len = 0;
+    file->pos = 0;
+    if (unread != 0 && host_lseek(file->fd, -(off_t)unread, SEEK_CUR) == -1) {
+        return -1;
+    }
+    return 0;
+}
+
+static ssize_t file_write(vfs_semihost_file_t *file, const void * data, size_t size)
+{
+    if (!file->dirty && file_drop_read_ahead(file) != 0) {
+        return -1;
+    }
+    if (file->len + size > SEMIHOST_BUFFER_SIZE && file_flush(file) != 0) {
+        return -1;
+    }
+    if (size >= SEMIHOST_BUFFER_SIZE) {
+        return host_write(file->fd, data, size);
+    }
+    memcpy(file->buf + file->len, data, size);
+    file->len += size;
+    file->dirty = true;
+    return size;
+}
+
+static ssize_t file_read(vfs_semihost_file_t *file, void * data, size_t size)
+{
+    if (file->dirty && file_flush(file) != 0) {
+        return -1;
+    }
+    size_t done = file->len - file->pos;
+    if (done > size) {
+        done = size;
+    }
+    memcpy(data, file->buf + file->pos, done);
+    file->pos += done;
+    if (done == size) {
+        return done;
+    }
+
+    /* the buffer is empty */
+    size_t rest = size - done;
+    file->len = 0;
+    file->pos = 0;
+    ssize_t ret;
+    if (rest >= SEMIHOST_BUFFER_SIZE) {
+        ret = host_read(file->fd, (uint8_t *) data + done, rest);
+    } else {
+        ret = host_read(file->fd, file->buf, SEMIHOST_BUFFER_SIZE);
+        if (ret > 0) {
+            file->len = ret;
+            file->pos = (ret < rest) ? ret : rest;
+            memcpy((uint8_t *) data + done, file->buf, file->pos);
+            ret = file->pos;
+        }
+    }
+    if (ret == -1) {
+        /* report the error on the next call if some data was read */
+        return (done != 0) ? done : -1;
+    }
+    return done + ret;
+}
+
+static off_t file_lseek(vfs_semihost_file_t *file, off_t offset, int mode)
+{
+    if (mode == SEEK_CUR && offset == 0) {
+        /* ftell(), keep the buffer */
+        off_t pos = host_lseek(file->fd, 0, SEEK_CUR);
+        if (pos == -1) {
+            return -1;
+        }
+        return file->dirty ? pos + file->len : pos - (file->len - file->pos);
+    }
+    if (file->dirty) {
+        if (file_flush(file) != 0) {
+            return -1;
+        }
+    } else {
+        if (mode == SEEK_CUR) {
+            offset -= file->len - file->pos;
+        }
+        file->len = 0;
+        file->pos = 0;
+    }
+    return host_lseek(file->fd, offset, mode);
+}
+
+static int vfs_semihost_fsync(void* ctx, int fd)
+{
+    int ret = 0;
+
+    ESP_LOGV(TAG, "%s: %d", __func__, fd);
+    vfs_semihost_file_t *file = file_get(fd);
+    if (file != NULL) {
+        ret = file_flush(file);
+        file_put(file);
+    }
+    return ret;
+}
+#endif // CONFIG_SEMIHOSTFS_BUFFER_SIZE > 0
+
 static int vfs_semihost_open(void* ctx, const char * path, int flags, int mode)
 {
     int fd = -1, host_err = 0;
@@ -105,57 +329,83 @@ static int vfs_semihost_open(void* ctx, const char * path, int flags, int mode)
     if (fd == -1) {
         errno = host_err;
     }
+#if CONFIG_SEMIHOSTFS_BUFFER_SIZE > 0
+    else {
+        file_add(fd);
+    }
+#endif
     return fd;
 }
 
 static ssize_t vfs_semihost_write(void* ctx, int fd, const void * data, size_t size)
 {
-    int host_err = 0;
-    size_t ret = -1;
-
     ESP_LOGV(TAG, "%s: %d %u bytes", __func__, fd, size);
-    ret = generic_syscall(SYS_WRITE, fd, (int)data, size, 0, &host_err);
-    if (ret == -1) {
-        errno = host_err;
+#if CONFIG_SEMIHOSTFS_BUFFER_SIZE > 0
+    vfs_semihost_file_t *file = file_get(fd);
+    if (file != NULL) {
+        ssize_t ret = file_write(file, data, size);
+        file_put(file);
+        return ret;
     }
-    return (ssize_t)ret;
+#endif
+    return host_write(fd, data, size);
 }
 
 static ssize_t vfs_semihost_read(void* ctx, int fd, void* data, size_t size)
 {
-    int host_err = 0;
-    size_t ret = -1;
-
     ESP_LOGV(TAG, "%s: %d %u bytes", __func__, fd, size);
-    ret = generic_syscall(SYS_READ, fd, (int)data, size, 0, &host_err);
-    if (ret == -1) {
-        errno = host_err;
+#if CONFIG_SEMIHOSTFS_BUFFER_SIZE > 0
+    vfs_semihost_file_t *file = file_get(fd);
+    if (file != NULL) {
+        ssize_t ret = file_read(file, data, size);
+        file_put(file);
+        return ret;
     }
-    return (ssize_t)ret;
+#endif
+    return host_read(fd, data, size);
 }
 
 static int vfs_semihost_close(void* ctx, int fd)
 {
-    int ret = -1, host_err = 0;
+    int ret = -1, host_err = 0, flush_ret = 0, flush_errno = 0;
 
     ESP_LOGV(TAG, "%s: %d", __func__, fd);
+#if CONFIG_SEMIHOSTFS_BUFFER_SIZE > 0
+    vfs_semihost_file_t *file = file_get(fd);
+    if (file != NULL) {
+        flush_ret = file_flush(file);
+        flush_errno = errno;
+        uint8_t *buf = file->buf;
+        _lock_acquire(&s_files_lock);
+        file->buf = NULL;
+        _lock_release(&s_files_lock);
+        file_put(file);
+        free(buf);
+    }
+#endif
     ret = generic_syscall(SYS_CLOSE, fd, 0, 0, 0, &host_err);
     if (ret == -1) {
         errno = host_err;
+    } else if (flush_ret == -1) {
+        /* the file is closed, but the buffered data could not be written */
+        errno = flush_errno;
+        ret = -1;
     }
     return ret;
 }
 
 static off_t vfs_semihost_lseek(void* ctx, int fd, off_t size, int mode)
 {
-    int ret = -1, host_err = 0;
-
     ESP_LOGV(TAG, "%s: %d %ld %d", __func__, fd, size, mode);
-    ret = generic_syscall(SYS_SEEK, fd, size, mode, 0, &host_err);
-    if (ret == -1) {
-        errno = host_err;
+#if CONFIG_SEMIHOSTFS_BUFFER_SIZE > 0
+    vfs_semihost_file_t *file = file_get(fd);
+    if (file != NULL) {
+        off_t ret = file_lseek(file, size, mode);
+        file_put(file);
+        return ret;
     }
-    return (off_t)ret;
+#endif
+    return host_lseek(fd, size, mode);
 }
 
 esp_err_t esp_vfs_semihost_register(const char* base_path, const char* host_path)
@@ -167,6 +417,9 @@ esp_err_t esp_vfs_semihost_register(const char* base_path, const char* host_path
         .close_p = &vfs_semihost_close,
         .read_p = &vfs_semihost_read,
         .lseek_p = &vfs_semihost_lseek,
+#if CONFIG_SEMIHOSTFS_BUFFER_SIZE > 0
+        .fsync_p = &vfs_semihost_fsync,
+#endif
     };
     ESP_LOGD(TAG, "Register semihosting driver '%s' -> '%s'", base_path, host_path ? host_path : "null");
     if (!esp_cpu_in_ocd_debug_mode()) {
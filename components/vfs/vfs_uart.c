@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <string.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <stdarg.h>
 #include <sys/errno.h>
@@ -22,6 +23,10 @@
 #include "esp_vfs.h"
 #include "esp_vfs_dev.h"
 #include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/ringbuf.h"
 #include "soc/uart_struct.h"
 #include "driver/uart.h"
 #include "sdkconfig.h"
@@ -34,10 +39,15 @@
 // Token signifying that no character is available
 #define NONE -1
 
+// Size of the chunks in which uart_write passes data to tx_block_func_t functions
+#define TX_CHUNK_SIZE 64
+
 // UART write bytes function type
 typedef void (*tx_func_t)(int, int);
 // UART read bytes function type
 typedef int (*rx_func_t)(int);
+// UART write block of bytes function type
+typedef void (*tx_block_func_t)(int, const char*, size_t);
 
 // Basic functions for sending and receiving bytes over UART
 static void uart_tx_char(int fd, int c);
@@ -46,6 +56,23 @@ static int uart_rx_char(int fd);
 // Functions for sending and receiving bytes which use UART driver
 static void uart_tx_char_via_driver(int fd, int c);
 static int uart_rx_char_via_driver(int fd);
+static void uart_tx_block_via_driver(int fd, const char* data, size_t size);
+
+// Function for sending bytes through the output buffer of esp_vfs_dev_uart_use_buffered
+static void uart_tx_block_buffered(int fd, const char* data, size_t size);
+
+// Output buffer of a UART, emptied into the UART driver by a task
+typedef struct {
+    int fd;
+    RingbufHandle_t ring;
+    TaskHandle_t task;
+    SemaphoreHandle_t drained;          // Given by the task after a flush or stop request
+    esp_vfs_uart_buffer_mode_t mode;
+    size_t size;
+    TickType_t flush_interval;
+    volatile bool flush_requested;
+    volatile bool stop_requested;
+} uart_tx_buffer_t;
 
 // Pointers to UART peripherals
 static uart_dev_t* s_uarts[UART_NUM] = {&UART0, &UART1, &UART2};
@@ -56,8 +83,13 @@ static _lock_t s_uart_write_locks[UART_NUM];
 static int s_peek_char[UART_NUM] = { NONE, NONE, NONE };
 // Per-UART non-blocking flag. Note: default implementation does not honor this
 // flag, all reads are non-blocking. This option becomes effective if UART
-// driver is used.
+// driver is used. Writes honor it only if output is buffered.
 static bool s_non_blocking[UART_NUM];
+// Per-UART output buffers, NULL unless esp_vfs_dev_uart_use_buffered was called.
+// Protected by s_uart_write_locks.
+static uart_tx_buffer_t* s_tx_buffers[UART_NUM];
+// Number of bytes dropped by non-blocking writes to a full output buffer
+static size_t s_tx_dropped[UART_NUM];
 
 /* Lock ensuring that uart_select is used from only one task at the time */
 static _lock_t s_one_select_lock;
@@ -103,6 +135,10 @@ static rx_func_t s_uart_rx_func[UART_NUM] = {
         &uart_rx_char, &uart_rx_char, &uart_rx_char
 };
 
+// Functions used to write blocks of bytes to UART. NULL if bytes are written
+// one by one using s_uart_tx_func, which is the default.
+static tx_block_func_t s_uart_tx_block_func[UART_NUM];
+
 
 static int uart_open(const char * path, int flags, int mode)
 {
@@ -141,6 +177,83 @@ static void uart_tx_char_via_driver(int fd, int c)
     uart_write_bytes(fd, &ch, 1);
 }
 
+static void uart_tx_block_via_driver(int fd, const char* data, size_t size)
+{
+    uart_write_bytes(fd, data, size);
+}
+
+static void uart_tx_block_buffered(int fd, const char* data, size_t size)
+{
+    uart_tx_buffer_t* buf = s_tx_buffers[fd];
+    if (xRingbufferSend(buf->ring, data, size, 0) != pdTRUE) {
+        if (s_non_blocking[fd]) {
+            s_tx_dropped[fd] += size;
+            return;
+        }
+        /* wake up the task to make room, then wait for it */
+        xTaskNotifyGive(buf->task);
+        xRingbufferSend(buf->ring, data, size, portMAX_DELAY);
+    }
+    if ((buf->mode == ESP_VFS_UART_BUFFER_LINE && memchr(data, '\n', size) != NULL) ||
+        (buf->mode == ESP_VFS_UART_BUFFER_BLOCK && xRingbufferGetCurFreeSize(buf->ring) < buf->size / 2)) {
+        xTaskNotifyGive(buf->task);
+    }
+}
+
+/* Empties the output buffer into the UART driver when notified by a writer and
+ * every flush_interval. Requests are checked before emptying the buffer, so that
+ * everything written before a request is sent when it is acknowledged.
+ */
+static void uart_flush_task(void* arg)
+{
+    uart_tx_buffer_t* buf = (uart_tx_buffer_t*) arg;
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, buf->flush_interval);
+        bool flush = buf->flush_requested;
+        bool stop = buf->stop_requested;
+        size_t size;
+        char* data;
+        while ((data = xRingbufferReceiveUpTo(buf->ring, &size, 0, buf->size)) != NULL) {
+            uart_write_bytes(buf->fd, data, size);
+            vRingbufferReturnItem(buf->ring, data);
+        }
+        if (stop) {
+            /* the buffer is freed as soon as the semaphore is given */
+            xSemaphoreGive(buf->drained);
+            vTaskDelete(NULL);
+        }
+        if (flush) {
+            buf->flush_requested = false;
+            xSemaphoreGive(buf->drained);
+        }
+    }
+}
+
+/* Waits until the output buffer is sent to the UART driver. Called with the write lock held. */
+static void uart_flush_buffered(int fd)
+{
+    uart_tx_buffer_t* buf = s_tx_buffers[fd];
+    buf->flush_requested = true;
+    xTaskNotifyGive(buf->task);
+    xSemaphoreTake(buf->drained, portMAX_DELAY);
+}
+
+/* Sends the output buffer and frees it. Called with the write lock held. */
+static void uart_stop_buffered(int fd)
+{
+    uart_tx_buffer_t* buf = s_tx_buffers[fd];
+    if (buf == NULL) {
+        return;
+    }
+    buf->stop_requested = true;
+    xTaskNotifyGive(buf->task);
+    xSemaphoreTake(buf->drained, portMAX_DELAY);
+    s_tx_buffers[fd] = NULL;
+    vRingbufferDelete(buf->ring);
+    vSemaphoreDelete(buf->drained);
+    free(buf);
+}
+
 static int uart_rx_char(int fd)
 {
     uart_dev_t* uart = s_uarts[fd];
@@ -170,15 +283,43 @@ static ssize_t uart_write(int fd, const void * data, size_t size)
      *  same UART.
      */
     _lock_acquire_recursive(&s_uart_write_locks[fd]);
-    for (size_t i = 0; i < size; i++) {
-        int c = data_c[i];
-        if (c == '\n' && s_tx_mode != ESP_LINE_ENDINGS_LF) {
-            s_uart_tx_func[fd](fd, '\r');
-            if (s_tx_mode == ESP_LINE_ENDINGS_CR) {
-                continue;
+    tx_block_func_t tx_block_func = s_uart_tx_block_func[fd];
+    if (tx_block_func == NULL) {
+        for (size_t i = 0; i < size; i++) {
+            int c = data_c[i];
+            if (c == '\n' && s_tx_mode != ESP_LINE_ENDINGS_LF) {
+                s_uart_tx_func[fd](fd, '\r');
+                if (s_tx_mode == ESP_LINE_ENDINGS_CR) {
+                    continue;
+                }
             }
+            s_uart_tx_func[fd](fd, c);
+        }
+    } else if (s_tx_mode == ESP_LINE_ENDINGS_LF) {
+        for (size_t i = 0; i < size; i += TX_CHUNK_SIZE) {
+            tx_block_func(fd, data_c + i, MIN(size - i, TX_CHUNK_SIZE));
+        }
+    } else {
+        /* convert line endings into chunks */
+        char chunk[TX_CHUNK_SIZE];
+        size_t len = 0;
+        for (size_t i = 0; i < size; i++) {
+            char c = data_c[i];
+            if (len + 2 > sizeof(chunk)) {
+                tx_block_func(fd, chunk, len);
+                len = 0;
+            }
+            if (c == '\n') {
+                chunk[len++] = '\r';
+                if (s_tx_mode == ESP_LINE_ENDINGS_CR) {
+                    continue;
+                }
+            }
+            chunk[len++] = c;
+        }
+        if (len > 0) {
+            tx_block_func(fd, chunk, len);
         }
-        s_uart_tx_func[fd](fd, c);
     }
     _lock_release_recursive(&s_uart_write_locks[fd]);
     return size;
@@ -206,12 +347,74 @@ static void uart_return_char(int fd, int c)
     s_peek_char[fd] = c;
 }
 
-static ssize_t uart_read(int fd, void* data, size_t size)
+/* Reads the data available in the ring buffer of the UART driver at once, then
+ * converts line endings in place. Waits for the first byte unless the UART is
+ * non-blocking. Called with the read lock held.
+ */
+static size_t uart_read_via_driver(int fd, char* data, size_t size)
+{
+    size_t len = 0;
+    if (s_peek_char[fd] != NONE) {
+        data[len++] = (char) s_peek_char[fd];
+        s_peek_char[fd] = NONE;
+    } else if (uart_read_bytes(fd, (uint8_t*) data, 1, s_non_blocking[fd] ? 0 : portMAX_DELAY) == 1) {
+        ++len;
+    } else {
+        return 0;
+    }
+    size_t available = 0;
+    uart_get_buffered_data_len(fd, &available);
+    available = MIN(available, size - len);
+    if (available > 0) {
+        int n = uart_read_bytes(fd, (uint8_t*) data + len, available, 0);
+        if (n > 0) {
+            len += n;
+        }
+    }
+    if (s_rx_mode[fd] == ESP_LINE_ENDINGS_LF) {
+        return len;
+    }
+
+    size_t received = 0;
+    for (size_t i = 0; i < len; ++i) {
+        char c = data[i];
+        if (c == '\r' && s_rx_mode[fd] == ESP_LINE_ENDINGS_CR) {
+            c = '\n';
+        } else if (c == '\r') {
+            /* look ahead, reading one more byte if this is the last one */
+            int c2 = NONE;
+            if (i + 1 < len) {
+                c2 = data[i + 1];
+            } else {
+                uint8_t next;
+                if (uart_read_bytes(fd, &next, 1, 0) == 1) {
+                    c2 = next;
+                }
+                if (c2 == NONE) {
+                    /* could not look ahead, put the current character back */
+                    uart_return_char(fd, c);
+                    break;
+                }
+                if (c2 != '\n') {
+                    /* \r followed by something else, processed by the next read */
+                    uart_return_char(fd, c2);
+                }
+            }
+            if (c2 == '\n') {
+                /* this was \r\n sequence. discard \r, return \n */
+                c = '\n';
+                ++i;
+            }
+        }
+        data[received++] = c;
+    }
+    return received;
+}
+
+/* Reads characters one by one until a newline. Called with the read lock held. */
+static size_t uart_read_by_char(int fd, char* data_c, size_t size)
 {
-    assert(fd >=0 && fd < 3);
-    char *data_c = (char *) data;
     size_t received = 0;
-    _lock_acquire_recursive(&s_uart_read_locks[fd]);
     while (received < size) {
         int c = uart_read_char(fd);
         if (c == '\r') {
@@ -244,6 +447,19 @@ static ssize_t uart_read(int fd, void* data, size_t size)
             break;
         }
     }
+    return received;
+}
+
+static ssize_t uart_read(int fd, void* data, size_t size)
+{
+    assert(fd >=0 && fd < 3);
+    size_t received;
+    _lock_acquire_recursive(&s_uart_read_locks[fd]);
+    if (s_uart_rx_func[fd] == uart_rx_char_via_driver) {
+        received = uart_read_via_driver(fd, (char *) data, size);
+    } else {
+        received = uart_read_by_char(fd, (char *) data, size);
+    }
     _lock_release_recursive(&s_uart_read_locks[fd]);
     if (received > 0) {
         return received;
@@ -308,7 +524,12 @@ static int uart_fsync(int fd)
 {
     assert(fd >= 0 && fd < 3);
     _lock_acquire_recursive(&s_uart_write_locks[fd]);
-    uart_tx_wait_idle((uint8_t) fd);
+    if (s_tx_buffers[fd] != NULL) {
+        uart_flush_buffered(fd);
+        uart_wait_tx_done(fd, portMAX_DELAY);
+    } else {
+        uart_tx_wait_idle((uint8_t) fd);
+    }
     _lock_release_recursive(&s_uart_write_locks[fd]);
     return 0;
 }
@@ -863,6 +1084,12 @@ static int uart_tcdrain(int fd)
         return -1;
     }
 
+    _lock_acquire_recursive(&s_uart_write_locks[fd]);
+    if (s_tx_buffers[fd] != NULL) {
+        uart_flush_buffered(fd);
+    }
+    _lock_release_recursive(&s_uart_write_locks[fd]);
+
     if (uart_wait_tx_done(fd, portMAX_DELAY) != ESP_OK) {
         errno = EINVAL;
         return -1;
@@ -933,8 +1160,10 @@ void esp_vfs_dev_uart_use_nonblocking(int uart_num)
 {
     _lock_acquire_recursive(&s_uart_read_locks[uart_num]);
     _lock_acquire_recursive(&s_uart_write_locks[uart_num]);
+    uart_stop_buffered(uart_num);
     s_uart_tx_func[uart_num] = uart_tx_char;
     s_uart_rx_func[uart_num] = uart_rx_char;
+    s_uart_tx_block_func[uart_num] = NULL;
     _lock_release_recursive(&s_uart_write_locks[uart_num]);
     _lock_release_recursive(&s_uart_read_locks[uart_num]);
 }
@@ -943,8 +1172,70 @@ void esp_vfs_dev_uart_use_driver(int uart_num)
 {
     _lock_acquire_recursive(&s_uart_read_locks[uart_num]);
     _lock_acquire_recursive(&s_uart_write_locks[uart_num]);
+    uart_stop_buffered(uart_num);
     s_uart_tx_func[uart_num] = uart_tx_char_via_driver;
     s_uart_rx_func[uart_num] = uart_rx_char_via_driver;
+    s_uart_tx_block_func[uart_num] = uart_tx_block_via_driver;
     _lock_release_recursive(&s_uart_write_locks[uart_num]);
     _lock_release_recursive(&s_uart_read_locks[uart_num]);
 }
+
+esp_err_t esp_vfs_dev_uart_use_buffered(int uart_num, const esp_vfs_dev_uart_buffered_config_t* config)
+{
+    if (uart_num < 0 || uart_num >= UART_NUM || config == NULL ||
+        config->buffer_size < 2 * TX_CHUNK_SIZE ||
+        (config->mode != ESP_VFS_UART_BUFFER_LINE && config->mode != ESP_VFS_UART_BUFFER_BLOCK)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uart_tx_buffer_t* buf = calloc(1, sizeof(uart_tx_buffer_t));
+    if (buf == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    buf->fd = uart_num;
+    buf->mode = config->mode;
+    buf->size = config->buffer_size;
+    buf->flush_interval = config->flush_interval_ms ? config->flush_interval_ms / portTICK_PERIOD_MS : portMAX_DELAY;
+    if (buf->flush_interval == 0) {
+        buf->flush_interval = 1;
+    }
+    buf->ring = xRingbufferCreate(config->buffer_size, RINGBUF_TYPE_BYTEBUF);
+    buf->drained = xSemaphoreCreateBinary();
+    if (buf->ring == NULL || buf->drained == NULL) {
+        goto fail;
+    }
+
+    _lock_acquire_recursive(&s_uart_read_locks[uart_num]);
+    _lock_acquire_recursive(&s_uart_write_locks[uart_num]);
+    uart_stop_buffered(uart_num);
+    if (xTaskCreate(uart_flush_task, "uart_flush", config->task_stack_size, buf,
+                    config->task_priority, &buf->task) != pdPASS) {
+        _lock_release_recursive(&s_uart_write_locks[uart_num]);
+        _lock_release_recursive(&s_uart_read_locks[uart_num]);
+        goto fail;
+    }
+    s_tx_buffers[uart_num] = buf;
+    s_uart_tx_func[uart_num] = uart_tx_char_via_driver;
+    s_uart_rx_func[uart_num] = uart_rx_char_via_driver;
+    s_uart_tx_block_func[uart_num] = uart_tx_block_buffered;
+    _lock_release_recursive(&s_uart_write_locks[uart_num]);
+    _lock_release_recursive(&s_uart_read_locks[uart_num]);
+    return ESP_OK;
+
+fail:
+    if (buf->ring) {
+        vRingbufferDelete(buf->ring);
+    }
+    if (buf->drained) {
+        vSemaphoreDelete(buf->drained);
+    }
+    free(buf);
+    return ESP_ERR_NO_MEM;
+}
+
+size_t esp_vfs_dev_uart_get_dropped_bytes(int uart_num)
+{
+    if (uart_num < 0 || uart_num >= UART_NUM) {
+        return 0;
+    }
+    return s_tx_dropped[uart_num];
+}
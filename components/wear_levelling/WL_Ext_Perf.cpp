@@ -80,22 +80,32 @@ esp_err_t WL_Ext_Perf::erase_sector_fit(uint32_t start_sector, uint32_t count)
 
     uint32_t pre_check_start = start_sector % this->size_factor;
 
-
-    for (int i = 0; i < this->size_factor; i++) {
-        if ((i < pre_check_start) || (i >= count + pre_check_start)) {
-            result = this->read(start_sector / this->size_factor * this->flash_sector_size + i * this->fat_sector_size, &this->sector_buffer[i * this->fat_sector_size / sizeof(uint32_t)], this->fat_sector_size);
-            WL_EXT_RESULT_CHECK(result);
-        }
-    }
+    result = this->copy_kept_sectors(start_sector / this->size_factor, pre_check_start, count, false);
+    WL_EXT_RESULT_CHECK(result);
 
     result = WL_Flash::erase_sector(start_sector / this->size_factor); // erase comlete flash sector
     WL_EXT_RESULT_CHECK(result);
     // And write back only data that should not be erased...
-    for (int i = 0; i < this->size_factor; i++) {
-        if ((i < pre_check_start) || (i >= count + pre_check_start)) {
-            result = this->write(start_sector / this->size_factor * this->flash_sector_size + i * this->fat_sector_size, &this->sector_buffer[i * this->fat_sector_size / sizeof(uint32_t)], this->fat_sector_size);
-            WL_EXT_RESULT_CHECK(result);
+    result = this->copy_kept_sectors(start_sector / this->size_factor, pre_check_start, count, true);
+    WL_EXT_RESULT_CHECK(result);
+    return ESP_OK;
+}
+
+esp_err_t WL_Ext_Perf::copy_kept_sectors(uint32_t flash_sector, uint32_t first, uint32_t count, bool write_back)
+{
+    // Reads the fatfs sectors of a flash device sector which are not erased, [0, first) and
+    // [first + count, size_factor), into sector_buffer, or writes them back from there.
+    // Each of the two ranges is transferred in one access.
+    const uint32_t ranges[2][2] = {{0, first}, {first + count, this->size_factor}};
+    for (int i = 0; i < 2; i++) {
+        if (ranges[i][0] >= ranges[i][1]) {
+            continue;
         }
+        size_t addr = flash_sector * this->flash_sector_size + ranges[i][0] * this->fat_sector_size;
+        uint32_t *buff = &this->sector_buffer[ranges[i][0] * this->fat_sector_size / sizeof(uint32_t)];
+        size_t size = (ranges[i][1] - ranges[i][0]) * this->fat_sector_size;
+        esp_err_t result = write_back ? this->write(addr, buff, size) : this->read(addr, buff, size);
+        WL_EXT_RESULT_CHECK(result);
     }
     return ESP_OK;
 }
@@ -153,12 +163,10 @@ esp_err_t WL_Ext_Perf::erase_range(size_t start_address, size_t size)
     }
     ESP_LOGV(TAG, "%s rest_check_start = %i, pre_check_count=%i, rest_check_count=%i, post_check_count=%i\n", __func__, rest_check_start, pre_check_count, rest_check_count, post_check_count);
     if (rest_check_count > 0) {
+        // complete flash device sectors, erased as few ranges as the mapping allows
         rest_check_count = rest_check_count / this->size_factor;
-        size_t start_sector = rest_check_start / this->flash_sector_size;
-        for (size_t i = 0; i < rest_check_count; i++) {
-            result = WL_Flash::erase_sector(start_sector + i);
-            WL_EXT_RESULT_CHECK(result);
-        }
+        result = WL_Flash::erase_range(rest_check_start, rest_check_count * this->flash_sector_size);
+        WL_EXT_RESULT_CHECK(result);
     }
     if (post_check_count != 0) {
         result = this->erase_sector_fit(post_check_start, post_check_count);
@@ -526,6 +526,21 @@ size_t WL_Flash::calcAddr(size_t addr)
     return result;
 }
 
+size_t WL_Flash::calcAddrRun(size_t addr, size_t *run_size)
+{
+    // Same mapping as calcAddr. The addresses following addr map to the following flash
+    // addresses until the mapping reaches the dummy block or wraps around.
+    size_t result = (this->flash_size - this->state.move_count * this->cfg.page_size + addr) % this->flash_size;
+    size_t dummy_addr = this->state.pos * this->cfg.page_size;
+    if (result < dummy_addr) {
+        *run_size = dummy_addr - result;
+    } else {
+        *run_size = this->flash_size - result;
+        result += this->cfg.page_size;
+    }
+    return result;
+}
+
 
 size_t WL_Flash::chip_size()
 {
@@ -565,10 +580,36 @@ esp_err_t WL_Flash::erase_range(size_t start_address, size_t size)
     }
     ESP_LOGD(TAG, "%s - start_address= 0x%08x, size= 0x%08x", __func__, (uint32_t) start_address, (uint32_t) size);
     size_t erase_count = (size + this->cfg.sector_size - 1) / this->cfg.sector_size;
-    size_t start_sector = start_address / this->cfg.sector_size;
-    for (size_t i = 0; i < erase_count; i++) {
-        result = this->erase_sector(start_sector + i);
+    size_t sector = start_address / this->cfg.sector_size;
+    while (erase_count > 0) {
+        // Sectors which are contiguous in flash and don't reach the next dummy block move
+        // only update the access counter, and are erased in one go.
+        size_t count = 0;
+        size_t virt_addr = 0;
+        if (this->state.access_count + 1 < this->state.max_count) {
+            size_t run_size;
+            virt_addr = this->calcAddrRun(sector * this->cfg.sector_size, &run_size);
+            count = run_size / this->cfg.sector_size;
+            if (count > erase_count) {
+                count = erase_count;
+            }
+            if (count > this->state.max_count - 1 - this->state.access_count) {
+                count = this->state.max_count - 1 - this->state.access_count;
+            }
+        }
+        if (count == 0) {
+            // this access moves the dummy block, which changes the mapping
+            result = WL_Flash::erase_sector(sector);
+            WL_RESULT_CHECK(result);
+            sector++;
+            erase_count--;
+            continue;
+        }
+        this->state.access_count += count;
+        result = this->flash_drv->erase_range(this->cfg.start_addr + virt_addr, count * this->cfg.sector_size);
         WL_RESULT_CHECK(result);
+        sector += count;
+        erase_count -= count;
     }
     ESP_LOGV(TAG, "%s - result= 0x%08x", __func__, result);
     return result;
@@ -581,15 +622,18 @@ esp_err_t WL_Flash::write(size_t dest_addr, const void *src, size_t size)
         return ESP_ERR_INVALID_STATE;
     }
     ESP_LOGD(TAG, "%s - dest_addr= 0x%08x, size= 0x%08x", __func__, (uint32_t) dest_addr, (uint32_t) size);
-    uint32_t count = (size - 1) / this->cfg.page_size;
-    for (size_t i = 0; i < count; i++) {
-        size_t virt_addr = this->calcAddr(dest_addr + i * this->cfg.page_size);
-        result = this->flash_drv->write(this->cfg.start_addr + virt_addr, &((uint8_t *)src)[i * this->cfg.page_size], this->cfg.page_size);
+    // write the data in as few runs as the mapping allows
+    size_t offset = 0;
+    while (offset < size) {
+        size_t run_size;
+        size_t virt_addr = this->calcAddrRun(dest_addr + offset, &run_size);
+        if (run_size > size - offset) {
+            run_size = size - offset;
+        }
+        result = this->flash_drv->write(this->cfg.start_addr + virt_addr, &((uint8_t *)src)[offset], run_size);
         WL_RESULT_CHECK(result);
+        offset += run_size;
     }
-    size_t virt_addr_last = this->calcAddr(dest_addr + count * this->cfg.page_size);
-    result = this->flash_drv->write(this->cfg.start_addr + virt_addr_last, &((uint8_t *)src)[count * this->cfg.page_size], size - count * this->cfg.page_size);
-    WL_RESULT_CHECK(result);
     return result;
 }
 
@@ -600,16 +644,19 @@ esp_err_t WL_Flash::read(size_t src_addr, void *dest, size_t size)
         return ESP_ERR_INVALID_STATE;
     }
     ESP_LOGD(TAG, "%s - src_addr= 0x%08x, size= 0x%08x", __func__, (uint32_t) src_addr, (uint32_t) size);
-    uint32_t count = (size - 1) / this->cfg.page_size;
-    for (size_t i = 0; i < count; i++) {
-        size_t virt_addr = this->calcAddr(src_addr + i * this->cfg.page_size);
-        ESP_LOGV(TAG, "%s - real_addr= 0x%08x, size= 0x%08x", __func__, (uint32_t) (this->cfg.start_addr + virt_addr), (uint32_t) size);
-        result = this->flash_drv->read(this->cfg.start_addr + virt_addr, &((uint8_t *)dest)[i * this->cfg.page_size], this->cfg.page_size);
+    // read the data in as few runs as the mapping allows
+    size_t offset = 0;
+    while (offset < size) {
+        size_t run_size;
+        size_t virt_addr = this->calcAddrRun(src_addr + offset, &run_size);
+        if (run_size > size - offset) {
+            run_size = size - offset;
+        }
+        ESP_LOGV(TAG, "%s - real_addr= 0x%08x, size= 0x%08x", __func__, (uint32_t) (this->cfg.start_addr + virt_addr), (uint32_t) run_size);
+        result = this->flash_drv->read(this->cfg.start_addr + virt_addr, &((uint8_t *)dest)[offset], run_size);
         WL_RESULT_CHECK(result);
+        offset += run_size;
     }
-    size_t virt_addr_last = this->calcAddr(src_addr + count * this->cfg.page_size);
-    result = this->flash_drv->read(this->cfg.start_addr + virt_addr_last, &((uint8_t *)dest)[count * this->cfg.page_size], size - count * this->cfg.page_size);
-    WL_RESULT_CHECK(result);
     return result;
 }
 
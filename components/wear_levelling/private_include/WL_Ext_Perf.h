@@ -40,6 +40,7 @@ protected:
     uint32_t *sector_buffer;
 
     virtual esp_err_t erase_sector_fit(uint32_t start_sector, uint32_t count);
+    esp_err_t copy_kept_sectors(uint32_t flash_sector, uint32_t first, uint32_t count, bool write_back);
 
 };
 
@@ -71,6 +71,7 @@ protected:
     esp_err_t updateWL();
     esp_err_t recoverPos();
     size_t calcAddr(size_t addr);
+    size_t calcAddrRun(size_t addr, size_t *run_size);
 
     esp_err_t updateVersion();
     esp_err_t updateV1_V2();
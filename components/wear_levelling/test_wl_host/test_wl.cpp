@@ -6,6 +6,9 @@
 #include "esp_partition.h"
 #include "wear_levelling.h"
 #include "WL_Flash.h"
+#include "WL_Ext_Perf.h"
+#include "WL_Ext_Safe.h"
+#include "Partition.h"
 #include "SpiFlash.h"
 
 #include "catch.hpp"
@@ -207,4 +210,88 @@ TEST_CASE("power down test", "[wear_levelling]")
     // Unmount
     result = wl_unmount(wl_handle);
     REQUIRE(result == ESP_OK);
-}
\ No newline at end of file
+}
+template <typename T>
+static Flash_Access* create_wl(Partition *part, size_t fat_sector_size)
+{
+    wl_ext_cfg_t cfg;
+    cfg.full_mem_size = part->chip_size();
+    cfg.start_addr = 0;
+    cfg.version = 2;
+    cfg.sector_size = SPI_FLASH_SEC_SIZE;
+    cfg.page_size = SPI_FLASH_SEC_SIZE;
+    cfg.updaterate = 16;
+    cfg.temp_buff_size = 32;
+    cfg.wr_size = 16;
+    cfg.fat_sector_size = fat_sector_size;
+
+    T *wl = new T();
+    REQUIRE(wl->config(&cfg, part) == ESP_OK);
+    REQUIRE(wl->init() == ESP_OK);
+    return wl;
+}
+
+static void check_wl_contents(Flash_Access *wl, const uint8_t *expected)
+{
+    size_t size = wl->chip_size();
+    uint8_t *read = (uint8_t *) malloc(size);
+    REQUIRE(wl->read(0, read, size) == ESP_OK);
+    REQUIRE(memcmp(expected, read, size) == 0);
+    free(read);
+}
+
+template <typename T>
+static void test_random_erase_write(size_t fat_sector_size)
+{
+    init_spi_flash(CONFIG_ESPTOOLPY_FLASHSIZE, CONFIG_WL_SECTOR_SIZE * 16, CONFIG_WL_SECTOR_SIZE, CONFIG_WL_SECTOR_SIZE, "partition_table.bin");
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "storage");
+    Partition part(partition);
+    Flash_Access *wl = create_wl<T>(&part, fat_sector_size);
+
+    const size_t sector_size = wl->sector_size();
+    const size_t sectors = wl->chip_size() / sector_size;
+    const size_t max_count = 32;
+    uint8_t *expected = (uint8_t *) malloc(wl->chip_size());
+    uint8_t *data = (uint8_t *) malloc(max_count * sector_size);
+    REQUIRE(wl->erase_range(0, sectors * sector_size) == ESP_OK);
+    memset(expected, 0xff, wl->chip_size());
+
+    // Ranges of several sectors, which get erased in runs between the moves of the dummy block
+    srand(1);
+    for (int round = 0; round < 400; round++) {
+        size_t start = rand() % sectors;
+        size_t count = 1 + rand() % max_count;
+        if (start + count > sectors) {
+            count = sectors - start;
+        }
+        REQUIRE(wl->erase_range(start * sector_size, count * sector_size) == ESP_OK);
+        memset(expected + start * sector_size, 0xff, count * sector_size);
+
+        size_t len = (rand() % (count * sector_size)) & ~3;
+        for (size_t i = 0; i < len; i++) {
+            data[i] = rand();
+        }
+        REQUIRE(wl->write(start * sector_size, data, len) == ESP_OK);
+        memcpy(expected + start * sector_size, data, len);
+        if (round % 50 == 0) {
+            check_wl_contents(wl, expected);
+        }
+    }
+    check_wl_contents(wl, expected);
+
+    // Remount
+    delete wl;
+    wl = create_wl<T>(&part, fat_sector_size);
+    check_wl_contents(wl, expected);
+
+    delete wl;
+    free(data);
+    free(expected);
+}
+
+TEST_CASE("multi-sector erase and write ranges are read back", "[wear_levelling]")
+{
+    test_random_erase_write<WL_Flash>(SPI_FLASH_SEC_SIZE);
+    test_random_erase_write<WL_Ext_Perf>(512);
+    test_random_erase_write<WL_Ext_Safe>(512);
+}
@@ -0,0 +1,130 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <string.h>
+#include "Flash_Emulator.h"
+
+#define EMULATOR_SECTOR_SIZE    4096
+#define EMULATOR_BLOCK_SIZE     (64 * 1024)
+#define EMULATOR_PAGE_SIZE      256
+
+Flash_Emulator::Flash_Emulator(size_t size, const flash_timing_t &timing)
+{
+    this->size = size;
+    this->timing = timing;
+    this->memory = (uint8_t *)malloc(size);
+    memset(this->memory, 0xff, size);
+    this->erase_counts = (uint32_t *)calloc(size / EMULATOR_SECTOR_SIZE, sizeof(uint32_t));
+}
+
+Flash_Emulator::~Flash_Emulator()
+{
+    free(this->memory);
+    free(this->erase_counts);
+}
+
+size_t Flash_Emulator::chip_size()
+{
+    return this->size;
+}
+
+size_t Flash_Emulator::sector_size()
+{
+    return EMULATOR_SECTOR_SIZE;
+}
+
+esp_err_t Flash_Emulator::erase_sector(size_t sector)
+{
+    return this->erase_range(sector * EMULATOR_SECTOR_SIZE, EMULATOR_SECTOR_SIZE);
+}
+
+esp_err_t Flash_Emulator::erase_range(size_t start_address, size_t size)
+{
+    if ((start_address % EMULATOR_SECTOR_SIZE) != 0 || (size % EMULATOR_SECTOR_SIZE) != 0 ||
+            start_address + size > this->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(&this->memory[start_address], 0xff, size);
+    // Like spi_flash_erase_range, use block erase for the aligned 64KB blocks in the range
+    size_t addr = start_address;
+    while (addr < start_address + size) {
+        size_t erase_size = EMULATOR_SECTOR_SIZE;
+        if ((addr % EMULATOR_BLOCK_SIZE) == 0 && start_address + size - addr >= EMULATOR_BLOCK_SIZE) {
+            erase_size = EMULATOR_BLOCK_SIZE;
+            this->busy_us += this->timing.erase_block_us;
+        } else {
+            this->busy_us += this->timing.erase_sector_us;
+        }
+        this->busy_us += this->timing.op_overhead_us;
+        for (size_t i = 0; i < erase_size / EMULATOR_SECTOR_SIZE; i++) {
+            this->erase_counts[addr / EMULATOR_SECTOR_SIZE + i]++;
+        }
+        addr += erase_size;
+    }
+    this->bytes_erased += size;
+    this->erase_ops++;
+    return ESP_OK;
+}
+
+esp_err_t Flash_Emulator::write(size_t dest_addr, const void *src, size_t size)
+{
+    if (dest_addr + size > this->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Programming can only clear bits
+    const uint8_t *data = (const uint8_t *)src;
+    for (size_t i = 0; i < size; i++) {
+        this->memory[dest_addr + i] &= data[i];
+    }
+    // Each program command writes up to the end of a page
+    size_t addr = dest_addr;
+    while (addr < dest_addr + size) {
+        size_t page_end = (addr / EMULATOR_PAGE_SIZE + 1) * EMULATOR_PAGE_SIZE;
+        size_t len = (page_end < dest_addr + size ? page_end : dest_addr + size) - addr;
+        this->busy_us += this->timing.op_overhead_us + this->timing.program_us_per_page * len / EMULATOR_PAGE_SIZE;
+        addr += len;
+    }
+    this->bytes_written += size;
+    this->write_ops++;
+    return ESP_OK;
+}
+
+esp_err_t Flash_Emulator::read(size_t src_addr, void *dest, size_t size)
+{
+    if (src_addr + size > this->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(dest, &this->memory[src_addr], size);
+    this->busy_us += this->timing.op_overhead_us + this->timing.read_us_per_byte * size;
+    this->bytes_read += size;
+    this->read_ops++;
+    return ESP_OK;
+}
+
+void Flash_Emulator::reset_stats()
+{
+    this->bytes_read = 0;
+    this->bytes_written = 0;
+    this->bytes_erased = 0;
+    this->read_ops = 0;
+    this->write_ops = 0;
+    this->erase_ops = 0;
+    this->busy_us = 0;
+    memset(this->erase_counts, 0, this->size / EMULATOR_SECTOR_SIZE * sizeof(uint32_t));
+}
+
+uint32_t Flash_Emulator::get_erase_count(size_t sector)
+{
+    return this->erase_counts[sector];
+}
@@ -0,0 +1,71 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _Flash_Emulator_H_
+#define _Flash_Emulator_H_
+
+#include <stdint.h>
+#include "Flash_Access.h"
+
+/**
+* @brief Timing of the emulated flash chip, in microseconds
+*
+* The defaults are typical values of a common SPI NOR flash chip, accessed at 40MHz in DIO mode.
+*/
+typedef struct {
+    double read_us_per_byte = 0.1;      /*!< time to read one byte*/
+    double program_us_per_page = 700;   /*!< time to program one 256 byte page*/
+    double erase_sector_us = 45000;     /*!< time to erase one 4KB sector*/
+    double erase_block_us = 150000;     /*!< time to erase one aligned 64KB block*/
+    double op_overhead_us = 20;         /*!< fixed cost of each read, write and erase command*/
+} flash_timing_t;
+
+/**
+* @brief This class emulates a NOR flash chip in RAM, and counts how it is used. Class implements Flash_Access interface
+*
+*/
+class Flash_Emulator : public Flash_Access
+{
+public:
+    Flash_Emulator(size_t size, const flash_timing_t &timing);
+    ~Flash_Emulator() override;
+
+    size_t chip_size() override;
+    size_t sector_size() override;
+
+    esp_err_t erase_sector(size_t sector) override;
+    esp_err_t erase_range(size_t start_address, size_t size) override;
+
+    esp_err_t write(size_t dest_addr, const void *src, size_t size) override;
+    esp_err_t read(size_t src_addr, void *dest, size_t size) override;
+
+    void reset_stats();
+
+    uint32_t get_erase_count(size_t sector);
+
+    uint64_t bytes_read = 0;
+    uint64_t bytes_written = 0;
+    uint64_t bytes_erased = 0;
+    uint32_t read_ops = 0;
+    uint32_t write_ops = 0;
+    uint32_t erase_ops = 0;
+    double busy_us = 0;     /*!< time the chip was busy, according to the timing*/
+
+protected:
+    size_t size;
+    flash_timing_t timing;
+    uint8_t *memory;
+    uint32_t *erase_counts;
+};
+
+#endif // _Flash_Emulator_H_
@@ -0,0 +1,564 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Replays I/O traces on the wear levelling layer, optionally with FAT on top of it, running on an
+// emulated flash chip, and reports write amplification, erase count distribution, modelled
+// latency and a lifetime estimate for each wear levelling configuration.
+//
+// Trace files contain one operation per line, '#' starts a comment:
+//
+//   sector_write SECTOR COUNT          write COUNT sectors through the FATFS disk I/O path
+//   sector_read SECTOR COUNT           read COUNT sectors through the FATFS disk I/O path
+//   append PATH SIZE [CHUNK]           append SIZE bytes to a file, CHUNK bytes per f_write
+//   write PATH OFFSET SIZE [CHUNK]     overwrite (or extend) a file at OFFSET
+//   read PATH [CHUNK]                  read a whole file, CHUNK bytes per f_read
+//   remove PATH                        delete a file
+//   mkdir PATH                         create a directory
+//   repeat COUNT ... end               repeat the enclosed operations COUNT times
+//
+// Log lines of the FATFS wear levelling driver ("ff_wl_write - pdrv=0, sector=1, count=2"),
+// printed with the log level of the "ff_diskio_spiflash" tag set to verbose, are replayed as
+// sector_write and sector_read operations, so traces can be recorded on the device.
+// The file operations format the emulated partition with FAT first.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <string>
+#include <vector>
+
+#include "ff.h"
+#include "diskio.h"
+#include "WL_Flash.h"
+#include "WL_Ext_Perf.h"
+#include "WL_Ext_Safe.h"
+#include "Flash_Emulator.h"
+
+typedef enum {
+    WL_PERF_FLASH,      // WL_Flash, 4096 byte sectors
+    WL_PERF_EXT_PERF,   // WL_Ext_Perf, 512 byte sectors
+    WL_PERF_EXT_SAFE,   // WL_Ext_Safe, 512 byte sectors
+} wl_perf_type_t;
+
+typedef struct {
+    const char *name;
+    wl_perf_type_t type;
+    uint32_t fat_sector_size;
+} wl_perf_config_t;
+
+static const wl_perf_config_t s_configs[] = {
+    { "wl4096", WL_PERF_FLASH, 4096 },
+    { "perf512", WL_PERF_EXT_PERF, 512 },
+    { "safe512", WL_PERF_EXT_SAFE, 512 },
+};
+
+typedef enum {
+    OP_SECTOR_WRITE,
+    OP_SECTOR_READ,
+    OP_APPEND,
+    OP_WRITE,
+    OP_READ,
+    OP_REMOVE,
+    OP_MKDIR,
+    OP_REPEAT,
+} trace_op_type_t;
+
+struct trace_op_t {
+    trace_op_type_t type;
+    std::string path;
+    uint32_t args[3];
+    std::vector<trace_op_t> body;   // operations repeated by OP_REPEAT
+};
+
+typedef struct {
+    size_t partition_size = 1024 * 1024;
+    uint32_t updaterate = 16;
+    uint32_t allocation_unit = 0;
+    uint32_t passes = 1;
+    uint32_t endurance = 100000;
+    flash_timing_t timing;
+} wl_perf_options_t;
+
+typedef struct {
+    uint64_t user_written = 0;
+    uint64_t user_read = 0;
+    uint32_t ops = 0;
+    double max_op_us = 0;
+    bool failed = false;
+} wl_perf_result_t;
+
+static WL_Flash *s_wl;
+static uint8_t *s_buf;
+static const size_t s_buf_size = 64 * 1024;
+
+static DSTATUS perf_disk_initialize(BYTE pdrv)
+{
+    return 0;
+}
+
+static DSTATUS perf_disk_status(BYTE pdrv)
+{
+    return 0;
+}
+
+static DRESULT perf_disk_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+    size_t ss = s_wl->sector_size();
+    return s_wl->read(sector * ss, buff, count * ss) == ESP_OK ? RES_OK : RES_ERROR;
+}
+
+// Same as ff_wl_write
+static DRESULT perf_disk_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
+{
+    size_t ss = s_wl->sector_size();
+    if (s_wl->erase_range(sector * ss, count * ss) != ESP_OK) {
+        return RES_ERROR;
+    }
+    return s_wl->write(sector * ss, buff, count * ss) == ESP_OK ? RES_OK : RES_ERROR;
+}
+
+static DRESULT perf_disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
+{
+    switch (cmd) {
+    case CTRL_SYNC:
+        return RES_OK;
+    case GET_SECTOR_COUNT:
+        *((DWORD *) buff) = s_wl->chip_size() / s_wl->sector_size();
+        return RES_OK;
+    case GET_SECTOR_SIZE:
+        *((WORD *) buff) = s_wl->sector_size();
+        return RES_OK;
+    }
+    return RES_ERROR;
+}
+
+static const ff_diskio_impl_t s_disk_impl = {
+    .init = &perf_disk_initialize,
+    .status = &perf_disk_status,
+    .read = &perf_disk_read,
+    .write = &perf_disk_write,
+    .ioctl = &perf_disk_ioctl,
+};
+
+static bool parse_trace(FILE *f, const char *file_name, std::vector<trace_op_t> &ops)
+{
+    std::vector<std::vector<trace_op_t> *> blocks(1, &ops);
+    char line[512];
+    int line_num = 0;
+    while (fgets(line, sizeof(line), f)) {
+        line_num++;
+        trace_op_t op = {};
+        unsigned pdrv, sector, count;
+        const char *log_op;
+        if ((log_op = strstr(line, "ff_wl_write - ")) != NULL || (log_op = strstr(line, "ff_wl_read - ")) != NULL) {
+            if (sscanf(strchr(log_op, '-'), "- pdrv=%u, sector=%u, count=%u", &pdrv, &sector, &count) != 3) {
+                fprintf(stderr, "%s:%d: can't parse log line\n", file_name, line_num);
+                return false;
+            }
+            op.type = (log_op[6] == 'w') ? OP_SECTOR_WRITE : OP_SECTOR_READ;
+            op.args[0] = sector;
+            op.args[1] = count;
+            blocks.back()->push_back(op);
+            continue;
+        }
+        char *comment = strchr(line, '#');
+        if (comment) {
+            *comment = 0;
+        }
+        char *argv[5];
+        int argc = 0;
+        for (char *tok = strtok(line, " \t\r\n"); tok && argc < 5; tok = strtok(NULL, " \t\r\n")) {
+            argv[argc++] = tok;
+        }
+        if (argc == 0) {
+            continue;
+        }
+        const char *cmd = argv[0];
+        bool ok = true;
+        if (!strcmp(cmd, "end") && argc == 1 && blocks.size() > 1) {
+            blocks.pop_back();
+            continue;
+        } else if (!strcmp(cmd, "repeat") && argc == 2) {
+            op.type = OP_REPEAT;
+        } else if (!strcmp(cmd, "sector_write") && argc == 3) {
+            op.type = OP_SECTOR_WRITE;
+        } else if (!strcmp(cmd, "sector_read") && argc == 3) {
+            op.type = OP_SECTOR_READ;
+        } else if (!strcmp(cmd, "append") && (argc == 3 || argc == 4)) {
+            op.type = OP_APPEND;
+            op.args[1] = 4096;
+        } else if (!strcmp(cmd, "write") && (argc == 4 || argc == 5)) {
+            op.type = OP_WRITE;
+            op.args[2] = 4096;
+        } else if (!strcmp(cmd, "read") && (argc == 2 || argc == 3)) {
+            op.type = OP_READ;
+            op.args[0] = 4096;
+        } else if (!strcmp(cmd, "remove") && argc == 2) {
+            op.type = OP_REMOVE;
+        } else if (!strcmp(cmd, "mkdir") && argc == 2) {
+            op.type = OP_MKDIR;
+        } else {
+            ok = false;
+        }
+        // numeric arguments follow the path, if the operation has one
+        int first_num = 1;
+        if (ok && op.type >= OP_APPEND && op.type <= OP_MKDIR) {
+            op.path = argv[1];
+            first_num = 2;
+        }
+        for (int i = first_num; ok && i < argc; i++) {
+            char *end;
+            op.args[i - first_num] = strtoul(argv[i], &end, 0);
+            ok = (*end == 0);
+        }
+        if (!ok) {
+            fprintf(stderr, "%s:%d: invalid operation\n", file_name, line_num);
+            return false;
+        }
+        blocks.back()->push_back(op);
+        if (op.type == OP_REPEAT) {
+            blocks.push_back(&blocks.back()->back().body);
+        }
+    }
+    if (blocks.size() > 1) {
+        fprintf(stderr, "%s: 'repeat' without 'end'\n", file_name);
+        return false;
+    }
+    return true;
+}
+
+static bool uses_fat(const std::vector<trace_op_t> &ops)
+{
+    for (const trace_op_t &op : ops) {
+        if ((op.type >= OP_APPEND && op.type <= OP_MKDIR) || (op.type == OP_REPEAT && uses_fat(op.body))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void fill_buf(size_t size, uint32_t seed)
+{
+    for (size_t i = 0; i < size; i++) {
+        s_buf[i] = (uint8_t)(seed + i * 7);
+    }
+}
+
+static bool run_op(const trace_op_t &op, wl_perf_result_t &res)
+{
+    size_t ss = s_wl->sector_size();
+    FIL file;
+    FRESULT fr = FR_OK;
+    UINT done;
+    switch (op.type) {
+    case OP_SECTOR_WRITE:
+    case OP_SECTOR_READ:
+        for (uint32_t i = 0; i < op.args[1]; i += s_buf_size / ss) {
+            UINT count = op.args[1] - i < s_buf_size / ss ? op.args[1] - i : s_buf_size / ss;
+            if ((op.args[0] + i + count) * ss > s_wl->chip_size()) {
+                fprintf(stderr, "sector %u is beyond the end of the partition\n", op.args[0] + i + count - 1);
+                return false;
+            }
+            if (op.type == OP_SECTOR_WRITE) {
+                fill_buf(count * ss, op.args[0] + i);
+                if (perf_disk_write(0, s_buf, op.args[0] + i, count) != RES_OK) {
+                    return false;
+                }
+                res.user_written += count * ss;
+            } else {
+                if (perf_disk_read(0, s_buf, op.args[0] + i, count) != RES_OK) {
+                    return false;
+                }
+                res.user_read += count * ss;
+            }
+        }
+        return true;
+    case OP_APPEND:
+    case OP_WRITE: {
+        const uint32_t size = (op.type == OP_APPEND) ? op.args[0] : op.args[1];
+        uint32_t chunk = (op.type == OP_APPEND) ? op.args[1] : op.args[2];
+        chunk = (chunk == 0 || chunk > s_buf_size) ? s_buf_size : chunk;
+        fr = f_open(&file, op.path.c_str(), FA_WRITE | (op.type == OP_APPEND ? FA_OPEN_APPEND : FA_OPEN_ALWAYS));
+        if (fr == FR_OK && op.type == OP_WRITE) {
+            fr = f_lseek(&file, op.args[0]);
+        }
+        for (uint32_t offset = 0; fr == FR_OK && offset < size; offset += chunk) {
+            UINT len = (size - offset < chunk) ? size - offset : chunk;
+            fill_buf(len, offset);
+            fr = f_write(&file, s_buf, len, &done);
+            if (fr == FR_OK && done != len) {
+                fr = FR_DENIED;     // disk full
+            }
+            res.user_written += done;
+        }
+        if (fr == FR_OK) {
+            fr = f_close(&file);
+        }
+        break;
+    }
+    case OP_READ: {
+        const uint32_t chunk = (op.args[0] == 0 || op.args[0] > s_buf_size) ? s_buf_size : op.args[0];
+        fr = f_open(&file, op.path.c_str(), FA_READ);
+        do {
+            if (fr == FR_OK) {
+                fr = f_read(&file, s_buf, chunk, &done);
+                res.user_read += done;
+            }
+        } while (fr == FR_OK && done == chunk);
+        if (fr == FR_OK) {
+            fr = f_close(&file);
+        }
+        break;
+    }
+    case OP_REMOVE:
+        fr = f_unlink(op.path.c_str());
+        break;
+    case OP_MKDIR:
+        fr = f_mkdir(op.path.c_str());
+        if (fr == FR_EXIST) {
+            fr = FR_OK;
+        }
+        break;
+    case OP_REPEAT:
+        return false;
+    }
+    if (fr != FR_OK) {
+        fprintf(stderr, "%s %s failed, FRESULT=%d\n", (op.type == OP_READ) ? "read" : "operation on", op.path.c_str(), fr);
+        return false;
+    }
+    return true;
+}
+
+static bool run_ops(const std::vector<trace_op_t> &ops, Flash_Emulator &flash, wl_perf_result_t &res)
+{
+    for (const trace_op_t &op : ops) {
+        if (op.type == OP_REPEAT) {
+            for (uint32_t i = 0; i < op.args[0]; i++) {
+                if (!run_ops(op.body, flash, res)) {
+                    return false;
+                }
+            }
+            continue;
+        }
+        double start_us = flash.busy_us;
+        if (!run_op(op, res)) {
+            return false;
+        }
+        double op_us = flash.busy_us - start_us;
+        if (op_us > res.max_op_us) {
+            res.max_op_us = op_us;
+        }
+        res.ops++;
+    }
+    return true;
+}
+
+static WL_Flash *create_wl(const wl_perf_config_t &config, const wl_perf_options_t &options, Flash_Access *flash)
+{
+    wl_ext_cfg_t cfg;
+    cfg.full_mem_size = flash->chip_size();
+    cfg.start_addr = 0;
+    cfg.version = 2;
+    cfg.sector_size = flash->sector_size();
+    cfg.page_size = flash->sector_size();
+    cfg.updaterate = options.updaterate;
+    cfg.temp_buff_size = 32;
+    cfg.wr_size = 16;
+    cfg.fat_sector_size = config.fat_sector_size;
+
+    WL_Flash *wl;
+    switch (config.type) {
+    case WL_PERF_EXT_PERF:
+        wl = new WL_Ext_Perf();
+        break;
+    case WL_PERF_EXT_SAFE:
+        wl = new WL_Ext_Safe();
+        break;
+    default:
+        wl = new WL_Flash();
+        break;
+    }
+    if (wl->config(&cfg, flash) != ESP_OK || wl->init() != ESP_OK) {
+        delete wl;
+        return NULL;
+    }
+    return wl;
+}
+
+static bool run_config(const wl_perf_config_t &config, const wl_perf_options_t &options, const std::vector<trace_op_t> &ops)
+{
+    Flash_Emulator flash(options.partition_size, options.timing);
+    s_wl = create_wl(config, options, &flash);
+    if (s_wl == NULL) {
+        fprintf(stderr, "%s: can't initialize wear levelling\n", config.name);
+        return false;
+    }
+
+    FATFS fs;
+    bool fat = uses_fat(ops);
+    BYTE pdrv = 0xFF;
+    if (fat) {
+        if (ff_diskio_get_drive(&pdrv) != ESP_OK) {
+            return false;
+        }
+        ff_diskio_register(pdrv, &s_disk_impl);
+        BYTE work[FF_MAX_SS];
+        char drv[3] = {(char)('0' + pdrv), ':', 0};
+        uint32_t au = options.allocation_unit ? options.allocation_unit : config.fat_sector_size;
+        if (f_mkfs(drv, FM_ANY | FM_SFD, au, work, sizeof(work)) != FR_OK || f_mount(&fs, drv, 1) != FR_OK) {
+            fprintf(stderr, "%s: can't format the partition\n", config.name);
+            ff_diskio_register(pdrv, NULL);
+            delete s_wl;
+            return false;
+        }
+    }
+
+    // Only the trace is measured, not wear levelling initialization and formatting
+    flash.reset_stats();
+    wl_perf_result_t res;
+    for (uint32_t pass = 0; pass < options.passes && !res.failed; pass++) {
+        res.failed = !run_ops(ops, flash, res);
+    }
+
+    if (fat) {
+        f_mount(NULL, "", 0);
+        ff_diskio_register(pdrv, NULL);
+    }
+    delete s_wl;
+    s_wl = NULL;
+
+    const size_t sectors = flash.chip_size() / flash.sector_size();
+    uint64_t total_erases = 0;
+    uint32_t min_erases = UINT32_MAX, max_erases = 0;
+    for (size_t i = 0; i < sectors; i++) {
+        uint32_t n = flash.get_erase_count(i);
+        total_erases += n;
+        min_erases = (n < min_erases) ? n : min_erases;
+        max_erases = (n > max_erases) ? n : max_erases;
+    }
+    const double user_mb = res.user_written / (1024.0 * 1024.0);
+    const double seconds = flash.busy_us / 1e6;
+
+    printf("%-8s %9.2f %7.2f %7.2f %9.2f %8.3f %8.2f %8.2f  %5u/%7.1f/%-5u %10.2f %10.2f%s\n",
+           config.name,
+           user_mb,
+           res.user_written ? (double)flash.bytes_written / res.user_written : 0.0,
+           res.user_written ? (double)flash.bytes_erased / res.user_written : 0.0,
+           seconds,
+           seconds > 0 ? (res.user_written + res.user_read) / (1024.0 * 1024.0) / seconds : 0.0,
+           res.ops ? flash.busy_us / res.ops / 1000.0 : 0.0,
+           res.max_op_us / 1000.0,
+           min_erases, (double)total_erases / sectors, max_erases,
+           // data written until the most erased sector, or all of them evenly, reach the endurance
+           max_erases ? user_mb * options.endurance / max_erases / 1024.0 : 0.0,
+           total_erases ? user_mb * options.endurance * sectors / total_erases / 1024.0 : 0.0,
+           res.failed ? "  FAILED" : "");
+    return !res.failed;
+}
+
+static void usage(const char *name)
+{
+    printf("Usage: %s [options] TRACE...\n"
+           "  -c CONFIG    run only this configuration (wl4096, perf512, safe512), can be repeated\n"
+           "  -s SIZE      partition size in KB (default 1024)\n"
+           "  -u RATE      wear levelling update rate (default 16)\n"
+           "  -a SIZE      FAT allocation unit size (default: sector size)\n"
+           "  -n COUNT     replay each trace COUNT times (default 1)\n"
+           "  -e CYCLES    erase cycles a flash sector endures (default 100000)\n"
+           "  -t R,P,S,B   read us/byte, program us/page, sector and block erase us\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    wl_perf_options_t options;
+    std::vector<const wl_perf_config_t *> configs;
+    int opt;
+    while ((opt = getopt(argc, argv, "c:s:u:a:n:e:t:h")) != -1) {
+        switch (opt) {
+        case 'c': {
+            size_t i;
+            for (i = 0; i < sizeof(s_configs) / sizeof(s_configs[0]); i++) {
+                if (!strcmp(optarg, s_configs[i].name)) {
+                    configs.push_back(&s_configs[i]);
+                    break;
+                }
+            }
+            if (i == sizeof(s_configs) / sizeof(s_configs[0])) {
+                fprintf(stderr, "unknown configuration %s\n", optarg);
+                return 1;
+            }
+            break;
+        }
+        case 's':
+            options.partition_size = strtoul(optarg, NULL, 0) * 1024;
+            break;
+        case 'u':
+            options.updaterate = strtoul(optarg, NULL, 0);
+            break;
+        case 'a':
+            options.allocation_unit = strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            options.passes = strtoul(optarg, NULL, 0);
+            break;
+        case 'e':
+            options.endurance = strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            if (sscanf(optarg, "%lf,%lf,%lf,%lf", &options.timing.read_us_per_byte, &options.timing.program_us_per_page,
+                       &options.timing.erase_sector_us, &options.timing.erase_block_us) != 4) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind >= argc || options.partition_size % 4096 != 0 || options.passes == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (configs.empty()) {
+        for (size_t i = 0; i < sizeof(s_configs) / sizeof(s_configs[0]); i++) {
+            configs.push_back(&s_configs[i]);
+        }
+    }
+
+    s_buf = (uint8_t *)malloc(s_buf_size);
+    bool ok = true;
+    for (int i = optind; i < argc; i++) {
+        FILE *f = fopen(argv[i], "r");
+        if (f == NULL) {
+            fprintf(stderr, "can't open %s\n", argv[i]);
+            return 1;
+        }
+        std::vector<trace_op_t> ops;
+        bool parsed = parse_trace(f, argv[i], ops);
+        fclose(f);
+        if (!parsed) {
+            return 1;
+        }
+        printf("%s: partition %u KB, update rate %u, %u pass(es)\n", argv[i],
+               (unsigned)(options.partition_size / 1024), options.updaterate, options.passes);
+        printf("%-8s %9s %7s %7s %9s %8s %8s %8s  %-19s %10s %10s\n", "config", "user MB", "wr amp",
+               "er amp", "time s", "MB/s", "avg ms", "max ms", "erases min/avg/max", "life GB", "ideal GB");
+        for (const wl_perf_config_t *config : configs) {
+            ok &= run_config(*config, options, ops);
+        }
+    }
+    free(s_buf);
+    return ok ? 0 : 1;
+}
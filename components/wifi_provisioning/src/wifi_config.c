@@ -19,25 +19,33 @@
 
 #include "wifi_constants.pb-c.h"
 #include "wifi_config.pb-c.h"
+#include "esp_protobuf_arena.h"
 
 #include <wifi_provisioning/wifi_config.h>
 
 static const char* TAG = "WiFiProvConfig";
 
+/* Request and response messages are allocated from this arena on the stack */
+#define WIFI_CONFIG_ARENA_SIZE  384
+
 typedef struct wifi_prov_config_cmd {
     int cmd_num;
     esp_err_t (*command_handler)(WiFiConfigPayload *req,
-                                 WiFiConfigPayload *resp, void *priv_data);
+                                 WiFiConfigPayload *resp, void *priv_data,
+                                 esp_protobuf_arena_t *arena);
 } wifi_prov_config_cmd_t;
 
 static esp_err_t cmd_get_status_handler(WiFiConfigPayload *req,
-                                        WiFiConfigPayload *resp, void *priv_data);
+                                        WiFiConfigPayload *resp, void *priv_data,
+                                        esp_protobuf_arena_t *arena);
 
 static esp_err_t cmd_set_config_handler(WiFiConfigPayload *req,
-                                        WiFiConfigPayload *resp, void *priv_data);
+                                        WiFiConfigPayload *resp, void *priv_data,
+                                        esp_protobuf_arena_t *arena);
 
 static esp_err_t cmd_apply_config_handler(WiFiConfigPayload *req,
-                                          WiFiConfigPayload *resp, void *priv_data);
+                                          WiFiConfigPayload *resp, void *priv_data,
+                                          esp_protobuf_arena_t *arena);
 
 static wifi_prov_config_cmd_t cmd_table[] = {
     {
@@ -54,8 +62,29 @@ static wifi_prov_config_cmd_t cmd_table[] = {
     }
 };
 
+static void *arena_memdup(esp_protobuf_arena_t *arena, const void *data, size_t len)
+{
+    void *copy = esp_protobuf_arena_alloc(arena, len);
+    if (copy) {
+        memcpy(copy, data, len);
+    }
+    return copy;
+}
+
+static char *arena_strndup(esp_protobuf_arena_t *arena, const char *str, size_t max_len)
+{
+    size_t len = strnlen(str, max_len);
+    char *copy = esp_protobuf_arena_alloc(arena, len + 1);
+    if (copy) {
+        memcpy(copy, str, len);
+        copy[len] = '\0';
+    }
+    return copy;
+}
+
 static esp_err_t cmd_get_status_handler(WiFiConfigPayload *req,
-                                        WiFiConfigPayload *resp, void *priv_data)
+                                        WiFiConfigPayload *resp, void *priv_data,
+                                        esp_protobuf_arena_t *arena)
 {
     ESP_LOGD(TAG, "Enter cmd_get_status_handler");
     wifi_prov_config_handlers_t *h = (wifi_prov_config_handlers_t *) priv_data;
@@ -64,7 +93,7 @@ static esp_err_t cmd_get_status_handler(WiFiConfigPayload *req,
         return ESP_ERR_INVALID_STATE;
     }
 
-    RespGetStatus *resp_payload = (RespGetStatus *) malloc(sizeof(RespGetStatus));
+    RespGetStatus *resp_payload = (RespGetStatus *) esp_protobuf_arena_alloc(arena, sizeof(RespGetStatus));
     if (!resp_payload) {
         ESP_LOGE(TAG, "Error allocating memory");
         return ESP_ERR_NO_MEM;
@@ -80,7 +109,7 @@ static esp_err_t cmd_get_status_handler(WiFiConfigPayload *req,
             resp_payload->sta_state  = WIFI_STATION_STATE__Connected;
             resp_payload->state_case = RESP_GET_STATUS__STATE_CONNECTED;
             WifiConnectedState *connected = (WifiConnectedState *)(
-                                            malloc(sizeof(WifiConnectedState)));
+                                            esp_protobuf_arena_alloc(arena, sizeof(WifiConnectedState)));
             if (!connected) {
                 ESP_LOGE(TAG, "Error allocating memory");
                 return ESP_ERR_NO_MEM;
@@ -88,27 +117,16 @@ static esp_err_t cmd_get_status_handler(WiFiConfigPayload *req,
             resp_payload->connected  = connected;
             wifi_connected_state__init(connected);
 
-            connected->ip4_addr = strdup(resp_data.conn_info.ip_addr);
-            if (connected->ip4_addr == NULL) {
-                free(resp_payload);
-                return ESP_ERR_NO_MEM;
-            }
-
+            /* Strings are copied, the response is packed after resp_data is gone */
+            connected->ip4_addr = arena_strndup(arena, resp_data.conn_info.ip_addr,
+                                                sizeof(resp_data.conn_info.ip_addr));
             connected->bssid.len  = sizeof(resp_data.conn_info.bssid);
-            connected->bssid.data = (uint8_t *) strndup(resp_data.conn_info.bssid,
-                                                        sizeof(resp_data.conn_info.bssid));
-            if (connected->bssid.data == NULL) {
-                free(connected->ip4_addr);
-                free(resp_payload);
-                return ESP_ERR_NO_MEM;
-            }
-
-            connected->ssid.len   = strlen(resp_data.conn_info.ssid);
-            connected->ssid.data  = (uint8_t *) strdup(resp_data.conn_info.ssid);
-            if (connected->ssid.data == NULL) {
-                free(connected->bssid.data);
-                free(connected->ip4_addr);
-                free(resp_payload);
+            connected->bssid.data = arena_memdup(arena, resp_data.conn_info.bssid,
+                                                 sizeof(resp_data.conn_info.bssid));
+            connected->ssid.len   = strnlen(resp_data.conn_info.ssid, sizeof(resp_data.conn_info.ssid));
+            connected->ssid.data  = arena_memdup(arena, resp_data.conn_info.ssid, connected->ssid.len);
+            if (!connected->ip4_addr || !connected->bssid.data || !connected->ssid.data) {
+                ESP_LOGE(TAG, "Error allocating memory");
                 return ESP_ERR_NO_MEM;
             }
 
@@ -133,7 +151,8 @@ static esp_err_t cmd_get_status_handler(WiFiConfigPayload *req,
 }
 
 static esp_err_t cmd_set_config_handler(WiFiConfigPayload *req,
-                                        WiFiConfigPayload *resp, void  *priv_data)
+                                        WiFiConfigPayload *resp, void  *priv_data,
+                                        esp_protobuf_arena_t *arena)
 {
     ESP_LOGD(TAG, "Enter cmd_set_config_handler");
     wifi_prov_config_handlers_t *h = (wifi_prov_config_handlers_t *) priv_data;
@@ -142,7 +161,7 @@ static esp_err_t cmd_set_config_handler(WiFiConfigPayload *req,
         return ESP_ERR_INVALID_STATE;
     }
 
-    RespSetConfig *resp_payload = (RespSetConfig *) malloc(sizeof(RespSetConfig));
+    RespSetConfig *resp_payload = (RespSetConfig *) esp_protobuf_arena_alloc(arena, sizeof(RespSetConfig));
     if (resp_payload == NULL) {
         ESP_LOGE(TAG, "Error allocating memory");
         return ESP_ERR_NO_MEM;
@@ -168,7 +187,8 @@ static esp_err_t cmd_set_config_handler(WiFiConfigPayload *req,
 }
 
 static esp_err_t cmd_apply_config_handler(WiFiConfigPayload *req,
-                                          WiFiConfigPayload *resp, void  *priv_data)
+                                          WiFiConfigPayload *resp, void  *priv_data,
+                                          esp_protobuf_arena_t *arena)
 {
     ESP_LOGD(TAG, "Enter cmd_apply_config_handler");
     wifi_prov_config_handlers_t *h = (wifi_prov_config_handlers_t *) priv_data;
@@ -177,7 +197,7 @@ static esp_err_t cmd_apply_config_handler(WiFiConfigPayload *req,
         return ESP_ERR_INVALID_STATE;
     }
 
-    RespApplyConfig *resp_payload = (RespApplyConfig *) malloc(sizeof(RespApplyConfig));
+    RespApplyConfig *resp_payload = (RespApplyConfig *) esp_protobuf_arena_alloc(arena, sizeof(RespApplyConfig));
     if (!resp_payload) {
         ESP_LOGE(TAG, "Error allocating memory");
         return ESP_ERR_NO_MEM;
@@ -208,59 +228,9 @@ static int lookup_cmd_handler(int cmd_id)
 
     return -1;
 }
-static void wifi_prov_config_command_cleanup(WiFiConfigPayload *resp, void *priv_data)
-{
-    if (!resp) {
-        return;
-    }
-
-    switch (resp->msg) {
-        case WI_FI_CONFIG_MSG_TYPE__TypeRespGetStatus:
-            {
-                switch (resp->resp_get_status->sta_state) {
-                    case WIFI_STATION_STATE__Connecting:
-                        break;
-                    case WIFI_STATION_STATE__Connected:
-                        if (resp->resp_get_status->connected) {
-                            if (resp->resp_get_status->connected->ip4_addr) {
-                                free(resp->resp_get_status->connected->ip4_addr);
-                            }
-                            if (resp->resp_get_status->connected->bssid.data) {
-                                free(resp->resp_get_status->connected->bssid.data);
-                            }
-                            if (resp->resp_get_status->connected->ssid.data) {
-                                free(resp->resp_get_status->connected->ssid.data);
-                            }
-                            free(resp->resp_get_status->connected);
-                        }
-                        break;
-                    case WIFI_STATION_STATE__ConnectionFailed:
-                        break;
-                    default:
-                        break;
-                }
-                free(resp->resp_get_status);
-            }
-            break;
-        case WI_FI_CONFIG_MSG_TYPE__TypeRespSetConfig:
-            {
-                free(resp->resp_set_config);
-            }
-            break;
-        case WI_FI_CONFIG_MSG_TYPE__TypeRespApplyConfig:
-            {
-                free(resp->resp_apply_config);
-            }
-            break;
-        default:
-            ESP_LOGE(TAG, "Unsupported response type in cleanup_handler");
-            break;
-    }
-    return;
-}
-
 static esp_err_t wifi_prov_config_command_dispatcher(WiFiConfigPayload *req,
-                                                     WiFiConfigPayload *resp, void *priv_data)
+                                                     WiFiConfigPayload *resp, void *priv_data,
+                                                     esp_protobuf_arena_t *arena)
 {
     esp_err_t ret;
 
@@ -272,7 +242,7 @@ static esp_err_t wifi_prov_config_command_dispatcher(WiFiConfigPayload *req,
         return ESP_FAIL;
     }
 
-    ret = cmd_table[cmd_index].command_handler(req, resp, priv_data);
+    ret = cmd_table[cmd_index].command_handler(req, resp, priv_data, arena);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Error executing command handler");
         return ESP_FAIL;
@@ -284,39 +254,39 @@ static esp_err_t wifi_prov_config_command_dispatcher(WiFiConfigPayload *req,
 esp_err_t wifi_prov_config_data_handler(uint32_t session_id, const uint8_t *inbuf, ssize_t inlen,
                                         uint8_t **outbuf, ssize_t *outlen, void *priv_data)
 {
+    uint8_t arena_buf[WIFI_CONFIG_ARENA_SIZE] __attribute__((aligned(ESP_PROTOBUF_ARENA_ALIGN)));
+    esp_protobuf_arena_t arena;
     WiFiConfigPayload *req;
     WiFiConfigPayload resp;
     esp_err_t ret;
 
-    req = wi_fi_config_payload__unpack(NULL, inlen, inbuf);
+    esp_protobuf_arena_init(&arena, arena_buf, sizeof(arena_buf));
+    req = wi_fi_config_payload__unpack(&arena.allocator, inlen, inbuf);
     if (!req) {
         ESP_LOGE(TAG, "Unable to unpack config data");
-        return ESP_ERR_INVALID_ARG;
+        ret = ESP_ERR_INVALID_ARG;
+        goto exit;
     }
 
     wi_fi_config_payload__init(&resp);
-    ret = wifi_prov_config_command_dispatcher(req, &resp, priv_data);
+    ret = wifi_prov_config_command_dispatcher(req, &resp, priv_data, &arena);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Proto command dispatcher error %d", ret);
-        return ESP_FAIL;
+        ret = ESP_FAIL;
+        goto exit;
     }
 
     resp.msg = req->msg + 1; /* Response is request + 1 */
-    wi_fi_config_payload__free_unpacked(req, NULL);
 
-    *outlen = wi_fi_config_payload__get_packed_size(&resp);
-    if (*outlen <= 0) {
-        ESP_LOGE(TAG, "Invalid encoding for response");
-        return ESP_FAIL;
-    }
-
-    *outbuf = (uint8_t *) malloc(*outlen);
-    if (!*outbuf) {
+    ret = esp_protobuf_pack_alloc(&resp.base, outbuf, outlen);
+    if (ret != ESP_OK) {
         ESP_LOGE(TAG, "System out of memory");
-        return ESP_ERR_NO_MEM;
+    } else if (*outlen <= 0) {
+        ESP_LOGE(TAG, "Invalid encoding for response");
+        ret = ESP_FAIL;
     }
-    wi_fi_config_payload__pack(&resp, *outbuf);
-    wifi_prov_config_command_cleanup(&resp, priv_data);
 
-    return ESP_OK;
+exit:
+    esp_protobuf_arena_release(&arena);
+    return ret;
 }
@@ -40,6 +40,7 @@
 
 #if (CONFIG_GATTS_NOTIFY_THROUGHPUT)
 #define GATTS_NOTIFY_LEN    490
+#define GATTS_NOTIFY_QUEUE_DEPTH    16
 static SemaphoreHandle_t gatts_semaphore;
 static bool can_send_notify = false;
 static uint8_t indicate_data[GATTS_NOTIFY_LEN] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a};
@@ -395,6 +396,13 @@ static void gatts_profile_a_event_handler(esp_gatts_cb_event_t event, esp_gatt_i
                     if (a_property & ESP_GATT_CHAR_PROP_BIT_NOTIFY){
                         
                         ESP_LOGI(GATTS_TAG, "notify enable");
+#if (CONFIG_GATTS_NOTIFY_QUEUE)
+                        esp_err_t err = esp_ble_gatts_notify_queue_open(gatts_if, param->write.conn_id,
+                                                                        GATTS_NOTIFY_QUEUE_DEPTH, GATTS_NOTIFY_LEN);
+                        if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+                            ESP_LOGE(GATTS_TAG, "notify queue open failed, error code = %x", err);
+                        }
+#endif /* #if (CONFIG_GATTS_NOTIFY_QUEUE) */
                         can_send_notify = true;
                         xSemaphoreGive(gatts_semaphore);
                     }
@@ -617,9 +625,18 @@ void throughput_server_task(void *param)
             assert(res == pdTRUE);
         } else {
             if (is_connecet) {
+#if (CONFIG_GATTS_NOTIFY_QUEUE)
+                if (esp_ble_gatts_notify_queue_send(gl_profile_tab[PROFILE_A_APP_ID].gatts_if, gl_profile_tab[PROFILE_A_APP_ID].conn_id,
+                                                    gl_profile_tab[PROFILE_A_APP_ID].char_handle,
+                                                    sizeof(indicate_data), indicate_data) == ESP_ERR_NO_MEM) {
+                    // the queue is full, give the host time to send
+                    vTaskDelay(1);
+                }
+#else
                 esp_ble_gatts_send_indicate(gl_profile_tab[PROFILE_A_APP_ID].gatts_if, gl_profile_tab[PROFILE_A_APP_ID].conn_id,
                                             gl_profile_tab[PROFILE_A_APP_ID].char_handle,
                                             sizeof(indicate_data), indicate_data, false);
+#endif /* #if (CONFIG_GATTS_NOTIFY_QUEUE) */
             }
         }
 #endif /* #if (CONFIG_GATTS_NOTIFY_THROUGHPUT) */
@@ -0,0 +1,41 @@
+from __future__ import print_function
+import re
+import os
+import sys
+
+try:
+    import IDF
+except ImportError:
+    # this is a test case write with tiny-test-fw.
+    # to run test cases outside tiny-test-fw,
+    # we need to set environment variable `TEST_FW_PATH`,
+    # then get and insert `TEST_FW_PATH` to sys path before import FW module
+    test_fw_path = os.getenv('TEST_FW_PATH')
+    if test_fw_path and test_fw_path not in sys.path:
+        sys.path.insert(0, test_fw_path)
+    import IDF
+
+RESULT_OR_DONE_REGEX = re.compile(r'(\[Performance\]\[(\w+)\]: ([^\r\n]+)|Benchmarks done)')
+
+# one result per line of each benchmark, see main/*.c
+EXPECTED_RESULTS = 21
+
+
+@IDF.idf_example_test(env_tag='Example_WIFI')
+def test_examples_system_benchmark(env, extra_data):
+    dut = env.get_dut('benchmark', 'examples/system/benchmark')
+    dut.start_app()
+
+    results = {}
+    while True:
+        data = dut.expect(RESULT_OR_DONE_REGEX, timeout=120)
+        if data[0] == 'Benchmarks done':
+            break
+        results[data[1]] = data[2]
+        IDF.log_performance(data[1], data[2])
+
+    assert len(results) == EXPECTED_RESULTS, "got {} results, expected {}".format(len(results), EXPECTED_RESULTS)
+
+
+if __name__ == '__main__':
+    test_examples_system_benchmark()
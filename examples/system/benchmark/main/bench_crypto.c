@@ -0,0 +1,63 @@
+/* System benchmark example: AES and SHA throughput
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "mbedtls/aes.h"
+#include "mbedtls/sha1.h"
+#include "mbedtls/sha256.h"
+#include "benchmark.h"
+
+static const char *TAG = "bench_crypto";
+
+/* Uses the hardware accelerators when CONFIG_MBEDTLS_HARDWARE_AES and CONFIG_MBEDTLS_HARDWARE_SHA are set */
+
+#define CRYPTO_BUF_SIZE (16 * 1024)
+#define CRYPTO_ROUNDS   8
+
+void bench_crypto(void)
+{
+    uint8_t *buf = calloc(1, CRYPTO_BUF_SIZE);
+    if (buf == NULL) {
+        ESP_LOGE(TAG, "not enough memory");
+        return;
+    }
+    uint8_t key[32] = { 0 };
+    uint8_t iv[16] = { 0 };
+    uint8_t digest[32];
+
+    mbedtls_aes_context aes;
+    mbedtls_aes_init(&aes);
+    mbedtls_aes_setkey_enc(&aes, key, 128);
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < CRYPTO_ROUNDS; i++) {
+        mbedtls_aes_crypt_cbc(&aes, MBEDTLS_AES_ENCRYPT, CRYPTO_BUF_SIZE, iv, buf, buf);
+    }
+    int64_t aes_us = esp_timer_get_time() - start;
+    mbedtls_aes_free(&aes);
+
+    start = esp_timer_get_time();
+    for (int i = 0; i < CRYPTO_ROUNDS; i++) {
+        mbedtls_sha1_ret(buf, CRYPTO_BUF_SIZE, digest);
+    }
+    int64_t sha1_us = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (int i = 0; i < CRYPTO_ROUNDS; i++) {
+        mbedtls_sha256_ret(buf, CRYPTO_BUF_SIZE, digest, 0);
+    }
+    int64_t sha256_us = esp_timer_get_time() - start;
+    free(buf);
+
+    BENCH_REPORT("aes128_cbc_encrypt_KBps", "%d KB/s", bench_kbps(CRYPTO_BUF_SIZE * CRYPTO_ROUNDS, aes_us));
+    BENCH_REPORT("sha1_KBps", "%d KB/s", bench_kbps(CRYPTO_BUF_SIZE * CRYPTO_ROUNDS, sha1_us));
+    BENCH_REPORT("sha256_KBps", "%d KB/s", bench_kbps(CRYPTO_BUF_SIZE * CRYPTO_ROUNDS, sha256_us));
+}
@@ -0,0 +1,105 @@
+/* System benchmark example: SPI flash and NVS
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_partition.h"
+#include "esp_spi_flash.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+#include "benchmark.h"
+
+static const char *TAG = "bench_flash";
+
+#define FLASH_BENCH_SIZE    (64 * 1024)
+#define FLASH_CHUNK_SIZE    4096
+#define NVS_KEYS            100
+
+static void bench_spi_flash(void)
+{
+    // Data partition with a custom subtype, see partitions_benchmark.csv
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, 0x40, "raw");
+    uint8_t *buf = malloc(FLASH_CHUNK_SIZE);
+    if (part == NULL || part->size < FLASH_BENCH_SIZE || buf == NULL) {
+        ESP_LOGE(TAG, "no 'raw' partition or not enough memory");
+        free(buf);
+        return;
+    }
+    for (int i = 0; i < FLASH_CHUNK_SIZE; i++) {
+        buf[i] = i;
+    }
+
+    int64_t start = esp_timer_get_time();
+    ESP_ERROR_CHECK(spi_flash_erase_range(part->address, FLASH_BENCH_SIZE));
+    int64_t erase_us = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (size_t offset = 0; offset < FLASH_BENCH_SIZE; offset += FLASH_CHUNK_SIZE) {
+        ESP_ERROR_CHECK(spi_flash_write(part->address + offset, buf, FLASH_CHUNK_SIZE));
+    }
+    int64_t write_us = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (size_t offset = 0; offset < FLASH_BENCH_SIZE; offset += FLASH_CHUNK_SIZE) {
+        ESP_ERROR_CHECK(spi_flash_read(part->address + offset, buf, FLASH_CHUNK_SIZE));
+    }
+    int64_t read_us = esp_timer_get_time() - start;
+
+    BENCH_REPORT("spi_flash_erase_KBps", "%d KB/s", bench_kbps(FLASH_BENCH_SIZE, erase_us));
+    BENCH_REPORT("spi_flash_write_KBps", "%d KB/s", bench_kbps(FLASH_BENCH_SIZE, write_us));
+    BENCH_REPORT("spi_flash_read_KBps", "%d KB/s", bench_kbps(FLASH_BENCH_SIZE, read_us));
+    free(buf);
+}
+
+static void bench_nvs(void)
+{
+    esp_err_t err = nvs_flash_init();
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        err = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(err);
+    nvs_handle handle;
+    ESP_ERROR_CHECK(nvs_open("benchmark", NVS_READWRITE, &handle));
+    ESP_ERROR_CHECK(nvs_erase_all(handle));
+    char key[16];
+
+    // A new value for each key on every run, so that every set writes to flash
+    int32_t base = esp_timer_get_time();
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < NVS_KEYS; i++) {
+        snprintf(key, sizeof(key), "key%d", i);
+        ESP_ERROR_CHECK(nvs_set_i32(handle, key, base + i));
+        ESP_ERROR_CHECK(nvs_commit(handle));
+    }
+    int64_t set_us = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (int i = 0; i < NVS_KEYS; i++) {
+        int32_t value;
+        snprintf(key, sizeof(key), "key%d", i);
+        ESP_ERROR_CHECK(nvs_get_i32(handle, key, &value));
+        if (value != base + i) {
+            ESP_LOGE(TAG, "%s: read %d, expected %d", key, (int) value, (int) (base + i));
+        }
+    }
+    int64_t get_us = esp_timer_get_time() - start;
+    nvs_close(handle);
+
+    BENCH_REPORT("nvs_set_i32_us", "%d us", (int)(set_us / NVS_KEYS));
+    BENCH_REPORT("nvs_get_i32_us", "%d us", (int)(get_us / NVS_KEYS));
+}
+
+void bench_flash(void)
+{
+    bench_spi_flash();
+    bench_nvs();
+}
@@ -0,0 +1,115 @@
+/* System benchmark example: FAT and SPIFFS file I/O
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_vfs_fat.h"
+#include "esp_spiffs.h"
+#include "sdkconfig.h"
+#include "benchmark.h"
+
+static const char *TAG = "bench_fs";
+
+#define FILE_SIZE       (128 * 1024)
+#define SEQ_CHUNK_SIZE  4096
+#define RAND_READ_SIZE  512
+#define RAND_READS      256
+
+static void bench_file(const char *path, const char *fs)
+{
+    uint8_t *buf = malloc(SEQ_CHUNK_SIZE);
+    if (buf == NULL) {
+        ESP_LOGE(TAG, "not enough memory");
+        return;
+    }
+    memset(buf, 0xa5, SEQ_CHUNK_SIZE);
+
+    int64_t start = esp_timer_get_time();
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        ESP_LOGE(TAG, "can't create %s", path);
+        free(buf);
+        return;
+    }
+    for (size_t done = 0; done < FILE_SIZE; done += SEQ_CHUNK_SIZE) {
+        fwrite(buf, 1, SEQ_CHUNK_SIZE, f);
+    }
+    fsync(fileno(f));
+    fclose(f);
+    int64_t write_us = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    f = fopen(path, "rb");
+    if (f == NULL) {
+        ESP_LOGE(TAG, "can't open %s", path);
+        free(buf);
+        return;
+    }
+    while (fread(buf, 1, SEQ_CHUNK_SIZE, f) == SEQ_CHUNK_SIZE) {
+    }
+    int64_t read_us = esp_timer_get_time() - start;
+
+    srand(1);
+    start = esp_timer_get_time();
+    for (int i = 0; i < RAND_READS; i++) {
+        fseek(f, rand() % (FILE_SIZE / RAND_READ_SIZE) * RAND_READ_SIZE, SEEK_SET);
+        fread(buf, 1, RAND_READ_SIZE, f);
+    }
+    int64_t rand_us = esp_timer_get_time() - start;
+    fclose(f);
+    unlink(path);
+    free(buf);
+
+    printf("[Performance][%s_seq_write_KBps]: %d KB/s\n", fs, bench_kbps(FILE_SIZE, write_us));
+    printf("[Performance][%s_seq_read_KBps]: %d KB/s\n", fs, bench_kbps(FILE_SIZE, read_us));
+    printf("[Performance][%s_rand_read_%d_us]: %d us\n", fs, RAND_READ_SIZE, (int)(rand_us / RAND_READS));
+}
+
+static void bench_fat(void)
+{
+    const esp_vfs_fat_mount_config_t config = {
+        .format_if_mount_failed = true,
+        .max_files = 2,
+        .allocation_unit_size = CONFIG_WL_SECTOR_SIZE,
+    };
+    wl_handle_t wl_handle;
+    esp_err_t err = esp_vfs_fat_spiflash_mount("/fat", "fat", &config, &wl_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "can't mount FAT partition (%s)", esp_err_to_name(err));
+        return;
+    }
+    bench_file("/fat/bench.bin", "fat");
+    esp_vfs_fat_spiflash_unmount("/fat", wl_handle);
+}
+
+static void bench_spiffs(void)
+{
+    const esp_vfs_spiffs_conf_t config = {
+        .base_path = "/spiffs",
+        .partition_label = "spiffs",
+        .max_files = 2,
+        .format_if_mount_failed = true,
+    };
+    esp_err_t err = esp_vfs_spiffs_register(&config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "can't mount SPIFFS partition (%s)", esp_err_to_name(err));
+        return;
+    }
+    bench_file("/spiffs/bench.bin", "spiffs");
+    esp_vfs_spiffs_unregister("spiffs");
+}
+
+void bench_fs(void)
+{
+    bench_fat();
+    bench_spiffs();
+}
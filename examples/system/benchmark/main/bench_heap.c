@@ -0,0 +1,85 @@
+/* System benchmark example: heap allocator
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "benchmark.h"
+
+static const char *TAG = "bench_heap";
+
+#define HEAP_BLOCKS     256
+#define HEAP_OPS        4096
+#define HEAP_MIN_SIZE   16
+#define HEAP_MAX_SIZE   512
+
+/*
+ Every other block stays allocated, so the free blocks between them can't be merged. The measured operations
+ then allocate and free blocks of random sizes into these holes, which is the allocation pattern of long
+ running applications.
+*/
+static int64_t run_ops(void **blocks, const uint16_t *sizes, const uint16_t *slots)
+{
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < HEAP_OPS; i++) {
+        void **block = &blocks[slots[i]];
+        if (*block != NULL) {
+            heap_caps_free(*block);
+            *block = NULL;
+        } else {
+            *block = heap_caps_malloc(sizes[i], MALLOC_CAP_8BIT);
+        }
+    }
+    return esp_timer_get_time() - start;
+}
+
+void bench_heap(void)
+{
+    void **blocks = calloc(HEAP_BLOCKS, sizeof(void *));
+    uint16_t *sizes = malloc(HEAP_OPS * sizeof(uint16_t));
+    uint16_t *slots = malloc(HEAP_OPS * sizeof(uint16_t));
+    if (blocks == NULL || sizes == NULL || slots == NULL) {
+        ESP_LOGE(TAG, "not enough memory");
+        goto out;
+    }
+    srand(1);
+    for (int i = 0; i < HEAP_OPS; i++) {
+        sizes[i] = HEAP_MIN_SIZE + rand() % (HEAP_MAX_SIZE - HEAP_MIN_SIZE);
+        slots[i] = 2 * (rand() % (HEAP_BLOCKS / 2)) + 1;
+    }
+
+    // Unfragmented: the holes are not there yet
+    int64_t us = run_ops(blocks, sizes, slots);
+    BENCH_REPORT("heap_malloc_free_ns", "%d ns", (int)(us * 1000 / HEAP_OPS));
+    for (int i = 0; i < HEAP_BLOCKS; i++) {
+        heap_caps_free(blocks[i]);
+        blocks[i] = NULL;
+    }
+
+    for (int i = 0; i < HEAP_BLOCKS; i++) {
+        blocks[i] = heap_caps_malloc(sizes[i], MALLOC_CAP_8BIT);
+    }
+    for (int i = 1; i < HEAP_BLOCKS; i += 2) {
+        heap_caps_free(blocks[i]);
+        blocks[i] = NULL;
+    }
+    ESP_LOGI(TAG, "fragmented heap: %d bytes free, largest free block %d bytes",
+             (int) heap_caps_get_free_size(MALLOC_CAP_8BIT), (int) heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    us = run_ops(blocks, sizes, slots);
+    BENCH_REPORT("heap_malloc_free_fragmented_ns", "%d ns", (int)(us * 1000 / HEAP_OPS));
+
+    for (int i = 0; i < HEAP_BLOCKS; i++) {
+        heap_caps_free(blocks[i]);
+    }
+out:
+    free(blocks);
+    free(sizes);
+    free(slots);
+}
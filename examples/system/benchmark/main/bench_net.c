@@ -0,0 +1,161 @@
+/* System benchmark example: lwIP TCP and UDP over the loopback interface
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "tcpip_adapter.h"
+#include "lwip/sockets.h"
+#include "benchmark.h"
+
+static const char *TAG = "bench_net";
+
+#define TCP_PORT        5001
+#define UDP_PORT        5002
+#define TCP_BYTES       (1024 * 1024)
+#define TCP_CHUNK_SIZE  4096
+#define UDP_SIZE        256
+#define UDP_SAMPLES     500
+
+static SemaphoreHandle_t s_done;
+
+static struct sockaddr_in loopback_addr(int port)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    return addr;
+}
+
+static void tcp_server(void *arg)
+{
+    int listener = (int)arg;
+    char *buf = malloc(TCP_CHUNK_SIZE);
+    int sock = accept(listener, NULL, NULL);
+    if (sock >= 0 && buf != NULL) {
+        while (recv(sock, buf, TCP_CHUNK_SIZE, 0) > 0) {
+        }
+        close(sock);
+    }
+    free(buf);
+    xSemaphoreGive(s_done);
+    vTaskDelete(NULL);
+}
+
+static void bench_tcp(void)
+{
+    struct sockaddr_in addr = loopback_addr(TCP_PORT);
+    int listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    char *buf = calloc(1, TCP_CHUNK_SIZE);
+    if (listener < 0 || sock < 0 || buf == NULL ||
+            bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listener, 1) != 0) {
+        ESP_LOGE(TAG, "can't set up TCP sockets");
+        goto out;
+    }
+    xTaskCreate(tcp_server, "tcp_server", 3072, (void *)listener, 5, NULL);
+
+    int64_t start = esp_timer_get_time();
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        ESP_LOGE(TAG, "can't connect over loopback, is CONFIG_LWIP_NETIF_LOOPBACK enabled?");
+        // wakes the server from accept()
+        close(listener);
+        listener = -1;
+        xSemaphoreTake(s_done, 1000 / portTICK_PERIOD_MS);
+        goto out;
+    }
+    for (size_t sent = 0; sent < TCP_BYTES; sent += TCP_CHUNK_SIZE) {
+        if (send(sock, buf, TCP_CHUNK_SIZE, 0) != TCP_CHUNK_SIZE) {
+            ESP_LOGE(TAG, "send failed");
+            break;
+        }
+    }
+    close(sock);
+    sock = -1;
+    xSemaphoreTake(s_done, portMAX_DELAY);
+    BENCH_REPORT("tcp_loopback_KBps", "%d KB/s", bench_kbps(TCP_BYTES, esp_timer_get_time() - start));
+out:
+    if (sock >= 0) {
+        close(sock);
+    }
+    if (listener >= 0) {
+        close(listener);
+    }
+    free(buf);
+}
+
+static void udp_echo(void *arg)
+{
+    int sock = (int)arg;
+    char buf[UDP_SIZE];
+    for (int i = 0; i < UDP_SAMPLES; i++) {
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        int len = recvfrom(sock, buf, sizeof(buf), 0, (struct sockaddr *)&from, &from_len);
+        if (len < 0) {
+            break;
+        }
+        sendto(sock, buf, len, 0, (struct sockaddr *)&from, from_len);
+    }
+    xSemaphoreGive(s_done);
+    vTaskDelete(NULL);
+}
+
+static void bench_udp(void)
+{
+    struct sockaddr_in addr = loopback_addr(UDP_PORT);
+    int server = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    uint32_t *rtt = calloc(UDP_SAMPLES, sizeof(uint32_t));
+    if (server < 0 || sock < 0 || rtt == NULL || bind(server, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        ESP_LOGE(TAG, "can't set up UDP sockets");
+        goto out;
+    }
+    // a lost datagram must not stall the benchmark
+    struct timeval timeout = { .tv_sec = 1 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(server, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    xTaskCreate(udp_echo, "udp_echo", 3072, (void *)server, 5, NULL);
+
+    char buf[UDP_SIZE] = { 0 };
+    int received = 0;
+    for (int i = 0; i < UDP_SAMPLES; i++) {
+        int64_t start = esp_timer_get_time();
+        sendto(sock, buf, sizeof(buf), 0, (struct sockaddr *)&addr, sizeof(addr));
+        if (recv(sock, buf, sizeof(buf), 0) == sizeof(buf)) {
+            rtt[received++] = esp_timer_get_time() - start;
+        }
+    }
+    xSemaphoreTake(s_done, portMAX_DELAY);
+    ESP_LOGI(TAG, "UDP: %d of %d datagrams echoed", received, UDP_SAMPLES);
+    BENCH_REPORT("udp_loopback_rtt_us", "%d us", bench_median(rtt, received));
+out:
+    if (sock >= 0) {
+        close(sock);
+    }
+    if (server >= 0) {
+        close(server);
+    }
+    free(rtt);
+}
+
+void bench_net(void)
+{
+    tcpip_adapter_init();
+    s_done = xSemaphoreCreateBinary();
+    bench_tcp();
+    bench_udp();
+    vSemaphoreDelete(s_done);
+}
@@ -0,0 +1,158 @@
+/* System benchmark example: FreeRTOS queues and the event loop
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_event.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "benchmark.h"
+
+static const char *TAG = "bench_rtos";
+
+#define LATENCY_SAMPLES 1000
+#define EVENT_POSTS     2000
+
+/* The receiving side runs on the other core if there is one, so the latencies include the cross-core wakeup */
+#define RECEIVER_CORE   (portNUM_PROCESSORS - 1)
+#define SENDER_CORE     0
+
+typedef struct {
+    QueueHandle_t queue;
+    SemaphoreHandle_t done;
+    uint32_t *latency;
+    int count;
+} queue_ctx_t;
+
+static void queue_receiver(void *arg)
+{
+    queue_ctx_t *ctx = (queue_ctx_t *)arg;
+    int64_t sent;
+    for (int i = 0; i < LATENCY_SAMPLES; i++) {
+        xQueueReceive(ctx->queue, &sent, portMAX_DELAY);
+        ctx->latency[i] = esp_timer_get_time() - sent;
+    }
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+static void queue_sender(void *arg)
+{
+    queue_ctx_t *ctx = (queue_ctx_t *)arg;
+    for (int i = 0; i < LATENCY_SAMPLES; i++) {
+        int64_t now = esp_timer_get_time();
+        xQueueSend(ctx->queue, &now, portMAX_DELAY);
+        // let the receiver pick up each item on its own
+        vTaskDelay(1);
+    }
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+static void bench_queue(void)
+{
+    queue_ctx_t ctx = {
+        .queue = xQueueCreate(1, sizeof(int64_t)),
+        .done = xSemaphoreCreateCounting(2, 0),
+        .latency = calloc(LATENCY_SAMPLES, sizeof(uint32_t)),
+    };
+    if (ctx.queue == NULL || ctx.done == NULL || ctx.latency == NULL) {
+        ESP_LOGE(TAG, "not enough memory");
+        goto out;
+    }
+    xTaskCreatePinnedToCore(queue_receiver, "receiver", 2048, &ctx, 10, NULL, RECEIVER_CORE);
+    xTaskCreatePinnedToCore(queue_sender, "sender", 2048, &ctx, 9, NULL, SENDER_CORE);
+    xSemaphoreTake(ctx.done, portMAX_DELAY);
+    xSemaphoreTake(ctx.done, portMAX_DELAY);
+    BENCH_REPORT("xQueueSend_cross_core_latency_us", "%d us", bench_median(ctx.latency, LATENCY_SAMPLES));
+out:
+    if (ctx.queue) {
+        vQueueDelete(ctx.queue);
+    }
+    if (ctx.done) {
+        vSemaphoreDelete(ctx.done);
+    }
+    free(ctx.latency);
+}
+
+ESP_EVENT_DEFINE_BASE(BENCH_EVENTS);
+
+typedef struct {
+    uint32_t *latency;
+    int received;
+    SemaphoreHandle_t done;
+} event_ctx_t;
+
+static void event_handler(void *arg, esp_event_base_t base, int32_t id, void *data)
+{
+    event_ctx_t *ctx = (event_ctx_t *)arg;
+    int64_t latency = esp_timer_get_time() - *(int64_t *)data;
+    if (ctx->received < LATENCY_SAMPLES) {
+        ctx->latency[ctx->received] = latency;
+    }
+    if (++ctx->received == EVENT_POSTS) {
+        xSemaphoreGive(ctx->done);
+    }
+}
+
+static void bench_event(void)
+{
+    esp_event_loop_args_t args = {
+        .queue_size = 32,
+        .task_name = "bench_loop",
+        .task_priority = 10,
+        .task_stack_size = 2048,
+        .task_core_id = RECEIVER_CORE,
+    };
+    event_ctx_t ctx = {
+        .latency = calloc(LATENCY_SAMPLES, sizeof(uint32_t)),
+        .done = xSemaphoreCreateBinary(),
+    };
+    esp_event_loop_handle_t loop = NULL;
+    if (ctx.latency == NULL || ctx.done == NULL || esp_event_loop_create(&args, &loop) != ESP_OK) {
+        ESP_LOGE(TAG, "not enough memory");
+        goto out;
+    }
+    ESP_ERROR_CHECK(esp_event_handler_register_with(loop, BENCH_EVENTS, ESP_EVENT_ANY_ID, event_handler, &ctx));
+
+    // Latency: one event at a time
+    for (int i = 0; i < LATENCY_SAMPLES; i++) {
+        int64_t now = esp_timer_get_time();
+        esp_event_post_to(loop, BENCH_EVENTS, 0, &now, sizeof(now), portMAX_DELAY);
+        vTaskDelay(1);
+    }
+    // Throughput: as fast as the loop dispatches them
+    int64_t start = esp_timer_get_time();
+    for (int i = LATENCY_SAMPLES; i < EVENT_POSTS; i++) {
+        int64_t now = esp_timer_get_time();
+        esp_event_post_to(loop, BENCH_EVENTS, 0, &now, sizeof(now), portMAX_DELAY);
+    }
+    xSemaphoreTake(ctx.done, portMAX_DELAY);
+    int64_t us = esp_timer_get_time() - start;
+
+    BENCH_REPORT("esp_event_post_latency_us", "%d us", bench_median(ctx.latency, LATENCY_SAMPLES));
+    BENCH_REPORT("esp_event_post_per_sec", "%d", (int)((EVENT_POSTS - LATENCY_SAMPLES) * 1000000LL / us));
+out:
+    if (loop) {
+        esp_event_loop_delete(loop);
+    }
+    if (ctx.done) {
+        vSemaphoreDelete(ctx.done);
+    }
+    free(ctx.latency);
+}
+
+void bench_rtos(void)
+{
+    bench_queue();
+    bench_event();
+}
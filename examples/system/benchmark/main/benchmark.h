@@ -0,0 +1,32 @@
+/* System benchmark example
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Prints one result, in the format collected by the example test runner */
+#define BENCH_REPORT(name, value_fmt, value) \
+    printf("[Performance][" name "]: " value_fmt "\n", value)
+
+/* Median of samples, sorts the array */
+uint32_t bench_median(uint32_t *samples, size_t count);
+
+/* Throughput in KB/s of moving 'bytes' in 'us' microseconds */
+static inline int bench_kbps(size_t bytes, int64_t us)
+{
+    return us > 0 ? (int)((int64_t)bytes * 1000000 / 1024 / us) : 0;
+}
+
+void bench_heap(void);
+void bench_rtos(void);
+void bench_flash(void);
+void bench_fs(void);
+void bench_net(void);
+void bench_crypto(void);
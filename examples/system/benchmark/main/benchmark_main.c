@@ -0,0 +1,57 @@
+/* System benchmark example
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "benchmark.h"
+
+static const char *TAG = "benchmark";
+
+static int compare_samples(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+uint32_t bench_median(uint32_t *samples, size_t count)
+{
+    if (count == 0) {
+        return 0;
+    }
+    qsort(samples, count, sizeof(uint32_t), compare_samples);
+    return samples[count / 2];
+}
+
+static const struct {
+    const char *name;
+    void (*run)(void);
+} s_benchmarks[] = {
+    { "heap", bench_heap },
+    { "FreeRTOS and event loop", bench_rtos },
+    { "SPI flash and NVS", bench_flash },
+    { "FAT and SPIFFS", bench_fs },
+    { "lwIP loopback", bench_net },
+    { "AES and SHA", bench_crypto },
+};
+
+void app_main()
+{
+    printf("IDF version: %s\n", esp_get_idf_version());
+    for (int i = 0; i < sizeof(s_benchmarks) / sizeof(s_benchmarks[0]); i++) {
+        ESP_LOGI(TAG, "Running %s benchmarks", s_benchmarks[i].name);
+        s_benchmarks[i].run();
+        // let lower priority tasks (idle task, pending deletions) run between benchmarks
+        vTaskDelay(10 / portTICK_PERIOD_MS);
+    }
+    ESP_LOGI(TAG, "Benchmarks done");
+}
@@ -40,6 +40,9 @@ static void register_light_sleep();
 #if WITH_TASKS_INFO
 static void register_tasks();
 #endif
+#if CONFIG_SPI_FLASH_ENABLE_COUNTERS
+static void register_flash_stats();
+#endif
 
 void register_system()
 {
@@ -52,6 +55,9 @@ void register_system()
 #if WITH_TASKS_INFO
     register_tasks();
 #endif
+#if CONFIG_SPI_FLASH_ENABLE_COUNTERS
+    register_flash_stats();
+#endif
 }
 
 /* 'version' command */
@@ -177,6 +183,48 @@ static void register_tasks()
 
 #endif // WITH_TASKS_INFO
 
+/** 'flash_stats' command prints SPI flash operation counters and latency histograms */
+#if CONFIG_SPI_FLASH_ENABLE_COUNTERS
+
+static struct {
+    struct arg_lit *reset;
+    struct arg_end *end;
+} flash_stats_args;
+
+static int flash_stats(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **) &flash_stats_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, flash_stats_args.end, argv[0]);
+        return 1;
+    }
+    spi_flash_dump_counters();
+#if CONFIG_SPI_FLASH_ENABLE_HISTOGRAMS
+    spi_flash_dump_histograms();
+#endif
+    if (flash_stats_args.reset->count) {
+        spi_flash_reset_counters();
+    }
+    return 0;
+}
+
+static void register_flash_stats()
+{
+    flash_stats_args.reset = arg_lit0("r", "reset", "Reset counters after printing them");
+    flash_stats_args.end = arg_end(1);
+
+    const esp_console_cmd_t cmd = {
+        .command = "flash_stats",
+        .help = "Print SPI flash operation counters and latency histograms",
+        .hint = NULL,
+        .func = &flash_stats,
+        .argtable = &flash_stats_args
+    };
+    ESP_ERROR_CHECK( esp_console_cmd_register(&cmd) );
+}
+
+#endif // CONFIG_SPI_FLASH_ENABLE_COUNTERS
+
 /** 'deep_sleep' command puts the chip into deep sleep mode */
 
 static struct {
@@ -111,6 +111,41 @@ static int connect(int argc, char **argv)
     return 0;
 }
 
+/** 'netstat' command prints the traffic counters of the network interfaces */
+
+static struct {
+    struct arg_lit *reset;
+    struct arg_end *end;
+} netstat_args;
+
+static int netstat(int argc, char **argv)
+{
+    static const char *if_names[TCPIP_ADAPTER_IF_MAX] = { "sta", "ap", "eth" };
+
+    int nerrors = arg_parse(argc, argv, (void **) &netstat_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, netstat_args.end, argv[0]);
+        return 1;
+    }
+    for (int i = 0; i < TCPIP_ADAPTER_IF_MAX; i++) {
+        tcpip_adapter_if_stats_t stats;
+        esp_err_t err = tcpip_adapter_get_if_stats(i, &stats);
+        if (err != ESP_OK) {
+            ESP_LOGW(__func__, "Interface counters not available: %s", esp_err_to_name(err));
+            return 1;
+        }
+        printf("%s: rx %u packets %llu bytes, tx %u packets %llu bytes\n", if_names[i],
+               stats.rx_packets, stats.rx_bytes, stats.tx_packets, stats.tx_bytes);
+        printf("  dropped: rx queue full %u, tx driver %u\n", stats.rx_drop_queue_full, stats.tx_drop_driver);
+        printf("  rx queued %u (max %u), latency avg %u us max %u us\n", stats.rx_queued, stats.rx_queued_max,
+               stats.rx_latency_avg_us, stats.rx_latency_max_us);
+        if (netstat_args.reset->count) {
+            tcpip_adapter_reset_if_stats(i);
+        }
+    }
+    return 0;
+}
+
 void register_wifi()
 {
     join_args.timeout = arg_int0(NULL, "timeout", "<t>", "Connection timeout, ms");
@@ -127,4 +162,17 @@ void register_wifi()
     };
 
     ESP_ERROR_CHECK( esp_console_cmd_register(&join_cmd) );
+
+    netstat_args.reset = arg_lit0("r", "reset", "Reset counters after printing them");
+    netstat_args.end = arg_end(1);
+
+    const esp_console_cmd_t netstat_cmd = {
+        .command = "netstat",
+        .help = "Print the traffic counters of the network interfaces",
+        .hint = NULL,
+        .func = &netstat,
+        .argtable = &netstat_args
+    };
+
+    ESP_ERROR_CHECK( esp_console_cmd_register(&netstat_cmd) );
 }
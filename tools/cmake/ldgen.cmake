@@ -50,6 +50,12 @@ function(ldgen_process_template template output)
     file(GENERATE OUTPUT ${CMAKE_BINARY_DIR}/ldgen.section_infos
         CONTENT "$<JOIN:$<TARGET_PROPERTY:ldgen_section_infos,SECTIONS_INFO_FILES>,\n>")
 
+    # Optional third argument: ordering file for the code placed in flash
+    set(order_file "${ARGV2}")
+    if(order_file)
+        set(order_args --order ${order_file})
+    endif()
+
     # Create command to invoke the linker script generator tool.
     add_custom_command(
         OUTPUT ${output}
@@ -65,8 +71,9 @@ function(ldgen_process_template template output)
         --env       "IDF_CMAKE=y"
         --env       "IDF_PATH=${IDF_PATH}"
         --env       "IDF_TARGET=${IDF_TARGET}"
+        ${order_args}
         DEPENDS     ${template} $<TARGET_PROPERTY:ldgen,FRAGMENT_FILES> ${SDKCONFIG}
-                    ldgen_section_infos
+                    ldgen_section_infos ${order_file}
     )
 
     get_filename_component(output_name ${output} NAME)
@@ -0,0 +1,162 @@
+#!/usr/bin/env python
+#
+# Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# Splits GCOV data stream dumped by esp_gcov_dump() (CONFIG_ESP32_GCOV_DUMP_STREAM) into .gcda files.
+#
+# Stream consists of dumps. Every dump starts with header:
+#   u32 magic ("COVS"), u32 version
+# followed by records, every record starts with type byte:
+#   FILE_OPEN (1):  u16 path length, path
+#   FILE_WRITE (2): u32 offset in file, u32 data length, data
+#   FILE_CLOSE (3)
+#   DUMP_END (4)
+# All numbers are little endian.
+
+from __future__ import print_function
+import argparse
+import os
+import struct
+import sys
+
+
+GCOV_STREAM_MAGIC = 0x53564f43
+GCOV_STREAM_VERSION = 1
+GCOV_REC_FILE_OPEN = 0x1
+GCOV_REC_FILE_WRITE = 0x2
+GCOV_REC_FILE_CLOSE = 0x3
+GCOV_REC_DUMP_END = 0x4
+
+
+class ESPGcovTraceParserError(RuntimeError):
+    def __init__(self, message):
+        RuntimeError.__init__(self, message)
+
+
+class ESPGcovFile(object):
+    def __init__(self, path):
+        super(ESPGcovFile, self).__init__()
+        self.path = path
+        self.data = bytearray()
+
+    def write(self, off, data):
+        if off > len(self.data):
+            self.data += bytearray(off - len(self.data))
+        self.data[off:off + len(data)] = data
+
+
+def gcovtrace_parse(fname):
+    """
+        Parses GCOV stream, returns list of dumps. Every dump is a list of files in the order of their closure.
+    """
+    try:
+        with open(fname, 'rb') as ftrc:
+            trc = ftrc.read()
+    except (OSError, IOError) as e:
+        raise ESPGcovTraceParserError("Failed to read trace file (%s)!" % e)
+
+    def unpack(fmt, off):
+        sz = struct.calcsize(fmt)
+        if off + sz > len(trc):
+            raise ESPGcovTraceParserError("Unexpected end of trace at %d!" % off)
+        return struct.unpack_from(fmt, trc, off), off + sz
+
+    dumps = []
+    off = 0
+    while off < len(trc):
+        (magic, ver), off = unpack('<LL', off)
+        if magic != GCOV_STREAM_MAGIC:
+            raise ESPGcovTraceParserError("Invalid dump magic 0x%x at %d!" % (magic, off - 8))
+        if ver != GCOV_STREAM_VERSION:
+            raise ESPGcovTraceParserError("Unsupported stream version %d!" % ver)
+        files = []
+        cur = None
+        while True:
+            (rec,), off = unpack('<B', off)
+            if rec == GCOV_REC_FILE_OPEN:
+                (path_len,), off = unpack('<H', off)
+                (path,), off = unpack('<%ds' % path_len, off)
+                cur = ESPGcovFile(path.decode('utf-8'))
+            elif rec == GCOV_REC_FILE_WRITE:
+                (data_off, data_len), off = unpack('<LL', off)
+                (data,), off = unpack('<%ds' % data_len, off)
+                if cur is None:
+                    raise ESPGcovTraceParserError("Write to not opened file at %d!" % off)
+                cur.write(data_off, data)
+            elif rec == GCOV_REC_FILE_CLOSE:
+                if cur is None:
+                    raise ESPGcovTraceParserError("Close of not opened file at %d!" % off)
+                files.append(cur)
+                cur = None
+            elif rec == GCOV_REC_DUMP_END:
+                break
+            else:
+                raise ESPGcovTraceParserError("Invalid record type %d at %d!" % (rec, off - 1))
+        dumps.append(files)
+    return dumps
+
+
+def gcov_file_path(path, strip, prefix):
+    """
+        Maps path of file on target to the host one the same way as GCOV_PREFIX_STRIP and GCOV_PREFIX do
+    """
+    if strip:
+        parts = [p for p in path.split('/') if p]
+        path = '/'.join(parts[strip:])
+        if not prefix:
+            return path
+    if prefix:
+        return os.path.join(prefix, path.lstrip('/'))
+    return path
+
+
+def main():
+    parser = argparse.ArgumentParser(description='ESP32 GCOV Stream Splitting Tool')
+
+    parser.add_argument('trace_file', help='Path to GCOV stream file', type=str)
+    parser.add_argument('--prefix', '-p', help='Directory to put data files to (like GCOV_PREFIX)', type=str, default='')
+    parser.add_argument('--strip', '-s', help='Number of leading path components to strip (like GCOV_PREFIX_STRIP)',
+                        type=int, default=0)
+    parser.add_argument('--dump', '-d', help='Index of dump to save, the last one by default', type=int, default=-1)
+    args = parser.parse_args()
+
+    try:
+        print("Parse trace file '%s'..." % args.trace_file)
+        dumps = gcovtrace_parse(args.trace_file)
+        print("Parsing completed.")
+    except ESPGcovTraceParserError as e:
+        print("Failed to parse GCOV stream (%s)!" % e)
+        sys.exit(2)
+    print("Dumps found: %d" % len(dumps))
+    if not dumps:
+        return
+    try:
+        files = dumps[args.dump]
+    except IndexError:
+        print("No dump %d in stream!" % args.dump)
+        sys.exit(2)
+    # every dump holds data collected since the start, so the selected one replaces existing files
+    for f in files:
+        path = gcov_file_path(f.path, args.strip, args.prefix)
+        print("Write %d bytes to '%s'" % (len(f.data), path))
+        dirname = os.path.dirname(path)
+        if dirname and not os.path.isdir(dirname):
+            os.makedirs(dirname)
+        with open(path, 'wb') as fout:
+            fout.write(f.data)
+
+
+if __name__ == '__main__':
+    main()
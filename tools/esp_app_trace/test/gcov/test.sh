@@ -0,0 +1,10 @@
+#! /bin/bash
+
+{ coverage debug sys \
+    && coverage erase &> output \
+    && rm -rf out \
+    && coverage run -a $IDF_PATH/tools/esp_app_trace/gcovtrace_proc.py -p out -s 2 gcov.trc &>> output \
+    && diff output expected_output \
+    && diff -r out expected \
+    && coverage report \
+; } || { echo 'The test for gcovtrace_proc has failed. Please examine the artifacts.' ; exit 1; }
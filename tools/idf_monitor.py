@@ -43,6 +43,7 @@ try:
 except ImportError:
     import Queue as queue
 import shlex
+import struct
 import time
 import sys
 import serial
@@ -301,6 +302,150 @@ class SerialStopException(Exception):
     pass
 
 
+class BinaryLogDecoder(object):
+    """
+    Converts binary log frames (CONFIG_LOG_BINARY) in the serial output back to text.
+
+    A frame is ESC 'b', the length of the encoded payload and the COBS encoded payload. The payload holds the
+    address of the format string and the raw values of the arguments. Format strings and string arguments which are
+    in flash are read from the ELF file.
+    """
+    FRAME_START = b'\033b'
+    RE_SPEC = re.compile(r'%([-+ #0]*)(\*|[0-9]+)?(?:\.(\*|[0-9]*))?(hh|h|ll|l|L|j|z|t)?([diouxXcpeEfFgGaAsn%])')
+
+    def __init__(self, elf_file):
+        self.elf_file = elf_file
+        self._sections = None
+        self._buffer = bytearray()
+
+    def feed(self, data):
+        """ Returns data with the complete frames replaced by text, keeps incomplete frames for the next call """
+        self._buffer += data
+        out = bytearray()
+        while True:
+            start = self._buffer.find(self.FRAME_START)
+            if start < 0:
+                # a trailing ESC can be the beginning of a frame
+                keep = 1 if self._buffer.endswith(b'\033') else 0
+                out += self._buffer[:len(self._buffer) - keep]
+                self._buffer = self._buffer[len(self._buffer) - keep:]
+                break
+            out += self._buffer[:start]
+            self._buffer = self._buffer[start:]
+            if len(self._buffer) < 3 or len(self._buffer) < 3 + self._buffer[2]:
+                break
+            end = 3 + self._buffer[2]
+            out += self._decode(self._buffer[3:end])
+            self._buffer = self._buffer[end:]
+        return bytes(out)
+
+    def _decode(self, encoded):
+        try:
+            return self._format(self._cobs_decode(encoded)).encode('latin-1')
+        except (struct.error, ValueError, TypeError, IndexError, IOError) as e:
+            return ('--- binary log frame cannot be decoded: %s\n' % e).encode('latin-1')
+
+    @staticmethod
+    def _cobs_decode(encoded):
+        out = bytearray()
+        i = 0
+        while i < len(encoded):
+            code = encoded[i]
+            if code == 0:
+                raise ValueError('invalid encoding')
+            out += encoded[i + 1:i + code]
+            i += code
+            if code < 0xff and i < len(encoded):
+                out.append(0)
+        return out
+
+    def _load_sections(self):
+        self._sections = []
+        with open(self.elf_file, 'rb') as f:
+            data = f.read()
+        ident = bytearray(data[:6])
+        if ident[:4] != b'\x7fELF':
+            raise ValueError('%s is not an ELF file' % self.elf_file)
+        endian = '<' if ident[5] == 1 else '>'
+        if ident[4] == 2:  # ELFCLASS64
+            shoff, = struct.unpack_from(endian + 'Q', data, 0x28)
+            shentsize, shnum = struct.unpack_from(endian + 'HH', data, 0x3a)
+            header = endian + 'IIQQQQ'
+        else:
+            shoff, = struct.unpack_from(endian + 'I', data, 0x20)
+            shentsize, shnum = struct.unpack_from(endian + 'HH', data, 0x2e)
+            header = endian + 'IIIIII'
+        for i in range(shnum):
+            _, sh_type, flags, addr, offset, size = struct.unpack_from(header, data, shoff + i * shentsize)
+            if sh_type == 1 and flags & 2:  # SHT_PROGBITS with SHF_ALLOC
+                self._sections.append((addr, data[offset:offset + size]))
+
+    def _read_string(self, addr):
+        if self._sections is None:
+            self._load_sections()
+        for start, data in self._sections:
+            if start <= addr < start + len(data):
+                end = data.find(b'\0', addr - start)
+                return bytearray(data[addr - start:end if end >= 0 else len(data)]).decode('latin-1')
+        raise ValueError('no string at address 0x%08x' % addr)
+
+    def _format(self, payload):
+        fmt = self._read_string(struct.unpack_from('<I', payload, 0)[0])
+        pos = 4
+        result = []
+        last = 0
+        for m in self.RE_SPEC.finditer(fmt):
+            result.append(fmt[last:m.start()])
+            last = m.end()
+            flags, width, precision, length, conv = m.groups()
+            if conv == '%':
+                result.append('%')
+                continue
+            if width == '*':
+                width = str(struct.unpack_from('<i', payload, pos)[0])
+                pos += 4
+            if precision == '*':
+                precision = str(struct.unpack_from('<i', payload, pos)[0])
+                pos += 4
+            spec = '%' + flags + (width or '') + ('.' + precision if precision is not None else '')
+            if conv in 'diouxXc':
+                size = 8 if length in ('ll', 'j') else 4
+                value, = struct.unpack_from('<Q' if size == 8 else '<I', payload, pos)
+                pos += size
+                bits = {'hh': 8, 'h': 16}.get(length, size * 8)
+                value &= (1 << bits) - 1
+                if conv in 'di' and value >> (bits - 1):
+                    value -= 1 << bits
+                if conv == 'c':
+                    result.append((spec + 'c') % chr(value & 0xff))
+                else:
+                    result.append((spec + ('d' if conv in 'diu' else conv)) % value)
+            elif conv == 'p':
+                value, = struct.unpack_from('<I', payload, pos)
+                pos += 4
+                result.append((spec + 's') % ('0x%x' % value))
+            elif conv in 'eEfFgGaA':
+                value, = struct.unpack_from('<d', payload, pos)
+                pos += 8
+                result.append((spec + (conv if conv not in 'aA' else 'e')) % value)
+            elif conv == 's':
+                kind = payload[pos]
+                pos += 1
+                if kind == 1:
+                    addr, = struct.unpack_from('<I', payload, pos)
+                    pos += 4
+                    value = self._read_string(addr) if addr != 0 else '(null)'
+                elif kind == 2:
+                    end = payload.index(b'\0', pos)
+                    value = payload[pos:end].decode('latin-1')
+                    pos = end + 1
+                else:
+                    raise ValueError('invalid string argument')
+                result.append((spec + 's') % value)
+        result.append(fmt[last:])
+        return ''.join(result)
+
+
 class Monitor(object):
     """
     Monitor application main class.
@@ -359,6 +504,7 @@ class Monitor(object):
         self._output_enabled = True
         self._serial_check_exit = socket_mode
         self._log_file = None
+        self._binary_log = BinaryLogDecoder(self.elf_file)
 
     def invoke_processing_last_line(self):
         self.event_queue.put((TAG_SERIAL_FLUSH, b''), False)
@@ -419,6 +565,7 @@ class Monitor(object):
                 pass  # this can happen if a non-ascii character was passed, ignoring
 
     def handle_serial_input(self, data, finalize_line=False):
+        data = self._binary_log.feed(data)
         sp = data.split(b'\n')
         if self._last_line_part != b"":
             # add unprocessed part from previous "data" to the first line
@@ -23,6 +23,7 @@
 from __future__ import print_function
 from __future__ import unicode_literals
 import argparse
+import bisect
 import re
 import os.path
 
@@ -125,6 +126,14 @@ def load_sections(map_file):
             source["file"] = "%s:%s" % (source["archive"], source["object_file"])
             section["sources"] += [source]
 
+        # symbol defined in the input section of the previous source line, ie
+        #                 0x00000000400d2724                app_main
+        RE_SYMBOL_DEF_LINE = r"^\s+0x(?P<address>[\da-f]+) +(?P<name>[A-Za-z_.$][\w.$]*)$"
+        m = re.match(RE_SYMBOL_DEF_LINE, line)
+        if section is not None and m is not None and len(section["sources"]) > 0:
+            section["sources"][-1].setdefault("symbols", []).append((int(m.group("address"), 16), m.group("name")))
+            continue
+
         # In some cases the section name appears on the previous line, back it up in here
         RE_SYMBOL_ONLY_LINE = r"^ (?P<sym_name>\S*)$"
         m = re.match(RE_SYMBOL_ONLY_LINE, line)
@@ -173,7 +182,31 @@ def main():
     parser.add_argument(
         '--files', help='Print per-file sizes', action='store_true')
 
+    parser.add_argument(
+        '--symbols', help='Print the N largest symbols in IRAM and in DRAM', type=int, metavar='N')
+
+    parser.add_argument(
+        '--profile', help='Rank functions by profile samples per byte, to choose which ones to place in IRAM. '
+        'The file has one sample per line, as an address optionally followed by a count of samples, '
+        'or a function name followed by a count of samples',
+        type=argparse.FileType('r'))
+
+    parser.add_argument(
+        '--iram-budget', help='IRAM bytes to fill with hot functions (default: the IRAM still available)', type=int)
+
+    parser.add_argument(
+        '--emit-fragment', help='Write a linker fragment placing the hot functions which fit into the IRAM budget '
+        'in IRAM (requires --profile)', type=argparse.FileType('w'))
+
+    parser.add_argument(
+        '--emit-order', help='Write an ldgen ordering file listing the sampled functions in flash, hottest first, '
+        'to place them contiguously (requires --profile)', type=argparse.FileType('w'))
+
     args = parser.parse_args()
+    if args.emit_fragment and not args.profile:
+        parser.error("--emit-fragment requires --profile")
+    if args.emit_order and not args.profile:
+        parser.error("--emit-order requires --profile")
 
     memory_config, sections = load_map_data(args.map_file)
     print_summary(memory_config, sections)
@@ -187,6 +220,19 @@ def main():
     if args.archive_details:
         print("Symbols within the archive:", args.archive_details, "(Not all symbols may be reported)")
         print_archive_symbols(sections, args.archive_details)
+    if args.symbols:
+        print_largest_symbols(memory_config, sections, args.symbols)
+    if args.profile:
+        functions = load_profile(args.profile, sections)
+        budget = args.iram_budget
+        if budget is None:
+            budget = memory_config["iram0_0_seg"]["length"] - sum(sections[s]["size"] for s in sections if s.startswith(".iram0"))
+        hot = print_profile(functions, budget)
+        if args.emit_fragment:
+            write_fragment(args.emit_fragment, hot)
+        if args.emit_order:
+            # functions moved to IRAM by the fragment don't need to be ordered in flash
+            write_order(args.emit_order, functions, hot if args.emit_fragment else [])
 
 
 def print_summary(memory_config, sections):
@@ -288,5 +334,198 @@ def print_archive_symbols(sections, archive):
         print("\nSection total:",section_total)
 
 
+IRAM_SECTIONS = [".iram0.vectors", ".iram0.text"]
+DRAM_SECTIONS = [".dram0.data", ".dram0.bss"]
+# number of IRAM functions without samples to list, as candidates to move back to flash
+PROFILE_COLD_COUNT = 10
+RE_SECTION_PREFIX = r"^\.(text|literal|iram1|iram|data|bss|rodata|dram1|sbss|sdata)\."
+
+
+def split_source(source):
+    """ Splits the input section of 'source' into the functions or variables it holds
+
+    Yields tuples (name, own_section, address, size). own_section is True if the input section holds only this
+    symbol (i.e. the code was compiled with -ffunction-sections/-fdata-sections), so that ldgen can place it on its
+    own. Otherwise the input section is split at the symbols defined in it, as listed in the map file.
+    """
+    m = re.match(RE_SECTION_PREFIX + r"(?P<name>.+)$", source["sym_name"])
+    if m is not None and not re.match(r"^(literal|\d+|str1\.\d+|cst\d+)$", m.group("name")):
+        yield m.group("name"), True, source["address"], source["size"]
+        return
+    end = source["address"] + source["size"]
+    symbols = sorted(sym for sym in source.get("symbols", []) if source["address"] <= sym[0] < end)
+    if len(symbols) == 0:
+        yield source["sym_name"], False, source["address"], source["size"]
+        return
+    # any bytes before the first symbol are counted to it
+    starts = [source["address"]] + [sym[0] for sym in symbols[1:]] + [end]
+    for i, (address, name) in enumerate(symbols):
+        if starts[i + 1] > starts[i]:  # aliases at the same address are counted once
+            yield name, False, starts[i], starts[i + 1] - starts[i]
+
+
+def object_name(object_file):
+    """ Object name as used in linker fragments: 'app_main' for 'app_main.o' or 'app_main.c.obj' """
+    return re.sub(r"(\.c)?\.o(bj)?$", "", object_file)
+
+
+def load_symbols(sections, section_names):
+    """ Returns a dict keyed by (archive, object_file, name) of the symbols in the given output sections,
+    and a list of (address, size, symbol) for all parts of the symbols.
+
+    The sizes of the input sections of one symbol (e.g. '.text.foo' and '.literal.foo') are added up.
+    """
+    result = {}
+    parts = []
+    for section_name in section_names:
+        for s in sections.get(section_name, {"sources": []})["sources"]:
+            for name, own_section, address, size in split_source(s):
+                key = (s["archive"], s["object_file"], name)
+                if key not in result:
+                    result[key] = {
+                        "name": name,
+                        "archive": s["archive"],
+                        "object_file": s["object_file"],
+                        "section": section_name,
+                        "own_section": own_section,
+                        "size": 0,
+                        "samples": 0,
+                    }
+                result[key]["size"] += size
+                parts.append((address, size, result[key]))
+    return result, parts
+
+
+def print_largest_symbols(memory_config, sections, count):
+    for title, section_names, segment in [("IRAM", IRAM_SECTIONS, "iram0_0_seg"),
+                                          ("DRAM", DRAM_SECTIONS, "dram0_0_seg")]:
+        total = memory_config[segment]["length"]
+        symbols, _ = load_symbols(sections, section_names)
+        symbols = sorted(symbols.values(), key=lambda v: (-v["size"], v["name"]))
+        print("Largest symbols in %s:" % title)
+        print("%32s %7s %6s %14s %s" % ("Symbol", "Size", "% used", "Section", "Object File"))
+        for v in symbols[:count]:
+            print("%32s %7d %5.1f%% %14s %s:%s" % (v["name"][:32], v["size"], 100.0 * v["size"] / total,
+                                                   v["section"], v["archive"], v["object_file"]))
+
+
+def load_profile(profile_file, sections):
+    """ Loads samples from a profile and adds them up per function.
+
+    Returns the functions in IRAM and flash (see load_symbols), with the number of samples of each.
+    """
+    functions, parts = load_symbols(sections, IRAM_SECTIONS + [".flash.text"])
+    by_name = {}
+    for function in functions.values():
+        by_name.setdefault(function["name"], function)
+    parts.sort(key=lambda p: p[0])
+    starts = [p[0] for p in parts]
+
+    unknown = 0
+    for line in profile_file:
+        fields = line.split("#")[0].split()
+        if len(fields) == 0:
+            continue
+        try:
+            samples = int(fields[1]) if len(fields) > 1 else 1
+        except ValueError:
+            continue
+        function = None
+        if re.match(r"^(0x)?[\da-fA-F]{8}$", fields[0]):
+            address = int(fields[0], 16)
+            i = bisect.bisect_right(starts, address) - 1
+            if i >= 0 and address < parts[i][0] + parts[i][1]:
+                function = parts[i][2]
+        else:
+            function = by_name.get(fields[0])
+        if function is None:
+            unknown += samples
+        else:
+            function["samples"] += samples
+    return {"functions": list(functions.values()), "unknown": unknown}
+
+
+def samples_per_kb(function):
+    return 1024.0 * function["samples"] / function["size"] if function["size"] > 0 else 0
+
+
+def profile_rank(function):
+    return (-samples_per_kb(function), -function["samples"], function["name"])
+
+
+def print_profile(profile, budget):
+    """ Prints the functions ranked by samples per byte, and returns the functions in flash to move to IRAM.
+
+    Functions are picked by decreasing samples per byte until the IRAM budget is used up: this keeps the
+    most samples out of the flash cache for a given amount of IRAM.
+    """
+    functions = profile["functions"]
+    in_iram = [f for f in functions if f["section"] in IRAM_SECTIONS]
+    in_flash = [f for f in functions if f["section"] == ".flash.text" and f["samples"] > 0]
+    total = sum(f["samples"] for f in functions) + profile["unknown"]
+    if total == 0:
+        print("Profile has no samples")
+        return []
+    iram_samples = sum(f["samples"] for f in in_iram)
+    flash_samples = sum(f["samples"] for f in in_flash)
+    print("Profile samples: %d, %d (%.1f%%) in IRAM, %d (%.1f%%) in flash, %d outside of the app" %
+          (total, iram_samples, 100.0 * iram_samples / total, flash_samples, 100.0 * flash_samples / total,
+           profile["unknown"]))
+
+    hot = []
+    used = 0
+    print("Hot functions in flash (IRAM budget %d bytes):" % budget)
+    print("%32s %6s %8s %10s %9s %s" % ("Function", "Size", "Samples", "Samples/KB", "IRAM used", "Object File"))
+    for f in sorted(in_flash, key=profile_rank):
+        note = ""
+        if not f["own_section"]:
+            note = " (not in a section of its own)"
+        elif used + f["size"] <= budget:
+            used += f["size"]
+            hot.append(f)
+        else:
+            note = " (over budget)"
+        print("%32s %6d %8d %10.1f %9s %s:%s%s" % (f["name"][:32], f["size"], f["samples"], samples_per_kb(f),
+                                                   used if f in hot else "", f["archive"], f["object_file"], note))
+    moved = sum(f["samples"] for f in hot)
+    print("Functions to move to IRAM: %d (%d bytes), covering %d (%.1f%%) more samples" %
+          (len(hot), used, moved, 100.0 * moved / total))
+
+    cold = sorted([f for f in in_iram if f["samples"] == 0 and f["section"] == ".iram0.text"],
+                  key=lambda f: (-f["size"], f["name"]))
+    cold_size = sum(f["size"] for f in cold)
+    print("IRAM functions without samples: %d (%d bytes), largest:" % (len(cold), cold_size))
+    for f in cold[:PROFILE_COLD_COUNT]:
+        print("%32s %6d %s:%s" % (f["name"][:32], f["size"], f["archive"], f["object_file"]))
+    return hot
+
+
+def write_fragment(fragment_file, functions):
+    """ Writes a linker fragment (see docs/en/api-guides/linker-script-generation.rst) which places the given
+    functions in IRAM. """
+    fragment_file.write("# Generated by idf_size.py --profile, places the hottest functions in IRAM\n")
+    archives = {}
+    for f in functions:
+        archives.setdefault(f["archive"], []).append(f)
+    for archive in sorted(archives):
+        name = re.sub(r"\W", "_", re.sub(r"^lib|\.a$", "", archive))
+        fragment_file.write("\n[mapping:profile_%s]\narchive: %s\nentries:\n" % (name, archive))
+        for f in sorted(archives[archive], key=lambda f: (f["object_file"], f["name"])):
+            fragment_file.write("    %s:%s (noflash)\n" % (object_name(f["object_file"]), f["name"]))
+
+
+def write_order(order_file, profile, excluded):
+    """ Writes an ordering file for ldgen (see docs/en/api-guides/linker-script-generation.rst) listing the sampled
+    functions in flash, densest in samples first, so that ldgen places them next to each other.
+
+    A PC sampling profile has no call graph, so functions are grouped by sample density rather than by caller:
+    the code that runs most often then shares the fewest flash cache pages.
+    """
+    order_file.write("# Generated by idf_size.py --profile, orders the hottest functions in flash\n")
+    for f in sorted(profile["functions"], key=profile_rank):
+        if f["section"] == ".flash.text" and f["samples"] > 0 and f["own_section"] and f not in excluded:
+            order_file.write("%s:%s:%s\n" % (f["archive"], object_name(f["object_file"]), f["name"]))
+
+
 if __name__ == "__main__":
     main()
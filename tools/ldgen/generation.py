@@ -254,10 +254,15 @@ class GenerationModel:
 
     DEFAULT_SCHEME = "default"
 
+    # Target of the symbols listed in an ordering file, and the sections fragment holding their code
+    ORDERED_TARGET = "flash_text"
+    ORDERED_SECTIONS = "text"
+
     def __init__(self):
         self.schemes = {}
         self.sections = {}
         self.mappings = {}
+        self.ordering = []
 
     def _add_mapping_rules(self, archive, obj, symbol, scheme_name, scheme_dict, rules):
         # Use an ordinary dictionary to raise exception on non-existing keys
@@ -351,6 +356,9 @@ class GenerationModel:
         for mapping_rules in all_mapping_rules.items():
             self._detect_conflicts(mapping_rules)
 
+        # Resolve the ordered symbols before exclusions modify the rules
+        ordered_rules = self._create_ordered_rules(default_rules, all_mapping_rules)
+
         # Add exclusions
         for mapping_rules in all_mapping_rules.values():
             self._create_exclusions(mapping_rules, default_rules, sections_infos)
@@ -368,8 +376,63 @@ class GenerationModel:
                 if mapping_rule.get_section_names():
                     existing_rules.append(mapping_rule)
 
+        # The linker places an input section with the first rule matching it, so the ordered symbols are
+        # placed before the other rules of the target.
+        if ordered_rules:
+            placement_rules[GenerationModel.ORDERED_TARGET] = ordered_rules + placement_rules[GenerationModel.ORDERED_TARGET]
+
         return placement_rules
 
+    def _create_ordered_rules(self, default_rules, all_mapping_rules):
+        # Generates one symbol specific rule per entry of the ordering file. Entries which the mapping fragments
+        # place somewhere else than the ordered target are skipped: a rule for them under the ordered target
+        # could take precedence over that placement.
+        if not self.ordering:
+            return []
+
+        try:
+            text_sections = self.sections[GenerationModel.ORDERED_SECTIONS].entries
+        except KeyError:
+            message = GenerationException.UNDEFINED_REFERENCE + " to sections '" + GenerationModel.ORDERED_SECTIONS + "'."
+            raise GenerationException(message)
+
+        rules = list(default_rules)
+        for mapping_rules in all_mapping_rules.values():
+            rules.extend(mapping_rules)
+
+        ordered_rules = []
+        for (archive, obj, symbol) in self.ordering:
+            rule = PlacementRule(archive, obj, symbol, text_sections, GenerationModel.ORDERED_TARGET)
+            matching = [r for r in rules if (r.specificity == PlacementRule.DEFAULT_SPECIFICITY or rule.is_more_specific_rule_of(r) or
+                                             rule.maps_same_entities_as(r)) and rule.get_sections_intersection(r)]
+            if not matching:
+                continue
+            placement = max(matching, key=lambda r: r.specificity)
+            if placement.target == GenerationModel.ORDERED_TARGET:
+                ordered_rules.append(rule)
+
+        return ordered_rules
+
+    def add_ordering_from_file(self, ordering_file):
+        """
+        Reads an ordering file: the symbols listed in it are placed first in the ordered target, in the order
+        of the file. Each line is an 'archive:object:symbol' entry, '#' starts a comment.
+        """
+        seen = set()
+        for (line_no, line) in enumerate(ordering_file, 1):
+            line = line.split("#")[0].strip()
+            if not line:
+                continue
+
+            entry = tuple(line.split(":"))
+            if len(entry) != 3 or not all(entry):
+                message = "Invalid entry '%s' in ordering file %s line %d, expected 'archive:object:symbol'." % (line, ordering_file.name, line_no)
+                raise GenerationException(message)
+
+            if entry not in seen:
+                seen.add(entry)
+                self.ordering.append(entry)
+
     def _detect_conflicts(self, rules):
         (archive, rules_list) = rules
 
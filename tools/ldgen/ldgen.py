@@ -59,6 +59,11 @@ def main():
         "--kconfig", "-k",
         help="IDF Kconfig file")
 
+    argparser.add_argument(
+        "--order",
+        type=argparse.FileType("r"),
+        help="Ordering file, listing symbols to place first in flash_text")
+
     argparser.add_argument(
         "--env", "-e",
         action='append', default=[],
@@ -100,6 +105,9 @@ def main():
                 raise LdGenFailure("failed to parse %s\n%s" % (fragment_file.name, str(e)))
             generation_model.add_fragments_from_file(fragment_file)
 
+        if args.order:
+            generation_model.add_ordering_from_file(args.order)
+
         mapping_rules = generation_model.generate_rules(sections_infos)
 
         script_model = TemplateModel(input_file)
@@ -1232,6 +1232,80 @@ entries:
 
             self.compare_rules(expected, actual)
 
+    def add_ordering(self, text):
+        ordering_file = self.create_fragment_file(text, "order.txt")
+        self.model.add_ordering_from_file(ordering_file)
+
+    def test_rule_generation_ordering(self):
+        normal = u"""
+[mapping:test]
+archive: libfreertos.a
+entries:
+    tasks (noflash)
+"""
+        ordering = u"""
+# hottest first
+libfreertos.a:queue:xQueueGenericSend
+libfreertos.a:tasks:vTaskDelay
+libfreertos.a:queue:xQueueGenericSend
+libfreertos.a:timers:xTimerGenericCommand   # comment
+"""
+        self.add_fragments(normal)
+        self.add_ordering(ordering)
+
+        actual = self.model.generate_rules(self.sections_info)
+
+        expected = self.generate_default_rules()
+
+        flash_text_default = self.get_default("flash_text", expected)
+        flash_rodata_default = self.get_default("flash_rodata", expected)
+
+        iram0_text_E1 = PlacementRule("libfreertos.a", "tasks", None, self.model.sections["text"].entries, "iram0_text")
+        dram0_data_E1 = PlacementRule("libfreertos.a", "tasks", None, self.model.sections["rodata"].entries, "dram0_data")
+
+        flash_text_default.add_exclusion(iram0_text_E1)
+        flash_rodata_default.add_exclusion(dram0_data_E1)
+
+        expected["iram0_text"].append(iram0_text_E1)
+        expected["dram0_data"].append(dram0_data_E1)
+
+        # Ordered symbols come first, in the order of the file. vTaskDelay is skipped, its object is in IRAM.
+        flash_text_O1 = PlacementRule("libfreertos.a", "queue", "xQueueGenericSend", self.model.sections["text"].entries, "flash_text")
+        flash_text_O2 = PlacementRule("libfreertos.a", "timers", "xTimerGenericCommand", self.model.sections["text"].entries, "flash_text")
+        expected["flash_text"] = [flash_text_O1, flash_text_O2] + expected["flash_text"]
+
+        self.compare_rules(expected, actual)
+        self.assertEqual([str(r) for r in expected["flash_text"]], [str(r) for r in actual["flash_text"]])
+
+    def test_rule_generation_ordering_mapped_symbol(self):
+        normal = u"""
+[mapping:test]
+archive: libfreertos.a
+entries:
+    * (noflash)
+    croutine:prvCheckPendingReadyList (default)
+"""
+        ordering = u"""
+libfreertos.a:croutine:prvCheckDelayedList
+libfreertos.a:croutine:prvCheckPendingReadyList
+"""
+        self.add_fragments(normal)
+        self.add_ordering(ordering)
+
+        actual = self.model.generate_rules(self.sections_info)
+
+        # Only the symbol mapped back to flash by a more specific entry is ordered
+        flash_text = actual["flash_text"]
+        self.assertEqual(PlacementRule("libfreertos.a", "croutine", "prvCheckPendingReadyList", self.model.sections["text"].entries, "flash_text"),
+                         flash_text[0])
+        self.assertEqual(None, flash_text[1].symbol)
+        self.assertFalse([r for r in flash_text[1:] if r.symbol == "prvCheckDelayedList"])
+
+    def test_rule_generation_ordering_invalid(self):
+        for ordering in [u"libfreertos.a:queue\n", u"libfreertos.a::xQueueGenericSend\n", u"a:b:c:d\n"]:
+            with self.assertRaises(GenerationException):
+                self.add_ordering(ordering)
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -7,6 +7,10 @@
     && coverage run -a $IDF_PATH/tools/idf_size.py --files app.map &>> output \
     && coverage run -a $IDF_PATH/tools/idf_size.py --archive_details libdriver.a app.map &>> output \
     && coverage run -a $IDF_PATH/tools/test_idf_size/test_idf_size.py &>> output \
+    && coverage run -a $IDF_PATH/tools/idf_size.py --symbols 5 app.map &>> output \
+    && coverage run -a $IDF_PATH/tools/idf_size.py --profile profile.txt --iram-budget 200 --emit-fragment profile.lf --emit-order profile.order app.map &>> output \
+    && cat profile.lf >> output \
+    && cat profile.order >> output \
     && diff output expected_output \
     && coverage report \
 ; } || { echo 'The test for idf_size has failed. Please examine the artifacts.' ; exit 1; }
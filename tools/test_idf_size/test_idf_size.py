@@ -39,3 +39,5 @@ if __name__ == "__main__":
         idf_size.print_summary({"iram0_0_seg": {"length":0}, "dram0_0_seg": {"length":0}}, {})
     except ZeroDivisionError:
         pass
+
+    idf_size.print_profile({"functions": [], "unknown": 0}, 0)
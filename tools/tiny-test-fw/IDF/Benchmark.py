@@ -0,0 +1,121 @@
+# Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http:#www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Benchmark results of ``test_benchmark_run()`` and their baselines.
+
+Test apps print one ``[Benchmark] {...}`` line per benchmark, holding a JSON object with the statistics of the
+measured runs in CPU cycles. Baselines are stored per target in ``components/idf_test/benchmark/<target>.json``,
+as a dictionary of app configs (e.g. the unit test app config name), each a dictionary of benchmark names to the
+baseline values::
+
+    {
+        "default": {
+            "esp_spiram_memcpy ext -> int": {"median": 1234}
+        }
+    }
+
+A benchmark regresses when its median is more than ``threshold`` (a fraction) above the baseline.
+"""
+import json
+import os
+import re
+
+BENCHMARK_PATTERN = re.compile(r"\[Benchmark\] (\{[^\r\n]+\})")
+DEFAULT_THRESHOLD = 0.1
+DEFAULT_TARGET = "esp32"
+COMPARED_VALUE = "median"
+
+
+def parse_results(data):
+    """
+    get the benchmark results from the output of a test app
+
+    :param data: output of the DUT
+    :return: list of result dictionaries, in order of output
+    """
+    results = []
+    for match in BENCHMARK_PATTERN.findall(data):
+        try:
+            result = json.loads(match)
+        except ValueError:
+            continue
+        if "name" in result and COMPARED_VALUE in result:
+            results.append(result)
+    return results
+
+
+def get_baseline_file(target=None, idf_path=None):
+    if target is None:
+        target = os.getenv("IDF_TARGET") or DEFAULT_TARGET
+    if idf_path is None:
+        idf_path = os.getenv("IDF_PATH")
+    return os.path.join(idf_path, "components", "idf_test", "benchmark", target + ".json")
+
+
+def load_baselines(baseline_file):
+    """ :return: the baselines stored in the file, or empty baselines if the file doesn't exist """
+    try:
+        with open(baseline_file, "r") as f:
+            return json.load(f)
+    except IOError:
+        return {}
+
+
+def save_baselines(baseline_file, baselines):
+    with open(baseline_file, "w") as f:
+        json.dump(baselines, f, indent=4, sort_keys=True, separators=(",", ": "))
+        f.write("\n")
+
+
+def compare(results, baselines, config):
+    """
+    compare benchmark results with the baselines of an app config
+
+    :param results: results returned by ``parse_results``
+    :param baselines: baselines returned by ``load_baselines``
+    :param config: app config the results were measured with
+    :return: a list of (result, baseline value, relative change) for each result. The baseline value is None
+             if there is no baseline for the benchmark.
+    """
+    config_baselines = baselines.get(config, {})
+    comparison = []
+    for result in results:
+        baseline = config_baselines.get(result["name"], {}).get(COMPARED_VALUE)
+        change = None
+        if baseline:
+            change = float(result[COMPARED_VALUE] - baseline) / baseline
+        comparison.append((result, baseline, change))
+    return comparison
+
+
+def get_regressions(comparison, threshold=DEFAULT_THRESHOLD):
+    """ :return: the entries of ``compare`` output which are slower than their baseline by more than threshold """
+    return [c for c in comparison if c[2] is not None and c[2] > threshold]
+
+
+def format_comparison(entry):
+    result, baseline, change = entry
+    value = "{} {}".format(result[COMPARED_VALUE], result.get("unit", "")).strip()
+    if baseline is None:
+        return "[Benchmark][{}]: {} {} (no baseline)".format(result["name"], COMPARED_VALUE, value)
+    return "[Benchmark][{}]: {} {}, baseline {} ({:+.1f}%)".format(result["name"], COMPARED_VALUE, value,
+                                                                  baseline, 100.0 * change)
+
+
+def update_baselines(baselines, config, results):
+    """ record results as the new baselines of an app config """
+    config_baselines = baselines.setdefault(config, {})
+    for result in results:
+        config_baselines[result["name"]] = {COMPARED_VALUE: result[COMPARED_VALUE]}
@@ -46,6 +46,40 @@
     printf("[Performance][%s]: "value_fmt"\n", item, value)
 
 
+/**
+ * @brief Statistics of a benchmark, in CPU cycles, see test_benchmark_run()
+ */
+typedef struct {
+    uint32_t runs;      /*!< Number of measured runs */
+    uint32_t min;       /*!< Fastest run */
+    uint32_t median;    /*!< Median run, the value compared against baselines */
+    uint32_t p90;       /*!< 90th percentile */
+    uint32_t p99;       /*!< 99th percentile */
+    uint32_t max;       /*!< Slowest run */
+} test_benchmark_result_t;
+
+/**
+ * @brief Run a micro-benchmark and report its statistics
+ *
+ * Calls fn(arg) 'warmup' times to fill caches, then 'runs' times measuring each call with the CCOUNT
+ * cycle counter. The cost of the measurement itself is subtracted. Results are printed as a line
+ * "[Benchmark] {...}" holding a JSON object, which the unit test runner compares against the baselines
+ * stored in components/idf_test/benchmark.
+ *
+ * Runs are not protected from interrupts, which is why the median rather than the mean is compared.
+ * A single run must take less than 2^32 cycles.
+ *
+ * @param name Name of the benchmark, unique among all tests. May not contain quotes or backslashes.
+ * @param fn Function to measure
+ * @param arg Argument passed to fn
+ * @param warmup Number of calls before measuring
+ * @param runs Number of measured calls, at least 1
+ * @param[out] result Statistics of the measured calls, may be NULL
+ */
+void test_benchmark_run(const char *name, void (*fn)(void *arg), void *arg,
+                        uint32_t warmup, uint32_t runs, test_benchmark_result_t *result);
+
+
 /* Some definitions applicable to Unity running in FreeRTOS */
 #define UNITY_FREERTOS_PRIORITY CONFIG_UNITY_FREERTOS_PRIORITY
 #define UNITY_FREERTOS_CPU CONFIG_UNITY_FREERTOS_CPU
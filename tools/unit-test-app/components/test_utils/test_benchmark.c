@@ -0,0 +1,94 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "esp_attr.h"
+#include "test_utils.h"
+#include "xtensa/hal.h"
+#include "sdkconfig.h"
+
+#define OVERHEAD_RUNS 16
+
+static void IRAM_ATTR noop(void *arg)
+{
+}
+
+static int compare_cycles(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+//Nearest rank percentile of sorted samples
+static uint32_t percentile(const uint32_t *sorted, uint32_t n, uint32_t pct)
+{
+    uint32_t rank = (n * pct + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+static void measure(void (*fn)(void *arg), void *arg, uint32_t *cycles, uint32_t runs)
+{
+    for (uint32_t i = 0; i < runs; i++) {
+        uint32_t start = xthal_get_ccount();
+        fn(arg);
+        cycles[i] = xthal_get_ccount() - start;
+    }
+}
+
+void test_benchmark_run(const char *name, void (*fn)(void *arg), void *arg,
+                        uint32_t warmup, uint32_t runs, test_benchmark_result_t *result)
+{
+    TEST_ASSERT_NOT_NULL(name);
+    TEST_ASSERT_NULL_MESSAGE(strpbrk(name, "\"\\"), "benchmark name can't be written to JSON as is");
+    TEST_ASSERT_GREATER_THAN(0, runs);
+    uint32_t *cycles = malloc(sizeof(uint32_t) * (runs > OVERHEAD_RUNS ? runs : OVERHEAD_RUNS));
+    TEST_ASSERT_NOT_NULL(cycles);
+
+    //Cost of reading CCOUNT around a call
+    measure(noop, NULL, cycles, OVERHEAD_RUNS);
+    qsort(cycles, OVERHEAD_RUNS, sizeof(uint32_t), compare_cycles);
+    uint32_t overhead = cycles[0];
+
+    for (uint32_t i = 0; i < warmup; i++) {
+        fn(arg);
+    }
+    measure(fn, arg, cycles, runs);
+    for (uint32_t i = 0; i < runs; i++) {
+        cycles[i] = cycles[i] > overhead ? cycles[i] - overhead : 0;
+    }
+    qsort(cycles, runs, sizeof(uint32_t), compare_cycles);
+
+    test_benchmark_result_t r = {
+        .runs = runs,
+        .min = cycles[0],
+        .median = runs % 2 ? cycles[runs / 2] : (uint32_t)(((uint64_t)cycles[runs / 2 - 1] + cycles[runs / 2]) / 2),
+        .p90 = percentile(cycles, runs, 90),
+        .p99 = percentile(cycles, runs, 99),
+        .max = cycles[runs - 1],
+    };
+    free(cycles);
+
+    printf("[Benchmark] {\"name\": \"%s\", \"unit\": \"cycles\", \"cpu_mhz\": %d, \"runs\": %" PRIu32 ", "
+           "\"warmup\": %" PRIu32 ", \"min\": %" PRIu32 ", \"median\": %" PRIu32 ", \"p90\": %" PRIu32 ", "
+           "\"p99\": %" PRIu32 ", \"max\": %" PRIu32 "}\n",
+           name, CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ, r.runs, warmup, r.min, r.median, r.p90, r.p99, r.max);
+    if (result) {
+        *result = r;
+    }
+}
@@ -46,6 +46,7 @@ import Utility
 import Env
 from DUT import ExpectTimeout
 from IDF.IDFApp import UT
+from IDF import Benchmark
 
 
 UT_APP_BOOT_UP_DONE = "Press ENTER to see the list of tests."
@@ -66,6 +67,11 @@ DEFAULT_TIMEOUT = 20
 DUT_STARTUP_CHECK_RETRY_COUNT = 5
 TEST_HISTORY_CHECK_TIMEOUT = 1
 
+# allowed increase of a benchmark over its baseline, as a fraction of the baseline
+BENCHMARK_THRESHOLD = Benchmark.DEFAULT_THRESHOLD
+# if set, benchmark results are stored as the new baselines instead of being checked
+UPDATE_BENCHMARK_BASELINES = False
+
 
 class TestCaseFailed(AssertionError):
     pass
@@ -175,6 +181,37 @@ def reset_dut(dut):
         raise AssertionError("Reset {} ({}) failed!".format(dut.name, dut.port))
 
 
+def check_benchmarks(output, one_case, junit_test_case):
+    """
+    compare the benchmarks printed by a case with the baselines of its config
+
+    :return: False if any benchmark regressed
+    """
+    results = Benchmark.parse_results(output)
+    if not results:
+        return True
+
+    baseline_file = Benchmark.get_baseline_file()
+    baselines = Benchmark.load_baselines(baseline_file)
+    if UPDATE_BENCHMARK_BASELINES:
+        Benchmark.update_baselines(baselines, one_case["config"], results)
+        Benchmark.save_baselines(baseline_file, baselines)
+        Utility.console_log("Updated {} benchmark baselines in {}".format(len(results), baseline_file), color="orange")
+        return True
+
+    comparison = Benchmark.compare(results, baselines, one_case["config"])
+    for entry in comparison:
+        msg = Benchmark.format_comparison(entry)
+        Utility.console_log(msg, color="orange")
+        junit_test_case.stdout += msg + "\r\n"
+    regressions = Benchmark.get_regressions(comparison, BENCHMARK_THRESHOLD)
+    for entry in regressions:
+        err_msg = "Benchmark regression over {:.0f}%: {}".format(100 * BENCHMARK_THRESHOLD, Benchmark.format_comparison(entry))
+        Utility.console_log(err_msg, color="red")
+        junit_test_case.add_failure_info(err_msg)
+    return not regressions
+
+
 def run_one_normal_case(dut, one_case, junit_test_case):
 
     reset_dut(dut)
@@ -195,6 +232,8 @@ def run_one_normal_case(dut, one_case, junit_test_case):
         """ one test finished, let expect loop break and log result """
         test_finish.append(True)
         output = dut.stop_capture_raw_data()
+        if result:
+            result = check_benchmarks(output, one_case, junit_test_case)
         if result:
             Utility.console_log("Success: " + one_case["name"], color="green")
         else:
@@ -727,6 +766,15 @@ if __name__ == '__main__':
                         help="application binary file for flashing the chip",
                         default=None
                         )
+    parser.add_argument("--benchmark_threshold",
+                        help="allowed increase of benchmark results over their baselines, e.g. 0.1 for 10%%",
+                        type=float,
+                        default=Benchmark.DEFAULT_THRESHOLD
+                        )
+    parser.add_argument("--update_benchmark_baselines",
+                        help="store benchmark results as the new baselines of the target instead of checking them",
+                        action="store_true"
+                        )
     parser.add_argument(
         'test',
         help='Comma separated list of <option>:<argument> where option can be "name" (default), "child case num", \
@@ -734,6 +782,8 @@ if __name__ == '__main__':
         nargs='+'
     )
     args = parser.parse_args()
+    BENCHMARK_THRESHOLD = args.benchmark_threshold
+    UPDATE_BENCHMARK_BASELINES = args.update_benchmark_baselines
     list_of_dicts = []
     for test in args.test:
         test_args = test.split(r',')